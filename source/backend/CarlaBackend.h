@@ -267,6 +267,34 @@ static const uint PLUGIN_OPTION_SEND_PROGRAM_CHANGES = 0x200;
  */
 static const uint PLUGIN_OPTION_SKIP_SENDING_NOTES = 0x400;
 
+/*!
+ * Stop processing the plugin while its audio inputs and outputs are silent and no events arrive.
+ * The plugin is put to sleep after about one second of silence and woken up on the first non-silent input or event.
+ * Only available for plugins with audio inputs and no CV inputs.
+ */
+static const uint PLUGIN_OPTION_AUTO_SLEEP = 0x800;
+
+/*!
+ * Render on more than one CPU core, for plugins that can split their own work between threads.
+ * Currently used by SF2/SF3 plugins, which give FluidSynth half of the available cores.
+ * Only applies when the plugin is loaded, so changing it requires a reload (for example of the project).
+ */
+static const uint PLUGIN_OPTION_MULTI_CORE = 0x1000;
+
+/*!
+ * Keep IEEE denormal handling while this plugin processes, even if the engine flushes denormals to zero.
+ * Only useful for plugins that rely on denormal numbers, which are otherwise turned into zero.
+ * @see ENGINE_OPTION_FLUSH_DENORMALS
+ */
+static const uint PLUGIN_OPTION_KEEP_DENORMALS = 0x2000;
+
+/*!
+ * Run this plugin at a larger internal block size than the engine, behind a FIFO that adds one block of latency.
+ * Only used in patchbay mode, the block size is set by ENGINE_OPTION_PATCHBAY_DECOUPLED_BUFFER_SIZE.
+ * Meant for heavy plugins where latency does not matter, so they do not pay the overhead of small engine blocks.
+ */
+static const uint PLUGIN_OPTION_DECOUPLED_BLOCKS = 0x4000;
+
 /*!
  * Special flag to indicate that plugin options are not yet set.
  * This flag exists because 0x0 as an option value is a valid one, so we need something else to indicate "null-ness".
@@ -1180,6 +1208,32 @@ typedef enum {
      */
     ENGINE_CALLBACK_EMBED_UI_RESIZED = 48,
 
+    /*!
+     * A batch of patchbay changes has finished, see carla_patchbay_begin_batch().
+     * The patchbay callbacks that happened during the batch are not sent on their own, but collected here.
+     * @a value1   Number of records
+     * @a valueStr Records in the same format as carla_patchbay_get_snapshot()
+     */
+    ENGINE_CALLBACK_PATCHBAY_BATCH = 49,
+
+    /*!
+     * Several parameter values have been changed at once, see carla_set_parameter_values().
+     * They are not sent as ENGINE_CALLBACK_PARAMETER_VALUE_CHANGED on their own, but collected here.
+     * @a value1   Number of records
+     * @a valueStr Records separated by new lines, each as "pluginId:parameterId:value"
+     */
+    ENGINE_CALLBACK_PARAMETER_VALUES_CHANGED = 50,
+
+    /*!
+     * A plugin requested with carla_add_plugin_async() changed loading state.
+     * Once added, the plugin is also announced with ENGINE_CALLBACK_PLUGIN_ADDED as usual.
+     * @a pluginId Id of the new plugin when added, 0 otherwise
+     * @a value1   Request id, as returned by carla_add_plugin_async()
+     * @a value2   1 for loading started, 2 for added, -1 for failed
+     * @a valueStr Plugin name or label, or the error message when failed
+     */
+    ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS = 51,
+
 } EngineCallbackOpcode;
 
 /* ------------------------------------------------------------------------------------------------------------
@@ -1455,7 +1509,229 @@ typedef enum {
      * Mostly useful for JACK multi-client mode.
      * @note MUST include at least one "." (dot).
      */
-    ENGINE_OPTION_CLIENT_NAME_PREFIX = 34
+    ENGINE_OPTION_CLIENT_NAME_PREFIX = 34,
+
+    /*!
+     * Number of extra threads used to process independent plugins in parallel.
+     * In patchbay mode independent graph branches run in parallel, in rack mode lanes can be enabled
+     * with ENGINE_OPTION_RACK_LANES. 0 (the default) processes everything in the audio thread.
+     * In JACK single-client mode plugins run in parallel as long as none of their ports are connected to each other.
+     * @note Cannot be set while the engine is running.
+     */
+    ENGINE_OPTION_PROCESSING_THREADS = 35,
+
+    /*!
+     * Run bridged plugins one period behind the engine.
+     * Each bridge is started at the end of its process call and collected on the next one,
+     * so bridges run concurrently with the rest of the cycle in their own processes.
+     * This adds one period of latency to every bridged plugin.
+     * @note Cannot be set while the engine is running.
+     */
+    ENGINE_OPTION_PIPELINED_BRIDGES = 36,
+
+    /*!
+     * Time in microseconds to busy-wait for a bridged plugin to finish processing before sleeping on its semaphore.
+     * Spinning avoids the kernel wake-up latency for small buffer sizes, at the cost of burning CPU while waiting.
+     * Valid range is 0 (the default, never spin) to 1000.
+     */
+    ENGINE_OPTION_BRIDGE_SPIN_TIME = 37,
+
+    /*!
+     * Save plugin chunks as raw binary files next to the project file, instead of base64 text inside of it.
+     * The chunks go into a folder named after the project file with a ".chunks" suffix.
+     * Projects saved this way cannot be loaded from memory, as the chunk files are referenced by path.
+     */
+    ENGINE_OPTION_SAVE_CHUNKS_AS_FILES = 38,
+
+    /*!
+     * Frame granularity used when splitting blocks at event times, for plugins without fixed buffers.
+     * Blocks are only split at multiples of this value, parameter changes in between apply from the start of their
+     * sub-block while MIDI events keep their exact time. Under dense automation plugins then run fewer and bigger
+     * sub-blocks, at the cost of parameter timing precision.
+     * Valid range is 1 (the default, sample accurate) to 512.
+     */
+    ENGINE_OPTION_EVENT_SPLIT_GRANULARITY = 39,
+
+    /*!
+     * Number of idle plugin bridge processes to keep ready for each bridge binary.
+     * These are started ahead of time and already attached to their shared memory, so that loading a bridged plugin
+     * only needs to tell one of them which plugin to load. Mostly useful for Windows plugins, as Wine startup is slow.
+     * Valid range is 0 (the default, disabled) to 8.
+     */
+    ENGINE_OPTION_PLUGIN_BRIDGE_POOL_SIZE = 40,
+
+    /*!
+     * Maximum number of bridged plugins to run in a single bridge process.
+     * Plugins using the same bridge binary then share one process and RT thread, which is woken up once for all of
+     * them instead of once per plugin. A crash in one of them takes down the whole group.
+     * Valid range is 0 (the default, one process per plugin) to 64.
+     */
+    ENGINE_OPTION_PLUGIN_BRIDGE_GROUP_SIZE = 41,
+
+    /*!
+     * Load LV2 bundles on demand.
+     * When the bundle of an LV2 plugin is known (as a full path or a bundle name inside LV2_PATH), only that bundle is
+     * loaded instead of scanning all of LV2_PATH the first time an LV2 plugin is added.
+     * Data that plugins keep in other bundles, like separate presets or UIs, is not available until a full scan.
+     * Default is false.
+     */
+    ENGINE_OPTION_LV2_LAZY_LOADING = 42,
+
+    /*!
+     * Amount of each SFZ sample to keep in memory, in milliseconds.
+     * The rest of the sample is streamed from disk while playing, which greatly reduces memory usage and loading
+     * time of big SFZ libraries. Samples that loop are always fully loaded.
+     * Only applies to SFZ plugins loaded after the change.
+     * Valid range is 0 (the default, load full samples) to 10000.
+     */
+    ENGINE_OPTION_SFZ_PRELOAD_TIME = 43,
+
+    /*!
+     * Number of extra threads each SFZ plugin may use to render its voices.
+     * Active voices are split between the threads and mixed together at the end of each block, which lets a single
+     * heavily polyphonic sampler use more than one CPU core. Limited to the number of CPUs minus one.
+     * Valid range is 0 (the default, render on the audio thread only) to 64.
+     */
+    ENGINE_OPTION_SFZ_RENDER_THREADS = 44,
+
+    /*!
+     * Frame period at which CV inputs mapped to parameters are read, for plugins without fixed buffers.
+     * Each CV is read once per period and a timed parameter event is sent whenever its value changed, which gives
+     * smooth modulation without sending an event per frame. Plugins with fixed buffers always get one event per block.
+     * Valid range is 0 (the default, read once per block) to 512.
+     */
+    ENGINE_OPTION_CV_CONTROL_PERIOD = 45,
+
+    /*!
+     * Number of events each plugin event port can initially hold in patchbay mode, where every port has its own buffer.
+     * Ports that run out of space are grown outside of the audio thread, up to 2048 events.
+     * Valid range is 16 to 2048, default is 256.
+     */
+    ENGINE_OPTION_EVENT_PORT_BUFFER_SIZE = 46,
+
+    /*!
+     * Flush denormal numbers to zero on every audio thread (FTZ and DAZ modes), including plugin bridges.
+     * Avoids the large CPU spikes that denormals cause on decaying signals, such as reverb and filter tails.
+     * Plugins that need IEEE behaviour can opt out with PLUGIN_OPTION_KEEP_DENORMALS.
+     * Default is true.
+     */
+    ENGINE_OPTION_FLUSH_DENORMALS = 47,
+
+    /*!
+     * Queue host callbacks instead of calling them from whichever thread raised them.
+     * Queued callbacks are dispatched from carla_engine_idle(), in order, with consecutive parameter value changes
+     * of the same parameter merged into one. This keeps a slow host from slowing down the engine threads.
+     * ENGINE_CALLBACK_IDLE is always called directly, after dispatching what was queued so far.
+     * Not used in plugin versions of Carla.
+     * Default is false.
+     */
+    ENGINE_OPTION_ASYNC_CALLBACKS = 48,
+
+    /*!
+     * Realtime priority of the audio thread in plugin bridges and JACK applications, from 1 to 99.
+     * Each plugin can override it with the "CarlaRtPriority" property custom data.
+     * Default is 0, which keeps the generic priority of Carla threads.
+     */
+    ENGINE_OPTION_BRIDGE_RT_PRIO = 49,
+
+    /*!
+     * CPUs the audio thread of plugin bridges and JACK applications is restricted to.
+     * Uses a comma-separated list of CPU indexes or ranges as value string, like "2,3,8-11".
+     * Each plugin can override it with the "CarlaCpuAffinity" property custom data.
+     * Only supported on Linux.
+     * Default is empty, which allows all CPUs.
+     */
+    ENGINE_OPTION_BRIDGE_CPU_AFFINITY = 50,
+
+    /*!
+     * CPUs the engine processing threads are restricted to, see ENGINE_OPTION_PROCESSING_THREADS.
+     * Uses the same format as ENGINE_OPTION_BRIDGE_CPU_AFFINITY.
+     * Only supported on Linux.
+     * Default is empty, which allows all CPUs.
+     */
+    ENGINE_OPTION_PROCESSING_CPU_AFFINITY = 51,
+
+    /*!
+     * Do not instantiate plugins saved as inactive when loading a project.
+     * Only their saved state is kept, the plugin is instantiated the first time it gets activated.
+     * Only used in rack mode, where there are no connections to the plugin ports to restore.
+     * Default is false.
+     */
+    ENGINE_OPTION_DORMANT_INACTIVE_PLUGINS = 52,
+
+    /*!
+     * Internal block size of patchbay plugins using PLUGIN_OPTION_DECOUPLED_BLOCKS.
+     * Has no effect while the engine buffer size is the same or bigger.
+     * Valid range is 128 to 8192, default is 1024.
+     */
+    ENGINE_OPTION_PATCHBAY_DECOUPLED_BUFFER_SIZE = 53,
+
+    /*!
+     * Crossfade time in milliseconds used when replacing a plugin while the engine is running.
+     * The new plugin is swapped in at the start of a cycle and both instances run during the fade.
+     * Valid range is 0 to 1000, default is 0 (no crossfade, the slot is replaced directly).
+     */
+    ENGINE_OPTION_REPLACE_PLUGIN_CROSSFADE = 54,
+
+    /*!
+     * Keep memory used by the audio thread in RAM, so it never gets paged out.
+     * Covers the engine buffers, bridge audio pools and the sample data of the internal sample players.
+     * 0 is off, 1 locks memory, 2 also asks for huge pages (if transparent huge pages are enabled).
+     * Locking is limited by RLIMIT_MEMLOCK, see carla_get_locked_memory_size().
+     * Cannot be changed while the engine is running. Default is 0.
+     */
+    ENGINE_OPTION_LOCK_MEMORY = 55,
+
+    /*!
+     * Minimum number of parameters for saving a plugin's parameter values as a single compact block.
+     * Parameters mapped to MIDI or CV are always saved individually.
+     * Older Carla versions cannot read the compact block, 0 disables it.
+     * Cannot be changed while the engine is running. Default is 0.
+     */
+    ENGINE_OPTION_COMPACT_PARAMETER_STATE = 56,
+
+    /*!
+     * Open bridged LV2 UIs of the same toolkit in a single shared process, instead of one process per UI.
+     * Saves startup time and memory, but a crashing UI takes the other UIs of its process with it.
+     * Only applies to UIs opened afterwards, not supported on Windows. Default is false.
+     */
+    ENGINE_OPTION_SHARE_UI_BRIDGES = 57,
+
+    /*!
+     * Maximum rate, in Hz, at which plugins are asked to redraw their inline display.
+     * 0 means no limit, redraws are then only bound by the host idle rate. Default is 30.
+     */
+    ENGINE_OPTION_INLINE_DISPLAY_MAX_RATE = 58,
+
+    /*!
+     * Minimum size, in frames, of the sub-blocks created when splitting blocks at event times.
+     * An event that would leave a smaller sub-block before or after it is merged into the current sub-block instead,
+     * so its parameter changes apply from the start of that sub-block. Combines with the split granularity.
+     * Valid range is 0 (the default, no minimum) to 512.
+     * @see ENGINE_OPTION_EVENT_SPLIT_GRANULARITY
+     */
+    ENGINE_OPTION_EVENT_SPLIT_MIN_FRAMES = 59,
+
+    /*!
+     * Secondary audio device (within the same driver), used together with the main one.
+     * Its inputs and outputs are added after the main device ones, and follow the main device clock
+     * through a resampling buffer, which adds a fixed latency to them. Default unset.
+     * Only used by RtAudio drivers that open hardware devices directly.
+     * @see ENGINE_OPTION_AUDIO_DEVICE
+     */
+    ENGINE_OPTION_AUDIO_SECONDARY_DEVICE = 60,
+
+    /*!
+     * Split the rack into lanes processed in parallel by the processing threads, one lane per chain
+     * started by a plugin without audio inputs, with the lanes mixed together at the end.
+     * This changes the rack signal flow: plugins after such a plugin no longer receive the audio and MIDI output
+     * of the plugins before it, and only the first lane receives the rack audio input.
+     * The result matches serial processing only when every lane after the first has no plugins processing audio
+     * or MIDI coming from earlier lanes, as is the case for a rack of independent instruments.
+     * Default is off. Only used in continuous rack mode when ENGINE_OPTION_PROCESSING_THREADS is set.
+     * @note Cannot be set while the engine is running.
+     */
+    ENGINE_OPTION_RACK_LANES = 61
 
 } EngineOption;
 
@@ -22,6 +22,7 @@
 #include "CarlaPluginPtr.hpp"
 
 namespace water {
+class File;
 class MemoryOutputStream;
 class XmlDocument;
 }
@@ -75,7 +76,12 @@ enum EngineType {
     /*!
      * Dummy engine type, does not send audio or MIDI anywhere.
      */
-    kEngineTypeDummy = 6
+    kEngineTypeDummy = 6,
+
+    /*!
+     * Render engine type, only processes audio when rendering to a file.
+     */
+    kEngineTypeRender = 7
 };
 
 /*!
@@ -253,6 +259,7 @@ struct CARLA_API EngineOptions {
     bool audioTripleBuffer;
     const char* audioDriver;
     const char* audioDevice;
+    const char* audioSecondaryDevice;
 
 #ifndef BUILD_BRIDGE
     bool oscEnabled;
@@ -277,6 +284,32 @@ struct CARLA_API EngineOptions {
 
     bool preventBadBehaviour;
     uintptr_t frontendWinId;
+    uint processingThreads;
+    bool rackLanes;
+    bool pipelinedBridges;
+    uint bridgeSpinTime;
+    bool saveChunksAsFiles;
+    uint eventSplitGranularity;
+    uint eventSplitMinFrames;
+    uint bridgePoolSize;
+    uint bridgeGroupSize;
+    bool lv2LazyLoading;
+    uint sfzPreloadTime;
+    uint sfzRenderThreads;
+    uint cvControlPeriod;
+    uint eventPortBufferSize;
+    bool flushDenormals;
+    bool asyncCallbacks;
+    int bridgeRtPrio;
+    const char* bridgeCpuAffinity;
+    const char* processingCpuAffinity;
+    bool dormantInactivePlugins;
+    uint patchbayDecoupledBufferSize;
+    uint replacePluginCrossfade;
+    uint lockMemory;
+    uint compactParameterState;
+    bool shareUiBridges;
+    uint inlineDisplayMaxRate;
 
 #ifndef CARLA_OS_WIN
     struct Wine {
@@ -319,11 +352,20 @@ struct CARLA_API EngineTimeInfoBBT {
     double ticksPerBeat;
     double beatsPerMinute;
 
+    double ppqPos;         //!< absolute position in beats, derived from the values above
+    double ppqBarStartPos; //!< absolute position of the current bar start in beats, derived from the values above
+
     /*!
      * Clear.
      */
     void clear() noexcept;
 
+    /*!
+     * Update the derived ppq positions.
+     * Called by the engine once per cycle after filling the values above, so plugins do not need to.
+     */
+    void updatePPQ() noexcept;
+
 #ifndef DOXYGEN
     EngineTimeInfoBBT() noexcept;
     EngineTimeInfoBBT(const EngineTimeInfoBBT&) noexcept;
@@ -358,6 +400,33 @@ struct CARLA_API EngineTimeInfo {
 #endif
 };
 
+/*!
+ * Timing of a plugin's process calls, in microseconds.
+ * Values are zero if the plugin has not been processed yet, or after a reset.
+ */
+struct CARLA_API EnginePluginProcessTimeInfo {
+    uint64_t count; //!< number of timed process calls
+    float minUsecs;
+    float avgUsecs;
+    float maxUsecs;
+    float p99Usecs; //!< 99th percentile, approximated from a log-scale histogram
+    float avgSubBlocks; //!< average number of sub-blocks per call, above 1 when blocks are split at events
+};
+
+/*!
+ * Timing of a single engine process cycle, in microseconds.
+ * The engine keeps these for the last few seconds, see CarlaEngine::getCycleRecords().
+ */
+struct CARLA_API EngineCycleRecord {
+    int64_t  startTime;     //!< monotonic time at which the cycle started
+    uint32_t frames;        //!< number of frames processed in the cycle
+    uint32_t totalUsecs;    //!< time spent in the whole cycle
+    uint32_t prepareUsecs;  //!< time spent preparing the cycle (time information)
+    uint32_t processUsecs;  //!< time spent processing plugins and graph, bridges included
+    uint32_t postUsecs;     //!< time spent on pending plugin actions (removal, switch)
+    uint32_t xruns;         //!< engine xrun count at the end of the cycle
+};
+
 // -----------------------------------------------------------------------
 
 /*!
@@ -458,6 +527,15 @@ public:
      */
     void initBuffer() noexcept override;
 
+    /*!
+     * Check if initBuffer() has to be called every cycle.
+     * This is false when the buffer is handed to the plugin directly, as done by the internal graphs.
+     */
+    inline bool needsBufferInit() const noexcept
+    {
+        return fNeedsBufferInit;
+    }
+
     /*!
      * Direct access to the port's audio buffer.
      * May be null.
@@ -470,6 +548,7 @@ public:
 #ifndef DOXYGEN
 protected:
     float* fBuffer;
+    bool fNeedsBufferInit;
 
     CARLA_DECLARE_NON_COPY_CLASS(CarlaEngineAudioPort)
 #endif
@@ -505,6 +584,15 @@ public:
      */
     void initBuffer() noexcept override;
 
+    /*!
+     * Check if initBuffer() has to be called every cycle.
+     * This is false when the buffer is handed to the plugin directly, as done by the internal graphs.
+     */
+    inline bool needsBufferInit() const noexcept
+    {
+        return fNeedsBufferInit;
+    }
+
     /*!
      * Direct access to the port's CV buffer.
      * May be null.
@@ -532,6 +620,7 @@ public:
 protected:
     float* fBuffer;
     float fMinimum, fMaximum;
+    bool fNeedsBufferInit;
 
     CARLA_DECLARE_NON_COPY_CLASS(CarlaEngineCVPort)
 #endif
@@ -567,6 +656,13 @@ public:
      */
     void initBuffer() noexcept override;
 
+    /*!
+     * Grow this port's own buffer if it ran out of space while processing.
+     * Must be called from a non-realtime thread, the new buffer is picked up at the start of the next cycle.
+     * Does nothing unless the engine is in patchbay mode.
+     */
+    void growBufferIfNeeded() noexcept;
+
     /*!
      * Get the number of events present in the buffer.
      * @note You must only call this for input ports.
@@ -613,6 +709,8 @@ public:
     /*!
      * Write a MIDI event into the buffer.
      * Arguments are the same as in the EngineMidiEvent struct.
+     * Events bigger than EngineMidiEvent::kDataSize (like SysEx) get their data copied,
+     * it stays valid until the next time this port's buffer is initialized.
      * @note You must only call this for output ports.
      */
     virtual bool writeMidiEvent(uint32_t time, uint8_t channel, uint8_t size, const uint8_t* data) noexcept;
@@ -621,6 +719,11 @@ public:
 protected:
     const EngineProcessMode kProcessMode;
     EngineEvent* fBuffer;
+    uint32_t fBufferCapacity;
+    struct EngineEventDataArena* fDataArena;
+    struct EngineEventPortStorage* fStorage;
+    void adoptGrownBuffer() noexcept;
+    void setBufferOverflowed() noexcept;
     friend class CarlaPluginInstance;
     friend class CarlaEngineCVSourcePorts;
 
@@ -733,6 +836,12 @@ public:
      */
     virtual void setLatency(uint32_t samples) noexcept;
 
+    /*!
+     * Let the engine know the plugin changed the buffer size it runs at.
+     * @see CarlaPlugin::getBufferSize()
+     */
+    void pluginBufferSizeChanged() noexcept;
+
     /*!
      * Add a new port of type @a portType.
      * @note This function does nothing in rack processing mode since ports are static there.
@@ -787,6 +896,7 @@ protected:
     /** @internal */
     struct ProtectedData;
     ProtectedData* const pData;
+    friend class CarlaEngineEventPort;
 
     /*!
      * The constructor, protected.
@@ -900,6 +1010,12 @@ public:
      */
     virtual void idle() noexcept;
 
+    /*!
+     * Ask the engine to run its next idle cycle as soon as possible, instead of waiting for the regular interval.
+     * Only has an effect while the engine idle thread is running. Can be called from any thread.
+     */
+    void requestIdle() noexcept;
+
     /*!
      * Check if engine is running.
      */
@@ -960,6 +1076,13 @@ public:
      */
     virtual bool showDeviceControlPanel() const noexcept;
 
+    /*!
+     * Render @a frames of engine output into a 32-bit float WAV file, as fast as possible.
+     * Transport is rewound and started before rendering. Blocks until done.
+     * Only supported by the "Render" engine driver.
+     */
+    virtual bool renderToFile(const char* filename, uint64_t frames);
+
     // -------------------------------------------------------------------
     // Plugin management
 
@@ -979,12 +1102,34 @@ public:
                    const char* filename, const char* name, const char* label, int64_t uniqueId,
                    const void* extra);
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    /*!
+     * Add new plugin without waiting for it to load.
+     * Plugin types that can be instantiated outside the main thread are loaded in the background
+     * and added during idle() once ready, the others are added right away like in addPlugin().
+     * Returns the request id used in ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS, or 0 on failure.
+     * @see ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS
+     */
+    uint addPluginAsync(BinaryType btype, PluginType ptype,
+                        const char* filename, const char* name, const char* label, int64_t uniqueId,
+                        const void* extra, uint options = PLUGIN_OPTIONS_NULL);
+#endif
+
     /*!
      * Remove plugin with id @a id.
      * @see ENGINE_CALLBACK_PLUGIN_REMOVED
      */
     virtual bool removePlugin(uint id);
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    /*!
+     * Remove several plugins at once.
+     * The audio thread is only waited for once, instead of once per plugin.
+     * Plugins are removed from the highest id to the lowest, with one ENGINE_CALLBACK_PLUGIN_REMOVED each.
+     */
+    virtual bool removePlugins(const uint* ids, uint count);
+#endif
+
     /*!
      * Remove all plugins.
      */
@@ -1011,10 +1156,24 @@ public:
      */
     bool replacePlugin(uint id) noexcept;
 
+    /*!
+     * Instantiate the plugin that the dormant placeholder with id @a id stands for, and restore its saved state.
+     * The new plugin takes the same id, it is left inactive.
+     * @see ENGINE_OPTION_DORMANT_INACTIVE_PLUGINS and CarlaPlugin::isDormant()
+     */
+    bool wakeDormantPlugin(uint id);
+
     /*!
      * Switch plugins with id @a idA and @a idB.
      */
     virtual bool switchPlugins(uint idA, uint idB) noexcept;
+
+    /*!
+     * Change @a count parameter values of any plugins at once.
+     * The values are applied together by the audio thread at the start of the next cycle,
+     * followed by a single ENGINE_CALLBACK_PARAMETER_VALUES_CHANGED.
+     */
+    bool setParameterValues(const uint* pluginIds, const uint32_t* parameterIds, const float* values, uint count);
 #endif
 
     /*!
@@ -1080,6 +1239,40 @@ public:
      * Clear the currently set project filename.
      */
     void clearCurrentProjectFilename() noexcept;
+
+    /*!
+     * Load a project ahead of time, to switch to it later with switchToPreloadedProject().
+     * Its plugins are added after the current ones and fully restored, but not processed until the switch.
+     * Engine settings and external connections of the project are ignored, its tempo is applied on switch.
+     */
+    bool preloadProject(const char* filename);
+
+    /*!
+     * Replace the current plugins with the preloaded ones.
+     * The audio outputs fade out during @a fadeTimeMs before the switch and back in after it,
+     * 0 switches without fading.
+     */
+    bool switchToPreloadedProject(uint fadeTimeMs);
+
+    /*!
+     * Remove the plugins of a preloaded project without switching to it.
+     */
+    bool cancelPreloadedProject();
+
+    /*!
+     * Freeze the chain of plugins from @a firstId to @a lastId.
+     * The chain is rendered offline into the WAV file @a filename, for @a frames frames starting at transport frame 0,
+     * then replaced by an audio file player for it.
+     * The plugin states are kept next to the audio file, with a ".carxp" extension, for unfreezePlugin().
+     * @note Only supported in rack mode.
+     */
+    bool freezePlugins(uint firstId, uint lastId, const char* filename, uint64_t frames);
+
+    /*!
+     * Restore the plugins that the frozen audio file player with id @a id was rendered from.
+     * @see freezePlugins()
+     */
+    bool unfreezePlugin(uint id);
 #endif
 
     // -------------------------------------------------------------------
@@ -1124,6 +1317,12 @@ public:
      */
     const float* getPeaks(uint pluginId) const noexcept;
 
+    /*!
+     * Get the peak values of all plugins at once, 4 per plugin, as published by the last audio cycle.
+     * Copies at most @a maxPlugins plugins and returns how many were copied.
+     */
+    uint getAllPeaks(float* peaks, uint maxPlugins) const noexcept;
+
     /*!
      * Get a plugin's input peak value.
      */
@@ -1134,6 +1333,25 @@ public:
      */
     float getOutputPeak(uint pluginId, bool isLeft) const noexcept;
 
+    // -------------------------------------------------------------------
+    // Information (process timing)
+
+    /*!
+     * Get timing information about a plugin's process calls.
+     */
+    EnginePluginProcessTimeInfo getPluginProcessTimeInfo(uint pluginId) const noexcept;
+
+    /*!
+     * Reset a plugin's process timing information.
+     */
+    void resetPluginProcessTimeInfo(uint pluginId) noexcept;
+
+    /*!
+     * Get timing records of the most recent engine process cycles, oldest first.
+     * Returns the number of records written into @a records, at most @a maxCount.
+     */
+    uint getCycleRecords(EngineCycleRecord* records, uint maxCount) const noexcept;
+
     // -------------------------------------------------------------------
     // Callback
 
@@ -1191,6 +1409,31 @@ public:
      * Force the engine to resend all patchbay clients, ports and connections again.
      */
     virtual bool patchbayRefresh(bool sendHost, bool sendOSC, bool external);
+
+    /*!
+     * Same as patchbayRefresh(), but instead of one callback per client, port and connection,
+     * everything is returned at once as a single string, valid until the next call.
+     * Each patchbay callback becomes one record, ended by '\x1e', with its fields separated by '\x1f'
+     * in the order action, pluginId, value1, value2, value3, valuef and valueStr.
+     * Changes after this are reported through the regular patchbay callbacks.
+     * Returns null on failure.
+     */
+    const char* getPatchbaySnapshot(bool sendHost, bool sendOSC, bool external);
+
+    /*!
+     * Start a batch of patchbay changes.
+     * Until the matching patchbayEndBatch(), the rendering order is not rebuilt
+     * and patchbay callbacks are collected instead of being sent one by one.
+     * Batches can be nested, only the outermost one has any effect.
+     */
+    void patchbayBeginBatch();
+
+    /*!
+     * Finish a batch of patchbay changes.
+     * Rebuilds the rendering order once if needed, and sends all collected patchbay callbacks
+     * as a single ENGINE_CALLBACK_PATCHBAY_BATCH.
+     */
+    void patchbayEndBatch();
 #endif
 
     // -------------------------------------------------------------------
@@ -1307,6 +1550,7 @@ protected:
     friend class CarlaEngineThread;
     friend class CarlaPluginInstance;
     friend class EngineInternalGraph;
+    friend struct EnginePluginLoader;
     friend class PendingRtEventsRunner;
     friend class ScopedActionLock;
     friend class ScopedEngineEnvironmentLocker;
@@ -1343,12 +1587,20 @@ protected:
     /*!
      * Common save project function for main engine and plugin.
      */
-    void saveProjectInternal(water::MemoryOutputStream& outStrm) const;
+    void saveProjectInternal(water::MemoryOutputStream& outStrm, const water::File* chunksDir = nullptr) const;
 
     /*!
      * Common load project function for main engine and plugin.
      */
-    bool loadProjectInternal(water::XmlDocument& xmlDoc, bool alwaysLoadConnections);
+    bool loadProjectInternal(water::XmlDocument& xmlDoc, bool alwaysLoadConnections, const water::File* projectDir = nullptr);
+
+    /*!
+     * Create and reload a new plugin with id @a id, without adding it to the engine.
+     * Used by addPlugin(), and by the background loader of addPluginAsync().
+     */
+    CarlaPluginPtr createPlugin(BinaryType btype, PluginType ptype, uint id,
+                                const char* filename, const char* name, const char* label, int64_t uniqueId,
+                                const void* extra, uint options);
 
     // -------------------------------------------------------------------
     // Helper functions
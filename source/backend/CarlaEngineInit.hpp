@@ -54,6 +54,9 @@ CarlaEngine* newJack();
 // Dummy
 CarlaEngine* newDummy();
 
+// Offline render
+CarlaEngine* newRender();
+
 // Bridge
 CarlaEngine* newBridge(const char* audioPoolBaseName,
                        const char* rtClientBaseName,
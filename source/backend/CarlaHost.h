@@ -302,6 +302,143 @@ typedef struct _CarlaRuntimeEngineInfo {
 
 } CarlaRuntimeEngineInfo;
 
+/*!
+ * Timing of a plugin's process calls.
+ * @see carla_get_plugin_process_time_info()
+ */
+typedef struct _CarlaPluginProcessTimeInfo {
+    /*!
+     * Number of timed process calls.
+     */
+    uint64_t count;
+
+    /*!
+     * Minimum, average and maximum time spent in a process call, in microseconds.
+     */
+    float minUsecs;
+    float avgUsecs;
+    float maxUsecs;
+
+    /*!
+     * 99th percentile of the time spent in a process call, in microseconds.
+     * This is an approximation, accurate to about 12%.
+     */
+    float p99Usecs;
+
+    /*!
+     * Average number of sub-blocks per process call.
+     * Above 1 when blocks are split at event times, see ENGINE_OPTION_EVENT_SPLIT_GRANULARITY.
+     */
+    float avgSubBlocks;
+
+} CarlaPluginProcessTimeInfo;
+
+/*!
+ * Timing of a single engine process cycle.
+ * @see carla_get_engine_cycle_history()
+ */
+typedef struct _CarlaEngineCycleInfo {
+    /*!
+     * Monotonic time at which the cycle started, in microseconds.
+     */
+    int64_t startTime;
+
+    /*!
+     * Number of frames processed in the cycle.
+     */
+    uint32_t frames;
+
+    /*!
+     * Time spent in the whole cycle, in microseconds.
+     */
+    uint32_t totalUsecs;
+
+    /*!
+     * Time spent in each stage of the cycle, in microseconds:
+     * preparation (time information), processing (plugins and graph, bridges included)
+     * and pending plugin actions (removal, switch).
+     */
+    uint32_t prepareUsecs;
+    uint32_t processUsecs;
+    uint32_t postUsecs;
+
+    /*!
+     * Engine xrun count at the end of the cycle.
+     */
+    uint32_t xruns;
+
+} CarlaEngineCycleInfo;
+
+/*!
+ * Timing of the most recent engine process cycles.
+ * @see carla_get_engine_cycle_history()
+ */
+typedef struct _CarlaEngineCycleHistory {
+    /*!
+     * Number of cycles.
+     */
+    uint count;
+
+    /*!
+     * Cycle timings, oldest first.
+     */
+    const CarlaEngineCycleInfo* cycles;
+
+} CarlaEngineCycleHistory;
+
+/*!
+ * Current value of a plugin output parameter, as part of a runtime snapshot.
+ */
+typedef struct _CarlaRuntimeParameterValue {
+    /*!
+     * Plugin this parameter belongs to.
+     */
+    uint pluginId;
+
+    /*!
+     * Parameter index.
+     */
+    uint32_t parameterId;
+
+    /*!
+     * Current value.
+     */
+    float value;
+
+} CarlaRuntimeParameterValue;
+
+/*!
+ * Runtime values of the engine and all its plugins, gathered in a single call.
+ * @see carla_get_runtime_snapshot()
+ */
+typedef struct _CarlaRuntimeSnapshot {
+    /*!
+     * Engine information, same as carla_get_runtime_engine_info().
+     */
+    CarlaRuntimeEngineInfo engine;
+
+    /*!
+     * Number of plugins.
+     */
+    uint pluginCount;
+
+    /*!
+     * Peak values, 4 per plugin: input left, input right, output left and output right.
+     */
+    const float* peaks;
+
+    /*!
+     * Number of output parameters, for all plugins.
+     */
+    uint32_t parameterCount;
+
+    /*!
+     * Output parameter values, ordered by plugin and then parameter index.
+     */
+    const CarlaRuntimeParameterValue* parameters;
+
+} CarlaRuntimeSnapshot;
+
 /*!
  * Runtime engine driver device information.
  */
@@ -464,6 +601,15 @@ CARLA_EXPORT bool carla_set_engine_buffer_size_and_sample_rate(CarlaHostHandle h
  * @see ENGINE_DRIVER_DEVICE_HAS_CONTROL_PANEL
  */
 CARLA_EXPORT bool carla_show_engine_device_control_panel(CarlaHostHandle handle);
+
+/*!
+ * Render the current project offline into a 32-bit float WAV file, as fast as possible.
+ * The transport is rewound and started before rendering, and paused when done.
+ * Only supported by the "Render" engine driver, this call blocks until rendering is complete.
+ * @param filename Output filename
+ * @param frames   Number of frames to render
+ */
+CARLA_EXPORT bool carla_render_to_file(CarlaHostHandle handle, const char* filename, uint64_t frames);
 #endif
 
 /*!
@@ -545,6 +691,24 @@ CARLA_EXPORT const char* carla_get_current_project_filename(CarlaHostHandle hand
  */
 CARLA_EXPORT void carla_clear_project_filename(CarlaHostHandle handle);
 
+/*!
+ * Load a Carla project file ahead of time, without processing it yet.
+ * Its plugins are added disabled after the current ones, use carla_switch_to_preloaded_project() to switch to them.
+ * @note Engine settings and external connections of the project are ignored.
+ */
+CARLA_EXPORT bool carla_preload_project(CarlaHostHandle handle, const char* filename);
+
+/*!
+ * Replace the currently loaded plugins with the ones from the preloaded project.
+ * @param fadeTimeMs Time to fade the audio outputs out before the switch and back in after it, 0 to not fade
+ */
+CARLA_EXPORT bool carla_switch_to_preloaded_project(CarlaHostHandle handle, uint fadeTimeMs);
+
+/*!
+ * Remove the plugins of the preloaded project, if any.
+ */
+CARLA_EXPORT bool carla_cancel_preloaded_project(CarlaHostHandle handle);
+
 /*!
  * Connect two patchbay ports.
  * @param groupIdA Output group
@@ -578,6 +742,32 @@ CARLA_EXPORT bool carla_patchbay_set_group_pos(CarlaHostHandle handle, bool exte
  */
 CARLA_EXPORT bool carla_patchbay_refresh(CarlaHostHandle handle, bool external);
 
+/*!
+ * Get all patchbay clients, ports and connections at once, instead of through one callback each.
+ * Each record is ended by '\x1e' and holds the fields of the callback it replaces, separated by '\x1f':
+ * action, pluginId, value1, value2, value3, valuef and valueStr.
+ * Later changes are still reported through the regular patchbay callbacks.
+ * Returns null on failure, check carla_get_last_error() for more information.
+ * @param external Wherever to show external/hardware ports instead of internal ones.
+ *                 Only valid in patchbay engine mode, other modes will ignore this.
+ */
+CARLA_EXPORT const char* carla_patchbay_get_snapshot(CarlaHostHandle handle, bool external);
+
+/*!
+ * Start a batch of patchbay changes, such as restoring many connections at once.
+ * Until the matching carla_patchbay_end_batch(), the rendering order is not rebuilt
+ * and patchbay callbacks are collected instead of being sent one by one.
+ * Batches can be nested.
+ */
+CARLA_EXPORT void carla_patchbay_begin_batch(CarlaHostHandle handle);
+
+/*!
+ * Finish a batch of patchbay changes.
+ * Rebuilds the rendering order once if needed, and sends all collected patchbay callbacks
+ * as a single ENGINE_CALLBACK_PATCHBAY_BATCH.
+ */
+CARLA_EXPORT void carla_patchbay_end_batch(CarlaHostHandle handle);
+
 /*!
  * Start playback of the engine transport.
  */
@@ -637,6 +827,20 @@ CARLA_EXPORT bool carla_add_plugin(CarlaHostHandle handle,
                                    const char* filename, const char* name, const char* label, int64_t uniqueId,
                                    const void* extraPtr, uint options);
 
+#ifndef BUILD_BRIDGE
+/*!
+ * Add a new plugin without waiting for it to load.
+ * The plugin is loaded in the background when its type allows it, and added later during carla_engine_idle().
+ * Progress is reported with ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS, using the returned request id.
+ * Returns 0 if the request failed, see carla_get_last_error().
+ * Parameters are the same as in carla_add_plugin().
+ */
+CARLA_EXPORT uint carla_add_plugin_async(CarlaHostHandle handle,
+                                         BinaryType btype, PluginType ptype,
+                                         const char* filename, const char* name, const char* label, int64_t uniqueId,
+                                         const void* extraPtr, uint options);
+#endif
+
 /*!
  * Remove one plugin.
  * @param pluginId Plugin to remove.
@@ -649,6 +853,13 @@ CARLA_EXPORT bool carla_remove_plugin(CarlaHostHandle handle, uint pluginId);
 CARLA_EXPORT bool carla_remove_all_plugins(CarlaHostHandle handle);
 
 #ifndef BUILD_BRIDGE
+/*!
+ * Remove several plugins at once, which is faster than removing them one by one.
+ * @param pluginIds Plugins to remove.
+ * @param count     Number of plugins in @a pluginIds.
+ */
+CARLA_EXPORT bool carla_remove_plugins(CarlaHostHandle handle, const uint* pluginIds, uint count);
+
 /*!
  * Rename a plugin.
  * Returns the new name, or NULL if the operation failed.
@@ -677,6 +888,24 @@ CARLA_EXPORT bool carla_replace_plugin(CarlaHostHandle handle, uint pluginId);
  * @param pluginIdB Plugin B
  */
 CARLA_EXPORT bool carla_switch_plugins(CarlaHostHandle handle, uint pluginIdA, uint pluginIdB);
+
+/*!
+ * Freeze a chain of plugins, rendering it offline into an audio file and replacing it with a player for that file.
+ * The plugin states are saved next to the audio file, see carla_unfreeze_plugin().
+ * Only supported in rack mode.
+ * @param firstId  First plugin of the chain
+ * @param lastId   Last plugin of the chain
+ * @param filename WAV file to render into
+ * @param frames   Number of frames to render, starting from transport frame 0
+ */
+CARLA_EXPORT bool carla_freeze_plugins(CarlaHostHandle handle,
+                                       uint firstId, uint lastId, const char* filename, uint64_t frames);
+
+/*!
+ * Restore the plugins a frozen audio file player was rendered from.
+ * @param pluginId Plugin of the frozen audio file player
+ */
+CARLA_EXPORT bool carla_unfreeze_plugin(CarlaHostHandle handle, uint pluginId);
 #endif
 
 /*!
@@ -889,6 +1118,17 @@ CARLA_EXPORT float carla_get_default_parameter_value(CarlaHostHandle handle, uin
  */
 CARLA_EXPORT float carla_get_current_parameter_value(CarlaHostHandle handle, uint pluginId, uint32_t parameterId);
 
+/*!
+ * Get a range of a plugin's current parameter values at once.
+ * @param pluginId    Plugin
+ * @param parameterId First parameter index
+ * @param count       Number of values to get
+ * @param values      Buffer to write the values into, must fit @a count values
+ * @return Number of values written, less than @a count if the range goes past the last parameter
+ */
+CARLA_EXPORT uint32_t carla_get_current_parameter_values(CarlaHostHandle handle, uint pluginId,
+                                                         uint32_t parameterId, uint32_t count, float* values);
+
 /*!
  * Get a plugin's internal parameter value.
  * @param pluginId    Plugin
@@ -917,6 +1157,34 @@ CARLA_EXPORT float carla_get_input_peak_value(CarlaHostHandle handle, uint plugi
  */
 CARLA_EXPORT float carla_get_output_peak_value(CarlaHostHandle handle, uint pluginId, bool isLeft);
 
+/*!
+ * Get timing information about a plugin's process calls, measured by the engine since the plugin was added or reset.
+ * Useful to find which plugins use the most DSP time.
+ * @param pluginId Plugin
+ */
+CARLA_EXPORT const CarlaPluginProcessTimeInfo* carla_get_plugin_process_time_info(CarlaHostHandle handle, uint pluginId);
+
+/*!
+ * Reset a plugin's process timing information.
+ * @param pluginId Plugin
+ */
+CARLA_EXPORT void carla_reset_plugin_process_time_info(CarlaHostHandle handle, uint pluginId);
+
+/*!
+ * Get the peaks of all plugins, their output parameter values and the engine runtime information at once.
+ * This replaces several calls per plugin by a single one when refreshing a GUI.
+ * The returned data is valid until the next call to this function.
+ */
+CARLA_EXPORT const CarlaRuntimeSnapshot* carla_get_runtime_snapshot(CarlaHostHandle handle);
+
+/*!
+ * Get the timing of the most recent engine process cycles, the engine keeps about 10 seconds worth or more.
+ * Useful to find out what happened around an xrun.
+ * The returned data is valid until the next call to this function.
+ * @param maxCount Maximum number of cycles to get
+ */
+CARLA_EXPORT const CarlaEngineCycleHistory* carla_get_engine_cycle_history(CarlaHostHandle handle, uint maxCount);
+
 /*!
  * Render a plugin's inline display.
  * @param pluginId Plugin
@@ -994,6 +1262,28 @@ CARLA_EXPORT void carla_set_option(CarlaHostHandle handle, uint pluginId, uint o
 CARLA_EXPORT void carla_set_parameter_value(CarlaHostHandle handle, uint pluginId, uint32_t parameterId, float value);
 
 #ifndef BUILD_BRIDGE
+/*!
+ * Change several parameter values of a plugin at once.
+ * All values are applied in the same audio cycle, with a single ENGINE_CALLBACK_PARAMETER_VALUES_CHANGED.
+ * @param pluginId     Plugin
+ * @param count        Number of values
+ * @param parameterIds Parameter indexes
+ * @param values       New values
+ */
+CARLA_EXPORT bool carla_set_parameter_values(CarlaHostHandle handle, uint pluginId,
+                                             uint32_t count, const uint32_t* parameterIds, const float* values);
+
+/*!
+ * Change parameter values of several plugins at once, for recalling a scene.
+ * All values are applied in the same audio cycle, with a single ENGINE_CALLBACK_PARAMETER_VALUES_CHANGED.
+ * @param count        Number of values
+ * @param pluginIds    Plugin of each value
+ * @param parameterIds Parameter indexes
+ * @param values       New values
+ */
+CARLA_EXPORT bool carla_set_multiple_parameter_values(CarlaHostHandle handle, uint32_t count, const uint* pluginIds,
+                                                      const uint32_t* parameterIds, const float* values);
+
 /*!
  * Change a plugin's parameter MIDI channel.
  * @param pluginId    Plugin
@@ -1138,6 +1428,12 @@ CARLA_EXPORT uint32_t carla_get_buffer_size(CarlaHostHandle handle);
  */
 CARLA_EXPORT double carla_get_sample_rate(CarlaHostHandle handle);
 
+/*!
+ * Get the amount of memory currently locked in RAM, in bytes.
+ * Always 0 unless ENGINE_OPTION_LOCK_MEMORY is set.
+ */
+CARLA_EXPORT uint64_t carla_get_locked_memory_size(CarlaHostHandle handle);
+
 /*!
  * Get the last error.
  */
@@ -28,6 +28,12 @@ typedef void* lo_message;
 typedef struct _NativePluginDescriptor NativePluginDescriptor;
 struct LADSPA_RDF_Descriptor;
 
+namespace water {
+class File;
+class MemoryOutputStream;
+class XmlElement;
+}
+
 // -----------------------------------------------------------------------
 
 CARLA_BACKEND_START_NAMESPACE
@@ -125,6 +131,14 @@ public:
      */
     bool isEnabled() const noexcept;
 
+    /*!
+     * Check if the plugin is a placeholder for a plugin that is not instantiated yet.
+     * Dormant plugins only hold their saved state, activating them instantiates the real plugin.
+     *
+     * @see ENGINE_OPTION_DORMANT_INACTIVE_PLUGINS
+     */
+    virtual bool isDormant() const noexcept;
+
     /*!
      * Get the plugin's internal name.
      * This name is unique within all plugins in an engine.
@@ -160,6 +174,14 @@ public:
      */
     virtual uint32_t getLatencyInFrames() const noexcept;
 
+    /*!
+     * Get the buffer size the plugin runs at.
+     * This is the engine buffer size, unless the plugin runs decoupled in patchbay mode.
+     *
+     * @see PLUGIN_OPTION_DECOUPLED_BLOCKS
+     */
+    uint32_t getBufferSize() const noexcept;
+
     // -------------------------------------------------------------------
     // Information (count)
 
@@ -425,6 +447,28 @@ public:
      */
     const CarlaStateSave& getStateSave(bool callPrepareForSave = true);
 
+    /*!
+     * Write the plugin's save state as project XML into @a stream.
+     * The XML of the previous call is reused if nothing in the plugin state was changed since,
+     * which makes frequent saving cheap.
+     * Plugins using chunks and bridged plugins are always asked again, their state can change without notice.
+     * If @a chunkFile is not null, the plugin chunk is written into it instead of inline as base64.
+     *
+     * @see getStateSave()
+     */
+    void dumpStateSave(water::MemoryOutputStream& stream, const water::File* chunkFile);
+
+    /*!
+     * dumpStateSave() split in 3 steps, so that the engine can encode several plugins in parallel.
+     * prepareStateDump() collects the state and writes the chunk file, it must run on the thread calling dumpStateSave().
+     * Returns false if the XML of the previous dump can be reused, in which case encodeStateDump() is skipped.
+     * encodeStateDump() only touches this plugin's already collected state, it can run on any thread.
+     * finishStateDump() writes the resulting XML into @a stream.
+     */
+    bool prepareStateDump(const water::File* chunkFile);
+    void encodeStateDump();
+    void finishStateDump(water::MemoryOutputStream& stream);
+
     /*!
      * Get the plugin's save state.
      *
@@ -669,6 +713,23 @@ public:
      */
     void setMidiProgramById(uint32_t bank, uint32_t program, bool sendGui, bool sendOsc, bool sendCallback) noexcept;
 
+    /*!
+     * Change the current plugin program on behalf of the user or host, from a non-realtime thread.
+     *
+     * While the plugin is running and supports realtime program changes, the change is handed over
+     * to the audio thread and applied at the start of its next cycle, so it never interrupts processing.
+     * The callback, OSC and GUI notifications, including the new parameter values, are then always sent
+     * once the change is done. Otherwise this is the same as setProgram().
+     * Returns true if the change was handed over to the audio thread, false if it was applied right away.
+     */
+    bool requestProgramChange(int32_t index, bool sendGui, bool sendOsc, bool sendCallback) noexcept;
+
+    /*!
+     * Change the current MIDI plugin program on behalf of the user or host, from a non-realtime thread.
+     * @see requestProgramChange()
+     */
+    bool requestMidiProgramChange(int32_t index, bool sendGui, bool sendOsc, bool sendCallback) noexcept;
+
     /*!
      * Overloaded functions, to be called from within RT context only.
      */
@@ -710,6 +771,44 @@ public:
     virtual void process(const float* const* audioIn, float** audioOut,
                          const float* const* cvIn, float** cvOut, uint32_t frames) = 0;
 
+    /*!
+     * Get the plugin's own memory for audio port @a index, or null if it has none.
+     * Hosts can write input audio straight into it and pass it to process(), which then skips copying that port.
+     * The pointer is only valid until the next buffer size change.
+     */
+    virtual float* getSharedAudioBuffer(bool isInput, uint32_t index) const noexcept;
+
+    /*!
+     * Check if the plugin can start processing in the background, see startProcess().
+     */
+    virtual bool canStartProcess() const noexcept;
+
+    /*!
+     * Start processing a block in the background, used for plugins that run out-of-process.
+     * The next process() call with the same buffers waits for and completes this block.
+     * This lets the engine run several of these plugins at once.
+     */
+    virtual void startProcess(const float* const* audioIn, float** audioOut,
+                              const float* const* cvIn, float** cvOut, uint32_t frames);
+
+    /*!
+     * Check if the plugin is asleep and process() can be skipped for this block, see PLUGIN_OPTION_AUTO_SLEEP.
+     * Must be called with the plugin locked, after initBuffers() and before process().
+     * When this returns true the host is responsible for silencing the plugin outputs.
+     */
+    bool checkAutoSleep(const float* const* audioIn, uint32_t frames) noexcept;
+
+    /*!
+     * Update the auto-sleep silence detection with the outputs of the block just processed.
+     */
+    void updateAutoSleep(const float* const* audioOut, uint32_t frames) noexcept;
+
+    /*!
+     * Get the number of extra sub-blocks process() was split into since the last call, and reset it.
+     * Must be called from the thread processing the plugin, used for the engine process statistics.
+     */
+    uint32_t takeEventSplitCount() noexcept;
+
     /*!
      * Tell the plugin the current buffer size changed.
      */
@@ -978,6 +1077,9 @@ public:
     static CarlaPluginPtr newSFZero(const Initializer& init);
 
     static CarlaPluginPtr newJackApp(const Initializer& init);
+
+    static CarlaPluginPtr newDormant(const Initializer& init,
+                                     const water::XmlElement* xmlElement, CarlaStateSave& stateSave);
 #endif
 
     // -------------------------------------------------------------------
@@ -26,6 +26,7 @@
 
 #include "CarlaBackendUtils.hpp"
 #include "CarlaBase64Utils.hpp"
+#include "CarlaMemoryLock.hpp"
 #include "ThreadSafeFFTW.hpp"
 
 #ifdef BUILD_BRIDGE
@@ -168,6 +169,15 @@ static void carla_engine_init_common(const CarlaHostStandalone& standalone, Carl
     if (const char* const uiBridgesTimeout = std::getenv("ENGINE_OPTION_UI_BRIDGES_TIMEOUT"))
         engine->setOption(CB::ENGINE_OPTION_UI_BRIDGES_TIMEOUT, std::atoi(uiBridgesTimeout), nullptr);
 
+    if (const char* const flushDenormals = std::getenv("ENGINE_OPTION_FLUSH_DENORMALS"))
+        engine->setOption(CB::ENGINE_OPTION_FLUSH_DENORMALS, (std::strcmp(flushDenormals, "true") == 0) ? 1 : 0, nullptr);
+
+    if (const char* const bridgeRtPrio = std::getenv("ENGINE_OPTION_BRIDGE_RT_PRIO"))
+        engine->setOption(CB::ENGINE_OPTION_BRIDGE_RT_PRIO, std::atoi(bridgeRtPrio), nullptr);
+
+    if (const char* const bridgeCpuAffinity = std::getenv("ENGINE_OPTION_BRIDGE_CPU_AFFINITY"))
+        engine->setOption(CB::ENGINE_OPTION_BRIDGE_CPU_AFFINITY, 0, bridgeCpuAffinity);
+
     if (const char* const pathAudio = std::getenv("ENGINE_OPTION_FILE_PATH_AUDIO"))
         engine->setOption(CB::ENGINE_OPTION_FILE_PATH, CB::FILE_AUDIO, pathAudio);
 
@@ -228,6 +238,9 @@ static void carla_engine_init_common(const CarlaHostStandalone& standalone, Carl
     if (standalone.engineOptions.audioDevice != nullptr)
         engine->setOption(CB::ENGINE_OPTION_AUDIO_DEVICE,      0, standalone.engineOptions.audioDevice);
 
+    if (standalone.engineOptions.audioSecondaryDevice != nullptr)
+        engine->setOption(CB::ENGINE_OPTION_AUDIO_SECONDARY_DEVICE, 0, standalone.engineOptions.audioSecondaryDevice);
+
     engine->setOption(CB::ENGINE_OPTION_OSC_ENABLED,  standalone.engineOptions.oscEnabled, nullptr);
     engine->setOption(CB::ENGINE_OPTION_OSC_PORT_TCP, standalone.engineOptions.oscPortTCP, nullptr);
     engine->setOption(CB::ENGINE_OPTION_OSC_PORT_UDP, standalone.engineOptions.oscPortUDP, nullptr);
@@ -300,6 +313,32 @@ static void carla_engine_init_common(const CarlaHostStandalone& standalone, Carl
 # endif
 
     engine->setOption(CB::ENGINE_OPTION_CLIENT_NAME_PREFIX, 0, standalone.engineOptions.clientNamePrefix);
+    engine->setOption(CB::ENGINE_OPTION_PROCESSING_THREADS, static_cast<int>(standalone.engineOptions.processingThreads), nullptr);
+    engine->setOption(CB::ENGINE_OPTION_RACK_LANES,         standalone.engineOptions.rackLanes ? 1 : 0,                    nullptr);
+    engine->setOption(CB::ENGINE_OPTION_PIPELINED_BRIDGES,  standalone.engineOptions.pipelinedBridges ? 1 : 0,             nullptr);
+    engine->setOption(CB::ENGINE_OPTION_BRIDGE_SPIN_TIME,   static_cast<int>(standalone.engineOptions.bridgeSpinTime),   nullptr);
+    engine->setOption(CB::ENGINE_OPTION_SAVE_CHUNKS_AS_FILES, standalone.engineOptions.saveChunksAsFiles ? 1 : 0,          nullptr);
+    engine->setOption(CB::ENGINE_OPTION_EVENT_SPLIT_GRANULARITY, static_cast<int>(standalone.engineOptions.eventSplitGranularity), nullptr);
+    engine->setOption(CB::ENGINE_OPTION_EVENT_SPLIT_MIN_FRAMES, static_cast<int>(standalone.engineOptions.eventSplitMinFrames), nullptr);
+    engine->setOption(CB::ENGINE_OPTION_PLUGIN_BRIDGE_POOL_SIZE, static_cast<int>(standalone.engineOptions.bridgePoolSize), nullptr);
+    engine->setOption(CB::ENGINE_OPTION_PLUGIN_BRIDGE_GROUP_SIZE, static_cast<int>(standalone.engineOptions.bridgeGroupSize), nullptr);
+    engine->setOption(CB::ENGINE_OPTION_LV2_LAZY_LOADING, standalone.engineOptions.lv2LazyLoading ? 1 : 0, nullptr);
+    engine->setOption(CB::ENGINE_OPTION_SFZ_PRELOAD_TIME, static_cast<int>(standalone.engineOptions.sfzPreloadTime), nullptr);
+    engine->setOption(CB::ENGINE_OPTION_SFZ_RENDER_THREADS, static_cast<int>(standalone.engineOptions.sfzRenderThreads), nullptr);
+    engine->setOption(CB::ENGINE_OPTION_CV_CONTROL_PERIOD, static_cast<int>(standalone.engineOptions.cvControlPeriod), nullptr);
+    engine->setOption(CB::ENGINE_OPTION_EVENT_PORT_BUFFER_SIZE, static_cast<int>(standalone.engineOptions.eventPortBufferSize), nullptr);
+    engine->setOption(CB::ENGINE_OPTION_FLUSH_DENORMALS, standalone.engineOptions.flushDenormals ? 1 : 0, nullptr);
+    engine->setOption(CB::ENGINE_OPTION_ASYNC_CALLBACKS, standalone.engineOptions.asyncCallbacks ? 1 : 0, nullptr);
+    engine->setOption(CB::ENGINE_OPTION_BRIDGE_RT_PRIO, standalone.engineOptions.bridgeRtPrio, nullptr);
+    engine->setOption(CB::ENGINE_OPTION_BRIDGE_CPU_AFFINITY, 0, standalone.engineOptions.bridgeCpuAffinity);
+    engine->setOption(CB::ENGINE_OPTION_PROCESSING_CPU_AFFINITY, 0, standalone.engineOptions.processingCpuAffinity);
+    engine->setOption(CB::ENGINE_OPTION_DORMANT_INACTIVE_PLUGINS, standalone.engineOptions.dormantInactivePlugins ? 1 : 0, nullptr);
+    engine->setOption(CB::ENGINE_OPTION_PATCHBAY_DECOUPLED_BUFFER_SIZE, static_cast<int>(standalone.engineOptions.patchbayDecoupledBufferSize), nullptr);
+    engine->setOption(CB::ENGINE_OPTION_REPLACE_PLUGIN_CROSSFADE, static_cast<int>(standalone.engineOptions.replacePluginCrossfade), nullptr);
+    engine->setOption(CB::ENGINE_OPTION_LOCK_MEMORY, static_cast<int>(standalone.engineOptions.lockMemory), nullptr);
+    engine->setOption(CB::ENGINE_OPTION_COMPACT_PARAMETER_STATE, static_cast<int>(standalone.engineOptions.compactParameterState), nullptr);
+    engine->setOption(CB::ENGINE_OPTION_SHARE_UI_BRIDGES, standalone.engineOptions.shareUiBridges ? 1 : 0, nullptr);
+    engine->setOption(CB::ENGINE_OPTION_INLINE_DISPLAY_MAX_RATE, static_cast<int>(standalone.engineOptions.inlineDisplayMaxRate), nullptr);
 #endif // BUILD_BRIDGE
 }
 
@@ -564,6 +603,16 @@ bool carla_show_engine_device_control_panel(CarlaHostHandle handle)
 
     return handle->engine->showDeviceControlPanel();
 }
+
+bool carla_render_to_file(CarlaHostHandle handle, const char* filename, uint64_t frames)
+{
+    CARLA_SAFE_ASSERT_WITH_LAST_ERROR_RETURN(handle->engine != nullptr, "Engine is not initialized", false);
+    CARLA_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', false);
+    CARLA_SAFE_ASSERT_RETURN(frames > 0, false);
+    carla_debug("carla_render_to_file(%p, \"%s\", " P_UINT64 ")", handle, filename, frames);
+
+    return handle->engine->renderToFile(filename, frames);
+}
 #endif // BUILD_BRIDGE
 
 void carla_clear_engine_xruns(CarlaHostHandle handle)
@@ -898,6 +947,153 @@ void carla_set_engine_option(CarlaHostHandle handle, EngineOption option, int va
                                                    ? carla_strdup_safe(valueStr)
                                                    : nullptr;
             break;
+
+        case CB::ENGINE_OPTION_PROCESSING_THREADS:
+            CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 64,);
+            shandle.engineOptions.processingThreads = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_RACK_LANES:
+            CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+            shandle.engineOptions.rackLanes = (value != 0);
+            break;
+
+        case CB::ENGINE_OPTION_PIPELINED_BRIDGES:
+            CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+            shandle.engineOptions.pipelinedBridges = (value != 0);
+            break;
+
+        case CB::ENGINE_OPTION_BRIDGE_SPIN_TIME:
+            CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 1000,);
+            shandle.engineOptions.bridgeSpinTime = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_SAVE_CHUNKS_AS_FILES:
+            CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+            shandle.engineOptions.saveChunksAsFiles = (value != 0);
+            break;
+
+        case CB::ENGINE_OPTION_EVENT_SPLIT_GRANULARITY:
+            CARLA_SAFE_ASSERT_RETURN(value >= 1 && value <= 512,);
+            shandle.engineOptions.eventSplitGranularity = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_PLUGIN_BRIDGE_POOL_SIZE:
+            CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 8,);
+            shandle.engineOptions.bridgePoolSize = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_PLUGIN_BRIDGE_GROUP_SIZE:
+            CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 64,);
+            shandle.engineOptions.bridgeGroupSize = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_LV2_LAZY_LOADING:
+            CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+            shandle.engineOptions.lv2LazyLoading = (value != 0);
+            break;
+
+        case CB::ENGINE_OPTION_SFZ_PRELOAD_TIME:
+            CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 10000,);
+            shandle.engineOptions.sfzPreloadTime = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_SFZ_RENDER_THREADS:
+            CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 64,);
+            shandle.engineOptions.sfzRenderThreads = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_CV_CONTROL_PERIOD:
+            CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 512,);
+            shandle.engineOptions.cvControlPeriod = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_EVENT_PORT_BUFFER_SIZE:
+            CARLA_SAFE_ASSERT_RETURN(value >= 16 && value <= 2048,);
+            shandle.engineOptions.eventPortBufferSize = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_FLUSH_DENORMALS:
+            CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+            shandle.engineOptions.flushDenormals = (value != 0);
+            break;
+
+        case CB::ENGINE_OPTION_ASYNC_CALLBACKS:
+            CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+            shandle.engineOptions.asyncCallbacks = (value != 0);
+            break;
+
+        case CB::ENGINE_OPTION_BRIDGE_RT_PRIO:
+            CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 99,);
+            shandle.engineOptions.bridgeRtPrio = value;
+            break;
+
+        case CB::ENGINE_OPTION_BRIDGE_CPU_AFFINITY:
+            if (shandle.engineOptions.bridgeCpuAffinity != nullptr)
+                delete[] shandle.engineOptions.bridgeCpuAffinity;
+
+            shandle.engineOptions.bridgeCpuAffinity = valueStr != nullptr && valueStr[0] != '\0'
+                                                    ? carla_strdup_safe(valueStr)
+                                                    : nullptr;
+            break;
+
+        case CB::ENGINE_OPTION_PROCESSING_CPU_AFFINITY:
+            if (shandle.engineOptions.processingCpuAffinity != nullptr)
+                delete[] shandle.engineOptions.processingCpuAffinity;
+
+            shandle.engineOptions.processingCpuAffinity = valueStr != nullptr && valueStr[0] != '\0'
+                                                        ? carla_strdup_safe(valueStr)
+                                                        : nullptr;
+            break;
+
+        case CB::ENGINE_OPTION_DORMANT_INACTIVE_PLUGINS:
+            CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+            shandle.engineOptions.dormantInactivePlugins = (value != 0);
+            break;
+
+        case CB::ENGINE_OPTION_PATCHBAY_DECOUPLED_BUFFER_SIZE:
+            CARLA_SAFE_ASSERT_RETURN(value >= 128 && value <= 8192,);
+            shandle.engineOptions.patchbayDecoupledBufferSize = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_REPLACE_PLUGIN_CROSSFADE:
+            CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 1000,);
+            shandle.engineOptions.replacePluginCrossfade = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_LOCK_MEMORY:
+            CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 2,);
+            shandle.engineOptions.lockMemory = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_COMPACT_PARAMETER_STATE:
+            CARLA_SAFE_ASSERT_RETURN(value >= 0,);
+            shandle.engineOptions.compactParameterState = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_SHARE_UI_BRIDGES:
+            CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+            shandle.engineOptions.shareUiBridges = (value != 0);
+            break;
+
+        case CB::ENGINE_OPTION_INLINE_DISPLAY_MAX_RATE:
+            CARLA_SAFE_ASSERT_RETURN(value >= 0,);
+            shandle.engineOptions.inlineDisplayMaxRate = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_EVENT_SPLIT_MIN_FRAMES:
+            CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 512,);
+            shandle.engineOptions.eventSplitMinFrames = static_cast<uint>(value);
+            break;
+
+        case CB::ENGINE_OPTION_AUDIO_SECONDARY_DEVICE:
+            CARLA_SAFE_ASSERT_RETURN(valueStr != nullptr,);
+
+            if (shandle.engineOptions.audioSecondaryDevice != nullptr)
+                delete[] shandle.engineOptions.audioSecondaryDevice;
+
+            shandle.engineOptions.audioSecondaryDevice = carla_strdup_safe(valueStr);
+            break;
         }
     }
 
@@ -988,6 +1184,34 @@ void carla_clear_project_filename(CarlaHostHandle handle)
     handle->engine->clearCurrentProjectFilename();
 }
 
+bool carla_preload_project(CarlaHostHandle handle, const char* filename)
+{
+    CARLA_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', false);
+    CARLA_SAFE_ASSERT_WITH_LAST_ERROR_RETURN(handle->engine != nullptr, "Engine is not initialized", false);
+
+    carla_debug("carla_preload_project(%p, \"%s\")", handle, filename);
+
+    return handle->engine->preloadProject(filename);
+}
+
+bool carla_switch_to_preloaded_project(CarlaHostHandle handle, uint fadeTimeMs)
+{
+    CARLA_SAFE_ASSERT_WITH_LAST_ERROR_RETURN(handle->engine != nullptr, "Engine is not initialized", false);
+
+    carla_debug("carla_switch_to_preloaded_project(%p, %u)", handle, fadeTimeMs);
+
+    return handle->engine->switchToPreloadedProject(fadeTimeMs);
+}
+
+bool carla_cancel_preloaded_project(CarlaHostHandle handle)
+{
+    CARLA_SAFE_ASSERT_WITH_LAST_ERROR_RETURN(handle->engine != nullptr, "Engine is not initialized", false);
+
+    carla_debug("carla_cancel_preloaded_project(%p)", handle);
+
+    return handle->engine->cancelPreloadedProject();
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 
 bool carla_patchbay_connect(CarlaHostHandle handle, bool external, uint groupIdA, uint portIdA, uint groupIdB, uint portIdB)
@@ -1032,6 +1256,33 @@ bool carla_patchbay_refresh(CarlaHostHandle handle, bool external)
     return handle->engine->patchbayRefresh(true, false, external);
 }
 
+const char* carla_patchbay_get_snapshot(CarlaHostHandle handle, bool external)
+{
+    CARLA_SAFE_ASSERT_WITH_LAST_ERROR_RETURN(handle->engine != nullptr, "Engine is not initialized", nullptr);
+
+    carla_debug("carla_patchbay_get_snapshot(%p, %s)", handle, bool2str(external));
+
+    return handle->engine->getPatchbaySnapshot(true, false, external);
+}
+
+void carla_patchbay_begin_batch(CarlaHostHandle handle)
+{
+    CARLA_SAFE_ASSERT_RETURN(handle->engine != nullptr,);
+
+    carla_debug("carla_patchbay_begin_batch(%p)", handle);
+
+    handle->engine->patchbayBeginBatch();
+}
+
+void carla_patchbay_end_batch(CarlaHostHandle handle)
+{
+    CARLA_SAFE_ASSERT_RETURN(handle->engine != nullptr,);
+
+    carla_debug("carla_patchbay_end_batch(%p)", handle);
+
+    handle->engine->patchbayEndBatch();
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 
 void carla_transport_play(CarlaHostHandle handle)
@@ -1139,6 +1390,24 @@ bool carla_add_plugin(CarlaHostHandle handle,
     return handle->engine->addPlugin(btype, ptype, filename, name, label, uniqueId, extraPtr, options);
 }
 
+#ifndef BUILD_BRIDGE
+uint carla_add_plugin_async(CarlaHostHandle handle,
+                            BinaryType btype, PluginType ptype,
+                            const char* filename, const char* name, const char* label, int64_t uniqueId,
+                            const void* extraPtr, uint options)
+{
+    CARLA_SAFE_ASSERT_WITH_LAST_ERROR_RETURN(handle->engine != nullptr, "Engine is not initialized", 0);
+
+    carla_debug("carla_add_plugin_async(%p, %i:%s, %i:%s, \"%s\", \"%s\", \"%s\", " P_INT64 ", %p, %u)",
+                handle,
+                btype, CB::BinaryType2Str(btype),
+                ptype, CB::PluginType2Str(ptype),
+                filename, name, label, uniqueId, extraPtr, options);
+
+    return handle->engine->addPluginAsync(btype, ptype, filename, name, label, uniqueId, extraPtr, options);
+}
+#endif
+
 bool carla_remove_plugin(CarlaHostHandle handle, uint pluginId)
 {
     CARLA_SAFE_ASSERT_WITH_LAST_ERROR_RETURN(handle->engine != nullptr, "Engine is not initialized", false);
@@ -1158,6 +1427,16 @@ bool carla_remove_all_plugins(CarlaHostHandle handle)
 }
 
 #ifndef BUILD_BRIDGE
+bool carla_remove_plugins(CarlaHostHandle handle, const uint* pluginIds, uint count)
+{
+    CARLA_SAFE_ASSERT_WITH_LAST_ERROR_RETURN(handle->engine != nullptr, "Engine is not initialized", false);
+    CARLA_SAFE_ASSERT_RETURN(pluginIds != nullptr && count != 0, false);
+
+    carla_debug("carla_remove_plugins(%p, %p, %u)", handle, pluginIds, count);
+
+    return handle->engine->removePlugins(pluginIds, count);
+}
+
 bool carla_rename_plugin(CarlaHostHandle handle, uint pluginId, const char* newName)
 {
     CARLA_SAFE_ASSERT_RETURN(newName != nullptr && newName[0] != '\0', false);
@@ -1195,6 +1474,27 @@ bool carla_switch_plugins(CarlaHostHandle handle, uint pluginIdA, uint pluginIdB
 
     return handle->engine->switchPlugins(pluginIdA, pluginIdB);
 }
+
+bool carla_freeze_plugins(CarlaHostHandle handle,
+                          uint firstId, uint lastId, const char* filename, uint64_t frames)
+{
+    CARLA_SAFE_ASSERT_RETURN(firstId <= lastId, false);
+    CARLA_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', false);
+    CARLA_SAFE_ASSERT_WITH_LAST_ERROR_RETURN(handle->engine != nullptr, "Engine is not initialized", false);
+
+    carla_debug("carla_freeze_plugins(%p, %i, %i, \"%s\", " P_UINT64 ")", handle, firstId, lastId, filename, frames);
+
+    return handle->engine->freezePlugins(firstId, lastId, filename, frames);
+}
+
+bool carla_unfreeze_plugin(CarlaHostHandle handle, uint pluginId)
+{
+    CARLA_SAFE_ASSERT_WITH_LAST_ERROR_RETURN(handle->engine != nullptr, "Engine is not initialized", false);
+
+    carla_debug("carla_unfreeze_plugin(%p, %i)", handle, pluginId);
+
+    return handle->engine->unfreezePlugin(pluginId);
+}
 #endif
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -1846,6 +2146,30 @@ float carla_get_current_parameter_value(CarlaHostHandle handle, uint pluginId, u
     return 0.0f;
 }
 
+uint32_t carla_get_current_parameter_values(CarlaHostHandle handle, uint pluginId,
+                                            uint32_t parameterId, uint32_t count, float* values)
+{
+    CARLA_SAFE_ASSERT_RETURN(handle->engine != nullptr, 0);
+    CARLA_SAFE_ASSERT_RETURN(count == 0 || values != nullptr, 0);
+
+    if (const CarlaPluginPtr plugin = handle->engine->getPlugin(pluginId))
+    {
+        const uint32_t parameterCount = plugin->getParameterCount();
+
+        if (parameterId >= parameterCount)
+            return 0;
+
+        count = std::min(count, parameterCount - parameterId);
+
+        for (uint32_t i=0; i < count; ++i)
+            values[i] = plugin->getParameterValue(parameterId + i);
+
+        return count;
+    }
+
+    return 0;
+}
+
 float carla_get_internal_parameter_value(CarlaHostHandle handle, uint pluginId, int32_t parameterId)
 {
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
@@ -1884,6 +2208,189 @@ float carla_get_output_peak_value(CarlaHostHandle handle, uint pluginId, bool is
     return handle->engine->getOutputPeak(pluginId, isLeft);
 }
 
+const CarlaPluginProcessTimeInfo* carla_get_plugin_process_time_info(CarlaHostHandle handle, uint pluginId)
+{
+    static CarlaPluginProcessTimeInfo retInfo;
+
+    // reset
+    carla_zeroStruct(retInfo);
+
+    CARLA_SAFE_ASSERT_RETURN(handle->engine != nullptr, &retInfo);
+
+    const CB::EnginePluginProcessTimeInfo info(handle->engine->getPluginProcessTimeInfo(pluginId));
+
+    retInfo.count    = info.count;
+    retInfo.minUsecs = info.minUsecs;
+    retInfo.avgUsecs = info.avgUsecs;
+    retInfo.maxUsecs = info.maxUsecs;
+    retInfo.p99Usecs = info.p99Usecs;
+    retInfo.avgSubBlocks = info.avgSubBlocks;
+
+    return &retInfo;
+}
+
+void carla_reset_plugin_process_time_info(CarlaHostHandle handle, uint pluginId)
+{
+    CARLA_SAFE_ASSERT_RETURN(handle->engine != nullptr,);
+
+    handle->engine->resetPluginProcessTimeInfo(pluginId);
+}
+
+const CarlaRuntimeSnapshot* carla_get_runtime_snapshot(CarlaHostHandle handle)
+{
+    static CarlaRuntimeSnapshot retSnapshot;
+    static float* peaks = nullptr;
+    static uint peaksSize = 0;
+    static CarlaRuntimeParameterValue* parameters = nullptr;
+    static uint32_t parametersSize = 0;
+
+    // reset
+    retSnapshot.engine.load = 0.0f;
+    retSnapshot.engine.xruns = 0;
+    retSnapshot.pluginCount = 0;
+    retSnapshot.peaks = peaks;
+    retSnapshot.parameterCount = 0;
+    retSnapshot.parameters = parameters;
+
+    CARLA_SAFE_ASSERT_RETURN(handle->engine != nullptr, &retSnapshot);
+
+    CarlaEngine* const engine(handle->engine);
+
+    retSnapshot.engine.load = engine->getDSPLoad();
+    retSnapshot.engine.xruns = engine->getTotalXruns();
+
+    const uint pluginCount = engine->getCurrentPluginCount();
+
+    if (pluginCount == 0)
+        return &retSnapshot;
+
+    uint32_t parameterCount = 0;
+
+    for (uint i=0; i < pluginCount; ++i)
+    {
+        if (const CarlaPluginPtr plugin = engine->getPluginUnchecked(i))
+        {
+            for (uint32_t j=0, count=plugin->getParameterCount(); j < count; ++j)
+                if (plugin->isParameterOutput(j))
+                    ++parameterCount;
+        }
+    }
+
+    // buffers only grow, so they get reused on the next calls
+    if (pluginCount > peaksSize)
+    {
+        float* newPeaks;
+
+        try {
+            newPeaks = new float[pluginCount*4];
+        } CARLA_SAFE_EXCEPTION_RETURN("carla_get_runtime_snapshot peaks", &retSnapshot);
+
+        delete[] peaks;
+        peaks = newPeaks;
+        peaksSize = pluginCount;
+    }
+
+    if (parameterCount > parametersSize)
+    {
+        CarlaRuntimeParameterValue* newParameters;
+
+        try {
+            newParameters = new CarlaRuntimeParameterValue[parameterCount];
+        } CARLA_SAFE_EXCEPTION_RETURN("carla_get_runtime_snapshot parameters", &retSnapshot);
+
+        delete[] parameters;
+        parameters = newParameters;
+        parametersSize = parameterCount;
+    }
+
+    const uint peaksCount = engine->getAllPeaks(peaks, pluginCount);
+
+    if (peaksCount < pluginCount)
+        carla_zeroFloats(peaks + peaksCount*4, (pluginCount - peaksCount)*4);
+
+    uint32_t p = 0;
+
+    for (uint i=0; i < pluginCount; ++i)
+    {
+        if (const CarlaPluginPtr plugin = engine->getPluginUnchecked(i))
+        {
+            for (uint32_t j=0, count=plugin->getParameterCount(); j < count && p < parameterCount; ++j)
+            {
+                if (! plugin->isParameterOutput(j))
+                    continue;
+
+                CarlaRuntimeParameterValue& param(parameters[p++]);
+                param.pluginId = i;
+                param.parameterId = j;
+                param.value = plugin->getParameterValue(j);
+            }
+        }
+    }
+
+    retSnapshot.pluginCount = pluginCount;
+    retSnapshot.peaks = peaks;
+    retSnapshot.parameterCount = p;
+    retSnapshot.parameters = parameters;
+
+    return &retSnapshot;
+}
+
+const CarlaEngineCycleHistory* carla_get_engine_cycle_history(CarlaHostHandle handle, uint maxCount)
+{
+    static CarlaEngineCycleHistory retHistory;
+    static CB::EngineCycleRecord* records = nullptr;
+    static CarlaEngineCycleInfo* cycles = nullptr;
+    static uint cyclesSize = 0;
+
+    // reset
+    retHistory.count = 0;
+    retHistory.cycles = cycles;
+
+    CARLA_SAFE_ASSERT_RETURN(handle->engine != nullptr, &retHistory);
+
+    if (maxCount == 0)
+        return &retHistory;
+
+    // buffers only grow, so they get reused on the next calls
+    if (maxCount > cyclesSize)
+    {
+        delete[] records;
+        delete[] cycles;
+        records = nullptr;
+        cycles = nullptr;
+        cyclesSize = 0;
+        retHistory.cycles = nullptr;
+
+        try {
+            records = new CB::EngineCycleRecord[maxCount];
+            cycles = new CarlaEngineCycleInfo[maxCount];
+        } CARLA_SAFE_EXCEPTION_RETURN("carla_get_engine_cycle_history", &retHistory);
+
+        cyclesSize = maxCount;
+    }
+
+    const uint count = handle->engine->getCycleRecords(records, maxCount);
+
+    for (uint i=0; i < count; ++i)
+    {
+        const CB::EngineCycleRecord& record(records[i]);
+        CarlaEngineCycleInfo& cycle(cycles[i]);
+
+        cycle.startTime    = record.startTime;
+        cycle.frames       = record.frames;
+        cycle.totalUsecs   = record.totalUsecs;
+        cycle.prepareUsecs = record.prepareUsecs;
+        cycle.processUsecs = record.processUsecs;
+        cycle.postUsecs    = record.postUsecs;
+        cycle.xruns        = record.xruns;
+    }
+
+    retHistory.count = count;
+    retHistory.cycles = cycles;
+
+    return &retHistory;
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 
 CARLA_BACKEND_START_NAMESPACE
@@ -2010,6 +2517,40 @@ void carla_set_parameter_value(CarlaHostHandle handle, uint pluginId, uint32_t p
 
 #ifndef BUILD_BRIDGE
 
+bool carla_set_parameter_values(CarlaHostHandle handle, uint pluginId,
+                                uint32_t count, const uint32_t* parameterIds, const float* values)
+{
+    CARLA_SAFE_ASSERT_WITH_LAST_ERROR_RETURN(handle->engine != nullptr, "Engine is not initialized", false);
+    CARLA_SAFE_ASSERT_RETURN(count == 0 || (parameterIds != nullptr && values != nullptr), false);
+
+    carla_debug("carla_set_parameter_values(%p, %i, %u, %p, %p)", handle, pluginId, count, parameterIds, values);
+
+    if (count == 0)
+        return true;
+
+    std::vector<uint> pluginIds;
+
+    try {
+        pluginIds.resize(count, pluginId);
+    } CARLA_SAFE_EXCEPTION_RETURN("carla_set_parameter_values", false);
+
+    return handle->engine->setParameterValues(pluginIds.data(), parameterIds, values, count);
+}
+
+bool carla_set_multiple_parameter_values(CarlaHostHandle handle, uint32_t count, const uint* pluginIds,
+                                         const uint32_t* parameterIds, const float* values)
+{
+    CARLA_SAFE_ASSERT_WITH_LAST_ERROR_RETURN(handle->engine != nullptr, "Engine is not initialized", false);
+    CARLA_SAFE_ASSERT_RETURN(count == 0 || (pluginIds != nullptr && parameterIds != nullptr && values != nullptr), false);
+
+    carla_debug("carla_set_multiple_parameter_values(%p, %u, %p, %p, %p)", handle, count, pluginIds, parameterIds, values);
+
+    if (count == 0)
+        return true;
+
+    return handle->engine->setParameterValues(pluginIds, parameterIds, values, count);
+}
+
 void carla_set_parameter_midi_channel(CarlaHostHandle handle, uint pluginId, uint32_t parameterId, uint8_t channel)
 {
     CARLA_SAFE_ASSERT_RETURN(handle->engine != nullptr,);
@@ -2067,7 +2608,7 @@ void carla_set_program(CarlaHostHandle handle, uint pluginId, uint32_t programId
     {
         CARLA_SAFE_ASSERT_RETURN(programId < plugin->getProgramCount(),);
 
-        plugin->setProgram(static_cast<int32_t>(programId), true, true, false);
+        plugin->requestProgramChange(static_cast<int32_t>(programId), true, true, false);
     }
 }
 
@@ -2079,7 +2620,7 @@ void carla_set_midi_program(CarlaHostHandle handle, uint pluginId, uint32_t midi
     {
         CARLA_SAFE_ASSERT_RETURN(midiProgramId < plugin->getMidiProgramCount(),);
 
-        plugin->setMidiProgram(static_cast<int32_t>(midiProgramId), true, true, false);
+        plugin->requestMidiProgramChange(static_cast<int32_t>(midiProgramId), true, true, false);
     }
 }
 
@@ -2195,6 +2736,15 @@ double carla_get_sample_rate(CarlaHostHandle handle)
     return handle->engine->getSampleRate();
 }
 
+uint64_t carla_get_locked_memory_size(CarlaHostHandle handle)
+{
+    carla_debug("carla_get_locked_memory_size(%p)", handle);
+    return CarlaMemoryLock::getInstance().getLockedSize();
+
+    // unused
+    (void)handle;
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 
 const char* carla_get_last_error(CarlaHostHandle handle)
@@ -21,6 +21,7 @@
 #include "CarlaBackend.h"
 
 #ifdef __cplusplus
+using CarlaBackend::BinaryType;
 using CarlaBackend::PluginCategory;
 using CarlaBackend::PluginType;
 #endif
@@ -138,6 +139,100 @@ typedef struct _CarlaCachedPluginInfo {
 
 } CarlaCachedPluginInfo;
 
+/*!
+ * Information about a plugin in the plugin index.
+ * String pointers remain valid until the index is next modified.
+ * @see carla_plugin_index_get_info()
+ */
+typedef struct _CarlaPluginIndexInfo {
+    /*!
+     * Plugin type.
+     */
+    PluginType type;
+
+    /*!
+     * Binary type.
+     */
+    BinaryType btype;
+
+    /*!
+     * Plugin category.
+     */
+    PluginCategory category;
+
+    /*!
+     * Plugin hints.
+     * @see PluginHints
+     */
+    uint hints;
+
+    /*!
+     * Number of audio inputs.
+     */
+    uint32_t audioIns;
+
+    /*!
+     * Number of audio outputs.
+     */
+    uint32_t audioOuts;
+
+    /*!
+     * Number of CV inputs.
+     */
+    uint32_t cvIns;
+
+    /*!
+     * Number of CV outputs.
+     */
+    uint32_t cvOuts;
+
+    /*!
+     * Number of MIDI inputs.
+     */
+    uint32_t midiIns;
+
+    /*!
+     * Number of MIDI outputs.
+     */
+    uint32_t midiOuts;
+
+    /*!
+     * Number of input parameters.
+     */
+    uint32_t parameterIns;
+
+    /*!
+     * Number of output parameters.
+     */
+    uint32_t parameterOuts;
+
+    /*!
+     * Plugin unique Id, 0 if the plugin format does not have one.
+     */
+    int64_t uniqueId;
+
+    /*!
+     * Plugin filename or bundle path.
+     */
+    const char* filename;
+
+    /*!
+     * Plugin label, or URI for LV2 plugins.
+     */
+    const char* label;
+
+    /*!
+     * Plugin name.
+     */
+    const char* name;
+
+    /*!
+     * Plugin author/maker.
+     */
+    const char* maker;
+
+} CarlaPluginIndexInfo;
+
 /* --------------------------------------------------------------------------------------------------------------------
  * get stuff */
 
@@ -178,6 +273,67 @@ CARLA_EXPORT uint carla_get_cached_plugin_count(PluginType ptype, const char* pl
  */
 CARLA_EXPORT const CarlaCachedPluginInfo* carla_get_cached_plugin_info(PluginType ptype, uint index);
 
+/* --------------------------------------------------------------------------------------------------------------------
+ * plugin index */
+
+/*!
+ * Remove all plugins from the plugin index.
+ */
+CARLA_EXPORT void carla_plugin_index_clear(void);
+
+/*!
+ * Add a plugin to the plugin index, replacing any previous entry with the same type and label.
+ * All strings are copied.
+ */
+CARLA_EXPORT bool carla_plugin_index_add(const CarlaPluginIndexInfo* info);
+
+/*!
+ * Add all valid cached plugins of type @a ptype to the plugin index.
+ * Returns the number of plugins added.
+ * @see carla_get_cached_plugin_count()
+ *
+ * @note if this carla build uses JUCE, then you must call carla_juce_init beforehand
+ */
+CARLA_EXPORT uint carla_plugin_index_add_cached(PluginType ptype, const char* pluginPath);
+
+/*!
+ * Load the plugin index from @a filename, replacing the current one.
+ */
+CARLA_EXPORT bool carla_plugin_index_load(const char* filename);
+
+/*!
+ * Save the plugin index to @a filename, in a compact binary format.
+ */
+CARLA_EXPORT bool carla_plugin_index_save(const char* filename);
+
+/*!
+ * Get how many plugins are in the plugin index.
+ */
+CARLA_EXPORT uint carla_plugin_index_count(void);
+
+/*!
+ * Get information about a plugin in the plugin index.
+ */
+CARLA_EXPORT const CarlaPluginIndexInfo* carla_plugin_index_get_info(uint index);
+
+/*!
+ * Find a plugin in the plugin index by its label (URI for LV2 plugins).
+ * Returns the plugin index, or -1 if not found.
+ */
+CARLA_EXPORT int carla_plugin_index_find_by_label(PluginType ptype, const char* label);
+
+/*!
+ * Find a plugin in the plugin index by its unique Id.
+ * Returns the plugin index, or -1 if not found.
+ */
+CARLA_EXPORT int carla_plugin_index_find_by_unique_id(PluginType ptype, int64_t uniqueId);
+
+/*!
+ * Find a plugin in the plugin index by its name, of any type.
+ * Returns the plugin index, or -1 if not found.
+ */
+CARLA_EXPORT int carla_plugin_index_find_by_name(const char* name);
+
 /* --------------------------------------------------------------------------------------------------------------------
  * set stuff */
 
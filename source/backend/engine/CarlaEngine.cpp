@@ -35,15 +35,19 @@
 #include "CarlaProcessUtils.hpp"
 #include "CarlaScopeUtils.hpp"
 #include "CarlaStateUtils.hpp"
+#include "CarlaThreadPool.hpp"
 #include "CarlaMIDI.h"
 
 #include "jackbridge/JackBridge.hpp"
 
 #include "water/files/File.h"
+#include "water/files/FileInputStream.h"
 #include "water/streams/MemoryOutputStream.h"
 #include "water/xml/XmlDocument.h"
 #include "water/xml/XmlElement.h"
 
+#include <algorithm>
+#include <functional>
 #include <map>
 
 // FIXME Remove on 2.1 release
@@ -52,6 +56,7 @@
 using water::Array;
 using water::CharPointer_UTF8;
 using water::File;
+using water::FileInputStream;
 using water::MemoryOutputStream;
 using water::String;
 using water::StringArray;
@@ -249,6 +254,8 @@ CarlaEngine* CarlaEngine::newDriverByName(const char* const driverName)
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     if (std::strcmp(driverName, "Dummy") == 0)
         return newDummy();
+    if (std::strcmp(driverName, "Render") == 0)
+        return newRender();
 #endif
 
 #ifndef BUILD_BRIDGE
@@ -343,6 +350,11 @@ bool CarlaEngine::close()
 {
     carla_debug("CarlaEngine::close()");
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    // plugins still loading in the background are never added
+    pData->pluginLoader.stop();
+#endif
+
     if (pData->curPluginCount != 0)
     {
         pData->aboutToClose = true;
@@ -362,10 +374,13 @@ bool CarlaEngine::usesConstantBufferSize() const noexcept
 
 void CarlaEngine::idle() noexcept
 {
-    CARLA_SAFE_ASSERT_RETURN(pData->nextAction.opcode == kEnginePostActionNull,);
+    CARLA_SAFE_ASSERT_RETURN(pData->nextAction.isEmpty(),);
     CARLA_SAFE_ASSERT_RETURN(pData->nextPluginId == pData->maxPluginNumber,);
     CARLA_SAFE_ASSERT_RETURN(getType() != kEngineTypePlugin,);
 
+    if (pData->options.asyncCallbacks)
+        pData->callbackQueue.dispatch(pData->callback, pData->callbackPtr);
+
     const bool engineNotRunning = !isRunning();
 
     for (uint i=0; i < pData->curPluginCount; ++i)
@@ -403,9 +418,22 @@ void CarlaEngine::idle() noexcept
     pData->osc.idle();
 #endif
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    try {
+        pData->pluginLoader.idle();
+    } CARLA_SAFE_EXCEPTION("Plugin loader idle");
+
+    pData->cycleLog.dumpOnXrun(pData->xruns, pData->sampleRate);
+#endif
+
     pData->deletePluginsAsNeeded();
 }
 
+void CarlaEngine::requestIdle() noexcept
+{
+    pData->thread.wakeUp();
+}
+
 CarlaEngineClient* CarlaEngine::addClient(CarlaPluginPtr plugin)
 {
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
@@ -453,66 +481,48 @@ bool CarlaEngine::setBufferSizeAndSampleRate(const uint, const double)
     return false;
 }
 
+bool CarlaEngine::renderToFile(const char* const, const uint64_t)
+{
+    setLastError("Rendering to file is only supported by the Render engine driver");
+    return false;
+}
+
 // -----------------------------------------------------------------------
 // Plugin management
 
-bool CarlaEngine::addPlugin(const BinaryType btype,
-                            const PluginType ptype,
-                            const char* const filename,
-                            const char* const name,
-                            const char* const label,
-                            const int64_t uniqueId,
-                            const void* const extra,
-                            const uint options)
+/*
+ * Binary type and extra data for addPlugin(), to load a plugin from its saved state.
+ */
+static BinaryType getStateSaveBinaryType(const CarlaStateSave& stateSave, const PluginType ptype, const void*& extra)
 {
-    CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
-#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-    CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins != nullptr, "Invalid engine internal data");
-    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextPluginId <= pData->maxPluginNumber, "Invalid engine internal data");
-#endif
-    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.opcode == kEnginePostActionNull, "Invalid engine internal data");
-    CARLA_SAFE_ASSERT_RETURN_ERR(btype != BINARY_NONE, "Invalid plugin binary mode");
-    CARLA_SAFE_ASSERT_RETURN_ERR(ptype != PLUGIN_NONE, "Invalid plugin type");
-    CARLA_SAFE_ASSERT_RETURN_ERR((filename != nullptr && filename[0] != '\0') || (label != nullptr && label[0] != '\0'), "Invalid plugin filename and label");
-    carla_debug("CarlaEngine::addPlugin(%i:%s, %i:%s, \"%s\", \"%s\", \"%s\", " P_INT64 ", %p, %u)",
-                btype, BinaryType2Str(btype), ptype, PluginType2Str(ptype), filename, name, label, uniqueId, extra, options);
-
-#ifndef CARLA_OS_WIN
-    if (ptype != PLUGIN_JACK && ptype != PLUGIN_LV2 && filename != nullptr && filename[0] != '\0') {
-        CARLA_SAFE_ASSERT_RETURN_ERR(filename[0] == CARLA_OS_SEP || filename[0] == '.' || filename[0] == '~', "Invalid plugin filename");
-    }
-#endif
-
-    uint id;
+    static const char kTrue[] = "true";
 
-#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-    CarlaPluginPtr oldPlugin;
-
-    if (pData->nextPluginId < pData->curPluginCount)
-    {
-        id = pData->nextPluginId;
-        pData->nextPluginId = pData->maxPluginNumber;
+    extra = nullptr;
 
-        oldPlugin = pData->plugins[id].plugin;
+    if (ptype == PLUGIN_SF2 && CarlaString(stateSave.label).endsWith(" (16 outs)"))
+        extra = kTrue;
 
-        CARLA_SAFE_ASSERT_RETURN_ERR(oldPlugin.get() != nullptr, "Invalid replace plugin Id");
-    }
-    else
-#endif
+    switch (ptype)
     {
-        id = pData->curPluginCount;
-
-        if (id == pData->maxPluginNumber)
-        {
-            setLastError("Maximum number of plugins reached");
-            return false;
-        }
-
-#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-        CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins[id].plugin.get() == nullptr, "Invalid engine internal data");
-#endif
+    case PLUGIN_LADSPA:
+    case PLUGIN_DSSI:
+    case PLUGIN_VST2:
+        return getBinaryTypeFromFile(stateSave.binary);
+    default:
+        return BINARY_NATIVE;
     }
+}
 
+CarlaPluginPtr CarlaEngine::createPlugin(const BinaryType btype,
+                                         const PluginType ptype,
+                                         const uint id,
+                                         const char* const filename,
+                                         const char* const name,
+                                         const char* const label,
+                                         const int64_t uniqueId,
+                                         const void* const extra,
+                                         const uint options)
+{
     CarlaPlugin::Initializer initializer = {
         this,
         id,
@@ -592,7 +602,7 @@ bool CarlaEngine::addPlugin(const BinaryType btype,
         else
         {
             setLastError("This Carla build cannot handle this binary");
-            return false;
+            return CarlaPluginPtr();
         }
     }
     else
@@ -683,7 +693,7 @@ bool CarlaEngine::addPlugin(const BinaryType btype,
     }
 
     if (plugin.get() == nullptr)
-        return false;
+        return plugin;
 
     plugin->reload();
 
@@ -719,12 +729,96 @@ bool CarlaEngine::addPlugin(const BinaryType btype,
     }
 
     if (! canRun)
+        return CarlaPluginPtr();
+
+    return plugin;
+}
+
+bool CarlaEngine::addPlugin(const BinaryType btype,
+                            const PluginType ptype,
+                            const char* const filename,
+                            const char* const name,
+                            const char* const label,
+                            const int64_t uniqueId,
+                            const void* const extra,
+                            const uint options)
+{
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins != nullptr, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextPluginId <= pData->maxPluginNumber, "Invalid engine internal data");
+#endif
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.isEmpty(), "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(btype != BINARY_NONE, "Invalid plugin binary mode");
+    CARLA_SAFE_ASSERT_RETURN_ERR(ptype != PLUGIN_NONE, "Invalid plugin type");
+    CARLA_SAFE_ASSERT_RETURN_ERR((filename != nullptr && filename[0] != '\0') || (label != nullptr && label[0] != '\0'), "Invalid plugin filename and label");
+    carla_debug("CarlaEngine::addPlugin(%i:%s, %i:%s, \"%s\", \"%s\", \"%s\", " P_INT64 ", %p, %u)",
+                btype, BinaryType2Str(btype), ptype, PluginType2Str(ptype), filename, name, label, uniqueId, extra, options);
+
+#ifndef CARLA_OS_WIN
+    if (ptype != PLUGIN_JACK && ptype != PLUGIN_LV2 && filename != nullptr && filename[0] != '\0') {
+        CARLA_SAFE_ASSERT_RETURN_ERR(filename[0] == CARLA_OS_SEP || filename[0] == '.' || filename[0] == '~', "Invalid plugin filename");
+    }
+#endif
+
+    uint id;
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    CarlaPluginPtr oldPlugin;
+
+    if (pData->nextPluginId < pData->curPluginCount)
     {
-        return false;
+        id = pData->nextPluginId;
+        pData->nextPluginId = pData->maxPluginNumber;
+
+        oldPlugin = pData->plugins[id].plugin;
+
+        CARLA_SAFE_ASSERT_RETURN_ERR(oldPlugin.get() != nullptr, "Invalid replace plugin Id");
+    }
+    else
+#endif
+    {
+        id = pData->curPluginCount;
+
+        if (id == pData->maxPluginNumber)
+        {
+            setLastError("Maximum number of plugins reached");
+            return false;
+        }
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+        CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins[id].plugin.get() == nullptr, "Invalid engine internal data");
+#endif
     }
 
+    const CarlaPluginPtr plugin = createPlugin(btype, ptype, id, filename, name, label, uniqueId, extra, options);
+
+    if (plugin.get() == nullptr)
+        return false;
+
     EnginePluginData& pluginData(pData->plugins[id]);
-    pluginData.plugin = plugin;
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    // when crossfading, the old plugin keeps its slot until the audio thread swaps them
+    uint32_t crossfadeFrames = 0;
+
+    if (oldPlugin.get() != nullptr && pData->options.replacePluginCrossfade != 0 && isRunning() && ! isOffline()
+        && pData->graph.isReady()
+        && (pData->options.processMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK ||
+            pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY))
+    {
+        crossfadeFrames = static_cast<uint32_t>(pData->sampleRate * pData->options.replacePluginCrossfade / 1000);
+
+        if (! pData->graph.stagePluginSwap(oldPlugin, plugin))
+            crossfadeFrames = 0;
+    }
+
+    if (crossfadeFrames == 0)
+#endif
+        pluginData.plugin = plugin;
+
+    pluginData.peaksEnabled = true;
+    pluginData.processStats.requestReset();
     carla_zeroFloats(pluginData.peaks, 4);
 
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
@@ -732,26 +826,44 @@ bool CarlaEngine::addPlugin(const BinaryType btype,
     {
         CARLA_SAFE_ASSERT(! pData->loadingProject);
 
-        const ScopedThreadStopper sts(this);
-
-        if (pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
-            pData->graph.replacePlugin(oldPlugin, plugin);
-
         const bool  wasActive = oldPlugin->getInternalParameterValue(PARAMETER_ACTIVE) >= 0.5f;
         const float oldDryWet = oldPlugin->getInternalParameterValue(PARAMETER_DRYWET);
         const float oldVolume = oldPlugin->getInternalParameterValue(PARAMETER_VOLUME);
 
-        oldPlugin->prepareForDeletion();
-        pData->pluginsToDelete.push_back(oldPlugin);
-
         if (plugin->getHints() & PLUGIN_CAN_DRYWET)
             plugin->setDryWet(oldDryWet, true, true);
 
         if (plugin->getHints() & PLUGIN_CAN_VOLUME)
             plugin->setVolume(oldVolume, true, true);
 
-        plugin->setActive(wasActive, true, true);
-        plugin->setEnabled(true);
+        if (crossfadeFrames != 0)
+        {
+            // the new plugin must be running before it is swapped in, the old one keeps going during the fade
+            plugin->setActive(wasActive, true, true);
+            plugin->setEnabled(true);
+
+            pData->pluginsFadingOut.push_back(oldPlugin);
+            pData->pluginToSwapIn = plugin;
+
+            {
+                const ScopedActionLock sal(this, kEnginePostActionReplacePlugin, id, crossfadeFrames);
+            }
+
+            pData->graph.finishPluginSwap(plugin);
+        }
+        else
+        {
+            const ScopedThreadStopper sts(this);
+
+            if (pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
+                pData->graph.replacePlugin(oldPlugin, plugin);
+
+            oldPlugin->prepareForDeletion();
+            pData->pluginsToDelete.push_back(oldPlugin);
+
+            plugin->setActive(wasActive, true, true);
+            plugin->setEnabled(true);
+        }
 
         callback(true, true, ENGINE_CALLBACK_RELOAD_ALL, id, 0, 0, 0, 0.0f, nullptr);
     }
@@ -785,6 +897,95 @@ bool CarlaEngine::addPlugin(const PluginType ptype,
     return addPlugin(BINARY_NATIVE, ptype, filename, name, label, uniqueId, extra, PLUGIN_OPTIONS_NULL);
 }
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+uint CarlaEngine::addPluginAsync(const BinaryType btype,
+                                 const PluginType ptype,
+                                 const char* const filename,
+                                 const char* const name,
+                                 const char* const label,
+                                 const int64_t uniqueId,
+                                 const void* const extra,
+                                 const uint options)
+{
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins != nullptr, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.isEmpty(), "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(btype != BINARY_NONE, "Invalid plugin binary mode");
+    CARLA_SAFE_ASSERT_RETURN_ERR(ptype != PLUGIN_NONE, "Invalid plugin type");
+    CARLA_SAFE_ASSERT_RETURN_ERR((filename != nullptr && filename[0] != '\0') || (label != nullptr && label[0] != '\0'), "Invalid plugin filename and label");
+    carla_debug("CarlaEngine::addPluginAsync(%i:%s, %i:%s, \"%s\", \"%s\", \"%s\", " P_INT64 ", %p, %u)",
+                btype, BinaryType2Str(btype), ptype, PluginType2Str(ptype), filename, name, label, uniqueId, extra, options);
+
+    const bool isBridged = ptype != PLUGIN_INTERNAL
+                        && ptype != PLUGIN_SF2
+                        && ptype != PLUGIN_SFZ
+                        && ptype != PLUGIN_JACK
+                        && (btype != BINARY_NATIVE || pData->options.preferPluginBridges);
+    const bool isSoundKit = ptype == PLUGIN_DLS || ptype == PLUGIN_GIG || ptype == PLUGIN_SF2;
+
+    // VST2, VST3, AU and JACK applications expect to be created on the main thread, unless bridged
+    bool canLoadInBackground;
+
+    switch (ptype)
+    {
+    case PLUGIN_LADSPA:
+    case PLUGIN_DSSI:
+    case PLUGIN_LV2:
+    case PLUGIN_INTERNAL:
+    case PLUGIN_DLS:
+    case PLUGIN_GIG:
+    case PLUGIN_SF2:
+    case PLUGIN_SFZ:
+        canLoadInBackground = true;
+        break;
+    default:
+        canLoadInBackground = isBridged;
+        break;
+    }
+
+    // extra data is not owned by us, only the sound kit flag can be kept for later
+    if (extra != nullptr && ! isSoundKit)
+        canLoadInBackground = false;
+
+    if (pData->nextPluginId < pData->curPluginCount || pData->loadingProject)
+        canLoadInBackground = false;
+
+    if (getType() == kEngineTypeBridge || getType() == kEngineTypePlugin)
+        canLoadInBackground = false;
+
+    const char* const displayName = (name != nullptr && name[0] != '\0')
+                                  ? name
+                                  : (label != nullptr && label[0] != '\0') ? label : filename;
+
+    if (canLoadInBackground)
+    {
+        const bool use16Outs = isSoundKit && extra != nullptr && std::strcmp((const char*)extra, "true") == 0;
+        const uint provisionalId = std::min(pData->curPluginCount, pData->maxPluginNumber - 1);
+
+        if (const uint requestId = pData->pluginLoader.add(btype, ptype, provisionalId,
+                                                           filename, name, label, uniqueId,
+                                                           use16Outs, options))
+            return requestId;
+
+        carla_stderr("CarlaEngine::addPluginAsync() - failed to start loader thread, adding plugin directly");
+    }
+
+    const uint requestId = pData->pluginLoader.getNextRequestId();
+    const uint id = pData->nextPluginId < pData->curPluginCount ? pData->nextPluginId : pData->curPluginCount;
+
+    callback(true, true, ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS, 0, static_cast<int>(requestId), 1, 0, 0.0f, displayName);
+
+    if (! addPlugin(btype, ptype, filename, name, label, uniqueId, extra, options))
+    {
+        callback(true, true, ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS, 0, static_cast<int>(requestId), -1, 0, 0.0f, getLastError());
+        return 0;
+    }
+
+    callback(true, true, ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS, id, static_cast<int>(requestId), 2, 0, 0.0f, displayName);
+    return requestId;
+}
+#endif
+
 bool CarlaEngine::removePlugin(const uint id)
 {
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
@@ -794,7 +995,7 @@ bool CarlaEngine::removePlugin(const uint id)
 #else
     CARLA_SAFE_ASSERT_RETURN_ERR(id == 0, "Invalid engine internal data");
 #endif
-    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.opcode == kEnginePostActionNull, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.isEmpty(), "Invalid engine internal data");
     CARLA_SAFE_ASSERT_RETURN_ERR(id < pData->curPluginCount, "Invalid plugin Id");
     carla_debug("CarlaEngine::removePlugin(%i)", id);
 
@@ -832,6 +1033,65 @@ bool CarlaEngine::removePlugin(const uint id)
     return true;
 }
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+bool CarlaEngine::removePlugins(const uint* const ids, const uint count)
+{
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins != nullptr, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->curPluginCount != 0, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.isEmpty(), "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(ids != nullptr && count != 0, "Invalid plugin Id list");
+    carla_debug("CarlaEngine::removePlugins(%p, %u)", ids, count);
+
+    // highest ids first, so each removal keeps the ids of the plugins still to be removed
+    std::vector<uint> sortedIds(ids, ids + count);
+    std::sort(sortedIds.begin(), sortedIds.end(), std::greater<uint>());
+
+    std::vector<CarlaPluginPtr> plugins;
+    std::vector<EngineNextAction::Action> actions;
+    plugins.reserve(count);
+    actions.reserve(count);
+
+    for (uint i=0; i < count; ++i)
+    {
+        const uint id = sortedIds[i];
+        CARLA_SAFE_ASSERT_RETURN_ERR(id < pData->curPluginCount, "Invalid plugin Id");
+        CARLA_SAFE_ASSERT_RETURN_ERR(i == 0 || id != sortedIds[i-1], "Invalid plugin Id list, contains duplicates");
+
+        const CarlaPluginPtr plugin = pData->plugins[id].plugin;
+
+        CARLA_SAFE_ASSERT_RETURN_ERR(plugin.get() != nullptr, "Could not find plugin to remove");
+        CARLA_SAFE_ASSERT_RETURN_ERR(plugin->getId() == id, "Invalid engine internal data");
+
+        const EngineNextAction::Action action = { kEnginePostActionRemovePlugin, id, 0 };
+        plugins.push_back(plugin);
+        actions.push_back(action);
+    }
+
+    const ScopedThreadStopper sts(this);
+
+    if (pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
+    {
+        for (uint i=0; i < count; ++i)
+            pData->graph.removePlugin(plugins[i]);
+    }
+
+    {
+        const ScopedActionLock sal(this, actions.data(), count);
+    }
+
+    for (uint i=0; i < count; ++i)
+    {
+        plugins[i]->prepareForDeletion();
+        pData->pluginsToDelete.push_back(plugins[i]);
+
+        callback(true, true, ENGINE_CALLBACK_PLUGIN_REMOVED, sortedIds[i], 0, 0, 0, 0.0f, nullptr);
+    }
+
+    return true;
+}
+#endif
+
 bool CarlaEngine::removeAllPlugins()
 {
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
@@ -839,9 +1099,14 @@ bool CarlaEngine::removeAllPlugins()
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins != nullptr, "Invalid engine internal data");
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextPluginId == pData->maxPluginNumber, "Invalid engine internal data");
 #endif
-    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.opcode == kEnginePostActionNull, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.isEmpty(), "Invalid engine internal data");
     carla_debug("CarlaEngine::removeAllPlugins()");
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    if (! pData->preloadedProject.loading)
+        pData->preloadedProject.clear();
+#endif
+
     if (pData->curPluginCount == 0)
         return true;
 
@@ -882,7 +1147,7 @@ bool CarlaEngine::renamePlugin(const uint id, const char* const newName)
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins != nullptr, "Invalid engine internal data");
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->curPluginCount != 0, "Invalid engine internal data");
-    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.opcode == kEnginePostActionNull, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.isEmpty(), "Invalid engine internal data");
     CARLA_SAFE_ASSERT_RETURN_ERR(id < pData->curPluginCount, "Invalid plugin Id");
     CARLA_SAFE_ASSERT_RETURN_ERR(newName != nullptr && newName[0] != '\0', "Invalid plugin name");
     carla_debug("CarlaEngine::renamePlugin(%i, \"%s\")", id, newName);
@@ -910,7 +1175,7 @@ bool CarlaEngine::clonePlugin(const uint id)
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins != nullptr, "Invalid engine internal data");
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->curPluginCount != 0, "Invalid engine internal data");
-    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.opcode == kEnginePostActionNull, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.isEmpty(), "Invalid engine internal data");
     CARLA_SAFE_ASSERT_RETURN_ERR(id < pData->curPluginCount, "Invalid plugin Id");
     carla_debug("CarlaEngine::clonePlugin(%i)", id);
 
@@ -948,7 +1213,7 @@ bool CarlaEngine::replacePlugin(const uint id) noexcept
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins != nullptr, "Invalid engine internal data");
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->curPluginCount != 0, "Invalid engine internal data");
-    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.opcode == kEnginePostActionNull, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.isEmpty(), "Invalid engine internal data");
     carla_debug("CarlaEngine::replacePlugin(%i)", id);
 
     // might use this to reset
@@ -970,12 +1235,53 @@ bool CarlaEngine::replacePlugin(const uint id) noexcept
     return true;
 }
 
+bool CarlaEngine::wakeDormantPlugin(const uint id)
+{
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins != nullptr, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(id < pData->curPluginCount, "Invalid plugin Id");
+    carla_debug("CarlaEngine::wakeDormantPlugin(%i)", id);
+
+    // keeps the saved state around until the new plugin has restored it
+    const CarlaPluginPtr dormantPlugin = pData->plugins[id].plugin;
+
+    CARLA_SAFE_ASSERT_RETURN_ERR(dormantPlugin.get() != nullptr, "Could not find plugin to wake");
+    CARLA_SAFE_ASSERT_RETURN_ERR(dormantPlugin->isDormant(), "Plugin is not dormant");
+
+    const CarlaStateSave& stateSave(dormantPlugin->getStateSave(false));
+    CARLA_SAFE_ASSERT_RETURN_ERR(stateSave.type != nullptr, "Invalid plugin state");
+
+    const PluginType ptype(getPluginTypeFromString(stateSave.type));
+    const void* extraStuff;
+    const BinaryType btype(getStateSaveBinaryType(stateSave, ptype, extraStuff));
+
+    if (! replacePlugin(id))
+        return false;
+
+    if (! addPlugin(btype, ptype, stateSave.binary,
+                    stateSave.name, stateSave.label, stateSave.uniqueId, extraStuff, stateSave.options))
+    {
+        pData->nextPluginId = pData->maxPluginNumber;
+        return false;
+    }
+
+    const CarlaPluginPtr plugin = pData->plugins[id].plugin;
+    CARLA_SAFE_ASSERT_RETURN_ERR(plugin.get() != nullptr && plugin != dormantPlugin, "Invalid engine internal data");
+
+    plugin->loadStateSave(stateSave);
+
+    // the dormant plugin was still holding the saved name while the new one got added
+    if (stateSave.name != nullptr && std::strcmp(plugin->getName(), stateSave.name) != 0)
+        renamePlugin(id, stateSave.name);
+
+    return true;
+}
+
 bool CarlaEngine::switchPlugins(const uint idA, const uint idB) noexcept
 {
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins != nullptr, "Invalid engine internal data");
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->curPluginCount >= 2, "Invalid engine internal data");
-    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.opcode == kEnginePostActionNull, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.isEmpty(), "Invalid engine internal data");
     CARLA_SAFE_ASSERT_RETURN_ERR(idA != idB, "Invalid operation, cannot switch plugin with itself");
     CARLA_SAFE_ASSERT_RETURN_ERR(idA < pData->curPluginCount, "Invalid plugin Id");
     CARLA_SAFE_ASSERT_RETURN_ERR(idB < pData->curPluginCount, "Invalid plugin Id");
@@ -1007,19 +1313,74 @@ bool CarlaEngine::switchPlugins(const uint idA, const uint idB) noexcept
 
     return true;
 }
-#endif
 
-void CarlaEngine::touchPluginParameter(const uint, const uint32_t, const bool) noexcept
+bool CarlaEngine::setParameterValues(const uint* const pluginIds, const uint32_t* const parameterIds,
+                                     const float* const values, const uint count)
 {
-}
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins != nullptr, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.isEmpty(), "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pluginIds != nullptr && parameterIds != nullptr && values != nullptr,
+                                 "Invalid parameter values");
+    carla_debug("CarlaEngine::setParameterValues(%p, %p, %p, %u)", pluginIds, parameterIds, values, count);
 
-CarlaPluginPtr CarlaEngine::getPlugin(const uint id) const noexcept
-{
-#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    std::vector<EngineStagedParameterValue> staged;
+    CarlaString records;
+    char strBuf[STR_MAX];
+
+    try {
+        staged.reserve(count);
+    } CARLA_SAFE_EXCEPTION_RETURN_ERR("setParameterValues reserve", "Out of memory");
+
+    for (uint i=0; i < count; ++i)
+    {
+        const uint pluginId = pluginIds[i];
+        const uint32_t parameterId = parameterIds[i];
+        CARLA_SAFE_ASSERT_UINT2_CONTINUE(pluginId < pData->curPluginCount, pluginId, pData->curPluginCount);
+
+        const CarlaPluginPtr plugin = pData->plugins[pluginId].plugin;
+        CARLA_SAFE_ASSERT_CONTINUE(plugin.get() != nullptr && plugin->isEnabled());
+        CARLA_SAFE_ASSERT_UINT2_CONTINUE(parameterId < plugin->getParameterCount(),
+                                         parameterId, plugin->getParameterCount());
+
+        const float value = plugin->getParameterRanges(parameterId).getFixedValue(values[i]);
+        const EngineStagedParameterValue stagedValue = { pluginId, parameterId, value };
+        staged.push_back(stagedValue);
+
+        std::snprintf(strBuf, STR_MAX-1, "%u:%u:%s\n", pluginId, parameterId, CarlaFloatString(value).buffer);
+        strBuf[STR_MAX-1] = '\0';
+        records += strBuf;
+    }
+
+    if (staged.empty())
+        return true;
+
+    pData->stagedParameterValues     = staged.data();
+    pData->stagedParameterValueCount = static_cast<uint>(staged.size());
+
+    {
+        const ScopedActionLock sal(this, kEnginePostActionSetParameterValues, 0, 0);
+    }
+
+    pData->stagedParameterValues     = nullptr;
+    pData->stagedParameterValueCount = 0;
+
+    callback(true, true, ENGINE_CALLBACK_PARAMETER_VALUES_CHANGED, 0, static_cast<int>(staged.size()), 0, 0, 0.0f, records);
+    return true;
+}
+#endif
+
+void CarlaEngine::touchPluginParameter(const uint, const uint32_t, const bool) noexcept
+{
+}
+
+CarlaPluginPtr CarlaEngine::getPlugin(const uint id) const noexcept
+{
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     CARLA_SAFE_ASSERT_RETURN_ERRN(pData->plugins != nullptr, "Invalid engine internal data");
     CARLA_SAFE_ASSERT_RETURN_ERRN(pData->curPluginCount != 0, "Invalid engine internal data");
 #endif
-    CARLA_SAFE_ASSERT_RETURN_ERRN(pData->nextAction.opcode == kEnginePostActionNull, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERRN(pData->nextAction.isEmpty(), "Invalid engine internal data");
     CARLA_SAFE_ASSERT_RETURN_ERRN(id < pData->curPluginCount, "Invalid plugin Id");
 
     return pData->plugins[id].plugin;
@@ -1032,7 +1393,7 @@ CarlaPluginPtr CarlaEngine::getPluginUnchecked(const uint id) const noexcept
 
 const char* CarlaEngine::getUniquePluginName(const char* const name) const
 {
-    CARLA_SAFE_ASSERT_RETURN(pData->nextAction.opcode == kEnginePostActionNull, nullptr);
+    CARLA_SAFE_ASSERT_RETURN(pData->nextAction.isEmpty(), nullptr);
     CARLA_SAFE_ASSERT_RETURN(name != nullptr && name[0] != '\0', nullptr);
     carla_debug("CarlaEngine::getUniquePluginName(\"%s\")", name);
 
@@ -1277,105 +1638,583 @@ bool CarlaEngine::loadFile(const char* const filename)
         return addPlugin(getBinaryTypeFromFile(filename), PLUGIN_VST3, filename, nullptr, nullptr, 0, nullptr);
 #endif
 
-    // -------------------------------------------------------------------
+    // -------------------------------------------------------------------
+
+    setLastError("Unknown file extension");
+    return false;
+}
+
+bool CarlaEngine::loadProject(const char* const filename, const bool setAsCurrentProject)
+{
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
+    CARLA_SAFE_ASSERT_RETURN_ERR(filename != nullptr && filename[0] != '\0', "Invalid filename");
+    carla_debug("CarlaEngine::loadProject(\"%s\")", filename);
+
+    const String jfilename = String(CharPointer_UTF8(filename));
+    const File file(jfilename);
+    CARLA_SAFE_ASSERT_RETURN_ERR(file.existsAsFile(), "Requested file does not exist or is not a readable file");
+
+    if (setAsCurrentProject)
+    {
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+        if (pData->currentProjectFilename != filename)
+        {
+            pData->currentProjectFilename = filename;
+
+            bool found;
+            const size_t r = pData->currentProjectFilename.rfind(CARLA_OS_SEP, &found);
+
+            if (found)
+            {
+                pData->currentProjectFolder = filename;
+                pData->currentProjectFolder[r] = '\0';
+            }
+            else
+            {
+                pData->currentProjectFolder.clear();
+            }
+        }
+#endif
+    }
+
+    XmlDocument xml(file);
+    const File projectDir(file.getParentDirectory());
+    return loadProjectInternal(xml, !setAsCurrentProject, &projectDir);
+}
+
+bool CarlaEngine::saveProject(const char* const filename, const bool setAsCurrentProject)
+{
+    CARLA_SAFE_ASSERT_RETURN_ERR(filename != nullptr && filename[0] != '\0', "Invalid filename");
+    carla_debug("CarlaEngine::saveProject(\"%s\")", filename);
+
+    const String jfilename = String(CharPointer_UTF8(filename));
+    File file(jfilename);
+
+    File chunksDir, chunksTmpDir, newChunksDir;
+
+    if (pData->options.saveChunksAsFiles)
+    {
+        chunksDir    = file.getSiblingFile(file.getFileName() + ".chunks");
+        chunksTmpDir = file.getSiblingFile(file.getFileName() + ".chunks.tmp");
+
+        // chunks are first written to a temporary dir, so the ones of the previous save stay valid until
+        // the new project file is written. the dir inside has the final name, as the project refers to it
+        if (chunksTmpDir.exists())
+            chunksTmpDir.deleteRecursively();
+
+        newChunksDir = chunksTmpDir.getChildFile(chunksDir.getFileName());
+    }
+
+    MemoryOutputStream out;
+    saveProjectInternal(out, newChunksDir.isNotNull() ? &newChunksDir : nullptr);
+
+    if (setAsCurrentProject)
+    {
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+        if (pData->currentProjectFilename != filename)
+        {
+            pData->currentProjectFilename = filename;
+
+            bool found;
+            const size_t r = pData->currentProjectFilename.rfind(CARLA_OS_SEP, &found);
+
+            if (found)
+            {
+                pData->currentProjectFolder = filename;
+                pData->currentProjectFolder[r] = '\0';
+            }
+            else
+            {
+                pData->currentProjectFolder.clear();
+            }
+        }
+#endif
+    }
+
+    if (! file.replaceWithData(out.getData(), out.getDataSize()))
+    {
+        if (chunksTmpDir.isNotNull())
+            chunksTmpDir.deleteRecursively();
+
+        setLastError("Failed to write file");
+        return false;
+    }
+
+    if (chunksTmpDir.isNotNull())
+    {
+        // swap in the new chunks, the old ones are removed as plugins might be gone by now
+        if (chunksDir.isDirectory() && ! chunksDir.moveFileTo(chunksTmpDir.getChildFile("previous")))
+            chunksDir.deleteRecursively();
+
+        if (newChunksDir.isDirectory() && ! newChunksDir.moveFileTo(chunksDir))
+        {
+            // keep them around, so they can still be moved by hand
+            carla_stderr2("Failed to move plugin chunk files into place, they are left in '%s'",
+                          newChunksDir.getFullPathName().toRawUTF8());
+        }
+        else
+        {
+            chunksTmpDir.deleteRecursively();
+        }
+    }
+
+    return true;
+}
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+const char* CarlaEngine::getCurrentProjectFolder() const noexcept
+{
+    return pData->currentProjectFolder;
+}
+
+const char* CarlaEngine::getCurrentProjectFilename() const noexcept
+{
+    return pData->currentProjectFilename;
+}
+
+void CarlaEngine::clearCurrentProjectFilename() noexcept
+{
+    pData->currentProjectFilename.clear();
+    pData->currentProjectFolder.clear();
+}
+
+bool CarlaEngine::preloadProject(const char* const filename)
+{
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
+    CARLA_SAFE_ASSERT_RETURN_ERR(filename != nullptr && filename[0] != '\0', "Invalid filename");
+    CARLA_SAFE_ASSERT_RETURN_ERR(! pData->preloadedProject.loading, "A project is already being preloaded");
+    carla_debug("CarlaEngine::preloadProject(\"%s\")", filename);
+
+    if (! pData->preloadedProject.plugins.empty())
+    {
+        setLastError("A project is already preloaded, switch to it or cancel it first");
+        return false;
+    }
+
+    const String jfilename = String(CharPointer_UTF8(filename));
+    const File file(jfilename);
+    CARLA_SAFE_ASSERT_RETURN_ERR(file.existsAsFile(), "Requested file does not exist or is not a readable file");
+
+    XmlDocument xml(file);
+    const File projectDir(file.getParentDirectory());
+
+    bool ok;
+
+    {
+        const CarlaScopedValueSetter<bool> csvs(pData->preloadedProject.loading, true, false);
+        ok = loadProjectInternal(xml, false, &projectDir);
+    }
+
+    if (ok && pData->preloadedProject.plugins.empty())
+    {
+        setLastError("Project has no plugins to preload");
+        ok = false;
+    }
+
+    if (! ok)
+    {
+        const CarlaString error(getLastError());
+        cancelPreloadedProject();
+        setLastError(error);
+    }
+
+    return ok;
+}
+
+bool CarlaEngine::switchToPreloadedProject(const uint fadeTimeMs)
+{
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.isEmpty(), "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(! pData->preloadedProject.loading, "A project is still being preloaded");
+    carla_debug("CarlaEngine::switchToPreloadedProject(%u)", fadeTimeMs);
+
+    EnginePreloadedProject& preloaded(pData->preloadedProject);
+
+    const std::vector<uint> newIds(pData->preloadedProject.getLoadedPluginIds(pData->plugins, pData->curPluginCount));
+
+    if (newIds.empty())
+    {
+        preloaded.clear();
+        setLastError("No project has been preloaded");
+        return false;
+    }
+
+    std::vector<CarlaPluginPtr> newPlugins;
+    std::vector<std::string> newNames;
+    std::vector<bool> isNew(pData->curPluginCount, false);
+
+    for (std::size_t i=0, count=preloaded.plugins.size(); i < count; ++i)
+    {
+        const uint id = preloaded.plugins[i]->getId();
+
+        if (std::find(newIds.begin(), newIds.end(), id) == newIds.end())
+            continue;
+
+        newPlugins.push_back(preloaded.plugins[i]);
+        newNames.push_back(preloaded.names[i]);
+        isNew[id] = true;
+    }
+
+    std::vector<uint> oldIds;
+
+    for (uint i=0; i < pData->curPluginCount; ++i)
+    {
+        if (! isNew[i])
+            oldIds.push_back(i);
+    }
+
+    const double bpm = preloaded.bpm;
+    preloaded.clear();
+
+    // hide the switch behind a short fade, if our own graph is producing the audio outputs
+    EngineOutputFader* const fader = pData->graph.isReady() ? &pData->graph.getOutputFader() : nullptr;
+    const uint32_t fadeFrames = static_cast<uint32_t>(pData->sampleRate * fadeTimeMs / 1000.0);
+    const bool fading = fader != nullptr && fadeFrames != 0 && isRunning() && ! isOffline();
+
+    if (fading)
+    {
+        fader->fadeOut(fadeFrames);
+
+        for (uint i = fadeTimeMs + 2000; --i != 0 && ! fader->isSilent();)
+        {
+            carla_msleep(1);
+
+            if (! isRunning())
+                break;
+        }
+
+        if (! fader->isSilent())
+            carla_stderr2("CarlaEngine::switchToPreloadedProject() - outputs did not fade out in time");
+    }
+
+    for (std::size_t i=0, count=newPlugins.size(); i < count; ++i)
+    {
+        const CarlaPluginPtr& plugin(newPlugins[i]);
+
+        plugin->setEnabled(true);
+
+        // preloading left the bridge ping check off, same as a regular project load does while loading
+        if ((plugin->getHints() & PLUGIN_IS_BRIDGE) != 0)
+            plugin->setCustomData(CUSTOM_DATA_TYPE_STRING, "__CarlaPingOnOff__", "true", false);
+    }
+
+    bool ok = true;
+
+    if (! oldIds.empty())
+        ok = removePlugins(oldIds.data(), static_cast<uint>(oldIds.size()));
+
+    // the names used in the project are free now
+    for (std::size_t i=0, count=newPlugins.size(); i < count; ++i)
+    {
+        const CarlaPluginPtr& plugin(newPlugins[i]);
+
+        if (newNames[i] != plugin->getName())
+            renamePlugin(plugin->getId(), newNames[i].c_str());
+    }
+
+    if (bpm > 0.0)
+        pData->time.setBPM(bpm);
+
+    if (fading)
+        fader->fadeIn(fadeFrames);
+
+    return ok;
+}
+
+bool CarlaEngine::cancelPreloadedProject()
+{
+    CARLA_SAFE_ASSERT_RETURN_ERR(! pData->preloadedProject.loading, "A project is still being preloaded");
+    carla_debug("CarlaEngine::cancelPreloadedProject()");
+
+    const std::vector<uint> ids(pData->preloadedProject.getLoadedPluginIds(pData->plugins, pData->curPluginCount));
+
+    pData->preloadedProject.clear();
+
+    if (ids.empty())
+        return true;
+
+    return removePlugins(ids.data(), static_cast<uint>(ids.size()));
+}
+
+/*
+ * Write the state of a plugin as a project <Plugin> element, same as saveProjectInternal() does.
+ */
+static void dumpPluginToProject(MemoryOutputStream& outStream, const CarlaPluginPtr& plugin)
+{
+    MemoryOutputStream streamPlugin;
+    plugin->dumpStateSave(streamPlugin, nullptr);
+
+    outStream << "\n";
+    outStream << " <Plugin>\n";
+    outStream << streamPlugin;
+    outStream << " </Plugin>\n";
+}
+
+bool CarlaEngine::freezePlugins(const uint firstId, const uint lastId, const char* const filename, const uint64_t frames)
+{
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins != nullptr, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.isEmpty(), "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(firstId <= lastId, "Invalid plugin Id");
+    CARLA_SAFE_ASSERT_RETURN_ERR(lastId < pData->curPluginCount, "Invalid plugin Id");
+    CARLA_SAFE_ASSERT_RETURN_ERR(filename != nullptr && filename[0] != '\0', "Invalid filename");
+    CARLA_SAFE_ASSERT_RETURN_ERR(frames > 0, "Invalid frame count");
+    CARLA_SAFE_ASSERT_RETURN_ERR(! pData->preloadedProject.loading, "A project is still being preloaded");
+    carla_debug("CarlaEngine::freezePlugins(%i, %i, \"%s\", " P_UINT64 ")", firstId, lastId, filename, frames);
+
+    if (pData->options.processMode != ENGINE_PROCESS_MODE_CONTINUOUS_RACK)
+    {
+        setLastError("Freezing plugins is only supported in rack mode");
+        return false;
+    }
+
+    if (! pData->preloadedProject.plugins.empty())
+    {
+        setLastError("Cannot freeze plugins while a project is preloaded");
+        return false;
+    }
+
+    // ---------------------------------------------------------------
+    // collect the states, the render needs the plugins before the chain too, they feed it
+
+    MemoryOutputStream renderProject, frozenStates;
+
+    renderProject << "<?xml version='1.0' encoding='UTF-8'?>\n";
+    renderProject << "<!DOCTYPE CARLA-PROJECT>\n";
+    renderProject << "<CARLA-PROJECT VERSION='2.2'>\n";
+
+    if (pData->timeInfo.bbt.valid)
+    {
+        renderProject << "\n <Transport>\n";
+        renderProject << "  <BeatsPerMinute>" << CarlaFloatString(pData->timeInfo.bbt.beatsPerMinute).buffer << "</BeatsPerMinute>\n";
+        renderProject << " </Transport>\n";
+    }
+
+    frozenStates << "<?xml version='1.0' encoding='UTF-8'?>\n";
+    frozenStates << "<!DOCTYPE CARLA-PROJECT>\n";
+    frozenStates << "<CARLA-PROJECT VERSION='2.2'>\n";
+
+    CarlaString firstName;
+
+    for (uint i=0; i <= lastId; ++i)
+    {
+        const CarlaPluginPtr plugin = pData->plugins[i].plugin;
+        CARLA_SAFE_ASSERT_CONTINUE(plugin.get() != nullptr);
+
+        if (i == firstId)
+            firstName = plugin->getName();
+
+        if (! (plugin->isEnabled() || plugin->isDormant()))
+            continue;
+
+        const bool isBridge = plugin->isEnabled() && (plugin->getHints() & PLUGIN_IS_BRIDGE) != 0;
+
+        // deactivate bridge client-side ping check, since some plugins block during save
+        if (isBridge)
+            plugin->setCustomData(CUSTOM_DATA_TYPE_STRING, "__CarlaPingOnOff__", "false", false);
+
+        plugin->prepareForSave(false);
+
+        dumpPluginToProject(renderProject, plugin);
+
+        if (i >= firstId)
+            dumpPluginToProject(frozenStates, plugin);
+
+        if (isBridge)
+            plugin->setCustomData(CUSTOM_DATA_TYPE_STRING, "__CarlaPingOnOff__", "true", false);
+    }
+
+    renderProject << "</CARLA-PROJECT>\n";
+    frozenStates << "</CARLA-PROJECT>\n";
+
+    const String jfilename = String(CharPointer_UTF8(filename));
+    const File statesFile(File(jfilename).withFileExtension("carxp"));
+
+    if (! statesFile.replaceWithData(frozenStates.getData(), frozenStates.getDataSize()))
+    {
+        setLastError("Failed to write plugin states file");
+        return false;
+    }
+
+    // ---------------------------------------------------------------
+    // render offline, with the same settings
+
+    {
+        CarlaScopedPointer<CarlaEngine> renderEngine(newDriverByName("Render"));
+        CARLA_SAFE_ASSERT_RETURN_ERR(renderEngine != nullptr, "Failed to create render engine");
+
+        const EngineOptions& options(pData->options);
+
+        renderEngine->setOption(ENGINE_OPTION_PROCESS_MODE, ENGINE_PROCESS_MODE_CONTINUOUS_RACK, nullptr);
+        renderEngine->setOption(ENGINE_OPTION_AUDIO_BUFFER_SIZE, static_cast<int>(pData->bufferSize), nullptr);
+        renderEngine->setOption(ENGINE_OPTION_AUDIO_SAMPLE_RATE, static_cast<int>(pData->sampleRate), nullptr);
+        renderEngine->setOption(ENGINE_OPTION_OSC_ENABLED, 0, nullptr);
+        renderEngine->setOption(ENGINE_OPTION_FORCE_STEREO, options.forceStereo ? 1 : 0, nullptr);
+        renderEngine->setOption(ENGINE_OPTION_PREFER_PLUGIN_BRIDGES, options.preferPluginBridges ? 1 : 0, nullptr);
+        renderEngine->setOption(ENGINE_OPTION_MAX_PARAMETERS, static_cast<int>(options.maxParameters), nullptr);
+        renderEngine->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_LADSPA, options.pathLADSPA);
+        renderEngine->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_DSSI,   options.pathDSSI);
+        renderEngine->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_LV2,    options.pathLV2);
+        renderEngine->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_VST2,   options.pathVST2);
+        renderEngine->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_VST3,   options.pathVST3);
+        renderEngine->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_SF2,    options.pathSF2);
+        renderEngine->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_SFZ,    options.pathSFZ);
+
+        if (options.binaryDir != nullptr)
+            renderEngine->setOption(ENGINE_OPTION_PATH_BINARIES, 0, options.binaryDir);
+        if (options.resourceDir != nullptr)
+            renderEngine->setOption(ENGINE_OPTION_PATH_RESOURCES, 0, options.resourceDir);
+
+        if (! renderEngine->init("Carla-Freeze"))
+        {
+            setLastError(renderEngine->getLastError());
+            return false;
+        }
+
+        XmlDocument xml(String::fromUTF8(static_cast<const char*>(renderProject.getData()),
+                                         static_cast<int>(renderProject.getDataSize())));
+
+        const bool ok = renderEngine->loadProjectInternal(xml, true) && renderEngine->renderToFile(filename, frames);
+
+        if (! ok)
+            setLastError(renderEngine->getLastError());
+
+        renderEngine->close();
+
+        if (! ok)
+            return false;
+    }
+
+    // ---------------------------------------------------------------
+    // swap in an audio file player for the chain
+
+    if (! replacePlugin(firstId))
+        return false;
+
+    const CarlaString playerName(firstName + " (frozen)");
+
+    if (! addPlugin(PLUGIN_INTERNAL, nullptr, playerName, "audiofile", 0, nullptr))
+    {
+        pData->nextPluginId = pData->maxPluginNumber;
+        return false;
+    }
+
+    const CarlaPluginPtr player = pData->plugins[firstId].plugin;
+    CARLA_SAFE_ASSERT_RETURN_ERR(player.get() != nullptr, "Invalid engine internal data");
+
+    // the render already has volume and dry/wet of the chain applied
+    if (player->getHints() & PLUGIN_CAN_DRYWET)
+        player->setDryWet(1.0f, true, true);
+    if (player->getHints() & PLUGIN_CAN_VOLUME)
+        player->setVolume(1.0f, true, true);
+
+    // follow transport, the render started at frame 0
+    player->setParameterValue(0, 0.0f, true, true, true);
+    player->setCustomData(CUSTOM_DATA_TYPE_STRING, "file", filename, true);
+
+    if (firstId == lastId)
+        return true;
+
+    std::vector<uint> ids;
+
+    for (uint i=firstId+1; i <= lastId; ++i)
+        ids.push_back(i);
+
+    return removePlugins(ids.data(), static_cast<uint>(ids.size()));
+}
+
+bool CarlaEngine::unfreezePlugin(const uint id)
+{
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins != nullptr, "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->nextAction.isEmpty(), "Invalid engine internal data");
+    CARLA_SAFE_ASSERT_RETURN_ERR(id < pData->curPluginCount, "Invalid plugin Id");
+    CARLA_SAFE_ASSERT_RETURN_ERR(! pData->preloadedProject.loading, "A project is still being preloaded");
+    carla_debug("CarlaEngine::unfreezePlugin(%i)", id);
+
+    if (! pData->preloadedProject.plugins.empty())
+    {
+        setLastError("Cannot unfreeze plugins while a project is preloaded");
+        return false;
+    }
+
+    const CarlaPluginPtr player = pData->plugins[id].plugin;
+    CARLA_SAFE_ASSERT_RETURN_ERR(player.get() != nullptr, "Could not find plugin to unfreeze");
 
-    setLastError("Unknown file extension");
-    return false;
-}
+    char strBuf[STR_MAX+1];
+    carla_zeroChars(strBuf, STR_MAX+1);
 
-bool CarlaEngine::loadProject(const char* const filename, const bool setAsCurrentProject)
-{
-    CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
-    CARLA_SAFE_ASSERT_RETURN_ERR(filename != nullptr && filename[0] != '\0', "Invalid filename");
-    carla_debug("CarlaEngine::loadProject(\"%s\")", filename);
+    if (player->getType() != PLUGIN_INTERNAL || ! player->getLabel(strBuf) || std::strcmp(strBuf, "audiofile") != 0)
+    {
+        setLastError("Plugin is not a frozen audio file player");
+        return false;
+    }
 
-    const String jfilename = String(CharPointer_UTF8(filename));
-    const File file(jfilename);
-    CARLA_SAFE_ASSERT_RETURN_ERR(file.existsAsFile(), "Requested file does not exist or is not a readable file");
+    const char* audioFilename = nullptr;
 
-    if (setAsCurrentProject)
+    for (uint32_t i=0, count=player->getCustomDataCount(); i < count; ++i)
     {
-#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-        if (pData->currentProjectFilename != filename)
+        const CustomData& cdata(player->getCustomData(i));
+
+        if (cdata.isValid() && std::strcmp(cdata.key, "file") == 0)
         {
-            pData->currentProjectFilename = filename;
+            audioFilename = cdata.value;
+            break;
+        }
+    }
 
-            bool found;
-            const size_t r = pData->currentProjectFilename.rfind(CARLA_OS_SEP, &found);
+    if (audioFilename == nullptr || audioFilename[0] == '\0')
+    {
+        setLastError("Plugin has no audio file");
+        return false;
+    }
 
-            if (found)
-            {
-                pData->currentProjectFolder = filename;
-                pData->currentProjectFolder[r] = '\0';
-            }
-            else
-            {
-                pData->currentProjectFolder.clear();
-            }
-        }
-#endif
+    const String jfilename = String(CharPointer_UTF8(audioFilename));
+    const File statesFile(File(jfilename).withFileExtension("carxp"));
+
+    if (! statesFile.existsAsFile())
+    {
+        setLastError("Could not find the plugin states of the frozen audio file");
+        return false;
     }
 
-    XmlDocument xml(file);
-    return loadProjectInternal(xml, !setAsCurrentProject);
-}
+    // ---------------------------------------------------------------
+    // load the plugins after the current ones, then move them into place
 
-bool CarlaEngine::saveProject(const char* const filename, const bool setAsCurrentProject)
-{
-    CARLA_SAFE_ASSERT_RETURN_ERR(filename != nullptr && filename[0] != '\0', "Invalid filename");
-    carla_debug("CarlaEngine::saveProject(\"%s\")", filename);
+    const uint oldCount = pData->curPluginCount;
 
-    MemoryOutputStream out;
-    saveProjectInternal(out);
+    XmlDocument xml(statesFile);
+    const File projectDir(statesFile.getParentDirectory());
 
-    const String jfilename = String(CharPointer_UTF8(filename));
-    File file(jfilename);
+    if (! loadProjectInternal(xml, false, &projectDir))
+        return false;
 
-    if (setAsCurrentProject)
-    {
-#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-        if (pData->currentProjectFilename != filename)
-        {
-            pData->currentProjectFilename = filename;
+    CARLA_SAFE_ASSERT_RETURN_ERR(pData->curPluginCount >= oldCount, "Invalid engine internal data");
+    const uint count = pData->curPluginCount - oldCount;
 
-            bool found;
-            const size_t r = pData->currentProjectFilename.rfind(CARLA_OS_SEP, &found);
+    if (count == 0)
+    {
+        setLastError("The plugin states file has no plugins");
+        return false;
+    }
 
-            if (found)
-            {
-                pData->currentProjectFolder = filename;
-                pData->currentProjectFolder[r] = '\0';
-            }
-            else
-            {
-                pData->currentProjectFolder.clear();
-            }
+    for (uint k=0; k < count; ++k)
+    {
+        for (uint j = oldCount + k; j > id + k; --j)
+        {
+            if (! switchPlugins(j - 1, j))
+                return false;
         }
-#endif
     }
 
-    if (file.replaceWithData(out.getData(), out.getDataSize()))
-        return true;
-
-    setLastError("Failed to write file");
-    return false;
-}
-
-#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-const char* CarlaEngine::getCurrentProjectFolder() const noexcept
-{
-    return pData->currentProjectFolder;
-}
+    // the player went down by as many places as plugins were restored
+    if (! removePlugin(id + count))
+        return false;
 
-const char* CarlaEngine::getCurrentProjectFilename() const noexcept
-{
-    return pData->currentProjectFilename;
-}
+    for (uint i=id; i < pData->curPluginCount; ++i)
+        callback(true, true, ENGINE_CALLBACK_RELOAD_ALL, i, 0, 0, 0, 0.0f, nullptr);
 
-void CarlaEngine::clearCurrentProjectFilename() noexcept
-{
-    pData->currentProjectFilename.clear();
-    pData->currentProjectFolder.clear();
+    return true;
 }
 #endif
 
@@ -1424,6 +2263,9 @@ const float* CarlaEngine::getPeaks(const uint pluginId) const noexcept
         // get peak from first plugin, if available
         if (const uint count = pData->curPluginCount)
         {
+            pData->plugins[0].markPeaksWatched();
+            pData->plugins[count-1].markPeaksWatched();
+
             pData->peaks[0] = pData->plugins[0].peaks[0];
             pData->peaks[1] = pData->plugins[0].peaks[1];
             pData->peaks[2] = pData->plugins[count-1].peaks[2];
@@ -1439,21 +2281,49 @@ const float* CarlaEngine::getPeaks(const uint pluginId) const noexcept
 
     CARLA_SAFE_ASSERT_RETURN(pluginId < pData->curPluginCount, kFallback);
 
+    pData->plugins[pluginId].markPeaksWatched();
     return pData->plugins[pluginId].peaks;
 }
 
+uint CarlaEngine::getAllPeaks(float* const peaks, const uint maxPlugins) const noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(peaks != nullptr, 0);
+
+    const uint count = std::min(pData->curPluginCount, maxPlugins);
+
+    for (uint i=0; i < count; ++i)
+        pData->plugins[i].markPeaksWatched();
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    const int published = pData->peaksBlock.read(peaks, count);
+
+    if (published >= 0)
+        return static_cast<uint>(published);
+#endif
+
+    // nothing published by the audio thread, take the values from each plugin
+    for (uint i=0; i < count; ++i)
+        carla_copyFloats(peaks + i*4, pData->plugins[i].peaks, 4);
+
+    return count;
+}
+
 float CarlaEngine::getInputPeak(const uint pluginId, const bool isLeft) const noexcept
 {
     if (pluginId == MAIN_CARLA_PLUGIN_ID)
     {
         // get peak from first plugin, if available
         if (pData->curPluginCount > 0)
+        {
+            pData->plugins[0].markPeaksWatched();
             return pData->plugins[0].peaks[isLeft ? 0 : 1];
+        }
         return 0.0f;
     }
 
     CARLA_SAFE_ASSERT_RETURN(pluginId < pData->curPluginCount, 0.0f);
 
+    pData->plugins[pluginId].markPeaksWatched();
     return pData->plugins[pluginId].peaks[isLeft ? 0 : 1];
 }
 
@@ -1463,15 +2333,52 @@ float CarlaEngine::getOutputPeak(const uint pluginId, const bool isLeft) const n
     {
         // get peak from last plugin, if available
         if (pData->curPluginCount > 0)
+        {
+            pData->plugins[pData->curPluginCount-1].markPeaksWatched();
             return pData->plugins[pData->curPluginCount-1].peaks[isLeft ? 2 : 3];
+        }
         return 0.0f;
     }
 
     CARLA_SAFE_ASSERT_RETURN(pluginId < pData->curPluginCount, 0.0f);
 
+    pData->plugins[pluginId].markPeaksWatched();
     return pData->plugins[pluginId].peaks[isLeft ? 2 : 3];
 }
 
+// -----------------------------------------------------------------------
+// Information (process timing)
+
+EnginePluginProcessTimeInfo CarlaEngine::getPluginProcessTimeInfo(const uint pluginId) const noexcept
+{
+    static const EnginePluginProcessTimeInfo kFallback = { 0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+    CARLA_SAFE_ASSERT_RETURN(pluginId < pData->curPluginCount, kFallback);
+
+    return pData->plugins[pluginId].processStats.getInfo();
+}
+
+void CarlaEngine::resetPluginProcessTimeInfo(const uint pluginId) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(pluginId < pData->curPluginCount,);
+
+    pData->plugins[pluginId].processStats.requestReset();
+}
+
+uint CarlaEngine::getCycleRecords(EngineCycleRecord* const records, const uint maxCount) const noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(records != nullptr, 0);
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    return pData->cycleLog.read(records, maxCount);
+#else
+    return 0;
+
+    // unused
+    (void)maxCount;
+#endif
+}
+
 // -----------------------------------------------------------------------
 // Callback
 
@@ -1493,7 +2400,38 @@ void CarlaEngine::callback(const bool sendHost, const bool sendOSC,
                     static_cast<double>(valuef), valueStr);
 #endif
 
-    if (sendHost && pData->callback != nullptr)
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    // a full patchbay refresh is being collected by getPatchbaySnapshot()
+    if (pData->patchbaySnapshot.add(action, pluginId, value1, value2, value3, valuef, valueStr))
+        return;
+
+    // a batch of patchbay changes is in progress, see patchbayBeginBatch()
+    if (sendHost && pData->patchbayBatch.collecting)
+    {
+        const CarlaMutexLocker cml(pData->patchbayBatchMutex);
+
+        if (pData->patchbayBatch.add(action, pluginId, value1, value2, value3, valuef, valueStr))
+            return;
+    }
+#endif
+
+    bool callHost = sendHost && pData->callback != nullptr;
+
+    if (callHost && pData->options.asyncCallbacks && getType() != kEngineTypePlugin)
+    {
+        // idle and engine stopped are sent right away, everything queued before them goes first
+        if (action == ENGINE_CALLBACK_IDLE || action == ENGINE_CALLBACK_ENGINE_STOPPED)
+        {
+            pData->callbackQueue.dispatch(pData->callback, pData->callbackPtr);
+        }
+        else
+        {
+            pData->callbackQueue.append(action, pluginId, value1, value2, value3, valuef, valueStr);
+            callHost = false;
+        }
+    }
+
+    if (callHost)
     {
         if (action == ENGINE_CALLBACK_IDLE)
             ++pData->isIdling;
@@ -1511,6 +2449,15 @@ void CarlaEngine::callback(const bool sendHost, const bool sendOSC,
 #if defined(HAVE_LIBLO) && ! defined(BUILD_BRIDGE)
         if (pData->osc.isControlRegisteredForTCP())
         {
+            // plugin (re)loads send a lot of messages at once
+            const bool bundled = action == ENGINE_CALLBACK_PLUGIN_ADDED
+                              || action == ENGINE_CALLBACK_RELOAD_ALL
+                              || action == ENGINE_CALLBACK_RELOAD_PARAMETERS
+                              || action == ENGINE_CALLBACK_RELOAD_PROGRAMS;
+
+            if (bundled)
+                pData->osc.beginTcpBundle();
+
             switch (action)
             {
             case ENGINE_CALLBACK_RELOAD_INFO:
@@ -1599,11 +2546,20 @@ void CarlaEngine::callback(const bool sendHost, const bool sendOSC,
             case ENGINE_CALLBACK_IDLE:
                 return;
 
+            // same format as a snapshot, and potentially just as big
+            case ENGINE_CALLBACK_PATCHBAY_BATCH:
+                if (valueStr != nullptr)
+                    pData->osc.sendPatchbaySnapshot(valueStr);
+                return;
+
             default:
                 break;
             }
 
             pData->osc.sendCallback(action, pluginId, value1, value2, value3, valuef, valueStr);
+
+            if (bundled)
+                pData->osc.endTcpBundle();
         }
 #endif
     }
@@ -1682,11 +2638,25 @@ void CarlaEngine::transportRelocate(const uint64_t frame) noexcept
 
 const char* CarlaEngine::getLastError() const noexcept
 {
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    if (pData->pluginLoader.isWorkerThread())
+        return pData->pluginLoader.workerError;
+#endif
+
     return pData->lastError;
 }
 
 void CarlaEngine::setLastError(const char* const error) const noexcept
 {
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    // plugins loaded in the background report errors through their load request
+    if (pData->pluginLoader.isWorkerThread())
+    {
+        pData->pluginLoader.workerError = error;
+        return;
+    }
+#endif
+
     pData->lastError = error;
 }
 
@@ -1739,6 +2709,13 @@ void CarlaEngine::setOption(const EngineOption option, const int value, const ch
         case ENGINE_OPTION_AUDIO_TRIPLE_BUFFER:
         case ENGINE_OPTION_AUDIO_DRIVER:
         case ENGINE_OPTION_AUDIO_DEVICE:
+        case ENGINE_OPTION_AUDIO_SECONDARY_DEVICE:
+        case ENGINE_OPTION_PROCESSING_THREADS:
+        case ENGINE_OPTION_RACK_LANES:
+        case ENGINE_OPTION_PIPELINED_BRIDGES:
+        case ENGINE_OPTION_PATCHBAY_DECOUPLED_BUFFER_SIZE:
+        case ENGINE_OPTION_LOCK_MEMORY:
+        case ENGINE_OPTION_COMPACT_PARAMETER_STATE:
             return carla_stderr("CarlaEngine::setOption(%i:%s, %i, \"%s\") - Cannot set this option while engine is running!",
                                 option, EngineOption2Str(option), value, valueStr);
         default:
@@ -2027,56 +3004,208 @@ void CarlaEngine::setOption(const EngineOption option, const int value, const ch
         pData->options.frontendWinId = static_cast<uintptr_t>(winId);
     }   break;
 
-#if !defined(BUILD_BRIDGE_ALTERNATIVE_ARCH) && !defined(CARLA_OS_WIN)
-    case ENGINE_OPTION_WINE_EXECUTABLE:
-        CARLA_SAFE_ASSERT_RETURN(valueStr != nullptr && valueStr[0] != '\0',);
+#if !defined(BUILD_BRIDGE_ALTERNATIVE_ARCH) && !defined(CARLA_OS_WIN)
+    case ENGINE_OPTION_WINE_EXECUTABLE:
+        CARLA_SAFE_ASSERT_RETURN(valueStr != nullptr && valueStr[0] != '\0',);
+
+        if (pData->options.wine.executable != nullptr)
+            delete[] pData->options.wine.executable;
+
+        pData->options.wine.executable = carla_strdup_safe(valueStr);
+        break;
+
+    case ENGINE_OPTION_WINE_AUTO_PREFIX:
+        CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+        pData->options.wine.autoPrefix = (value != 0);
+        break;
+
+    case ENGINE_OPTION_WINE_FALLBACK_PREFIX:
+        CARLA_SAFE_ASSERT_RETURN(valueStr != nullptr && valueStr[0] != '\0',);
+
+        if (pData->options.wine.fallbackPrefix != nullptr)
+            delete[] pData->options.wine.fallbackPrefix;
+
+        pData->options.wine.fallbackPrefix = carla_strdup_safe(valueStr);
+        break;
+
+    case ENGINE_OPTION_WINE_RT_PRIO_ENABLED:
+        CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+        pData->options.wine.rtPrio = (value != 0);
+        break;
+
+    case ENGINE_OPTION_WINE_BASE_RT_PRIO:
+        CARLA_SAFE_ASSERT_RETURN(value >= 1 && value <= 89,);
+        pData->options.wine.baseRtPrio = value;
+        break;
+
+    case ENGINE_OPTION_WINE_SERVER_RT_PRIO:
+        CARLA_SAFE_ASSERT_RETURN(value >= 1 && value <= 99,);
+        pData->options.wine.serverRtPrio = value;
+        break;
+#endif
+
+    case ENGINE_OPTION_DEBUG_CONSOLE_OUTPUT:
+        break;
+
+    case ENGINE_OPTION_CLIENT_NAME_PREFIX:
+        if (pData->options.clientNamePrefix != nullptr)
+            delete[] pData->options.clientNamePrefix;
+
+        pData->options.clientNamePrefix = valueStr != nullptr && valueStr[0] != '\0'
+                                        ? carla_strdup_safe(valueStr)
+                                        : nullptr;
+        break;
+
+    case ENGINE_OPTION_PROCESSING_THREADS:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 64,);
+        pData->options.processingThreads = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_RACK_LANES:
+        CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+        pData->options.rackLanes = (value != 0);
+        break;
+
+    case ENGINE_OPTION_PIPELINED_BRIDGES:
+        CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+        pData->options.pipelinedBridges = (value != 0);
+        break;
+
+    case ENGINE_OPTION_BRIDGE_SPIN_TIME:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 1000,);
+        pData->options.bridgeSpinTime = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_SAVE_CHUNKS_AS_FILES:
+        CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+        pData->options.saveChunksAsFiles = (value != 0);
+        break;
+
+    case ENGINE_OPTION_EVENT_SPLIT_GRANULARITY:
+        CARLA_SAFE_ASSERT_RETURN(value >= 1 && value <= 512,);
+        pData->options.eventSplitGranularity = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_PLUGIN_BRIDGE_POOL_SIZE:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 8,);
+        pData->options.bridgePoolSize = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_PLUGIN_BRIDGE_GROUP_SIZE:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 64,);
+        pData->options.bridgeGroupSize = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_LV2_LAZY_LOADING:
+        CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+        pData->options.lv2LazyLoading = (value != 0);
+        break;
+
+    case ENGINE_OPTION_SFZ_PRELOAD_TIME:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 10000,);
+        pData->options.sfzPreloadTime = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_SFZ_RENDER_THREADS:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 64,);
+        pData->options.sfzRenderThreads = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_CV_CONTROL_PERIOD:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 512,);
+        pData->options.cvControlPeriod = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_EVENT_PORT_BUFFER_SIZE:
+        CARLA_SAFE_ASSERT_RETURN(value >= 16 && value <= kMaxEngineEventInternalCount,);
+        pData->options.eventPortBufferSize = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_FLUSH_DENORMALS:
+        CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+        pData->options.flushDenormals = (value != 0);
+        break;
+
+    case ENGINE_OPTION_ASYNC_CALLBACKS:
+        CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+        pData->options.asyncCallbacks = (value != 0);
+
+        // do not leave anything behind when going back to direct callbacks
+        if (! pData->options.asyncCallbacks)
+            pData->callbackQueue.dispatch(pData->callback, pData->callbackPtr);
+        break;
 
-        if (pData->options.wine.executable != nullptr)
-            delete[] pData->options.wine.executable;
+    case ENGINE_OPTION_BRIDGE_RT_PRIO:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 99,);
+        pData->options.bridgeRtPrio = value;
+        break;
 
-        pData->options.wine.executable = carla_strdup_safe(valueStr);
+    case ENGINE_OPTION_BRIDGE_CPU_AFFINITY:
+        if (pData->options.bridgeCpuAffinity != nullptr)
+            delete[] pData->options.bridgeCpuAffinity;
+
+        pData->options.bridgeCpuAffinity = valueStr != nullptr && valueStr[0] != '\0'
+                                         ? carla_strdup_safe(valueStr)
+                                         : nullptr;
         break;
 
-    case ENGINE_OPTION_WINE_AUTO_PREFIX:
+    case ENGINE_OPTION_PROCESSING_CPU_AFFINITY:
+        if (pData->options.processingCpuAffinity != nullptr)
+            delete[] pData->options.processingCpuAffinity;
+
+        pData->options.processingCpuAffinity = valueStr != nullptr && valueStr[0] != '\0'
+                                             ? carla_strdup_safe(valueStr)
+                                             : nullptr;
+        break;
+
+    case ENGINE_OPTION_DORMANT_INACTIVE_PLUGINS:
         CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
-        pData->options.wine.autoPrefix = (value != 0);
+        pData->options.dormantInactivePlugins = (value != 0);
         break;
 
-    case ENGINE_OPTION_WINE_FALLBACK_PREFIX:
-        CARLA_SAFE_ASSERT_RETURN(valueStr != nullptr && valueStr[0] != '\0',);
+    case ENGINE_OPTION_PATCHBAY_DECOUPLED_BUFFER_SIZE:
+        CARLA_SAFE_ASSERT_RETURN(value >= 128 && value <= 8192,);
+        pData->options.patchbayDecoupledBufferSize = static_cast<uint>(value);
+        break;
 
-        if (pData->options.wine.fallbackPrefix != nullptr)
-            delete[] pData->options.wine.fallbackPrefix;
+    case ENGINE_OPTION_REPLACE_PLUGIN_CROSSFADE:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 1000,);
+        pData->options.replacePluginCrossfade = static_cast<uint>(value);
+        break;
 
-        pData->options.wine.fallbackPrefix = carla_strdup_safe(valueStr);
+    case ENGINE_OPTION_LOCK_MEMORY:
+        CARLA_SAFE_ASSERT_RETURN(value >= CarlaMemoryLock::kModeOff && value <= CarlaMemoryLock::kModeLockHugePages,);
+        pData->options.lockMemory = static_cast<uint>(value);
+        CarlaMemoryLock::getInstance().setMode(value);
         break;
 
-    case ENGINE_OPTION_WINE_RT_PRIO_ENABLED:
-        CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
-        pData->options.wine.rtPrio = (value != 0);
+    case ENGINE_OPTION_COMPACT_PARAMETER_STATE:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0,);
+        pData->options.compactParameterState = static_cast<uint>(value);
         break;
 
-    case ENGINE_OPTION_WINE_BASE_RT_PRIO:
-        CARLA_SAFE_ASSERT_RETURN(value >= 1 && value <= 89,);
-        pData->options.wine.baseRtPrio = value;
+    case ENGINE_OPTION_SHARE_UI_BRIDGES:
+        CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+        pData->options.shareUiBridges = (value != 0);
         break;
 
-    case ENGINE_OPTION_WINE_SERVER_RT_PRIO:
-        CARLA_SAFE_ASSERT_RETURN(value >= 1 && value <= 99,);
-        pData->options.wine.serverRtPrio = value;
+    case ENGINE_OPTION_INLINE_DISPLAY_MAX_RATE:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0,);
+        pData->options.inlineDisplayMaxRate = static_cast<uint>(value);
         break;
-#endif
 
-    case ENGINE_OPTION_DEBUG_CONSOLE_OUTPUT:
+    case ENGINE_OPTION_EVENT_SPLIT_MIN_FRAMES:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 512,);
+        pData->options.eventSplitMinFrames = static_cast<uint>(value);
         break;
 
-    case ENGINE_OPTION_CLIENT_NAME_PREFIX:
-        if (pData->options.clientNamePrefix != nullptr)
-            delete[] pData->options.clientNamePrefix;
+    case ENGINE_OPTION_AUDIO_SECONDARY_DEVICE:
+        CARLA_SAFE_ASSERT_RETURN(valueStr != nullptr,);
 
-        pData->options.clientNamePrefix = valueStr != nullptr && valueStr[0] != '\0'
-                                        ? carla_strdup_safe(valueStr)
-                                        : nullptr;
+        if (pData->options.audioSecondaryDevice != nullptr)
+            delete[] pData->options.audioSecondaryDevice;
+
+        pData->options.audioSecondaryDevice = carla_strdup_safe(valueStr);
         break;
     }
 }
@@ -2136,7 +3265,7 @@ void CarlaEngine::bufferSizeChanged(const uint32_t newBufferSize)
         {
             if (plugin->isEnabled() && plugin->tryLock(true))
             {
-                plugin->bufferSizeChanged(newBufferSize);
+                plugin->bufferSizeChanged(plugin->getBufferSize());
                 plugin->unlock();
             }
         }
@@ -2204,7 +3333,48 @@ void CarlaEngine::setPluginPeaksRT(const uint pluginId, float const inPeaks[2],
     pluginData.peaks[3] = outPeaks[1];
 }
 
-void CarlaEngine::saveProjectInternal(water::MemoryOutputStream& outStream) const
+/*
+ * Plugin states of a project being saved, whose XML needs to be encoded again.
+ * Encoding only touches already collected data and is spread over a thread pool,
+ * the results are written into the project in plugin order afterwards.
+ */
+struct ProjectPluginDumps {
+    CarlaPlugin** plugins;
+    int count;
+    volatile int nextIndex;
+
+    ProjectPluginDumps(const uint maxPlugins)
+        : plugins(new CarlaPlugin*[maxPlugins > 0 ? maxPlugins : 1]),
+          count(0),
+          nextIndex(0) {}
+
+    ~ProjectPluginDumps()
+    {
+        delete[] plugins;
+    }
+
+    void encode(const uint numThreads)
+    {
+        CarlaThreadPool threadPool;
+
+        if (numThreads > 1 && count > 1)
+            threadPool.start(std::min(numThreads, static_cast<uint>(count)) - 1, false);
+
+        threadPool.run(encodeCallback, this);
+    }
+
+    static void encodeCallback(void* const ptr, uint)
+    {
+        ProjectPluginDumps* const self = static_cast<ProjectPluginDumps*>(ptr);
+
+        for (int i; (i = __sync_fetch_and_add(&self->nextIndex, 1)) < self->count;)
+            self->plugins[i]->encodeStateDump();
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(ProjectPluginDumps)
+};
+
+void CarlaEngine::saveProjectInternal(water::MemoryOutputStream& outStream, const water::File* const chunksDir) const
 {
     // send initial prepareForSave first, giving time for bridges to act
     for (uint i=0; i < pData->curPluginCount; ++i)
@@ -2271,7 +3441,7 @@ void CarlaEngine::saveProjectInternal(water::MemoryOutputStream& outStream) cons
 
         outTransport << "\n <Transport>\n";
         // outTransport << "  <BeatsPerBar>"    << pData->timeInfo.bbt.beatsPerBar    << "</BeatsPerBar>\n";
-        outTransport << "  <BeatsPerMinute>" << pData->timeInfo.bbt.beatsPerMinute << "</BeatsPerMinute>\n";
+        outTransport << "  <BeatsPerMinute>" << CarlaFloatString(pData->timeInfo.bbt.beatsPerMinute).buffer << "</BeatsPerMinute>\n";
         outTransport << " </Transport>\n";
         outStream << outTransport;
     }
@@ -2279,14 +3449,43 @@ void CarlaEngine::saveProjectInternal(water::MemoryOutputStream& outStream) cons
     char strBuf[STR_MAX+1];
     carla_zeroChars(strBuf, STR_MAX+1);
 
+    ProjectPluginDumps pluginDumps(pData->curPluginCount);
+
+    // plugin states are collected here, as plugins might expect to be called from this thread
     for (uint i=0; i < pData->curPluginCount; ++i)
     {
         if (const CarlaPluginPtr plugin = pData->plugins[i].plugin)
         {
-            if (plugin->isEnabled())
+            if (plugin->isEnabled() || plugin->isDormant())
+            {
+                bool needsEncoding;
+
+                if (chunksDir != nullptr)
+                {
+                    const File chunkFile(chunksDir->getChildFile(String(i) + ".chunk"));
+                    needsEncoding = plugin->prepareStateDump(&chunkFile);
+                }
+                else
+                {
+                    needsEncoding = plugin->prepareStateDump(nullptr);
+                }
+
+                if (needsEncoding)
+                    pluginDumps.plugins[pluginDumps.count++] = plugin.get();
+            }
+        }
+    }
+
+    pluginDumps.encode(CarlaThreadPool::getNumCPUs());
+
+    for (uint i=0; i < pData->curPluginCount; ++i)
+    {
+        if (const CarlaPluginPtr plugin = pData->plugins[i].plugin)
+        {
+            if (plugin->isEnabled() || plugin->isDormant())
             {
                 MemoryOutputStream outPlugin(4096), streamPlugin;
-                plugin->getStateSave(false).dumpToMemoryStream(streamPlugin);
+                plugin->finishStateDump(streamPlugin);
 
                 outPlugin << "\n";
 
@@ -2527,7 +3726,204 @@ static String findBinaryInCustomPath(const char* const searchPath, const char* c
     return String();
 }
 
-bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alwaysLoadConnections)
+// -----------------------------------------------------------------------
+// Project loading helpers
+
+/*
+ * Look for a plugin binary that does not exist on this system, as saved paths might be from another machine.
+ * Only reads engine options, so this is safe to call from several threads at once.
+ */
+static void findMissingProjectPluginBinary(const EngineOptions& options, CarlaStateSave& stateSave)
+{
+    if (stateSave.type == nullptr)
+        return;
+    if (stateSave.binary == nullptr || stateSave.binary[0] == '\0')
+        return;
+    if (File::isAbsolutePath(stateSave.binary) && File(stateSave.binary).exists())
+        return;
+
+    const PluginType ptype(getPluginTypeFromString(stateSave.type));
+    const char* searchPath;
+
+    switch (ptype)
+    {
+    case PLUGIN_LADSPA: searchPath = options.pathLADSPA; break;
+    case PLUGIN_DSSI:   searchPath = options.pathDSSI;   break;
+    case PLUGIN_VST2:   searchPath = options.pathVST2;   break;
+    case PLUGIN_VST3:   searchPath = options.pathVST3;   break;
+    case PLUGIN_SF2:    searchPath = options.pathSF2;    break;
+    case PLUGIN_SFZ:    searchPath = options.pathSFZ;    break;
+    default:            return;
+    }
+
+    if (searchPath == nullptr || searchPath[0] == '\0')
+        return;
+
+    carla_stderr("Plugin binary '%s' doesn't exist on this filesystem, let's look for it...",
+                 stateSave.binary);
+
+    String result = findBinaryInCustomPath(searchPath, stateSave.binary);
+
+    if (result.isEmpty())
+    {
+        switch (ptype)
+        {
+        case PLUGIN_LADSPA: searchPath = std::getenv("LADSPA_PATH"); break;
+        case PLUGIN_DSSI:   searchPath = std::getenv("DSSI_PATH");   break;
+        case PLUGIN_VST2:   searchPath = std::getenv("VST_PATH");    break;
+        case PLUGIN_VST3:   searchPath = std::getenv("VST3_PATH");   break;
+        case PLUGIN_SF2:    searchPath = std::getenv("SF2_PATH");    break;
+        case PLUGIN_SFZ:    searchPath = std::getenv("SFZ_PATH");    break;
+        default:            searchPath = nullptr;                    break;
+        }
+
+        if (searchPath != nullptr && searchPath[0] != '\0')
+            result = findBinaryInCustomPath(searchPath, stateSave.binary);
+    }
+
+    if (result.isNotEmpty())
+    {
+        delete[] stateSave.binary;
+        stateSave.binary = carla_strdup(result.toRawUTF8());
+        carla_stderr("Found it! :)");
+    }
+    else
+    {
+        carla_stderr("Damn, we failed... :(");
+    }
+}
+
+/*
+ * Read a chunk saved as a separate file, straight into the state chunk buffer.
+ */
+static void loadProjectPluginChunkFile(const File* const projectDir, CarlaStateSave& stateSave)
+{
+    if (projectDir == nullptr)
+    {
+        carla_stderr2("Plugin chunk is saved in file '%s', which cannot be used without a project file",
+                      stateSave.chunkFile);
+        return;
+    }
+
+    const File file(projectDir->getChildFile(stateSave.chunkFile));
+    const water::int64 size = file.getSize();
+
+    if (size <= 0 || size > INT32_MAX)
+    {
+        carla_stderr2("Plugin chunk file '%s' is missing or invalid", stateSave.chunkFile);
+        return;
+    }
+
+    FileInputStream stream(file);
+    CARLA_SAFE_ASSERT_RETURN(stream.openedOk(),);
+
+    try {
+        stateSave.chunkData.resize(static_cast<std::size_t>(size));
+    } CARLA_SAFE_EXCEPTION_RETURN("loadProjectPluginChunkFile",);
+
+    if (stream.read(&stateSave.chunkData.front(), static_cast<int>(size)) != static_cast<int>(size))
+    {
+        carla_stderr2("Failed to read plugin chunk file '%s'", stateSave.chunkFile);
+        std::vector<uint8_t>().swap(stateSave.chunkData);
+    }
+}
+
+/*
+ * Plugin states of a project, parsed ahead of creating the plugins.
+ * Parsing and binary lookups do not depend on other plugins, so they are spread over a thread pool,
+ * while plugins are still created and added one by one in project order on the calling thread.
+ * The calling thread keeps sending idle callbacks while the pool works, as binary lookups can take long.
+ */
+struct ProjectPluginStates {
+    struct State {
+        XmlElement* xmlElement;
+        CarlaStateSave stateSave;
+
+        State() noexcept
+            : xmlElement(nullptr),
+              stateSave() {}
+
+        CARLA_DECLARE_NON_COPY_STRUCT(State)
+    };
+
+    CarlaEngine* const engine;
+    const EngineOptions& options;
+    const File* const projectDir;
+    const bool& canceled;
+    State* states;
+    int count;
+    volatile int nextIndex;
+    volatile int doneCount;
+
+    ProjectPluginStates(CarlaEngine* const eng, const File* const dir, const bool& cancel, const int numStates)
+        : engine(eng),
+          options(eng->getOptions()),
+          projectDir(dir),
+          canceled(cancel),
+          states(new State[numStates]),
+          count(numStates),
+          nextIndex(0),
+          doneCount(0) {}
+
+    ~ProjectPluginStates()
+    {
+        delete[] states;
+    }
+
+    void prepare(const uint numThreads)
+    {
+        CarlaThreadPool threadPool;
+
+        if (numThreads > 1 && count > 1)
+            threadPool.start(std::min(numThreads, static_cast<uint>(count)) - 1, false);
+
+        threadPool.run(prepareCallback, this);
+    }
+
+    static void prepareCallback(void* const ptr, const uint threadIndex)
+    {
+        ProjectPluginStates* const self = static_cast<ProjectPluginStates*>(ptr);
+
+        for (int i; (i = __sync_fetch_and_add(&self->nextIndex, 1)) < self->count;)
+        {
+            if (! self->canceled)
+                self->prepareState(self->states[i]);
+
+            __sync_fetch_and_add(&self->doneCount, 1);
+
+            if (threadIndex == 0)
+                self->engine->callback(true, true, ENGINE_CALLBACK_IDLE, 0, 0, 0, 0, 0.0f, nullptr);
+        }
+
+        if (threadIndex != 0)
+            return;
+
+        // keep the host responsive until the other threads are done too
+        while (__sync_fetch_and_add(&self->doneCount, 0) < self->count)
+        {
+            self->engine->callback(true, true, ENGINE_CALLBACK_IDLE, 0, 0, 0, 0, 0.0f, nullptr);
+            carla_msleep(30);
+        }
+    }
+
+    void prepareState(State& state) const
+    {
+        state.stateSave.fillFromXmlElement(state.xmlElement);
+        findMissingProjectPluginBinary(options, state.stateSave);
+
+        if (state.stateSave.chunkFile != nullptr && state.stateSave.chunkData.empty())
+            loadProjectPluginChunkFile(projectDir, state.stateSave);
+
+        // the chunk is decoded now, release its text from the document
+        if (XmlElement* const xmlData = state.xmlElement->getChildByName("Data"))
+            xmlData->deleteAllChildElementsWithTagName("Chunk");
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(ProjectPluginStates)
+};
+
+bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alwaysLoadConnections,
+                                      const water::File* const projectDir)
 {
     carla_debug("CarlaEngine::loadProjectInternal(%p, %s) - START", &xmlDoc, bool2str(alwaysLoadConnections));
 
@@ -2580,11 +3976,14 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     const bool isMultiClient = pData->options.processMode == ENGINE_PROCESS_MODE_MULTIPLE_CLIENTS;
     const bool isPatchbay    = pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY;
+    const bool isPreloading  = pData->preloadedProject.loading;
+#else
+    const bool isPreloading  = false;
 #endif
     const bool isPlugin = getType() == kEngineTypePlugin;
 
-    // load engine settings first of all
-    if (XmlElement* const elem = isPreset ? nullptr : xmlElement->getChildByName("EngineSettings"))
+    // load engine settings first of all, unless the current project is still running
+    if (XmlElement* const elem = (isPreset || isPreloading) ? nullptr : xmlElement->getChildByName("EngineSettings"))
     {
         for (XmlElement* settElem = elem->getFirstChildElement(); settElem != nullptr; settElem = settElem->getNextElement())
         {
@@ -2711,11 +4110,18 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
         if (XmlElement* const bpmElem = elem->getChildByName("BeatsPerMinute"))
         {
             const String bpmText(bpmElem->getAllSubText().trim());
-            const double bpm = bpmText.getDoubleValue();
+            const double bpm = carla_stringToDouble(bpmText.toRawUTF8());
 
             // some sane limits
             if (bpm >= 20.0 && bpm < 400.0)
-                pData->time.setBPM(bpm);
+            {
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+                if (isPreloading)
+                    pData->preloadedProject.bpm = bpm;
+                else
+#endif
+                    pData->time.setBPM(bpm);
+            }
 
             if (pData->aboutToClose)
                 return true;
@@ -2728,15 +4134,56 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
         }
     }
 
+    // parse all plugin states first
+    int numPluginStates = 0;
+
+    if (isPreset)
+    {
+        numPluginStates = 1;
+    }
+    else
+    {
+        for (XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr; elem = elem->getNextElement())
+            if (elem->getTagName() == "Plugin")
+                ++numPluginStates;
+    }
+
+    ProjectPluginStates pluginStates(this, projectDir, pData->actionCanceled, numPluginStates);
+
+    {
+        int i = 0;
+
+        for (XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr && i < numPluginStates; elem = elem->getNextElement())
+        {
+            if (isPreset)
+                pluginStates.states[i++].xmlElement = xmlElement.get();
+            else if (elem->getTagName() == "Plugin")
+                pluginStates.states[i++].xmlElement = elem;
+        }
+
+        pluginStates.count = i;
+    }
+
+    pluginStates.prepare(CarlaThreadPool::getNumCPUs());
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    // group names used in the project against the ones they got in this session
+    std::map<water::String, water::String> mapGroupNamesInternal, mapGroupNamesExternal;
+#endif
+
     // and we handle plugins
+    int pluginStateIndex = 0;
+
     for (XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr; elem = elem->getNextElement())
     {
         const String& tagName(elem->getTagName());
 
         if (isPreset || tagName == "Plugin")
         {
-            CarlaStateSave stateSave;
-            stateSave.fillFromXmlElement(isPreset ? xmlElement.get() : elem);
+            CARLA_SAFE_ASSERT_BREAK(pluginStateIndex < pluginStates.count);
+
+            ProjectPluginStates::State& pluginState(pluginStates.states[pluginStateIndex++]);
+            CarlaStateSave& stateSave(pluginState.stateSave);
 
             if (pData->aboutToClose)
                 return true;
@@ -2787,7 +4234,11 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
                         plugin->setPanning(stateSave.panning, true, true);
                         plugin->setCtrlChannel(stateSave.ctrlChannel, true, true);
                         plugin->setActive(stateSave.active, true, true);
-                        plugin->setEnabled(true);
+
+                        if (isPreloading)
+                            pData->preloadedProject.add(plugin, stateSave.name);
+                        else
+                            plugin->setEnabled(true);
 
                         ++pData->curPluginCount;
                         callback(true, true, ENGINE_CALLBACK_PLUGIN_ADDED, pluginId, 0, 0, 0, 0.0f, plugin->getName());
@@ -2840,7 +4291,11 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
                         plugin->setPanning(stateSave.panning, true, true);
                         plugin->setCtrlChannel(stateSave.ctrlChannel, true, true);
                         plugin->setActive(stateSave.active, true, true);
-                        plugin->setEnabled(true);
+
+                        if (isPreloading)
+                            pData->preloadedProject.add(plugin, stateSave.name);
+                        else
+                            plugin->setEnabled(true);
 
                         ++pData->curPluginCount;
                         callback(true, true, ENGINE_CALLBACK_PLUGIN_ADDED, pluginId, 0, 0, 0, 0.0f, plugin->getName());
@@ -2864,95 +4319,56 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
 # endif
 #endif
 
-            const void* extraStuff    = nullptr;
-            static const char kTrue[] = "true";
-
-            const PluginType ptype(getPluginTypeFromString(stateSave.type));
-
-            switch (ptype)
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+            // keep inactive plugins as their saved state only, until they get activated
+            if (pData->options.dormantInactivePlugins && ! stateSave.active && ! isPreset && ! isPreloading &&
+                pData->options.processMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK)
             {
-            case PLUGIN_SF2:
-                if (CarlaString(stateSave.label).endsWith(" (16 outs)"))
-                    extraStuff = kTrue;
-                // fall through
-            case PLUGIN_LADSPA:
-            case PLUGIN_DSSI:
-            case PLUGIN_VST2:
-            case PLUGIN_VST3:
-            case PLUGIN_SFZ:
-                if (stateSave.binary != nullptr && stateSave.binary[0] != '\0' &&
-                    ! (File::isAbsolutePath(stateSave.binary) && File(stateSave.binary).exists()))
-                {
-                    const char* searchPath;
-
-                    switch (ptype)
-                    {
-                    case PLUGIN_LADSPA: searchPath = pData->options.pathLADSPA; break;
-                    case PLUGIN_DSSI:   searchPath = pData->options.pathDSSI;   break;
-                    case PLUGIN_VST2:   searchPath = pData->options.pathVST2;   break;
-                    case PLUGIN_VST3:   searchPath = pData->options.pathVST3;   break;
-                    case PLUGIN_SF2:    searchPath = pData->options.pathSF2;    break;
-                    case PLUGIN_SFZ:    searchPath = pData->options.pathSFZ;    break;
-                    default:            searchPath = nullptr;                   break;
-                    }
-
-                    if (searchPath != nullptr && searchPath[0] != '\0')
-                    {
-                        carla_stderr("Plugin binary '%s' doesn't exist on this filesystem, let's look for it...",
-                                     stateSave.binary);
+                const uint pluginId = pData->curPluginCount;
 
-                        String result = findBinaryInCustomPath(searchPath, stateSave.binary);
+                if (pluginId == pData->maxPluginNumber)
+                {
+                    carla_stderr2("Failed to load a plugin '%s', maximum number of plugins reached", stateSave.name);
+                    continue;
+                }
 
-                        if (result.isEmpty())
-                        {
-                            switch (ptype)
-                            {
-                            case PLUGIN_LADSPA: searchPath = std::getenv("LADSPA_PATH"); break;
-                            case PLUGIN_DSSI:   searchPath = std::getenv("DSSI_PATH");   break;
-                            case PLUGIN_VST2:   searchPath = std::getenv("VST_PATH");    break;
-                            case PLUGIN_VST3:   searchPath = std::getenv("VST3_PATH");   break;
-                            case PLUGIN_SF2:    searchPath = std::getenv("SF2_PATH");    break;
-                            case PLUGIN_SFZ:    searchPath = std::getenv("SFZ_PATH");    break;
-                            default:            searchPath = nullptr;                    break;
-                            }
-
-                            if (searchPath != nullptr && searchPath[0] != '\0')
-                                result = findBinaryInCustomPath(searchPath, stateSave.binary);
-                        }
+                const CarlaPlugin::Initializer initializer = {
+                    this,
+                    pluginId,
+                    stateSave.binary,
+                    stateSave.name,
+                    stateSave.label,
+                    stateSave.uniqueId,
+                    stateSave.options
+                };
 
-                        if (result.isNotEmpty())
-                        {
-                            delete[] stateSave.binary;
-                            stateSave.binary = carla_strdup(result.toRawUTF8());
-                            carla_stderr("Found it! :)");
-                        }
-                        else
-                        {
-                            carla_stderr("Damn, we failed... :(");
-                        }
+                if (const CarlaPluginPtr plugin = CarlaPlugin::newDormant(initializer, pluginState.xmlElement, stateSave))
+                {
+                    EnginePluginData& pluginData(pData->plugins[pluginId]);
+                    pluginData.plugin = plugin;
+                    pluginData.peaksEnabled = true;
+                    pluginData.processStats.requestReset();
+                    carla_zeroFloats(pluginData.peaks, 4);
 
-                        callback(true, true, ENGINE_CALLBACK_IDLE, 0, 0, 0, 0, 0.0f, nullptr);
-                    }
+                    // never enabled, there is nothing to process
+                    ++pData->curPluginCount;
+                    callback(true, true, ENGINE_CALLBACK_PLUGIN_ADDED, pluginId, 0, 0, 0, 0.0f, plugin->getName());
+                }
+                else
+                {
+                    carla_stderr2("Failed to load a plugin '%s', error was:\n%s", stateSave.name, getLastError());
                 }
-                break;
-            default:
-                break;
-            }
 
-            BinaryType btype;
+                stateSave.clear();
 
-            switch (ptype)
-            {
-            case PLUGIN_LADSPA:
-            case PLUGIN_DSSI:
-            case PLUGIN_LV2:
-            case PLUGIN_VST2:
-                btype = getBinaryTypeFromFile(stateSave.binary);
-                break;
-            default:
-                btype = BINARY_NATIVE;
-                break;
+                callback(true, true, ENGINE_CALLBACK_IDLE, 0, 0, 0, 0, 0.0f, nullptr);
+                continue;
             }
+#endif
+
+            const void* extraStuff;
+            const PluginType ptype(getPluginTypeFromString(stateSave.type));
+            const BinaryType btype(getStateSaveBinaryType(stateSave, ptype, extraStuff));
 
             if (addPlugin(btype, ptype, stateSave.binary,
                           stateSave.name, stateSave.label, stateSave.uniqueId, extraStuff, stateSave.options))
@@ -2978,13 +4394,28 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
                     if ((plugin->getHints() & PLUGIN_IS_BRIDGE) != 0 && ! isPreset)
                         plugin->setCustomData(CUSTOM_DATA_TYPE_STRING, "__CarlaPingOnOff__", "false", false);
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+                    // keep preloaded plugins apart from the current ones, they are only enabled on switch
+                    if (isPreloading)
+                    {
+                        pData->preloadedProject.add(plugin, stateSave.name);
+
+                        if (stateSave.name != nullptr && std::strcmp(plugin->getName(), stateSave.name) != 0)
+                            mapGroupNamesInternal[String(CharPointer_UTF8(stateSave.name))] = String(CharPointer_UTF8(plugin->getName()));
+                    }
+#endif
+
                     plugin->loadStateSave(stateSave);
 
+                    // state is restored, free its data as we go (chunks can be big)
+                    stateSave.clear();
+
                     /* NOTE: The following code is the same as the end of addPlugin().
                      *       When project is loading we do not enable the plugin right away,
                      *        as we want to load state first.
                      */
-                    plugin->setEnabled(true);
+                    if (! isPreloading)
+                        plugin->setEnabled(true);
 
                     ++pData->curPluginCount;
                     callback(true, true, ENGINE_CALLBACK_PLUGIN_ADDED, pluginId, 0, 0, 0, 0.0f, plugin->getName());
@@ -3036,7 +4467,6 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
 
     // now we handle positions
     bool loadingAsExternal;
-    std::map<water::String, water::String> mapGroupNamesInternal, mapGroupNamesExternal;
 
     bool hasInternalPositions = false;
 
@@ -3062,6 +4492,15 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
                 const String nameText(patchName->getAllSubText().trim());
                 name = xmlSafeString(nameText, false);
 
+                // preloaded plugins got unique names next to the current ones
+                if (isPreloading)
+                {
+                    const std::map<water::String, water::String>::const_iterator it = mapGroupNamesInternal.find(name);
+
+                    if (it != mapGroupNamesInternal.end())
+                        name = it->second;
+                }
+
                 ppos.name = name.toRawUTF8();
                 ppos.x1 = patchElem->getIntAttribute("x1");
                 ppos.y1 = patchElem->getIntAttribute("y1");
@@ -3070,6 +4509,10 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
                 ppos.pluginId = patchElem->getIntAttribute("pluginId", -1);
                 ppos.dealloc = false;
 
+                // leave the shared hardware groups where the current project has them
+                if (isPreloading && ppos.pluginId < 0)
+                    continue;
+
                 loadingAsExternal = ppos.pluginId >= 0 && isMultiClient;
 
                 if (name.isNotEmpty() && restorePatchbayGroupPosition(loadingAsExternal, ppos))
@@ -3100,7 +4543,7 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
         }
     }
 
-    if (XmlElement* const elemPatchbay = xmlElement->getChildByName("ExternalPatchbay"))
+    if (XmlElement* const elemPatchbay = isPreloading ? nullptr : xmlElement->getChildByName("ExternalPatchbay"))
     {
         if (XmlElement* const elemPositions = elemPatchbay->getChildByName("Positions"))
         {
@@ -3162,6 +4605,9 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
         }
     }
 
+    // restore all connections with a single graph rebuild and patchbay callback
+    ScopedPatchbayBatch patchbayBatch(this);
+
     bool hasInternalConnections = false;
 
     // and now we handle connections (internal)
@@ -3240,8 +4686,8 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
             loadExternalConnections = true;
     }
 
-    // plus external connections too
-    if (loadExternalConnections)
+    // plus external connections too, a preloaded project shares those of the current one
+    if (loadExternalConnections && ! isPreloading)
     {
         bool isExternal;
         loadingAsExternal = hasInternalConnections &&
@@ -3394,9 +4840,11 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc, const bool alw
             break;
         }
     }
+
+    patchbayBatch.end();
 #endif
 
-    if (pData->options.resetXruns)
+    if (pData->options.resetXruns && ! isPreloading)
         clearXruns();
 
     callback(true, true, ENGINE_CALLBACK_PROJECT_LOAD_FINISHED, 0, 0, 0, 0, 0.0f, nullptr);
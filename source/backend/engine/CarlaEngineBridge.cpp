@@ -28,10 +28,6 @@
 #include "CarlaBridgeUtils.hpp"
 #include "CarlaMIDI.h"
 
-#ifdef __SSE2_MATH__
-# include <xmmintrin.h>
-#endif
-
 #include "water/files/File.h"
 #include "water/misc/Time.h"
 
@@ -47,6 +43,11 @@ CARLA_BACKEND_START_NAMESPACE
 
 // -----------------------------------------------------------------------
 
+// max number of parameters sent per kPluginBridgeNonRtServerParameterInfo message, must fit in 1/4 of the ring
+static const uint32_t kParameterInfoBatchSize = 32;
+
+// -----------------------------------------------------------------------
+
 // just want to access private options...
 struct CarlaPlugin::ProtectedData {
     CarlaEngine* const engine;
@@ -106,6 +107,8 @@ public:
         : CarlaEngine(),
           CarlaThread("CarlaEngineBridge"),
           fShmAudioPool(),
+          fShmChunkPool(),
+          fShmSaveChunkPool(),
           fShmRtClientControl(),
           fShmNonRtClientControl(),
           fShmNonRtServerControl(),
@@ -116,7 +119,18 @@ public:
           fClosingDown(false),
           fIsOffline(false),
           fFirstIdle(true),
-          fLastPingTime(-1)
+          fChunkPoolResizeRequested(false),
+          fWaitingForPlugin(false),
+          fLastPingTime(-1),
+          fMidiBlockSize(0),
+          fIsGroupLeader(false),
+          fGroupLeader(nullptr),
+          fGroupMembers(),
+          fGroupMembersMutex(),
+          fThreadPolicyMutex(),
+          fThreadPolicyRtPrio(0),
+          fThreadPolicyCpuList(),
+          fThreadPolicyPending(false)
     {
         carla_debug("CarlaEngineBridge::CarlaEngineBridge(\"%s\", \"%s\", \"%s\", \"%s\")", audioPoolBaseName, rtClientBaseName, nonRtClientBaseName, nonRtServerBaseName);
     }
@@ -246,7 +260,15 @@ public:
             fShmNonRtServerControl.commitWrite();
         }
 
-        startThread(true);
+        // pooled bridges are started ahead of time, the plugin to load comes later via kPluginBridgeNonRtClientLoadPlugin.
+        // group leaders never load a plugin themselves, see kPluginBridgeNonRtClientAddGroupMember
+        fIsGroupLeader = fGroupLeader == nullptr && std::getenv("ENGINE_BRIDGE_GROUP") != nullptr;
+        fWaitingForPlugin = fIsGroupLeader || fGroupLeader != nullptr || std::getenv("ENGINE_BRIDGE_POOLED") != nullptr;
+
+        // group members are run from the leader thread
+        if (fGroupLeader == nullptr)
+            startThread(true);
+
         return true;
     }
 
@@ -255,8 +277,17 @@ public:
         carla_debug("CarlaEngineBridge::close()");
         fLastPingTime = -1;
 
+        if (fIsGroupLeader)
+            closeGroupMembers();
+
         CarlaEngine::close();
 
+        if (fIsGroupLeader && fShmRtClientControl.data != nullptr)
+        {
+            signalThreadShouldExit();
+            fShmRtClientControl.interruptGroupWait();
+        }
+
         stopThread(5000);
         clear();
 
@@ -268,6 +299,10 @@ public:
         if (fClosingDown)
             return false;
 
+        // no thread of its own, stays around until asked to close
+        if (fGroupLeader != nullptr)
+            return true;
+
         return isThreadRunning() || ! fFirstIdle;
     }
 
@@ -313,6 +348,15 @@ public:
     {
         const CarlaPluginPtr plugin = pData->plugins[0].plugin;
 
+        if (plugin.get() == nullptr && fWaitingForPlugin)
+        {
+            handlePooledNonRtData();
+
+            if (fIsGroupLeader)
+                idleGroupMembers();
+            return;
+        }
+
         if (plugin.get() == nullptr)
         {
             if (const uint32_t length = static_cast<uint32_t>(pData->lastError.length()))
@@ -324,6 +368,10 @@ public:
                 fShmNonRtServerControl.commitWrite();
             }
 
+            // lets group leaders know this one is done
+            if (fGroupLeader != nullptr)
+                fClosingDown = true;
+
             signalThreadShouldExit();
             callback(true, true, ENGINE_CALLBACK_QUIT, 0, 0, 0, 0, 0.0f, nullptr);
             return;
@@ -465,79 +513,37 @@ public:
                 fShmNonRtServerControl.writeUInt(count);
                 fShmNonRtServerControl.commitWrite();
 
-                for (uint32_t i=0; i<count; ++i)
-                {
-                    const ParameterData& paramData(plugin->getParameterData(i));
-
-                    if (paramData.type != PARAMETER_INPUT && paramData.type != PARAMETER_OUTPUT)
-                        continue;
-                    if ((paramData.hints & PARAMETER_IS_ENABLED) == 0)
-                        continue;
+                // names are left out, the server requests them when needed
+                uint32_t batch[kParameterInfoBatchSize];
+                uint32_t batchCount;
 
-                    // kPluginBridgeNonRtServerParameterData1
-                    {
-                        // uint/index, int/rindex, uint/type, uint/hints, short/cc
-                        fShmNonRtServerControl.writeOpcode(kPluginBridgeNonRtServerParameterData1);
-                        fShmNonRtServerControl.writeUInt(i);
-                        fShmNonRtServerControl.writeInt(paramData.rindex);
-                        fShmNonRtServerControl.writeUInt(paramData.type);
-                        fShmNonRtServerControl.writeUInt(paramData.hints);
-                        fShmNonRtServerControl.writeShort(paramData.mappedControlIndex);
-                        fShmNonRtServerControl.commitWrite();
-                    }
+                for (uint32_t i=0; i<count;)
+                {
+                    batchCount = 0;
 
-                    // kPluginBridgeNonRtServerParameterData2
+                    for (; i<count && batchCount<kParameterInfoBatchSize; ++i)
                     {
-                        // uint/index, uint/size, str[] (name), uint/size, str[] (symbol), uint/size, str[] (unit)
-                        fShmNonRtServerControl.writeOpcode(kPluginBridgeNonRtServerParameterData2);
-                        fShmNonRtServerControl.writeUInt(i);
-
-                        if (! plugin->getParameterName(i, bufStr))
-                            std::snprintf(bufStr, STR_MAX, "Param %u", i+1);
-                        bufStrSize = carla_fixedValue(1U, 32U, static_cast<uint32_t>(std::strlen(bufStr)));
-                        fShmNonRtServerControl.writeUInt(bufStrSize);
-                        fShmNonRtServerControl.writeCustomData(bufStr, bufStrSize);
-
-                        if (! plugin->getParameterSymbol(i, bufStr))
-                            bufStr[0] = '\0';
-                        bufStrSize = carla_fixedValue(1U, 64U, static_cast<uint32_t>(std::strlen(bufStr)));
-                        fShmNonRtServerControl.writeUInt(bufStrSize);
-                        fShmNonRtServerControl.writeCustomData(bufStr, bufStrSize);
+                        const ParameterData& paramData(plugin->getParameterData(i));
 
-                        if (! plugin->getParameterUnit(i, bufStr))
-                            bufStr[0] = '\0';
-                        bufStrSize = carla_fixedValue(1U, 32U, static_cast<uint32_t>(std::strlen(bufStr)));
-                        fShmNonRtServerControl.writeUInt(bufStrSize);
-                        fShmNonRtServerControl.writeCustomData(bufStr, bufStrSize);
+                        if (paramData.type != PARAMETER_INPUT && paramData.type != PARAMETER_OUTPUT)
+                            continue;
+                        if ((paramData.hints & PARAMETER_IS_ENABLED) == 0)
+                            continue;
 
-                        fShmNonRtServerControl.commitWrite();
+                        batch[batchCount++] = i;
                     }
 
-                    // kPluginBridgeNonRtServerParameterRanges
-                    {
-                        const ParameterRanges& paramRanges(plugin->getParameterRanges(i));
+                    if (batchCount == 0)
+                        break;
 
-                        // uint/index, float/def, float/min, float/max, float/step, float/stepSmall, float/stepLarge
-                        fShmNonRtServerControl.writeOpcode(kPluginBridgeNonRtServerParameterRanges);
-                        fShmNonRtServerControl.writeUInt(i);
-                        fShmNonRtServerControl.writeFloat(paramRanges.def);
-                        fShmNonRtServerControl.writeFloat(paramRanges.min);
-                        fShmNonRtServerControl.writeFloat(paramRanges.max);
-                        fShmNonRtServerControl.writeFloat(paramRanges.step);
-                        fShmNonRtServerControl.writeFloat(paramRanges.stepSmall);
-                        fShmNonRtServerControl.writeFloat(paramRanges.stepLarge);
-                        fShmNonRtServerControl.commitWrite();
-                    }
+                    // uint/count, then parameter info for each
+                    fShmNonRtServerControl.writeOpcode(kPluginBridgeNonRtServerParameterInfo2);
+                    fShmNonRtServerControl.writeUInt(batchCount);
 
-                    // kPluginBridgeNonRtServerParameterValue2
-                    {
-                        // uint/index float/value (used for init/output parameters only, don't resend values)
-                        fShmNonRtServerControl.writeOpcode(kPluginBridgeNonRtServerParameterValue2);
-                        fShmNonRtServerControl.writeUInt(i);
-                        fShmNonRtServerControl.writeFloat(plugin->getParameterValue(i));
-                        fShmNonRtServerControl.commitWrite();
-                    }
+                    for (uint32_t j=0; j<batchCount; ++j)
+                        writeParameterInfo(plugin, batch[j]);
 
+                    fShmNonRtServerControl.commitWrite();
                     fShmNonRtServerControl.waitIfDataIsReachingLimit();
                 }
             }
@@ -640,6 +646,10 @@ public:
         if (fLastPingTime > 0 && Time::currentTimeMillis() > fLastPingTime + 30000 && ! wasFirstIdle)
         {
             carla_stderr("Did not receive ping message from server for 30 secs, closing...");
+
+            if (fGroupLeader != nullptr)
+                fClosingDown = true;
+
             signalThreadShouldExit();
             callback(true, true, ENGINE_CALLBACK_QUIT, 0, 0, 0, 0, 0.0f, nullptr);
         }
@@ -741,11 +751,173 @@ public:
     void clear() noexcept
     {
         fShmAudioPool.clear();
+        fShmSaveChunkPool.clear();
+        fShmChunkPool.clear();
         fShmRtClientControl.clear();
         fShmNonRtClientControl.clear();
         fShmNonRtServerControl.clear();
     }
 
+    // writes the contents of a single kPluginBridgeNonRtServerParameterInfo2 entry, without committing
+    void writeParameterInfo(const CarlaPluginPtr& plugin, const uint32_t index) noexcept
+    {
+        const ParameterData&   paramData(plugin->getParameterData(index));
+        const ParameterRanges& paramRanges(plugin->getParameterRanges(index));
+
+        // uint/index, int/rindex, uint/type, uint/hints, short/cc
+        fShmNonRtServerControl.writeUInt(index);
+        fShmNonRtServerControl.writeInt(paramData.rindex);
+        fShmNonRtServerControl.writeUInt(paramData.type);
+        fShmNonRtServerControl.writeUInt(paramData.hints);
+        fShmNonRtServerControl.writeShort(paramData.mappedControlIndex);
+
+        // float/def, float/min, float/max, float/step, float/stepSmall, float/stepLarge
+        fShmNonRtServerControl.writeFloat(paramRanges.def);
+        fShmNonRtServerControl.writeFloat(paramRanges.min);
+        fShmNonRtServerControl.writeFloat(paramRanges.max);
+        fShmNonRtServerControl.writeFloat(paramRanges.step);
+        fShmNonRtServerControl.writeFloat(paramRanges.stepSmall);
+        fShmNonRtServerControl.writeFloat(paramRanges.stepLarge);
+
+        // float/value
+        fShmNonRtServerControl.writeFloat(plugin->getParameterValue(index));
+    }
+
+    // writes the name, symbol and unit of a parameter, as used in kPluginBridgeNonRtServerParameterData2
+    void writeParameterNames(const CarlaPluginPtr& plugin, const uint32_t index, char* const bufStr) noexcept
+    {
+        uint32_t bufStrSize;
+
+        // uint/size, str[] (name), uint/size, str[] (symbol), uint/size, str[] (unit)
+        if (! plugin->getParameterName(index, bufStr))
+            std::snprintf(bufStr, STR_MAX, "Param %u", index+1);
+        bufStrSize = carla_fixedValue(1U, 32U, static_cast<uint32_t>(std::strlen(bufStr)));
+        fShmNonRtServerControl.writeUInt(bufStrSize);
+        fShmNonRtServerControl.writeCustomData(bufStr, bufStrSize);
+
+        if (! plugin->getParameterSymbol(index, bufStr))
+            bufStr[0] = '\0';
+        bufStrSize = carla_fixedValue(1U, 64U, static_cast<uint32_t>(std::strlen(bufStr)));
+        fShmNonRtServerControl.writeUInt(bufStrSize);
+        fShmNonRtServerControl.writeCustomData(bufStr, bufStrSize);
+
+        if (! plugin->getParameterUnit(index, bufStr))
+            bufStr[0] = '\0';
+        bufStrSize = carla_fixedValue(1U, 32U, static_cast<uint32_t>(std::strlen(bufStr)));
+        fShmNonRtServerControl.writeUInt(bufStrSize);
+        fShmNonRtServerControl.writeCustomData(bufStr, bufStrSize);
+    }
+
+    // handles messages for a pooled bridge that has no plugin loaded yet
+    void handlePooledNonRtData()
+    {
+        for (; fWaitingForPlugin && fShmNonRtClientControl.isDataAvailableForReading();)
+        {
+            const PluginBridgeNonRtClientOpcode opcode = fShmNonRtClientControl.readOpcode();
+
+            switch (opcode)
+            {
+            case kPluginBridgeNonRtClientNull:
+                break;
+
+            case kPluginBridgeNonRtClientPing: {
+                const CarlaMutexLocker _cml(fShmNonRtServerControl.mutex);
+
+                fShmNonRtServerControl.writeOpcode(kPluginBridgeNonRtServerPong);
+                fShmNonRtServerControl.commitWrite();
+            }   break;
+
+            case kPluginBridgeNonRtClientPingOnOff:
+                fLastPingTime = fShmNonRtClientControl.readBool() ? Time::currentTimeMillis() : -1;
+                break;
+
+            case kPluginBridgeNonRtClientLoadPlugin: {
+                // uint/type, uint/size, str[] (filename), uint/size, str[] (label), long/uniqueId
+                const PluginType ptype = static_cast<PluginType>(fShmNonRtClientControl.readUInt());
+
+                const uint32_t filenameSize(fShmNonRtClientControl.readUInt());
+                char filename[filenameSize+1];
+                carla_zeroChars(filename, filenameSize+1);
+                if (filenameSize != 0)
+                    fShmNonRtClientControl.readCustomData(filename, filenameSize);
+
+                const uint32_t labelSize(fShmNonRtClientControl.readUInt());
+                char label[labelSize+1];
+                carla_zeroChars(label, labelSize+1);
+                if (labelSize != 0)
+                    fShmNonRtClientControl.readCustomData(label, labelSize);
+
+                const int64_t uniqueId(fShmNonRtClientControl.readLong());
+
+                if (fIsGroupLeader)
+                {
+                    carla_stderr2("CarlaEngineBridge::handlePooledNonRtData() - group leaders cannot load plugins");
+                    break;
+                }
+
+                // anything after this message is for the plugin
+                fWaitingForPlugin = false;
+
+                const void* extraStuff = nullptr;
+
+                if (ptype == PLUGIN_SF2 && std::strstr(label, " (16 outs)") != nullptr)
+                    extraStuff = "true";
+
+                if (! addPlugin(BINARY_NATIVE, ptype,
+                                filename[0] != '\0' ? filename : nullptr, nullptr,
+                                label[0] != '\0' ? label : nullptr, uniqueId, extraStuff, 0x0))
+                {
+                    carla_stderr("Plugin failed to load, error was:\n%s", getLastError());
+                }
+            }   break;
+
+            case kPluginBridgeNonRtClientAddGroupMember: {
+                // uint/size, str[] (shm ids)
+                const uint32_t shmIdsSize(fShmNonRtClientControl.readUInt());
+
+                if (shmIdsSize != 6*4)
+                {
+                    // consume the payload anyway, so the next messages are still read from the right place
+                    char discard[32];
+
+                    for (uint32_t left = shmIdsSize; left != 0;)
+                    {
+                        const uint32_t chunk = std::min<uint32_t>(left, sizeof(discard));
+                        fShmNonRtClientControl.readCustomData(discard, chunk);
+                        left -= chunk;
+                    }
+
+                    carla_safe_assert_uint("shmIdsSize == 6*4", __FILE__, __LINE__, shmIdsSize);
+                    break;
+                }
+
+                char shmIds[6*4+1];
+                carla_zeroChars(shmIds, 6*4+1);
+                fShmNonRtClientControl.readCustomData(shmIds, shmIdsSize);
+
+                if (fIsGroupLeader)
+                    addGroupMember(shmIds);
+                else
+                    carla_stderr2("CarlaEngineBridge::handlePooledNonRtData() - not a group leader, ignoring new member");
+            }   break;
+
+            case kPluginBridgeNonRtClientQuit:
+                fWaitingForPlugin = false;
+                fClosingDown = true;
+                signalThreadShouldExit();
+                callback(true, true, ENGINE_CALLBACK_QUIT, 0, 0, 0, 0, 0.0f, nullptr);
+                break;
+
+            default:
+                // we cannot know the size of messages meant for a plugin, so give up
+                carla_stderr2("CarlaEngineBridge::handlePooledNonRtData() - unexpected opcode %i:%s",
+                              opcode, PluginBridgeNonRtClientOpcode2str(opcode));
+                fWaitingForPlugin = false;
+                break;
+            }
+        }
+    }
+
     void handleNonRtData()
     {
         const CarlaPluginPtr plugin = pData->plugins[0].plugin;
@@ -846,7 +1018,7 @@ public:
                 const int32_t index(fShmNonRtClientControl.readInt());
 
                 if (plugin->isEnabled())
-                    plugin->setProgram(index, true, false, false);
+                    plugin->requestProgramChange(index, true, false, false);
                 break;
             }
 
@@ -854,7 +1026,7 @@ public:
                 const int32_t index(fShmNonRtClientControl.readInt());
 
                 if (plugin->isEnabled())
-                    plugin->setMidiProgram(index, true, false, false);
+                    plugin->requestMidiProgramChange(index, true, false, false);
                 break;
             }
 
@@ -920,6 +1092,47 @@ public:
                 break;
             }
 
+            case kPluginBridgeNonRtClientSetChunkDataShm: {
+                const uint32_t size(fShmNonRtClientControl.readUInt());
+                CARLA_SAFE_ASSERT_BREAK(size > 0);
+
+                char suffix[size+1];
+                carla_zeroChars(suffix, size+1);
+                fShmNonRtClientControl.readCustomData(suffix, size);
+
+                const uint64_t poolSize(fShmNonRtClientControl.readULong());
+                const uint64_t dataSize(fShmNonRtClientControl.readULong());
+                CARLA_SAFE_ASSERT_BREAK(poolSize > 0);
+                CARLA_SAFE_ASSERT_BREAK(dataSize <= poolSize);
+
+                CARLA_SAFE_ASSERT_BREAK(attachChunkPool(fShmChunkPool, suffix, poolSize));
+
+                if (dataSize > 0)
+                {
+                    if (plugin->isEnabled())
+                        plugin->setChunkData(fShmChunkPool.data, static_cast<std::size_t>(dataSize));
+
+                    // the server can write the next chunk now
+                    fShmChunkPool.release();
+                }
+                break;
+            }
+
+            case kPluginBridgeNonRtClientSetSaveChunkDataShm: {
+                const uint32_t size(fShmNonRtClientControl.readUInt());
+                CARLA_SAFE_ASSERT_BREAK(size > 0);
+
+                char suffix[size+1];
+                carla_zeroChars(suffix, size+1);
+                fShmNonRtClientControl.readCustomData(suffix, size);
+
+                const uint64_t poolSize(fShmNonRtClientControl.readULong());
+                CARLA_SAFE_ASSERT_BREAK(poolSize > 0);
+
+                CARLA_SAFE_ASSERT_BREAK(attachChunkPool(fShmSaveChunkPool, suffix, poolSize));
+                break;
+            }
+
             case kPluginBridgeNonRtClientSetCtrlChannel: {
                 const int16_t channel(fShmNonRtClientControl.readShort());
                 CARLA_SAFE_ASSERT_BREAK(channel >= -1 && channel < MAX_MIDI_CHANNELS);
@@ -981,6 +1194,43 @@ public:
                 break;
             }
 
+            case kPluginBridgeNonRtClientGetParameterNames: {
+                // uint/first, uint/count
+                const uint32_t first = fShmNonRtClientControl.readUInt();
+                const uint32_t count = fShmNonRtClientControl.readUInt();
+
+                const uint32_t paramCount = std::min(pData->options.maxParameters, plugin->getParameterCount());
+                const uint32_t last = first < paramCount ? first + std::min(count, paramCount - first) : first;
+
+                char bufStr[STR_MAX+1];
+                carla_zeroChars(bufStr, STR_MAX+1);
+
+                const CarlaMutexLocker _cml(fShmNonRtServerControl.mutex);
+
+                // always reply, even if empty, so the server does not keep waiting
+                for (uint32_t i=first;;)
+                {
+                    const uint32_t batchCount = std::min(kParameterInfoBatchSize, last - i);
+
+                    // uint/count, then uint/index and names for each
+                    fShmNonRtServerControl.writeOpcode(kPluginBridgeNonRtServerParameterNames);
+                    fShmNonRtServerControl.writeUInt(batchCount);
+
+                    for (uint32_t j=0; j<batchCount; ++j, ++i)
+                    {
+                        fShmNonRtServerControl.writeUInt(i);
+                        writeParameterNames(plugin, i, bufStr);
+                    }
+
+                    fShmNonRtServerControl.commitWrite();
+                    fShmNonRtServerControl.waitIfDataIsReachingLimit();
+
+                    if (i >= last)
+                        break;
+                }
+                break;
+            }
+
             case kPluginBridgeNonRtClientPrepareForSave: {
                 if (! plugin->isEnabled())
                 {
@@ -992,6 +1242,27 @@ public:
 
                 plugin->prepareForSave(false);
 
+                void* chunkData = nullptr;
+                std::size_t chunkDataSize = 0;
+
+                if (plugin->getOptionsEnabled() & PLUGIN_OPTION_USE_CHUNKS)
+                    chunkDataSize = plugin->getChunkData(&chunkData);
+
+                // ask only once per save
+                if (chunkDataSize > fShmSaveChunkPool.dataSize && ! fChunkPoolResizeRequested)
+                {
+                    fChunkPoolResizeRequested = true;
+
+                    const CarlaMutexLocker _cml(fShmNonRtServerControl.mutex);
+
+                    fShmNonRtServerControl.writeOpcode(kPluginBridgeNonRtServerResizeChunkDataShm);
+                    fShmNonRtServerControl.writeULong(static_cast<uint64_t>(chunkDataSize));
+                    fShmNonRtServerControl.commitWrite();
+                    break;
+                }
+
+                fChunkPoolResizeRequested = false;
+
                 for (uint32_t i=0, count=plugin->getCustomDataCount(); i<count; ++i)
                 {
                     const CustomData& cdata(plugin->getCustomData(i));
@@ -1024,32 +1295,41 @@ public:
                     }
                 }
 
-                if (plugin->getOptionsEnabled() & PLUGIN_OPTION_USE_CHUNKS)
+                // the server releases the save pool once it copied the previous chunk, use a file until then
+                if (chunkDataSize > 0 && chunkDataSize <= fShmSaveChunkPool.dataSize && fShmSaveChunkPool.acquire())
                 {
-                    void* data = nullptr;
-                    if (const std::size_t dataSize = plugin->getChunkData(&data))
-                    {
-                        CARLA_SAFE_ASSERT_BREAK(data != nullptr);
+                    CARLA_SAFE_ASSERT_BREAK(chunkData != nullptr);
+
+                    std::memcpy(fShmSaveChunkPool.data, chunkData, chunkDataSize);
+
+                    const CarlaMutexLocker _cml(fShmNonRtServerControl.mutex);
 
-                        CarlaString dataBase64 = CarlaString::asBase64(data, dataSize);
-                        CARLA_SAFE_ASSERT_BREAK(dataBase64.length() > 0);
+                    fShmNonRtServerControl.writeOpcode(kPluginBridgeNonRtServerSetChunkDataShm);
+                    fShmNonRtServerControl.writeULong(static_cast<uint64_t>(chunkDataSize));
+                    fShmNonRtServerControl.commitWrite();
+                }
+                else if (chunkDataSize > 0)
+                {
+                    CARLA_SAFE_ASSERT_BREAK(chunkData != nullptr);
 
-                        String filePath(File::getSpecialLocation(File::tempDirectory).getFullPathName());
+                    CarlaString dataBase64 = CarlaString::asBase64(chunkData, chunkDataSize);
+                    CARLA_SAFE_ASSERT_BREAK(dataBase64.length() > 0);
 
-                        filePath += CARLA_OS_SEP_STR ".CarlaChunk_";
-                        filePath += fShmAudioPool.getFilenameSuffix();
+                    String filePath(File::getSpecialLocation(File::tempDirectory).getFullPathName());
 
-                        if (File(filePath).replaceWithText(dataBase64.buffer()))
-                        {
-                            const uint32_t ulength(static_cast<uint32_t>(filePath.length()));
+                    filePath += CARLA_OS_SEP_STR ".CarlaChunk_";
+                    filePath += fShmAudioPool.getFilenameSuffix();
 
-                            const CarlaMutexLocker _cml(fShmNonRtServerControl.mutex);
+                    if (File(filePath).replaceWithText(dataBase64.buffer()))
+                    {
+                        const uint32_t ulength(static_cast<uint32_t>(filePath.length()));
+
+                        const CarlaMutexLocker _cml(fShmNonRtServerControl.mutex);
 
-                            fShmNonRtServerControl.writeOpcode(kPluginBridgeNonRtServerSetChunkDataFile);
-                            fShmNonRtServerControl.writeUInt(ulength);
-                            fShmNonRtServerControl.writeCustomData(filePath.toRawUTF8(), ulength);
-                            fShmNonRtServerControl.commitWrite();
-                        }
+                        fShmNonRtServerControl.writeOpcode(kPluginBridgeNonRtServerSetChunkDataFile);
+                        fShmNonRtServerControl.writeUInt(ulength);
+                        fShmNonRtServerControl.writeCustomData(filePath.toRawUTF8(), ulength);
+                        fShmNonRtServerControl.commitWrite();
                     }
                 }
 
@@ -1126,360 +1406,519 @@ public:
                 signalThreadShouldExit();
                 callback(true, true, ENGINE_CALLBACK_QUIT, 0, 0, 0, 0, 0.0f, nullptr);
                 break;
+
+            case kPluginBridgeNonRtClientLoadPlugin: {
+                // only valid for pooled bridges without a plugin, see handlePooledNonRtData()
+                carla_stderr2("CarlaEngineBridge::handleNonRtData() - plugin is already loaded, ignoring load request");
+
+                fShmNonRtClientControl.readUInt();
+
+                for (int i=0; i<2; ++i)
+                {
+                    if (const uint32_t size = fShmNonRtClientControl.readUInt())
+                    {
+                        char str[size];
+                        fShmNonRtClientControl.readCustomData(str, size);
+                    }
+                }
+
+                fShmNonRtClientControl.readLong();
+                break;
+            }
+
+            case kPluginBridgeNonRtClientAddGroupMember: {
+                // only valid for group leaders, see handlePooledNonRtData()
+                carla_stderr2("CarlaEngineBridge::handleNonRtData() - not a group leader, ignoring new member");
+
+                if (const uint32_t size = fShmNonRtClientControl.readUInt())
+                {
+                    char str[size];
+                    fShmNonRtClientControl.readCustomData(str, size);
+                }
+                break;
+            }
+
+            case kPluginBridgeNonRtClientSetThreadPolicy: {
+                // int/rtPrio, uint/size, str[] (cpu list)
+                const int32_t rtPrio(fShmNonRtClientControl.readInt());
+
+                const uint32_t cpuListSize(fShmNonRtClientControl.readUInt());
+                char cpuList[cpuListSize+1];
+                carla_zeroChars(cpuList, cpuListSize+1);
+                if (cpuListSize != 0)
+                    fShmNonRtClientControl.readCustomData(cpuList, cpuListSize);
+
+                // members of a group bridge are processed by the leader thread
+                CarlaEngineBridge* const rtThread = fGroupLeader != nullptr ? fGroupLeader : this;
+
+                if (! rtThread->isThreadRunning())
+                    break;
+
+                // applied by the RT thread itself, see applyPendingThreadPolicy()
+                const CarlaMutexLocker cml(rtThread->fThreadPolicyMutex);
+                rtThread->fThreadPolicyRtPrio   = rtPrio;
+                rtThread->fThreadPolicyCpuList  = cpuList;
+                rtThread->fThreadPolicyPending  = true;
+                break;
+            }
             }
         }
     }
 
-    // -------------------------------------------------------------------
-
-protected:
-    void run() override
+    // handles all pending RT messages, returns true if asked to quit
+    bool handleRtData()
     {
-#ifdef __SSE2_MATH__
-        // Set FTZ and DAZ flags
-        _mm_setcsr(_mm_getcsr() | 0x8040);
-#endif
-
         bool quitReceived = false;
 
-        for (; ! shouldThreadExit();)
+        for (; fShmRtClientControl.isDataAvailableForReading();)
         {
-            const BridgeRtClientControl::WaitHelper helper(fShmRtClientControl);
+            const PluginBridgeRtClientOpcode opcode(fShmRtClientControl.readOpcode());
+            const CarlaPluginPtr plugin = pData->plugins[0].plugin;
 
-            if (! helper.ok)
-                continue;
+#ifdef DEBUG
+            if (opcode != kPluginBridgeRtClientProcess) {
+                carla_debug("CarlaEngineBridgeRtThread::run() - got opcode: %s", PluginBridgeRtClientOpcode2str(opcode));
+            }
+#endif
 
-            for (; fShmRtClientControl.isDataAvailableForReading();)
+            switch (opcode)
             {
-                const PluginBridgeRtClientOpcode opcode(fShmRtClientControl.readOpcode());
-                const CarlaPluginPtr plugin = pData->plugins[0].plugin;
+            case kPluginBridgeRtClientNull:
+                break;
 
-#ifdef DEBUG
-                if (opcode != kPluginBridgeRtClientProcess && opcode != kPluginBridgeRtClientMidiEvent) {
-                    carla_debug("CarlaEngineBridgeRtThread::run() - got opcode: %s", PluginBridgeRtClientOpcode2str(opcode));
+            case kPluginBridgeRtClientSetAudioPool: {
+                if (fShmAudioPool.data != nullptr)
+                {
+                    jackbridge_shm_unmap(fShmAudioPool.shm, fShmAudioPool.data);
+                    fShmAudioPool.data = nullptr;
                 }
-#endif
+                const uint64_t poolSize(fShmRtClientControl.readULong());
+                CARLA_SAFE_ASSERT_BREAK(poolSize > 0);
+                fShmAudioPool.data = (float*)jackbridge_shm_map(fShmAudioPool.shm, static_cast<size_t>(poolSize));
+                break;
+            }
 
-                switch (opcode)
-                {
-                case kPluginBridgeRtClientNull:
-                    break;
+            case kPluginBridgeRtClientSetMidiBlockSize:
+                fMidiBlockSize = fShmRtClientControl.readUInt();
+                break;
 
-                case kPluginBridgeRtClientSetAudioPool: {
-                    if (fShmAudioPool.data != nullptr)
-                    {
-                        jackbridge_shm_unmap(fShmAudioPool.shm, fShmAudioPool.data);
-                        fShmAudioPool.data = nullptr;
-                    }
-                    const uint64_t poolSize(fShmRtClientControl.readULong());
-                    CARLA_SAFE_ASSERT_BREAK(poolSize > 0);
-                    fShmAudioPool.data = (float*)jackbridge_shm_map(fShmAudioPool.shm, static_cast<size_t>(poolSize));
-                    break;
-                }
+            case kPluginBridgeRtClientSetBufferSize: {
+                const uint32_t bufferSize(fShmRtClientControl.readUInt());
+                pData->bufferSize = bufferSize;
+                bufferSizeChanged(bufferSize);
+                break;
+            }
 
-                case kPluginBridgeRtClientSetBufferSize: {
-                    const uint32_t bufferSize(fShmRtClientControl.readUInt());
-                    pData->bufferSize = bufferSize;
-                    bufferSizeChanged(bufferSize);
-                    break;
-                }
+            case kPluginBridgeRtClientSetSampleRate: {
+                const double sampleRate(fShmRtClientControl.readDouble());
+                pData->sampleRate = sampleRate;
+                sampleRateChanged(sampleRate);
+                break;
+            }
 
-                case kPluginBridgeRtClientSetSampleRate: {
-                    const double sampleRate(fShmRtClientControl.readDouble());
-                    pData->sampleRate = sampleRate;
-                    sampleRateChanged(sampleRate);
-                    break;
+            case kPluginBridgeRtClientSetOnline:
+                fIsOffline = fShmRtClientControl.readBool();
+                offlineModeChanged(fIsOffline);
+                break;
+
+            // NOTE this is never used
+            case kPluginBridgeRtClientControlEventParameter: {
+                const uint32_t time(fShmRtClientControl.readUInt());
+                const uint8_t  channel(fShmRtClientControl.readByte());
+                const uint16_t param(fShmRtClientControl.readUShort());
+                const float    value(fShmRtClientControl.readFloat());
+
+                if (EngineEvent* const event = getNextFreeInputEvent())
+                {
+                    event->type                 = kEngineEventTypeControl;
+                    event->time                 = time;
+                    event->channel              = channel;
+                    event->ctrl.type            = kEngineControlEventTypeParameter;
+                    event->ctrl.param           = param;
+                    event->ctrl.midiValue       = -1;
+                    event->ctrl.normalizedValue = value;
+                    event->ctrl.handled         = true;
                 }
+                break;
+            }
 
-                case kPluginBridgeRtClientSetOnline:
-                    fIsOffline = fShmRtClientControl.readBool();
-                    offlineModeChanged(fIsOffline);
-                    break;
+            case kPluginBridgeRtClientControlEventMidiBank: {
+                const uint32_t time(fShmRtClientControl.readUInt());
+                const uint8_t  channel(fShmRtClientControl.readByte());
+                const uint16_t index(fShmRtClientControl.readUShort());
+
+                if (EngineEvent* const event = getNextFreeInputEvent())
+                {
+                    event->type                 = kEngineEventTypeControl;
+                    event->time                 = time;
+                    event->channel              = channel;
+                    event->ctrl.type            = kEngineControlEventTypeMidiBank;
+                    event->ctrl.param           = index;
+                    event->ctrl.midiValue       = -1;
+                    event->ctrl.normalizedValue = 0.0f;
+                    event->ctrl.handled         = true;
+                }
+                break;
+            }
 
-                // NOTE this is never used
-                case kPluginBridgeRtClientControlEventParameter: {
-                    const uint32_t time(fShmRtClientControl.readUInt());
-                    const uint8_t  channel(fShmRtClientControl.readByte());
-                    const uint16_t param(fShmRtClientControl.readUShort());
-                    const float    value(fShmRtClientControl.readFloat());
+            case kPluginBridgeRtClientControlEventMidiProgram: {
+                const uint32_t time(fShmRtClientControl.readUInt());
+                const uint8_t  channel(fShmRtClientControl.readByte());
+                const uint16_t index(fShmRtClientControl.readUShort());
 
-                    if (EngineEvent* const event = getNextFreeInputEvent())
-                    {
-                        event->type                 = kEngineEventTypeControl;
-                        event->time                 = time;
-                        event->channel              = channel;
-                        event->ctrl.type            = kEngineControlEventTypeParameter;
-                        event->ctrl.param           = param;
-                        event->ctrl.midiValue       = -1;
-                        event->ctrl.normalizedValue = value;
-                        event->ctrl.handled         = true;
-                    }
-                    break;
+                if (EngineEvent* const event = getNextFreeInputEvent())
+                {
+                    event->type                 = kEngineEventTypeControl;
+                    event->time                 = time;
+                    event->channel              = channel;
+                    event->ctrl.type            = kEngineControlEventTypeMidiProgram;
+                    event->ctrl.param           = index;
+                    event->ctrl.midiValue       = -1;
+                    event->ctrl.normalizedValue = 0.0f;
+                    event->ctrl.handled         = true;
                 }
+                break;
+            }
 
-                case kPluginBridgeRtClientControlEventMidiBank: {
-                    const uint32_t time(fShmRtClientControl.readUInt());
-                    const uint8_t  channel(fShmRtClientControl.readByte());
-                    const uint16_t index(fShmRtClientControl.readUShort());
+            case kPluginBridgeRtClientControlEventAllSoundOff: {
+                const uint32_t time(fShmRtClientControl.readUInt());
+                const uint8_t  channel(fShmRtClientControl.readByte());
 
-                    if (EngineEvent* const event = getNextFreeInputEvent())
-                    {
-                        event->type                 = kEngineEventTypeControl;
-                        event->time                 = time;
-                        event->channel              = channel;
-                        event->ctrl.type            = kEngineControlEventTypeMidiBank;
-                        event->ctrl.param           = index;
-                        event->ctrl.midiValue       = -1;
-                        event->ctrl.normalizedValue = 0.0f;
-                        event->ctrl.handled         = true;
-                    }
-                    break;
+                if (EngineEvent* const event = getNextFreeInputEvent())
+                {
+                    event->type                 = kEngineEventTypeControl;
+                    event->time                 = time;
+                    event->channel              = channel;
+                    event->ctrl.type            = kEngineControlEventTypeAllSoundOff;
+                    event->ctrl.param           = 0;
+                    event->ctrl.midiValue       = -1;
+                    event->ctrl.normalizedValue = 0.0f;
+                    event->ctrl.handled         = true;
                 }
+            }   break;
 
-                case kPluginBridgeRtClientControlEventMidiProgram: {
-                    const uint32_t time(fShmRtClientControl.readUInt());
-                    const uint8_t  channel(fShmRtClientControl.readByte());
-                    const uint16_t index(fShmRtClientControl.readUShort());
+            case kPluginBridgeRtClientControlEventAllNotesOff: {
+                const uint32_t time(fShmRtClientControl.readUInt());
+                const uint8_t  channel(fShmRtClientControl.readByte());
 
-                    if (EngineEvent* const event = getNextFreeInputEvent())
-                    {
-                        event->type                 = kEngineEventTypeControl;
-                        event->time                 = time;
-                        event->channel              = channel;
-                        event->ctrl.type            = kEngineControlEventTypeMidiProgram;
-                        event->ctrl.param           = index;
-                        event->ctrl.midiValue       = -1;
-                        event->ctrl.normalizedValue = 0.0f;
-                        event->ctrl.handled         = true;
-                    }
-                    break;
+                if (EngineEvent* const event = getNextFreeInputEvent())
+                {
+                    event->type                 = kEngineEventTypeControl;
+                    event->time                 = time;
+                    event->channel              = channel;
+                    event->ctrl.type            = kEngineControlEventTypeAllNotesOff;
+                    event->ctrl.param           = 0;
+                    event->ctrl.midiValue       = -1;
+                    event->ctrl.normalizedValue = 0.0f;
+                    event->ctrl.handled         = true;
                 }
+            }   break;
 
-                case kPluginBridgeRtClientControlEventAllSoundOff: {
-                    const uint32_t time(fShmRtClientControl.readUInt());
-                    const uint8_t  channel(fShmRtClientControl.readByte());
+            case kPluginBridgeRtClientMidiEvent:
+                // only used by JACK applications, plugin bridges always get MIDI through the audio pool blocks
+                carla_stderr2("CarlaEngineBridge: unexpected kPluginBridgeRtClientMidiEvent");
+                break;
 
-                    if (EngineEvent* const event = getNextFreeInputEvent())
-                    {
-                        event->type                 = kEngineEventTypeControl;
-                        event->time                 = time;
-                        event->channel              = channel;
-                        event->ctrl.type            = kEngineControlEventTypeAllSoundOff;
-                        event->ctrl.param           = 0;
-                        event->ctrl.midiValue       = -1;
-                        event->ctrl.normalizedValue = 0.0f;
-                        event->ctrl.handled         = true;
-                    }
-                }   break;
+            case kPluginBridgeRtClientProcess: {
+                const uint32_t frames(fShmRtClientControl.readUInt());
+
+                CARLA_SAFE_ASSERT_BREAK(fShmAudioPool.data != nullptr);
+
+                uint8_t* midiBlockOut = nullptr;
+
+                if (plugin.get() != nullptr && plugin->isEnabled() && plugin->tryLock(fIsOffline))
+                {
+                    const BridgeTimeInfo& bridgeTimeInfo(fShmRtClientControl.data->timeInfo);
+
+                    const uint32_t audioInCount(plugin->getAudioInCount());
+                    const uint32_t audioOutCount(plugin->getAudioOutCount());
+                    const uint32_t cvInCount(plugin->getCVInCount());
+                    const uint32_t cvOutCount(plugin->getCVOutCount());
 
-                case kPluginBridgeRtClientControlEventAllNotesOff: {
-                    const uint32_t time(fShmRtClientControl.readUInt());
-                    const uint8_t  channel(fShmRtClientControl.readByte());
+                    const float* audioIn[audioInCount];
+                    /* */ float* audioOut[audioOutCount];
+                    const float* cvIn[cvInCount];
+                    /* */ float* cvOut[cvOutCount];
 
-                    if (EngineEvent* const event = getNextFreeInputEvent())
+                    float* fdata = fShmAudioPool.data;
+
+                    for (uint32_t i=0; i < audioInCount; ++i, fdata += pData->bufferSize)
+                        audioIn[i] = fdata;
+                    for (uint32_t i=0; i < audioOutCount; ++i, fdata += pData->bufferSize)
+                        audioOut[i] = fdata;
+
+                    for (uint32_t i=0; i < cvInCount; ++i, fdata += pData->bufferSize)
+                        cvIn[i] = fdata;
+                    for (uint32_t i=0; i < cvOutCount; ++i, fdata += pData->bufferSize)
+                        cvOut[i] = fdata;
+
+                    if (fMidiBlockSize != 0)
                     {
-                        event->type                 = kEngineEventTypeControl;
-                        event->time                 = time;
-                        event->channel              = channel;
-                        event->ctrl.type            = kEngineControlEventTypeAllNotesOff;
-                        event->ctrl.param           = 0;
-                        event->ctrl.midiValue       = -1;
-                        event->ctrl.normalizedValue = 0.0f;
-                        event->ctrl.handled         = true;
+                        readMidiBlockInputEvents((const uint8_t*)fdata);
+                        midiBlockOut = (uint8_t*)fdata + fMidiBlockSize;
                     }
-                }   break;
 
-                case kPluginBridgeRtClientMidiEvent: {
-                    const uint32_t time(fShmRtClientControl.readUInt());
-                    const uint8_t  port(fShmRtClientControl.readByte());
-                    const uint8_t  size(fShmRtClientControl.readByte());
-                    CARLA_SAFE_ASSERT_BREAK(size > 0);
+                    EngineTimeInfo& timeInfo(pData->timeInfo);
 
-                    // FIXME variable-size stack
-                    uint8_t data[size];
+                    timeInfo.playing   = bridgeTimeInfo.playing;
+                    timeInfo.frame     = bridgeTimeInfo.frame;
+                    timeInfo.usecs     = bridgeTimeInfo.usecs;
+                    timeInfo.bbt.valid = (bridgeTimeInfo.validFlags & kPluginBridgeTimeInfoValidBBT) != 0;
 
-                    for (uint8_t i=0; i<size; ++i)
-                        data[i] = fShmRtClientControl.readByte();
+                    if (timeInfo.bbt.valid)
+                    {
+                        timeInfo.bbt.bar  = bridgeTimeInfo.bar;
+                        timeInfo.bbt.beat = bridgeTimeInfo.beat;
+                        timeInfo.bbt.tick = bridgeTimeInfo.tick;
+
+                        timeInfo.bbt.beatsPerBar = bridgeTimeInfo.beatsPerBar;
+                        timeInfo.bbt.beatType    = bridgeTimeInfo.beatType;
+
+                        timeInfo.bbt.ticksPerBeat   = bridgeTimeInfo.ticksPerBeat;
+                        timeInfo.bbt.beatsPerMinute = bridgeTimeInfo.beatsPerMinute;
+                        timeInfo.bbt.barStartTick   = bridgeTimeInfo.barStartTick;
+                        timeInfo.bbt.updatePPQ();
+                    }
 
-                    if (EngineEvent* const event = getNextFreeInputEvent())
+                    plugin->initBuffers();
                     {
-                        event->type    = kEngineEventTypeMidi;
-                        event->time    = time;
-                        event->channel = MIDI_GET_CHANNEL_FROM_DATA(data);
-
-                        event->midi.port = port;
-                        event->midi.size = size;
-
-                        if (size > EngineMidiEvent::kDataSize)
-                        {
-                            event->midi.dataExt = data;
-                            std::memset(event->midi.data, 0, sizeof(uint8_t)*EngineMidiEvent::kDataSize);
-                        }
-                        else
-                        {
-                            event->midi.data[0] = MIDI_GET_STATUS_FROM_DATA(data);
-
-                            uint8_t i=1;
-                            for (; i < size; ++i)
-                                event->midi.data[i] = data[i];
-                            for (; i < EngineMidiEvent::kDataSize; ++i)
-                                event->midi.data[i] = 0;
-
-                            event->midi.dataExt = nullptr;
-                        }
+                        const ScopedPluginDenormals spd(plugin->getOptionsEnabled());
+                        const ScopedPluginProcessTimer sppt(pData->plugins[0].processStats, plugin.get());
+                        plugin->process(audioIn, audioOut, cvIn, cvOut, frames);
                     }
-                    break;
+                    plugin->unlock();
                 }
 
-                case kPluginBridgeRtClientProcess: {
-                    const uint32_t frames(fShmRtClientControl.readUInt());
+                if (pData->events.in[0].type != kEngineEventTypeNull)
+                    carla_zeroStructs(pData->events.in, kMaxEngineEventInternalCount);
 
-                    CARLA_SAFE_ASSERT_BREAK(fShmAudioPool.data != nullptr);
+                if (pData->events.out[0].type != kEngineEventTypeNull)
+                {
+                    if (midiBlockOut != nullptr)
+                        writeMidiBlockOutputEvents(midiBlockOut);
 
-                    if (plugin.get() != nullptr && plugin->isEnabled() && plugin->tryLock(fIsOffline))
-                    {
-                        const BridgeTimeInfo& bridgeTimeInfo(fShmRtClientControl.data->timeInfo);
+                    carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
+                }
 
-                        const uint32_t audioInCount(plugin->getAudioInCount());
-                        const uint32_t audioOutCount(plugin->getAudioOutCount());
-                        const uint32_t cvInCount(plugin->getCVInCount());
-                        const uint32_t cvOutCount(plugin->getCVOutCount());
+            }   break;
 
-                        const float* audioIn[audioInCount];
-                        /* */ float* audioOut[audioOutCount];
-                        const float* cvIn[cvInCount];
-                        /* */ float* cvOut[cvOutCount];
+            case kPluginBridgeRtClientQuit: {
+                quitReceived = true;
+                fClosingDown = true;
+                signalThreadShouldExit();
+            }   break;
+            }
+        }
 
-                        float* fdata = fShmAudioPool.data;
+        return quitReceived;
+    }
 
-                        for (uint32_t i=0; i < audioInCount; ++i, fdata += pData->bufferSize)
-                            audioIn[i] = fdata;
-                        for (uint32_t i=0; i < audioOutCount; ++i, fdata += pData->bufferSize)
-                            audioOut[i] = fdata;
+    // -------------------------------------------------------------------
+    // group leader side, each member is an engine of its own with a single plugin
 
-                        for (uint32_t i=0; i < cvInCount; ++i, fdata += pData->bufferSize)
-                            cvIn[i] = fdata;
-                        for (uint32_t i=0; i < cvOutCount; ++i, fdata += pData->bufferSize)
-                            cvOut[i] = fdata;
+    void addGroupMember(const char* const shmIds)
+    {
+        char audioPoolBaseName[6+1];
+        char rtClientBaseName[6+1];
+        char nonRtClientBaseName[6+1];
+        char nonRtServerBaseName[6+1];
+
+        std::memcpy(audioPoolBaseName,   shmIds+6*0, 6);
+        std::memcpy(rtClientBaseName,    shmIds+6*1, 6);
+        std::memcpy(nonRtClientBaseName, shmIds+6*2, 6);
+        std::memcpy(nonRtServerBaseName, shmIds+6*3, 6);
+        audioPoolBaseName[6]   = '\0';
+        rtClientBaseName[6]    = '\0';
+        nonRtClientBaseName[6] = '\0';
+        nonRtServerBaseName[6] = '\0';
+
+        CarlaScopedPointer<CarlaEngineBridge> member(new CarlaEngineBridge(audioPoolBaseName,
+                                                                           rtClientBaseName,
+                                                                           nonRtClientBaseName,
+                                                                           nonRtServerBaseName));
+
+        setGroupMemberOptions(member.get());
+        member->fGroupLeader = this;
+
+        if (! member->init(getName()))
+        {
+            carla_stderr2("CarlaEngineBridge::addGroupMember(\"%s\") - failed to init new member", shmIds);
+            return;
+        }
 
-                        EngineTimeInfo& timeInfo(pData->timeInfo);
+        const CarlaMutexLocker cml(fGroupMembersMutex);
+        fGroupMembers.append(member.release());
+    }
 
-                        timeInfo.playing   = bridgeTimeInfo.playing;
-                        timeInfo.frame     = bridgeTimeInfo.frame;
-                        timeInfo.usecs     = bridgeTimeInfo.usecs;
-                        timeInfo.bbt.valid = (bridgeTimeInfo.validFlags & kPluginBridgeTimeInfoValidBBT) != 0;
+    // members get the same options as their leader, which got them from the environment
+    void setGroupMemberOptions(CarlaEngineBridge* const member) const noexcept
+    {
+        const EngineOptions& options(pData->options);
+
+        member->setOption(ENGINE_OPTION_PROCESS_MODE,          ENGINE_PROCESS_MODE_BRIDGE,             nullptr);
+        member->setOption(ENGINE_OPTION_TRANSPORT_MODE,        ENGINE_TRANSPORT_MODE_BRIDGE,           nullptr);
+        member->setOption(ENGINE_OPTION_FORCE_STEREO,          options.forceStereo         ? 1 : 0,    nullptr);
+        member->setOption(ENGINE_OPTION_PREFER_PLUGIN_BRIDGES, options.preferPluginBridges ? 1 : 0,    nullptr);
+        member->setOption(ENGINE_OPTION_PREFER_UI_BRIDGES,     options.preferUiBridges     ? 1 : 0,    nullptr);
+        member->setOption(ENGINE_OPTION_UIS_ALWAYS_ON_TOP,     options.uisAlwaysOnTop      ? 1 : 0,    nullptr);
+        member->setOption(ENGINE_OPTION_MAX_PARAMETERS,        static_cast<int>(options.maxParameters),    nullptr);
+        member->setOption(ENGINE_OPTION_RESET_XRUNS,           options.resetXruns          ? 1 : 0,    nullptr);
+        member->setOption(ENGINE_OPTION_UI_BRIDGES_TIMEOUT,    static_cast<int>(options.uiBridgesTimeout), nullptr);
+        member->setOption(ENGINE_OPTION_PREVENT_BAD_BEHAVIOUR, options.preventBadBehaviour ? 1 : 0,    nullptr);
+        member->setOption(ENGINE_OPTION_FLUSH_DENORMALS,       options.flushDenormals      ? 1 : 0,    nullptr);
+
+        if (options.pathAudio != nullptr)
+            member->setOption(ENGINE_OPTION_FILE_PATH, FILE_AUDIO, options.pathAudio);
+        if (options.pathMIDI != nullptr)
+            member->setOption(ENGINE_OPTION_FILE_PATH, FILE_MIDI, options.pathMIDI);
+
+        if (options.pathLADSPA != nullptr)
+            member->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_LADSPA, options.pathLADSPA);
+        if (options.pathDSSI != nullptr)
+            member->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_DSSI, options.pathDSSI);
+        if (options.pathLV2 != nullptr)
+            member->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_LV2, options.pathLV2);
+        if (options.pathVST2 != nullptr)
+            member->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_VST2, options.pathVST2);
+        if (options.pathVST3 != nullptr)
+            member->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_VST3, options.pathVST3);
+        if (options.pathSF2 != nullptr)
+            member->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_SF2, options.pathSF2);
+        if (options.pathSFZ != nullptr)
+            member->setOption(ENGINE_OPTION_PLUGIN_PATH, PLUGIN_SFZ, options.pathSFZ);
+
+        if (options.binaryDir != nullptr)
+            member->setOption(ENGINE_OPTION_PATH_BINARIES, 0, options.binaryDir);
+        if (options.resourceDir != nullptr)
+            member->setOption(ENGINE_OPTION_PATH_RESOURCES, 0, options.resourceDir);
+
+        if (options.frontendWinId != 0)
+        {
+            char strBuf[STR_MAX+1];
+            std::snprintf(strBuf, STR_MAX, P_UINTPTR, options.frontendWinId);
+            strBuf[STR_MAX] = '\0';
+            member->setOption(ENGINE_OPTION_FRONTEND_WIN_ID, 0, strBuf);
+        }
+    }
 
-                        if (timeInfo.bbt.valid)
-                        {
-                            timeInfo.bbt.bar  = bridgeTimeInfo.bar;
-                            timeInfo.bbt.beat = bridgeTimeInfo.beat;
-                            timeInfo.bbt.tick = bridgeTimeInfo.tick;
+    // runs the non-RT side of all members, removing those that have been closed
+    void idleGroupMembers()
+    {
+        for (LinkedList<CarlaEngineBridge*>::Itenerator it = fGroupMembers.begin2(); it.valid(); it.next())
+        {
+            CarlaEngineBridge* const member(it.getValue(nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(member != nullptr);
 
-                            timeInfo.bbt.beatsPerBar = bridgeTimeInfo.beatsPerBar;
-                            timeInfo.bbt.beatType    = bridgeTimeInfo.beatType;
+            member->idle();
 
-                            timeInfo.bbt.ticksPerBeat   = bridgeTimeInfo.ticksPerBeat;
-                            timeInfo.bbt.beatsPerMinute = bridgeTimeInfo.beatsPerMinute;
-                            timeInfo.bbt.barStartTick   = bridgeTimeInfo.barStartTick;
-                        }
+            if (member->isRunning())
+                continue;
 
-                        plugin->initBuffers();
-                        plugin->process(audioIn, audioOut, cvIn, cvOut, frames);
-                        plugin->unlock();
-                    }
+            {
+                const CarlaMutexLocker cml(fGroupMembersMutex);
+                fGroupMembers.remove(it);
+            }
 
-                    uint8_t* midiData(fShmRtClientControl.data->midiOut);
-                    carla_zeroBytes(midiData, kBridgeBaseMidiOutHeaderSize);
-                    std::size_t curMidiDataPos = 0;
+            member->close();
+            delete member;
+        }
+    }
 
-                    if (pData->events.in[0].type != kEngineEventTypeNull)
-                        carla_zeroStructs(pData->events.in, kMaxEngineEventInternalCount);
+    void closeGroupMembers()
+    {
+        LinkedList<CarlaEngineBridge*> members;
 
-                    if (pData->events.out[0].type != kEngineEventTypeNull)
-                    {
-                        for (ushort i=0; i < kMaxEngineEventInternalCount; ++i)
-                        {
-                            const EngineEvent& event(pData->events.out[i]);
+        {
+            const CarlaMutexLocker cml(fGroupMembersMutex);
+            fGroupMembers.moveTo(members);
+        }
 
-                            if (event.type == kEngineEventTypeNull)
-                                break;
+        for (LinkedList<CarlaEngineBridge*>::Itenerator it = members.begin2(); it.valid(); it.next())
+        {
+            CarlaEngineBridge* const member(it.getValue(nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(member != nullptr);
 
-                            if (event.type == kEngineEventTypeControl)
-                            {
-                                uint8_t data[3];
-                                const uint8_t size = event.ctrl.convertToMidiData(event.channel, data);
-                                CARLA_SAFE_ASSERT_CONTINUE(size > 0 && size <= 3);
+            member->close();
+            delete member;
+        }
 
-                                if (curMidiDataPos + kBridgeBaseMidiOutHeaderSize + size >= kBridgeRtClientDataMidiOutSize)
-                                    break;
+        members.clear();
+    }
 
-                                // set time
-                                *(uint32_t*)midiData = event.time;
-                                midiData = midiData + 4;
-                                curMidiDataPos += 4;
+    // called from the RT thread, which changes its own scheduling through jackbridge
+    // so that it also works for Windows bridges running in Wine
+    void applyPendingThreadPolicy() noexcept
+    {
+        if (! fThreadPolicyPending)
+            return;
+
+        const CarlaMutexTryLocker cmtl(fThreadPolicyMutex);
+
+        if (! cmtl.wasLocked())
+            return;
 
-                                // set port
-                                *midiData++ = 0;
-                                ++curMidiDataPos;
+        jackbridge_set_thread_policy(fThreadPolicyRtPrio, fThreadPolicyCpuList.buffer());
+        fThreadPolicyPending = false;
+    }
 
-                                // set size
-                                *midiData++ = size;
-                                ++curMidiDataPos;
+    // called from the leader RT thread, each time the server wakes it up
+    void runGroupMembers()
+    {
+        for (; ! shouldThreadExit();)
+        {
+            applyPendingThreadPolicy();
 
-                                // set data
-                                for (uint8_t j=0; j<size; ++j)
-                                    *midiData++ = data[j];
+            if (! fShmRtClientControl.waitForGroupRequest(5000))
+                continue;
 
-                                curMidiDataPos += size;
-                            }
-                            else if (event.type == kEngineEventTypeMidi)
-                            {
-                                const EngineMidiEvent& _midiEvent(event.midi);
+            const CarlaMutexLocker cml(fGroupMembersMutex);
 
-                                if (curMidiDataPos + kBridgeBaseMidiOutHeaderSize + _midiEvent.size >= kBridgeRtClientDataMidiOutSize)
-                                    break;
+            for (LinkedList<CarlaEngineBridge*>::Itenerator it = fGroupMembers.begin2(); it.valid(); it.next())
+            {
+                CarlaEngineBridge* const member(it.getValue(nullptr));
+                CARLA_SAFE_ASSERT_CONTINUE(member != nullptr);
 
-                                const uint8_t* const _midiData(_midiEvent.dataExt != nullptr ? _midiEvent.dataExt : _midiEvent.data);
+                // members without a pending request are skipped right away
+                const BridgeRtClientControl::GroupedWaitHelper helper(member->fShmRtClientControl);
 
-                                // set time
-                                *(uint32_t*)midiData = event.time;
-                                midiData += 4;
-                                curMidiDataPos += 4;
+                if (helper.ok)
+                    member->handleRtData();
+            }
+        }
+    }
 
-                                // set port
-                                *midiData++ = _midiEvent.port;
-                                ++curMidiDataPos;
+    // -------------------------------------------------------------------
 
-                                // set size
-                                *midiData++ = _midiEvent.size;
-                                ++curMidiDataPos;
+protected:
+    void run() override
+    {
+        // Set FTZ and DAZ flags
+        if (pData->options.flushDenormals)
+            carla_setDenormalsFlushed(true);
 
-                                // set data
-                                *midiData++ = uint8_t(_midiData[0] | (event.channel & MIDI_CHANNEL_BIT));
+        // engine defaults, plugin overrides come later through kPluginBridgeNonRtClientSetThreadPolicy
+        jackbridge_set_thread_policy(pData->options.bridgeRtPrio, pData->options.bridgeCpuAffinity);
 
-                                for (uint8_t j=1; j<_midiEvent.size; ++j)
-                                    *midiData++ = _midiData[j];
+        if (fIsGroupLeader)
+        {
+            runGroupMembers();
+            callback(true, true, ENGINE_CALLBACK_ENGINE_STOPPED, 0, 0, 0, 0, 0.0f, nullptr);
+            return;
+        }
 
-                                curMidiDataPos += _midiEvent.size;
-                            }
-                        }
+        bool quitReceived = false;
 
-                        if (curMidiDataPos != 0 &&
-                            curMidiDataPos + kBridgeBaseMidiOutHeaderSize < kBridgeRtClientDataMidiOutSize)
-                            carla_zeroBytes(midiData, kBridgeBaseMidiOutHeaderSize);
+        for (; ! shouldThreadExit();)
+        {
+            applyPendingThreadPolicy();
 
-                        carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
-                    }
+            const BridgeRtClientControl::WaitHelper helper(fShmRtClientControl);
 
-                }   break;
+            if (! helper.ok)
+                continue;
 
-                case kPluginBridgeRtClientQuit: {
-                    quitReceived = true;
-                    fClosingDown = true;
-                    signalThreadShouldExit();
-                }   break;
-                }
-            }
+            if (handleRtData())
+                quitReceived = true;
         }
 
         callback(true, true, ENGINE_CALLBACK_ENGINE_STOPPED, 0, 0, 0, 0, 0.0f, nullptr);
@@ -1497,6 +1936,130 @@ protected:
         }
     }
 
+    // called from process thread above, merges MIDI block events into the control events received so far
+    void readMidiBlockInputEvents(const uint8_t* const block) const noexcept
+    {
+        const BridgeMidiBlockHeader* const header = (const BridgeMidiBlockHeader*)block;
+
+        if (header->count == 0)
+            return;
+
+        CARLA_SAFE_ASSERT_RETURN(header->size <= fMidiBlockSize - sizeof(BridgeMidiBlockHeader),);
+
+        EngineEvent* const events = pData->events.in;
+        const uint32_t ctrlCount = getEngineEventCount(events);
+        const uint32_t ctrlStart = kMaxEngineEventInternalCount - ctrlCount;
+
+        // move control events to the end, so both sorted lists can be merged from the start
+        if (ctrlCount != 0 && ctrlStart != 0)
+            std::memmove(events + ctrlStart, events, sizeof(EngineEvent)*ctrlCount);
+
+        const uint8_t* midiData = block + sizeof(BridgeMidiBlockHeader);
+        const uint8_t* const midiDataEnd = midiData + header->size;
+        uint32_t midiLeft = std::min(header->count, ctrlStart);
+        uint32_t w = 0, r = ctrlStart;
+
+        for (uint32_t time; midiLeft != 0; ++w)
+        {
+            std::memcpy(&time, midiData, sizeof(uint32_t));
+
+            if (r < kMaxEngineEventInternalCount && events[r].time <= time)
+            {
+                events[w] = events[r++];
+                continue;
+            }
+
+            const uint8_t port = midiData[4];
+            const uint8_t size = midiData[5];
+            const uint8_t* const data = midiData + kBridgeBaseMidiOutHeaderSize;
+
+            if (size == 0 || data + size > midiDataEnd)
+            {
+                carla_safe_assert("size != 0 && data + size <= midiDataEnd", __FILE__, __LINE__);
+                break;
+            }
+
+            midiData = data + size;
+            --midiLeft;
+
+            EngineEvent& event(events[w]);
+            event.type    = kEngineEventTypeMidi;
+            event.time    = time;
+            event.channel = MIDI_GET_CHANNEL_FROM_DATA(data);
+
+            event.midi.port = port;
+            event.midi.size = size;
+
+            if (size > EngineMidiEvent::kDataSize)
+            {
+                // the block stays untouched until the next process call
+                event.midi.dataExt = data;
+                std::memset(event.midi.data, 0, sizeof(uint8_t)*EngineMidiEvent::kDataSize);
+            }
+            else
+            {
+                event.midi.data[0] = MIDI_GET_STATUS_FROM_DATA(data);
+
+                uint8_t i=1;
+                for (; i < size; ++i)
+                    event.midi.data[i] = data[i];
+                for (; i < EngineMidiEvent::kDataSize; ++i)
+                    event.midi.data[i] = 0;
+
+                event.midi.dataExt = nullptr;
+            }
+        }
+
+        // remaining control events, then clear the ones left behind
+        if (r < kMaxEngineEventInternalCount)
+        {
+            if (w != r)
+                std::memmove(events + w, events + r, sizeof(EngineEvent)*(kMaxEngineEventInternalCount - r));
+            w += kMaxEngineEventInternalCount - r;
+        }
+
+        if (ctrlCount != 0 && w < kMaxEngineEventInternalCount)
+        {
+            const uint32_t clearStart = std::max(w, ctrlStart);
+            carla_zeroStructs(events + clearStart, kMaxEngineEventInternalCount - clearStart);
+        }
+    }
+
+    // called from process thread above, writes all output events into the MIDI block
+    void writeMidiBlockOutputEvents(uint8_t* const block) const noexcept
+    {
+        for (ushort i=0; i < kMaxEngineEventInternalCount; ++i)
+        {
+            const EngineEvent& event(pData->events.out[i]);
+
+            if (event.type == kEngineEventTypeNull)
+                break;
+
+            if (event.type == kEngineEventTypeControl)
+            {
+                uint8_t data[3];
+                const uint8_t size = event.ctrl.convertToMidiData(event.channel, data);
+                CARLA_SAFE_ASSERT_CONTINUE(size > 0 && size <= 3);
+
+                if (writeBridgeMidiBlockEvent(block, fMidiBlockSize, event.time, 0, size, data) == nullptr)
+                    break;
+            }
+            else if (event.type == kEngineEventTypeMidi)
+            {
+                const EngineMidiEvent& midiEvent(event.midi);
+
+                uint8_t* const data = writeBridgeMidiBlockEvent(block, fMidiBlockSize, event.time,
+                                                                midiEvent.port, midiEvent.size,
+                                                                midiEvent.dataExt != nullptr ? midiEvent.dataExt
+                                                                                             : midiEvent.data);
+                if (data == nullptr)
+                    break;
+
+                data[0] = uint8_t(data[0] | (event.channel & MIDI_CHANNEL_BIT));
+            }
+        }
+    }
+
     // called from process thread above
     EngineEvent* getNextFreeInputEvent() const noexcept
     {
@@ -1522,7 +2085,23 @@ protected:
     // -------------------------------------------------------------------
 
 private:
+    // (re)attaches to a chunk pool announced by the server, the suffix changes when the server recreates it
+    static bool attachChunkPool(BridgeChunkPool& pool, const char* const suffix, const uint64_t poolSize) noexcept
+    {
+        const char* const currentSuffix = pool.filename.isNotEmpty() ? pool.getFilenameSuffix() : nullptr;
+
+        if (currentSuffix == nullptr || std::strcmp(currentSuffix, suffix) != 0)
+        {
+            pool.clear();
+            CARLA_SAFE_ASSERT_RETURN(pool.attachClient(suffix), false);
+        }
+
+        return pool.map(static_cast<std::size_t>(poolSize));
+    }
+
     BridgeAudioPool          fShmAudioPool;
+    BridgeChunkPool          fShmChunkPool;     // from the server, setChunkData
+    BridgeChunkPool          fShmSaveChunkPool; // to the server, saves
     BridgeRtClientControl    fShmRtClientControl;
     BridgeNonRtClientControl fShmNonRtClientControl;
     BridgeNonRtServerControl fShmNonRtServerControl;
@@ -1535,8 +2114,25 @@ private:
     bool fClosingDown;
     bool fIsOffline;
     bool fFirstIdle;
+    bool fChunkPoolResizeRequested;
+    bool fWaitingForPlugin;
     int64_t fLastPingTime;
 
+    // MIDI blocks in the audio pool, see kPluginBridgeRtClientSetMidiBlockSize
+    uint32_t fMidiBlockSize;
+
+    // bridges hosting several plugins, see kPluginBridgeNonRtClientAddGroupMember
+    bool fIsGroupLeader;
+    CarlaEngineBridge* fGroupLeader;
+    LinkedList<CarlaEngineBridge*> fGroupMembers;
+    CarlaMutex fGroupMembersMutex;
+
+    // see kPluginBridgeNonRtClientSetThreadPolicy
+    CarlaMutex fThreadPolicyMutex;
+    int32_t fThreadPolicyRtPrio;
+    CarlaString fThreadPolicyCpuList;
+    volatile bool fThreadPolicyPending;
+
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaEngineBridge)
 };
 
@@ -18,6 +18,10 @@
 #include "CarlaEngineClient.hpp"
 #include "CarlaEngineUtils.hpp"
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+#include "CarlaEngineGraph.hpp"
+#endif
+
 #include "CarlaString.hpp"
 
 CARLA_BACKEND_START_NAMESPACE
@@ -222,6 +226,27 @@ uint32_t CarlaEngineClient::getLatency() const noexcept
 void CarlaEngineClient::setLatency(const uint32_t samples) noexcept
 {
     pData->latency = samples;
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    if (PatchbayGraph* const graph = pData->egraph.getPatchbayGraphOrNull())
+    {
+        try {
+            graph->setPluginLatency(pData->plugin, samples);
+        } CARLA_SAFE_EXCEPTION("setPluginLatency");
+    }
+#endif
+}
+
+void CarlaEngineClient::pluginBufferSizeChanged() noexcept
+{
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    if (PatchbayGraph* const graph = pData->egraph.getPatchbayGraphOrNull())
+    {
+        try {
+            graph->setPluginBufferSize(pData->plugin);
+        } CARLA_SAFE_EXCEPTION("setPluginBufferSize");
+    }
+#endif
 }
 
 CarlaEnginePort* CarlaEngineClient::addPort(const EnginePortType portType, const char* const name, const bool isInput, const uint32_t indexOffset)
@@ -219,6 +219,7 @@ EngineOptions::EngineOptions() noexcept
       audioTripleBuffer(false),
       audioDriver(nullptr),
       audioDevice(nullptr),
+      audioSecondaryDevice(nullptr),
 #ifndef BUILD_BRIDGE
 # ifdef CARLA_OS_WIN
       oscEnabled(false),
@@ -241,7 +242,33 @@ EngineOptions::EngineOptions() noexcept
       resourceDir(nullptr),
       clientNamePrefix(nullptr),
       preventBadBehaviour(false),
-      frontendWinId(0)
+      frontendWinId(0),
+      processingThreads(0),
+      rackLanes(false),
+      pipelinedBridges(false),
+      bridgeSpinTime(0),
+      saveChunksAsFiles(false),
+      eventSplitGranularity(1),
+      eventSplitMinFrames(0),
+      bridgePoolSize(0),
+      bridgeGroupSize(0),
+      lv2LazyLoading(false),
+      sfzPreloadTime(0),
+      sfzRenderThreads(0),
+      cvControlPeriod(0),
+      eventPortBufferSize(256),
+      flushDenormals(true),
+      asyncCallbacks(false),
+      bridgeRtPrio(0),
+      bridgeCpuAffinity(nullptr),
+      processingCpuAffinity(nullptr),
+      dormantInactivePlugins(false),
+      patchbayDecoupledBufferSize(1024),
+      replacePluginCrossfade(0),
+      lockMemory(0),
+      compactParameterState(0),
+      shareUiBridges(false),
+      inlineDisplayMaxRate(30)
 #ifndef CARLA_OS_WIN
       , wine()
 #endif
@@ -260,6 +287,11 @@ EngineOptions::~EngineOptions() noexcept
         delete[] audioDevice;
         audioDevice = nullptr;
     }
+    if (audioSecondaryDevice != nullptr)
+    {
+        delete[] audioSecondaryDevice;
+        audioSecondaryDevice = nullptr;
+    }
     if (pathAudio != nullptr)
     {
         delete[] pathAudio;
@@ -320,6 +352,16 @@ EngineOptions::~EngineOptions() noexcept
         delete[] clientNamePrefix;
         clientNamePrefix = nullptr;
     }
+    if (bridgeCpuAffinity != nullptr)
+    {
+        delete[] bridgeCpuAffinity;
+        bridgeCpuAffinity = nullptr;
+    }
+    if (processingCpuAffinity != nullptr)
+    {
+        delete[] processingCpuAffinity;
+        processingCpuAffinity = nullptr;
+    }
 }
 
 #ifndef CARLA_OS_WIN
@@ -359,7 +401,9 @@ EngineTimeInfoBBT::EngineTimeInfoBBT() noexcept
       beatsPerBar(0.0f),
       beatType(0.0f),
       ticksPerBeat(0.0),
-      beatsPerMinute(0.0) {}
+      beatsPerMinute(0.0),
+      ppqPos(0.0),
+      ppqBarStartPos(0.0) {}
 
 EngineTimeInfoBBT::EngineTimeInfoBBT(const EngineTimeInfoBBT& bbt) noexcept
     : valid(bbt.valid),
@@ -370,7 +414,9 @@ EngineTimeInfoBBT::EngineTimeInfoBBT(const EngineTimeInfoBBT& bbt) noexcept
       beatsPerBar(bbt.beatsPerBar),
       beatType(bbt.beatType),
       ticksPerBeat(bbt.ticksPerBeat),
-      beatsPerMinute(bbt.beatsPerMinute) {}
+      beatsPerMinute(bbt.beatsPerMinute),
+      ppqPos(bbt.ppqPos),
+      ppqBarStartPos(bbt.ppqBarStartPos) {}
 
 void EngineTimeInfoBBT::clear() noexcept
 {
@@ -383,6 +429,20 @@ void EngineTimeInfoBBT::clear() noexcept
     beatType = 0.0f;
     ticksPerBeat = 0.0;
     beatsPerMinute = 0.0;
+    ppqPos = 0.0;
+    ppqBarStartPos = 0.0;
+}
+
+void EngineTimeInfoBBT::updatePPQ() noexcept
+{
+    if (! valid || bar <= 0 || beat <= 0 || carla_isZero(ticksPerBeat))
+    {
+        ppqPos = ppqBarStartPos = 0.0;
+        return;
+    }
+
+    ppqBarStartPos = static_cast<double>(beatsPerBar) * (bar - 1);
+    ppqPos = ppqBarStartPos + static_cast<double>(beat - 1) + tick / ticksPerBeat;
 }
 
 // -----------------------------------------------------------------------
@@ -422,6 +482,8 @@ EngineTimeInfo& EngineTimeInfo::operator=(const EngineTimeInfo& info) noexcept
     bbt.beatType = info.bbt.beatType;
     bbt.ticksPerBeat = info.bbt.ticksPerBeat;
     bbt.beatsPerMinute = info.bbt.beatsPerMinute;
+    bbt.ppqPos = info.bbt.ppqPos;
+    bbt.ppqBarStartPos = info.bbt.ppqBarStartPos;
 
     return *this;
 }
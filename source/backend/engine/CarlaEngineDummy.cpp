@@ -19,8 +19,11 @@
 #include "CarlaEngineInit.hpp"
 #include "CarlaEngineInternal.hpp"
 
+#include "CarlaRtLog.hpp"
+#include "CarlaTimeUtils.hpp"
+
+#include <cerrno>
 #include <ctime>
-#include <sys/time.h>
 
 CARLA_BACKEND_START_NAMESPACE
 
@@ -34,7 +37,8 @@ public:
     CarlaEngineDummy()
         : CarlaEngine(),
           CarlaThread("CarlaEngineDummy"),
-          fRunning(false)
+          fRunning(false),
+          fBenchmark(std::getenv("CARLA_DUMMY_BENCHMARK") != nullptr)
     {
         carla_debug("CarlaEngineDummy::CarlaEngineDummy()");
 
@@ -54,7 +58,8 @@ public:
         CARLA_SAFE_ASSERT_RETURN(clientName != nullptr && clientName[0] != '\0', false);
         carla_debug("CarlaEngineDummy::init(\"%s\")", clientName);
 
-        if (pData->options.processMode != ENGINE_PROCESS_MODE_CONTINUOUS_RACK)
+        if (pData->options.processMode != ENGINE_PROCESS_MODE_CONTINUOUS_RACK &&
+            pData->options.processMode != ENGINE_PROCESS_MODE_PATCHBAY)
         {
             setLastError("Invalid process mode");
             return false;
@@ -84,6 +89,9 @@ public:
 
         patchbayRefresh(true, false, false);
 
+        if (pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
+            refreshExternalGraphPorts<PatchbayGraph>(pData->graph.getPatchbayGraph(), false, false);
+
         callback(true, true,
                  ENGINE_CALLBACK_ENGINE_STARTED,
                  0,
@@ -130,11 +138,27 @@ public:
     // -------------------------------------------------------------------
     // Patchbay
 
-    bool patchbayRefresh(const bool sendHost, const bool sendOSC, const bool) override
+    bool patchbayRefresh(const bool sendHost, const bool sendOSC, const bool external) override
     {
         CARLA_SAFE_ASSERT_RETURN(pData->graph.isReady(), false);
 
-        RackGraph* const graph = pData->graph.getRackGraph();
+        if (pData->options.processMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK)
+            return refreshExternalGraphPorts<RackGraph>(pData->graph.getRackGraph(), sendHost, sendOSC);
+
+        if (sendHost)
+            pData->graph.setUsingExternalHost(external);
+        if (sendOSC)
+            pData->graph.setUsingExternalOSC(external);
+
+        if (external)
+            return refreshExternalGraphPorts<PatchbayGraph>(pData->graph.getPatchbayGraph(), sendHost, sendOSC);
+
+        return CarlaEngine::patchbayRefresh(sendHost, sendOSC, false);
+    }
+
+    template<class Graph>
+    bool refreshExternalGraphPorts(Graph* const graph, const bool sendHost, const bool sendOSC)
+    {
         CARLA_SAFE_ASSERT_RETURN(graph != nullptr, false);
 
         ExternalGraph& extGraph(graph->extGraph);
@@ -179,7 +203,7 @@ public:
         // now refresh
 
         if (sendHost || sendOSC)
-            graph->refresh(sendHost, sendOSC, false, "Dummy");
+            graph->refresh(sendHost, sendOSC, true, "Dummy");
 
         return true;
     }
@@ -187,24 +211,59 @@ public:
     // -------------------------------------------------------------------
 
 protected:
-    static int64_t getTimeInMicroseconds() noexcept
+#if !(defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN))
+    static void addNanoseconds(struct timespec& ts, const int64_t nsecs) noexcept
+    {
+        const int64_t total = static_cast<int64_t>(ts.tv_nsec) + nsecs;
+
+        ts.tv_sec  += static_cast<time_t>(total / 1000000000);
+        ts.tv_nsec  = static_cast<long>(total % 1000000000);
+    }
+
+    static bool isBefore(const struct timespec& a, const struct timespec& b) noexcept
     {
-    #if defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN)
-        struct timeval tv;
-        gettimeofday(&tv, nullptr);
-
-        return (tv.tv_sec * 1000000) + tv.tv_usec;
-    #else
-        struct timespec ts;
-    # ifdef CLOCK_MONOTONIC_RAW
-        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
-    # else
-        clock_gettime(CLOCK_MONOTONIC, &ts);
-    # endif
-
-        return (ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
-    #endif
+        return a.tv_sec < b.tv_sec || (a.tv_sec == b.tv_sec && a.tv_nsec < b.tv_nsec);
     }
+#endif
+
+    struct BenchmarkStats {
+        int64_t startTime, lastReportTime;
+        uint64_t cycles, totalUsecs;
+        int64_t minUsecs, maxUsecs;
+
+        BenchmarkStats(const int64_t now) noexcept
+            : startTime(now),
+              lastReportTime(now),
+              cycles(0),
+              totalUsecs(0),
+              minUsecs(INT64_MAX),
+              maxUsecs(0) {}
+
+        void add(const int64_t usecs) noexcept
+        {
+            ++cycles;
+            totalUsecs += static_cast<uint64_t>(usecs);
+
+            if (usecs < minUsecs)
+                minUsecs = usecs;
+            if (usecs > maxUsecs)
+                maxUsecs = usecs;
+        }
+
+        void report(const int64_t now, const int64_t cycleTime) const noexcept
+        {
+            if (cycles == 0 || now <= startTime)
+                return;
+
+            const double elapsed = static_cast<double>(now - startTime);
+            const double speed   = static_cast<double>(cycles) * static_cast<double>(cycleTime) / elapsed;
+
+            carla_stdout("CarlaEngineDummy benchmark: " P_UINT64 " cycles, "
+                         "avg %.1fus, min " P_INT64 "us, max " P_INT64 "us, %.2fx realtime",
+                         cycles, static_cast<double>(totalUsecs) / static_cast<double>(cycles),
+                         minUsecs, maxUsecs, speed);
+        }
+    };
 
     void run() override
     {
@@ -212,7 +271,11 @@ protected:
         const int64_t cycleTime = static_cast<int64_t>(
             static_cast<double>(bufferSize) / pData->sampleRate * 1000000 + 0.5);
 
-        carla_stdout("CarlaEngineDummy audio thread started, cycle time: " P_INT64 "ms", cycleTime / 1000);
+        if (fBenchmark)
+            carla_stdout("CarlaEngineDummy audio thread started in benchmark mode, cycle time: " P_INT64 "us",
+                         cycleTime);
+        else
+            carla_stdout("CarlaEngineDummy audio thread started, cycle time: " P_INT64 "us", cycleTime);
 
         float* audioIns[2] = {
             (float*)std::malloc(sizeof(float)*bufferSize),
@@ -232,36 +295,86 @@ protected:
         carla_zeroFloats(audioIns[1], bufferSize);
         carla_zeroStructs(pData->events.in,  kMaxEngineEventInternalCount);
 
+        BenchmarkStats stats(carla_gettime_us());
+
+#if !(defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN))
+        // absolute deadlines, so time spent processing or oversleeping does not accumulate as drift
+        const int64_t cycleTimeNs = static_cast<int64_t>(
+            static_cast<double>(bufferSize) / pData->sampleRate * 1000000000.0 + 0.5);
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+#endif
+
         while (! shouldThreadExit())
         {
-            const int64_t oldTime = getTimeInMicroseconds();
+            const int64_t oldTime = carla_gettime_us();
 
-            const PendingRtEventsRunner prt(this, bufferSize, true);
+            {
+                const PendingRtEventsRunner prt(this, bufferSize, true);
 
-            carla_zeroFloats(audioOuts[0], bufferSize);
-            carla_zeroFloats(audioOuts[1], bufferSize);
-            carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
+                carla_zeroFloats(audioOuts[0], bufferSize);
+                carla_zeroFloats(audioOuts[1], bufferSize);
+                carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
 
-            pData->graph.process(pData, audioIns, audioOuts, bufferSize);
+                pData->graph.process(pData, audioIns, audioOuts, bufferSize);
+            }
 
-            const int64_t newTime = getTimeInMicroseconds();
+            const int64_t newTime = carla_gettime_us();
             CARLA_SAFE_ASSERT_CONTINUE(newTime >= oldTime);
 
+            if (fBenchmark)
+            {
+                // run cycles back to back, per-cycle timings go into the engine cycle log
+                stats.add(newTime - oldTime);
+
+                if (newTime - stats.lastReportTime >= 5000000)
+                {
+                    stats.report(newTime, cycleTime);
+                    stats.lastReportTime = newTime;
+                }
+                continue;
+            }
+
+#if defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN)
             const int64_t remainingTime = cycleTime - (newTime - oldTime);
 
             if (remainingTime <= 0)
             {
                 ++pData->xruns;
-                carla_stdout("XRUN! remaining time: " P_INT64 ", old: " P_INT64 ", new: " P_INT64 ")",
-                             remainingTime, oldTime, newTime);
+                carla_rt_stdout("XRUN! remaining time: " P_INT64 ", old: " P_INT64 ", new: " P_INT64 ")",
+                                remainingTime, oldTime, newTime);
             }
             else
             {
                 CARLA_SAFE_ASSERT_CONTINUE(remainingTime < 1000000); // 1 sec
                 carla_msleep(static_cast<uint>(remainingTime / 1000));
             }
+#else
+            addNanoseconds(deadline, cycleTimeNs);
+
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+
+            if (isBefore(deadline, now))
+            {
+                ++pData->xruns;
+                carla_rt_stdout("XRUN! cycle took " P_INT64 "us, cycle time is " P_INT64 "us",
+                                newTime - oldTime, cycleTime);
+
+                // start over from now instead of trying to catch up
+                deadline = now;
+            }
+            else
+            {
+                while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {}
+            }
+#endif
         }
 
+        if (fBenchmark)
+            stats.report(carla_gettime_us(), cycleTime);
+
         std::free(audioIns[0]);
         std::free(audioIns[1]);
         std::free(audioOuts[0]);
@@ -275,6 +388,9 @@ protected:
 private:
     bool fRunning;
 
+    // set with CARLA_DUMMY_BENCHMARK, process as fast as possible instead of in realtime
+    const bool fBenchmark;
+
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaEngineDummy)
 };
 
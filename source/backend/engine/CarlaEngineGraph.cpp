@@ -705,23 +705,43 @@ bool ExternalGraph::getGroupAndPortIdFromFullName(const char* const fullPortName
 // -----------------------------------------------------------------------
 // RackGraph Buffers
 
+RackGraph::Buffers::Routing::Routing() noexcept
+    : ports(nullptr)
+{
+    numIns[0]  = numIns[1]  = 0;
+    numOuts[0] = numOuts[1] = 0;
+    ins[0]  = ins[1]  = nullptr;
+    outs[0] = outs[1] = nullptr;
+}
+
+RackGraph::Buffers::Routing::~Routing() noexcept
+{
+    delete[] ports;
+}
+
 RackGraph::Buffers::Buffers() noexcept
     : mutex(),
       connectedIn1(),
       connectedIn2(),
       connectedOut1(),
       connectedOut2(),
+      routing(nullptr),
+      routingPending(nullptr),
+      routingRetired(nullptr),
 #ifdef CARLA_PROPER_CPP11_SUPPORT
       inBuf{nullptr, nullptr},
       inBufTmp{nullptr, nullptr},
       outBuf{nullptr, nullptr},
+      fadeBuf{nullptr, nullptr},
 #endif
-      unusedBuf(nullptr)
+      unusedBuf(nullptr),
+      arena()
     {
 #ifndef CARLA_PROPER_CPP11_SUPPORT
         inBuf[0]    = inBuf[1]    = nullptr;
         inBufTmp[0] = inBufTmp[1] = nullptr;
         outBuf[0]   = outBuf[1]   = nullptr;
+        fadeBuf[0]  = fadeBuf[1]  = nullptr;
 #endif
     }
 
@@ -729,72 +749,238 @@ RackGraph::Buffers::~Buffers() noexcept
 {
     const CarlaRecursiveMutexLocker cml(mutex);
 
-    if (inBuf[0]    != nullptr) { delete[] inBuf[0];    inBuf[0]    = nullptr; }
-    if (inBuf[1]    != nullptr) { delete[] inBuf[1];    inBuf[1]    = nullptr; }
-    if (inBufTmp[0] != nullptr) { delete[] inBufTmp[0]; inBufTmp[0] = nullptr; }
-    if (inBufTmp[1] != nullptr) { delete[] inBufTmp[1]; inBufTmp[1] = nullptr; }
-    if (outBuf[0]   != nullptr) { delete[] outBuf[0];   outBuf[0]   = nullptr; }
-    if (outBuf[1]   != nullptr) { delete[] outBuf[1];   outBuf[1]   = nullptr; }
-    if (unusedBuf   != nullptr) { delete[] unusedBuf;   unusedBuf   = nullptr; }
+    inBuf[0]    = inBuf[1]    = nullptr;
+    inBufTmp[0] = inBufTmp[1] = nullptr;
+    outBuf[0]   = outBuf[1]   = nullptr;
+    fadeBuf[0]  = fadeBuf[1]  = nullptr;
+    unusedBuf   = nullptr;
+    arena.reset(0, 0);
 
     connectedIn1.clear();
     connectedIn2.clear();
     connectedOut1.clear();
     connectedOut2.clear();
+
+    delete routing;
+    delete routingPending;
+    delete routingRetired;
+    routing = routingPending = routingRetired = nullptr;
+}
+
+static uint* compileRackRoutes(const LinkedList<uint>& connected, const uint maxPort,
+                               uint* const ports, uint& numPorts) noexcept
+{
+    numPorts = 0;
+
+    for (LinkedList<uint>::Itenerator it = connected.begin2(); it.valid(); it.next())
+    {
+        const uint& port(it.getValue(0));
+        CARLA_SAFE_ASSERT_CONTINUE(port > 0);
+        CARLA_SAFE_ASSERT_CONTINUE(port <= maxPort);
+
+        ports[numPorts++] = port - 1;
+    }
+
+    return ports + numPorts;
+}
+
+void RackGraph::Buffers::updateRouting(const uint inputs, const uint outputs) noexcept
+{
+    if (Routing* const retired = __sync_lock_test_and_set(&routingRetired, nullptr))
+        delete retired;
+
+    const std::size_t count = connectedIn1.count() + connectedIn2.count()
+                            + connectedOut1.count() + connectedOut2.count();
+
+    Routing* newRouting;
+
+    try {
+        newRouting = new Routing();
+        newRouting->ports = new uint[std::max(count, static_cast<std::size_t>(1U))];
+    } CARLA_SAFE_EXCEPTION_RETURN("RackGraph::Buffers::updateRouting",);
+
+    uint* ports = newRouting->ports;
+    newRouting->ins[0]  = ports; ports = compileRackRoutes(connectedIn1,  inputs,  ports, newRouting->numIns[0]);
+    newRouting->ins[1]  = ports; ports = compileRackRoutes(connectedIn2,  inputs,  ports, newRouting->numIns[1]);
+    newRouting->outs[0] = ports; ports = compileRackRoutes(connectedOut1, outputs, ports, newRouting->numOuts[0]);
+    newRouting->outs[1] = ports; ports = compileRackRoutes(connectedOut2, outputs, ports, newRouting->numOuts[1]);
+
+    // replaces one not adopted yet, which the audio thread never saw
+    if (Routing* const unused = __sync_lock_test_and_set(&routingPending, newRouting))
+        delete unused;
+}
+
+const RackGraph::Buffers::Routing* RackGraph::Buffers::adoptRouting() noexcept
+{
+    // the previous routing was last used in the previous cycle, so it can be retired now
+    if (routingPending != nullptr && routingRetired == nullptr)
+    {
+        routingRetired = routing;
+        routing = __sync_lock_test_and_set(&routingPending, nullptr);
+    }
+
+    return routing;
 }
 
 void RackGraph::Buffers::setBufferSize(const uint32_t bufferSize, const bool createBuffers) noexcept
 {
     const CarlaRecursiveMutexLocker cml(mutex);
 
-    if (inBuf[0]    != nullptr) { delete[] inBuf[0];    inBuf[0]    = nullptr; }
-    if (inBuf[1]    != nullptr) { delete[] inBuf[1];    inBuf[1]    = nullptr; }
-    if (inBufTmp[0] != nullptr) { delete[] inBufTmp[0]; inBufTmp[0] = nullptr; }
-    if (inBufTmp[1] != nullptr) { delete[] inBufTmp[1]; inBufTmp[1] = nullptr; }
-    if (outBuf[0]   != nullptr) { delete[] outBuf[0];   outBuf[0]   = nullptr; }
-    if (outBuf[1]   != nullptr) { delete[] outBuf[1];   outBuf[1]   = nullptr; }
-    if (unusedBuf   != nullptr) { delete[] unusedBuf;   unusedBuf   = nullptr; }
+    inBuf[0]    = inBuf[1]    = nullptr;
+    inBufTmp[0] = inBufTmp[1] = nullptr;
+    outBuf[0]   = outBuf[1]   = nullptr;
+    fadeBuf[0]  = fadeBuf[1]  = nullptr;
+    unusedBuf   = nullptr;
+
+    arena.reset(0, 0);
 
     CARLA_SAFE_ASSERT_RETURN(bufferSize > 0,);
 
-    try {
-        inBufTmp[0] = new float[bufferSize];
-        inBufTmp[1] = new float[bufferSize];
-        unusedBuf   = new float[bufferSize];
+    if (! arena.reset(createBuffers ? 9 : 5, bufferSize))
+        return;
 
-        if (createBuffers)
-        {
-            inBuf[0]  = new float[bufferSize];
-            inBuf[1]  = new float[bufferSize];
-            outBuf[0] = new float[bufferSize];
-            outBuf[1] = new float[bufferSize];
-        }
+    inBufTmp[0] = arena.allocate();
+    inBufTmp[1] = arena.allocate();
+    fadeBuf[0]  = arena.allocate();
+    fadeBuf[1]  = arena.allocate();
+    unusedBuf   = arena.allocate();
+
+    if (createBuffers)
+    {
+        inBuf[0]  = arena.allocate();
+        inBuf[1]  = arena.allocate();
+        outBuf[0] = arena.allocate();
+        outBuf[1] = arena.allocate();
     }
-    catch(...) {
-        if (inBufTmp[0] != nullptr) { delete[] inBufTmp[0]; inBufTmp[0] = nullptr; }
-        if (inBufTmp[1] != nullptr) { delete[] inBufTmp[1]; inBufTmp[1] = nullptr; }
-        if (unusedBuf   != nullptr) { delete[] unusedBuf;   unusedBuf   = nullptr; }
+}
 
-        if (createBuffers)
-        {
-            if (inBuf[0]  != nullptr) { delete[] inBuf[0];  inBuf[0]  = nullptr; }
-            if (inBuf[1]  != nullptr) { delete[] inBuf[1];  inBuf[1]  = nullptr; }
-            if (outBuf[0] != nullptr) { delete[] outBuf[0]; outBuf[0] = nullptr; }
-            if (outBuf[1] != nullptr) { delete[] outBuf[1]; outBuf[1] = nullptr; }
-        }
+// -----------------------------------------------------------------------
+// RackGraph Lanes
+
+RackGraph::Lanes::Lanes() noexcept
+    : count(0),
+      zeroBuf(nullptr),
+      arena(),
+      threadPool(nullptr),
+      numThreads(0),
+      nextLane(0),
+      data(nullptr),
+      frames(0)
+{
+    carla_zeroStructs(lanes, kMaxRackLanes);
+    carla_zeroStructs(pluginLanes, MAX_RACK_PLUGINS);
+    inBuf[0] = inBuf[1] = nullptr;
+
+    CarlaMemoryLock& memoryLock(CarlaMemoryLock::getInstance());
+
+    for (uint i=0; i < kMaxRackLanes; ++i)
+    {
+        Lane& lane(lanes[i]);
+
+        lane.eventsIn  = static_cast<EngineEvent*>(memoryLock.allocate(sizeof(EngineEvent)*kMaxEngineEventInternalCount));
+        lane.eventsOut = static_cast<EngineEvent*>(memoryLock.allocate(sizeof(EngineEvent)*kMaxEngineEventInternalCount));
+        CARLA_SAFE_ASSERT_CONTINUE(lane.eventsIn != nullptr && lane.eventsOut != nullptr);
+
+        carla_zeroStructs(lane.eventsIn,  kMaxEngineEventInternalCount);
+        carla_zeroStructs(lane.eventsOut, kMaxEngineEventInternalCount);
+    }
+}
+
+RackGraph::Lanes::~Lanes() noexcept
+{
+    if (threadPool != nullptr)
+    {
+        CarlaSharedThreadPool::release(threadPool);
+        threadPool = nullptr;
+    }
+
+    setBufferSize(0);
+
+    CarlaMemoryLock& memoryLock(CarlaMemoryLock::getInstance());
+
+    for (uint i=0; i < kMaxRackLanes; ++i)
+    {
+        Lane& lane(lanes[i]);
+
+        memoryLock.deallocate(lane.eventsIn);
+        memoryLock.deallocate(lane.eventsOut);
+        lane.eventsIn  = lane.eventsOut = nullptr;
+    }
+}
+
+void RackGraph::Lanes::setBufferSize(const uint32_t bufferSize) noexcept
+{
+    zeroBuf = nullptr;
+
+    for (uint i=0; i < kMaxRackLanes; ++i)
+    {
+        Lane& lane(lanes[i]);
+
+        lane.inBufTmp[0] = lane.inBufTmp[1] = nullptr;
+        lane.outBuf[0]   = lane.outBuf[1]   = nullptr;
+        lane.fadeBuf[0]  = lane.fadeBuf[1]  = nullptr;
+        lane.unusedBuf   = nullptr;
+    }
+
+    arena.reset(0, 0);
+
+    if (bufferSize == 0)
         return;
+
+    // lanes are laid out one after the other, each lane's buffers adjacent in memory
+    if (! arena.reset(1 + kMaxRackLanes*7, bufferSize))
+        return;
+
+    zeroBuf = arena.allocate();
+
+    for (uint i=0; i < kMaxRackLanes; ++i)
+    {
+        Lane& lane(lanes[i]);
+
+        lane.inBufTmp[0] = arena.allocate();
+        lane.inBufTmp[1] = arena.allocate();
+        lane.outBuf[0]   = arena.allocate();
+        lane.outBuf[1]   = arena.allocate();
+        lane.fadeBuf[0]  = arena.allocate();
+        lane.fadeBuf[1]  = arena.allocate();
+        lane.unusedBuf   = arena.allocate();
     }
+}
 
-    carla_zeroFloats(inBufTmp[0], bufferSize);
-    carla_zeroFloats(inBufTmp[1], bufferSize);
+bool RackGraph::Lanes::update(const CarlaEngine::ProtectedData* const engineData) noexcept
+{
+    const uint pluginCount = std::min(engineData->curPluginCount, MAX_RACK_PLUGINS);
 
-    if (createBuffers)
+    count = 0;
+
+    if (zeroBuf == nullptr || threadPool == nullptr)
+        return false;
+
+    for (uint i=0; i < pluginCount; ++i)
     {
-        carla_zeroFloats(inBuf[0],  bufferSize);
-        carla_zeroFloats(inBuf[1],  bufferSize);
-        carla_zeroFloats(outBuf[0], bufferSize);
-        carla_zeroFloats(outBuf[1], bufferSize);
+        const CarlaPluginPtr plugin = engineData->plugins[i].plugin;
+
+        if (count == 0 || (count < kMaxRackLanes && plugin.get() != nullptr
+                                                 && plugin->isEnabled()
+                                                 && plugin->getAudioInCount() == 0))
+        {
+            if (count != 0)
+                lanes[count-1].endPlugin = i;
+
+            lanes[count++].firstPlugin = i;
+        }
+
+        pluginLanes[i] = count - 1;
     }
+
+    if (count != 0)
+        lanes[count-1].endPlugin = pluginCount;
+
+    if (count > 1)
+        return true;
+
+    count = 0;
+    return false;
 }
 
 // -----------------------------------------------------------------------
@@ -806,19 +992,56 @@ RackGraph::RackGraph(CarlaEngine* const engine, const uint32_t ins, const uint32
       outputs(outs),
       isOffline(false),
       audioBuffers(),
+      lanes(nullptr),
       kEngine(engine)
 {
+    // lanes change the rack signal flow, so they are only used if asked for, see ENGINE_OPTION_RACK_LANES
+    if (const uint processingThreads = engine->getOptions().rackLanes ? engine->getOptions().processingThreads : 0)
+    {
+        try {
+            lanes = new Lanes();
+        } CARLA_SAFE_EXCEPTION("RackGraph lanes");
+
+        if (lanes != nullptr)
+        {
+            lanes->threadPool = CarlaSharedThreadPool::acquire(processingThreads,
+                                                               engine->getOptions().processingCpuAffinity);
+
+            if (lanes->threadPool != nullptr)
+            {
+                lanes->numThreads = processingThreads;
+            }
+            else
+            {
+                delete lanes;
+                lanes = nullptr;
+            }
+        }
+    }
+
     setBufferSize(engine->getBufferSize());
 }
 
 RackGraph::~RackGraph() noexcept
 {
     extGraph.clear();
+
+    if (lanes != nullptr)
+    {
+        delete lanes;
+        lanes = nullptr;
+    }
 }
 
 void RackGraph::setBufferSize(const uint32_t bufferSize) noexcept
 {
     audioBuffers.setBufferSize(bufferSize, (inputs > 0 || outputs > 0));
+
+    if (lanes != nullptr)
+    {
+        const CarlaRecursiveMutexLocker cml(audioBuffers.mutex);
+        lanes->setBufferSize(bufferSize);
+    }
 }
 
 void RackGraph::setOffline(const bool offline) noexcept
@@ -943,21 +1166,35 @@ void RackGraph::process(CarlaEngine::ProtectedData* const data, const float* inB
     CARLA_SAFE_ASSERT_RETURN(data->events.in != nullptr,);
     CARLA_SAFE_ASSERT_RETURN(data->events.out != nullptr,);
 
+    if (lanes != nullptr && lanes->update(data))
+        return processLanes(data, inBufReal, outBufReal, frames);
+
+    processPlugins(data, 0, data->curPluginCount,
+                   inBufReal, audioBuffers.inBufTmp, outBufReal, audioBuffers.fadeBuf, audioBuffers.unusedBuf,
+                   data->events.in, data->events.out, frames);
+}
+
+void RackGraph::processPlugins(CarlaEngine::ProtectedData* const data, const uint firstPlugin, const uint endPlugin,
+                               const float* inBufReal[2], float* inBufTmp[2], float* outBufReal[2], float* fadeBuf[2],
+                               float* const dummyBuf,
+                               EngineEvent* const eventsIn, EngineEvent* const eventsOut, const uint32_t frames)
+{
     // safe copy
-    float* const dummyBuf = audioBuffers.unusedBuf;
-    float* const inBuf0   = audioBuffers.inBufTmp[0];
-    float* const inBuf1   = audioBuffers.inBufTmp[1];
+    float* const inBuf0 = inBufTmp[0];
+    float* const inBuf1 = inBufTmp[1];
 
-    // initialize audio inputs
-    carla_copyFloats(inBuf0, inBufReal[0], frames);
-    carla_copyFloats(inBuf1, inBufReal[1], frames);
+    // initialize audio inputs, peaks are taken while copying
+    float inPeaks[2] = {
+        carla_copyFloatsWithPeak(inBuf0, inBufReal[0], frames),
+        carla_copyFloatsWithPeak(inBuf1, inBufReal[1], frames)
+    };
 
     // initialize audio outputs (zero)
     carla_zeroFloats(outBufReal[0], frames);
     carla_zeroFloats(outBufReal[1], frames);
 
-    // initialize event outputs (zero)
-    carla_zeroStructs(data->events.out, kMaxEngineEventInternalCount);
+    // initialize event outputs (empty)
+    clearEngineEvents(eventsOut);
 
     uint32_t oldAudioInCount  = 0;
     uint32_t oldAudioOutCount = 0;
@@ -965,40 +1202,122 @@ void RackGraph::process(CarlaEngine::ProtectedData* const data, const float* inB
     bool processed = false;
 
     // process plugins
-    for (uint i=0; i < data->curPluginCount; ++i)
+    for (uint i=firstPlugin; i < endPlugin; ++i)
     {
         const CarlaPluginPtr plugin = data->plugins[i].plugin;
 
         if (plugin.get() == nullptr || ! plugin->isEnabled() || ! plugin->tryLock(isOffline))
             continue;
 
+        EnginePluginData& pluginData(data->plugins[i]);
+        const bool peaksEnabled = pluginData.peaksEnabled;
+
+        float* in0 = inBuf0;
+        float* in1 = inBuf1;
+
         if (processed)
         {
+            // bridged plugins take their inputs straight from shared memory, saving a copy
+            const uint32_t audioInCount = plugin->getAudioInCount();
+
+            if (audioInCount > 0)
+                if (float* const sharedIn = plugin->getSharedAudioBuffer(true, 0))
+                    in0 = sharedIn;
+            if (audioInCount > 1)
+                if (float* const sharedIn = plugin->getSharedAudioBuffer(true, 1))
+                    in1 = sharedIn;
+
             // initialize audio inputs (from previous outputs)
-            carla_copyFloats(inBuf0, outBufReal[0], frames);
-            carla_copyFloats(inBuf1, outBufReal[1], frames);
+            if (peaksEnabled)
+            {
+                inPeaks[0] = carla_copyFloatsWithPeak(in0, outBufReal[0], frames);
+                inPeaks[1] = carla_copyFloatsWithPeak(in1, outBufReal[1], frames);
+            }
+            else
+            {
+                carla_copyFloats(in0, outBufReal[0], frames);
+                carla_copyFloats(in1, outBufReal[1], frames);
+            }
 
             // initialize audio outputs (zero)
             carla_zeroFloats(outBufReal[0], frames);
             carla_zeroFloats(outBufReal[1], frames);
 
             // if plugin has no midi out, add previous events
-            if (oldMidiOutCount == 0 && data->events.in[0].type != kEngineEventTypeNull)
+            if (oldMidiOutCount == 0 && eventsIn[0].type != kEngineEventTypeNull)
             {
-                if (data->events.out[0].type != kEngineEventTypeNull)
+                if (eventsOut[0].type != kEngineEventTypeNull)
                 {
-                    // TODO: carefully add to input, sorted events
-                    //carla_stderr("TODO midi event mixing here %s", plugin->getName());
+                    mergeEngineEvents(eventsIn, eventsOut);
+                    clearEngineEvents(eventsOut);
                 }
                 // else nothing needed
             }
             else
             {
                 // initialize event inputs from previous outputs
-                carla_copyStructs(data->events.in, data->events.out, kMaxEngineEventInternalCount);
+                copyEngineEvents(eventsIn, eventsOut);
+
+                // initialize event outputs (empty)
+                clearEngineEvents(eventsOut);
+            }
+        }
+
+        // a plugin being replaced runs first on the same inputs, only the events of the new one go through
+        bool crossfading = false;
+
+        if (CarlaPlugin* const fadingPlugin = pluginData.fadingOut)
+        {
+            if (fadingPlugin->tryLock(isOffline))
+            {
+                const uint32_t fadeAudioInCount  = fadingPlugin->getAudioInCount();
+                const uint32_t fadeAudioOutCount = fadingPlugin->getAudioOutCount();
+
+                const uint32_t numFadeInBufs  = std::max(fadeAudioInCount,  2U);
+                const uint32_t numFadeOutBufs = std::max(fadeAudioOutCount, 2U);
+
+                const float* fadeInBuf[numFadeInBufs];
+                fadeInBuf[0] = in0;
+                fadeInBuf[1] = in1;
+
+                float* fadeOutBuf[numFadeOutBufs];
+                fadeOutBuf[0] = fadeBuf[0];
+                fadeOutBuf[1] = fadeBuf[1];
+
+                carla_zeroFloats(fadeBuf[0], frames);
+                carla_zeroFloats(fadeBuf[1], frames);
+
+                if (numFadeInBufs > 2 || numFadeOutBufs > 2)
+                {
+                    carla_zeroFloats(dummyBuf, frames);
+
+                    for (uint32_t j=2; j<numFadeInBufs; ++j)
+                        fadeInBuf[j] = dummyBuf;
+
+                    for (uint32_t j=2; j<numFadeOutBufs; ++j)
+                        fadeOutBuf[j] = dummyBuf;
+                }
+
+                fadingPlugin->initBuffers();
+
+                {
+                    const ScopedPluginDenormals spd(fadingPlugin->getOptionsEnabled());
+                    fadingPlugin->process(fadeInBuf, fadeOutBuf, nullptr, nullptr, frames);
+                }
 
-                // initialize event outputs (zero)
-                carla_zeroStructs(data->events.out, kMaxEngineEventInternalCount);
+                fadingPlugin->unlock();
+
+                if (fadeAudioInCount == 0)
+                {
+                    carla_addFloats(fadeBuf[0], in0, frames);
+                    carla_addFloats(fadeBuf[1], in1, frames);
+                }
+
+                if (fadeAudioOutCount == 1)
+                    carla_copyFloats(fadeBuf[1], fadeBuf[0], frames);
+
+                clearEngineEvents(eventsOut);
+                crossfading = true;
             }
         }
 
@@ -1010,8 +1329,8 @@ void RackGraph::process(CarlaEngine::ProtectedData* const data, const float* inB
         const uint32_t numOutBufs = std::max(oldAudioOutCount, 2U);
 
         const float* inBuf[numInBufs];
-        inBuf[0] = inBuf0;
-        inBuf[1] = inBuf1;
+        inBuf[0] = in0;
+        inBuf[1] = in1;
 
         float* outBuf[numOutBufs];
         outBuf[0] = outBufReal[0];
@@ -1028,16 +1347,26 @@ void RackGraph::process(CarlaEngine::ProtectedData* const data, const float* inB
                 outBuf[j] = dummyBuf;
         }
 
-        // process
+        // process, outputs are already silent if the plugin is asleep
         plugin->initBuffers();
-        plugin->process(inBuf, outBuf, nullptr, nullptr, frames);
+
+        if (! plugin->checkAutoSleep(inBuf, frames))
+        {
+            {
+                const ScopedPluginDenormals spd(plugin->getOptionsEnabled());
+                const ScopedPluginProcessTimer sppt(pluginData.processStats, plugin.get());
+                plugin->process(inBuf, outBuf, nullptr, nullptr, frames);
+            }
+            plugin->updateAutoSleep(outBuf, frames);
+        }
+
         plugin->unlock();
 
         // if plugin has no audio inputs, add input buffer
         if (oldAudioInCount == 0)
         {
-            carla_addFloats(outBufReal[0], inBuf0, frames);
-            carla_addFloats(outBufReal[1], inBuf1, frames);
+            carla_addFloats(outBufReal[0], in0, frames);
+            carla_addFloats(outBufReal[1], in1, frames);
         }
 
         // if plugin only has 1 output, copy it to the 2nd
@@ -1046,14 +1375,16 @@ void RackGraph::process(CarlaEngine::ProtectedData* const data, const float* inB
             carla_copyFloats(outBufReal[1], outBufReal[0], frames);
         }
 
+        if (crossfading)
+            pluginData.mixCrossfade(outBufReal, fadeBuf, 2, frames);
+
         // set peaks
+        if (peaksEnabled)
         {
-            EnginePluginData& pluginData(data->plugins[i]);
-
             if (oldAudioInCount > 0)
             {
-                pluginData.peaks[0] = carla_findMaxNormalizedFloat(inBuf0, frames);
-                pluginData.peaks[1] = carla_findMaxNormalizedFloat(inBuf1, frames);
+                pluginData.peaks[0] = inPeaks[0];
+                pluginData.peaks[1] = inPeaks[1];
             }
             else
             {
@@ -1077,63 +1408,147 @@ void RackGraph::process(CarlaEngine::ProtectedData* const data, const float* inB
     }
 }
 
-void RackGraph::processHelper(CarlaEngine::ProtectedData* const data, const float* const* const inBuf, float* const* const outBuf, const uint32_t frames)
+void RackGraph::processLanes(CarlaEngine::ProtectedData* const data, const float* inBufReal[2], float* outBufReal[2], const uint32_t frames)
 {
-    CARLA_SAFE_ASSERT_RETURN(audioBuffers.outBuf[1] != nullptr,);
+    lanes->nextLane = 0;
+    lanes->data     = data;
+    lanes->inBuf[0] = inBufReal[0];
+    lanes->inBuf[1] = inBufReal[1];
+    lanes->frames   = frames;
 
-    const CarlaRecursiveMutexLocker _cml(audioBuffers.mutex);
+    lanes->threadPool->run(processLanesCallback, this, lanes->numThreads);
 
-    if (inBuf != nullptr && inputs > 0)
+    // mix audio
+    carla_copyFloats(outBufReal[0], lanes->lanes[0].outBuf[0], frames);
+    carla_copyFloats(outBufReal[1], lanes->lanes[0].outBuf[1], frames);
+
+    for (uint i=1; i < lanes->count; ++i)
     {
-        bool noConnections = true;
+        carla_addFloats(outBufReal[0], lanes->lanes[i].outBuf[0], frames);
+        carla_addFloats(outBufReal[1], lanes->lanes[i].outBuf[1], frames);
+    }
+
+    // merge events, keeping them sorted by time
+    uint eventIndexes[kMaxRackLanes];
+    carla_zeroStructs(eventIndexes, kMaxRackLanes);
+
+    uint j=0;
 
-        // connect input buffers
-        for (LinkedList<uint>::Itenerator it = audioBuffers.connectedIn1.begin2(); it.valid(); it.next())
+    for (; j < kMaxEngineEventInternalCount; ++j)
+    {
+        const EngineEvent* nextEvent = nullptr;
+        uint nextLane = 0;
+
+        for (uint i=0; i < lanes->count; ++i)
         {
-            const uint& port(it.getValue(0));
-            CARLA_SAFE_ASSERT_CONTINUE(port > 0);
-            CARLA_SAFE_ASSERT_CONTINUE(port <= inputs);
+            if (eventIndexes[i] >= kMaxEngineEventInternalCount)
+                continue;
 
-            if (noConnections)
-            {
-                carla_copyFloats(audioBuffers.inBuf[0], inBuf[port], frames);
-                noConnections = false;
-            }
-            else
+            const EngineEvent& event(lanes->lanes[i].eventsOut[eventIndexes[i]]);
+
+            if (event.type == kEngineEventTypeNull)
+                continue;
+
+            if (nextEvent == nullptr || event.time < nextEvent->time)
             {
-                carla_addFloats(audioBuffers.inBuf[0], inBuf[port], frames);
+                nextEvent = &event;
+                nextLane  = i;
             }
         }
 
-        if (noConnections)
-            carla_zeroFloats(audioBuffers.inBuf[0], frames);
+        if (nextEvent == nullptr)
+            break;
 
-        noConnections = true;
+        data->events.out[j] = *nextEvent;
+        ++eventIndexes[nextLane];
+    }
 
-        for (LinkedList<uint>::Itenerator it = audioBuffers.connectedIn2.begin2(); it.valid(); it.next())
-        {
-            const uint& port(it.getValue(0));
-            CARLA_SAFE_ASSERT_CONTINUE(port > 0);
-            CARLA_SAFE_ASSERT_CONTINUE(port <= inputs);
+    terminateEngineEvents(data->events.out, j);
+}
 
-            if (noConnections)
-            {
-                carla_copyFloats(audioBuffers.inBuf[1], inBuf[port-1], frames);
-                noConnections = false;
-            }
-            else
-            {
-                carla_addFloats(audioBuffers.inBuf[1], inBuf[port-1], frames);
-            }
+void RackGraph::processLanesCallback(void* const ptr, uint)
+{
+    RackGraph* const self = static_cast<RackGraph*>(ptr);
+    Lanes* const lanes = self->lanes;
+
+    // pool threads are only used for processing, so they can keep the flags
+    if (lanes->data->options.flushDenormals)
+        carla_setDenormalsFlushed(true);
+
+    for (int index; (index = __sync_fetch_and_add(&lanes->nextLane, 1)) < static_cast<int>(lanes->count);)
+    {
+        Lanes::Lane& lane(lanes->lanes[index]);
+
+        // every lane receives the rack input events, only the first one receives its audio
+        copyEngineEvents(lane.eventsIn, lanes->data->events.in);
+
+        const float* inBuf[2] = { lanes->zeroBuf, lanes->zeroBuf };
+
+        if (index == 0)
+        {
+            inBuf[0] = lanes->inBuf[0];
+            inBuf[1] = lanes->inBuf[1];
         }
 
-        if (noConnections)
-            carla_zeroFloats(audioBuffers.inBuf[1], frames);
+        self->processPlugins(lanes->data, lane.firstPlugin, lane.endPlugin,
+                             inBuf, lane.inBufTmp, lane.outBuf, lane.fadeBuf, lane.unusedBuf,
+                             lane.eventsIn, lane.eventsOut, lanes->frames);
     }
-    else
+}
+
+EngineEvent* RackGraph::getLaneEventBuffer(const uint pluginId, const bool isInput) const noexcept
+{
+    if (lanes == nullptr || lanes->count == 0 || pluginId >= MAX_RACK_PLUGINS)
+        return nullptr;
+
+    const Lanes::Lane& lane(lanes->lanes[lanes->pluginLanes[pluginId]]);
+    return isInput ? lane.eventsIn : lane.eventsOut;
+}
+
+uint32_t RackGraph::getLatency(const CarlaEngine::ProtectedData* const data) const noexcept
+{
+    // with lanes only the first one gets the rack audio, otherwise it passes through every plugin
+    const uint endPlugin = (lanes != nullptr && lanes->count > 1)
+                         ? lanes->lanes[0].endPlugin
+                         : std::min(data->curPluginCount, MAX_RACK_PLUGINS);
+
+    uint32_t latency = 0;
+
+    for (uint i=0; i < endPlugin; ++i)
     {
-        carla_zeroFloats(audioBuffers.inBuf[0], frames);
-        carla_zeroFloats(audioBuffers.inBuf[1], frames);
+        const CarlaPluginPtr plugin = data->plugins[i].plugin;
+
+        // plugins without audio inputs mix the rack audio into their outputs undelayed
+        if (plugin.get() == nullptr || ! plugin->isEnabled() || plugin->getAudioInCount() == 0)
+            continue;
+
+        latency += plugin->getLatencyInFrames();
+    }
+
+    return latency;
+}
+
+void RackGraph::processHelper(CarlaEngine::ProtectedData* const data, const float* const* const inBuf, float* const* const outBuf, const uint32_t frames)
+{
+    CARLA_SAFE_ASSERT_RETURN(audioBuffers.outBuf[1] != nullptr,);
+
+    const Buffers::Routing* const routing = audioBuffers.adoptRouting();
+
+    // connect input buffers
+    for (uint i=0; i < 2; ++i)
+    {
+        const uint numIns = (routing != nullptr && inBuf != nullptr) ? routing->numIns[i] : 0;
+
+        if (numIns == 0)
+        {
+            carla_zeroFloats(audioBuffers.inBuf[i], frames);
+            continue;
+        }
+
+        carla_copyFloats(audioBuffers.inBuf[i], inBuf[routing->ins[i][0]], frames);
+
+        for (uint j=1; j < numIns; ++j)
+            carla_addFloats(audioBuffers.inBuf[i], inBuf[routing->ins[i][j]], frames);
     }
 
     carla_zeroFloats(audioBuffers.outBuf[0], frames);
@@ -1143,28 +1558,13 @@ void RackGraph::processHelper(CarlaEngine::ProtectedData* const data, const floa
     process(data, const_cast<const float**>(audioBuffers.inBuf), audioBuffers.outBuf, frames);
 
     // connect output buffers
-    if (audioBuffers.connectedOut1.count() != 0)
-    {
-        for (LinkedList<uint>::Itenerator it = audioBuffers.connectedOut1.begin2(); it.valid(); it.next())
-        {
-            const uint& port(it.getValue(0));
-            CARLA_SAFE_ASSERT_CONTINUE(port > 0);
-            CARLA_SAFE_ASSERT_CONTINUE(port <= outputs);
-
-            carla_addFloats(outBuf[port-1], audioBuffers.outBuf[0], frames);
-        }
-    }
+    if (routing == nullptr)
+        return;
 
-    if (audioBuffers.connectedOut2.count() != 0)
+    for (uint i=0; i < 2; ++i)
     {
-        for (LinkedList<uint>::Itenerator it = audioBuffers.connectedOut2.begin2(); it.valid(); it.next())
-        {
-            const uint& port(it.getValue(0));
-            CARLA_SAFE_ASSERT_CONTINUE(port > 0);
-            CARLA_SAFE_ASSERT_CONTINUE(port <= outputs);
-
-            carla_addFloats(outBuf[port-1], audioBuffers.outBuf[1], frames);
-        }
+        for (uint j=0; j < routing->numOuts[i]; ++j)
+            carla_addFloats(outBuf[routing->outs[i][j]], audioBuffers.outBuf[i], frames);
     }
 }
 
@@ -1447,12 +1847,52 @@ void removeNodeFromPatchbay(const bool sendHost, const bool sendOSC, CarlaEngine
 
 // -----------------------------------------------------------------------
 
+// Copy the raw events of 'src' within [start, start+frames) into 'dst', moved to begin at 'dstStart'.
+// Stops after 'maxEvents', returns how many events were copied.
+static uint32_t copyRawMidiEvents(MidiBuffer& dst, const MidiBuffer& src,
+                                  const uint32_t start, const uint32_t frames, const uint32_t dstStart,
+                                  const uint32_t maxEvents)
+{
+    const uint8_t* eventData;
+    int numBytes, sampleNumber;
+    int lastTime = dst.isEmpty() ? 0 : -1;
+    uint32_t count = 0;
+
+    MidiBuffer::Iterator it(src);
+    it.setNextSamplePosition(static_cast<int>(start));
+
+    for (; count < maxEvents && it.getNextEvent(eventData, numBytes, sampleNumber); ++count)
+    {
+        if (sampleNumber >= static_cast<int>(start + frames))
+            break;
+
+        const int time = sampleNumber - static_cast<int>(start) + static_cast<int>(dstStart);
+
+        dst.addRawEvent(eventData, numBytes, time, lastTime);
+
+        if (lastTime >= 0 && time >= lastTime)
+            lastTime = time;
+    }
+
+    return count;
+}
+
+// -----------------------------------------------------------------------
+
 class CarlaPluginInstance : public AudioProcessor
 {
 public:
     CarlaPluginInstance(CarlaEngine* const engine, const CarlaPluginPtr plugin)
         : kEngine(engine),
-          fPlugin(plugin)
+          fPlugin(plugin),
+          fStartingBlock(false),
+          fBlockStarted(false),
+          fSleeping(false),
+          fDecoupled(),
+          fStagedPlugin(),
+          fFadingPlugin(),
+          fFadeAudio(),
+          fFadeCVOut()
     {
         CarlaEngineClient* const client = plugin->getEngineClient();
 
@@ -1463,6 +1903,7 @@ public:
                              client->getPortCount(kEnginePortTypeEvent, true),
                              client->getPortCount(kEnginePortTypeEvent, false),
                              getSampleRate(), getBlockSize());
+        prepareDecoupledBlock();
     }
 
     ~CarlaPluginInstance() override
@@ -1485,11 +1926,114 @@ public:
                              client->getPortCount(kEnginePortTypeEvent, true),
                              client->getPortCount(kEnginePortTypeEvent, false),
                              getSampleRate(), getBlockSize());
+        prepareDecoupledBlock();
     }
 
     void invalidatePlugin() noexcept
     {
         fPlugin.reset();
+        fStagedPlugin.reset();
+        fFadingPlugin.reset();
+    }
+
+    bool isForPlugin(const CarlaPluginPtr& plugin) const noexcept
+    {
+        return fPlugin == plugin;
+    }
+
+    // extra latency added by running the plugin decoupled, 0 if not
+    uint32_t getDecoupledLatency() const noexcept
+    {
+        return fDecoupled.size;
+    }
+
+    // (re)allocate the FIFO for the buffer size the plugin runs at, see PLUGIN_OPTION_DECOUPLED_BLOCKS
+    // must not be called while the plugin is processing with its old buffer size
+    void prepareDecoupledBlock()
+    {
+        CARLA_SAFE_ASSERT_RETURN(fPlugin.get() != nullptr,);
+
+        const uint32_t engineBufferSize = kEngine->getBufferSize();
+        const uint32_t pluginBufferSize = fPlugin->getBufferSize();
+        const uint32_t blockSize = pluginBufferSize > engineBufferSize ? pluginBufferSize : 0;
+
+        const uint32_t numAudioChan = jmax(getTotalNumInputChannels(ChannelTypeAudio),
+                                           getTotalNumOutputChannels(ChannelTypeAudio));
+
+        const CarlaRecursiveMutexLocker crml(getCallbackLock());
+
+        fDecoupled.size = blockSize;
+        fDecoupled.pos = 0;
+        fDecoupled.numEventsIn = 0;
+
+        fDecoupled.audio.setSize(blockSize != 0 ? numAudioChan : 0, blockSize);
+        fDecoupled.cvIn.setSize(blockSize != 0 ? getTotalNumInputChannels(ChannelTypeCV) : 0, blockSize);
+        fDecoupled.cvOut.setSize(blockSize != 0 ? getTotalNumOutputChannels(ChannelTypeCV) : 0, blockSize);
+        fDecoupled.audio.clear();
+        fDecoupled.cvIn.clear();
+        fDecoupled.cvOut.clear();
+
+        fDecoupled.midiIn.clear();
+        fDecoupled.midiOut.clear();
+        fDecoupled.midiScratch.clear();
+
+        if (blockSize != 0)
+        {
+            fDecoupled.midiIn.ensureSize(kMaxEngineEventInternalCount*(sizeof(EngineEvent)+8));
+            fDecoupled.midiOut.ensureSize(kMaxEngineEventInternalCount*(sizeof(EngineEvent)+8));
+            fDecoupled.midiScratch.ensureSize(kMaxEngineEventInternalCount*(sizeof(EngineEvent)+8));
+        }
+
+        setLatencySamples(static_cast<int>(fPlugin->getEngineClient()->getLatency() + blockSize));
+    }
+
+    // the replacement must fit the node as it is, with the same ports and running at the engine buffer size
+    bool canSwapPlugin(const CarlaPluginPtr& newPlugin) const
+    {
+        CARLA_SAFE_ASSERT_RETURN(newPlugin.get() != nullptr, false);
+
+        if (fDecoupled.size != 0 || fStagedPlugin.get() != nullptr || fFadingPlugin.get() != nullptr)
+            return false;
+        if (newPlugin->getBufferSize() != kEngine->getBufferSize())
+            return false;
+
+        CarlaEngineClient* const client = newPlugin->getEngineClient();
+        CARLA_SAFE_ASSERT_RETURN(client != nullptr, false);
+
+        return client->getPortCount(kEnginePortTypeAudio, true)  == getTotalNumInputChannels(ChannelTypeAudio)
+            && client->getPortCount(kEnginePortTypeAudio, false) == getTotalNumOutputChannels(ChannelTypeAudio)
+            && client->getPortCount(kEnginePortTypeCV, true)     == getTotalNumInputChannels(ChannelTypeCV)
+            && client->getPortCount(kEnginePortTypeCV, false)    == getTotalNumOutputChannels(ChannelTypeCV)
+            && client->getPortCount(kEnginePortTypeEvent, true)  == getTotalNumInputChannels(ChannelTypeMIDI)
+            && client->getPortCount(kEnginePortTypeEvent, false) == getTotalNumOutputChannels(ChannelTypeMIDI);
+    }
+
+    void stagePluginSwap(const CarlaPluginPtr newPlugin)
+    {
+        const CarlaRecursiveMutexLocker crml(getCallbackLock());
+
+        fStagedPlugin = newPlugin;
+        prepareCrossfadeBuffers();
+    }
+
+    // RT, called at the start of a cycle, the old plugin keeps running here until its slot is done crossfading
+    void swapPlugin() noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(fStagedPlugin.get() != nullptr,);
+
+        fFadingPlugin = fPlugin;
+        fPlugin = fStagedPlugin;
+        fStagedPlugin.reset();
+    }
+
+    void prepareCrossfadeBuffers()
+    {
+        const bool needed = fStagedPlugin.get() != nullptr || fFadingPlugin.get() != nullptr;
+        const int blockSize = getBlockSize();
+
+        fFadeAudio.setSize(needed ? jmax(getTotalNumInputChannels(ChannelTypeAudio),
+                                         getTotalNumOutputChannels(ChannelTypeAudio)) : 0, blockSize);
+        fFadeCVOut.setSize(needed ? getTotalNumOutputChannels(ChannelTypeCV) : 0, blockSize);
     }
 
     // -------------------------------------------------------------------
@@ -1499,31 +2043,185 @@ public:
         return fPlugin->getName();
     }
 
+    bool canStartBlock() const noexcept override
+    {
+        return fPlugin.get() != nullptr && fDecoupled.size == 0 && fFadingPlugin.get() == nullptr
+            && fPlugin->canStartProcess();
+    }
+
+    bool mustAlwaysProcess() const noexcept override
+    {
+        if (fPlugin.get() == nullptr)
+            return false;
+
+        // meters and analysers report through output parameters, keep them running while unconnected
+        for (uint32_t i=0, count=fPlugin->getParameterCount(); i < count; ++i)
+        {
+            if (fPlugin->isParameterOutput(i))
+                return true;
+        }
+
+        return false;
+    }
+
+    void startBlockWithCV(AudioSampleBuffer& audio,
+                          const AudioSampleBuffer& cvIn,
+                          AudioSampleBuffer& cvOut,
+                          MidiBuffer& midi) override
+    {
+        fStartingBlock = true;
+        processPluginBlock(audio, cvIn, cvOut, midi);
+        fStartingBlock = false;
+    }
+
     void processBlockWithCV(AudioSampleBuffer& audio,
                             const AudioSampleBuffer& cvIn,
                             AudioSampleBuffer& cvOut,
                             MidiBuffer& midi) override
     {
-        if (fPlugin.get() == nullptr || ! fPlugin->isEnabled() || ! fPlugin->tryLock(kEngine->isOffline()))
+        if (fDecoupled.size != 0)
+            processDecoupledBlock(audio, cvIn, cvOut, midi);
+        else if (fFadingPlugin.get() != nullptr)
+            processCrossfadeBlock(audio, cvIn, cvOut, midi);
+        else
+            processPluginBlock(audio, cvIn, cvOut, midi);
+    }
+
+    // The plugin being replaced runs first, on a copy of the inputs and events, its output events are dropped.
+    // Then the new plugin runs as usual and both outputs get mixed, see EnginePluginData::mixCrossfade().
+    void processCrossfadeBlock(AudioSampleBuffer& audio,
+                               const AudioSampleBuffer& cvIn,
+                               AudioSampleBuffer& cvOut,
+                               MidiBuffer& midi)
+    {
+        EnginePluginData& pluginData(kEngine->pData->plugins[fPlugin->getId()]);
+        CarlaPlugin* const fadingPlugin = fFadingPlugin.get();
+
+        // finished, or cancelled by moving the plugin around, the engine still holds a reference
+        if (pluginData.fadingOut != fadingPlugin)
         {
-            audio.clear();
-            cvOut.clear();
-            midi.clear();
-            return;
+            fFadingPlugin.reset();
+            return processPluginBlock(audio, cvIn, cvOut, midi);
         }
 
-        if (CarlaEngineEventPort* const port = fPlugin->getDefaultEventInPort())
+        const uint32_t numSamples   = audio.getNumSamples();
+        const uint32_t numAudioChan = jmin(audio.getNumChannels(), fFadeAudio.getNumChannels());
+        const uint32_t numAudioOuts = jmin(getTotalNumOutputChannels(ChannelTypeAudio), numAudioChan);
+        const uint32_t numCVInChan  = cvIn.getNumChannels();
+        const uint32_t numCVOutChan = jmin(cvOut.getNumChannels(), fFadeCVOut.getNumChannels());
+
+        if (numSamples > static_cast<uint32_t>(fFadeAudio.getNumSamples()) || ! fadingPlugin->tryLock(kEngine->isOffline()))
+            return processPluginBlock(audio, cvIn, cvOut, midi);
+
+        if (CarlaEngineEventPort* const port = fadingPlugin->getDefaultEventInPort())
         {
-            EngineEvent* const engineEvents(port->fBuffer);
-            CARLA_SAFE_ASSERT_RETURN(engineEvents != nullptr,);
+            port->adoptGrownBuffer();
+
+            if (EngineEvent* const engineEvents = port->fBuffer)
+            {
+                clearEngineEvents(engineEvents);
+
+                if (! fillEngineEventsFromWaterMidiBuffer(engineEvents, midi, port->fBufferCapacity))
+                    port->setBufferOverflowed();
+            }
+        }
+
+        fadingPlugin->initBuffers();
+
+        float* fadeAudioBuffers[numAudioChan];
+        float* fadeCVOutBuffers[numCVOutChan];
+        const float* cvInBuffers[numCVInChan];
 
-            carla_zeroStructs(engineEvents, kMaxEngineEventInternalCount);
-            fillEngineEventsFromWaterMidiBuffer(engineEvents, midi);
+        for (uint32_t i=0; i<numAudioChan; ++i)
+        {
+            fadeAudioBuffers[i] = fFadeAudio.getWritePointer(i);
+
+            if (fadingPlugin->getAudioInCount() != 0)
+                carla_copyFloats(fadeAudioBuffers[i], audio.getReadPointer(i), numSamples);
+            else
+                carla_zeroFloats(fadeAudioBuffers[i], numSamples);
         }
+        for (uint32_t i=0; i<numCVOutChan; ++i)
+            fadeCVOutBuffers[i] = fFadeCVOut.getWritePointer(i);
+        for (uint32_t i=0; i<numCVInChan; ++i)
+            cvInBuffers[i] = cvIn.getReadPointer(i);
 
-        midi.clear();
+        {
+            const ScopedPluginDenormals spd(fadingPlugin->getOptionsEnabled());
+            fadingPlugin->process(const_cast<const float**>(fadeAudioBuffers), fadeAudioBuffers,
+                                  cvInBuffers, fadeCVOutBuffers, numSamples);
+        }
+
+        if (CarlaEngineEventPort* const port = fadingPlugin->getDefaultEventOutPort())
+        {
+            if (EngineEvent* const engineEvents = port->fBuffer)
+                clearEngineEvents(engineEvents);
+        }
+
+        fadingPlugin->unlock();
+
+        processPluginBlock(audio, cvIn, cvOut, midi);
 
-        fPlugin->initBuffers();
+        float* outs[numAudioOuts+numCVOutChan];
+        const float* fadeOuts[numAudioOuts+numCVOutChan];
+
+        for (uint32_t i=0; i<numAudioOuts; ++i)
+        {
+            outs[i] = audio.getWritePointer(i);
+            fadeOuts[i] = fadeAudioBuffers[i];
+        }
+        for (uint32_t i=0; i<numCVOutChan; ++i)
+        {
+            outs[numAudioOuts+i] = cvOut.getWritePointer(i);
+            fadeOuts[numAudioOuts+i] = fadeCVOutBuffers[i];
+        }
+
+        pluginData.mixCrossfade(outs, fadeOuts, numAudioOuts+numCVOutChan, numSamples);
+
+        if (pluginData.fadingOut == nullptr)
+            fFadingPlugin.reset();
+    }
+
+    void processPluginBlock(AudioSampleBuffer& audio,
+                            const AudioSampleBuffer& cvIn,
+                            AudioSampleBuffer& cvOut,
+                            MidiBuffer& midi)
+    {
+        // when completing a started block the plugin is still locked and has its events already
+        const bool wasStarted = fBlockStarted;
+        fBlockStarted = false;
+
+        if (! wasStarted)
+        {
+            if (fPlugin.get() == nullptr || ! fPlugin->isEnabled() || ! fPlugin->tryLock(kEngine->isOffline()))
+            {
+                // try again when the block gets completed
+                if (fStartingBlock)
+                    return;
+
+                audio.clear();
+                cvOut.clear();
+                midi.clear();
+                return;
+            }
+
+            if (CarlaEngineEventPort* const port = fPlugin->getDefaultEventInPort())
+            {
+                port->adoptGrownBuffer();
+
+                EngineEvent* const engineEvents(port->fBuffer);
+                CARLA_SAFE_ASSERT_RETURN(engineEvents != nullptr,);
+
+                clearEngineEvents(engineEvents);
+
+                if (! fillEngineEventsFromWaterMidiBuffer(engineEvents, midi, port->fBufferCapacity))
+                    port->setBufferOverflowed();
+            }
+
+            midi.clear();
+
+            fPlugin->initBuffers();
+        }
 
         const uint32_t numSamples   = audio.getNumSamples();
         const uint32_t numAudioChan = audio.getNumChannels();
@@ -1533,7 +2231,8 @@ public:
         if (numAudioChan+numCVInChan+numCVOutChan == 0)
         {
             // nothing to process
-            fPlugin->process(nullptr, nullptr, nullptr, nullptr, numSamples);
+            if (! processPlugin(nullptr, nullptr, nullptr, nullptr, numSamples))
+                return;
         }
         else if (numAudioChan != 0)
         {
@@ -1554,20 +2253,50 @@ public:
             for (uint32_t i=0; i<numCVInChan; ++i)
                 cvInBuffers[i] = cvIn.getReadPointer(i);
 
+            // skip peaks if nobody is reading them
+            const bool peaksEnabled = kEngine->pData->plugins[fPlugin->getId()].peaksEnabled;
+
             float inPeaks[2] = { 0.0f };
             float outPeaks[2] = { 0.0f };
 
-            for (uint32_t i=0, count=jmin(fPlugin->getAudioInCount(), numChan2); i<count; ++i)
-                inPeaks[i] = carla_findMaxNormalizedFloat(audioBuffers[i], numSamples);
+            if (peaksEnabled)
+            {
+                for (uint32_t i=0, count=jmin(fPlugin->getAudioInCount(), numChan2); i<count; ++i)
+                    inPeaks[i] = carla_findMaxNormalizedFloat(audioBuffers[i], numSamples);
+            }
 
-            fPlugin->process(const_cast<const float**>(audioBuffers), audioBuffers,
-                             cvInBuffers, cvOutBuffers,
-                             numSamples);
+            if (! wasStarted)
+                fSleeping = fPlugin->checkAutoSleep(const_cast<const float**>(audioBuffers), numSamples);
 
-            for (uint32_t i=0, count=jmin(fPlugin->getAudioOutCount(), numChan2); i<count; ++i)
-                outPeaks[i] = carla_findMaxNormalizedFloat(audioBuffers[i], numSamples);
+            if (fSleeping)
+            {
+                // nothing to run in the background, silence the outputs when the block completes
+                if (fStartingBlock)
+                {
+                    fBlockStarted = true;
+                    return;
+                }
 
-            kEngine->setPluginPeaksRT(fPlugin->getId(), inPeaks, outPeaks);
+                audio.clear();
+                cvOut.clear();
+            }
+            else
+            {
+                if (! processPlugin(const_cast<const float**>(audioBuffers), audioBuffers,
+                                    cvInBuffers, cvOutBuffers,
+                                    numSamples))
+                    return;
+
+                fPlugin->updateAutoSleep(audioBuffers, numSamples);
+            }
+
+            if (peaksEnabled)
+            {
+                for (uint32_t i=0, count=jmin(fPlugin->getAudioOutCount(), numChan2); i<count; ++i)
+                    outPeaks[i] = carla_findMaxNormalizedFloat(audioBuffers[i], numSamples);
+
+                kEngine->setPluginPeaksRT(fPlugin->getId(), inPeaks, outPeaks);
+            }
         }
         else
         {
@@ -1580,9 +2309,10 @@ public:
             for (uint32_t i=0; i<numCVInChan; ++i)
                 cvInBuffers[i] = cvIn.getReadPointer(i);
 
-            fPlugin->process(nullptr, nullptr,
-                             cvInBuffers, cvOutBuffers,
-                             numSamples);
+            if (! processPlugin(nullptr, nullptr,
+                                cvInBuffers, cvOutBuffers,
+                                numSamples))
+                return;
         }
 
         midi.clear();
@@ -1593,12 +2323,73 @@ public:
             CARLA_SAFE_ASSERT_RETURN(engineEvents != nullptr,);
 
             fillWaterMidiBufferFromEngineEvents(midi, engineEvents);
-            carla_zeroStructs(engineEvents, kMaxEngineEventInternalCount);
+            clearEngineEvents(engineEvents);
         }
 
         fPlugin->unlock();
     }
 
+    // The plugin runs once per fDecoupled.size frames, on FIFO buffers holding the outputs of the previous block.
+    // These are handed out while being replaced by new inputs, so the node adds exactly one block of latency.
+    // Time info is the one of the cycle that completes the block.
+    void processDecoupledBlock(AudioSampleBuffer& audio,
+                               const AudioSampleBuffer& cvIn,
+                               AudioSampleBuffer& cvOut,
+                               MidiBuffer& midi)
+    {
+        const uint32_t numSamples   = audio.getNumSamples();
+        const uint32_t numAudioChan = jmin(audio.getNumChannels(), fDecoupled.audio.getNumChannels());
+        const uint32_t numCVInChan  = jmin(cvIn.getNumChannels(), fDecoupled.cvIn.getNumChannels());
+        const uint32_t numCVOutChan = jmin(cvOut.getNumChannels(), fDecoupled.cvOut.getNumChannels());
+
+        // take the incoming events out, so outgoing ones can be written as we go
+        fDecoupled.midiScratch.swapWith(midi);
+
+        for (uint32_t offset = 0; offset < numSamples;)
+        {
+            const uint32_t pos    = fDecoupled.pos;
+            const uint32_t frames = jmin(numSamples - offset, fDecoupled.size - pos);
+
+            for (uint32_t i=0; i<numAudioChan; ++i)
+            {
+                float* const io   = audio.getWritePointer(i, offset);
+                float* const fifo = fDecoupled.audio.getWritePointer(i, pos);
+
+                for (uint32_t j=0; j<frames; ++j)
+                {
+                    const float tmp = fifo[j];
+                    fifo[j] = io[j];
+                    io[j] = tmp;
+                }
+            }
+
+            for (uint32_t i=0; i<numCVInChan; ++i)
+                carla_copyFloats(fDecoupled.cvIn.getWritePointer(i, pos), cvIn.getReadPointer(i, offset), frames);
+            for (uint32_t i=0; i<numCVOutChan; ++i)
+                carla_copyFloats(cvOut.getWritePointer(i, offset), fDecoupled.cvOut.getReadPointer(i, pos), frames);
+
+            fDecoupled.numEventsIn += copyRawMidiEvents(fDecoupled.midiIn, fDecoupled.midiScratch, offset, frames, pos,
+                                                        kMaxEngineEventInternalCount - fDecoupled.numEventsIn);
+            copyRawMidiEvents(midi, fDecoupled.midiOut, pos, frames, offset, kMaxEngineEventInternalCount);
+
+            offset += frames;
+            fDecoupled.pos = pos + frames;
+
+            if (fDecoupled.pos != fDecoupled.size)
+                continue;
+
+            // all outputs of the previous block are out, its event buffer now takes the inputs and outputs of this one
+            fDecoupled.pos = 0;
+            fDecoupled.numEventsIn = 0;
+            fDecoupled.midiOut.swapWith(fDecoupled.midiIn);
+            fDecoupled.midiIn.clear();
+
+            processPluginBlock(fDecoupled.audio, fDecoupled.cvIn, fDecoupled.cvOut, fDecoupled.midiOut);
+        }
+
+        fDecoupled.midiScratch.clear();
+    }
+
     const String getInputChannelName(ChannelType t, uint i) const override
     {
         CarlaEngineClient* const client = fPlugin->getEngineClient();
@@ -1633,7 +2424,14 @@ public:
         return String();
     }
 
-    void prepareToPlay(double, int) override {}
+    void prepareToPlay(double, int) override
+    {
+        prepareDecoupledBlock();
+
+        const CarlaRecursiveMutexLocker crml(getCallbackLock());
+        prepareCrossfadeBuffers();
+    }
+
     void releaseResources() override {}
 
     bool acceptsMidi()  const override { return fPlugin->getDefaultEventInPort() != nullptr; }
@@ -1643,6 +2441,63 @@ private:
     CarlaEngine* const kEngine;
     CarlaPluginPtr fPlugin;
 
+    // see startBlockWithCV()
+    bool fStartingBlock;
+    bool fBlockStarted;
+
+    // see CarlaPlugin::checkAutoSleep(), decided once per block
+    bool fSleeping;
+
+    // see processDecoupledBlock(), size is 0 when not decoupled
+    struct DecoupledBlock {
+        uint32_t size;
+        uint32_t pos;
+        uint32_t numEventsIn;
+        AudioSampleBuffer audio;
+        AudioSampleBuffer cvIn;
+        AudioSampleBuffer cvOut;
+        MidiBuffer midiIn;
+        MidiBuffer midiOut;
+        MidiBuffer midiScratch;
+
+        DecoupledBlock()
+            : size(0),
+              pos(0),
+              numEventsIn(0),
+              audio(),
+              cvIn(),
+              cvOut(),
+              midiIn(),
+              midiOut(),
+              midiScratch() {}
+
+        CARLA_DECLARE_NON_COPY_STRUCT(DecoupledBlock)
+    } fDecoupled;
+
+    // see stagePluginSwap() and processCrossfadeBlock()
+    CarlaPluginPtr fStagedPlugin;
+    CarlaPluginPtr fFadingPlugin;
+    AudioSampleBuffer fFadeAudio;
+    AudioSampleBuffer fFadeCVOut;
+
+    // returns false if the block was only started, keeping the plugin locked until it completes
+    bool processPlugin(const float* const* const audioIn, float** const audioOut,
+                       const float* const* const cvIn, float** const cvOut, const uint32_t frames)
+    {
+        if (fStartingBlock)
+        {
+            fPlugin->startProcess(audioIn, audioOut, cvIn, cvOut, frames);
+            fBlockStarted = true;
+            return false;
+        }
+
+        const ScopedPluginDenormals spd(fPlugin->getOptionsEnabled());
+        const ScopedPluginProcessTimer sppt(kEngine->pData->plugins[fPlugin->getId()].processStats,
+                                            fPlugin.get());
+        fPlugin->process(audioIn, audioOut, cvIn, cvOut, frames);
+        return true;
+    }
+
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaPluginInstance)
 };
 
@@ -1673,18 +2528,126 @@ public:
         return String("Capture ") + String(index+1);
     }
 
-    void setNames(const bool setInputNames, const StringArray& names)
-    {
-        if (setInputNames)
-            inputNames = names;
-        else
-            outputNames = names;
-    }
+    void setNames(const bool setInputNames, const StringArray& names)
+    {
+        if (setInputNames)
+            inputNames = names;
+        else
+            outputNames = names;
+    }
+
+private:
+    StringArray inputNames;
+    StringArray outputNames;
+};
+
+// -----------------------------------------------------------------------
+// PatchbayPortNameIndex
+
+static const AudioProcessor::ChannelType kPortNameIndexTypes[3] = {
+    AudioProcessor::ChannelTypeAudio,
+    AudioProcessor::ChannelTypeCV,
+    AudioProcessor::ChannelTypeMIDI,
+};
+
+static const uint32_t kPortNameIndexInputOffsets[3] = {
+    kAudioInputPortOffset, kCVInputPortOffset, kMidiInputPortOffset
+};
+
+static const uint32_t kPortNameIndexOutputOffsets[3] = {
+    kAudioOutputPortOffset, kCVOutputPortOffset, kMidiOutputPortOffset
+};
+
+PatchbayPortNameIndex::PatchbayPortNameIndex()
+    : ports(),
+      namesByGroup() {}
+
+void PatchbayPortNameIndex::addNode(AudioProcessorGraph::Node* const node)
+{
+    CARLA_SAFE_ASSERT_RETURN(node != nullptr,);
+
+    AudioProcessor* const proc(node->getProcessor());
+    CARLA_SAFE_ASSERT_RETURN(proc != nullptr,);
+
+    const uint groupId = node->nodeId;
+
+    removeNode(groupId);
+
+    const std::string groupPrefix(std::string(proc->getName().toRawUTF8()) + ":");
+    std::vector<std::string>& names(namesByGroup[groupId]);
+
+    // same order as the old scan: audio, cv and midi, inputs before outputs
+    for (uint t=0; t<3; ++t)
+    {
+        const AudioProcessor::ChannelType channelType = kPortNameIndexTypes[t];
+
+        for (uint i=0, numInputs=proc->getTotalNumInputChannels(channelType); i<numInputs; ++i)
+        {
+            const std::string name(groupPrefix + proc->getInputChannelName(channelType, i).toRawUTF8());
+
+            if (ports.emplace(name, GroupAndPortId(groupId, kPortNameIndexInputOffsets[t]+i)).second)
+                names.push_back(name);
+        }
+
+        for (uint i=0, numOutputs=proc->getTotalNumOutputChannels(channelType); i<numOutputs; ++i)
+        {
+            const std::string name(groupPrefix + proc->getOutputChannelName(channelType, i).toRawUTF8());
+
+            if (ports.emplace(name, GroupAndPortId(groupId, kPortNameIndexOutputOffsets[t]+i)).second)
+                names.push_back(name);
+        }
+    }
+}
+
+void PatchbayPortNameIndex::removeNode(const uint groupId)
+{
+    const std::unordered_map<uint, std::vector<std::string> >::iterator it = namesByGroup.find(groupId);
+
+    if (it == namesByGroup.end())
+        return;
+
+    for (std::vector<std::string>::const_iterator nit = it->second.begin(), end = it->second.end(); nit != end; ++nit)
+        ports.erase(*nit);
+
+    namesByGroup.erase(it);
+}
+
+bool PatchbayPortNameIndex::find(const char* const fullPortName, uint& groupId, uint& portId) const
+{
+    const std::unordered_map<std::string, GroupAndPortId>::const_iterator it = ports.find(fullPortName);
+
+    if (it == ports.end())
+        return false;
+
+    groupId = it->second.first;
+    portId  = it->second.second;
+    return true;
+}
+
+// checks an index hit against the processor itself, in case its ports changed behind our back
+static inline
+bool processorHasFullPortName(AudioProcessor* const proc, const uint portId, const char* const fullPortName)
+{
+    CARLA_SAFE_ASSERT_RETURN(proc != nullptr, false);
+
+    AudioProcessor::ChannelType channelType;
+    uint index = portId;
+
+    if (! adjustPatchbayPortIdForWater(channelType, index))
+        return false;
+
+    // input offsets are odd multiples of kMaxPortsPerPlugin, outputs are even
+    const bool isInput = ((portId - index) / kMaxPortsPerPlugin) % 2 == 1;
+
+    if (index >= (isInput ? proc->getTotalNumInputChannels(channelType)
+                          : proc->getTotalNumOutputChannels(channelType)))
+        return false;
+
+    return getProcessorFullPortName(proc, portId) == fullPortName;
+}
 
-private:
-    StringArray inputNames;
-    StringArray outputNames;
-};
+// -----------------------------------------------------------------------
+// PatchbayGraph
 
 PatchbayGraph::PatchbayGraph(CarlaEngine* const engine,
                              const uint32_t audioIns, const uint32_t audioOuts,
@@ -1695,15 +2658,21 @@ PatchbayGraph::PatchbayGraph(CarlaEngine* const engine,
       audioBuffer(),
       cvInBuffer(),
       cvOutBuffer(),
+      directAudioIn(),
+      directAudioOut(),
+      directCVIn(),
+      directCVOut(),
       midiBuffer(),
       numAudioIns(carla_fixedValue(0U, 64U, audioIns)),
       numAudioOuts(carla_fixedValue(0U, 64U, audioOuts)),
       numCVIns(carla_fixedValue(0U, 8U, cvIns)),
       numCVOuts(carla_fixedValue(0U, 8U, cvOuts)),
       retCon(),
+      portNameIndex(),
       usingExternalHost(false),
       usingExternalOSC(false),
       extGraph(engine),
+      stagedSwapInstance(nullptr),
       kEngine(engine)
 {
     const uint32_t bufferSize(engine->getBufferSize());
@@ -1713,13 +2682,20 @@ PatchbayGraph::PatchbayGraph(CarlaEngine* const engine,
                                numCVIns, numCVOuts,
                                1, 1,
                                sampleRate, static_cast<int>(bufferSize));
+    graph.setNumProcessingThreads(engine->getOptions().processingThreads, engine->getOptions().processingCpuAffinity);
     graph.prepareToPlay(sampleRate, static_cast<int>(bufferSize));
 
     audioBuffer.setSize(jmax(numAudioIns, numAudioOuts), bufferSize);
     cvInBuffer.setSize(numCVIns, bufferSize);
     cvOutBuffer.setSize(numCVOuts, bufferSize);
 
-    midiBuffer.ensureSize(kMaxEngineEventInternalCount*2);
+    // allocate the channel lists now, the real pointers are set on each cycle
+    directAudioIn.setDataToReferTo(audioBuffer.getArrayOfWritePointers(), numAudioIns, bufferSize);
+    directAudioOut.setDataToReferTo(audioBuffer.getArrayOfWritePointers(), numAudioOuts, bufferSize);
+    directCVIn.setDataToReferTo(cvInBuffer.getArrayOfWritePointers(), numCVIns, bufferSize);
+    directCVOut.setDataToReferTo(cvOutBuffer.getArrayOfWritePointers(), numCVOuts, bufferSize);
+
+    midiBuffer.ensureSize(kMaxEngineEventInternalCount*(sizeof(EngineEvent)+8));
     midiBuffer.clear();
 
     StringArray channelNames;
@@ -1750,6 +2726,8 @@ PatchbayGraph::PatchbayGraph(CarlaEngine* const engine,
         node->properties.set("isCV", false);
         node->properties.set("isMIDI", false);
         node->properties.set("isOSC", false);
+
+        portNameIndex.addNode(node);
     }
 
     if (numAudioOuts != 0)
@@ -1765,6 +2743,8 @@ PatchbayGraph::PatchbayGraph(CarlaEngine* const engine,
         node->properties.set("isCV", false);
         node->properties.set("isMIDI", false);
         node->properties.set("isOSC", false);
+
+        portNameIndex.addNode(node);
     }
 
     if (numCVIns != 0)
@@ -1780,6 +2760,8 @@ PatchbayGraph::PatchbayGraph(CarlaEngine* const engine,
         node->properties.set("isCV", true);
         node->properties.set("isMIDI", false);
         node->properties.set("isOSC", false);
+
+        portNameIndex.addNode(node);
     }
 
     if (numCVOuts != 0)
@@ -1795,6 +2777,8 @@ PatchbayGraph::PatchbayGraph(CarlaEngine* const engine,
         node->properties.set("isCV", true);
         node->properties.set("isMIDI", false);
         node->properties.set("isOSC", false);
+
+        portNameIndex.addNode(node);
     }
 
     {
@@ -1807,6 +2791,8 @@ PatchbayGraph::PatchbayGraph(CarlaEngine* const engine,
         node->properties.set("isCV", false);
         node->properties.set("isMIDI", true);
         node->properties.set("isOSC", false);
+
+        portNameIndex.addNode(node);
     }
 
     {
@@ -1819,6 +2805,8 @@ PatchbayGraph::PatchbayGraph(CarlaEngine* const engine,
         node->properties.set("isCV", false);
         node->properties.set("isMIDI", true);
         node->properties.set("isOSC", false);
+
+        portNameIndex.addNode(node);
     }
 
     startThread();
@@ -1826,6 +2814,8 @@ PatchbayGraph::PatchbayGraph(CarlaEngine* const engine,
 
 PatchbayGraph::~PatchbayGraph()
 {
+    signalThreadShouldExit();
+    graph.wakeUpReorderWaiter();
     stopThread(-1);
 
     connections.clear();
@@ -1879,6 +2869,8 @@ void PatchbayGraph::addPlugin(const CarlaPluginPtr plugin)
     node->properties.set("isPlugin", true);
     node->properties.set("pluginId", static_cast<int>(plugin->getId()));
 
+    portNameIndex.addNode(node);
+
     addNodeToPatchbay(sendHost, sendOSC, kEngine, node, static_cast<int>(plugin->getId()), instance);
 }
 
@@ -1900,6 +2892,7 @@ void PatchbayGraph::replacePlugin(const CarlaPluginPtr oldPlugin, const CarlaPlu
 
     ((CarlaPluginInstance*)oldNode->getProcessor())->invalidatePlugin();
 
+    portNameIndex.removeNode(oldNode->nodeId);
     graph.removeNode(oldNode->nodeId);
 
     CarlaPluginInstance* const instance(new CarlaPluginInstance(kEngine, newPlugin));
@@ -1911,6 +2904,8 @@ void PatchbayGraph::replacePlugin(const CarlaPluginPtr oldPlugin, const CarlaPlu
     node->properties.set("isPlugin", true);
     node->properties.set("pluginId", static_cast<int>(newPlugin->getId()));
 
+    portNameIndex.addNode(node);
+
     addNodeToPatchbay(sendHost, sendOSC, kEngine, node, static_cast<int>(newPlugin->getId()), instance);
 }
 
@@ -1925,6 +2920,9 @@ void PatchbayGraph::renamePlugin(const CarlaPluginPtr plugin, const char* const
     const bool sendHost = !usingExternalHost;
     const bool sendOSC  = !usingExternalOSC;
 
+    // the plugin has its new name already
+    portNameIndex.addNode(node);
+
     kEngine->callback(sendHost, sendOSC,
                       ENGINE_CALLBACK_PATCHBAY_CLIENT_RENAMED,
                       node->nodeId,
@@ -1932,6 +2930,139 @@ void PatchbayGraph::renamePlugin(const CarlaPluginPtr plugin, const char* const
                       newName);
 }
 
+bool PatchbayGraph::stagePluginSwap(const CarlaPluginPtr oldPlugin, const CarlaPluginPtr newPlugin)
+{
+    CARLA_SAFE_ASSERT_RETURN(oldPlugin.get() != nullptr, false);
+    CARLA_SAFE_ASSERT_RETURN(newPlugin.get() != nullptr, false);
+    CARLA_SAFE_ASSERT_RETURN(stagedSwapInstance == nullptr, false);
+    carla_debug("PatchbayGraph::stagePluginSwap(%p, %p)", oldPlugin.get(), newPlugin.get());
+
+    AudioProcessorGraph::Node* const node = graph.getNodeForId(oldPlugin->getPatchbayNodeId());
+    CARLA_SAFE_ASSERT_RETURN(node != nullptr, false);
+
+    CarlaPluginInstance* const proc = dynamic_cast<CarlaPluginInstance*>(node->getProcessor());
+    CARLA_SAFE_ASSERT_RETURN(proc != nullptr && proc->isForPlugin(oldPlugin), false);
+
+    if (! proc->canSwapPlugin(newPlugin))
+        return false;
+
+    proc->stagePluginSwap(newPlugin);
+    newPlugin->setPatchbayNodeId(node->nodeId);
+
+    stagedSwapInstance = proc;
+    return true;
+}
+
+void PatchbayGraph::swapStagedPlugin() noexcept
+{
+    if (stagedSwapInstance == nullptr)
+        return;
+
+    stagedSwapInstance->swapPlugin();
+    stagedSwapInstance = nullptr;
+}
+
+void PatchbayGraph::finishPluginSwap(const CarlaPluginPtr newPlugin)
+{
+    CARLA_SAFE_ASSERT_RETURN(newPlugin.get() != nullptr,);
+
+    AudioProcessorGraph::Node* const node = graph.getNodeForId(newPlugin->getPatchbayNodeId());
+    CARLA_SAFE_ASSERT_RETURN(node != nullptr,);
+
+    AudioProcessor* const proc = node->getProcessor();
+    CARLA_SAFE_ASSERT_RETURN(proc != nullptr,);
+
+    const bool sendHost = !usingExternalHost;
+    const bool sendOSC  = !usingExternalOSC;
+
+    // connections stay, only names can differ
+    portNameIndex.addNode(node);
+
+    kEngine->callback(sendHost, sendOSC,
+                      ENGINE_CALLBACK_PATCHBAY_CLIENT_RENAMED,
+                      node->nodeId,
+                      0, 0, 0, 0.0f,
+                      proc->getName().toRawUTF8());
+
+    static const struct {
+        AudioProcessor::ChannelType type;
+        bool isInput;
+        uint offset;
+        int hints;
+    } kPortTypes[] = {
+        { AudioProcessor::ChannelTypeAudio, true,  kAudioInputPortOffset,  PATCHBAY_PORT_TYPE_AUDIO|PATCHBAY_PORT_IS_INPUT },
+        { AudioProcessor::ChannelTypeAudio, false, kAudioOutputPortOffset, PATCHBAY_PORT_TYPE_AUDIO },
+        { AudioProcessor::ChannelTypeCV,    true,  kCVInputPortOffset,     PATCHBAY_PORT_TYPE_CV|PATCHBAY_PORT_IS_INPUT },
+        { AudioProcessor::ChannelTypeCV,    false, kCVOutputPortOffset,    PATCHBAY_PORT_TYPE_CV },
+        { AudioProcessor::ChannelTypeMIDI,  true,  kMidiInputPortOffset,   PATCHBAY_PORT_TYPE_MIDI|PATCHBAY_PORT_IS_INPUT },
+        { AudioProcessor::ChannelTypeMIDI,  false, kMidiOutputPortOffset,  PATCHBAY_PORT_TYPE_MIDI },
+    };
+
+    for (uint t=0; t < sizeof(kPortTypes)/sizeof(kPortTypes[0]); ++t)
+    {
+        const AudioProcessor::ChannelType type = kPortTypes[t].type;
+        const bool isInput = kPortTypes[t].isInput;
+
+        for (uint i=0, count=isInput ? proc->getTotalNumInputChannels(type) : proc->getTotalNumOutputChannels(type); i<count; ++i)
+        {
+            kEngine->callback(sendHost, sendOSC,
+                              ENGINE_CALLBACK_PATCHBAY_PORT_CHANGED,
+                              node->nodeId,
+                              static_cast<int>(kPortTypes[t].offset+i),
+                              kPortTypes[t].hints,
+                              0, 0.0f,
+                              (isInput ? proc->getInputChannelName(type, i)
+                                       : proc->getOutputChannelName(type, i)).toRawUTF8());
+        }
+    }
+}
+
+void PatchbayGraph::setPluginLatency(const CarlaPluginPtr plugin, const uint32_t latency)
+{
+    CARLA_SAFE_ASSERT_RETURN(plugin.get() != nullptr,);
+
+    // not added to the graph yet, the latency is read when it is
+    AudioProcessorGraph::Node* const node = graph.getNodeForId(plugin->getPatchbayNodeId());
+    if (node == nullptr)
+        return;
+
+    CarlaPluginInstance* const proc = dynamic_cast<CarlaPluginInstance*>(node->getProcessor());
+    if (proc == nullptr || ! proc->isForPlugin(plugin))
+        return;
+
+    const int newLatency = static_cast<int>(latency + proc->getDecoupledLatency());
+
+    if (proc->getLatencySamples() == newLatency)
+        return;
+
+    proc->setLatencySamples(newLatency);
+
+    // only delay amounts change, the reorder thread adjusts them without rebuilding the graph
+    graph.triggerLatencyUpdate();
+}
+
+void PatchbayGraph::setPluginBufferSize(const CarlaPluginPtr plugin)
+{
+    CARLA_SAFE_ASSERT_RETURN(plugin.get() != nullptr,);
+    carla_debug("PatchbayGraph::setPluginBufferSize(%p)", plugin.get());
+
+    // not added to the graph yet, the buffer size is read when it is
+    AudioProcessorGraph::Node* const node = graph.getNodeForId(plugin->getPatchbayNodeId());
+    if (node == nullptr)
+        return;
+
+    CarlaPluginInstance* const proc = dynamic_cast<CarlaPluginInstance*>(node->getProcessor());
+    if (proc == nullptr || ! proc->isForPlugin(plugin))
+        return;
+
+    const int oldLatency = proc->getLatencySamples();
+
+    proc->prepareDecoupledBlock();
+
+    if (proc->getLatencySamples() != oldLatency)
+        graph.triggerLatencyUpdate();
+}
+
 void PatchbayGraph::reconfigureForCV(const CarlaPluginPtr plugin, const uint portIndex, bool added)
 {
     CARLA_SAFE_ASSERT_RETURN(plugin.get() != nullptr,);
@@ -1957,6 +3088,8 @@ void PatchbayGraph::reconfigureForCV(const CarlaPluginPtr plugin, const uint por
         graph.buildRenderingSequence();
     }
 
+    portNameIndex.addNode(node);
+
     const uint newCvIn = proc->getTotalNumInputChannels(AudioProcessor::ChannelTypeCV);
     // const uint newCvOut = proc->getTotalNumOutputChannels(AudioProcessor::ChannelTypeCV);
 
@@ -2015,6 +3148,8 @@ void PatchbayGraph::removePlugin(const CarlaPluginPtr plugin)
         }
     }
 
+    portNameIndex.removeNode(node->nodeId);
+
     CARLA_SAFE_ASSERT_RETURN(graph.removeNode(node->nodeId),);
 }
 
@@ -2038,6 +3173,7 @@ void PatchbayGraph::removeAllPlugins()
 
         ((CarlaPluginInstance*)node->getProcessor())->invalidatePlugin();
 
+        portNameIndex.removeNode(node->nodeId);
         graph.removeNode(node->nodeId);
     }
 }
@@ -2414,6 +3550,27 @@ bool PatchbayGraph::getGroupAndPortIdFromFullName(const bool external, const cha
     if (external)
         return extGraph.getGroupAndPortIdFromFullName(fullPortName, groupId, portId);
 
+    CARLA_SAFE_ASSERT_RETURN(fullPortName != nullptr && fullPortName[0] != '\0', false);
+
+    if (portNameIndex.find(fullPortName, groupId, portId))
+    {
+        if (AudioProcessorGraph::Node* const node = graph.getNodeForId(groupId))
+            if (processorHasFullPortName(node->getProcessor(), portId, fullPortName))
+                return true;
+    }
+
+    // not indexed or out of date, look for it the slow way and index its node again
+    if (! findGroupAndPortIdFromFullName(fullPortName, groupId, portId))
+        return false;
+
+    if (AudioProcessorGraph::Node* const node = graph.getNodeForId(groupId))
+        portNameIndex.addNode(node);
+
+    return true;
+}
+
+bool PatchbayGraph::findGroupAndPortIdFromFullName(const char* const fullPortName, uint& groupId, uint& portId) const
+{
     String groupName(String(fullPortName).upToFirstOccurrenceOf(":", false, false));
     String portName(String(fullPortName).fromFirstOccurrenceOf(":", false, false));
 
@@ -2488,6 +3645,35 @@ bool PatchbayGraph::getGroupAndPortIdFromFullName(const bool external, const cha
     return false;
 }
 
+// In-place drivers and plugin hosts can pass the same memory as input and output,
+// which needs the graph to work on copies, as it clears the outputs before reading any input.
+static bool canUseDriverBuffersDirectly(const float* const* const inBuf, const uint32_t numIns,
+                                        float* const* const outBuf, const uint32_t numOuts,
+                                        const uint32_t frames) noexcept
+{
+    for (uint32_t i=0; i < numIns; ++i)
+    {
+        if (inBuf[i] == nullptr)
+            return false;
+    }
+
+    for (uint32_t o=0; o < numOuts; ++o)
+    {
+        const float* const out = outBuf[o];
+
+        if (out == nullptr)
+            return false;
+
+        for (uint32_t i=0; i < numIns; ++i)
+        {
+            if (inBuf[i] < out + frames && out < inBuf[i] + frames)
+                return false;
+        }
+    }
+
+    return true;
+}
+
 void PatchbayGraph::process(CarlaEngine::ProtectedData* const data,
                             const float* const* const inBuf,
                             float* const* const outBuf,
@@ -2504,6 +3690,29 @@ void PatchbayGraph::process(CarlaEngine::ProtectedData* const data,
         fillWaterMidiBufferFromEngineEvents(midiBuffer, data->events.in);
     }
 
+    if (canUseDriverBuffersDirectly(inBuf, numAudioIns + numCVIns, outBuf, numAudioOuts + numCVOuts, frames)
+        && directAudioIn.setDataToReferToRT(const_cast<float* const*>(inBuf), frames)
+        && directCVIn.setDataToReferToRT(const_cast<float* const*>(inBuf + numAudioIns), frames)
+        && directAudioOut.setDataToReferToRT(outBuf, frames)
+        && directCVOut.setDataToReferToRT(outBuf + numAudioOuts, frames))
+    {
+        graph.processBlockWithCV(directAudioIn, directAudioOut, directCVIn, directCVOut, midiBuffer);
+    }
+    else
+    {
+        processWithCopies(inBuf, outBuf, frames);
+    }
+
+    // put water events in carla buffer
+    {
+        clearEngineEvents(data->events.out);
+        fillEngineEventsFromWaterMidiBuffer(data->events.out, midiBuffer);
+        midiBuffer.clear();
+    }
+}
+
+void PatchbayGraph::processWithCopies(const float* const* const inBuf, float* const* const outBuf, const uint32_t frames)
+{
     // set audio and cv buffer size, needed for water internals
     if (! audioBuffer.setSizeRT(frames))
         return;
@@ -2547,24 +3756,106 @@ void PatchbayGraph::process(CarlaEngine::ProtectedData* const data,
         for (uint32_t j=0; j < numCVOuts; ++j, ++i)
             carla_copyFloats(outBuf[i], cvOutBuffer.getReadPointer(j), frames);
     }
-
-    // put water events in carla buffer
-    {
-        carla_zeroStructs(data->events.out, kMaxEngineEventInternalCount);
-        fillEngineEventsFromWaterMidiBuffer(data->events.out, midiBuffer);
-        midiBuffer.clear();
-    }
 }
 
 void PatchbayGraph::run()
 {
     while (! shouldThreadExit())
     {
-        carla_msleep(100);
+        graph.waitForReorderRequest();
+
+        if (shouldThreadExit())
+            break;
+
         graph.reorderNowIfNeeded();
     }
 }
 
+// -----------------------------------------------------------------------
+// EngineOutputFader
+
+EngineOutputFader::EngineOutputFader() noexcept
+    : state(kStateIdle),
+      fadeFrames(1),
+      rtState(kStateIdle),
+      position(0) {}
+
+void EngineOutputFader::fadeOut(const uint32_t frames) noexcept
+{
+    fadeFrames = std::max(frames, 1U);
+    __sync_synchronize();
+    state = kStateFadingOut;
+}
+
+void EngineOutputFader::fadeIn(const uint32_t frames) noexcept
+{
+    fadeFrames = std::max(frames, 1U);
+    __sync_synchronize();
+    state = kStateFadingIn;
+}
+
+void EngineOutputFader::reset() noexcept
+{
+    state = kStateIdle;
+}
+
+bool EngineOutputFader::isSilent() const noexcept
+{
+    return state == kStateSilent;
+}
+
+void EngineOutputFader::process(float* const* const outBuf, const uint32_t numChannels, const uint32_t frames) noexcept
+{
+    const int curState = state;
+
+    if (curState == kStateIdle)
+    {
+        rtState = kStateIdle;
+        return;
+    }
+
+    if (curState != rtState)
+    {
+        rtState  = curState;
+        position = 0;
+    }
+
+    if (curState == kStateSilent)
+    {
+        for (uint32_t c=0; c < numChannels; ++c)
+            carla_zeroFloats(outBuf[c], frames);
+        return;
+    }
+
+    const bool fadingIn = curState == kStateFadingIn;
+    const uint32_t total = fadeFrames;
+    const float ftotal = static_cast<float>(total);
+
+    for (uint32_t c=0; c < numChannels; ++c)
+    {
+        float* const out = outBuf[c];
+
+        for (uint32_t i=0; i < frames; ++i)
+        {
+            const uint32_t pos = position + i;
+            const float gain = pos >= total ? 1.0f : static_cast<float>(pos) / ftotal;
+
+            out[i] *= fadingIn ? gain : 1.0f - gain;
+        }
+    }
+
+    position = std::min(total, position + frames);
+
+    if (position < total)
+        return;
+
+    // the main thread may have started another fade meanwhile, do not override it
+    if (fadingIn)
+        __sync_bool_compare_and_swap(&state, kStateFadingIn, kStateIdle);
+    else
+        __sync_bool_compare_and_swap(&state, kStateFadingOut, kStateSilent);
+}
+
 // -----------------------------------------------------------------------
 // InternalGraph
 
@@ -2572,6 +3863,7 @@ EngineInternalGraph::EngineInternalGraph(CarlaEngine* const engine) noexcept
     : fIsRack(false),
       fNumAudioOuts(0),
       fIsReady(false),
+      fFader(),
       fRack(nullptr),
       kEngine(engine) {}
 
@@ -2624,6 +3916,7 @@ void EngineInternalGraph::destroy() noexcept
 
     fIsReady = false;
     fNumAudioOuts = 0;
+    fFader.reset();
 }
 
 void EngineInternalGraph::setBufferSize(const uint32_t bufferSize)
@@ -2702,6 +3995,8 @@ void EngineInternalGraph::process(CarlaEngine::ProtectedData* const data, const
         CARLA_SAFE_ASSERT_RETURN(fPatchbay != nullptr,);
         fPatchbay->process(data, inBuf, outBuf, frames);
     }
+
+    fFader.process(outBuf, fNumAudioOuts, frames);
 }
 
 void EngineInternalGraph::processRack(CarlaEngine::ProtectedData* const data, const float* inBuf[2], float* outBuf[2], const uint32_t frames)
@@ -2710,6 +4005,16 @@ void EngineInternalGraph::processRack(CarlaEngine::ProtectedData* const data, co
     CARLA_SAFE_ASSERT_RETURN(fRack != nullptr,);
 
     fRack->process(data, inBuf, outBuf, frames);
+
+    fFader.process(outBuf, 2, frames);
+}
+
+uint32_t EngineInternalGraph::getRackLatency(const CarlaEngine::ProtectedData* const data) const noexcept
+{
+    if (! fIsRack || fRack == nullptr)
+        return 0;
+
+    return fRack->getLatency(data);
 }
 
 // -----------------------------------------------------------------------
@@ -2727,6 +4032,33 @@ void EngineInternalGraph::replacePlugin(const CarlaPluginPtr oldPlugin, const Ca
     fPatchbay->replacePlugin(oldPlugin, newPlugin);
 }
 
+bool EngineInternalGraph::stagePluginSwap(const CarlaPluginPtr oldPlugin, const CarlaPluginPtr newPlugin)
+{
+    // rack mode reads plugins from the engine slots directly, nothing to stage
+    if (fIsRack)
+        return true;
+
+    CARLA_SAFE_ASSERT_RETURN(fPatchbay != nullptr, false);
+    return fPatchbay->stagePluginSwap(oldPlugin, newPlugin);
+}
+
+void EngineInternalGraph::swapStagedPlugin() noexcept
+{
+    if (fIsRack || fPatchbay == nullptr)
+        return;
+
+    fPatchbay->swapStagedPlugin();
+}
+
+void EngineInternalGraph::finishPluginSwap(const CarlaPluginPtr newPlugin)
+{
+    if (fIsRack)
+        return;
+
+    CARLA_SAFE_ASSERT_RETURN(fPatchbay != nullptr,);
+    fPatchbay->finishPluginSwap(newPlugin);
+}
+
 void EngineInternalGraph::renamePlugin(const CarlaPluginPtr plugin, const char* const newName)
 {
     CARLA_SAFE_ASSERT_RETURN(fPatchbay != nullptr,);
@@ -2874,6 +4206,63 @@ bool CarlaEngine::patchbayRefresh(const bool sendHost, const bool sendOSC, const
     return false;
 }
 
+const char* CarlaEngine::getPatchbaySnapshot(const bool sendHost, const bool sendOSC, const bool external)
+{
+    CARLA_SAFE_ASSERT_RETURN(! pData->patchbaySnapshot.collecting, nullptr);
+
+    bool ok = false;
+
+    pData->patchbaySnapshot.begin();
+
+    try {
+        ok = patchbayRefresh(sendHost, sendOSC, external);
+    } CARLA_SAFE_EXCEPTION("patchbayRefresh");
+
+    const char* const snapshot = pData->patchbaySnapshot.end();
+    carla_debug("CarlaEngine::getPatchbaySnapshot(%s, %s, %s) - %u records",
+                bool2str(sendHost), bool2str(sendOSC), bool2str(external), pData->patchbaySnapshot.count);
+
+    return ok ? snapshot : nullptr;
+}
+
+void CarlaEngine::patchbayBeginBatch()
+{
+    carla_debug("CarlaEngine::patchbayBeginBatch() - depth %u", pData->patchbayBatchDepth);
+
+    if (pData->patchbayBatchDepth++ == 0)
+    {
+        const CarlaMutexLocker cml(pData->patchbayBatchMutex);
+        pData->patchbayBatch.begin();
+    }
+
+    if (PatchbayGraph* const graph = pData->graph.getPatchbayGraphOrNull())
+        graph->graph.suspendReordering();
+}
+
+void CarlaEngine::patchbayEndBatch()
+{
+    CARLA_SAFE_ASSERT_RETURN(pData->patchbayBatchDepth > 0,);
+    carla_debug("CarlaEngine::patchbayEndBatch() - depth %u", pData->patchbayBatchDepth);
+
+    if (PatchbayGraph* const graph = pData->graph.getPatchbayGraphOrNull())
+        graph->graph.resumeReordering();
+
+    if (--pData->patchbayBatchDepth != 0)
+        return;
+
+    CarlaString records;
+    uint count;
+
+    {
+        const CarlaMutexLocker cml(pData->patchbayBatchMutex);
+        records = pData->patchbayBatch.end();
+        count   = pData->patchbayBatch.count;
+    }
+
+    if (count != 0)
+        callback(true, true, ENGINE_CALLBACK_PATCHBAY_BATCH, 0, static_cast<int>(count), 0, 0, 0.0f, records);
+}
+
 // -----------------------------------------------------------------------
 // Patchbay stuff
 
@@ -2999,19 +4388,30 @@ bool CarlaEngine::connectExternalGraphPort(const uint connectionType, const uint
 
     const CarlaRecursiveMutexLocker cml(graph->audioBuffers.mutex);
 
+    bool ok;
+
     switch (connectionType)
     {
     case kExternalGraphConnectionAudioIn1:
-        return graph->audioBuffers.connectedIn1.append(portId);
+        ok = graph->audioBuffers.connectedIn1.append(portId);
+        break;
     case kExternalGraphConnectionAudioIn2:
-        return graph->audioBuffers.connectedIn2.append(portId);
+        ok = graph->audioBuffers.connectedIn2.append(portId);
+        break;
     case kExternalGraphConnectionAudioOut1:
-        return graph->audioBuffers.connectedOut1.append(portId);
+        ok = graph->audioBuffers.connectedOut1.append(portId);
+        break;
     case kExternalGraphConnectionAudioOut2:
-        return graph->audioBuffers.connectedOut2.append(portId);
+        ok = graph->audioBuffers.connectedOut2.append(portId);
+        break;
+    default:
+        return false;
     }
 
-    return false;
+    if (ok)
+        graph->audioBuffers.updateRouting(graph->inputs, graph->outputs);
+
+    return ok;
 }
 
 bool CarlaEngine::disconnectExternalGraphPort(const uint connectionType, const uint portId, const char* const portName)
@@ -3024,19 +4424,30 @@ bool CarlaEngine::disconnectExternalGraphPort(const uint connectionType, const u
 
     const CarlaRecursiveMutexLocker cml(graph->audioBuffers.mutex);
 
+    bool ok;
+
     switch (connectionType)
     {
     case kExternalGraphConnectionAudioIn1:
-        return graph->audioBuffers.connectedIn1.removeOne(portId);
+        ok = graph->audioBuffers.connectedIn1.removeOne(portId);
+        break;
     case kExternalGraphConnectionAudioIn2:
-        return graph->audioBuffers.connectedIn2.removeOne(portId);
+        ok = graph->audioBuffers.connectedIn2.removeOne(portId);
+        break;
     case kExternalGraphConnectionAudioOut1:
-        return graph->audioBuffers.connectedOut1.removeOne(portId);
+        ok = graph->audioBuffers.connectedOut1.removeOne(portId);
+        break;
     case kExternalGraphConnectionAudioOut2:
-        return graph->audioBuffers.connectedOut2.removeOne(portId);
+        ok = graph->audioBuffers.connectedOut2.removeOne(portId);
+        break;
+    default:
+        return false;
     }
 
-    return false;
+    if (ok)
+        graph->audioBuffers.updateRouting(graph->inputs, graph->outputs);
+
+    return ok;
 }
 
 // -----------------------------------------------------------------------
@@ -19,20 +19,28 @@
 #define CARLA_ENGINE_GRAPH_HPP_INCLUDED
 
 #include "CarlaEngine.hpp"
+#include "CarlaEngineUtils.hpp"
 #include "CarlaMutex.hpp"
 #include "CarlaPatchbayUtils.hpp"
 #include "CarlaStringList.hpp"
 #include "CarlaThread.hpp"
+#include "CarlaThreadPool.hpp"
 
 #include "water/processors/AudioProcessorGraph.h"
 #include "water/text/StringArray.h"
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 using water::AudioProcessorGraph;
 using water::AudioSampleBuffer;
 using water::MidiBuffer;
 
 CARLA_BACKEND_START_NAMESPACE
 
+class CarlaPluginInstance;
+
 // -----------------------------------------------------------------------
 
 struct PatchbayPosition {
@@ -114,6 +122,8 @@ struct ExternalGraph {
 // -----------------------------------------------------------------------
 // RackGraph
 
+static const uint kMaxRackLanes = 16;
+
 struct RackGraph {
     ExternalGraph extGraph;
     const uint32_t inputs;
@@ -121,22 +131,84 @@ struct RackGraph {
     bool isOffline;
 
     struct Buffers {
+        // External connections compiled into flat lists of 0-based port indexes, read by the audio thread.
+        // A new one is built after every connection change and handed over like grown event buffers:
+        // published as pending, adopted at the start of the next cycle, and deleted on the next change.
+        struct Routing {
+            uint numIns[2];
+            uint numOuts[2];
+            uint* ins[2];
+            uint* outs[2];
+            uint* ports;
+            Routing() noexcept;
+            ~Routing() noexcept;
+            CARLA_DECLARE_NON_COPY_STRUCT(Routing)
+        };
+
+        // protects the connection lists, only used outside of the audio thread
         CarlaRecursiveMutex mutex;
         LinkedList<uint> connectedIn1;
         LinkedList<uint> connectedIn2;
         LinkedList<uint> connectedOut1;
         LinkedList<uint> connectedOut2;
+        Routing* routing;
+        Routing* routingPending;
+        Routing* routingRetired;
         float* inBuf[2];
         float* inBufTmp[2];
         float* outBuf[2];
+        float* fadeBuf[2];
         float* unusedBuf;
+        EngineAudioBufferArena arena;
         Buffers() noexcept;
         ~Buffers() noexcept;
         void setBufferSize(uint32_t bufferSize, bool createBuffers) noexcept;
+
+        // non-RT, must be called with the mutex locked after changing the connection lists
+        void updateRouting(uint inputs, uint outputs) noexcept;
+
+        // RT, returns the routing to use for the current cycle, may be null
+        const Routing* adoptRouting() noexcept;
         CARLA_PREVENT_HEAP_ALLOCATION
         CARLA_DECLARE_NON_COPY_CLASS(Buffers)
     } audioBuffers;
 
+    // Independent plugin chains, processed concurrently when processing threads are enabled.
+    // A new lane starts on each plugin without audio inputs, lanes are mixed together at the end.
+    struct Lanes {
+        struct Lane {
+            uint firstPlugin;
+            uint endPlugin;
+            float* inBufTmp[2];
+            float* outBuf[2];
+            float* fadeBuf[2];
+            float* unusedBuf;
+            EngineEvent* eventsIn;
+            EngineEvent* eventsOut;
+        } lanes[kMaxRackLanes];
+        uint count;
+        uint pluginLanes[MAX_RACK_PLUGINS];
+        float* zeroBuf;
+        EngineAudioBufferArena arena;
+
+        // shared with other engines, at most numThreads of its workers are used by this one
+        CarlaThreadPool* threadPool;
+        uint numThreads;
+
+        // current cycle, used by the worker threads
+        volatile int nextLane;
+        CarlaEngine::ProtectedData* data;
+        const float* inBuf[2];
+        uint32_t frames;
+
+        Lanes() noexcept;
+        ~Lanes() noexcept;
+        void setBufferSize(uint32_t bufferSize) noexcept;
+        bool update(const CarlaEngine::ProtectedData* data) noexcept;
+        CARLA_DECLARE_NON_COPY_STRUCT(Lanes)
+    };
+    Lanes* lanes;
+
     RackGraph(CarlaEngine* engine, uint32_t inputs, uint32_t outputs) noexcept;
     ~RackGraph() noexcept;
 
@@ -153,6 +225,21 @@ struct RackGraph {
     // the base, where plugins run
     void process(CarlaEngine::ProtectedData* data, const float* inBuf[2], float* outBuf[2], uint32_t frames);
 
+    // process a range of plugins in series, fadeBuf takes the outputs of plugins being replaced
+    void processPlugins(CarlaEngine::ProtectedData* data, uint firstPlugin, uint endPlugin,
+                        const float* inBuf[2], float* inBufTmp[2], float* outBuf[2], float* fadeBuf[2], float* dummyBuf,
+                        EngineEvent* eventsIn, EngineEvent* eventsOut, uint32_t frames);
+
+    // process each lane on the thread pool, then mix them together
+    void processLanes(CarlaEngine::ProtectedData* data, const float* inBuf[2], float* outBuf[2], uint32_t frames);
+    static void processLanesCallback(void* ptr, uint threadIndex);
+
+    // event buffers of the lane a plugin belongs to, or null if lanes are not active
+    EngineEvent* getLaneEventBuffer(uint pluginId, bool isInput) const noexcept;
+
+    // total latency of the audio path from the rack inputs to its outputs, in frames
+    uint32_t getLatency(const CarlaEngine::ProtectedData* data) const noexcept;
+
     // extended, will call process() in the middle
     void processHelper(CarlaEngine::ProtectedData* data, const float* const* inBuf, float* const* outBuf, uint32_t frames);
 
@@ -160,6 +247,27 @@ struct RackGraph {
     CARLA_DECLARE_NON_COPY_CLASS(RackGraph)
 };
 
+// -----------------------------------------------------------------------
+// PatchbayPortNameIndex
+
+// Full "group:port" names of the internal patchbay ports, so restoring connections does not scan every node.
+// Nodes are (re)indexed as they are added, renamed or reconfigured, and dropped when removed.
+// If a name is taken by more than one port, the first one indexed wins, like the old scan did.
+struct PatchbayPortNameIndex {
+    typedef std::pair<uint, uint> GroupAndPortId;
+
+    std::unordered_map<std::string, GroupAndPortId> ports;
+    std::unordered_map<uint, std::vector<std::string> > namesByGroup;
+
+    PatchbayPortNameIndex();
+
+    void addNode(AudioProcessorGraph::Node* node);
+    void removeNode(uint groupId);
+    bool find(const char* fullPortName, uint& groupId, uint& portId) const;
+
+    CARLA_DECLARE_NON_COPY_STRUCT(PatchbayPortNameIndex)
+};
+
 // -----------------------------------------------------------------------
 // PatchbayGraph
 
@@ -170,12 +278,18 @@ public:
     AudioSampleBuffer audioBuffer;
     AudioSampleBuffer cvInBuffer;
     AudioSampleBuffer cvOutBuffer;
+    // refer to the driver buffers, for processing without copying them
+    AudioSampleBuffer directAudioIn;
+    AudioSampleBuffer directAudioOut;
+    AudioSampleBuffer directCVIn;
+    AudioSampleBuffer directCVOut;
     MidiBuffer midiBuffer;
     const uint32_t numAudioIns;
     const uint32_t numAudioOuts;
     const uint32_t numCVIns;
     const uint32_t numCVOuts;
     mutable CharStringListPtr retCon;
+    mutable PatchbayPortNameIndex portNameIndex;
     bool usingExternalHost;
     bool usingExternalOSC;
 
@@ -193,6 +307,14 @@ public:
     void addPlugin(CarlaPluginPtr plugin);
     void replacePlugin(CarlaPluginPtr oldPlugin, CarlaPluginPtr newPlugin);
     void renamePlugin(CarlaPluginPtr plugin, const char* newName);
+
+    // keeps the node and its connections, returns false if the new plugin cannot take over the node as-is
+    bool stagePluginSwap(CarlaPluginPtr oldPlugin, CarlaPluginPtr newPlugin);
+    void swapStagedPlugin() noexcept;
+    void finishPluginSwap(CarlaPluginPtr newPlugin);
+
+    void setPluginLatency(CarlaPluginPtr plugin, uint32_t latency);
+    void setPluginBufferSize(CarlaPluginPtr plugin);
     void reconfigureForCV(CarlaPluginPtr plugin, const uint portIndex, bool added);
     void reconfigurePlugin(CarlaPluginPtr plugin, bool portsAdded);
     void removePlugin(CarlaPluginPtr plugin);
@@ -215,8 +337,13 @@ public:
                  uint32_t frames);
 
 private:
+    void processWithCopies(const float* const* inBuf, float* const* outBuf, uint32_t frames);
+    bool findGroupAndPortIdFromFullName(const char* fullPortName, uint& groupId, uint& portId) const;
     void run() override;
 
+    // see stagePluginSwap(), picked up by the audio thread
+    CarlaPluginInstance* stagedSwapInstance;
+
     CarlaEngine* const kEngine;
     CARLA_DECLARE_NON_COPY_CLASS(PatchbayGraph)
 };
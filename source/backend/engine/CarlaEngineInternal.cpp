@@ -17,12 +17,15 @@
 
 #include "CarlaEngineInternal.hpp"
 #include "CarlaPlugin.hpp"
+#include "CarlaMathUtils.hpp"
 #include "CarlaSemUtils.hpp"
+#include "CarlaTimeUtils.hpp"
 
 #include "jackbridge/JackBridge.hpp"
 
-#include <ctime>
-#include <sys/time.h>
+#ifdef CARLA_OS_LINUX
+# include <dlfcn.h>
+#endif
 
 CARLA_BACKEND_START_NAMESPACE
 
@@ -47,15 +50,17 @@ EngineInternalEvents::~EngineInternalEvents() noexcept
 
 void EngineInternalEvents::clear() noexcept
 {
+    CarlaMemoryLock& memoryLock(CarlaMemoryLock::getInstance());
+
     if (in != nullptr)
     {
-        delete[] in;
+        memoryLock.deallocate(in);
         in = nullptr;
     }
 
     if (out != nullptr)
     {
-        delete[] out;
+        memoryLock.deallocate(out);
         out = nullptr;
     }
 }
@@ -250,6 +255,7 @@ void EngineInternalTime::fillEngineTimeInfo(const uint32_t newFrames) noexcept
     timeInfo.bbt.beatsPerBar = static_cast<float>(beatsPerBar);
     timeInfo.bbt.beatsPerMinute = beatsPerMinute;
     timeInfo.bbt.tick = ticktmp;
+    timeInfo.bbt.updatePPQ();
     tick = ticktmp;
 
     if (transportMode == ENGINE_TRANSPORT_MODE_INTERNAL && timeInfo.playing)
@@ -330,9 +336,8 @@ EngineInternalTime::Hylia::~Hylia()
 // NextAction
 
 EngineNextAction::EngineNextAction() noexcept
-    : opcode(kEnginePostActionNull),
-      pluginId(0),
-      value(0),
+    : actions(),
+      count(0),
       mutex(),
       needsPost(false),
       postDone(false),
@@ -340,7 +345,7 @@ EngineNextAction::EngineNextAction() noexcept
 
 EngineNextAction::~EngineNextAction() noexcept
 {
-    CARLA_SAFE_ASSERT(opcode == kEnginePostActionNull);
+    CARLA_SAFE_ASSERT(count == 0);
 
     if (sem != nullptr)
     {
@@ -352,11 +357,9 @@ EngineNextAction::~EngineNextAction() noexcept
 void EngineNextAction::clearAndReset() noexcept
 {
     mutex.lock();
-    CARLA_SAFE_ASSERT(opcode == kEnginePostActionNull);
+    CARLA_SAFE_ASSERT(count == 0);
 
-    opcode    = kEnginePostActionNull;
-    pluginId  = 0;
-    value     = 0;
+    count     = 0;
     needsPost = false;
     postDone  = false;
     mutex.unlock();
@@ -380,6 +383,7 @@ CarlaEngine::ProtectedData::ProtectedData(CarlaEngine* const engine)
 #endif
       callback(nullptr),
       callbackPtr(nullptr),
+      callbackQueue(),
       fileCallback(nullptr),
       fileCallbackPtr(nullptr),
       actionCanceled(false),
@@ -405,11 +409,26 @@ CarlaEngine::ProtectedData::ProtectedData(CarlaEngine* const engine)
       plugins(nullptr),
       xruns(0),
       dspLoad(0.0f),
+      cycleLog(),
+      peaksBlock(),
 #endif
       pluginsToDelete(),
+      pluginReaper(),
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+      pluginLoader(*engine),
+      pluginsFadingOut(),
+      pluginToSwapIn(),
+#endif
       events(),
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
       graph(engine),
+      patchbaySnapshot(),
+      patchbayBatch(),
+      patchbayBatchMutex(),
+      patchbayBatchDepth(0),
+      preloadedProject(),
+      stagedParameterValues(nullptr),
+      stagedParameterValueCount(0),
 #endif
       time(timeInfo, options.transportMode),
       nextAction()
@@ -475,13 +494,17 @@ bool CarlaEngine::ProtectedData::init(const char* const clientName)
         break;
     }
 
+    CarlaMemoryLock& memoryLock(CarlaMemoryLock::getInstance());
+
     switch (options.processMode)
     {
     case ENGINE_PROCESS_MODE_CONTINUOUS_RACK:
     case ENGINE_PROCESS_MODE_PATCHBAY:
     case ENGINE_PROCESS_MODE_BRIDGE:
-        events.in  = new EngineEvent[kMaxEngineEventInternalCount];
-        events.out = new EngineEvent[kMaxEngineEventInternalCount];
+        // read and written by the audio thread, kept in RAM if ENGINE_OPTION_LOCK_MEMORY is set
+        events.in  = static_cast<EngineEvent*>(memoryLock.allocate(sizeof(EngineEvent)*kMaxEngineEventInternalCount));
+        events.out = static_cast<EngineEvent*>(memoryLock.allocate(sizeof(EngineEvent)*kMaxEngineEventInternalCount));
+        CARLA_SAFE_ASSERT_RETURN(events.in != nullptr && events.out != nullptr, false);
         carla_zeroStructs(events.in,  kMaxEngineEventInternalCount);
         carla_zeroStructs(events.out, kMaxEngineEventInternalCount);
         break;
@@ -489,6 +512,10 @@ bool CarlaEngine::ProtectedData::init(const char* const clientName)
         break;
     }
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    cycleLog.init();
+#endif
+
     nextPluginId = maxPluginNumber;
 
     name = clientName;
@@ -505,8 +532,12 @@ bool CarlaEngine::ProtectedData::init(const char* const clientName)
     plugins = new EnginePluginData[maxPluginNumber];
     xruns = 0;
     dspLoad = 0.0f;
+    peaksBlock.init(maxPluginNumber);
 #endif
 
+    // detect CPU features for the buffer functions now, not in the first audio callback
+    carla_cpuHasAVX();
+
     nextAction.clearAndReset();
     thread.startThread();
 
@@ -537,6 +568,9 @@ void CarlaEngine::ProtectedData::close()
 
     deletePluginsAsNeeded();
 
+    // plugin libraries and clients must be gone once the engine is closed
+    pluginReaper.stop();
+
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     if (plugins != nullptr)
     {
@@ -546,6 +580,10 @@ void CarlaEngine::ProtectedData::close()
 #endif
 
     events.clear();
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    cycleLog.clear();
+    peaksBlock.clear();
+#endif
     name.clear();
 }
 
@@ -566,8 +604,57 @@ void CarlaEngine::ProtectedData::initTime(const char* const features)
 
 // -----------------------------------------------------------------------
 
+// embedded UIs and plugins hosted through JUCE or the VST2 API expect to be deleted from the main thread,
+// bridges only wait for their remote process so they are always fine
+static bool canDeletePluginInBackground(const CarlaPluginPtr& plugin) noexcept
+{
+    const uint hints = plugin->getHints();
+
+    if (hints & PLUGIN_IS_BRIDGE)
+        return true;
+
+    switch (plugin->getType())
+    {
+    case PLUGIN_VST2:
+    case PLUGIN_VST3:
+    case PLUGIN_AU:
+        return false;
+    default:
+        return (hints & PLUGIN_HAS_CUSTOM_UI) == 0;
+    }
+}
+
 void CarlaEngine::ProtectedData::deletePluginsAsNeeded()
 {
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    // replaced plugins are deleted like the others once no slot is crossfading from them anymore
+    for (std::vector<CarlaPluginPtr>::iterator it = pluginsFadingOut.begin(); it != pluginsFadingOut.end();)
+    {
+        bool fading = false;
+
+        for (uint i=0; i < curPluginCount; ++i)
+        {
+            if (plugins[i].fadingOut == it->get())
+            {
+                fading = true;
+                break;
+            }
+        }
+
+        if (fading)
+        {
+            ++it;
+            continue;
+        }
+
+        const CarlaPluginPtr plugin = *it;
+        it = pluginsFadingOut.erase(it);
+
+        plugin->prepareForDeletion();
+        pluginsToDelete.push_back(plugin);
+    }
+#endif
+
     for (bool stop;;)
     {
         stop = true;
@@ -577,7 +664,13 @@ void CarlaEngine::ProtectedData::deletePluginsAsNeeded()
             if (it->use_count() == 1)
             {
                 stop = false;
+
+                CarlaPluginPtr plugin;
+                plugin.swap(*it);
                 pluginsToDelete.erase(it);
+
+                if (! (canDeletePluginInBackground(plugin) && pluginReaper.add(plugin)))
+                    plugin.reset();
                 break;
             }
         }
@@ -605,13 +698,19 @@ void CarlaEngine::ProtectedData::doPluginRemove(const uint pluginId) noexcept
         plugin->setId(i);
 
         plugins[i].plugin = plugin;
+        plugins[i].processStats.requestReset();
         carla_zeroStruct(plugins[i].peaks);
     }
 
+    // crossfades do not follow the plugins around, the engine thread deletes the old instances
+    for (uint i=pluginId; i <= curPluginCount; ++i)
+        plugins[i].fadingOut = nullptr;
+
     const uint id = curPluginCount;
 
     // reset last plugin (now removed)
     plugins[id].plugin.reset();
+    plugins[id].processStats.requestReset();
     carla_zeroFloats(plugins[id].peaks, 4);
 }
 
@@ -630,9 +729,50 @@ void CarlaEngine::ProtectedData::doPluginsSwitch(const uint idA, const uint idB)
 
     pluginA->setId(idB);
     plugins[idA].plugin = pluginB;
+    plugins[idA].processStats.requestReset();
 
     pluginB->setId(idA);
     plugins[idB].plugin = pluginA;
+    plugins[idB].processStats.requestReset();
+
+    plugins[idA].fadingOut = nullptr;
+    plugins[idB].fadingOut = nullptr;
+}
+
+void CarlaEngine::ProtectedData::doParameterValuesSet() noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(stagedParameterValues != nullptr,);
+
+    for (uint i=0; i < stagedParameterValueCount; ++i)
+    {
+        const EngineStagedParameterValue& staged(stagedParameterValues[i]);
+        CARLA_SAFE_ASSERT_CONTINUE(staged.pluginId < curPluginCount);
+
+        const CarlaPluginPtr plugin = plugins[staged.pluginId].plugin;
+        CARLA_SAFE_ASSERT_CONTINUE(plugin.get() != nullptr);
+
+        // host is told about all values at once afterwards
+        plugin->setParameterValueRT(staged.parameterId, staged.value, false);
+    }
+}
+
+void CarlaEngine::ProtectedData::doPluginReplace(const uint pluginId, const uint32_t fadeFrames) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(pluginId < curPluginCount,);
+    CARLA_SAFE_ASSERT_RETURN(pluginToSwapIn.get() != nullptr,);
+
+    EnginePluginData& pluginData(plugins[pluginId]);
+
+    // the old plugin is still referenced by pluginsFadingOut, so this never deletes it
+    pluginData.fadingOut = pluginData.plugin.get();
+    pluginData.fadeFrames = fadeFrames;
+    pluginData.fadePos = 0;
+    pluginData.plugin = pluginToSwapIn;
+    pluginData.processStats.requestReset();
+
+    graph.swapStagedPlugin();
+
+    pluginToSwapIn.reset();
 }
 #endif
 
@@ -641,37 +781,41 @@ void CarlaEngine::ProtectedData::doNextPluginAction() noexcept
     if (! nextAction.mutex.tryLock())
         return;
 
-    const EnginePostAction opcode    = nextAction.opcode;
-    const bool             needsPost = nextAction.needsPost;
+    const bool needsPost = nextAction.needsPost;
+
+    for (uint i=0; i < nextAction.count; ++i)
+    {
+        const EngineNextAction::Action& action(nextAction.actions[i]);
+
+        switch (action.opcode)
+        {
+        case kEnginePostActionNull:
+            break;
+        case kEnginePostActionZeroCount:
+            curPluginCount = 0;
+            break;
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-    const uint             pluginId  = nextAction.pluginId;
-    const uint             value     = nextAction.value;
+        case kEnginePostActionRemovePlugin:
+            doPluginRemove(action.pluginId);
+            break;
+        case kEnginePostActionSwitchPlugins:
+            doPluginsSwitch(action.pluginId, action.value);
+            break;
+        case kEnginePostActionSetParameterValues:
+            doParameterValuesSet();
+            break;
+        case kEnginePostActionReplacePlugin:
+            doPluginReplace(action.pluginId, action.value);
+            break;
 #endif
+        }
+    }
 
-    nextAction.opcode    = kEnginePostActionNull;
-    nextAction.pluginId  = 0;
-    nextAction.value     = 0;
+    nextAction.count     = 0;
     nextAction.needsPost = false;
 
     nextAction.mutex.unlock();
 
-    switch (opcode)
-    {
-    case kEnginePostActionNull:
-        break;
-    case kEnginePostActionZeroCount:
-        curPluginCount = 0;
-        break;
-#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-    case kEnginePostActionRemovePlugin:
-        doPluginRemove(pluginId);
-        break;
-    case kEnginePostActionSwitchPlugins:
-        doPluginsSwitch(pluginId, value);
-        break;
-#endif
-    }
-
     if (needsPost)
     {
         if (nextAction.sem != nullptr)
@@ -681,45 +825,117 @@ void CarlaEngine::ProtectedData::doNextPluginAction() noexcept
 }
 
 // -----------------------------------------------------------------------
-// PendingRtEventsRunner
+// RT safety checks, only active when libcarla_interposer-rtcheck.so is preloaded
 
-static int64_t getTimeInMicroseconds() noexcept
-{
-#if defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN)
-    struct timeval tv;
-    gettimeofday(&tv, nullptr);
+#ifdef CARLA_OS_LINUX
+typedef const char* (*RtCheckEnterFunc)(const char*);
+typedef void (*RtCheckLeaveFunc)(const char*);
+
+static const struct RtCheckHooks {
+    RtCheckEnterFunc enter;
+    RtCheckLeaveFunc leave;
 
-    return (tv.tv_sec * 1000000) + tv.tv_usec;
+    RtCheckHooks() noexcept
+        : enter((RtCheckEnterFunc)::dlsym(RTLD_DEFAULT, "carla_interposer_rtcheck_enter")),
+          leave((RtCheckLeaveFunc)::dlsym(RTLD_DEFAULT, "carla_interposer_rtcheck_leave"))
+    {
+        if (enter == nullptr || leave == nullptr)
+            enter = nullptr;
+        else
+            carla_stdout("Carla RT check interposer found, audio thread calls will be checked");
+    }
+} sRtCheckHooks;
+#endif
+
+static inline
+const char* rtCheckEnter(const char* const context) noexcept
+{
+#ifdef CARLA_OS_LINUX
+    if (sRtCheckHooks.enter != nullptr)
+        return sRtCheckHooks.enter(context);
 #else
-    struct timespec ts;
-# ifdef CLOCK_MONOTONIC_RAW
-    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
-# else
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-# endif
+    // unused
+    (void)context;
+#endif
+    return nullptr;
+}
 
-    return (ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+static inline
+void rtCheckLeave(const char* const prevContext) noexcept
+{
+#ifdef CARLA_OS_LINUX
+    if (sRtCheckHooks.enter != nullptr)
+        sRtCheckHooks.leave(prevContext);
+#else
+    // unused
+    (void)prevContext;
 #endif
 }
 
+// -----------------------------------------------------------------------
+// PendingRtEventsRunner
+
+static inline
+uint32_t getUsecsBetween(const int64_t start, const int64_t end) noexcept
+{
+    if (end <= start)
+        return 0;
+
+    return end - start < static_cast<int64_t>(UINT32_MAX) ? static_cast<uint32_t>(end - start) : UINT32_MAX;
+}
+
 PendingRtEventsRunner::PendingRtEventsRunner(CarlaEngine* const engine,
                                              const uint32_t frames,
                                              const bool calcDSPLoad) noexcept
     : pData(engine->pData),
-      prevTime(calcDSPLoad ? getTimeInMicroseconds() : 0)
+      numFrames(frames),
+      startTime(carla_gettime_us()),
+      processStartTime(0),
+      prevTime(calcDSPLoad ? startTime : 0),
+      prevRtCheckContext(rtCheckEnter("engine")),
+      flushDenormals(pData->options.flushDenormals),
+      prevFloatControl(flushDenormals ? carla_setDenormalsFlushed(true) : 0)
 {
     pData->time.preProcess(frames);
+
+#if defined(HAVE_LIBLO) && !defined(BUILD_BRIDGE)
+    pData->osc.runPendingRtMessages();
+#endif
+
+    processStartTime = carla_gettime_us();
 }
 
 PendingRtEventsRunner::~PendingRtEventsRunner() noexcept
 {
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    const int64_t processEndTime = carla_gettime_us();
+#endif
+
     pData->doNextPluginAction();
 
+    rtCheckLeave(prevRtCheckContext);
+
+    // the host thread might not expect flushed denormals (e.g. engine running as a plugin)
+    if (flushDenormals)
+        carla_restoreFloatControl(prevFloatControl);
+
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    const int64_t newTime = carla_gettime_us();
+
+    EngineCycleRecord record;
+    record.startTime    = startTime;
+    record.frames       = numFrames;
+    record.totalUsecs   = getUsecsBetween(startTime, newTime);
+    record.prepareUsecs = getUsecsBetween(startTime, processStartTime);
+    record.processUsecs = getUsecsBetween(processStartTime, processEndTime);
+    record.postUsecs    = getUsecsBetween(processEndTime, newTime);
+    record.xruns        = pData->xruns;
+    pData->cycleLog.write(record);
+
+    pData->peaksBlock.publish(pData->plugins, pData->curPluginCount);
+
     if (prevTime > 0)
     {
-        const int64_t newTime = getTimeInMicroseconds();
-
         if (newTime < prevTime)
             return;
 
@@ -736,119 +952,1201 @@ PendingRtEventsRunner::~PendingRtEventsRunner() noexcept
 }
 
 // -----------------------------------------------------------------------
-// ScopedActionLock
+// EnginePeaksBlock
 
-ScopedActionLock::ScopedActionLock(CarlaEngine* const engine,
-                                   const EnginePostAction action,
-                                   const uint pluginId,
-                                   const uint value) noexcept
-    : pData(engine->pData)
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+// readers give up waiting for a consistent copy after this, taking whatever they got
+static const uint kPeaksBlockReadTries = 16;
+
+EnginePeaksBlock::EnginePeaksBlock() noexcept
+    : peaks(nullptr),
+      maxCount(0),
+      count(0),
+      sequence(0),
+      published(false) {}
+
+EnginePeaksBlock::~EnginePeaksBlock() noexcept
 {
-    CARLA_SAFE_ASSERT_RETURN(action != kEnginePostActionNull,);
+    CARLA_SAFE_ASSERT(peaks == nullptr);
+}
 
-    {
-        const CarlaMutexLocker cml(pData->nextAction.mutex);
+void EnginePeaksBlock::init(const uint maxPluginNumber)
+{
+    CARLA_SAFE_ASSERT_RETURN(peaks == nullptr,);
 
-        CARLA_SAFE_ASSERT_RETURN(pData->nextAction.opcode == kEnginePostActionNull,);
+    peaks = new float[maxPluginNumber*4];
+    carla_zeroFloats(peaks, maxPluginNumber*4);
 
-        pData->nextAction.opcode    = action;
-        pData->nextAction.pluginId  = pluginId;
-        pData->nextAction.value     = value;
-        pData->nextAction.needsPost = engine->isRunning();
-        pData->nextAction.postDone  = false;
-    }
+    maxCount  = maxPluginNumber;
+    count     = 0;
+    sequence  = 0;
+    published = false;
+}
 
-   #ifdef BUILD_BRIDGE
-    #define ACTION_MSG_PREFIX "Bridge: "
-   #else
-    #define ACTION_MSG_PREFIX ""
-   #endif
+void EnginePeaksBlock::clear() noexcept
+{
+    published = false;
+    maxCount  = 0;
+    count     = 0;
 
-    if (pData->nextAction.needsPost)
-    {
-       #if defined(DEBUG) || defined(BUILD_BRIDGE)
-        // block wait for unlock on processing side
-        carla_stdout(ACTION_MSG_PREFIX "ScopedPluginAction(%i) - blocking START", pluginId);
-       #endif
+    delete[] peaks;
+    peaks = nullptr;
+}
 
-        bool engineStoppedWhileWaiting = false;
+void EnginePeaksBlock::publish(const EnginePluginData* const plugins, uint pluginCount) noexcept
+{
+    if (peaks == nullptr)
+        return;
 
-        if (! pData->nextAction.postDone)
-        {
-            for (int i = 10; --i >= 0;)
-            {
-                if (pData->nextAction.sem != nullptr)
-                {
-                    if (carla_sem_timedwait(*pData->nextAction.sem, 200))
-                        break;
-                }
-                else
-                {
-                    carla_msleep(200);
-                }
+    if (pluginCount > maxCount)
+        pluginCount = maxCount;
 
-                if (! engine->isRunning())
-                {
-                    engineStoppedWhileWaiting = true;
-                    break;
-                }
-            }
-        }
+    __sync_add_and_fetch(&sequence, 1);
 
-       #if defined(DEBUG) || defined(BUILD_BRIDGE)
-        carla_stdout(ACTION_MSG_PREFIX "ScopedPluginAction(%i) - blocking DONE", pluginId);
-       #endif
+    for (uint i=0; i < pluginCount; ++i)
+        carla_copyFloats(peaks + i*4, plugins[i].peaks, 4);
 
-        // check if anything went wrong...
-        if (! pData->nextAction.postDone)
-        {
-            bool needsCorrection = false;
+    count = pluginCount;
 
-            {
-                const CarlaMutexLocker cml(pData->nextAction.mutex);
+    __sync_add_and_fetch(&sequence, 1);
+    published = true;
+}
 
-                if (pData->nextAction.opcode != kEnginePostActionNull)
-                {
-                    needsCorrection = true;
-                    pData->nextAction.needsPost = false;
-                }
-            }
+int EnginePeaksBlock::read(float* const peaksOut, const uint maxPlugins) const noexcept
+{
+    if (! published || peaks == nullptr)
+        return -1;
 
-            if (needsCorrection)
-            {
-                pData->doNextPluginAction();
+    uint copied = 0;
 
-                if (! engineStoppedWhileWaiting)
-                    carla_stderr2(ACTION_MSG_PREFIX "Failed to wait for engine, is audio not running?");
-            }
-        }
-    }
-    else
+    for (uint i=0; i < kPeaksBlockReadTries; ++i)
     {
-        pData->doNextPluginAction();
+        const uint32_t seq = sequence;
+        __sync_synchronize();
+
+        if (seq & 1)
+            continue;
+
+        copied = std::min(count, maxPlugins);
+        std::memcpy(peaksOut, peaks, sizeof(float)*4*copied);
+
+        __sync_synchronize();
+
+        if (sequence == seq)
+            break;
     }
+
+    return static_cast<int>(copied);
 }
+#endif
 
-ScopedActionLock::~ScopedActionLock() noexcept
+// -----------------------------------------------------------------------
+// EngineInternalCycleLog
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+// number of cycles printed before and after the one where an xrun was noticed
+static const uint kCycleLogDumpBefore = 24;
+static const uint kCycleLogDumpAfter  = 4;
+
+EngineInternalCycleLog::EngineInternalCycleLog() noexcept
+    : records(nullptr),
+      writeCount(0),
+      lastXruns(0),
+      lastDumpTime(0) {}
+
+EngineInternalCycleLog::~EngineInternalCycleLog() noexcept
 {
-    CARLA_SAFE_ASSERT(pData->nextAction.opcode == kEnginePostActionNull);
+    CARLA_SAFE_ASSERT(records == nullptr);
 }
 
-// -----------------------------------------------------------------------
-// ScopedThreadStopper
+void EngineInternalCycleLog::init()
+{
+    CARLA_SAFE_ASSERT_RETURN(records == nullptr,);
 
-ScopedThreadStopper::ScopedThreadStopper(CarlaEngine* const e) noexcept
-    : engine(e),
-      pData(e->pData)
+    records = new EngineCycleRecord[kMaxRecords];
+    carla_zeroStructs(records, kMaxRecords);
+
+    writeCount = 0;
+    lastXruns = 0;
+    lastDumpTime = 0;
+}
+
+void EngineInternalCycleLog::clear() noexcept
 {
-    pData->thread.stopThread(500);
+    if (records != nullptr)
+    {
+        delete[] records;
+        records = nullptr;
+    }
+
+    writeCount = 0;
 }
 
-ScopedThreadStopper::~ScopedThreadStopper() noexcept
+void EngineInternalCycleLog::write(const EngineCycleRecord& record) noexcept
 {
-    if (engine->isRunning() && ! pData->aboutToClose)
-        pData->thread.startThread();
+    if (records == nullptr)
+        return;
+
+    const uint64_t index = writeCount;
+    records[index & (kMaxRecords - 1)] = record;
+
+    __sync_synchronize();
+    writeCount = index + 1;
+}
+
+uint EngineInternalCycleLog::read(EngineCycleRecord* const out, const uint maxCount) const noexcept
+{
+    if (records == nullptr || maxCount == 0)
+        return 0;
+
+    const uint64_t endIndex = writeCount;
+    __sync_synchronize();
+
+    uint64_t available = maxCount < kMaxRecords ? maxCount : kMaxRecords;
+
+    if (available > endIndex)
+        available = endIndex;
+
+    const uint64_t startIndex = endIndex - available;
+
+    for (uint64_t i = startIndex; i < endIndex; ++i)
+        out[i - startIndex] = records[i & (kMaxRecords - 1)];
+
+    // anything the writer reached while we were copying cannot be trusted, including the record in progress
+    __sync_synchronize();
+    const uint64_t newEndIndex = writeCount + 1;
+
+    if (newEndIndex <= startIndex + kMaxRecords)
+        return static_cast<uint>(available);
+
+    const uint64_t skipped = std::min<uint64_t>(newEndIndex - kMaxRecords - startIndex, available);
+    const uint count = static_cast<uint>(available - skipped);
+
+    std::memmove(out, out + skipped, sizeof(EngineCycleRecord)*count);
+    return count;
+}
+
+void EngineInternalCycleLog::dumpOnXrun(const uint32_t xruns, const double sampleRate)
+{
+    if (xruns == lastXruns)
+        return;
+
+    const uint32_t prevXruns = lastXruns;
+    lastXruns = xruns;
+
+    // xruns got cleared
+    if (xruns < prevXruns)
+        return;
+
+    // at most once per second, a struggling system could fill the log otherwise
+    const int64_t now = carla_gettime_us();
+
+    if (lastDumpTime != 0 && now - lastDumpTime < 1000000)
+        return;
+
+    lastDumpTime = now;
+
+    EngineCycleRecord cycles[kCycleLogDumpBefore*4];
+    const uint count = read(cycles, kCycleLogDumpBefore*4);
+
+    if (count == 0)
+        return;
+
+    // drivers report xruns after the fact, find the first cycle which saw the new count
+    uint xrunIndex = count - 1;
+
+    for (uint i=0; i < count; ++i)
+    {
+        if (cycles[i].xruns > prevXruns)
+        {
+            xrunIndex = i;
+            break;
+        }
+    }
+
+    const uint first = xrunIndex > kCycleLogDumpBefore ? xrunIndex - kCycleLogDumpBefore : 0;
+    const uint last  = std::min(count, xrunIndex + kCycleLogDumpAfter + 1);
+
+    carla_stdout("Xrun #%u, timings of the engine cycles around it, relative to the first cycle that noticed it:",
+                 xruns);
+
+    for (uint i=first; i < last; ++i)
+    {
+        const EngineCycleRecord& cycle(cycles[i]);
+        const double budgetUsecs = sampleRate > 0.0 ? cycle.frames * 1000000.0 / sampleRate : 0.0;
+        const int load = budgetUsecs > 0.0 ? static_cast<int>(cycle.totalUsecs * 100.0 / budgetUsecs + 0.5) : 0;
+
+        carla_stdout("  %+9.3f ms, %4u frames, %6u us total (%3i%%): prepare %u, process %u, post %u%s",
+                     static_cast<double>(cycle.startTime - cycles[xrunIndex].startTime) / 1000.0,
+                     cycle.frames, cycle.totalUsecs, load,
+                     cycle.prepareUsecs, cycle.processUsecs, cycle.postUsecs,
+                     i == xrunIndex ? " <- xrun" : "");
+    }
 }
+#endif
+
+// -----------------------------------------------------------------------
+// EngineCallbackQueue
+
+EngineCallbackQueue::EngineCallbackQueue() noexcept
+    : mutex(),
+      callbacks(),
+      valueChanges() {}
+
+void EngineCallbackQueue::append(const EngineCallbackOpcode action, const uint pluginId,
+                                 const int value1, const int value2, const int value3,
+                                 const float valuef, const char* const valueStr) noexcept
+{
+    const CarlaMutexLocker cml(mutex);
+
+    try {
+        if (action == ENGINE_CALLBACK_PARAMETER_VALUE_CHANGED)
+        {
+            const uint64_t key = (static_cast<uint64_t>(pluginId) << 32) | static_cast<uint32_t>(value1);
+            const std::map<uint64_t, std::size_t>::iterator it = valueChanges.find(key);
+
+            if (it != valueChanges.end())
+            {
+                callbacks[it->second].valuef = valuef;
+                return;
+            }
+
+            valueChanges[key] = callbacks.size();
+        }
+        else
+        {
+            // keep the order of value changes relative to everything else
+            valueChanges.clear();
+        }
+
+        Callback cb;
+        cb.action = action;
+        cb.pluginId = pluginId;
+        cb.value1 = value1;
+        cb.value2 = value2;
+        cb.value3 = value3;
+        cb.valuef = valuef;
+        cb.hasValueStr = valueStr != nullptr;
+        cb.valueStr = valueStr;
+
+        callbacks.push_back(cb);
+    } CARLA_SAFE_EXCEPTION("EngineCallbackQueue::append");
+}
+
+void EngineCallbackQueue::dispatch(const EngineCallbackFunc func, void* const ptr) noexcept
+{
+    std::vector<Callback> queued;
+
+    {
+        const CarlaMutexLocker cml(mutex);
+
+        if (callbacks.empty())
+            return;
+
+        queued.swap(callbacks);
+        valueChanges.clear();
+    }
+
+    if (func == nullptr)
+        return;
+
+    for (std::vector<Callback>::const_iterator it = queued.begin(); it != queued.end(); ++it)
+    {
+        const Callback& cb(*it);
+
+        try {
+            func(ptr, cb.action, cb.pluginId, cb.value1, cb.value2, cb.value3, cb.valuef,
+                 cb.hasValueStr ? cb.valueStr.buffer() : nullptr);
+        } CARLA_SAFE_EXCEPTION("callback");
+    }
+}
+
+// -----------------------------------------------------------------------
+// EnginePluginReaper
+
+EnginePluginReaper::Worker::Worker(EnginePluginReaper& reaper) noexcept
+    : CarlaThread("CarlaEnginePluginReaper"),
+      kReaper(reaper) {}
+
+void EnginePluginReaper::Worker::run() noexcept
+{
+    for (; ! shouldThreadExit();)
+    {
+        if (! carla_sem_timedwait(kReaper.sem, 100))
+            continue;
+
+        CarlaPluginPtr plugin;
+
+        {
+            const CarlaMutexLocker cml(kReaper.mutex);
+
+            if (kReaper.plugins.empty())
+                continue;
+
+            plugin.swap(kReaper.plugins.back());
+            kReaper.plugins.pop_back();
+        }
+
+        try {
+            plugin.reset();
+        } CARLA_SAFE_EXCEPTION("EnginePluginReaper delete");
+
+        __sync_sub_and_fetch(&kReaper.pending, 1);
+    }
+}
+
+EnginePluginReaper::EnginePluginReaper() noexcept
+    : mutex(),
+      plugins(),
+      sem(),
+      semValid(false),
+      pending(0)
+{
+    carla_zeroPointers(workers, kNumWorkers);
+}
+
+EnginePluginReaper::~EnginePluginReaper() noexcept
+{
+    stop();
+}
+
+bool EnginePluginReaper::add(CarlaPluginPtr& plugin)
+{
+    CARLA_SAFE_ASSERT_RETURN(plugin.get() != nullptr, false);
+
+    if (workers[0] == nullptr)
+    {
+        if (! semValid)
+        {
+            semValid = carla_sem_create2(sem, false);
+            CARLA_SAFE_ASSERT_RETURN(semValid, false);
+        }
+
+        for (uint i=0; i < kNumWorkers; ++i)
+        {
+            Worker* const worker = new Worker(*this);
+
+            if (! worker->startThread())
+            {
+                delete worker;
+                break;
+            }
+
+            workers[i] = worker;
+        }
+
+        if (workers[0] == nullptr)
+            return false;
+    }
+
+    __sync_add_and_fetch(&pending, 1);
+
+    {
+        const CarlaMutexLocker cml(mutex);
+        plugins.push_back(CarlaPluginPtr());
+        plugins.back().swap(plugin);
+    }
+
+    carla_sem_post(sem);
+    return true;
+}
+
+void EnginePluginReaper::stop() noexcept
+{
+    if (workers[0] == nullptr)
+        return;
+
+    while (__sync_fetch_and_add(&pending, 0) != 0)
+        carla_msleep(5);
+
+    for (uint i=0; i < kNumWorkers; ++i)
+    {
+        if (workers[i] == nullptr)
+            continue;
+
+        workers[i]->stopThread(-1);
+        delete workers[i];
+        workers[i] = nullptr;
+    }
+
+    if (semValid)
+    {
+        carla_sem_destroy2(sem);
+        semValid = false;
+    }
+}
+
+// -----------------------------------------------------------------------
+// EnginePluginLoader
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+static const char* getNullIfEmpty(const CarlaString& string) noexcept
+{
+    return string.isNotEmpty() ? string.buffer() : nullptr;
+}
+
+EnginePluginLoader::Request::Request() noexcept
+    : requestId(0),
+      btype(BINARY_NONE),
+      ptype(PLUGIN_NONE),
+      provisionalId(0),
+      filename(),
+      name(),
+      label(),
+      uniqueId(0),
+      use16Outs(false),
+      options(0),
+      started(false),
+      finished(false),
+      plugin(),
+      error(),
+      startReported(false) {}
+
+EnginePluginLoader::Worker::Worker(EnginePluginLoader& loader) noexcept
+    : CarlaThread("CarlaEnginePluginLoader"),
+      kLoader(loader) {}
+
+void EnginePluginLoader::Worker::run() noexcept
+{
+    for (; ! shouldThreadExit();)
+    {
+        if (! carla_sem_timedwait(kLoader.sem, 100))
+            continue;
+
+        Request* request = nullptr;
+
+        {
+            const CarlaMutexLocker cml(kLoader.mutex);
+
+            for (std::vector<Request*>::iterator it = kLoader.requests.begin(); it != kLoader.requests.end(); ++it)
+            {
+                if ((*it)->started)
+                    continue;
+
+                request = *it;
+                request->started = true;
+                break;
+            }
+        }
+
+        if (request == nullptr)
+            continue;
+
+        CarlaPluginPtr plugin;
+        kLoader.workerError.clear();
+
+        try {
+            plugin = kLoader.kEngine.createPlugin(request->btype, request->ptype, request->provisionalId,
+                                                  getNullIfEmpty(request->filename),
+                                                  getNullIfEmpty(request->name),
+                                                  getNullIfEmpty(request->label),
+                                                  request->uniqueId,
+                                                  request->use16Outs ? "true" : nullptr,
+                                                  request->options);
+        } CARLA_SAFE_EXCEPTION("EnginePluginLoader createPlugin");
+
+        const CarlaMutexLocker cml(kLoader.mutex);
+
+        if (plugin.get() != nullptr)
+            request->plugin = plugin;
+        else
+            request->error = kLoader.workerError;
+
+        request->finished = true;
+    }
+}
+
+EnginePluginLoader::EnginePluginLoader(CarlaEngine& engine) noexcept
+    : kEngine(engine),
+      mutex(),
+      requests(),
+      sem(),
+      semValid(false),
+      lastRequestId(0),
+      worker(nullptr),
+      workerError() {}
+
+EnginePluginLoader::~EnginePluginLoader() noexcept
+{
+    stop();
+}
+
+uint EnginePluginLoader::getNextRequestId() noexcept
+{
+    if (++lastRequestId == 0)
+        ++lastRequestId;
+
+    return lastRequestId;
+}
+
+uint EnginePluginLoader::add(const BinaryType btype, const PluginType ptype, const uint provisionalId,
+                             const char* const filename, const char* const name, const char* const label,
+                             const int64_t uniqueId, const bool use16Outs, const uint options)
+{
+    if (worker == nullptr)
+    {
+        if (! semValid)
+        {
+            semValid = carla_sem_create2(sem, false);
+            CARLA_SAFE_ASSERT_RETURN(semValid, 0);
+        }
+
+        Worker* const newWorker = new Worker(*this);
+
+        if (! newWorker->startThread())
+        {
+            delete newWorker;
+            return 0;
+        }
+
+        worker = newWorker;
+    }
+
+    Request* const request = new Request();
+    request->requestId     = getNextRequestId();
+    request->btype         = btype;
+    request->ptype         = ptype;
+    request->provisionalId = provisionalId;
+    request->filename      = filename;
+    request->name          = name;
+    request->label         = label;
+    request->uniqueId      = uniqueId;
+    request->use16Outs     = use16Outs;
+    request->options       = options;
+
+    {
+        const CarlaMutexLocker cml(mutex);
+        requests.push_back(request);
+    }
+
+    carla_sem_post(sem);
+    return request->requestId;
+}
+
+static const char* getRequestDisplayName(const EnginePluginLoader::Request* const request) noexcept
+{
+    if (const char* const name = getNullIfEmpty(request->name))
+        return name;
+
+    return request->label.isNotEmpty() ? request->label.buffer() : request->filename.buffer();
+}
+
+void EnginePluginLoader::idle()
+{
+    // plugins are added as if loaded after the project, not in the middle of it
+    const bool canInsert = ! kEngine.pData->loadingProject;
+
+    std::vector<Request*> startedRequests, finishedRequests;
+
+    // the worker walks the same list, only take out what needs reporting while locked
+    {
+        const CarlaMutexLocker cml(mutex);
+
+        for (std::vector<Request*>::iterator it = requests.begin(); it != requests.end();)
+        {
+            Request* const request = *it;
+
+            if (request->started && ! request->startReported)
+            {
+                request->startReported = true;
+                startedRequests.push_back(request);
+            }
+
+            if (request->finished && canInsert)
+            {
+                finishedRequests.push_back(request);
+                it = requests.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    // names are never changed after a request is added, no need to lock for them
+    for (std::vector<Request*>::iterator it = startedRequests.begin(); it != startedRequests.end(); ++it)
+    {
+        const Request* const request = *it;
+
+        kEngine.callback(true, true, ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS, 0,
+                         static_cast<int>(request->requestId), 1, 0, 0.0f, getRequestDisplayName(request));
+    }
+
+    // a finished request is no longer touched by the worker
+    for (std::vector<Request*>::iterator it = finishedRequests.begin(); it != finishedRequests.end(); ++it)
+    {
+        Request* const request = *it;
+        const char* const displayName = getRequestDisplayName(request);
+
+        if (request->plugin.get() != nullptr && insertPlugin(request->plugin))
+        {
+            kEngine.callback(true, true, ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS, request->plugin->getId(),
+                             static_cast<int>(request->requestId), 2, 0, 0.0f, displayName);
+        }
+        else
+        {
+            if (request->plugin.get() != nullptr)
+                request->error = kEngine.getLastError();
+            if (request->error.isEmpty())
+                request->error = "Failed to load plugin";
+
+            kEngine.callback(true, true, ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS, 0,
+                             static_cast<int>(request->requestId), -1, 0, 0.0f, request->error);
+        }
+
+        delete request;
+    }
+}
+
+bool EnginePluginLoader::isWorkerThread() const noexcept
+{
+    // 'worker' is set before any request is posted to it, and only reset once it stopped
+    return worker != nullptr && pthread_equal(worker->getThreadId(), pthread_self()) != 0;
+}
+
+void EnginePluginLoader::stop() noexcept
+{
+    if (worker != nullptr)
+    {
+        worker->stopThread(-1);
+        delete worker;
+        worker = nullptr;
+    }
+
+    for (std::vector<Request*>::iterator it = requests.begin(); it != requests.end(); ++it)
+        delete *it;
+
+    requests.clear();
+
+    if (semValid)
+    {
+        carla_sem_destroy2(sem);
+        semValid = false;
+    }
+}
+
+bool EnginePluginLoader::insertPlugin(const CarlaPluginPtr plugin)
+{
+    CarlaEngine::ProtectedData* const pData = kEngine.pData;
+
+    if (pData->curPluginCount >= pData->maxPluginNumber)
+    {
+        kEngine.setLastError("Maximum number of plugins reached");
+        return false;
+    }
+
+    const uint id = pData->curPluginCount;
+
+    if (pData->plugins[id].plugin.get() != nullptr)
+    {
+        kEngine.setLastError("Invalid engine internal data");
+        return false;
+    }
+
+    plugin->setId(id);
+
+    /* NOTE: The following code is the same as the end of CarlaEngine::addPlugin(). */
+    EnginePluginData& pluginData(pData->plugins[id]);
+    pluginData.plugin = plugin;
+    pluginData.peaksEnabled = true;
+    pluginData.processStats.requestReset();
+    carla_zeroFloats(pluginData.peaks, 4);
+
+    plugin->setEnabled(true);
+
+    ++pData->curPluginCount;
+    kEngine.callback(true, true, ENGINE_CALLBACK_PLUGIN_ADDED, id, 0, 0, 0, 0.0f, plugin->getName());
+
+    plugin->setActive(true, true, true);
+
+    if (pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
+        pData->graph.addPlugin(plugin);
+
+    return true;
+}
+#endif
+
+// -----------------------------------------------------------------------
+// EnginePreloadedProject
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+EnginePreloadedProject::EnginePreloadedProject() noexcept
+    : loading(false),
+      plugins(),
+      names(),
+      bpm(0.0) {}
+
+void EnginePreloadedProject::add(const CarlaPluginPtr plugin, const char* const name)
+{
+    CARLA_SAFE_ASSERT_RETURN(plugin.get() != nullptr,);
+
+    plugins.push_back(plugin);
+    names.push_back(name != nullptr ? name : plugin->getName());
+}
+
+void EnginePreloadedProject::clear() noexcept
+{
+    loading = false;
+    plugins.clear();
+    names.clear();
+    bpm = 0.0;
+}
+
+std::vector<uint> EnginePreloadedProject::getLoadedPluginIds(const EnginePluginData* const enginePlugins,
+                                                             const uint curPluginCount) const
+{
+    std::vector<uint> ids;
+
+    for (std::size_t i=0, count=plugins.size(); i < count; ++i)
+    {
+        const uint id = plugins[i]->getId();
+
+        if (id < curPluginCount && enginePlugins[id].plugin == plugins[i])
+            ids.push_back(id);
+    }
+
+    return ids;
+}
+#endif
+
+// -----------------------------------------------------------------------
+// EnginePatchbaySnapshot
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+// ASCII unit and record separators, not expected in client or port names
+static const char kPatchbaySnapshotFieldSeparator  = '\x1f';
+static const char kPatchbaySnapshotRecordSeparator = '\x1e';
+
+EnginePatchbaySnapshot::EnginePatchbaySnapshot() noexcept
+    : collecting(false),
+      count(0),
+      data() {}
+
+void EnginePatchbaySnapshot::begin() noexcept
+{
+    CARLA_SAFE_ASSERT(! collecting);
+
+    collecting = true;
+    count = 0;
+    data.clear();
+}
+
+const char* EnginePatchbaySnapshot::end() noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(collecting, nullptr);
+
+    collecting = false;
+
+    try {
+        data.push_back('\0');
+    } CARLA_SAFE_EXCEPTION_RETURN("EnginePatchbaySnapshot::end", nullptr);
+
+    return &data[0];
+}
+
+bool EnginePatchbaySnapshot::add(const EngineCallbackOpcode action, const uint pluginId,
+                                 const int value1, const int value2, const int value3,
+                                 const float valuef, const char* const valueStr) noexcept
+{
+    if (! collecting)
+        return false;
+
+    switch (action)
+    {
+    case ENGINE_CALLBACK_PATCHBAY_CLIENT_ADDED:
+    case ENGINE_CALLBACK_PATCHBAY_CLIENT_REMOVED:
+    case ENGINE_CALLBACK_PATCHBAY_CLIENT_RENAMED:
+    case ENGINE_CALLBACK_PATCHBAY_CLIENT_DATA_CHANGED:
+    case ENGINE_CALLBACK_PATCHBAY_CLIENT_POSITION_CHANGED:
+    case ENGINE_CALLBACK_PATCHBAY_PORT_ADDED:
+    case ENGINE_CALLBACK_PATCHBAY_PORT_REMOVED:
+    case ENGINE_CALLBACK_PATCHBAY_PORT_CHANGED:
+    case ENGINE_CALLBACK_PATCHBAY_PORT_GROUP_ADDED:
+    case ENGINE_CALLBACK_PATCHBAY_PORT_GROUP_REMOVED:
+    case ENGINE_CALLBACK_PATCHBAY_PORT_GROUP_CHANGED:
+    case ENGINE_CALLBACK_PATCHBAY_CONNECTION_ADDED:
+    case ENGINE_CALLBACK_PATCHBAY_CONNECTION_REMOVED:
+        break;
+    default:
+        return false;
+    }
+
+    char numBuf[STR_MAX+1];
+    const int numLen = std::snprintf(numBuf, STR_MAX, "%i%c%u%c%i%c%i%c%i%c%f%c",
+                                     static_cast<int>(action), kPatchbaySnapshotFieldSeparator,
+                                     pluginId, kPatchbaySnapshotFieldSeparator,
+                                     value1, kPatchbaySnapshotFieldSeparator,
+                                     value2, kPatchbaySnapshotFieldSeparator,
+                                     value3, kPatchbaySnapshotFieldSeparator,
+                                     static_cast<double>(valuef), kPatchbaySnapshotFieldSeparator);
+    CARLA_SAFE_ASSERT_RETURN(numLen > 0 && numLen < STR_MAX, true);
+
+    try {
+        data.insert(data.end(), numBuf, numBuf + numLen);
+
+        if (valueStr != nullptr)
+            data.insert(data.end(), valueStr, valueStr + std::strlen(valueStr));
+
+        data.push_back(kPatchbaySnapshotRecordSeparator);
+    } CARLA_SAFE_EXCEPTION_RETURN("EnginePatchbaySnapshot::add", true);
+
+    ++count;
+    return true;
+}
+#endif
+
+// -----------------------------------------------------------------------
+// EnginePluginProcessStats
+
+static inline
+uint getProcessStatsBucketIndex(const uint32_t ns) noexcept
+{
+    if (ns < 4)
+        return ns;
+
+    // 4 sub-divisions per power of 2
+    const uint msb = 31U - static_cast<uint>(__builtin_clz(ns));
+    return msb * 4U + ((ns >> (msb - 2U)) & 3U);
+}
+
+static inline
+uint32_t getProcessStatsBucketValue(const uint index) noexcept
+{
+    if (index < 4)
+        return index;
+
+    const uint msb = index / 4U;
+    const uint32_t width = 1U << (msb - 2U);
+
+    // middle of the bucket range
+    return (4U + (index & 3U)) * width + width / 2U;
+}
+
+EnginePluginProcessStats::EnginePluginProcessStats() noexcept
+    : count(0),
+      subBlocks(0),
+      totalNs(0),
+      minNs(0),
+      maxNs(0),
+      buckets(),
+      resetPending(false)
+{
+    carla_zeroStructs(const_cast<uint32_t*>(buckets), kNumBuckets);
+}
+
+void EnginePluginProcessStats::record(const uint32_t ns, const uint32_t extraSubBlocks) noexcept
+{
+    if (resetPending)
+    {
+        resetPending = false;
+        count = 0;
+        subBlocks = 0;
+        totalNs = 0;
+        carla_zeroStructs(const_cast<uint32_t*>(buckets), kNumBuckets);
+    }
+
+    if (count == 0 || ns < minNs)
+        minNs = ns;
+    if (ns > maxNs || count == 0)
+        maxNs = ns;
+
+    totalNs += ns;
+    subBlocks += 1 + extraSubBlocks;
+    ++buckets[getProcessStatsBucketIndex(ns)];
+    ++count;
+}
+
+EnginePluginProcessTimeInfo EnginePluginProcessStats::getInfo() const noexcept
+{
+    EnginePluginProcessTimeInfo info;
+    carla_zeroStruct(info);
+
+    const uint64_t numCalls = count;
+
+    if (numCalls == 0 || resetPending)
+        return info;
+
+    info.count    = numCalls;
+    info.minUsecs = static_cast<float>(minNs) / 1000.0f;
+    info.maxUsecs = static_cast<float>(maxNs) / 1000.0f;
+    info.avgUsecs = static_cast<float>(static_cast<double>(totalNs) / static_cast<double>(numCalls) / 1000.0);
+    info.avgSubBlocks = static_cast<float>(static_cast<double>(subBlocks) / static_cast<double>(numCalls));
+
+    // first bucket where 99% of the calls are accounted for
+    const uint64_t target = numCalls - numCalls / 100;
+    uint64_t accumulated = 0;
+
+    for (uint i=0; i < kNumBuckets; ++i)
+    {
+        accumulated += buckets[i];
+
+        if (accumulated >= target)
+        {
+            const uint32_t value = std::min(std::max(getProcessStatsBucketValue(i), static_cast<uint32_t>(minNs)),
+                                            static_cast<uint32_t>(maxNs));
+            info.p99Usecs = static_cast<float>(value) / 1000.0f;
+            break;
+        }
+    }
+
+    return info;
+}
+
+// -----------------------------------------------------------------------
+// EnginePluginData
+
+void EnginePluginData::mixCrossfade(float* const* const outs, const float* const* const fadeOuts,
+                                    const uint32_t numChannels, const uint32_t frames) noexcept
+{
+    const uint32_t pos   = fadePos;
+    const uint32_t total = fadeFrames;
+
+    if (pos < total)
+    {
+        // linear, matching the engine output fades
+        const float step = 1.0f / static_cast<float>(total);
+
+        for (uint32_t c=0; c < numChannels; ++c)
+        {
+            float* const out = outs[c];
+            const float* const fadeOut = fadeOuts[c];
+
+            for (uint32_t i=0; i < frames; ++i)
+            {
+                const float gain = pos + i < total ? static_cast<float>(pos + i) * step : 1.0f;
+                out[i] = out[i] * gain + fadeOut[i] * (1.0f - gain);
+            }
+        }
+    }
+
+    if (pos + frames < total)
+    {
+        fadePos = pos + frames;
+        return;
+    }
+
+    fadePos = total;
+    fadingOut = nullptr;
+}
+
+// -----------------------------------------------------------------------
+// ScopedPluginProcessTimer
+
+ScopedPluginProcessTimer::ScopedPluginProcessTimer(EnginePluginProcessStats& stats,
+                                                   CarlaPlugin* const plugin) noexcept
+    : fStats(stats),
+      fPlugin(plugin),
+      fPrevRtCheckContext(rtCheckEnter(plugin->getName())),
+      fStartTime(carla_gettime_ns()) {}
+
+ScopedPluginProcessTimer::~ScopedPluginProcessTimer() noexcept
+{
+    const int64_t timeDiff = carla_gettime_ns() - fStartTime;
+
+    rtCheckLeave(fPrevRtCheckContext);
+
+    if (timeDiff < 0)
+        return;
+
+    fStats.record(timeDiff < static_cast<int64_t>(UINT32_MAX) ? static_cast<uint32_t>(timeDiff) : UINT32_MAX,
+                  fPlugin->takeEventSplitCount());
+}
+
+// -----------------------------------------------------------------------
+// ScopedPluginDenormals
+
+ScopedPluginDenormals::ScopedPluginDenormals(const uint pluginOptions) noexcept
+    : fKeepDenormals((pluginOptions & PLUGIN_OPTION_KEEP_DENORMALS) != 0),
+      fPrevFloatControl(fKeepDenormals ? carla_setDenormalsFlushed(false) : 0) {}
+
+ScopedPluginDenormals::~ScopedPluginDenormals() noexcept
+{
+    if (fKeepDenormals)
+        carla_restoreFloatControl(fPrevFloatControl);
+}
+
+// -----------------------------------------------------------------------
+// ScopedActionLock
+
+ScopedActionLock::ScopedActionLock(CarlaEngine* const engine,
+                                   const EnginePostAction action,
+                                   const uint pluginId,
+                                   const uint value) noexcept
+    : pData(engine->pData)
+{
+    CARLA_SAFE_ASSERT_RETURN(action != kEnginePostActionNull,);
+
+    const EngineNextAction::Action singleAction = { action, pluginId, value };
+    run(engine, &singleAction, 1);
+}
+
+ScopedActionLock::ScopedActionLock(CarlaEngine* const engine,
+                                   const EngineNextAction::Action* const actions,
+                                   const uint count) noexcept
+    : pData(engine->pData)
+{
+    CARLA_SAFE_ASSERT_RETURN(actions != nullptr,);
+
+    for (uint i=0; i < count; i += EngineNextAction::kMaxActions)
+        run(engine, actions + i, std::min(count - i, EngineNextAction::kMaxActions));
+}
+
+void ScopedActionLock::run(CarlaEngine* const engine,
+                           const EngineNextAction::Action* const actions,
+                           const uint count) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(count != 0 && count <= EngineNextAction::kMaxActions,);
+
+    {
+        const CarlaMutexLocker cml(pData->nextAction.mutex);
+
+        CARLA_SAFE_ASSERT_RETURN(pData->nextAction.count == 0,);
+
+        for (uint i=0; i < count; ++i)
+            pData->nextAction.actions[i] = actions[i];
+
+        pData->nextAction.count     = count;
+        pData->nextAction.needsPost = engine->isRunning();
+        pData->nextAction.postDone  = false;
+    }
+
+   #ifdef BUILD_BRIDGE
+    #define ACTION_MSG_PREFIX "Bridge: "
+   #else
+    #define ACTION_MSG_PREFIX ""
+   #endif
+
+    if (pData->nextAction.needsPost)
+    {
+       #if defined(DEBUG) || defined(BUILD_BRIDGE)
+        // block wait for unlock on processing side
+        carla_stdout(ACTION_MSG_PREFIX "ScopedPluginAction(%i) - blocking START", actions[0].pluginId);
+       #endif
+
+        bool engineStoppedWhileWaiting = false;
+
+        if (! pData->nextAction.postDone)
+        {
+            if (pData->nextAction.sem != nullptr)
+            {
+                for (int i = 10; --i >= 0;)
+                {
+                    if (carla_sem_timedwait(*pData->nextAction.sem, 200))
+                        break;
+
+                    if (! engine->isRunning())
+                    {
+                        engineStoppedWhileWaiting = true;
+                        break;
+                    }
+                }
+            }
+            else
+            {
+                // no semaphore, check often instead of sleeping through a whole audio cycle or more
+                for (int i = 2000; --i >= 0 && ! pData->nextAction.postDone;)
+                {
+                    carla_msleep(1);
+
+                    if (! engine->isRunning())
+                    {
+                        engineStoppedWhileWaiting = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+       #if defined(DEBUG) || defined(BUILD_BRIDGE)
+        carla_stdout(ACTION_MSG_PREFIX "ScopedPluginAction(%i) - blocking DONE", actions[0].pluginId);
+       #endif
+
+        // check if anything went wrong...
+        if (! pData->nextAction.postDone)
+        {
+            bool needsCorrection = false;
+
+            {
+                const CarlaMutexLocker cml(pData->nextAction.mutex);
+
+                if (pData->nextAction.count != 0)
+                {
+                    needsCorrection = true;
+                    pData->nextAction.needsPost = false;
+                }
+            }
+
+            if (needsCorrection)
+            {
+                pData->doNextPluginAction();
+
+                if (! engineStoppedWhileWaiting)
+                    carla_stderr2(ACTION_MSG_PREFIX "Failed to wait for engine, is audio not running?");
+            }
+        }
+    }
+    else
+    {
+        pData->doNextPluginAction();
+    }
+}
+
+ScopedActionLock::~ScopedActionLock() noexcept
+{
+    CARLA_SAFE_ASSERT(pData->nextAction.count == 0);
+}
+
+// -----------------------------------------------------------------------
+// ScopedThreadStopper
+
+ScopedThreadStopper::ScopedThreadStopper(CarlaEngine* const e) noexcept
+    : engine(e),
+      pData(e->pData)
+{
+    pData->thread.stopThread(500);
+#if defined(HAVE_LIBLO) && !defined(BUILD_BRIDGE)
+    pData->osc.suspendUdpDispatch();
+#endif
+}
+
+ScopedThreadStopper::~ScopedThreadStopper() noexcept
+{
+#if defined(HAVE_LIBLO) && !defined(BUILD_BRIDGE)
+    pData->osc.resumeUdpDispatch();
+#endif
+
+    if (engine->isRunning() && ! pData->aboutToClose)
+        pData->thread.startThread();
+}
+
+// -----------------------------------------------------------------------
+// ScopedPatchbayBatch
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+ScopedPatchbayBatch::ScopedPatchbayBatch(CarlaEngine* const e)
+    : engine(e),
+      active(true)
+{
+    engine->patchbayBeginBatch();
+}
+
+ScopedPatchbayBatch::~ScopedPatchbayBatch() noexcept
+{
+    try {
+        end();
+    } CARLA_SAFE_EXCEPTION("ScopedPatchbayBatch end");
+}
+
+void ScopedPatchbayBatch::end()
+{
+    if (! active)
+        return;
+
+    active = false;
+    engine->patchbayEndBatch();
+}
+#endif
 
 // -----------------------------------------------------------------------
 // ScopedEngineEnvironmentLocker
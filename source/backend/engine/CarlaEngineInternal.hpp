@@ -21,6 +21,7 @@
 #include "CarlaEngineThread.hpp"
 #include "CarlaEngineUtils.hpp"
 #include "CarlaPlugin.hpp"
+#include "CarlaSemUtils.hpp"
 #include "LinkedList.hpp"
 
 #ifndef BUILD_BRIDGE
@@ -34,6 +35,8 @@
 # include "water/memory/Atomic.h"
 #endif
 
+#include <map>
+#include <string>
 #include <vector>
 
 // FIXME only use CARLA_PREVENT_HEAP_ALLOCATION for structs
@@ -68,6 +71,41 @@ struct EngineInternalEvents {
 };
 
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+// -----------------------------------------------------------------------
+// EngineOutputFader
+
+/*
+ * Fades the engine audio outputs out and back in, used to hide the switch to a preloaded project.
+ * Fades are started from the main thread, the audio thread applies them and reports when the outputs are silent.
+ */
+struct EngineOutputFader {
+    enum State {
+        kStateIdle = 0,
+        kStateFadingOut,
+        kStateSilent,
+        kStateFadingIn
+    };
+
+    // the audio thread only moves from fading out to silent and from fading in to idle
+    volatile int state;
+    uint32_t fadeFrames;
+
+    // audio thread only
+    int rtState;
+    uint32_t position;
+
+    EngineOutputFader() noexcept;
+
+    void fadeOut(uint32_t frames) noexcept;
+    void fadeIn(uint32_t frames) noexcept;
+    void reset() noexcept;
+    bool isSilent() const noexcept;
+
+    void process(float* const* outBuf, uint32_t numChannels, uint32_t frames) noexcept;
+
+    CARLA_DECLARE_NON_COPY_STRUCT(EngineOutputFader)
+};
+
 // -----------------------------------------------------------------------
 // InternalGraph
 
@@ -111,6 +149,9 @@ public:
     // special direct process with connections already handled, used in JACK and Plugin
     void processRack(CarlaEngine::ProtectedData* data, const float* inBuf[2], float* outBuf[2], uint32_t frames);
 
+    // latency added to the rack audio by its plugins, always 0 in patchbay mode
+    uint32_t getRackLatency(const CarlaEngine::ProtectedData* data) const noexcept;
+
     // used for internal patchbay mode
     void addPlugin(CarlaPluginPtr plugin);
     void replacePlugin(CarlaPluginPtr oldPlugin, CarlaPluginPtr newPlugin);
@@ -118,15 +159,27 @@ public:
     void removePlugin(CarlaPluginPtr plugin);
     void removeAllPlugins();
 
+    // crossfaded plugin replacement, the patchbay node is kept and takes the new plugin at the start of a cycle
+    bool stagePluginSwap(CarlaPluginPtr oldPlugin, CarlaPluginPtr newPlugin);
+    void swapStagedPlugin() noexcept;
+    void finishPluginSwap(CarlaPluginPtr newPlugin);
+
     bool isUsingExternalHost() const noexcept;
     bool isUsingExternalOSC() const noexcept;
     void setUsingExternalHost(bool usingExternal) noexcept;
     void setUsingExternalOSC(bool usingExternal) noexcept;
 
+    // fades applied to the audio outputs after processing, see EngineOutputFader
+    EngineOutputFader& getOutputFader() noexcept
+    {
+        return fFader;
+    }
+
 private:
     bool fIsRack;
     uint32_t fNumAudioOuts;
     volatile bool fIsReady;
+    EngineOutputFader fFader;
 
     union {
         RackGraph*     fRack;
@@ -198,15 +251,33 @@ enum EnginePostAction {
     kEnginePostActionNull = 0,
     kEnginePostActionZeroCount,    // set curPluginCount to 0
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-    kEnginePostActionRemovePlugin, // remove a plugin
-    kEnginePostActionSwitchPlugins // switch between 2 plugins
+    kEnginePostActionRemovePlugin,       // remove a plugin
+    kEnginePostActionSwitchPlugins,      // switch between 2 plugins
+    kEnginePostActionSetParameterValues, // apply the staged parameter values, see CarlaEngine::setParameterValues
+    kEnginePostActionReplacePlugin       // swap in the staged replacement plugin and start crossfading to it
 #endif
 };
 
-struct EngineNextAction {
-    EnginePostAction opcode;
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+struct EngineStagedParameterValue {
     uint pluginId;
-    uint value;
+    uint32_t parameterId;
+    float value;
+};
+#endif
+
+struct EngineNextAction {
+    struct Action {
+        EnginePostAction opcode;
+        uint pluginId;
+        uint value;
+    };
+
+    // queued actions are applied by the audio thread in one go, in order
+    static const uint kMaxActions = 32;
+
+    Action actions[kMaxActions];
+    uint count;
 
     CarlaMutex mutex;
 
@@ -218,27 +289,390 @@ struct EngineNextAction {
     ~EngineNextAction() noexcept;
     void clearAndReset() noexcept;
 
+    bool isEmpty() const noexcept
+    {
+        return count == 0;
+    }
+
     CARLA_DECLARE_NON_COPY_STRUCT(EngineNextAction)
 };
 
+// -----------------------------------------------------------------------
+// EnginePluginProcessStats
+
+/*
+ * Timing of a plugin's process calls.
+ * Only written by the thread processing the plugin, readers can be anywhere and never block it.
+ * Durations also go into a log-scale histogram, so percentiles can be computed without keeping samples.
+ * Reads are not atomic as a whole, which is fine for diagnostics.
+ */
+struct EnginePluginProcessStats {
+    // 4 buckets per power of 2, enough for any uint32_t nanoseconds value
+    static const uint kNumBuckets = 32*4;
+
+    volatile uint64_t count;
+    volatile uint64_t subBlocks;
+    volatile uint64_t totalNs;
+    volatile uint32_t minNs;
+    volatile uint32_t maxNs;
+    volatile uint32_t buckets[kNumBuckets];
+
+    // set from any thread, done by the writer on its next record() call
+    volatile bool resetPending;
+
+    EnginePluginProcessStats() noexcept;
+
+    void record(uint32_t ns, uint32_t extraSubBlocks) noexcept;
+    EnginePluginProcessTimeInfo getInfo() const noexcept;
+
+    void requestReset() noexcept
+    {
+        resetPending = true;
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(EnginePluginProcessStats)
+};
+
+// -----------------------------------------------------------------------
+// EngineInternalCycleLog
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+/*
+ * Ring of timing records for the last engine process cycles, written by PendingRtEventsRunner.
+ * The audio thread is the only writer and never blocks, readers drop the records that got overwritten while copying.
+ * The engine idle prints the cycles that led to an xrun, so a single xrun can be looked at after the fact.
+ */
+struct EngineInternalCycleLog {
+    // power of 2, a bit over 10 seconds at 64 frames and 48kHz, longer with bigger buffers
+    static const uint kMaxRecords = 8192;
+
+    EngineCycleRecord* records;
+    volatile uint64_t writeCount;
+
+    // only used by dumpOnXrun()
+    uint32_t lastXruns;
+    int64_t lastDumpTime;
+
+    EngineInternalCycleLog() noexcept;
+    ~EngineInternalCycleLog() noexcept;
+
+    void init();
+    void clear() noexcept;
+
+    // audio thread
+    void write(const EngineCycleRecord& record) noexcept;
+
+    // any thread, oldest first
+    uint read(EngineCycleRecord* out, uint maxCount) const noexcept;
+
+    // engine idle, prints the last cycles to the log if the xrun count went up
+    void dumpOnXrun(uint32_t xruns, double sampleRate);
+
+    CARLA_DECLARE_NON_COPY_STRUCT(EngineInternalCycleLog)
+};
+#endif
+
+// -----------------------------------------------------------------------
+// EngineCallbackQueue
+
+/*
+ * Host callbacks waiting to be dispatched from the engine idle, see ENGINE_OPTION_ASYNC_CALLBACKS.
+ * Can be appended to from any non-RT thread, the lock is only held for the append or to take the whole queue.
+ * A parameter value change replaces the previous one of the same parameter, unless another callback came in between.
+ */
+struct EngineCallbackQueue {
+    struct Callback {
+        EngineCallbackOpcode action;
+        uint pluginId;
+        int value1, value2, value3;
+        float valuef;
+        bool hasValueStr;
+        CarlaString valueStr;
+    };
+
+    CarlaMutex mutex;
+    std::vector<Callback> callbacks;
+
+    // plugin and parameter id to the index of its value change in callbacks
+    std::map<uint64_t, std::size_t> valueChanges;
+
+    EngineCallbackQueue() noexcept;
+
+    void append(EngineCallbackOpcode action, uint pluginId,
+                int value1, int value2, int value3, float valuef, const char* valueStr) noexcept;
+
+    // calls func for each queued callback, in order, from the calling thread
+    void dispatch(EngineCallbackFunc func, void* ptr) noexcept;
+
+    CARLA_DECLARE_NON_COPY_STRUCT(EngineCallbackQueue)
+};
+
+// -----------------------------------------------------------------------
+// EnginePluginReaper
+
+/*
+ * Deletes removed plugins on background threads, a few at once, so that freeing big sample pools
+ * or waiting for bridge processes to quit does not block the thread that removed them.
+ * Workers are started on first use, see CarlaEngine::ProtectedData::deletePluginsAsNeeded().
+ */
+struct EnginePluginReaper {
+    static const uint kNumWorkers = 2;
+
+    class Worker : public CarlaThread
+    {
+    public:
+        Worker(EnginePluginReaper& reaper) noexcept;
+
+    protected:
+        void run() noexcept override;
+
+    private:
+        EnginePluginReaper& kReaper;
+        CARLA_DECLARE_NON_COPY_CLASS(Worker)
+    };
+
+    CarlaMutex mutex;
+    std::vector<CarlaPluginPtr> plugins;
+    carla_sem_t sem;
+    bool semValid;
+    volatile int pending;
+    Worker* workers[kNumWorkers];
+
+    EnginePluginReaper() noexcept;
+    ~EnginePluginReaper() noexcept;
+
+    // takes over the last reference to a plugin, leaving 'plugin' empty.
+    // returns false if no worker could be started, the caller then deletes the plugin itself.
+    bool add(CarlaPluginPtr& plugin);
+
+    // waits until all plugins are deleted, then stops the workers
+    void stop() noexcept;
+
+    CARLA_DECLARE_NON_COPY_STRUCT(EnginePluginReaper)
+};
+
+// -----------------------------------------------------------------------
+// EnginePluginLoader
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+/*
+ * Creates the plugins requested with CarlaEngine::addPluginAsync() on a background thread, one at a time.
+ * Loaded plugins are added to the engine by idle(), on the main thread, which also sends the progress callbacks.
+ * The worker is started on first use.
+ */
+struct EnginePluginLoader {
+    struct Request {
+        uint requestId;
+        BinaryType btype;
+        PluginType ptype;
+        uint provisionalId; // used while loading, the plugin gets its real id once added
+        CarlaString filename;
+        CarlaString name;
+        CarlaString label;
+        int64_t uniqueId;
+        bool use16Outs;
+        uint options;
+
+        // set by the worker, guarded by the loader mutex
+        bool started;
+        bool finished;
+        CarlaPluginPtr plugin;
+        CarlaString error; // the engine last error is not touched while loading, see workerError
+
+        bool startReported;
+
+        Request() noexcept;
+
+        CARLA_DECLARE_NON_COPY_STRUCT(Request)
+    };
+
+    class Worker : public CarlaThread
+    {
+    public:
+        Worker(EnginePluginLoader& loader) noexcept;
+
+    protected:
+        void run() noexcept override;
+
+    private:
+        EnginePluginLoader& kLoader;
+        CARLA_DECLARE_NON_COPY_CLASS(Worker)
+    };
+
+    CarlaEngine& kEngine;
+    CarlaMutex mutex;
+    std::vector<Request*> requests; // guarded by mutex, only added and removed on the main thread
+    carla_sem_t sem;
+    bool semValid;
+    uint lastRequestId;
+    Worker* worker;
+    CarlaString workerError; // worker thread only, receives the engine last error while creating a plugin
+
+    EnginePluginLoader(CarlaEngine& engine) noexcept;
+    ~EnginePluginLoader() noexcept;
+
+    uint getNextRequestId() noexcept;
+
+    // queues a plugin to be created in the background.
+    // returns the request id, or 0 if the worker could not be started.
+    uint add(BinaryType btype, PluginType ptype, uint provisionalId,
+             const char* filename, const char* name, const char* label, int64_t uniqueId,
+             bool use16Outs, uint options);
+
+    // reports progress and adds the plugins that finished loading, main thread only
+    void idle();
+
+    // engine last error calls made by the worker thread go to workerError instead
+    bool isWorkerThread() const noexcept;
+
+    // waits for the plugin being loaded, then drops it and all pending requests
+    void stop() noexcept;
+
+private:
+    bool insertPlugin(CarlaPluginPtr plugin);
+
+    CARLA_DECLARE_NON_COPY_STRUCT(EnginePluginLoader)
+};
+#endif
+
+// -----------------------------------------------------------------------
+// EnginePreloadedProject
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+struct EnginePluginData;
+
+/*
+ * Plugins of a project loaded ahead of time by CarlaEngine::preloadProject().
+ * They sit after the current plugins and stay disabled, so they are not processed until the switch.
+ */
+struct EnginePreloadedProject {
+    bool loading;
+    std::vector<CarlaPluginPtr> plugins;
+    // names as saved in the project, preloaded plugins get unique ones next to the current plugins
+    std::vector<std::string> names;
+    // 0.0 if the project does not set one
+    double bpm;
+
+    EnginePreloadedProject() noexcept;
+
+    void add(CarlaPluginPtr plugin, const char* name);
+    void clear() noexcept;
+
+    // ids of the preloaded plugins that are still loaded, in case some were removed in the meantime
+    std::vector<uint> getLoadedPluginIds(const EnginePluginData* enginePlugins, uint curPluginCount) const;
+
+    CARLA_DECLARE_NON_COPY_STRUCT(EnginePreloadedProject)
+};
+#endif
+
+// -----------------------------------------------------------------------
+// EnginePatchbaySnapshot
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+/*
+ * Collects the patchbay callbacks of a full refresh into a single string, see CarlaEngine::getPatchbaySnapshot().
+ * Only active for the duration of that call, on the thread doing the refresh.
+ * Also used for batches of patchbay changes, see CarlaEngine::patchbayBeginBatch(), guarded by a mutex there.
+ */
+struct EnginePatchbaySnapshot {
+    bool collecting;
+    uint count;
+    std::vector<char> data;
+
+    EnginePatchbaySnapshot() noexcept;
+
+    void begin() noexcept;
+    const char* end() noexcept;
+
+    // returns true if the callback went into the snapshot, and so must not be sent
+    bool add(EngineCallbackOpcode action, uint pluginId,
+             int value1, int value2, int value3, float valuef, const char* valueStr) noexcept;
+
+    CARLA_DECLARE_NON_COPY_STRUCT(EnginePatchbaySnapshot)
+};
+#endif
+
 // -----------------------------------------------------------------------
 // EnginePluginData
 
 struct EnginePluginData {
     CarlaPluginPtr plugin;
     float peaks[4];
+    EnginePluginProcessStats processStats;
+
+    // peaks are only computed while being read, the engine thread turns them off otherwise
+    volatile bool peaksEnabled;
+    volatile bool peaksWatched;
+
+    // plugin being replaced, still processed next to the new one until the crossfade is done.
+    // set and cleared by the audio thread, the engine keeps a reference in pluginsFadingOut meanwhile.
+    CarlaPlugin* volatile fadingOut;
+    uint32_t fadeFrames;
+    uint32_t fadePos;
 
     EnginePluginData()
         : plugin(nullptr),
 #ifdef CARLA_PROPER_CPP11_SUPPORT
-          peaks{0.0f, 0.0f, 0.0f, 0.0f} {}
+          peaks{0.0f, 0.0f, 0.0f, 0.0f},
+          peaksEnabled(true),
+          peaksWatched(false),
+          fadingOut(nullptr),
+          fadeFrames(0),
+          fadePos(0) {}
 #else
-          peaks()
+          peaks(),
+          peaksEnabled(true),
+          peaksWatched(false),
+          fadingOut(nullptr),
+          fadeFrames(0),
+          fadePos(0)
     {
         carla_zeroStruct(peaks);
     }
 #endif
+
+    void markPeaksWatched() noexcept
+    {
+        peaksWatched = true;
+        peaksEnabled = true;
+    }
+
+    // RT, mixes the outputs of the plugin fading out into the outputs of the current one, ending the fade when done
+    void mixCrossfade(float* const* outs, const float* const* fadeOuts, uint32_t numChannels, uint32_t frames) noexcept;
+};
+
+// -----------------------------------------------------------------------
+// EnginePeaksBlock
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+/*
+ * Peaks of all plugins, published by the audio thread once per cycle from PendingRtEventsRunner.
+ * A sequence counter, odd while publishing, lets readers copy all peaks of the same cycle without locking.
+ * Engines processing plugins outside of PendingRtEventsRunner (JACK multi-client) never publish,
+ * readers then have to take the values from each plugin instead.
+ */
+struct EnginePeaksBlock {
+    float* peaks; // 4 per plugin
+    uint maxCount;
+    uint count;
+    volatile uint32_t sequence;
+    volatile bool published;
+
+    EnginePeaksBlock() noexcept;
+    ~EnginePeaksBlock() noexcept;
+
+    void init(uint maxPluginNumber);
+    void clear() noexcept;
+
+    // RT call
+    void publish(const EnginePluginData* plugins, uint pluginCount) noexcept;
+
+    // copies at most 'maxPlugins' plugins into 'peaksOut', returns the count or -1 if nothing was published yet
+    int read(float* peaksOut, uint maxPlugins) const noexcept;
+
+    CARLA_DECLARE_NON_COPY_STRUCT(EnginePeaksBlock)
 };
+#endif
 
 // -----------------------------------------------------------------------
 // CarlaEngineProtectedData
@@ -250,8 +684,9 @@ struct CarlaEngine::ProtectedData {
     CarlaEngineOsc osc;
 #endif
 
-    EngineCallbackFunc callback;
-    void*              callbackPtr;
+    EngineCallbackFunc  callback;
+    void*               callbackPtr;
+    EngineCallbackQueue callbackQueue;
 
     FileCallbackFunc fileCallback;
     void*            fileCallbackPtr;
@@ -286,13 +721,32 @@ struct CarlaEngine::ProtectedData {
     EnginePluginData* plugins;
     uint32_t xruns;
     float dspLoad;
+    EngineInternalCycleLog cycleLog;
+    EnginePeaksBlock peaksBlock;
 #endif
     float peaks[4];
     std::vector<CarlaPluginPtr> pluginsToDelete;
+    EnginePluginReaper pluginReaper;
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    EnginePluginLoader pluginLoader;
+#endif
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    // replaced plugins still referenced by a slot crossfade, see EnginePluginData::fadingOut
+    std::vector<CarlaPluginPtr> pluginsFadingOut;
+    CarlaPluginPtr pluginToSwapIn;
+#endif
 
     EngineInternalEvents events;
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     EngineInternalGraph  graph;
+    EnginePatchbaySnapshot patchbaySnapshot;
+    EnginePatchbaySnapshot patchbayBatch;
+    CarlaMutex patchbayBatchMutex;
+    uint patchbayBatchDepth;
+    EnginePreloadedProject preloadedProject;
+    // owned by the caller of setParameterValues, which waits for them to be applied
+    const EngineStagedParameterValue* stagedParameterValues;
+    uint stagedParameterValueCount;
 #endif
     EngineInternalTime   time;
     EngineNextAction     nextAction;
@@ -317,6 +771,8 @@ struct CarlaEngine::ProtectedData {
 
     void doPluginRemove(uint pluginId) noexcept;
     void doPluginsSwitch(uint idA, uint idB) noexcept;
+    void doParameterValuesSet() noexcept;
+    void doPluginReplace(uint pluginId, uint32_t fadeFrames) noexcept;
     void doNextPluginAction() noexcept;
 
     // -------------------------------------------------------------------
@@ -339,23 +795,74 @@ public:
 
 private:
     CarlaEngine::ProtectedData* const pData;
+    const uint32_t numFrames;
+    const int64_t startTime;
+    int64_t processStartTime;
     int64_t prevTime;
+    const char* prevRtCheckContext;
+    const bool flushDenormals;
+    const uintptr_t prevFloatControl;
 
     CARLA_PREVENT_HEAP_ALLOCATION
     CARLA_DECLARE_NON_COPY_CLASS(PendingRtEventsRunner)
 };
 
+// -----------------------------------------------------------------------
+// ScopedPluginProcessTimer
+
+// times a plugin process call, to be placed right around it
+// also tells the rtcheck interposer (if preloaded) which plugin is running
+class ScopedPluginProcessTimer
+{
+public:
+    ScopedPluginProcessTimer(EnginePluginProcessStats& stats, CarlaPlugin* plugin) noexcept;
+    ~ScopedPluginProcessTimer() noexcept;
+
+private:
+    EnginePluginProcessStats& fStats;
+    CarlaPlugin* const fPlugin;
+    const char* const fPrevRtCheckContext;
+    const int64_t fStartTime;
+
+    CARLA_PREVENT_HEAP_ALLOCATION
+    CARLA_DECLARE_NON_COPY_CLASS(ScopedPluginProcessTimer)
+};
+
+// -----------------------------------------------------------------------
+// ScopedPluginDenormals
+
+// turns denormal flushing off while a plugin with PLUGIN_OPTION_KEEP_DENORMALS processes, to be placed right around it
+class ScopedPluginDenormals
+{
+public:
+    ScopedPluginDenormals(uint pluginOptions) noexcept;
+    ~ScopedPluginDenormals() noexcept;
+
+private:
+    const bool fKeepDenormals;
+    const uintptr_t fPrevFloatControl;
+
+    CARLA_PREVENT_HEAP_ALLOCATION
+    CARLA_DECLARE_NON_COPY_CLASS(ScopedPluginDenormals)
+};
+
 // -----------------------------------------------------------------------
 
 class ScopedActionLock
 {
 public:
     ScopedActionLock(CarlaEngine* engine, EnginePostAction action, uint pluginId, uint value) noexcept;
+
+    // applies several actions, with a single wait for the audio thread per EngineNextAction::kMaxActions
+    ScopedActionLock(CarlaEngine* engine, const EngineNextAction::Action* actions, uint count) noexcept;
+
     ~ScopedActionLock() noexcept;
 
 private:
     CarlaEngine::ProtectedData* const pData;
 
+    void run(CarlaEngine* engine, const EngineNextAction::Action* actions, uint count) noexcept;
+
     CARLA_PREVENT_HEAP_ALLOCATION
     CARLA_DECLARE_NON_COPY_CLASS(ScopedActionLock)
 };
@@ -378,6 +885,27 @@ private:
 
 // -----------------------------------------------------------------------
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+class ScopedPatchbayBatch
+{
+public:
+    ScopedPatchbayBatch(CarlaEngine* engine);
+    ~ScopedPatchbayBatch() noexcept;
+
+    // ends the batch early, so its callback can be sent before others
+    void end();
+
+private:
+    CarlaEngine* const engine;
+    bool active;
+
+    CARLA_PREVENT_HEAP_ALLOCATION
+    CARLA_DECLARE_NON_COPY_CLASS(ScopedPatchbayBatch)
+};
+#endif
+
+// -----------------------------------------------------------------------
+
 CARLA_BACKEND_END_NAMESPACE
 
 #endif // CARLA_ENGINE_INTERNAL_HPP_INCLUDED
@@ -26,6 +26,7 @@
 #include "CarlaMIDI.h"
 #include "CarlaPatchbayUtils.hpp"
 #include "CarlaStringList.hpp"
+#include "CarlaThreadPool.hpp"
 
 #include "jackey.h"
 
@@ -46,10 +47,6 @@
 # endif
 #endif
 
-#ifdef __SSE2_MATH__
-# include <xmmintrin.h>
-#endif
-
 // must be last
 #include "jackbridge/JackBridge.hpp"
 
@@ -178,6 +175,9 @@ public:
     {
         carla_debug("CarlaEngineJackAudioPort::CarlaEngineJackAudioPort(%s, %p, %p)", bool2str(isInputPort), jackClient, jackPort);
 
+        // JACK hands out a new buffer each cycle
+        fNeedsBufferInit = jackPort != nullptr;
+
         switch (kClient.getEngine().getProccessMode())
         {
         case ENGINE_PROCESS_MODE_SINGLE_CLIENT:
@@ -286,6 +286,8 @@ public:
     {
         carla_debug("CarlaEngineJackCVPort::CarlaEngineJackCVPort(%s, %p, %p)", bool2str(isInputPort), jackClient, jackPort);
 
+        fNeedsBufferInit = jackPort != nullptr;
+
         switch (kClient.getEngine().getProccessMode())
         {
         case ENGINE_PROCESS_MODE_SINGLE_CLIENT:
@@ -634,7 +636,8 @@ public:
         : CarlaEngineCVSourcePorts(),
           fUseClient(useClient),
           fBuffer(nullptr),
-          fBufferToDeleteLater(nullptr)
+          fBufferToDeleteLater(nullptr),
+          fHasCVSources(false)
     {}
 
     ~CarlaEngineJackCVSourcePorts() override
@@ -664,6 +667,7 @@ public:
             fBuffer = buffer;
         }
 
+        fHasCVSources = true;
         return true;
     }
 
@@ -686,6 +690,7 @@ public:
             fBuffer = nullptr;
         }
 
+        fHasCVSources = pData->cvs.size() != 0;
         return true;
     }
 
@@ -756,6 +761,12 @@ public:
         return pData->rmutex;
     }
 
+    // can be called without the mutex, the audio thread uses it to skip locking when there are no sources
+    bool hasCVSources() const noexcept
+    {
+        return fHasCVSources;
+    }
+
     uint32_t getPortCount() const noexcept
     {
         return static_cast<uint32_t>(pData->cvs.size());
@@ -783,11 +794,89 @@ private:
     const bool fUseClient;
     EngineEvent* fBuffer;
     EngineEvent* fBufferToDeleteLater;
+    volatile bool fHasCVSources;
 
     CARLA_DECLARE_NON_COPY_CLASS(CarlaEngineJackCVSourcePorts)
 };
 #endif
 
+// -----------------------------------------------------------------------
+// Jack Engine plugin port tables, used by CarlaEngineJack::processPlugin()
+
+struct CarlaEngineJackProcessPorts {
+    const uint32_t audioCapacity;
+    const uint32_t cvCapacity;
+
+    uint32_t audioInCount;
+    uint32_t audioOutCount;
+    uint32_t cvInCount;
+    uint32_t cvOutCount;
+
+    // ins followed by outs
+    CarlaEngineAudioPort** const audioPorts;
+    CarlaEngineCVPort**    const cvPorts;
+    float** const audioBuffers;
+    float** const cvBuffers;
+
+    CarlaEngineJackProcessPorts(const uint32_t audioCap, const uint32_t cvCap)
+        : audioCapacity(audioCap),
+          cvCapacity(cvCap),
+          audioInCount(0),
+          audioOutCount(0),
+          cvInCount(0),
+          cvOutCount(0),
+          audioPorts(new CarlaEngineAudioPort*[audioCap]),
+          cvPorts(new CarlaEngineCVPort*[cvCap]),
+          audioBuffers(new float*[audioCap]),
+          cvBuffers(new float*[cvCap]) {}
+
+    ~CarlaEngineJackProcessPorts() noexcept
+    {
+        delete[] audioPorts;
+        delete[] cvPorts;
+        delete[] audioBuffers;
+        delete[] cvBuffers;
+    }
+
+    // refill the port pointers, needs the plugin to be locked
+    bool update(const CarlaPluginPtr& plugin) noexcept
+    {
+        audioInCount  = plugin->getAudioInCount();
+        audioOutCount = plugin->getAudioOutCount();
+        cvInCount     = plugin->getCVInCount();
+        cvOutCount    = plugin->getCVOutCount();
+
+        if (audioInCount + audioOutCount > audioCapacity || cvInCount + cvOutCount > cvCapacity)
+        {
+            carla_safe_assert("port count > capacity", __FILE__, __LINE__);
+            audioInCount = audioOutCount = cvInCount = cvOutCount = 0;
+            return false;
+        }
+
+        for (uint32_t i=0; i < audioInCount; ++i)
+            audioPorts[i] = plugin->getAudioInPort(i);
+        for (uint32_t i=0; i < audioOutCount; ++i)
+            audioPorts[audioInCount + i] = plugin->getAudioOutPort(i);
+        for (uint32_t i=0; i < cvInCount; ++i)
+            cvPorts[i] = plugin->getCVInPort(i);
+        for (uint32_t i=0; i < cvOutCount; ++i)
+            cvPorts[cvInCount + i] = plugin->getCVOutPort(i);
+
+        return true;
+    }
+
+    // JACK buffers are only valid for the current cycle, so these need to be fetched every time
+    void updateBuffers() noexcept
+    {
+        for (uint32_t i=0, count=audioInCount+audioOutCount; i < count; ++i)
+            audioBuffers[i] = audioPorts[i] != nullptr ? audioPorts[i]->getBuffer() : nullptr;
+        for (uint32_t i=0, count=cvInCount+cvOutCount; i < count; ++i)
+            cvBuffers[i] = cvPorts[i] != nullptr ? cvPorts[i]->getBuffer() : nullptr;
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(CarlaEngineJackProcessPorts)
+};
+
 // -----------------------------------------------------------------------
 // Jack Engine client
 
@@ -816,6 +905,10 @@ public:
           fAudioPorts(),
           fCVPorts(),
           fEventPorts(),
+          fProcessPorts(nullptr),
+          fProcessPortsRT(nullptr),
+          fProcessPortsDirty(1),
+          fOldProcessPorts(),
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
           fCVSourcePorts(fUseClient),
           fPreRenameMutex(),
@@ -837,6 +930,8 @@ public:
         {
             CARLA_SAFE_ASSERT(jackClient == nullptr);
         }
+
+        _reserveProcessPorts();
     }
 
     ~CarlaEngineJackClient() noexcept override
@@ -851,6 +946,12 @@ public:
         //fCVPorts.clear();
         //fEventPorts.clear();
 
+        for (LinkedList<CarlaEngineJackProcessPorts*>::Itenerator it = fOldProcessPorts.begin2(); it.valid(); it.next())
+            delete it.getValue(nullptr);
+
+        fOldProcessPorts.clear();
+        delete fProcessPorts;
+
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
         const CarlaMutexLocker cml(fPreRenameMutex);
 
@@ -1037,6 +1138,7 @@ public:
                                                                                     fThreadSafeMetadataMutex,
                                                                                     this));
             fAudioPorts.append(enginePort);
+            _reserveProcessPorts();
             return enginePort;
         }
         case kEnginePortTypeCV: {
@@ -1050,6 +1152,7 @@ public:
                                                                               fThreadSafeMetadataMutex,
                                                                               this));
             fCVPorts.append(enginePort);
+            _reserveProcessPorts();
             return enginePort;
         }
         case kEnginePortTypeEvent: {
@@ -1123,14 +1226,34 @@ public:
         } CARLA_SAFE_EXCEPTION_RETURN("jack_get_client_name", nullptr);
     }
 
+    /*
+     * Get the plugin port tables for processing, refilled here after any port was added or removed.
+     * Must be called from the audio thread with the plugin locked.
+     */
+    CarlaEngineJackProcessPorts* getProcessPorts(const CarlaPluginPtr& plugin) noexcept
+    {
+        // clear the flag before reading the tables, so a newer reserve is always picked up on the next cycle
+        if (__sync_bool_compare_and_swap(&fProcessPortsDirty, 1, 0))
+        {
+            fProcessPortsRT = fProcessPorts;
+
+            if (fProcessPortsRT != nullptr && ! fProcessPortsRT->update(plugin))
+                return nullptr;
+        }
+
+        return fProcessPortsRT;
+    }
+
     void jackAudioPortDeleted(CarlaEngineJackAudioPort* const port) noexcept override
     {
         fAudioPorts.removeAll(port);
+        fProcessPortsDirty = 1;
     }
 
     void jackCVPortDeleted(CarlaEngineJackCVPort* const port) noexcept override
     {
         fCVPorts.removeAll(port);
+        fProcessPortsDirty = 1;
     }
 
     void jackEventPortDeleted(CarlaEngineJackEventPort* const port) noexcept override
@@ -1185,6 +1308,7 @@ public:
         fAudioPorts.clear();
         fCVPorts.clear();
         fEventPorts.clear();
+        fProcessPortsDirty = 1;
         pData->clearPorts();
 
         fJackClient = newClient;
@@ -1229,6 +1353,35 @@ private:
     LinkedList<CarlaEngineJackCVPort*>    fCVPorts;
     LinkedList<CarlaEngineJackEventPort*> fEventPorts;
 
+    // tables are only replaced by bigger ones, the old ones stay around as the audio thread might still use them
+    CarlaEngineJackProcessPorts* fProcessPorts;
+    CarlaEngineJackProcessPorts* fProcessPortsRT;
+    volatile int fProcessPortsDirty;
+    LinkedList<CarlaEngineJackProcessPorts*> fOldProcessPorts;
+
+    void _reserveProcessPorts() noexcept
+    {
+        const uint32_t audioCount = static_cast<uint32_t>(fAudioPorts.count());
+        const uint32_t cvCount    = static_cast<uint32_t>(fCVPorts.count());
+
+        if (fProcessPorts == nullptr || audioCount > fProcessPorts->audioCapacity || cvCount > fProcessPorts->cvCapacity)
+        {
+            CarlaEngineJackProcessPorts* newPorts = nullptr;
+
+            try {
+                newPorts = new CarlaEngineJackProcessPorts(std::max(8U, audioCount * 2), std::max(8U, cvCount * 2));
+            } CARLA_SAFE_EXCEPTION_RETURN("CarlaEngineJackProcessPorts",);
+
+            if (fProcessPorts != nullptr)
+                fOldProcessPorts.append(fProcessPorts);
+
+            fProcessPorts = newPorts;
+        }
+
+        __sync_synchronize();
+        fProcessPortsDirty = 1;
+    }
+
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     CarlaEngineJackCVSourcePorts fCVSourcePorts;
 
@@ -1374,6 +1527,7 @@ public:
           fTimebaseMaster(false),
           fTimebaseRolling(false),
           fTimebaseUsecs(0),
+          fRackLatency(0),
           fUsedGroups(),
           fUsedPorts(),
           fUsedConnections(),
@@ -1384,7 +1538,11 @@ public:
           fPostPonedEventsMutex(),
           fPostPonedUUIDs(),
           fPostPonedUUIDsMutex(),
-          fIsInternalClient(false)
+          fIsInternalClient(false),
+          fSingleClientPool(nullptr),
+          fSingleClientNextPlugin(0),
+          fSingleClientFrames(0),
+          fSingleClientInternalConnections(false)
 #endif
     {
         carla_debug("CarlaEngineJack::CarlaEngineJack()");
@@ -1406,6 +1564,7 @@ public:
         fUsedPorts.clear();
         fUsedConnections.clear();
         CARLA_SAFE_ASSERT(fPostPonedEvents.count() == 0);
+        CARLA_SAFE_ASSERT(fSingleClientPool == nullptr);
 #endif
     }
 
@@ -1548,7 +1707,7 @@ public:
         pData->sampleRate = jackbridge_get_sample_rate(fClient);
         pData->initTime(opts.transportExtra);
 
-        jackbridge_set_thread_init_callback(fClient, carla_jack_thread_init_callback, nullptr);
+        jackbridge_set_thread_init_callback(fClient, carla_jack_thread_init_callback, this);
         jackbridge_set_buffer_size_callback(fClient, carla_jack_bufsize_callback, this);
         jackbridge_set_sample_rate_callback(fClient, carla_jack_srate_callback, this);
         jackbridge_set_freewheel_callback(fClient, carla_jack_freewheel_callback, this);
@@ -1594,6 +1753,12 @@ public:
                 patchbayRefresh(true, false, false);
             }
         }
+        else if (opts.processMode == ENGINE_PROCESS_MODE_SINGLE_CLIENT && opts.processingThreads != 0)
+        {
+            fSingleClientNextPlugin = 0;
+            fSingleClientInternalConnections = false;
+            fSingleClientPool = CarlaSharedThreadPool::acquire(opts.processingThreads, opts.processingCpuAffinity);
+        }
 
 # ifdef HAVE_LIBLO
         {
@@ -1688,6 +1853,12 @@ public:
             pData->graph.destroy();
         }
 
+        if (fSingleClientPool != nullptr)
+        {
+            CarlaSharedThreadPool::release(fSingleClientPool);
+            fSingleClientPool = nullptr;
+        }
+
         pData->close();
         jackbridge_client_close(fClient);
         fClient = nullptr;
@@ -1748,6 +1919,13 @@ public:
             pData->graph.destroy();
         }
 
+        // client is closed, so no process callback can be using the pool anymore
+        if (fSingleClientPool != nullptr)
+        {
+            CarlaSharedThreadPool::release(fSingleClientPool);
+            fSingleClientPool = nullptr;
+        }
+
         return true;
 #endif
     }
@@ -1880,6 +2058,18 @@ public:
             }
         }
 
+        // ask JACK to query our port latencies again if the plugins changed the rack latency
+        if (fClient != nullptr && pData->options.processMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK && pData->graph.isReady())
+        {
+            const uint32_t rackLatency = pData->graph.getRackLatency(pData);
+
+            if (fRackLatency != rackLatency)
+            {
+                fRackLatency = rackLatency;
+                jackbridge_recompute_total_latencies(fClient);
+            }
+        }
+
         CarlaEngine::idle();
     }
 #endif
@@ -1934,6 +2124,7 @@ public:
             timeInfo.bbt.beatType       = jpos.beat_type;
             timeInfo.bbt.ticksPerBeat   = jpos.ticks_per_beat;
             timeInfo.bbt.beatsPerMinute = jpos.beats_per_minute;
+            timeInfo.bbt.updatePPQ();
         }
         else
         {
@@ -2014,7 +2205,7 @@ public:
             }
             CARLA_CUSTOM_SAFE_ASSERT_RETURN("Failure to open client", client != nullptr, nullptr);
 
-            jackbridge_set_thread_init_callback(client, carla_jack_thread_init_callback, nullptr);
+            jackbridge_set_thread_init_callback(client, carla_jack_thread_init_callback, this);
 
             const CarlaRecursiveMutexLocker crml(fThreadSafeMetadataMutex);
 
@@ -2115,6 +2306,29 @@ public:
         return true;
     }
 
+    bool removePlugins(const uint* const ids, const uint count) override
+    {
+        if (! CarlaEngine::removePlugins(ids, count))
+            return false;
+
+        const uint lowestId = *std::min_element(ids, ids + count);
+
+        const CarlaRecursiveMutexLocker crml(fThreadSafeMetadataMutex);
+
+        for (uint i=lowestId; i < pData->curPluginCount; ++i)
+        {
+            const CarlaPluginPtr plugin = pData->plugins[i].plugin;
+            CARLA_SAFE_ASSERT_BREAK(plugin.get() != nullptr);
+
+            CarlaEngineJackClient* const client = dynamic_cast<CarlaEngineJackClient*>(plugin->getEngineClient());
+            CARLA_SAFE_ASSERT_BREAK(client != nullptr);
+
+            client->setNewPluginId(i);
+        }
+
+        return true;
+    }
+
     bool switchPlugins(const uint idA, const uint idB) noexcept override
     {
         if (! CarlaEngine::switchPlugins(idA, idB))
@@ -2227,7 +2441,7 @@ public:
 
                 // NOTE: jack1 locks up here
                 if (jackbridge_get_version_string() != nullptr)
-                    jackbridge_set_thread_init_callback(jackClient, carla_jack_thread_init_callback, nullptr);
+                    jackbridge_set_thread_init_callback(jackClient, carla_jack_thread_init_callback, this);
 
                 /* The following code is because of a tricky situation.
                    We cannot lock or do jack operations during jack callbacks on jack1. jack2 events are asynchronous.
@@ -2930,6 +3144,7 @@ protected:
                     timeInfo.bbt.beatType       = jpos.beat_type;
                     timeInfo.bbt.ticksPerBeat   = jpos.ticks_per_beat;
                     timeInfo.bbt.beatsPerMinute = jpos.beats_per_minute;
+                    timeInfo.bbt.updatePPQ();
                 }
                 else
                 {
@@ -2977,6 +3192,17 @@ protected:
 
         if (pData->options.processMode == ENGINE_PROCESS_MODE_SINGLE_CLIENT)
         {
+            // plugins connected to each other within our own client must run in order
+            if (fSingleClientPool != nullptr && pData->curPluginCount > 1 && ! fSingleClientInternalConnections)
+            {
+                fSingleClientNextPlugin = 0;
+                fSingleClientFrames     = nframes;
+
+                fSingleClientPool->run(processSingleClientCallback, this,
+                                       std::min(pData->options.processingThreads, pData->curPluginCount - 1));
+                return;
+            }
+
             for (uint i=0; i < pData->curPluginCount; ++i)
             {
                 if (CarlaPluginPtr plugin = pData->plugins[i].plugin)
@@ -3140,9 +3366,42 @@ protected:
 #endif // ! BUILD_BRIDGE
     }
 
-    void handleJackLatencyCallback(const jack_latency_callback_mode_t /*mode*/)
+    void handleJackLatencyCallback(const jack_latency_callback_mode_t mode)
     {
-        // TODO
+#ifndef BUILD_BRIDGE
+        if (pData->options.processMode != ENGINE_PROCESS_MODE_CONTINUOUS_RACK || ! pData->graph.isReady())
+            return;
+
+        const uint32_t latency = pData->graph.getRackLatency(pData);
+        const bool isCapture = (mode == JackCaptureLatency);
+
+        jack_latency_range_t range;
+
+        static const uint kInPorts[3]  = { kRackPortAudioIn1,  kRackPortAudioIn2,  kRackPortEventIn  };
+        static const uint kOutPorts[3] = { kRackPortAudioOut1, kRackPortAudioOut2, kRackPortEventOut };
+
+        // capture latency goes from inputs to outputs, playback latency the other way around
+        for (uint i=0; i<3; ++i)
+        {
+            jack_port_t* const inPort  = fRackPorts[kInPorts[i]];
+            jack_port_t* const outPort = fRackPorts[kOutPorts[i]];
+            CARLA_SAFE_ASSERT_CONTINUE(inPort != nullptr && outPort != nullptr);
+
+            jackbridge_port_get_latency_range(isCapture ? inPort : outPort, mode, &range);
+
+            // only audio is delayed by the plugins, events go through as-is
+            if (i != 2)
+            {
+                range.min += latency;
+                range.max += latency;
+            }
+
+            jackbridge_port_set_latency_range(isCapture ? outPort : inPort, mode, &range);
+        }
+#else
+        // unused
+        (void)mode;
+#endif
     }
 
 #ifndef BUILD_BRIDGE
@@ -3570,6 +3829,9 @@ private:
     bool fTimebaseRolling;
     uint64_t fTimebaseUsecs;
 
+    // last rack latency reported to JACK, see handleJackLatencyCallback()
+    uint32_t fRackLatency;
+
     PatchbayGroupList      fUsedGroups;
     PatchbayPortList       fUsedPorts;
     PatchbayConnectionList fUsedConnections;
@@ -4008,113 +4270,150 @@ private:
 
     // -------------------------------------------------------------------
 
-    void processPlugin(CarlaPluginPtr& plugin, const uint32_t nframes)
+#ifndef BUILD_BRIDGE
+    static void processSingleClientCallback(void* const ptr, uint)
     {
-#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-        CarlaEngineJackClient* const client = (CarlaEngineJackClient*)plugin->getEngineClient();
-        CarlaEngineJackCVSourcePorts& cvSourcePorts(client->getCVSourcePorts());
+        CarlaEngineJack* const self = static_cast<CarlaEngineJack*>(ptr);
+        const CarlaEngine::ProtectedData* const data = self->pData;
 
-        const CarlaRecursiveMutexTryLocker crmtl(cvSourcePorts.getMutex(), fFreewheel);
-        // const CarlaRecursiveMutexLocker crml(cvSourcePorts.getMutex());
-#endif
-
-        /*
-        const uint32_t audioInCount  = client->getPortCount(kEnginePortTypeAudio, true);
-        const uint32_t audioOutCount = client->getPortCount(kEnginePortTypeAudio, false);
-        const uint32_t cvInCount     = client->getPortCount(kEnginePortTypeCV, true);
-        const uint32_t cvOutCount    = client->getPortCount(kEnginePortTypeCV, false);
-        */
-
-        const uint32_t audioInCount  = plugin->getAudioInCount();
-        const uint32_t audioOutCount = plugin->getAudioOutCount();
-        const uint32_t cvInCount     = plugin->getCVInCount();
-        const uint32_t cvOutCount    = plugin->getCVOutCount();
-#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-        const uint32_t cvsInCount    = crmtl.wasLocked() ? cvSourcePorts.getPortCount() : 0;
-#else
-        const uint32_t cvsInCount    = 0;
-#endif
-
-        const float* audioIn[audioInCount];
-        /* */ float* audioOut[audioOutCount];
-        const float* cvIn[cvInCount+cvsInCount];
-        /* */ float* cvOut[cvOutCount];
+        // pool threads are only used for processing, so they can keep the flags
+        if (data->options.flushDenormals)
+            carla_setDenormalsFlushed(true);
 
-        for (uint32_t i=0; i < audioInCount; ++i)
+        for (int index; (index = __sync_fetch_and_add(&self->fSingleClientNextPlugin, 1)) < static_cast<int>(data->curPluginCount);)
         {
-            if (CarlaEngineAudioPort* const port = plugin->getAudioInPort(i))
-                audioIn[i] = port->getBuffer();
-            else
-                audioIn[i] = nullptr;
+            if (CarlaPluginPtr plugin = data->plugins[index].plugin)
+            {
+                if (plugin->isEnabled() && plugin->tryLock(self->fFreewheel))
+                {
+                    plugin->initBuffers();
+                    self->processPlugin(plugin, self->fSingleClientFrames);
+                    plugin->unlock();
+                }
+            }
         }
+    }
 
-        for (uint32_t i=0; i < audioOutCount; ++i)
-        {
-            if (CarlaEngineAudioPort* const port = plugin->getAudioOutPort(i))
-                audioOut[i] = port->getBuffer();
-            else
-                audioOut[i] = nullptr;
-        }
+    // check if any of our own ports are connected to each other, without touching the patchbay lists
+    void updateSingleClientInternalConnections()
+    {
+        const CarlaString prefix(fClientName + ":");
+        bool hasInternalConnections = false;
 
-        for (uint32_t i=0; i < cvInCount; ++i)
+        if (const char** const ports = jackbridge_get_ports(fClient, nullptr, nullptr, JackPortIsInput))
         {
-            if (CarlaEngineCVPort* const port = plugin->getCVInPort(i))
-                cvIn[i] = port->getBuffer();
-            else
-                cvIn[i] = nullptr;
+            for (int i=0; ports[i] != nullptr && ! hasInternalConnections; ++i)
+            {
+                if (std::strncmp(ports[i], prefix.buffer(), prefix.length()) != 0)
+                    continue;
+
+                const jack_port_t* const port = jackbridge_port_by_name(fClient, ports[i]);
+                CARLA_SAFE_ASSERT_CONTINUE(port != nullptr);
+
+                if (const char** const connections = jackbridge_port_get_connections(port))
+                {
+                    for (int j=0; connections[j] != nullptr; ++j)
+                    {
+                        if (std::strncmp(connections[j], prefix.buffer(), prefix.length()) == 0)
+                        {
+                            hasInternalConnections = true;
+                            break;
+                        }
+                    }
+
+                    jackbridge_free(connections);
+                }
+            }
+
+            jackbridge_free(ports);
         }
 
+        fSingleClientInternalConnections = hasInternalConnections;
+    }
+#endif
+
+    void processPlugin(CarlaPluginPtr& plugin, const uint32_t nframes)
+    {
+        CarlaEngineJackClient* const client = (CarlaEngineJackClient*)plugin->getEngineClient();
+
+        CarlaEngineJackProcessPorts* const ports = client->getProcessPorts(plugin);
+        CARLA_SAFE_ASSERT_RETURN(ports != nullptr,);
+
+        ports->updateBuffers();
+
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-        for (uint32_t i=cvInCount, j=0; j < cvsInCount; ++i, ++j)
+        CarlaEngineJackCVSourcePorts& cvSourcePorts(client->getCVSourcePorts());
+
+        if (cvSourcePorts.hasCVSources())
         {
-            if (CarlaEngineCVPort* const port = cvSourcePorts.getPort(j))
-            {
-                port->initBuffer();
-                cvIn[i] = port->getBuffer();
-            }
-            else
+            const CarlaRecursiveMutexTryLocker crmtl(cvSourcePorts.getMutex(), fFreewheel);
+
+            if (crmtl.wasLocked())
             {
-                cvIn[i] = nullptr;
+                if (const uint32_t cvsInCount = cvSourcePorts.getPortCount())
+                {
+                    const uint32_t cvInCount = ports->cvInCount;
+                    const float* cvIn[cvInCount+cvsInCount];
+
+                    for (uint32_t i=0; i < cvInCount; ++i)
+                        cvIn[i] = ports->cvBuffers[i];
+
+                    for (uint32_t i=cvInCount, j=0; j < cvsInCount; ++i, ++j)
+                    {
+                        if (CarlaEngineCVPort* const port = cvSourcePorts.getPort(j))
+                        {
+                            if (port->needsBufferInit())
+                                port->initBuffer();
+                            cvIn[i] = port->getBuffer();
+                        }
+                        else
+                        {
+                            cvIn[i] = nullptr;
+                        }
+                    }
+
+                    processPluginBuffers(plugin, *ports, cvIn, nframes);
+                    return;
+                }
             }
         }
 #endif
 
-        for (uint32_t i=0; i < cvOutCount; ++i)
-        {
-            if (CarlaEngineCVPort* const port = plugin->getCVOutPort(i))
-                cvOut[i] = port->getBuffer();
-            else
-                cvOut[i] = nullptr;
-        }
+        processPluginBuffers(plugin, *ports, ports->cvBuffers, nframes);
+    }
+
+    void processPluginBuffers(CarlaPluginPtr& plugin, const CarlaEngineJackProcessPorts& ports,
+                              const float* const* const cvIn, const uint32_t nframes)
+    {
+        const float* const* const audioIn = ports.audioBuffers;
+        float** const audioOut = ports.audioBuffers + ports.audioInCount;
+        float** const cvOut    = ports.cvBuffers + ports.cvInCount;
+
+        // skip peaks if nobody is reading them
+        const bool peaksEnabled = pData->plugins[plugin->getId()].peaksEnabled;
 
         float inPeaks[2] = { 0.0f };
         float outPeaks[2] = { 0.0f };
 
-        for (uint32_t i=0; i < audioInCount && i < 2; ++i)
+        if (peaksEnabled)
         {
-            for (uint32_t j=0; j < nframes; ++j)
-            {
-                const float absV(std::abs(audioIn[i][j]));
-
-                if (absV > inPeaks[i])
-                    inPeaks[i] = absV;
-            }
+            for (uint32_t i=0; i < ports.audioInCount && i < 2; ++i)
+                inPeaks[i] = carla_findMaxNormalizedFloat(audioIn[i], nframes);
         }
 
-        plugin->process(audioIn, audioOut, cvIn, cvOut, nframes);
+        {
+            const ScopedPluginDenormals spd(plugin->getOptionsEnabled());
+            const ScopedPluginProcessTimer sppt(pData->plugins[plugin->getId()].processStats, plugin.get());
+            plugin->process(audioIn, audioOut, cvIn, cvOut, nframes);
+        }
 
-        for (uint32_t i=0; i < audioOutCount && i < 2; ++i)
+        if (peaksEnabled)
         {
-            for (uint32_t j=0; j < nframes; ++j)
-            {
-                const float absV(std::abs(audioOut[i][j]));
+            for (uint32_t i=0; i < ports.audioOutCount && i < 2; ++i)
+                outPeaks[i] = carla_findMaxNormalizedFloat(audioOut[i], nframes);
 
-                if (absV > outPeaks[i])
-                    outPeaks[i] = absV;
-            }
+            setPluginPeaksRT(plugin->getId(), inPeaks, outPeaks);
         }
-
-        setPluginPeaksRT(plugin->getId(), inPeaks, outPeaks);
     }
 
 #ifndef BUILD_BRIDGE
@@ -4173,6 +4472,12 @@ private:
 
     bool fIsInternalClient;
 
+    // parallel plugin processing in single-client mode, see processSingleClientCallback()
+    CarlaThreadPool* fSingleClientPool;
+    volatile int fSingleClientNextPlugin;
+    uint32_t fSingleClientFrames;
+    volatile bool fSingleClientInternalConnections;
+
     void postPoneJackCallback(PostPonedJackEvent& ev)
     {
         const CarlaMutexLocker cml(fPostPonedEventsMutex);
@@ -4207,11 +4512,18 @@ private:
                 continue;
             }
 
+            bool connectionsChanged = false;
+
             for (LinkedList<PostPonedJackEvent>::Itenerator it = events.begin2(); it.valid(); it.next())
             {
                 const PostPonedJackEvent& ev(it.getValue(nullEvent));
                 CARLA_SAFE_ASSERT_CONTINUE(ev.type != PostPonedJackEvent::kTypeNull);
 
+                if (ev.type == PostPonedJackEvent::kTypePortConnect ||
+                    ev.type == PostPonedJackEvent::kTypePortDisconnect ||
+                    ev.type == PostPonedJackEvent::kTypePortUnregister)
+                    connectionsChanged = true;
+
                 switch (ev.type)
                 {
                 case PostPonedJackEvent::kTypeNull:
@@ -4254,6 +4566,9 @@ private:
             }
 
             events.clear();
+
+            if (connectionsChanged && fSingleClientPool != nullptr)
+                updateSingleClientInternalConnections();
         }
 
         events.clear();
@@ -4273,12 +4588,11 @@ private:
 
     #define handlePtr ((CarlaEngineJack*)arg)
 
-    static void JACKBRIDGE_API carla_jack_thread_init_callback(void*)
+    static void JACKBRIDGE_API carla_jack_thread_init_callback(void* arg)
     {
-#ifdef __SSE2_MATH__
-        // Set FTZ and DAZ flags
-        _mm_setcsr(_mm_getcsr() | 0x8040);
-#endif
+        // per-plugin clients have no PendingRtEventsRunner, so set FTZ and DAZ flags for the whole thread
+        if (handlePtr->pData->options.flushDenormals)
+            carla_setDenormalsFlushed(true);
     }
 
     static int JACKBRIDGE_API carla_jack_bufsize_callback(jack_nframes_t newBufferSize, void* arg)
@@ -4375,6 +4689,10 @@ private:
         const char* const fullNameB = jackbridge_port_name(portB);
         CARLA_SAFE_ASSERT_RETURN(fullNameB != nullptr && fullNameB[0] != '\0',);
 
+        // stop parallel processing right away, the run thread does the full check later
+        if (connect != 0 && jackbridge_port_is_mine(handlePtr->fClient, portA) && jackbridge_port_is_mine(handlePtr->fClient, portB))
+            handlePtr->fSingleClientInternalConnections = true;
+
         PostPonedJackEvent ev;
         carla_zeroStruct(ev);
 
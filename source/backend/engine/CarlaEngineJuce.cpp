@@ -18,11 +18,10 @@
 #include "CarlaEngineGraph.hpp"
 #include "CarlaEngineInit.hpp"
 #include "CarlaEngineInternal.hpp"
+#include "CarlaEngineMidiInput.hpp"
 #include "CarlaBackendUtils.hpp"
 #include "CarlaStringList.hpp"
 
-#include "RtLinkedList.hpp"
-
 #if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 6))
 # pragma GCC diagnostic push
 # pragma GCC diagnostic ignored "-Wdouble-promotion"
@@ -41,8 +40,27 @@ CARLA_BACKEND_START_NAMESPACE
 
 // -------------------------------------------------------------------------------------------------------------------
 
+// MIDI input queue that receives events directly from a juce device
+struct JuceMidiInputQueue : public EngineMidiInputQueue,
+                            public juce::MidiInputCallback
+{
+    JuceMidiInputQueue() noexcept
+        : EngineMidiInputQueue(),
+          juce::MidiInputCallback() {}
+
+    void handleIncomingMidiMessage(juce::MidiInput* /*source*/, const juce::MidiMessage& message) override
+    {
+        const int messageSize(message.getRawDataSize());
+        CARLA_SAFE_ASSERT_RETURN(messageSize >= 0,);
+
+        // juce timestamps are not relative to the previous event, use time of arrival instead
+        put(message.getRawData(), static_cast<size_t>(messageSize), -1.0);
+    }
+};
+
 struct MidiInPort {
     juce::MidiInput* port;
+    JuceMidiInputQueue* queue;
     char name[STR_MAX+1];
 };
 
@@ -51,20 +69,13 @@ struct MidiOutPort {
     char name[STR_MAX+1];
 };
 
-struct RtMidiEvent {
-    uint64_t time; // needs to compare to internal time
-    uint8_t  size;
-    uint8_t  data[EngineMidiEvent::kDataSize];
-};
-
 // -------------------------------------------------------------------------------------------------------------------
 // Fallback data
 
-static const MidiInPort  kMidiInPortFallback    = { nullptr, { '\0' } };
-static /* */ MidiInPort  kMidiInPortFallbackNC  = { nullptr, { '\0' } };
+static const MidiInPort  kMidiInPortFallback    = { nullptr, nullptr, { '\0' } };
+static /* */ MidiInPort  kMidiInPortFallbackNC  = { nullptr, nullptr, { '\0' } };
 static const MidiOutPort kMidiOutPortFallback   = { nullptr, { '\0' } };
 static /* */ MidiOutPort kMidiOutPortFallbackNC = { nullptr, { '\0' } };
-static const RtMidiEvent kRtMidiEventFallback   = { 0, 0, { 0 } };
 
 // -------------------------------------------------------------------------------------------------------------------
 // Global static data
@@ -122,8 +133,7 @@ static void initJuceDevicesIfNeeded()
 // Juce Engine
 
 class CarlaEngineJuce : public CarlaEngine,
-                        public juce::AudioIODeviceCallback,
-                        public juce::MidiInputCallback
+                        public juce::AudioIODeviceCallback
 {
 public:
     CarlaEngineJuce(juce::AudioIODeviceType* const devType)
@@ -132,7 +142,8 @@ public:
           fDevice(),
           fDeviceType(devType),
           fMidiIns(),
-          fMidiInEvents(),
+          fMidiInMutex(),
+          fMidiInClock(),
           fMidiOuts(),
           fMidiOutMutex()
     {
@@ -224,6 +235,8 @@ public:
         pData->sampleRate = fDevice->getCurrentSampleRate();
         pData->initTime(pData->options.transportExtra);
 
+        fMidiInClock.reset();
+
         pData->graph.create(static_cast<uint32_t>(inputNames.size()),
                             static_cast<uint32_t>(outputNames.size()),
                             0, 0);
@@ -261,6 +274,8 @@ public:
 
         pData->graph.destroy();
 
+        fMidiInMutex.lock();
+
         for (LinkedList<MidiInPort>::Itenerator it = fMidiIns.begin2(); it.valid(); it.next())
         {
             MidiInPort& inPort(it.getValue(kMidiInPortFallbackNC));
@@ -268,10 +283,11 @@ public:
 
             inPort.port->stop();
             delete inPort.port;
+            delete inPort.queue;
         }
 
         fMidiIns.clear();
-        fMidiInEvents.clear();
+        fMidiInMutex.unlock();
 
         fMidiOutMutex.lock();
 
@@ -599,38 +615,27 @@ protected:
         carla_zeroStructs(pData->events.in,  kMaxEngineEventInternalCount);
         carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
 
-        if (fMidiInEvents.mutex.tryLock())
-        {
-            uint32_t engineEventIndex = 0;
-            fMidiInEvents.splice();
+        fMidiInClock.cycle(nframes, pData->sampleRate);
 
-            for (LinkedList<RtMidiEvent>::Itenerator it = fMidiInEvents.data.begin2(); it.valid(); it.next())
+        if (fMidiInMutex.tryLock())
+        {
+            if (const std::size_t numQueues = fMidiIns.count())
             {
-                const RtMidiEvent& midiEvent(it.getValue(kRtMidiEventFallback));
-                CARLA_SAFE_ASSERT_CONTINUE(midiEvent.size > 0);
+                EngineMidiInputQueue* queues[numQueues];
+                uint i = 0;
 
-                EngineEvent& engineEvent(pData->events.in[engineEventIndex++]);
-
-                if (midiEvent.time < pData->timeInfo.frame)
+                for (LinkedList<MidiInPort>::Itenerator it = fMidiIns.begin2(); it.valid(); it.next())
                 {
-                    engineEvent.time = 0;
-                }
-                else if (midiEvent.time >= pData->timeInfo.frame + nframes)
-                {
-                    carla_stderr("MIDI Event in the future!, %i vs %i", engineEvent.time, pData->timeInfo.frame);
-                    engineEvent.time = static_cast<uint32_t>(pData->timeInfo.frame) + nframes - 1;
-                }
-                else
-                    engineEvent.time = static_cast<uint32_t>(midiEvent.time - pData->timeInfo.frame);
+                    const MidiInPort& inPort(it.getValue(kMidiInPortFallback));
+                    CARLA_SAFE_ASSERT_CONTINUE(inPort.queue != nullptr);
 
-                engineEvent.fillFromMidiData(midiEvent.size, midiEvent.data, 0);
+                    queues[i++] = inPort.queue;
+                }
 
-                if (engineEventIndex >= kMaxEngineEventInternalCount)
-                    break;
+                fMidiInClock.fillEngineEvents(queues, i, pData->events.in, kMaxEngineEventInternalCount);
             }
 
-            fMidiInEvents.data.clear();
-            fMidiInEvents.mutex.unlock();
+            fMidiInMutex.unlock();
         }
 
         pData->graph.process(pData, inputChannelData, outputChannelData, nframes);
@@ -705,31 +710,6 @@ protected:
 
     // -------------------------------------------------------------------
 
-    void handleIncomingMidiMessage(juce::MidiInput* /*source*/, const juce::MidiMessage& message) override
-    {
-        const int messageSize(message.getRawDataSize());
-
-        if (messageSize <= 0 || messageSize > EngineMidiEvent::kDataSize)
-            return;
-
-        const uint8_t* const messageData(message.getRawData());
-
-        RtMidiEvent midiEvent;
-        midiEvent.time = 0; // TODO
-
-        midiEvent.size = static_cast<uint8_t>(messageSize);
-
-        int i=0;
-        for (; i < messageSize; ++i)
-            midiEvent.data[i] = messageData[i];
-        for (; i < EngineMidiEvent::kDataSize; ++i)
-            midiEvent.data[i] = 0;
-
-        fMidiInEvents.append(midiEvent);
-    }
-
-    // -------------------------------------------------------------------
-
     bool connectExternalGraphPort(const uint connectionType, const uint portId, const char* const portName) override
     {
         CARLA_SAFE_ASSERT_RETURN(connectionType != 0 || (portName != nullptr && portName[0] != '\0'), false);
@@ -749,15 +729,19 @@ protected:
             if (! midiIns.contains(portName))
                 return false;
 
-            std::unique_ptr<juce::MidiInput> juceMidiIn(juce::MidiInput::openDevice(midiIns.indexOf(portName), this));
+            std::unique_ptr<JuceMidiInputQueue> queue(new JuceMidiInputQueue());
+            std::unique_ptr<juce::MidiInput> juceMidiIn(juce::MidiInput::openDevice(midiIns.indexOf(portName), queue.get()));
             juceMidiIn->start();
 
             MidiInPort midiPort;
-            midiPort.port = juceMidiIn.release();
+            midiPort.port  = juceMidiIn.release();
+            midiPort.queue = queue.release();
 
             std::strncpy(midiPort.name, portName, STR_MAX);
             midiPort.name[STR_MAX] = '\0';
 
+            const CarlaMutexLocker cml(fMidiInMutex);
+
             fMidiIns.append(midiPort);
             return true;
         }   break;
@@ -812,7 +796,14 @@ protected:
                 inPort.port->stop();
                 delete inPort.port;
 
-                fMidiIns.remove(it);
+                JuceMidiInputQueue* const queue(inPort.queue);
+
+                {
+                    const CarlaMutexLocker cml(fMidiInMutex);
+                    fMidiIns.remove(it);
+                }
+
+                delete queue;
                 return true;
             }
             break;
@@ -846,47 +837,9 @@ private:
     CarlaScopedPointer<juce::AudioIODevice> fDevice;
     juce::AudioIODeviceType* const fDeviceType;
 
-    struct RtMidiEvents {
-        CarlaMutex mutex;
-        RtLinkedList<RtMidiEvent>::Pool dataPool;
-        RtLinkedList<RtMidiEvent> data;
-        RtLinkedList<RtMidiEvent> dataPending;
-
-        RtMidiEvents()
-            : mutex(),
-              dataPool(512, 512),
-              data(dataPool),
-              dataPending(dataPool) {}
-
-        ~RtMidiEvents()
-        {
-            clear();
-        }
-
-        void append(const RtMidiEvent& event)
-        {
-            mutex.lock();
-            dataPending.append(event);
-            mutex.unlock();
-        }
-
-        void clear()
-        {
-            mutex.lock();
-            data.clear();
-            dataPending.clear();
-            mutex.unlock();
-        }
-
-        void splice()
-        {
-            if (dataPending.count() > 0)
-                dataPending.moveTo(data, true /* append */);
-        }
-    };
-
     LinkedList<MidiInPort> fMidiIns;
-    RtMidiEvents           fMidiInEvents;
+    CarlaMutex             fMidiInMutex;
+    EngineMidiInputClock   fMidiInClock;
 
     LinkedList<MidiOutPort> fMidiOuts;
     CarlaMutex              fMidiOutMutex;
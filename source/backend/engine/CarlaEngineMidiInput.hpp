@@ -0,0 +1,303 @@
+/*
+ * Carla Plugin Host
+ * Copyright (C) 2011-2019 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_ENGINE_MIDI_INPUT_HPP_INCLUDED
+#define CARLA_ENGINE_MIDI_INPUT_HPP_INCLUDED
+
+#include "CarlaEngine.hpp"
+#include "CarlaUtils.hpp"
+
+#include <cmath>
+
+#if defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN)
+# include <sys/time.h>
+#else
+# include <ctime>
+#endif
+
+CARLA_BACKEND_START_NAMESPACE
+
+// -----------------------------------------------------------------------
+// EngineMidiInputQueue
+
+/*
+ * Lock-free queue of incoming MIDI events for a single input device.
+ * put() is only called from the MIDI driver thread, front() and pop() only from the audio thread.
+ * Events are stamped with the system monotonic clock, in microseconds.
+ */
+class EngineMidiInputQueue
+{
+public:
+    static const uint32_t kMaxEvents = 512; // must be power of 2
+
+    struct Event {
+        int64_t time;
+        uint8_t size;
+        uint8_t data[EngineMidiEvent::kDataSize];
+    };
+
+    EngineMidiInputQueue() noexcept
+        : fReadIndex(0),
+          fWriteIndex(0),
+          fDriverTimeAnchor(0),
+          fDriverTime(0.0)
+    {
+        carla_zeroStructs(fEvents, kMaxEvents);
+    }
+
+    virtual ~EngineMidiInputQueue() noexcept {}
+
+    /*
+     * Push a new event into the queue, dropping it if full.
+     * deltaTime is the time in seconds since the previous event as reported by the driver,
+     * or a negative value if the driver does not provide timestamps.
+     */
+    bool put(const uint8_t* const data, const size_t size, const double deltaTime) noexcept
+    {
+        if (size == 0 || size > EngineMidiEvent::kDataSize)
+            return false;
+
+        const int64_t now = getCurrentTime();
+        int64_t time = now;
+
+        if (deltaTime >= 0.0 && fDriverTimeAnchor != 0)
+        {
+            fDriverTime += deltaTime;
+
+            const int64_t driverTime = fDriverTimeAnchor + static_cast<int64_t>(fDriverTime * 1000000.0);
+
+            // trust driver timestamps as long as they stay close to the system clock
+            if (driverTime <= now && now - driverTime < kMaxDriverLatency)
+                time = driverTime;
+            else
+                fDriverTimeAnchor = 0;
+        }
+
+        if (fDriverTimeAnchor == 0)
+        {
+            fDriverTimeAnchor = now;
+            fDriverTime = 0.0;
+        }
+
+        const uint32_t writeIndex = fWriteIndex;
+        const uint32_t nextIndex  = (writeIndex + 1) & (kMaxEvents - 1);
+
+        if (nextIndex == __sync_fetch_and_add(&fReadIndex, 0))
+            return false;
+
+        Event& event(fEvents[writeIndex]);
+        event.time = time;
+        event.size = static_cast<uint8_t>(size);
+
+        size_t i=0;
+        for (; i < size; ++i)
+            event.data[i] = data[i];
+        for (; i < EngineMidiEvent::kDataSize; ++i)
+            event.data[i] = 0;
+
+        __sync_synchronize();
+        fWriteIndex = nextIndex;
+        return true;
+    }
+
+    const Event* front() const noexcept
+    {
+        const uint32_t readIndex = fReadIndex;
+
+        if (readIndex == __sync_fetch_and_add(const_cast<uint32_t*>(&fWriteIndex), 0))
+            return nullptr;
+
+        return &fEvents[readIndex];
+    }
+
+    void pop() noexcept
+    {
+        const uint32_t readIndex = fReadIndex;
+        CARLA_SAFE_ASSERT_RETURN(readIndex != fWriteIndex,);
+
+        __sync_synchronize();
+        fReadIndex = (readIndex + 1) & (kMaxEvents - 1);
+    }
+
+    static int64_t getCurrentTime() noexcept
+    {
+#if defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN)
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+
+        return (tv.tv_sec * 1000000) + tv.tv_usec;
+#else
+        struct timespec ts;
+# ifdef CLOCK_MONOTONIC_RAW
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+# else
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+# endif
+
+        return (ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+#endif
+    }
+
+private:
+    // max time in usecs between a driver timestamp and event arrival before re-syncing
+    static const int64_t kMaxDriverLatency = 50000;
+
+    volatile uint32_t fReadIndex;
+    volatile uint32_t fWriteIndex;
+    Event fEvents[kMaxEvents];
+
+    // writer-side only
+    int64_t fDriverTimeAnchor;
+    double  fDriverTime;
+
+    CARLA_DECLARE_NON_COPY_CLASS(EngineMidiInputQueue)
+};
+
+// -----------------------------------------------------------------------
+// EngineMidiInputClock
+
+/*
+ * Delay-locked loop that models the audio callback clock, used to map MIDI event times into frame offsets.
+ * Events are delayed by exactly one period, so they keep their relative timing instead of landing at block boundaries.
+ * Only used from the audio thread.
+ */
+class EngineMidiInputClock
+{
+public:
+    EngineMidiInputClock() noexcept
+        : fRunning(false),
+          fFrames(0),
+          fB(0.0),
+          fC(0.0),
+          fPeriod(0.0),
+          fCurrTime(0.0),
+          fNextTime(0.0) {}
+
+    void reset() noexcept
+    {
+        fRunning = false;
+    }
+
+    // must be called at the start of each audio cycle
+    void cycle(const uint32_t frames, const double sampleRate) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(frames > 0,);
+        CARLA_SAFE_ASSERT_RETURN(sampleRate > 0.0,);
+
+        const double now = static_cast<double>(EngineMidiInputQueue::getCurrentTime());
+
+        if (fRunning && frames == fFrames)
+        {
+            const double error = now - fNextTime;
+
+            // only keep filtering if we did not skip a cycle (xrun or device stall)
+            if (std::abs(error) < fPeriod)
+            {
+                fCurrTime  = fNextTime;
+                fNextTime += fB * error + fPeriod;
+                fPeriod   += fC * error;
+                return;
+            }
+        }
+
+        const double period = 1000000.0 * frames / sampleRate;
+        const double omega  = 2.0 * M_PI * kBandwidthHz * period / 1000000.0;
+
+        fRunning  = true;
+        fFrames   = frames;
+        fB        = std::sqrt(2.0) * omega;
+        fC        = omega * omega;
+        fPeriod   = period;
+        fCurrTime = now;
+        fNextTime = now + period;
+    }
+
+    /*
+     * Move events from all queues into engine events, ordered by time.
+     * Events that arrived after the current cycle started are kept for the next one.
+     */
+    uint32_t fillEngineEvents(EngineMidiInputQueue* const* const queues, const uint numQueues,
+                              EngineEvent* const engineEvents, const uint32_t maxEvents) const noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(fRunning, 0);
+
+        const double period = fNextTime - fCurrTime;
+        const double start  = fCurrTime - period;
+
+        uint32_t engineEventIndex = 0;
+
+        for (; engineEventIndex < maxEvents; ++engineEventIndex)
+        {
+            EngineMidiInputQueue* nextQueue = nullptr;
+            const EngineMidiInputQueue::Event* nextEvent = nullptr;
+
+            for (uint i=0; i < numQueues; ++i)
+            {
+                const EngineMidiInputQueue::Event* const event = queues[i]->front();
+
+                if (event == nullptr || static_cast<double>(event->time) >= fCurrTime)
+                    continue;
+                if (nextEvent != nullptr && nextEvent->time <= event->time)
+                    continue;
+
+                nextQueue = queues[i];
+                nextEvent = event;
+            }
+
+            if (nextEvent == nullptr)
+                break;
+
+            const double time = static_cast<double>(nextEvent->time);
+            uint32_t frame = 0;
+
+            if (time > start)
+            {
+                frame = static_cast<uint32_t>((time - start) / period * fFrames);
+
+                if (frame >= fFrames)
+                    frame = fFrames - 1;
+            }
+
+            EngineEvent& engineEvent(engineEvents[engineEventIndex]);
+            engineEvent.time = frame;
+            engineEvent.fillFromMidiData(nextEvent->size, nextEvent->data, 0);
+
+            nextQueue->pop();
+        }
+
+        return engineEventIndex;
+    }
+
+private:
+    // DLL bandwidth, low enough to filter out callback wake-up jitter
+    static const int kBandwidthHz = 1;
+
+    bool     fRunning;
+    uint32_t fFrames;
+    double   fB, fC;
+    double   fPeriod;
+    double   fCurrTime;
+    double   fNextTime;
+
+    CARLA_DECLARE_NON_COPY_CLASS(EngineMidiInputClock)
+};
+
+// -----------------------------------------------------------------------
+
+CARLA_BACKEND_END_NAMESPACE
+
+#endif // CARLA_ENGINE_MIDI_INPUT_HPP_INCLUDED
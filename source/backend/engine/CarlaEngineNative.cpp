@@ -180,6 +180,10 @@ public:
 #endif
           kIsPatchbay(isPatchbay),
           kHasMidiOut(withMidiOut),
+          kNumInputs(inChan + cvIns),
+          kNumOutputs((outChan != 0 ? outChan : inChan) + cvOuts),
+          fSubBlockIns(new const float*[kNumInputs]),
+          fSubBlockOuts(new float*[kNumOutputs]),
           fIsActive(false),
           fIsRunning(false),
           fUiServer(this),
@@ -263,6 +267,9 @@ public:
             fJuceMsgThread->decRef();
 #endif
 
+        delete[] fSubBlockIns;
+        delete[] fSubBlockOuts;
+
         carla_debug("CarlaEngineNative::~CarlaEngineNative() - END");
     }
 
@@ -471,10 +478,7 @@ protected:
                 char tmpBuf[STR_MAX+1];
                 carla_zeroChars(tmpBuf, STR_MAX+1);
 
-                {
-                    const CarlaScopedLocale csl;
-                    std::snprintf(tmpBuf, STR_MAX, "%.12g\n", newSampleRate);
-                }
+                std::snprintf(tmpBuf, STR_MAX, "%s\n", CarlaFloatString(newSampleRate).buffer);
 
                 if (fUiServer.writeMessage(tmpBuf))
                     fUiServer.flushMessages();
@@ -573,7 +577,6 @@ protected:
         carla_zeroChars(tmpBuf, STR_MAX+1);
 
         const CarlaMutexLocker cml(fUiServer.getPipeLock());
-        const CarlaScopedLocale csl;
 
         const uint pluginId(plugin->getId());
 
@@ -582,7 +585,7 @@ protected:
             std::snprintf(tmpBuf, STR_MAX, "PARAMVAL_%u:%i\n", pluginId, i);
             CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
-            std::snprintf(tmpBuf, STR_MAX, "%.12g\n", static_cast<double>(plugin->getInternalParameterValue(i)));
+            std::snprintf(tmpBuf, STR_MAX, "%s\n", CarlaFloatString(plugin->getInternalParameterValue(i)).buffer);
             CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
             fUiServer.flushMessages();
@@ -607,8 +610,8 @@ protected:
                                                             paramData.mappedControlIndex, paramData.midiChannel);
             CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
-            std::snprintf(tmpBuf, STR_MAX, "%.12g:%.12g\n", static_cast<double>(paramData.mappedMinimum),
-                                                            static_cast<double>(paramData.mappedMaximum));
+            std::snprintf(tmpBuf, STR_MAX, "%s:%s\n", CarlaFloatString(paramData.mappedMinimum).buffer,
+                                                      CarlaFloatString(paramData.mappedMaximum).buffer);
             CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
             if (plugin->getParameterName(i, tmpBuf)) {
@@ -638,19 +641,19 @@ protected:
             std::snprintf(tmpBuf, STR_MAX, "PARAMETER_RANGES_%i:%i\n", pluginId, i);
             CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
-            std::snprintf(tmpBuf, STR_MAX, "%.12g:%.12g:%.12g:%.12g:%.12g:%.12g\n",
-                          static_cast<double>(paramRanges.def),
-                          static_cast<double>(paramRanges.min),
-                          static_cast<double>(paramRanges.max),
-                          static_cast<double>(paramRanges.step),
-                          static_cast<double>(paramRanges.stepSmall),
-                          static_cast<double>(paramRanges.stepLarge));
+            std::snprintf(tmpBuf, STR_MAX, "%s:%s:%s:%s:%s:%s\n",
+                          CarlaFloatString(paramRanges.def).buffer,
+                          CarlaFloatString(paramRanges.min).buffer,
+                          CarlaFloatString(paramRanges.max).buffer,
+                          CarlaFloatString(paramRanges.step).buffer,
+                          CarlaFloatString(paramRanges.stepSmall).buffer,
+                          CarlaFloatString(paramRanges.stepLarge).buffer);
             CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
             std::snprintf(tmpBuf, STR_MAX, "PARAMVAL_%u:%u\n", pluginId, i);
             CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
-            std::snprintf(tmpBuf, STR_MAX, "%.12g\n", static_cast<double>(plugin->getParameterValue(i)));
+            std::snprintf(tmpBuf, STR_MAX, "%s\n", CarlaFloatString(plugin->getParameterValue(i)).buffer);
             CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
         }
 
@@ -831,10 +834,7 @@ protected:
         std::snprintf(tmpBuf, STR_MAX, "%i\n", value3);
         CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
-        {
-            const CarlaScopedLocale csl;
-            std::snprintf(tmpBuf, STR_MAX, "%.12g\n", static_cast<double>(valuef));
-        }
+        std::snprintf(tmpBuf, STR_MAX, "%s\n", CarlaFloatString(valuef).buffer);
         CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
         if (valueStr != nullptr) {
@@ -871,10 +871,7 @@ protected:
         CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
         CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage("sample-rate\n"),);
-        {
-            const CarlaScopedLocale csl;
-            std::snprintf(tmpBuf, STR_MAX, "%.12g\n", pData->sampleRate);
-        }
+        std::snprintf(tmpBuf, STR_MAX, "%s\n", CarlaFloatString(pData->sampleRate).buffer);
         CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
         fUiServer.flushMessages();
@@ -1111,19 +1108,74 @@ protected:
         //runPendingRtEvents();
     }
 
+    // move time info forward, used for blocks that start in the middle of the host one
+    void advanceTimeInfo(const uint32_t frames) noexcept
+    {
+        EngineTimeInfo& timeInfo(pData->timeInfo);
+
+        timeInfo.frame += frames;
+        timeInfo.usecs += static_cast<uint64_t>(frames / pData->sampleRate * 1000000.0);
+
+        if (! timeInfo.bbt.valid)
+            return;
+
+        EngineTimeInfoBBT& bbt(timeInfo.bbt);
+        CARLA_SAFE_ASSERT_RETURN(bbt.ticksPerBeat > 0.0 && bbt.beatsPerBar > 0.0f,);
+
+        bbt.tick += frames / pData->sampleRate * bbt.beatsPerMinute / 60.0 * bbt.ticksPerBeat;
+
+        while (bbt.tick >= bbt.ticksPerBeat)
+        {
+            bbt.tick -= bbt.ticksPerBeat;
+
+            if (++bbt.beat > static_cast<int32_t>(bbt.beatsPerBar + 0.5f))
+            {
+                bbt.beat = 1;
+                ++bbt.bar;
+                bbt.barStartTick += bbt.beatsPerBar * bbt.ticksPerBeat;
+            }
+        }
+    }
+
     void process(const float* const* const inBuffer, float** const outBuffer, const uint32_t frames,
                  const NativeMidiEvent* const midiEvents, const uint32_t midiEventCount)
     {
-        if (frames > pData->bufferSize)
+        const uint32_t bufferSize = pData->bufferSize;
+
+        if (frames <= bufferSize)
+            return processBlock(inBuffer, outBuffer, frames, 0, midiEvents, midiEventCount);
+
+        CARLA_SAFE_ASSERT_RETURN(bufferSize != 0,);
+
+        // Some hosts send blocks bigger than the size they announced (automation splits, loop points, etc).
+        // Reallocating buffers here would glitch, so run those as several blocks of the known size instead.
+        uint32_t midiEventIndex = 0;
+
+        for (uint32_t offset = 0; offset < frames; offset += bufferSize)
         {
-            carla_stderr2("Host is calling process with too high number of frames! %u vs %u",
-                          frames, pData->bufferSize);
+            const uint32_t subFrames = std::min(bufferSize, frames - offset);
+
+            for (uint32_t i=0; i < kNumInputs; ++i)
+                fSubBlockIns[i] = inBuffer[i] + offset;
+
+            for (uint32_t i=0; i < kNumOutputs; ++i)
+                fSubBlockOuts[i] = outBuffer[i] + offset;
 
-            deactivate();
-            bufferSizeChanged(frames);
-            activate();
+            // host MIDI events are sorted by time
+            const uint32_t firstMidiEvent = midiEventIndex;
+
+            while (midiEventIndex < midiEventCount && midiEvents[midiEventIndex].time < offset + subFrames)
+                ++midiEventIndex;
+
+            processBlock(fSubBlockIns, fSubBlockOuts, subFrames, offset,
+                         midiEvents + firstMidiEvent, midiEventIndex - firstMidiEvent);
         }
+    }
 
+    // frameOffset is the position of this block within the host one, non-zero when splitting
+    void processBlock(const float* const* const inBuffer, float* const* const outBuffer, const uint32_t frames,
+                      const uint32_t frameOffset, const NativeMidiEvent* const midiEvents, const uint32_t midiEventCount)
+    {
         const PendingRtEventsRunner prt(this, frames, true);
 
         // ---------------------------------------------------------------
@@ -1150,6 +1202,11 @@ protected:
             pData->timeInfo.bbt.beatsPerMinute = timeInfo->bbt.beatsPerMinute;
         }
 
+        if (frameOffset != 0 && timeInfo->playing)
+            advanceTimeInfo(frameOffset);
+
+        pData->timeInfo.bbt.updatePPQ();
+
         // ---------------------------------------------------------------
         // Do nothing if no plugins and rack mode
 
@@ -1170,28 +1227,22 @@ protected:
         }
 
         // ---------------------------------------------------------------
-        // initialize events
-
-        carla_zeroStructs(pData->events.in,  kMaxEngineEventInternalCount);
-        carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
-
-        // ---------------------------------------------------------------
-        // events input (before processing)
+        // events input (before processing), buffers only need to be terminated after the last event
 
         {
-            uint32_t engineEventIndex = 0;
+            const uint32_t engineEventCount = std::min(midiEventCount, static_cast<uint32_t>(kMaxEngineEventInternalCount));
 
-            for (uint32_t i=0; i < midiEventCount && engineEventIndex < kMaxEngineEventInternalCount; ++i)
+            for (uint32_t i=0; i < engineEventCount; ++i)
             {
                 const NativeMidiEvent& midiEvent(midiEvents[i]);
-                EngineEvent&           engineEvent(pData->events.in[engineEventIndex++]);
+                EngineEvent&           engineEvent(pData->events.in[i]);
 
-                engineEvent.time = midiEvent.time;
+                engineEvent.time = midiEvent.time >= frameOffset ? midiEvent.time - frameOffset : 0;
                 engineEvent.fillFromMidiData(midiEvent.size, midiEvent.data, 0);
-
-                if (engineEventIndex >= kMaxEngineEventInternalCount)
-                    break;
             }
+
+            terminateEngineEvents(pData->events.in, engineEventCount);
+            clearEngineEvents(pData->events.out);
         }
 
         if (kIsPatchbay)
@@ -1218,7 +1269,7 @@ protected:
         // ---------------------------------------------------------------
         // events output (after processing)
 
-        carla_zeroStructs(pData->events.in, kMaxEngineEventInternalCount);
+        clearEngineEvents(pData->events.in);
 
         if (kHasMidiOut)
         {
@@ -1232,7 +1283,7 @@ protected:
                     break;
 
                 carla_zeroStruct(midiEvent);
-                midiEvent.time = engineEvent.time;
+                midiEvent.time = engineEvent.time + frameOffset;
 
                 /**/ if (engineEvent.type == kEngineEventTypeControl)
                 {
@@ -1426,13 +1477,12 @@ protected:
         carla_zeroChars(tmpBuf, STR_MAX+1);
 
         const CarlaMutexLocker cml(fUiServer.getPipeLock());
-        const CarlaScopedLocale csl;
         const EngineTimeInfo& timeInfo(pData->timeInfo);
 
         // ------------------------------------------------------------------------------------------------------------
         // send engine info
 
-        std::snprintf(tmpBuf, STR_MAX, "%.12g:0\n", static_cast<double>(getDSPLoad()));
+        std::snprintf(tmpBuf, STR_MAX, "%s:0\n", CarlaFloatString(getDSPLoad()).buffer);
         CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage("runtime-info\n"),);
         CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
@@ -1463,7 +1513,7 @@ protected:
                                                                    timeInfo.bbt.beat,
                                                                    static_cast<int>(timeInfo.bbt.tick + 0.5));
             CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
-            std::snprintf(tmpBuf, STR_MAX, "%.12g\n", timeInfo.bbt.beatsPerMinute);
+            std::snprintf(tmpBuf, STR_MAX, "%s\n", CarlaFloatString(timeInfo.bbt.beatsPerMinute).buffer);
             CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
         }
         else
@@ -1480,16 +1530,18 @@ protected:
 
         for (uint i=0; i < pData->curPluginCount; ++i)
         {
-            const EnginePluginData& plugData(pData->plugins[i]);
+            EnginePluginData& plugData(pData->plugins[i]);
             const CarlaPluginPtr plugin = pData->plugins[i].plugin;
 
+            plugData.markPeaksWatched();
+
             std::snprintf(tmpBuf, STR_MAX, "PEAKS_%i\n", i);
             CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
-            std::snprintf(tmpBuf, STR_MAX, "%.12g:%.12g:%.12g:%.12g\n",
-                          static_cast<double>(plugData.peaks[0]),
-                          static_cast<double>(plugData.peaks[1]),
-                          static_cast<double>(plugData.peaks[2]),
-                          static_cast<double>(plugData.peaks[3]));
+            std::snprintf(tmpBuf, STR_MAX, "%s:%s:%s:%s\n",
+                          CarlaFloatString(plugData.peaks[0]).buffer,
+                          CarlaFloatString(plugData.peaks[1]).buffer,
+                          CarlaFloatString(plugData.peaks[2]).buffer,
+                          CarlaFloatString(plugData.peaks[3]).buffer);
             CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
             fUiServer.flushMessages();
@@ -1501,7 +1553,7 @@ protected:
 
                 std::snprintf(tmpBuf, STR_MAX, "PARAMVAL_%u:%u\n", i, j);
                 CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
-                std::snprintf(tmpBuf, STR_MAX, "%.12g\n", static_cast<double>(plugin->getParameterValue(j)));
+                std::snprintf(tmpBuf, STR_MAX, "%s\n", CarlaFloatString(plugin->getParameterValue(j)).buffer);
                 CARLA_SAFE_ASSERT_RETURN(fUiServer.writeMessage(tmpBuf),);
 
                 fUiServer.flushMessages();
@@ -1714,6 +1766,12 @@ private:
 
     const bool kIsPatchbay; // rack if false
     const bool kHasMidiOut;
+
+    // audio + cv ports, used for splitting big host blocks
+    const uint32_t kNumInputs, kNumOutputs;
+    const float** const fSubBlockIns;
+    float** const fSubBlockOuts;
+
     bool fIsActive, fIsRunning;
     CarlaEngineNativeUI fUiServer;
 
@@ -2196,8 +2254,9 @@ bool CarlaEngineNativeUI::msgReceived(const char* const msg) noexcept
 
         if (const CarlaPluginPtr plugin = fEngine->getPlugin(pluginId))
         {
-            plugin->setProgram(index, true, true, false);
-            _updateParamValues(plugin, pluginId, true, true);
+            // once the audio thread applied a deferred change, the post-RT event sends the new parameter values
+            if (! plugin->requestProgramChange(index, true, true, false))
+                _updateParamValues(plugin, pluginId, true, true);
         }
     }
     else if (std::strcmp(msg, "set_midi_program") == 0)
@@ -2210,8 +2269,9 @@ bool CarlaEngineNativeUI::msgReceived(const char* const msg) noexcept
 
         if (const CarlaPluginPtr plugin = fEngine->getPlugin(pluginId))
         {
-            plugin->setMidiProgram(index, true, true, false);
-            _updateParamValues(plugin, pluginId, true, true);
+            // see set_program above
+            if (! plugin->requestMidiProgramChange(index, true, true, false))
+                _updateParamValues(plugin, pluginId, true, true);
         }
     }
     else if (std::strcmp(msg, "set_custom_data") == 0)
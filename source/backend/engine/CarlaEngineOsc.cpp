@@ -28,12 +28,24 @@ CARLA_BACKEND_START_NAMESPACE
 CarlaEngineOsc::CarlaEngineOsc(CarlaEngine* const engine) noexcept
     : fEngine(engine),
       fControlDataTCP(),
-      fControlDataUDP(),
+      fTcpBundleSender(nullptr),
+      fTcpBundleLevel(0),
+      fTcpBundleMutex(),
+      fUdpClients(),
+      fNumUdpClients(0),
+      fUdpClientsMutex(),
       fName(),
       fServerPathTCP(),
       fServerPathUDP(),
       fServerTCP(nullptr),
-      fServerUDP(nullptr)
+      fServerUDP(nullptr),
+      fUdpThread(*this),
+      fUdpDispatchMutex(),
+      fUdpDeferred(),
+      fUdpDeferredMutex(),
+      fUdpRtQueue(),
+      fUdpRtPending(),
+      fUdpRtHasPending(false)
 {
     CARLA_SAFE_ASSERT(engine != nullptr);
     carla_debug("CarlaEngineOsc::CarlaEngineOsc(%p)", engine);
@@ -46,6 +58,7 @@ CarlaEngineOsc::~CarlaEngineOsc() noexcept
     CARLA_SAFE_ASSERT(fServerPathUDP.isEmpty());
     CARLA_SAFE_ASSERT(fServerTCP == nullptr);
     CARLA_SAFE_ASSERT(fServerUDP == nullptr);
+    CARLA_SAFE_ASSERT(fTcpBundleSender == nullptr);
     carla_debug("CarlaEngineOsc::~CarlaEngineOsc()");
 }
 
@@ -144,6 +157,9 @@ void CarlaEngineOsc::init(const char* const name, int tcpPort, int udpPort) noex
 
         lo_server_add_method(fServerUDP, nullptr, nullptr, osc_message_handler_UDP, this);
         carla_debug("OSC UDP server running and listening at %s", fServerPathUDP.buffer());
+
+        fUdpDeferred.createBuffer(kMaxDeferredUdpMessageSize * 4);
+        fUdpThread.startThread();
     }
 
     // ----------------------------------------------------------------------------------------------------------------
@@ -151,7 +167,7 @@ void CarlaEngineOsc::init(const char* const name, int tcpPort, int udpPort) noex
     CARLA_SAFE_ASSERT(fName.isNotEmpty());
 }
 
-void CarlaEngineOsc::idle() const noexcept
+void CarlaEngineOsc::idle() noexcept
 {
     if (fServerTCP != nullptr)
     {
@@ -164,7 +180,11 @@ void CarlaEngineOsc::idle() const noexcept
         }
     }
 
-    if (fServerUDP != nullptr)
+    if (fServerUDP == nullptr)
+        return;
+
+    // only if the receive thread failed to start
+    if (! fUdpThread.isThreadRunning())
     {
         for (;;)
         {
@@ -174,12 +194,54 @@ void CarlaEngineOsc::idle() const noexcept
             } CARLA_SAFE_EXCEPTION_CONTINUE("OSC idle UDP")
         }
     }
+
+    // messages the receive thread did not handle itself
+    uint8_t data[kMaxDeferredUdpMessageSize];
+
+    for (;;)
+    {
+        uint32_t size;
+
+        {
+            const CarlaMutexLocker cml(fUdpDeferredMutex);
+
+            if (! fUdpDeferred.isDataAvailableForReading())
+                break;
+
+            size = fUdpDeferred.readUInt();
+            CARLA_SAFE_ASSERT_UINT2_BREAK(size > 0 && size <= kMaxDeferredUdpMessageSize,
+                                          size, kMaxDeferredUdpMessageSize);
+
+            fUdpDeferred.readCustomData(data, size);
+        }
+
+        try {
+            lo_server_dispatch_data(fServerUDP, data, size);
+        } CARLA_SAFE_EXCEPTION_CONTINUE("OSC idle UDP deferred")
+    }
+}
+
+void CarlaEngineOsc::suspendUdpDispatch() noexcept
+{
+    fUdpDispatchMutex.lock();
+}
+
+void CarlaEngineOsc::resumeUdpDispatch() noexcept
+{
+    fUdpDispatchMutex.unlock();
+}
+
+bool CarlaEngineOsc::isUdpReceiveThread() const noexcept
+{
+    return fUdpThread.isThreadRunning() && pthread_equal(fUdpThread.getThreadId(), pthread_self()) != 0;
 }
 
 void CarlaEngineOsc::close() noexcept
 {
     carla_debug("CarlaEngineOsc::close()");
 
+    fUdpThread.stopThread(-1);
+
     if (fControlDataTCP.target != nullptr)
         sendExit();
 
@@ -197,13 +259,69 @@ void CarlaEngineOsc::close() noexcept
         lo_server_del_method(fServerUDP, nullptr, nullptr);
         lo_server_free(fServerUDP);
         fServerUDP = nullptr;
+
+        fUdpDeferred.deleteBuffer();
     }
 
     fServerPathTCP.clear();
     fServerPathUDP.clear();
 
     fControlDataTCP.clear();
-    fControlDataUDP.clear();
+
+    const CarlaMutexLocker cml(fUdpClientsMutex);
+
+    for (uint i=0; i < kMaxUdpClients; ++i)
+        fUdpClients[i].clear();
+
+    fNumUdpClients = 0;
+}
+
+// -----------------------------------------------------------------------
+
+void CarlaEngineOsc::UdpReceiveThread::run()
+{
+    const lo_server server = kOsc.fServerUDP;
+    CARLA_SAFE_ASSERT_RETURN(server != nullptr,);
+
+    while (! shouldThreadExit())
+    {
+        // wake up regularly to check if we should exit
+        if (lo_server_wait(server, 50) <= 0)
+            continue;
+
+        const CarlaRecursiveMutexLocker crml(kOsc.fUdpDispatchMutex);
+
+        for (;;)
+        {
+            try {
+                if (lo_server_recv_noblock(server, 0) == 0)
+                    break;
+            } CARLA_SAFE_EXCEPTION_CONTINUE("OSC UDP receive")
+        }
+    }
+}
+
+// -----------------------------------------------------------------------
+
+CarlaEngineOsc::UdpClient::UdpClient() noexcept
+    : data(),
+      updateInterval(0),
+      epsilon(0.0f),
+      lastUpdateTime(0),
+      lastFullUpdateTime(0),
+      plugins() {}
+
+void CarlaEngineOsc::UdpClient::clear() noexcept
+{
+    data.clear();
+    updateInterval = 0;
+    epsilon = 0.0f;
+    lastUpdateTime = 0;
+    lastFullUpdateTime = 0;
+
+    try {
+        plugins.clear();
+    } CARLA_SAFE_EXCEPTION("UdpClient::clear");
 }
 
 // -----------------------------------------------------------------------
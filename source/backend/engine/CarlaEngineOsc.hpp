@@ -24,9 +24,14 @@
 
 #include "CarlaBackend.h"
 #include "CarlaJuceUtils.hpp"
+#include "CarlaMutex.hpp"
 #include "CarlaPluginPtr.hpp"
 #include "CarlaOscUtils.hpp"
+#include "CarlaRingBuffer.hpp"
 #include "CarlaString.hpp"
+#include "CarlaThread.hpp"
+
+#include <vector>
 
 #define CARLA_ENGINE_OSC_HANDLE_ARGS const CarlaPluginPtr& plugin, \
   const int argc, const lo_arg* const* const argv, const char* const types
@@ -56,6 +61,8 @@
 
 CARLA_BACKEND_START_NAMESPACE
 
+class CarlaOscBundleSender;
+
 // -----------------------------------------------------------------------
 
 class CarlaEngineOsc
@@ -65,9 +72,19 @@ public:
     ~CarlaEngineOsc() noexcept;
 
     void init(const char* name, int tcpPort, int udpPort) noexcept;
-    void idle() const noexcept;
+    void idle() noexcept;
     void close() noexcept;
 
+    // UDP messages are received on a dedicated thread. Parameter and mixer messages are queued for the audio thread,
+    // notes go to the plugin external note queue, everything else is handed over to idle().
+    // Structural engine changes suspend it meanwhile.
+    void suspendUdpDispatch() noexcept;
+    void resumeUdpDispatch() noexcept;
+
+    // applies the parameter and mixer messages queued by the UDP receive thread,
+    // called by the audio thread at the start of each cycle, before any plugin is processed
+    void runPendingRtMessages() noexcept;
+
     // -------------------------------------------------------------------
 
     const CarlaString& getServerPathTCP() const noexcept
@@ -89,12 +106,17 @@ public:
 
     bool isControlRegisteredForUDP() const noexcept
     {
-        return fControlDataUDP.target != nullptr;
+        return fNumUdpClients != 0;
     }
 
     // -------------------------------------------------------------------
     // TCP
 
+    // Until the matching endTcpBundle(), TCP messages are collected into as few bundles as possible
+    // instead of being sent one by one. Used for syncing a whole session to a new control client.
+    void beginTcpBundle() noexcept;
+    void endTcpBundle() noexcept;
+
     void sendCallback(EngineCallbackOpcode action, uint pluginId,
                       int value1, int value2, int value3,
                       float valuef, const char* valueStr) const noexcept;
@@ -107,6 +129,7 @@ public:
     void sendPluginMidiProgram(const CarlaPluginPtr& plugin, uint32_t index) const noexcept;
     void sendPluginCustomData(const CarlaPluginPtr& plugin, uint32_t index) const noexcept;
     void sendPluginInternalParameterValues(const CarlaPluginPtr& plugin) const noexcept;
+    void sendPatchbaySnapshot(const char* snapshot) const noexcept;
     void sendPing() const noexcept;
     void sendResponse(int messageId, const char* error) const noexcept;
     void sendExit() const noexcept;
@@ -114,18 +137,80 @@ public:
     // -------------------------------------------------------------------
     // UDP
 
-    void sendRuntimeInfo() const noexcept;
-    void sendParameterValue(uint pluginId, uint32_t index, float value) const noexcept;
-    void sendPeaks(uint pluginId, const float peaks[4]) const noexcept;
+    // Sends runtime info, and the output parameters and peaks that changed since the last update,
+    // to each client whose update interval has passed. Each client gets a single OSC bundle per update.
+    void sendRuntimeUpdates() noexcept;
 
     // -------------------------------------------------------------------
 
 private:
+    static const uint kMaxUdpClients = 8;
+    static const uint kMaxDeferredUdpMessageSize = 8192;
+
+    // returned by immediate handlers when the audio thread queue is full, the message then goes to idle()
+    static const int kUdpMessageNeedsIdle = -1;
+
+    enum UdpRtMessageType {
+        kUdpRtMessageDryWet = 0,
+        kUdpRtMessageVolume,
+        kUdpRtMessageBalanceLeft,
+        kUdpRtMessageBalanceRight,
+        kUdpRtMessagePanning,
+        kUdpRtMessageParameterValue
+    };
+
+    struct UdpRtMessage {
+        uint32_t type;
+        uint32_t pluginId;
+        uint32_t index; // parameter only
+        float    value;
+    };
+
+    class UdpReceiveThread : public CarlaThread
+    {
+    public:
+        UdpReceiveThread(CarlaEngineOsc& osc) noexcept
+            : CarlaThread("CarlaEngineOscUDP"),
+              kOsc(osc) {}
+
+    protected:
+        void run() override;
+
+    private:
+        CarlaEngineOsc& kOsc;
+
+        CARLA_DECLARE_NON_COPY_CLASS(UdpReceiveThread)
+    };
+
+    // last values sent to a UDP client for a plugin: 4 peaks followed by all parameter values
+    struct UdpPluginValues {
+        const CarlaPlugin* plugin;
+        std::vector<float> values;
+    };
+
+    struct UdpClient {
+        CarlaOscData data;
+        uint updateInterval; // in ms
+        float epsilon;       // minimum change for a value to be sent again
+        int64_t lastUpdateTime;
+        int64_t lastFullUpdateTime;
+        std::vector<UdpPluginValues> plugins;
+
+        UdpClient() noexcept;
+        void clear() noexcept;
+        CARLA_DECLARE_NON_COPY_STRUCT(UdpClient)
+    };
+
     CarlaEngine* const fEngine;
 
-    // for carla-control
+    // for carla-control, only 1 client can control the engine but several can receive runtime updates
     CarlaOscData fControlDataTCP;
-    CarlaOscData fControlDataUDP;
+    CarlaOscBundleSender* fTcpBundleSender;
+    uint         fTcpBundleLevel;
+    CarlaMutex   fTcpBundleMutex;
+    UdpClient    fUdpClients[kMaxUdpClients];
+    uint         fNumUdpClients;
+    CarlaMutex   fUdpClientsMutex;
 
     CarlaString  fName;
     CarlaString  fServerPathTCP;
@@ -133,13 +218,31 @@ private:
     lo_server    fServerTCP;
     lo_server    fServerUDP;
 
+    UdpReceiveThread    fUdpThread;
+    CarlaRecursiveMutex fUdpDispatchMutex;
+    CarlaHeapRingBuffer fUdpDeferred; // messages the receive thread leaves for idle()
+    CarlaMutex          fUdpDeferredMutex;
+
+    // single producer (receive thread), single consumer (audio thread), see runPendingRtMessages()
+    CarlaSmallStackRingBuffer fUdpRtQueue;
+    UdpRtMessage fUdpRtPending; // audio thread only, read but not applied yet
+    bool fUdpRtHasPending;      // audio thread only
+
     // -------------------------------------------------------------------
 
     int handleMessage(bool isTCP, const char* path,
                       int argc, const lo_arg* const* argv, const char* types, lo_message msg);
 
+    bool isUdpReceiveThread() const noexcept;
+    bool queueUdpRtMessage(UdpRtMessageType type, uint pluginId, uint32_t index, float value) noexcept;
+    int handleUdpMessageFromThread(const char* path,
+                                   int argc, const lo_arg* const* argv, const char* types, lo_message msg);
+
     int handleMsgRegister(bool isTCP, int argc, const lo_arg* const* argv, const char* types);
     int handleMsgUnregister(bool isTCP, int argc, const lo_arg* const* argv, const char* types);
+    void sendRegisterError(bool isTCP, const char* url, lo_address addr, const char* error) const noexcept;
+    void sendTcpMessage(const char* path, lo_message msg) const noexcept;
+    void sendUpdateToUdpClient(UdpClient& client, bool fullUpdate) noexcept;
     int handleMsgControl(const char* method,
                          int argc, const lo_arg* const* argv, const char* types);
 
@@ -178,7 +281,12 @@ private:
 
     static int osc_message_handler_UDP(const char* path, const char* types, lo_arg** argv, int argc, lo_message msg, void* userData)
     {
-        return ((CarlaEngineOsc*)userData)->handleMessage(false, path, argc, argv, types, msg);
+        CarlaEngineOsc* const self = (CarlaEngineOsc*)userData;
+
+        if (self->isUdpReceiveThread())
+            return self->handleUdpMessageFromThread(path, argc, argv, types, msg);
+
+        return self->handleMessage(false, path, argc, argv, types, msg);
     }
 
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaEngineOsc)
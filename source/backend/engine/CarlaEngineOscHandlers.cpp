@@ -27,6 +27,127 @@
 
 CARLA_BACKEND_START_NAMESPACE
 
+// -----------------------------------------------------------------------
+// Plugin method lookup
+
+enum OscPluginMethod {
+    kOscPluginMethodIgnored = 0, // known, but not handled yet
+    kOscPluginMethodSetActive,
+    kOscPluginMethodSetDryWet,
+    kOscPluginMethodSetVolume,
+    kOscPluginMethodSetBalanceLeft,
+    kOscPluginMethodSetBalanceRight,
+    kOscPluginMethodSetPanning,
+    kOscPluginMethodSetParameterValue,
+    kOscPluginMethodSetParameterMappedControlIndex,
+    kOscPluginMethodSetParameterMappedRange,
+    kOscPluginMethodSetParameterMidiChannel,
+    kOscPluginMethodSetProgram,
+    kOscPluginMethodSetMidiProgram,
+    kOscPluginMethodNoteOn,
+    kOscPluginMethodNoteOff
+};
+
+struct OscPluginMethodInfo {
+    const char* name;
+    OscPluginMethod method;
+    bool immediate; // handled from the UDP receive thread without going through idle(), see the handlers
+};
+
+static const OscPluginMethodInfo kOscPluginMethods[] = {
+    { "set_option",                         kOscPluginMethodIgnored,                        false }, // TODO
+    { "set_active",                         kOscPluginMethodSetActive,                      false },
+    { "set_drywet",                         kOscPluginMethodSetDryWet,                      true  },
+    { "set_volume",                         kOscPluginMethodSetVolume,                      true  },
+    { "set_balance_left",                   kOscPluginMethodSetBalanceLeft,                 true  },
+    { "set_balance_right",                  kOscPluginMethodSetBalanceRight,                true  },
+    { "set_panning",                        kOscPluginMethodSetPanning,                     true  },
+    { "set_ctrl_channel",                   kOscPluginMethodIgnored,                        false }, // TODO
+    { "set_parameter_value",                kOscPluginMethodSetParameterValue,              true  },
+    { "set_parameter_mapped_control_index", kOscPluginMethodSetParameterMappedControlIndex, false },
+    { "set_parameter_mapped_range",         kOscPluginMethodSetParameterMappedRange,        false },
+    { "set_parameter_midi_channel",         kOscPluginMethodSetParameterMidiChannel,        false },
+    { "set_program",                        kOscPluginMethodSetProgram,                     false },
+    { "set_midi_program",                   kOscPluginMethodSetMidiProgram,                 false },
+    { "set_custom_data",                    kOscPluginMethodIgnored,                        false }, // TODO
+    { "set_chunk",                          kOscPluginMethodIgnored,                        false }, // TODO
+    { "note_on",                            kOscPluginMethodNoteOn,                         true  },
+    { "note_off",                           kOscPluginMethodNoteOff,                        true  },
+};
+
+// Hash table over kOscPluginMethods, built on first use and read-only afterwards.
+// Lookups cost one hash of the method name and, normally, a single string compare.
+class OscPluginMethodTable
+{
+public:
+    static const OscPluginMethodTable& getInstance() noexcept
+    {
+        static const OscPluginMethodTable table;
+        return table;
+    }
+
+    const OscPluginMethodInfo* find(const char* const name) const noexcept
+    {
+        const uint32_t hash = getHash(name);
+
+        for (uint32_t i = hash & kMask;; i = (i + 1) & kMask)
+        {
+            const OscPluginMethodInfo* const info = fSlots[i];
+
+            if (info == nullptr)
+                return nullptr;
+            if (fHashes[i] == hash && std::strcmp(info->name, name) == 0)
+                return info;
+        }
+    }
+
+private:
+    // power of 2, kept well above the method count so probe chains stay short
+    static const uint32_t kSize = 64;
+    static const uint32_t kMask = kSize - 1;
+
+    const OscPluginMethodInfo* fSlots[kSize];
+    uint32_t fHashes[kSize];
+
+    OscPluginMethodTable() noexcept
+    {
+        for (uint32_t i=0; i < kSize; ++i)
+        {
+            fSlots[i]  = nullptr;
+            fHashes[i] = 0;
+        }
+
+        for (std::size_t m=0; m < sizeof(kOscPluginMethods)/sizeof(kOscPluginMethods[0]); ++m)
+        {
+            const OscPluginMethodInfo& info(kOscPluginMethods[m]);
+            const uint32_t hash = getHash(info.name);
+
+            uint32_t i = hash & kMask;
+            while (fSlots[i] != nullptr)
+                i = (i + 1) & kMask;
+
+            fSlots[i]  = &info;
+            fHashes[i] = hash;
+        }
+    }
+
+    static uint32_t getHash(const char* name) noexcept
+    {
+        // FNV-1a
+        uint32_t hash = 2166136261U;
+
+        for (; *name != '\0'; ++name)
+        {
+            hash ^= static_cast<uint8_t>(*name);
+            hash *= 16777619U;
+        }
+
+        return hash;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(OscPluginMethodTable)
+};
+
 // -----------------------------------------------------------------------
 
 int CarlaEngineOsc::handleMessage(const bool isTCP, const char* const path, const int argc, const lo_arg* const* const argv, const char* const types, const lo_message msg)
@@ -65,56 +186,44 @@ int CarlaEngineOsc::handleMessage(const bool isTCP, const char* const path, cons
 
     const std::size_t nameSize(fName.length());
 
-    // Check if message is for this client
-    if (std::strlen(path) <= nameSize || std::strncmp(path+1, fName, nameSize) != 0)
+    // Check if message is for this client, "/carla/..."
+    if (std::strncmp(path+1, fName, nameSize) != 0 || path[nameSize+1] != '/')
     {
         carla_stderr("CarlaEngineOsc::handleMessage() - message not for this client -> '%s' != '/%s/'",
                      path, fName.buffer());
         return 1;
     }
 
-    // Get plugin id from path, "/carla/23/method" -> 23
+    // Get plugin id and method from path, "/carla/23/method" -> 23 and "method"
+    const char* method = path + (nameSize + 2);
+
+    if (! std::isdigit(*method))
+    {
+        carla_stderr("CarlaEngineOsc::handleMessage() - invalid message '%s'", path);
+        return 1;
+    }
+
     uint pluginId = 0;
-    std::size_t offset;
 
-    if (std::isdigit(path[nameSize+2]))
+    for (int digits = 0; std::isdigit(*method); ++method)
     {
-        if (std::isdigit(path[nameSize+3]))
-        {
-            if (std::isdigit(path[nameSize+5]))
-            {
-                carla_stderr2("CarlaEngineOsc::handleMessage() - invalid plugin id, over 999? (value: \"%s\")", path+(nameSize+1));
-                return 1;
-            }
-            else if (std::isdigit(path[nameSize+4]))
-            {
-                // 3 digits, /xyz/method
-                offset    = 6;
-                pluginId += uint(path[nameSize+2]-'0')*100;
-                pluginId += uint(path[nameSize+3]-'0')*10;
-                pluginId += uint(path[nameSize+4]-'0');
-            }
-            else
-            {
-                // 2 digits, /xy/method
-                offset    = 5;
-                pluginId += uint(path[nameSize+2]-'0')*10;
-                pluginId += uint(path[nameSize+3]-'0');
-            }
-        }
-        else
+        if (++digits > 3)
         {
-            // single digit, /x/method
-            offset    = 4;
-            pluginId += uint(path[nameSize+2]-'0');
+            carla_stderr2("CarlaEngineOsc::handleMessage() - invalid plugin id, over 999? (value: \"%s\")", path+(nameSize+1));
+            return 1;
         }
+
+        pluginId = pluginId * 10 + uint(*method - '0');
     }
-    else
+
+    if (*method != '/')
     {
         carla_stderr("CarlaEngineOsc::handleMessage() - invalid message '%s'", path);
         return 1;
     }
 
+    ++method;
+
     if (pluginId > fEngine->getCurrentPluginCount())
     {
         carla_stderr("CarlaEngineOsc::handleMessage() - failed to get plugin, wrong id '%i'", pluginId);
@@ -130,11 +239,6 @@ int CarlaEngineOsc::handleMessage(const bool isTCP, const char* const path, cons
         return 0;
     }
 
-    // Get method from path, "/Carla/i/method" -> "method"
-    char method[48];
-    std::strncpy(method, path + (nameSize + offset), 47);
-    method[47] = '\0';
-
     if (method[0] == '\0')
     {
         carla_stderr("CarlaEngineOsc::handleMessage(%s, \"%s\", ...) - received message without method", bool2str(isTCP), path);
@@ -142,42 +246,42 @@ int CarlaEngineOsc::handleMessage(const bool isTCP, const char* const path, cons
     }
 
     // Internal methods
-    if (std::strcmp(method, "set_option") == 0)
-        return 0; //handleMsgSetOption(plugin, argc, argv, types); // TODO
-    if (std::strcmp(method, "set_active") == 0)
-        return handleMsgSetActive(plugin, argc, argv, types);
-    if (std::strcmp(method, "set_drywet") == 0)
-        return handleMsgSetDryWet(plugin, argc, argv, types);
-    if (std::strcmp(method, "set_volume") == 0)
-        return handleMsgSetVolume(plugin, argc, argv, types);
-    if (std::strcmp(method, "set_balance_left") == 0)
-        return handleMsgSetBalanceLeft(plugin, argc, argv, types);
-    if (std::strcmp(method, "set_balance_right") == 0)
-        return handleMsgSetBalanceRight(plugin, argc, argv, types);
-    if (std::strcmp(method, "set_panning") == 0)
-        return handleMsgSetPanning(plugin, argc, argv, types);
-    if (std::strcmp(method, "set_ctrl_channel") == 0)
-        return 0; //handleMsgSetControlChannel(plugin, argc, argv, types); // TODO
-    if (std::strcmp(method, "set_parameter_value") == 0)
-        return handleMsgSetParameterValue(plugin, argc, argv, types);
-    if (std::strcmp(method, "set_parameter_mapped_control_index") == 0)
-        return handleMsgSetParameterMappedControlIndex(plugin, argc, argv, types);
-    if (std::strcmp(method, "set_parameter_mapped_range") == 0)
-        return handleMsgSetParameterMappedRange(plugin, argc, argv, types);
-    if (std::strcmp(method, "set_parameter_midi_channel") == 0)
-        return handleMsgSetParameterMidiChannel(plugin, argc, argv, types);
-    if (std::strcmp(method, "set_program") == 0)
-        return handleMsgSetProgram(plugin, argc, argv, types);
-    if (std::strcmp(method, "set_midi_program") == 0)
-        return handleMsgSetMidiProgram(plugin, argc, argv, types);
-    if (std::strcmp(method, "set_custom_data") == 0)
-        return 0; //handleMsgSetCustomData(plugin, argc, argv, types); // TODO
-    if (std::strcmp(method, "set_chunk") == 0)
-        return 0; //handleMsgSetChunk(plugin, argc, argv, types); // TODO
-    if (std::strcmp(method, "note_on") == 0)
-        return handleMsgNoteOn(plugin, argc, argv, types);
-    if (std::strcmp(method, "note_off") == 0)
-        return handleMsgNoteOff(plugin, argc, argv, types);
+    if (const OscPluginMethodInfo* const info = OscPluginMethodTable::getInstance().find(method))
+    {
+        switch (info->method)
+        {
+        case kOscPluginMethodIgnored:
+            return 0;
+        case kOscPluginMethodSetActive:
+            return handleMsgSetActive(plugin, argc, argv, types);
+        case kOscPluginMethodSetDryWet:
+            return handleMsgSetDryWet(plugin, argc, argv, types);
+        case kOscPluginMethodSetVolume:
+            return handleMsgSetVolume(plugin, argc, argv, types);
+        case kOscPluginMethodSetBalanceLeft:
+            return handleMsgSetBalanceLeft(plugin, argc, argv, types);
+        case kOscPluginMethodSetBalanceRight:
+            return handleMsgSetBalanceRight(plugin, argc, argv, types);
+        case kOscPluginMethodSetPanning:
+            return handleMsgSetPanning(plugin, argc, argv, types);
+        case kOscPluginMethodSetParameterValue:
+            return handleMsgSetParameterValue(plugin, argc, argv, types);
+        case kOscPluginMethodSetParameterMappedControlIndex:
+            return handleMsgSetParameterMappedControlIndex(plugin, argc, argv, types);
+        case kOscPluginMethodSetParameterMappedRange:
+            return handleMsgSetParameterMappedRange(plugin, argc, argv, types);
+        case kOscPluginMethodSetParameterMidiChannel:
+            return handleMsgSetParameterMidiChannel(plugin, argc, argv, types);
+        case kOscPluginMethodSetProgram:
+            return handleMsgSetProgram(plugin, argc, argv, types);
+        case kOscPluginMethodSetMidiProgram:
+            return handleMsgSetMidiProgram(plugin, argc, argv, types);
+        case kOscPluginMethodNoteOn:
+            return handleMsgNoteOn(plugin, argc, argv, types);
+        case kOscPluginMethodNoteOff:
+            return handleMsgNoteOff(plugin, argc, argv, types);
+        }
+    }
 
     // Send all other methods to plugins, TODO
     plugin->handleOscMessage(method, argc, argv, types, msg);
@@ -186,97 +290,296 @@ int CarlaEngineOsc::handleMessage(const bool isTCP, const char* const path, cons
 
 // -----------------------------------------------------------------------
 
+int CarlaEngineOsc::handleUdpMessageFromThread(const char* const path, const int argc, const lo_arg* const* const argv, const char* const types, const lo_message msg)
+{
+    CARLA_SAFE_ASSERT_RETURN(path != nullptr && path[0] != '\0', 1);
+
+    // some methods are handled directly from the receive thread, see their handlers
+    if (const char* const method = std::strrchr(path, '/'))
+    {
+        const OscPluginMethodInfo* const info = OscPluginMethodTable::getInstance().find(method + 1);
+
+        if (info != nullptr && info->immediate)
+        {
+            const int ret = handleMessage(false, path, argc, argv, types, msg);
+
+            if (ret != kUdpMessageNeedsIdle)
+                return ret;
+        }
+    }
+
+    // everything else needs the main thread, pass it along as raw OSC data
+    const size_t size = lo_message_length(msg, path);
+    CARLA_SAFE_ASSERT_UINT2_RETURN(size > 0 && size <= kMaxDeferredUdpMessageSize,
+                                   size, kMaxDeferredUdpMessageSize, 0);
+
+    uint8_t data[kMaxDeferredUdpMessageSize];
+    size_t dataSize = size;
+
+    if (lo_message_serialise(msg, path, data, &dataSize) == nullptr)
+        return 0;
+
+    const CarlaMutexLocker cml(fUdpDeferredMutex);
+
+    fUdpDeferred.writeUInt(static_cast<uint32_t>(dataSize));
+    fUdpDeferred.writeCustomData(data, static_cast<uint32_t>(dataSize));
+    fUdpDeferred.commitWrite();
+    return 0;
+}
+
+// -----------------------------------------------------------------------
+
+bool CarlaEngineOsc::queueUdpRtMessage(const UdpRtMessageType type, const uint pluginId,
+                                       const uint32_t index, const float value) noexcept
+{
+    UdpRtMessage message;
+    message.type     = static_cast<uint32_t>(type);
+    message.pluginId = pluginId;
+    message.index    = index;
+    message.value    = value;
+
+    fUdpRtQueue.writeCustomType(message);
+    return fUdpRtQueue.commitWrite();
+}
+
+void CarlaEngineOsc::runPendingRtMessages() noexcept
+{
+    for (;;)
+    {
+        if (! fUdpRtHasPending)
+        {
+            if (! fUdpRtQueue.isDataAvailableForReading())
+                return;
+
+            fUdpRtQueue.readCustomType(fUdpRtPending);
+            fUdpRtHasPending = true;
+        }
+
+        const UdpRtMessage& message(fUdpRtPending);
+
+        if (message.pluginId < fEngine->getCurrentPluginCount())
+        {
+            const CarlaPluginPtr plugin = fEngine->getPluginUnchecked(message.pluginId);
+
+            if (plugin.get() != nullptr && plugin->getId() == message.pluginId && plugin->isEnabled())
+            {
+                // the plugin can be processing on another thread (JACK multi-client) or be busy on the main thread,
+                // keep the message and try again next cycle
+                if (! plugin->tryLock(false))
+                    return;
+
+                switch (message.type)
+                {
+                case kUdpRtMessageDryWet:
+                    plugin->setDryWetRT(message.value, true);
+                    break;
+                case kUdpRtMessageVolume:
+                    plugin->setVolumeRT(message.value, true);
+                    break;
+                case kUdpRtMessageBalanceLeft:
+                    plugin->setBalanceLeftRT(message.value, true);
+                    break;
+                case kUdpRtMessageBalanceRight:
+                    plugin->setBalanceRightRT(message.value, true);
+                    break;
+                case kUdpRtMessagePanning:
+                    plugin->setPanningRT(message.value, true);
+                    break;
+                case kUdpRtMessageParameterValue:
+                    if (message.index < plugin->getParameterCount())
+                        plugin->setParameterValueRT(message.index, message.value, true);
+                    break;
+                }
+
+                plugin->unlock();
+            }
+        }
+
+        fUdpRtHasPending = false;
+    }
+}
+
+// -----------------------------------------------------------------------
+
 int CarlaEngineOsc::handleMsgRegister(const bool isTCP,
                                       const int argc, const lo_arg* const* const argv, const char* const types)
 {
     carla_debug("CarlaEngineOsc::handleMsgRegister()");
-    CARLA_ENGINE_OSC_CHECK_OSC_TYPES(1, "s");
+
+    // UDP clients can optionally pass their update interval in ms and the minimum change for a value to be sent
+    if (isTCP || argc == 1)
+    {
+        CARLA_ENGINE_OSC_CHECK_OSC_TYPES(1, "s");
+    }
+    else if (argc == 2)
+    {
+        CARLA_ENGINE_OSC_CHECK_OSC_TYPES(2, "si");
+    }
+    else
+    {
+        CARLA_ENGINE_OSC_CHECK_OSC_TYPES(3, "sif");
+    }
 
     const char* const url = &argv[0]->s;
     const lo_address addr = lo_address_new_from_url(url);
 
-    CarlaOscData& oscData(isTCP ? fControlDataTCP : fControlDataUDP);
+    const char* const host  = lo_address_get_hostname(addr);
+    const char* const port  = lo_address_get_port(addr);
 
-    if (oscData.owner != nullptr)
+    if (! isTCP)
     {
-        carla_stderr("OSC backend already registered to %s", oscData.owner);
+        const CarlaMutexLocker cml(fUdpClientsMutex);
+
+        UdpClient* client = nullptr;
+
+        for (uint i=0; i < kMaxUdpClients; ++i)
+        {
+            UdpClient& udpClient(fUdpClients[i]);
+
+            if (udpClient.data.owner != nullptr && std::strcmp(udpClient.data.owner, url) == 0)
+            {
+                // registering again only updates the settings
+                client = &udpClient;
+                break;
+            }
+
+            if (client == nullptr && udpClient.data.owner == nullptr)
+                client = &udpClient;
+        }
+
+        if (client == nullptr)
+        {
+            carla_stderr("OSC backend already registered to %u UDP clients", kMaxUdpClients);
+            sendRegisterError(isTCP, url, addr, "OSC already registered to too many clients");
+        }
+        else
+        {
+            if (client->data.owner == nullptr)
+            {
+                carla_stdout("OSC backend registered to %s", url);
+
+                client->data.owner  = carla_strdup_safe(url);
+                client->data.path   = carla_strdup_free(lo_url_get_path(url));
+                client->data.target = lo_address_new_with_proto(LO_UDP, host, port);
+                ++fNumUdpClients;
+            }
 
-        char* const path = lo_url_get_path(url);
+            client->updateInterval = argc >= 2 && argv[1]->i > 0 ? static_cast<uint>(argv[1]->i) : 0;
+            client->epsilon        = argc >= 3 && argv[2]->f > 0.0f ? argv[2]->f : 0.0f;
 
-        char targetPath[std::strlen(path)+18];
-        std::strcpy(targetPath, path);
-        std::strcat(targetPath, "/exit-error");
+            // send everything on the next update
+            client->lastUpdateTime     = 0;
+            client->lastFullUpdateTime = 0;
+        }
 
-        lo_send_from(addr, isTCP ? fServerTCP : fServerUDP, LO_TT_IMMEDIATE,
-                     targetPath, "s", "OSC already registered to another client");
+        lo_address_free(addr);
+        return 0;
+    }
 
-        free(path);
+    if (fControlDataTCP.owner != nullptr)
+    {
+        carla_stderr("OSC backend already registered to %s", fControlDataTCP.owner);
+        sendRegisterError(isTCP, url, addr, "OSC already registered to another client");
     }
     else
     {
         carla_stdout("OSC backend registered to %s", url);
 
-        const char* const host  = lo_address_get_hostname(addr);
-        const char* const port  = lo_address_get_port(addr);
-        const lo_address target = lo_address_new_with_proto(isTCP ? LO_TCP : LO_UDP, host, port);
+        fControlDataTCP.owner  = carla_strdup_safe(url);
+        fControlDataTCP.path   = carla_strdup_free(lo_url_get_path(url));
+        fControlDataTCP.target = lo_address_new_with_proto(LO_TCP, host, port);
 
-        oscData.owner  = carla_strdup_safe(url);
-        oscData.path   = carla_strdup_free(lo_url_get_path(url));
-        oscData.target = target;
+        const EngineOptions& opts(fEngine->getOptions());
 
-        if (isTCP)
-        {
-            const EngineOptions& opts(fEngine->getOptions());
-
-            fEngine->callback(false, true,
-                              ENGINE_CALLBACK_ENGINE_STARTED,
-                              fEngine->getCurrentPluginCount(),
-                              opts.processMode,
-                              opts.transportMode,
-                              static_cast<int>(fEngine->getBufferSize()),
-                              static_cast<float>(fEngine->getSampleRate()),
-                              fEngine->getCurrentDriverName());
-
-            for (uint i=0, count=fEngine->getCurrentPluginCount(); i < count; ++i)
-            {
-                const CarlaPluginPtr plugin = fEngine->getPluginUnchecked(i);
-                CARLA_SAFE_ASSERT_CONTINUE(plugin != nullptr);
+        // send the whole session in a few big bundles, later changes go through the regular callbacks
+        beginTcpBundle();
 
-                fEngine->callback(false, true, ENGINE_CALLBACK_PLUGIN_ADDED, i, 0, 0, 0, 0.0f, plugin->getName());
-            }
+        fEngine->callback(false, true,
+                          ENGINE_CALLBACK_ENGINE_STARTED,
+                          fEngine->getCurrentPluginCount(),
+                          opts.processMode,
+                          opts.transportMode,
+                          static_cast<int>(fEngine->getBufferSize()),
+                          static_cast<float>(fEngine->getSampleRate()),
+                          fEngine->getCurrentDriverName());
+
+        for (uint i=0, count=fEngine->getCurrentPluginCount(); i < count; ++i)
+        {
+            const CarlaPluginPtr plugin = fEngine->getPluginUnchecked(i);
+            CARLA_SAFE_ASSERT_CONTINUE(plugin != nullptr);
 
-            fEngine->patchbayRefresh(false, true, fEngine->pData->graph.isUsingExternalOSC());
+            fEngine->callback(false, true, ENGINE_CALLBACK_PLUGIN_ADDED, i, 0, 0, 0, 0.0f, plugin->getName());
         }
+
+        if (const char* const snapshot = fEngine->getPatchbaySnapshot(false, true,
+                                                                      fEngine->pData->graph.isUsingExternalOSC()))
+            sendPatchbaySnapshot(snapshot);
+
+        endTcpBundle();
     }
 
     lo_address_free(addr);
     return 0;
 }
 
+void CarlaEngineOsc::sendRegisterError(const bool isTCP, const char* const url, const lo_address addr,
+                                       const char* const error) const noexcept
+{
+    char* const path = lo_url_get_path(url);
+    CARLA_SAFE_ASSERT_RETURN(path != nullptr,);
+
+    char targetPath[std::strlen(path)+18];
+    std::strcpy(targetPath, path);
+    std::strcat(targetPath, "/exit-error");
+
+    lo_send_from(addr, isTCP ? fServerTCP : fServerUDP, LO_TT_IMMEDIATE, targetPath, "s", error);
+
+    free(path);
+}
+
 int CarlaEngineOsc::handleMsgUnregister(const bool isTCP,
                                         const int argc, const lo_arg* const* const argv, const char* const types)
 {
     carla_debug("CarlaEngineOsc::handleMsgUnregister()");
     CARLA_ENGINE_OSC_CHECK_OSC_TYPES(1, "s");
 
-    CarlaOscData& oscData(isTCP ? fControlDataTCP : fControlDataUDP);
+    const char* const url = &argv[0]->s;
 
-    if (oscData.owner == nullptr)
+    if (! isTCP)
     {
-        carla_stderr("OSC backend is not registered yet, unregister failed");
+        const CarlaMutexLocker cml(fUdpClientsMutex);
+
+        for (uint i=0; i < kMaxUdpClients; ++i)
+        {
+            UdpClient& udpClient(fUdpClients[i]);
+
+            if (udpClient.data.owner == nullptr || std::strcmp(udpClient.data.owner, url) != 0)
+                continue;
+
+            carla_stdout("OSC client %s unregistered", url);
+            udpClient.clear();
+            --fNumUdpClients;
+            return 0;
+        }
+
+        carla_stderr("OSC backend unregister failed, %s is not registered", url);
         return 0;
     }
 
-    const char* const url = &argv[0]->s;
+    if (fControlDataTCP.owner == nullptr)
+    {
+        carla_stderr("OSC backend is not registered yet, unregister failed");
+        return 0;
+    }
 
-    if (std::strcmp(oscData.owner, url) == 0)
+    if (std::strcmp(fControlDataTCP.owner, url) == 0)
     {
         carla_stdout("OSC client %s unregistered", url);
-        oscData.clear();
+        fControlDataTCP.clear();
         return 0;
     }
 
-    carla_stderr("OSC backend unregister failed, current owner %s does not match requested %s", oscData.owner, url);
+    carla_stderr("OSC backend unregister failed, current owner %s does not match requested %s", fControlDataTCP.owner, url);
     return 0;
 }
 
@@ -378,7 +681,11 @@ int CarlaEngineOsc::handleMsgControl(const char* const method,
 
         const bool external = argv[1]->i != 0;
 
-        ok = fEngine->patchbayRefresh(false, true, external);
+        const char* const snapshot = fEngine->getPatchbaySnapshot(false, true, external);
+        ok = snapshot != nullptr;
+
+        if (ok)
+            sendPatchbaySnapshot(snapshot);
     }
     else if (std::strcmp(method, "transport_play") == 0)
     {
@@ -589,6 +896,9 @@ int CarlaEngineOsc::handleMsgSetDryWet(CARLA_ENGINE_OSC_HANDLE_ARGS)
 
     const float value = argv[0]->f;
 
+    if (isUdpReceiveThread())
+        return queueUdpRtMessage(kUdpRtMessageDryWet, plugin->getId(), 0, value) ? 0 : kUdpMessageNeedsIdle;
+
     plugin->setDryWet(value, false, true);
     return 0;
 }
@@ -600,6 +910,9 @@ int CarlaEngineOsc::handleMsgSetVolume(CARLA_ENGINE_OSC_HANDLE_ARGS)
 
     const float value = argv[0]->f;
 
+    if (isUdpReceiveThread())
+        return queueUdpRtMessage(kUdpRtMessageVolume, plugin->getId(), 0, value) ? 0 : kUdpMessageNeedsIdle;
+
     plugin->setVolume(value, false, true);
     return 0;
 }
@@ -611,6 +924,9 @@ int CarlaEngineOsc::handleMsgSetBalanceLeft(CARLA_ENGINE_OSC_HANDLE_ARGS)
 
     const float value = argv[0]->f;
 
+    if (isUdpReceiveThread())
+        return queueUdpRtMessage(kUdpRtMessageBalanceLeft, plugin->getId(), 0, value) ? 0 : kUdpMessageNeedsIdle;
+
     plugin->setBalanceLeft(value, false, true);
     return 0;
 }
@@ -622,6 +938,9 @@ int CarlaEngineOsc::handleMsgSetBalanceRight(CARLA_ENGINE_OSC_HANDLE_ARGS)
 
     const float value = argv[0]->f;
 
+    if (isUdpReceiveThread())
+        return queueUdpRtMessage(kUdpRtMessageBalanceRight, plugin->getId(), 0, value) ? 0 : kUdpMessageNeedsIdle;
+
     plugin->setBalanceRight(value, false, true);
     return 0;
 }
@@ -633,6 +952,9 @@ int CarlaEngineOsc::handleMsgSetPanning(CARLA_ENGINE_OSC_HANDLE_ARGS)
 
     const float value = argv[0]->f;
 
+    if (isUdpReceiveThread())
+        return queueUdpRtMessage(kUdpRtMessagePanning, plugin->getId(), 0, value) ? 0 : kUdpMessageNeedsIdle;
+
     plugin->setPanning(value, false, true);
     return 0;
 }
@@ -647,6 +969,11 @@ int CarlaEngineOsc::handleMsgSetParameterValue(CARLA_ENGINE_OSC_HANDLE_ARGS)
 
     CARLA_SAFE_ASSERT_RETURN(index >= 0, 0);
 
+    // from the receive thread, applied by the audio thread, the UI and host are updated later on the main thread
+    if (isUdpReceiveThread())
+        return queueUdpRtMessage(kUdpRtMessageParameterValue, plugin->getId(), static_cast<uint32_t>(index), value)
+               ? 0 : kUdpMessageNeedsIdle;
+
     plugin->setParameterValue(static_cast<uint32_t>(index), value, true, false, true);
     return 0;
 }
@@ -705,7 +1032,7 @@ int CarlaEngineOsc::handleMsgSetProgram(CARLA_ENGINE_OSC_HANDLE_ARGS)
 
     CARLA_SAFE_ASSERT_RETURN(index >= -1, 0);
 
-    plugin->setProgram(index, true, false, true);
+    plugin->requestProgramChange(index, true, false, true);
     return 0;
 }
 
@@ -718,7 +1045,7 @@ int CarlaEngineOsc::handleMsgSetMidiProgram(CARLA_ENGINE_OSC_HANDLE_ARGS)
 
     CARLA_SAFE_ASSERT_RETURN(index >= -1, 0);
 
-    plugin->setMidiProgram(index, true, false, true);
+    plugin->requestMidiProgramChange(index, true, false, true);
     return 0;
 }
 
@@ -735,7 +1062,10 @@ int CarlaEngineOsc::handleMsgNoteOn(CARLA_ENGINE_OSC_HANDLE_ARGS)
     CARLA_SAFE_ASSERT_RETURN(note >= 0 && note < MAX_MIDI_NOTE, 0);
     CARLA_SAFE_ASSERT_RETURN(velo >= 0 && velo < MAX_MIDI_VALUE, 0);
 
-    plugin->sendMidiSingleNote(static_cast<uint8_t>(channel), static_cast<uint8_t>(note), static_cast<uint8_t>(velo), true, false, true);
+    // UI and host notifications are not thread-safe, skip them when coming from the receive thread
+    const bool notify = ! isUdpReceiveThread();
+
+    plugin->sendMidiSingleNote(static_cast<uint8_t>(channel), static_cast<uint8_t>(note), static_cast<uint8_t>(velo), notify, false, notify);
     return 0;
 }
 
@@ -750,7 +1080,9 @@ int CarlaEngineOsc::handleMsgNoteOff(CARLA_ENGINE_OSC_HANDLE_ARGS)
     CARLA_SAFE_ASSERT_RETURN(channel >= 0 && channel < MAX_MIDI_CHANNELS, 0);
     CARLA_SAFE_ASSERT_RETURN(note >= 0 && note < MAX_MIDI_NOTE, 0);
 
-    plugin->sendMidiSingleNote(static_cast<uint8_t>(channel), static_cast<uint8_t>(note), 0, true, false, true);
+    const bool notify = ! isUdpReceiveThread();
+
+    plugin->sendMidiSingleNote(static_cast<uint8_t>(channel), static_cast<uint8_t>(note), 0, notify, false, notify);
     return 0;
 }
 
@@ -23,10 +23,171 @@
 #include "CarlaEngine.hpp"
 #include "CarlaPlugin.hpp"
 
+#include "water/misc/Time.h"
+
+#include <cmath>
+
 CARLA_BACKEND_START_NAMESPACE
 
 static const char* const kNullString = "";
 
+// sends a TCP message to the registered control client, directly or as part of the current bundle
+#define try_lo_send_tcp(path, ...)                  \
+    if (const lo_message msg_ = lo_message_new())   \
+    {                                               \
+        lo_message_add(msg_, __VA_ARGS__);          \
+        sendTcpMessage(path, msg_);                 \
+    }
+
+// -----------------------------------------------------------------------
+
+// keep bundles well below the maximum UDP payload size
+static const std::size_t kMaxUdpBundleSize = 32768;
+
+// TCP messages have no payload limit, but liblo servers drop messages bigger than 32768 bytes by default
+static const std::size_t kMaxTcpBundleSize = 16384;
+
+// collects messages for a single target into bundles, sending them once they get too big
+class CarlaOscBundleSender
+{
+public:
+    // copyPaths is needed when the message paths do not outlive the add() call
+    CarlaOscBundleSender(const lo_address target, const std::size_t maxSize, const bool copyPaths = false) noexcept
+        : fTarget(target),
+          fMaxSize(maxSize),
+          fCopyPaths(copyPaths),
+          fBundle(nullptr),
+          fSize(0),
+          fPaths() {}
+
+    ~CarlaOscBundleSender() noexcept
+    {
+        flush();
+    }
+
+    // takes ownership of msg, path must stay valid until the bundle is sent unless copyPaths is set
+    void add(const char* path, const lo_message msg) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(msg != nullptr,);
+
+        // each bundle element is prefixed by its size
+        const std::size_t msgSize = lo_message_length(msg, path) + 4;
+
+        if (fBundle != nullptr && fSize + msgSize > fMaxSize)
+            flush();
+
+        if (fBundle == nullptr)
+        {
+            fBundle = lo_bundle_new(LO_TT_IMMEDIATE);
+
+            if (fBundle == nullptr)
+            {
+                lo_message_free(msg);
+                return;
+            }
+
+            // "#bundle" string and time tag
+            fSize = 16;
+        }
+
+        if (fCopyPaths)
+        {
+            path = carla_strdup_safe(path);
+
+            if (path == nullptr)
+            {
+                lo_message_free(msg);
+                return;
+            }
+
+            try {
+                fPaths.push_back(path);
+            } catch(...) {
+                delete[] path;
+                lo_message_free(msg);
+                return;
+            }
+        }
+
+        lo_bundle_add_message(fBundle, path, msg);
+        fSize += msgSize;
+    }
+
+    void flush() noexcept
+    {
+        if (fBundle == nullptr)
+            return;
+
+        try {
+            lo_send_bundle(fTarget, fBundle);
+        } CARLA_SAFE_EXCEPTION("lo_send_bundle");
+
+        lo_bundle_free_recursive(fBundle);
+        fBundle = nullptr;
+        fSize = 0;
+
+        for (std::vector<const char*>::iterator it = fPaths.begin(); it != fPaths.end(); ++it)
+            delete[] *it;
+
+        fPaths.clear();
+    }
+
+private:
+    const lo_address fTarget;
+    const std::size_t fMaxSize;
+    const bool fCopyPaths;
+    lo_bundle fBundle;
+    std::size_t fSize;
+    std::vector<const char*> fPaths;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaOscBundleSender)
+};
+
+// -----------------------------------------------------------------------
+
+void CarlaEngineOsc::beginTcpBundle() noexcept
+{
+    const CarlaMutexLocker cml(fTcpBundleMutex);
+
+    if (fTcpBundleLevel++ != 0)
+        return;
+
+    CARLA_SAFE_ASSERT_RETURN(fControlDataTCP.target != nullptr,);
+
+    try {
+        fTcpBundleSender = new CarlaOscBundleSender(fControlDataTCP.target, kMaxTcpBundleSize, true);
+    } CARLA_SAFE_EXCEPTION("CarlaOscBundleSender");
+}
+
+void CarlaEngineOsc::endTcpBundle() noexcept
+{
+    const CarlaMutexLocker cml(fTcpBundleMutex);
+    CARLA_SAFE_ASSERT_RETURN(fTcpBundleLevel != 0,);
+
+    if (--fTcpBundleLevel != 0)
+        return;
+
+    if (fTcpBundleSender != nullptr)
+    {
+        delete fTcpBundleSender;
+        fTcpBundleSender = nullptr;
+    }
+}
+
+void CarlaEngineOsc::sendTcpMessage(const char* const path, const lo_message msg) const noexcept
+{
+    const CarlaMutexLocker cml(fTcpBundleMutex);
+
+    if (fTcpBundleSender != nullptr)
+        return fTcpBundleSender->add(path, msg);
+
+    try {
+        lo_send_message(fControlDataTCP.target, path, msg);
+    } CARLA_SAFE_EXCEPTION("lo_send_message");
+
+    lo_message_free(msg);
+}
+
 // -----------------------------------------------------------------------
 
 void CarlaEngineOsc::sendCallback(const EngineCallbackOpcode action, const uint pluginId,
@@ -42,7 +203,7 @@ void CarlaEngineOsc::sendCallback(const EngineCallbackOpcode action, const uint
     char targetPath[std::strlen(fControlDataTCP.path)+10];
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/cb");
-    try_lo_send(fControlDataTCP.target, targetPath, "iiiiifs",
+    try_lo_send_tcp(targetPath, "iiiiifs",
                 action, pluginId, value1, value2, value3, static_cast<double>(valuef),
                 valueStr != nullptr ? valueStr : kNullString);
 }
@@ -83,7 +244,7 @@ void CarlaEngineOsc::sendPluginInfo(const CarlaPluginPtr& plugin) const noexcept
     char targetPath[std::strlen(fControlDataTCP.path)+10];
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/info");
-    try_lo_send(fControlDataTCP.target, targetPath, "iiiihiisssssss",
+    try_lo_send_tcp(targetPath, "iiiihiisssssss",
                 static_cast<int32_t>(plugin->getId()),
                 static_cast<int32_t>(plugin->getType()),
                 static_cast<int32_t>(plugin->getCategory()),
@@ -113,7 +274,7 @@ void CarlaEngineOsc::sendPluginPortCount(const CarlaPluginPtr& plugin) const noe
     char targetPath[std::strlen(fControlDataTCP.path)+7];
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/ports");
-    try_lo_send(fControlDataTCP.target, targetPath, "iiiiiiii",
+    try_lo_send_tcp(targetPath, "iiiiiiii",
                 static_cast<int32_t>(plugin->getId()),
                 static_cast<int32_t>(plugin->getAudioInCount()),
                 static_cast<int32_t>(plugin->getAudioOutCount()),
@@ -156,7 +317,7 @@ void CarlaEngineOsc::sendPluginParameterInfo(const CarlaPluginPtr& plugin, const
 
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/paramInfo");
-    try_lo_send(fControlDataTCP.target, targetPath, "iissss",
+    try_lo_send_tcp(targetPath, "iissss",
                 pluginId, 
                 paramId,
                 bufName, 
@@ -166,7 +327,7 @@ void CarlaEngineOsc::sendPluginParameterInfo(const CarlaPluginPtr& plugin, const
 
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/paramData");
-    try_lo_send(fControlDataTCP.target, targetPath, "iiiiiifff",
+    try_lo_send_tcp(targetPath, "iiiiiifff",
                 pluginId, 
                 paramId,
                 static_cast<int32_t>(paramData.type), 
@@ -179,7 +340,7 @@ void CarlaEngineOsc::sendPluginParameterInfo(const CarlaPluginPtr& plugin, const
 
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/paramRanges");
-    try_lo_send(fControlDataTCP.target, targetPath, "iiffffff",
+    try_lo_send_tcp(targetPath, "iiffffff",
                 pluginId, 
                 paramId,
                 static_cast<double>(paramRanges.def),
@@ -200,7 +361,7 @@ void CarlaEngineOsc::sendPluginDataCount(const CarlaPluginPtr& plugin) const noe
     char targetPath[std::strlen(fControlDataTCP.path)+7];
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/count");
-    try_lo_send(fControlDataTCP.target, targetPath, "iiiiii",
+    try_lo_send_tcp(targetPath, "iiiiii",
                 static_cast<int32_t>(plugin->getId()),
                 static_cast<int32_t>(plugin->getProgramCount()),
                 static_cast<int32_t>(plugin->getMidiProgramCount()),
@@ -219,7 +380,7 @@ void CarlaEngineOsc::sendPluginProgramCount(const CarlaPluginPtr& plugin) const
     char targetPath[std::strlen(fControlDataTCP.path)+7];
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/pcount");
-    try_lo_send(fControlDataTCP.target, targetPath, "iii",
+    try_lo_send_tcp(targetPath, "iii",
                 static_cast<int32_t>(plugin->getId()),
                 static_cast<int32_t>(plugin->getProgramCount()),
                 static_cast<int32_t>(plugin->getMidiProgramCount()));
@@ -239,7 +400,7 @@ void CarlaEngineOsc::sendPluginProgram(const CarlaPluginPtr& plugin, const uint3
     char targetPath[std::strlen(fControlDataTCP.path)+6];
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/prog");
-    try_lo_send(fControlDataTCP.target, targetPath, "iis",
+    try_lo_send_tcp(targetPath, "iis",
                 static_cast<int32_t>(plugin->getId()), static_cast<int32_t>(index), strBuf);
 }
 
@@ -255,7 +416,7 @@ void CarlaEngineOsc::sendPluginMidiProgram(const CarlaPluginPtr& plugin, const u
     char targetPath[std::strlen(fControlDataTCP.path)+7];
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/mprog");
-    try_lo_send(fControlDataTCP.target, targetPath, "iiiis",
+    try_lo_send_tcp(targetPath, "iiiis",
                 static_cast<int32_t>(plugin->getId()),
                 static_cast<int32_t>(index),
                 static_cast<int32_t>(mpdata.bank), static_cast<int32_t>(mpdata.program), mpdata.name);
@@ -273,7 +434,7 @@ void CarlaEngineOsc::sendPluginCustomData(const CarlaPluginPtr& plugin, const ui
     char targetPath[std::strlen(fControlDataTCP.path)+7];
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/cdata");
-    try_lo_send(fControlDataTCP.target, targetPath, "iisss",
+    try_lo_send_tcp(targetPath, "iisss",
                 static_cast<int32_t>(plugin->getId()),
                 static_cast<int32_t>(index),
                 cdata.type, cdata.key, cdata.value);
@@ -298,7 +459,7 @@ void CarlaEngineOsc::sendPluginInternalParameterValues(const CarlaPluginPtr& plu
     char targetPath[std::strlen(fControlDataTCP.path)+18];
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/iparams");
-    try_lo_send(fControlDataTCP.target, targetPath, "ifffffff",
+    try_lo_send_tcp(targetPath, "ifffffff",
                 static_cast<int32_t>(plugin->getId()),
                 iparams[0], // PARAMETER_ACTIVE
                 iparams[1], // PARAMETER_DRYWET
@@ -312,6 +473,51 @@ void CarlaEngineOsc::sendPluginInternalParameterValues(const CarlaPluginPtr& plu
 
 // -----------------------------------------------------------------------
 
+// small enough to fit in a TCP bundle
+static const std::size_t kMaxPatchbaySnapshotChunkSize = 8192;
+
+void CarlaEngineOsc::sendPatchbaySnapshot(const char* snapshot) const noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(fControlDataTCP.path != nullptr && fControlDataTCP.path[0] != '\0',);
+    CARLA_SAFE_ASSERT_RETURN(fControlDataTCP.target != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(snapshot != nullptr,);
+    carla_debug("CarlaEngineOsc::sendPatchbaySnapshot(%p)", snapshot);
+
+    char targetPath[std::strlen(fControlDataTCP.path)+10];
+    std::strcpy(targetPath, fControlDataTCP.path);
+    std::strcat(targetPath, "/patchbay");
+
+    // split on record boundaries, so each chunk can be parsed on its own
+    char chunk[kMaxPatchbaySnapshotChunkSize+1];
+    std::size_t remaining = std::strlen(snapshot);
+    int index = 0;
+
+    do {
+        std::size_t size = remaining;
+
+        if (size > kMaxPatchbaySnapshotChunkSize)
+        {
+            size = kMaxPatchbaySnapshotChunkSize;
+
+            while (size > 0 && snapshot[size-1] != '\x1e')
+                --size;
+
+            // records are names plus a few numbers, way smaller than a chunk
+            CARLA_SAFE_ASSERT_RETURN(size != 0,);
+        }
+
+        std::memcpy(chunk, snapshot, size);
+        chunk[size] = '\0';
+
+        snapshot  += size;
+        remaining -= size;
+
+        try_lo_send_tcp(targetPath, "iis", index++, remaining == 0 ? 1 : 0, chunk);
+    } while (remaining != 0);
+}
+
+// -----------------------------------------------------------------------
+
 void CarlaEngineOsc::sendPing() const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(fControlDataTCP.path != nullptr && fControlDataTCP.path[0] != '\0',);
@@ -320,7 +526,7 @@ void CarlaEngineOsc::sendPing() const noexcept
     char targetPath[std::strlen(fControlDataTCP.path)+6];
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/ping");
-    try_lo_send(fControlDataTCP.target, targetPath, "");
+    try_lo_send_tcp(targetPath, "");
 }
 
 void CarlaEngineOsc::sendResponse(const int messageId, const char* const error) const noexcept
@@ -332,7 +538,7 @@ void CarlaEngineOsc::sendResponse(const int messageId, const char* const error)
     char targetPath[std::strlen(fControlDataTCP.path)+6];
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/resp");
-    try_lo_send(fControlDataTCP.target, targetPath, "is", messageId, error);
+    try_lo_send_tcp(targetPath, "is", messageId, error);
 }
 
 void CarlaEngineOsc::sendExit() const noexcept
@@ -344,59 +550,176 @@ void CarlaEngineOsc::sendExit() const noexcept
     char targetPath[std::strlen(fControlDataTCP.path)+6];
     std::strcpy(targetPath, fControlDataTCP.path);
     std::strcat(targetPath, "/exit");
-    try_lo_send(fControlDataTCP.target, targetPath, "");
+    try_lo_send_tcp(targetPath, "");
 }
 
 // -----------------------------------------------------------------------
 
-void CarlaEngineOsc::sendRuntimeInfo() const noexcept
-{
-    CARLA_SAFE_ASSERT_RETURN(fControlDataUDP.path != nullptr && fControlDataUDP.path[0] != '\0',);
-    CARLA_SAFE_ASSERT_RETURN(fControlDataUDP.target != nullptr,);
-
-    const EngineTimeInfo timeInfo(fEngine->getTimeInfo());
-
-    char targetPath[std::strlen(fControlDataUDP.path)+18];
-    std::strcpy(targetPath, fControlDataUDP.path);
-    std::strcat(targetPath, "/runtime");
-    try_lo_send(fControlDataUDP.target, targetPath, "fiihiiif",
-                static_cast<double>(fEngine->getDSPLoad()),
-                static_cast<int32_t>(fEngine->getTotalXruns()),
-                timeInfo.playing ? 1 : 0,
-                static_cast<int64_t>(timeInfo.frame),
-                static_cast<int32_t>(timeInfo.bbt.bar),
-                static_cast<int32_t>(timeInfo.bbt.beat),
-                static_cast<int32_t>(timeInfo.bbt.tick),
-                timeInfo.bbt.beatsPerMinute);
-}
+// full updates are sent once in a while, in case some packets were lost
+static const int64_t kFullUpdateInterval = 1000;
 
-void CarlaEngineOsc::sendParameterValue(const uint pluginId, const uint32_t index, const float value) const noexcept
+void CarlaEngineOsc::sendRuntimeUpdates() noexcept
 {
-    CARLA_SAFE_ASSERT_RETURN(fControlDataUDP.path != nullptr && fControlDataUDP.path[0] != '\0',);
-    CARLA_SAFE_ASSERT_RETURN(fControlDataUDP.target != nullptr,);
-
-    char targetPath[std::strlen(fControlDataUDP.path)+21];
-    std::strcpy(targetPath, fControlDataUDP.path);
-    std::strcat(targetPath, "/param");
-    try_lo_send(fControlDataUDP.target, targetPath, "iif",
-                static_cast<int32_t>(pluginId),
-                index,
-                static_cast<double>(value));
+    const CarlaMutexLocker cml(fUdpClientsMutex);
+
+    if (fNumUdpClients == 0)
+        return;
+
+    const int64_t timeNow = water::Time::currentTimeMillis();
+
+    for (uint i=0; i < kMaxUdpClients; ++i)
+    {
+        UdpClient& client(fUdpClients[i]);
+
+        if (client.data.path == nullptr || client.data.target == nullptr)
+            continue;
+        if (client.lastUpdateTime != 0 && timeNow - client.lastUpdateTime < static_cast<int64_t>(client.updateInterval))
+            continue;
+
+        const bool fullUpdate = timeNow - client.lastFullUpdateTime >= kFullUpdateInterval;
+
+        client.lastUpdateTime = timeNow;
+
+        if (fullUpdate)
+            client.lastFullUpdateTime = timeNow;
+
+        try {
+            sendUpdateToUdpClient(client, fullUpdate);
+        } CARLA_SAFE_EXCEPTION("sendUpdateToUdpClient");
+    }
 }
 
-void CarlaEngineOsc::sendPeaks(const uint pluginId, const float peaks[4]) const noexcept
+void CarlaEngineOsc::sendUpdateToUdpClient(UdpClient& client, const bool fullUpdate) noexcept
 {
-    CARLA_SAFE_ASSERT_RETURN(fControlDataUDP.path != nullptr && fControlDataUDP.path[0] != '\0',);
-    CARLA_SAFE_ASSERT_RETURN(fControlDataUDP.target != nullptr,);
-
-    char targetPath[std::strlen(fControlDataUDP.path)+11];
-    std::strcpy(targetPath, fControlDataUDP.path);
-    std::strcat(targetPath, "/peaks");
-    try_lo_send(fControlDataUDP.target, targetPath, "iffff", static_cast<int32_t>(pluginId),
-                static_cast<double>(peaks[0]),
-                static_cast<double>(peaks[1]),
-                static_cast<double>(peaks[2]),
-                static_cast<double>(peaks[3]));
+    const std::size_t pathSize = std::strlen(client.data.path);
+
+    char runtimePath[pathSize+9];
+    std::strcpy(runtimePath, client.data.path);
+    std::strcat(runtimePath, "/runtime");
+
+    char paramPath[pathSize+7];
+    std::strcpy(paramPath, client.data.path);
+    std::strcat(paramPath, "/param");
+
+    char peaksPath[pathSize+7];
+    std::strcpy(peaksPath, client.data.path);
+    std::strcat(peaksPath, "/peaks");
+
+    char cpuTimePath[pathSize+9];
+    std::strcpy(cpuTimePath, client.data.path);
+    std::strcat(cpuTimePath, "/cputime");
+
+    CarlaOscBundleSender sender(client.data.target, kMaxUdpBundleSize);
+
+    // -------------------------------------------------------------------
+    // runtime info, always sent
+
+    if (const lo_message msg = lo_message_new())
+    {
+        const EngineTimeInfo timeInfo(fEngine->getTimeInfo());
+
+        lo_message_add_float(msg, fEngine->getDSPLoad());
+        lo_message_add_int32(msg, static_cast<int32_t>(fEngine->getTotalXruns()));
+        lo_message_add_int32(msg, timeInfo.playing ? 1 : 0);
+        lo_message_add_int64(msg, static_cast<int64_t>(timeInfo.frame));
+        lo_message_add_int32(msg, static_cast<int32_t>(timeInfo.bbt.bar));
+        lo_message_add_int32(msg, static_cast<int32_t>(timeInfo.bbt.beat));
+        lo_message_add_int32(msg, static_cast<int32_t>(timeInfo.bbt.tick));
+        lo_message_add_float(msg, static_cast<float>(timeInfo.bbt.beatsPerMinute));
+        sender.add(runtimePath, msg);
+    }
+
+    // -------------------------------------------------------------------
+    // peaks and output parameters, only sent if changed
+    // process time statistics, only sent on full updates
+
+    const uint pluginCount = fEngine->getCurrentPluginCount();
+
+    if (client.plugins.size() != pluginCount)
+        client.plugins.resize(pluginCount);
+
+    std::vector<float> allPeaks(pluginCount*4, 0.0f);
+
+    if (pluginCount != 0)
+        fEngine->getAllPeaks(allPeaks.data(), pluginCount);
+
+    for (uint i=0; i < pluginCount; ++i)
+    {
+        const CarlaPluginPtr plugin = fEngine->getPluginUnchecked(i);
+        CARLA_SAFE_ASSERT_CONTINUE(plugin.get() != nullptr && plugin->isEnabled());
+
+        const uint32_t paramCount = plugin->getParameterCount();
+        UdpPluginValues& last(client.plugins[i]);
+        bool sendAll = fullUpdate;
+
+        // plugins were added, removed or reloaded
+        if (last.plugin != plugin.get() || last.values.size() != paramCount + 4)
+        {
+            last.plugin = plugin.get();
+            last.values.assign(paramCount + 4, 0.0f);
+            sendAll = true;
+        }
+
+        float* const lastValues = last.values.data();
+        const float* const peaks = &allPeaks[i*4];
+
+        if (sendAll
+            || std::abs(peaks[0] - lastValues[0]) > client.epsilon
+            || std::abs(peaks[1] - lastValues[1]) > client.epsilon
+            || std::abs(peaks[2] - lastValues[2]) > client.epsilon
+            || std::abs(peaks[3] - lastValues[3]) > client.epsilon)
+        {
+            if (const lo_message msg = lo_message_new())
+            {
+                lo_message_add_int32(msg, static_cast<int32_t>(i));
+                lo_message_add_float(msg, peaks[0]);
+                lo_message_add_float(msg, peaks[1]);
+                lo_message_add_float(msg, peaks[2]);
+                lo_message_add_float(msg, peaks[3]);
+                sender.add(peaksPath, msg);
+            }
+
+            carla_copyFloats(lastValues, peaks, 4);
+        }
+
+        if (fullUpdate)
+        {
+            const EnginePluginProcessTimeInfo timeInfo(fEngine->getPluginProcessTimeInfo(i));
+
+            if (const lo_message msg = lo_message_new())
+            {
+                lo_message_add_int32(msg, static_cast<int32_t>(i));
+                lo_message_add_int64(msg, static_cast<int64_t>(timeInfo.count));
+                lo_message_add_float(msg, timeInfo.minUsecs);
+                lo_message_add_float(msg, timeInfo.avgUsecs);
+                lo_message_add_float(msg, timeInfo.maxUsecs);
+                lo_message_add_float(msg, timeInfo.p99Usecs);
+                lo_message_add_float(msg, timeInfo.avgSubBlocks);
+                sender.add(cpuTimePath, msg);
+            }
+        }
+
+        for (uint32_t j=0; j < paramCount; ++j)
+        {
+            if (! plugin->isParameterOutput(j))
+                continue;
+
+            const float value = plugin->getParameterValue(j);
+
+            if (! sendAll && std::abs(value - lastValues[4+j]) <= client.epsilon)
+                continue;
+
+            if (const lo_message msg = lo_message_new())
+            {
+                lo_message_add_int32(msg, static_cast<int32_t>(i));
+                lo_message_add_int32(msg, static_cast<int32_t>(j));
+                lo_message_add_float(msg, value);
+                sender.add(paramPath, msg);
+            }
+
+            lastValues[4+j] = value;
+        }
+    }
 }
 
 // -----------------------------------------------------------------------
@@ -17,10 +17,12 @@
 
 #include "CarlaEnginePorts.hpp"
 #include "CarlaEngineUtils.hpp"
+#include "CarlaFloatStringUtils.hpp"
 #include "CarlaMathUtils.hpp"
 #include "CarlaMIDI.h"
 
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+#include "CarlaEngineClient.hpp"
 #include "CarlaEngineGraph.hpp"
 #endif
 
@@ -60,7 +62,8 @@ void CarlaEnginePort::setMetaData(const char*, const char*, const char*)
 
 CarlaEngineAudioPort::CarlaEngineAudioPort(const CarlaEngineClient& client, const bool isInputPort, const uint32_t indexOffset) noexcept
     : CarlaEnginePort(client, isInputPort, indexOffset),
-      fBuffer(nullptr)
+      fBuffer(nullptr),
+      fNeedsBufferInit(false)
 {
     carla_debug("CarlaEngineAudioPort::CarlaEngineAudioPort(%s)", bool2str(isInputPort));
 }
@@ -81,7 +84,8 @@ CarlaEngineCVPort::CarlaEngineCVPort(const CarlaEngineClient& client, const bool
     : CarlaEnginePort(client, isInputPort, indexOffset),
       fBuffer(nullptr),
       fMinimum(-1.0f),
-      fMaximum(1.0f)
+      fMaximum(1.0f),
+      fNeedsBufferInit(false)
 {
     carla_debug("CarlaEngineCVPort::CarlaEngineCVPort(%s)", bool2str(isInputPort));
 }
@@ -100,20 +104,44 @@ void CarlaEngineCVPort::setRange(const float min, const float max) noexcept
     fMinimum = min;
     fMaximum = max;
 
-    char strBufMin[STR_MAX];
-    char strBufMax[STR_MAX];
-    carla_zeroChars(strBufMin, STR_MAX);
-    carla_zeroChars(strBufMax, STR_MAX);
+    setMetaData(LV2_CORE__minimum, CarlaFloatString(min).buffer, "");
+    setMetaData(LV2_CORE__maximum, CarlaFloatString(max).buffer, "");
+}
 
+// -----------------------------------------------------------------------
+// Carla Engine Event port storage
+// In patchbay mode each event port owns its buffer, sized by ENGINE_OPTION_EVENT_PORT_BUFFER_SIZE.
+// When it overflows the audio thread only raises a flag; a non-RT thread then allocates a buffer twice as big,
+// which the audio thread swaps in at the start of its next cycle, handing back the old one to be deleted.
+// Buffers get one extra slot that always stays null, so they are terminated even when full.
+
+struct EngineEventPortStorage {
+    EngineEvent* volatile pending;
+    EngineEvent* volatile retired;
+    volatile uint32_t pendingCapacity;
+    volatile bool overflowed;
+
+    EngineEventPortStorage() noexcept
+        : pending(nullptr),
+          retired(nullptr),
+          pendingCapacity(0),
+          overflowed(false) {}
+
+    ~EngineEventPortStorage() noexcept
     {
-        const CarlaScopedLocale csl;
-        std::snprintf(strBufMin, STR_MAX-1, "%.12g", static_cast<double>(min));
-        std::snprintf(strBufMax, STR_MAX-1, "%.12g", static_cast<double>(max));
+        delete[] pending;
+        delete[] retired;
     }
 
-    setMetaData(LV2_CORE__minimum, strBufMin, "");
-    setMetaData(LV2_CORE__maximum, strBufMax, "");
-}
+    static EngineEvent* allocateBuffer(const uint32_t capacity)
+    {
+        EngineEvent* const buffer = new EngineEvent[capacity+1];
+        carla_zeroStructs(buffer, capacity+1);
+        return buffer;
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(EngineEventPortStorage)
+};
 
 // -----------------------------------------------------------------------
 // Carla Engine Event port
@@ -121,14 +149,31 @@ void CarlaEngineCVPort::setRange(const float min, const float max) noexcept
 CarlaEngineEventPort::CarlaEngineEventPort(const CarlaEngineClient& client, const bool isInputPort, const uint32_t indexOffset) noexcept
     : CarlaEnginePort(client, isInputPort, indexOffset),
       kProcessMode(client.getEngine().getProccessMode()),
-      fBuffer(nullptr)
+      fBuffer(nullptr),
+      fBufferCapacity(0),
+      fDataArena(nullptr),
+      fStorage(nullptr)
 {
     carla_debug("CarlaEngineEventPort::CarlaEngineEventPort(%s)", bool2str(isInputPort));
 
     if (kProcessMode == ENGINE_PROCESS_MODE_PATCHBAY)
     {
-        fBuffer = new EngineEvent[kMaxEngineEventInternalCount];
-        carla_zeroStructs(fBuffer, kMaxEngineEventInternalCount);
+        const uint32_t capacity = carla_fixedValue<uint32_t>(16U, kMaxEngineEventInternalCount,
+                                                             client.getEngine().getOptions().eventPortBufferSize);
+
+        try {
+            fStorage = new EngineEventPortStorage();
+            fBuffer  = EngineEventPortStorage::allocateBuffer(capacity);
+            fBufferCapacity = capacity;
+        } CARLA_SAFE_EXCEPTION("CarlaEngineEventPort buffer");
+    }
+
+    // only used for large MIDI events written into internal buffers
+    if (! isInputPort && kProcessMode != ENGINE_PROCESS_MODE_SINGLE_CLIENT && kProcessMode != ENGINE_PROCESS_MODE_MULTIPLE_CLIENTS)
+    {
+        try {
+            fDataArena = new EngineEventDataArena();
+        } CARLA_SAFE_EXCEPTION("CarlaEngineEventPort data arena");
     }
 }
 
@@ -136,6 +181,18 @@ CarlaEngineEventPort::~CarlaEngineEventPort() noexcept
 {
     carla_debug("CarlaEngineEventPort::~CarlaEngineEventPort()");
 
+    if (fDataArena != nullptr)
+    {
+        delete fDataArena;
+        fDataArena = nullptr;
+    }
+
+    if (fStorage != nullptr)
+    {
+        delete fStorage;
+        fStorage = nullptr;
+    }
+
     if (kProcessMode == ENGINE_PROCESS_MODE_PATCHBAY)
     {
         CARLA_SAFE_ASSERT_RETURN(fBuffer != nullptr,);
@@ -147,10 +204,88 @@ CarlaEngineEventPort::~CarlaEngineEventPort() noexcept
 
 void CarlaEngineEventPort::initBuffer() noexcept
 {
+    if (fDataArena != nullptr)
+        fDataArena->reset();
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    // plugins processed in a separate rack lane have their own event buffers
+    if (kProcessMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK)
+    {
+        if (const CarlaPlugin* const plugin = kClient.pData->plugin.get())
+        {
+            if (RackGraph* const rack = kClient.pData->egraph.getRackGraph())
+            {
+                if (EngineEvent* const laneBuffer = rack->getLaneEventBuffer(plugin->getId(), kIsInput))
+                {
+                    fBuffer = laneBuffer;
+                    fBufferCapacity = kMaxEngineEventInternalCount;
+                    return;
+                }
+            }
+        }
+    }
+#endif
+
     if (kProcessMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK || kProcessMode == ENGINE_PROCESS_MODE_BRIDGE)
+    {
         fBuffer = kClient.getEngine().getInternalEventBuffer(kIsInput);
+        fBufferCapacity = kMaxEngineEventInternalCount;
+    }
     else if (kProcessMode == ENGINE_PROCESS_MODE_PATCHBAY && ! kIsInput)
-        carla_zeroStructs(fBuffer, kMaxEngineEventInternalCount);
+    {
+        // input ports are filled by the graph before this, which picks up grown buffers on its own
+        adoptGrownBuffer();
+        clearEngineEvents(fBuffer);
+    }
+}
+
+void CarlaEngineEventPort::growBufferIfNeeded() noexcept
+{
+    if (fStorage == nullptr)
+        return;
+
+    if (EngineEvent* const retired = __sync_lock_test_and_set(&fStorage->retired, nullptr))
+        delete[] retired;
+
+    // the capacity only changes while a grown buffer is pending, so it is safe to read here
+    if (! fStorage->overflowed || fStorage->pending != nullptr || fStorage->retired != nullptr)
+        return;
+
+    fStorage->overflowed = false;
+
+    if (fBufferCapacity >= kMaxEngineEventInternalCount)
+        return;
+
+    const uint32_t capacity = std::min(fBufferCapacity*2, static_cast<uint32_t>(kMaxEngineEventInternalCount));
+    EngineEvent* buffer;
+
+    try {
+        buffer = EngineEventPortStorage::allocateBuffer(capacity);
+    } CARLA_SAFE_EXCEPTION_RETURN("CarlaEngineEventPort::growBufferIfNeeded",);
+
+    fStorage->pendingCapacity = capacity;
+    __sync_synchronize();
+    fStorage->pending = buffer;
+
+    carla_stdout("CarlaEngineEventPort::growBufferIfNeeded() - event buffer now holds %u events", capacity);
+}
+
+void CarlaEngineEventPort::adoptGrownBuffer() noexcept
+{
+    if (fStorage == nullptr || fStorage->pending == nullptr)
+        return;
+
+    fStorage->retired = fBuffer;
+    fBuffer = fStorage->pending;
+    fBufferCapacity = fStorage->pendingCapacity;
+    __sync_synchronize();
+    fStorage->pending = nullptr;
+}
+
+void CarlaEngineEventPort::setBufferOverflowed() noexcept
+{
+    if (fStorage != nullptr)
+        fStorage->overflowed = true;
 }
 
 uint32_t CarlaEngineEventPort::getEventCount() const noexcept
@@ -159,15 +294,7 @@ uint32_t CarlaEngineEventPort::getEventCount() const noexcept
     CARLA_SAFE_ASSERT_RETURN(fBuffer != nullptr, 0);
     CARLA_SAFE_ASSERT_RETURN(kProcessMode != ENGINE_PROCESS_MODE_SINGLE_CLIENT && kProcessMode != ENGINE_PROCESS_MODE_MULTIPLE_CLIENTS, 0);
 
-    uint32_t i=0;
-
-    for (; i < kMaxEngineEventInternalCount; ++i)
-    {
-        if (fBuffer[i].type == kEngineEventTypeNull)
-            break;
-    }
-
-    return i;
+    return getEngineEventCount(fBuffer);
 }
 
 EngineEvent& CarlaEngineEventPort::getEvent(const uint32_t index) const noexcept
@@ -175,7 +302,7 @@ EngineEvent& CarlaEngineEventPort::getEvent(const uint32_t index) const noexcept
     CARLA_SAFE_ASSERT_RETURN(kIsInput, kFallbackEngineEvent);
     CARLA_SAFE_ASSERT_RETURN(fBuffer != nullptr, kFallbackEngineEvent);
     CARLA_SAFE_ASSERT_RETURN(kProcessMode != ENGINE_PROCESS_MODE_SINGLE_CLIENT && kProcessMode != ENGINE_PROCESS_MODE_MULTIPLE_CLIENTS, kFallbackEngineEvent);
-    CARLA_SAFE_ASSERT_RETURN(index < kMaxEngineEventInternalCount, kFallbackEngineEvent);
+    CARLA_SAFE_ASSERT_RETURN(index < fBufferCapacity, kFallbackEngineEvent);
 
     return fBuffer[index];
 }
@@ -207,13 +334,15 @@ bool CarlaEngineEventPort::writeControlEvent(const uint32_t time, const uint8_t
         CARLA_SAFE_ASSERT(! MIDI_IS_CONTROL_BANK_SELECT(param));
     }
 
-    for (uint32_t i=0; i < kMaxEngineEventInternalCount; ++i)
+    for (uint32_t i=0; i < fBufferCapacity; ++i)
     {
         EngineEvent& event(fBuffer[i]);
 
         if (event.type != kEngineEventTypeNull)
             continue;
 
+        terminateEngineEvents(fBuffer, i+1);
+
         event.type    = kEngineEventTypeControl;
         event.time    = time;
         event.channel = channel;
@@ -222,11 +351,13 @@ bool CarlaEngineEventPort::writeControlEvent(const uint32_t time, const uint8_t
         event.ctrl.param           = param;
         event.ctrl.midiValue       = midiValue;
         event.ctrl.normalizedValue = carla_fixedValue<float>(0.0f, 1.0f, normalizedValue);
+        event.ctrl.handled         = false;
 
         return true;
     }
 
     carla_stderr2("CarlaEngineEventPort::writeControlEvent() - buffer full");
+    setBufferOverflowed();
     return false;
 }
 
@@ -238,7 +369,7 @@ bool CarlaEngineEventPort::writeMidiEvent(const uint32_t time, const uint8_t siz
 bool CarlaEngineEventPort::writeMidiEvent(const uint32_t time, const uint8_t channel, const EngineMidiEvent& midi) noexcept
 {
     CARLA_SAFE_ASSERT(midi.port == kIndexOffset);
-    return writeMidiEvent(time, channel, midi.size, midi.data);
+    return writeMidiEvent(time, channel, midi.size, midi.size > EngineMidiEvent::kDataSize ? midi.dataExt : midi.data);
 }
 
 bool CarlaEngineEventPort::writeMidiEvent(const uint32_t time, const uint8_t channel, const uint8_t size, const uint8_t* const data) noexcept
@@ -247,19 +378,50 @@ bool CarlaEngineEventPort::writeMidiEvent(const uint32_t time, const uint8_t cha
     CARLA_SAFE_ASSERT_RETURN(fBuffer != nullptr, false);
     CARLA_SAFE_ASSERT_RETURN(kProcessMode != ENGINE_PROCESS_MODE_SINGLE_CLIENT && kProcessMode != ENGINE_PROCESS_MODE_MULTIPLE_CLIENTS, false);
     CARLA_SAFE_ASSERT_RETURN(channel < MAX_MIDI_CHANNELS, false);
-    CARLA_SAFE_ASSERT_RETURN(size > 0 && size <= EngineMidiEvent::kDataSize, false);
+    CARLA_SAFE_ASSERT_RETURN(size > 0, false);
     CARLA_SAFE_ASSERT_RETURN(data != nullptr, false);
 
-    for (uint32_t i=0; i < kMaxEngineEventInternalCount; ++i)
+    // large events keep their raw data (channel included) in the arena
+    uint8_t* dataExt = nullptr;
+
+    if (size > EngineMidiEvent::kDataSize)
+    {
+        CARLA_SAFE_ASSERT_RETURN(fDataArena != nullptr, false);
+
+        dataExt = fDataArena->allocate(size);
+
+        if (dataExt == nullptr)
+        {
+            carla_stderr2("CarlaEngineEventPort::writeMidiEvent() - data arena full");
+            return false;
+        }
+
+        std::memcpy(dataExt, data, size);
+    }
+
+    for (uint32_t i=0; i < fBufferCapacity; ++i)
     {
         EngineEvent& event(fBuffer[i]);
 
         if (event.type != kEngineEventTypeNull)
             continue;
 
+        // slots are reused without zeroing, keep the buffer terminated
+        terminateEngineEvents(fBuffer, i+1);
+
         event.time    = time;
         event.channel = channel;
 
+        if (dataExt != nullptr)
+        {
+            event.type         = kEngineEventTypeMidi;
+            event.midi.port    = kIndexOffset < 0xFF ? static_cast<uint8_t>(kIndexOffset) : 0;
+            event.midi.size    = size;
+            event.midi.dataExt = dataExt;
+            carla_zeroBytes(event.midi.data, EngineMidiEvent::kDataSize);
+            return true;
+        }
+
         const uint8_t status(uint8_t(MIDI_GET_STATUS_FROM_DATA(data)));
 
         if (status == MIDI_STATUS_CONTROL_CHANGE)
@@ -333,10 +495,12 @@ bool CarlaEngineEventPort::writeMidiEvent(const uint32_t time, const uint8_t cha
         for (; j < EngineMidiEvent::kDataSize; ++j)
             event.midi.data[j] = 0;
 
+        event.midi.dataExt = nullptr;
         return true;
     }
 
     carla_stderr2("CarlaEngineEventPort::writeMidiEvent() - buffer full");
+    setBufferOverflowed();
     return false;
 }
 
@@ -429,25 +593,22 @@ void CarlaEngineCVSourcePorts::initPortBuffers(const float* const* const buffers
     EngineEvent* const buffer = eventPort->fBuffer;
     CARLA_SAFE_ASSERT_RETURN(buffer != nullptr,);
 
-    uint32_t eventCount = 0;
+    const uint32_t bufferSize = eventPort->fBufferCapacity;
+    uint32_t eventCount = getEngineEventCount(buffer);
     float v, min, max;
 
-    for (; eventCount < kMaxEngineEventInternalCount; ++eventCount)
-    {
-        if (buffer[eventCount].type == kEngineEventTypeNull)
-            break;
-    }
-
-    if (eventCount == kMaxEngineEventInternalCount)
+    if (eventCount >= bufferSize)
         return;
 
-    // TODO be sample accurate
+    const uint32_t controlPeriod = sampleAccurate
+                                 ? eventPort->getEngineClient().getEngine().getOptions().cvControlPeriod
+                                 : 0;
 
-    if (true || ! sampleAccurate)
+    if (controlPeriod == 0 || controlPeriod >= frames)
     {
         const uint32_t eventFrame = eventCount == 0 ? 0 : std::min(buffer[eventCount-1].time, frames-1U);
 
-        for (int i = 0; i < numCVs && eventCount < kMaxEngineEventInternalCount; ++i)
+        for (int i = 0; i < numCVs && eventCount < bufferSize; ++i)
         {
             CarlaEngineEventCV& ecv(pData->cvs.getReference(i));
             CARLA_SAFE_ASSERT_CONTINUE(ecv.cvPort != nullptr);
@@ -472,11 +633,73 @@ void CarlaEngineCVSourcePorts::initPortBuffers(const float* const* const buffers
                 event.ctrl.param           = static_cast<uint16_t>(ecv.indexOffset);
                 event.ctrl.midiValue       = -1;
                 event.ctrl.normalizedValue = carla_fixedValue(0.0f, 1.0f, (v - min) / (max - min));
+                event.ctrl.handled         = false;
             }
 
             ecv.previousValue = previousValue;
         }
+
+        terminateEngineEvents(buffer, eventCount);
+        return;
     }
+
+    // Read each CV once per control period and stage the changes at the end of the buffer, in time order.
+    // Only half of the free space is used, so that the merge below never overwrites staged events not yet read.
+    const uint32_t capacity   = (bufferSize - eventCount) / 2;
+    const uint32_t stageStart = bufferSize - capacity;
+    uint32_t numStaged = 0;
+
+    for (uint32_t frame = 0; frame < frames && numStaged < capacity; frame += controlPeriod)
+    {
+        for (int i = 0; i < numCVs && numStaged < capacity; ++i)
+        {
+            CarlaEngineEventCV& ecv(pData->cvs.getReference(i));
+            CARLA_SAFE_ASSERT_CONTINUE(ecv.cvPort != nullptr);
+            CARLA_SAFE_ASSERT_CONTINUE(buffers[i] != nullptr);
+
+            v = buffers[i][frame];
+
+            if (carla_isEqual(v, ecv.previousValue))
+                continue;
+
+            ecv.previousValue = v;
+            ecv.cvPort->getRange(min, max);
+
+            EngineEvent& event(buffer[stageStart + numStaged++]);
+
+            event.type    = kEngineEventTypeControl;
+            event.time    = frame;
+            event.channel = kEngineEventNonMidiChannel;
+
+            event.ctrl.type            = kEngineControlEventTypeParameter;
+            event.ctrl.param           = static_cast<uint16_t>(ecv.indexOffset);
+            event.ctrl.midiValue       = -1;
+            event.ctrl.normalizedValue = carla_fixedValue(0.0f, 1.0f, (v - min) / (max - min));
+            event.ctrl.handled         = false;
+        }
+    }
+
+    // Merge from the back, keeping events sorted by time and CV events after other events of the same frame.
+    uint32_t numOld  = eventCount;
+    uint32_t numLeft = numStaged;
+    uint32_t writeIndex = eventCount + numStaged;
+
+    while (numLeft != 0)
+    {
+        const EngineEvent& staged(buffer[stageStart + numLeft - 1]);
+
+        if (numOld != 0 && buffer[numOld - 1].time > staged.time)
+        {
+            buffer[--writeIndex] = buffer[--numOld];
+        }
+        else
+        {
+            buffer[--writeIndex] = staged;
+            --numLeft;
+        }
+    }
+
+    terminateEngineEvents(buffer, eventCount + numStaged);
 }
 
 bool CarlaEngineCVSourcePorts::setCVSourceRange(const uint32_t portIndexOffset, const float minimum, const float maximum)
@@ -0,0 +1,576 @@
+/*
+ * Carla Plugin Host
+ * Copyright (C) 2011-2019 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#include "CarlaEngineGraph.hpp"
+#include "CarlaEngineInit.hpp"
+#include "CarlaEngineInternal.hpp"
+#include "CarlaTimeUtils.hpp"
+
+#include <cstdio>
+
+CARLA_BACKEND_START_NAMESPACE
+
+// -------------------------------------------------------------------------------------------------------------------
+// Render file writer, encodes rendered audio on its own thread so disk I/O does not slow down rendering
+
+class CarlaEngineRenderWriter : public CarlaThread
+{
+public:
+    static const uint kNumBlocks   = 64;
+    static const uint kNumChannels = 2;
+
+    CarlaEngineRenderWriter()
+        : CarlaThread("CarlaEngineRenderWriter"),
+          fFile(nullptr),
+          fBlockSize(0),
+          fSampleRate(0),
+          fReadIndex(0),
+          fWriteIndex(0),
+          fNumQueued(0),
+          fFramesWritten(0),
+          fFinishing(false),
+          fFailed(false),
+          fMutex(),
+          fDataSignal(),
+          fSpaceSignal()
+    {
+        carla_zeroPointers(fBlocks, kNumBlocks);
+        carla_zeroStructs(fBlockFrames, kNumBlocks);
+    }
+
+    ~CarlaEngineRenderWriter() override
+    {
+        close();
+
+        for (uint i=0; i < kNumBlocks; ++i)
+            delete[] fBlocks[i];
+    }
+
+    bool open(const char* const filename, const uint32_t blockSize, const double sampleRate)
+    {
+        CARLA_SAFE_ASSERT_RETURN(fFile == nullptr, false);
+        CARLA_SAFE_ASSERT_RETURN(blockSize > 0, false);
+
+        try {
+            for (uint i=0; i < kNumBlocks; ++i)
+                fBlocks[i] = new float[blockSize * kNumChannels];
+        } CARLA_SAFE_EXCEPTION_RETURN("CarlaEngineRenderWriter blocks", false);
+
+        fFile = std::fopen(filename, "wb");
+        CARLA_SAFE_ASSERT_RETURN(fFile != nullptr, false);
+
+        fBlockSize     = blockSize;
+        fSampleRate    = static_cast<uint32_t>(sampleRate + 0.5);
+        fFramesWritten = 0;
+
+        // sizes are filled in once rendering is done
+        writeHeader();
+
+        return startThread();
+    }
+
+    // returns false if writing the file failed at some point
+    bool close()
+    {
+        if (fFile == nullptr)
+            return false;
+
+        fFinishing = true;
+        fDataSignal.signal();
+        stopThread(-1);
+
+        writeHeader();
+
+        const bool ok = ! fFailed && std::fclose(fFile) == 0;
+        fFile = nullptr;
+        return ok;
+    }
+
+    // get a free interleaved block to render into, blocks while the writer thread catches up
+    float* getBlock()
+    {
+        for (;;)
+        {
+            {
+                const CarlaMutexLocker cml(fMutex);
+
+                if (fNumQueued < kNumBlocks)
+                    return fBlocks[fWriteIndex];
+            }
+
+            fSpaceSignal.wait();
+        }
+    }
+
+    void commitBlock(const uint32_t frames)
+    {
+        CARLA_SAFE_ASSERT_RETURN(frames <= fBlockSize,);
+
+        fBlockFrames[fWriteIndex] = frames;
+        fWriteIndex = (fWriteIndex + 1) % kNumBlocks;
+
+        {
+            const CarlaMutexLocker cml(fMutex);
+            ++fNumQueued;
+        }
+
+        fDataSignal.signal();
+    }
+
+protected:
+    void run() override
+    {
+        for (;;)
+        {
+            uint numQueued;
+
+            {
+                const CarlaMutexLocker cml(fMutex);
+                numQueued = fNumQueued;
+            }
+
+            if (numQueued == 0)
+            {
+                if (fFinishing)
+                    break;
+
+                fDataSignal.wait();
+                continue;
+            }
+
+            const uint32_t frames = fBlockFrames[fReadIndex];
+
+            // keep consuming blocks after an error, so rendering never stalls
+            if (! fFailed && frames > 0)
+            {
+                const size_t samples = frames * kNumChannels;
+
+                if (std::fwrite(fBlocks[fReadIndex], sizeof(float), samples, fFile) == samples)
+                    fFramesWritten += frames;
+                else
+                    fFailed = true;
+            }
+
+            fReadIndex = (fReadIndex + 1) % kNumBlocks;
+
+            {
+                const CarlaMutexLocker cml(fMutex);
+                --fNumQueued;
+            }
+
+            fSpaceSignal.signal();
+        }
+    }
+
+private:
+    std::FILE* fFile;
+    float*     fBlocks[kNumBlocks];
+    uint32_t   fBlockFrames[kNumBlocks];
+    uint32_t   fBlockSize;
+    uint32_t   fSampleRate;
+    uint       fReadIndex;
+    uint       fWriteIndex;
+    uint       fNumQueued;
+    uint64_t   fFramesWritten;
+    volatile bool fFinishing;
+    volatile bool fFailed;
+
+    CarlaMutex  fMutex;
+    CarlaSignal fDataSignal;
+    CarlaSignal fSpaceSignal;
+
+    void writeUInt16(const uint16_t value)
+    {
+        const uint8_t data[2] = { uint8_t(value & 0xff), uint8_t(value >> 8) };
+        std::fwrite(data, 1, 2, fFile);
+    }
+
+    void writeUInt32(const uint32_t value)
+    {
+        const uint8_t data[4] = {
+            uint8_t(value & 0xff), uint8_t((value >> 8) & 0xff), uint8_t((value >> 16) & 0xff), uint8_t(value >> 24)
+        };
+        std::fwrite(data, 1, 4, fFile);
+    }
+
+    // 32-bit float WAV header, with extended fmt and fact chunks as required for non-PCM data
+    void writeHeader()
+    {
+        static const uint32_t kHeaderSize = 58;
+        static const uint64_t kMaxDataSize = 0xffffffffULL - kHeaderSize;
+
+        uint64_t dataSize = fFramesWritten * kNumChannels * sizeof(float);
+
+        if (dataSize > kMaxDataSize)
+        {
+            carla_stderr2("CarlaEngineRenderWriter: output is too big for WAV, header sizes will be wrong");
+            dataSize = kMaxDataSize;
+        }
+
+        if (std::fseek(fFile, 0, SEEK_SET) != 0)
+        {
+            fFailed = true;
+            return;
+        }
+
+        std::fwrite("RIFF", 1, 4, fFile);
+        writeUInt32(static_cast<uint32_t>(kHeaderSize - 8 + dataSize));
+        std::fwrite("WAVE", 1, 4, fFile);
+
+        std::fwrite("fmt ", 1, 4, fFile);
+        writeUInt32(18);
+        writeUInt16(3); // WAVE_FORMAT_IEEE_FLOAT
+        writeUInt16(kNumChannels);
+        writeUInt32(fSampleRate);
+        writeUInt32(fSampleRate * kNumChannels * sizeof(float));
+        writeUInt16(kNumChannels * sizeof(float));
+        writeUInt16(32);
+        writeUInt16(0);
+
+        std::fwrite("fact", 1, 4, fFile);
+        writeUInt32(4);
+        writeUInt32(static_cast<uint32_t>(dataSize / (kNumChannels * sizeof(float))));
+
+        std::fwrite("data", 1, 4, fFile);
+        writeUInt32(static_cast<uint32_t>(dataSize));
+
+        if (std::ferror(fFile) != 0)
+            fFailed = true;
+
+        std::fseek(fFile, 0, SEEK_END);
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaEngineRenderWriter)
+};
+
+// -------------------------------------------------------------------------------------------------------------------
+// Render Engine
+
+class CarlaEngineRender : public CarlaEngine,
+                          public CarlaThread
+{
+public:
+    CarlaEngineRender()
+        : CarlaEngine(),
+          CarlaThread("CarlaEngineRender"),
+          fRunning(false),
+          fRenderWriter(nullptr),
+          fRenderFramesLeft(0),
+          fRenderDone()
+    {
+        carla_debug("CarlaEngineRender::CarlaEngineRender()");
+
+        // just to make sure
+        pData->options.transportMode = ENGINE_TRANSPORT_MODE_INTERNAL;
+    }
+
+    ~CarlaEngineRender() override
+    {
+        carla_debug("CarlaEngineRender::~CarlaEngineRender()");
+    }
+
+    // -------------------------------------
+
+    bool init(const char* const clientName) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(clientName != nullptr && clientName[0] != '\0', false);
+        carla_debug("CarlaEngineRender::init(\"%s\")", clientName);
+
+        if (pData->options.processMode != ENGINE_PROCESS_MODE_CONTINUOUS_RACK && pData->options.processMode != ENGINE_PROCESS_MODE_PATCHBAY)
+        {
+            setLastError("Invalid process mode");
+            return false;
+        }
+
+        fRunning = true;
+
+        if (! pData->init(clientName))
+        {
+            close();
+            setLastError("Failed to init internal data");
+            return false;
+        }
+
+        pData->bufferSize = pData->options.audioBufferSize;
+        pData->sampleRate = pData->options.audioSampleRate;
+        pData->initTime(pData->options.transportExtra);
+
+        pData->graph.create(2, 2, 0, 0);
+
+        // not realtime, this thread only renders on request and otherwise idles
+        if (! startThread(false))
+        {
+            close();
+            setLastError("Failed to start render thread");
+            return false;
+        }
+
+        patchbayRefresh(true, false, false);
+
+        callback(true, true,
+                 ENGINE_CALLBACK_ENGINE_STARTED,
+                 0,
+                 pData->options.processMode,
+                 pData->options.transportMode,
+                 static_cast<int>(pData->bufferSize),
+                 static_cast<float>(pData->sampleRate),
+                 getCurrentDriverName());
+        return true;
+    }
+
+    bool close() override
+    {
+        carla_debug("CarlaEngineRender::close()");
+
+        fRunning = false;
+        stopThread(-1);
+        CarlaEngine::close();
+
+        pData->graph.destroy();
+        return true;
+    }
+
+    bool isRunning() const noexcept override
+    {
+        return fRunning;
+    }
+
+    bool isOffline() const noexcept override
+    {
+        return true;
+    }
+
+    EngineType getType() const noexcept override
+    {
+        return kEngineTypeRender;
+    }
+
+    const char* getCurrentDriverName() const noexcept override
+    {
+        return "Render";
+    }
+
+    // -------------------------------------
+
+    bool renderToFile(const char* const filename, const uint64_t frames) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', false);
+        CARLA_SAFE_ASSERT_RETURN(frames > 0, false);
+        CARLA_SAFE_ASSERT_RETURN(fRenderWriter == nullptr, false);
+        carla_debug("CarlaEngineRender::renderToFile(\"%s\", " P_UINT64 ")", filename, frames);
+
+        if (! fRunning || ! isThreadRunning())
+        {
+            setLastError("Engine is not running");
+            return false;
+        }
+
+        CarlaEngineRenderWriter writer;
+
+        if (! writer.open(filename, pData->bufferSize, pData->sampleRate))
+        {
+            setLastError("Failed to open output file");
+            return false;
+        }
+
+        transportRelocate(0);
+        transportPlay();
+
+        const int64_t startTime = carla_gettime_us();
+
+        // hand over to the render thread and wait for it to finish
+        fRenderFramesLeft = frames;
+        __sync_synchronize();
+        fRenderWriter = &writer;
+
+        fRenderDone.wait();
+
+        const int64_t elapsedTime = carla_gettime_us() - startTime;
+        const uint64_t framesLeft = fRenderFramesLeft;
+
+        transportPause();
+
+        if (! writer.close())
+        {
+            setLastError("Failed to write output file");
+            return false;
+        }
+
+        if (framesLeft != 0)
+        {
+            setLastError("Rendering was interrupted");
+            return false;
+        }
+
+        if (elapsedTime > 0)
+            carla_stdout("CarlaEngineRender: rendered " P_UINT64 " frames in %.3fs, %.1fx realtime",
+                         frames, static_cast<double>(elapsedTime) / 1000000.0,
+                         static_cast<double>(frames) / pData->sampleRate * 1000000.0 / static_cast<double>(elapsedTime));
+
+        return true;
+    }
+
+    // -------------------------------------------------------------------
+    // Patchbay
+
+    bool patchbayRefresh(const bool sendHost, const bool sendOSC, const bool) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(pData->graph.isReady(), false);
+
+        if (pData->options.processMode != ENGINE_PROCESS_MODE_CONTINUOUS_RACK)
+            return CarlaEngine::patchbayRefresh(sendHost, sendOSC, false);
+
+        RackGraph* const graph = pData->graph.getRackGraph();
+        CARLA_SAFE_ASSERT_RETURN(graph != nullptr, false);
+
+        ExternalGraph& extGraph(graph->extGraph);
+
+        // ---------------------------------------------------------------
+        // clear last ports
+
+        extGraph.clear();
+
+        // ---------------------------------------------------------------
+        // fill in new ones
+
+        {
+            PortNameToId portNameToId;
+            portNameToId.setData(kExternalGraphGroupAudioOut, 1, "file_1", "");
+
+            extGraph.audioPorts.outs.append(portNameToId);
+        }
+
+        {
+            PortNameToId portNameToId;
+            portNameToId.setData(kExternalGraphGroupAudioOut, 2, "file_2", "");
+
+            extGraph.audioPorts.outs.append(portNameToId);
+        }
+
+        // ---------------------------------------------------------------
+        // now refresh
+
+        if (sendHost || sendOSC)
+            graph->refresh(sendHost, sendOSC, false, "Render");
+
+        return true;
+    }
+
+    // -------------------------------------------------------------------
+
+protected:
+    void run() override
+    {
+        const uint32_t bufferSize = pData->bufferSize;
+
+        float* audioIns[2] = {
+            (float*)std::malloc(sizeof(float)*bufferSize),
+            (float*)std::malloc(sizeof(float)*bufferSize),
+        };
+        CARLA_SAFE_ASSERT_RETURN(audioIns[0] != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(audioIns[1] != nullptr,);
+
+        float* audioOuts[2] = {
+            (float*)std::malloc(sizeof(float)*bufferSize),
+            (float*)std::malloc(sizeof(float)*bufferSize),
+        };
+        CARLA_SAFE_ASSERT_RETURN(audioOuts[0] != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(audioOuts[1] != nullptr,);
+
+        carla_zeroFloats(audioIns[0], bufferSize);
+        carla_zeroFloats(audioIns[1], bufferSize);
+        carla_zeroStructs(pData->events.in,  kMaxEngineEventInternalCount);
+
+        while (! shouldThreadExit())
+        {
+            CarlaEngineRenderWriter* const writer = fRenderWriter;
+
+            if (writer == nullptr)
+            {
+                // nothing to render, only handle pending plugin actions
+                pData->doNextPluginAction();
+                carla_msleep(5);
+                continue;
+            }
+
+            // run the graph back to back, without pacing
+            for (; fRenderFramesLeft != 0 && ! shouldThreadExit();)
+            {
+                const uint64_t framesLeft = fRenderFramesLeft;
+                const uint32_t frames = framesLeft > bufferSize ? bufferSize : static_cast<uint32_t>(framesLeft);
+
+                {
+                    const PendingRtEventsRunner prt(this, bufferSize, false);
+
+                    carla_zeroFloats(audioOuts[0], bufferSize);
+                    carla_zeroFloats(audioOuts[1], bufferSize);
+                    carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
+
+                    pData->graph.process(pData, audioIns, audioOuts, bufferSize);
+                }
+
+                carla_interleaveFloats(writer->getBlock(), audioOuts, 2, frames);
+
+                writer->commitBlock(frames);
+                fRenderFramesLeft -= frames;
+            }
+
+            fRenderWriter = nullptr;
+            fRenderDone.signal();
+        }
+
+        // do not leave a render request waiting forever
+        if (fRenderWriter != nullptr)
+        {
+            fRenderWriter = nullptr;
+            fRenderDone.signal();
+        }
+
+        std::free(audioIns[0]);
+        std::free(audioIns[1]);
+        std::free(audioOuts[0]);
+        std::free(audioOuts[1]);
+    }
+
+    // -------------------------------------------------------------------
+
+private:
+    bool fRunning;
+
+    // set by renderToFile(), cleared by the render thread when done
+    CarlaEngineRenderWriter* volatile fRenderWriter;
+    volatile uint64_t fRenderFramesLeft;
+    CarlaSignal fRenderDone;
+
+    CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaEngineRender)
+};
+
+// -----------------------------------------
+
+namespace EngineInit {
+
+CarlaEngine* newRender()
+{
+    carla_debug("EngineInit::newRender()");
+    return new CarlaEngineRender();
+}
+
+}
+
+// -----------------------------------------
+
+CARLA_BACKEND_END_NAMESPACE
@@ -18,12 +18,11 @@
 #include "CarlaEngineGraph.hpp"
 #include "CarlaEngineInit.hpp"
 #include "CarlaEngineInternal.hpp"
+#include "CarlaEngineMidiInput.hpp"
 #include "CarlaBackendUtils.hpp"
 #include "CarlaMathUtils.hpp"
 #include "CarlaStringList.hpp"
 
-#include "RtLinkedList.hpp"
-
 #include "jackbridge/JackBridge.hpp"
 
 #if defined(__clang__)
@@ -173,6 +172,446 @@ static RtMidi::Api getMatchedAudioMidiAPI(const RtAudio::Api rtApi) noexcept
     return RtMidi::UNSPECIFIED;
 }
 
+// -------------------------------------------------------------------------------------------------------------------
+// Drift buffer
+
+// smoothing of the fill level, per read
+static const double kDriftFillSmoothing = 1.0 / 64.0;
+
+// speed change for a fill level error the size of the target, and its limit
+static const double kDriftRatioGain      = 0.003;
+static const double kDriftMaxRatioChange = 0.002;
+
+// Multi-channel ring buffer written at the rate of one device and read at the rate of another.
+// The reader interpolates through the written frames, going slightly faster or slower than the writer
+// so that the buffer stays filled to its target size, which is the latency it adds.
+// There must be only one writer and one reader thread.
+class RtAudioDriftBuffer
+{
+public:
+    RtAudioDriftBuffer() noexcept
+        : fBuffers(nullptr),
+          fChannels(0),
+          fMask(0),
+          fTarget(0),
+          fWritten(0),
+          fReleased(~0U),
+          fReaderStarted(false),
+          fReadIndex(0),
+          fReadFrac(0.0),
+          fRatio(1.0),
+          fAvgFill(0.0),
+          fPriming(true) {}
+
+    ~RtAudioDriftBuffer() noexcept
+    {
+        clear();
+    }
+
+    void create(const uint channels, const uint target)
+    {
+        clear();
+
+        if (channels == 0)
+            return;
+
+        const uint32_t size = carla_nextPowerOf2(target * 4);
+
+        fBuffers = new float*[channels];
+
+        for (uint i=0; i < channels; ++i)
+        {
+            fBuffers[i] = new float[size];
+            carla_zeroFloats(fBuffers[i], size);
+        }
+
+        fChannels = channels;
+        fMask     = size - 1;
+        fTarget   = target;
+    }
+
+    void clear() noexcept
+    {
+        if (fBuffers != nullptr)
+        {
+            for (uint i=0; i < fChannels; ++i)
+                delete[] fBuffers[i];
+
+            delete[] fBuffers;
+            fBuffers = nullptr;
+        }
+
+        fChannels = 0;
+        fMask = 0;
+        fTarget = 0;
+        fWritten = 0;
+        // the reader keeps one frame before its position for interpolation
+        fReleased = ~0U;
+        fReaderStarted = false;
+        fReadIndex = 0;
+        fReadFrac = 0.0;
+        fRatio = 1.0;
+        fAvgFill = 0.0;
+        fPriming = true;
+    }
+
+    // writer side, returns false if the frames did not fit and were dropped
+    bool write(const float* const* const buffers, const uint frames) noexcept
+    {
+        if (fChannels == 0)
+            return true;
+
+        const uint32_t size = fMask + 1;
+        const uint32_t written = fWritten;
+        const uint32_t used = written - fReleased;
+
+        // until the other side starts reading, old frames are just left in the buffer
+        if (frames > size - used)
+            return ! fReaderStarted;
+
+        const uint32_t start = written & fMask;
+        const uint32_t first = std::min<uint32_t>(frames, size - start);
+
+        for (uint i=0; i < fChannels; ++i)
+        {
+            carla_copyFloats(fBuffers[i] + start, buffers[i], first);
+
+            if (first < frames)
+                carla_copyFloats(fBuffers[i], buffers[i] + first, frames - first);
+        }
+
+        __sync_synchronize();
+        fWritten = written + frames;
+        return true;
+    }
+
+    // reader side, returns false on underruns, silence is returned while the buffer fills up
+    bool read(float* const* const buffers, const uint frames) noexcept
+    {
+        if (fChannels == 0)
+            return true;
+
+        const uint32_t written = fWritten;
+        __sync_synchronize();
+
+        fReaderStarted = true;
+
+        uint32_t fill = written - fReadIndex;
+
+        if (fPriming)
+        {
+            if (fill < fTarget)
+                return readSilence(buffers, frames, true);
+
+            startAt(written);
+            fill = fTarget;
+        }
+        else if (fill > fTarget * 2 + frames)
+        {
+            // the writer got too far ahead, skip to the newest frames
+            startAt(written);
+            return readSilence(buffers, frames, false);
+        }
+
+        fAvgFill += (static_cast<double>(fill) - fAvgFill) * kDriftFillSmoothing;
+        fRatio = carla_fixedValue(1.0 - kDriftMaxRatioChange, 1.0 + kDriftMaxRatioChange,
+                                  1.0 + (fAvgFill - fTarget) * kDriftRatioGain / fTarget);
+
+        // the last output frame interpolates up to 2 frames past its position
+        const double lastPos = fReadFrac + fRatio * static_cast<double>(frames - 1);
+
+        if (static_cast<uint32_t>(lastPos) + 3 > fill)
+        {
+            fPriming = true;
+            return readSilence(buffers, frames, false);
+        }
+
+        uint32_t index = 0;
+        double frac = 0.0;
+
+        for (uint i=0; i < fChannels; ++i)
+        {
+            const float* const buf = fBuffers[i];
+            float* const out = buffers[i];
+
+            index = fReadIndex;
+            frac  = fReadFrac;
+
+            for (uint j=0; j < frames; ++j)
+            {
+                out[j] = interpolate(buf[(index - 1) & fMask], buf[index & fMask],
+                                     buf[(index + 1) & fMask], buf[(index + 2) & fMask], static_cast<float>(frac));
+
+                frac += fRatio;
+                const uint32_t step = static_cast<uint32_t>(frac);
+                index += step;
+                frac  -= step;
+            }
+        }
+
+        fReadIndex = index;
+        fReadFrac  = frac;
+
+        __sync_synchronize();
+        fReleased = index - 1;
+        return true;
+    }
+
+    // reader side, current speed relative to the writer
+    double getRatio() const noexcept
+    {
+        return fRatio;
+    }
+
+private:
+    float** fBuffers;
+    uint fChannels;
+    uint32_t fMask;
+    uint fTarget;
+
+    // frame counters, wrapping
+    volatile uint32_t fWritten;
+    volatile uint32_t fReleased;
+    volatile bool fReaderStarted;
+
+    // reader state
+    uint32_t fReadIndex;
+    double fReadFrac;
+    double fRatio;
+    double fAvgFill;
+    bool fPriming;
+
+    void startAt(const uint32_t written) noexcept
+    {
+        fReadIndex = written - fTarget;
+        fReadFrac  = 0.0;
+        fAvgFill   = fTarget;
+        fRatio     = 1.0;
+        fPriming   = false;
+
+        __sync_synchronize();
+        fReleased = fReadIndex - 1;
+    }
+
+    bool readSilence(float* const* const buffers, const uint frames, const bool ret) noexcept
+    {
+        for (uint i=0; i < fChannels; ++i)
+            carla_zeroFloats(buffers[i], frames);
+
+        return ret;
+    }
+
+    // cubic hermite between y1 and y2
+    static inline float interpolate(const float y0, const float y1, const float y2, const float y3, const float t) noexcept
+    {
+        const float c1 = 0.5f * (y2 - y0);
+        const float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+        const float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+        return ((c3 * t + c2) * t + c1) * t + y1;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(RtAudioDriftBuffer)
+};
+
+// -------------------------------------------------------------------------------------------------------------------
+// Secondary device
+
+// Another device of the same driver, running on its own clock next to the main device.
+// Its audio goes through drift buffers so the engine can process it as part of the main device cycle.
+class RtAudioSecondaryDevice
+{
+public:
+    RtAudioSecondaryDevice(const RtAudio::Api api)
+        : fAudio(api),
+          fName(),
+          fInCount(0),
+          fOutCount(0),
+          fLatency(0),
+          fXruns(0),
+          fCapture(),
+          fPlayback() {}
+
+    ~RtAudioSecondaryDevice()
+    {
+        close();
+    }
+
+    // can throw RtAudioError
+    bool open(const char* const deviceName, const char* const clientName,
+              const uint sampleRate, const uint bufferSize, const uint numberOfBuffers)
+    {
+        RtAudio::StreamParameters iParams, oParams;
+        bool found = false;
+
+        for (uint i=0, count=fAudio.getDeviceCount(); i < count; ++i)
+        {
+            const RtAudio::DeviceInfo devInfo(fAudio.getDeviceInfo(i));
+
+            if (devInfo.probed && devInfo.name == deviceName)
+            {
+                found = true;
+                iParams.deviceId  = i;
+                oParams.deviceId  = i;
+                iParams.nChannels = carla_fixedValue(0U, 128U, devInfo.inputChannels);
+                oParams.nChannels = carla_fixedValue(0U, 128U, devInfo.outputChannels);
+                break;
+            }
+        }
+
+        if (! found || iParams.nChannels + oParams.nChannels == 0)
+            return false;
+
+        RtAudio::StreamOptions rtOptions;
+        rtOptions.flags = RTAUDIO_MINIMIZE_LATENCY | RTAUDIO_SCHEDULE_REALTIME | RTAUDIO_NONINTERLEAVED;
+        rtOptions.numberOfBuffers = numberOfBuffers;
+        rtOptions.streamName = clientName;
+        rtOptions.priority = 85;
+
+        uint bufferFrames = bufferSize;
+
+        fAudio.openStream(oParams.nChannels > 0 ? &oParams : nullptr,
+                          iParams.nChannels > 0 ? &iParams : nullptr,
+                          RTAUDIO_FLOAT32, sampleRate, &bufferFrames,
+                          carla_rtaudio_secondary_process_callback, this, &rtOptions);
+
+        if (fAudio.getStreamSampleRate() != sampleRate)
+        {
+            fAudio.closeStream();
+            return false;
+        }
+
+        // enough for a block of each device, plus another one of the biggest for scheduling jitter
+        fLatency  = bufferSize + bufferFrames + std::max(bufferSize, bufferFrames);
+        fInCount  = iParams.nChannels;
+        fOutCount = oParams.nChannels;
+        fName     = deviceName;
+
+        fCapture.create(fInCount, fLatency);
+        fPlayback.create(fOutCount, fLatency);
+        return true;
+    }
+
+    void start()
+    {
+        fAudio.startStream();
+    }
+
+    void close()
+    {
+        if (fAudio.isStreamOpen())
+        {
+            if (fAudio.isStreamRunning())
+            {
+                try {
+                    fAudio.stopStream();
+                } CARLA_SAFE_EXCEPTION("RtAudio secondary device stopStream");
+            }
+
+            // capture ratio is the secondary clock over the main one, playback the inverse
+            const double ratio = fInCount > 0 ? fCapture.getRatio() : 1.0 / fPlayback.getRatio();
+            carla_stdout("Secondary audio device \"%s\" clock drift was %.1f ppm", fName.buffer(), (ratio - 1.0) * 1e6);
+
+            fAudio.closeStream();
+        }
+
+        fCapture.clear();
+        fPlayback.clear();
+        fInCount  = 0;
+        fOutCount = 0;
+        fLatency  = 0;
+    }
+
+    const char* getName() const noexcept
+    {
+        return fName.buffer();
+    }
+
+    uint getInputCount() const noexcept
+    {
+        return fInCount;
+    }
+
+    uint getOutputCount() const noexcept
+    {
+        return fOutCount;
+    }
+
+    // frames added to its inputs and outputs, in addition to the device own latency
+    uint getLatency() const noexcept
+    {
+        return fLatency;
+    }
+
+    // engine side, called from the main device audio thread
+
+    void readInputs(float* const* const buffers, const uint frames) noexcept
+    {
+        if (! fCapture.read(buffers, frames))
+            __sync_add_and_fetch(&fXruns, 1);
+    }
+
+    void writeOutputs(const float* const* const buffers, const uint frames) noexcept
+    {
+        if (! fPlayback.write(buffers, frames))
+            __sync_add_and_fetch(&fXruns, 1);
+    }
+
+    uint32_t takeXruns() noexcept
+    {
+        return __sync_fetch_and_and(&fXruns, 0U);
+    }
+
+private:
+    RtAudio fAudio;
+    CarlaString fName;
+    uint fInCount;
+    uint fOutCount;
+    uint fLatency;
+    volatile uint32_t fXruns;
+
+    RtAudioDriftBuffer fCapture;
+    RtAudioDriftBuffer fPlayback;
+
+    void handleAudioProcessCallback(void* const outputBuffer, void* const inputBuffer,
+                                    const uint nframes, const RtAudioStreamStatus status)
+    {
+        if (status & (RTAUDIO_INPUT_OVERFLOW|RTAUDIO_OUTPUT_UNDERFLOW))
+            __sync_add_and_fetch(&fXruns, 1);
+
+        if (fInCount > 0 && inputBuffer != nullptr)
+        {
+            const float* const insPtr = (const float*)inputBuffer;
+            const float* inBuf[fInCount];
+
+            for (uint i=0; i < fInCount; ++i)
+                inBuf[i] = insPtr+(nframes*i);
+
+            if (! fCapture.write(inBuf, nframes))
+                __sync_add_and_fetch(&fXruns, 1);
+        }
+
+        if (fOutCount > 0 && outputBuffer != nullptr)
+        {
+            float* const outsPtr = (float*)outputBuffer;
+            float* outBuf[fOutCount];
+
+            for (uint i=0; i < fOutCount; ++i)
+                outBuf[i] = outsPtr+(nframes*i);
+
+            if (! fPlayback.read(outBuf, nframes))
+                __sync_add_and_fetch(&fXruns, 1);
+        }
+    }
+
+    static int carla_rtaudio_secondary_process_callback(void* outputBuffer, void* inputBuffer, uint nframes, double, RtAudioStreamStatus status, void* userData)
+    {
+        ((RtAudioSecondaryDevice*)userData)->handleAudioProcessCallback(outputBuffer, inputBuffer, nframes, status);
+        return 0;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(RtAudioSecondaryDevice)
+};
+
 // -------------------------------------------------------------------------------------------------------------------
 // RtAudio Engine
 
@@ -185,12 +624,15 @@ public:
           fAudioInterleaved(false),
           fAudioInCount(0),
           fAudioOutCount(0),
-          fLastEventTime(0),
           fDeviceName(),
           fAudioIntBufIn(nullptr),
           fAudioIntBufOut(nullptr),
+          fSecondary(nullptr),
+          fSecondaryBufIn(nullptr),
+          fSecondaryBufOut(nullptr),
           fMidiIns(),
-          fMidiInEvents(),
+          fMidiInMutex(),
+          fMidiInClock(),
           fMidiOuts(),
           fMidiOutMutex(),
           fMidiOutVector(EngineMidiEvent::kDataSize)
@@ -205,7 +647,6 @@ public:
     {
         CARLA_SAFE_ASSERT(fAudioInCount == 0);
         CARLA_SAFE_ASSERT(fAudioOutCount == 0);
-        CARLA_SAFE_ASSERT(fLastEventTime == 0);
         carla_debug("CarlaEngineRtAudio::~CarlaEngineRtAudio()");
     }
 
@@ -215,7 +656,6 @@ public:
     {
         CARLA_SAFE_ASSERT_RETURN(fAudioInCount == 0, false);
         CARLA_SAFE_ASSERT_RETURN(fAudioOutCount == 0, false);
-        CARLA_SAFE_ASSERT_RETURN(fLastEventTime == 0, false);
         CARLA_SAFE_ASSERT_RETURN(clientName != nullptr && clientName[0] != '\0', false);
         carla_debug("CarlaEngineRtAudio::init(\"%s\")", clientName);
 
@@ -325,9 +765,43 @@ public:
         pData->sampleRate = isDummy ? 44100.0 : fAudio.getStreamSampleRate();
         pData->initTime(pData->options.transportExtra);
 
+        if (pData->options.audioSecondaryDevice != nullptr && pData->options.audioSecondaryDevice[0] != '\0')
+        {
+            if (isDummy || fAudioInterleaved || fAudio.getCurrentApi() == RtAudio::UNIX_JACK)
+            {
+                carla_stderr2("Secondary audio devices are not supported by the %s driver, ignored", getCurrentDriverName());
+            }
+            else
+            {
+                fSecondary = new RtAudioSecondaryDevice(fAudio.getCurrentApi());
+
+                bool opened = false;
+
+                try {
+                    opened = fSecondary->open(pData->options.audioSecondaryDevice, clientName,
+                                              static_cast<uint>(pData->sampleRate), bufferFrames,
+                                              rtOptions.numberOfBuffers);
+                }
+                catch (const RtAudioError& e) {
+                    carla_stderr2("Failed to open secondary audio device: %s", e.what());
+                }
+
+                if (! opened)
+                {
+                    close();
+                    setLastError("Failed to open the secondary audio device with the same sample rate");
+                    return false;
+                }
+
+                carla_stdout("Using secondary audio device \"%s\" with %u inputs and %u outputs, %u frames (%.1f ms) of added latency",
+                             fSecondary->getName(), fSecondary->getInputCount(), fSecondary->getOutputCount(),
+                             fSecondary->getLatency(), fSecondary->getLatency() * 1000.0 / pData->sampleRate);
+            }
+        }
+
         fAudioInCount  = iParams.nChannels;
         fAudioOutCount = oParams.nChannels;
-        fLastEventTime = 0;
+        fMidiInClock.reset();
 
         if (fAudioInCount > 0)
             fAudioIntBufIn = new float[fAudioInCount*bufferFrames];
@@ -335,10 +809,22 @@ public:
         if (fAudioOutCount > 0)
             fAudioIntBufOut = new float[fAudioOutCount*bufferFrames];
 
-        pData->graph.create(fAudioInCount, fAudioOutCount, 0, 0);
+        if (fSecondary != nullptr)
+        {
+            if (const uint secondaryInCount = fSecondary->getInputCount())
+                fSecondaryBufIn = new float[secondaryInCount*bufferFrames];
+
+            if (const uint secondaryOutCount = fSecondary->getOutputCount())
+                fSecondaryBufOut = new float[secondaryOutCount*bufferFrames];
+        }
+
+        pData->graph.create(getTotalAudioInCount(), getTotalAudioOutCount(), 0, 0);
 
         try {
             fAudio.startStream();
+
+            if (fSecondary != nullptr)
+                fSecondary->start();
         }
         catch (const RtAudioError& e)
         {
@@ -382,14 +868,23 @@ public:
             }
         }
 
+        // secondary device follows the main one
+        if (fSecondary != nullptr)
+        {
+            delete fSecondary;
+            fSecondary = nullptr;
+        }
+
         // clear engine data
         CarlaEngine::close();
 
         pData->graph.destroy();
 
+        fMidiInMutex.lock();
+
         for (LinkedList<MidiInPort>::Itenerator it = fMidiIns.begin2(); it.valid(); it.next())
         {
-            static MidiInPort fallback = { nullptr, { '\0' } };
+            static MidiInPort fallback = { nullptr, nullptr, { '\0' } };
 
             MidiInPort& inPort(it.getValue(fallback));
             CARLA_SAFE_ASSERT_CONTINUE(inPort.port != nullptr);
@@ -397,10 +892,11 @@ public:
             inPort.port->cancelCallback();
             inPort.port->closePort();
             delete inPort.port;
+            delete inPort.queue;
         }
 
         fMidiIns.clear();
-        fMidiInEvents.clear();
+        fMidiInMutex.unlock();
 
         fMidiOutMutex.lock();
 
@@ -420,7 +916,6 @@ public:
 
         fAudioInCount  = 0;
         fAudioOutCount = 0;
-        fLastEventTime = 0;
         fDeviceName.clear();
 
         if (fAudioIntBufIn != nullptr)
@@ -435,6 +930,18 @@ public:
             fAudioIntBufOut = nullptr;
         }
 
+        if (fSecondaryBufIn != nullptr)
+        {
+            delete[] fSecondaryBufIn;
+            fSecondaryBufIn = nullptr;
+        }
+
+        if (fSecondaryBufOut != nullptr)
+        {
+            delete[] fSecondaryBufOut;
+            fSecondaryBufOut = nullptr;
+        }
+
         // close stream
         if (fAudio.isStreamOpen())
             fAudio.closeStream();
@@ -483,8 +990,8 @@ public:
         // ---------------------------------------------------------------
         // fill in new ones
 
-        // Audio In
-        for (uint i=0; i < fAudioInCount; ++i)
+        // Audio In, secondary device channels come after the main device ones
+        for (uint i=0, count=getTotalAudioInCount(); i < count; ++i)
         {
             std::snprintf(strBuf, STR_MAX, "capture_%i", i+1);
 
@@ -495,7 +1002,7 @@ public:
         }
 
         // Audio Out
-        for (uint i=0; i < fAudioOutCount; ++i)
+        for (uint i=0, count=getTotalAudioOutCount(); i < count; ++i)
         {
             std::snprintf(strBuf, STR_MAX, "playback_%i", i+1);
 
@@ -544,7 +1051,7 @@ public:
 
         for (LinkedList<MidiInPort>::Itenerator it=fMidiIns.begin2(); it.valid(); it.next())
         {
-            static const MidiInPort fallback = { nullptr, { '\0' } };
+            static const MidiInPort fallback = { nullptr, nullptr, { '\0' } };
 
             const MidiInPort& inPort(it.getValue(fallback));
             CARLA_SAFE_ASSERT_CONTINUE(inPort.port != nullptr);
@@ -636,26 +1143,24 @@ protected:
         CARLA_SAFE_ASSERT_RETURN(outputBuffer != nullptr,);
 
         // set rtaudio buffers as non-interleaved
-        const float* inBuf[fAudioInCount];
-        /* */ float* outBuf[fAudioOutCount];
+        const float* inBuf[getTotalAudioInCount()];
+        /* */ float* outBuf[getTotalAudioOutCount()];
 
         if (fAudioInterleaved)
         {
-            // FIXME - this looks completely wrong!
-            float* inBuf2[fAudioInCount];
+            float* inBufTmp[fAudioInCount];
 
             for (uint i=0, count=fAudioInCount; i<count; ++i)
             {
-                inBuf [i] = fAudioIntBufIn + (nframes*i);
-                inBuf2[i] = fAudioIntBufIn + (nframes*i);
+                inBuf   [i] = fAudioIntBufIn + (nframes*i);
+                inBufTmp[i] = fAudioIntBufIn + (nframes*i);
             }
             for (uint i=0, count=fAudioOutCount; i<count; ++i)
                 outBuf[i] = fAudioIntBufOut + (nframes*i);
 
             // init input
-            for (uint i=0; i<nframes; ++i)
-                for (uint j=0; j<fAudioInCount; ++j)
-                    inBuf2[j][i] = insPtr[i*fAudioInCount+j];
+            if (fAudioInCount > 0 && insPtr != nullptr)
+                carla_deinterleaveFloats(inBufTmp, insPtr, fAudioInCount, nframes);
 
             // clear output
             carla_zeroFloats(fAudioIntBufOut, fAudioOutCount*nframes);
@@ -671,44 +1176,60 @@ protected:
             carla_zeroFloats(outsPtr, nframes*fAudioOutCount);
         }
 
+        if (fSecondary != nullptr)
+        {
+            const uint secondaryInCount  = fSecondary->getInputCount();
+            const uint secondaryOutCount = fSecondary->getOutputCount();
+
+            if (secondaryInCount > 0)
+            {
+                float* secondaryInBuf[secondaryInCount];
+
+                for (uint i=0; i < secondaryInCount; ++i)
+                {
+                    secondaryInBuf[i] = fSecondaryBufIn + (nframes*i);
+                    inBuf[fAudioInCount+i] = secondaryInBuf[i];
+                }
+
+                fSecondary->readInputs(secondaryInBuf, nframes);
+            }
+
+            for (uint i=0; i < secondaryOutCount; ++i)
+                outBuf[fAudioOutCount+i] = fSecondaryBufOut + (nframes*i);
+
+            if (secondaryOutCount > 0)
+                carla_zeroFloats(fSecondaryBufOut, nframes*secondaryOutCount);
+
+            pData->xruns += fSecondary->takeXruns();
+        }
+
         // initialize events
         carla_zeroStructs(pData->events.in,  kMaxEngineEventInternalCount);
         carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
 
-        if (fMidiInEvents.mutex.tryLock())
-        {
-            uint32_t engineEventIndex = 0;
-            fMidiInEvents.splice();
+        fMidiInClock.cycle(nframes, pData->sampleRate);
 
-            for (LinkedList<RtMidiEvent>::Itenerator it = fMidiInEvents.data.begin2(); it.valid(); it.next())
+        if (fMidiInMutex.tryLock())
+        {
+            if (const std::size_t numQueues = fMidiIns.count())
             {
-                static const RtMidiEvent fallback = { 0, 0, { 0 } };
+                EngineMidiInputQueue* queues[numQueues];
+                uint i = 0;
 
-                const RtMidiEvent& midiEvent(it.getValue(fallback));
-                CARLA_SAFE_ASSERT_CONTINUE(midiEvent.size > 0);
+                for (LinkedList<MidiInPort>::Itenerator it = fMidiIns.begin2(); it.valid(); it.next())
+                {
+                    static const MidiInPort fallback = { nullptr, nullptr, { '\0' } };
 
-                EngineEvent& engineEvent(pData->events.in[engineEventIndex++]);
+                    const MidiInPort& inPort(it.getValue(fallback));
+                    CARLA_SAFE_ASSERT_CONTINUE(inPort.queue != nullptr);
 
-                if (midiEvent.time < pData->timeInfo.frame)
-                {
-                    engineEvent.time = 0;
+                    queues[i++] = inPort.queue;
                 }
-                else if (midiEvent.time >= pData->timeInfo.frame + nframes)
-                {
-                    carla_stderr("MIDI Event in the future!, %i vs %i", engineEvent.time, pData->timeInfo.frame);
-                    engineEvent.time = static_cast<uint32_t>(pData->timeInfo.frame) + nframes - 1;
-                }
-                else
-                    engineEvent.time = static_cast<uint32_t>(midiEvent.time - pData->timeInfo.frame);
-
-                engineEvent.fillFromMidiData(midiEvent.size, midiEvent.data, 0);
 
-                if (engineEventIndex >= kMaxEngineEventInternalCount)
-                    break;
+                fMidiInClock.fillEngineEvents(queues, i, pData->events.in, kMaxEngineEventInternalCount);
             }
 
-            fMidiInEvents.data.clear();
-            fMidiInEvents.mutex.unlock();
+            fMidiInMutex.unlock();
         }
 
         pData->graph.process(pData, inBuf, outBuf, nframes);
@@ -785,12 +1306,11 @@ protected:
 
         fMidiOutMutex.unlock();
 
-        if (fAudioInterleaved)
-        {
-            for (uint i=0; i < nframes; ++i)
-                for (uint j=0; j<fAudioOutCount; ++j)
-                    outsPtr[i*fAudioOutCount+j] = outBuf[j][i];
-        }
+        if (fAudioInterleaved && fAudioOutCount > 0)
+            carla_interleaveFloats(outsPtr, outBuf, fAudioOutCount, nframes);
+
+        if (fSecondary != nullptr && fSecondary->getOutputCount() > 0)
+            fSecondary->writeOutputs(outBuf + fAudioOutCount, nframes);
 
         return; // unused
         (void)streamTime;
@@ -818,39 +1338,6 @@ protected:
         bufferSizeChanged(newBufferSize);
     }
 
-    void handleMidiCallback(double timeStamp, std::vector<uchar>* const message)
-    {
-        const size_t messageSize(message->size());
-
-        if (messageSize == 0 || messageSize > EngineMidiEvent::kDataSize)
-            return;
-
-        timeStamp /= 2;
-
-        if (timeStamp > 0.95)
-            timeStamp = 0.95;
-        else if (timeStamp < 0.0)
-            timeStamp = 0.0;
-
-        RtMidiEvent midiEvent;
-        midiEvent.time = pData->timeInfo.frame + uint64_t(timeStamp * (double)pData->bufferSize);
-
-        if (midiEvent.time < fLastEventTime)
-            midiEvent.time = fLastEventTime;
-        else
-            fLastEventTime = midiEvent.time;
-
-        midiEvent.size = static_cast<uint8_t>(messageSize);
-
-        size_t i=0;
-        for (; i < messageSize; ++i)
-            midiEvent.data[i] = message->at(i);
-        for (; i < EngineMidiEvent::kDataSize; ++i)
-            midiEvent.data[i] = 0;
-
-        fMidiInEvents.append(midiEvent);
-    }
-
     // -------------------------------------------------------------------
 
     bool connectExternalGraphPort(const uint connectionType, const uint portId, const char* const portName) override
@@ -878,8 +1365,10 @@ protected:
                 rtMidiIn = new RtMidiIn(getMatchedAudioMidiAPI(fAudio.getCurrentApi()), newRtMidiPortName.buffer(), 512);
             } CARLA_SAFE_EXCEPTION_RETURN("new RtMidiIn", false);
 
+            EngineMidiInputQueue* const queue(new EngineMidiInputQueue());
+
             rtMidiIn->ignoreTypes();
-            rtMidiIn->setCallback(carla_rtmidi_callback, this);
+            rtMidiIn->setCallback(carla_rtmidi_callback, queue);
 
             bool found = false;
             uint rtMidiPortIndex;
@@ -897,6 +1386,7 @@ protected:
             if (! found)
             {
                 delete rtMidiIn;
+                delete queue;
                 return false;
             }
 
@@ -905,15 +1395,19 @@ protected:
             }
             catch(...) {
                 delete rtMidiIn;
+                delete queue;
                 return false;
             };
 
             MidiInPort midiPort;
-            midiPort.port = rtMidiIn;
+            midiPort.port  = rtMidiIn;
+            midiPort.queue = queue;
 
             std::strncpy(midiPort.name, portName, STR_MAX);
             midiPort.name[STR_MAX] = '\0';
 
+            const CarlaMutexLocker cml(fMidiInMutex);
+
             fMidiIns.append(midiPort);
             return true;
         }   break;
@@ -989,7 +1483,7 @@ protected:
         case kExternalGraphConnectionMidiInput:
             for (LinkedList<MidiInPort>::Itenerator it=fMidiIns.begin2(); it.valid(); it.next())
             {
-                static MidiInPort fallback = { nullptr, { '\0' } };
+                static MidiInPort fallback = { nullptr, nullptr, { '\0' } };
 
                 MidiInPort& inPort(it.getValue(fallback));
                 CARLA_SAFE_ASSERT_CONTINUE(inPort.port != nullptr);
@@ -1001,7 +1495,14 @@ protected:
                 inPort.port->closePort();
                 delete inPort.port;
 
-                fMidiIns.remove(it);
+                EngineMidiInputQueue* const queue(inPort.queue);
+
+                {
+                    const CarlaMutexLocker cml(fMidiInMutex);
+                    fMidiIns.remove(it);
+                }
+
+                delete queue;
                 return true;
             }
             break;
@@ -1040,7 +1541,6 @@ private:
     bool fAudioInterleaved;
     uint fAudioInCount;
     uint fAudioOutCount;
-    uint64_t fLastEventTime;
 
     // current device name
     CarlaString fDeviceName;
@@ -1049,8 +1549,24 @@ private:
     float* fAudioIntBufIn;
     float* fAudioIntBufOut;
 
+    // optional secondary device, and engine side buffers for its channels
+    RtAudioSecondaryDevice* fSecondary;
+    float* fSecondaryBufIn;
+    float* fSecondaryBufOut;
+
+    uint getTotalAudioInCount() const noexcept
+    {
+        return fAudioInCount + (fSecondary != nullptr ? fSecondary->getInputCount() : 0);
+    }
+
+    uint getTotalAudioOutCount() const noexcept
+    {
+        return fAudioOutCount + (fSecondary != nullptr ? fSecondary->getOutputCount() : 0);
+    }
+
     struct MidiInPort {
         RtMidiIn* port;
+        EngineMidiInputQueue* queue;
         char name[STR_MAX+1];
     };
 
@@ -1059,53 +1575,9 @@ private:
         char name[STR_MAX+1];
     };
 
-    struct RtMidiEvent {
-        uint64_t time; // needs to compare to internal time
-        uint8_t  size;
-        uint8_t  data[EngineMidiEvent::kDataSize];
-    };
-
-    struct RtMidiEvents {
-        CarlaMutex mutex;
-        RtLinkedList<RtMidiEvent>::Pool dataPool;
-        RtLinkedList<RtMidiEvent> data;
-        RtLinkedList<RtMidiEvent> dataPending;
-
-        RtMidiEvents()
-            : mutex(),
-              dataPool(512, 512),
-              data(dataPool),
-              dataPending(dataPool) {}
-
-        ~RtMidiEvents()
-        {
-            clear();
-        }
-
-        void append(const RtMidiEvent& event)
-        {
-            mutex.lock();
-            dataPending.append(event);
-            mutex.unlock();
-        }
-
-        void clear()
-        {
-            mutex.lock();
-            data.clear();
-            dataPending.clear();
-            mutex.unlock();
-        }
-
-        void splice()
-        {
-            if (dataPending.count() > 0)
-                dataPending.moveTo(data, true /* append */);
-        }
-    };
-
     LinkedList<MidiInPort> fMidiIns;
-    RtMidiEvents           fMidiInEvents;
+    CarlaMutex             fMidiInMutex;
+    EngineMidiInputClock   fMidiInClock;
 
     LinkedList<MidiOutPort> fMidiOuts;
     CarlaMutex              fMidiOutMutex;
@@ -1125,12 +1597,14 @@ private:
         return true;
     }
 
+    #undef handlePtr
+
     static void carla_rtmidi_callback(double timeStamp, std::vector<uchar>* message, void* userData)
     {
-        handlePtr->handleMidiCallback(timeStamp, message);
-    }
+        EngineMidiInputQueue* const queue((EngineMidiInputQueue*)userData);
 
-    #undef handlePtr
+        queue->put(message->data(), message->size(), timeStamp);
+    }
 
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaEngineRtAudio)
 };
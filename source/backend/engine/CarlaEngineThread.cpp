@@ -18,6 +18,7 @@
 #include "CarlaEngineThread.hpp"
 #include "CarlaEngineInternal.hpp"
 #include "CarlaPlugin.hpp"
+#include "CarlaRtLog.hpp"
 
 #include "water/misc/Time.h"
 
@@ -27,7 +28,8 @@ CARLA_BACKEND_START_NAMESPACE
 
 CarlaEngineThread::CarlaEngineThread(CarlaEngine* const engine) noexcept
     : CarlaThread("CarlaEngineThread"),
-      kEngine(engine)
+      kEngine(engine),
+      fWakeUpSignal()
 {
     CARLA_SAFE_ASSERT(engine != nullptr);
     carla_debug("CarlaEngineThread::CarlaEngineThread(%p)", engine);
@@ -38,6 +40,11 @@ CarlaEngineThread::~CarlaEngineThread() noexcept
     carla_debug("CarlaEngineThread::~CarlaEngineThread()");
 }
 
+void CarlaEngineThread::wakeUp() noexcept
+{
+    fWakeUpSignal.signal();
+}
+
 // -----------------------------------------------------------------------
 
 void CarlaEngineThread::run() noexcept
@@ -49,10 +56,11 @@ void CarlaEngineThread::run() noexcept
     const bool kIsAlwaysRunning = kEngine->getType() == kEngineTypeBridge || kIsPlugin;
 
     float value;
+    uint32_t lastPeaksCheckTime = water::Time::getMillisecondCounter();
 
 #if defined(HAVE_LIBLO) && ! defined(BUILD_BRIDGE)
     // int64_t lastPingTime = 0;
-    const CarlaEngineOsc& engineOsc(kEngine->pData->osc);
+    CarlaEngineOsc& engineOsc(kEngine->pData->osc);
 #endif
 
     // thread must do something...
@@ -60,12 +68,6 @@ void CarlaEngineThread::run() noexcept
 
     for (; (kIsAlwaysRunning || kEngine->isRunning()) && ! shouldThreadExit();)
     {
-#if defined(HAVE_LIBLO) && ! defined(BUILD_BRIDGE)
-        const bool oscRegistedForUDP = engineOsc.isControlRegisteredForUDP();
-#else
-        const bool oscRegistedForUDP = false;
-#endif
-
 #if defined(HAVE_LIBLO) && !defined(BUILD_BRIDGE)
         if (kIsPlugin)
             engineOsc.idle();
@@ -91,7 +93,7 @@ void CarlaEngineThread::run() noexcept
             // -----------------------------------------------------------
             // Post-poned events
 
-            if (oscRegistedForUDP || updateUI)
+            if (updateUI)
             {
                 // -------------------------------------------------------
                 // Update parameter outputs
@@ -103,36 +105,22 @@ void CarlaEngineThread::run() noexcept
 
                     value = plugin->getParameterValue(j);
 
-#if defined(HAVE_LIBLO) && ! defined(BUILD_BRIDGE)
-                    // Update OSC engine client
-                    if (oscRegistedForUDP)
-                        engineOsc.sendParameterValue(i, j, value);
-#endif
                     // Update UI
-                    if (updateUI)
-                        plugin->uiParameterChange(j, value);
+                    plugin->uiParameterChange(j, value);
                 }
 
-                if (updateUI)
-                {
-                    try {
-                        plugin->uiIdle();
-                    } CARLA_SAFE_EXCEPTION("uiIdle()")
-                }
+                try {
+                    plugin->uiIdle();
+                } CARLA_SAFE_EXCEPTION("uiIdle()")
             }
-
-#if defined(HAVE_LIBLO) && ! defined(BUILD_BRIDGE)
-            // -----------------------------------------------------------
-            // Update OSC control client peaks
-
-            if (oscRegistedForUDP)
-                engineOsc.sendPeaks(i, kEngine->getPeaks(i));
-#endif
         }
 
 #if defined(HAVE_LIBLO) && !defined(BUILD_BRIDGE)
-        if (oscRegistedForUDP)
-            engineOsc.sendRuntimeInfo();
+        // ---------------------------------------------------------------
+        // Update OSC clients, output parameters and peaks are only sent if changed
+
+        if (engineOsc.isControlRegisteredForUDP())
+            engineOsc.sendRuntimeUpdates();
 
         /*
         if (engineOsc.isControlRegisteredForTCP())
@@ -148,7 +136,38 @@ void CarlaEngineThread::run() noexcept
         */
 #endif
 
-        carla_msleep(25);
+        // ---------------------------------------------------------------
+        // Stop computing peaks that were not read during the last second
+
+        const uint32_t timeNow = water::Time::getMillisecondCounter();
+
+        if (timeNow - lastPeaksCheckTime >= 1000)
+        {
+            lastPeaksCheckTime = timeNow;
+
+            for (uint i=0, count = kEngine->getCurrentPluginCount(); i < count; ++i)
+            {
+                EnginePluginData& pluginData(kEngine->pData->plugins[i]);
+
+                if (pluginData.peaksWatched)
+                {
+                    pluginData.peaksWatched = false;
+                }
+                else if (pluginData.peaksEnabled)
+                {
+                    pluginData.peaksEnabled = false;
+                    carla_zeroFloats(pluginData.peaks, 4);
+                }
+            }
+        }
+
+        // ---------------------------------------------------------------
+        // Print messages queued by the audio thread
+
+        CarlaRtLog::getInstance().flush();
+
+        // plugins can wake us up early, see CarlaEngine::requestIdle()
+        fWakeUpSignal.wait(25);
     }
 
     carla_debug("CarlaEngineThread closed");
@@ -34,11 +34,18 @@ public:
     CarlaEngineThread(CarlaEngine* engine) noexcept;
     ~CarlaEngineThread() noexcept override;
 
+    /*
+     * Run the next idle cycle now, instead of waiting for the regular interval.
+     * Can be called from any thread.
+     */
+    void wakeUp() noexcept;
+
 protected:
     void run() noexcept override;
 
 private:
     CarlaEngine* const kEngine;
+    CarlaSignal fWakeUpSignal;
 
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaEngineThread)
 };
@@ -27,6 +27,8 @@
 #include "CarlaStringList.hpp"
 
 #include <ctime>
+#include <string>
+#include <unordered_map>
 
 #include "water/files/File.h"
 #include "water/streams/MemoryOutputStream.h"
@@ -54,31 +56,6 @@ static const CustomData        kCustomDataFallback        = { nullptr, nullptr,
 static /* */ CustomData        kCustomDataFallbackNC      = { nullptr, nullptr, nullptr };
 static const PluginPostRtEvent kPluginPostRtEventFallback = { kPluginPostRtEventNull, false, 0, 0, 0, 0.0f };
 
-// -------------------------------------------------------------------------------------------------------------------
-// ParamSymbol struct, needed for CarlaPlugin::loadStateSave()
-
-struct ParamSymbol {
-    int32_t index;
-    const char* symbol;
-
-    ParamSymbol(const uint32_t i, const char* const s)
-        : index(static_cast<int32_t>(i)),
-          symbol(carla_strdup(s)) {}
-
-    ~ParamSymbol() noexcept
-    {
-        CARLA_SAFE_ASSERT_RETURN(symbol != nullptr,)
-
-        delete[] symbol;
-        symbol = nullptr;
-    }
-
-#ifdef CARLA_PROPER_CPP11_SUPPORT
-    ParamSymbol() = delete;
-    CARLA_DECLARE_NON_COPY_STRUCT(ParamSymbol)
-#endif
-};
-
 // -------------------------------------------------------------------------------------------------------------------
 // Constructor and destructor
 
@@ -140,6 +117,11 @@ bool CarlaPlugin::isEnabled() const noexcept
     return pData->enabled;
 }
 
+bool CarlaPlugin::isDormant() const noexcept
+{
+    return false;
+}
+
 const char* CarlaPlugin::getName() const noexcept
 {
     return pData->name;
@@ -170,6 +152,24 @@ uint32_t CarlaPlugin::getLatencyInFrames() const noexcept
     return 0;
 }
 
+uint32_t CarlaPlugin::getBufferSize() const noexcept
+{
+    const uint32_t engineBufferSize = pData->engine->getBufferSize();
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    if ((pData->options & PLUGIN_OPTION_DECOUPLED_BLOCKS) != 0 &&
+        pData->engine->getProccessMode() == ENGINE_PROCESS_MODE_PATCHBAY)
+    {
+        const uint32_t decoupledBufferSize = pData->engine->getOptions().patchbayDecoupledBufferSize;
+
+        if (decoupledBufferSize > engineBufferSize)
+            return decoupledBufferSize;
+    }
+#endif
+
+    return engineBufferSize;
+}
+
 // -------------------------------------------------------------------
 // Information (count)
 
@@ -508,6 +508,10 @@ void CarlaPlugin::randomizeParameters() noexcept
 
 const CarlaStateSave& CarlaPlugin::getStateSave(const bool callPrepareForSave)
 {
+    // dormant plugins only have the state they were loaded with
+    if (isDormant())
+        return pData->stateSave;
+
     pData->stateSave.clear();
 
     if (callPrepareForSave)
@@ -566,7 +570,9 @@ const CarlaStateSave& CarlaPlugin::getStateSave(const bool callPrepareForSave)
 
         if (data != nullptr && dataSize > 0)
         {
-            pData->stateSave.chunk = CarlaString::asBase64(data, dataSize).dup();
+            // kept raw, only encoded as base64 if it ends up inside the project file
+            const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+            pData->stateSave.chunkData.assign(bytes, bytes + dataSize);
 
             if (pluginType != PLUGIN_INTERNAL)
                 usingChunk = true;
@@ -744,24 +750,24 @@ void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave)
     // ---------------------------------------------------------------
     // Part 4a - get plugin parameter symbols
 
-    LinkedList<ParamSymbol*> paramSymbols;
+    std::unordered_map<std::string, int32_t> paramSymbols;
 
     if (pluginType == PLUGIN_LADSPA || pluginType == PLUGIN_LV2)
     {
+        paramSymbols.reserve(pData->param.count);
+
         for (uint32_t i=0; i < pData->param.count; ++i)
         {
             if (getParameterSymbol(i, strBuf))
-            {
-                ParamSymbol* const paramSymbol(new ParamSymbol(i, strBuf));
-                paramSymbols.append(paramSymbol);
-            }
+                paramSymbols.emplace(strBuf, static_cast<int32_t>(i));
         }
     }
 
     // ---------------------------------------------------------------
-    // Part 4b - set parameter values (carefully)
+    // Part 4b - set parameter values (carefully), listeners are notified once afterwards
 
     const float sampleRate(static_cast<float>(pData->engine->getSampleRate()));
+    bool parametersChanged = false;
 
     for (CarlaStateSave::ParameterItenerator it = stateSave.parameters.begin2(); it.valid(); it.next())
     {
@@ -775,18 +781,11 @@ void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave)
             // Try to set by symbol, otherwise use index
             if (stateParameter->symbol != nullptr && stateParameter->symbol[0] != '\0')
             {
-                for (LinkedList<ParamSymbol*>::Itenerator it2 = paramSymbols.begin2(); it2.valid(); it2.next())
-                {
-                    ParamSymbol* const paramSymbol(it2.getValue(nullptr));
-                    CARLA_SAFE_ASSERT_CONTINUE(paramSymbol != nullptr);
-                    CARLA_SAFE_ASSERT_CONTINUE(paramSymbol->symbol != nullptr);
-
-                    if (std::strcmp(stateParameter->symbol, paramSymbol->symbol) == 0)
-                    {
-                        index = paramSymbol->index;
-                        break;
-                    }
-                }
+                const std::unordered_map<std::string, int32_t>::const_iterator it2 = paramSymbols.find(stateParameter->symbol);
+
+                if (it2 != paramSymbols.end())
+                    index = it2->second;
+
                 if (index == -1)
                     index = stateParameter->index;
             }
@@ -800,25 +799,19 @@ void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave)
             // Symbol only
             if (stateParameter->symbol != nullptr && stateParameter->symbol[0] != '\0')
             {
-                for (LinkedList<ParamSymbol*>::Itenerator it2 = paramSymbols.begin2(); it2.valid(); it2.next())
-                {
-                    ParamSymbol* const paramSymbol(it2.getValue(nullptr));
-                    CARLA_SAFE_ASSERT_CONTINUE(paramSymbol != nullptr);
-                    CARLA_SAFE_ASSERT_CONTINUE(paramSymbol->symbol != nullptr);
-
-                    if (std::strcmp(stateParameter->symbol, paramSymbol->symbol) == 0)
-                    {
-                        index = paramSymbol->index;
-                        break;
-                    }
-                }
+                const std::unordered_map<std::string, int32_t>::const_iterator it2 = paramSymbols.find(stateParameter->symbol);
+
+                if (it2 != paramSymbols.end())
+                    index = it2->second;
+
                 if (index == -1)
                     carla_stderr("Failed to find LV2 parameter symbol '%s' for '%s'",
                                  stateParameter->symbol, pData->name);
             }
             else
             {
-                carla_stderr("LV2 Plugin parameter '%s' has no symbol", stateParameter->name);
+                carla_stderr("LV2 Plugin parameter #%i '%s' has no symbol",
+                             stateParameter->index, stateParameter->name != nullptr ? stateParameter->name : "");
             }
         }
         else
@@ -837,7 +830,8 @@ void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave)
                 if (pData->param.data[index].hints & PARAMETER_USES_SAMPLERATE)
                     stateParameter->value *= sampleRate;
 
-                setParameterValue(static_cast<uint32_t>(index), stateParameter->value, true, true, true);
+                setParameterValue(static_cast<uint32_t>(index), stateParameter->value, true, false, false);
+                parametersChanged = true;
             }
 
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
@@ -860,20 +854,12 @@ void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave)
 #endif
         }
         else
-            carla_stderr("Could not set parameter '%s' value for '%s'",
-                         stateParameter->name, pData->name);
+            carla_stderr("Could not set parameter #%i '%s' value for '%s'", stateParameter->index,
+                         stateParameter->name != nullptr ? stateParameter->name : "", pData->name);
     }
 
-    // ---------------------------------------------------------------
-    // Part 4c - clear
-
-    for (LinkedList<ParamSymbol*>::Itenerator it = paramSymbols.begin2(); it.valid(); it.next())
-    {
-        ParamSymbol* const paramSymbol(it.getValue(nullptr));
-        delete paramSymbol;
-    }
-
-    paramSymbols.clear();
+    if (parametersChanged)
+        pData->engine->callback(true, true, ENGINE_CALLBACK_RELOAD_PARAMETERS, pData->id, -1, 0, 0, 0.0f, nullptr);
 
     // ---------------------------------------------------------------
     // Part 5 - set custom data
@@ -917,7 +903,15 @@ void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave)
     // ---------------------------------------------------------------
     // Part 6 - set chunk
 
-    if (stateSave.chunk != nullptr && (pData->options & PLUGIN_OPTION_USE_CHUNKS) != 0)
+    if (! stateSave.chunkData.empty() && (pData->options & PLUGIN_OPTION_USE_CHUNKS) != 0)
+    {
+#ifdef CARLA_PROPER_CPP11_SUPPORT
+        setChunkData(stateSave.chunkData.data(), stateSave.chunkData.size());
+#else
+        setChunkData(&stateSave.chunkData.front(), stateSave.chunkData.size());
+#endif
+    }
+    else if (stateSave.chunk != nullptr && (pData->options & PLUGIN_OPTION_USE_CHUNKS) != 0)
     {
         std::vector<uint8_t> chunk(carla_getChunkFromBase64String(stateSave.chunk));
 #ifdef CARLA_PROPER_CPP11_SUPPORT
@@ -954,13 +948,21 @@ void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave)
 #endif
 }
 
+void CarlaPlugin::dumpStateSave(MemoryOutputStream& stream, const File* const chunkFile)
+{
+    if (prepareStateDump(chunkFile))
+        encodeStateDump();
+
+    finishStateDump(stream);
+}
+
 bool CarlaPlugin::saveStateToFile(const char* const filename)
 {
     CARLA_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', false);
     carla_debug("CarlaPlugin::saveStateToFile(\"%s\")", filename);
 
     MemoryOutputStream out, streamState;
-    getStateSave().dumpToMemoryStream(streamState);
+    getStateSave().dumpToMemoryStream(streamState, nullptr, pData->engine->getOptions().compactParameterState);
 
     out << "<?xml version='1.0' encoding='UTF-8'?>\n";
     out << "<!DOCTYPE CARLA-PRESET>\n";
@@ -1341,16 +1343,34 @@ void CarlaPlugin::setName(const char* const newName)
         delete[] pData->name;
 
     pData->name = carla_strdup(newName);
+    pData->stateChanged = true;
 }
 
 void CarlaPlugin::setOption(const uint option, const bool yesNo, const bool sendCallback)
 {
     CARLA_SAFE_ASSERT_UINT2_RETURN(getOptionsAvailable() & option, getOptionsAvailable(), option,);
 
+    const uint oldOptions = pData->options;
+
     if (yesNo)
         pData->options |= option;
     else
         pData->options &= ~option;
+    pData->stateChanged = true;
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    if (option == PLUGIN_OPTION_DECOUPLED_BLOCKS && oldOptions != pData->options && pData->client != nullptr)
+    {
+        // keep the plugin from running until both it and its patchbay node use the new buffer size
+        const ScopedSingleProcessLocker sspl(this, true);
+
+        bufferSizeChanged(getBufferSize());
+        pData->client->pluginBufferSizeChanged();
+    }
+#else
+    // unused
+    (void)oldOptions;
+#endif
 
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     if (sendCallback)
@@ -1393,6 +1413,36 @@ void CarlaPlugin::setActive(const bool active, const bool sendOsc, const bool se
     if (pData->active == active)
         return;
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    // instantiate the real plugin first, it replaces this one
+    if (active && isDormant())
+    {
+        const uint id = pData->id;
+        CarlaEngine* const engine = pData->engine;
+
+        try {
+            if (engine->wakeDormantPlugin(id))
+            {
+                if (const CarlaPluginPtr plugin = engine->getPlugin(id))
+                    plugin->setActive(true, sendOsc, sendCallback);
+                return;
+            }
+        } CARLA_SAFE_EXCEPTION_RETURN("CarlaPlugin::setActive - wakeDormantPlugin",);
+
+        carla_stderr2("Failed to instantiate dormant plugin '%s', error was:\n%s", pData->name, engine->getLastError());
+
+        // let the host know it is still inactive
+        engine->callback(sendCallback, sendOsc,
+                         ENGINE_CALLBACK_PARAMETER_VALUE_CHANGED,
+                         id,
+                         PARAMETER_ACTIVE,
+                         0, 0,
+                         0.0f,
+                         nullptr);
+        return;
+    }
+#endif
+
     {
         const ScopedSingleProcessLocker spl(this, true);
 
@@ -1403,6 +1453,7 @@ void CarlaPlugin::setActive(const bool active, const bool sendOsc, const bool se
     }
 
     pData->active = active;
+    pData->stateChanged = true;
 
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     const float value = active ? 1.0f : 0.0f;
@@ -1433,6 +1484,7 @@ void CarlaPlugin::setDryWet(const float value, const bool sendOsc, const bool se
         return;
 
     pData->postProc.dryWet = fixedValue;
+    pData->stateChanged = true;
 
     pData->engine->callback(sendCallback, sendOsc,
                             ENGINE_CALLBACK_PARAMETER_VALUE_CHANGED,
@@ -1458,6 +1510,7 @@ void CarlaPlugin::setVolume(const float value, const bool sendOsc, const bool se
         return;
 
     pData->postProc.volume = fixedValue;
+    pData->stateChanged = true;
 
     pData->engine->callback(sendCallback, sendOsc,
                             ENGINE_CALLBACK_PARAMETER_VALUE_CHANGED,
@@ -1483,6 +1536,7 @@ void CarlaPlugin::setBalanceLeft(const float value, const bool sendOsc, const bo
         return;
 
     pData->postProc.balanceLeft = fixedValue;
+    pData->stateChanged = true;
 
     pData->engine->callback(sendCallback, sendOsc,
                             ENGINE_CALLBACK_PARAMETER_VALUE_CHANGED,
@@ -1508,6 +1562,7 @@ void CarlaPlugin::setBalanceRight(const float value, const bool sendOsc, const b
         return;
 
     pData->postProc.balanceRight = fixedValue;
+    pData->stateChanged = true;
 
     pData->engine->callback(sendCallback, sendOsc,
                             ENGINE_CALLBACK_PARAMETER_VALUE_CHANGED,
@@ -1533,6 +1588,7 @@ void CarlaPlugin::setPanning(const float value, const bool sendOsc, const bool s
         return;
 
     pData->postProc.panning = fixedValue;
+    pData->stateChanged = true;
 
     pData->engine->callback(sendCallback, sendOsc,
                             ENGINE_CALLBACK_PARAMETER_VALUE_CHANGED,
@@ -1553,6 +1609,7 @@ void CarlaPlugin::setDryWetRT(const float value, const bool sendCallbackLater) n
         return;
 
     pData->postProc.dryWet = fixedValue;
+    pData->stateChanged = true;
     pData->postponeRtEvent(kPluginPostRtEventParameterChange, sendCallbackLater, PARAMETER_DRYWET, 0, 0, fixedValue);
 }
 
@@ -1566,6 +1623,7 @@ void CarlaPlugin::setVolumeRT(const float value, const bool sendCallbackLater) n
         return;
 
     pData->postProc.volume = fixedValue;
+    pData->stateChanged = true;
     pData->postponeRtEvent(kPluginPostRtEventParameterChange, sendCallbackLater, PARAMETER_VOLUME, 0, 0, fixedValue);
 }
 
@@ -1579,6 +1637,7 @@ void CarlaPlugin::setBalanceLeftRT(const float value, const bool sendCallbackLat
         return;
 
     pData->postProc.balanceLeft = fixedValue;
+    pData->stateChanged = true;
     pData->postponeRtEvent(kPluginPostRtEventParameterChange, sendCallbackLater, PARAMETER_BALANCE_LEFT, 0, 0, fixedValue);
 }
 
@@ -1592,6 +1651,7 @@ void CarlaPlugin::setBalanceRightRT(const float value, const bool sendCallbackLa
         return;
 
     pData->postProc.balanceRight = fixedValue;
+    pData->stateChanged = true;
     pData->postponeRtEvent(kPluginPostRtEventParameterChange, sendCallbackLater, PARAMETER_BALANCE_RIGHT, 0, 0, fixedValue);
 }
 
@@ -1605,6 +1665,7 @@ void CarlaPlugin::setPanningRT(const float value, const bool sendCallbackLater)
         return;
 
     pData->postProc.panning = fixedValue;
+    pData->stateChanged = true;
     pData->postponeRtEvent(kPluginPostRtEventParameterChange, sendCallbackLater, PARAMETER_PANNING, 0, 0, fixedValue);
 }
 #endif // ! BUILD_BRIDGE_ALTERNATIVE_ARCH
@@ -1622,6 +1683,7 @@ void CarlaPlugin::setCtrlChannel(const int8_t channel, const bool sendOsc, const
         return;
 
     pData->ctrlChannel = channel;
+    pData->stateChanged = true;
 
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     const float channelf = static_cast<float>(channel);
@@ -1652,6 +1714,8 @@ void CarlaPlugin::setParameterValue(const uint32_t parameterId, const float valu
 
     if (sendGui && (pData->hints & PLUGIN_HAS_CUSTOM_UI) != 0)
         uiParameterChange(parameterId, value);
+    pData->stateChanged = true;
+    pData->autoSleep.wakeUp = true;
 
     pData->engine->callback(sendCallback, sendOsc,
                             ENGINE_CALLBACK_PARAMETER_VALUE_CHANGED,
@@ -1664,6 +1728,7 @@ void CarlaPlugin::setParameterValue(const uint32_t parameterId, const float valu
 
 void CarlaPlugin::setParameterValueRT(const uint32_t parameterId, const float value, const bool sendCallbackLater) noexcept
 {
+    pData->stateChanged = true;
     pData->postponeRtEvent(kPluginPostRtEventParameterChange,
                            sendCallbackLater, static_cast<int32_t>(parameterId), 0, 0, value);
 }
@@ -1718,6 +1783,8 @@ void CarlaPlugin::setParameterMidiChannel(const uint32_t parameterId, const uint
         return;
 
     pData->param.data[parameterId].midiChannel = channel;
+    pData->param.controlMappingChanged();
+    pData->stateChanged = true;
 
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     pData->engine->callback(sendCallback, sendOsc,
@@ -1791,6 +1858,8 @@ void CarlaPlugin::setParameterMappedControlIndex(const uint32_t parameterId, con
 #endif
 
     paramData.mappedControlIndex = index;
+    pData->param.controlMappingChanged();
+    pData->stateChanged = true;
 
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     if (index == CONTROL_INDEX_MIDI_LEARN)
@@ -1838,6 +1907,7 @@ void CarlaPlugin::setParameterMappedRange(const uint32_t parameterId, const floa
     paramData.hints |= PARAMETER_MAPPED_RANGES_SET;
     paramData.mappedMinimum = minimum;
     paramData.mappedMaximum = maximum;
+    pData->stateChanged = true;
 
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     if (pData->event.cvSourcePorts != nullptr && paramData.mappedControlIndex == CONTROL_INDEX_CV)
@@ -1845,7 +1915,7 @@ void CarlaPlugin::setParameterMappedRange(const uint32_t parameterId, const floa
 
     char strBuf[STR_MAX+1];
     carla_zeroChars(strBuf, STR_MAX+1);
-    std::snprintf(strBuf, STR_MAX, "%.12g:%.12g", static_cast<double>(minimum), static_cast<double>(maximum));
+    std::snprintf(strBuf, STR_MAX, "%s:%s", CarlaFloatString(minimum).buffer, CarlaFloatString(maximum).buffer);
 
     pData->engine->callback(sendCallback, sendOsc,
                             ENGINE_CALLBACK_PARAMETER_MAPPED_RANGE_CHANGED,
@@ -1882,9 +1952,16 @@ void CarlaPlugin::setCustomData(const char* const type, const char* const key, c
         if (std::strcmp(customData.key, key) == 0)
         {
             if (customData.value != nullptr)
+            {
+                // plugins often save their state into custom data, do not flag it as changed if it did not
+                if (std::strcmp(customData.value, value) == 0)
+                    return;
+
                 delete[] customData.value;
+            }
 
             customData.value = carla_strdup(value);
+            pData->stateChanged = true;
             return;
         }
     }
@@ -1895,6 +1972,7 @@ void CarlaPlugin::setCustomData(const char* const type, const char* const key, c
     customData.key   = carla_strdup(key);
     customData.value = carla_strdup(value);
     pData->custom.append(customData);
+    pData->stateChanged = true;
 }
 
 void CarlaPlugin::setChunkData(const void* const data, const std::size_t dataSize)
@@ -1910,6 +1988,8 @@ void CarlaPlugin::setProgram(const int32_t index,
     CARLA_SAFE_ASSERT_RETURN(index >= -1 && index < static_cast<int32_t>(pData->prog.count),);
 
     pData->prog.current = index;
+    pData->stateChanged = true;
+    pData->autoSleep.wakeUp = true;
 
     pData->engine->callback(sendCallback, sendOsc,
                             ENGINE_CALLBACK_PROGRAM_CHANGED,
@@ -1942,6 +2022,8 @@ void CarlaPlugin::setMidiProgram(const int32_t index,
     CARLA_SAFE_ASSERT_RETURN(index >= -1 && index < static_cast<int32_t>(pData->midiprog.count),);
 
     pData->midiprog.current = index;
+    pData->stateChanged = true;
+    pData->autoSleep.wakeUp = true;
 
     pData->engine->callback(sendCallback, sendOsc,
                             ENGINE_CALLBACK_MIDI_PROGRAM_CHANGED,
@@ -1977,12 +2059,37 @@ void CarlaPlugin::setMidiProgramById(const uint32_t bank, const uint32_t program
     }
 }
 
+bool CarlaPlugin::requestProgramChange(const int32_t index,
+                                       const bool sendGui, const bool sendOsc, const bool sendCallback) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(index >= -1 && index < static_cast<int32_t>(pData->prog.count), false);
+
+    if (pData->deferProgramChange(index, false))
+        return true;
+
+    setProgram(index, sendGui, sendOsc, sendCallback);
+    return false;
+}
+
+bool CarlaPlugin::requestMidiProgramChange(const int32_t index,
+                                           const bool sendGui, const bool sendOsc, const bool sendCallback) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(index >= -1 && index < static_cast<int32_t>(pData->midiprog.count), false);
+
+    if (pData->deferProgramChange(index, true))
+        return true;
+
+    setMidiProgram(index, sendGui, sendOsc, sendCallback);
+    return false;
+}
+
 void CarlaPlugin::setProgramRT(const uint32_t uindex, const bool sendCallbackLater) noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(uindex < pData->prog.count,);
 
     const int32_t index = static_cast<int32_t>(uindex);
     pData->prog.current = index;
+    pData->stateChanged = true;
 
     // Change default parameter values
     switch (getType())
@@ -2005,6 +2112,7 @@ void CarlaPlugin::setMidiProgramRT(const uint32_t uindex, const bool sendCallbac
 
     const int32_t index = static_cast<int32_t>(uindex);
     pData->midiprog.current = index;
+    pData->stateChanged = true;
 
     // Change default parameter values
     switch (getType())
@@ -2041,6 +2149,103 @@ void CarlaPlugin::deactivate() noexcept
     CARLA_SAFE_ASSERT(pData->active);
 }
 
+float* CarlaPlugin::getSharedAudioBuffer(const bool, const uint32_t) const noexcept
+{
+    return nullptr;
+}
+
+bool CarlaPlugin::canStartProcess() const noexcept
+{
+    return false;
+}
+
+void CarlaPlugin::startProcess(const float* const*, float**, const float* const*, float**, const uint32_t)
+{
+}
+
+// anything below this (about -100dB) counts as silence for auto-sleep
+static const float kAutoSleepThreshold = 0.00001f;
+
+bool CarlaPlugin::checkAutoSleep(const float* const* const audioIn, const uint32_t frames) noexcept
+{
+    ProtectedData::AutoSleep& autoSleep(pData->autoSleep);
+
+    if ((pData->options & PLUGIN_OPTION_AUTO_SLEEP) == 0x0 || pData->audioIn.count == 0 || pData->cvIn.count != 0 || audioIn == nullptr)
+    {
+        autoSleep.inputSilent  = false;
+        autoSleep.sleeping     = false;
+        autoSleep.silentFrames = 0;
+        return false;
+    }
+
+    bool silent = true;
+
+    if (autoSleep.wakeUp)
+    {
+        autoSleep.wakeUp = false;
+        silent = false;
+    }
+    else if (pData->needsReset || ! pData->extNotes.isEmpty())
+    {
+        silent = false;
+    }
+    else if (pData->event.portIn != nullptr && pData->event.portIn->getEventCount() != 0)
+    {
+        silent = false;
+    }
+    else
+    {
+        for (uint32_t i=0; i < pData->audioIn.count; ++i)
+        {
+            if (carla_findMaxAbsFloat(nullptr, audioIn[i], frames) > kAutoSleepThreshold)
+            {
+                silent = false;
+                break;
+            }
+        }
+    }
+
+    autoSleep.inputSilent = silent;
+
+    if (! silent)
+    {
+        autoSleep.sleeping     = false;
+        autoSleep.silentFrames = 0;
+    }
+
+    return autoSleep.sleeping;
+}
+
+void CarlaPlugin::updateAutoSleep(const float* const* const audioOut, const uint32_t frames) noexcept
+{
+    ProtectedData::AutoSleep& autoSleep(pData->autoSleep);
+
+    if (! autoSleep.inputSilent || autoSleep.sleeping || audioOut == nullptr)
+        return;
+
+    // there is no generic way to query a plugin's tail, so wait for its outputs to go silent too
+    for (uint32_t i=0; i < pData->audioOut.count; ++i)
+    {
+        if (carla_findMaxAbsFloat(nullptr, audioOut[i], frames) > kAutoSleepThreshold)
+        {
+            autoSleep.silentFrames = 0;
+            return;
+        }
+    }
+
+    autoSleep.silentFrames += frames;
+
+    if (autoSleep.silentFrames >= static_cast<uint32_t>(pData->engine->getSampleRate()))
+        autoSleep.sleeping = true;
+}
+
+uint32_t CarlaPlugin::takeEventSplitCount() noexcept
+{
+    const uint32_t count = pData->eventSplitCount;
+    pData->eventSplitCount = 0;
+    return count;
+}
+
 void CarlaPlugin::bufferSizeChanged(const uint32_t)
 {
 }
@@ -2079,14 +2284,21 @@ void CarlaPlugin::idle()
 #endif
     }
 
-    ProtectedData::PostRtEvents::Access rtEvents(pData->postRtEvents);
+    try {
+        pData->param.updateControlMap();
+    } CARLA_SAFE_EXCEPTION("updateControlMap");
 
-    if (rtEvents.isEmpty())
-        return;
+    // event ports that ran out of space during processing
+    if (pData->event.portIn != nullptr)
+        pData->event.portIn->growBufferIfNeeded();
+    if (pData->event.portOut != nullptr)
+        pData->event.portOut->growBufferIfNeeded();
 
-    for (RtLinkedList<PluginPostRtEvent>::Itenerator it = rtEvents.getDataIterator(); it.valid(); it.next())
+    ProtectedData::PostRtEvents::Access rtEvents(pData->postRtEvents);
+    PluginPostRtEvent event;
+
+    while (rtEvents.next(event))
     {
-        const PluginPostRtEvent& event(it.getValue(kPluginPostRtEventFallback));
         CARLA_SAFE_ASSERT_CONTINUE(event.type != kPluginPostRtEventNull);
 
         switch (event.type)
@@ -2101,6 +2313,12 @@ void CarlaPlugin::idle()
         } break;
 
         case kPluginPostRtEventParameterChange: {
+            // Changes coming from the plugin itself (automation, trigger resets) invalidate the cached state
+            if (event.value1 < 0 ||
+                (static_cast<uint32_t>(event.value1) < pData->param.count &&
+                 pData->param.data[event.value1].type == PARAMETER_INPUT))
+                pData->stateChanged = true;
+
             // Update UI
             if (event.value1 >= 0 && hasUI)
             {
@@ -2124,6 +2342,8 @@ void CarlaPlugin::idle()
         } break;
 
         case kPluginPostRtEventProgramChange: {
+            pData->stateChanged = true;
+
             // Update UI
             if (event.value1 >= 0 && hasUI)
             {
@@ -2167,6 +2387,8 @@ void CarlaPlugin::idle()
         } break;
 
         case kPluginPostRtEventMidiProgramChange: {
+            pData->stateChanged = true;
+
             // Update UI
             if (event.value1 >= 0 && hasUI)
             {
@@ -2360,6 +2582,7 @@ void CarlaPlugin::sendMidiSingleNote(const uint8_t channel, const uint8_t note,
     extNote.channel = static_cast<int8_t>(channel);
     extNote.note    = note;
     extNote.velo    = velo;
+    extNote.time    = 0;
 
     pData->extNotes.appendNonRT(extNote);
 
@@ -2597,6 +2820,7 @@ void CarlaPlugin::checkForMidiLearn(EngineEvent& event) noexcept
     event.ctrl.handled = true;
     paramData.mappedControlIndex = static_cast<int16_t>(event.ctrl.param);
     paramData.midiChannel = event.channel;
+    pData->param.controlMappingChanged();
 
     pData->postponeRtEvent(kPluginPostRtEventMidiLearn, true,
                            pData->midiLearnParameterIndex, event.ctrl.param, event.channel, 0.0f);
@@ -2656,6 +2880,55 @@ void CarlaPlugin::waitForBridgeSaveSignal() noexcept
 {
 }
 
+// state can change without us knowing in these cases
+static bool hasOpaqueState(const uint options, const uint hints) noexcept
+{
+    return (options & PLUGIN_OPTION_USE_CHUNKS) != 0 || (hints & PLUGIN_IS_BRIDGE) != 0;
+}
+
+bool CarlaPlugin::prepareStateDump(const File* const chunkFile)
+{
+    if (! hasOpaqueState(pData->options, pData->hints) && ! pData->stateChanged && pData->stateSaveXml.isNotEmpty())
+        return false;
+
+    // reset before collecting the state, so that changes happening meanwhile are caught by the next save
+    pData->stateChanged = false;
+    pData->stateSaveChunkFilename.clear();
+
+    const CarlaStateSave& stateSave(getStateSave(false));
+
+    if (chunkFile != nullptr && ! stateSave.chunkData.empty())
+    {
+        const File chunkDir(chunkFile->getParentDirectory());
+
+        if (chunkDir.createDirectory().wasOk() &&
+            chunkFile->replaceWithData(&stateSave.chunkData.front(), stateSave.chunkData.size()))
+            pData->stateSaveChunkFilename = chunkDir.getFileName() + "/" + chunkFile->getFileName();
+        else
+            carla_stderr2("Failed to write chunk file for plugin '%s', saving it inline instead", pData->name);
+    }
+
+    return true;
+}
+
+void CarlaPlugin::encodeStateDump()
+{
+    MemoryOutputStream streamState;
+    pData->stateSave.dumpToMemoryStream(streamState, pData->stateSaveChunkFilename.toRawUTF8(),
+                                        pData->engine->getOptions().compactParameterState);
+
+    pData->stateSaveXml = streamState.toUTF8();
+}
+
+void CarlaPlugin::finishStateDump(MemoryOutputStream& stream)
+{
+    stream << pData->stateSaveXml;
+
+    // never reused, do not keep a possibly big chunk around
+    if (hasOpaqueState(pData->options, pData->hints))
+        pData->stateSaveXml.clear();
+}
+
 // -------------------------------------------------------------------
 // Scoped Disabler
 
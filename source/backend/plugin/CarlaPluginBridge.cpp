@@ -46,9 +46,8 @@ using water::Time;
 CARLA_BACKEND_START_NAMESPACE
 
 // ---------------------------------------------------------------------------------------------------------------------
-// Fallback data
-
-static const ExternalMidiNote kExternalMidiNoteFallback = { -1, 0, 0 };
+// number of parameter names requested at once, see kPluginBridgeNonRtClientGetParameterNames
+static const uint32_t kParameterNamesBlockSize = 256;
 
 // ---------------------------------------------------------------------------------------------------------------------
 
@@ -69,12 +68,14 @@ static String findWinePrefix(const String filename, const int recursionLimit = 1
 
 struct BridgeParamInfo {
     float value;
+    bool hasNames; // false until name, symbol and unit are received, when the bridge sends them lazily
     CarlaString name;
     CarlaString symbol;
     CarlaString unit;
 
     BridgeParamInfo() noexcept
         : value(0.0f),
+          hasNames(true),
           name(),
           symbol(),
           unit() {}
@@ -84,6 +85,297 @@ struct BridgeParamInfo {
 
 // ---------------------------------------------------------------------------------------------------------------------
 
+// Fills 'shmIds' with the suffixes of the 4 shared memory segments, as passed to the bridge via ENGINE_BRIDGE_SHM_IDS.
+static void getBridgeShmIds(char shmIds[6*4+1],
+                            const BridgeAudioPool& shmAudioPool,
+                            const BridgeRtClientControl& shmRtClientControl,
+                            const BridgeNonRtClientControl& shmNonRtClientControl,
+                            const BridgeNonRtServerControl& shmNonRtServerControl) noexcept
+{
+    carla_zeroChars(shmIds, 6*4+1);
+
+    std::strncpy(shmIds+6*0, shmAudioPool.filename.buffer() + shmAudioPool.filename.length()-6, 6);
+    std::strncpy(shmIds+6*1, shmRtClientControl.filename.buffer() + shmRtClientControl.filename.length()-6, 6);
+    std::strncpy(shmIds+6*2, shmNonRtClientControl.filename.buffer() + shmNonRtClientControl.filename.length()-6, 6);
+    std::strncpy(shmIds+6*3, shmNonRtServerControl.filename.buffer() + shmNonRtServerControl.filename.length()-6, 6);
+}
+
+// First messages a bridge reads, before anything else.
+static void writeBridgeInitialSetup(BridgeNonRtClientControl& shmNonRtClientControl,
+                                    const uint32_t bufferSize, const double sampleRate) noexcept
+{
+    shmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientVersion);
+    shmNonRtClientControl.writeUInt(CARLA_PLUGIN_BRIDGE_API_VERSION_CURRENT);
+
+    shmNonRtClientControl.writeUInt(static_cast<uint32_t>(sizeof(BridgeRtClientData)));
+    shmNonRtClientControl.writeUInt(static_cast<uint32_t>(sizeof(BridgeNonRtClientData)));
+    shmNonRtClientControl.writeUInt(static_cast<uint32_t>(sizeof(BridgeNonRtServerData)));
+
+    shmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientInitialSetup);
+    shmNonRtClientControl.writeUInt(bufferSize);
+    shmNonRtClientControl.writeDouble(sampleRate);
+
+    shmNonRtClientControl.commitWrite();
+}
+
+enum BridgeProcessMode {
+    kBridgeProcessSinglePlugin,
+    kBridgeProcessPooled, // see CarlaPluginBridgePool
+    kBridgeProcessGroup   // see CarlaPluginBridgeGroup
+};
+
+// Engine options that startBridgeProcess() passes through the environment, joined into a single string.
+// A running bridge does not see later changes to these, so it must not be reused once they differ.
+static String getBridgeProcessOptionsKey(const EngineOptions& options)
+{
+    String key;
+
+    key << bool2str(options.forceStereo) << '\n'
+        << bool2str(options.preferPluginBridges) << '\n'
+        << bool2str(options.preferUiBridges) << '\n'
+        << bool2str(options.uisAlwaysOnTop) << '\n'
+        << bool2str(options.flushDenormals) << '\n'
+        << static_cast<int>(options.maxParameters) << '\n'
+        << static_cast<int>(options.uiBridgesTimeout) << '\n'
+        << (options.pathLADSPA != nullptr ? options.pathLADSPA : "") << '\n'
+        << (options.pathDSSI != nullptr ? options.pathDSSI : "") << '\n'
+        << (options.pathLV2 != nullptr ? options.pathLV2 : "") << '\n'
+        << (options.pathVST2 != nullptr ? options.pathVST2 : "") << '\n'
+        << (options.pathVST3 != nullptr ? options.pathVST3 : "") << '\n'
+        << (options.pathSF2 != nullptr ? options.pathSF2 : "") << '\n'
+        << (options.pathSFZ != nullptr ? options.pathSFZ : "") << '\n'
+        << (options.binaryDir != nullptr ? options.binaryDir : "") << '\n'
+        << (options.resourceDir != nullptr ? options.resourceDir : "") << '\n'
+        << bool2str(options.preventBadBehaviour) << '\n'
+        << options.bridgeRtPrio << '\n'
+        << (options.bridgeCpuAffinity != nullptr ? options.bridgeCpuAffinity : "") << '\n'
+        << String::toHexString(static_cast<water::int64>(options.frontendWinId));
+
+#ifndef CARLA_OS_WIN
+    key << '\n'
+        << (options.wine.executable != nullptr ? options.wine.executable : "") << '\n'
+        << bool2str(options.wine.rtPrio) << '\n'
+        << options.wine.baseRtPrio << '\n'
+        << options.wine.serverRtPrio;
+#endif
+
+    return key;
+}
+
+// Starts a bridge process with the current engine options.
+// Pooled bridges are started without a plugin, they wait for kPluginBridgeNonRtClientLoadPlugin instead.
+// Group bridges never load a plugin themselves, only kPluginBridgeNonRtClientAddGroupMember.
+static bool startBridgeProcess(ChildProcess& process,
+                               CarlaEngine* const engine,
+                               const String& binary,
+#ifndef CARLA_OS_WIN
+                               const String& winePrefix,
+#endif
+                               const String& shmIds,
+                               const PluginType ptype,
+                               const String& filename,
+                               const String& label,
+                               const int64_t uniqueId,
+                               const BridgeProcessMode mode)
+{
+    char strBuf[STR_MAX+1];
+    strBuf[STR_MAX] = '\0';
+
+    const EngineOptions& options(engine->getOptions());
+
+    String filename2(filename);
+    String label2(label);
+
+    if (filename2.isEmpty())
+        filename2 = "\"\"";
+
+    if (label2.isEmpty())
+        label2 = "\"\"";
+
+    StringArray arguments;
+
+#ifndef CARLA_OS_WIN
+    // start with "wine" if needed
+    if (binary.endsWithIgnoreCase(".exe"))
+    {
+        String wineCMD;
+
+        if (options.wine.executable != nullptr && options.wine.executable[0] != '\0')
+        {
+            wineCMD = options.wine.executable;
+
+            if (binary.endsWithIgnoreCase("64.exe")
+                && options.wine.executable[0] == CARLA_OS_SEP
+                && File(wineCMD + "64").existsAsFile())
+                wineCMD += "64";
+        }
+        else
+        {
+            wineCMD = "wine";
+        }
+
+        arguments.add(wineCMD);
+    }
+#endif
+
+    // binary
+    arguments.add(binary);
+
+    // plugin type
+    arguments.add(getPluginTypeAsString(ptype));
+
+    // filename
+    arguments.add(filename2);
+
+    // label
+    arguments.add(label2);
+
+    // uniqueId
+    arguments.add(String(static_cast<water::int64>(uniqueId)));
+
+    {
+        const ScopedEngineEnvironmentLocker _seel(engine);
+
+#ifdef CARLA_OS_LINUX
+        const CarlaScopedEnvVar sev1("LD_LIBRARY_PATH", nullptr);
+        const CarlaScopedEnvVar sev2("LD_PRELOAD", nullptr);
+#endif
+
+        carla_setenv("ENGINE_OPTION_FORCE_STEREO",          bool2str(options.forceStereo));
+        carla_setenv("ENGINE_OPTION_PREFER_PLUGIN_BRIDGES", bool2str(options.preferPluginBridges));
+        carla_setenv("ENGINE_OPTION_PREFER_UI_BRIDGES",     bool2str(options.preferUiBridges));
+        carla_setenv("ENGINE_OPTION_UIS_ALWAYS_ON_TOP",     bool2str(options.uisAlwaysOnTop));
+        carla_setenv("ENGINE_OPTION_FLUSH_DENORMALS",       bool2str(options.flushDenormals));
+
+        std::snprintf(strBuf, STR_MAX, "%u", options.maxParameters);
+        carla_setenv("ENGINE_OPTION_MAX_PARAMETERS", strBuf);
+
+        std::snprintf(strBuf, STR_MAX, "%u", options.uiBridgesTimeout);
+        carla_setenv("ENGINE_OPTION_UI_BRIDGES_TIMEOUT",strBuf);
+
+        if (options.pathLADSPA != nullptr)
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_LADSPA", options.pathLADSPA);
+        else
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_LADSPA", "");
+
+        if (options.pathDSSI != nullptr)
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_DSSI", options.pathDSSI);
+        else
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_DSSI", "");
+
+        if (options.pathLV2 != nullptr)
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_LV2", options.pathLV2);
+        else
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_LV2", "");
+
+        if (options.pathVST2 != nullptr)
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_VST2", options.pathVST2);
+        else
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_VST2", "");
+
+        if (options.pathVST3 != nullptr)
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_VST3", options.pathVST3);
+        else
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_VST3", "");
+
+        if (options.pathSF2 != nullptr)
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_SF2", options.pathSF2);
+        else
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_SF2", "");
+
+        if (options.pathSFZ != nullptr)
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_SFZ", options.pathSFZ);
+        else
+            carla_setenv("ENGINE_OPTION_PLUGIN_PATH_SFZ", "");
+
+        if (options.binaryDir != nullptr)
+            carla_setenv("ENGINE_OPTION_PATH_BINARIES", options.binaryDir);
+        else
+            carla_setenv("ENGINE_OPTION_PATH_BINARIES", "");
+
+        if (options.resourceDir != nullptr)
+            carla_setenv("ENGINE_OPTION_PATH_RESOURCES", options.resourceDir);
+        else
+            carla_setenv("ENGINE_OPTION_PATH_RESOURCES", "");
+
+        carla_setenv("ENGINE_OPTION_PREVENT_BAD_BEHAVIOUR", bool2str(options.preventBadBehaviour));
+
+        // per-plugin overrides are sent later, see kPluginBridgeNonRtClientSetThreadPolicy
+        std::snprintf(strBuf, STR_MAX, "%i", options.bridgeRtPrio);
+        carla_setenv("ENGINE_OPTION_BRIDGE_RT_PRIO", strBuf);
+
+        if (options.bridgeCpuAffinity != nullptr)
+            carla_setenv("ENGINE_OPTION_BRIDGE_CPU_AFFINITY", options.bridgeCpuAffinity);
+        else
+            carla_setenv("ENGINE_OPTION_BRIDGE_CPU_AFFINITY", "");
+
+        std::snprintf(strBuf, STR_MAX, P_UINTPTR, options.frontendWinId);
+        carla_setenv("ENGINE_OPTION_FRONTEND_WIN_ID", strBuf);
+
+        carla_setenv("ENGINE_BRIDGE_SHM_IDS", shmIds.toRawUTF8());
+
+        if (mode == kBridgeProcessPooled)
+            carla_setenv("ENGINE_BRIDGE_POOLED", "true");
+        else
+            carla_unsetenv("ENGINE_BRIDGE_POOLED");
+
+        if (mode == kBridgeProcessGroup)
+            carla_setenv("ENGINE_BRIDGE_GROUP", "true");
+        else
+            carla_unsetenv("ENGINE_BRIDGE_GROUP");
+
+#ifndef CARLA_OS_WIN
+        if (winePrefix.isNotEmpty())
+        {
+            carla_setenv("WINEDEBUG", "-all");
+            carla_setenv("WINEPREFIX", winePrefix.toRawUTF8());
+
+            if (options.wine.rtPrio)
+            {
+                carla_setenv("STAGING_SHARED_MEMORY", "1");
+                carla_setenv("WINE_RT_POLICY", "FF");
+
+                std::snprintf(strBuf, STR_MAX, "%i", options.wine.baseRtPrio);
+                carla_setenv("STAGING_RT_PRIORITY_BASE", strBuf);
+                carla_setenv("WINE_RT", strBuf);
+                carla_setenv("WINE_RT_PRIO", strBuf);
+
+                std::snprintf(strBuf, STR_MAX, "%i", options.wine.serverRtPrio);
+                carla_setenv("STAGING_RT_PRIORITY_SERVER", strBuf);
+                carla_setenv("WINE_SVR_RT", strBuf);
+
+                carla_stdout("Using WINEPREFIX '%s', with base RT prio %i and server RT prio %i",
+                            winePrefix.toRawUTF8(), options.wine.baseRtPrio, options.wine.serverRtPrio);
+            }
+            else
+            {
+                carla_unsetenv("STAGING_SHARED_MEMORY");
+                carla_unsetenv("WINE_RT_POLICY");
+                carla_unsetenv("STAGING_RT_PRIORITY_BASE");
+                carla_unsetenv("STAGING_RT_PRIORITY_SERVER");
+                carla_unsetenv("WINE_RT");
+                carla_unsetenv("WINE_RT_PRIO");
+                carla_unsetenv("WINE_SVR_RT");
+
+                carla_stdout("Using WINEPREFIX '%s', without RT priorities", winePrefix.toRawUTF8());
+            }
+        }
+#endif
+
+        if (mode == kBridgeProcessPooled)
+            carla_stdout("Starting pooled plugin bridge, command is:\n%s", binary.toRawUTF8());
+        else if (mode == kBridgeProcessGroup)
+            carla_stdout("Starting plugin bridge group, command is:\n%s", binary.toRawUTF8());
+        else
+            carla_stdout("Starting plugin bridge, command is:\n%s \"%s\" \"%s\" \"%s\" " P_INT64,
+                         binary.toRawUTF8(), getPluginTypeAsString(ptype), filename2.toRawUTF8(), label2.toRawUTF8(), uniqueId);
+
+        return process.start(arguments);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
 class CarlaPluginBridgeThread : public CarlaThread
 {
 public:
@@ -97,7 +389,9 @@ public:
 #ifndef CARLA_OS_WIN
           fWinePrefix(),
 #endif
-          fProcess() {}
+          fProcess(),
+          fProcessFromPool(false),
+          fGroupProcess(nullptr) {}
 
     void setData(
 #ifndef CARLA_OS_WIN
@@ -123,8 +417,34 @@ public:
             fLabel = "\"\"";
     }
 
+    // use an already running process for the next run, instead of starting a new one
+    void setPooledProcess(ChildProcess* const process) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(process != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(! isThreadRunning(),);
+
+        fProcess = process;
+        fProcessFromPool = true;
+    }
+
+    bool hasPooledProcess() const noexcept
+    {
+        return fProcessFromPool;
+    }
+
+    // watch a process shared with other plugins instead of starting one, null to go back to a process of our own
+    void setGroupProcess(ChildProcess* const process) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(! isThreadRunning(),);
+
+        fGroupProcess = process;
+    }
+
     uintptr_t getProcessPID() const noexcept
     {
+        if (fGroupProcess != nullptr)
+            return (uintptr_t)fGroupProcess->getPID();
+
         CARLA_SAFE_ASSERT_RETURN(fProcess != nullptr, 0);
 
         return (uintptr_t)fProcess->getPID();
@@ -133,244 +453,592 @@ public:
 protected:
     void run()
     {
-        if (fProcess == nullptr)
+        // the group closes its own process, we only report a crash
+        if (fGroupProcess != nullptr)
         {
-            fProcess = new ChildProcess();
+            for (; fGroupProcess->isRunning() && ! shouldThreadExit();)
+                carla_sleep(1);
+
+            if (! shouldThreadExit())
+                reportCrash();
+            return;
         }
-        else if (fProcess->isRunning())
+
+        if (fProcessFromPool)
         {
-            carla_stderr("CarlaPluginBridgeThread::run() - already running");
+            fProcessFromPool = false;
         }
+        else
+        {
+            if (fProcess == nullptr)
+            {
+                fProcess = new ChildProcess();
+            }
+            else if (fProcess->isRunning())
+            {
+                carla_stderr("CarlaPluginBridgeThread::run() - already running");
+            }
 
-        char strBuf[STR_MAX+1];
-        strBuf[STR_MAX] = '\0';
-
-        const EngineOptions& options(kEngine->getOptions());
-
-        String name(kPlugin->getName());
-        String filename(kPlugin->getFilename());
-
-        if (name.isEmpty())
-            name = "(none)";
+            const bool started = startBridgeProcess(*fProcess, kEngine, fBinary,
+#ifndef CARLA_OS_WIN
+                                                    fWinePrefix,
+#endif
+                                                    fShmIds, kPlugin->getType(), kPlugin->getFilename(), fLabel,
+                                                    kPlugin->getUniqueId(), kBridgeProcessSinglePlugin);
 
-        if (filename.isEmpty())
-            filename = "\"\"";
+            if (! started)
+            {
+                carla_stdout("failed!");
+                fProcess = nullptr;
+                return;
+            }
+        }
 
-        StringArray arguments;
+        for (; fProcess->isRunning() && ! shouldThreadExit();)
+            carla_sleep(1);
 
-#ifndef CARLA_OS_WIN
-        // start with "wine" if needed
-        if (fBinary.endsWithIgnoreCase(".exe"))
+        // we only get here if bridge crashed or thread asked to exit
+        if (fProcess->isRunning() && shouldThreadExit())
         {
-            String wineCMD;
+            fProcess->waitForProcessToFinish(2000);
 
-            if (options.wine.executable != nullptr && options.wine.executable[0] != '\0')
+            if (fProcess->isRunning())
             {
-                wineCMD = options.wine.executable;
-
-                if (fBinary.endsWithIgnoreCase("64.exe")
-                    && options.wine.executable[0] == CARLA_OS_SEP
-                    && File(wineCMD + "64").existsAsFile())
-                    wineCMD += "64";
+                carla_stdout("CarlaPluginBridgeThread::run() - bridge refused to close, force kill now");
+                fProcess->kill();
             }
             else
             {
-                wineCMD = "wine";
+                carla_stdout("CarlaPluginBridgeThread::run() - bridge auto-closed successfully");
             }
-
-            arguments.add(wineCMD);
         }
+        else
+        {
+            // forced quit, may have crashed
+            if (fProcess->getExitCode() != 0 /*|| fProcess->exitStatus() == QProcess::CrashExit*/)
+                reportCrash();
+        }
+
+        fProcess = nullptr;
+    }
+
+private:
+    void reportCrash()
+    {
+        carla_stderr("CarlaPluginBridgeThread::run() - bridge crashed");
+
+        CarlaString errorString("Plugin '" + CarlaString(kPlugin->getName()) + "' has crashed!\n"
+                                "Saving now will lose its current settings.\n"
+                                "Please remove this plugin, and not rely on it from this point.");
+        kEngine->callback(true, true,
+                          CarlaBackend::ENGINE_CALLBACK_ERROR, kPlugin->getId(), 0, 0, 0, 0.0f, errorString);
+    }
+
+    CarlaEngine* const kEngine;
+    CarlaPlugin* const kPlugin;
+
+    String fBinary;
+    String fLabel;
+    String fShmIds;
+#ifndef CARLA_OS_WIN
+    String fWinePrefix;
 #endif
 
-        // binary
-        arguments.add(fBinary);
+    CarlaScopedPointer<ChildProcess> fProcess;
+    bool fProcessFromPool;
+    ChildProcess* fGroupProcess;
 
-        // plugin type
-        arguments.add(getPluginTypeAsString(kPlugin->getType()));
+    CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaPluginBridgeThread)
+};
 
-        // filename
-        arguments.add(filename);
+// ---------------------------------------------------------------------------------------------------------------------
+// Idle bridge processes, started ahead of time
 
-        // label
-        arguments.add(fLabel);
+/*
+ * Keeps a few bridge processes running for each bridge binary, already attached to their shared memory.
+ * Loading a bridged plugin takes one of these and only needs to tell it which plugin to load,
+ * which skips process and Wine startup.
+ * The pool is shared by all bridged plugins in the process, and stopped together with the last one.
+ * See ENGINE_OPTION_PLUGIN_BRIDGE_POOL_SIZE.
+ */
+class CarlaPluginBridgePool
+{
+public:
+    struct Process {
+        BridgeAudioPool shmAudioPool;
+        BridgeRtClientControl shmRtClientControl;
+        BridgeNonRtClientControl shmNonRtClientControl;
+        BridgeNonRtServerControl shmNonRtServerControl;
+        CarlaScopedPointer<ChildProcess> process;
+        String binary;
+#ifndef CARLA_OS_WIN
+        String winePrefix;
+#endif
+        String optionsKey;
+        uint32_t bufferSize;
+        double sampleRate;
+
+        Process() noexcept
+            : shmAudioPool(),
+              shmRtClientControl(),
+              shmNonRtClientControl(),
+              shmNonRtServerControl(),
+              process(),
+              binary(),
+#ifndef CARLA_OS_WIN
+              winePrefix(),
+#endif
+              optionsKey(),
+              bufferSize(0),
+              sampleRate(0.0) {}
+
+        ~Process() noexcept
+        {
+            if (process != nullptr && process->isRunning())
+            {
+                process->waitForProcessToFinish(2000);
 
-        // uniqueId
-        arguments.add(String(static_cast<water::int64>(kPlugin->getUniqueId())));
+                if (process->isRunning())
+                {
+                    carla_stdout("CarlaPluginBridgePool - idle bridge refused to close, force kill now");
+                    process->kill();
+                }
+            }
 
-        bool started;
+            process = nullptr;
 
+            shmNonRtServerControl.clear();
+            shmNonRtClientControl.clear();
+            shmRtClientControl.clear();
+            shmAudioPool.clear();
+        }
+
+        // asks the bridge to close, without waiting for it
+        void requestQuit() noexcept
         {
-            const ScopedEngineEnvironmentLocker _seel(kEngine);
+            if (process == nullptr || ! process->isRunning())
+                return;
 
-#ifdef CARLA_OS_LINUX
-            const CarlaScopedEnvVar sev1("LD_LIBRARY_PATH", nullptr);
-            const CarlaScopedEnvVar sev2("LD_PRELOAD", nullptr);
+            const CarlaMutexLocker _cml(shmNonRtClientControl.mutex);
+
+            shmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientQuit);
+            shmNonRtClientControl.commitWrite();
+        }
+
+        bool matches(const String& binary2,
+#ifndef CARLA_OS_WIN
+                     const String& winePrefix2,
+#endif
+                     const String& optionsKey2,
+                     const uint32_t bufferSize2, const double sampleRate2) const noexcept
+        {
+            return binary == binary2
+#ifndef CARLA_OS_WIN
+                && winePrefix == winePrefix2
 #endif
+                && optionsKey == optionsKey2
+                && bufferSize == bufferSize2
+                && carla_isEqual(sampleRate, sampleRate2);
+        }
 
-            carla_setenv("ENGINE_OPTION_FORCE_STEREO",          bool2str(options.forceStereo));
-            carla_setenv("ENGINE_OPTION_PREFER_PLUGIN_BRIDGES", bool2str(options.preferPluginBridges));
-            carla_setenv("ENGINE_OPTION_PREFER_UI_BRIDGES",     bool2str(options.preferUiBridges));
-            carla_setenv("ENGINE_OPTION_UIS_ALWAYS_ON_TOP",     bool2str(options.uisAlwaysOnTop));
+        CARLA_DECLARE_NON_COPY_STRUCT(Process)
+    };
 
-            std::snprintf(strBuf, STR_MAX, "%u", options.maxParameters);
-            carla_setenv("ENGINE_OPTION_MAX_PARAMETERS", strBuf);
+    static void addClient() noexcept
+    {
+        const CarlaMutexLocker cml(getPoolMutex());
+        CarlaPluginBridgePool*& pool(getPool());
 
-            std::snprintf(strBuf, STR_MAX, "%u", options.uiBridgesTimeout);
-            carla_setenv("ENGINE_OPTION_UI_BRIDGES_TIMEOUT",strBuf);
+        if (pool == nullptr)
+            pool = new CarlaPluginBridgePool();
 
-            if (options.pathLADSPA != nullptr)
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_LADSPA", options.pathLADSPA);
-            else
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_LADSPA", "");
+        ++pool->fNumClients;
+    }
 
-            if (options.pathDSSI != nullptr)
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_DSSI", options.pathDSSI);
-            else
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_DSSI", "");
+    static void removeClient() noexcept
+    {
+        const CarlaMutexLocker cml(getPoolMutex());
+        CarlaPluginBridgePool*& pool(getPool());
+        CARLA_SAFE_ASSERT_RETURN(pool != nullptr,);
 
-            if (options.pathLV2 != nullptr)
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_LV2", options.pathLV2);
-            else
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_LV2", "");
+        if (--pool->fNumClients != 0)
+            return;
 
-            if (options.pathVST2 != nullptr)
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_VST2", options.pathVST2);
-            else
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_VST2", "");
+        delete pool;
+        pool = nullptr;
+    }
 
-            if (options.pathVST3 != nullptr)
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_VST3", options.pathVST3);
-            else
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_VST3", "");
+    /*
+     * Takes an idle bridge matching the given binary and engine setup, if there is one.
+     * The caller owns the returned process.
+     */
+    static Process* take(CarlaEngine* const engine,
+                         const String& binary
+#ifndef CARLA_OS_WIN
+                       , const String& winePrefix
+#endif
+                         ) noexcept
+    {
+        const CarlaMutexLocker cml(getPoolMutex());
+        CarlaPluginBridgePool* const pool(getPool());
+        CARLA_SAFE_ASSERT_RETURN(pool != nullptr, nullptr);
 
-            if (options.pathSF2 != nullptr)
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_SF2", options.pathSF2);
-            else
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_SF2", "");
+        const String optionsKey(getBridgeProcessOptionsKey(engine->getOptions()));
+        const uint32_t bufferSize(engine->getBufferSize());
+        const double sampleRate(engine->getSampleRate());
 
-            if (options.pathSFZ != nullptr)
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_SFZ", options.pathSFZ);
-            else
-                carla_setenv("ENGINE_OPTION_PLUGIN_PATH_SFZ", "");
+        for (LinkedList<Process*>::Itenerator it = pool->fProcesses.begin2(); it.valid(); it.next())
+        {
+            Process* const proc(it.getValue(nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(proc != nullptr);
 
-            if (options.binaryDir != nullptr)
-                carla_setenv("ENGINE_OPTION_PATH_BINARIES", options.binaryDir);
-            else
-                carla_setenv("ENGINE_OPTION_PATH_BINARIES", "");
+            if (! proc->matches(binary,
+#ifndef CARLA_OS_WIN
+                                winePrefix,
+#endif
+                                optionsKey, bufferSize, sampleRate))
+                continue;
 
-            if (options.resourceDir != nullptr)
-                carla_setenv("ENGINE_OPTION_PATH_RESOURCES", options.resourceDir);
-            else
-                carla_setenv("ENGINE_OPTION_PATH_RESOURCES", "");
+            pool->fProcesses.remove(it);
 
-            carla_setenv("ENGINE_OPTION_PREVENT_BAD_BEHAVIOUR", bool2str(options.preventBadBehaviour));
+            // crashed or closed meanwhile, the next one might still be good
+            if (! proc->process->isRunning())
+            {
+                delete proc;
+                continue;
+            }
 
-            std::snprintf(strBuf, STR_MAX, P_UINTPTR, options.frontendWinId);
-            carla_setenv("ENGINE_OPTION_FRONTEND_WIN_ID", strBuf);
+            return proc;
+        }
 
-            carla_setenv("ENGINE_BRIDGE_SHM_IDS", fShmIds.toRawUTF8());
+        return nullptr;
+    }
 
+    /*
+     * Starts new idle bridges until there are as many as the engine asks for.
+     * Bridges started for an older engine setup, including engine options passed on at startup, are closed.
+     */
+    static void refill(CarlaEngine* const engine,
+                       const String& binary
 #ifndef CARLA_OS_WIN
-            if (fWinePrefix.isNotEmpty())
-            {
-                carla_setenv("WINEDEBUG", "-all");
-                carla_setenv("WINEPREFIX", fWinePrefix.toRawUTF8());
+                     , const String& winePrefix
+#endif
+                       ) noexcept
+    {
+        const CarlaMutexLocker cml(getPoolMutex());
+        CarlaPluginBridgePool* const pool(getPool());
+        CARLA_SAFE_ASSERT_RETURN(pool != nullptr,);
 
-                if (options.wine.rtPrio)
-                {
-                    carla_setenv("STAGING_SHARED_MEMORY", "1");
-                    carla_setenv("WINE_RT_POLICY", "FF");
+        const uint poolSize(engine->getOptions().bridgePoolSize);
+        const String optionsKey(getBridgeProcessOptionsKey(engine->getOptions()));
+        const uint32_t bufferSize(engine->getBufferSize());
+        const double sampleRate(engine->getSampleRate());
+        uint count = 0;
 
-                    std::snprintf(strBuf, STR_MAX, "%i", options.wine.baseRtPrio);
-                    carla_setenv("STAGING_RT_PRIORITY_BASE", strBuf);
-                    carla_setenv("WINE_RT", strBuf);
-                    carla_setenv("WINE_RT_PRIO", strBuf);
+        for (LinkedList<Process*>::Itenerator it = pool->fProcesses.begin2(); it.valid(); it.next())
+        {
+            Process* const proc(it.getValue(nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(proc != nullptr);
 
-                    std::snprintf(strBuf, STR_MAX, "%i", options.wine.serverRtPrio);
-                    carla_setenv("STAGING_RT_PRIORITY_SERVER", strBuf);
-                    carla_setenv("WINE_SVR_RT", strBuf);
+            if (proc->binary != binary)
+                continue;
+#ifndef CARLA_OS_WIN
+            if (proc->winePrefix != winePrefix)
+                continue;
+#endif
 
-                    carla_stdout("Using WINEPREFIX '%s', with base RT prio %i and server RT prio %i",
-                                fWinePrefix.toRawUTF8(), options.wine.baseRtPrio, options.wine.serverRtPrio);
-                }
-                else
-                {
-                    carla_unsetenv("STAGING_SHARED_MEMORY");
-                    carla_unsetenv("WINE_RT_POLICY");
-                    carla_unsetenv("STAGING_RT_PRIORITY_BASE");
-                    carla_unsetenv("STAGING_RT_PRIORITY_SERVER");
-                    carla_unsetenv("WINE_RT");
-                    carla_unsetenv("WINE_RT_PRIO");
-                    carla_unsetenv("WINE_SVR_RT");
-
-                    carla_stdout("Using WINEPREFIX '%s', without RT priorities", fWinePrefix.toRawUTF8());
-                }
+            if (count < poolSize && proc->matches(binary,
+#ifndef CARLA_OS_WIN
+                                                  winePrefix,
+#endif
+                                                  optionsKey, bufferSize, sampleRate))
+            {
+                ++count;
+                continue;
             }
+
+            pool->fProcesses.remove(it);
+            proc->requestQuit();
+            delete proc;
+        }
+
+        for (; count < poolSize; ++count)
+        {
+            Process* const proc(startProcess(engine, binary,
+#ifndef CARLA_OS_WIN
+                                             winePrefix,
 #endif
+                                             bufferSize, sampleRate, kBridgeProcessPooled));
 
-            carla_stdout("Starting plugin bridge, command is:\n%s \"%s\" \"%s\" \"%s\" " P_INT64,
-                         fBinary.toRawUTF8(), getPluginTypeAsString(kPlugin->getType()), filename.toRawUTF8(), fLabel.toRawUTF8(), kPlugin->getUniqueId());
+            if (proc == nullptr)
+                break;
 
-            started = fProcess->start(arguments);
+            pool->fProcesses.append(proc);
         }
+    }
 
-        if (! started)
+    /*
+     * Starts a new bridge without a plugin, attached to new shared memory and set up for the given engine setup.
+     * Also used for the group leaders of CarlaPluginBridgeGroup.
+     */
+    static Process* startProcess(CarlaEngine* const engine,
+                                 const String& binary,
+#ifndef CARLA_OS_WIN
+                                 const String& winePrefix,
+#endif
+                                 const uint32_t bufferSize, const double sampleRate,
+                                 const BridgeProcessMode mode) noexcept
+    {
+        CarlaScopedPointer<Process> proc(new Process());
+
+        if (! proc->shmAudioPool.initializeServer())
         {
-            carla_stdout("failed!");
-            fProcess = nullptr;
-            return;
+            carla_stderr("CarlaPluginBridgePool - failed to initialize shared memory audio pool");
+            return nullptr;
         }
 
-        for (; fProcess->isRunning() && ! shouldThreadExit();)
-            carla_sleep(1);
-
-        // we only get here if bridge crashed or thread asked to exit
-        if (fProcess->isRunning() && shouldThreadExit())
+        if (! proc->shmRtClientControl.initializeServer())
         {
-            fProcess->waitForProcessToFinish(2000);
+            carla_stderr("CarlaPluginBridgePool - failed to initialize RT client control");
+            return nullptr;
+        }
 
-            if (fProcess->isRunning())
-            {
-                carla_stdout("CarlaPluginBridgeThread::run() - bridge refused to close, force kill now");
-                fProcess->kill();
-            }
-            else
-            {
-                carla_stdout("CarlaPluginBridgeThread::run() - bridge auto-closed successfully");
-            }
+        if (! proc->shmNonRtClientControl.initializeServer())
+        {
+            carla_stderr("CarlaPluginBridgePool - failed to initialize Non-RT client control");
+            return nullptr;
         }
-        else
+
+        if (! proc->shmNonRtServerControl.initializeServer())
         {
-            // forced quit, may have crashed
-            if (fProcess->getExitCode() != 0 /*|| fProcess->exitStatus() == QProcess::CrashExit*/)
-            {
-                carla_stderr("CarlaPluginBridgeThread::run() - bridge crashed");
+            carla_stderr("CarlaPluginBridgePool - failed to initialize Non-RT server control");
+            return nullptr;
+        }
 
-                CarlaString errorString("Plugin '" + CarlaString(kPlugin->getName()) + "' has crashed!\n"
-                                        "Saving now will lose its current settings.\n"
-                                        "Please remove this plugin, and not rely on it from this point.");
-                kEngine->callback(true, true,
-                                  CarlaBackend::ENGINE_CALLBACK_ERROR, kPlugin->getId(), 0, 0, 0, 0.0f, errorString);
-            }
+        proc->binary = binary;
+#ifndef CARLA_OS_WIN
+        proc->winePrefix = winePrefix;
+#endif
+        proc->optionsKey = getBridgeProcessOptionsKey(engine->getOptions());
+        proc->bufferSize = bufferSize;
+        proc->sampleRate = sampleRate;
+
+        writeBridgeInitialSetup(proc->shmNonRtClientControl, bufferSize, sampleRate);
+
+        // testing dummy message, there is no audio pool until a plugin is loaded
+        proc->shmRtClientControl.writeOpcode(kPluginBridgeRtClientNull);
+        proc->shmRtClientControl.commitWrite();
+
+        char shmIdsStr[6*4+1];
+        getBridgeShmIds(shmIdsStr,
+                        proc->shmAudioPool, proc->shmRtClientControl,
+                        proc->shmNonRtClientControl, proc->shmNonRtServerControl);
+
+        proc->process = new ChildProcess();
+
+        if (! startBridgeProcess(*proc->process, engine, binary,
+#ifndef CARLA_OS_WIN
+                                 winePrefix,
+#endif
+                                 shmIdsStr, PLUGIN_NONE, String(), String(), 0, mode))
+        {
+            carla_stderr("CarlaPluginBridgePool - failed to start idle bridge");
+            proc->process = nullptr;
+            return nullptr;
         }
 
-        fProcess = nullptr;
+        return proc.release();
     }
 
 private:
-    CarlaEngine* const kEngine;
-    CarlaPlugin* const kPlugin;
+    CarlaPluginBridgePool() noexcept
+        : fProcesses(),
+          fNumClients(0) {}
 
-    String fBinary;
-    String fLabel;
-    String fShmIds;
+    ~CarlaPluginBridgePool() noexcept
+    {
+        // ask all bridges to close first, so they do so in parallel
+        for (LinkedList<Process*>::Itenerator it = fProcesses.begin2(); it.valid(); it.next())
+        {
+            Process* const proc(it.getValue(nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(proc != nullptr);
+
+            proc->requestQuit();
+        }
+
+        for (LinkedList<Process*>::Itenerator it = fProcesses.begin2(); it.valid(); it.next())
+        {
+            Process* const proc(it.getValue(nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(proc != nullptr);
+
+            delete proc;
+        }
+
+        fProcesses.clear();
+    }
+
+    static CarlaMutex& getPoolMutex() noexcept
+    {
+        static CarlaMutex mutex;
+        return mutex;
+    }
+
+    static CarlaPluginBridgePool*& getPool() noexcept
+    {
+        static CarlaPluginBridgePool* pool = nullptr;
+        return pool;
+    }
+
+    LinkedList<Process*> fProcesses;
+    uint fNumClients;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaPluginBridgePool)
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Bridge processes shared by several plugins
+
+/*
+ * Runs several bridged plugins of the same bridge binary in a single process.
+ * Each plugin keeps its own shared memory and protocol, and is hosted in an engine of its own inside the bridge.
+ * Instead of waking up one RT thread per plugin, the host wakes up the one of the group leader,
+ * which then runs all plugins with a pending request in one go.
+ * A crash in any of the plugins takes down the whole group.
+ * See ENGINE_OPTION_PLUGIN_BRIDGE_GROUP_SIZE.
+ */
+class CarlaPluginBridgeGroup
+{
+public:
+    /*
+     * Joins a running group for the given binary that still has room for more plugins, or starts a new one.
+     * Returns null if a new group could not be started.
+     */
+    static CarlaPluginBridgeGroup* join(CarlaEngine* const engine,
+                                        const String& binary
 #ifndef CARLA_OS_WIN
-    String fWinePrefix;
+                                      , const String& winePrefix
 #endif
+                                        ) noexcept
+    {
+        const CarlaMutexLocker cml(getGroupsMutex());
+        LinkedList<CarlaPluginBridgeGroup*>& groups(getGroups());
 
-    CarlaScopedPointer<ChildProcess> fProcess;
+        const uint groupSize(engine->getOptions().bridgeGroupSize);
+        const String optionsKey(getBridgeProcessOptionsKey(engine->getOptions()));
 
-    CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaPluginBridgeThread)
+        for (LinkedList<CarlaPluginBridgeGroup*>::Itenerator it = groups.begin2(); it.valid(); it.next())
+        {
+            CarlaPluginBridgeGroup* const group(it.getValue(nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(group != nullptr);
+
+            if (group->fNumMembers >= groupSize)
+                continue;
+            if (group->fProcess->binary != binary)
+                continue;
+#ifndef CARLA_OS_WIN
+            if (group->fProcess->winePrefix != winePrefix)
+                continue;
+#endif
+            if (group->fProcess->optionsKey != optionsKey)
+                continue;
+            if (! group->isRunning())
+                continue;
+
+            ++group->fNumMembers;
+            return group;
+        }
+
+        CarlaPluginBridgePool::Process* const proc(CarlaPluginBridgePool::startProcess(engine, binary,
+#ifndef CARLA_OS_WIN
+                                                                                       winePrefix,
+#endif
+                                                                                       engine->getBufferSize(),
+                                                                                       engine->getSampleRate(),
+                                                                                       kBridgeProcessGroup));
+
+        if (proc == nullptr)
+            return nullptr;
+
+        CarlaPluginBridgeGroup* const group(new CarlaPluginBridgeGroup(proc));
+        groups.append(group);
+        return group;
+    }
+
+    /*
+     * Leaves a group, closing it if this was the last member.
+     */
+    static void leave(CarlaPluginBridgeGroup* const group) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(group != nullptr,);
+
+        const CarlaMutexLocker cml(getGroupsMutex());
+
+        if (--group->fNumMembers != 0)
+            return;
+
+        getGroups().removeOne(group);
+        delete group;
+    }
+
+    /*
+     * Asks the group to host a new plugin, its shared memory must be set up already.
+     * The plugin is loaded afterwards with kPluginBridgeNonRtClientLoadPlugin on its own channel.
+     */
+    void addMember(const char* const shmIds) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(shmIds != nullptr && std::strlen(shmIds) == 6*4,);
+
+        BridgeNonRtClientControl& shmNonRtClientControl(fProcess->shmNonRtClientControl);
+        const CarlaMutexLocker _cml(shmNonRtClientControl.mutex);
+
+        shmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientAddGroupMember);
+        shmNonRtClientControl.writeUInt(6*4);
+        shmNonRtClientControl.writeCustomData(shmIds, 6*4);
+        shmNonRtClientControl.commitWrite();
+    }
+
+    bool isRunning() const noexcept
+    {
+        return fProcess->process != nullptr && fProcess->process->isRunning();
+    }
+
+    ChildProcess* getProcess() const noexcept
+    {
+        return fProcess->process.get();
+    }
+
+    // the RT control used to wake up the group, see BridgeRtClientControl::setGroup()
+    BridgeRtClientData* getRtClientData() const noexcept
+    {
+        return fProcess->shmRtClientControl.data;
+    }
+
+private:
+    CarlaPluginBridgeGroup(CarlaPluginBridgePool::Process* const proc) noexcept
+        : fProcess(proc),
+          fNumMembers(1) {}
+
+    ~CarlaPluginBridgeGroup() noexcept
+    {
+        fProcess->requestQuit();
+    }
+
+    static CarlaMutex& getGroupsMutex() noexcept
+    {
+        static CarlaMutex mutex;
+        return mutex;
+    }
+
+    static LinkedList<CarlaPluginBridgeGroup*>& getGroups() noexcept
+    {
+        static LinkedList<CarlaPluginBridgeGroup*> groups;
+        return groups;
+    }
+
+    const CarlaScopedPointer<CarlaPluginBridgePool::Process> fProcess;
+    uint fNumMembers;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaPluginBridgeGroup)
 };
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -382,7 +1050,6 @@ public:
         : CarlaPlugin(engine, id),
           fBinaryType(btype),
           fPluginType(ptype),
-          fBridgeVersion(6), // before kPluginBridgeNonRtServerVersion was a thing, API was at 6
           fInitiated(false),
           fInitError(false),
           fSaved(true),
@@ -390,9 +1057,23 @@ public:
           fTimedError(false),
           fBufferSize(engine->getBufferSize()),
           fProcWaitTime(0),
+          fProcPipelined(engine->getOptions().pipelinedBridges),
+          fProcPending(false),
+          fProcStartOnly(false),
+          fProcStarted(false),
+          fMidiBlockSize(static_cast<uint>(sizeof(BridgeMidiBlockHeader)
+                                           + kMaxEngineEventInternalCount * kBridgeMidiBlockBytesPerEvent)),
+          fMidiBlockIn(new uint8_t[fMidiBlockSize]),
+          fPipelinedMidiBlockOut(new uint8_t[fMidiBlockSize]),
+          fUsesBridgePool(false),
+          fBridgeGroup(nullptr),
+          fRtPrioOverride(-1),
+          fCpuAffinityOverride(),
           fBridgeBinary(),
           fBridgeThread(engine, this),
           fShmAudioPool(),
+          fShmChunkPool(),
+          fShmSaveChunkPool(),
           fShmRtClientControl(),
           fShmNonRtClientControl(),
           fShmNonRtServerControl(),
@@ -403,11 +1084,15 @@ public:
           fInfo(),
           fUniqueId(0),
           fLatency(0),
+          fReceivingParamNames(false),
           fParams(nullptr)
     {
         carla_debug("CarlaPluginBridge::CarlaPluginBridge(%p, %i, %s, %s)", engine, id, BinaryType2Str(btype), PluginType2Str(ptype));
 
         pData->hints |= PLUGIN_IS_BRIDGE;
+
+        carla_zeroBytes(fMidiBlockIn, fMidiBlockSize);
+        carla_zeroBytes(fPipelinedMidiBlockOut, fMidiBlockSize);
     }
 
     ~CarlaPluginBridge() override
@@ -432,7 +1117,7 @@ public:
             pData->active = false;
         }
 
-        if (fBridgeThread.isThreadRunning())
+        if (fBridgeThread.isThreadRunning() || (fBridgeGroup != nullptr && fBridgeGroup->isRunning()))
         {
             fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientQuit);
             fShmNonRtClientControl.commitWrite();
@@ -449,8 +1134,23 @@ public:
         fShmNonRtServerControl.clear();
         fShmNonRtClientControl.clear();
         fShmRtClientControl.clear();
+        fShmSaveChunkPool.clear();
+        fShmChunkPool.clear();
         fShmAudioPool.clear();
 
+        delete[] fMidiBlockIn;
+        delete[] fPipelinedMidiBlockOut;
+        fMidiBlockIn = fPipelinedMidiBlockOut = nullptr;
+
+        if (fUsesBridgePool)
+            CarlaPluginBridgePool::removeClient();
+
+        if (fBridgeGroup != nullptr)
+        {
+            CarlaPluginBridgeGroup::leave(fBridgeGroup);
+            fBridgeGroup = nullptr;
+        }
+
         clearBuffers();
 
         fInfo.chunk.clear();
@@ -481,7 +1181,8 @@ public:
 
     uint32_t getLatencyInFrames() const noexcept override
     {
-        return fLatency;
+        // pipelined bridges deliver their output one period later
+        return fProcPipelined ? fLatency + fBufferSize : fLatency;
     }
 
     // -------------------------------------------------------------------
@@ -560,6 +1261,15 @@ public:
     {
         CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count, false);
 
+        if (! fParams[parameterId].hasNames)
+            const_cast<CarlaPluginBridge*>(this)->requestParameterNames(parameterId);
+
+        if (! fParams[parameterId].hasNames)
+        {
+            std::snprintf(strBuf, STR_MAX, "Param %u", parameterId+1);
+            return true;
+        }
+
         std::strncpy(strBuf, fParams[parameterId].name.buffer(), STR_MAX);
         return true;
     }
@@ -583,7 +1293,7 @@ public:
         if (waitForParameterText())
             return true;
 
-        std::snprintf(strBuf, STR_MAX, "%.12g", static_cast<double>(fParams[parameterId].value));
+        std::snprintf(strBuf, STR_MAX, "%s", CarlaFloatString(fParams[parameterId].value).buffer);
         return false;
     }
 
@@ -591,6 +1301,9 @@ public:
     {
         CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count, false);
 
+        if (! fParams[parameterId].hasNames)
+            const_cast<CarlaPluginBridge*>(this)->requestParameterNames(parameterId);
+
         std::strncpy(strBuf, fParams[parameterId].symbol.buffer(), STR_MAX);
         return true;
     }
@@ -599,6 +1312,9 @@ public:
     {
         CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count, false);
 
+        if (! fParams[parameterId].hasNames)
+            const_cast<CarlaPluginBridge*>(this)->requestParameterNames(parameterId);
+
         std::strncpy(strBuf, fParams[parameterId].unit.buffer(), STR_MAX);
         return true;
     }
@@ -629,51 +1345,179 @@ public:
 
         for (; Time::getMillisecondCounter() < timeoutEnd && fBridgeThread.isThreadRunning();)
         {
-            if (fReceivingParamText.wasDataReceived(&success))
-                return success;
+            if (fReceivingParamText.wasDataReceived(&success))
+                return success;
+
+            if (needsEngineIdle)
+                pData->engine->idle();
+
+            carla_msleep(5);
+        }
+
+        if (! fBridgeThread.isThreadRunning())
+        {
+            carla_stderr("CarlaPluginBridge::waitForParameterText() - Bridge is not running");
+            return false;
+        }
+
+        carla_stderr("CarlaPluginBridge::waitForParameterText() - Timeout while requesting text");
+        return false;
+    }
+
+    // parameter names are not sent during init since API 15, get the block containing this parameter
+    void requestParameterNames(const uint32_t parameterId) noexcept
+    {
+        // already waiting, possibly called again while running engine idle below
+        if (fReceivingParamNames)
+            return;
+
+        const uint32_t first = parameterId - parameterId % kParameterNamesBlockSize;
+        const uint32_t count = std::min(kParameterNamesBlockSize, pData->param.count - first);
+
+        const CarlaScopedValueSetter<bool> svs(fReceivingParamNames, true, false);
+
+        {
+            const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
+
+            fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientGetParameterNames);
+            fShmNonRtClientControl.writeUInt(first);
+            fShmNonRtClientControl.writeUInt(count);
+            fShmNonRtClientControl.commitWrite();
+        }
+
+        const uint32_t timeoutEnd = Time::getMillisecondCounter() + 500; // 500 ms
+        const bool needsEngineIdle = pData->engine->getType() != kEngineTypePlugin;
+
+        for (; Time::getMillisecondCounter() < timeoutEnd && fBridgeThread.isThreadRunning();)
+        {
+            if (fParams[parameterId].hasNames)
+                return;
+
+            if (needsEngineIdle)
+                pData->engine->idle();
+
+            carla_msleep(5);
+        }
+
+        carla_stderr("CarlaPluginBridge::requestParameterNames(%u) - Timeout while requesting names", parameterId);
+
+        // do not ask again for this block, names received late will still be used
+        for (uint32_t i=first; i < first+count; ++i)
+        {
+            if (fParams[i].hasNames)
+                continue;
+
+            char strBuf[STR_MAX+1];
+            std::snprintf(strBuf, STR_MAX, "Param %u", i+1);
+            strBuf[STR_MAX] = '\0';
+
+            fParams[i].name     = strBuf;
+            fParams[i].hasNames = true;
+        }
+    }
+
+    void waitForSaved()
+    {
+        if (fSaved)
+            return;
+
+        // TODO: only wait 1 minute for NI plugins
+        const uint32_t timeoutEnd = Time::getMillisecondCounter() + 60*1000; // 60 secs, 1 minute
+        const bool needsEngineIdle = pData->engine->getType() != kEngineTypePlugin;
+
+        for (; Time::getMillisecondCounter() < timeoutEnd && fBridgeThread.isThreadRunning();)
+        {
+            pData->engine->callback(true, true, ENGINE_CALLBACK_IDLE, 0, 0, 0, 0, 0.0f, nullptr);
+
+            if (needsEngineIdle)
+                pData->engine->idle();
+
+            if (fSaved)
+                break;
+
+            carla_msleep(20);
+        }
+
+        if (! fBridgeThread.isThreadRunning())
+            return carla_stderr("CarlaPluginBridge::waitForSaved() - Bridge is not running");
+        if (! fSaved)
+            return carla_stderr("CarlaPluginBridge::waitForSaved() - Timeout while requesting save state");
+    }
+
+    // bridges from API 8 get chunks through a shared memory pool, older ones through a base64 temporary file.
+    // the file is also used while the bridge has not released the previous chunk yet
+    void sendChunkData(const void* const data, const std::size_t dataSize)
+    {
+        if (growChunkPool(fShmChunkPool, dataSize) && fShmChunkPool.acquire())
+        {
+            std::memcpy(fShmChunkPool.data, data, dataSize);
+
+            const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
+
+            writeChunkPoolOpcode(dataSize);
+            fShmNonRtClientControl.commitWrite();
+            return;
+        }
+
+        CarlaString dataBase64(CarlaString::asBase64(data, dataSize));
+        CARLA_SAFE_ASSERT_RETURN(dataBase64.length() > 0,);
+
+        String filePath(File::getSpecialLocation(File::tempDirectory).getFullPathName());
+
+        filePath += CARLA_OS_SEP_STR ".CarlaChunk_";
+        filePath += fShmAudioPool.getFilenameSuffix();
+
+        if (File(filePath).replaceWithText(dataBase64.buffer()))
+        {
+            const uint32_t ulength(static_cast<uint32_t>(filePath.length()));
 
-            if (needsEngineIdle)
-                pData->engine->idle();
+            const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
 
-            carla_msleep(5);
+            fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientSetChunkDataFile);
+            fShmNonRtClientControl.writeUInt(ulength);
+            fShmNonRtClientControl.writeCustomData(filePath.toRawUTF8(), ulength);
+            fShmNonRtClientControl.commitWrite();
         }
+    }
 
-        if (! fBridgeThread.isThreadRunning())
+    bool growChunkPool(BridgeChunkPool& pool, const std::size_t dataSize)
+    {
+        if (pool.filename.isEmpty() && ! pool.initializeServer())
         {
-            carla_stderr("CarlaPluginBridge::waitForParameterText() - Bridge is not running");
+            carla_stderr("Failed to initialize shared memory chunk pool");
             return false;
         }
 
-        carla_stderr("CarlaPluginBridge::waitForParameterText() - Timeout while requesting text");
-        return false;
+        return pool.grow(dataSize);
     }
 
-    void waitForSaved()
+    // must be called with the non-rt client control mutex locked
+    void writeChunkPoolOpcode(const std::size_t dataSize)
     {
-        if (fSaved)
-            return;
-
-        // TODO: only wait 1 minute for NI plugins
-        const uint32_t timeoutEnd = Time::getMillisecondCounter() + 60*1000; // 60 secs, 1 minute
-        const bool needsEngineIdle = pData->engine->getType() != kEngineTypePlugin;
+        const char* const suffix = fShmChunkPool.getFilenameSuffix();
+        CARLA_SAFE_ASSERT_RETURN(suffix != nullptr,);
 
-        for (; Time::getMillisecondCounter() < timeoutEnd && fBridgeThread.isThreadRunning();)
-        {
-            pData->engine->callback(true, true, ENGINE_CALLBACK_IDLE, 0, 0, 0, 0, 0.0f, nullptr);
+        const uint32_t ulength(static_cast<uint32_t>(std::strlen(suffix)));
 
-            if (needsEngineIdle)
-                pData->engine->idle();
+        fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientSetChunkDataShm);
+        fShmNonRtClientControl.writeUInt(ulength);
+        fShmNonRtClientControl.writeCustomData(suffix, ulength);
+        fShmNonRtClientControl.writeULong(static_cast<uint64_t>(fShmChunkPool.dataSize));
+        fShmNonRtClientControl.writeULong(static_cast<uint64_t>(dataSize));
+    }
 
-            if (fSaved)
-                break;
+    // must be called with the non-rt client control mutex locked
+    void writeSaveChunkPoolOpcode()
+    {
+        const char* const suffix = fShmSaveChunkPool.getFilenameSuffix();
+        CARLA_SAFE_ASSERT_RETURN(suffix != nullptr,);
 
-            carla_msleep(20);
-        }
+        const uint32_t ulength(static_cast<uint32_t>(std::strlen(suffix)));
 
-        if (! fBridgeThread.isThreadRunning())
-            return carla_stderr("CarlaPluginBridge::waitForSaved() - Bridge is not running");
-        if (! fSaved)
-            return carla_stderr("CarlaPluginBridge::waitForSaved() - Timeout while requesting save state");
+        fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientSetSaveChunkDataShm);
+        fShmNonRtClientControl.writeUInt(ulength);
+        fShmNonRtClientControl.writeCustomData(suffix, ulength);
+        fShmNonRtClientControl.writeULong(static_cast<uint64_t>(fShmSaveChunkPool.dataSize));
     }
 
     // -------------------------------------------------------------------
@@ -795,8 +1639,6 @@ public:
         CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count,);
         CARLA_SAFE_ASSERT_RETURN(sendOsc || sendCallback,);
 
-        // kPluginBridgeNonRtClientSetParameterMappedRange was added in API 7
-        if (fBridgeVersion >= 7)
         {
             const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
 
@@ -879,7 +1721,20 @@ public:
         CARLA_SAFE_ASSERT_RETURN(value != nullptr,);
 
         if (std::strcmp(type, CUSTOM_DATA_TYPE_PROPERTY) == 0)
+        {
+            if (std::strcmp(key, "CarlaRtPriority") == 0)
+            {
+                fRtPrioOverride = value[0] != '\0' ? carla_fixedValue(0, 99, std::atoi(value)) : -1;
+                sendThreadPolicy();
+            }
+            else if (std::strcmp(key, "CarlaCpuAffinity") == 0)
+            {
+                fCpuAffinityOverride = value;
+                sendThreadPolicy();
+            }
+
             return CarlaPlugin::setCustomData(type, key, value, sendGui);
+        }
 
         if (std::strcmp(type, CUSTOM_DATA_TYPE_STRING) == 0 && std::strcmp(key, "__CarlaPingOnOff__") == 0)
         {
@@ -923,25 +1778,7 @@ public:
         CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
         CARLA_SAFE_ASSERT_RETURN(dataSize > 0,);
 
-        CarlaString dataBase64(CarlaString::asBase64(data, dataSize));
-        CARLA_SAFE_ASSERT_RETURN(dataBase64.length() > 0,);
-
-        String filePath(File::getSpecialLocation(File::tempDirectory).getFullPathName());
-
-        filePath += CARLA_OS_SEP_STR ".CarlaChunk_";
-        filePath += fShmAudioPool.getFilenameSuffix();
-
-        if (File(filePath).replaceWithText(dataBase64.buffer()))
-        {
-            const uint32_t ulength(static_cast<uint32_t>(filePath.length()));
-
-            const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
-
-            fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientSetChunkDataFile);
-            fShmNonRtClientControl.writeUInt(ulength);
-            fShmNonRtClientControl.writeCustomData(filePath.toRawUTF8(), ulength);
-            fShmNonRtClientControl.commitWrite();
-        }
+        sendChunkData(data, dataSize);
 
         // save data internally as well
         fInfo.chunk.resize(dataSize);
@@ -1274,10 +2111,14 @@ public:
                  float** const cvOut,
                  const uint32_t frames) override
     {
+        // set when startProcess() already went through the event input and started the client
+        const bool wasStarted = fProcStarted;
+        fProcStarted = false;
+
         // --------------------------------------------------------------------------------------------------------
         // Check if active
 
-        if (fTimedOut || fTimedError || ! pData->active)
+        if (fTimedOut || fTimedError || ! pData->active || (wasStarted && ! fProcPending))
         {
             // disable any output sound
             for (uint32_t i=0; i < pData->audioOut.count; ++i)
@@ -1300,35 +2141,25 @@ public:
         // --------------------------------------------------------------------------------------------------------
         // Event Input
 
-        if (pData->event.portIn != nullptr)
+        if (pData->event.portIn != nullptr && ! wasStarted)
         {
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                for (RtLinkedList<ExternalMidiNote>::Itenerator it = pData->extNotes.data.begin2(); it.valid(); it.next())
+                ExternalMidiNote note = { 0, 0, 0, 0 };
+
+                while (pData->extNotes.getNextRT(note, frames))
                 {
-                    const ExternalMidiNote& note(it.getValue(kExternalMidiNoteFallback));
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
-                    uint8_t data1, data2, data3;
-                    data1 = uint8_t((note.velo > 0 ? MIDI_STATUS_NOTE_ON : MIDI_STATUS_NOTE_OFF) | (note.channel & MIDI_CHANNEL_BIT));
-                    data2 = note.note;
-                    data3 = note.velo;
-
-                    fShmRtClientControl.writeOpcode(kPluginBridgeRtClientMidiEvent);
-                    fShmRtClientControl.writeUInt(0); // time
-                    fShmRtClientControl.writeByte(0); // port
-                    fShmRtClientControl.writeByte(3); // size
-                    fShmRtClientControl.writeByte(data1);
-                    fShmRtClientControl.writeByte(data2);
-                    fShmRtClientControl.writeByte(data3);
-                    fShmRtClientControl.commitWrite();
-                }
+                    uint8_t data[3];
+                    data[0] = uint8_t((note.velo > 0 ? MIDI_STATUS_NOTE_ON : MIDI_STATUS_NOTE_OFF) | (note.channel & MIDI_CHANNEL_BIT));
+                    data[1] = note.note;
+                    data[2] = note.velo;
 
-                pData->extNotes.data.clear();
-                pData->extNotes.mutex.unlock();
+                    writeMidiEventRT(note.time, 0, 3, data);
+                }
 
             } // End of MIDI Input (External)
 
@@ -1423,8 +2254,15 @@ public:
                         }
 #endif
                         // Control plugin parameters
-                        for (uint32_t k=0; k < pData->param.count; ++k)
+                        const uint32_t* mappedParams = nullptr;
+                        uint32_t numMappedParams = 0;
+                        const bool useControlMap = pData->param.getMappedParameters(event.channel, ctrlEvent.param,
+                                                                                    mappedParams, numMappedParams);
+
+                        for (uint32_t m=0, end = useControlMap ? numMappedParams : pData->param.count; m < end; ++m)
                         {
+                            const uint32_t k = useControlMap ? mappedParams[m] : m;
+
                             if (pData->param.data[k].midiChannel != event.channel)
                                 continue;
                             if (pData->param.data[k].mappedControlIndex != ctrlEvent.param)
@@ -1446,13 +2284,12 @@ public:
 
                         if ((pData->options & PLUGIN_OPTION_SEND_CONTROL_CHANGES) != 0 && ctrlEvent.param < MAX_MIDI_VALUE)
                         {
-                            fShmRtClientControl.writeOpcode(kPluginBridgeRtClientMidiEvent);
-                            fShmRtClientControl.writeUInt(event.time);
-                            fShmRtClientControl.writeByte(0); // port
-                            fShmRtClientControl.writeByte(3); // size
-                            fShmRtClientControl.writeByte(uint8_t(MIDI_STATUS_CONTROL_CHANGE | (event.channel & MIDI_CHANNEL_BIT)));
-                            fShmRtClientControl.writeByte(uint8_t(ctrlEvent.param));
-                            fShmRtClientControl.writeByte(uint8_t(ctrlEvent.normalizedValue*127.0f));
+                            const uint8_t data[3] = {
+                                uint8_t(MIDI_STATUS_CONTROL_CHANGE | (event.channel & MIDI_CHANNEL_BIT)),
+                                uint8_t(ctrlEvent.param),
+                                uint8_t(ctrlEvent.normalizedValue*127.0f)
+                            };
+                            writeMidiEventRT(event.time, 0, 3, data);
                         }
                         break;
                     }
@@ -1469,23 +2306,11 @@ public:
                         else if ((pData->options & PLUGIN_OPTION_SEND_PROGRAM_CHANGES) != 0)
                         {
                             // VST2's that use banks usually require both a MSB bank message and a LSB bank message. The MSB bank message can just be 0
-                            fShmRtClientControl.writeOpcode(kPluginBridgeRtClientMidiEvent);
-                            fShmRtClientControl.writeUInt(event.time);
-                            fShmRtClientControl.writeByte(0); // port
-                            fShmRtClientControl.writeByte(3); // size
-                            fShmRtClientControl.writeByte(uint8_t(MIDI_STATUS_CONTROL_CHANGE | (event.channel & MIDI_CHANNEL_BIT)));
-                            fShmRtClientControl.writeByte(MIDI_CONTROL_BANK_SELECT);
-                            fShmRtClientControl.writeByte(0);
-                            fShmRtClientControl.commitWrite();
-
-                            fShmRtClientControl.writeOpcode(kPluginBridgeRtClientMidiEvent);
-                            fShmRtClientControl.writeUInt(event.time);
-                            fShmRtClientControl.writeByte(0); // port
-                            fShmRtClientControl.writeByte(3); // size
-                            fShmRtClientControl.writeByte(uint8_t(MIDI_STATUS_CONTROL_CHANGE | (event.channel & MIDI_CHANNEL_BIT)));
-                            fShmRtClientControl.writeByte(MIDI_CONTROL_BANK_SELECT__LSB);
-                            fShmRtClientControl.writeByte(uint8_t(event.ctrl.param));
-                            fShmRtClientControl.commitWrite();
+                            const uint8_t status = uint8_t(MIDI_STATUS_CONTROL_CHANGE | (event.channel & MIDI_CHANNEL_BIT));
+                            const uint8_t dataMSB[3] = { status, MIDI_CONTROL_BANK_SELECT, 0 };
+                            const uint8_t dataLSB[3] = { status, MIDI_CONTROL_BANK_SELECT__LSB, uint8_t(event.ctrl.param) };
+                            writeMidiEventRT(event.time, 0, 3, dataMSB);
+                            writeMidiEventRT(event.time, 0, 3, dataLSB);
                         }
                         break;
 
@@ -1556,17 +2381,11 @@ public:
                     if (status == MIDI_STATUS_NOTE_ON && midiData[2] == 0)
                         status = MIDI_STATUS_NOTE_OFF;
 
-                    fShmRtClientControl.writeOpcode(kPluginBridgeRtClientMidiEvent);
-                    fShmRtClientControl.writeUInt(event.time);
-                    fShmRtClientControl.writeByte(midiEvent.port);
-                    fShmRtClientControl.writeByte(midiEvent.size);
-
-                    fShmRtClientControl.writeByte(uint8_t(midiData[0] | (event.channel & MIDI_CHANNEL_BIT)));
+                    uint8_t data[MAX_MIDI_VALUE];
+                    data[0] = uint8_t(midiData[0] | (event.channel & MIDI_CHANNEL_BIT));
+                    std::memcpy(data+1, midiData+1, midiEvent.size-1U);
 
-                    for (uint8_t j=1; j < midiEvent.size; ++j)
-                        fShmRtClientControl.writeByte(midiData[j]);
-
-                    fShmRtClientControl.commitWrite();
+                    writeMidiEventRT(event.time, midiEvent.port, midiEvent.size, data);
 
                     if (status == MIDI_STATUS_NOTE_ON)
                     {
@@ -1589,13 +2408,15 @@ public:
                 }
             }
 
-            pData->postRtEvents.trySplice();
-
         } // End of Event Input
 
         if (! processSingle(audioIn, audioOut, cvIn, cvOut, frames))
             return;
 
+        // output is only ready on the next process() call
+        if (fProcStartOnly)
+            return;
+
         // --------------------------------------------------------------------------------------------------------
         // Control and MIDI Output
 
@@ -1620,37 +2441,27 @@ public:
                 }
             }
 
-            uint32_t time;
-            uint8_t port, size;
-            const uint8_t* midiData(fShmRtClientControl.data->midiOut);
-
-            for (std::size_t read=0; read<kBridgeRtClientDataMidiOutSize-kBridgeBaseMidiOutHeaderSize;)
-            {
-                // get time
-                time = *(const uint32_t*)midiData;
-                midiData += 4;
-
-                // get port and size
-                port = *midiData++;
-                size = *midiData++;
+            const uint8_t* const block(fProcPipelined ? fPipelinedMidiBlockOut : getShmMidiBlock(false));
+            const BridgeMidiBlockHeader* const header = (const BridgeMidiBlockHeader*)block;
+            CARLA_SAFE_ASSERT_RETURN(header->size <= fMidiBlockSize - sizeof(BridgeMidiBlockHeader),);
 
-                if (size == 0)
-                    break;
+            const uint8_t* midiData = block + sizeof(BridgeMidiBlockHeader);
+            const uint8_t* const midiDataEnd = midiData + header->size;
 
-                // store midi data advancing as needed
-                uint8_t data[size];
+            uint32_t time;
+            uint8_t size;
 
-                for (uint8_t j=0; j<size; ++j)
-                    data[j] = *midiData++;
+            for (uint32_t i=0; i < header->count && midiData + kBridgeBaseMidiOutHeaderSize <= midiDataEnd; ++i)
+            {
+                std::memcpy(&time, midiData, sizeof(uint32_t));
+                size = midiData[5];
+                midiData += kBridgeBaseMidiOutHeaderSize;
 
-                pData->event.portOut->writeMidiEvent(time, size, data);
+                CARLA_SAFE_ASSERT_BREAK(size != 0 && midiData + size <= midiDataEnd);
 
-                read += kBridgeBaseMidiOutHeaderSize + size;
+                pData->event.portOut->writeMidiEvent(time, size, midiData);
+                midiData += size;
             }
-
-            // TODO
-            (void)port;
-
         } // End of Control and MIDI Output
     }
 
@@ -1678,6 +2489,22 @@ public:
             CARLA_SAFE_ASSERT_RETURN(cvOut != nullptr, false);
         }
 
+        // --------------------------------------------------------------------------------------------------------
+        // Finish block started by startProcess(), lock is still held
+
+        if (fProcPending && ! fProcPipelined)
+        {
+            waitForPendingProcess();
+
+            if (fTimedOut)
+            {
+                pData->singleMutex.unlock();
+                return false;
+            }
+
+            return processSingleOutput(audioIn, audioOut, cvOut, frames);
+        }
+
         // --------------------------------------------------------------------------------------------------------
         // Try lock, silence otherwise
 
@@ -1698,12 +2525,66 @@ public:
         }
 
         // --------------------------------------------------------------------------------------------------------
-        // Reset audio buffers
+        // Collect previous cycle (pipelined mode)
+
+        if (fProcPipelined)
+        {
+            const bool wasPending = fProcPending;
+
+            waitForPendingProcess();
+
+            if (fTimedOut)
+            {
+                for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                    carla_zeroFloats(audioOut[i], frames);
+                for (uint32_t i=0; i < pData->cvOut.count; ++i)
+                    carla_zeroFloats(cvOut[i], frames);
+                pData->singleMutex.unlock();
+                return false;
+            }
+
+            // inputs go first, as the host may process in-place
+            for (uint32_t i=0; i < pData->audioIn.count; ++i)
+                carla_copyFloats(fShmAudioPool.data + (i * fBufferSize), audioIn[i], frames);
+            for (uint32_t i=0; i < pData->cvIn.count; ++i)
+                carla_copyFloats(fShmAudioPool.data + ((pData->audioIn.count + pData->audioOut.count + i) * fBufferSize), cvIn[i], frames);
+
+            if (wasPending)
+            {
+                for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                    carla_copyFloats(audioOut[i], fShmAudioPool.data + ((pData->audioIn.count + i) * fBufferSize), frames);
+                for (uint32_t i=0; i < pData->cvOut.count; ++i)
+                    carla_copyFloats(cvOut[i], fShmAudioPool.data + ((pData->audioIn.count + pData->audioOut.count + pData->cvIn.count + i) * fBufferSize), frames);
+
+                const uint8_t* const shmBlockOut = getShmMidiBlock(false);
+                std::memcpy(fPipelinedMidiBlockOut, shmBlockOut,
+                            sizeof(BridgeMidiBlockHeader) + ((const BridgeMidiBlockHeader*)shmBlockOut)->size);
+            }
+            else
+            {
+                for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                    carla_zeroFloats(audioOut[i], frames);
+                for (uint32_t i=0; i < pData->cvOut.count; ++i)
+                    carla_zeroFloats(cvOut[i], frames);
+
+                carla_zeroStruct(*(BridgeMidiBlockHeader*)fPipelinedMidiBlockOut);
+            }
+        }
+        else
+        {
+            // ----------------------------------------------------------------------------------------------------
+            // Reset audio buffers (skipping those the host already wrote in place)
+
+            for (uint32_t i=0; i < pData->audioIn.count; ++i)
+            {
+                float* const shmIn = fShmAudioPool.data + (i * fBufferSize);
 
-        for (uint32_t i=0; i < pData->audioIn.count; ++i)
-            carla_copyFloats(fShmAudioPool.data + (i * fBufferSize), audioIn[i], frames);
-        for (uint32_t i=0; i < pData->cvIn.count; ++i)
-            carla_copyFloats(fShmAudioPool.data + ((pData->audioIn.count + pData->audioOut.count + i) * fBufferSize), cvIn[i], frames);
+                if (audioIn[i] != shmIn)
+                    carla_copyFloats(shmIn, audioIn[i], frames);
+            }
+            for (uint32_t i=0; i < pData->cvIn.count; ++i)
+                carla_copyFloats(fShmAudioPool.data + ((pData->audioIn.count + pData->audioOut.count + i) * fBufferSize), cvIn[i], frames);
+        }
 
         // --------------------------------------------------------------------------------------------------------
         // TimeInfo
@@ -1730,6 +2611,19 @@ public:
             bridgeTimeInfo.barStartTick   = timeInfo.bbt.barStartTick;
         }
 
+        // --------------------------------------------------------------------------------------------------------
+        // MIDI Input, all events at once
+
+        {
+            BridgeMidiBlockHeader* const header = (BridgeMidiBlockHeader*)fMidiBlockIn;
+
+            std::memcpy(getShmMidiBlock(true), fMidiBlockIn, sizeof(BridgeMidiBlockHeader) + header->size);
+            carla_zeroStruct(*header);
+
+            // the client only writes to the output block when it processes
+            carla_zeroStruct(*(BridgeMidiBlockHeader*)getShmMidiBlock(false));
+        }
+
         // --------------------------------------------------------------------------------------------------------
         // Run plugin
 
@@ -1739,124 +2633,57 @@ public:
             fShmRtClientControl.commitWrite();
         }
 
-        waitForClient("process", fProcWaitTime);
-
-        if (fTimedOut)
+        if (fProcPipelined || fProcStartOnly)
         {
-            pData->singleMutex.unlock();
-            return false;
+            // outputs are collected on the next process() call
+            fShmRtClientControl.startClient();
+            fProcPending = true;
+
+            if (fProcStartOnly)
+                return true;
         }
+        else
+        {
+            waitForClient("process", fProcWaitTime, pData->engine->getOptions().bridgeSpinTime);
 
-        for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            carla_copyFloats(audioOut[i], fShmAudioPool.data + ((pData->audioIn.count + i) * fBufferSize), frames);
-        for (uint32_t i=0; i < pData->cvOut.count; ++i)
-            carla_copyFloats(cvOut[i], fShmAudioPool.data + ((pData->audioIn.count + pData->audioOut.count + pData->cvIn.count + i) * fBufferSize), frames);
+            if (fTimedOut)
+            {
+                pData->singleMutex.unlock();
+                return false;
+            }
+        }
 
-#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-        // --------------------------------------------------------------------------------------------------------
-        // Post-processing (dry/wet, volume and balance)
+        return processSingleOutput(audioIn, audioOut, cvOut, frames);
+    }
 
+    // copy back the bridge output and run post-processing, unlocks singleMutex
+    bool processSingleOutput(const float* const* const audioIn, float** const audioOut,
+                             float** const cvOut, const uint32_t frames)
+    {
+        if (! fProcPipelined)
         {
-            const bool doVolume  = (pData->hints & PLUGIN_CAN_VOLUME) != 0 && carla_isNotEqual(pData->postProc.volume, 1.0f);
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-            const bool isMono    = (pData->audioIn.count == 1);
-
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
-
             for (uint32_t i=0; i < pData->audioOut.count; ++i)
             {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    const uint32_t c = isMono ? 0 : i;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-# ifndef BUILD_BRIDGE
-                        if (k < pData->latency.frames && pData->latency.buffers != nullptr)
-                            bufValue = pData->latency.buffers[c][k];
-                        else if (pData->latency.frames < frames)
-                            bufValue = audioIn[c][k-pData->latency.frames];
-                        else
-# endif
-                            bufValue = audioIn[c][k];
-
-                        audioOut[i][k] = (audioOut[i][k] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
-
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
-
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        carla_copyFloats(oldBufLeft, audioOut[i], frames);
-                    }
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
+                const float* const shmOut = fShmAudioPool.data + ((pData->audioIn.count + i) * fBufferSize);
 
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            audioOut[i][k]  = oldBufLeft[k]     * (1.0f - balRangeL);
-                            audioOut[i][k] += audioOut[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            audioOut[i][k]  = audioOut[i][k] * balRangeR;
-                            audioOut[i][k] += oldBufLeft[k]   * balRangeL;
-                        }
-                    }
-                }
-
-                // Volume (and buffer copy)
-                if (doVolume)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        audioOut[i][k] *= pData->postProc.volume;
-                }
+                if (audioOut[i] != shmOut)
+                    carla_copyFloats(audioOut[i], shmOut, frames);
             }
+            for (uint32_t i=0; i < pData->cvOut.count; ++i)
+                carla_copyFloats(cvOut[i], fShmAudioPool.data + ((pData->audioIn.count + pData->audioOut.count + pData->cvIn.count + i) * fBufferSize), frames);
+        }
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+        // --------------------------------------------------------------------------------------------------------
+        // Post-processing (dry/wet, volume and balance)
 
-        } // End of Post-processing
+        pData->processPostProc(audioIn, 0, true, audioOut, audioOut, 0, frames);
 
 # ifndef BUILD_BRIDGE
         // --------------------------------------------------------------------------------------------------------
         // Save latency values for next callback
 
-        if (pData->latency.frames != 0 && pData->latency.buffers != nullptr)
-        {
-            const uint32_t latframes = pData->latency.frames;
-
-            if (latframes <= frames)
-            {
-                for (uint32_t i=0; i < pData->audioIn.count; ++i)
-                    carla_copyFloats(pData->latency.buffers[i], audioIn[i]+(frames-latframes), latframes);
-            }
-            else
-            {
-                const uint32_t diff = latframes - frames;
-
-                for (uint32_t i=0, k; i<pData->audioIn.count; ++i)
-                {
-                    // push back buffer by 'frames'
-                    for (k=0; k < diff; ++k)
-                        pData->latency.buffers[i][k] = pData->latency.buffers[i][k+frames];
-
-                    // put current input at the end
-                    for (uint32_t j=0; k < latframes; ++j, ++k)
-                        pData->latency.buffers[i][k] = audioIn[i][j];
-                }
-            }
-        }
+        pData->latency.saveInputs(audioIn, pData->audioIn.count, frames);
 # endif
 #endif // BUILD_BRIDGE_ALTERNATIVE_ARCH
 
@@ -1866,11 +2693,55 @@ public:
         return true;
     }
 
+    float* getSharedAudioBuffer(const bool isInput, const uint32_t index) const noexcept override
+    {
+        // in pipelined mode the client keeps using the pool while the host runs
+        if (fProcPipelined || fShmAudioPool.data == nullptr)
+            return nullptr;
+
+        if (isInput)
+        {
+            CARLA_SAFE_ASSERT_RETURN(index < pData->audioIn.count, nullptr);
+            return fShmAudioPool.data + (index * fBufferSize);
+        }
+
+        CARLA_SAFE_ASSERT_RETURN(index < pData->audioOut.count, nullptr);
+        return fShmAudioPool.data + ((pData->audioIn.count + index) * fBufferSize);
+    }
+
+    bool canStartProcess() const noexcept override
+    {
+        // pipelined bridges never wait inside process()
+        return ! fProcPipelined;
+    }
+
+    void startProcess(const float* const* const audioIn,
+                      float** const audioOut,
+                      const float* const* const cvIn,
+                      float** const cvOut,
+                      const uint32_t frames) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(! fProcPipelined,);
+        CARLA_SAFE_ASSERT_RETURN(! fProcStarted,);
+
+        fProcStartOnly = true;
+        process(audioIn, audioOut, cvIn, cvOut, frames);
+        fProcStartOnly = false;
+        fProcStarted = true;
+    }
+
     void bufferSizeChanged(const uint32_t newBufferSize) override
     {
+        waitForPendingProcess();
+
         fBufferSize = newBufferSize;
         resizeAudioPool(newBufferSize);
 
+#ifndef BUILD_BRIDGE
+        if (fProcPipelined && fInitiated)
+            pData->latency.recreateBuffers(std::max(fInfo.aIns, fInfo.aOuts), getLatencyInFrames());
+#endif
+
         {
             fShmRtClientControl.writeOpcode(kPluginBridgeRtClientSetBufferSize);
             fShmRtClientControl.writeUInt(newBufferSize);
@@ -1885,6 +2756,8 @@ public:
 
     void sampleRateChanged(const double newSampleRate) override
     {
+        waitForPendingProcess();
+
         {
             fShmRtClientControl.writeOpcode(kPluginBridgeRtClientSetSampleRate);
             fShmRtClientControl.writeDouble(newSampleRate);
@@ -1899,6 +2772,8 @@ public:
 
     void offlineModeChanged(const bool isOffline) override
     {
+        waitForPendingProcess();
+
         {
             fShmRtClientControl.writeOpcode(kPluginBridgeRtClientSetOnline);
             fShmRtClientControl.writeBool(isOffline);
@@ -2023,9 +2898,11 @@ public:
             case kPluginBridgeNonRtServerPong:
                 break;
 
-            case kPluginBridgeNonRtServerVersion:
-                fBridgeVersion = fShmNonRtServerControl.readUInt();
-                break;
+            case kPluginBridgeNonRtServerVersion: {
+                const uint32_t apiVersion = fShmNonRtServerControl.readUInt();
+                CARLA_SAFE_ASSERT_UINT2(apiVersion >= CARLA_PLUGIN_BRIDGE_API_VERSION_MINIMUM,
+                                        apiVersion, CARLA_PLUGIN_BRIDGE_API_VERSION_MINIMUM);
+            }   break;
 
             case kPluginBridgeNonRtServerPluginInfo1: {
                 // uint/category, uint/hints, uint/optionsAvailable, uint/optionsEnabled, long/uniqueId
@@ -2209,6 +3086,7 @@ public:
                     pData->param.data[index].rindex = rindex;
                     pData->param.data[index].hints  = hints;
                     pData->param.data[index].mappedControlIndex = ctrl;
+                    pData->param.controlMappingChanged();
                 }
             }   break;
 
@@ -2236,37 +3114,199 @@ public:
 
                 CARLA_SAFE_ASSERT_INT2(index < pData->param.count, index, pData->param.count);
 
-                if (index < pData->param.count)
-                {
+                if (index < pData->param.count)
+                {
+                    fParams[index].name   = name;
+                    fParams[index].symbol = symbol;
+                    fParams[index].unit   = unit;
+                    fParams[index].hasNames = true;
+                }
+            }   break;
+
+            case kPluginBridgeNonRtServerParameterRanges: {
+                // uint/index, float/def, float/min, float/max, float/step, float/stepSmall, float/stepLarge
+                const uint32_t index = fShmNonRtServerControl.readUInt();
+                const float def      = fShmNonRtServerControl.readFloat();
+                const float min      = fShmNonRtServerControl.readFloat();
+                const float max      = fShmNonRtServerControl.readFloat();
+                const float step      = fShmNonRtServerControl.readFloat();
+                const float stepSmall = fShmNonRtServerControl.readFloat();
+                const float stepLarge = fShmNonRtServerControl.readFloat();
+
+                CARLA_SAFE_ASSERT_BREAK(min < max);
+                CARLA_SAFE_ASSERT_BREAK(def >= min);
+                CARLA_SAFE_ASSERT_BREAK(def <= max);
+                CARLA_SAFE_ASSERT_INT2(index < pData->param.count, index, pData->param.count);
+
+                if (index < pData->param.count)
+                {
+                    pData->param.ranges[index].def = def;
+                    pData->param.ranges[index].min = min;
+                    pData->param.ranges[index].max = max;
+                    pData->param.ranges[index].step      = step;
+                    pData->param.ranges[index].stepSmall = stepSmall;
+                    pData->param.ranges[index].stepLarge = stepLarge;
+                }
+            }   break;
+
+            case kPluginBridgeNonRtServerParameterInfo: {
+                // uint/count, then for each parameter:
+                // uint/index, int/rindex, uint/type, uint/hints, short/cc,
+                // uint/size, str[] (name), uint/size, str[] (symbol), uint/size, str[] (unit),
+                // float/def, float/min, float/max, float/step, float/stepSmall, float/stepLarge, float/value
+                const uint32_t count = fShmNonRtServerControl.readUInt();
+
+                for (uint32_t i=0; i<count; ++i)
+                {
+                    const uint32_t index  = fShmNonRtServerControl.readUInt();
+                    const  int32_t rindex = fShmNonRtServerControl.readInt();
+                    const uint32_t type   = fShmNonRtServerControl.readUInt();
+                    const uint32_t hints  = fShmNonRtServerControl.readUInt();
+                    const  int16_t ctrl   = fShmNonRtServerControl.readShort();
+
+                    const uint32_t nameSize(fShmNonRtServerControl.readUInt());
+                    char name[nameSize+1];
+                    carla_zeroChars(name, nameSize+1);
+                    fShmNonRtServerControl.readCustomData(name, nameSize);
+
+                    const uint32_t symbolSize(fShmNonRtServerControl.readUInt());
+                    char symbol[symbolSize+1];
+                    carla_zeroChars(symbol, symbolSize+1);
+                    fShmNonRtServerControl.readCustomData(symbol, symbolSize);
+
+                    const uint32_t unitSize(fShmNonRtServerControl.readUInt());
+                    char unit[unitSize+1];
+                    carla_zeroChars(unit, unitSize+1);
+                    fShmNonRtServerControl.readCustomData(unit, unitSize);
+
+                    const float def       = fShmNonRtServerControl.readFloat();
+                    const float min       = fShmNonRtServerControl.readFloat();
+                    const float max       = fShmNonRtServerControl.readFloat();
+                    const float step      = fShmNonRtServerControl.readFloat();
+                    const float stepSmall = fShmNonRtServerControl.readFloat();
+                    const float stepLarge = fShmNonRtServerControl.readFloat();
+                    const float value     = fShmNonRtServerControl.readFloat();
+
+                    // keep reading the remaining entries even if this one is invalid
+                    CARLA_SAFE_ASSERT_INT2(index < pData->param.count, index, pData->param.count);
+                    if (index >= pData->param.count)
+                        continue;
+
+                    CARLA_SAFE_ASSERT_CONTINUE(ctrl >= CONTROL_INDEX_NONE && ctrl <= CONTROL_INDEX_MAX_ALLOWED);
+
+                    pData->param.data[index].type   = static_cast<ParameterType>(type);
+                    pData->param.data[index].index  = static_cast<int32_t>(index);
+                    pData->param.data[index].rindex = rindex;
+                    pData->param.data[index].hints  = hints;
+                    pData->param.data[index].mappedControlIndex = ctrl;
+                    pData->param.controlMappingChanged();
+
                     fParams[index].name   = name;
                     fParams[index].symbol = symbol;
                     fParams[index].unit   = unit;
+                    fParams[index].hasNames = true;
+
+                    CARLA_SAFE_ASSERT_CONTINUE(min < max);
+                    CARLA_SAFE_ASSERT_CONTINUE(def >= min);
+                    CARLA_SAFE_ASSERT_CONTINUE(def <= max);
+
+                    pData->param.ranges[index].def = def;
+                    pData->param.ranges[index].min = min;
+                    pData->param.ranges[index].max = max;
+                    pData->param.ranges[index].step      = step;
+                    pData->param.ranges[index].stepSmall = stepSmall;
+                    pData->param.ranges[index].stepLarge = stepLarge;
+
+                    fParams[index].value = pData->param.getFixedValue(index, value);
                 }
             }   break;
 
-            case kPluginBridgeNonRtServerParameterRanges: {
-                // uint/index, float/def, float/min, float/max, float/step, float/stepSmall, float/stepLarge
-                const uint32_t index = fShmNonRtServerControl.readUInt();
-                const float def      = fShmNonRtServerControl.readFloat();
-                const float min      = fShmNonRtServerControl.readFloat();
-                const float max      = fShmNonRtServerControl.readFloat();
-                const float step      = fShmNonRtServerControl.readFloat();
-                const float stepSmall = fShmNonRtServerControl.readFloat();
-                const float stepLarge = fShmNonRtServerControl.readFloat();
-
-                CARLA_SAFE_ASSERT_BREAK(min < max);
-                CARLA_SAFE_ASSERT_BREAK(def >= min);
-                CARLA_SAFE_ASSERT_BREAK(def <= max);
-                CARLA_SAFE_ASSERT_INT2(index < pData->param.count, index, pData->param.count);
+            case kPluginBridgeNonRtServerParameterInfo2: {
+                // uint/count, then for each parameter:
+                // uint/index, int/rindex, uint/type, uint/hints, short/cc,
+                // float/def, float/min, float/max, float/step, float/stepSmall, float/stepLarge, float/value
+                const uint32_t count = fShmNonRtServerControl.readUInt();
 
-                if (index < pData->param.count)
+                for (uint32_t i=0; i<count; ++i)
                 {
+                    const uint32_t index  = fShmNonRtServerControl.readUInt();
+                    const  int32_t rindex = fShmNonRtServerControl.readInt();
+                    const uint32_t type   = fShmNonRtServerControl.readUInt();
+                    const uint32_t hints  = fShmNonRtServerControl.readUInt();
+                    const  int16_t ctrl   = fShmNonRtServerControl.readShort();
+
+                    const float def       = fShmNonRtServerControl.readFloat();
+                    const float min       = fShmNonRtServerControl.readFloat();
+                    const float max       = fShmNonRtServerControl.readFloat();
+                    const float step      = fShmNonRtServerControl.readFloat();
+                    const float stepSmall = fShmNonRtServerControl.readFloat();
+                    const float stepLarge = fShmNonRtServerControl.readFloat();
+                    const float value     = fShmNonRtServerControl.readFloat();
+
+                    // keep reading the remaining entries even if this one is invalid
+                    CARLA_SAFE_ASSERT_INT2(index < pData->param.count, index, pData->param.count);
+                    if (index >= pData->param.count)
+                        continue;
+
+                    CARLA_SAFE_ASSERT_CONTINUE(ctrl >= CONTROL_INDEX_NONE && ctrl <= CONTROL_INDEX_MAX_ALLOWED);
+
+                    pData->param.data[index].type   = static_cast<ParameterType>(type);
+                    pData->param.data[index].index  = static_cast<int32_t>(index);
+                    pData->param.data[index].rindex = rindex;
+                    pData->param.data[index].hints  = hints;
+                    pData->param.data[index].mappedControlIndex = ctrl;
+                    pData->param.controlMappingChanged();
+
+                    // requested later, see requestParameterNames()
+                    fParams[index].hasNames = false;
+
+                    CARLA_SAFE_ASSERT_CONTINUE(min < max);
+                    CARLA_SAFE_ASSERT_CONTINUE(def >= min);
+                    CARLA_SAFE_ASSERT_CONTINUE(def <= max);
+
                     pData->param.ranges[index].def = def;
                     pData->param.ranges[index].min = min;
                     pData->param.ranges[index].max = max;
                     pData->param.ranges[index].step      = step;
                     pData->param.ranges[index].stepSmall = stepSmall;
                     pData->param.ranges[index].stepLarge = stepLarge;
+
+                    fParams[index].value = pData->param.getFixedValue(index, value);
+                }
+            }   break;
+
+            case kPluginBridgeNonRtServerParameterNames: {
+                // uint/count, then for each parameter:
+                // uint/index, uint/size, str[] (name), uint/size, str[] (symbol), uint/size, str[] (unit)
+                const uint32_t count = fShmNonRtServerControl.readUInt();
+
+                for (uint32_t i=0; i<count; ++i)
+                {
+                    const uint32_t index = fShmNonRtServerControl.readUInt();
+
+                    const uint32_t nameSize(fShmNonRtServerControl.readUInt());
+                    char name[nameSize+1];
+                    carla_zeroChars(name, nameSize+1);
+                    fShmNonRtServerControl.readCustomData(name, nameSize);
+
+                    const uint32_t symbolSize(fShmNonRtServerControl.readUInt());
+                    char symbol[symbolSize+1];
+                    carla_zeroChars(symbol, symbolSize+1);
+                    fShmNonRtServerControl.readCustomData(symbol, symbolSize);
+
+                    const uint32_t unitSize(fShmNonRtServerControl.readUInt());
+                    char unit[unitSize+1];
+                    carla_zeroChars(unit, unitSize+1);
+                    fShmNonRtServerControl.readCustomData(unit, unitSize);
+
+                    CARLA_SAFE_ASSERT_INT2(index < pData->param.count, index, pData->param.count);
+                    if (index >= pData->param.count)
+                        continue;
+
+                    fParams[index].name   = name;
+                    fParams[index].symbol = symbol;
+                    fParams[index].unit   = unit;
+                    fParams[index].hasNames = true;
                 }
             }   break;
 
@@ -2441,12 +3481,52 @@ public:
                 chunkFile.deleteFile();
             }   break;
 
+            case kPluginBridgeNonRtServerSetChunkDataShm: {
+                // ulong/dataSize
+                const uint64_t dataSize(fShmNonRtServerControl.readULong());
+                CARLA_SAFE_ASSERT_BREAK(fShmSaveChunkPool.data != nullptr);
+
+                if (dataSize > 0 && dataSize <= fShmSaveChunkPool.dataSize)
+                {
+                    fInfo.chunk.resize(static_cast<std::size_t>(dataSize));
+#ifdef CARLA_PROPER_CPP11_SUPPORT
+                    std::memcpy(fInfo.chunk.data(), fShmSaveChunkPool.data, static_cast<std::size_t>(dataSize));
+#else
+                    std::memcpy(&fInfo.chunk.front(), fShmSaveChunkPool.data, static_cast<std::size_t>(dataSize));
+#endif
+                }
+                else
+                {
+                    carla_stderr2("CarlaPluginBridge: invalid save chunk size " P_UINT64, dataSize);
+                }
+
+                // always hand the pool back, or the bridge falls back to files for good
+                fShmSaveChunkPool.release();
+            }   break;
+
+            case kPluginBridgeNonRtServerResizeChunkDataShm: {
+                // ulong/dataSize
+                const uint64_t dataSize(fShmNonRtServerControl.readULong());
+                CARLA_SAFE_ASSERT_BREAK(dataSize > 0);
+
+                // the bridge saves again once told about the new size, or falls back to a file if it still does not fit
+                const bool grown = growChunkPool(fShmSaveChunkPool, static_cast<std::size_t>(dataSize));
+
+                const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
+
+                if (grown)
+                    writeSaveChunkPoolOpcode();
+
+                fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientPrepareForSave);
+                fShmNonRtClientControl.commitWrite();
+            }   break;
+
             case kPluginBridgeNonRtServerSetLatency:
                 // uint
                 fLatency = fShmNonRtServerControl.readUInt();
 #ifndef BUILD_BRIDGE
                 if (! fInitiated)
-                    pData->latency.recreateBuffers(std::max(fInfo.aIns, fInfo.aOuts), fLatency);
+                    pData->latency.recreateBuffers(std::max(fInfo.aIns, fInfo.aOuts), getLatencyInFrames());
 #endif
                 break;
 
@@ -2557,39 +3637,6 @@ public:
 
         std::srand(static_cast<uint>(std::time(nullptr)));
 
-        // ---------------------------------------------------------------
-        // init sem/shm
-
-        if (! fShmAudioPool.initializeServer())
-        {
-            carla_stderr("Failed to initialize shared memory audio pool");
-            return false;
-        }
-
-        if (! fShmRtClientControl.initializeServer())
-        {
-            carla_stderr("Failed to initialize RT client control");
-            fShmAudioPool.clear();
-            return false;
-        }
-
-        if (! fShmNonRtClientControl.initializeServer())
-        {
-            carla_stderr("Failed to initialize Non-RT client control");
-            fShmRtClientControl.clear();
-            fShmAudioPool.clear();
-            return false;
-        }
-
-        if (! fShmNonRtServerControl.initializeServer())
-        {
-            carla_stderr("Failed to initialize Non-RT server control");
-            fShmNonRtClientControl.clear();
-            fShmRtClientControl.clear();
-            fShmAudioPool.clear();
-            return false;
-        }
-
 #ifndef CARLA_OS_WIN
         // ---------------------------------------------------------------
         // set wine prefix
@@ -2615,27 +3662,103 @@ public:
         }
 #endif
 
+        // ---------------------------------------------------------------
+        // join a shared bridge process, if enabled
+
+        if (pData->engine->getOptions().bridgeGroupSize > 1)
+        {
+            fBridgeGroup = CarlaPluginBridgeGroup::join(pData->engine, String(fBridgeBinary.buffer())
+#ifndef CARLA_OS_WIN
+                                                      , fWinePrefix
+#endif
+                                                       );
+
+            if (fBridgeGroup == nullptr)
+                carla_stderr("Failed to start plugin bridge group, using a bridge process of its own");
+        }
+
+        // ---------------------------------------------------------------
+        // take an idle bridge from the pool, if enabled
+
+        CarlaScopedPointer<CarlaPluginBridgePool::Process> pooledProcess;
+
+        if (fBridgeGroup == nullptr && pData->engine->getOptions().bridgePoolSize != 0)
+        {
+            const String binary(fBridgeBinary.buffer());
+
+            if (! fUsesBridgePool)
+            {
+                CarlaPluginBridgePool::addClient();
+                fUsesBridgePool = true;
+            }
+
+            pooledProcess = CarlaPluginBridgePool::take(pData->engine, binary
+#ifndef CARLA_OS_WIN
+                                                      , fWinePrefix
+#endif
+                                                        );
+
+            // start the next ones now, so they get ready while this plugin loads
+            CarlaPluginBridgePool::refill(pData->engine, binary
+#ifndef CARLA_OS_WIN
+                                        , fWinePrefix
+#endif
+                                         );
+        }
+
+        // ---------------------------------------------------------------
+        // init sem/shm
+
+        if (pooledProcess != nullptr)
+        {
+            fShmAudioPool.adopt(pooledProcess->shmAudioPool);
+            fShmRtClientControl.adopt(pooledProcess->shmRtClientControl);
+            fShmNonRtClientControl.adopt(pooledProcess->shmNonRtClientControl);
+            fShmNonRtServerControl.adopt(pooledProcess->shmNonRtServerControl);
+            fBridgeThread.setPooledProcess(pooledProcess->process.release());
+            pooledProcess = nullptr;
+        }
+        else if (! initializeShm())
+        {
+            return false;
+        }
+
         // ---------------------------------------------------------------
         // init bridge thread
 
         {
             char shmIdsStr[6*4+1];
-            carla_zeroChars(shmIdsStr, 6*4+1);
-
-            std::strncpy(shmIdsStr+6*0, &fShmAudioPool.filename[fShmAudioPool.filename.length()-6], 6);
-            std::strncpy(shmIdsStr+6*1, &fShmRtClientControl.filename[fShmRtClientControl.filename.length()-6], 6);
-            std::strncpy(shmIdsStr+6*2, &fShmNonRtClientControl.filename[fShmNonRtClientControl.filename.length()-6], 6);
-            std::strncpy(shmIdsStr+6*3, &fShmNonRtServerControl.filename[fShmNonRtServerControl.filename.length()-6], 6);
+            getBridgeShmIds(shmIdsStr, fShmAudioPool, fShmRtClientControl, fShmNonRtClientControl, fShmNonRtServerControl);
 
             fBridgeThread.setData(
 #ifndef CARLA_OS_WIN
                                   fWinePrefix.toRawUTF8(),
 #endif
                                   bridgeBinary, label, shmIdsStr);
+
+            if (fBridgeGroup != nullptr)
+            {
+                writeBridgeInitialSetup(fShmNonRtClientControl, pData->engine->getBufferSize(), pData->engine->getSampleRate());
+
+                // testing dummy message, there is no audio pool until the plugin is loaded
+                fShmRtClientControl.writeOpcode(kPluginBridgeRtClientNull);
+                fShmRtClientControl.commitWrite();
+
+                fShmRtClientControl.setGroup(fBridgeGroup->getRtClientData());
+                fBridgeThread.setGroupProcess(fBridgeGroup->getProcess());
+                fBridgeGroup->addMember(shmIdsStr);
+            }
         }
 
-        if (! restartBridgeThread())
+        if (fBridgeGroup != nullptr)
+        {
+            if (! loadPluginInPooledBridge(label))
+                return false;
+        }
+        else if (! (fBridgeThread.hasPooledProcess() ? loadPluginInPooledBridge(label) : restartBridgeThread()))
+        {
             return false;
+        }
 
         // ---------------------------------------------------------------
         // register client
@@ -2715,8 +3838,10 @@ public:
                 pData->options |= PLUGIN_OPTION_MAP_PROGRAM_CHANGES;
         }
 
-        // kPluginBridgeNonRtClientSetOptions was added in API 7
-        if (fBridgeVersion >= 7)
+        if (fInfo.optionsAvailable & PLUGIN_OPTION_AUTO_SLEEP)
+            if (options & PLUGIN_OPTION_AUTO_SLEEP)
+                pData->options |= PLUGIN_OPTION_AUTO_SLEEP;
+
         {
             const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
 
@@ -2728,10 +3853,33 @@ public:
         return true;
     }
 
+    // Sends this plugin's realtime priority and CPU affinity, using the engine options where not overridden.
+    // Several plugins in a group bridge share the same thread, the last one sent wins.
+    void sendThreadPolicy()
+    {
+        const EngineOptions& options(pData->engine->getOptions());
+
+        const int rtPrio = fRtPrioOverride >= 0 ? fRtPrioOverride : options.bridgeRtPrio;
+        const char* const cpuList = fCpuAffinityOverride.isNotEmpty()
+                                  ? fCpuAffinityOverride.buffer()
+                                  : (options.bridgeCpuAffinity != nullptr ? options.bridgeCpuAffinity : "");
+        const uint32_t cpuListLen = static_cast<uint32_t>(std::strlen(cpuList));
+
+        const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
+
+        fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientSetThreadPolicy);
+        fShmNonRtClientControl.writeInt(rtPrio);
+        fShmNonRtClientControl.writeUInt(cpuListLen);
+
+        if (cpuListLen != 0)
+            fShmNonRtClientControl.writeCustomData(cpuList, cpuListLen);
+
+        fShmNonRtClientControl.commitWrite();
+    }
+
 private:
     const BinaryType fBinaryType;
     const PluginType fPluginType;
-    uint fBridgeVersion;
 
     bool fInitiated;
     bool fInitError;
@@ -2741,10 +3889,33 @@ private:
     uint fBufferSize;
     uint fProcWaitTime;
 
+    // pipelined mode, see ENGINE_OPTION_PIPELINED_BRIDGES
+    const bool fProcPipelined;
+    bool fProcPending;
+
+    // split processing, see startProcess()
+    bool fProcStartOnly;
+    bool fProcStarted;
+
+    // MIDI blocks in the audio pool, input events are collected here and copied over once per cycle
+    const uint fMidiBlockSize;
+    uint8_t* fMidiBlockIn;
+    uint8_t* fPipelinedMidiBlockOut;
+
+    // see ENGINE_OPTION_PLUGIN_BRIDGE_POOL_SIZE
+    bool fUsesBridgePool;
+    CarlaPluginBridgeGroup* fBridgeGroup;
+
+    // from "CarlaRtPriority" and "CarlaCpuAffinity" properties, -1 and empty for engine defaults
+    int fRtPrioOverride;
+    CarlaString fCpuAffinityOverride;
+
     CarlaString             fBridgeBinary;
     CarlaPluginBridgeThread fBridgeThread;
 
     BridgeAudioPool          fShmAudioPool;
+    BridgeChunkPool          fShmChunkPool;     // to the bridge, setChunkData
+    BridgeChunkPool          fShmSaveChunkPool; // from the bridge, saves
     BridgeRtClientControl    fShmRtClientControl;
     BridgeNonRtClientControl fShmNonRtClientControl;
     BridgeNonRtServerControl fShmNonRtServerControl;
@@ -2907,6 +4078,9 @@ private:
     int64_t  fUniqueId;
     uint32_t fLatency;
 
+    // true while waiting for a block of parameter names, see requestParameterNames()
+    bool fReceivingParamNames;
+
     BridgeParamInfo* fParams;
 
     void handleProcessStopped() noexcept
@@ -2937,37 +4111,151 @@ private:
         }
     }
 
+    // queues a MIDI event for the bridge, the first byte of 'data' must already contain the channel
+    void writeMidiEventRT(const uint32_t time, const uint8_t port, const uint8_t size, const uint8_t* const data) noexcept
+    {
+        writeBridgeMidiBlockEvent(fMidiBlockIn, fMidiBlockSize, time, port, size, data);
+    }
+
+    // MIDI block inside the audio pool, right after the audio and CV buffers
+    uint8_t* getShmMidiBlock(const bool isInput) const noexcept
+    {
+        uint8_t* const block = (uint8_t*)(fShmAudioPool.data
+                                          + (fInfo.aIns + fInfo.aOuts + fInfo.cvIns + fInfo.cvOuts) * fBufferSize);
+        return isInput ? block : block + fMidiBlockSize;
+    }
+
     void resizeAudioPool(const uint32_t bufferSize)
     {
-        fShmAudioPool.resize(bufferSize, fInfo.aIns+fInfo.aOuts, fInfo.cvIns+fInfo.cvOuts);
+        waitForPendingProcess();
+
+        fShmAudioPool.resize(bufferSize, fInfo.aIns+fInfo.aOuts, fInfo.cvIns+fInfo.cvOuts, fMidiBlockSize);
 
         fShmRtClientControl.writeOpcode(kPluginBridgeRtClientSetAudioPool);
         fShmRtClientControl.writeULong(static_cast<uint64_t>(fShmAudioPool.dataSize));
         fShmRtClientControl.commitWrite();
 
+        fShmRtClientControl.writeOpcode(kPluginBridgeRtClientSetMidiBlockSize);
+        fShmRtClientControl.writeUInt(fMidiBlockSize);
+        fShmRtClientControl.commitWrite();
+
         waitForClient("resize-pool", 5000);
     }
 
-    void waitForClient(const char* const action, const uint msecs)
+    void waitForClient(const char* const action, const uint msecs, const uint spinUsecs = 0)
     {
         CARLA_SAFE_ASSERT_RETURN(! fTimedOut,);
         CARLA_SAFE_ASSERT_RETURN(! fTimedError,);
 
-        if (fShmRtClientControl.waitForClient(msecs))
+        waitForPendingProcess();
+
+        if (fTimedOut)
+            return;
+
+        if (fShmRtClientControl.waitForClient(msecs, spinUsecs))
             return;
 
         fTimedOut = true;
         carla_stderr2("waitForClient(%s) timed out", action);
     }
 
+    // collect a process cycle started in pipelined mode, keeping the client semaphore in sync
+    void waitForPendingProcess()
+    {
+        if (! fProcPending)
+            return;
+
+        fProcPending = false;
+
+        if (fTimedOut || fTimedError)
+            return;
+
+        if (fShmRtClientControl.waitForClientToFinish(fProcWaitTime, pData->engine->getOptions().bridgeSpinTime))
+            return;
+
+        fTimedOut = true;
+        carla_stderr2("waitForClient(process) timed out");
+    }
+
+    bool initializeShm()
+    {
+        if (! fShmAudioPool.initializeServer())
+        {
+            carla_stderr("Failed to initialize shared memory audio pool");
+            return false;
+        }
+
+        if (! fShmRtClientControl.initializeServer())
+        {
+            carla_stderr("Failed to initialize RT client control");
+            fShmAudioPool.clear();
+            return false;
+        }
+
+        if (! fShmNonRtClientControl.initializeServer())
+        {
+            carla_stderr("Failed to initialize Non-RT client control");
+            fShmRtClientControl.clear();
+            fShmAudioPool.clear();
+            return false;
+        }
+
+        if (! fShmNonRtServerControl.initializeServer())
+        {
+            carla_stderr("Failed to initialize Non-RT server control");
+            fShmNonRtClientControl.clear();
+            fShmRtClientControl.clear();
+            fShmAudioPool.clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    // the bridge is already running and set up, it only needs to know which plugin to load
+    bool loadPluginInPooledBridge(const char* const label)
+    {
+        const uint32_t filenameSize = static_cast<uint32_t>(std::strlen(pData->filename));
+        const uint32_t labelSize = label != nullptr ? static_cast<uint32_t>(std::strlen(label)) : 0;
+
+        {
+            const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
+
+            fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientLoadPlugin);
+            fShmNonRtClientControl.writeUInt(static_cast<uint32_t>(fPluginType));
+            fShmNonRtClientControl.writeUInt(filenameSize);
+            if (filenameSize != 0)
+                fShmNonRtClientControl.writeCustomData(pData->filename, filenameSize);
+            fShmNonRtClientControl.writeUInt(labelSize);
+            if (labelSize != 0)
+                fShmNonRtClientControl.writeCustomData(label, labelSize);
+            fShmNonRtClientControl.writeLong(fUniqueId);
+            fShmNonRtClientControl.commitWrite();
+        }
+
+        return startBridgeThread();
+    }
+
     bool restartBridgeThread()
     {
+        // a crashed group is not restarted, the plugin gets a bridge process of its own instead
+        if (fBridgeGroup != nullptr)
+        {
+            fShmRtClientControl.setGroup(nullptr);
+            fBridgeThread.setGroupProcess(nullptr);
+            CarlaPluginBridgeGroup::leave(fBridgeGroup);
+            fBridgeGroup = nullptr;
+        }
+
         fInitiated  = false;
         fInitError  = false;
         fTimedError = false;
+        fProcPending = false;
+        fProcStarted = false;
 
         // reset memory
         fShmRtClientControl.data->procFlags = 0;
+        fShmRtClientControl.data->serverPending = 0;
         carla_zeroStruct(fShmRtClientControl.data->timeInfo);
         carla_zeroBytes(fShmRtClientControl.data->midiOut, kBridgeRtClientDataMidiOutSize);
 
@@ -2975,24 +4263,19 @@ private:
         fShmNonRtClientControl.clearData();
         fShmNonRtServerControl.clearData();
 
-        fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientVersion);
-        fShmNonRtClientControl.writeUInt(CARLA_PLUGIN_BRIDGE_API_VERSION_CURRENT);
-
-        fShmNonRtClientControl.writeUInt(static_cast<uint32_t>(sizeof(BridgeRtClientData)));
-        fShmNonRtClientControl.writeUInt(static_cast<uint32_t>(sizeof(BridgeNonRtClientData)));
-        fShmNonRtClientControl.writeUInt(static_cast<uint32_t>(sizeof(BridgeNonRtServerData)));
-
-        fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientInitialSetup);
-        fShmNonRtClientControl.writeUInt(pData->engine->getBufferSize());
-        fShmNonRtClientControl.writeDouble(pData->engine->getSampleRate());
-
-        fShmNonRtClientControl.commitWrite();
+        writeBridgeInitialSetup(fShmNonRtClientControl, pData->engine->getBufferSize(), pData->engine->getSampleRate());
 
         if (fShmAudioPool.dataSize != 0)
         {
             fShmRtClientControl.writeOpcode(kPluginBridgeRtClientSetAudioPool);
             fShmRtClientControl.writeULong(static_cast<uint64_t>(fShmAudioPool.dataSize));
             fShmRtClientControl.commitWrite();
+
+            carla_zeroStruct(*(BridgeMidiBlockHeader*)fMidiBlockIn);
+
+            fShmRtClientControl.writeOpcode(kPluginBridgeRtClientSetMidiBlockSize);
+            fShmRtClientControl.writeUInt(fMidiBlockSize);
+            fShmRtClientControl.commitWrite();
         }
         else
         {
@@ -3001,6 +4284,12 @@ private:
             fShmRtClientControl.commitWrite();
         }
 
+        return startBridgeThread();
+    }
+
+    // starts the bridge thread and waits for the bridge to send the plugin info
+    bool startBridgeThread()
+    {
         fBridgeThread.startThread();
 
         const bool needsEngineIdle = pData->engine->getType() != kEngineTypePlugin;
@@ -3066,25 +4355,7 @@ private:
 #else
             void* data = &fInfo.chunk.front();
 #endif
-            CarlaString dataBase64(CarlaString::asBase64(data, dataSize));
-            CARLA_SAFE_ASSERT_RETURN(dataBase64.length() > 0, true);
-
-            String filePath(File::getSpecialLocation(File::tempDirectory).getFullPathName());
-
-            filePath += CARLA_OS_SEP_STR ".CarlaChunk_";
-            filePath += fShmAudioPool.getFilenameSuffix();
-
-            if (File(filePath).replaceWithText(dataBase64.buffer()))
-            {
-                const uint32_t ulength(static_cast<uint32_t>(filePath.length()));
-
-                const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
-
-                fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientSetChunkDataFile);
-                fShmNonRtClientControl.writeUInt(ulength);
-                fShmNonRtClientControl.writeCustomData(filePath.toRawUTF8(), ulength);
-                fShmNonRtClientControl.commitWrite();
-            }
+            sendChunkData(data, dataSize);
         }
 
         return true;
@@ -0,0 +1,214 @@
+/*
+ * Carla Dormant Plugin
+ * Copyright (C) 2011-2020 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#include "CarlaPluginInternal.hpp"
+#include "CarlaBackendUtils.hpp"
+#include "CarlaEngine.hpp"
+
+#include "water/xml/XmlElement.h"
+
+CARLA_BACKEND_START_NAMESPACE
+
+// -------------------------------------------------------------------------------------------------------------------
+
+/*
+ * Placeholder for a plugin loaded from a project as inactive, see ENGINE_OPTION_DORMANT_INACTIVE_PLUGINS.
+ * Holds nothing but the saved state, the real plugin replaces it when activated.
+ * Stays disabled, so it is never processed.
+ */
+class CarlaPluginDormant : public CarlaPlugin
+{
+public:
+    CarlaPluginDormant(CarlaEngine* const engine, const uint id)
+        : CarlaPlugin(engine, id),
+          fType(PLUGIN_NONE)
+    {
+        carla_debug("CarlaPluginDormant::CarlaPluginDormant(%p, %i)", engine, id);
+    }
+
+    ~CarlaPluginDormant() override
+    {
+        carla_debug("CarlaPluginDormant::~CarlaPluginDormant()");
+    }
+
+    // -------------------------------------------------------------------
+    // Information (base)
+
+    PluginType getType() const noexcept override
+    {
+        return fType;
+    }
+
+    bool isDormant() const noexcept override
+    {
+        return true;
+    }
+
+    int64_t getUniqueId() const noexcept override
+    {
+        return pData->stateSave.uniqueId;
+    }
+
+    // -------------------------------------------------------------------
+    // Information (per-plugin data)
+
+    bool getLabel(char* const strBuf) const noexcept override
+    {
+        if (pData->stateSave.label == nullptr)
+            return CarlaPlugin::getLabel(strBuf);
+
+        std::strncpy(strBuf, pData->stateSave.label, STR_MAX);
+        return true;
+    }
+
+    // -------------------------------------------------------------------
+    // Set data (plugin-specific stuff)
+
+    void setName(const char* const newName) override
+    {
+        CarlaPlugin::setName(newName);
+
+        // keep the saved state in sync, it is what gets saved and restored on wake
+        if (pData->stateSave.name != nullptr)
+            delete[] pData->stateSave.name;
+
+        pData->stateSave.name = carla_strdup(pData->name);
+    }
+
+    // -------------------------------------------------------------------
+    // Plugin state
+
+    void reload() override
+    {
+        CARLA_SAFE_ASSERT_RETURN(pData->engine != nullptr,);
+        carla_debug("CarlaPluginDormant::reload()");
+
+        // nothing to process, no ports
+        pData->clearBuffers();
+    }
+
+    // -------------------------------------------------------------------
+    // Plugin processing
+
+    void process(const float* const* const, float** const,
+                 const float* const*, float**, const uint32_t) override
+    {
+    }
+
+    // -------------------------------------------------------------------
+
+    bool init(const CarlaPluginPtr plugin, const water::XmlElement* const xmlElement, CarlaStateSave& stateSave)
+    {
+        CARLA_SAFE_ASSERT_RETURN(pData->engine != nullptr, false);
+
+        // ---------------------------------------------------------------
+        // first checks
+
+        if (pData->client != nullptr)
+        {
+            pData->engine->setLastError("Plugin client is already registered");
+            return false;
+        }
+
+        if (xmlElement == nullptr || ! pData->stateSave.fillFromXmlElement(xmlElement))
+        {
+            pData->engine->setLastError("Invalid plugin state");
+            return false;
+        }
+
+        // keep what was resolved while preparing the project: binaries found elsewhere and decoded chunks
+        if (stateSave.binary != nullptr)
+        {
+            if (pData->stateSave.binary != nullptr)
+                delete[] pData->stateSave.binary;
+
+            pData->stateSave.binary = carla_strdup(stateSave.binary);
+        }
+
+        pData->stateSave.chunkData.swap(stateSave.chunkData);
+
+        fType = getPluginTypeFromString(pData->stateSave.type);
+
+        if (fType == PLUGIN_NONE)
+        {
+            pData->engine->setLastError("Invalid plugin type");
+            return false;
+        }
+
+        // ---------------------------------------------------------------
+
+        if (pData->stateSave.binary != nullptr)
+            pData->filename = carla_strdup(pData->stateSave.binary);
+
+        if (pData->stateSave.name != nullptr && pData->stateSave.name[0] != '\0')
+            pData->name = pData->engine->getUniquePluginName(pData->stateSave.name);
+        else if (pData->stateSave.label != nullptr && pData->stateSave.label[0] != '\0')
+            pData->name = pData->engine->getUniquePluginName(pData->stateSave.label);
+        else
+            pData->name = pData->engine->getUniquePluginName("(No name)");
+
+        if (pData->stateSave.name == nullptr || std::strcmp(pData->stateSave.name, pData->name) != 0)
+        {
+            if (pData->stateSave.name != nullptr)
+                delete[] pData->stateSave.name;
+
+            pData->stateSave.name = carla_strdup(pData->name);
+        }
+
+        pData->options = pData->stateSave.options;
+
+        // ---------------------------------------------------------------
+        // register client
+
+        pData->client = pData->engine->addClient(plugin);
+
+        if (pData->client == nullptr || ! pData->client->isOk())
+        {
+            pData->engine->setLastError("Failed to register plugin client");
+            return false;
+        }
+
+        return true;
+    }
+
+    // -------------------------------------------------------------------
+
+private:
+    PluginType fType;
+
+    CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaPluginDormant)
+};
+
+// -------------------------------------------------------------------------------------------------------------------
+
+CarlaPluginPtr CarlaPlugin::newDormant(const Initializer& init,
+                                       const water::XmlElement* const xmlElement, CarlaStateSave& stateSave)
+{
+    carla_debug("CarlaPluginDormant::newDormant({%p, \"%s\", \"%s\", \"%s\", " P_INT64 "}, %p)",
+                init.engine, init.filename, init.name, init.label, init.uniqueId, xmlElement);
+
+    std::shared_ptr<CarlaPluginDormant> plugin(new CarlaPluginDormant(init.engine, init.id));
+
+    if (! plugin->init(plugin, xmlElement, stateSave))
+        return nullptr;
+
+    return plugin;
+}
+
+// -------------------------------------------------------------------------------------------------------------------
+
+CARLA_BACKEND_END_NAMESPACE
@@ -21,7 +21,10 @@
 #ifdef HAVE_FLUIDSYNTH
 
 #include "CarlaBackendUtils.hpp"
+#include "CarlaEngineUtils.hpp"
 #include "CarlaMathUtils.hpp"
+#include "CarlaRtLog.hpp"
+#include "CarlaThreadPool.hpp"
 
 #include "water/text/StringArray.h"
 
@@ -34,26 +37,24 @@ using water::StringArray;
 
 CARLA_BACKEND_START_NAMESPACE
 
-// -------------------------------------------------------------------------------------------------------------------
-// Fallback data
-
-static const ExternalMidiNote kExternalMidiNoteFallback = { -1, 0, 0 };
-
 // -------------------------------------------------------------------------------------------------------------------
 
 class CarlaPluginFluidSynth : public CarlaPlugin
 {
 public:
-    CarlaPluginFluidSynth(CarlaEngine* const engine, const uint id, const bool use16Outs)
+    CarlaPluginFluidSynth(CarlaEngine* const engine, const uint id, const bool use16Outs, const uint options)
         : CarlaPlugin(engine, id),
           kUse16Outs(use16Outs),
           fSettings(nullptr),
           fSynth(nullptr),
           fSynthId(0),
           fAudio16Buffers(nullptr),
+          fAudioBufferArena(),
           fLabel(nullptr)
     {
-        carla_debug("CarlaPluginFluidSynth::CarlaPluginFluidSynth(%p, %i, %s)", engine, id,  bool2str(use16Outs));
+        carla_debug("CarlaPluginFluidSynth::CarlaPluginFluidSynth(%p, %i, %s, 0x%x)", engine, id,  bool2str(use16Outs), options);
+
+        pData->midiprog.supportsRT = true;
 
         carla_zeroFloats(fParamBuffers, FluidSynthParametersMax);
         carla_fill<int32_t>(fCurMidiProgs, 0, MAX_MIDI_CHANNELS);
@@ -66,7 +67,9 @@ public:
         fluid_settings_setint(fSettings, "synth.audio-channels", use16Outs ? 16 : 1);
         fluid_settings_setint(fSettings, "synth.audio-groups", use16Outs ? 16 : 1);
         fluid_settings_setnum(fSettings, "synth.sample-rate", pData->engine->getSampleRate());
-        //fluid_settings_setnum(fSettings, "synth.cpu-cores", 2);
+        // voices are split between the cores, regardless of the audio groups, so this works for both output layouts
+        if (isPluginOptionInverseEnabled(options, PLUGIN_OPTION_MULTI_CORE))
+            fluid_settings_setint(fSettings, "synth.cpu-cores", getMultiCoreCount());
         fluid_settings_setint(fSettings, "synth.ladspa.active", 0);
         fluid_settings_setint(fSettings, "synth.lock-memory", 1);
 #if FLUIDSYNTH_VERSION_MAJOR < 2
@@ -194,6 +197,10 @@ public:
         options |= PLUGIN_OPTION_SEND_PITCHBEND;
         options |= PLUGIN_OPTION_SEND_ALL_SOUND_OFF;
         options |= PLUGIN_OPTION_SKIP_SENDING_NOTES;
+        options |= PLUGIN_OPTION_MULTI_CORE;
+
+        if (pData->engine->getProccessMode() == ENGINE_PROCESS_MODE_PATCHBAY)
+            options |= PLUGIN_OPTION_DECOUPLED_BLOCKS;
 
         return options;
     }
@@ -967,7 +974,7 @@ public:
         pData->extraHints  = 0x0;
         pData->extraHints |= PLUGIN_EXTRA_HINT_HAS_MIDI_IN;
 
-        bufferSizeChanged(pData->engine->getBufferSize());
+        bufferSizeChanged(getBufferSize());
         reloadPrograms(true);
 
         if (pData->active)
@@ -1167,11 +1174,11 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                for (RtLinkedList<ExternalMidiNote>::Itenerator it = pData->extNotes.data.begin2(); it.valid(); it.next())
+                ExternalMidiNote note = { 0, 0, 0, 0 };
+
+                while (pData->extNotes.getNextRT(note, frames))
                 {
-                    const ExternalMidiNote& note(it.getValue(kExternalMidiNoteFallback));
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                     if (note.velo > 0)
@@ -1180,9 +1187,6 @@ public:
                         fluid_synth_noteoff(fSynth,note.channel, note.note);
                 }
 
-                pData->extNotes.data.clear();
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -1207,8 +1211,8 @@ public:
 
                 if (eventTime < timeOffset)
                 {
-                    carla_stderr2("Timing error, eventTime:%u < timeOffset:%u for '%s'",
-                                  eventTime, timeOffset, pData->name);
+                    carla_rt_stderr2("Timing error, eventTime:%u < timeOffset:%u for '%s'",
+                                     eventTime, timeOffset, pData->name);
                     eventTime = timeOffset;
                 }
                 else if (eventTime > timeOffset)
@@ -1284,8 +1288,15 @@ public:
                         }
 #endif
                         // Control plugin parameters
-                        for (uint32_t k=0; k < pData->param.count; ++k)
+                        const uint32_t* mappedParams = nullptr;
+                        uint32_t numMappedParams = 0;
+                        const bool useControlMap = pData->param.getMappedParameters(event.channel, ctrlEvent.param,
+                                                                                    mappedParams, numMappedParams);
+
+                        for (uint32_t m=0, end = useControlMap ? numMappedParams : pData->param.count; m < end; ++m)
                         {
+                            const uint32_t k = useControlMap ? mappedParams[m] : m;
+
                             if (pData->param.data[k].midiChannel != event.channel)
                                 continue;
                             if (pData->param.data[k].mappedControlIndex != ctrlEvent.param)
@@ -1453,8 +1464,6 @@ public:
                 } // switch (event.type)
             }
 
-            pData->postRtEvents.trySplice();
-
             if (frames > timeOffset)
                 processSingle(audioOut, frames - timeOffset, timeOffset);
 
@@ -1510,6 +1519,9 @@ public:
             return false;
         }
 
+        // program changes requested by the host while we were running
+        pData->applyDeferredProgramChangesRT(this);
+
         // --------------------------------------------------------------------------------------------------------
         // Fill plugin buffers and Run plugin
 
@@ -1605,12 +1617,10 @@ public:
         if (! kUse16Outs)
             return;
 
+        fAudioBufferArena.reset(pData->audioOut.count, newBufferSize);
+
         for (uint32_t i=0; i < pData->audioOut.count; ++i)
-        {
-            if (fAudio16Buffers[i] != nullptr)
-                delete[] fAudio16Buffers[i];
-            fAudio16Buffers[i] = new float[newBufferSize];
-        }
+            fAudio16Buffers[i] = fAudioBufferArena.allocate();
     }
 
     void sampleRateChanged(const double newSampleRate) override
@@ -1633,19 +1643,12 @@ public:
 
         if (fAudio16Buffers != nullptr)
         {
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                if (fAudio16Buffers[i] != nullptr)
-                {
-                    delete[] fAudio16Buffers[i];
-                    fAudio16Buffers[i] = nullptr;
-                }
-            }
-
             delete[] fAudio16Buffers;
             fAudio16Buffers = nullptr;
         }
 
+        fAudioBufferArena.reset(0, 0);
+
         CarlaPlugin::clearBuffers();
 
         carla_debug("CarlaPluginFluidSynth::clearBuffers() - end");
@@ -1756,11 +1759,21 @@ public:
             pData->options |= PLUGIN_OPTION_MAP_PROGRAM_CHANGES;
         if (isPluginOptionInverseEnabled(options, PLUGIN_OPTION_SKIP_SENDING_NOTES))
             pData->options |= PLUGIN_OPTION_SKIP_SENDING_NOTES;
+        if (isPluginOptionInverseEnabled(options, PLUGIN_OPTION_MULTI_CORE))
+            pData->options |= PLUGIN_OPTION_MULTI_CORE;
 
         return true;
     }
 
 private:
+    static int getMultiCoreCount() noexcept
+    {
+        const uint numCPUs = CarlaThreadPool::getNumCPUs();
+
+        // leave the other half to the audio thread and other plugins
+        return numCPUs > 1 ? static_cast<int>(std::max(2U, numCPUs / 2)) : 1;
+    }
+
     void initializeFluidDefaultsIfNeeded()
     {
         if (sFluidDefaultsStored)
@@ -1860,6 +1873,7 @@ private:
 #endif
 
     float** fAudio16Buffers;
+    EngineAudioBufferArena fAudioBufferArena;
     float   fParamBuffers[FluidSynthParametersMax];
 
     static bool sFluidDefaultsStored;
@@ -1912,7 +1926,7 @@ CarlaPluginPtr CarlaPlugin::newFluidSynth(const Initializer& init, PluginType pt
     }
 #endif
 
-    std::shared_ptr<CarlaPluginFluidSynth> plugin(new CarlaPluginFluidSynth(init.engine, init.id,  use16Outs));
+    std::shared_ptr<CarlaPluginFluidSynth> plugin(new CarlaPluginFluidSynth(init.engine, init.id, use16Outs, init.options));
 
     if (! plugin->init(plugin, init.filename, init.name, init.label, init.options))
         return nullptr;
@@ -79,7 +79,7 @@ void PluginAudioData::initBuffers() const noexcept
 {
     for (uint32_t i=0; i < count; ++i)
     {
-        if (ports[i].port != nullptr)
+        if (ports[i].port != nullptr && ports[i].port->needsBufferInit())
             ports[i].port->initBuffer();
     }
 }
@@ -133,7 +133,7 @@ void PluginCVData::initBuffers() const noexcept
 {
     for (uint32_t i=0; i < count; ++i)
     {
-        if (ports[i].port != nullptr)
+        if (ports[i].port != nullptr && ports[i].port->needsBufferInit())
             ports[i].port->initBuffer();
     }
 }
@@ -191,6 +191,20 @@ void PluginEventData::initBuffers() const noexcept
         portOut->initBuffer();
 }
 
+// -----------------------------------------------------------------------
+// ParameterControlMap
+
+ParameterControlMap::ParameterControlMap(const uint32_t s) noexcept
+    : serial(s),
+      offsets(nullptr),
+      params(nullptr) {}
+
+ParameterControlMap::~ParameterControlMap() noexcept
+{
+    delete[] offsets;
+    delete[] params;
+}
+
 // -----------------------------------------------------------------------
 // PluginParameterData
 
@@ -198,7 +212,12 @@ PluginParameterData::PluginParameterData() noexcept
     : count(0),
       data(nullptr),
       ranges(nullptr),
-      special(nullptr) {}
+      special(nullptr),
+      controlMap(nullptr),
+      controlMapPending(nullptr),
+      controlMapRetired(nullptr),
+      controlMapSerial(0),
+      controlMapBuiltSerial(0) {}
 
 PluginParameterData::~PluginParameterData() noexcept
 {
@@ -206,6 +225,7 @@ PluginParameterData::~PluginParameterData() noexcept
     CARLA_SAFE_ASSERT(data == nullptr);
     CARLA_SAFE_ASSERT(ranges == nullptr);
     CARLA_SAFE_ASSERT(special == nullptr);
+    CARLA_SAFE_ASSERT(controlMap == nullptr);
 }
 
 void PluginParameterData::createNew(const uint32_t newCount, const bool withSpecial)
@@ -238,6 +258,7 @@ void PluginParameterData::createNew(const uint32_t newCount, const bool withSpec
     }
 
     count = newCount;
+    controlMappingChanged();
 }
 
 void PluginParameterData::clear() noexcept
@@ -260,6 +281,12 @@ void PluginParameterData::clear() noexcept
         special = nullptr;
     }
 
+    delete controlMap;
+    delete controlMapPending;
+    delete controlMapRetired;
+    controlMap = controlMapPending = controlMapRetired = nullptr;
+    controlMapBuiltSerial = controlMapSerial;
+
     count = 0;
 }
 
@@ -398,13 +425,113 @@ float PluginParameterData::getFinalValueWithMidiDelta(const uint32_t parameterId
     return value;
 }
 
+static bool isInControlMap(const ParameterData& paramData) noexcept
+{
+    return paramData.mappedControlIndex >= 0
+        && paramData.mappedControlIndex < static_cast<int16_t>(ParameterControlMap::kNumControls)
+        && paramData.midiChannel < MAX_MIDI_CHANNELS;
+}
+
+void PluginParameterData::controlMappingChanged() noexcept
+{
+    __sync_add_and_fetch(&controlMapSerial, 1);
+}
+
+void PluginParameterData::updateControlMap()
+{
+    if (ParameterControlMap* const retired = __sync_lock_test_and_set(&controlMapRetired, nullptr))
+        delete retired;
+
+    // wait for the audio thread to adopt the previous one
+    if (controlMapPending != nullptr || controlMapRetired != nullptr)
+        return;
+
+    const uint32_t serial = controlMapSerial;
+
+    if (serial == controlMapBuiltSerial)
+        return;
+
+    ParameterControlMap* const map = new ParameterControlMap(serial);
+    const uint32_t numSlots = MAX_MIDI_CHANNELS * ParameterControlMap::kNumControls;
+    uint32_t numMapped = 0;
+
+    for (uint32_t i=0; i < count; ++i)
+    {
+        if (isInControlMap(data[i]))
+            ++numMapped;
+    }
+
+    if (numMapped != 0)
+    {
+        map->offsets = new uint32_t[numSlots + 1];
+        map->params  = new uint32_t[numMapped];
+        carla_zeroStructs(map->offsets, numSlots + 1);
+
+        // count parameters per slot, turn counts into start offsets, then fill in order
+        for (uint32_t i=0; i < count; ++i)
+        {
+            if (isInControlMap(data[i]))
+                ++map->offsets[data[i].midiChannel * ParameterControlMap::kNumControls
+                               + static_cast<uint32_t>(data[i].mappedControlIndex) + 1];
+        }
+
+        for (uint32_t i=0; i < numSlots; ++i)
+            map->offsets[i + 1] += map->offsets[i];
+
+        for (uint32_t i=0; i < count; ++i)
+        {
+            if (isInControlMap(data[i]))
+                map->params[map->offsets[data[i].midiChannel * ParameterControlMap::kNumControls
+                                         + static_cast<uint32_t>(data[i].mappedControlIndex)]++] = i;
+        }
+
+        // filling moved each start offset to the next slot's start, shift them back
+        for (uint32_t i=numSlots; i > 0; --i)
+            map->offsets[i] = map->offsets[i - 1];
+
+        map->offsets[0] = 0;
+    }
+
+    controlMapBuiltSerial = serial;
+    __sync_synchronize();
+    controlMapPending = map;
+}
+
+bool PluginParameterData::getMappedParameters(const uint8_t channel, const uint16_t control,
+                                              const uint32_t*& params, uint32_t& numParams) noexcept
+{
+    if (controlMapPending != nullptr && controlMapRetired == nullptr)
+    {
+        controlMapRetired = controlMap;
+        controlMap = controlMapPending;
+        __sync_synchronize();
+        controlMapPending = nullptr;
+    }
+
+    if (controlMap == nullptr || controlMap->serial != controlMapSerial)
+        return false;
+
+    numParams = 0;
+
+    if (controlMap->offsets == nullptr || channel >= MAX_MIDI_CHANNELS || control >= ParameterControlMap::kNumControls)
+        return true;
+
+    const uint32_t slot = channel * ParameterControlMap::kNumControls + control;
+
+    params    = controlMap->params + controlMap->offsets[slot];
+    numParams = controlMap->offsets[slot + 1] - controlMap->offsets[slot];
+    return true;
+}
+
 // -----------------------------------------------------------------------
 // PluginProgramData
 
 PluginProgramData::PluginProgramData() noexcept
     : count(0),
       current(-1),
-      names(nullptr) {}
+      names(nullptr),
+      pending(-1),
+      supportsRT(false) {}
 
 PluginProgramData::~PluginProgramData() noexcept
 {
@@ -446,6 +573,7 @@ void PluginProgramData::clear() noexcept
 
     count   = 0;
     current = -1;
+    pending = -1;
 }
 
 // -----------------------------------------------------------------------
@@ -454,7 +582,9 @@ void PluginProgramData::clear() noexcept
 PluginMidiProgramData::PluginMidiProgramData() noexcept
     : count(0),
       current(-1),
-      data(nullptr) {}
+      data(nullptr),
+      pending(-1),
+      supportsRT(false) {}
 
 PluginMidiProgramData::~PluginMidiProgramData() noexcept
 {
@@ -496,6 +626,7 @@ void PluginMidiProgramData::clear() noexcept
 
     count   = 0;
     current = -1;
+    pending = -1;
 }
 
 const MidiProgramData& PluginMidiProgramData::getCurrent() const noexcept
@@ -508,27 +639,56 @@ const MidiProgramData& PluginMidiProgramData::getCurrent() const noexcept
 // ProtectedData::ExternalNotes
 
 CarlaPlugin::ProtectedData::ExternalNotes::ExternalNotes() noexcept
-    : mutex(),
-      dataPool(32, 152),
-      data(dataPool) {}
+    : writeMutex(),
+      data(),
+      readIndex(0),
+      writeIndex(0) {}
 
-CarlaPlugin::ProtectedData::ExternalNotes::~ExternalNotes() noexcept
+void CarlaPlugin::ProtectedData::ExternalNotes::appendNonRT(const ExternalMidiNote& note) noexcept
 {
-    clear();
+    const CarlaMutexLocker cml(writeMutex);
+
+    const uint32_t wrIndex = writeIndex;
+
+    if (wrIndex - readIndex >= kMaxNotes)
+    {
+        carla_stderr2("External MIDI note queue is full, note dropped");
+        return;
+    }
+
+    data[wrIndex % kMaxNotes] = note;
+
+    __sync_synchronize();
+    writeIndex = wrIndex + 1;
 }
 
-void CarlaPlugin::ProtectedData::ExternalNotes::appendNonRT(const ExternalMidiNote& note) noexcept
+bool CarlaPlugin::ProtectedData::ExternalNotes::isEmpty() const noexcept
 {
-    mutex.lock();
-    data.append_sleepy(note);
-    mutex.unlock();
+    return readIndex == writeIndex;
 }
 
-void CarlaPlugin::ProtectedData::ExternalNotes::clear() noexcept
+bool CarlaPlugin::ProtectedData::ExternalNotes::getNextRT(ExternalMidiNote& note, const uint32_t frames) noexcept
 {
-    mutex.lock();
-    data.clear();
-    mutex.unlock();
+    const uint32_t rdIndex = readIndex;
+
+    if (rdIndex == writeIndex)
+        return false;
+
+    __sync_synchronize();
+    note = data[rdIndex % kMaxNotes];
+    __sync_synchronize();
+    readIndex = rdIndex + 1;
+
+    if (note.time >= frames)
+        note.time = frames > 0 ? frames - 1 : 0;
+
+    return true;
+}
+
+void CarlaPlugin::ProtectedData::ExternalNotes::clearRT() noexcept
+{
+    __sync_synchronize();
+    readIndex = writeIndex;
 }
 
 // -----------------------------------------------------------------------
@@ -540,10 +700,129 @@ CarlaPlugin::ProtectedData::Latency::Latency() noexcept
 #else
     : frames(0),
       channels(0),
+      capacity(0),
+      position(0),
       buffers(nullptr) {}
 #endif
 
 #ifndef BUILD_BRIDGE
+// Latency buffers are allocated in power-of-two sizes and shared between all plugins,
+// a buffer released by one plugin is reused by the next one that needs the same size.
+class LatencyBufferPool
+{
+public:
+    static const uint32_t kMinCapacity = 64;
+    static const uint32_t kMaxCachedPerSize = 32;
+
+    LatencyBufferPool() noexcept
+        : fMutex() {}
+
+    ~LatencyBufferPool() noexcept
+    {
+        for (uint32_t i=0; i < kNumSizes; ++i)
+        {
+            for (std::vector<float*>::iterator it = fFree[i].begin(); it != fFree[i].end(); ++it)
+                delete[] *it;
+        }
+    }
+
+    static uint32_t capacityFor(const uint32_t frames) noexcept
+    {
+        uint32_t capacity = kMinCapacity;
+
+        while (capacity < frames && capacity < (1U << 31))
+            capacity <<= 1;
+
+        return capacity;
+    }
+
+    float* acquire(const uint32_t capacity)
+    {
+        std::vector<float*>& free(fFree[sizeIndex(capacity)]);
+
+        {
+            const CarlaMutexLocker cml(fMutex);
+
+            if (! free.empty())
+            {
+                float* const buffer = free.back();
+                free.pop_back();
+                return buffer;
+            }
+        }
+
+        return new float[capacity];
+    }
+
+    void release(float* const buffer, const uint32_t capacity) noexcept
+    {
+        std::vector<float*>& free(fFree[sizeIndex(capacity)]);
+
+        {
+            const CarlaMutexLocker cml(fMutex);
+
+            if (free.size() < kMaxCachedPerSize)
+            {
+                try {
+                    free.push_back(buffer);
+                    return;
+                } CARLA_SAFE_EXCEPTION("LatencyBufferPool::release");
+            }
+        }
+
+        delete[] buffer;
+    }
+
+    static LatencyBufferPool& getInstance() noexcept
+    {
+        static LatencyBufferPool pool;
+        return pool;
+    }
+
+private:
+    static const uint32_t kNumSizes = 32;
+
+    CarlaMutex fMutex;
+    std::vector<float*> fFree[kNumSizes];
+
+    static uint32_t sizeIndex(uint32_t capacity) noexcept
+    {
+        uint32_t index = 0;
+
+        for (; capacity > 1; capacity >>= 1)
+            ++index;
+
+        return index;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(LatencyBufferPool)
+};
+
+// move the oldest sample of a ring buffer to its start, then resize it keeping the newest samples
+static void resizeLatencyBuffer(float* const buffer, const uint32_t position,
+                                const uint32_t oldFrames, const uint32_t newFrames) noexcept
+{
+    if (oldFrames == 0)
+    {
+        carla_zeroFloats(buffer, newFrames);
+        return;
+    }
+
+    if (position != 0)
+        std::rotate(buffer, buffer + position, buffer + oldFrames);
+
+    if (oldFrames > newFrames)
+    {
+        std::memmove(buffer, buffer + (oldFrames - newFrames), newFrames * sizeof(float));
+    }
+    else if (oldFrames < newFrames)
+    {
+        const uint32_t diff = newFrames - oldFrames;
+        std::memmove(buffer + diff, buffer, oldFrames * sizeof(float));
+        carla_zeroFloats(buffer, diff);
+    }
+}
+
 CarlaPlugin::ProtectedData::Latency::~Latency() noexcept
 {
     clearBuffers();
@@ -553,11 +832,13 @@ void CarlaPlugin::ProtectedData::Latency::clearBuffers() noexcept
 {
     if (buffers != nullptr)
     {
+        LatencyBufferPool& pool(LatencyBufferPool::getInstance());
+
         for (uint32_t i=0; i < channels; ++i)
         {
             CARLA_SAFE_ASSERT_CONTINUE(buffers[i] != nullptr);
 
-            delete[] buffers[i];
+            pool.release(buffers[i], capacity);
             buffers[i] = nullptr;
         }
 
@@ -567,26 +848,52 @@ void CarlaPlugin::ProtectedData::Latency::clearBuffers() noexcept
 
     channels = 0;
     frames   = 0;
+    capacity = 0;
+    position = 0;
 }
 
 void CarlaPlugin::ProtectedData::Latency::recreateBuffers(const uint32_t newChannels, const uint32_t newFrames)
 {
     CARLA_SAFE_ASSERT_RETURN(channels != newChannels || frames != newFrames,);
 
+    // same layout and the new latency fits, rearrange the current buffers in place.
+    // buffers are kept while latency is 0, so toggling lookahead on and off does not allocate
+    if (channels == newChannels && buffers != nullptr && newFrames <= capacity)
+    {
+        for (uint32_t i=0; i < channels; ++i)
+            resizeLatencyBuffer(buffers[i], position, frames, newFrames);
+
+        frames   = newFrames;
+        position = 0;
+        return;
+    }
+
     const bool retrieveOldBuffer = (channels == newChannels && channels > 0 && frames > 0 && newFrames > 0);
     float** const oldBuffers = buffers;
+    const uint32_t oldChannels = channels;
     const uint32_t oldFrames = frames;
+    const uint32_t oldCapacity = capacity;
+    LatencyBufferPool& pool(LatencyBufferPool::getInstance());
+
+    if (retrieveOldBuffer)
+    {
+        for (uint32_t i=0; i < channels; ++i)
+            if (position != 0)
+                std::rotate(oldBuffers[i], oldBuffers[i] + position, oldBuffers[i] + oldFrames);
+    }
 
     channels = newChannels;
     frames   = newFrames;
+    position = 0;
 
     if (channels > 0 && frames > 0)
     {
+        capacity = LatencyBufferPool::capacityFor(frames);
         buffers = new float*[channels];
 
         for (uint32_t i=0; i < channels; ++i)
         {
-            buffers[i] = new float[frames];
+            buffers[i] = pool.acquire(capacity);
 
             if (retrieveOldBuffer)
             {
@@ -610,63 +917,171 @@ void CarlaPlugin::ProtectedData::Latency::recreateBuffers(const uint32_t newChan
     }
     else
     {
+        capacity = 0;
         buffers = nullptr;
     }
 
-    // delete old buffer
+    // give old buffers back to the pool
     if (oldBuffers != nullptr)
     {
-        for (uint32_t i=0; i < channels; ++i)
+        for (uint32_t i=0; i < oldChannels; ++i)
         {
             CARLA_SAFE_ASSERT_CONTINUE(oldBuffers[i] != nullptr);
 
-            delete[] oldBuffers[i];
+            pool.release(oldBuffers[i], oldCapacity);
             oldBuffers[i] = nullptr;
         }
 
         delete[] oldBuffers;
     }
 }
+
+void CarlaPlugin::ProtectedData::Latency::saveInputs(const float* const* const audioIn, uint32_t count,
+                                                     const uint32_t blockFrames) noexcept
+{
+    if (frames == 0 || buffers == nullptr)
+        return;
+
+    if (count > channels)
+        count = channels;
+
+    if (frames <= blockFrames)
+    {
+        for (uint32_t i=0; i < count; ++i)
+            carla_copyFloats(buffers[i], audioIn[i] + (blockFrames - frames), frames);
+
+        position = 0;
+    }
+    else
+    {
+        // the oldest 'blockFrames' samples were used during this block, overwrite them with the current input
+        const uint32_t first = std::min(blockFrames, frames - position);
+
+        for (uint32_t i=0; i < count; ++i)
+        {
+            carla_copyFloats(buffers[i] + position, audioIn[i], first);
+
+            if (first < blockFrames)
+                carla_copyFloats(buffers[i], audioIn[i] + first, blockFrames - first);
+        }
+
+        position = (position + blockFrames) % frames;
+    }
+}
 #endif
 
 // -----------------------------------------------------------------------
 // ProtectedData::PostRtEvents
 
 CarlaPlugin::ProtectedData::PostRtEvents::PostRtEvents() noexcept
-    : dataPool(512, 512),
-      data(dataPool),
-      dataPendingRT(dataPool),
-      dataMutex(),
-      dataPendingMutex() {}
-
-CarlaPlugin::ProtectedData::PostRtEvents::~PostRtEvents() noexcept
+    : ringReadIndex(0),
+      ringWriteIndex(0),
+      ringWriting(0)
 {
-    dataMutex.lock();
-    dataPendingMutex.lock();
+    carla_zeroStructs(ringEvents, kMaxEvents);
+    carla_zeroFloats(paramValues, kNumParameterSlots);
 
-    data.clear();
-    dataPendingRT.clear();
-
-    dataMutex.unlock();
-    dataPendingMutex.unlock();
+    for (uint32_t i=0; i < kNumParameterWords; ++i)
+    {
+        paramDirty[i] = 0;
+        paramCallback[i] = 0;
+    }
 }
 
 void CarlaPlugin::ProtectedData::PostRtEvents::appendRT(const PluginPostRtEvent& e) noexcept
 {
-    CARLA_SAFE_ASSERT_INT2_RETURN(dataPendingMutex.tryLock(), e.type, e.value1,);
-    dataPendingRT.append(e);
-    dataPendingMutex.unlock();
+    if (e.type == kPluginPostRtEventParameterChange
+        && e.value1 > PARAMETER_MAX
+        && e.value1 < static_cast<int32_t>(kMaxCoalescedParameters))
+    {
+        const uint32_t slot = static_cast<uint32_t>(e.value1) + kParameterSlotOffset;
+        const uint32_t word = slot / 32;
+        const uint32_t bit  = 1U << (slot % 32);
+
+        // value first, so the consumer never sees the dirty bit without it
+        paramValues[slot] = e.valuef;
+
+        if (e.sendCallback)
+            __sync_fetch_and_or(&paramCallback[word], bit);
+
+        __sync_fetch_and_or(&paramDirty[word], bit);
+        return;
+    }
+
+    // mostly single producer (the audio thread), but non-RT threads can post events too
+    CARLA_SAFE_ASSERT_INT2_RETURN(__sync_bool_compare_and_swap(&ringWriting, 0, 1), e.type, e.value1,);
+
+    const uint32_t writeIndex = ringWriteIndex;
+    const uint32_t nextIndex  = (writeIndex + 1) & (kMaxEvents - 1);
+
+    if (nextIndex != __sync_fetch_and_add(&ringReadIndex, 0))
+    {
+        ringEvents[writeIndex] = e;
+        __sync_synchronize();
+        ringWriteIndex = nextIndex;
+    }
+    else
+    {
+        carla_stderr2("PostRtEvents: queue is full, event %i:%i dropped", e.type, e.value1);
+    }
+
+    __sync_lock_release(&ringWriting);
 }
 
-void CarlaPlugin::ProtectedData::PostRtEvents::trySplice() noexcept
-{
-    const CarlaMutexTryLocker cmtl(dataPendingMutex);
+CarlaPlugin::ProtectedData::PostRtEvents::Access::Access(PostRtEvents& e) noexcept
+    : events(e),
+      paramWord(0),
+      paramBits(0),
+      callbackBits(0),
+      writeIndex(__sync_fetch_and_add(&e.ringWriteIndex, 0)) {}
 
-    if (cmtl.wasLocked() && dataPendingRT.isNotEmpty() && dataMutex.tryLock())
+bool CarlaPlugin::ProtectedData::PostRtEvents::Access::next(PluginPostRtEvent& event) noexcept
+{
+    // coalesced parameter changes
+    for (; paramWord < kNumParameterWords; ++paramWord)
     {
-        dataPendingRT.moveTo(data, true);
-        dataMutex.unlock();
+        if (paramBits == 0)
+        {
+            if (events.paramDirty[paramWord] == 0)
+                continue;
+
+            paramBits    = __sync_fetch_and_and(&events.paramDirty[paramWord], 0U);
+            callbackBits = __sync_fetch_and_and(&events.paramCallback[paramWord], ~paramBits);
+
+            if (paramBits == 0)
+                continue;
+        }
+
+        const uint32_t bitIndex = static_cast<uint32_t>(__builtin_ctz(paramBits));
+        const uint32_t bit      = 1U << bitIndex;
+        const uint32_t slot     = paramWord * 32 + bitIndex;
+
+        paramBits &= ~bit;
+
+        event.type         = kPluginPostRtEventParameterChange;
+        event.sendCallback = (callbackBits & bit) != 0;
+        event.value1       = static_cast<int32_t>(slot) - static_cast<int32_t>(kParameterSlotOffset);
+        event.value2       = 0;
+        event.value3       = 0;
+        event.valuef       = events.paramValues[slot];
+
+        if (paramBits == 0)
+            ++paramWord;
+
+        return true;
     }
+
+    // queued events, up to what was available when access started
+    const uint32_t readIndex = events.ringReadIndex;
+
+    if (readIndex == writeIndex)
+        return false;
+
+    event = events.ringEvents[readIndex];
+
+    __sync_synchronize();
+    events.ringReadIndex = (readIndex + 1) & (kMaxEvents - 1);
+    return true;
 }
 
 // -----------------------------------------------------------------------
@@ -683,9 +1098,32 @@ CarlaPlugin::ProtectedData::PostUiEvents::~PostUiEvents() noexcept
 
 void CarlaPlugin::ProtectedData::PostUiEvents::append(const PluginPostRtEvent& e) noexcept
 {
-    mutex.lock();
+    const CarlaMutexLocker cml(mutex);
+
+    if (e.type == kPluginPostRtEventParameterChange)
+    {
+        // replace a pending change of the same parameter, as long as no other kind of event comes after it
+        PluginPostRtEvent fallback = { kPluginPostRtEventNull, false, 0, 0, 0, 0.0f };
+        PluginPostRtEvent* pending = nullptr;
+
+        for (LinkedList<PluginPostRtEvent>::Itenerator it = data.begin2(); it.valid(); it.next())
+        {
+            PluginPostRtEvent& event(it.getValue(fallback));
+
+            if (event.type != kPluginPostRtEventParameterChange)
+                pending = nullptr;
+            else if (event.value1 == e.value1)
+                pending = &event;
+        }
+
+        if (pending != nullptr)
+        {
+            pending->valuef = e.valuef;
+            return;
+        }
+    }
+
     data.append(e);
-    mutex.unlock();
 }
 
 void CarlaPlugin::ProtectedData::PostUiEvents::clear() noexcept
@@ -695,6 +1133,15 @@ void CarlaPlugin::ProtectedData::PostUiEvents::clear() noexcept
     mutex.unlock();
 }
 
+// -----------------------------------------------------------------------
+// ProtectedData::AutoSleep
+
+CarlaPlugin::ProtectedData::AutoSleep::AutoSleep() noexcept
+    : wakeUp(false),
+      inputSilent(false),
+      sleeping(false),
+      silentFrames(0) {}
+
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
 // -----------------------------------------------------------------------
 // ProtectedData::PostProc
@@ -704,7 +1151,11 @@ CarlaPlugin::ProtectedData::PostProc::PostProc() noexcept
       volume(1.0f),
       balanceLeft(-1.0f),
       balanceRight(1.0f),
-      panning(0.0f) {}
+      panning(0.0f),
+      lastDryWet(1.0f),
+      lastVolume(1.0f),
+      lastBalanceLeft(-1.0f),
+      lastBalanceRight(1.0f) {}
 #endif
 
 // -----------------------------------------------------------------------
@@ -725,6 +1176,7 @@ CarlaPlugin::ProtectedData::ProtectedData(CarlaEngine* const eng, const uint idx
       uiLib(nullptr),
       ctrlChannel(0),
       extraHints(0x0),
+      eventSplitCount(0),
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
       midiLearnParameterIndex(-1),
       transientTryCounter(0),
@@ -745,11 +1197,15 @@ CarlaPlugin::ProtectedData::ProtectedData(CarlaEngine* const eng, const uint idx
       masterMutex(),
       singleMutex(),
       stateSave(),
+      stateSaveXml(),
+      stateSaveChunkFilename(),
+      stateChanged(true),
       uiTitle(),
       extNotes(),
       latency(),
       postRtEvents(),
-      postUiEvents()
+      postUiEvents(),
+      autoSleep()
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     , postProc()
 #endif
@@ -863,6 +1319,200 @@ void CarlaPlugin::ProtectedData::clearBuffers() noexcept
 #endif
 }
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+// -----------------------------------------------------------------------
+// Post-processing
+
+// linear ramp from the last used value to the current one, reaching it at the end of the block
+struct PostProcRamp {
+    float value, step;
+
+    PostProcRamp(const float last, const float current, const uint32_t frames) noexcept
+        : value(last),
+          step((current - last) / static_cast<float>(frames)) {}
+
+    float at(const uint32_t frame) const noexcept
+    {
+        return value + step * static_cast<float>(frame);
+    }
+};
+
+// single channel, dry/wet and volume
+static void postProcMono(const PostProcRamp& dryWet, const PostProcRamp& volume, const uint32_t start, const uint32_t count,
+                         const float* const dry, const float* const wet, float* const out) noexcept
+{
+    for (uint32_t k=0; k < count; ++k)
+        out[k] = (dry[k] + (wet[k] - dry[k]) * dryWet.at(start + k)) * volume.at(start + k);
+}
+
+// channel pair, dry/wet, balance and volume
+static void postProcStereo(const PostProcRamp& dryWet, const PostProcRamp& balL, const PostProcRamp& balR,
+                           const PostProcRamp& volume, const uint32_t start, const uint32_t count,
+                           const float* const dryL, const float* const dryR,
+                           const float* const wetL, const float* const wetR,
+                           float* const outL, float* const outR) noexcept
+{
+    for (uint32_t k=0; k < count; ++k)
+    {
+        const uint32_t frame = start + k;
+        const float dw = dryWet.at(frame);
+        const float bl = balL.at(frame);
+        const float br = balR.at(frame);
+        const float vol = volume.at(frame);
+        const float left  = dryL[k] + (wetL[k] - dryL[k]) * dw;
+        const float right = dryR[k] + (wetR[k] - dryR[k]) * dw;
+
+        outL[k] = (left * (1.0f - bl) + right * (1.0f - br)) * vol;
+        outR[k] = (right * br + left * bl) * vol;
+    }
+}
+
+bool CarlaPlugin::ProtectedData::canProcessDirectly(const bool inPlaceSafe) const noexcept
+{
+    if (! inPlaceSafe && engine->getProccessMode() != ENGINE_PROCESS_MODE_MULTIPLE_CLIENTS)
+        return false;
+
+    if ((hints & PLUGIN_CAN_DRYWET) != 0 && audioIn.count != 0 &&
+        (carla_isNotEqual(postProc.dryWet, 1.0f) || carla_isNotEqual(postProc.lastDryWet, 1.0f)))
+        return false;
+
+    if ((hints & PLUGIN_CAN_BALANCE) != 0 &&
+        ! (carla_isEqual(postProc.balanceLeft, -1.0f) && carla_isEqual(postProc.lastBalanceLeft, -1.0f) &&
+           carla_isEqual(postProc.balanceRight, 1.0f) && carla_isEqual(postProc.lastBalanceRight, 1.0f)))
+        return false;
+
+    if ((hints & PLUGIN_CAN_VOLUME) != 0 &&
+        (carla_isNotEqual(postProc.volume, 1.0f) || carla_isNotEqual(postProc.lastVolume, 1.0f)))
+        return false;
+
+    return true;
+}
+
+void CarlaPlugin::ProtectedData::processPostProc(const float* const* const dryBuffers, const uint32_t dryOffset,
+                                                 const bool dryHasLatency, float* const* const wetBuffers,
+                                                 float* const* const outBuffers, const uint32_t outOffset,
+                                                 const uint32_t frames) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(frames > 0,);
+
+    const float dryWet       = postProc.dryWet;
+    const float volume       = postProc.volume;
+    const float balanceLeft  = postProc.balanceLeft;
+    const float balanceRight = postProc.balanceRight;
+
+    const bool doDryWet  = (hints & PLUGIN_CAN_DRYWET) != 0 && audioIn.count != 0 && dryBuffers != nullptr &&
+                           (carla_isNotEqual(dryWet, 1.0f) || carla_isNotEqual(postProc.lastDryWet, 1.0f));
+    const bool doBalance = (hints & PLUGIN_CAN_BALANCE) != 0 &&
+                         ! (carla_isEqual(balanceLeft, -1.0f) && carla_isEqual(postProc.lastBalanceLeft, -1.0f) &&
+                            carla_isEqual(balanceRight, 1.0f) && carla_isEqual(postProc.lastBalanceRight, 1.0f));
+    const bool doVolume  = (hints & PLUGIN_CAN_VOLUME) != 0 &&
+                           (carla_isNotEqual(volume, 1.0f) || carla_isNotEqual(postProc.lastVolume, 1.0f));
+
+    // disabled stages use a constant identity ramp, so a single loop handles all cases
+    const PostProcRamp dryWetRamp(doDryWet ? postProc.lastDryWet : 1.0f, doDryWet ? dryWet : 1.0f, frames);
+    const PostProcRamp volumeRamp(doVolume ? postProc.lastVolume : 1.0f, doVolume ? volume : 1.0f, frames);
+    const PostProcRamp balLRamp((postProc.lastBalanceLeft  + 1.0f) / 2.0f, (balanceLeft  + 1.0f) / 2.0f, frames);
+    const PostProcRamp balRRamp((postProc.lastBalanceRight + 1.0f) / 2.0f, (balanceRight + 1.0f) / 2.0f, frames);
+
+    postProc.lastDryWet       = dryWet;
+    postProc.lastVolume       = volume;
+    postProc.lastBalanceLeft  = balanceLeft;
+    postProc.lastBalanceRight = balanceRight;
+
+    // dry signal is taken from the latency buffers first, if the plugin reports any
+#ifndef BUILD_BRIDGE
+    uint32_t latencyFrames = 0;
+
+    if (doDryWet && dryHasLatency && latency.frames != 0 && latency.buffers != nullptr)
+        latencyFrames = std::min(latency.frames, frames);
+#else
+    // unused
+    (void)dryHasLatency;
+#endif
+
+    for (uint32_t i=0; i < audioOut.count; ++i)
+    {
+        const float* const wetL = wetBuffers[i];
+        float* const outL = outBuffers[i] + outOffset;
+        const uint32_t cL = (audioIn.count == 1) ? 0 : i;
+        const bool hasDryL = doDryWet && cL < audioIn.count;
+
+        if (doBalance && i % 2 == 0 && i+1 < audioOut.count)
+        {
+            const float* const wetR = wetBuffers[i+1];
+            float* const outR = outBuffers[i+1] + outOffset;
+            const uint32_t cR = (audioIn.count == 1) ? 0 : i+1;
+            const bool hasDryR = doDryWet && cR < audioIn.count;
+            uint32_t start = 0;
+
+            // an output without its own input keeps its wet signal
+#ifndef BUILD_BRIDGE
+            // the latency ring buffer can wrap, giving the delayed dry signal in 2 parts
+            for (uint32_t pos = latency.position; start < latencyFrames; pos = 0)
+            {
+                const uint32_t len = std::min(latencyFrames - start, latency.frames - pos);
+                postProcStereo(dryWetRamp, balLRamp, balRRamp, volumeRamp, start, len,
+                               hasDryL ? latency.buffers[cL] + pos : wetL + start,
+                               hasDryR ? latency.buffers[cR] + pos : wetR + start,
+                               wetL + start, wetR + start, outL + start, outR + start);
+                start += len;
+            }
+#endif
+            if (start < frames)
+                postProcStereo(dryWetRamp, balLRamp, balRRamp, volumeRamp, start, frames - start,
+                               hasDryL ? dryBuffers[cL] + dryOffset : wetL + start,
+                               hasDryR ? dryBuffers[cR] + dryOffset : wetR + start,
+                               wetL + start, wetR + start, outL + start, outR + start);
+
+            ++i;
+            continue;
+        }
+
+        if (! (hasDryL || doVolume))
+        {
+            if (outL != wetL)
+                carla_copyFloats(outL, wetL, frames);
+            continue;
+        }
+
+        uint32_t start = 0;
+
+#ifndef BUILD_BRIDGE
+        for (uint32_t pos = latency.position; start < latencyFrames; pos = 0)
+        {
+            const uint32_t len = std::min(latencyFrames - start, latency.frames - pos);
+            postProcMono(dryWetRamp, volumeRamp, start, len,
+                         hasDryL ? latency.buffers[cL] + pos : wetL + start, wetL + start, outL + start);
+            start += len;
+        }
+#endif
+        if (start < frames)
+            postProcMono(dryWetRamp, volumeRamp, start, frames - start,
+                         hasDryL ? dryBuffers[cL] + dryOffset : wetL + start, wetL + start, outL + start);
+    }
+}
+#endif
+
+// -----------------------------------------------------------------------
+// Block splitting
+
+uint32_t CarlaPlugin::ProtectedData::getEventSplitTime(const uint32_t eventTime, const uint32_t timeOffset,
+                                                       const uint32_t frames) const noexcept
+{
+    const EngineOptions& opts(engine->getOptions());
+    const uint32_t granularity = std::max(opts.eventSplitGranularity, 1U);
+    const uint32_t splitTime   = eventTime - eventTime % granularity;
+
+    if (splitTime <= timeOffset)
+        return timeOffset;
+
+    // merge into the current sub-block if either side of the split would be too small
+    if (splitTime - timeOffset < opts.eventSplitMinFrames || frames - splitTime < opts.eventSplitMinFrames)
+        return timeOffset;
+
+    return splitTime;
+}
+
 // -----------------------------------------------------------------------
 // Post-poned events
 
@@ -887,6 +1537,42 @@ void CarlaPlugin::ProtectedData::postponeRtEvent(const PluginPostRtEventType typ
     postRtEvents.appendRT(rtEvent);
 }
 
+// -----------------------------------------------------------------------
+// Program changes from non-RT threads
+
+bool CarlaPlugin::ProtectedData::deferProgramChange(const int32_t index, const bool midi) noexcept
+{
+    if (index < 0 || ! (midi ? midiprog.supportsRT : prog.supportsRT))
+        return false;
+    if (! (enabled && active) || client == nullptr || ! client->isActive())
+        return false;
+    if (! engine->isRunning() || engine->isOffline())
+        return false;
+
+    // a newer request replaces one not yet picked up by the audio thread
+    __sync_lock_test_and_set(midi ? &midiprog.pending : &prog.pending, index);
+    return true;
+}
+
+void CarlaPlugin::ProtectedData::applyDeferredProgramChangesRT(CarlaPlugin* const plugin) noexcept
+{
+    if (prog.pending >= 0)
+    {
+        const int32_t index = __sync_lock_test_and_set(&prog.pending, -1);
+
+        if (index >= 0 && static_cast<uint32_t>(index) < prog.count)
+            plugin->setProgramRT(static_cast<uint32_t>(index), true);
+    }
+
+    if (midiprog.pending >= 0)
+    {
+        const int32_t index = __sync_lock_test_and_set(&midiprog.pending, -1);
+
+        if (index >= 0 && static_cast<uint32_t>(index) < midiprog.count)
+            plugin->setMidiProgramRT(static_cast<uint32_t>(index), true);
+    }
+}
+
 // -----------------------------------------------------------------------
 // Library functions
 
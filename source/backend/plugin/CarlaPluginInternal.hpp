@@ -106,9 +106,10 @@ struct PluginPostRtEvent {
 // -----------------------------------------------------------------------
 
 struct ExternalMidiNote {
-    int8_t  channel; // invalid if -1
-    uint8_t note;    // 0 to 127
-    uint8_t velo;    // 1 to 127, 0 for note-off
+    int8_t   channel; // invalid if -1
+    uint8_t  note;    // 0 to 127
+    uint8_t  velo;    // 1 to 127, 0 for note-off
+    uint32_t time;    // frame offset within the next process cycle
 };
 
 // -----------------------------------------------------------------------
@@ -171,12 +172,35 @@ struct PluginEventData {
 
 // -----------------------------------------------------------------------
 
+// Parameters mapped to each MIDI channel and control index, for control events on the audio thread.
+struct ParameterControlMap {
+    static const uint32_t kNumControls = CONTROL_INDEX_MAX_ALLOWED + 1;
+
+    uint32_t serial;   // PluginParameterData::controlMapSerial this was built from
+    uint32_t* offsets; // [channel * kNumControls + control], with one extra end offset; null if nothing is mapped
+    uint32_t* params;
+
+    ParameterControlMap(uint32_t s) noexcept;
+    ~ParameterControlMap() noexcept;
+
+    CARLA_DECLARE_NON_COPY_STRUCT(ParameterControlMap)
+};
+
 struct PluginParameterData {
     uint32_t count;
     ParameterData* data;
     ParameterRanges* ranges;
     SpecialParameterType* special;
 
+    // The control map is rebuilt during idle after 'controlMapSerial' changes, then handed to the
+    // audio thread like grown event buffers: published as pending, adopted, and deleted once retired.
+    // Until a map for the current serial is adopted, control events scan all parameters.
+    ParameterControlMap* controlMap;
+    ParameterControlMap* controlMapPending;
+    ParameterControlMap* controlMapRetired;
+    volatile uint32_t controlMapSerial;
+    uint32_t controlMapBuiltSerial;
+
     PluginParameterData() noexcept;
     ~PluginParameterData() noexcept;
     void createNew(uint32_t newCount, bool withSpecial);
@@ -185,6 +209,16 @@ struct PluginParameterData {
     float getFinalUnnormalizedValue(uint32_t parameterId, float normalizedValue) const noexcept;
     float getFinalValueWithMidiDelta(uint32_t parameterId, float value, int8_t delta) const noexcept;
 
+    // to be called after changing the MIDI channel or mapped control index of any parameter, from any thread
+    void controlMappingChanged() noexcept;
+
+    // non-RT, builds and publishes a new control map if mappings changed
+    void updateControlMap();
+
+    // RT, gets the parameters mapped to a channel and control index.
+    // returns false if the map is not up to date, in which case all parameters need to be checked
+    bool getMappedParameters(uint8_t channel, uint16_t control, const uint32_t*& params, uint32_t& numParams) noexcept;
+
     CARLA_DECLARE_NON_COPY_STRUCT(PluginParameterData)
 };
 
@@ -197,6 +231,10 @@ struct PluginProgramData {
     int32_t current;
     ProgramName* names;
 
+    // change requested by a non-RT thread, applied by the audio thread on its next cycle
+    volatile int32_t pending;
+    bool supportsRT;
+
     PluginProgramData() noexcept;
     ~PluginProgramData() noexcept;
     void createNew(uint32_t newCount);
@@ -212,6 +250,10 @@ struct PluginMidiProgramData {
     int32_t current;
     MidiProgramData* data;
 
+    // change requested by a non-RT thread, applied by the audio thread on its next cycle
+    volatile int32_t pending;
+    bool supportsRT;
+
     PluginMidiProgramData() noexcept;
     ~PluginMidiProgramData() noexcept;
     void createNew(uint32_t newCount);
@@ -245,6 +287,7 @@ struct CarlaPlugin::ProtectedData {
     // misc
     int8_t ctrlChannel;
     uint   extraHints;
+    uint32_t eventSplitCount; // extra sub-blocks from splitting at events, see takeEventSplitCount()
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     int32_t midiLearnParameterIndex;
     uint    transientTryCounter;
@@ -272,17 +315,30 @@ struct CarlaPlugin::ProtectedData {
 
     CarlaStateSave stateSave;
 
+    // project XML of the last dumpStateSave(), valid while 'stateChanged' is false
+    water::String stateSaveXml;
+
+    // chunk file written by the last prepareStateDump(), relative to the project folder
+    water::String stateSaveChunkFilename;
+    volatile bool stateChanged;
+
     CarlaString uiTitle;
 
+    // Single-consumer ring, the audio thread never locks.
+    // Non-RT writers (UI, OSC, API) are serialized among themselves through writeMutex.
     struct ExternalNotes {
-        CarlaMutex mutex;
-        RtLinkedList<ExternalMidiNote>::Pool dataPool;
-        RtLinkedList<ExternalMidiNote> data;
+        static const uint32_t kMaxNotes = 512; // must be power of 2
+
+        CarlaMutex writeMutex;
+        ExternalMidiNote data[kMaxNotes];
+        volatile uint32_t readIndex;
+        volatile uint32_t writeIndex;
 
         ExternalNotes() noexcept;
-        ~ExternalNotes() noexcept;
         void appendNonRT(const ExternalMidiNote& note) noexcept;
-        void clear() noexcept;
+        bool isEmpty() const noexcept;
+        bool getNextRT(ExternalMidiNote& note, uint32_t frames) noexcept;
+        void clearRT() noexcept;
 
         CARLA_DECLARE_NON_COPY_STRUCT(ExternalNotes)
 
@@ -292,6 +348,8 @@ struct CarlaPlugin::ProtectedData {
         uint32_t frames;
 #ifndef BUILD_BRIDGE
         uint32_t channels;
+        uint32_t capacity; // allocated size of each buffer, latency changes within it do not reallocate
+        uint32_t position; // ring buffer read/write index, oldest sample first
         float**  buffers;
 #endif
 
@@ -300,53 +358,57 @@ struct CarlaPlugin::ProtectedData {
         ~Latency() noexcept;
         void clearBuffers() noexcept;
         void recreateBuffers(uint32_t newChannels, uint32_t newFrames);
+
+        // keep the last 'frames' samples of the inputs, to be used as delayed dry signal on the next block
+        void saveInputs(const float* const* audioIn, uint32_t count, uint32_t blockFrames) noexcept;
 #endif
 
         CARLA_DECLARE_NON_COPY_STRUCT(Latency)
 
     } latency;
 
+    // Events from the audio thread to the idle/main thread, lock-free on both sides.
+    // Parameter changes are coalesced so that only the latest value per parameter is kept,
+    // everything else goes through a fixed-size ring and is dropped when the ring is full.
     class PostRtEvents {
     public:
+        static const uint32_t kMaxEvents = 1024; // must be power of 2
+        static const uint32_t kMaxCoalescedParameters = 4096;
+
         PostRtEvents() noexcept;
-        ~PostRtEvents() noexcept;
         void appendRT(const PluginPostRtEvent& event) noexcept;
-        void trySplice() noexcept;
 
+        // consumer side, only one Access can be active at a time
         struct Access {
-            Access(PostRtEvents& e)
-              : data2(e.dataPool)
-            {
-                const CarlaMutexLocker cml(e.dataMutex);
-
-                if (e.data.isNotEmpty())
-                    e.data.moveTo(data2, true);
-            }
-
-            ~Access()
-            {
-                data2.clear();
-            }
-
-            inline RtLinkedList<PluginPostRtEvent>::Itenerator getDataIterator() const noexcept
-            {
-                return data2.begin2();
-            }
-
-            inline std::size_t isEmpty() const noexcept
-            {
-                return data2.isEmpty();
-            }
+            Access(PostRtEvents& e) noexcept;
+
+            // coalesced parameter changes come first, then the queued events in order
+            bool next(PluginPostRtEvent& event) noexcept;
 
         private:
-            RtLinkedList<PluginPostRtEvent> data2;
+            PostRtEvents& events;
+            uint32_t paramWord;
+            uint32_t paramBits;
+            uint32_t callbackBits;
+            uint32_t writeIndex;
+
+            CARLA_DECLARE_NON_COPY_STRUCT(Access)
         };
 
     private:
-        RtLinkedList<PluginPostRtEvent>::Pool dataPool;
-        RtLinkedList<PluginPostRtEvent> data, dataPendingRT;
-        CarlaMutex dataMutex;
-        CarlaMutex dataPendingMutex;
+        // slot 0 matches PARAMETER_MAX, regular parameters start at kParameterSlotOffset
+        static const uint32_t kParameterSlotOffset = static_cast<uint32_t>(-PARAMETER_MAX);
+        static const uint32_t kNumParameterSlots = kMaxCoalescedParameters + kParameterSlotOffset;
+        static const uint32_t kNumParameterWords = (kNumParameterSlots + 31) / 32;
+
+        PluginPostRtEvent ringEvents[kMaxEvents];
+        volatile uint32_t ringReadIndex;
+        volatile uint32_t ringWriteIndex;
+        volatile int ringWriting;
+
+        float paramValues[kNumParameterSlots];
+        volatile uint32_t paramDirty[kNumParameterWords];
+        volatile uint32_t paramCallback[kNumParameterWords];
 
         CARLA_DECLARE_NON_COPY_CLASS(PostRtEvents)
 
@@ -358,6 +420,7 @@ struct CarlaPlugin::ProtectedData {
 
         PostUiEvents() noexcept;
         ~PostUiEvents() noexcept;
+        // parameter changes overwrite a still pending one for the same parameter
         void append(const PluginPostRtEvent& event) noexcept;
         void clear() noexcept;
 
@@ -365,6 +428,19 @@ struct CarlaPlugin::ProtectedData {
 
     } postUiEvents;
 
+    struct AutoSleep {
+        // set from non-RT threads when something changed that might make the plugin produce sound
+        volatile bool wakeUp;
+        bool inputSilent;
+        bool sleeping;
+        uint32_t silentFrames;
+
+        AutoSleep() noexcept;
+
+        CARLA_DECLARE_NON_COPY_STRUCT(AutoSleep)
+
+    } autoSleep;
+
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
     struct PostProc {
         float dryWet;
@@ -373,6 +449,12 @@ struct CarlaPlugin::ProtectedData {
         float balanceRight;
         float panning;
 
+        // values used in the previous block, changes are ramped from these
+        float lastDryWet;
+        float lastVolume;
+        float lastBalanceLeft;
+        float lastBalanceRight;
+
         PostProc() noexcept;
 
         CARLA_DECLARE_NON_COPY_STRUCT(PostProc)
@@ -388,6 +470,38 @@ struct CarlaPlugin::ProtectedData {
 
     void clearBuffers() noexcept;
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    // -------------------------------------------------------------------
+    // Post-processing
+
+    /*
+     * Apply dry/wet, balance and volume to 'wetBuffers' in a single pass, writing the result into 'outBuffers'.
+     * 'outBuffers' may be the same as 'wetBuffers' if 'outOffset' is 0.
+     * Stages at their default value are skipped, changes since the last block are ramped over 'frames'.
+     */
+    void processPostProc(const float* const* dryBuffers, uint32_t dryOffset, bool dryHasLatency,
+                         float* const* wetBuffers, float* const* outBuffers, uint32_t outOffset,
+                         uint32_t frames) noexcept;
+
+    /*
+     * Whether the plugin can run directly on the engine port buffers, skipping its own buffer copies.
+     * True only when post-processing would leave the output untouched and the engine runs in multi-client mode,
+     * as that is the only mode where input and output buffers are guaranteed not to alias.
+     * Plugins that work with aliased buffers can pass 'inPlaceSafe' to skip the engine mode check.
+     */
+    bool canProcessDirectly(bool inPlaceSafe = false) const noexcept;
+#endif
+
+    // -------------------------------------------------------------------
+    // Block splitting
+
+    /*
+     * Where to split the block for a sample accurate event at 'eventTime', given the current sub-block start.
+     * Follows the engine split granularity and minimum sub-block size.
+     * Returns a value <= 'timeOffset' if the event should be merged into the current sub-block instead.
+     */
+    uint32_t getEventSplitTime(uint32_t eventTime, uint32_t timeOffset, uint32_t frames) const noexcept;
+
     // -------------------------------------------------------------------
     // Post-poned events
 
@@ -395,6 +509,21 @@ struct CarlaPlugin::ProtectedData {
     void postponeRtEvent(PluginPostRtEventType type, bool sendCallbackLater,
                          int32_t value1, int32_t value2, int32_t value3, float valuef) noexcept;
 
+    // -------------------------------------------------------------------
+    // Program changes from non-RT threads
+
+    /*
+     * Hand a program change over to the audio thread instead of taking 'singleMutex' for it.
+     * Only possible while the plugin is running and can change programs in realtime,
+     * returns false if the caller needs to do the change itself.
+     */
+    bool deferProgramChange(int32_t index, bool midi) noexcept;
+
+    /*
+     * Apply the program changes deferred above, called by the audio thread while holding 'singleMutex'.
+     */
+    void applyDeferredProgramChangesRT(CarlaPlugin* plugin) noexcept;
+
     // -------------------------------------------------------------------
     // Library functions
 
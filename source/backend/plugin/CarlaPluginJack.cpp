@@ -64,11 +64,6 @@ static size_t safe_rand(const size_t limit)
     return static_cast<uint>(r) % limit;
 }
 
-// -------------------------------------------------------------------------------------------------------------------
-// Fallback data
-
-static const ExternalMidiNote kExternalMidiNoteFallback = { -1, 0, 0 };
-
 // -------------------------------------------------------------------------------------------------------------------
 
 struct Announcer {
@@ -380,6 +375,12 @@ protected:
             carla_setenv("CARLA_LIBJACK_SETUP", fSetupLabel.buffer());
             carla_setenv("CARLA_SHM_IDS", fShmIds.buffer());
 
+            // per-plugin overrides are sent later, see kPluginBridgeNonRtClientSetThreadPolicy
+            char rtPrioStr[16];
+            std::snprintf(rtPrioStr, sizeof(rtPrioStr), "%i", options.bridgeRtPrio);
+            carla_setenv("CARLA_LIBJACK_RT_PRIO", rtPrioStr);
+            carla_setenv("CARLA_LIBJACK_CPU_AFFINITY", options.bridgeCpuAffinity != nullptr ? options.bridgeCpuAffinity : "");
+
             if (! fProcess->start(arguments))
             {
                 carla_stdout("failed!");
@@ -522,6 +523,8 @@ public:
           fBufferSize(engine->getBufferSize()),
           fProcWaitTime(0),
           fSetupHints(0x0),
+          fRtPrioOverride(-1),
+          fCpuAffinityOverride(),
           fBridgeThread(this, engine, this),
           fShmAudioPool(),
           fShmRtClientControl(),
@@ -738,7 +741,20 @@ public:
         CARLA_SAFE_ASSERT_RETURN(value != nullptr,);
 
         if (std::strcmp(type, CUSTOM_DATA_TYPE_PROPERTY) == 0)
+        {
+            if (std::strcmp(key, "CarlaRtPriority") == 0)
+            {
+                fRtPrioOverride = value[0] != '\0' ? carla_fixedValue(0, 99, std::atoi(value)) : -1;
+                sendThreadPolicy();
+            }
+            else if (std::strcmp(key, "CarlaCpuAffinity") == 0)
+            {
+                fCpuAffinityOverride = value;
+                sendThreadPolicy();
+            }
+
             return CarlaPlugin::setCustomData(type, key, value, sendGui);
+        }
 
         if (std::strcmp(type, CUSTOM_DATA_TYPE_STRING) == 0 && std::strcmp(key, "__CarlaPingOnOff__") == 0)
         {
@@ -1030,11 +1046,11 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                for (RtLinkedList<ExternalMidiNote>::Itenerator it = pData->extNotes.data.begin2(); it.valid(); it.next())
+                ExternalMidiNote note = { 0, 0, 0, 0 };
+
+                while (pData->extNotes.getNextRT(note, frames))
                 {
-                    const ExternalMidiNote& note(it.getValue(kExternalMidiNoteFallback));
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                     uint8_t data1, data2, data3;
@@ -1043,7 +1059,7 @@ public:
                     data3 = note.velo;
 
                     fShmRtClientControl.writeOpcode(kPluginBridgeRtClientMidiEvent);
-                    fShmRtClientControl.writeUInt(0); // time
+                    fShmRtClientControl.writeUInt(note.time);
                     fShmRtClientControl.writeByte(0); // port
                     fShmRtClientControl.writeByte(3); // size
                     fShmRtClientControl.writeByte(data1);
@@ -1052,9 +1068,6 @@ public:
                     fShmRtClientControl.commitWrite();
                 }
 
-                pData->extNotes.data.clear();
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -1249,8 +1262,6 @@ public:
                 }
             }
 
-            pData->postRtEvents.trySplice();
-
         } // End of Event Input
 
         if (! processSingle(audioIn, audioOut, frames))
@@ -1388,69 +1399,7 @@ public:
         // --------------------------------------------------------------------------------------------------------
         // Post-processing (dry/wet, volume and balance)
 
-        {
-            const bool doVolume  = (pData->hints & PLUGIN_CAN_VOLUME) != 0 && carla_isNotEqual(pData->postProc.volume, 1.0f);
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-            const bool isMono    = (pData->audioIn.count == 1);
-
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    const uint32_t c = isMono ? 0 : i;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        bufValue = audioIn[c][k];
-                        audioOut[i][k] = (audioOut[i][k] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
-
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
-
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        carla_copyFloats(oldBufLeft, audioOut[i], frames);
-                    }
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            audioOut[i][k]  = oldBufLeft[k]     * (1.0f - balRangeL);
-                            audioOut[i][k] += audioOut[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            audioOut[i][k]  = audioOut[i][k] * balRangeR;
-                            audioOut[i][k] += oldBufLeft[k]   * balRangeL;
-                        }
-                    }
-                }
-
-                // Volume (and buffer copy)
-                if (doVolume)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        audioOut[i][k] *= pData->postProc.volume;
-                }
-            }
-
-        } // End of Post-processing
+        pData->processPostProc(audioIn, 0, false, audioOut, audioOut, 0, frames);
 #endif
         // --------------------------------------------------------------------------------------------------------
 
@@ -1534,6 +1483,9 @@ public:
             case kPluginBridgeNonRtServerParameterRanges:
             case kPluginBridgeNonRtServerParameterValue:
             case kPluginBridgeNonRtServerParameterValue2:
+            case kPluginBridgeNonRtServerParameterInfo:
+            case kPluginBridgeNonRtServerParameterInfo2:
+            case kPluginBridgeNonRtServerParameterNames:
             case kPluginBridgeNonRtServerParameterTouch:
             case kPluginBridgeNonRtServerDefaultValue:
             case kPluginBridgeNonRtServerCurrentProgram:
@@ -1553,6 +1505,12 @@ public:
                 }
                 break;
 
+            case kPluginBridgeNonRtServerSetChunkDataShm:
+            case kPluginBridgeNonRtServerResizeChunkDataShm:
+                // ulong/dataSize
+                fShmNonRtServerControl.readULong();
+                break;
+
             case kPluginBridgeNonRtServerSetLatency:
             case kPluginBridgeNonRtServerSetParameterText:
                 break;
@@ -1794,6 +1752,29 @@ public:
         return true;
     }
 
+    // Sends this plugin's realtime priority and CPU affinity, using the engine options where not overridden.
+    void sendThreadPolicy()
+    {
+        const EngineOptions& options(pData->engine->getOptions());
+
+        const int rtPrio = fRtPrioOverride >= 0 ? fRtPrioOverride : options.bridgeRtPrio;
+        const char* const cpuList = fCpuAffinityOverride.isNotEmpty()
+                                  ? fCpuAffinityOverride.buffer()
+                                  : (options.bridgeCpuAffinity != nullptr ? options.bridgeCpuAffinity : "");
+        const uint32_t cpuListLen = static_cast<uint32_t>(std::strlen(cpuList));
+
+        const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
+
+        fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientSetThreadPolicy);
+        fShmNonRtClientControl.writeInt(rtPrio);
+        fShmNonRtClientControl.writeUInt(cpuListLen);
+
+        if (cpuListLen != 0)
+            fShmNonRtClientControl.writeCustomData(cpuList, cpuListLen);
+
+        fShmNonRtClientControl.commitWrite();
+    }
+
 private:
     bool fInitiated;
     bool fInitError;
@@ -1804,6 +1785,10 @@ private:
     uint fProcWaitTime;
     uint fSetupHints;
 
+    // from "CarlaRtPriority" and "CarlaCpuAffinity" properties, -1 and empty for engine defaults
+    int fRtPrioOverride;
+    CarlaString fCpuAffinityOverride;
+
     CarlaPluginJackThread fBridgeThread;
 
     BridgeAudioPool          fShmAudioPool;
@@ -2000,7 +1985,7 @@ private:
             if (pData->engine->isAboutToClose() || pData->engine->wasActionCanceled())
                 break;
 
-            carla_msleep(5);
+            fShmNonRtServerControl.waitForData(5);
         }
 
         if (needsCancelableAction)
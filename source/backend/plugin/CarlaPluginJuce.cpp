@@ -51,9 +51,8 @@
 CARLA_BACKEND_START_NAMESPACE
 
 // -------------------------------------------------------------------------------------------------------------------
-// Fallback data
-
-static const ExternalMidiNote kExternalMidiNoteFallback = { -1, 0, 0 };
+// JUCE audio buffers refer to less channels than this without allocating
+static const uint32_t kMaxInPlaceChannels = 32;
 
 // -------------------------------------------------------------------------------------------------------------------
 // find all available plugin audio ports
@@ -100,6 +99,7 @@ public:
           fFormatManager(),
           fInstance(),
           fAudioBuffer(),
+          fAudioBufferRef(),
           fMidiBuffer(),
           fPosInfo(),
           fChunk(),
@@ -108,7 +108,10 @@ public:
     {
         carla_debug("CarlaPluginJuce::CarlaPluginJuce(%p, %i)", engine, id);
 
-        fMidiBuffer.ensureSize(2048);
+        pData->prog.supportsRT = true;
+
+        // enough for a full cycle of short events, so adding them never allocates; clear() keeps the storage
+        fMidiBuffer.ensureSize(kPluginMaxMidiEvents * (sizeof(int32_t) + sizeof(uint16_t) + EngineMidiEvent::kDataSize));
         fMidiBuffer.clear();
         fPosInfo.resetToDefault();
     }
@@ -216,6 +219,15 @@ public:
             options |= PLUGIN_OPTION_SKIP_SENDING_NOTES;
         }
 
+        options |= PLUGIN_OPTION_KEEP_DENORMALS;
+
+        if (pData->engine->getProccessMode() == ENGINE_PROCESS_MODE_PATCHBAY)
+            options |= PLUGIN_OPTION_DECOUPLED_BLOCKS;
+
+        // only effects can sleep, and CV inputs are not checked for silence
+        if (pData->audioIn.count != 0 && pData->cvIn.count == 0)
+            options |= PLUGIN_OPTION_AUTO_SLEEP;
+
         return options;
     }
 
@@ -706,9 +718,9 @@ public:
         fInstance->setPlayConfigDetails(static_cast<int>(aIns),
                                         static_cast<int>(aOuts),
                                         pData->engine->getSampleRate(),
-                                        static_cast<int>(pData->engine->getBufferSize()));
+                                        static_cast<int>(getBufferSize()));
 
-        bufferSizeChanged(pData->engine->getBufferSize());
+        bufferSizeChanged(getBufferSize());
         reloadPrograms(true);
 
         if (pData->active)
@@ -803,7 +815,7 @@ public:
         CARLA_SAFE_ASSERT_RETURN(fInstance != nullptr,);
 
         try {
-            fInstance->prepareToPlay(pData->engine->getSampleRate(), static_cast<int>(pData->engine->getBufferSize()));
+            fInstance->prepareToPlay(pData->engine->getSampleRate(), static_cast<int>(getBufferSize()));
         } catch(...) {}
     }
 
@@ -852,11 +864,11 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                for (RtLinkedList<ExternalMidiNote>::Itenerator it = pData->extNotes.data.begin2(); it.valid(); it.next())
+                ExternalMidiNote note = { 0, 0, 0, 0 };
+
+                while (pData->extNotes.getNextRT(note, frames))
                 {
-                    const ExternalMidiNote& note(it.getValue(kExternalMidiNoteFallback));
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                     uint8_t midiEvent[3];
@@ -864,12 +876,9 @@ public:
                     midiEvent[1] = note.note;
                     midiEvent[2] = note.velo;
 
-                    fMidiBuffer.addEvent(midiEvent, 3, 0);
+                    fMidiBuffer.addEvent(midiEvent, 3, static_cast<int>(note.time));
                 }
 
-                pData->extNotes.data.clear();
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -961,9 +970,15 @@ public:
                         }
 #endif
                         // Control plugin parameters
-                        uint32_t k;
-                        for (k=0; k < pData->param.count; ++k)
+                        const uint32_t* mappedParams = nullptr;
+                        uint32_t numMappedParams = 0;
+                        const bool useControlMap = pData->param.getMappedParameters(event.channel, ctrlEvent.param,
+                                                                                    mappedParams, numMappedParams);
+
+                        for (uint32_t m=0, end = useControlMap ? numMappedParams : pData->param.count; m < end; ++m)
                         {
+                            const uint32_t k = useControlMap ? mappedParams[m] : m;
+
                             if (pData->param.data[k].midiChannel != event.channel)
                                 continue;
                             if (pData->param.data[k].mappedControlIndex != ctrlEvent.param)
@@ -1112,8 +1127,6 @@ public:
                 } // switch (event.type)
             }
 
-            pData->postRtEvents.trySplice();
-
         } // End of Event Input
 
         // --------------------------------------------------------------------------------------------------------
@@ -1128,10 +1141,6 @@ public:
             CARLA_SAFE_ASSERT_INT(timeInfo.bbt.bar > 0, timeInfo.bbt.bar);
             CARLA_SAFE_ASSERT_INT(timeInfo.bbt.beat > 0, timeInfo.bbt.beat);
 
-            const double ppqBar  = static_cast<double>(timeInfo.bbt.beatsPerBar) * (timeInfo.bbt.bar - 1);
-            const double ppqBeat = static_cast<double>(timeInfo.bbt.beat - 1);
-            const double ppqTick = timeInfo.bbt.tick / timeInfo.bbt.ticksPerBeat;
-
             fPosInfo.bpm = timeInfo.bbt.beatsPerMinute;
 
             fPosInfo.timeSigNumerator   = static_cast<int>(timeInfo.bbt.beatsPerBar);
@@ -1140,8 +1149,8 @@ public:
             fPosInfo.timeInSamples = static_cast<int64_t>(timeInfo.frame);
             fPosInfo.timeInSeconds = static_cast<double>(fPosInfo.timeInSamples)/pData->engine->getSampleRate();
 
-            fPosInfo.ppqPosition = ppqBar + ppqBeat + ppqTick;
-            fPosInfo.ppqPositionOfLastBarStart = ppqBar;
+            fPosInfo.ppqPosition = timeInfo.bbt.ppqPos;
+            fPosInfo.ppqPositionOfLastBarStart = timeInfo.bbt.ppqBarStartPos;
         }
 
         // --------------------------------------------------------------------------------------------------------
@@ -1186,22 +1195,48 @@ public:
             return false;
         }
 
+        // program changes requested by the host while we were running
+        pData->applyDeferredProgramChangesRT(this);
+
         // --------------------------------------------------------------------------------------------------------
         // Set audio in buffers
 
-        for (uint32_t i=0; i < pData->audioIn.count; ++i)
-            fAudioBuffer.copyFrom(static_cast<int>(i), 0, inBuffer[i], static_cast<int>(frames));
+        // JUCE processes in place, let it work directly on our output buffers if there are enough of them
+        const bool inPlace = pData->audioOut.count > 0
+                          && pData->audioOut.count >= pData->audioIn.count
+                          && pData->audioOut.count < kMaxInPlaceChannels;
+
+        if (inPlace)
+        {
+            for (uint32_t i=0; i < pData->audioIn.count; ++i)
+            {
+                if (outBuffer[i] != inBuffer[i])
+                    carla_copyFloats(outBuffer[i], inBuffer[i], frames);
+            }
+            for (uint32_t i=pData->audioIn.count; i < pData->audioOut.count; ++i)
+                carla_zeroFloats(outBuffer[i], frames);
+
+            fAudioBufferRef.setDataToReferTo(outBuffer, static_cast<int>(pData->audioOut.count), static_cast<int>(frames));
+        }
+        else
+        {
+            for (uint32_t i=0; i < pData->audioIn.count; ++i)
+                fAudioBuffer.copyFrom(static_cast<int>(i), 0, inBuffer[i], static_cast<int>(frames));
+        }
 
         // --------------------------------------------------------------------------------------------------------
         // Run plugin
 
-        fInstance->processBlock(fAudioBuffer, fMidiBuffer);
+        fInstance->processBlock(inPlace ? fAudioBufferRef : fAudioBuffer, fMidiBuffer);
 
         // --------------------------------------------------------------------------------------------------------
         // Set audio out buffers
 
-        for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            carla_copyFloats(outBuffer[i], fAudioBuffer.getReadPointer(static_cast<int>(i)), frames);
+        if (! inPlace)
+        {
+            for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                carla_copyFloats(outBuffer[i], fAudioBuffer.getReadPointer(static_cast<int>(i)), frames);
+        }
 
         // --------------------------------------------------------------------------------------------------------
         // Midi out
@@ -1422,7 +1457,7 @@ public:
             try {
                 fInstance = fFormatManager.createPluginInstance(fDesc,
                                                                 pData->engine->getSampleRate(),
-                                                                static_cast<int>(pData->engine->getBufferSize()),
+                                                                static_cast<int>(getBufferSize()),
                                                                 error);
             } CARLA_SAFE_EXCEPTION("createPluginInstance")
 
@@ -1495,6 +1530,10 @@ public:
                 pData->options |= PLUGIN_OPTION_MAP_PROGRAM_CHANGES;
         }
 
+        // off by default, needs to be explicitly enabled per plugin
+        if (options & PLUGIN_OPTION_AUTO_SLEEP)
+            pData->options |= PLUGIN_OPTION_AUTO_SLEEP;
+
         return true;
     }
 
@@ -1504,6 +1543,7 @@ private:
     std::unique_ptr<juce::AudioPluginInstance> fInstance;
 
     juce::AudioSampleBuffer fAudioBuffer;
+    juce::AudioSampleBuffer fAudioBufferRef; // non-owning, wraps our output buffers for in-place processing
     juce::MidiBuffer        fMidiBuffer;
     CurrentPositionInfo     fPosInfo;
     juce::MemoryBlock       fChunk;
@@ -22,6 +22,10 @@
 #include "CarlaLadspaUtils.hpp"
 #include "CarlaDssiUtils.hpp"
 #include "CarlaMathUtils.hpp"
+#include "CarlaRtLog.hpp"
+#include "CarlaThreadPool.hpp"
+
+#include <chrono>
 
 #if defined(HAVE_LIBLO) && !defined(BUILD_BRIDGE)
 # include "CarlaOscUtils.hpp"
@@ -34,6 +38,9 @@ using water::ChildProcess;
 using water::String;
 using water::StringArray;
 
+// minimum average run time of a single instance, in seconds, for forced stereo instances to run in parallel
+static const double kParallelInstanceMinRunTime = 0.0001;
+
 #define CARLA_PLUGIN_DSSI_OSC_CHECK_OSC_TYPES(/* argc, types, */ argcToCompare, typesToCompare) \
     /* check argument count */                                                                  \
     if (argc != argcToCompare)                                                                  \
@@ -301,12 +308,17 @@ public:
           fAudioInBuffers(nullptr),
           fAudioOutBuffers(nullptr),
           fExtraStereoBuffer(),
+          fAudioBufferArena(),
           fParamBuffers(nullptr),
           fLatencyIndex(-1),
           fForcedStereoIn(false),
           fForcedStereoOut(false),
           fNeedsFixedBuffers(false),
-          fUsesCustomData(false)
+          fUsesCustomData(false),
+          fAudioConnectedDirectly(false),
+          fThreadPool(nullptr),
+          fInstanceRunTime(0.0),
+          fParallelRun()
 #if defined(HAVE_LIBLO) && !defined(BUILD_BRIDGE)
         , fOscData(),
           fThreadUI(engine, this, fOscData),
@@ -315,6 +327,8 @@ public:
     {
         carla_debug("CarlaPluginLADSPADSSI::CarlaPluginLADSPADSSI(%p, %i)", engine, id);
 
+        pData->midiprog.supportsRT = true;
+
         carla_zeroPointers(fExtraStereoBuffer, 2);
     }
 
@@ -345,6 +359,12 @@ public:
             pData->active = false;
         }
 
+        if (fThreadPool != nullptr)
+        {
+            CarlaSharedThreadPool::release(fThreadPool);
+            fThreadPool = nullptr;
+        }
+
         if (fDescriptor != nullptr)
         {
             if (fDescriptor->cleanup != nullptr)
@@ -523,6 +543,15 @@ public:
             }
         }
 
+        options |= PLUGIN_OPTION_KEEP_DENORMALS;
+
+        if (pData->engine->getProccessMode() == ENGINE_PROCESS_MODE_PATCHBAY)
+            options |= PLUGIN_OPTION_DECOUPLED_BLOCKS;
+
+        // only effects can sleep, and CV inputs are not checked for silence
+        if (pData->audioIn.count != 0 && pData->cvIn.count == 0)
+            options |= PLUGIN_OPTION_AUTO_SLEEP;
+
         return options;
     }
 
@@ -1300,7 +1329,23 @@ public:
         fForcedStereoIn  = forcedStereoIn;
         fForcedStereoOut = forcedStereoOut;
 
-        bufferSizeChanged(pData->engine->getBufferSize());
+        // worker threads for running forced stereo instances in parallel
+        if (fHandles.count() > 1 && fThreadPool == nullptr)
+        {
+            if (const uint processingThreads = pData->engine->getOptions().processingThreads)
+                fThreadPool = CarlaSharedThreadPool::acquire(std::min(processingThreads,
+                                                                      static_cast<uint>(fHandles.count() - 1)),
+                                                             pData->engine->getOptions().processingCpuAffinity);
+        }
+        else if (fHandles.count() <= 1 && fThreadPool != nullptr)
+        {
+            CarlaSharedThreadPool::release(fThreadPool);
+            fThreadPool = nullptr;
+        }
+
+        fInstanceRunTime = 0.0;
+
+        bufferSizeChanged(getBufferSize());
         reloadPrograms(true);
 
         if (pData->active)
@@ -1558,25 +1603,22 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                ExternalMidiNote note = { 0, 0, 0 };
+                ExternalMidiNote note = { 0, 0, 0, 0 };
 
-                for (; midiEventCount < kPluginMaxMidiEvents && ! pData->extNotes.data.isEmpty();)
+                for (; midiEventCount < kPluginMaxMidiEvents && pData->extNotes.getNextRT(note, frames);)
                 {
-                    note = pData->extNotes.data.getFirst(note, true);
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                     snd_seq_event_t& seqEvent(fMidiEvents[midiEventCount++]);
 
                     seqEvent.type               = (note.velo > 0) ? SND_SEQ_EVENT_NOTEON : SND_SEQ_EVENT_NOTEOFF;
+                    seqEvent.time.tick          = note.time;
                     seqEvent.data.note.channel  = static_cast<uchar>(note.channel);
                     seqEvent.data.note.note     = note.note;
                     seqEvent.data.note.velocity = note.velo;
                 }
 
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -1610,17 +1652,25 @@ public:
 
                 if (eventTime < timeOffset)
                 {
-                    carla_stderr2("Timing error, eventTime:%u < timeOffset:%u for '%s'",
-                                  eventTime, timeOffset, pData->name);
+                    carla_rt_stderr2("Timing error, eventTime:%u < timeOffset:%u for '%s'",
+                                     eventTime, timeOffset, pData->name);
                     eventTime = timeOffset;
                 }
 
                 if (isSampleAccurate && eventTime > timeOffset)
                 {
-                    if (processSingle(audioIn, audioOut, eventTime - timeOffset, timeOffset, midiEventCount))
+                    // split where the engine options allow, events in between keep their offset
+                    const uint32_t splitTime = pData->getEventSplitTime(eventTime, timeOffset, frames);
+
+                    if (splitTime <= timeOffset)
                     {
-                        startTime  = 0;
-                        timeOffset = eventTime;
+                        startTime = eventTime - timeOffset;
+                    }
+                    else if (processSingle(audioIn, audioOut, splitTime - timeOffset, timeOffset, midiEventCount))
+                    {
+                        ++pData->eventSplitCount;
+                        startTime  = eventTime - splitTime;
+                        timeOffset = splitTime;
                         midiEventCount = 0;
 
                         if (pData->midiprog.current >= 0 && pData->midiprog.count > 0)
@@ -1704,8 +1754,15 @@ public:
                         }
 #endif
                         // Control plugin parameters
-                        for (uint32_t k=0; k < pData->param.count; ++k)
+                        const uint32_t* mappedParams = nullptr;
+                        uint32_t numMappedParams = 0;
+                        const bool useControlMap = pData->param.getMappedParameters(event.channel, ctrlEvent.param,
+                                                                                    mappedParams, numMappedParams);
+
+                        for (uint32_t m=0, end = useControlMap ? numMappedParams : pData->param.count; m < end; ++m)
                         {
+                            const uint32_t k = useControlMap ? mappedParams[m] : m;
+
                             if (pData->param.data[k].midiChannel != event.channel)
                                 continue;
                             if (pData->param.data[k].mappedControlIndex != ctrlEvent.param)
@@ -1912,8 +1969,6 @@ public:
                 } // switch (event.type)
             }
 
-            pData->postRtEvents.trySplice();
-
             if (frames > timeOffset)
                 processSingle(audioIn, audioOut, frames - timeOffset, timeOffset, midiEventCount);
 
@@ -1998,59 +2053,98 @@ public:
             return false;
         }
 
+        // program changes requested by the host while we were running
+        pData->applyDeferredProgramChangesRT(this);
+
         // --------------------------------------------------------------------------------------------------------
         // Set audio buffers
 
         const bool customMonoOut   = pData->audioOut.count == 2 && fForcedStereoOut && ! fForcedStereoIn;
         const bool customStereoOut = pData->audioOut.count == 2 && fForcedStereoIn  && ! fForcedStereoOut;
 
-        if (! customMonoOut)
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+        // skip staging copies if the plugin can run on the engine buffers as-is
+        const bool processDirectly = timeOffset == 0 && fHandles.count() == 1 &&
+                                     ! (fForcedStereoIn || fForcedStereoOut || fNeedsFixedBuffers) &&
+                                     pData->canProcessDirectly();
+#else
+        const bool processDirectly = false;
+#endif
+
+        if (processDirectly)
         {
+            LADSPA_Handle const handle(fHandles.getFirst(nullptr));
+
+            for (uint32_t i=0; i < pData->audioIn.count; ++i)
+                fDescriptor->connect_port(handle, pData->audioIn.ports[i].rindex, const_cast<float*>(audioIn[i]));
+
             for (uint32_t i=0; i < pData->audioOut.count; ++i)
-                carla_zeroFloats(fAudioOutBuffers[i], frames);
+            {
+                carla_zeroFloats(audioOut[i], frames);
+                fDescriptor->connect_port(handle, pData->audioOut.ports[i].rindex, audioOut[i]);
+            }
+
+            fAudioConnectedDirectly = true;
         }
+        else
+        {
+            if (fAudioConnectedDirectly)
+                reconnectAudioPorts();
 
-        for (uint32_t i=0; i < pData->audioIn.count; ++i)
-            carla_copyFloats(fAudioInBuffers[i], audioIn[i]+timeOffset, frames);
+            if (! customMonoOut)
+            {
+                for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                    carla_zeroFloats(fAudioOutBuffers[i], frames);
+            }
+
+            for (uint32_t i=0; i < pData->audioIn.count; ++i)
+                carla_copyFloats(fAudioInBuffers[i], audioIn[i]+timeOffset, frames);
+        }
 
         // --------------------------------------------------------------------------------------------------------
         // Run plugin
 
-        uint instn = 0;
-        for (LinkedList<LADSPA_Handle>::Itenerator it = fHandles.begin2(); it.valid(); it.next(), ++instn)
+        const std::size_t instanceCount = fHandles.count();
+
+        if (instanceCount > 1 && fThreadPool != nullptr && fInstanceRunTime >= kParallelInstanceMinRunTime)
         {
-            LADSPA_Handle const handle(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(handle != nullptr);
+            fParallelRun.frames          = frames;
+            fParallelRun.midiEventCount  = midiEventCount;
+            fParallelRun.customMonoOut   = customMonoOut;
+            fParallelRun.customStereoOut = customStereoOut;
+            fParallelRun.nextInstance    = 0;
+            fParallelRun.callerRunTime   = 0.0;
+            fParallelRun.callerRunCount  = 0;
 
-            // ----------------------------------------------------------------------------------------------------
-            // Mixdown for forced stereo
+            // returns once all instances are done
+            fThreadPool->run(runInstancesCallback, this, static_cast<uint>(instanceCount - 1));
 
-            if (customMonoOut)
-                carla_zeroFloats(fAudioOutBuffers[instn], frames);
+            if (fParallelRun.callerRunCount != 0)
+                updateInstanceRunTime(fParallelRun.callerRunTime / fParallelRun.callerRunCount);
+        }
+        else
+        {
+            // keep track of the instance run time, to know when to switch to parallel runs
+            const bool measureRunTime = instanceCount > 1 && fThreadPool != nullptr;
+            std::chrono::steady_clock::time_point start;
 
-            // ----------------------------------------------------------------------------------------------------
-            // Run it
+            if (measureRunTime)
+                start = std::chrono::steady_clock::now();
 
-            if (fDssiDescriptor != nullptr && fDssiDescriptor->run_synth != nullptr)
+            uint instn = 0;
+            for (LinkedList<LADSPA_Handle>::Itenerator it = fHandles.begin2(); it.valid(); it.next(), ++instn)
             {
-                try {
-                    fDssiDescriptor->run_synth(handle, frames, fMidiEvents, midiEventCount);
-                } CARLA_SAFE_EXCEPTION("LADSPA/DSSI run_synth");
+                LADSPA_Handle const handle(it.getValue(nullptr));
+                CARLA_SAFE_ASSERT_CONTINUE(handle != nullptr);
+
+                runInstance(handle, instn, frames, midiEventCount, customMonoOut, customStereoOut);
             }
-            else
+
+            if (measureRunTime)
             {
-                try {
-                    fDescriptor->run(handle, frames);
-                } CARLA_SAFE_EXCEPTION("LADSPA/DSSI run");
+                const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                updateInstanceRunTime(elapsed.count() / static_cast<double>(instanceCount));
             }
-
-            // ----------------------------------------------------------------------------------------------------
-            // Mixdown for forced stereo
-
-            if (customMonoOut)
-                carla_multiply(fAudioOutBuffers[instn], 0.5f, frames);
-            else if (customStereoOut)
-                carla_copyFloats(fExtraStereoBuffer[instn], fAudioOutBuffers[instn], frames);
         }
 
         if (customStereoOut)
@@ -2063,119 +2157,103 @@ public:
         // --------------------------------------------------------------------------------------------------------
         // Post-processing (dry/wet, volume and balance)
 
-        {
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-            const bool isMono    = (pData->audioIn.count == 1);
-
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    const uint32_t c = isMono ? 0 : i;
+        if (! processDirectly)
+            pData->processPostProc(fAudioInBuffers, 0, true, fAudioOutBuffers, audioOut, timeOffset, frames);
 
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
 # ifndef BUILD_BRIDGE
-                        if (k < pData->latency.frames && pData->latency.buffers != nullptr)
-                            bufValue = pData->latency.buffers[c][k];
-                        else if (pData->latency.frames < frames)
-                            bufValue = fAudioInBuffers[c][k-pData->latency.frames];
-                        else
-# endif
-                            bufValue = fAudioInBuffers[c][k];
+        // --------------------------------------------------------------------------------------------------------
+        // Save latency values for next callback
 
-                        fAudioOutBuffers[i][k] = (fAudioOutBuffers[i][k] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
+        CARLA_SAFE_ASSERT(pData->latency.frames == 0 || timeOffset == 0);
+        pData->latency.saveInputs(audioIn, pData->audioIn.count, frames);
+# endif
+#else // BUILD_BRIDGE_ALTERNATIVE_ARCH
+        for (uint32_t i=0; i < pData->audioOut.count; ++i)
+        {
+            for (uint32_t k=0; k < frames; ++k)
+                audioOut[i][k+timeOffset] = fAudioOutBuffers[i][k];
+        }
+#endif
 
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
+        // --------------------------------------------------------------------------------------------------------
 
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        carla_copyFloats(oldBufLeft, fAudioOutBuffers[i], frames);
-                    }
+        pData->singleMutex.unlock();
+        return true;
+    }
 
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
+    void runInstance(LADSPA_Handle const handle, const uint instn, const uint32_t frames, const ulong midiEventCount,
+                     const bool customMonoOut, const bool customStereoOut)
+    {
+        // --------------------------------------------------------------------------------------------------------
+        // Mixdown for forced stereo
 
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            fAudioOutBuffers[i][k]  = oldBufLeft[k]            * (1.0f - balRangeL);
-                            fAudioOutBuffers[i][k] += fAudioOutBuffers[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            fAudioOutBuffers[i][k]  = fAudioOutBuffers[i][k] * balRangeR;
-                            fAudioOutBuffers[i][k] += oldBufLeft[k]          * balRangeL;
-                        }
-                    }
-                }
+        if (customMonoOut)
+            carla_zeroFloats(fAudioOutBuffers[instn], frames);
 
-                // Volume (and buffer copy)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        audioOut[i][k+timeOffset] = fAudioOutBuffers[i][k] * pData->postProc.volume;
-                }
-            }
+        // --------------------------------------------------------------------------------------------------------
+        // Run it
 
-        } // End of Post-processing
+        if (fDssiDescriptor != nullptr && fDssiDescriptor->run_synth != nullptr)
+        {
+            try {
+                fDssiDescriptor->run_synth(handle, frames, fMidiEvents, midiEventCount);
+            } CARLA_SAFE_EXCEPTION("LADSPA/DSSI run_synth");
+        }
+        else
+        {
+            try {
+                fDescriptor->run(handle, frames);
+            } CARLA_SAFE_EXCEPTION("LADSPA/DSSI run");
+        }
 
-# ifndef BUILD_BRIDGE
         // --------------------------------------------------------------------------------------------------------
-        // Save latency values for next callback
+        // Mixdown for forced stereo
 
-        if (pData->latency.frames != 0 && pData->latency.buffers != nullptr)
+        if (customMonoOut)
+            carla_multiply(fAudioOutBuffers[instn], 0.5f, frames);
+        else if (customStereoOut)
+            carla_copyFloats(fExtraStereoBuffer[instn], fAudioOutBuffers[instn], frames);
+    }
+
+    // thread pool job, every participating thread takes instances until none are left
+    static void runInstancesCallback(void* const ptr, const uint threadIndex)
+    {
+        CarlaPluginLADSPADSSI* const self = static_cast<CarlaPluginLADSPADSSI*>(ptr);
+        ParallelRun& prun(self->fParallelRun);
+
+        for (;;)
         {
-            CARLA_SAFE_ASSERT(timeOffset == 0);
-            const uint32_t latframes = pData->latency.frames;
+            const uint instn = static_cast<uint>(__sync_fetch_and_add(&prun.nextInstance, 1));
+
+            if (instn >= self->fHandles.count())
+                break;
+
+            LADSPA_Handle const handle(self->fHandles.getAt(instn, nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(handle != nullptr);
 
-            if (latframes <= frames)
+            if (threadIndex != 0)
             {
-                for (uint32_t i=0; i < pData->audioIn.count; ++i)
-                    carla_copyFloats(pData->latency.buffers[i], audioIn[i]+(frames-latframes), latframes);
+                self->runInstance(handle, instn, prun.frames, prun.midiEventCount,
+                                  prun.customMonoOut, prun.customStereoOut);
+                continue;
             }
-            else
-            {
-                const uint32_t diff = latframes - frames;
 
-                for (uint32_t i=0, k; i<pData->audioIn.count; ++i)
-                {
-                    // push back buffer by 'frames'
-                    for (k=0; k < diff; ++k)
-                        pData->latency.buffers[i][k] = pData->latency.buffers[i][k+frames];
+            // only the calling thread keeps track of run time
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-                    // put current input at the end
-                    for (uint32_t j=0; k < latframes; ++j, ++k)
-                        pData->latency.buffers[i][k] = audioIn[i][j];
-                }
-            }
-        }
-# endif
-#else // BUILD_BRIDGE_ALTERNATIVE_ARCH
-        for (uint32_t i=0; i < pData->audioOut.count; ++i)
-        {
-            for (uint32_t k=0; k < frames; ++k)
-                audioOut[i][k+timeOffset] = fAudioOutBuffers[i][k];
-        }
-#endif
+            self->runInstance(handle, instn, prun.frames, prun.midiEventCount,
+                              prun.customMonoOut, prun.customStereoOut);
 
-        // --------------------------------------------------------------------------------------------------------
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            prun.callerRunTime += elapsed.count();
+            ++prun.callerRunCount;
+        }
+    }
 
-        pData->singleMutex.unlock();
-        return true;
+    void updateInstanceRunTime(const double runTime) noexcept
+    {
+        // smoothed, so a single slow cycle does not switch modes
+        fInstanceRunTime = fInstanceRunTime * 0.9 + runTime * 0.1;
     }
 
     void bufferSizeChanged(const uint32_t newBufferSize) override
@@ -2183,42 +2261,24 @@ public:
         CARLA_ASSERT_INT(newBufferSize > 0, newBufferSize);
         carla_debug("CarlaPluginLADSPADSSI::bufferSizeChanged(%i) - start", newBufferSize);
 
-        for (uint32_t i=0; i < pData->audioIn.count; ++i)
-        {
-            if (fAudioInBuffers[i] != nullptr)
-                delete[] fAudioInBuffers[i];
-
-            fAudioInBuffers[i] = new float[newBufferSize];
-            carla_zeroFloats(fAudioInBuffers[i], newBufferSize);
-        }
+        const bool needsExtraStereo = fForcedStereoIn && pData->audioOut.count == 2;
 
-        for (uint32_t i=0; i < pData->audioOut.count; ++i)
-        {
-            if (fAudioOutBuffers[i] != nullptr)
-                delete[] fAudioOutBuffers[i];
+        fAudioBufferArena.reset(pData->audioIn.count + pData->audioOut.count + (needsExtraStereo ? 2 : 0), newBufferSize);
 
-            fAudioOutBuffers[i] = new float[newBufferSize];
-            carla_zeroFloats(fAudioOutBuffers[i], newBufferSize);
-        }
+        for (uint32_t i=0; i < pData->audioIn.count; ++i)
+            fAudioInBuffers[i] = fAudioBufferArena.allocate();
 
-        if (fExtraStereoBuffer[0] != nullptr)
-        {
-            delete[] fExtraStereoBuffer[0];
-            fExtraStereoBuffer[0] = nullptr;
-        }
+        for (uint32_t i=0; i < pData->audioOut.count; ++i)
+            fAudioOutBuffers[i] = fAudioBufferArena.allocate();
 
-        if (fExtraStereoBuffer[1] != nullptr)
+        if (needsExtraStereo)
         {
-            delete[] fExtraStereoBuffer[1];
-            fExtraStereoBuffer[1] = nullptr;
+            fExtraStereoBuffer[0] = fAudioBufferArena.allocate();
+            fExtraStereoBuffer[1] = fAudioBufferArena.allocate();
         }
-
-        if (fForcedStereoIn && pData->audioOut.count == 2)
+        else
         {
-            fExtraStereoBuffer[0] = new float[newBufferSize];
-            fExtraStereoBuffer[1] = new float[newBufferSize];
-            carla_zeroFloats(fExtraStereoBuffer[0], newBufferSize);
-            carla_zeroFloats(fExtraStereoBuffer[1], newBufferSize);
+            fExtraStereoBuffer[0] = fExtraStereoBuffer[1] = nullptr;
         }
 
         reconnectAudioPorts();
@@ -2264,8 +2324,10 @@ public:
         carla_debug("CarlaPluginLADSPADSSI::sampleRateChanged(%g) - end", newSampleRate);
     }
 
-    void reconnectAudioPorts() const noexcept
+    void reconnectAudioPorts() noexcept
     {
+        fAudioConnectedDirectly = false;
+
         if (fForcedStereoIn)
         {
             if (LADSPA_Handle const handle = fHandles.getFirst(nullptr))
@@ -2340,45 +2402,18 @@ public:
 
         if (fAudioInBuffers != nullptr)
         {
-            for (uint32_t i=0; i < pData->audioIn.count; ++i)
-            {
-                if (fAudioInBuffers[i] != nullptr)
-                {
-                    delete[] fAudioInBuffers[i];
-                    fAudioInBuffers[i] = nullptr;
-                }
-            }
-
             delete[] fAudioInBuffers;
             fAudioInBuffers = nullptr;
         }
 
         if (fAudioOutBuffers != nullptr)
         {
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                if (fAudioOutBuffers[i] != nullptr)
-                {
-                    delete[] fAudioOutBuffers[i];
-                    fAudioOutBuffers[i] = nullptr;
-                }
-            }
-
             delete[] fAudioOutBuffers;
             fAudioOutBuffers = nullptr;
         }
 
-        if (fExtraStereoBuffer[0] != nullptr)
-        {
-            delete[] fExtraStereoBuffer[0];
-            fExtraStereoBuffer[0] = nullptr;
-        }
-
-        if (fExtraStereoBuffer[1] != nullptr)
-        {
-            delete[] fExtraStereoBuffer[1];
-            fExtraStereoBuffer[1] = nullptr;
-        }
+        fExtraStereoBuffer[0] = fExtraStereoBuffer[1] = nullptr;
+        fAudioBufferArena.reset(0, 0);
 
         if (fParamBuffers != nullptr)
         {
@@ -3047,6 +3082,10 @@ public:
             }
         }
 
+        // off by default, needs to be explicitly enabled per plugin
+        if (options & PLUGIN_OPTION_AUTO_SLEEP)
+            pData->options |= PLUGIN_OPTION_AUTO_SLEEP;
+
         return true;
     }
 
@@ -3061,6 +3100,7 @@ private:
     float** fAudioInBuffers;
     float** fAudioOutBuffers;
     float*  fExtraStereoBuffer[2]; // used only if forcedStereoIn and audioOut == 2
+    EngineAudioBufferArena fAudioBufferArena;
     float*  fParamBuffers;
 
     snd_seq_event_t fMidiEvents[kPluginMaxMidiEvents];
@@ -3070,6 +3110,30 @@ private:
     bool    fForcedStereoOut;
     bool    fNeedsFixedBuffers;
     bool    fUsesCustomData;
+    bool    fAudioConnectedDirectly;
+
+    // forced stereo instances run on these when slow enough, see kParallelInstanceMinRunTime
+    CarlaThreadPool* fThreadPool;
+    double fInstanceRunTime;
+
+    struct ParallelRun {
+        uint32_t frames;
+        ulong midiEventCount;
+        bool customMonoOut;
+        bool customStereoOut;
+        volatile int nextInstance;
+        double callerRunTime;
+        uint callerRunCount;
+
+        ParallelRun() noexcept
+            : frames(0),
+              midiEventCount(0),
+              customMonoOut(false),
+              customStereoOut(false),
+              nextInstance(0),
+              callerRunTime(0.0),
+              callerRunCount(0) {}
+    } fParallelRun;
 
 #if defined(HAVE_LIBLO) && !defined(BUILD_BRIDGE)
     CarlaOscData      fOscData;
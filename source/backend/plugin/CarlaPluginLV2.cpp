@@ -29,7 +29,9 @@
 #include "CarlaEngineUtils.hpp"
 #include "CarlaPipeUtils.hpp"
 #include "CarlaPluginUI.hpp"
+#include "CarlaRtLog.hpp"
 #include "CarlaScopeUtils.hpp"
+#include "CarlaThreadPool.hpp"
 #include "Lv2AtomRingBuffer.hpp"
 
 #include "../modules/lilv/config/lilv_config.h"
@@ -44,6 +46,12 @@ extern "C" {
 #include <string>
 #include <vector>
 
+#ifndef CARLA_OS_WIN
+# include <fcntl.h>
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
 using water::File;
 
 #define URI_CARLA_ATOM_WORKER_IN   "http://kxstudio.sf.net/ns/carla/atomWorkerIn"
@@ -56,7 +64,6 @@ CARLA_BACKEND_START_NAMESPACE
 
 static const CustomData       kCustomDataFallback       = { nullptr, nullptr, nullptr };
 static /* */ CustomData       kCustomDataFallbackNC     = { nullptr, nullptr, nullptr };
-static const ExternalMidiNote kExternalMidiNoteFallback = { -1, 0, 0 };
 static const char* const      kUnmapFallback            = "urn:null";
 
 // -------------------------------------------------------------------------------------------------------------------
@@ -322,6 +329,68 @@ struct CarlaPluginLV2EventData {
     CARLA_DECLARE_NON_COPY_STRUCT(CarlaPluginLV2EventData)
 };
 
+// -------------------------------------------------------------------------------------------------------------------
+// Runs a plugin at a fixed block size when the engine cannot provide it, see CarlaPluginLV2::runFixedBlock().
+// Engine cycles are gathered until a block is complete, outputs are taken from the previous block.
+// This adds exactly one block of latency, which is reported as part of the plugin latency.
+
+struct CarlaPluginLV2FixedBlock {
+    uint32_t size;      // 0 when not in use
+    uint32_t fill;      // frames gathered for the next run
+    bool pendingEvents; // input atom sequences are holding events for the next run
+    float** audioOut;   // outputs for the current engine cycle
+    float** cvOut;
+
+    CarlaPluginLV2FixedBlock() noexcept
+        : size(0),
+          fill(0),
+          pendingEvents(false),
+          audioOut(nullptr),
+          cvOut(nullptr) {}
+
+    ~CarlaPluginLV2FixedBlock() noexcept
+    {
+        clear();
+    }
+
+    void createNew(const uint32_t aOuts, const uint32_t cvOuts)
+    {
+        CARLA_SAFE_ASSERT_RETURN(audioOut == nullptr && cvOut == nullptr,);
+
+        if (aOuts > 0)
+        {
+            audioOut = new float*[aOuts];
+            carla_zeroPointers(audioOut, aOuts);
+        }
+
+        if (cvOuts > 0)
+        {
+            cvOut = new float*[cvOuts];
+            carla_zeroPointers(cvOut, cvOuts);
+        }
+    }
+
+    void clear() noexcept
+    {
+        size = fill = 0;
+        pendingEvents = false;
+
+        if (audioOut != nullptr)
+        {
+            delete[] audioOut;
+            audioOut = nullptr;
+        }
+
+        if (cvOut != nullptr)
+        {
+            delete[] cvOut;
+            cvOut = nullptr;
+        }
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(CarlaPluginLV2FixedBlock)
+};
+
 // -------------------------------------------------------------------------------------------------------------------
 
 struct CarlaPluginLV2Options {
@@ -444,126 +513,1046 @@ struct CarlaPluginLV2Options {
         optWindowTitle.type    = kUridAtomString;
         optWindowTitle.value   = nullptr;
 
-        LV2_Options_Option& optNull(opts[Null]);
-        optNull.context = LV2_OPTIONS_INSTANCE;
-        optNull.subject = 0;
-        optNull.key     = kUridNull;
-        optNull.size    = 0;
-        optNull.type    = kUridNull;
-        optNull.value   = nullptr;
+        LV2_Options_Option& optNull(opts[Null]);
+        optNull.context = LV2_OPTIONS_INSTANCE;
+        optNull.subject = 0;
+        optNull.key     = kUridNull;
+        optNull.size    = 0;
+        optNull.type    = kUridNull;
+        optNull.value   = nullptr;
+    }
+
+    ~CarlaPluginLV2Options() noexcept
+    {
+        LV2_Options_Option& optWindowTitle(opts[WindowTitle]);
+
+        optWindowTitle.size  = 0;
+        optWindowTitle.value = nullptr;
+
+        if (windowTitle != nullptr)
+        {
+            std::free(const_cast<char*>(windowTitle));
+            windowTitle = nullptr;
+        }
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(CarlaPluginLV2Options);
+};
+
+// -------------------------------------------------------------------------------------------------------------------
+
+class CarlaPluginLV2;
+
+#ifndef CARLA_OS_WIN
+// -------------------------------------------------------------------------------------------------------------------
+// UI bridge processes shared by all LV2 plugins
+
+/*
+ * A single UI bridge process hosting the UIs of several plugins, one per bridge binary (and so per toolkit).
+ * Every UI keeps its own pipe server, the client side of its pipes is passed to the process over a socket.
+ * The process is started with the first UI and stopped with the last one.
+ */
+class CarlaLv2SharedUiHost : public CarlaPipeServer
+{
+public:
+    static CarlaLv2SharedUiHost* acquire(CarlaEngine* const engine, const char* const filename) noexcept
+    {
+        const CarlaMutexLocker cml(getHostsMutex());
+        LinkedList<CarlaLv2SharedUiHost*>& hosts(getHosts());
+
+        for (LinkedList<CarlaLv2SharedUiHost*>::Itenerator it = hosts.begin2(); it.valid(); it.next())
+        {
+            CarlaLv2SharedUiHost* const host(it.getValue(nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(host != nullptr);
+
+            // a process that stopped responding is left to its current users
+            if (host->fDead || host->fFilename != filename)
+                continue;
+
+            ++host->fRefCount;
+            return host;
+        }
+
+        CarlaLv2SharedUiHost* const host(new CarlaLv2SharedUiHost(filename));
+
+        if (! host->start(engine))
+        {
+            delete host;
+            return nullptr;
+        }
+
+        hosts.append(host);
+        return host;
+    }
+
+    static void release(CarlaLv2SharedUiHost* const host) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(host != nullptr,);
+
+        const CarlaMutexLocker cml(getHostsMutex());
+        CARLA_SAFE_ASSERT_RETURN(host->fRefCount > 0,);
+
+        if (--host->fRefCount != 0)
+            return;
+
+        getHosts().removeOne(host);
+        delete host;
+    }
+
+    /*
+     * Open a new UI in this process, connected to @a pipeServer.
+     */
+    bool startUI(CarlaPipeServer& pipeServer, const char* const pluginURI, const char* const uiURI,
+                 const char* const sampleRateStr, const int size) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(! fDead, false);
+
+        // plugin URI, UI URI and sample rate, each null-terminated
+        const std::size_t pluginURILen = std::strlen(pluginURI) + 1;
+        const std::size_t uiURILen = std::strlen(uiURI) + 1;
+        const std::size_t sampleRateLen = std::strlen(sampleRateStr) + 1;
+        CARLA_SAFE_ASSERT_RETURN(pluginURILen + uiURILen + sampleRateLen <= sizeof(fRequest), false);
+
+        std::memcpy(fRequest, pluginURI, pluginURILen);
+        std::memcpy(fRequest + pluginURILen, uiURI, uiURILen);
+        std::memcpy(fRequest + pluginURILen + uiURILen, sampleRateStr, sampleRateLen);
+        fRequestSize = pluginURILen + uiURILen + sampleRateLen;
+
+        return pipeServer.startPipeServerWithSharedClient(sendClientPipes, this, size);
+    }
+
+protected:
+    // nothing is expected from the process itself
+    bool msgReceived(const char* const) noexcept override
+    {
+        return true;
+    }
+
+private:
+    const CarlaString fFilename;
+    int fSocket;
+    uint fRefCount;
+    bool fDead;
+
+    char fRequest[2048];
+    std::size_t fRequestSize;
+
+    CarlaLv2SharedUiHost(const char* const filename) noexcept
+        : CarlaPipeServer(),
+          fFilename(filename),
+          fSocket(-1),
+          fRefCount(1),
+          fDead(false),
+          fRequest(),
+          fRequestSize(0) {}
+
+    ~CarlaLv2SharedUiHost() noexcept override
+    {
+        stopPipeServer(5*1000);
+
+        if (fSocket != -1)
+            ::close(fSocket);
+    }
+
+    bool start(CarlaEngine* const engine) noexcept
+    {
+        int fds[2];
+
+        if (::socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) != 0)
+        {
+            carla_stderr2("CarlaLv2SharedUiHost: socket creation failed");
+            return false;
+        }
+
+        // only the process we start here must see the other end
+        ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+
+        char socketStr[32];
+        std::snprintf(socketStr, 31, "%i", fds[1]);
+        socketStr[31] = '\0';
+
+        bool started;
+
+        {
+            const ScopedEngineEnvironmentLocker _seel(engine);
+            const CarlaScopedEnvVar _sev1("LV2_PATH", engine->getOptions().pathLV2);
+#ifdef CARLA_OS_LINUX
+            const CarlaScopedEnvVar _sev2("LD_PRELOAD", nullptr);
+#endif
+            started = startPipeServer(fFilename, "--shared-ui-host", socketStr);
+        }
+
+        ::close(fds[1]);
+
+        if (! started)
+        {
+            ::close(fds[0]);
+            return false;
+        }
+
+        fSocket = fds[0];
+        return true;
+    }
+
+    static bool sendClientPipes(void* const ptr, const int pipeRecv, const int pipeSend)
+    {
+        CarlaLv2SharedUiHost* const self = static_cast<CarlaLv2SharedUiHost*>(ptr);
+
+        const int fds[2] = { pipeRecv, pipeSend };
+        char control[CMSG_SPACE(sizeof(fds))];
+        carla_zeroChars(control, sizeof(control));
+
+        struct iovec iov;
+        iov.iov_base = self->fRequest;
+        iov.iov_len  = self->fRequestSize;
+
+        struct msghdr msg;
+        carla_zeroStruct(msg);
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+
+        struct cmsghdr* const cmsg(CMSG_FIRSTHDR(&msg));
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type  = SCM_RIGHTS;
+        cmsg->cmsg_len   = CMSG_LEN(sizeof(fds));
+        std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+
+        if (::sendmsg(self->fSocket, &msg, flags) == static_cast<ssize_t>(self->fRequestSize))
+            return true;
+
+        self->fDead = true;
+        return false;
+    }
+
+    static CarlaMutex& getHostsMutex() noexcept
+    {
+        static CarlaMutex mutex;
+        return mutex;
+    }
+
+    static LinkedList<CarlaLv2SharedUiHost*>& getHosts() noexcept
+    {
+        static LinkedList<CarlaLv2SharedUiHost*> hosts;
+        return hosts;
+    }
+
+    CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaLv2SharedUiHost)
+};
+#endif
+
+// -------------------------------------------------------------------------------------------------------------------
+
+class CarlaPipeServerLV2 : public CarlaPipeServer
+{
+public:
+    enum UiState {
+        UiNone = 0,
+        UiHide,
+        UiShow,
+        UiCrashed
+    };
+
+    CarlaPipeServerLV2(CarlaEngine* const engine, CarlaPluginLV2* const plugin)
+        : kEngine(engine),
+          kPlugin(plugin),
+          fFilename(),
+          fPluginURI(),
+          fUiURI(),
+          fUiState(UiNone)
+#ifndef CARLA_OS_WIN
+        , fSharedHost(nullptr)
+#endif
+    {}
+
+    ~CarlaPipeServerLV2() noexcept override
+    {
+        CARLA_SAFE_ASSERT_INT(fUiState == UiNone, fUiState);
+
+        stopPipeServer(5*1000);
+    }
+
+    UiState getAndResetUiState() noexcept
+    {
+        const UiState uiState(fUiState);
+        fUiState = UiNone;
+        return uiState;
+    }
+
+    void setData(const char* const filename, const char* const pluginURI, const char* const uiURI) noexcept
+    {
+        fFilename  = filename;
+        fPluginURI = pluginURI;
+        fUiURI     = uiURI;
+    }
+
+    bool startPipeServer(const int size) noexcept
+    {
+        const CarlaFloatString sampleRateStr(kEngine->getSampleRate());
+
+#ifndef CARLA_OS_WIN
+        if (kEngine->getOptions().shareUiBridges)
+        {
+            CARLA_SAFE_ASSERT(fSharedHost == nullptr);
+
+            if ((fSharedHost = CarlaLv2SharedUiHost::acquire(kEngine, fFilename)) != nullptr)
+            {
+                if (fSharedHost->startUI(*this, fPluginURI, fUiURI, sampleRateStr.buffer, size))
+                    return true;
+
+                carla_stderr("Failed to open UI in a shared bridge process, starting a separate one instead");
+                CarlaLv2SharedUiHost::release(fSharedHost);
+                fSharedHost = nullptr;
+            }
+        }
+#endif
+
+        const ScopedEngineEnvironmentLocker _seel(kEngine);
+        const CarlaScopedEnvVar _sev1("LV2_PATH", kEngine->getOptions().pathLV2);
+#ifdef CARLA_OS_LINUX
+        const CarlaScopedEnvVar _sev2("LD_PRELOAD", nullptr);
+#endif
+        carla_setenv("CARLA_SAMPLE_RATE", sampleRateStr.buffer);
+
+        return CarlaPipeServer::startPipeServer(fFilename, fPluginURI, fUiURI, size);
+    }
+
+    void stopPipeServer(const uint32_t timeOutMilliseconds) noexcept
+    {
+        CarlaPipeServer::stopPipeServer(timeOutMilliseconds);
+
+#ifndef CARLA_OS_WIN
+        if (fSharedHost != nullptr)
+        {
+            CarlaLv2SharedUiHost::release(fSharedHost);
+            fSharedHost = nullptr;
+        }
+#endif
+    }
+
+    uintptr_t getPID() const noexcept
+    {
+#ifndef CARLA_OS_WIN
+        if (fSharedHost != nullptr)
+            return fSharedHost->getPID();
+#endif
+        return CarlaPipeServer::getPID();
+    }
+
+    void writeUiTitleMessage(const char* const title) const noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(title != nullptr && title[0] != '\0',);
+
+        const CarlaMutexLocker cml(getPipeLock());
+
+        if (! _writeMsgBuffer("uiTitle\n", 8))
+            return;
+        if (! writeAndFixMessage(title))
+            return;
+
+        flushMessages();
+    }
+
+protected:
+    // returns true if msg was handled
+    bool msgReceived(const char* const msg) noexcept override;
+
+private:
+    CarlaEngine*    const kEngine;
+    CarlaPluginLV2* const kPlugin;
+
+    CarlaString fFilename;
+    CarlaString fPluginURI;
+    CarlaString fUiURI;
+    UiState     fUiState;
+#ifndef CARLA_OS_WIN
+    CarlaLv2SharedUiHost* fSharedHost;
+#endif
+
+    CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaPipeServerLV2)
+};
+
+// -------------------------------------------------------------------------------------------------------------------
+// Worker threads shared by all LV2 plugins
+
+/*
+ * Runs scheduled LV2 work as soon as it arrives, instead of waiting for the next idle call.
+ * Plugins are served concurrently, but work for a single plugin never runs in parallel with itself.
+ * Threads are started with the first client and stopped with the last one.
+ */
+class CarlaLv2WorkerPool
+{
+public:
+    class Client
+    {
+    public:
+        Client() noexcept
+            : fPool(nullptr),
+              fWorkPending(0),
+              fWorkBusy(0) {}
+
+        virtual ~Client()
+        {
+            CARLA_SAFE_ASSERT(fPool == nullptr);
+        }
+
+    protected:
+        /*
+         * Called from a worker thread when work was scheduled.
+         */
+        virtual void runScheduledWork() = 0;
+
+        bool addToWorkerPool() noexcept
+        {
+            CARLA_SAFE_ASSERT_RETURN(fPool == nullptr, true);
+
+            fPool = CarlaLv2WorkerPool::addClient(this);
+            return fPool != nullptr;
+        }
+
+        void removeFromWorkerPool() noexcept
+        {
+            if (fPool == nullptr)
+                return;
+
+            CarlaLv2WorkerPool::removeClient(this);
+            fPool = nullptr;
+        }
+
+        bool isInWorkerPool() const noexcept
+        {
+            return fPool != nullptr;
+        }
+
+        /*
+         * Wake up a worker for this client, safe to call from RT.
+         */
+        void scheduleWork() noexcept
+        {
+            CARLA_SAFE_ASSERT_RETURN(fPool != nullptr,);
+
+            __sync_fetch_and_or(&fWorkPending, 1);
+            fPool->wakeUp();
+        }
+
+        /*
+         * Prevent workers from running work for this client, waiting for any current work to finish.
+         */
+        void suspendWork() noexcept
+        {
+            while (! __sync_bool_compare_and_swap(&fWorkBusy, 0, 1))
+                carla_msleep(1);
+        }
+
+        void resumeWork() noexcept
+        {
+            __sync_lock_release(&fWorkBusy);
+
+            if (fPool != nullptr && fWorkPending != 0)
+                fPool->wakeUp();
+        }
+
+    private:
+        CarlaLv2WorkerPool* fPool;
+        volatile int fWorkPending;
+        volatile int fWorkBusy;
+
+        friend class CarlaLv2WorkerPool;
+        CARLA_DECLARE_NON_COPY_CLASS(Client)
+    };
+
+private:
+    class Worker : public CarlaThread
+    {
+    public:
+        Worker(CarlaLv2WorkerPool* const pool) noexcept
+            : CarlaThread("CarlaLv2Worker"),
+              fPool(pool) {}
+
+        ~Worker() noexcept override
+        {
+            stopThread(-1);
+        }
+
+    protected:
+        void run() noexcept override
+        {
+            for (; ! shouldThreadExit();)
+            {
+                if (! carla_sem_timedwait(fPool->fSem, 100))
+                    continue;
+
+                // allow new wake-ups from now on, anything scheduled before this is picked up below
+                __sync_bool_compare_and_swap(&fPool->fWakeUp, 1, 0);
+
+                fPool->runPendingWork();
+            }
+        }
+
+    private:
+        CarlaLv2WorkerPool* const fPool;
+
+        CARLA_DECLARE_NON_COPY_CLASS(Worker)
+    };
+
+    CarlaLv2WorkerPool() noexcept
+        : fSem(),
+          fWakeUp(0),
+          fClientsMutex(),
+          fClients(),
+          fWorkers(nullptr),
+          fNumWorkers(0)
+    {
+        carla_sem_create2(fSem, false);
+    }
+
+    ~CarlaLv2WorkerPool() noexcept
+    {
+        CARLA_SAFE_ASSERT(fClients.isEmpty());
+
+        for (uint i=0; i < fNumWorkers; ++i)
+            delete fWorkers[i];
+
+        delete[] fWorkers;
+        carla_sem_destroy2(fSem);
+    }
+
+    bool start() noexcept
+    {
+        const uint numCPUs = CarlaThreadPool::getNumCPUs();
+        const uint numWorkers = numCPUs > 2 ? std::min(numCPUs - 1, 4U) : 1U;
+
+        try {
+            fWorkers = new Worker*[numWorkers];
+        } CARLA_SAFE_EXCEPTION_RETURN("CarlaLv2WorkerPool::start", false);
+
+        for (uint i=0; i < numWorkers; ++i)
+        {
+            Worker* const worker(new Worker(this));
+
+            if (! worker->startThread())
+            {
+                delete worker;
+                continue;
+            }
+
+            fWorkers[fNumWorkers++] = worker;
+        }
+
+        return fNumWorkers != 0;
+    }
+
+    void wakeUp() noexcept
+    {
+        // the semaphore can only be posted once, the first worker to wake up clears this again
+        if (__sync_bool_compare_and_swap(&fWakeUp, 0, 1))
+            carla_sem_post(fSem);
+    }
+
+    void runPendingWork() noexcept
+    {
+        for (;;)
+        {
+            Client* client = nullptr;
+
+            {
+                const CarlaMutexLocker cml(fClientsMutex);
+
+                for (LinkedList<Client*>::Itenerator it = fClients.begin2(); it.valid(); it.next())
+                {
+                    Client* const c(it.getValue(nullptr));
+                    CARLA_SAFE_ASSERT_CONTINUE(c != nullptr);
+
+                    if (c->fWorkPending == 0)
+                        continue;
+                    // being served by another worker, which checks again when done
+                    if (! __sync_bool_compare_and_swap(&c->fWorkBusy, 0, 1))
+                        continue;
+
+                    if (__sync_bool_compare_and_swap(&c->fWorkPending, 1, 0))
+                    {
+                        client = c;
+                        break;
+                    }
+
+                    __sync_lock_release(&c->fWorkBusy);
+                }
+            }
+
+            if (client == nullptr)
+                break;
+
+            // let another worker look at the other clients meanwhile
+            wakeUp();
+
+            try {
+                client->runScheduledWork();
+            } CARLA_SAFE_EXCEPTION("CarlaLv2WorkerPool::runScheduledWork");
+
+            __sync_lock_release(&client->fWorkBusy);
+        }
+    }
+
+    static CarlaMutex& getPoolMutex() noexcept
+    {
+        static CarlaMutex mutex;
+        return mutex;
+    }
+
+    static CarlaLv2WorkerPool*& getPool() noexcept
+    {
+        static CarlaLv2WorkerPool* pool = nullptr;
+        return pool;
+    }
+
+    static CarlaLv2WorkerPool* addClient(Client* const client) noexcept
+    {
+        const CarlaMutexLocker cml(getPoolMutex());
+        CarlaLv2WorkerPool*& pool(getPool());
+
+        if (pool == nullptr)
+        {
+            CarlaLv2WorkerPool* const newPool(new CarlaLv2WorkerPool());
+
+            if (! newPool->start())
+            {
+                carla_stderr2("Failed to start LV2 worker threads, work will run in idle instead");
+                delete newPool;
+                return nullptr;
+            }
+
+            pool = newPool;
+        }
+
+        {
+            const CarlaMutexLocker cml2(pool->fClientsMutex);
+            pool->fClients.append(client);
+        }
+
+        if (client->fWorkPending != 0)
+            pool->wakeUp();
+
+        return pool;
+    }
+
+    static void removeClient(Client* const client) noexcept
+    {
+        const CarlaMutexLocker cml(getPoolMutex());
+        CarlaLv2WorkerPool*& pool(getPool());
+        CARLA_SAFE_ASSERT_RETURN(pool != nullptr,);
+
+        bool isLastClient;
+
+        {
+            const CarlaMutexLocker cml2(pool->fClientsMutex);
+            pool->fClients.removeOne(client);
+            isLastClient = pool->fClients.isEmpty();
+        }
+
+        // no new work can start now, but some might still be running
+        client->suspendWork();
+        __sync_lock_release(&client->fWorkBusy);
+
+        if (isLastClient)
+        {
+            delete pool;
+            pool = nullptr;
+        }
+    }
+
+    carla_sem_t fSem;
+    volatile int fWakeUp;
+
+    CarlaMutex fClientsMutex;
+    LinkedList<Client*> fClients;
+
+    Worker** fWorkers;
+    uint fNumWorkers;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaLv2WorkerPool)
+};
+
+// -------------------------------------------------------------------------------------------------------------------
+// URID map shared by all LV2 plugins
+
+/*
+ * Process-wide URI <-> URID map, so the same URI gets the same URID in every plugin instance.
+ * URIDs are never removed and start after the fixed Carla URIDs, which are resolved before reaching this map.
+ * Looking up known URIs and unmapping URIDs is lock-free, only adding new URIs takes a lock.
+ */
+class CarlaLv2UridMap
+{
+public:
+    /*
+     * Get the URID for 'uri', adding it if needed.
+     * Returns kUridNull on failure.
+     */
+    static LV2_URID map(const char* const uri) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', kUridNull);
+
+        CarlaLv2UridMap& self(getInstance());
+        const uint32_t hash = getHash(uri);
+
+        if (const LV2_URID urid = self.find(self.getTable(), uri, hash))
+            return urid;
+
+        return self.add(uri, hash);
+    }
+
+    /*
+     * Get the URI for 'urid', or null if it is not known.
+     */
+    static const char* unmap(const LV2_URID urid) noexcept
+    {
+        CarlaLv2UridMap& self(getInstance());
+
+        if (urid < kUridCount || urid >= getCount())
+            return nullptr;
+
+        return self.fChunks[urid / kChunkSize][urid % kChunkSize];
+    }
+
+    /*
+     * Get the next URID to be added, valid URIDs go from kUridCount up to this value.
+     */
+    static LV2_URID getCount() noexcept
+    {
+        CarlaLv2UridMap& self(getInstance());
+        return static_cast<LV2_URID>(__sync_fetch_and_add(&self.fCount, 0));
+    }
+
+private:
+    static const uint32_t kChunkSize = 1024;
+    static const uint32_t kMaxChunks = 1024;
+    static const uint32_t kInitialTableSize = 1024;
+
+    // open addressing, a slot is written only once and never changes after that
+    struct Slot {
+        volatile uint32_t hash;
+        volatile LV2_URID urid;
+    };
+
+    struct Table {
+        uint32_t mask;
+        Slot* slots;
+    };
+
+    CarlaLv2UridMap() noexcept
+        : fMutex(),
+          fChunks(),
+          fCount(kUridCount),
+          fTable(nullptr),
+          fOldTables()
+    {
+        fTable = createTable(kInitialTableSize);
+    }
+
+    ~CarlaLv2UridMap() noexcept
+    {
+        for (uint32_t urid = kUridCount, count = static_cast<uint32_t>(fCount); urid < count; ++urid)
+            delete[] fChunks[urid / kChunkSize][urid % kChunkSize];
+
+        for (uint32_t i=0; i < kMaxChunks; ++i)
+            delete[] fChunks[i];
+
+        for (LinkedList<Table*>::Itenerator it = fOldTables.begin2(); it.valid(); it.next())
+            destroyTable(it.getValue(nullptr));
+
+        fOldTables.clear();
+        destroyTable(fTable);
     }
 
-    ~CarlaPluginLV2Options() noexcept
+    static CarlaLv2UridMap& getInstance() noexcept
     {
-        LV2_Options_Option& optWindowTitle(opts[WindowTitle]);
+        static CarlaLv2UridMap map;
+        return map;
+    }
 
-        optWindowTitle.size  = 0;
-        optWindowTitle.value = nullptr;
+    static uint32_t getHash(const char* uri) noexcept
+    {
+        // FNV-1a
+        uint32_t hash = 2166136261U;
 
-        if (windowTitle != nullptr)
+        for (; *uri != '\0'; ++uri)
         {
-            std::free(const_cast<char*>(windowTitle));
-            windowTitle = nullptr;
+            hash ^= static_cast<uint8_t>(*uri);
+            hash *= 16777619U;
         }
+
+        return hash;
     }
 
-    CARLA_DECLARE_NON_COPY_STRUCT(CarlaPluginLV2Options);
-};
+    static Table* createTable(const uint32_t size) noexcept
+    {
+        Table* table;
 
-// -------------------------------------------------------------------------------------------------------------------
+        try {
+            table = new Table;
+        } CARLA_SAFE_EXCEPTION_RETURN("CarlaLv2UridMap::createTable", nullptr);
 
-class CarlaPluginLV2;
+        try {
+            table->slots = new Slot[size];
+        } catch(...) {
+            delete table;
+            return nullptr;
+        }
 
-class CarlaPipeServerLV2 : public CarlaPipeServer
-{
-public:
-    enum UiState {
-        UiNone = 0,
-        UiHide,
-        UiShow,
-        UiCrashed
-    };
+        table->mask = size - 1;
+        carla_zeroStructs(table->slots, size);
+        return table;
+    }
 
-    CarlaPipeServerLV2(CarlaEngine* const engine, CarlaPluginLV2* const plugin)
-        : kEngine(engine),
-          kPlugin(plugin),
-          fFilename(),
-          fPluginURI(),
-          fUiURI(),
-          fUiState(UiNone) {}
+    static void destroyTable(Table* const table) noexcept
+    {
+        if (table == nullptr)
+            return;
 
-    ~CarlaPipeServerLV2() noexcept override
+        delete[] table->slots;
+        delete table;
+    }
+
+    static void insertIntoTable(Table* const table, const uint32_t hash, const LV2_URID urid) noexcept
     {
-        CARLA_SAFE_ASSERT_INT(fUiState == UiNone, fUiState);
+        for (uint32_t i = hash & table->mask;; i = (i + 1) & table->mask)
+        {
+            Slot& slot(table->slots[i]);
+
+            if (slot.urid != kUridNull)
+                continue;
+
+            // readers check the URID first, so the hash needs to be visible before it
+            slot.hash = hash;
+            __sync_synchronize();
+            slot.urid = urid;
+            return;
+        }
     }
 
-    UiState getAndResetUiState() noexcept
+    Table* getTable() noexcept
     {
-        const UiState uiState(fUiState);
-        fUiState = UiNone;
-        return uiState;
+        Table* const table = fTable;
+        __sync_synchronize();
+        return table;
     }
 
-    void setData(const char* const filename, const char* const pluginURI, const char* const uiURI) noexcept
+    LV2_URID find(const Table* const table, const char* const uri, const uint32_t hash) const noexcept
     {
-        fFilename  = filename;
-        fPluginURI = pluginURI;
-        fUiURI     = uiURI;
+        for (uint32_t i = hash & table->mask;; i = (i + 1) & table->mask)
+        {
+            const Slot& slot(table->slots[i]);
+            const LV2_URID urid = slot.urid;
+
+            if (urid == kUridNull)
+                return kUridNull;
+
+            __sync_synchronize();
+
+            if (slot.hash == hash && std::strcmp(fChunks[urid / kChunkSize][urid % kChunkSize], uri) == 0)
+                return urid;
+        }
     }
 
-    bool startPipeServer(const int size) noexcept
+    LV2_URID add(const char* const uri, const uint32_t hash) noexcept
     {
-        char sampleRateStr[32];
+        const CarlaMutexLocker cml(fMutex);
+
+        // might have been added meanwhile
+        if (const LV2_URID urid = find(fTable, uri, hash))
+            return urid;
+
+        const uint32_t urid = static_cast<uint32_t>(fCount);
+        const uint32_t chunkIndex = urid / kChunkSize;
+        CARLA_SAFE_ASSERT_RETURN(chunkIndex < kMaxChunks, kUridNull);
+
+        // keep the table at most half full, old tables stay valid for readers still using them
+        if ((urid - kUridCount + 1) * 2 > fTable->mask + 1)
         {
-            const CarlaScopedLocale csl;
-            std::snprintf(sampleRateStr, 31, "%.12g", kEngine->getSampleRate());
+            Table* const newTable(createTable((fTable->mask + 1) * 2));
+            CARLA_SAFE_ASSERT_RETURN(newTable != nullptr, kUridNull);
+
+            Table* const oldTable(fTable);
+
+            for (uint32_t i=0; i <= oldTable->mask; ++i)
+            {
+                const Slot& slot(oldTable->slots[i]);
+
+                if (slot.urid != kUridNull)
+                    insertIntoTable(newTable, slot.hash, slot.urid);
+            }
+
+            fOldTables.append(oldTable);
+            __sync_synchronize();
+            fTable = newTable;
         }
-        sampleRateStr[31] = '\0';
 
-        const ScopedEngineEnvironmentLocker _seel(kEngine);
-        const CarlaScopedEnvVar _sev1("LV2_PATH", kEngine->getOptions().pathLV2);
-#ifdef CARLA_OS_LINUX
-        const CarlaScopedEnvVar _sev2("LD_PRELOAD", nullptr);
-#endif
-        carla_setenv("CARLA_SAMPLE_RATE", sampleRateStr);
+        if (fChunks[chunkIndex] == nullptr)
+        {
+            const char** chunk;
 
-        return CarlaPipeServer::startPipeServer(fFilename, fPluginURI, fUiURI, size);
+            try {
+                chunk = new const char*[kChunkSize];
+            } CARLA_SAFE_EXCEPTION_RETURN("CarlaLv2UridMap::add", kUridNull);
+
+            carla_zeroPointers(chunk, kChunkSize);
+            fChunks[chunkIndex] = chunk;
+        }
+
+        fChunks[chunkIndex][urid % kChunkSize] = carla_strdup_safe(uri);
+        CARLA_SAFE_ASSERT_RETURN(fChunks[chunkIndex][urid % kChunkSize] != nullptr, kUridNull);
+
+        // make the URI visible before the URID can be found
+        __sync_synchronize();
+        fCount = urid + 1;
+        insertIntoTable(fTable, hash, urid);
+
+        return urid;
     }
 
-    void writeUiTitleMessage(const char* const title) const noexcept
+    CarlaMutex fMutex;
+    const char** fChunks[kMaxChunks];
+    volatile uint32_t fCount;
+    Table* volatile fTable;
+    LinkedList<Table*> fOldTables;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaLv2UridMap)
+};
+
+// -------------------------------------------------------------------------------------------------------------------
+
+// Append a MIDI event to an input atom sequence, writing straight into the buffer memory.
+// The status byte is given separately so callers can put back the channel without a temporary copy.
+static inline
+bool lv2_atom_buffer_write_midi(LV2_Atom_Buffer_Iterator* const iter, const uint32_t frames, const LV2_URID type,
+                                const uint8_t status, const uint8_t* const data, const uint32_t size) noexcept
+{
+    LV2_Atom_Sequence* const atoms = &iter->buf->atoms;
+
+    if (iter->buf->capacity - sizeof(LV2_Atom) - atoms->atom.size < sizeof(LV2_Atom_Event) + size)
+        return false;
+
+    // events are stored past the end of the LV2_Atom_Buffer struct, in the memory allocated with it.
+    // address them from the start of the allocation, not from the 'atoms' member, which ends right there
+    static_assert(sizeof(LV2_Atom_Buffer) == offsetof(LV2_Atom_Buffer, atoms) + sizeof(LV2_Atom_Sequence),
+                  "LV2_Atom_Buffer events must start right after the struct");
+    uint8_t* const eventData = reinterpret_cast<uint8_t*>(iter->buf) + sizeof(LV2_Atom_Buffer);
+
+    LV2_Atom_Event* const ev = reinterpret_cast<LV2_Atom_Event*>(eventData + iter->offset);
+    ev->time.frames = frames;
+    ev->body.type   = type;
+    ev->body.size   = size;
+
+    uint8_t* const body = (uint8_t*)LV2_ATOM_BODY(&ev->body);
+    body[0] = status;
+
+    for (uint32_t i=1; i<size; ++i)
+        body[i] = data[i];
+
+    const uint32_t padSize = lv2_atom_pad_size(static_cast<uint32_t>(sizeof(LV2_Atom_Event)) + size);
+    atoms->atom.size += padSize;
+    iter->offset     += padSize;
+    return true;
+}
+
+// -------------------------------------------------------------------------------------------------------------------
+// RDF descriptors shared by all plugin instances in the process, they are read-only once created.
+// Mostly useful when Carla runs as a plugin and many engines load the same LV2 plugins.
+
+class Lv2RdfDescriptorCache
+{
+public:
+    static const LV2_RDF_Descriptor* acquire(const LV2_URI uri)
     {
-        CARLA_SAFE_ASSERT_RETURN(title != nullptr && title[0] != '\0',);
+        CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', nullptr);
 
-        const CarlaMutexLocker cml(getPipeLock());
+        SharedData& sd(getSharedData());
+        const CarlaMutexLocker cml(sd.mutex);
 
-        if (! _writeMsgBuffer("uiTitle\n", 8))
-            return;
-        if (! writeAndFixMessage(title))
-            return;
+        for (LinkedList<Entry>::Itenerator it = sd.entries.begin2(); it.valid(); it.next())
+        {
+            Entry& entry(it.getValue(kEntryFallback));
+            CARLA_SAFE_ASSERT_CONTINUE(entry.descriptor != nullptr);
 
-        flushMessages();
+            if (std::strcmp(entry.descriptor->URI, uri) == 0)
+            {
+                ++entry.refCount;
+                return entry.descriptor;
+            }
+        }
+
+        const LV2_RDF_Descriptor* const descriptor = lv2_rdf_new(uri, true);
+
+        if (descriptor == nullptr)
+            return nullptr;
+
+        const Entry entry = { descriptor, 1 };
+        sd.entries.append(entry);
+        return descriptor;
     }
 
-protected:
-    // returns true if msg was handled
-    bool msgReceived(const char* const msg) noexcept override;
+    static void release(const LV2_RDF_Descriptor* const descriptor)
+    {
+        CARLA_SAFE_ASSERT_RETURN(descriptor != nullptr,);
+
+        SharedData& sd(getSharedData());
+        const CarlaMutexLocker cml(sd.mutex);
+
+        for (LinkedList<Entry>::Itenerator it = sd.entries.begin2(); it.valid(); it.next())
+        {
+            Entry& entry(it.getValue(kEntryFallback));
+
+            if (entry.descriptor != descriptor)
+                continue;
+
+            if (--entry.refCount == 0)
+            {
+                sd.entries.remove(it);
+                delete descriptor;
+            }
+            return;
+        }
+
+        carla_safe_assert("descriptor in cache", __FILE__, __LINE__);
+    }
 
 private:
-    CarlaEngine*    const kEngine;
-    CarlaPluginLV2* const kPlugin;
+    struct Entry {
+        const LV2_RDF_Descriptor* descriptor;
+        uint refCount;
+    };
 
-    CarlaString fFilename;
-    CarlaString fPluginURI;
-    CarlaString fUiURI;
-    UiState     fUiState;
+    struct SharedData {
+        CarlaMutex mutex;
+        LinkedList<Entry> entries;
 
-    CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaPipeServerLV2)
+        SharedData() noexcept
+            : mutex(),
+              entries() {}
+    };
+
+    static Entry kEntryFallback;
+
+    static SharedData& getSharedData() noexcept
+    {
+        static SharedData sData;
+        return sData;
+    }
 };
 
+Lv2RdfDescriptorCache::Entry Lv2RdfDescriptorCache::kEntryFallback = { nullptr, 0 };
+
 // -------------------------------------------------------------------------------------------------------------------
 
 class CarlaPluginLV2 : public CarlaPlugin,
-                       private CarlaPluginUI::Callback
+                       private CarlaPluginUI::Callback,
+                       private CarlaLv2WorkerPool::Client
 {
 public:
     CarlaPluginLV2(CarlaEngine* const engine, const uint id)
@@ -576,11 +1565,15 @@ public:
           fAudioOutBuffers(nullptr),
           fCvInBuffers(nullptr),
           fCvOutBuffers(nullptr),
+          fAudioBufferArena(),
+          fFixedBlock(),
           fParamBuffers(nullptr),
           fHasLoadDefaultState(false),
           fHasThreadSafeRestore(false),
           fNeedsFixedBuffers(false),
+          fNeedsPowerOf2Buffers(false),
           fNeedsUiClose(false),
+          fAudioConnectedDirectly(false),
           fInlineDisplayNeedsRedraw(false),
           fInlineDisplayLastRedrawTime(0),
           fLatencyIndex(-1),
@@ -596,7 +1589,7 @@ public:
           fEventsOut(),
           fLv2Options(),
           fPipeServer(engine, this),
-          fCustomURIDs(kUridCount, std::string("urn:null")),
+          fUridsSentToUi(kUridCount),
           fFirstActive(true),
           fLastStateChunk(nullptr),
           fLastTimeInfo(),
@@ -605,7 +1598,8 @@ public:
           fUI()
     {
         carla_debug("CarlaPluginLV2::CarlaPluginLV2(%p, %i)", engine, id);
-        CARLA_SAFE_ASSERT(fCustomURIDs.size() == kUridCount);
+
+        pData->midiprog.supportsRT = true;
 
         carla_zeroPointers(fFeatures, kFeatureCountAll+1);
         carla_zeroPointers(fStateFeatures, kStateFeatureCountAll+1);
@@ -648,6 +1642,8 @@ public:
 
         fInlineDisplayNeedsRedraw = false;
 
+        removeFromWorkerPool();
+
         // close UI
         if (fUI.type != UI::TYPE_NULL)
         {
@@ -729,7 +1725,7 @@ public:
 
         if (fRdfDescriptor != nullptr)
         {
-            delete fRdfDescriptor;
+            Lv2RdfDescriptorCache::release(fRdfDescriptor);
             fRdfDescriptor = nullptr;
         }
 
@@ -865,13 +1861,16 @@ public:
 
     uint32_t getLatencyInFrames() const noexcept override
     {
+        // the fixed block adapter delays everything by one block
+        const uint32_t blockLatency = fFixedBlock.size;
+
         if (fLatencyIndex < 0 || fParamBuffers == nullptr)
-            return 0;
+            return blockLatency;
 
         const float latency(fParamBuffers[fLatencyIndex]);
-        CARLA_SAFE_ASSERT_RETURN(latency >= 0.0f, 0);
+        CARLA_SAFE_ASSERT_RETURN(latency >= 0.0f, blockLatency);
 
-        return static_cast<uint32_t>(latency);
+        return static_cast<uint32_t>(latency) + blockLatency;
     }
 
     // -------------------------------------------------------------------
@@ -940,7 +1939,7 @@ public:
         uint options = 0x0;
 
         // can't disable fixed buffers if using latency or MIDI output
-        if (fLatencyIndex == -1 && getMidiOutCount() == 0 && ! fNeedsFixedBuffers)
+        if (fLatencyIndex == -1 && getMidiOutCount() == 0 && ! fNeedsFixedBuffers && ! fNeedsPowerOf2Buffers)
             options |= PLUGIN_OPTION_FIXED_BUFFERS;
 
         // can't disable forced stereo if enabled in the engine
@@ -964,6 +1963,15 @@ public:
             options |= PLUGIN_OPTION_SKIP_SENDING_NOTES;
         }
 
+        options |= PLUGIN_OPTION_KEEP_DENORMALS;
+
+        if (pData->engine->getProccessMode() == ENGINE_PROCESS_MODE_PATCHBAY)
+            options |= PLUGIN_OPTION_DECOUPLED_BLOCKS;
+
+        // only effects can sleep, and CV inputs are not checked for silence
+        if (pData->audioIn.count != 0 && pData->cvIn.count == 0)
+            options |= PLUGIN_OPTION_AUTO_SLEEP;
+
         return options;
     }
 
@@ -1661,30 +2669,16 @@ public:
                     tmpBuf[0xfe] = '\0';
 
                     const CarlaMutexLocker cml(fPipeServer.getPipeLock());
-                    const CarlaScopedLocale csl;
-
-                    // write URI mappings
-                    uint32_t u = 0;
-                    for (std::vector<std::string>::iterator it=fCustomURIDs.begin(), end=fCustomURIDs.end(); it != end; ++it, ++u)
-                    {
-                        if (u < kUridCount)
-                            continue;
-                        const std::string& uri(*it);
-
-                        if (! fPipeServer.writeMessage("urid\n", 5))
-                            return;
 
-                        std::snprintf(tmpBuf, 0xfe, "%u\n", u);
-                        if (! fPipeServer.writeMessage(tmpBuf))
-                            return;
+                    // write plugin data, so the bridge does not need to load the LV2 world
+                    if (! writeRdfToUi())
+                        return;
 
-                        std::snprintf(tmpBuf, 0xfe, "%lu\n", static_cast<long unsigned>(uri.length()));
-                        if (! fPipeServer.writeMessage(tmpBuf))
-                            return;
+                    // write URI mappings
+                    fUridsSentToUi = kUridCount;
 
-                        if (! fPipeServer.writeAndFixMessage(uri.c_str()))
-                            return;
-                    }
+                    if (! writeNewUridsToUi())
+                        return;
 
                     // write UI options
                     if (! fPipeServer.writeMessage("uiOptions\n", 10))
@@ -1692,7 +2686,7 @@ public:
 
                     const EngineOptions& opts(pData->engine->getOptions());
 
-                    std::snprintf(tmpBuf, 0xff, "%g\n", pData->engine->getSampleRate());
+                    std::snprintf(tmpBuf, 0xff, "%s\n", CarlaFloatString(pData->engine->getSampleRate()).buffer);
                     if (! fPipeServer.writeMessage(tmpBuf))
                         return;
 
@@ -1704,7 +2698,7 @@ public:
                     if (! fPipeServer.writeMessage(tmpBuf))
                         return;
 
-                    std::snprintf(tmpBuf, 0xff, "%.12g\n", static_cast<double>(opts.uiScale));
+                    std::snprintf(tmpBuf, 0xff, "%s\n", CarlaFloatString(opts.uiScale).buffer);
                     if (! fPipeServer.writeMessage(tmpBuf))
                         return;
 
@@ -1735,7 +2729,7 @@ public:
                         if (! fPipeServer.writeMessage(tmpBuf))
                             return;
 
-                        std::snprintf(tmpBuf, 0xff, "%.12g\n", static_cast<double>(getParameterValue(i)));
+                        std::snprintf(tmpBuf, 0xff, "%s\n", CarlaFloatString(getParameterValue(i)).buffer);
                         if (! fPipeServer.writeMessage(tmpBuf))
                             return;
                     }
@@ -1938,21 +2932,9 @@ public:
 
     void idle() override
     {
-        if (fAtomBufferWorkerIn.isDataAvailableForReading())
-        {
-            Lv2AtomRingBuffer tmpRingBuffer(fAtomBufferWorkerIn, fAtomBufferWorkerInTmpData);
-            CARLA_SAFE_ASSERT_RETURN(tmpRingBuffer.isDataAvailableForReading(),);
-            CARLA_SAFE_ASSERT_RETURN(fExt.worker != nullptr && fExt.worker->work != nullptr,);
-
-            uint32_t portIndex;
-            const LV2_Atom* atom;
-
-            for (; tmpRingBuffer.get(atom, portIndex);)
-            {
-                CARLA_SAFE_ASSERT_CONTINUE(atom->type == kUridCarlaAtomWorkerIn);
-                fExt.worker->work(fHandle, carla_lv2_worker_respond, this, atom->size, LV2_ATOM_BODY_CONST(atom));
-            }
-        }
+        // work is handled by the worker pool when available
+        if (! isInWorkerPool())
+            runScheduledWork();
 
         if (fInlineDisplayNeedsRedraw)
         {
@@ -1965,7 +2947,9 @@ public:
             {
                 const int64_t timeNow = water::Time::currentTimeMillis();
 
-                if (timeNow - fInlineDisplayLastRedrawTime > (1000 / 30))
+                const uint maxRate = pData->engine->getOptions().inlineDisplayMaxRate;
+
+                if (maxRate == 0 || timeNow - fInlineDisplayLastRedrawTime > static_cast<int64_t>(1000 / maxRate))
                 {
                     fInlineDisplayNeedsRedraw = false;
                     fInlineDisplayLastRedrawTime = timeNow;
@@ -2036,6 +3020,7 @@ public:
 
         if (fPipeServer.isPipeRunning())
         {
+            sendNewUridsToUi();
             fPipeServer.idlePipe();
 
             switch (fPipeServer.getAndResetUiState())
@@ -2261,6 +3246,8 @@ public:
                 fCvOutBuffers[i] = nullptr;
         }
 
+        fFixedBlock.createNew(aOuts, cvOuts);
+
         if (params > 0)
         {
             pData->param.createNew(params, true);
@@ -2274,7 +3261,7 @@ public:
 
             for (uint32_t i=0; i < count; ++i)
             {
-                const uint32_t& type(evIns.getAt(i, 0x0));
+                const uint32_t type(evIns.getAt(i, 0x0));
 
                 if (type == CARLA_EVENT_DATA_ATOM)
                 {
@@ -2306,7 +3293,7 @@ public:
 
             for (uint32_t i=0; i < count; ++i)
             {
-                const uint32_t& type(evOuts.getAt(i, 0x0));
+                const uint32_t type(evOuts.getAt(i, 0x0));
 
                 if (type == CARLA_EVENT_DATA_ATOM)
                 {
@@ -3013,11 +4000,14 @@ public:
             pData->event.portOut = (CarlaEngineEventPort*)pData->client->addPort(kEnginePortTypeEvent, portName, false, 0);
         }
 
-        if (fExt.worker != nullptr && fEventsIn.ctrl != nullptr)
+        if (fExt.worker != nullptr && fEventsIn.ctrl != nullptr && fAtomBufferWorkerInTmpData == nullptr)
         {
             fAtomBufferWorkerIn.createBuffer(eventBufferSize);
             fAtomBufferWorkerResp.createBuffer(eventBufferSize);
             fAtomBufferWorkerInTmpData = new uint8_t[fAtomBufferWorkerIn.getSize()];
+
+            if (! pData->engine->isOffline())
+                addToWorkerPool();
         }
 
         if (fRdfDescriptor->ParameterCount > 0 ||
@@ -3085,7 +4075,7 @@ public:
         // check initial latency
         findInitialLatencyValue(aIns, cvIns, aOuts, cvOuts);
 
-        bufferSizeChanged(pData->engine->getBufferSize());
+        bufferSizeChanged(getBufferSize());
         reloadPrograms(true);
 
         evIns.clear();
@@ -3304,6 +4294,12 @@ public:
 
         if (fDescriptor->activate != nullptr)
         {
+            // activate must not run at the same time as work
+            const bool suspendsWork = isInWorkerPool();
+
+            if (suspendsWork)
+                suspendWork();
+
             try {
                 fDescriptor->activate(fHandle);
             } CARLA_SAFE_EXCEPTION("LV2 activate");
@@ -3314,6 +4310,9 @@ public:
                     fDescriptor->activate(fHandle2);
                 } CARLA_SAFE_EXCEPTION("LV2 activate #2");
             }
+
+            if (suspendsWork)
+                resumeWork();
         }
 
         fFirstActive = true;
@@ -3326,6 +4325,12 @@ public:
 
         if (fDescriptor->deactivate != nullptr)
         {
+            // deactivate must not run at the same time as work
+            const bool suspendsWork = isInWorkerPool();
+
+            if (suspendsWork)
+                suspendWork();
+
             try {
                 fDescriptor->deactivate(fHandle);
             } CARLA_SAFE_EXCEPTION("LV2 deactivate");
@@ -3336,6 +4341,9 @@ public:
                     fDescriptor->deactivate(fHandle2);
                 } CARLA_SAFE_EXCEPTION("LV2 deactivate #2");
             }
+
+            if (suspendsWork)
+                resumeWork();
         }
     }
 
@@ -3361,13 +4369,24 @@ public:
         LV2_Atom_Buffer_Iterator evInAtomIters[fEventsIn.count];
         LV2_Event_Iterator       evInEventIters[fEventsIn.count];
         LV2_MIDIState            evInMidiStates[fEventsIn.count];
+        uint32_t                 evInAtomStarts[fEventsIn.count];
 
         for (uint32_t i=0; i < fEventsIn.count; ++i)
         {
             if (fEventsIn.data[i].type & CARLA_EVENT_DATA_ATOM)
             {
-                lv2_atom_buffer_reset(fEventsIn.data[i].atom, true);
-                lv2_atom_buffer_begin(&evInAtomIters[i], fEventsIn.data[i].atom);
+                // with the fixed block adapter, events are kept until the block they belong to is run
+                if (fFixedBlock.pendingEvents)
+                {
+                    lv2_atom_buffer_end(&evInAtomIters[i], fEventsIn.data[i].atom);
+                }
+                else
+                {
+                    lv2_atom_buffer_reset(fEventsIn.data[i].atom, true);
+                    lv2_atom_buffer_begin(&evInAtomIters[i], fEventsIn.data[i].atom);
+                }
+
+                evInAtomStarts[i] = evInAtomIters[i].offset;
             }
             else if (fEventsIn.data[i].type & CARLA_EVENT_DATA_EVENT)
             {
@@ -3473,8 +4492,7 @@ public:
             bool doPostRt;
             int32_t rindex;
 
-            const double barBeat = static_cast<double>(timeInfo.bbt.beat - 1)
-                                 + (timeInfo.bbt.tick / timeInfo.bbt.ticksPerBeat);
+            const double barBeat = timeInfo.bbt.ppqPos - timeInfo.bbt.ppqBarStartPos;
 
             // update input ports
             for (uint32_t k=0; k < pData->param.count; ++k)
@@ -3578,61 +4596,65 @@ public:
                                            fParamBuffers[k]);
             }
 
+            // the time position object is the same for all ports, forge it once
+            uint8_t timeInfoBuf[256];
+            const LV2_Atom* timeInfoAtom = nullptr;
+
             for (uint32_t i=0; i < fEventsIn.count; ++i)
             {
                 if ((fEventsIn.data[i].type & CARLA_EVENT_DATA_ATOM) == 0 || (fEventsIn.data[i].type & CARLA_EVENT_TYPE_TIME) == 0)
                     continue;
 
-                uint8_t timeInfoBuf[256];
-                lv2_atom_forge_set_buffer(&fAtomForge, timeInfoBuf, sizeof(timeInfoBuf));
+                if (timeInfoAtom == nullptr)
+                {
+                    lv2_atom_forge_set_buffer(&fAtomForge, timeInfoBuf, sizeof(timeInfoBuf));
 
-                LV2_Atom_Forge_Frame forgeFrame;
-                lv2_atom_forge_object(&fAtomForge, &forgeFrame, kUridNull, kUridTimePosition);
+                    LV2_Atom_Forge_Frame forgeFrame;
+                    lv2_atom_forge_object(&fAtomForge, &forgeFrame, kUridNull, kUridTimePosition);
 
-                lv2_atom_forge_key(&fAtomForge, kUridTimeSpeed);
-                lv2_atom_forge_float(&fAtomForge, timeInfo.playing ? 1.0f : 0.0f);
+                    lv2_atom_forge_key(&fAtomForge, kUridTimeSpeed);
+                    lv2_atom_forge_float(&fAtomForge, timeInfo.playing ? 1.0f : 0.0f);
 
-                lv2_atom_forge_key(&fAtomForge, kUridTimeFrame);
-                lv2_atom_forge_long(&fAtomForge, static_cast<int64_t>(timeInfo.frame));
+                    lv2_atom_forge_key(&fAtomForge, kUridTimeFrame);
+                    lv2_atom_forge_long(&fAtomForge, static_cast<int64_t>(timeInfo.frame));
 
-                if (timeInfo.bbt.valid)
-                {
-                    lv2_atom_forge_key(&fAtomForge, kUridTimeBar);
-                    lv2_atom_forge_long(&fAtomForge, timeInfo.bbt.bar - 1);
+                    if (timeInfo.bbt.valid)
+                    {
+                        lv2_atom_forge_key(&fAtomForge, kUridTimeBar);
+                        lv2_atom_forge_long(&fAtomForge, timeInfo.bbt.bar - 1);
 
-                    lv2_atom_forge_key(&fAtomForge, kUridTimeBarBeat);
-                    lv2_atom_forge_float(&fAtomForge, static_cast<float>(barBeat));
+                        lv2_atom_forge_key(&fAtomForge, kUridTimeBarBeat);
+                        lv2_atom_forge_float(&fAtomForge, static_cast<float>(barBeat));
 
-                    lv2_atom_forge_key(&fAtomForge, kUridTimeBeat);
-                    lv2_atom_forge_double(&fAtomForge, timeInfo.bbt.beat - 1);
+                        lv2_atom_forge_key(&fAtomForge, kUridTimeBeat);
+                        lv2_atom_forge_double(&fAtomForge, timeInfo.bbt.beat - 1);
 
-                    lv2_atom_forge_key(&fAtomForge, kUridTimeBeatUnit);
-                    lv2_atom_forge_int(&fAtomForge, static_cast<int32_t>(timeInfo.bbt.beatType));
+                        lv2_atom_forge_key(&fAtomForge, kUridTimeBeatUnit);
+                        lv2_atom_forge_int(&fAtomForge, static_cast<int32_t>(timeInfo.bbt.beatType));
 
-                    lv2_atom_forge_key(&fAtomForge, kUridTimeBeatsPerBar);
-                    lv2_atom_forge_float(&fAtomForge, timeInfo.bbt.beatsPerBar);
+                        lv2_atom_forge_key(&fAtomForge, kUridTimeBeatsPerBar);
+                        lv2_atom_forge_float(&fAtomForge, timeInfo.bbt.beatsPerBar);
 
-                    lv2_atom_forge_key(&fAtomForge, kUridTimeBeatsPerMinute);
-                    lv2_atom_forge_float(&fAtomForge, static_cast<float>(timeInfo.bbt.beatsPerMinute));
+                        lv2_atom_forge_key(&fAtomForge, kUridTimeBeatsPerMinute);
+                        lv2_atom_forge_float(&fAtomForge, static_cast<float>(timeInfo.bbt.beatsPerMinute));
 
-                    lv2_atom_forge_key(&fAtomForge, kUridTimeTicksPerBeat);
-                    lv2_atom_forge_double(&fAtomForge, timeInfo.bbt.ticksPerBeat);
-                }
+                        lv2_atom_forge_key(&fAtomForge, kUridTimeTicksPerBeat);
+                        lv2_atom_forge_double(&fAtomForge, timeInfo.bbt.ticksPerBeat);
+                    }
 
-                lv2_atom_forge_pop(&fAtomForge, &forgeFrame);
+                    lv2_atom_forge_pop(&fAtomForge, &forgeFrame);
 
-                LV2_Atom* const atom((LV2_Atom*)timeInfoBuf);
-                CARLA_SAFE_ASSERT_BREAK(atom->size < 256);
+                    timeInfoAtom = (const LV2_Atom*)timeInfoBuf;
+                    CARLA_SAFE_ASSERT_BREAK(timeInfoAtom->size < 256);
+                }
 
                 // send only deprecated blank object for now
-                lv2_atom_buffer_write(&evInAtomIters[i], 0, 0, kUridAtomBlank, atom->size, LV2_ATOM_BODY_CONST(atom));
+                lv2_atom_buffer_write(&evInAtomIters[i], 0, 0, kUridAtomBlank, timeInfoAtom->size, LV2_ATOM_BODY_CONST(timeInfoAtom));
 
                 // for atom:object
-                //lv2_atom_buffer_write(&evInAtomIters[i], 0, 0, atom->type, atom->size, LV2_ATOM_BODY_CONST(atom));
+                //lv2_atom_buffer_write(&evInAtomIters[i], 0, 0, timeInfoAtom->type, timeInfoAtom->size, LV2_ATOM_BODY_CONST(timeInfoAtom));
             }
 
-            pData->postRtEvents.trySplice();
-
             fLastTimeInfo = timeInfo;
         }
 
@@ -3666,7 +4688,7 @@ public:
                 fAtomBufferEvIn.unlock();
             }
 
-            if (fExt.worker != nullptr && fAtomBufferWorkerIn.tryLock())
+            if (fExt.worker != nullptr && ! isInWorkerPool() && fAtomBufferWorkerIn.tryLock())
             {
                 if (fAtomBufferWorkerIn.isDataAvailableForReading())
                 {
@@ -3686,20 +4708,19 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
                 if ((fEventsIn.ctrl->type & CARLA_EVENT_TYPE_MIDI) == 0)
                 {
                     // does not handle MIDI
-                    pData->extNotes.data.clear();
+                    pData->extNotes.clearRT();
                 }
                 else
                 {
                     const uint32_t j = fEventsIn.ctrlIndex;
+                    ExternalMidiNote note = { 0, 0, 0, 0 };
 
-                    for (RtLinkedList<ExternalMidiNote>::Itenerator it = pData->extNotes.data.begin2(); it.valid(); it.next())
+                    while (pData->extNotes.getNextRT(note, frames))
                     {
-                        const ExternalMidiNote& note(it.getValue(kExternalMidiNoteFallback));
                         CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                         uint8_t midiEvent[3];
@@ -3708,20 +4729,16 @@ public:
                         midiEvent[2] = note.velo;
 
                         if (fEventsIn.ctrl->type & CARLA_EVENT_DATA_ATOM)
-                            lv2_atom_buffer_write(&evInAtomIters[j], 0, 0, kUridMidiEvent, 3, midiEvent);
+                            lv2_atom_buffer_write(&evInAtomIters[j], note.time, 0, kUridMidiEvent, 3, midiEvent);
 
                         else if (fEventsIn.ctrl->type & CARLA_EVENT_DATA_EVENT)
-                            lv2_event_write(&evInEventIters[j], 0, 0, kUridMidiEvent, 3, midiEvent);
+                            lv2_event_write(&evInEventIters[j], note.time, 0, kUridMidiEvent, 3, midiEvent);
 
                         else if (fEventsIn.ctrl->type & CARLA_EVENT_DATA_MIDI_LL)
-                            lv2midi_put_event(&evInMidiStates[j], 0.0, 3, midiEvent);
+                            lv2midi_put_event(&evInMidiStates[j], static_cast<double>(note.time), 3, midiEvent);
                     }
-
-                    pData->extNotes.data.clear();
                 }
 
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -3757,17 +4774,25 @@ public:
 
                 if (eventTime < timeOffset)
                 {
-                    carla_stderr2("Timing error, eventTime:%u < timeOffset:%u for '%s'",
-                                  eventTime, timeOffset, pData->name);
+                    carla_rt_stderr2("Timing error, eventTime:%u < timeOffset:%u for '%s'",
+                                     eventTime, timeOffset, pData->name);
                     eventTime = timeOffset;
                 }
 
                 if (isSampleAccurate && eventTime > timeOffset)
                 {
-                    if (processSingle(audioIn, audioOut, cvIn, cvOut, eventTime - timeOffset, timeOffset))
+                    // split where the engine options allow, events in between keep their offset
+                    const uint32_t splitTime = pData->getEventSplitTime(eventTime, timeOffset, frames);
+
+                    if (splitTime <= timeOffset)
+                    {
+                        startTime = eventTime - timeOffset;
+                    }
+                    else if (processSingle(audioIn, audioOut, cvIn, cvOut, splitTime - timeOffset, timeOffset))
                     {
-                        startTime  = 0;
-                        timeOffset = eventTime;
+                        ++pData->eventSplitCount;
+                        startTime  = eventTime - splitTime;
+                        timeOffset = splitTime;
 
                         if (pData->midiprog.current >= 0 && pData->midiprog.count > 0)
                             nextBankId = pData->midiprog.data[pData->midiprog.current].bank;
@@ -3790,7 +4815,7 @@ public:
                             {
                                 fEventsIn.data[j].midi.event_count = 0;
                                 fEventsIn.data[j].midi.size        = 0;
-                                evInMidiStates[j].position         = eventTime;
+                                evInMidiStates[j].position         = splitTime;
                             }
                         }
 
@@ -3888,9 +4913,15 @@ public:
                         }
 #endif
                         // Control plugin parameters
-                        uint32_t k;
-                        for (k=0; k < pData->param.count; ++k)
+                        const uint32_t* mappedParams = nullptr;
+                        uint32_t numMappedParams = 0;
+                        const bool useControlMap = pData->param.getMappedParameters(event.channel, ctrlEvent.param,
+                                                                                    mappedParams, numMappedParams);
+
+                        for (uint32_t m=0, end = useControlMap ? numMappedParams : pData->param.count; m < end; ++m)
                         {
+                            const uint32_t k = useControlMap ? mappedParams[m] : m;
+
                             if (pData->param.data[k].midiChannel != event.channel)
                                 continue;
                             if (pData->param.data[k].mappedControlIndex != ctrlEvent.param)
@@ -4072,18 +5103,26 @@ public:
                     const uint32_t mtime = isSampleAccurate ? startTime : eventTime;
 
                     // put back channel in data
-                    uint8_t midiData2[midiEvent.size];
-                    midiData2[0] = uint8_t(status | (event.channel & MIDI_CHANNEL_BIT));
-                    std::memcpy(midiData2+1, midiData+1, static_cast<std::size_t>(midiEvent.size-1));
+                    const uint8_t statusWithChannel = uint8_t(status | (event.channel & MIDI_CHANNEL_BIT));
 
                     if (fEventsIn.ctrl->type & CARLA_EVENT_DATA_ATOM)
-                        lv2_atom_buffer_write(&evInAtomIters[j], mtime, 0, kUridMidiEvent, midiEvent.size, midiData2);
+                    {
+                        // common case, no temporary copy
+                        lv2_atom_buffer_write_midi(&evInAtomIters[j], mtime, kUridMidiEvent,
+                                                   statusWithChannel, midiData, midiEvent.size);
+                    }
+                    else
+                    {
+                        uint8_t midiData2[midiEvent.size];
+                        midiData2[0] = statusWithChannel;
+                        std::memcpy(midiData2+1, midiData+1, static_cast<std::size_t>(midiEvent.size-1));
 
-                    else if (fEventsIn.ctrl->type & CARLA_EVENT_DATA_EVENT)
-                        lv2_event_write(&evInEventIters[j], mtime, 0, kUridMidiEvent, midiEvent.size, midiData2);
+                        if (fEventsIn.ctrl->type & CARLA_EVENT_DATA_EVENT)
+                            lv2_event_write(&evInEventIters[j], mtime, 0, kUridMidiEvent, midiEvent.size, midiData2);
 
-                    else if (fEventsIn.ctrl->type & CARLA_EVENT_DATA_MIDI_LL)
-                        lv2midi_put_event(&evInMidiStates[j], mtime, midiEvent.size, midiData2);
+                        else if (fEventsIn.ctrl->type & CARLA_EVENT_DATA_MIDI_LL)
+                            lv2midi_put_event(&evInMidiStates[j], mtime, midiEvent.size, midiData2);
+                    }
 
                     if (status == MIDI_STATUS_NOTE_ON)
                     {
@@ -4106,7 +5145,8 @@ public:
                 } // switch (event.type)
             }
 
-            pData->postRtEvents.trySplice();
+            if (fFixedBlock.size != 0)
+                moveFixedBlockEvents(evInAtomStarts);
 
             if (frames > timeOffset)
                 processSingle(audioIn, audioOut, cvIn, cvOut, frames - timeOffset, timeOffset);
@@ -4118,6 +5158,9 @@ public:
 
         else
         {
+            if (fFixedBlock.size != 0)
+                moveFixedBlockEvents(evInAtomStarts);
+
             processSingle(audioIn, audioOut, cvIn, cvOut, frames, 0);
 
         } // End of Plugin processing (no events)
@@ -4343,31 +5386,80 @@ public:
             return false;
         }
 
+        // program changes requested by the host while we were running
+        pData->applyDeferredProgramChangesRT(this);
+
         // --------------------------------------------------------------------------------------------------------
         // Set audio buffers
 
-        for (uint32_t i=0; i < pData->audioIn.count; ++i)
-            carla_copyFloats(fAudioInBuffers[i], audioIn[i]+timeOffset, frames);
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+        // skip staging copies if the plugin can run on the engine buffers as-is
+        const bool processDirectly = timeOffset == 0 && fHandle2 == nullptr && ! fNeedsFixedBuffers &&
+                                     fFixedBlock.size == 0 && pData->canProcessDirectly();
+#else
+        const bool processDirectly = false;
+#endif
 
-        for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            carla_zeroFloats(fAudioOutBuffers[i], frames);
+        float** wetAudioOut = fAudioOutBuffers;
+        float** wetCvOut    = fCvOutBuffers;
 
-        // --------------------------------------------------------------------------------------------------------
-        // Set CV buffers
+        if (fFixedBlock.size != 0)
+        {
+            runFixedBlock(audioIn, cvIn, frames, timeOffset);
+
+            wetAudioOut = fFixedBlock.audioOut;
+            wetCvOut    = fFixedBlock.cvOut;
+        }
+        else
+        {
+            if (processDirectly)
+            {
+                for (uint32_t i=0; i < pData->audioIn.count; ++i)
+                    fDescriptor->connect_port(fHandle, pData->audioIn.ports[i].rindex, const_cast<float*>(audioIn[i]));
+
+                for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                {
+                    carla_zeroFloats(audioOut[i], frames);
+                    fDescriptor->connect_port(fHandle, pData->audioOut.ports[i].rindex, audioOut[i]);
+                }
+
+                fAudioConnectedDirectly = true;
+            }
+            else
+            {
+                if (fAudioConnectedDirectly)
+                {
+                    for (uint32_t i=0; i < pData->audioIn.count; ++i)
+                        fDescriptor->connect_port(fHandle, pData->audioIn.ports[i].rindex, fAudioInBuffers[i]);
+
+                    for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                        fDescriptor->connect_port(fHandle, pData->audioOut.ports[i].rindex, fAudioOutBuffers[i]);
+
+                    fAudioConnectedDirectly = false;
+                }
+
+                for (uint32_t i=0; i < pData->audioIn.count; ++i)
+                    carla_copyFloats(fAudioInBuffers[i], audioIn[i]+timeOffset, frames);
+
+                for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                    carla_zeroFloats(fAudioOutBuffers[i], frames);
+            }
+
+            // Set CV buffers
 
-        for (uint32_t i=0; i < pData->cvIn.count; ++i)
-            carla_copyFloats(fCvInBuffers[i], cvIn[i]+timeOffset, frames);
+            for (uint32_t i=0; i < pData->cvIn.count; ++i)
+                carla_copyFloats(fCvInBuffers[i], cvIn[i]+timeOffset, frames);
 
-        for (uint32_t i=0; i < pData->cvOut.count; ++i)
-            carla_zeroFloats(fCvOutBuffers[i], frames);
+            for (uint32_t i=0; i < pData->cvOut.count; ++i)
+                carla_zeroFloats(fCvOutBuffers[i], frames);
 
-        // --------------------------------------------------------------------------------------------------------
-        // Run plugin
+            // Run plugin
 
-        fDescriptor->run(fHandle, frames);
+            fDescriptor->run(fHandle, frames);
 
-        if (fHandle2 != nullptr)
-            fDescriptor->run(fHandle2, frames);
+            if (fHandle2 != nullptr)
+                fDescriptor->run(fHandle2, frames);
+        }
 
         // --------------------------------------------------------------------------------------------------------
         // Handle trigger parameters
@@ -4391,129 +5483,143 @@ public:
             }
         }
 
-        pData->postRtEvents.trySplice();
-
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
         // --------------------------------------------------------------------------------------------------------
         // Post-processing (dry/wet, volume and balance)
 
-        {
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-            const bool isMono    = (pData->audioIn.count == 1);
-
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    const uint32_t c = isMono ? 0 : i;
+        if (fFixedBlock.size != 0)
+            pData->processPostProc(audioIn, timeOffset, true, wetAudioOut, audioOut, timeOffset, frames);
+        else if (! processDirectly)
+            pData->processPostProc(fAudioInBuffers, 0, true, wetAudioOut, audioOut, timeOffset, frames);
 
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
 # ifndef BUILD_BRIDGE
-                        if (k < pData->latency.frames && pData->latency.buffers != nullptr)
-                            bufValue = pData->latency.buffers[c][k];
-                        else if (pData->latency.frames < frames)
-                            bufValue = fAudioInBuffers[c][k-pData->latency.frames];
-                        else
-# endif
-                            bufValue = fAudioInBuffers[c][k];
+        // --------------------------------------------------------------------------------------------------------
+        // Save latency values for next callback
 
-                        fAudioOutBuffers[i][k] = (fAudioOutBuffers[i][k] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
+        CARLA_SAFE_ASSERT(pData->latency.frames == 0 || timeOffset == 0);
+        pData->latency.saveInputs(audioIn, pData->audioIn.count, frames);
+# endif
+#else // BUILD_BRIDGE_ALTERNATIVE_ARCH
+        for (uint32_t i=0; i < pData->audioOut.count; ++i)
+        {
+            for (uint32_t k=0; k < frames; ++k)
+                audioOut[i][k+timeOffset] = wetAudioOut[i][k];
+        }
+#endif
 
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
+        for (uint32_t i=0; i < pData->cvOut.count; ++i)
+        {
+            for (uint32_t k=0; k < frames; ++k)
+                cvOut[i][k+timeOffset] = wetCvOut[i][k];
+        }
 
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        carla_copyFloats(oldBufLeft, fAudioOutBuffers[i], frames);
-                    }
+        // --------------------------------------------------------------------------------------------------------
 
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
+        pData->singleMutex.unlock();
+        return true;
+    }
 
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            fAudioOutBuffers[i][k]  = oldBufLeft[k]            * (1.0f - balRangeL);
-                            fAudioOutBuffers[i][k] += fAudioOutBuffers[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            fAudioOutBuffers[i][k]  = fAudioOutBuffers[i][k] * balRangeR;
-                            fAudioOutBuffers[i][k] += oldBufLeft[k]          * balRangeL;
-                        }
-                    }
-                }
+    // Feed one engine cycle into the fixed block adapter, running the plugin each time a block is complete.
+    void runFixedBlock(const float* const* const audioIn, const float* const* const cvIn,
+                       const uint32_t frames, const uint32_t timeOffset) noexcept
+    {
+        const uint32_t blockSize = fFixedBlock.size;
 
-                // Volume (and buffer copy)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        audioOut[i][k+timeOffset] = fAudioOutBuffers[i][k] * pData->postProc.volume;
-                }
-            }
-        } // End of Post-processing
+        for (uint32_t done = 0; done < frames;)
+        {
+            const uint32_t fill = fFixedBlock.fill;
+            const uint32_t len  = std::min(frames - done, blockSize - fill);
 
-# ifndef BUILD_BRIDGE
-        // --------------------------------------------------------------------------------------------------------
-        // Save latency values for next callback
+            // outputs at this position come from the previous block, read them before the next run
+            for (uint32_t i=0; i < pData->audioIn.count; ++i)
+                carla_copyFloats(fAudioInBuffers[i] + fill, audioIn[i] + timeOffset + done, len);
+            for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                carla_copyFloats(fFixedBlock.audioOut[i] + done, fAudioOutBuffers[i] + fill, len);
+            for (uint32_t i=0; i < pData->cvIn.count; ++i)
+                carla_copyFloats(fCvInBuffers[i] + fill, cvIn[i] + timeOffset + done, len);
+            for (uint32_t i=0; i < pData->cvOut.count; ++i)
+                carla_copyFloats(fFixedBlock.cvOut[i] + done, fCvOutBuffers[i] + fill, len);
 
-        if (pData->latency.frames != 0 && pData->latency.buffers != nullptr)
-        {
-            CARLA_SAFE_ASSERT(timeOffset == 0);
-            const uint32_t latframes = pData->latency.frames;
+            done += len;
 
-            if (latframes <= frames)
+            if (fill + len < blockSize)
             {
-                for (uint32_t i=0; i < pData->audioIn.count; ++i)
-                    carla_copyFloats(pData->latency.buffers[i], audioIn[i]+(frames-latframes), latframes);
+                fFixedBlock.fill = fill + len;
+                continue;
             }
-            else
-            {
-                const uint32_t diff = latframes - frames;
 
-                for (uint32_t i=0, k; i<pData->audioIn.count; ++i)
-                {
-                    // push back buffer by 'frames'
-                    for (k=0; k < diff; ++k)
-                        pData->latency.buffers[i][k] = pData->latency.buffers[i][k+frames];
+            fDescriptor->run(fHandle, blockSize);
 
-                    // put current input at the end
-                    for (uint32_t j=0; k < latframes; ++j, ++k)
-                        pData->latency.buffers[i][k] = audioIn[i][j];
-                }
-            }
+            if (fHandle2 != nullptr)
+                fDescriptor->run(fHandle2, blockSize);
+
+            fFixedBlock.fill = 0;
+            fFixedBlock.pendingEvents = false;
         }
-# endif
-#else // BUILD_BRIDGE_ALTERNATIVE_ARCH
-        for (uint32_t i=0; i < pData->audioOut.count; ++i)
+    }
+
+    // Place the events written during this engine cycle at their position within the pending block.
+    // Events after the end of the block are run with it, at its last frame.
+    void moveFixedBlockEvents(const uint32_t* const evInAtomStarts) noexcept
+    {
+        const uint32_t fill = fFixedBlock.fill;
+        const uint32_t last = fFixedBlock.size - 1;
+
+        for (uint32_t i=0; i < fEventsIn.count; ++i)
         {
-            for (uint32_t k=0; k < frames; ++k)
-                audioOut[i][k+timeOffset] = fAudioOutBuffers[i][k];
+            if ((fEventsIn.data[i].type & CARLA_EVENT_DATA_ATOM) == 0)
+                continue;
+
+            LV2_Atom_Buffer_Iterator iter;
+            iter.buf    = fEventsIn.data[i].atom;
+            iter.offset = evInAtomStarts[i];
+
+            uint8_t* data;
+
+            for (; lv2_atom_buffer_is_valid(&iter); lv2_atom_buffer_increment(&iter))
+            {
+                LV2_Atom_Event* const ev = lv2_atom_buffer_get(&iter, &data);
+                CARLA_SAFE_ASSERT_BREAK(ev != nullptr);
+
+                ev->time.frames = std::min(static_cast<int64_t>(last), ev->time.frames + fill);
+            }
         }
-#endif
 
-        for (uint32_t i=0; i < pData->cvOut.count; ++i)
+        fFixedBlock.pendingEvents = true;
+    }
+
+    // Block size to run the plugin at if the engine cannot provide what it needs, 0 if not needed.
+    uint32_t getFixedBlockSize(const uint32_t bufferSize) const noexcept
+    {
+        if (bufferSize == 0 || ! canUseFixedBlockAdapter())
+            return 0;
+
+        const uint32_t powerOf2Size = carla_nextPowerOf2(bufferSize);
+
+        // plugins hosted inside other hosts can receive any block size
+        if (fNeedsFixedBuffers && (! pData->engine->usesConstantBufferSize() ||
+                                   pData->engine->getType() == kEngineTypePlugin))
+            return fNeedsPowerOf2Buffers ? powerOf2Size : bufferSize;
+
+        if (fNeedsPowerOf2Buffers && powerOf2Size != bufferSize)
+            return powerOf2Size;
+
+        return 0;
+    }
+
+    // The adapter only knows how to delay atom events, old event and MIDI port types are not supported.
+    bool canUseFixedBlockAdapter() const noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(fRdfDescriptor != nullptr, false);
+
+        for (uint32_t i=0; i < fRdfDescriptor->PortCount; ++i)
         {
-            for (uint32_t k=0; k < frames; ++k)
-                cvOut[i][k+timeOffset] = fCvOutBuffers[i][k];
-        }
+            const LV2_Property portTypes(fRdfDescriptor->Ports[i].Types);
 
-        // --------------------------------------------------------------------------------------------------------
+            if (LV2_IS_PORT_INPUT(portTypes) && (LV2_IS_PORT_EVENT(portTypes) || LV2_IS_PORT_MIDI_LL(portTypes)))
+                return false;
+        }
 
-        pData->singleMutex.unlock();
         return true;
     }
 
@@ -4522,20 +5628,29 @@ public:
         CARLA_ASSERT_INT(newBufferSize > 0, newBufferSize);
         carla_debug("CarlaPluginLV2::bufferSizeChanged(%i) - start", newBufferSize);
 
+        const uint32_t fixedBlockSize = getFixedBlockSize(newBufferSize);
+        const uint32_t pluginBufferSize = fixedBlockSize != 0 ? std::max(fixedBlockSize, newBufferSize) : newBufferSize;
+
+        fFixedBlock.size = fixedBlockSize;
+        fFixedBlock.fill = 0;
+        fFixedBlock.pendingEvents = false;
+
+        fAudioBufferArena.reset(pData->audioIn.count + pData->audioOut.count + pData->cvIn.count + pData->cvOut.count
+                                + (fixedBlockSize != 0 ? pData->audioOut.count + pData->cvOut.count : 0),
+                                pluginBufferSize);
+
         for (uint32_t i=0; i < pData->audioIn.count; ++i)
         {
-            if (fAudioInBuffers[i] != nullptr)
-                delete[] fAudioInBuffers[i];
-            fAudioInBuffers[i] = new float[newBufferSize];
+            fAudioInBuffers[i] = fAudioBufferArena.allocate();
         }
 
         for (uint32_t i=0; i < pData->audioOut.count; ++i)
         {
-            if (fAudioOutBuffers[i] != nullptr)
-                delete[] fAudioOutBuffers[i];
-            fAudioOutBuffers[i] = new float[newBufferSize];
+            fAudioOutBuffers[i] = fAudioBufferArena.allocate();
         }
 
+        fAudioConnectedDirectly = false;
+
         if (fHandle2 == nullptr)
         {
             for (uint32_t i=0; i < pData->audioIn.count; ++i)
@@ -4575,9 +5690,7 @@ public:
 
         for (uint32_t i=0; i < pData->cvIn.count; ++i)
         {
-            if (fCvInBuffers[i] != nullptr)
-                delete[] fCvInBuffers[i];
-            fCvInBuffers[i] = new float[newBufferSize];
+            fCvInBuffers[i] = fAudioBufferArena.allocate();
 
             fDescriptor->connect_port(fHandle, pData->cvIn.ports[i].rindex, fCvInBuffers[i]);
 
@@ -4587,9 +5700,7 @@ public:
 
         for (uint32_t i=0; i < pData->cvOut.count; ++i)
         {
-            if (fCvOutBuffers[i] != nullptr)
-                delete[] fCvOutBuffers[i];
-            fCvOutBuffers[i] = new float[newBufferSize];
+            fCvOutBuffers[i] = fAudioBufferArena.allocate();
 
             fDescriptor->connect_port(fHandle, pData->cvOut.ports[i].rindex, fCvOutBuffers[i]);
 
@@ -4597,7 +5708,16 @@ public:
                 fDescriptor->connect_port(fHandle2, pData->cvOut.ports[i].rindex, fCvOutBuffers[i]);
         }
 
-        const int newBufferSizeInt(static_cast<int>(newBufferSize));
+        if (fixedBlockSize != 0)
+        {
+            for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                fFixedBlock.audioOut[i] = fAudioBufferArena.allocate();
+
+            for (uint32_t i=0; i < pData->cvOut.count; ++i)
+                fFixedBlock.cvOut[i] = fAudioBufferArena.allocate();
+        }
+
+        const int newBufferSizeInt(static_cast<int>(fixedBlockSize != 0 ? fixedBlockSize : newBufferSize));
 
         if (fLv2Options.maxBufferSize != newBufferSizeInt || (fLv2Options.minBufferSize != 1 && fLv2Options.minBufferSize != newBufferSizeInt))
         {
@@ -4711,64 +5831,31 @@ public:
 
         if (fAudioInBuffers != nullptr)
         {
-            for (uint32_t i=0; i < pData->audioIn.count; ++i)
-            {
-                if (fAudioInBuffers[i] != nullptr)
-                {
-                    delete[] fAudioInBuffers[i];
-                    fAudioInBuffers[i] = nullptr;
-                }
-            }
-
             delete[] fAudioInBuffers;
             fAudioInBuffers = nullptr;
         }
 
         if (fAudioOutBuffers != nullptr)
         {
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                if (fAudioOutBuffers[i] != nullptr)
-                {
-                    delete[] fAudioOutBuffers[i];
-                    fAudioOutBuffers[i] = nullptr;
-                }
-            }
-
             delete[] fAudioOutBuffers;
             fAudioOutBuffers = nullptr;
         }
 
         if (fCvInBuffers != nullptr)
         {
-            for (uint32_t i=0; i < pData->cvIn.count; ++i)
-            {
-                if (fCvInBuffers[i] != nullptr)
-                {
-                    delete[] fCvInBuffers[i];
-                    fCvInBuffers[i] = nullptr;
-                }
-            }
-
             delete[] fCvInBuffers;
             fCvInBuffers = nullptr;
         }
 
         if (fCvOutBuffers != nullptr)
         {
-            for (uint32_t i=0; i < pData->cvOut.count; ++i)
-            {
-                if (fCvOutBuffers[i] != nullptr)
-                {
-                    delete[] fCvOutBuffers[i];
-                    fCvOutBuffers[i] = nullptr;
-                }
-            }
-
             delete[] fCvOutBuffers;
             fCvOutBuffers = nullptr;
         }
 
+        fFixedBlock.clear();
+        fAudioBufferArena.reset(0, 0);
+
         if (fParamBuffers != nullptr)
         {
             delete[] fParamBuffers;
@@ -5257,35 +6344,135 @@ public:
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', kUridNull);
         carla_debug("CarlaPluginLV2::getCustomURID(\"%s\")", uri);
 
-        const std::string    s_uri(uri);
-        const std::ptrdiff_t s_pos(std::find(fCustomURIDs.begin(), fCustomURIDs.end(), s_uri) - fCustomURIDs.begin());
+        const LV2_URID urid = CarlaLv2UridMap::map(uri);
 
-        if (s_pos <= 0 || s_pos >= INT32_MAX)
-            return kUridNull;
+        if (urid >= fUridsSentToUi)
+            sendNewUridsToUi();
 
-        const LV2_URID urid     = static_cast<LV2_URID>(s_pos);
-        const LV2_URID uriCount = static_cast<LV2_URID>(fCustomURIDs.size());
+        return urid;
+    }
 
-        if (urid < uriCount)
-            return urid;
+    const char* getCustomURIDString(const LV2_URID urid) const noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(urid != kUridNull, kUnmapFallback);
+        carla_debug("CarlaPluginLV2::getCustomURIString(%i)", urid);
+
+        const char* const uri = CarlaLv2UridMap::unmap(urid);
+        CARLA_SAFE_ASSERT_RETURN(uri != nullptr, kUnmapFallback);
 
-        CARLA_SAFE_ASSERT(urid == uriCount);
+        return uri;
+    }
 
-        fCustomURIDs.push_back(uri);
+    // send URIDs not known to the bridged UI yet, those might have been added by other plugins
+    void sendNewUridsToUi()
+    {
+        if (fUI.type != UI::TYPE_BRIDGE || ! fPipeServer.isPipeRunning())
+            return;
+        if (fUridsSentToUi == CarlaLv2UridMap::getCount())
+            return;
 
-        if (fUI.type == UI::TYPE_BRIDGE && fPipeServer.isPipeRunning())
-            fPipeServer.writeLv2UridMessage(urid, uri);
+        const CarlaMutexLocker cml(fPipeServer.getPipeLock());
 
-        return urid;
+        if (writeNewUridsToUi())
+            fPipeServer.flushMessages();
     }
 
-    const char* getCustomURIDString(const LV2_URID urid) const noexcept
+    // must be called with the pipe lock held
+    bool writeRdfToUi()
     {
-        CARLA_SAFE_ASSERT_RETURN(urid != kUridNull, kUnmapFallback);
-        CARLA_SAFE_ASSERT_RETURN(urid < fCustomURIDs.size(), kUnmapFallback);
-        carla_debug("CarlaPluginLV2::getCustomURIString(%i)", urid);
+        CARLA_SAFE_ASSERT_RETURN(fRdfDescriptor != nullptr, false);
+        CARLA_SAFE_ASSERT_RETURN(fUI.rdfDescriptor != nullptr, false);
+
+        char tmpBuf[0xff];
+        tmpBuf[0xfe] = '\0';
+
+        const LV2_RDF_UI* const rdfUI(fUI.rdfDescriptor);
+
+        if (! fPipeServer.writeMessage("rdf\n", 4))
+            return false;
+        if (! fPipeServer.writeAndFixMessage(fRdfDescriptor->URI))
+            return false;
+        if (! fPipeServer.writeAndFixMessage(rdfUI->URI))
+            return false;
+        if (! fPipeServer.writeAndFixMessage(rdfUI->Binary))
+            return false;
+        if (! fPipeServer.writeAndFixMessage(rdfUI->Bundle))
+            return false;
+
+        std::snprintf(tmpBuf, 0xfe, "%u\n", rdfUI->FeatureCount);
+        if (! fPipeServer.writeMessage(tmpBuf))
+            return false;
+
+        for (uint32_t i=0; i < rdfUI->FeatureCount; ++i)
+        {
+            const LV2_RDF_Feature& rdfFeature(rdfUI->Features[i]);
+
+            std::snprintf(tmpBuf, 0xfe, "%s\n", bool2str(rdfFeature.Required));
+            if (! fPipeServer.writeMessage(tmpBuf))
+                return false;
+            if (! fPipeServer.writeAndFixMessage(rdfFeature.URI != nullptr ? rdfFeature.URI : ""))
+                return false;
+        }
+
+        std::snprintf(tmpBuf, 0xfe, "%u\n", fRdfDescriptor->PortCount);
+        if (! fPipeServer.writeMessage(tmpBuf))
+            return false;
+
+        for (uint32_t i=0; i < fRdfDescriptor->PortCount; ++i)
+        {
+            const LV2_RDF_Port& rdfPort(fRdfDescriptor->Ports[i]);
+
+            std::snprintf(tmpBuf, 0xfe, "%u\n", rdfPort.Designation);
+            if (! fPipeServer.writeMessage(tmpBuf))
+                return false;
+            if (! fPipeServer.writeAndFixMessage(rdfPort.Symbol != nullptr ? rdfPort.Symbol : ""))
+                return false;
+        }
+
+        std::snprintf(tmpBuf, 0xfe, "%u\n", fRdfDescriptor->ParameterCount);
+        if (! fPipeServer.writeMessage(tmpBuf))
+            return false;
+
+        for (uint32_t i=0; i < fRdfDescriptor->ParameterCount; ++i)
+        {
+            const LV2_RDF_Parameter& rdfParameter(fRdfDescriptor->Parameters[i]);
+
+            std::snprintf(tmpBuf, 0xfe, "%u\n", rdfParameter.Type);
+            if (! fPipeServer.writeMessage(tmpBuf))
+                return false;
+            if (! fPipeServer.writeAndFixMessage(rdfParameter.URI != nullptr ? rdfParameter.URI : ""))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool writeNewUridsToUi()
+    {
+        char tmpBuf[0xff];
+        tmpBuf[0xfe] = '\0';
+
+        for (const LV2_URID count = CarlaLv2UridMap::getCount(); fUridsSentToUi < count; ++fUridsSentToUi)
+        {
+            const char* const uri = CarlaLv2UridMap::unmap(fUridsSentToUi);
+            CARLA_SAFE_ASSERT_CONTINUE(uri != nullptr);
+
+            if (! fPipeServer.writeMessage("urid\n", 5))
+                return false;
+
+            std::snprintf(tmpBuf, 0xfe, "%u\n", fUridsSentToUi);
+            if (! fPipeServer.writeMessage(tmpBuf))
+                return false;
 
-        return fCustomURIDs[urid].c_str();
+            std::snprintf(tmpBuf, 0xfe, "%lu\n", static_cast<long unsigned>(std::strlen(uri)));
+            if (! fPipeServer.writeMessage(tmpBuf))
+                return false;
+
+            if (! fPipeServer.writeAndFixMessage(uri))
+                return false;
+        }
+
+        return true;
     }
 
     // -------------------------------------------------------------------
@@ -5581,6 +6768,25 @@ public:
 
     // -------------------------------------------------------------------
 
+    void runScheduledWork() override
+    {
+        if (! fAtomBufferWorkerIn.isDataAvailableForReading())
+            return;
+
+        Lv2AtomRingBuffer tmpRingBuffer(fAtomBufferWorkerIn, fAtomBufferWorkerInTmpData);
+        CARLA_SAFE_ASSERT_RETURN(tmpRingBuffer.isDataAvailableForReading(),);
+        CARLA_SAFE_ASSERT_RETURN(fExt.worker != nullptr && fExt.worker->work != nullptr,);
+
+        uint32_t portIndex;
+        const LV2_Atom* atom;
+
+        for (; tmpRingBuffer.get(atom, portIndex);)
+        {
+            CARLA_SAFE_ASSERT_CONTINUE(atom->type == kUridCarlaAtomWorkerIn);
+            fExt.worker->work(fHandle, carla_lv2_worker_respond, this, atom->size, LV2_ATOM_BODY_CONST(atom));
+        }
+    }
+
     LV2_Worker_Status handleWorkerSchedule(const uint32_t size, const void* const data)
     {
         CARLA_SAFE_ASSERT_RETURN(fExt.worker != nullptr && fExt.worker->work != nullptr, LV2_WORKER_ERR_UNKNOWN);
@@ -5597,7 +6803,13 @@ public:
         atom.size = size;
         atom.type = kUridCarlaAtomWorkerIn;
 
-        return fAtomBufferWorkerIn.putChunk(&atom, data, fEventsOut.ctrlIndex) ? LV2_WORKER_SUCCESS : LV2_WORKER_ERR_NO_SPACE;
+        if (! fAtomBufferWorkerIn.putChunk(&atom, data, fEventsOut.ctrlIndex))
+            return LV2_WORKER_ERR_NO_SPACE;
+
+        if (isInWorkerPool())
+            scheduleWork();
+
+        return LV2_WORKER_SUCCESS;
     }
 
     LV2_Worker_Status handleWorkerRespond(const uint32_t size, const void* const data)
@@ -5959,7 +7171,7 @@ public:
 
 public:
     bool init(const CarlaPluginPtr plugin,
-              const char* const name, const char* const uri, const uint options)
+              const char* const bundle, const char* const name, const char* const uri, const uint options)
     {
         CARLA_SAFE_ASSERT_RETURN(pData->engine != nullptr, false);
 
@@ -5985,17 +7197,28 @@ public:
 
         Lv2WorldClass& lv2World(Lv2WorldClass::getInstance());
 
+        const char* LV2_PATH;
+
         if (opts.pathLV2 != nullptr && opts.pathLV2[0] != '\0')
-            lv2World.initIfNeeded(opts.pathLV2);
-        else if (const char* const LV2_PATH = std::getenv("LV2_PATH"))
-            lv2World.initIfNeeded(LV2_PATH);
+            LV2_PATH = opts.pathLV2;
+        else if (const char* const envLV2_PATH = std::getenv("LV2_PATH"))
+            LV2_PATH = envLV2_PATH;
         else
-            lv2World.initIfNeeded(LILV_DEFAULT_LV2_PATH);
+            LV2_PATH = LILV_DEFAULT_LV2_PATH;
+
+        // only scan everything if the plugin is not in the bundle we were told about
+        if (! (opts.lv2LazyLoading
+               && bundle != nullptr && bundle[0] != '\0'
+               && lv2World.loadBundleOnDemand(LV2_PATH, bundle)
+               && lv2World.getPluginFromURI(uri) != nullptr))
+        {
+            lv2World.initIfNeeded(LV2_PATH);
+        }
 
         // ---------------------------------------------------------------
         // get plugin from lv2_rdf (lilv)
 
-        fRdfDescriptor = lv2_rdf_new(uri, true);
+        fRdfDescriptor = Lv2RdfDescriptorCache::acquire(uri);
 
         if (fRdfDescriptor == nullptr)
         {
@@ -6102,6 +7325,10 @@ public:
             {
                 fNeedsFixedBuffers = true;
             }
+            else if (std::strcmp(feature.URI, LV2_BUF_SIZE__powerOf2BlockLength) == 0)
+            {
+                fNeedsPowerOf2Buffers = true;
+            }
             else if (std::strcmp(feature.URI, LV2_PORT_PROPS__supportsStrictBounds) == 0)
             {
                 fStrictBounds = feature.Required ? 1 : 0;
@@ -6131,7 +7358,7 @@ public:
             return false;
         }
 
-        if (fNeedsFixedBuffers && ! pData->engine->usesConstantBufferSize())
+        if (fNeedsFixedBuffers && ! pData->engine->usesConstantBufferSize() && ! canUseFixedBlockAdapter())
         {
             pData->engine->setLastError("Cannot use this plugin under the current engine.\n"
                                         "The plugin requires a fixed block size which is not possible right now.");
@@ -6152,6 +7379,10 @@ public:
         else
             pData->name = pData->engine->getUniquePluginName(fRdfDescriptor->Name);
 
+        // saved as the plugin binary, so projects can load this bundle on demand
+        if (fRdfDescriptor->Bundle != nullptr)
+            pData->filename = carla_strdup(fRdfDescriptor->Bundle);
+
         // ---------------------------------------------------------------
         // register client
 
@@ -6166,7 +7397,9 @@ public:
         // ---------------------------------------------------------------
         // initialize options
 
-        const int bufferSize = static_cast<int>(pData->engine->getBufferSize());
+        const uint32_t hostBufferSize   = getBufferSize();
+        const uint32_t fixedBlockSize   = getFixedBlockSize(hostBufferSize);
+        const int      bufferSize       = static_cast<int>(fixedBlockSize != 0 ? fixedBlockSize : hostBufferSize);
 
         fLv2Options.minBufferSize     = fNeedsFixedBuffers ? bufferSize : 1;
         fLv2Options.maxBufferSize     = bufferSize;
@@ -6381,7 +7614,7 @@ public:
 
         pData->options = 0x0;
 
-        if (fLatencyIndex >= 0 || getMidiOutCount() != 0 || fNeedsFixedBuffers)
+        if (fLatencyIndex >= 0 || getMidiOutCount() != 0 || fNeedsFixedBuffers || fNeedsPowerOf2Buffers)
             pData->options |= PLUGIN_OPTION_FIXED_BUFFERS;
         else if (options & PLUGIN_OPTION_FIXED_BUFFERS)
             pData->options |= PLUGIN_OPTION_FIXED_BUFFERS;
@@ -6415,6 +7648,10 @@ public:
                 pData->options |= PLUGIN_OPTION_MAP_PROGRAM_CHANGES;
         }
 
+        // off by default, needs to be explicitly enabled per plugin
+        if (options & PLUGIN_OPTION_AUTO_SLEEP)
+            pData->options |= PLUGIN_OPTION_AUTO_SLEEP;
+
         // ---------------------------------------------------------------
         // gui stuff
 
@@ -6907,29 +8144,17 @@ public:
         fAtomBufferEvIn.put(atom, portIndex);
     }
 
-    void handleUridMap(const LV2_URID urid, const char* const uri)
+    // the bridged UI asks for the URID of a URI it does not know yet, and waits for the answer.
+    // it never picks URIDs by itself, as other plugins share our map and it would get out of sync.
+    void handleUridMap(const char* const uri)
     {
-        CARLA_SAFE_ASSERT_RETURN(urid != kUridNull,);
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0',);
-        carla_debug("CarlaPluginLV2::handleUridMap(%i v " P_SIZE ", \"%s\")", urid, fCustomURIDs.size()-1, uri);
-
-        const std::size_t uriCount(fCustomURIDs.size());
+        carla_debug("CarlaPluginLV2::handleUridMap(\"%s\")", uri);
 
-        if (urid < uriCount)
-        {
-            const char* const ourURI(carla_lv2_urid_unmap(this, urid));
-            CARLA_SAFE_ASSERT_RETURN(ourURI != nullptr && ourURI != kUnmapFallback,);
+        CARLA_SAFE_ASSERT_RETURN(CarlaLv2UridMap::map(uri) != kUridNull,);
 
-            if (std::strcmp(ourURI, uri) != 0)
-            {
-                carla_stderr2("PLUGIN :: wrong URI '%s' vs '%s'", ourURI,  uri);
-            }
-        }
-        else
-        {
-            CARLA_SAFE_ASSERT_RETURN(urid == uriCount,);
-            fCustomURIDs.push_back(uri);
-        }
+        // URIDs already sent are either known to the UI or on their way
+        sendNewUridsToUi();
     }
 
     // -------------------------------------------------------------------
@@ -6970,12 +8195,16 @@ private:
     float** fAudioOutBuffers;
     float** fCvInBuffers;
     float** fCvOutBuffers;
+    EngineAudioBufferArena fAudioBufferArena;
+    CarlaPluginLV2FixedBlock fFixedBlock;
     float*  fParamBuffers;
 
     bool    fHasLoadDefaultState : 1;
     bool    fHasThreadSafeRestore : 1;
     bool    fNeedsFixedBuffers : 1;
+    bool    fNeedsPowerOf2Buffers : 1;
     bool    fNeedsUiClose  : 1;
+    bool    fAudioConnectedDirectly : 1;
     bool    fInlineDisplayNeedsRedraw : 1;
     int64_t fInlineDisplayLastRedrawTime;
     int32_t fLatencyIndex; // -1 if invalid
@@ -6994,7 +8223,7 @@ private:
     CarlaPluginLV2Options   fLv2Options;
     CarlaPipeServerLV2      fPipeServer;
 
-    std::vector<std::string> fCustomURIDs;
+    LV2_URID fUridsSentToUi;
 
     bool fFirstActive; // first process() call after activate()
     void* fLastStateChunk;
@@ -7700,14 +8929,28 @@ bool CarlaPipeServerLV2::msgReceived(const char* const msg) noexcept
     if (std::strcmp(msg, "atom") == 0)
     {
         uint32_t index, atomTotalSize, base64Size;
+        const void* atomData;
         const char* base64atom;
 
         CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(index), true);
-        CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(atomTotalSize), true);
-        CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(base64Size), true);
-        CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(base64atom, false, base64Size), true);
 
-        std::vector<uint8_t> chunk(carla_getChunkFromBase64String(base64atom));
+        std::vector<uint8_t> chunk;
+
+        if (readNextBinaryFrame(atomData, atomTotalSize))
+        {
+            // copy, frame data is not aligned
+            const uint8_t* const atomBytes((const uint8_t*)atomData);
+            chunk.assign(atomBytes, atomBytes + atomTotalSize);
+        }
+        else
+        {
+            CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(atomTotalSize), true);
+            CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(base64Size), true);
+            CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(base64atom, false, base64Size), true);
+
+            chunk = carla_getChunkFromBase64String(base64atom);
+        }
+
         CARLA_SAFE_ASSERT_UINT2_RETURN(chunk.size() >= sizeof(LV2_Atom), chunk.size(), sizeof(LV2_Atom), true);
 
 #ifdef CARLA_PROPER_CPP11_SUPPORT
@@ -7731,7 +8974,7 @@ bool CarlaPipeServerLV2::msgReceived(const char* const msg) noexcept
         CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(index), true);
 
         try {
-            kPlugin->setMidiProgram(static_cast<int32_t>(index), false, true, true, false);
+            kPlugin->requestMidiProgramChange(static_cast<int32_t>(index), false, true, true);
         } CARLA_SAFE_EXCEPTION("msgReceived program");
 
         return true;
@@ -7746,12 +8989,12 @@ bool CarlaPipeServerLV2::msgReceived(const char* const msg) noexcept
         CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(size), true);
         CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(uri, false, size), true);
 
-        if (urid != 0)
-        {
-            try {
-                kPlugin->handleUridMap(urid, uri);
-            } CARLA_SAFE_EXCEPTION("msgReceived urid");
-        }
+        // the UI only sends requests, the URID is chosen here
+        CARLA_SAFE_ASSERT_UINT(urid == 0, urid);
+
+        try {
+            kPlugin->handleUridMap(uri);
+        } CARLA_SAFE_EXCEPTION("msgReceived urid");
 
         return true;
     }
@@ -7797,7 +9040,7 @@ CarlaPluginPtr CarlaPlugin::newLV2(const Initializer& init)
 
     std::shared_ptr<CarlaPluginLV2> plugin(new CarlaPluginLV2(init.engine, init.id));
 
-    if (! plugin->init(plugin, init.name, init.label, init.options))
+    if (! plugin->init(plugin, init.filename, init.name, init.label, init.options))
         return nullptr;
 
     return plugin;
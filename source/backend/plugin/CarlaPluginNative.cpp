@@ -19,7 +19,9 @@
 #include "CarlaEngine.hpp"
 
 #include "CarlaBackendUtils.hpp"
+#include "CarlaEngineUtils.hpp"
 #include "CarlaMathUtils.hpp"
+#include "CarlaRtLog.hpp"
 #include "CarlaNative.h"
 
 #include "water/misc/Time.h"
@@ -262,6 +264,9 @@ public:
           fLastProjectFolder(),
           fAudioAndCvInBuffers(nullptr),
           fAudioAndCvOutBuffers(nullptr),
+          fDirectInBuffers(nullptr),
+          fDirectOutBuffers(nullptr),
+          fAudioBufferArena(),
           fMidiEventInCount(0),
           fMidiEventOutCount(0),
           fCurBufferSize(engine->getBufferSize()),
@@ -272,6 +277,8 @@ public:
     {
         carla_debug("CarlaPluginNative::CarlaPluginNative(%p, %i)", engine, id);
 
+        pData->midiprog.supportsRT = true;
+
         carla_fill(fCurMidiProgs, 0, MAX_MIDI_CHANNELS);
         carla_zeroStructs(fMidiInEvents, kPluginMaxMidiEvents);
         carla_zeroStructs(fMidiOutEvents, kPluginMaxMidiEvents);
@@ -453,6 +460,15 @@ public:
         else if (hasMidiProgs)
             options |= PLUGIN_OPTION_MAP_PROGRAM_CHANGES;
 
+        options |= PLUGIN_OPTION_KEEP_DENORMALS;
+
+        if (pData->engine->getProccessMode() == ENGINE_PROCESS_MODE_PATCHBAY)
+            options |= PLUGIN_OPTION_DECOUPLED_BLOCKS;
+
+        // only effects can sleep, and CV inputs are not checked for silence
+        if (pData->audioIn.count != 0 && pData->cvIn.count == 0)
+            options |= PLUGIN_OPTION_AUTO_SLEEP;
+
         return options;
     }
 
@@ -1021,7 +1037,9 @@ public:
             {
                 const int64_t timeNow = water::Time::currentTimeMillis();
 
-                if (timeNow - fInlineDisplayLastRedrawTime > (1000 / 30))
+                const uint maxRate = pData->engine->getOptions().inlineDisplayMaxRate;
+
+                if (maxRate == 0 || timeNow - fInlineDisplayLastRedrawTime > static_cast<int64_t>(1000 / maxRate))
                 {
                     fInlineDisplayNeedsRedraw = false;
                     fInlineDisplayLastRedrawTime = timeNow;
@@ -1131,13 +1149,17 @@ public:
         if (const uint32_t acIns = aIns + cvIns)
         {
             fAudioAndCvInBuffers = new float*[acIns];
+            fDirectInBuffers     = new float*[acIns];
             carla_zeroPointers(fAudioAndCvInBuffers, acIns);
+            carla_zeroPointers(fDirectInBuffers, acIns);
         }
 
         if (const uint32_t acOuts = aOuts + cvOuts)
         {
             fAudioAndCvOutBuffers = new float*[acOuts];
+            fDirectOutBuffers     = new float*[acOuts];
             carla_zeroPointers(fAudioAndCvOutBuffers, acOuts);
+            carla_zeroPointers(fDirectOutBuffers, acOuts);
         }
 
         if (mIns > 0)
@@ -1434,7 +1456,7 @@ public:
         // extra plugin hints
         pData->extraHints = 0x0;
 
-        bufferSizeChanged(pData->engine->getBufferSize());
+        bufferSizeChanged(getBufferSize());
         reloadPrograms(true);
 
         if (pData->active)
@@ -1756,9 +1778,14 @@ public:
             return;
         }
 
-        fMidiEventInCount = fMidiEventOutCount = 0;
-        carla_zeroStructs(fMidiInEvents, kPluginMaxMidiEvents);
-        carla_zeroStructs(fMidiOutEvents, kPluginMaxMidiEvents);
+        // only clear what was used during the previous cycle, output events are always written whole
+        if (fMidiEventInCount > 0)
+        {
+            carla_zeroStructs(fMidiInEvents, fMidiEventInCount);
+            fMidiEventInCount = 0;
+        }
+
+        fMidiEventOutCount = 0;
 
         // --------------------------------------------------------------------------------------------------------
         // Check if needs reset
@@ -1868,26 +1895,22 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                ExternalMidiNote note = { 0, 0, 0 };
+                ExternalMidiNote note = { 0, 0, 0, 0 };
 
-                for (; fMidiEventInCount < kPluginMaxMidiEvents && ! pData->extNotes.data.isEmpty();)
+                for (; fMidiEventInCount < kPluginMaxMidiEvents && pData->extNotes.getNextRT(note, frames);)
                 {
-                    note = pData->extNotes.data.getFirst(note, true);
-
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                     NativeMidiEvent& nativeEvent(fMidiInEvents[fMidiEventInCount++]);
 
+                    nativeEvent.time    = note.time;
                     nativeEvent.data[0] = uint8_t((note.velo > 0 ? MIDI_STATUS_NOTE_ON : MIDI_STATUS_NOTE_OFF) | (note.channel & MIDI_CHANNEL_BIT));
                     nativeEvent.data[1] = note.note;
                     nativeEvent.data[2] = note.velo;
                     nativeEvent.size    = 3;
                 }
 
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -1924,17 +1947,25 @@ public:
 
                 if (eventTime < timeOffset)
                 {
-                    carla_stderr2("Timing error, eventTime:%u < timeOffset:%u for '%s'",
-                                  eventTime, timeOffset, pData->name);
+                    carla_rt_stderr2("Timing error, eventTime:%u < timeOffset:%u for '%s'",
+                                     eventTime, timeOffset, pData->name);
                     eventTime = timeOffset;
                 }
 
                 if (isSampleAccurate && eventTime > timeOffset)
                 {
-                    if (processSingle(audioIn, audioOut, cvIn, cvOut, eventTime - timeOffset, timeOffset))
+                    // split where the engine options allow, events in between keep their offset
+                    const uint32_t splitTime = pData->getEventSplitTime(eventTime, timeOffset, frames);
+
+                    if (splitTime <= timeOffset)
                     {
-                        startTime  = 0;
-                        timeOffset = eventTime;
+                        startTime = eventTime - timeOffset;
+                    }
+                    else if (processSingle(audioIn, audioOut, cvIn, cvOut, splitTime - timeOffset, timeOffset))
+                    {
+                        ++pData->eventSplitCount;
+                        startTime  = eventTime - splitTime;
+                        timeOffset = splitTime;
 
                         if (pData->midiprog.current >= 0 && pData->midiprog.count > 0)
                             nextBankId = pData->midiprog.data[pData->midiprog.current].bank;
@@ -1947,11 +1978,7 @@ public:
                             fMidiEventInCount = 0;
                         }
 
-                        if (fMidiEventOutCount > 0)
-                        {
-                            carla_zeroStructs(fMidiOutEvents, fMidiEventOutCount);
-                            fMidiEventOutCount = 0;
-                        }
+                        fMidiEventOutCount = 0;
                     }
                     else
                         startTime += timeOffset;
@@ -2030,8 +2057,15 @@ public:
                         }
 #endif
                         // Control plugin parameters
-                        for (uint32_t k=0; k < pData->param.count; ++k)
+                        const uint32_t* mappedParams = nullptr;
+                        uint32_t numMappedParams = 0;
+                        const bool useControlMap = pData->param.getMappedParameters(event.channel, ctrlEvent.param,
+                                                                                    mappedParams, numMappedParams);
+
+                        for (uint32_t m=0, end = useControlMap ? numMappedParams : pData->param.count; m < end; ++m)
                         {
+                            const uint32_t k = useControlMap ? mappedParams[m] : m;
+
                             if (pData->param.data[k].midiChannel != event.channel)
                                 continue;
                             if (pData->param.data[k].mappedControlIndex != ctrlEvent.param)
@@ -2243,8 +2277,6 @@ public:
                 } // switch (event.type)
             }
 
-            pData->postRtEvents.trySplice();
-
             if (frames > timeOffset)
                 processSingle(audioIn, audioOut, cvIn, cvOut, frames - timeOffset, timeOffset);
 
@@ -2332,9 +2364,34 @@ public:
             return false;
         }
 
+        // program changes requested by the host while we were running
+        pData->applyDeferredProgramChangesRT(this);
+
         // --------------------------------------------------------------------------------------------------------
         // Set audio buffers
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+        // in-place safe plugins run on the engine buffers as-is, as long as post-processing has nothing to do
+        const bool processDirectly = fHandle2 == nullptr &&
+                                     (fDescriptor->hints & NATIVE_PLUGIN_IS_INPLACE_SAFE) != 0 &&
+                                     pData->canProcessDirectly(true);
+#else
+        const bool processDirectly = false;
+#endif
+
+        if (processDirectly)
+        {
+            for (uint32_t i=0; i < pData->audioIn.count; ++i)
+                fDirectInBuffers[i] = const_cast<float*>(audioIn[i]) + timeOffset;
+            for (uint32_t i=0; i < pData->cvIn.count; ++i)
+                fDirectInBuffers[pData->audioIn.count+i] = const_cast<float*>(cvIn[i]) + timeOffset;
+
+            for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                fDirectOutBuffers[i] = audioOut[i] + timeOffset;
+            for (uint32_t i=0; i < pData->cvOut.count; ++i)
+                fDirectOutBuffers[pData->audioOut.count+i] = cvOut[i] + timeOffset;
+        }
+        else
         {
             for (uint32_t i=0; i < pData->audioIn.count; ++i)
                 carla_copyFloats(fAudioAndCvInBuffers[i], audioIn[i]+timeOffset, frames);
@@ -2352,7 +2409,13 @@ public:
 
         fIsProcessing = true;
 
-        if (fHandle2 == nullptr)
+        if (processDirectly)
+        {
+            fDescriptor->process(fHandle,
+                                 fDirectInBuffers, fDirectOutBuffers, frames,
+                                 fMidiInEvents, fMidiEventInCount);
+        }
+        else if (fHandle2 == nullptr)
         {
             fDescriptor->process(fHandle,
                                  fAudioAndCvInBuffers, fAudioAndCvOutBuffers, frames,
@@ -2376,81 +2439,28 @@ public:
         if (fTimeInfo.playing)
             fTimeInfo.frame += frames;
 
-        uint32_t i=0;
-#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
-        // --------------------------------------------------------------------------------------------------------
-        // Post-processing (dry/wet, volume and balance)
-
+        if (! processDirectly)
         {
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
+            uint32_t i=0;
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+            // ----------------------------------------------------------------------------------------------------
+            // Post-processing (dry/wet, volume and balance)
 
+            pData->processPostProc(fAudioAndCvInBuffers, 0, false, fAudioAndCvOutBuffers, audioOut, timeOffset, frames);
+            i = pData->audioOut.count;
+#else
             for (; i < pData->audioOut.count; ++i)
             {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        bufValue = fAudioAndCvInBuffers[(pData->audioIn.count == 1) ? 0 : i][k];
-                        fAudioAndCvOutBuffers[i][k] = (fAudioAndCvOutBuffers[i][k] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
-
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
-
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        carla_copyFloats(oldBufLeft, fAudioAndCvOutBuffers[i], frames);
-                    }
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            fAudioAndCvOutBuffers[i][k]  = oldBufLeft[k]            * (1.0f - balRangeL);
-                            fAudioAndCvOutBuffers[i][k] += fAudioAndCvOutBuffers[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            fAudioAndCvOutBuffers[i][k]  = fAudioAndCvOutBuffers[i][k] * balRangeR;
-                            fAudioAndCvOutBuffers[i][k] += oldBufLeft[k]          * balRangeL;
-                        }
-                    }
-                }
-
-                // Volume (and buffer copy)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        audioOut[i][k+timeOffset] = fAudioAndCvOutBuffers[i][k] * pData->postProc.volume;
-                }
+                for (uint32_t k=0; k < frames; ++k)
+                    audioOut[i][k+timeOffset] = fAudioAndCvOutBuffers[i][k];
             }
-
-        } // End of Post-processing
-#else
-        for (; i < pData->audioOut.count; ++i)
-        {
-            for (uint32_t k=0; k < frames; ++k)
-                audioOut[i][k+timeOffset] = fAudioAndCvOutBuffers[i][k];
-        }
 #endif
-        // CV stuff too
-        for (; i < pData->cvOut.count; ++i)
-        {
-            for (uint32_t k=0; k < frames; ++k)
-                cvOut[i][k+timeOffset] = fAudioAndCvOutBuffers[pData->audioOut.count+i][k];
+            // CV stuff too
+            for (; i < pData->cvOut.count; ++i)
+            {
+                for (uint32_t k=0; k < frames; ++k)
+                    cvOut[i][k+timeOffset] = fAudioAndCvOutBuffers[pData->audioOut.count+i][k];
+            }
         }
 
         // --------------------------------------------------------------------------------------------------------
@@ -2481,19 +2491,14 @@ public:
         CARLA_ASSERT_INT(newBufferSize > 0, newBufferSize);
         carla_debug("CarlaPluginNative::bufferSizeChanged(%i)", newBufferSize);
 
+        fAudioBufferArena.reset(pData->audioIn.count + pData->cvIn.count + pData->audioOut.count + pData->cvOut.count,
+                                newBufferSize);
+
         for (uint32_t i=0; i < (pData->audioIn.count+pData->cvIn.count); ++i)
-        {
-            if (fAudioAndCvInBuffers[i] != nullptr)
-                delete[] fAudioAndCvInBuffers[i];
-            fAudioAndCvInBuffers[i] = new float[newBufferSize];
-        }
+            fAudioAndCvInBuffers[i] = fAudioBufferArena.allocate();
 
         for (uint32_t i=0; i < (pData->audioOut.count+pData->cvOut.count); ++i)
-        {
-            if (fAudioAndCvOutBuffers[i] != nullptr)
-                delete[] fAudioAndCvOutBuffers[i];
-            fAudioAndCvOutBuffers[i] = new float[newBufferSize];
-        }
+            fAudioAndCvOutBuffers[i] = fAudioBufferArena.allocate();
 
         if (fCurBufferSize == newBufferSize)
             return;
@@ -2561,34 +2566,30 @@ public:
 
         if (fAudioAndCvInBuffers != nullptr)
         {
-            for (uint32_t i=0; i < (pData->audioIn.count+pData->cvIn.count); ++i)
-            {
-                if (fAudioAndCvInBuffers[i] != nullptr)
-                {
-                    delete[] fAudioAndCvInBuffers[i];
-                    fAudioAndCvInBuffers[i] = nullptr;
-                }
-            }
-
             delete[] fAudioAndCvInBuffers;
             fAudioAndCvInBuffers = nullptr;
         }
 
         if (fAudioAndCvOutBuffers != nullptr)
         {
-            for (uint32_t i=0; i < (pData->audioOut.count+pData->cvOut.count); ++i)
-            {
-                if (fAudioAndCvOutBuffers[i] != nullptr)
-                {
-                    delete[] fAudioAndCvOutBuffers[i];
-                    fAudioAndCvOutBuffers[i] = nullptr;
-                }
-            }
-
             delete[] fAudioAndCvOutBuffers;
             fAudioAndCvOutBuffers = nullptr;
         }
 
+        if (fDirectInBuffers != nullptr)
+        {
+            delete[] fDirectInBuffers;
+            fDirectInBuffers = nullptr;
+        }
+
+        if (fDirectOutBuffers != nullptr)
+        {
+            delete[] fDirectOutBuffers;
+            fDirectOutBuffers = nullptr;
+        }
+
+        fAudioBufferArena.reset(0, 0);
+
         if (fMidiIn.count > 1)
             pData->event.portIn = nullptr;
 
@@ -2818,6 +2819,7 @@ protected:
 
         case NATIVE_HOST_OPCODE_REQUEST_IDLE:
             fNeedsIdle = true;
+            pData->engine->requestIdle();
             break;
 
         case NATIVE_HOST_OPCODE_GET_FILE_PATH:
@@ -2933,7 +2935,7 @@ public:
         // ---------------------------------------------------------------
         // set icon
 
-        /**/ if (std::strcmp(fDescriptor->label, "audiofile") == 0)
+        /**/ if (std::strncmp(fDescriptor->label, "audiofile", 9) == 0)
             pData->iconName = carla_strdup_safe("file");
         else if (std::strcmp(fDescriptor->label, "midifile") == 0)
             pData->iconName = carla_strdup_safe("file");
@@ -3061,6 +3063,10 @@ public:
                 pData->options |= PLUGIN_OPTION_MAP_PROGRAM_CHANGES;
         }
 
+        // off by default, needs to be explicitly enabled per plugin
+        if (options & PLUGIN_OPTION_AUTO_SLEEP)
+            pData->options |= PLUGIN_OPTION_AUTO_SLEEP;
+
         return true;
     }
 
@@ -3085,6 +3091,9 @@ private:
 
     float**         fAudioAndCvInBuffers;
     float**         fAudioAndCvOutBuffers;
+    float**         fDirectInBuffers;
+    float**         fDirectOutBuffers;
+    EngineAudioBufferArena fAudioBufferArena;
     uint32_t        fMidiEventInCount;
     uint32_t        fMidiEventOutCount;
     NativeMidiEvent fMidiInEvents[kPluginMaxMidiEvents];
@@ -18,6 +18,7 @@
 #include "CarlaPluginInternal.hpp"
 #include "CarlaBackendUtils.hpp"
 #include "CarlaEngine.hpp"
+#include "CarlaRtLog.hpp"
 
 #include "sfzero/SFZero.h"
 
@@ -34,12 +35,6 @@ using water::String;
 
 CARLA_BACKEND_START_NAMESPACE
 
-// -------------------------------------------------------------------------------------------------------------------
-// Fallback data
-
-static const ExternalMidiNote kExternalMidiNoteFallback = { -1, 0, 0 };
-
-
 static void loadingIdleCallbackFunction(void* ptr)
 {
     ((CarlaEngine*)ptr)->callback(true, false, ENGINE_CALLBACK_IDLE, 0, 0, 0, 0, 0.0f, nullptr);
@@ -52,6 +47,7 @@ class CarlaPluginSFZero : public CarlaPlugin
 public:
     CarlaPluginSFZero(CarlaEngine* const engine, const uint id)
         : CarlaPlugin(engine, id),
+          fStreamer(),
           fSynth(),
           fNumVoices(0.0f),
           fLabel(nullptr),
@@ -76,6 +72,8 @@ public:
             pData->active = false;
         }
 
+        fStreamer.stopNow();
+
         if (fLabel != nullptr)
         {
             delete[] fLabel;
@@ -128,6 +126,9 @@ public:
         options |= PLUGIN_OPTION_SEND_ALL_SOUND_OFF;
         options |= PLUGIN_OPTION_SKIP_SENDING_NOTES;
 
+        if (pData->engine->getProccessMode() == ENGINE_PROCESS_MODE_PATCHBAY)
+            options |= PLUGIN_OPTION_DECOUPLED_BLOCKS;
+
         return options;
     }
 
@@ -299,7 +300,7 @@ public:
         pData->extraHints  = 0x0;
         pData->extraHints |= PLUGIN_EXTRA_HINT_HAS_MIDI_IN;
 
-        bufferSizeChanged(pData->engine->getBufferSize());
+        bufferSizeChanged(getBufferSize());
         reloadPrograms(true);
 
         if (pData->active)
@@ -347,11 +348,11 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                for (RtLinkedList<ExternalMidiNote>::Itenerator it = pData->extNotes.data.begin2(); it.valid(); it.next())
+                ExternalMidiNote note = { 0, 0, 0, 0 };
+
+                while (pData->extNotes.getNextRT(note, frames))
                 {
-                    const ExternalMidiNote& note(it.getValue(kExternalMidiNoteFallback));
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                     if (note.velo > 0)
@@ -360,9 +361,6 @@ public:
                         fSynth.noteOff(note.channel+1, note.note, static_cast<float>(note.velo)/127.0f, true);
                 }
 
-                pData->extNotes.data.clear();
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -382,8 +380,8 @@ public:
 
                 if (eventTime < timeOffset)
                 {
-                    carla_stderr2("Timing error, eventTime:%u < timeOffset:%u for '%s'",
-                                  eventTime, timeOffset, pData->name);
+                    carla_rt_stderr2("Timing error, eventTime:%u < timeOffset:%u for '%s'",
+                                     eventTime, timeOffset, pData->name);
                     eventTime = timeOffset;
                 }
                 else if (eventTime > timeOffset)
@@ -454,8 +452,15 @@ public:
                         }
 #endif
                         // Control plugin parameters
-                        for (uint32_t k=0; k < pData->param.count; ++k)
+                        const uint32_t* mappedParams = nullptr;
+                        uint32_t numMappedParams = 0;
+                        const bool useControlMap = pData->param.getMappedParameters(event.channel, ctrlEvent.param,
+                                                                                    mappedParams, numMappedParams);
+
+                        for (uint32_t m=0, end = useControlMap ? numMappedParams : pData->param.count; m < end; ++m)
                         {
+                            const uint32_t k = useControlMap ? mappedParams[m] : m;
+
                             if (pData->param.data[k].midiChannel != event.channel)
                                 continue;
                             if (pData->param.data[k].mappedControlIndex != ctrlEvent.param)
@@ -552,8 +557,6 @@ public:
                 }
             }
 
-            pData->postRtEvents.trySplice();
-
             if (frames > timeOffset)
                 processSingle(audioOutBuffer, frames - timeOffset, timeOffset);
 
@@ -661,7 +664,10 @@ public:
     // -------------------------------------------------------------------
     // Plugin buffers
 
-    // nothing
+    void bufferSizeChanged(const uint32_t newBufferSize) override
+    {
+        fSynth.setNumRenderThreads(pData->engine->getOptions().sfzRenderThreads, 2, static_cast<int>(newBufferSize));
+    }
 
     // -------------------------------------------------------------------
 
@@ -685,8 +691,13 @@ public:
             return false;
         }
 
+        const uint preloadTime = pData->engine->getOptions().sfzPreloadTime;
+
+        if (preloadTime != 0)
+            fStreamer.allocate(128);
+
         for (int i = 128; --i >=0;)
-            fSynth.addVoice(new sfzero::Voice());
+            fSynth.addVoice(new sfzero::Voice(&fStreamer));
 
         // ---------------------------------------------------------------
         // Init SFZero stuff
@@ -702,7 +713,7 @@ public:
         };
 
         sound->loadRegions();
-        sound->loadSamples(cb);
+        sound->loadSamples(cb, preloadTime);
 
         if (fSynth.addSound(sound) == nullptr)
         {
@@ -712,6 +723,8 @@ public:
 
         sound->dumpToConsole();
 
+        fStreamer.startNow();
+
         // ---------------------------------------------------------------
 
         const String basename(File(filename).getFileNameWithoutExtension());
@@ -765,6 +778,7 @@ public:
     // -------------------------------------------------------------------
 
 private:
+    sfzero::SampleStreamer fStreamer;
     sfzero::Synth fSynth;
     float fNumVoices;
 
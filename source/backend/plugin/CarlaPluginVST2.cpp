@@ -23,8 +23,10 @@
 #endif
 
 #include "CarlaBackendUtils.hpp"
+#include "CarlaEngineUtils.hpp"
 #include "CarlaMathUtils.hpp"
 #include "CarlaProcessUtils.hpp"
+#include "CarlaRtLog.hpp"
 #include "CarlaScopeUtils.hpp"
 #include "CarlaVstUtils.hpp"
 
@@ -74,6 +76,7 @@ public:
           fUnique1(1),
           fEffect(nullptr),
           fMidiEventCount(0),
+          fMidiOutEventCount(0),
           fTimeInfo(),
           fNeedIdle(false),
           fLastChunk(nullptr),
@@ -90,6 +93,7 @@ public:
           fFirstActive(true),
           fBufferSize(engine->getBufferSize()),
           fAudioOutBuffers(nullptr),
+          fAudioBufferArena(),
           fLastTimeInfo(),
           fEvents(),
           fUI(),
@@ -97,6 +101,8 @@ public:
     {
         carla_debug("CarlaPluginVST2::CarlaPluginVST2(%p, %i)", engine, id);
 
+        pData->prog.supportsRT = true;
+
         carla_zeroStructs(fMidiEvents, kPluginMaxMidiEvents*2);
         carla_zeroStruct(fTimeInfo);
 
@@ -267,6 +273,15 @@ public:
             options |= PLUGIN_OPTION_SKIP_SENDING_NOTES;
         }
 
+        options |= PLUGIN_OPTION_KEEP_DENORMALS;
+
+        if (pData->engine->getProccessMode() == ENGINE_PROCESS_MODE_PATCHBAY)
+            options |= PLUGIN_OPTION_DECOUPLED_BLOCKS;
+
+        // only effects can sleep, and CV inputs are not checked for silence
+        if (pData->audioIn.count != 0 && pData->cvIn.count == 0)
+            options |= PLUGIN_OPTION_AUTO_SLEEP;
+
         return options;
     }
 
@@ -341,7 +356,7 @@ public:
         dispatcher(effGetParamDisplay, static_cast<int32_t>(parameterId), 0, strBuf);
 
         if (strBuf[0] == '\0')
-            std::snprintf(strBuf, STR_MAX, "%.12g", static_cast<double>(getParameterValue(parameterId)));
+            std::snprintf(strBuf, STR_MAX, "%s", CarlaFloatString(getParameterValue(parameterId)).buffer);
 
         return true;
     }
@@ -991,7 +1006,7 @@ public:
 #endif
         }
 
-        bufferSizeChanged(pData->engine->getBufferSize());
+        bufferSizeChanged(getBufferSize());
         reloadPrograms(true);
 
         if (pData->active)
@@ -1145,8 +1160,18 @@ public:
             return;
         }
 
-        fMidiEventCount = 0;
-        carla_zeroStructs(fMidiEvents, kPluginMaxMidiEvents*2);
+        // only clear what was used during the previous cycle
+        if (fMidiEventCount > 0)
+        {
+            carla_zeroStructs(fMidiEvents, fMidiEventCount);
+            fMidiEventCount = 0;
+        }
+
+        if (fMidiOutEventCount > 0)
+        {
+            carla_zeroStructs(fMidiEvents + (kPluginMaxMidiEvents*2 - fMidiOutEventCount), fMidiOutEventCount);
+            fMidiOutEventCount = 0;
+        }
 
         // --------------------------------------------------------------------------------------------------------
         // Check if needs reset
@@ -1216,13 +1241,8 @@ public:
             CARLA_SAFE_ASSERT_INT(timeInfo.bbt.bar > 0, timeInfo.bbt.bar);
             CARLA_SAFE_ASSERT_INT(timeInfo.bbt.beat > 0, timeInfo.bbt.beat);
 
-            const double ppqBar  = static_cast<double>(timeInfo.bbt.beatsPerBar) * (timeInfo.bbt.bar - 1);
-            // const double ppqBeat = static_cast<double>(timeInfo.bbt.beat - 1);
-            // const double ppqTick = timeInfo.bbt.tick / timeInfo.bbt.ticksPerBeat;
-
             // PPQ Pos
-            fTimeInfo.ppqPos = fTimeInfo.samplePos / (fTimeInfo.sampleRate * 60 / fTimeInfo.tempo);
-            // fTimeInfo.ppqPos = ppqBar + ppqBeat + ppqTick;
+            fTimeInfo.ppqPos = timeInfo.bbt.ppqPos;
             fTimeInfo.flags |= kVstPpqPosValid;
 
             // Tempo
@@ -1230,7 +1250,7 @@ public:
             fTimeInfo.flags |= kVstTempoValid;
 
             // Bars
-            fTimeInfo.barStartPos = ppqBar;
+            fTimeInfo.barStartPos = timeInfo.bbt.ppqBarStartPos;
             fTimeInfo.flags |= kVstBarsValid;
 
             // Time Signature
@@ -1262,27 +1282,23 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                ExternalMidiNote note = { 0, 0, 0 };
+                ExternalMidiNote note = { 0, 0, 0, 0 };
 
-                for (; fMidiEventCount < kPluginMaxMidiEvents*2 && ! pData->extNotes.data.isEmpty();)
+                for (; fMidiEventCount < kPluginMaxMidiEvents*2 && pData->extNotes.getNextRT(note, frames);)
                 {
-                    note = pData->extNotes.data.getFirst(note, true);
-
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                     VstMidiEvent& vstMidiEvent(fMidiEvents[fMidiEventCount++]);
 
                     vstMidiEvent.type        = kVstMidiType;
                     vstMidiEvent.byteSize    = kVstMidiEventSize;
+                    vstMidiEvent.deltaFrames = static_cast<int32_t>(note.time);
                     vstMidiEvent.midiData[0] = char((note.velo > 0 ? MIDI_STATUS_NOTE_ON : MIDI_STATUS_NOTE_OFF) | (note.channel & MIDI_CHANNEL_BIT));
                     vstMidiEvent.midiData[1] = char(note.note);
                     vstMidiEvent.midiData[2] = char(note.velo);
                 }
 
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -1310,28 +1326,27 @@ public:
 
                 if (eventTime < timeOffset)
                 {
-                    carla_stderr2("Timing error, eventTime:%u < timeOffset:%u for '%s'",
-                                  eventTime, timeOffset, pData->name);
+                    carla_rt_stderr2("Timing error, eventTime:%u < timeOffset:%u for '%s'",
+                                     eventTime, timeOffset, pData->name);
                     eventTime = timeOffset;
                 }
 
-                if (isSampleAccurate && eventTime > timeOffset)
+                // MIDI already carries its offset, only parameter changes need the block to be split.
+                // Splits happen where the engine options allow, events in between keep their offset.
+                if (isSampleAccurate && eventTime > timeOffset && isParameterChangeEvent(event))
                 {
-                    if (processSingle(audioIn, audioOut, eventTime - timeOffset, timeOffset))
-                    {
-                        startTime  = 0;
-                        timeOffset = eventTime;
+                    const uint32_t splitTime = pData->getEventSplitTime(eventTime, timeOffset, frames);
 
-                        if (fMidiEventCount > 0)
-                        {
-                            carla_zeroStructs(fMidiEvents, fMidiEventCount);
-                            fMidiEventCount = 0;
-                        }
+                    if (splitTime > timeOffset && processSingle(audioIn, audioOut, splitTime - timeOffset, timeOffset))
+                    {
+                        ++pData->eventSplitCount;
+                        removeProcessedMidiEvents(splitTime - timeOffset);
+                        timeOffset = splitTime;
                     }
-                    else
-                        startTime += timeOffset;
                 }
 
+                startTime = eventTime - timeOffset;
+
                 switch (event.type)
                 {
                 case kEngineEventTypeNull:
@@ -1404,9 +1419,15 @@ public:
                         }
 #endif
                         // Control plugin parameters
-                        uint32_t k;
-                        for (k=0; k < pData->param.count; ++k)
+                        const uint32_t* mappedParams = nullptr;
+                        uint32_t numMappedParams = 0;
+                        const bool useControlMap = pData->param.getMappedParameters(event.channel, ctrlEvent.param,
+                                                                                    mappedParams, numMappedParams);
+
+                        for (uint32_t m=0, end = useControlMap ? numMappedParams : pData->param.count; m < end; ++m)
                         {
+                            const uint32_t k = useControlMap ? mappedParams[m] : m;
+
                             if (pData->param.data[k].midiChannel != event.channel)
                                 continue;
                             if (pData->param.data[k].mappedControlIndex != ctrlEvent.param)
@@ -1600,8 +1621,6 @@ public:
                 } // switch (event.type)
             }
 
-            pData->postRtEvents.trySplice();
-
             if (frames > timeOffset)
                 processSingle(audioIn, audioOut, frames - timeOffset, timeOffset);
 
@@ -1622,12 +1641,12 @@ public:
         if (pData->event.portOut != nullptr)
         {
             // reverse lookup MIDI events
-            for (uint32_t k = (kPluginMaxMidiEvents*2)-1; k >= fMidiEventCount; --k)
+            for (uint32_t i=0; i < fMidiOutEventCount; ++i)
             {
-                if (fMidiEvents[k].type == 0)
-                    break;
+                const VstMidiEvent& vstMidiEvent(fMidiEvents[kPluginMaxMidiEvents*2 - 1 - i]);
 
-                const VstMidiEvent& vstMidiEvent(fMidiEvents[k]);
+                if (vstMidiEvent.type == 0)
+                    break;
 
                 CARLA_SAFE_ASSERT_CONTINUE(vstMidiEvent.deltaFrames >= 0);
                 CARLA_SAFE_ASSERT_CONTINUE(vstMidiEvent.midiData[0] != 0);
@@ -1690,16 +1709,30 @@ public:
             return false;
         }
 
+        // program changes requested by the host while we were running
+        pData->applyDeferredProgramChangesRT(this);
+
         // --------------------------------------------------------------------------------------------------------
         // Set audio buffers
 
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+        // write straight into the engine buffers if post-processing has nothing to do
+        const bool processDirectly = pData->canProcessDirectly();
+#else
+        const bool processDirectly = false;
+#endif
+
         float* vstInBuffer[pData->audioIn.count];
+        float* vstOutBuffer[pData->audioOut.count];
 
         for (uint32_t i=0; i < pData->audioIn.count; ++i)
             vstInBuffer[i] = const_cast<float*>(inBuffer[i]+timeOffset);
 
         for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            carla_zeroFloats(fAudioOutBuffers[i], frames);
+        {
+            vstOutBuffer[i] = processDirectly ? outBuffer[i]+timeOffset : fAudioOutBuffers[i];
+            carla_zeroFloats(vstOutBuffer[i], frames);
+        }
 
         // --------------------------------------------------------------------------------------------------------
         // Set MIDI events
@@ -1720,7 +1753,7 @@ public:
         {
             fEffect->processReplacing(fEffect,
                                       (pData->audioIn.count > 0) ? vstInBuffer : nullptr,
-                                      (pData->audioOut.count > 0) ? fAudioOutBuffers : nullptr,
+                                      (pData->audioOut.count > 0) ? vstOutBuffer : nullptr,
                                       static_cast<int32_t>(frames));
         }
         else
@@ -1728,7 +1761,7 @@ public:
 #if ! VST_FORCE_DEPRECATED
             fEffect->process(fEffect,
                              (pData->audioIn.count > 0) ? vstInBuffer : nullptr,
-                             (pData->audioOut.count > 0) ? fAudioOutBuffers : nullptr,
+                             (pData->audioOut.count > 0) ? vstOutBuffer : nullptr,
                              static_cast<int32_t>(frames));
 #endif
         }
@@ -1740,67 +1773,15 @@ public:
         // --------------------------------------------------------------------------------------------------------
         // Post-processing (dry/wet, volume and balance)
 
-        {
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-            const bool isMono    = (pData->audioIn.count == 1);
-
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    const uint32_t c = isMono ? 0 : i;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        bufValue = inBuffer[c][k+timeOffset];
-                        fAudioOutBuffers[i][k] = (fAudioOutBuffers[i][k] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
-
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
-
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        carla_copyFloats(oldBufLeft, fAudioOutBuffers[i], frames);
-                    }
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            fAudioOutBuffers[i][k]  = oldBufLeft[k]            * (1.0f - balRangeL);
-                            fAudioOutBuffers[i][k] += fAudioOutBuffers[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            fAudioOutBuffers[i][k]  = fAudioOutBuffers[i][k] * balRangeR;
-                            fAudioOutBuffers[i][k] += oldBufLeft[k]          * balRangeL;
-                        }
-                    }
-                }
+        if (! processDirectly)
+            pData->processPostProc(inBuffer, timeOffset, true, fAudioOutBuffers, outBuffer, timeOffset, frames);
 
-                // Volume (and buffer copy)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        outBuffer[i][k+timeOffset] = fAudioOutBuffers[i][k] * pData->postProc.volume;
-                }
-            }
+# ifndef BUILD_BRIDGE
+        // --------------------------------------------------------------------------------------------------------
+        // Save latency values for next callback
 
-        } // End of Post-processing
+        pData->latency.saveInputs(vstInBuffer, pData->audioIn.count, frames);
+# endif
 #else // BUILD_BRIDGE_ALTERNATIVE_ARCH
         for (uint32_t i=0; i < pData->audioOut.count; ++i)
         {
@@ -1815,22 +1796,59 @@ public:
         return true;
     }
 
+    // events that change parameters or programs, which VST2 can only apply at the start of a block
+    static bool isParameterChangeEvent(const EngineEvent& event) noexcept
+    {
+        if (event.type != kEngineEventTypeControl)
+            return false;
+
+        switch (event.ctrl.type)
+        {
+        case kEngineControlEventTypeParameter:
+        case kEngineControlEventTypeMidiBank:
+        case kEngineControlEventTypeMidiProgram:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // drop the MIDI events sent to the plugin in the last sub-block, keeping later ones for the next
+    void removeProcessedMidiEvents(const uint32_t frames) noexcept
+    {
+        uint32_t count = 0;
+
+        for (uint32_t i=0; i < fMidiEventCount; ++i)
+        {
+            if (fMidiEvents[i].deltaFrames < static_cast<int32_t>(frames))
+                continue;
+
+            if (count != i)
+                fMidiEvents[count] = fMidiEvents[i];
+
+            fMidiEvents[count++].deltaFrames -= static_cast<int32_t>(frames);
+        }
+
+        if (count < fMidiEventCount)
+            carla_zeroStructs(fMidiEvents + count, fMidiEventCount - count);
+
+        fMidiEventCount = count;
+    }
+
     void bufferSizeChanged(const uint32_t newBufferSize) override
     {
         CARLA_ASSERT_INT(newBufferSize > 0, newBufferSize);
         carla_debug("CarlaPluginVST2::bufferSizeChanged(%i)", newBufferSize);
 
-        fBufferSize = pData->engine->getBufferSize();
+        fBufferSize = newBufferSize;
 
         if (pData->active)
             deactivate();
 
+        fAudioBufferArena.reset(pData->audioOut.count, newBufferSize);
+
         for (uint32_t i=0; i < pData->audioOut.count; ++i)
-        {
-            if (fAudioOutBuffers[i] != nullptr)
-                delete[] fAudioOutBuffers[i];
-            fAudioOutBuffers[i] = new float[newBufferSize];
-        }
+            fAudioOutBuffers[i] = fAudioBufferArena.allocate();
 
 #if ! VST_FORCE_DEPRECATED
         dispatcher(effSetBlockSizeAndSampleRate, 0, static_cast<int32_t>(newBufferSize), nullptr, static_cast<float>(pData->engine->getSampleRate()));
@@ -1850,7 +1868,7 @@ public:
             deactivate();
 
 #if ! VST_FORCE_DEPRECATED
-        dispatcher(effSetBlockSizeAndSampleRate, 0, static_cast<int32_t>(pData->engine->getBufferSize()), nullptr, static_cast<float>(newSampleRate));
+        dispatcher(effSetBlockSizeAndSampleRate, 0, static_cast<int32_t>(getBufferSize()), nullptr, static_cast<float>(newSampleRate));
 #endif
         dispatcher(effSetSampleRate, 0, 0, nullptr, static_cast<float>(newSampleRate));
 
@@ -1867,19 +1885,12 @@ public:
 
         if (fAudioOutBuffers != nullptr)
         {
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                if (fAudioOutBuffers[i] != nullptr)
-                {
-                    delete[] fAudioOutBuffers[i];
-                    fAudioOutBuffers[i] = nullptr;
-                }
-            }
-
             delete[] fAudioOutBuffers;
             fAudioOutBuffers = nullptr;
         }
 
+        fAudioBufferArena.reset(0, 0);
+
         CarlaPlugin::clearBuffers();
 
         carla_debug("CarlaPluginVST2::clearBuffers() - end");
@@ -2060,15 +2071,12 @@ protected:
                     if (vstMidiEvent->type != kVstMidiType)
                         continue;
 
-                    // reverse-find first free event, and put it there
-                    for (uint32_t j=(kPluginMaxMidiEvents*2)-1; j >= fMidiEventCount; --j)
-                    {
-                        if (fMidiEvents[j].type == 0)
-                        {
-                            std::memcpy(&fMidiEvents[j], vstMidiEvent, sizeof(VstMidiEvent));
-                            break;
-                        }
-                    }
+                    // put it in the next free event from the end, while not reaching the input ones
+                    if (fMidiEventCount + fMidiOutEventCount >= kPluginMaxMidiEvents*2)
+                        break;
+
+                    const uint32_t j = kPluginMaxMidiEvents*2 - 1 - fMidiOutEventCount++;
+                    std::memcpy(&fMidiEvents[j], vstMidiEvent, sizeof(VstMidiEvent));
                 }
             }
             ret = 1;
@@ -2159,7 +2167,7 @@ protected:
             break;
 
         case audioMasterGetBlockSize:
-            ret = static_cast<intptr_t>(pData->engine->getBufferSize());
+            ret = static_cast<intptr_t>(getBufferSize());
             break;
 
         case audioMasterGetInputLatency:
@@ -2652,6 +2660,10 @@ public:
             if (isPluginOptionEnabled(options, PLUGIN_OPTION_MAP_PROGRAM_CHANGES))
                 pData->options |= PLUGIN_OPTION_MAP_PROGRAM_CHANGES;
 
+        // off by default, needs to be explicitly enabled per plugin
+        if (options & PLUGIN_OPTION_AUTO_SLEEP)
+            pData->options |= PLUGIN_OPTION_AUTO_SLEEP;
+
         return true;
     }
 
@@ -2660,7 +2672,9 @@ private:
 
     AEffect* fEffect;
 
+    // input events fill fMidiEvents from the start, output events from the end
     uint32_t     fMidiEventCount;
+    uint32_t     fMidiOutEventCount;
     VstMidiEvent fMidiEvents[kPluginMaxMidiEvents*2];
     VstTimeInfo  fTimeInfo;
 
@@ -2682,6 +2696,7 @@ private:
     bool fFirstActive; // first process() call after activate()
     uint32_t fBufferSize;
     float** fAudioOutBuffers;
+    EngineAudioBufferArena fAudioBufferArena;
     EngineTimeInfo fLastTimeInfo;
 
     struct FixedVstEvents {
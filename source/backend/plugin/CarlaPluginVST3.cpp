@@ -15,25 +15,3129 @@
  * For a full copy of the GNU General Public License see the doc/GPL.txt file.
  */
 
-#include "CarlaPlugin.hpp"
+#include "CarlaPluginInternal.hpp"
 #include "CarlaEngine.hpp"
-#include "CarlaUtils.hpp"
+
+#if defined(USING_JUCE) && JUCE_PLUGINHOST_VST3
+# define USE_JUCE_FOR_VST3
+#endif
+
+#include "CarlaBackendUtils.hpp"
+#include "CarlaEngineUtils.hpp"
+#include "CarlaMathUtils.hpp"
+#include "CarlaScopeUtils.hpp"
+#include "CarlaVst3Utils.hpp"
+
+#include "water/memory/ByteOrder.h"
+#include "water/memory/MemoryBlock.h"
+#include "water/xml/XmlDocument.h"
+#include "water/xml/XmlElement.h"
+
+using water::ByteOrder;
+using water::MemoryBlock;
+using water::String;
+using water::XmlDocument;
+using water::XmlElement;
+
+using namespace Steinberg;
 
 CARLA_BACKEND_START_NAMESPACE
 
+// -----------------------------------------------------
+// Host application shared by all plugin factories and instances
+
+static CarlaVst3HostApplication& getHostApplication() noexcept
+{
+    static CarlaVst3HostApplication hostApp;
+    return hostApp;
+}
+
+// -----------------------------------------------------
+// Plugin state, stored in the same format as JUCE so projects saved with the previous VST3 host keep loading
+
+static const uint32_t kJuceStateMagic = 0x21324356;
+static const char     kJuceBase64Table[] = ".ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+";
+
+static void encodeJuceBase64(std::string& out, const void* const data, const std::size_t size)
+{
+    const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+    const std::size_t numChars = (size * 8 + 5) / 6;
+
+    out += std::to_string(size);
+    out += '.';
+
+    for (std::size_t i=0; i < numChars; ++i)
+    {
+        const std::size_t bit    = i * 6;
+        const std::size_t byte   = bit >> 3;
+        const std::size_t offset = bit & 7;
+
+        uint value = static_cast<uint>(bytes[byte] >> offset);
+
+        if (offset > 2 && byte + 1 < size)
+            value |= static_cast<uint>(bytes[byte + 1]) << (8 - offset);
+
+        out += kJuceBase64Table[value & 0x3f];
+    }
+}
+
+static bool decodeJuceBase64(MemoryBlock& block, const char* const text)
+{
+    const char* const dot = std::strchr(text, '.');
+    CARLA_SAFE_ASSERT_RETURN(dot != nullptr, false);
+
+    const long size = std::atol(text);
+    CARLA_SAFE_ASSERT_RETURN(size >= 0, false);
+
+    block.setSize(static_cast<std::size_t>(size), true);
+
+    uint8_t* const bytes = static_cast<uint8_t*>(block.getData());
+    std::size_t bit = 0;
+
+    for (const char* c = dot + 1; *c != '\0'; ++c)
+    {
+        const char* const pos = std::strchr(kJuceBase64Table, *c);
+
+        if (pos == nullptr)
+            continue;
+
+        const uint value = static_cast<uint>(pos - kJuceBase64Table);
+        const std::size_t byte   = bit >> 3;
+        const std::size_t offset = bit & 7;
+
+        if (byte >= static_cast<std::size_t>(size))
+            break;
+
+        bytes[byte] = static_cast<uint8_t>(bytes[byte] | (value << offset));
+
+        if (offset > 2 && byte + 1 < static_cast<std::size_t>(size))
+            bytes[byte + 1] = static_cast<uint8_t>(bytes[byte + 1] | (value >> (8 - offset)));
+
+        bit += 6;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------
+// Memory stream for plugin state, either growing (for writing) or a view into existing data (for reading)
+
+class CarlaVst3MemoryStream : public IBStream
+{
+public:
+    CarlaVst3MemoryStream() noexcept
+        : fData(nullptr),
+          fSize(0),
+          fAllocated(0),
+          fPosition(0),
+          fReadOnly(false) {}
+
+    CarlaVst3MemoryStream(const void* const data, const std::size_t size) noexcept
+        : fData(static_cast<uint8_t*>(const_cast<void*>(data))),
+          fSize(static_cast<int64>(size)),
+          fAllocated(static_cast<int64>(size)),
+          fPosition(0),
+          fReadOnly(true) {}
+
+    virtual ~CarlaVst3MemoryStream()
+    {
+        if (! fReadOnly && fData != nullptr)
+            std::free(fData);
+    }
+
+    const void* getData() const noexcept
+    {
+        return fData;
+    }
+
+    std::size_t getSize() const noexcept
+    {
+        return static_cast<std::size_t>(fSize);
+    }
+
+    tresult PLUGIN_API queryInterface(const TUID iid, void** const obj) override
+    {
+        if (FUnknownPrivate::iidEqual(iid, FUnknown_iid) || FUnknownPrivate::iidEqual(iid, IBStream_iid))
+        {
+            *obj = this;
+            return kResultOk;
+        }
+
+        *obj = nullptr;
+        return kNoInterface;
+    }
+
+    // always used on the stack
+    uint32 PLUGIN_API addRef() override { return 1; }
+    uint32 PLUGIN_API release() override { return 1; }
+
+    tresult PLUGIN_API read(void* const buffer, const int32 numBytes, int32* const numBytesRead) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(buffer != nullptr || numBytes <= 0, kInvalidArgument);
+
+        const int64 available = fSize - fPosition;
+        const int32 count = static_cast<int32>(std::max<int64>(0, std::min<int64>(numBytes, available)));
+
+        if (count > 0)
+        {
+            std::memcpy(buffer, fData + fPosition, static_cast<std::size_t>(count));
+            fPosition += count;
+        }
+
+        if (numBytesRead != nullptr)
+            *numBytesRead = count;
+
+        return count > 0 || numBytes <= 0 ? kResultOk : kResultFalse;
+    }
+
+    tresult PLUGIN_API write(void* const buffer, const int32 numBytes, int32* const numBytesWritten) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(! fReadOnly, kResultFalse);
+        CARLA_SAFE_ASSERT_RETURN(buffer != nullptr || numBytes <= 0, kInvalidArgument);
+
+        if (numBytesWritten != nullptr)
+            *numBytesWritten = 0;
+
+        if (numBytes <= 0)
+            return kResultOk;
+
+        const int64 needed = fPosition + numBytes;
+
+        if (needed > fAllocated)
+        {
+            const int64 newAllocated = std::max<int64>(needed, std::max<int64>(fAllocated * 2, 4096));
+            uint8_t* const newData = static_cast<uint8_t*>(std::realloc(fData, static_cast<std::size_t>(newAllocated)));
+            CARLA_SAFE_ASSERT_RETURN(newData != nullptr, kOutOfMemory);
+
+            fData      = newData;
+            fAllocated = newAllocated;
+        }
+
+        std::memcpy(fData + fPosition, buffer, static_cast<std::size_t>(numBytes));
+        fPosition += numBytes;
+
+        if (fPosition > fSize)
+            fSize = fPosition;
+
+        if (numBytesWritten != nullptr)
+            *numBytesWritten = numBytes;
+
+        return kResultOk;
+    }
+
+    tresult PLUGIN_API seek(const int64 pos, const int32 mode, int64* const result) override
+    {
+        int64 newPosition;
+
+        switch (mode)
+        {
+        case kIBSeekSet:
+            newPosition = pos;
+            break;
+        case kIBSeekCur:
+            newPosition = fPosition + pos;
+            break;
+        case kIBSeekEnd:
+            newPosition = fSize + pos;
+            break;
+        default:
+            return kInvalidArgument;
+        }
+
+        CARLA_SAFE_ASSERT_RETURN(newPosition >= 0 && newPosition <= fSize, kInvalidArgument);
+
+        fPosition = newPosition;
+
+        if (result != nullptr)
+            *result = fPosition;
+
+        return kResultOk;
+    }
+
+    tresult PLUGIN_API tell(int64* const pos) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(pos != nullptr, kInvalidArgument);
+
+        *pos = fPosition;
+        return kResultOk;
+    }
+
+private:
+    uint8_t* fData;
+    int64 fSize;
+    int64 fAllocated;
+    int64 fPosition;
+    const bool fReadOnly;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaVst3MemoryStream)
+};
+
+// -----------------------------------------------------
+// Event list with fixed capacity, kept sorted by sample offset
+
+class CarlaVst3EventList : public Vst::IEventList
+{
+public:
+    static const int32 kMaxEvents = kPluginMaxMidiEvents*2;
+
+    CarlaVst3EventList() noexcept
+        : fCount(0)
+    {
+        carla_zeroStructs(fEvents, kMaxEvents);
+    }
+
+    virtual ~CarlaVst3EventList() {}
+
+    void clear() noexcept
+    {
+        fCount = 0;
+    }
+
+    bool isFull() const noexcept
+    {
+        return fCount >= kMaxEvents;
+    }
+
+    tresult PLUGIN_API queryInterface(const TUID iid, void** const obj) override
+    {
+        if (FUnknownPrivate::iidEqual(iid, FUnknown_iid) || FUnknownPrivate::iidEqual(iid, Vst::IEventList_iid))
+        {
+            *obj = this;
+            return kResultOk;
+        }
+
+        *obj = nullptr;
+        return kNoInterface;
+    }
+
+    // owned by the plugin host
+    uint32 PLUGIN_API addRef() override { return 1; }
+    uint32 PLUGIN_API release() override { return 1; }
+
+    int32 PLUGIN_API getEventCount() override
+    {
+        return fCount;
+    }
+
+    tresult PLUGIN_API getEvent(const int32 index, Vst::Event& e) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(index >= 0 && index < fCount, kInvalidArgument);
+
+        e = fEvents[index];
+        return kResultOk;
+    }
+
+    tresult PLUGIN_API addEvent(Vst::Event& e) override
+    {
+        if (fCount >= kMaxEvents)
+            return kResultFalse;
+
+        // events mostly arrive in order, search for the insert position from the end
+        int32 pos = fCount;
+
+        for (; pos > 0 && fEvents[pos-1].sampleOffset > e.sampleOffset; --pos)
+            fEvents[pos] = fEvents[pos-1];
+
+        fEvents[pos] = e;
+        ++fCount;
+        return kResultOk;
+    }
+
+private:
+    int32 fCount;
+    Vst::Event fEvents[kMaxEvents];
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaVst3EventList)
+};
+
+// -----------------------------------------------------
+// Parameter changes for a single block, one queue per changed parameter
+
+class CarlaVst3ParamValueQueue : public Vst::IParamValueQueue
+{
+public:
+    static const int32 kMaxPoints = 32;
+
+    CarlaVst3ParamValueQueue() noexcept
+        : fId(0),
+          fHostIndex(-1),
+          fCount(0)
+    {
+        carla_zeroStructs(fPoints, kMaxPoints);
+    }
+
+    virtual ~CarlaVst3ParamValueQueue() {}
+
+    void reset(const Vst::ParamID id, const int32_t hostIndex) noexcept
+    {
+        fId = id;
+        fHostIndex = hostIndex;
+        fCount = 0;
+    }
+
+    int32_t getHostIndex() const noexcept
+    {
+        return fHostIndex;
+    }
+
+    bool getLastValue(Vst::ParamValue& value) const noexcept
+    {
+        if (fCount == 0)
+            return false;
+
+        value = fPoints[fCount-1].value;
+        return true;
+    }
+
+    tresult PLUGIN_API queryInterface(const TUID iid, void** const obj) override
+    {
+        if (FUnknownPrivate::iidEqual(iid, FUnknown_iid) || FUnknownPrivate::iidEqual(iid, Vst::IParamValueQueue_iid))
+        {
+            *obj = this;
+            return kResultOk;
+        }
+
+        *obj = nullptr;
+        return kNoInterface;
+    }
+
+    // owned by the parameter changes
+    uint32 PLUGIN_API addRef() override { return 1; }
+    uint32 PLUGIN_API release() override { return 1; }
+
+    Vst::ParamID PLUGIN_API getParameterId() override
+    {
+        return fId;
+    }
+
+    int32 PLUGIN_API getPointCount() override
+    {
+        return fCount;
+    }
+
+    tresult PLUGIN_API getPoint(const int32 index, int32& sampleOffset, Vst::ParamValue& value) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(index >= 0 && index < fCount, kInvalidArgument);
+
+        sampleOffset = fPoints[index].offset;
+        value        = fPoints[index].value;
+        return kResultOk;
+    }
+
+    tresult PLUGIN_API addPoint(const int32 sampleOffset, const Vst::ParamValue value, int32& index) override
+    {
+        int32 pos = fCount;
+
+        // keep points sorted, a later value at the same offset replaces the previous one
+        for (; pos > 0 && fPoints[pos-1].offset >= sampleOffset; --pos)
+        {
+            if (fPoints[pos-1].offset == sampleOffset)
+            {
+                fPoints[pos-1].value = value;
+                index = pos-1;
+                return kResultOk;
+            }
+        }
+
+        if (fCount >= kMaxPoints)
+        {
+            // out of room, the last point wins
+            fPoints[fCount-1].offset = sampleOffset;
+            fPoints[fCount-1].value  = value;
+            index = fCount-1;
+            return kResultOk;
+        }
+
+        for (int32 i = fCount; i > pos; --i)
+            fPoints[i] = fPoints[i-1];
+
+        fPoints[pos].offset = sampleOffset;
+        fPoints[pos].value  = value;
+        index = pos;
+        ++fCount;
+        return kResultOk;
+    }
+
+private:
+    struct Point {
+        int32 offset;
+        Vst::ParamValue value;
+    };
+
+    Vst::ParamID fId;
+    int32_t fHostIndex;
+    int32 fCount;
+    Point fPoints[kMaxPoints];
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaVst3ParamValueQueue)
+};
+
+class CarlaVst3ParameterChanges : public Vst::IParameterChanges
+{
+public:
+    static const uint32_t kMaxQueues = 512;
+
+    CarlaVst3ParameterChanges() noexcept
+        : fQueues(nullptr),
+          fQueueCount(0),
+          fUsedCount(0),
+          fHostQueueIndexes(nullptr),
+          fHostCount(0) {}
+
+    virtual ~CarlaVst3ParameterChanges()
+    {
+        init(0);
+    }
+
+    void init(const uint32_t hostCount)
+    {
+        delete[] fQueues;
+        delete[] fHostQueueIndexes;
+
+        fQueues = nullptr;
+        fQueueCount = 0;
+        fUsedCount = 0;
+        fHostQueueIndexes = nullptr;
+        fHostCount = 0;
+
+        if (hostCount == 0)
+            return;
+
+        fQueueCount = std::min(hostCount, kMaxQueues);
+        fQueues = new CarlaVst3ParamValueQueue[fQueueCount];
+
+        fHostCount = hostCount;
+        fHostQueueIndexes = new int32_t[hostCount];
+
+        for (uint32_t i=0; i < hostCount; ++i)
+            fHostQueueIndexes[i] = -1;
+    }
+
+    // only reset what was used during the previous cycle
+    void clear() noexcept
+    {
+        for (uint32_t i=0; i < fUsedCount; ++i)
+        {
+            const int32_t hostIndex = fQueues[i].getHostIndex();
+
+            if (hostIndex >= 0)
+                fHostQueueIndexes[hostIndex] = -1;
+        }
+
+        fUsedCount = 0;
+    }
+
+    bool addHostPoint(const uint32_t hostIndex, const Vst::ParamID id, const uint32_t offset, const Vst::ParamValue value) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(hostIndex < fHostCount, false);
+
+        int32_t queueIndex = fHostQueueIndexes[hostIndex];
+
+        if (queueIndex < 0)
+        {
+            if (fUsedCount >= fQueueCount)
+                return false;
+
+            queueIndex = static_cast<int32_t>(fUsedCount++);
+            fQueues[queueIndex].reset(id, static_cast<int32_t>(hostIndex));
+            fHostQueueIndexes[hostIndex] = queueIndex;
+        }
+
+        int32 pointIndex;
+        return fQueues[queueIndex].addPoint(static_cast<int32>(offset), value, pointIndex) == kResultOk;
+    }
+
+    CarlaVst3ParamValueQueue& getQueue(const uint32_t index) noexcept
+    {
+        return fQueues[index];
+    }
+
+    uint32_t getUsedCount() const noexcept
+    {
+        return fUsedCount;
+    }
+
+    tresult PLUGIN_API queryInterface(const TUID iid, void** const obj) override
+    {
+        if (FUnknownPrivate::iidEqual(iid, FUnknown_iid) || FUnknownPrivate::iidEqual(iid, Vst::IParameterChanges_iid))
+        {
+            *obj = this;
+            return kResultOk;
+        }
+
+        *obj = nullptr;
+        return kNoInterface;
+    }
+
+    // owned by the plugin host
+    uint32 PLUGIN_API addRef() override { return 1; }
+    uint32 PLUGIN_API release() override { return 1; }
+
+    int32 PLUGIN_API getParameterCount() override
+    {
+        return static_cast<int32>(fUsedCount);
+    }
+
+    Vst::IParamValueQueue* PLUGIN_API getParameterData(const int32 index) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(index >= 0 && static_cast<uint32_t>(index) < fUsedCount, nullptr);
+
+        return &fQueues[index];
+    }
+
+    Vst::IParamValueQueue* PLUGIN_API addParameterData(const Vst::ParamID& id, int32& index) override
+    {
+        for (uint32_t i=0; i < fUsedCount; ++i)
+        {
+            if (fQueues[i].getParameterId() == id)
+            {
+                index = static_cast<int32>(i);
+                return &fQueues[i];
+            }
+        }
+
+        if (fUsedCount >= fQueueCount)
+            return nullptr;
+
+        index = static_cast<int32>(fUsedCount);
+        fQueues[fUsedCount].reset(id, -1);
+        return &fQueues[fUsedCount++];
+    }
+
+private:
+    CarlaVst3ParamValueQueue* fQueues;
+    uint32_t fQueueCount;
+    uint32_t fUsedCount;
+
+    // queue used by each host parameter in the current cycle, -1 if none
+    int32_t* fHostQueueIndexes;
+    uint32_t fHostCount;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaVst3ParameterChanges)
+};
+
+// -----------------------------------------------------
+
+class CarlaPluginVST3 : public CarlaPlugin
+{
+public:
+    CarlaPluginVST3(CarlaEngine* const engine, const uint id)
+        : CarlaPlugin(engine, id),
+          fModuleExit(nullptr),
+#ifdef CARLA_OS_MAC
+          fMacBundleRef(nullptr),
+#endif
+          fFactory(nullptr),
+          fComponent(nullptr),
+          fProcessor(nullptr),
+          fController(nullptr),
+          fControllerIsComponent(false),
+          fComponentConnection(nullptr),
+          fControllerConnection(nullptr),
+          fMidiMapping(nullptr),
+          fUnitInfo(nullptr),
+          fComponentHandler(this),
+          fUniqueId(0),
+          fLabel(),
+          fMaker(),
+          fSubCategories(),
+          fAudioInBuses(),
+          fAudioOutBuses(),
+          fParams(nullptr),
+          fParamOrder(nullptr),
+          fParamCount(0),
+          fParamsPendingForProcessor(false),
+          fParamsPendingForController(false),
+          fProgramParamIndex(-1),
+          fProgramListId(Vst::kNoProgramListId),
+          fRestartFlags(0),
+          fProcessContext(),
+          fProcessData(),
+          fEventsIn(),
+          fEventsOut(),
+          fParamChangesIn(),
+          fParamChangesOut(),
+          fBufferSize(engine->getBufferSize()),
+          fAudioOutBuffers(nullptr),
+          fAudioBufferArena(),
+          fChunk()
+    {
+        carla_debug("CarlaPluginVST3::CarlaPluginVST3(%p, %i)", engine, id);
+
+        carla_zeroStruct(fProcessContext);
+
+        for (uint8_t c=0; c < MAX_MIDI_CHANNELS; ++c)
+            for (int32 i=0; i < Vst::kCountCtrlNumber; ++i)
+                fMidiCCMap[c][i] = -1;
+
+        pData->prog.supportsRT = true;
+    }
+
+    ~CarlaPluginVST3() override
+    {
+        carla_debug("CarlaPluginVST3::~CarlaPluginVST3()");
+
+        pData->singleMutex.lock();
+        pData->masterMutex.lock();
+
+        if (pData->client != nullptr && pData->client->isActive())
+            pData->client->deactivate(true);
+
+        if (pData->active)
+        {
+            deactivate();
+            pData->active = false;
+        }
+
+        clearBuffers();
+
+        if (fComponentConnection != nullptr && fControllerConnection != nullptr)
+        {
+            fComponentConnection->disconnect(fControllerConnection);
+            fControllerConnection->disconnect(fComponentConnection);
+        }
+
+        if (fComponentConnection != nullptr)
+        {
+            fComponentConnection->release();
+            fComponentConnection = nullptr;
+        }
+
+        if (fControllerConnection != nullptr)
+        {
+            fControllerConnection->release();
+            fControllerConnection = nullptr;
+        }
+
+        if (fMidiMapping != nullptr)
+        {
+            fMidiMapping->release();
+            fMidiMapping = nullptr;
+        }
+
+        if (fUnitInfo != nullptr)
+        {
+            fUnitInfo->release();
+            fUnitInfo = nullptr;
+        }
+
+        if (fController != nullptr)
+        {
+            fController->setComponentHandler(nullptr);
+
+            if (! fControllerIsComponent)
+                fController->terminate();
+
+            fController->release();
+            fController = nullptr;
+        }
+
+        if (fProcessor != nullptr)
+        {
+            fProcessor->release();
+            fProcessor = nullptr;
+        }
+
+        if (fComponent != nullptr)
+        {
+            fComponent->terminate();
+            fComponent->release();
+            fComponent = nullptr;
+        }
+
+        if (fFactory != nullptr)
+        {
+            fFactory->release();
+            fFactory = nullptr;
+        }
+
+        if (fModuleExit != nullptr)
+        {
+            fModuleExit();
+            fModuleExit = nullptr;
+        }
+
+#ifdef CARLA_OS_MAC
+        if (fMacBundleRef != nullptr)
+        {
+            CFBundleUnloadExecutable(fMacBundleRef);
+            CFRelease(fMacBundleRef);
+            fMacBundleRef = nullptr;
+        }
+#endif
+
+        delete[] fParams;
+        delete[] fParamOrder;
+    }
+
+    // -------------------------------------------------------------------
+    // Information (base)
+
+    PluginType getType() const noexcept override
+    {
+        return PLUGIN_VST3;
+    }
+
+    PluginCategory getCategory() const noexcept override
+    {
+        if (fSubCategories.contains("Instrument"))
+            return PLUGIN_CATEGORY_SYNTH;
+
+        if (fSubCategories.isNotEmpty())
+        {
+            const PluginCategory category = getPluginCategoryFromName(fSubCategories);
+
+            if (category != PLUGIN_CATEGORY_NONE)
+                return category;
+        }
+
+        return CarlaPlugin::getCategory();
+    }
+
+    int64_t getUniqueId() const noexcept override
+    {
+        return fUniqueId;
+    }
+
+    // -------------------------------------------------------------------
+    // Information (count)
+
+    // nothing
+
+    // -------------------------------------------------------------------
+    // Information (current data)
+
+    std::size_t getChunkData(void** const dataPtr) noexcept override
+    {
+        CARLA_SAFE_ASSERT_RETURN(pData->options & PLUGIN_OPTION_USE_CHUNKS, 0);
+        CARLA_SAFE_ASSERT_RETURN(fComponent != nullptr, 0);
+        CARLA_SAFE_ASSERT_RETURN(dataPtr != nullptr, 0);
+
+        *dataPtr = nullptr;
+
+        try {
+            CarlaVst3MemoryStream componentStream, controllerStream;
+
+            if (fComponent->getState(&componentStream) != kResultOk)
+                return 0;
+
+            std::string xml("<?xml version=\"1.0\" encoding=\"UTF-8\"?> <VST3PluginState><IComponent>");
+            encodeJuceBase64(xml, componentStream.getData(), componentStream.getSize());
+            xml += "</IComponent>";
+
+            if (fController->getState(&controllerStream) == kResultOk)
+            {
+                xml += "<IEditController>";
+                encodeJuceBase64(xml, controllerStream.getData(), controllerStream.getSize());
+                xml += "</IEditController>";
+            }
+
+            xml += "</VST3PluginState>";
+
+            const uint32_t header[2] = {
+                ByteOrder::swapIfBigEndian(kJuceStateMagic),
+                ByteOrder::swapIfBigEndian(static_cast<uint32_t>(xml.size()))
+            };
+
+            fChunk.setSize(0);
+            fChunk.append(header, sizeof(header));
+            fChunk.append(xml.c_str(), xml.size() + 1);
+
+            *dataPtr = fChunk.getData();
+            return fChunk.getSize();
+        } CARLA_SAFE_EXCEPTION_RETURN("CarlaPluginVST3::getChunkData", 0);
+    }
+
+    // -------------------------------------------------------------------
+    // Information (per-plugin data)
+
+    uint getOptionsAvailable() const noexcept override
+    {
+        CARLA_SAFE_ASSERT_RETURN(fComponent != nullptr, 0);
+
+        uint options = 0x0;
+
+        if (fProgramParamIndex >= 0)
+            options |= PLUGIN_OPTION_MAP_PROGRAM_CHANGES;
+
+        if (pData->extraHints & PLUGIN_EXTRA_HINT_HAS_MIDI_IN)
+        {
+            options |= PLUGIN_OPTION_SEND_CONTROL_CHANGES;
+            options |= PLUGIN_OPTION_SEND_CHANNEL_PRESSURE;
+            options |= PLUGIN_OPTION_SEND_NOTE_AFTERTOUCH;
+            options |= PLUGIN_OPTION_SEND_PITCHBEND;
+            options |= PLUGIN_OPTION_SEND_ALL_SOUND_OFF;
+            options |= PLUGIN_OPTION_SKIP_SENDING_NOTES;
+        }
+
+        // only effects can sleep, and CV inputs are not checked for silence
+        if (pData->audioIn.count != 0 && pData->cvIn.count == 0)
+            options |= PLUGIN_OPTION_AUTO_SLEEP;
+
+        return options;
+    }
+
+    float getParameterValue(const uint32_t parameterId) const noexcept override
+    {
+        CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count, 0.0f);
+
+        const uint32_t index = static_cast<uint32_t>(pData->param.data[parameterId].rindex);
+        CARLA_SAFE_ASSERT_RETURN(index < fParamCount, 0.0f);
+
+        return normalizedToCarla(index, fParams[index].value);
+    }
+
+    bool getLabel(char* const strBuf) const noexcept override
+    {
+        std::strncpy(strBuf, fLabel, STR_MAX);
+        return true;
+    }
+
+    bool getMaker(char* const strBuf) const noexcept override
+    {
+        std::strncpy(strBuf, fMaker, STR_MAX);
+        return true;
+    }
+
+    bool getCopyright(char* const strBuf) const noexcept override
+    {
+        return getMaker(strBuf);
+    }
+
+    bool getRealName(char* const strBuf) const noexcept override
+    {
+        return getLabel(strBuf);
+    }
+
+    bool getParameterName(const uint32_t parameterId, char* const strBuf) const noexcept override
+    {
+        CARLA_SAFE_ASSERT_RETURN(fController != nullptr, false);
+        CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count, false);
+
+        Vst::ParameterInfo info;
+        carla_zeroStruct(info);
+
+        strBuf[0] = '\0';
+
+        try {
+            if (fController->getParameterInfo(pData->param.data[parameterId].rindex, info) != kResultOk)
+                return false;
+        } CARLA_SAFE_EXCEPTION_RETURN("getParameterInfo", false);
+
+        vst3StringToUtf8(strBuf, info.title, STR_MAX);
+        return true;
+    }
+
+    bool getParameterText(const uint32_t parameterId, char* const strBuf) noexcept override
+    {
+        CARLA_SAFE_ASSERT_RETURN(fController != nullptr, false);
+        CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count, false);
+
+        const uint32_t index = static_cast<uint32_t>(pData->param.data[parameterId].rindex);
+        CARLA_SAFE_ASSERT_RETURN(index < fParamCount, false);
+
+        Vst::String128 text;
+        carla_zeroStructs(text, 128);
+
+        strBuf[0] = '\0';
+
+        try {
+            if (fController->getParamStringByValue(fParams[index].id, fParams[index].value, text) == kResultOk)
+                vst3StringToUtf8(strBuf, text, STR_MAX);
+        } CARLA_SAFE_EXCEPTION("getParamStringByValue");
+
+        if (strBuf[0] == '\0')
+            std::snprintf(strBuf, STR_MAX, "%s", CarlaFloatString(getParameterValue(parameterId)).buffer);
+
+        return true;
+    }
+
+    bool getParameterUnit(const uint32_t parameterId, char* const strBuf) const noexcept override
+    {
+        CARLA_SAFE_ASSERT_RETURN(fController != nullptr, false);
+        CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count, false);
+
+        Vst::ParameterInfo info;
+        carla_zeroStruct(info);
+
+        strBuf[0] = '\0';
+
+        try {
+            if (fController->getParameterInfo(pData->param.data[parameterId].rindex, info) != kResultOk)
+                return false;
+        } CARLA_SAFE_EXCEPTION_RETURN("getParameterInfo", false);
+
+        vst3StringToUtf8(strBuf, info.units, STR_MAX);
+        return true;
+    }
+
+    // -------------------------------------------------------------------
+    // Set data (state)
+
+    // nothing
+
+    // -------------------------------------------------------------------
+    // Set data (internal stuff)
+
+    // nothing
+
+    // -------------------------------------------------------------------
+    // Set data (plugin-specific stuff)
+
+    void setParameterValue(const uint32_t parameterId, const float value, const bool sendGui, const bool sendOsc, const bool sendCallback) noexcept override
+    {
+        CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count,);
+
+        const uint32_t index = static_cast<uint32_t>(pData->param.data[parameterId].rindex);
+        CARLA_SAFE_ASSERT_RETURN(index < fParamCount,);
+
+        const float fixedValue(pData->param.getFixedValue(parameterId, value));
+
+        // the processor and controller are given the new value on their own threads
+        fParams[index].value = carlaToNormalized(index, fixedValue);
+        fParams[index].pendingForProcessor = true;
+        fParams[index].pendingForController = true;
+        fParamsPendingForProcessor = true;
+        fParamsPendingForController = true;
+
+        CarlaPlugin::setParameterValue(parameterId, fixedValue, sendGui, sendOsc, sendCallback);
+    }
+
+    void setParameterValueRT(const uint32_t parameterId, const float value, const bool sendCallbackLater) noexcept override
+    {
+        setParameterValueRT(parameterId, value, 0, sendCallbackLater);
+    }
+
+    void setChunkData(const void* const data, const std::size_t dataSize) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(pData->options & PLUGIN_OPTION_USE_CHUNKS,);
+        CARLA_SAFE_ASSERT_RETURN(fComponent != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(dataSize > 0,);
+
+        MemoryBlock componentState, controllerState;
+
+        if (! loadJuceSaveFormat(data, dataSize, componentState, controllerState))
+        {
+            // not something we saved, try it as raw component state
+            componentState.replaceWith(data, dataSize);
+        }
+
+        {
+            const ScopedSingleProcessLocker spl(this, true);
+
+            if (componentState.getSize() > 0)
+            {
+                CarlaVst3MemoryStream stream(componentState.getData(), componentState.getSize());
+
+                try {
+                    fComponent->setState(&stream);
+                } CARLA_SAFE_EXCEPTION("IComponent::setState");
+
+                stream.seek(0, IBStream::kIBSeekSet, nullptr);
+
+                try {
+                    fController->setComponentState(&stream);
+                } CARLA_SAFE_EXCEPTION("IEditController::setComponentState");
+            }
+
+            if (controllerState.getSize() > 0)
+            {
+                CarlaVst3MemoryStream stream(controllerState.getData(), controllerState.getSize());
+
+                try {
+                    fController->setState(&stream);
+                } CARLA_SAFE_EXCEPTION("IEditController::setState");
+            }
+        }
+
+        refreshParameterValuesFromController();
+        pData->updateParameterValues(this, true, true, false);
+    }
+
+    void setProgram(const int32_t index, const bool sendGui, const bool sendOsc, const bool sendCallback, const bool doingInit) noexcept override
+    {
+        CARLA_SAFE_ASSERT_RETURN(fController != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(index >= -1 && index < static_cast<int32_t>(pData->prog.count),);
+        CARLA_SAFE_ASSERT_RETURN(sendGui || sendOsc || sendCallback || doingInit,);
+
+        if (index >= 0 && fProgramParamIndex >= 0)
+        {
+            Param& param(fParams[fProgramParamIndex]);
+
+            param.value = programToNormalized(static_cast<uint32_t>(index));
+            param.pendingForProcessor = true;
+            fParamsPendingForProcessor = true;
+
+            // the controller updates its other parameters to match the program
+            try {
+                fController->setParamNormalized(param.id, param.value);
+            } CARLA_SAFE_EXCEPTION("setParamNormalized");
+
+            refreshParameterValuesFromController();
+        }
+
+        CarlaPlugin::setProgram(index, sendGui, sendOsc, sendCallback, doingInit);
+    }
+
+    void setProgramRT(const uint32_t uindex, const bool sendCallbackLater) noexcept override
+    {
+        CARLA_SAFE_ASSERT_RETURN(uindex < pData->prog.count,);
+        CARLA_SAFE_ASSERT_RETURN(fProgramParamIndex >= 0,);
+
+        const uint32_t index = static_cast<uint32_t>(fProgramParamIndex);
+        Param& param(fParams[index]);
+
+        param.value = programToNormalized(uindex);
+        param.pendingForController = true;
+        fParamsPendingForController = true;
+
+        fParamChangesIn.addHostPoint(index, param.id, 0, param.value);
+
+        CarlaPlugin::setProgramRT(uindex, sendCallbackLater);
+    }
+
+    // -------------------------------------------------------------------
+    // Set ui stuff
+
+    void idle() override
+    {
+        if (fParamsPendingForController)
+        {
+            fParamsPendingForController = false;
+
+            for (uint32_t i=0; i < fParamCount; ++i)
+            {
+                if (! fParams[i].pendingForController)
+                    continue;
+
+                fParams[i].pendingForController = false;
+
+                try {
+                    fController->setParamNormalized(fParams[i].id, fParams[i].value);
+                } CARLA_SAFE_EXCEPTION("setParamNormalized");
+            }
+        }
+
+        if (const int32 flags = __sync_fetch_and_and(&fRestartFlags, 0))
+            handleRestartRequest(flags);
+
+        CarlaPlugin::idle();
+    }
+
+    // -------------------------------------------------------------------
+    // Plugin state
+
+    void reload() override
+    {
+        CARLA_SAFE_ASSERT_RETURN(pData->engine != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(fComponent != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(fController != nullptr,);
+        carla_debug("CarlaPluginVST3::reload() - start");
+
+        const EngineProcessMode processMode(pData->engine->getProccessMode());
+
+        // Safely disable plugin for reload
+        const ScopedDisabler sd(this);
+
+        if (pData->active)
+            deactivate();
+
+        clearBuffers();
+
+        uint32_t aIns, aOuts, mIns, mOuts, params;
+
+        bool needsCtrlIn, needsCtrlOut;
+        needsCtrlIn = needsCtrlOut = false;
+
+        aIns  = fAudioInBuses.create(fComponent, Vst::kInput);
+        aOuts = fAudioOutBuses.create(fComponent, Vst::kOutput);
+
+        if (fComponent->getBusCount(Vst::kEvent, Vst::kInput) > 0)
+        {
+            fComponent->activateBus(Vst::kEvent, Vst::kInput, 0, true);
+            mIns = 1;
+            needsCtrlIn = true;
+        }
+        else
+            mIns = 0;
+
+        if (fComponent->getBusCount(Vst::kEvent, Vst::kOutput) > 0)
+        {
+            fComponent->activateBus(Vst::kEvent, Vst::kOutput, 0, true);
+            mOuts = 1;
+            needsCtrlOut = true;
+        }
+        else
+            mOuts = 0;
+
+        if (aIns > 0)
+        {
+            pData->audioIn.createNew(aIns);
+        }
+
+        if (aOuts > 0)
+        {
+            pData->audioOut.createNew(aOuts);
+            fAudioOutBuffers = new float*[aOuts];
+            needsCtrlIn = true;
+
+            for (uint32_t i=0; i < aOuts; ++i)
+                fAudioOutBuffers[i] = nullptr;
+        }
+
+        const uint portNameSize(pData->engine->getMaxPortNameSize());
+        CarlaString portName;
+
+        // Audio Ins
+        for (uint32_t j=0; j < aIns; ++j)
+        {
+            portName.clear();
+
+            if (processMode == ENGINE_PROCESS_MODE_SINGLE_CLIENT)
+            {
+                portName  = pData->name;
+                portName += ":";
+            }
+
+            if (aIns > 1)
+            {
+                portName += "input_";
+                portName += CarlaString(j+1);
+            }
+            else
+                portName += "input";
+
+            portName.truncate(portNameSize);
+
+            pData->audioIn.ports[j].port   = (CarlaEngineAudioPort*)pData->client->addPort(kEnginePortTypeAudio, portName, true, j);
+            pData->audioIn.ports[j].rindex = j;
+        }
+
+        // Audio Outs
+        for (uint32_t j=0; j < aOuts; ++j)
+        {
+            portName.clear();
+
+            if (processMode == ENGINE_PROCESS_MODE_SINGLE_CLIENT)
+            {
+                portName  = pData->name;
+                portName += ":";
+            }
+
+            if (aOuts > 1)
+            {
+                portName += "output_";
+                portName += CarlaString(j+1);
+            }
+            else
+                portName += "output";
+
+            portName.truncate(portNameSize);
+
+            pData->audioOut.ports[j].port   = (CarlaEngineAudioPort*)pData->client->addPort(kEnginePortTypeAudio, portName, false, j);
+            pData->audioOut.ports[j].rindex = j;
+        }
+
+        // Parameters, hiding the program change parameter and the ones only used for MIDI CC mapping
+        params = reloadParameters();
+
+        if (params > 0)
+        {
+            pData->param.createNew(params, false);
+            needsCtrlIn = true;
+        }
+
+        for (uint32_t i=0, j=0; i < fParamCount; ++i)
+        {
+            if (fParams[i].carlaIndex < 0)
+                continue;
+
+            const Param& param(fParams[i]);
+
+            pData->param.data[j].type   = (param.flags & Vst::ParameterInfo::kIsReadOnly) ? PARAMETER_OUTPUT : PARAMETER_INPUT;
+            pData->param.data[j].index  = static_cast<int32_t>(j);
+            pData->param.data[j].rindex = static_cast<int32_t>(i);
+
+            float min, max, def, step, stepSmall, stepLarge;
+
+            min = 0.0f;
+
+            if (param.stepCount == 1)
+            {
+                max = 1.0f;
+                step = stepSmall = stepLarge = 1.0f;
+                pData->param.data[j].hints |= PARAMETER_IS_BOOLEAN;
+            }
+            else if (param.stepCount > 1)
+            {
+                max = static_cast<float>(param.stepCount);
+                step = stepSmall = 1.0f;
+                stepLarge = std::min(10.0f, max);
+                pData->param.data[j].hints |= PARAMETER_IS_INTEGER;
+            }
+            else
+            {
+                max = 1.0f;
+                step = 0.01f;
+                stepSmall = 0.001f;
+                stepLarge = 0.1f;
+            }
+
+            pData->param.data[j].hints |= PARAMETER_IS_ENABLED;
+            pData->param.data[j].hints |= PARAMETER_USES_CUSTOM_TEXT;
+
+            if (param.flags & Vst::ParameterInfo::kCanAutomate)
+            {
+                pData->param.data[j].hints |= PARAMETER_IS_AUTOMABLE;
+
+                if (param.stepCount == 0)
+                    pData->param.data[j].hints |= PARAMETER_CAN_BE_CV_CONTROLLED;
+            }
+
+            def = normalizedToCarla(i, param.defaultValue);
+
+            if (def < min)
+                def = min;
+            else if (def > max)
+                def = max;
+
+            pData->param.ranges[j].min = min;
+            pData->param.ranges[j].max = max;
+            pData->param.ranges[j].def = def;
+            pData->param.ranges[j].step = step;
+            pData->param.ranges[j].stepSmall = stepSmall;
+            pData->param.ranges[j].stepLarge = stepLarge;
+
+            ++j;
+        }
+
+        if (needsCtrlIn)
+        {
+            portName.clear();
+
+            if (processMode == ENGINE_PROCESS_MODE_SINGLE_CLIENT)
+            {
+                portName  = pData->name;
+                portName += ":";
+            }
+
+            portName += "events-in";
+            portName.truncate(portNameSize);
+
+            pData->event.portIn = (CarlaEngineEventPort*)pData->client->addPort(kEnginePortTypeEvent, portName, true, 0);
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+            pData->event.cvSourcePorts = pData->client->createCVSourcePorts();
+#endif
+        }
+
+        if (needsCtrlOut)
+        {
+            portName.clear();
+
+            if (processMode == ENGINE_PROCESS_MODE_SINGLE_CLIENT)
+            {
+                portName  = pData->name;
+                portName += ":";
+            }
+
+            portName += "events-out";
+            portName.truncate(portNameSize);
+
+            pData->event.portOut = (CarlaEngineEventPort*)pData->client->addPort(kEnginePortTypeEvent, portName, false, 0);
+        }
+
+        // processing data, pointers stay valid until the next reload
+        fEventsIn.clear();
+        fEventsOut.clear();
+        fParamChangesIn.init(fParamCount);
+        fParamChangesOut.init(fParamCount);
+
+        fProcessData.symbolicSampleSize     = Vst::kSample32;
+        fProcessData.numInputs              = fAudioInBuses.busCount;
+        fProcessData.numOutputs             = fAudioOutBuses.busCount;
+        fProcessData.inputs                 = fAudioInBuses.buses;
+        fProcessData.outputs                = fAudioOutBuses.buses;
+        fProcessData.inputParameterChanges  = &fParamChangesIn;
+        fProcessData.outputParameterChanges = &fParamChangesOut;
+        fProcessData.inputEvents            = (mIns > 0)  ? &fEventsIn  : nullptr;
+        fProcessData.outputEvents           = (mOuts > 0) ? &fEventsOut : nullptr;
+        fProcessData.processContext         = &fProcessContext;
+
+        // plugin hints
+        pData->hints = 0x0;
+
+        if (fSubCategories.contains("Instrument"))
+            pData->hints |= PLUGIN_IS_SYNTH;
+
+        if (aOuts > 0 && (aIns == aOuts || aIns == 1))
+            pData->hints |= PLUGIN_CAN_DRYWET;
+
+        if (aOuts > 0)
+            pData->hints |= PLUGIN_CAN_VOLUME;
+
+        if (aOuts >= 2 && aOuts % 2 == 0)
+            pData->hints |= PLUGIN_CAN_BALANCE;
+
+        // extra plugin hints
+        pData->extraHints = 0x0;
+
+        if (mIns > 0)
+            pData->extraHints |= PLUGIN_EXTRA_HINT_HAS_MIDI_IN;
+
+        if (mOuts > 0)
+            pData->extraHints |= PLUGIN_EXTRA_HINT_HAS_MIDI_OUT;
+
+        // latency is only known after setupProcessing
+        uint32_t latency;
+        {
+            activate();
+            latency = fProcessor->getLatencySamples();
+            deactivate();
+        }
+
+        if (latency != 0)
+        {
+            pData->client->setLatency(latency);
+#ifndef BUILD_BRIDGE
+            pData->latency.recreateBuffers(std::max(aIns, aOuts), latency);
+#endif
+        }
+
+        bufferSizeChanged(getBufferSize());
+        reloadPrograms(true);
+
+        if (pData->active)
+            activate();
+
+        carla_debug("CarlaPluginVST3::reload() - end");
+    }
+
+    void reloadPrograms(const bool doInit) override
+    {
+        carla_debug("CarlaPluginVST3::reloadPrograms(%s)", bool2str(doInit));
+        const uint32_t oldCount = pData->prog.count;
+        const int32_t  current  = pData->prog.current;
+
+        // Delete old programs
+        pData->prog.clear();
+
+        // Query new programs
+        const uint32_t newCount = (fProgramParamIndex >= 0) ? static_cast<uint32_t>(fParams[fProgramParamIndex].stepCount + 1) : 0;
+
+        if (newCount > 0)
+        {
+            pData->prog.createNew(newCount);
+
+            const Param& param(fParams[fProgramParamIndex]);
+
+            // Update names
+            for (uint32_t i=0; i < newCount; ++i)
+            {
+                char strBuf[STR_MAX+1] = { '\0' };
+                Vst::String128 name;
+                carla_zeroStructs(name, 128);
+
+                try {
+                    if (fUnitInfo != nullptr && fProgramListId != Vst::kNoProgramListId &&
+                        fUnitInfo->getProgramName(fProgramListId, static_cast<int32>(i), name) == kResultOk)
+                    {
+                        vst3StringToUtf8(strBuf, name, STR_MAX);
+                    }
+                    else if (fController->getParamStringByValue(param.id, programToNormalized(i), name) == kResultOk)
+                    {
+                        vst3StringToUtf8(strBuf, name, STR_MAX);
+                    }
+                } CARLA_SAFE_EXCEPTION("program name");
+
+                pData->prog.names[i] = carla_strdup(strBuf);
+            }
+        }
+
+        if (doInit)
+        {
+            if (newCount > 0)
+                setProgram(0, false, false, false, true);
+        }
+        else
+        {
+            // Check if current program is invalid
+            bool programChanged = false;
+
+            if (newCount == oldCount+1)
+            {
+                // one program added, probably created by user
+                pData->prog.current = static_cast<int32_t>(oldCount);
+                programChanged = true;
+            }
+            else if (current < 0 && newCount > 0)
+            {
+                // programs exist now, but not before
+                pData->prog.current = 0;
+                programChanged = true;
+            }
+            else if (current >= 0 && newCount == 0)
+            {
+                // programs existed before, but not anymore
+                pData->prog.current = -1;
+                programChanged = true;
+            }
+            else if (current >= static_cast<int32_t>(newCount))
+            {
+                // current program > count
+                pData->prog.current = 0;
+                programChanged = true;
+            }
+            else
+            {
+                // no change
+                pData->prog.current = current;
+            }
+
+            if (programChanged)
+                setProgram(pData->prog.current, true, true, true, false);
+
+            pData->engine->callback(true, true, ENGINE_CALLBACK_RELOAD_PROGRAMS, pData->id, 0, 0, 0, 0.0f, nullptr);
+        }
+    }
+
+    // -------------------------------------------------------------------
+    // Plugin processing
+
+    void activate() noexcept override
+    {
+        CARLA_SAFE_ASSERT_RETURN(fComponent != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(fProcessor != nullptr,);
+
+        Vst::ProcessSetup setup;
+        setup.processMode        = pData->engine->isOffline() ? Vst::kOffline : Vst::kRealtime;
+        setup.symbolicSampleSize = Vst::kSample32;
+        setup.maxSamplesPerBlock = static_cast<int32>(fBufferSize);
+        setup.sampleRate         = pData->engine->getSampleRate();
+
+        fProcessData.processMode = setup.processMode;
+
+        try {
+            fProcessor->setupProcessing(setup);
+        } CARLA_SAFE_EXCEPTION("setupProcessing");
+
+        try {
+            fComponent->setActive(true);
+        } CARLA_SAFE_EXCEPTION("setActive on");
+
+        try {
+            fProcessor->setProcessing(true);
+        } CARLA_SAFE_EXCEPTION("setProcessing on");
+    }
+
+    void deactivate() noexcept override
+    {
+        CARLA_SAFE_ASSERT_RETURN(fComponent != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(fProcessor != nullptr,);
+
+        try {
+            fProcessor->setProcessing(false);
+        } CARLA_SAFE_EXCEPTION("setProcessing off");
+
+        try {
+            fComponent->setActive(false);
+        } CARLA_SAFE_EXCEPTION("setActive off");
+    }
+
+    void process(const float* const* const audioIn,
+                 float** const audioOut,
+                 const float* const* const cvIn,
+                 float** const,
+                 const uint32_t frames) override
+    {
+        // --------------------------------------------------------------------------------------------------------
+        // Check if active
+
+        if (! pData->active)
+        {
+            // disable any output sound
+            for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                carla_zeroFloats(audioOut[i], frames);
+            return;
+        }
+
+        fEventsIn.clear();
+        fEventsOut.clear();
+        fParamChangesIn.clear();
+        fParamChangesOut.clear();
+
+        // --------------------------------------------------------------------------------------------------------
+        // Check if needs reset
+
+        if (pData->needsReset)
+        {
+            if (pData->options & PLUGIN_OPTION_SEND_ALL_SOUND_OFF)
+            {
+                for (uint8_t i=0; i < MAX_MIDI_CHANNELS; ++i)
+                {
+                    addMidiControllerRT(0, i, MIDI_CONTROL_ALL_NOTES_OFF, 0.0);
+                    addMidiControllerRT(0, i, MIDI_CONTROL_ALL_SOUND_OFF, 0.0);
+                }
+            }
+            else if (pData->ctrlChannel >= 0 && pData->ctrlChannel < MAX_MIDI_CHANNELS)
+            {
+                for (uint8_t i=0; i < MAX_MIDI_NOTE; ++i)
+                    addNoteEventRT(0, false, static_cast<uint8_t>(pData->ctrlChannel), i, 0);
+            }
+
+            pData->needsReset = false;
+        }
+
+        // --------------------------------------------------------------------------------------------------------
+        // Parameter changes from other threads
+
+        if (fParamsPendingForProcessor)
+        {
+            fParamsPendingForProcessor = false;
+
+            for (uint32_t i=0; i < fParamCount; ++i)
+            {
+                if (! fParams[i].pendingForProcessor)
+                    continue;
+
+                fParams[i].pendingForProcessor = false;
+                fParamChangesIn.addHostPoint(i, fParams[i].id, 0, fParams[i].value);
+            }
+        }
+
+        // --------------------------------------------------------------------------------------------------------
+        // Set ProcessContext
+
+        const EngineTimeInfo timeInfo(pData->engine->getTimeInfo());
+
+        fProcessContext.state      = 0;
+        fProcessContext.sampleRate = pData->engine->getSampleRate();
+        fProcessContext.projectTimeSamples = static_cast<Vst::TSamples>(timeInfo.frame);
+
+        if (timeInfo.playing)
+            fProcessContext.state |= Vst::ProcessContext::kPlaying;
+
+        if (timeInfo.usecs != 0)
+        {
+            fProcessContext.systemTime = static_cast<int64>(timeInfo.usecs) * 1000;
+            fProcessContext.state |= Vst::ProcessContext::kSystemTimeValid;
+        }
+
+        if (timeInfo.bbt.valid)
+        {
+            CARLA_SAFE_ASSERT_INT(timeInfo.bbt.bar > 0, timeInfo.bbt.bar);
+            CARLA_SAFE_ASSERT_INT(timeInfo.bbt.beat > 0, timeInfo.bbt.beat);
+
+            fProcessContext.projectTimeMusic = timeInfo.bbt.ppqPos;
+            fProcessContext.barPositionMusic = timeInfo.bbt.ppqBarStartPos;
+            fProcessContext.tempo = timeInfo.bbt.beatsPerMinute;
+            fProcessContext.timeSigNumerator   = static_cast<int32>(timeInfo.bbt.beatsPerBar);
+            fProcessContext.timeSigDenominator = static_cast<int32>(timeInfo.bbt.beatType);
+            fProcessContext.state |= Vst::ProcessContext::kProjectTimeMusicValid
+                                   | Vst::ProcessContext::kBarPositionValid
+                                   | Vst::ProcessContext::kTempoValid
+                                   | Vst::ProcessContext::kTimeSigValid;
+        }
+        else
+        {
+            fProcessContext.projectTimeMusic = 0.0;
+            fProcessContext.barPositionMusic = 0.0;
+            fProcessContext.tempo = 120.0;
+            fProcessContext.timeSigNumerator   = 4;
+            fProcessContext.timeSigDenominator = 4;
+            fProcessContext.state |= Vst::ProcessContext::kTempoValid
+                                   | Vst::ProcessContext::kTimeSigValid;
+        }
+
+        // --------------------------------------------------------------------------------------------------------
+        // Event Input
+        // VST3 takes events and parameter changes at their sample offsets, so the block never needs splitting
+
+        if (pData->event.portIn != nullptr)
+        {
+            // ----------------------------------------------------------------------------------------------------
+            // MIDI Input (External)
+
+            {
+                ExternalMidiNote note = { 0, 0, 0, 0 };
+
+                for (; ! fEventsIn.isFull() && pData->extNotes.getNextRT(note, frames);)
+                {
+                    CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
+
+                    addNoteEventRT(note.time, note.velo > 0, static_cast<uint8_t>(note.channel), note.note, note.velo);
+                }
+
+            } // End of MIDI Input (External)
+
+            // ----------------------------------------------------------------------------------------------------
+            // Event Input (System)
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+            bool allNotesOffSent = false;
+
+            if (cvIn != nullptr && pData->event.cvSourcePorts != nullptr)
+                pData->event.cvSourcePorts->initPortBuffers(cvIn, frames, (pData->options & PLUGIN_OPTION_FIXED_BUFFERS) == 0, pData->event.portIn);
+#endif
+
+            for (uint32_t i=0, numEvents = pData->event.portIn->getEventCount(); i < numEvents; ++i)
+            {
+                EngineEvent& event(pData->event.portIn->getEvent(i));
+
+                const uint32_t eventTime = event.time;
+                CARLA_SAFE_ASSERT_UINT2_CONTINUE(eventTime < frames, eventTime, frames);
+
+                switch (event.type)
+                {
+                case kEngineEventTypeNull:
+                    break;
+
+                case kEngineEventTypeControl: {
+                    EngineControlEvent& ctrlEvent(event.ctrl);
+
+                    switch (ctrlEvent.type)
+                    {
+                    case kEngineControlEventTypeNull:
+                        break;
+
+                    case kEngineControlEventTypeParameter: {
+                        float value;
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+                        // non-midi
+                        if (event.channel == kEngineEventNonMidiChannel)
+                        {
+                            const uint32_t k = ctrlEvent.param;
+                            CARLA_SAFE_ASSERT_CONTINUE(k < pData->param.count);
+
+                            ctrlEvent.handled = true;
+                            value = pData->param.getFinalUnnormalizedValue(k, ctrlEvent.normalizedValue);
+                            setParameterValueRT(k, value, eventTime, true);
+                            continue;
+                        }
+
+                        // Control backend stuff
+                        if (event.channel == pData->ctrlChannel)
+                        {
+                            if (MIDI_IS_CONTROL_BREATH_CONTROLLER(ctrlEvent.param) && (pData->hints & PLUGIN_CAN_DRYWET) != 0)
+                            {
+                                ctrlEvent.handled = true;
+                                value = ctrlEvent.normalizedValue;
+                                setDryWetRT(value, true);
+                            }
+                            else if (MIDI_IS_CONTROL_CHANNEL_VOLUME(ctrlEvent.param) && (pData->hints & PLUGIN_CAN_VOLUME) != 0)
+                            {
+                                ctrlEvent.handled = true;
+                                value = ctrlEvent.normalizedValue*127.0f/100.0f;
+                                setVolumeRT(value, true);
+                            }
+                            else if (MIDI_IS_CONTROL_BALANCE(ctrlEvent.param) && (pData->hints & PLUGIN_CAN_BALANCE) != 0)
+                            {
+                                float left, right;
+                                value = ctrlEvent.normalizedValue/0.5f - 1.0f;
+
+                                if (value < 0.0f)
+                                {
+                                    left  = -1.0f;
+                                    right = (value*2.0f)+1.0f;
+                                }
+                                else if (value > 0.0f)
+                                {
+                                    left  = (value*2.0f)-1.0f;
+                                    right = 1.0f;
+                                }
+                                else
+                                {
+                                    left  = -1.0f;
+                                    right = 1.0f;
+                                }
+
+                                ctrlEvent.handled = true;
+                                setBalanceLeftRT(left, true);
+                                setBalanceRightRT(right, true);
+                            }
+                        }
+#endif
+                        // Control plugin parameters
+                        const uint32_t* mappedParams = nullptr;
+                        uint32_t numMappedParams = 0;
+                        const bool useControlMap = pData->param.getMappedParameters(event.channel, ctrlEvent.param,
+                                                                                    mappedParams, numMappedParams);
+
+                        for (uint32_t m=0, end = useControlMap ? numMappedParams : pData->param.count; m < end; ++m)
+                        {
+                            const uint32_t k = useControlMap ? mappedParams[m] : m;
+
+                            if (pData->param.data[k].midiChannel != event.channel)
+                                continue;
+                            if (pData->param.data[k].mappedControlIndex != ctrlEvent.param)
+                                continue;
+                            if (pData->param.data[k].type != PARAMETER_INPUT)
+                                continue;
+                            if ((pData->param.data[k].hints & PARAMETER_IS_AUTOMABLE) == 0)
+                                continue;
+
+                            ctrlEvent.handled = true;
+                            value = pData->param.getFinalUnnormalizedValue(k, ctrlEvent.normalizedValue);
+                            setParameterValueRT(k, value, eventTime, true);
+                        }
+
+                        if ((pData->options & PLUGIN_OPTION_SEND_CONTROL_CHANGES) != 0 && ctrlEvent.param < MAX_MIDI_VALUE)
+                            addMidiControllerRT(eventTime, event.channel, ctrlEvent.param, ctrlEvent.normalizedValue);
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+                        if (! ctrlEvent.handled)
+                            checkForMidiLearn(event);
+#endif
+                        break;
+                    } // case kEngineControlEventTypeParameter
+
+                    case kEngineControlEventTypeMidiBank:
+                        break;
+
+                    case kEngineControlEventTypeMidiProgram:
+                        if (event.channel == pData->ctrlChannel && (pData->options & PLUGIN_OPTION_MAP_PROGRAM_CHANGES) != 0)
+                        {
+                            if (ctrlEvent.param < pData->prog.count)
+                            {
+                                setProgramRT(ctrlEvent.param, true);
+                                break;
+                            }
+                        }
+                        break;
+
+                    case kEngineControlEventTypeAllSoundOff:
+                        if (pData->options & PLUGIN_OPTION_SEND_ALL_SOUND_OFF)
+                            addMidiControllerRT(eventTime, event.channel, MIDI_CONTROL_ALL_SOUND_OFF, 0.0);
+                        break;
+
+                    case kEngineControlEventTypeAllNotesOff:
+                        if (pData->options & PLUGIN_OPTION_SEND_ALL_SOUND_OFF)
+                        {
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+                            if (event.channel == pData->ctrlChannel && ! allNotesOffSent)
+                            {
+                                allNotesOffSent = true;
+                                postponeRtAllNotesOff();
+                            }
+#endif
+
+                            addMidiControllerRT(eventTime, event.channel, MIDI_CONTROL_ALL_NOTES_OFF, 0.0);
+                        }
+                        break;
+                    } // switch (ctrlEvent.type)
+                    break;
+                } // case kEngineEventTypeControl
+
+                case kEngineEventTypeMidi: {
+                    const EngineMidiEvent& midiEvent(event.midi);
+
+                    if (midiEvent.size > 3)
+                        continue;
+#ifdef CARLA_PROPER_CPP11_SUPPORT
+                    static_assert(3 <= EngineMidiEvent::kDataSize, "Incorrect data");
+#endif
+
+                    uint8_t status = uint8_t(MIDI_GET_STATUS_FROM_DATA(midiEvent.data));
+
+                    if ((status == MIDI_STATUS_NOTE_OFF || status == MIDI_STATUS_NOTE_ON) && (pData->options & PLUGIN_OPTION_SKIP_SENDING_NOTES))
+                        continue;
+                    if (status == MIDI_STATUS_CHANNEL_PRESSURE && (pData->options & PLUGIN_OPTION_SEND_CHANNEL_PRESSURE) == 0)
+                        continue;
+                    if (status == MIDI_STATUS_CONTROL_CHANGE && (pData->options & PLUGIN_OPTION_SEND_CONTROL_CHANGES) == 0)
+                        continue;
+                    if (status == MIDI_STATUS_POLYPHONIC_AFTERTOUCH && (pData->options & PLUGIN_OPTION_SEND_NOTE_AFTERTOUCH) == 0)
+                        continue;
+                    if (status == MIDI_STATUS_PITCH_WHEEL_CONTROL && (pData->options & PLUGIN_OPTION_SEND_PITCHBEND) == 0)
+                        continue;
+
+                    // Fix bad note-off
+                    if (status == MIDI_STATUS_NOTE_ON && midiEvent.data[2] == 0)
+                        status = MIDI_STATUS_NOTE_OFF;
+
+                    const uint8_t data1 = midiEvent.size >= 2 ? midiEvent.data[1] : 0;
+                    const uint8_t data2 = midiEvent.size >= 3 ? midiEvent.data[2] : 0;
+
+                    switch (status)
+                    {
+                    case MIDI_STATUS_NOTE_OFF:
+                        addNoteEventRT(eventTime, false, event.channel, data1, data2);
+                        pData->postponeRtEvent(kPluginPostRtEventNoteOff,
+                                               true,
+                                               event.channel,
+                                               data1,
+                                               0, 0.0f);
+                        break;
+
+                    case MIDI_STATUS_NOTE_ON:
+                        addNoteEventRT(eventTime, true, event.channel, data1, data2);
+                        pData->postponeRtEvent(kPluginPostRtEventNoteOn,
+                                               true,
+                                               event.channel,
+                                               data1,
+                                               data2,
+                                               0.0f);
+                        break;
+
+                    case MIDI_STATUS_POLYPHONIC_AFTERTOUCH:
+                        addPolyPressureEventRT(eventTime, event.channel, data1, data2);
+                        break;
+
+                    case MIDI_STATUS_CONTROL_CHANGE:
+                        addMidiControllerRT(eventTime, event.channel, data1, static_cast<double>(data2)/127.0);
+                        break;
+
+                    case MIDI_STATUS_CHANNEL_PRESSURE:
+                        addMidiControllerRT(eventTime, event.channel, Vst::kAfterTouch, static_cast<double>(data1)/127.0);
+                        break;
+
+                    case MIDI_STATUS_PITCH_WHEEL_CONTROL:
+                        addMidiControllerRT(eventTime, event.channel, Vst::kPitchBend,
+                                            static_cast<double>((data2 << 7) | data1)/16383.0);
+                        break;
+                    }
+                } break;
+                } // switch (event.type)
+            }
+
+        } // End of Event Input
+
+        // --------------------------------------------------------------------------------------------------------
+        // Plugin processing
+
+        processSingle(audioIn, audioOut, frames);
+
+        // --------------------------------------------------------------------------------------------------------
+        // Parameter changes from the plugin
+
+        for (uint32_t i=0, count = fParamChangesOut.getUsedCount(); i < count; ++i)
+        {
+            CarlaVst3ParamValueQueue& queue(fParamChangesOut.getQueue(i));
+
+            Vst::ParamValue value;
+            if (! queue.getLastValue(value))
+                continue;
+
+            const int32_t index = findParamIndex(queue.getParameterId());
+            if (index < 0)
+                continue;
+
+            Param& param(fParams[index]);
+            param.value = value;
+            param.pendingForController = true;
+            fParamsPendingForController = true;
+
+            if (index == fProgramParamIndex)
+            {
+                const int32_t program = static_cast<int32_t>(normalizedToCarla(static_cast<uint32_t>(index), value) + 0.5f);
+
+                if (program != pData->prog.current && program < static_cast<int32_t>(pData->prog.count))
+                {
+                    pData->prog.current = program;
+                    pData->postponeRtEvent(kPluginPostRtEventProgramChange, true, program, 0, 0, 0.0f);
+                }
+            }
+            else if (param.carlaIndex >= 0)
+            {
+                pData->postponeRtEvent(kPluginPostRtEventParameterChange,
+                                       true,
+                                       param.carlaIndex,
+                                       0, 0,
+                                       normalizedToCarla(static_cast<uint32_t>(index), value));
+            }
+        }
+
+        // --------------------------------------------------------------------------------------------------------
+        // MIDI Output
+
+        if (pData->event.portOut != nullptr)
+        {
+            Vst::Event event;
+
+            for (int32 i=0, count = fEventsOut.getEventCount(); i < count; ++i)
+            {
+                if (fEventsOut.getEvent(i, event) != kResultOk)
+                    break;
+
+                CARLA_SAFE_ASSERT_CONTINUE(event.sampleOffset >= 0);
+
+                uint8_t midiData[3] = { 0, 0, 0 };
+
+                switch (event.type)
+                {
+                case Vst::Event::kNoteOnEvent:
+                    midiData[0] = static_cast<uint8_t>(MIDI_STATUS_NOTE_ON | (event.noteOn.channel & MIDI_CHANNEL_BIT));
+                    midiData[1] = static_cast<uint8_t>(event.noteOn.pitch);
+                    midiData[2] = static_cast<uint8_t>(carla_fixedValue(0.0f, 1.0f, event.noteOn.velocity) * 127.0f);
+                    break;
+
+                case Vst::Event::kNoteOffEvent:
+                    midiData[0] = static_cast<uint8_t>(MIDI_STATUS_NOTE_OFF | (event.noteOff.channel & MIDI_CHANNEL_BIT));
+                    midiData[1] = static_cast<uint8_t>(event.noteOff.pitch);
+                    midiData[2] = static_cast<uint8_t>(carla_fixedValue(0.0f, 1.0f, event.noteOff.velocity) * 127.0f);
+                    break;
+
+                case Vst::Event::kPolyPressureEvent:
+                    midiData[0] = static_cast<uint8_t>(MIDI_STATUS_POLYPHONIC_AFTERTOUCH | (event.polyPressure.channel & MIDI_CHANNEL_BIT));
+                    midiData[1] = static_cast<uint8_t>(event.polyPressure.pitch);
+                    midiData[2] = static_cast<uint8_t>(carla_fixedValue(0.0f, 1.0f, event.polyPressure.pressure) * 127.0f);
+                    break;
+
+                case Vst::Event::kLegacyMIDICCOutEvent: {
+                    const Vst::LegacyMIDICCOutEvent& cc(event.midiCCOut);
+                    const uint8_t channel = static_cast<uint8_t>(cc.channel & MIDI_CHANNEL_BIT);
+
+                    if (cc.controlNumber < MAX_MIDI_CONTROL)
+                    {
+                        midiData[0] = static_cast<uint8_t>(MIDI_STATUS_CONTROL_CHANGE | channel);
+                        midiData[1] = cc.controlNumber;
+                        midiData[2] = static_cast<uint8_t>(cc.value);
+                    }
+                    else if (cc.controlNumber == Vst::kAfterTouch)
+                    {
+                        midiData[0] = static_cast<uint8_t>(MIDI_STATUS_CHANNEL_PRESSURE | channel);
+                        midiData[1] = static_cast<uint8_t>(cc.value);
+                    }
+                    else if (cc.controlNumber == Vst::kPitchBend)
+                    {
+                        midiData[0] = static_cast<uint8_t>(MIDI_STATUS_PITCH_WHEEL_CONTROL | channel);
+                        midiData[1] = static_cast<uint8_t>(cc.value);
+                        midiData[2] = static_cast<uint8_t>(cc.value2);
+                    }
+                    else if (cc.controlNumber == Vst::kCtrlPolyPressure)
+                    {
+                        midiData[0] = static_cast<uint8_t>(MIDI_STATUS_POLYPHONIC_AFTERTOUCH | channel);
+                        midiData[1] = static_cast<uint8_t>(cc.value);
+                        midiData[2] = static_cast<uint8_t>(cc.value2);
+                    }
+                    else if (cc.controlNumber == Vst::kCtrlProgramChange)
+                    {
+                        midiData[0] = static_cast<uint8_t>(MIDI_STATUS_PROGRAM_CHANGE | channel);
+                        midiData[1] = static_cast<uint8_t>(cc.value);
+                    }
+                } break;
+                }
+
+                if (midiData[0] == 0)
+                    continue;
+
+                if (! pData->event.portOut->writeMidiEvent(static_cast<uint32_t>(event.sampleOffset), 3, midiData))
+                    break;
+            }
+
+        } // End of MIDI Output
+
+        // --------------------------------------------------------------------------------------------------------
+
+#ifdef BUILD_BRIDGE_ALTERNATIVE_ARCH
+        return;
+
+        // unused
+        (void)cvIn;
+#endif
+    }
+
+    bool processSingle(const float* const* const inBuffer, float** const outBuffer, const uint32_t frames)
+    {
+        CARLA_SAFE_ASSERT_RETURN(frames > 0, false);
+
+        if (pData->audioIn.count > 0)
+        {
+            CARLA_SAFE_ASSERT_RETURN(inBuffer != nullptr, false);
+        }
+        if (pData->audioOut.count > 0)
+        {
+            CARLA_SAFE_ASSERT_RETURN(outBuffer != nullptr, false);
+            CARLA_SAFE_ASSERT_RETURN(fAudioOutBuffers != nullptr, false);
+        }
+
+        // --------------------------------------------------------------------------------------------------------
+        // Try lock, silence otherwise
+
+        if (pData->engine->isOffline())
+        {
+            pData->singleMutex.lock();
+        }
+        else if (! pData->singleMutex.tryLock())
+        {
+            for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                carla_zeroFloats(outBuffer[i], frames);
+
+            return false;
+        }
+
+        // program changes requested by the host while we were running
+        pData->applyDeferredProgramChangesRT(this);
+
+        // --------------------------------------------------------------------------------------------------------
+        // Set audio buffers
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+        // write straight into the engine buffers if post-processing has nothing to do
+        const bool processDirectly = pData->canProcessDirectly();
+#else
+        const bool processDirectly = false;
+#endif
+
+        for (uint32_t i=0; i < pData->audioIn.count; ++i)
+            fAudioInBuses.channels[i] = const_cast<float*>(inBuffer[i]);
+
+        for (uint32_t i=0; i < pData->audioOut.count; ++i)
+        {
+            fAudioOutBuses.channels[i] = processDirectly ? outBuffer[i] : fAudioOutBuffers[i];
+            carla_zeroFloats(fAudioOutBuses.channels[i], frames);
+        }
+
+        // --------------------------------------------------------------------------------------------------------
+        // Run plugin
+
+        fProcessData.numSamples = static_cast<int32>(frames);
+
+        try {
+            fProcessor->process(fProcessData);
+        } CARLA_SAFE_EXCEPTION("process");
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+        // --------------------------------------------------------------------------------------------------------
+        // Post-processing (dry/wet, volume and balance)
+
+        if (! processDirectly)
+            pData->processPostProc(inBuffer, 0, true, fAudioOutBuffers, outBuffer, 0, frames);
+
+# ifndef BUILD_BRIDGE
+        // --------------------------------------------------------------------------------------------------------
+        // Save latency values for next callback
+
+        pData->latency.saveInputs(fAudioInBuses.channels, pData->audioIn.count, frames);
+# endif
+#else // BUILD_BRIDGE_ALTERNATIVE_ARCH
+        for (uint32_t i=0; i < pData->audioOut.count; ++i)
+            carla_copyFloats(outBuffer[i], fAudioOutBuffers[i], frames);
+#endif
+
+        // --------------------------------------------------------------------------------------------------------
+
+        pData->singleMutex.unlock();
+        return true;
+    }
+
+    void bufferSizeChanged(const uint32_t newBufferSize) override
+    {
+        CARLA_ASSERT_INT(newBufferSize > 0, newBufferSize);
+        carla_debug("CarlaPluginVST3::bufferSizeChanged(%i)", newBufferSize);
+
+        fBufferSize = newBufferSize;
+
+        if (pData->active)
+            deactivate();
+
+        fAudioBufferArena.reset(pData->audioOut.count, newBufferSize);
+
+        for (uint32_t i=0; i < pData->audioOut.count; ++i)
+            fAudioOutBuffers[i] = fAudioBufferArena.allocate();
+
+        if (pData->active)
+            activate();
+    }
+
+    void sampleRateChanged(const double newSampleRate) override
+    {
+        CARLA_ASSERT_INT(newSampleRate > 0.0, newSampleRate);
+        carla_debug("CarlaPluginVST3::sampleRateChanged(%g)", newSampleRate);
+
+        // the new rate is passed on through setupProcessing
+        if (pData->active)
+        {
+            deactivate();
+            activate();
+        }
+    }
+
+    // -------------------------------------------------------------------
+    // Plugin buffers
+
+    void clearBuffers() noexcept override
+    {
+        carla_debug("CarlaPluginVST3::clearBuffers() - start");
+
+        if (fAudioOutBuffers != nullptr)
+        {
+            delete[] fAudioOutBuffers;
+            fAudioOutBuffers = nullptr;
+        }
+
+        fAudioBufferArena.reset(0, 0);
+
+        CarlaPlugin::clearBuffers();
+
+        carla_debug("CarlaPluginVST3::clearBuffers() - end");
+    }
+
+    // -------------------------------------------------------------------
+
+    const void* getNativeDescriptor() const noexcept override
+    {
+        return fComponent;
+    }
+
+    const void* getExtraStuff() const noexcept override
+    {
+        return fController;
+    }
+
+    // -------------------------------------------------------------------
+
+public:
+    bool init(const CarlaPluginPtr plugin,
+              const char* const filename, const char* const name, const char* const label, const int64_t uniqueId,
+              const uint options)
+    {
+        CARLA_SAFE_ASSERT_RETURN(pData->engine != nullptr, false);
+
+        // ---------------------------------------------------------------
+        // first checks
+
+        if (pData->client != nullptr)
+        {
+            pData->engine->setLastError("Plugin client is already registered");
+            return false;
+        }
+
+        if (filename == nullptr || filename[0] == '\0')
+        {
+            pData->engine->setLastError("null filename");
+            return false;
+        }
+
+        // ---------------------------------------------------------------
+        // open module and get factory
+
+        V3_GetFactoryFunction getFactory;
+
+#ifdef CARLA_OS_MAC
+        {
+            const CFURLRef urlRef = CFURLCreateFromFileSystemRepresentation(0, (const UInt8*)filename, (CFIndex)strlen(filename), true);
+            CARLA_SAFE_ASSERT_RETURN(urlRef != nullptr, false);
+
+            fMacBundleRef = CFBundleCreate(kCFAllocatorDefault, urlRef);
+            CFRelease(urlRef);
+
+            if (fMacBundleRef == nullptr || ! CFBundleLoadExecutable(fMacBundleRef))
+            {
+                pData->engine->setLastError("Failed to load VST3 bundle executable");
+                return false;
+            }
+
+            if (const V3_ModuleEntryFunction entryFn = (V3_ModuleEntryFunction)CFBundleGetFunctionPointerForName(fMacBundleRef, CFSTR(V3_MODULE_ENTRY_NAME)))
+            {
+                if (! entryFn(fMacBundleRef))
+                {
+                    pData->engine->setLastError("VST3 module entry failed");
+                    return false;
+                }
+
+                fModuleExit = (V3_ModuleExitFunction)CFBundleGetFunctionPointerForName(fMacBundleRef, CFSTR(V3_MODULE_EXIT_NAME));
+            }
+
+            getFactory = (V3_GetFactoryFunction)CFBundleGetFunctionPointerForName(fMacBundleRef, CFSTR("GetPluginFactory"));
+        }
+#else
+        {
+            const water::File binaryFile(getVst3BinaryFile(filename));
+            const String binaryPath(binaryFile.getFullPathName());
+
+            if (! pData->libOpen(binaryPath.toRawUTF8()))
+            {
+                pData->engine->setLastError(pData->libError(binaryPath.toRawUTF8()));
+                return false;
+            }
+
+            if (const V3_ModuleEntryFunction entryFn = pData->libSymbol<V3_ModuleEntryFunction>(V3_MODULE_ENTRY_NAME))
+            {
+# ifdef CARLA_OS_WIN
+                if (! entryFn())
+# else
+                if (! entryFn(pData->lib))
+# endif
+                {
+                    pData->engine->setLastError("VST3 module entry failed");
+                    return false;
+                }
+
+                fModuleExit = pData->libSymbol<V3_ModuleExitFunction>(V3_MODULE_EXIT_NAME);
+            }
+
+            getFactory = pData->libSymbol<V3_GetFactoryFunction>("GetPluginFactory");
+        }
+#endif
+
+        if (getFactory == nullptr)
+        {
+            pData->engine->setLastError("Not a VST3 plugin");
+            return false;
+        }
+
+        try {
+            fFactory = getFactory();
+        } CARLA_SAFE_EXCEPTION("GetPluginFactory");
+
+        if (fFactory == nullptr)
+        {
+            pData->engine->setLastError("VST3 plugin failed to return a factory");
+            return false;
+        }
+
+        IPluginFactory2* factory2 = nullptr;
+        fFactory->queryInterface(IPluginFactory2_iid, (void**)&factory2);
+
+        {
+            IPluginFactory3* factory3 = nullptr;
+
+            if (fFactory->queryInterface(IPluginFactory3_iid, (void**)&factory3) == kResultOk && factory3 != nullptr)
+            {
+                factory3->setHostContext(&getHostApplication());
+                factory3->release();
+            }
+        }
+
+        // ---------------------------------------------------------------
+        // find the requested class, by unique id or name, falling back to the first audio effect
+
+        TUID classId;
+        int32 classIndex = -1;
+        {
+            PClassInfo info;
+
+            for (int32 i=0, count = fFactory->countClasses(); i < count; ++i)
+            {
+                info = PClassInfo();
+
+                if (fFactory->getClassInfo(i, &info) != kResultOk)
+                    continue;
+                if (std::strcmp(info.category, kVstAudioEffectClass) != 0)
+                    continue;
+
+                if (classIndex < 0)
+                    classIndex = i;
+
+                if ((uniqueId != 0 && getVst3UniqueId(info.cid) == uniqueId) ||
+                    (uniqueId == 0 && label != nullptr && label[0] != '\0' && std::strcmp(info.name, label) == 0))
+                {
+                    classIndex = i;
+                    break;
+                }
+            }
+
+            if (classIndex < 0)
+            {
+                if (factory2 != nullptr)
+                    factory2->release();
+
+                pData->engine->setLastError("No audio effects found in VST3 plugin");
+                return false;
+            }
+
+            info = PClassInfo();
+            fFactory->getClassInfo(classIndex, &info);
+            std::memcpy(classId, info.cid, sizeof(TUID));
+
+            fUniqueId = getVst3UniqueId(info.cid);
+            fLabel    = info.name;
+        }
+
+        if (factory2 != nullptr)
+        {
+            PClassInfo2 info2;
+
+            if (factory2->getClassInfo2(classIndex, &info2) == kResultOk)
+            {
+                fMaker         = info2.vendor;
+                fSubCategories = info2.subCategories;
+            }
+
+            factory2->release();
+        }
+
+        if (fMaker.isEmpty())
+        {
+            PFactoryInfo factoryInfo;
+
+            if (fFactory->getFactoryInfo(&factoryInfo) == kResultOk)
+                fMaker = factoryInfo.vendor;
+        }
+
+        // ---------------------------------------------------------------
+        // create and initialize component
+
+        try {
+            fFactory->createInstance(classId, Vst::IComponent_iid, (void**)&fComponent);
+        } CARLA_SAFE_EXCEPTION("createInstance component");
+
+        if (fComponent == nullptr)
+        {
+            pData->engine->setLastError("Failed to create VST3 component");
+            return false;
+        }
+
+        if (fComponent->initialize(&getHostApplication()) != kResultOk)
+        {
+            fComponent->release();
+            fComponent = nullptr;
+            pData->engine->setLastError("Failed to initialize VST3 component");
+            return false;
+        }
+
+        if (fComponent->queryInterface(Vst::IAudioProcessor_iid, (void**)&fProcessor) != kResultOk || fProcessor == nullptr)
+        {
+            fProcessor = nullptr;
+            pData->engine->setLastError("VST3 component is not an audio processor");
+            return false;
+        }
+
+        if (fProcessor->canProcessSampleSize(Vst::kSample32) != kResultOk)
+        {
+            pData->engine->setLastError("VST3 plugin does not support 32bit processing");
+            return false;
+        }
+
+        // ---------------------------------------------------------------
+        // get edit controller, either the component itself or a separate class
+
+        if (fComponent->queryInterface(Vst::IEditController_iid, (void**)&fController) == kResultOk && fController != nullptr)
+        {
+            fControllerIsComponent = true;
+        }
+        else
+        {
+            fController = nullptr;
+
+            TUID controllerClassId;
+
+            if (fComponent->getControllerClassId(controllerClassId) == kResultOk)
+            {
+                try {
+                    fFactory->createInstance(controllerClassId, Vst::IEditController_iid, (void**)&fController);
+                } CARLA_SAFE_EXCEPTION("createInstance controller");
+            }
+
+            if (fController == nullptr)
+            {
+                pData->engine->setLastError("Failed to create VST3 edit controller");
+                return false;
+            }
+
+            if (fController->initialize(&getHostApplication()) != kResultOk)
+            {
+                fController->release();
+                fController = nullptr;
+                pData->engine->setLastError("Failed to initialize VST3 edit controller");
+                return false;
+            }
+
+            // let component and controller talk to each other
+            if (fComponent->queryInterface(Vst::IConnectionPoint_iid, (void**)&fComponentConnection) != kResultOk)
+                fComponentConnection = nullptr;
+            if (fController->queryInterface(Vst::IConnectionPoint_iid, (void**)&fControllerConnection) != kResultOk)
+                fControllerConnection = nullptr;
+
+            if (fComponentConnection != nullptr && fControllerConnection != nullptr)
+            {
+                fComponentConnection->connect(fControllerConnection);
+                fControllerConnection->connect(fComponentConnection);
+            }
+        }
+
+        fController->setComponentHandler(&fComponentHandler);
+
+        // sync controller with the component default state
+        {
+            CarlaVst3MemoryStream stream;
+
+            if (fComponent->getState(&stream) == kResultOk)
+            {
+                stream.seek(0, IBStream::kIBSeekSet, nullptr);
+                fController->setComponentState(&stream);
+            }
+        }
+
+        if (fController->queryInterface(Vst::IMidiMapping_iid, (void**)&fMidiMapping) != kResultOk)
+            fMidiMapping = nullptr;
+        if (fController->queryInterface(Vst::IUnitInfo_iid, (void**)&fUnitInfo) != kResultOk)
+            fUnitInfo = nullptr;
+
+        // ---------------------------------------------------------------
+        // get info
+
+        if (name != nullptr && name[0] != '\0')
+            pData->name = pData->engine->getUniquePluginName(name);
+        else if (fLabel.isNotEmpty())
+            pData->name = pData->engine->getUniquePluginName(fLabel);
+        else
+            pData->name = pData->engine->getUniquePluginName("unknown");
+
+        pData->filename = carla_strdup(filename);
+
+        // ---------------------------------------------------------------
+        // register client
+
+        pData->client = pData->engine->addClient(plugin);
+
+        if (pData->client == nullptr || ! pData->client->isOk())
+        {
+            pData->engine->setLastError("Failed to register plugin client");
+            return false;
+        }
+
+        // ---------------------------------------------------------------
+        // set default options
+
+        const bool hasMidiIn = fComponent->getBusCount(Vst::kEvent, Vst::kInput) > 0;
+
+        pData->options = 0x0;
+
+        // events and parameter changes are passed with their offsets, splitting blocks is never needed
+        pData->options |= PLUGIN_OPTION_FIXED_BUFFERS;
+        pData->options |= PLUGIN_OPTION_USE_CHUNKS;
+
+        if (hasMidiIn)
+        {
+            if (isPluginOptionEnabled(options, PLUGIN_OPTION_SEND_CONTROL_CHANGES))
+                pData->options |= PLUGIN_OPTION_SEND_CONTROL_CHANGES;
+            if (isPluginOptionEnabled(options, PLUGIN_OPTION_SEND_CHANNEL_PRESSURE))
+                pData->options |= PLUGIN_OPTION_SEND_CHANNEL_PRESSURE;
+            if (isPluginOptionEnabled(options, PLUGIN_OPTION_SEND_NOTE_AFTERTOUCH))
+                pData->options |= PLUGIN_OPTION_SEND_NOTE_AFTERTOUCH;
+            if (isPluginOptionEnabled(options, PLUGIN_OPTION_SEND_PITCHBEND))
+                pData->options |= PLUGIN_OPTION_SEND_PITCHBEND;
+            if (isPluginOptionEnabled(options, PLUGIN_OPTION_SEND_ALL_SOUND_OFF))
+                pData->options |= PLUGIN_OPTION_SEND_ALL_SOUND_OFF;
+            if (isPluginOptionInverseEnabled(options, PLUGIN_OPTION_SKIP_SENDING_NOTES))
+                pData->options |= PLUGIN_OPTION_SKIP_SENDING_NOTES;
+        }
+
+        // programs are only known after reload, which checks this option again
+        if (isPluginOptionEnabled(options, PLUGIN_OPTION_MAP_PROGRAM_CHANGES))
+            pData->options |= PLUGIN_OPTION_MAP_PROGRAM_CHANGES;
+
+        // off by default, needs to be explicitly enabled per plugin
+        if (options & PLUGIN_OPTION_AUTO_SLEEP)
+            pData->options |= PLUGIN_OPTION_AUTO_SLEEP;
+
+        return true;
+    }
+
+private:
+    // -------------------------------------------------------------------
+    // Audio buses, with one flat list of channel pointers shared by all buses
+
+    struct AudioBuses {
+        Vst::AudioBusBuffers* buses;
+        float** channels;
+        int32 busCount;
+        uint32_t channelCount;
+
+        AudioBuses() noexcept
+            : buses(nullptr),
+              channels(nullptr),
+              busCount(0),
+              channelCount(0) {}
+
+        ~AudioBuses()
+        {
+            clear();
+        }
+
+        void clear() noexcept
+        {
+            delete[] buses;
+            delete[] channels;
+            buses = nullptr;
+            channels = nullptr;
+            busCount = 0;
+            channelCount = 0;
+        }
+
+        // activate all buses of a direction and return the total channel count
+        uint32_t create(Vst::IComponent* const component, const Vst::BusDirection direction)
+        {
+            clear();
+
+            const int32 count = component->getBusCount(Vst::kAudio, direction);
+
+            if (count <= 0)
+                return 0;
+
+            for (int32 i=0; i < count; ++i)
+            {
+                component->activateBus(Vst::kAudio, direction, i, true);
+                channelCount += static_cast<uint32_t>(getBusChannelCount(component, direction, i));
+            }
+
+            busCount = count;
+            buses    = new Vst::AudioBusBuffers[count];
+            channels = new float*[std::max(channelCount, 1U)];
+
+            carla_zeroPointers(channels, std::max(channelCount, 1U));
+
+            for (int32 i=0, offset=0; i < count; ++i)
+            {
+                buses[i].numChannels = getBusChannelCount(component, direction, i);
+                buses[i].channelBuffers32 = channels + offset;
+                offset += buses[i].numChannels;
+            }
+
+            return channelCount;
+        }
+
+        static int32 getBusChannelCount(Vst::IComponent* const component, const Vst::BusDirection direction, const int32 index)
+        {
+            Vst::BusInfo info;
+            carla_zeroStruct(info);
+
+            if (component->getBusInfo(Vst::kAudio, direction, index, info) == kResultOk && info.channelCount > 0)
+                return info.channelCount;
+
+            return 0;
+        }
+
+        CARLA_DECLARE_NON_COPY_STRUCT(AudioBuses);
+    };
+
+    // -------------------------------------------------------------------
+    // Parameters, indexed as in the edit controller
+
+    struct Param {
+        Vst::ParamID id;
+        int32 stepCount;
+        int32 flags;
+        int32 carlaIndex; // -1 if hidden
+        bool isMidiMapped;
+        Vst::ParamValue defaultValue;
+        volatile Vst::ParamValue value;
+        volatile bool pendingForProcessor;
+        volatile bool pendingForController;
+    };
+
+    float normalizedToCarla(const uint32_t index, const Vst::ParamValue value) const noexcept
+    {
+        const int32 stepCount = fParams[index].stepCount;
+
+        if (stepCount > 0)
+            return static_cast<float>(std::floor(value * stepCount + 0.5));
+
+        return static_cast<float>(value);
+    }
+
+    Vst::ParamValue carlaToNormalized(const uint32_t index, const float value) const noexcept
+    {
+        const int32 stepCount = fParams[index].stepCount;
+
+        if (stepCount > 0)
+            return carla_fixedValue(0.0, 1.0, static_cast<double>(value) / stepCount);
+
+        return carla_fixedValue(0.0, 1.0, static_cast<double>(value));
+    }
+
+    Vst::ParamValue programToNormalized(const uint32_t program) const noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(fProgramParamIndex >= 0, 0.0);
+
+        const int32 stepCount = fParams[fProgramParamIndex].stepCount;
+
+        return stepCount > 0 ? static_cast<double>(program) / stepCount : 0.0;
+    }
+
+    // binary search over the parameter ids, sorted in reloadParameters()
+    int32_t findParamIndex(const Vst::ParamID id) const noexcept
+    {
+        uint32_t low = 0, high = fParamCount;
+
+        while (low < high)
+        {
+            const uint32_t mid = (low + high) / 2;
+
+            if (fParams[fParamOrder[mid]].id < id)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        if (low < fParamCount && fParams[fParamOrder[low]].id == id)
+            return static_cast<int32_t>(fParamOrder[low]);
+
+        return -1;
+    }
+
+    // query all parameters from the controller, returns how many are exposed to the host
+    uint32_t reloadParameters()
+    {
+        delete[] fParams;
+        delete[] fParamOrder;
+        fParams = nullptr;
+        fParamOrder = nullptr;
+        fParamCount = 0;
+        fProgramParamIndex = -1;
+        fProgramListId = Vst::kNoProgramListId;
+
+        const int32 count = fController->getParameterCount();
+
+        if (count <= 0)
+        {
+            reloadMidiMapping();
+            return 0;
+        }
+
+        fParamCount = static_cast<uint32_t>(count);
+        fParams = new Param[fParamCount];
+        fParamOrder = new uint32_t[fParamCount];
+
+        Vst::UnitID programUnitId = Vst::kRootUnitId;
+
+        for (uint32_t i=0; i < fParamCount; ++i)
+        {
+            Vst::ParameterInfo info;
+            carla_zeroStruct(info);
+
+            try {
+                fController->getParameterInfo(static_cast<int32>(i), info);
+            } CARLA_SAFE_EXCEPTION("getParameterInfo");
+
+            Param& param(fParams[i]);
+            param.id = info.id;
+            param.stepCount = std::max(0, info.stepCount);
+            param.flags = info.flags;
+            param.carlaIndex = -1;
+            param.isMidiMapped = false;
+            param.defaultValue = info.defaultNormalizedValue;
+            param.value = fController->getParamNormalized(info.id);
+            param.pendingForProcessor = false;
+            param.pendingForController = false;
+
+            if ((info.flags & Vst::ParameterInfo::kIsProgramChange) != 0 && fProgramParamIndex < 0)
+            {
+                fProgramParamIndex = static_cast<int32_t>(i);
+                programUnitId = info.unitId;
+            }
+
+            fParamOrder[i] = i;
+        }
+
+        std::sort(fParamOrder, fParamOrder + fParamCount, ParamIdCompare(fParams));
+
+        reloadMidiMapping();
+
+        uint32_t exposedCount = 0;
+
+        for (uint32_t i=0; i < fParamCount; ++i)
+        {
+            Param& param(fParams[i]);
+
+            if (static_cast<int32_t>(i) == fProgramParamIndex)
+                continue;
+            if (param.isMidiMapped && (param.flags & Vst::ParameterInfo::kCanAutomate) == 0)
+                continue;
+
+            param.carlaIndex = static_cast<int32_t>(exposedCount++);
+        }
+
+        // find the program list of the unit the program change parameter belongs to
+        if (fProgramParamIndex >= 0 && fUnitInfo != nullptr)
+        {
+            Vst::UnitInfo unitInfo;
+
+            for (int32 i=0, unitCount = fUnitInfo->getUnitCount(); i < unitCount; ++i)
+            {
+                carla_zeroStruct(unitInfo);
+
+                if (fUnitInfo->getUnitInfo(i, unitInfo) != kResultOk)
+                    continue;
+
+                if (unitInfo.id == programUnitId)
+                {
+                    fProgramListId = unitInfo.programListId;
+                    break;
+                }
+            }
+
+            if (fProgramListId == Vst::kNoProgramListId && fUnitInfo->getProgramListCount() > 0)
+            {
+                Vst::ProgramListInfo listInfo;
+                carla_zeroStruct(listInfo);
+
+                if (fUnitInfo->getProgramListInfo(0, listInfo) == kResultOk)
+                    fProgramListId = listInfo.id;
+            }
+        }
+
+        return exposedCount;
+    }
+
+    struct ParamIdCompare {
+        const Param* const params;
+
+        ParamIdCompare(const Param* const p) noexcept
+            : params(p) {}
+
+        bool operator()(const uint32_t a, const uint32_t b) const noexcept
+        {
+            return params[a].id < params[b].id;
+        }
+    };
+
+    void reloadMidiMapping()
+    {
+        for (uint8_t c=0; c < MAX_MIDI_CHANNELS; ++c)
+            for (int32 i=0; i < Vst::kCountCtrlNumber; ++i)
+                fMidiCCMap[c][i] = -1;
+
+        if (fMidiMapping == nullptr)
+            return;
+
+        Vst::ParamID id;
+
+        for (uint8_t c=0; c < MAX_MIDI_CHANNELS; ++c)
+        {
+            for (int32 i=0; i < Vst::kCountCtrlNumber; ++i)
+            {
+                if (fMidiMapping->getMidiControllerAssignment(0, c, static_cast<Vst::CtrlNumber>(i), id) != kResultOk)
+                    continue;
+
+                const int32_t index = findParamIndex(id);
+
+                if (index < 0)
+                    continue;
+
+                fMidiCCMap[c][i] = index;
+                fParams[index].isMidiMapped = true;
+            }
+        }
+    }
+
+    void refreshParameterValuesFromController() noexcept
+    {
+        for (uint32_t i=0; i < fParamCount; ++i)
+        {
+            try {
+                fParams[i].value = fController->getParamNormalized(fParams[i].id);
+            } CARLA_SAFE_EXCEPTION_CONTINUE("getParamNormalized");
+        }
+    }
+
+    // -------------------------------------------------------------------
+    // Realtime helpers
+
+    void setParameterValueRT(const uint32_t parameterId, const float value, const uint32_t frameOffset, const bool sendCallbackLater) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count,);
+
+        const uint32_t index = static_cast<uint32_t>(pData->param.data[parameterId].rindex);
+        CARLA_SAFE_ASSERT_RETURN(index < fParamCount,);
+
+        const float fixedValue(pData->param.getFixedValue(parameterId, value));
+
+        Param& param(fParams[index]);
+        param.value = carlaToNormalized(index, fixedValue);
+        param.pendingForController = true;
+        fParamsPendingForController = true;
+
+        fParamChangesIn.addHostPoint(index, param.id, frameOffset, param.value);
+
+        CarlaPlugin::setParameterValueRT(parameterId, fixedValue, sendCallbackLater);
+    }
+
+    void addNoteEventRT(const uint32_t time, const bool noteOn, const uint8_t channel, const uint8_t note, const uint8_t velo) noexcept
+    {
+        Vst::Event event;
+        carla_zeroStruct(event);
+
+        event.sampleOffset = static_cast<int32>(time);
+
+        if (noteOn)
+        {
+            event.type = Vst::Event::kNoteOnEvent;
+            event.noteOn.channel  = channel;
+            event.noteOn.pitch    = note;
+            event.noteOn.velocity = static_cast<float>(velo) / 127.0f;
+            event.noteOn.noteId   = -1;
+        }
+        else
+        {
+            event.type = Vst::Event::kNoteOffEvent;
+            event.noteOff.channel  = channel;
+            event.noteOff.pitch    = note;
+            event.noteOff.velocity = static_cast<float>(velo) / 127.0f;
+            event.noteOff.noteId   = -1;
+        }
+
+        fEventsIn.addEvent(event);
+    }
+
+    void addPolyPressureEventRT(const uint32_t time, const uint8_t channel, const uint8_t note, const uint8_t pressure) noexcept
+    {
+        Vst::Event event;
+        carla_zeroStruct(event);
+
+        event.type = Vst::Event::kPolyPressureEvent;
+        event.sampleOffset = static_cast<int32>(time);
+        event.polyPressure.channel  = channel;
+        event.polyPressure.pitch    = note;
+        event.polyPressure.pressure = static_cast<float>(pressure) / 127.0f;
+        event.polyPressure.noteId   = -1;
+
+        fEventsIn.addEvent(event);
+    }
+
+    // VST3 has no MIDI controller events, the plugin maps them to parameters instead
+    void addMidiControllerRT(const uint32_t time, const uint8_t channel, const uint16_t controller, const double value) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(channel < MAX_MIDI_CHANNELS,);
+        CARLA_SAFE_ASSERT_RETURN(controller < Vst::kCountCtrlNumber,);
+
+        const int32_t index = fMidiCCMap[channel][controller];
+
+        if (index < 0)
+            return;
+
+        Param& param(fParams[index]);
+        param.value = value;
+        param.pendingForController = true;
+        fParamsPendingForController = true;
+
+        fParamChangesIn.addHostPoint(static_cast<uint32_t>(index), param.id, time, value);
+    }
+
+    // -------------------------------------------------------------------
+    // Restart requests from the plugin, handled on the main thread
+
+    void handleRestartRequest(const int32 flags)
+    {
+        carla_debug("CarlaPluginVST3::handleRestartRequest(0x%x)", flags);
+
+        if (flags & (Vst::kReloadComponent|Vst::kIoChanged|Vst::kParamTitlesChanged))
+        {
+            reload();
+            pData->engine->callback(true, true, ENGINE_CALLBACK_RELOAD_ALL, pData->id, 0, 0, 0, 0.0f, nullptr);
+            return;
+        }
+
+        if (flags & Vst::kLatencyChanged)
+        {
+            const uint32_t latency = fProcessor->getLatencySamples();
+
+            if (latency != pData->client->getLatency())
+            {
+                const ScopedSingleProcessLocker spl(this, true);
+
+                pData->client->setLatency(latency);
+#ifndef BUILD_BRIDGE
+                pData->latency.recreateBuffers(std::max(pData->audioIn.count, pData->audioOut.count), latency);
+#endif
+
+                if (pData->active)
+                {
+                    deactivate();
+                    activate();
+                }
+            }
+        }
+
+        if (flags & Vst::kMidiCCAssignmentChanged)
+        {
+            const ScopedSingleProcessLocker spl(this, true);
+            reloadMidiMapping();
+        }
+
+        if (flags & Vst::kParamValuesChanged)
+        {
+            refreshParameterValuesFromController();
+            pData->updateParameterValues(this, true, true, false);
+        }
+    }
+
+    void handlePerformEdit(const Vst::ParamID id, const Vst::ParamValue value)
+    {
+        const int32_t index = findParamIndex(id);
+        CARLA_SAFE_ASSERT_RETURN(index >= 0,);
+
+        Param& param(fParams[index]);
+        param.value = value;
+        param.pendingForProcessor = true;
+        fParamsPendingForProcessor = true;
+
+        if (param.carlaIndex >= 0)
+            CarlaPlugin::setParameterValue(static_cast<uint32_t>(param.carlaIndex),
+                                           normalizedToCarla(static_cast<uint32_t>(index), value),
+                                           false, true, true);
+    }
+
+    // -------------------------------------------------------------------
+    // State in JUCE format, see getChunkData()
+
+    bool loadJuceSaveFormat(const void* const data, const std::size_t dataSize,
+                            MemoryBlock& componentState, MemoryBlock& controllerState)
+    {
+        if (dataSize <= 8)
+            return false;
+
+        const uint32_t* const header = static_cast<const uint32_t*>(data);
+
+        if (ByteOrder::swapIfBigEndian(header[0]) != kJuceStateMagic)
+            return false;
+
+        const std::size_t stringLength = std::min<std::size_t>(ByteOrder::swapIfBigEndian(header[1]), dataSize - 8);
+        const String xmlText(String::fromUTF8(static_cast<const char*>(data) + 8, static_cast<int>(stringLength)));
+
+        CarlaScopedPointer<XmlElement> xml(XmlDocument::parse(xmlText));
+
+        if (xml == nullptr || xml->getTagName() != "VST3PluginState")
+            return false;
+
+        const String componentText(xml->getChildElementAllSubText("IComponent", String()));
+        const String controllerText(xml->getChildElementAllSubText("IEditController", String()));
+
+        if (componentText.isNotEmpty())
+            decodeJuceBase64(componentState, componentText.toRawUTF8());
+
+        if (controllerText.isNotEmpty())
+            decodeJuceBase64(controllerState, controllerText.toRawUTF8());
+
+        carla_stdout("NOTE: Loading plugin state in VST3/JUCE compatibility mode");
+        return true;
+    }
+
+    // -------------------------------------------------------------------
+    // Component handler, gets edits and restart requests from the controller
+
+    class ComponentHandler : public Vst::IComponentHandler
+    {
+    public:
+        ComponentHandler(CarlaPluginVST3* const plugin) noexcept
+            : fPlugin(plugin) {}
+
+        virtual ~ComponentHandler() {}
+
+        tresult PLUGIN_API queryInterface(const TUID iid, void** const obj) override
+        {
+            if (FUnknownPrivate::iidEqual(iid, FUnknown_iid) || FUnknownPrivate::iidEqual(iid, Vst::IComponentHandler_iid))
+            {
+                *obj = this;
+                return kResultOk;
+            }
+
+            *obj = nullptr;
+            return kNoInterface;
+        }
+
+        // owned by the plugin
+        uint32 PLUGIN_API addRef() override { return 1; }
+        uint32 PLUGIN_API release() override { return 1; }
+
+        tresult PLUGIN_API beginEdit(Vst::ParamID) override
+        {
+            return kResultOk;
+        }
+
+        tresult PLUGIN_API performEdit(const Vst::ParamID id, const Vst::ParamValue valueNormalized) override
+        {
+            fPlugin->handlePerformEdit(id, valueNormalized);
+            return kResultOk;
+        }
+
+        tresult PLUGIN_API endEdit(Vst::ParamID) override
+        {
+            return kResultOk;
+        }
+
+        // may be called from any thread, the request is handled during idle
+        tresult PLUGIN_API restartComponent(const int32 flags) override
+        {
+            __sync_fetch_and_or(&fPlugin->fRestartFlags, flags);
+            return kResultOk;
+        }
+
+    private:
+        CarlaPluginVST3* const fPlugin;
+
+        CARLA_DECLARE_NON_COPY_CLASS(ComponentHandler)
+    };
+
+    // -------------------------------------------------------------------
+
+    V3_ModuleExitFunction fModuleExit;
+#ifdef CARLA_OS_MAC
+    CFBundleRef fMacBundleRef;
+#endif
+
+    IPluginFactory* fFactory;
+    Vst::IComponent* fComponent;
+    Vst::IAudioProcessor* fProcessor;
+    Vst::IEditController* fController;
+    bool fControllerIsComponent;
+    Vst::IConnectionPoint* fComponentConnection;
+    Vst::IConnectionPoint* fControllerConnection;
+    Vst::IMidiMapping* fMidiMapping;
+    Vst::IUnitInfo* fUnitInfo;
+    ComponentHandler fComponentHandler;
+
+    int64_t fUniqueId;
+    CarlaString fLabel;
+    CarlaString fMaker;
+    CarlaString fSubCategories;
+
+    AudioBuses fAudioInBuses;
+    AudioBuses fAudioOutBuses;
+
+    Param* fParams;
+    uint32_t* fParamOrder;
+    uint32_t fParamCount;
+    volatile bool fParamsPendingForProcessor;
+    volatile bool fParamsPendingForController;
+
+    int32_t fProgramParamIndex;
+    Vst::ProgramListID fProgramListId;
+
+    // parameter index for each MIDI controller, -1 if not mapped
+    int32_t fMidiCCMap[MAX_MIDI_CHANNELS][Vst::kCountCtrlNumber];
+
+    volatile int32 fRestartFlags;
+
+    Vst::ProcessContext fProcessContext;
+    Vst::ProcessData fProcessData;
+    CarlaVst3EventList fEventsIn;
+    CarlaVst3EventList fEventsOut;
+    CarlaVst3ParameterChanges fParamChangesIn;
+    CarlaVst3ParameterChanges fParamChangesOut;
+
+    uint32_t fBufferSize;
+    float** fAudioOutBuffers;
+    EngineAudioBufferArena fAudioBufferArena;
+    MemoryBlock fChunk;
+
+    CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaPluginVST3)
+};
+
+CARLA_BACKEND_END_NAMESPACE
+
 // -------------------------------------------------------------------------------------------------------------------
 
+CARLA_BACKEND_START_NAMESPACE
+
 CarlaPluginPtr CarlaPlugin::newVST3(const Initializer& init)
 {
-    carla_debug("CarlaPlugin::newVST3({%p, \"%s\", \"%s\", " P_INT64 "})",
-                init.engine, init.filename, init.name, init.uniqueId);
+    carla_debug("CarlaPlugin::newVST3({%p, \"%s\", \"%s\", \"%s\", " P_INT64 "})",
+                init.engine, init.filename, init.name, init.label, init.uniqueId);
 
-#ifdef USING_JUCE
-    return newJuce(init, "VST3");
-#else
-    init.engine->setLastError("VST3 support not available");
-    return nullptr;
+#ifdef USE_JUCE_FOR_VST3
+    if (std::getenv("CARLA_USE_JUCE_FOR_VST3") != nullptr)
+        return newJuce(init, "VST3");
 #endif
+
+    std::shared_ptr<CarlaPluginVST3> plugin(new CarlaPluginVST3(init.engine, init.id));
+
+    if (! plugin->init(plugin, init.filename, init.name, init.label, init.uniqueId, init.options))
+        return nullptr;
+
+    return plugin;
 }
 
 // -------------------------------------------------------------------------------------------------------------------
@@ -17,6 +17,7 @@
 
 #include "CarlaUtils.h"
 
+#include "CarlaFloatStringUtils.hpp"
 #include "CarlaPipeUtils.hpp"
 
 namespace CB = CarlaBackend;
@@ -61,6 +62,15 @@ public:
 
     int readlineblock_int(const uint timeout) noexcept
     {
+        uint32_t size;
+        if (const void* const data = CarlaPipeClient::_readBinaryFrame(size, timeout))
+        {
+            int32_t value;
+            CARLA_SAFE_ASSERT_UINT2_RETURN(size == sizeof(value), size, sizeof(value), 0);
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
         if (const char* const line = CarlaPipeClient::_readlineblock(false, 0, timeout))
             return std::atoi(line);
 
@@ -69,8 +79,24 @@ public:
 
     double readlineblock_float(const uint timeout) noexcept
     {
+        uint32_t size;
+        if (const void* const data = CarlaPipeClient::_readBinaryFrame(size, timeout))
+        {
+            if (size == sizeof(float))
+            {
+                float value;
+                std::memcpy(&value, data, sizeof(value));
+                return static_cast<double>(value);
+            }
+
+            double value;
+            CARLA_SAFE_ASSERT_UINT2_RETURN(size == sizeof(value), size, sizeof(value), 0.0);
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
         if (const char* const line = CarlaPipeClient::_readlineblock(false, 0, timeout))
-            return std::atof(line);
+            return carla_stringToDouble(line);
 
         return 0.0;
     }
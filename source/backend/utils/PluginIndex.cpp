@@ -0,0 +1,488 @@
+/*
+ * Carla Plugin Host
+ * Copyright (C) 2011-2020 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#include "CarlaUtils.h"
+
+#include "CarlaBackendUtils.hpp"
+#include "CarlaString.hpp"
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace CB = CarlaBackend;
+
+// -------------------------------------------------------------------------------------------------------------------
+// On-disk format, in native byte order:
+//  - header
+//  - 'count' fixed-size records
+//  - string table of 'stringsSize' bytes, every string null-terminated, records refer to strings by offset
+
+static const char     kPluginIndexMagic[8] = { 'C','R','L','P','I','D','X','\0' };
+static const uint32_t kPluginIndexVersion  = 1;
+
+struct PluginIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint32_t stringsSize;
+    uint32_t recordSize;
+};
+
+struct PluginIndexRecord {
+    uint32_t type;
+    uint32_t btype;
+    uint32_t category;
+    uint32_t hints;
+    uint32_t audioIns;
+    uint32_t audioOuts;
+    uint32_t cvIns;
+    uint32_t cvOuts;
+    uint32_t midiIns;
+    uint32_t midiOuts;
+    uint32_t parameterIns;
+    uint32_t parameterOuts;
+    int64_t  uniqueId;
+    uint32_t filename;
+    uint32_t label;
+    uint32_t name;
+    uint32_t maker;
+};
+
+// -------------------------------------------------------------------------------------------------------------------
+
+class PluginIndex
+{
+public:
+    PluginIndex()
+        : fRecords(),
+          fStrings(1, '\0'),
+          fByLabel(),
+          fByUniqueId(),
+          fByName()
+    {
+        carla_zeroStruct(fRetInfo);
+    }
+
+    void clear()
+    {
+        fRecords.clear();
+        fStrings.assign(1, '\0');
+        fByLabel.clear();
+        fByUniqueId.clear();
+        fByName.clear();
+    }
+
+    bool add(const CarlaPluginIndexInfo& info)
+    {
+        CARLA_SAFE_ASSERT_RETURN(info.type != CB::PLUGIN_NONE, false);
+        CARLA_SAFE_ASSERT_RETURN(info.label != nullptr, false);
+
+        PluginIndexRecord record;
+        record.type          = static_cast<uint32_t>(info.type);
+        record.btype         = static_cast<uint32_t>(info.btype);
+        record.category      = static_cast<uint32_t>(info.category);
+        record.hints         = info.hints;
+        record.audioIns      = info.audioIns;
+        record.audioOuts     = info.audioOuts;
+        record.cvIns         = info.cvIns;
+        record.cvOuts        = info.cvOuts;
+        record.midiIns       = info.midiIns;
+        record.midiOuts      = info.midiOuts;
+        record.parameterIns  = info.parameterIns;
+        record.parameterOuts = info.parameterOuts;
+        record.uniqueId      = info.uniqueId;
+        record.filename      = addString(info.filename);
+        record.label         = addString(info.label);
+        record.name          = addString(info.name);
+        record.maker         = addString(info.maker);
+
+        const int existing = findByLabel(info.type, info.label);
+
+        if (existing >= 0)
+        {
+            // replaced entries can change name or unique id, cheaper to rebuild lookups than to patch them
+            fRecords[static_cast<size_t>(existing)] = record;
+            rebuildLookups();
+            return true;
+        }
+
+        fRecords.push_back(record);
+        addLookups(static_cast<uint>(fRecords.size() - 1));
+        return true;
+    }
+
+    bool load(const char* const filename)
+    {
+        std::FILE* const file = std::fopen(filename, "rb");
+        CARLA_SAFE_ASSERT_RETURN(file != nullptr, false);
+
+        std::vector<PluginIndexRecord> records;
+        std::vector<char> strings;
+        bool ok = false;
+
+        PluginIndexHeader header;
+
+        if (std::fread(&header, sizeof(header), 1, file) == 1
+            && std::memcmp(header.magic, kPluginIndexMagic, sizeof(kPluginIndexMagic)) == 0
+            && header.version == kPluginIndexVersion
+            && header.recordSize == sizeof(PluginIndexRecord)
+            && header.stringsSize != 0)
+        {
+            records.resize(header.count);
+            strings.resize(header.stringsSize);
+
+            ok = (header.count == 0 || std::fread(records.data(), sizeof(PluginIndexRecord), header.count, file) == header.count)
+                && std::fread(strings.data(), 1, header.stringsSize, file) == header.stringsSize
+                && strings.back() == '\0';
+        }
+
+        std::fclose(file);
+
+        if (! ok)
+        {
+            carla_stderr("Plugin index '%s' is invalid or from an incompatible version", filename);
+            return false;
+        }
+
+        for (std::vector<PluginIndexRecord>::const_iterator it = records.begin(); it != records.end(); ++it)
+        {
+            const PluginIndexRecord& record(*it);
+
+            CARLA_SAFE_ASSERT_RETURN(record.filename < header.stringsSize, false);
+            CARLA_SAFE_ASSERT_RETURN(record.label < header.stringsSize, false);
+            CARLA_SAFE_ASSERT_RETURN(record.name < header.stringsSize, false);
+            CARLA_SAFE_ASSERT_RETURN(record.maker < header.stringsSize, false);
+        }
+
+        fRecords.swap(records);
+        fStrings.swap(strings);
+        rebuildLookups();
+        return true;
+    }
+
+    bool save(const char* const filename) const
+    {
+        // compact the string table, replaced entries leave unused strings behind
+        std::vector<PluginIndexRecord> records(fRecords);
+        std::vector<char> strings(1, '\0');
+
+        for (std::vector<PluginIndexRecord>::iterator it = records.begin(); it != records.end(); ++it)
+        {
+            PluginIndexRecord& record(*it);
+            record.filename = copyString(strings, record.filename);
+            record.label    = copyString(strings, record.label);
+            record.name     = copyString(strings, record.name);
+            record.maker    = copyString(strings, record.maker);
+        }
+
+        PluginIndexHeader header;
+        carla_zeroStruct(header);
+        std::memcpy(header.magic, kPluginIndexMagic, sizeof(kPluginIndexMagic));
+        header.version     = kPluginIndexVersion;
+        header.count       = static_cast<uint32_t>(records.size());
+        header.stringsSize = static_cast<uint32_t>(strings.size());
+        header.recordSize  = sizeof(PluginIndexRecord);
+
+        std::FILE* const file = std::fopen(filename, "wb");
+        CARLA_SAFE_ASSERT_RETURN(file != nullptr, false);
+
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+               && (records.empty() || std::fwrite(records.data(), sizeof(PluginIndexRecord), records.size(), file) == records.size())
+               && std::fwrite(strings.data(), 1, strings.size(), file) == strings.size();
+
+        if (std::fclose(file) != 0)
+            ok = false;
+
+        return ok;
+    }
+
+    uint count() const noexcept
+    {
+        return static_cast<uint>(fRecords.size());
+    }
+
+    const CarlaPluginIndexInfo* getInfo(const uint index)
+    {
+        CARLA_SAFE_ASSERT_RETURN(index < fRecords.size(), nullptr);
+
+        const PluginIndexRecord& record(fRecords[index]);
+
+        fRetInfo.type          = static_cast<CB::PluginType>(record.type);
+        fRetInfo.btype         = static_cast<CB::BinaryType>(record.btype);
+        fRetInfo.category      = static_cast<CB::PluginCategory>(record.category);
+        fRetInfo.hints         = record.hints;
+        fRetInfo.audioIns      = record.audioIns;
+        fRetInfo.audioOuts     = record.audioOuts;
+        fRetInfo.cvIns         = record.cvIns;
+        fRetInfo.cvOuts        = record.cvOuts;
+        fRetInfo.midiIns       = record.midiIns;
+        fRetInfo.midiOuts      = record.midiOuts;
+        fRetInfo.parameterIns  = record.parameterIns;
+        fRetInfo.parameterOuts = record.parameterOuts;
+        fRetInfo.uniqueId      = record.uniqueId;
+        fRetInfo.filename      = getString(record.filename);
+        fRetInfo.label         = getString(record.label);
+        fRetInfo.name          = getString(record.name);
+        fRetInfo.maker         = getString(record.maker);
+        return &fRetInfo;
+    }
+
+    int findByLabel(const CB::PluginType ptype, const char* const label) const
+    {
+        CARLA_SAFE_ASSERT_RETURN(label != nullptr, -1);
+
+        const LabelMap::const_iterator it = fByLabel.find(getLabelKey(ptype, label));
+        return it != fByLabel.end() ? static_cast<int>(it->second) : -1;
+    }
+
+    int findByUniqueId(const CB::PluginType ptype, const int64_t uniqueId) const
+    {
+        typedef std::pair<UniqueIdMap::const_iterator, UniqueIdMap::const_iterator> Range;
+
+        const Range range = fByUniqueId.equal_range(uniqueId);
+
+        for (UniqueIdMap::const_iterator it = range.first; it != range.second; ++it)
+        {
+            if (fRecords[it->second].type == static_cast<uint32_t>(ptype))
+                return static_cast<int>(it->second);
+        }
+
+        return -1;
+    }
+
+    int findByName(const char* const name) const
+    {
+        CARLA_SAFE_ASSERT_RETURN(name != nullptr, -1);
+
+        const LabelMap::const_iterator it = fByName.find(name);
+        return it != fByName.end() ? static_cast<int>(it->second) : -1;
+    }
+
+private:
+    typedef std::unordered_map<std::string, uint> LabelMap;
+    typedef std::unordered_multimap<int64_t, uint> UniqueIdMap;
+
+    std::vector<PluginIndexRecord> fRecords;
+    std::vector<char> fStrings;
+
+    LabelMap    fByLabel;
+    UniqueIdMap fByUniqueId;
+    LabelMap    fByName;
+
+    CarlaPluginIndexInfo fRetInfo;
+
+    static std::string getLabelKey(const CB::PluginType ptype, const char* const label)
+    {
+        std::string key(label);
+        key += '\n';
+        key += static_cast<char>('0' + static_cast<int>(ptype));
+        return key;
+    }
+
+    static uint32_t copyString(std::vector<char>& strings, const char* const string)
+    {
+        if (string == nullptr || string[0] == '\0')
+            return 0;
+
+        const uint32_t offset = static_cast<uint32_t>(strings.size());
+        strings.insert(strings.end(), string, string + std::strlen(string) + 1);
+        return offset;
+    }
+
+    uint32_t copyString(std::vector<char>& strings, const uint32_t offset) const
+    {
+        return copyString(strings, getString(offset));
+    }
+
+    uint32_t addString(const char* const string)
+    {
+        return copyString(fStrings, string);
+    }
+
+    const char* getString(const uint32_t offset) const noexcept
+    {
+        return &fStrings[offset];
+    }
+
+    void addLookups(const uint index)
+    {
+        const PluginIndexRecord& record(fRecords[index]);
+        const CB::PluginType ptype = static_cast<CB::PluginType>(record.type);
+
+        if (record.label != 0)
+            fByLabel[getLabelKey(ptype, getString(record.label))] = index;
+
+        if (record.uniqueId != 0 && findByUniqueId(ptype, record.uniqueId) < 0)
+            fByUniqueId.insert(UniqueIdMap::value_type(record.uniqueId, index));
+
+        // keep the first plugin for duplicated names
+        if (record.name != 0)
+            fByName.insert(LabelMap::value_type(getString(record.name), index));
+    }
+
+    void rebuildLookups()
+    {
+        fByLabel.clear();
+        fByUniqueId.clear();
+        fByName.clear();
+
+        for (uint i=0, count=static_cast<uint>(fRecords.size()); i < count; ++i)
+            addLookups(i);
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(PluginIndex)
+};
+
+static PluginIndex& getPluginIndex()
+{
+    static PluginIndex index;
+    return index;
+}
+
+// -------------------------------------------------------------------------------------------------------------------
+
+void carla_plugin_index_clear()
+{
+    carla_debug("carla_plugin_index_clear()");
+
+    getPluginIndex().clear();
+}
+
+bool carla_plugin_index_add(const CarlaPluginIndexInfo* info)
+{
+    CARLA_SAFE_ASSERT_RETURN(info != nullptr, false);
+    carla_debug("carla_plugin_index_add(%p)", info);
+
+    return getPluginIndex().add(*info);
+}
+
+uint carla_plugin_index_add_cached(CB::PluginType ptype, const char* pluginPath)
+{
+    carla_debug("carla_plugin_index_add_cached(%i:%s, %s)", ptype, CB::PluginType2Str(ptype), pluginPath);
+
+    PluginIndex& index(getPluginIndex());
+    const uint count = carla_get_cached_plugin_count(ptype, pluginPath);
+    uint added = 0;
+
+    for (uint i=0; i < count; ++i)
+    {
+        const CarlaCachedPluginInfo* const cinfo = carla_get_cached_plugin_info(ptype, i);
+
+        if (cinfo == nullptr || ! cinfo->valid)
+            continue;
+
+        CarlaPluginIndexInfo info;
+        info.type          = ptype;
+        info.btype         = CB::BINARY_NATIVE;
+        info.category      = cinfo->category;
+        info.hints         = cinfo->hints;
+        info.audioIns      = cinfo->audioIns;
+        info.audioOuts     = cinfo->audioOuts;
+        info.cvIns         = cinfo->cvIns;
+        info.cvOuts        = cinfo->cvOuts;
+        info.midiIns       = cinfo->midiIns;
+        info.midiOuts      = cinfo->midiOuts;
+        info.parameterIns  = cinfo->parameterIns;
+        info.parameterOuts = cinfo->parameterOuts;
+        info.uniqueId      = 0;
+        info.filename      = "";
+        info.label         = cinfo->label;
+        info.name          = cinfo->name;
+        info.maker         = cinfo->maker;
+
+        // same conventions as the frontend plugin database
+        CarlaString bundle;
+
+        switch (ptype)
+        {
+        case CB::PLUGIN_LV2:
+            // cached LV2 labels are "bundle/URI"
+            if (const char* const sep = std::strchr(cinfo->label, CARLA_OS_SEP))
+            {
+                bundle = cinfo->label;
+                bundle.truncate(static_cast<std::size_t>(sep - cinfo->label));
+                info.filename = bundle.buffer();
+                info.label    = sep + 1;
+            }
+            break;
+        case CB::PLUGIN_SFZ:
+            info.filename = cinfo->label;
+            info.label    = cinfo->name;
+            break;
+        default:
+            break;
+        }
+
+        if (index.add(info))
+            ++added;
+    }
+
+    return added;
+}
+
+bool carla_plugin_index_load(const char* filename)
+{
+    CARLA_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', false);
+    carla_debug("carla_plugin_index_load(\"%s\")", filename);
+
+    return getPluginIndex().load(filename);
+}
+
+bool carla_plugin_index_save(const char* filename)
+{
+    CARLA_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', false);
+    carla_debug("carla_plugin_index_save(\"%s\")", filename);
+
+    return getPluginIndex().save(filename);
+}
+
+uint carla_plugin_index_count()
+{
+    return getPluginIndex().count();
+}
+
+const CarlaPluginIndexInfo* carla_plugin_index_get_info(uint index)
+{
+    carla_debug("carla_plugin_index_get_info(%i)", index);
+
+    return getPluginIndex().getInfo(index);
+}
+
+int carla_plugin_index_find_by_label(CB::PluginType ptype, const char* label)
+{
+    carla_debug("carla_plugin_index_find_by_label(%i:%s, \"%s\")", ptype, CB::PluginType2Str(ptype), label);
+
+    return getPluginIndex().findByLabel(ptype, label);
+}
+
+int carla_plugin_index_find_by_unique_id(CB::PluginType ptype, int64_t uniqueId)
+{
+    carla_debug("carla_plugin_index_find_by_unique_id(%i:%s, " P_INT64 ")", ptype, CB::PluginType2Str(ptype), uniqueId);
+
+    return getPluginIndex().findByUniqueId(ptype, uniqueId);
+}
+
+int carla_plugin_index_find_by_name(const char* name)
+{
+    carla_debug("carla_plugin_index_find_by_name(\"%s\")", name);
+
+    return getPluginIndex().findByName(name);
+}
+
+// -------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,499 @@
+/*
+ * Carla headless session benchmark
+ * Copyright (C) 2020 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#include "CarlaHost.h"
+#include "CarlaUtils.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+
+CARLA_BACKEND_USE_NAMESPACE
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+struct BenchOptions {
+    const char* projectFile;
+    const char* cyclesFile;
+    double duration;
+    uint bufferSize;
+    uint sampleRate;
+    bool patchbay;
+    bool fast;
+    bool randomAutomation;
+    bool randomMidi;
+    uint32_t seed;
+
+    BenchOptions() noexcept
+        : projectFile(nullptr),
+          cyclesFile(nullptr),
+          duration(60.0),
+          bufferSize(256),
+          sampleRate(48000),
+          patchbay(false),
+          fast(false),
+          randomAutomation(false),
+          randomMidi(false),
+          seed(1) {}
+};
+
+static void printUsage(const char* const name)
+{
+    std::printf("Usage: %s [options] project.carxp\n"
+                "Load a Carla project, run it on the dummy driver and report timing statistics.\n"
+                "\n"
+                "  -d, --duration SECONDS      how long to run, default 60\n"
+                "  -b, --buffer-size FRAMES    default 256\n"
+                "  -r, --sample-rate HZ        default 48000\n"
+                "  -p, --patchbay              use patchbay mode instead of rack\n"
+                "  -f, --fast                  run cycles back to back instead of in realtime\n"
+                "  -a, --random-automation     randomly change plugin input parameters\n"
+                "  -m, --random-midi           send random notes to plugins with MIDI input\n"
+                "  -s, --seed NUMBER           seed for the random changes, default 1\n"
+                "  -c, --cycles FILE           write the timing of every cycle to FILE, as CSV\n"
+                "  -h, --help                  show this help\n", name);
+}
+
+static bool parseArgs(BenchOptions& options, const int argc, char* argv[])
+{
+    for (int i=1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+        const char* const next = i+1 < argc ? argv[i+1] : nullptr;
+
+        if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0)
+            return false;
+
+        if (std::strcmp(arg, "-p") == 0 || std::strcmp(arg, "--patchbay") == 0)
+            options.patchbay = true;
+        else if (std::strcmp(arg, "-f") == 0 || std::strcmp(arg, "--fast") == 0)
+            options.fast = true;
+        else if (std::strcmp(arg, "-a") == 0 || std::strcmp(arg, "--random-automation") == 0)
+            options.randomAutomation = true;
+        else if (std::strcmp(arg, "-m") == 0 || std::strcmp(arg, "--random-midi") == 0)
+            options.randomMidi = true;
+        else if (arg[0] == '-' && next == nullptr)
+            return false;
+        else if (std::strcmp(arg, "-d") == 0 || std::strcmp(arg, "--duration") == 0)
+            options.duration = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "-b") == 0 || std::strcmp(arg, "--buffer-size") == 0)
+            options.bufferSize = static_cast<uint>(std::atoi(argv[++i]));
+        else if (std::strcmp(arg, "-r") == 0 || std::strcmp(arg, "--sample-rate") == 0)
+            options.sampleRate = static_cast<uint>(std::atoi(argv[++i]));
+        else if (std::strcmp(arg, "-s") == 0 || std::strcmp(arg, "--seed") == 0)
+            options.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(arg, "-c") == 0 || std::strcmp(arg, "--cycles") == 0)
+            options.cyclesFile = argv[++i];
+        else if (arg[0] == '-' || options.projectFile != nullptr)
+            return false;
+        else
+            options.projectFile = arg;
+    }
+
+    return options.projectFile != nullptr
+        && options.duration > 0.0
+        && options.bufferSize > 0
+        && options.sampleRate > 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static int64_t getTimeInMicroseconds() noexcept
+{
+#if defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN)
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+
+    return (tv.tv_sec * 1000000) + tv.tv_usec;
+#else
+    // must match the clock used by the engine cycle log
+    struct timespec ts;
+# ifdef CLOCK_MONOTONIC_RAW
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+# else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+# endif
+
+    return (ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+#endif
+}
+
+static int64_t getCpuTimeInMicroseconds() noexcept
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+         + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+// small and deterministic, so runs with the same seed send the same changes
+struct Random {
+    uint32_t state;
+
+    Random(const uint32_t seed) noexcept
+        : state(seed != 0 ? seed : 1) {}
+
+    uint32_t next() noexcept
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    uint32_t next(const uint32_t max) noexcept
+    {
+        return max != 0 ? next() % max : 0;
+    }
+
+    float nextFloat() noexcept
+    {
+        return static_cast<float>(next() >> 8) / static_cast<float>(1 << 24);
+    }
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Cycle statistics, fed from the engine cycle history
+
+class CycleStats
+{
+public:
+    CycleStats(const uint32_t cycleUsecs, FILE* const csv)
+        : fCycleUsecs(cycleUsecs),
+          fCsv(csv),
+          fLastStartTime(0),
+          fCount(0),
+          fOverBudget(0),
+          fTotalUsecs(0),
+          fProcessUsecs(0),
+          fMaxUsecs(0),
+          fHistogram(cycleUsecs * 4 + 1, 0)
+    {
+        if (fCsv != nullptr)
+            std::fprintf(fCsv, "start_us,frames,total_us,prepare_us,process_us,post_us,xruns\n");
+    }
+
+    void update(const CarlaHostHandle handle, const int64_t sinceTime)
+    {
+        const CarlaEngineCycleHistory* const history = carla_get_engine_cycle_history(handle, 8192);
+        CARLA_SAFE_ASSERT_RETURN(history != nullptr,);
+
+        for (uint i=0; i < history->count; ++i)
+        {
+            const CarlaEngineCycleInfo& cycle(history->cycles[i]);
+
+            if (cycle.startTime <= fLastStartTime || cycle.startTime < sinceTime)
+                continue;
+
+            fLastStartTime = cycle.startTime;
+
+            ++fCount;
+            fTotalUsecs   += cycle.totalUsecs;
+            fProcessUsecs += cycle.processUsecs;
+
+            if (cycle.totalUsecs > fMaxUsecs)
+                fMaxUsecs = cycle.totalUsecs;
+            if (cycle.totalUsecs > fCycleUsecs)
+                ++fOverBudget;
+
+            ++fHistogram[std::min<std::size_t>(cycle.totalUsecs, fHistogram.size() - 1)];
+
+            if (fCsv != nullptr)
+                std::fprintf(fCsv, P_INT64 ",%u,%u,%u,%u,%u,%u\n",
+                             cycle.startTime, cycle.frames, cycle.totalUsecs,
+                             cycle.prepareUsecs, cycle.processUsecs, cycle.postUsecs, cycle.xruns);
+        }
+    }
+
+    void print() const
+    {
+        if (fCount == 0)
+        {
+            std::printf("Cycles: none recorded\n");
+            return;
+        }
+
+        const double avg = static_cast<double>(fTotalUsecs) / static_cast<double>(fCount);
+
+        std::printf("Cycles: " P_UINT64 " analysed, budget %uus\n", fCount, fCycleUsecs);
+        std::printf("  avg %.1fus (%.1f%%), process avg %.1fus\n",
+                    avg, avg * 100.0 / fCycleUsecs,
+                    static_cast<double>(fProcessUsecs) / static_cast<double>(fCount));
+        std::printf("  p50 %uus, p99 %uus, p99.9 %uus, max %uus\n",
+                    getPercentile(0.5), getPercentile(0.99), getPercentile(0.999), fMaxUsecs);
+        std::printf("  over budget: " P_UINT64 " (%.3f%%)\n",
+                    fOverBudget, static_cast<double>(fOverBudget) * 100.0 / static_cast<double>(fCount));
+    }
+
+private:
+    const uint32_t fCycleUsecs;
+    FILE* const fCsv;
+
+    int64_t fLastStartTime;
+    uint64_t fCount, fOverBudget;
+    uint64_t fTotalUsecs, fProcessUsecs;
+    uint32_t fMaxUsecs;
+
+    // 1us resolution up to 4 times the budget, last entry holds everything above that
+    std::vector<uint64_t> fHistogram;
+
+    uint32_t getPercentile(const double percentile) const
+    {
+        const uint64_t target = static_cast<uint64_t>(static_cast<double>(fCount) * percentile);
+        uint64_t accum = 0;
+
+        for (std::size_t i=0; i < fHistogram.size(); ++i)
+        {
+            accum += fHistogram[i];
+
+            if (accum > target)
+                return i + 1 < fHistogram.size() ? static_cast<uint32_t>(i) : fMaxUsecs;
+        }
+
+        return fMaxUsecs;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(CycleStats)
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Random input
+
+static void sendRandomAutomation(const CarlaHostHandle handle, Random& random)
+{
+    const uint32_t pluginCount = carla_get_current_plugin_count(handle);
+
+    if (pluginCount == 0)
+        return;
+
+    const uint pluginId = random.next(pluginCount);
+    const uint32_t paramCount = carla_get_parameter_count(handle, pluginId);
+
+    if (paramCount == 0)
+        return;
+
+    const uint32_t paramId = random.next(paramCount);
+
+    const ParameterData* const paramData = carla_get_parameter_data(handle, pluginId, paramId);
+    CARLA_SAFE_ASSERT_RETURN(paramData != nullptr,);
+
+    if (paramData->type != PARAMETER_INPUT || (paramData->hints & PARAMETER_IS_ENABLED) == 0)
+        return;
+    if ((paramData->hints & PARAMETER_IS_AUTOMABLE) == 0)
+        return;
+
+    const ParameterRanges* const paramRanges = carla_get_parameter_ranges(handle, pluginId, paramId);
+    CARLA_SAFE_ASSERT_RETURN(paramRanges != nullptr,);
+
+    float value = paramRanges->getUnnormalizedValue(random.nextFloat());
+
+    if (paramData->hints & PARAMETER_IS_BOOLEAN)
+        value = random.next(2) != 0 ? paramRanges->max : paramRanges->min;
+    else if (paramData->hints & PARAMETER_IS_INTEGER)
+        value = static_cast<float>(static_cast<int>(value + 0.5f));
+
+    carla_set_parameter_value(handle, pluginId, paramId, value);
+}
+
+static void sendRandomNotes(const CarlaHostHandle handle, Random& random, std::vector<uint8_t>& activeNotes)
+{
+    const uint32_t pluginCount = carla_get_current_plugin_count(handle);
+
+    activeNotes.resize(pluginCount, 0);
+
+    for (uint i=0; i < pluginCount; ++i)
+    {
+        const CarlaPortCountInfo* const midiCount = carla_get_midi_port_count_info(handle, i);
+
+        if (midiCount == nullptr || midiCount->ins == 0)
+            continue;
+
+        // note-off for the previous note, then maybe start a new one
+        if (activeNotes[i] != 0)
+        {
+            carla_send_midi_note(handle, i, 0, activeNotes[i], 0);
+            activeNotes[i] = 0;
+        }
+
+        if (random.next(2) == 0)
+            continue;
+
+        activeNotes[i] = static_cast<uint8_t>(36 + random.next(60));
+        carla_send_midi_note(handle, i, 0, activeNotes[i], static_cast<uint8_t>(40 + random.next(87)));
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void printPluginStats(const CarlaHostHandle handle, const uint32_t cycleUsecs)
+{
+    const uint32_t pluginCount = carla_get_current_plugin_count(handle);
+
+    std::printf("Plugins:\n");
+    std::printf("  %-32s %10s %9s %9s %9s %9s %8s\n",
+                "name", "calls", "min(us)", "avg(us)", "p99(us)", "max(us)", "avg(%)");
+
+    for (uint i=0; i < pluginCount; ++i)
+    {
+        const CarlaPluginInfo* const info = carla_get_plugin_info(handle, i);
+        const CarlaPluginProcessTimeInfo* const timeInfo = carla_get_plugin_process_time_info(handle, i);
+        CARLA_SAFE_ASSERT_CONTINUE(info != nullptr && timeInfo != nullptr);
+
+        std::printf("  %-32.32s %10llu %9.1f %9.1f %9.1f %9.1f %8.2f\n",
+                    info->name, static_cast<unsigned long long>(timeInfo->count),
+                    timeInfo->minUsecs, timeInfo->avgUsecs, timeInfo->p99Usecs, timeInfo->maxUsecs,
+                    timeInfo->avgUsecs * 100.0 / cycleUsecs);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+
+    if (! parseArgs(options, argc, argv))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    FILE* csv = nullptr;
+
+    if (options.cyclesFile != nullptr)
+    {
+        csv = std::fopen(options.cyclesFile, "w");
+
+        if (csv == nullptr)
+        {
+            std::fprintf(stderr, "Failed to open '%s' for writing\n", options.cyclesFile);
+            return 1;
+        }
+    }
+
+    if (options.fast)
+        carla_setenv("CARLA_DUMMY_BENCHMARK", "1");
+
+    const CarlaHostHandle handle = carla_standalone_host_init();
+    CARLA_SAFE_ASSERT_RETURN(handle != nullptr, 1);
+
+    carla_set_engine_option(handle, ENGINE_OPTION_PROCESS_MODE,
+                            options.patchbay ? ENGINE_PROCESS_MODE_PATCHBAY : ENGINE_PROCESS_MODE_CONTINUOUS_RACK,
+                            nullptr);
+    carla_set_engine_option(handle, ENGINE_OPTION_AUDIO_BUFFER_SIZE, static_cast<int>(options.bufferSize), nullptr);
+    carla_set_engine_option(handle, ENGINE_OPTION_AUDIO_SAMPLE_RATE, static_cast<int>(options.sampleRate), nullptr);
+
+    if (! carla_engine_init(handle, "Dummy", "carla-bench"))
+    {
+        std::fprintf(stderr, "Failed to init engine: %s\n", carla_get_last_error(handle));
+        return 1;
+    }
+
+    int64_t loadTime = getTimeInMicroseconds();
+
+    if (! carla_load_project(handle, options.projectFile))
+    {
+        std::fprintf(stderr, "Failed to load project: %s\n", carla_get_last_error(handle));
+        carla_engine_close(handle);
+        return 1;
+    }
+
+    loadTime = getTimeInMicroseconds() - loadTime;
+
+    const uint32_t pluginCount = carla_get_current_plugin_count(handle);
+    const uint32_t cycleUsecs  = static_cast<uint32_t>(1000000.0 * options.bufferSize / options.sampleRate + 0.5);
+
+    std::printf("Project: %s\n", options.projectFile);
+    std::printf("  %u plugins, loaded in %.1fms\n", pluginCount, static_cast<double>(loadTime) / 1000.0);
+    std::printf("  %s mode, %u frames @ %uHz, %s for %.1fs\n",
+                options.patchbay ? "patchbay" : "rack", options.bufferSize, options.sampleRate,
+                options.fast ? "as fast as possible" : "realtime", options.duration);
+
+    // drop whatever happened during loading
+    for (uint i=0; i < pluginCount; ++i)
+        carla_reset_plugin_process_time_info(handle, i);
+
+    const uint32_t startXruns = carla_get_runtime_engine_info(handle)->xruns;
+
+    CycleStats cycleStats(cycleUsecs, csv);
+    Random random(options.seed);
+    std::vector<uint8_t> activeNotes;
+
+    const int64_t startTime    = getTimeInMicroseconds();
+    const int64_t startCpuTime = getCpuTimeInMicroseconds();
+    const int64_t endTime      = startTime + static_cast<int64_t>(options.duration * 1000000.0);
+
+    for (int64_t now = startTime, nextStats = startTime, nextInput = startTime; now < endTime;
+         now = getTimeInMicroseconds())
+    {
+        carla_engine_idle(handle);
+
+        if (now >= nextInput)
+        {
+            if (options.randomAutomation)
+                sendRandomAutomation(handle, random);
+            if (options.randomMidi)
+                sendRandomNotes(handle, random, activeNotes);
+
+            nextInput = now + 50000;
+        }
+
+        // the history only holds a few seconds of cycles, so poll it often
+        if (now >= nextStats)
+        {
+            cycleStats.update(handle, startTime);
+            nextStats = now + 250000;
+        }
+
+        carla_msleep(10);
+    }
+
+    cycleStats.update(handle, startTime);
+
+    const int64_t elapsed = getTimeInMicroseconds() - startTime;
+    const int64_t cpuTime = getCpuTimeInMicroseconds() - startCpuTime;
+    const CarlaRuntimeEngineInfo* const engineInfo = carla_get_runtime_engine_info(handle);
+
+    std::printf("Engine:\n");
+    std::printf("  xruns: %u, final DSP load %.1f%%, process CPU usage %.1f%%\n",
+                engineInfo->xruns - startXruns, engineInfo->load,
+                static_cast<double>(cpuTime) * 100.0 / static_cast<double>(elapsed));
+
+    cycleStats.print();
+    printPluginStats(handle, cycleUsecs);
+
+    for (uint i=0; i < activeNotes.size(); ++i)
+    {
+        if (activeNotes[i] != 0)
+            carla_send_midi_note(handle, i, 0, activeNotes[i], 0);
+    }
+
+    carla_engine_close(handle);
+
+    if (csv != nullptr)
+        std::fclose(csv);
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
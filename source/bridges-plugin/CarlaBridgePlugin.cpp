@@ -405,6 +405,11 @@ int main(int argc, char* argv[])
     if (label[0] == '\0' || std::strcmp(label, "(none)") == 0)
         label = nullptr;
 
+    // pooled bridges are started before knowing which plugin to load, the engine is told about it later.
+    // bridges hosting a group of plugins never load one themselves, each plugin gets an engine of its own.
+    const bool pooled = std::getenv("ENGINE_BRIDGE_SHM_IDS") != nullptr && (std::getenv("ENGINE_BRIDGE_POOLED") != nullptr ||
+                                                                             std::getenv("ENGINE_BRIDGE_GROUP") != nullptr);
+
     // ---------------------------------------------------------------------
     // Check binary type
 
@@ -424,7 +429,7 @@ int main(int argc, char* argv[])
 
     CarlaBackend::PluginType itype(CarlaBackend::getPluginTypeFromString(stype));
 
-    if (itype == CarlaBackend::PLUGIN_NONE)
+    if (itype == CarlaBackend::PLUGIN_NONE && ! pooled)
     {
         carla_stderr("Invalid plugin type '%s'", stype);
         return 1;
@@ -637,9 +642,9 @@ int main(int argc, char* argv[])
         // -----------------------------------------------------------------
         // Init plugin
 
-        if (carla_add_plugin(gHostHandle,
-                             btype, itype,
-                             file.getFullPathName().toRawUTF8(), name, label, uniqueId, extraStuff, 0x0))
+        if (pooled || carla_add_plugin(gHostHandle,
+                                       btype, itype,
+                                       file.getFullPathName().toRawUTF8(), name, label, uniqueId, extraStuff, 0x0))
         {
             ret = 0;
 
@@ -137,6 +137,9 @@ public:
             fPorts.paramsLast[i] = fPlugin->getParameterValue(i);
             fPorts.paramsOut [i] = fPlugin->isParameterOutput(i);
         }
+
+        if (fPorts.numParams > 0)
+            fPorts.initParamsIn();
     }
 
     ~CarlaEngineSingleLV2()
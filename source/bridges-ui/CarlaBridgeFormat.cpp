@@ -124,14 +124,25 @@ bool CarlaBridgeFormat::msgReceived(const char* const msg) noexcept
     if (std::strcmp(msg, "atom") == 0)
     {
         uint32_t index, atomTotalSize, base64Size;
+        const void* atomData;
         const char* base64atom;
 
         CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(index), true);
-        CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(atomTotalSize), true);
-        CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(base64Size), true);
-        CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(base64atom, false, base64Size), true);
 
-        carla_getChunkFromBase64String_impl(fBase64ReservedChunk, base64atom);
+        if (readNextBinaryFrame(atomData, atomTotalSize))
+        {
+            // copy, frame data is not aligned
+            const uint8_t* const atomBytes((const uint8_t*)atomData);
+            fBase64ReservedChunk.assign(atomBytes, atomBytes + atomTotalSize);
+        }
+        else
+        {
+            CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(atomTotalSize), true);
+            CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(base64Size), true);
+            CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(base64atom, false, base64Size), true);
+
+            carla_getChunkFromBase64String_impl(fBase64ReservedChunk, base64atom);
+        }
         CARLA_SAFE_ASSERT_UINT2_RETURN(fBase64ReservedChunk.size() >= sizeof(LV2_Atom),
                                        fBase64ReservedChunk.size(), sizeof(LV2_Atom), true);
 
@@ -295,12 +306,20 @@ bool CarlaBridgeFormat::msgReceived(const char* const msg) noexcept
 // ---------------------------------------------------------------------
 
 bool CarlaBridgeFormat::init(const int argc, const char* argv[])
+{
+    return initPipe(argc, argv) && initToolkit(argc, argv);
+}
+
+bool CarlaBridgeFormat::initPipe(const int argc, const char* argv[])
 {
     CARLA_SAFE_ASSERT_RETURN(fToolkit != nullptr, false);
 
-    if (argc == 7)
+    // pipes are already open for UIs hosted in a shared process
+    const bool sharedPipes = isPipeRunning();
+
+    if (sharedPipes || argc == 7)
     {
-        if (! initPipeClient(argv))
+        if (! sharedPipes && ! initPipeClient(argv))
             return false;
 
         fLastMsgTimer = 0;
@@ -321,9 +340,16 @@ bool CarlaBridgeFormat::init(const int argc, const char* argv[])
         }
     }
 
+    return true;
+}
+
+bool CarlaBridgeFormat::initToolkit(const int argc, const char* argv[])
+{
+    CARLA_SAFE_ASSERT_RETURN(fToolkit != nullptr, false);
+
     if (! fToolkit->init(argc, argv))
     {
-        if (argc == 7)
+        if (isPipeRunning())
             closePipeClient();
         return false;
     }
@@ -339,6 +365,30 @@ void CarlaBridgeFormat::exec(const bool showUI)
     fToolkit->exec(showUI);
 }
 
+void CarlaBridgeFormat::startShared(const bool showUI)
+{
+    CARLA_SAFE_ASSERT_RETURN(fToolkit != nullptr,);
+
+    fToolkit->start(showUI);
+}
+
+bool CarlaBridgeFormat::idleShared()
+{
+    if (fToolkit == nullptr || ! isPipeRunning())
+        return false;
+
+    idlePipe();
+
+    // toolkit is gone after a quit message
+    if (fToolkit == nullptr)
+        return false;
+
+    idleUI();
+    fToolkit->idle();
+
+    return ! fToolkit->isClosed();
+}
+
 // ---------------------------------------------------------------------
 
 CARLA_BRIDGE_UI_END_NAMESPACE
@@ -84,6 +84,20 @@ protected:
 
     virtual void uiOptionsChanged(const BridgeFormatOptions& opts) = 0;
 
+    // ---------------------------------------------------------------------
+    // the two steps of init(), for formats that need host data before creating the UI
+
+    /*!
+     * Open the pipes to the host if requested and wait for the UI options.
+     * Messages sent by the host before the options are also received here.
+     */
+    bool initPipe(const int argc, const char* argv[]);
+
+    /*!
+     * Initialize the toolkit.
+     */
+    bool initToolkit(const int argc, const char* argv[]);
+
 public:
     // ---------------------------------------------------------------------
     // UI initialization
@@ -92,6 +106,19 @@ public:
     virtual void exec(const bool showUI);
     virtual void idleUI() {}
 
+    /*!
+     * Start the UI without running a main loop, for UIs hosted in a shared process.
+     * The pipes must have been opened with initPipeClient(int, int) before init().
+     * @see CarlaBridgeToolkit::runSharedHost()
+     */
+    void startShared(const bool showUI);
+
+    /*!
+     * Idle a UI started with startShared().
+     * Returns false once the UI has been closed, either by the user or the host.
+     */
+    bool idleShared();
+
     // ---------------------------------------------------------------------
     // UI management
 
@@ -21,6 +21,7 @@
 #include "CarlaLibUtils.hpp"
 #include "CarlaLv2Utils.hpp"
 #include "CarlaMIDI.h"
+#include "CarlaProcessUtils.hpp"
 #include "LinkedList.hpp"
 
 #include "water/files/File.h"
@@ -28,6 +29,11 @@
 #include <string>
 #include <vector>
 
+#ifndef CARLA_OS_WIN
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
 #define URI_CARLA_ATOM_WORKER_IN   "http://kxstudio.sf.net/ns/carla/atomWorkerIn"
 #define URI_CARLA_ATOM_WORKER_RESP "http://kxstudio.sf.net/ns/carla/atomWorkerResp"
 
@@ -404,28 +410,44 @@ public:
         const char* uiURI     = argc > 2 ? argv[2] : nullptr;
 
         // ------------------------------------------------------------------------------------------------------------
-        // load plugin
+        // connect to host, which can send the plugin data
+
+        if (! CarlaBridgeFormat::initPipe(argc, argv))
+            return false;
+
+        if (fRdfDescriptor != nullptr && std::strcmp(fRdfDescriptor->URI, pluginURI) != 0)
+        {
+            carla_stderr("Host sent data for a different plugin, ignoring it");
+            delete fRdfDescriptor;
+            fRdfDescriptor = nullptr;
+        }
+
+        if (fRdfDescriptor == nullptr)
+        {
+            // ----------------------------------------------------------------------------------------------------------
+            // load plugin
 
-        Lv2WorldClass& lv2World(Lv2WorldClass::getInstance());
-        lv2World.initIfNeeded(std::getenv("LV2_PATH"));
+            Lv2WorldClass& lv2World(Lv2WorldClass::getInstance());
+            lv2World.initIfNeeded(std::getenv("LV2_PATH"));
 
 #if 0
-        Lilv::Node bundleNode(lv2World.new_file_uri(nullptr, uiBundle));
-        CARLA_SAFE_ASSERT_RETURN(bundleNode.is_uri(), false);
+            Lilv::Node bundleNode(lv2World.new_file_uri(nullptr, uiBundle));
+            CARLA_SAFE_ASSERT_RETURN(bundleNode.is_uri(), false);
 
-        CarlaString sBundle(bundleNode.as_uri());
+            CarlaString sBundle(bundleNode.as_uri());
 
-        if (! sBundle.endsWith("/"))
-           sBundle += "/";
+            if (! sBundle.endsWith("/"))
+               sBundle += "/";
 
-        lv2World.load_bundle(sBundle);
+            lv2World.load_bundle(sBundle);
 #endif
 
-        // ------------------------------------------------------------------------------------------------------------
-        // get plugin from lv2_rdf (lilv)
+            // ----------------------------------------------------------------------------------------------------------
+            // get plugin from lv2_rdf (lilv)
 
-        fRdfDescriptor = lv2_rdf_new(pluginURI, false);
-        CARLA_SAFE_ASSERT_RETURN(fRdfDescriptor != nullptr, false);
+            fRdfDescriptor = lv2_rdf_new(pluginURI, false);
+            CARLA_SAFE_ASSERT_RETURN(fRdfDescriptor != nullptr, false);
+        }
 
         // ------------------------------------------------------------------------------------------------------------
         // find requested UI
@@ -467,7 +489,7 @@ public:
         // ------------------------------------------------------------------------------------------------------------
         // init UI
 
-        if (! CarlaBridgeFormat::init(argc, argv))
+        if (! CarlaBridgeFormat::initToolkit(argc, argv))
             return false;
 
         // ------------------------------------------------------------------------------------------------------------
@@ -638,9 +660,30 @@ public:
 
     void dspURIDReceived(const LV2_URID urid, const char* const uri) override
     {
-        CARLA_SAFE_ASSERT_RETURN(urid == fCustomURIDs.size(),);
+        CARLA_SAFE_ASSERT_RETURN(urid != kUridNull,);
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0',);
 
+        // the host map is shared with other plugins, so URIDs may be resent or skip some values.
+        // the host chooses all URIDs, a different URI for a known one means something is very wrong.
+        if (urid < fCustomURIDs.size())
+        {
+            if (fCustomURIDs[urid] == uri)
+                return;
+
+            if (fCustomURIDs[urid] != "urn:null")
+            {
+                carla_stderr2("CarlaLv2Client :: host sent URI '%s' for URID %u, which is already '%s', ignored",
+                              uri, urid, fCustomURIDs[urid].c_str());
+                return;
+            }
+
+            fCustomURIDs[urid] = uri;
+            return;
+        }
+
+        if (urid > fCustomURIDs.size())
+            fCustomURIDs.resize(urid, std::string("urn:null"));
+
         fCustomURIDs.push_back(uri);
     }
 
@@ -732,14 +775,35 @@ public:
 
         CARLA_SAFE_ASSERT(urid == uriCount);
 
-        fCustomURIDs.push_back(uri);
-
+        // the host chooses new URIDs, so that atoms mean the same on both sides
         if (isPipeRunning())
-            writeLv2UridMessage(urid, uri);
+            return requestCustomURID(s_uri);
 
+        fCustomURIDs.push_back(uri);
         return urid;
     }
 
+    // ask the host for the URID of a new URI, handling host messages until it arrives
+    LV2_URID requestCustomURID(const std::string& uri)
+    {
+        writeLv2UridMessage(kUridNull, uri.c_str());
+
+        for (int i = 0; i < 200 && isPipeRunning(); ++i)
+        {
+            idlePipe();
+
+            const std::ptrdiff_t s_pos(std::find(fCustomURIDs.begin(), fCustomURIDs.end(), uri) - fCustomURIDs.begin());
+
+            if (s_pos > 0 && s_pos < static_cast<std::ptrdiff_t>(fCustomURIDs.size()))
+                return static_cast<LV2_URID>(s_pos);
+
+            carla_msleep(10);
+        }
+
+        carla_stderr2("CarlaLv2Client :: host did not send a URID for '%s'", uri.c_str());
+        return kUridNull;
+    }
+
     const char* getCustomURIDString(const LV2_URID urid) const noexcept
     {
         CARLA_SAFE_ASSERT_RETURN(urid != kUridNull, kUnmapFallback);
@@ -914,6 +978,99 @@ public:
 
     // ----------------------------------------------------------------------------------------------------------------
 
+protected:
+    bool msgReceived(const char* const msg) noexcept override
+    {
+        if (std::strcmp(msg, "rdf") == 0)
+        {
+            LV2_RDF_Descriptor* rdfDescriptor = nullptr;
+            bool ok = false;
+
+            try {
+                rdfDescriptor = new LV2_RDF_Descriptor();
+                ok = readRdfDescriptor(rdfDescriptor);
+            } CARLA_SAFE_EXCEPTION("readRdfDescriptor");
+
+            if (ok && fRdfDescriptor == nullptr)
+                fRdfDescriptor = rdfDescriptor;
+            else
+                delete rdfDescriptor;
+
+            return true;
+        }
+
+        return CarlaBridgeFormat::msgReceived(msg);
+    }
+
+    /*
+     * Read the plugin data sent by the host, so the LV2 world does not need to be loaded here.
+     * Only what the bridge uses is sent, with the requested UI as the only one.
+     * Strings are allocated the same way as lv2_rdf_new() does, so the descriptor can be deleted as usual.
+     */
+    bool readRdfDescriptor(LV2_RDF_Descriptor* const desc) const
+    {
+        uint32_t count;
+
+        CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(desc->URI, true), false);
+
+        desc->UIs = new LV2_RDF_UI[1];
+        desc->UICount = 1;
+
+        LV2_RDF_UI& rdfUI(desc->UIs[0]);
+        CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(rdfUI.URI, true), false);
+        CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(rdfUI.Binary, true), false);
+        CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(rdfUI.Bundle, true), false);
+
+        CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(count), false);
+
+        if (count > 0)
+        {
+            rdfUI.Features = new LV2_RDF_Feature[count];
+            rdfUI.FeatureCount = count;
+
+            for (uint32_t i=0; i < count; ++i)
+            {
+                LV2_RDF_Feature& rdfFeature(rdfUI.Features[i]);
+                CARLA_SAFE_ASSERT_RETURN(readNextLineAsBool(rdfFeature.Required), false);
+                CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(rdfFeature.URI, true), false);
+            }
+        }
+
+        CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(count), false);
+
+        if (count > 0)
+        {
+            desc->Ports = new LV2_RDF_Port[count];
+            desc->PortCount = count;
+
+            for (uint32_t i=0; i < count; ++i)
+            {
+                LV2_RDF_Port& rdfPort(desc->Ports[i]);
+                CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(rdfPort.Designation), false);
+                CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(rdfPort.Symbol, true), false);
+            }
+        }
+
+        CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(count), false);
+
+        if (count > 0)
+        {
+            desc->Parameters = new LV2_RDF_Parameter[count];
+            desc->ParameterCount = count;
+
+            for (uint32_t i=0; i < count; ++i)
+            {
+                LV2_RDF_Parameter& rdfParameter(desc->Parameters[i]);
+                CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(rdfParameter.Type), false);
+                CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(rdfParameter.URI, true), false);
+            }
+        }
+
+        return true;
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+
 private:
     LV2UI_Handle fHandle;
     LV2UI_Widget fWidget;
@@ -1383,6 +1540,163 @@ private:
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaLv2Client)
 };
 
+#ifndef CARLA_OS_WIN
+// --------------------------------------------------------------------------------------------------------------------
+// Process hosting the UIs of several plugins, started by the engine with "--shared-ui-host <socket>".
+// Each new UI is requested over the socket, together with the client side of its pipes.
+
+class CarlaLv2SharedUiHost : public CarlaPipeClient
+{
+public:
+    CarlaLv2SharedUiHost(const int socket) noexcept
+        : CarlaPipeClient(),
+          fSocket(socket),
+          fClients() {}
+
+    ~CarlaLv2SharedUiHost() noexcept override
+    {
+        for (LinkedList<CarlaLv2Client*>::Itenerator it = fClients.begin2(); it.valid(); it.next())
+        {
+            CarlaLv2Client* const client(it.getValue(nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(client != nullptr);
+
+            try {
+                delete client;
+            } CARLA_SAFE_EXCEPTION("delete client");
+        }
+
+        fClients.clear();
+
+        ::close(fSocket);
+    }
+
+    static bool idleCallback(void* const ptr)
+    {
+        return ((CarlaLv2SharedUiHost*)ptr)->idle();
+    }
+
+protected:
+    // nothing is expected from the engine, besides the quit request
+    bool msgReceived(const char* const) noexcept override
+    {
+        return true;
+    }
+
+private:
+    const int fSocket;
+    LinkedList<CarlaLv2Client*> fClients;
+
+    bool idle()
+    {
+        idlePipe();
+
+        // the engine is gone or does not need us anymore
+        if (! isPipeRunning())
+            return false;
+
+        for (; receiveRequest();) {}
+
+        for (LinkedList<CarlaLv2Client*>::Itenerator it = fClients.begin2(); it.valid(); it.next())
+        {
+            CarlaLv2Client* const client(it.getValue(nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(client != nullptr);
+
+            if (client->idleShared())
+                continue;
+
+            fClients.remove(it);
+
+            try {
+                delete client;
+            } CARLA_SAFE_EXCEPTION("delete client");
+        }
+
+        return true;
+    }
+
+    bool receiveRequest()
+    {
+        char request[2048];
+        int fds[2];
+        char control[CMSG_SPACE(sizeof(fds))];
+
+        struct iovec iov;
+        iov.iov_base = request;
+        iov.iov_len  = sizeof(request)-1;
+
+        struct msghdr msg;
+        carla_zeroStruct(msg);
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+
+        const ssize_t size = ::recvmsg(fSocket, &msg, MSG_DONTWAIT);
+
+        if (size <= 0)
+            return false;
+
+        const struct cmsghdr* const cmsg(CMSG_FIRSTHDR(&msg));
+
+        if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS
+            || cmsg->cmsg_len != CMSG_LEN(sizeof(fds)))
+        {
+            carla_stderr2("CarlaLv2SharedUiHost: received request without pipes");
+            return true;
+        }
+
+        std::memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+        request[size] = '\0';
+
+        // plugin URI, UI URI and sample rate, each null-terminated
+        const char* const pluginURI = request;
+        const char* const uiURI = pluginURI + std::strlen(pluginURI) + 1;
+        const char* const sampleRateStr = uiURI < request + size ? uiURI + std::strlen(uiURI) + 1 : request + size;
+
+        if (sampleRateStr >= request + size)
+        {
+            carla_stderr2("CarlaLv2SharedUiHost: received invalid request");
+            ::close(fds[0]);
+            ::close(fds[1]);
+            return true;
+        }
+
+        startClient(pluginURI, uiURI, sampleRateStr, fds[0], fds[1]);
+        return true;
+    }
+
+    void startClient(const char* const pluginURI, const char* const uiURI, const char* const sampleRateStr,
+                     const int pipeRecv, const int pipeSend)
+    {
+        gInitialSampleRate = carla_stringToDouble(sampleRateStr);
+
+        CarlaLv2Client* const client(new CarlaLv2Client());
+
+        if (! client->initPipeClient(pipeRecv, pipeSend))
+        {
+            ::close(pipeRecv);
+            ::close(pipeSend);
+            delete client;
+            return;
+        }
+
+        const char* argv[] = { "carla-bridge-lv2", pluginURI, uiURI, nullptr };
+
+        if (! client->init(3, argv))
+        {
+            carla_stderr2("CarlaLv2SharedUiHost: failed to start UI '%s' for plugin '%s'", uiURI, pluginURI);
+            delete client;
+            return;
+        }
+
+        client->startShared(false);
+        fClients.append(client);
+    }
+
+    CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaLv2SharedUiHost)
+};
+#endif
+
 // --------------------------------------------------------------------------------------------------------------------
 
 CARLA_BRIDGE_UI_END_NAMESPACE
@@ -1399,14 +1713,25 @@ int main(int argc, const char* argv[])
         return 1;
     }
 
+#ifndef CARLA_OS_WIN
+    if (argc == 7 && std::strcmp(argv[1], "--shared-ui-host") == 0)
+    {
+        CarlaLv2SharedUiHost host(std::atoi(argv[2]));
+
+        if (! host.initPipeClient(argv))
+            return 1;
+
+        carla_terminateProcessOnParentExit(true);
+        CarlaBridgeToolkit::runSharedHost(CarlaLv2SharedUiHost::idleCallback, &host);
+        return 0;
+    }
+#endif
+
     const bool testingModeOnly = (argc != 7);
 
     // try to get sampleRate value
     if (const char* const sampleRateStr = std::getenv("CARLA_SAMPLE_RATE"))
-    {
-        const CarlaScopedLocale csl;
-        gInitialSampleRate = std::atof(sampleRateStr);
-    }
+        gInitialSampleRate = carla_stringToDouble(sampleRateStr);
 
     // Init LV2 client
     CarlaLv2Client client;
@@ -35,6 +35,12 @@ public:
     virtual void exec(const bool showUI) = 0;
     virtual void quit() = 0;
 
+    // used for UIs running in a shared process, see runSharedHost()
+    virtual void start(const bool showUI) = 0;
+    virtual void idle() {}
+
+    bool isClosed() const noexcept { return fClosed; }
+
     virtual void show() = 0;
     virtual void focus() = 0;
     virtual void hide() = 0;
@@ -47,11 +53,16 @@ public:
 
     static CarlaBridgeToolkit* createNew(CarlaBridgeFormat* const format);
 
+    // run the main loop of a process hosting several UIs, until idleCallback returns false
+    static void runSharedHost(bool (*idleCallback)(void* ptr), void* const ptr);
+
 protected:
     CarlaBridgeFormat* const fPlugin;
+    bool fClosed;
 
     CarlaBridgeToolkit(CarlaBridgeFormat* const format)
-        : fPlugin(format) {}
+        : fPlugin(format),
+          fClosed(false) {}
 
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaBridgeToolkit)
 };
@@ -41,6 +41,7 @@ public:
     CarlaBridgeToolkitGtk(CarlaBridgeFormat* const format)
         : CarlaBridgeToolkit(format),
           fNeedsShow(false),
+          fShared(false),
           fWindow(nullptr),
           fLastX(0),
           fLastY(0),
@@ -78,26 +79,10 @@ public:
         CARLA_SAFE_ASSERT_RETURN(fWindow != nullptr,);
         carla_debug("CarlaBridgeToolkitGtk::exec(%s)", bool2str(showUI));
 
-        const CarlaBridgeFormat::Options& options(fPlugin->getOptions());
-
-        GtkWindow* const gtkWindow(GTK_WINDOW(fWindow));
-        CARLA_SAFE_ASSERT_RETURN(gtkWindow != nullptr,);
-
-        GtkWidget* const widget((GtkWidget*)fPlugin->getWidget());
-        gtk_container_add(GTK_CONTAINER(fWindow), widget);
-
-        gtk_window_set_resizable(gtkWindow, options.isResizable);
-        gtk_window_set_title(gtkWindow, options.windowTitle.buffer());
-
-        if (showUI || fNeedsShow)
-        {
-            show();
-            fNeedsShow = false;
-        }
+        if (! setupWindow(showUI))
+            return;
 
         g_timeout_add(30, gtk_ui_timeout, this);
-        g_signal_connect(fWindow, "destroy", G_CALLBACK(gtk_ui_destroy), this);
-        g_signal_connect(fWindow, "realize", G_CALLBACK(gtk_ui_realize), this);
 
         // First idle
         handleTimeout();
@@ -106,6 +91,25 @@ public:
         gtk_main();
     }
 
+    void start(const bool showUI) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(fPlugin != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(fWindow != nullptr,);
+        carla_debug("CarlaBridgeToolkitGtk::start(%s)", bool2str(showUI));
+
+        fShared = true;
+        setupWindow(showUI);
+    }
+
+    void idle() override
+    {
+        if (fWindow == nullptr)
+            return;
+
+        gtk_window_get_position(GTK_WINDOW(fWindow), &fLastX, &fLastY);
+        gtk_window_get_size(GTK_WINDOW(fWindow), &fLastWidth, &fLastHeight);
+    }
+
     void quit() override
     {
         carla_debug("CarlaBridgeToolkitGtk::quit()");
@@ -115,7 +119,9 @@ public:
             gtk_widget_destroy(fWindow);
             fWindow = nullptr;
 
-            gtk_main_quit_if_needed();
+            // the main loop belongs to the shared host
+            if (! fShared)
+                gtk_main_quit_if_needed();
         }
     }
 
@@ -166,6 +172,7 @@ public:
 
 protected:
     bool fNeedsShow;
+    bool fShared;
     GtkWidget* fWindow;
 
     gint fLastX;
@@ -173,11 +180,37 @@ protected:
     gint fLastWidth;
     gint fLastHeight;
 
+    bool setupWindow(const bool showUI)
+    {
+        const CarlaBridgeFormat::Options& options(fPlugin->getOptions());
+
+        GtkWindow* const gtkWindow(GTK_WINDOW(fWindow));
+        CARLA_SAFE_ASSERT_RETURN(gtkWindow != nullptr, false);
+
+        GtkWidget* const widget((GtkWidget*)fPlugin->getWidget());
+        gtk_container_add(GTK_CONTAINER(fWindow), widget);
+
+        gtk_window_set_resizable(gtkWindow, options.isResizable);
+        gtk_window_set_title(gtkWindow, options.windowTitle.buffer());
+
+        if (showUI || fNeedsShow)
+        {
+            show();
+            fNeedsShow = false;
+        }
+
+        g_signal_connect(fWindow, "destroy", G_CALLBACK(gtk_ui_destroy), this);
+        g_signal_connect(fWindow, "realize", G_CALLBACK(gtk_ui_realize), this);
+
+        return true;
+    }
+
     void handleDestroy()
     {
         carla_debug("CarlaBridgeToolkitGtk::handleDestroy()");
 
         fWindow = nullptr;
+        fClosed = true;
     }
 
     void handleRealize()
@@ -192,11 +225,7 @@ protected:
 
     gboolean handleTimeout()
     {
-        if (fWindow != nullptr)
-        {
-            gtk_window_get_position(GTK_WINDOW(fWindow), &fLastX, &fLastY);
-            gtk_window_get_size(GTK_WINDOW(fWindow), &fLastWidth, &fLastHeight);
-        }
+        idle();
 
         if (fPlugin->isPipeRunning())
             fPlugin->idlePipe();
@@ -265,8 +294,11 @@ private:
     {
         CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
 
-        ((CarlaBridgeToolkitGtk*)data)->handleDestroy();
-        gtk_main_quit_if_needed();
+        CarlaBridgeToolkitGtk* const self((CarlaBridgeToolkitGtk*)data);
+        self->handleDestroy();
+
+        if (! self->fShared)
+            gtk_main_quit_if_needed();
     }
 
     static void gtk_ui_realize(GtkWidget*, gpointer data)
@@ -293,6 +325,34 @@ CarlaBridgeToolkit* CarlaBridgeToolkit::createNew(CarlaBridgeFormat* const forma
     return new CarlaBridgeToolkitGtk(format);
 }
 
+struct SharedHostIdleData {
+    bool (*callback)(void* ptr);
+    void* ptr;
+};
+
+static gboolean gtk_shared_host_timeout(gpointer data)
+{
+    const SharedHostIdleData* const idleData((const SharedHostIdleData*)data);
+
+    if (idleData->callback(idleData->ptr))
+        return true;
+
+    gtk_main_quit();
+    return false;
+}
+
+void CarlaBridgeToolkit::runSharedHost(bool (*idleCallback)(void* ptr), void* const ptr)
+{
+    CARLA_SAFE_ASSERT_RETURN(idleCallback != nullptr,);
+
+    gtk_init(&gargc, &gargv);
+
+    SharedHostIdleData idleData = { idleCallback, ptr };
+    g_timeout_add(30, gtk_shared_host_timeout, &idleData);
+
+    gtk_main();
+}
+
 // -------------------------------------------------------------------------
 
 CARLA_BRIDGE_UI_END_NAMESPACE
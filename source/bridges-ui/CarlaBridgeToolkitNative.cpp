@@ -103,7 +103,7 @@ public:
                 fPlugin->idlePipe();
 
             fPlugin->idleUI();
-            fHostUI->idle();
+            idle();
 #if defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN)
             // MacOS and Win32 have event-loops to run, so minimize sleep time
             carla_msleep(1);
@@ -113,6 +113,24 @@ public:
         }
     }
 
+    void start(const bool showUI) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(fHostUI != nullptr,);
+        carla_debug("CarlaBridgeToolkitNative::start(%s)", bool2str(showUI));
+
+        if (showUI)
+        {
+            fHostUI->show();
+            fHostUI->focus();
+        }
+    }
+
+    void idle() override
+    {
+        if (fHostUI != nullptr)
+            fHostUI->idle();
+    }
+
     void quit() override
     {
         carla_debug("CarlaBridgeToolkitNative::quit()");
@@ -200,6 +218,7 @@ protected:
     void handlePluginUIClosed() override
     {
         fIdling = false;
+        fClosed = true;
     }
 
     void handlePluginUIResized(const uint width, const uint height) override
@@ -223,6 +242,20 @@ CarlaBridgeToolkit* CarlaBridgeToolkit::createNew(CarlaBridgeFormat* const forma
     return new CarlaBridgeToolkitNative(format);
 }
 
+void CarlaBridgeToolkit::runSharedHost(bool (*idleCallback)(void* ptr), void* const ptr)
+{
+    CARLA_SAFE_ASSERT_RETURN(idleCallback != nullptr,);
+
+    for (; runMainLoopOnce() && idleCallback(ptr);)
+    {
+#if defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN)
+        carla_msleep(1);
+#else
+        carla_msleep(33);
+#endif
+    }
+}
+
 // -------------------------------------------------------------------------
 
 CARLA_BRIDGE_UI_END_NAMESPACE
@@ -89,11 +89,14 @@ public:
         CARLA_SAFE_ASSERT_RETURN(fMsgTimer == 0, false);
         carla_debug("CarlaBridgeToolkitQt::init()");
 
-        fApp = new QApplication(qargc, qargv);
+        // UIs in a shared process use the application created by the host
+        if (QApplication::instance() == nullptr)
+            fApp = new QApplication(qargc, qargv);
 
         fWindow = new QMainWindow(nullptr, nullptr);
         fWindow->resize(30, 30);
         fWindow->hide();
+        fWindow->installEventFilter(this);
 
         return true;
     }
@@ -105,41 +108,7 @@ public:
         CARLA_SAFE_ASSERT_RETURN(fWindow != nullptr,);
         carla_debug("CarlaBridgeToolkitQt::exec(%s)", bool2str(showUI));
 
-        const CarlaBridgeFormat::Options& options(fPlugin->getOptions());
-
-        QWidget* const widget((QWidget*)fPlugin->getWidget());
-
-        fWindow->setCentralWidget(widget);
-        fWindow->adjustSize();
-
-        widget->setParent(fWindow);
-        widget->show();
-
-        if (! options.isResizable)
-        {
-            fWindow->setFixedSize(fWindow->width(), fWindow->height());
-#ifdef CARLA_OS_WIN
-            fWindow->setWindowFlags(fWindow->windowFlags() | Qt::MSWindowsFixedSizeDialogHint);
-#endif
-        }
-
-        fWindow->setWindowIcon(QIcon::fromTheme("carla", QIcon(":/scalable/carla.svg")));
-        fWindow->setWindowTitle(options.windowTitle.buffer());
-
-#ifdef USE_CUSTOM_X11_METHODS
-        if (options.transientWindowId != 0)
-        {
-            XSetTransientForHint(QX11Info::display(),
-                                 static_cast< ::Window>(fWindow->winId()),
-                                 static_cast< ::Window>(options.transientWindowId));
-        }
-#endif
-
-        if (showUI || fNeedsShow)
-        {
-            show();
-            fNeedsShow = false;
-        }
+        setupWindow(showUI);
 
         fMsgTimer = startTimer(30);
 
@@ -150,10 +119,18 @@ public:
         fApp->exec();
     }
 
+    void start(const bool showUI) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(fPlugin != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(fWindow != nullptr,);
+        carla_debug("CarlaBridgeToolkitQt::start(%s)", bool2str(showUI));
+
+        setupWindow(showUI);
+    }
+
     void quit() override
     {
         CARLA_SAFE_ASSERT_RETURN(fPlugin != nullptr,);
-        CARLA_SAFE_ASSERT_RETURN(fApp != nullptr,);
         CARLA_SAFE_ASSERT_RETURN(fWindow != nullptr,);
         carla_debug("CarlaBridgeToolkitQt::quit()");
 
@@ -238,6 +215,45 @@ protected:
     int  fMsgTimer;
     bool fNeedsShow;
 
+    void setupWindow(const bool showUI)
+    {
+        const CarlaBridgeFormat::Options& options(fPlugin->getOptions());
+
+        QWidget* const widget((QWidget*)fPlugin->getWidget());
+
+        fWindow->setCentralWidget(widget);
+        fWindow->adjustSize();
+
+        widget->setParent(fWindow);
+        widget->show();
+
+        if (! options.isResizable)
+        {
+            fWindow->setFixedSize(fWindow->width(), fWindow->height());
+#ifdef CARLA_OS_WIN
+            fWindow->setWindowFlags(fWindow->windowFlags() | Qt::MSWindowsFixedSizeDialogHint);
+#endif
+        }
+
+        fWindow->setWindowIcon(QIcon::fromTheme("carla", QIcon(":/scalable/carla.svg")));
+        fWindow->setWindowTitle(options.windowTitle.buffer());
+
+#ifdef USE_CUSTOM_X11_METHODS
+        if (options.transientWindowId != 0)
+        {
+            XSetTransientForHint(QX11Info::display(),
+                                 static_cast< ::Window>(fWindow->winId()),
+                                 static_cast< ::Window>(options.transientWindowId));
+        }
+#endif
+
+        if (showUI || fNeedsShow)
+        {
+            show();
+            fNeedsShow = false;
+        }
+    }
+
     void handleTimeout()
     {
         CARLA_SAFE_ASSERT_RETURN(fPlugin != nullptr,);
@@ -249,6 +265,14 @@ protected:
     }
 
 private:
+    bool eventFilter(QObject* const obj, QEvent* const ev) override
+    {
+        if (obj == fWindow && ev->type() == QEvent::Close)
+            fClosed = true;
+
+        return QObject::eventFilter(obj, ev);
+    }
+
     void timerEvent(QTimerEvent* const ev) override
     {
         if (ev->timerId() == fMsgTimer)
@@ -271,6 +295,46 @@ CarlaBridgeToolkit* CarlaBridgeToolkit::createNew(CarlaBridgeFormat* const forma
 
 // -------------------------------------------------------------------------
 
+class CarlaBridgeToolkitQtSharedHost : public QObject
+{
+public:
+    CarlaBridgeToolkitQtSharedHost(bool (*idleCallback)(void* ptr), void* const ptr)
+        : QObject(nullptr),
+          fIdleCallback(idleCallback),
+          fIdlePtr(ptr),
+          fMsgTimer(startTimer(30)) {}
+
+protected:
+    void timerEvent(QTimerEvent* const ev) override
+    {
+        if (ev->timerId() == fMsgTimer && ! fIdleCallback(fIdlePtr))
+        {
+            killTimer(fMsgTimer);
+            QApplication::quit();
+        }
+
+        QObject::timerEvent(ev);
+    }
+
+private:
+    bool (*const fIdleCallback)(void* ptr);
+    void* const fIdlePtr;
+    const int fMsgTimer;
+};
+
+void CarlaBridgeToolkit::runSharedHost(bool (*idleCallback)(void* ptr), void* const ptr)
+{
+    CARLA_SAFE_ASSERT_RETURN(idleCallback != nullptr,);
+
+    QApplication app(qargc, qargv);
+    app.setQuitOnLastWindowClosed(false);
+
+    CarlaBridgeToolkitQtSharedHost host(idleCallback, ptr);
+    app.exec();
+}
+
+// -------------------------------------------------------------------------
+
 CARLA_BRIDGE_UI_END_NAMESPACE
 
 // -------------------------------------------------------------------------
@@ -55,6 +55,8 @@
 # include "CarlaVstUtils.hpp"
 #endif
 
+#include "CarlaVst3Utils.hpp"
+
 #ifdef CARLA_OS_MAC
 # define Component CocoaComponent
 # define MemoryBlock CocoaMemoryBlock
@@ -75,6 +77,13 @@
 #endif
 
 #include <iostream>
+#include <string>
+
+#if !defined(CARLA_OS_WIN) && !defined(CARLA_OS_MAC)
+# include <cerrno>
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
 
 #include "water/files/File.h"
 
@@ -1380,6 +1389,260 @@ static void do_vst_check(lib_t& libHandle, const char* const filename, const boo
 }
 #endif // ! USING_JUCE_FOR_VST2
 
+// -------------------------------------------------------------------------------------------------------------------
+
+static uint32_t getVst3ChannelCount(Steinberg::Vst::IComponent* const component, const Steinberg::Vst::BusDirection direction)
+{
+    uint32_t channels = 0;
+
+    for (Steinberg::int32 i=0, count = component->getBusCount(Steinberg::Vst::kAudio, direction); i < count; ++i)
+    {
+        Steinberg::Vst::BusInfo info;
+        carla_zeroStruct(info);
+
+        if (component->getBusInfo(Steinberg::Vst::kAudio, direction, i, info) == Steinberg::kResultOk && info.channelCount > 0)
+            channels += static_cast<uint32_t>(info.channelCount);
+    }
+
+    return channels;
+}
+
+static void do_vst3_check(const char* const filename, const bool doInit)
+{
+    using namespace Steinberg;
+
+    static CarlaVst3HostApplication hostApp;
+
+    V3_GetFactoryFunction getFactory = nullptr;
+    V3_ModuleExitFunction moduleExit = nullptr;
+
+#ifdef CARLA_OS_MAC
+    const CFURLRef urlRef = CFURLCreateFromFileSystemRepresentation(0, (const UInt8*)filename, (CFIndex)strlen(filename), true);
+    CARLA_SAFE_ASSERT_RETURN(urlRef != nullptr,);
+
+    const CFBundleRef bundleRef = CFBundleCreate(kCFAllocatorDefault, urlRef);
+    CFRelease(urlRef);
+    CARLA_SAFE_ASSERT_RETURN(bundleRef != nullptr,);
+
+    if (! CFBundleLoadExecutable(bundleRef))
+    {
+        CFRelease(bundleRef);
+        DISCOVERY_OUT("error", "Failed to load VST3 bundle executable");
+        return;
+    }
+
+    if (const V3_ModuleEntryFunction entryFn = (V3_ModuleEntryFunction)CFBundleGetFunctionPointerForName(bundleRef, CFSTR(V3_MODULE_ENTRY_NAME)))
+    {
+        if (! entryFn(bundleRef))
+        {
+            CFBundleUnloadExecutable(bundleRef);
+            CFRelease(bundleRef);
+            DISCOVERY_OUT("error", "VST3 module entry failed");
+            return;
+        }
+
+        moduleExit = (V3_ModuleExitFunction)CFBundleGetFunctionPointerForName(bundleRef, CFSTR(V3_MODULE_EXIT_NAME));
+    }
+
+    getFactory = (V3_GetFactoryFunction)CFBundleGetFunctionPointerForName(bundleRef, CFSTR("GetPluginFactory"));
+#else
+    const water::String binaryPath(getVst3BinaryFile(filename).getFullPathName());
+    const lib_t libHandle = lib_open(binaryPath.toRawUTF8());
+
+    if (libHandle == nullptr)
+    {
+        print_lib_error(binaryPath.toRawUTF8());
+        return;
+    }
+
+    if (const V3_ModuleEntryFunction entryFn = lib_symbol<V3_ModuleEntryFunction>(libHandle, V3_MODULE_ENTRY_NAME))
+    {
+# ifdef CARLA_OS_WIN
+        if (! entryFn())
+# else
+        if (! entryFn(libHandle))
+# endif
+        {
+            lib_close(libHandle);
+            DISCOVERY_OUT("error", "VST3 module entry failed");
+            return;
+        }
+
+        moduleExit = lib_symbol<V3_ModuleExitFunction>(libHandle, V3_MODULE_EXIT_NAME);
+    }
+
+    getFactory = lib_symbol<V3_GetFactoryFunction>(libHandle, "GetPluginFactory");
+#endif
+
+    IPluginFactory* const factory = getFactory != nullptr ? getFactory() : nullptr;
+
+    if (factory == nullptr)
+    {
+        DISCOVERY_OUT("error", "Not a VST3 plugin");
+    }
+    else
+    {
+        IPluginFactory2* factory2 = nullptr;
+        IPluginFactory3* factory3 = nullptr;
+
+        if (factory->queryInterface(IPluginFactory2_iid, (void**)&factory2) != kResultOk)
+            factory2 = nullptr;
+
+        if (factory->queryInterface(IPluginFactory3_iid, (void**)&factory3) == kResultOk && factory3 != nullptr)
+        {
+            factory3->setHostContext(&hostApp);
+            factory3->release();
+        }
+
+        PFactoryInfo factoryInfo;
+        factory->getFactoryInfo(&factoryInfo);
+
+        for (int32 i=0, count = factory->countClasses(); i < count; ++i)
+        {
+            PClassInfo info;
+
+            if (factory->getClassInfo(i, &info) != kResultOk)
+                continue;
+            if (std::strcmp(info.category, kVstAudioEffectClass) != 0)
+                continue;
+
+            CarlaString maker(factoryInfo.vendor);
+            CarlaString subCategories;
+
+            if (factory2 != nullptr)
+            {
+                PClassInfo2 info2;
+
+                if (factory2->getClassInfo2(i, &info2) == kResultOk)
+                {
+                    if (info2.vendor[0] != '\0')
+                        maker = info2.vendor;
+
+                    subCategories = info2.subCategories;
+                }
+            }
+
+            PluginCategory category = PLUGIN_CATEGORY_NONE;
+            uint hints = 0x0;
+            uint32_t audioIns = 0;
+            uint32_t audioOuts = 0;
+            uint32_t midiIns = 0;
+            uint32_t midiOuts = 0;
+            uint32_t parameters = 0;
+
+            if (subCategories.contains("Instrument"))
+            {
+                category = PLUGIN_CATEGORY_SYNTH;
+                hints |= PLUGIN_IS_SYNTH;
+                midiIns = 1;
+            }
+            else if (subCategories.isNotEmpty())
+            {
+                category = getPluginCategoryFromName(subCategories);
+            }
+
+            if (doInit)
+            {
+                Vst::IComponent* component = nullptr;
+
+                try {
+                    factory->createInstance(info.cid, Vst::IComponent_iid, (void**)&component);
+                } CARLA_SAFE_EXCEPTION("createInstance component");
+
+                if (component != nullptr && component->initialize(&hostApp) == kResultOk)
+                {
+                    audioIns  = getVst3ChannelCount(component, Vst::kInput);
+                    audioOuts = getVst3ChannelCount(component, Vst::kOutput);
+                    midiIns   = component->getBusCount(Vst::kEvent, Vst::kInput)  > 0 ? 1 : 0;
+                    midiOuts  = component->getBusCount(Vst::kEvent, Vst::kOutput) > 0 ? 1 : 0;
+
+                    Vst::IEditController* controller = nullptr;
+                    bool controllerIsComponent = false;
+
+                    if (component->queryInterface(Vst::IEditController_iid, (void**)&controller) == kResultOk && controller != nullptr)
+                    {
+                        controllerIsComponent = true;
+                    }
+                    else
+                    {
+                        TUID controllerClassId;
+                        controller = nullptr;
+
+                        if (component->getControllerClassId(controllerClassId) == kResultOk)
+                        {
+                            try {
+                                factory->createInstance(controllerClassId, Vst::IEditController_iid, (void**)&controller);
+                            } CARLA_SAFE_EXCEPTION("createInstance controller");
+                        }
+
+                        if (controller != nullptr && controller->initialize(&hostApp) != kResultOk)
+                        {
+                            controller->release();
+                            controller = nullptr;
+                        }
+                    }
+
+                    if (controller != nullptr)
+                    {
+                        for (int32 j=0, paramCount = controller->getParameterCount(); j < paramCount; ++j)
+                        {
+                            Vst::ParameterInfo paramInfo;
+                            carla_zeroStruct(paramInfo);
+
+                            if (controller->getParameterInfo(j, paramInfo) != kResultOk)
+                                continue;
+                            if (paramInfo.flags & (Vst::ParameterInfo::kIsReadOnly|Vst::ParameterInfo::kIsProgramChange))
+                                continue;
+
+                            ++parameters;
+                        }
+
+                        if (! controllerIsComponent)
+                            controller->terminate();
+
+                        controller->release();
+                    }
+
+                    component->terminate();
+                }
+
+                if (component != nullptr)
+                    component->release();
+            }
+
+            DISCOVERY_OUT("init", "-----------");
+            DISCOVERY_OUT("build", BINARY_NATIVE);
+            DISCOVERY_OUT("hints", hints);
+            DISCOVERY_OUT("category", getPluginCategoryAsString(category));
+            DISCOVERY_OUT("name", info.name);
+            DISCOVERY_OUT("label", info.name);
+            DISCOVERY_OUT("maker", maker);
+            DISCOVERY_OUT("uniqueId", getVst3UniqueId(info.cid));
+            DISCOVERY_OUT("audio.ins", audioIns);
+            DISCOVERY_OUT("audio.outs", audioOuts);
+            DISCOVERY_OUT("midi.ins", midiIns);
+            DISCOVERY_OUT("midi.outs", midiOuts);
+            DISCOVERY_OUT("parameters.ins", parameters);
+            DISCOVERY_OUT("end", "------------");
+        }
+
+        if (factory2 != nullptr)
+            factory2->release();
+
+        factory->release();
+    }
+
+    if (moduleExit != nullptr)
+        moduleExit();
+
+#ifdef CARLA_OS_MAC
+    CFBundleUnloadExecutable(bundleRef);
+    CFRelease(bundleRef);
+#else
+    lib_close(libHandle);
+#endif
+}
+
 #ifdef USING_JUCE
 // -------------------------------------------------------------------------------------------------------------------
 // find all available plugin audio ports
@@ -1642,20 +1905,10 @@ static void do_fluidsynth_check(const char* const filename, const PluginType typ
 #endif
 }
 
-// ------------------------------ main entry point ------------------------------
+// ------------------------------ Single and batch checks ------------------------------
 
-int main(int argc, char* argv[])
+static bool do_check(const PluginType type, const char* const filename)
 {
-    if (argc != 3)
-    {
-        carla_stdout("usage: %s <type> </path/to/plugin>", argv[0]);
-        return 1;
-    }
-
-    const char* const stype    = argv[1];
-    const char* const filename = argv[2];
-    const PluginType  type     = getPluginTypeFromString(stype);
-
     CarlaString filenameCheck(filename);
     filenameCheck.toLower();
 
@@ -1669,9 +1922,6 @@ int main(int argc, char* argv[])
     case PLUGIN_VST2:
         openLib = true;
         break;
-    case PLUGIN_VST3:
-        openLib = water::File(filename).existsAsFile();
-        break;
     default:
         break;
     }
@@ -1679,7 +1929,7 @@ int main(int argc, char* argv[])
     if (type != PLUGIN_SF2 && filenameCheck.contains("fluidsynth", true))
     {
         DISCOVERY_OUT("info", "skipping fluidsynth based plugin");
-        return 0;
+        return true;
     }
 
 #ifdef CARLA_OS_MAC
@@ -1687,27 +1937,6 @@ int main(int argc, char* argv[])
         openLib = false;
 #endif
 
-    // ---------------------------------------------------------------------------------------------------------------
-    // Initialize OS features
-
-    // we want stuff in English so we can parse error messages
-    ::setlocale(LC_ALL, "C");
-#ifndef CARLA_OS_WIN
-    carla_setenv("LC_ALL", "C");
-#endif
-
-#ifdef CARLA_OS_WIN
-    OleInitialize(nullptr);
-    CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
-# ifndef __WINPTHREADS_VERSION
-    // (non-portable) initialization of statically linked pthread library
-    pthread_win32_process_attach_np();
-    pthread_win32_thread_attach_np();
-# endif
-#endif
-
-    // ---------------------------------------------------------------------------------------------------------------
-
     if (openLib)
     {
         handle = lib_open(filename);
@@ -1715,7 +1944,7 @@ int main(int argc, char* argv[])
         if (handle == nullptr)
         {
             print_lib_error(filename);
-            return 1;
+            return false;
         }
     }
 
@@ -1733,7 +1962,7 @@ int main(int argc, char* argv[])
         if (! lib_close(handle))
         {
             print_lib_error(filename);
-            return 1;
+            return false;
         }
 
         handle = lib_open(filename);
@@ -1741,18 +1970,10 @@ int main(int argc, char* argv[])
         if (handle == nullptr)
         {
             print_lib_error(filename);
-            return 1;
+            return false;
         }
     }
 
-#ifndef BUILD_BRIDGE
-    if (std::strcmp(filename, ":all") == 0)
-    {
-        do_cached_check(type);
-        return 0;
-    }
-#endif
-
     switch (type)
     {
     case PLUGIN_LADSPA:
@@ -1778,11 +1999,7 @@ int main(int argc, char* argv[])
         break;
 
     case PLUGIN_VST3:
-#if defined(USING_JUCE) && JUCE_PLUGINHOST_VST3
-        do_juce_check(filename, "VST3", doInit);
-#else
-        DISCOVERY_OUT("error", "VST3 support not available");
-#endif
+        do_vst3_check(filename, doInit);
         break;
 
     case PLUGIN_AU:
@@ -1806,6 +2023,104 @@ int main(int argc, char* argv[])
     if (openLib && handle != nullptr)
         lib_close(handle);
 
+    return true;
+}
+
+// Check many files within a single process, reading one filename per line from stdin.
+// The output of each file is enclosed by "file" and "done" lines, so the host knows where a crash happened.
+// On systems with a fork-safe runtime each check runs in a child process, a crashing plugin only loses its own file.
+static void do_batch_check(const PluginType type)
+{
+    std::string filename;
+
+    while (std::getline(std::cin, filename))
+    {
+        if (filename.empty())
+            continue;
+
+        DISCOVERY_OUT("file", filename);
+
+#if defined(CARLA_OS_WIN) || defined(CARLA_OS_MAC)
+        do_check(type, filename.c_str());
+#else
+        std::cout.flush();
+        std::fflush(stdout);
+
+        const pid_t pid = ::fork();
+
+        if (pid == 0)
+        {
+            const bool ok = do_check(type, filename.c_str());
+
+            std::cout.flush();
+            std::fflush(stdout);
+            ::_exit(ok ? 0 : 1);
+        }
+        else if (pid > 0)
+        {
+            int status = 0;
+
+            while (::waitpid(pid, &status, 0) == -1 && errno == EINTR) {}
+
+            if (WIFSIGNALED(status))
+                DISCOVERY_OUT("error", "plugin crashed during discovery");
+        }
+        else
+        {
+            do_check(type, filename.c_str());
+        }
+#endif
+
+        DISCOVERY_OUT("done", filename);
+    }
+}
+
+// ------------------------------ main entry point ------------------------------
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        carla_stdout("usage: %s <type> </path/to/plugin | :batch>", argv[0]);
+        return 1;
+    }
+
+    const char* const stype    = argv[1];
+    const char* const filename = argv[2];
+    const PluginType  type     = getPluginTypeFromString(stype);
+
+    // ---------------------------------------------------------------------------------------------------------------
+    // Initialize OS features
+
+    // we want stuff in English so we can parse error messages
+    ::setlocale(LC_ALL, "C");
+#ifndef CARLA_OS_WIN
+    carla_setenv("LC_ALL", "C");
+#endif
+
+#ifdef CARLA_OS_WIN
+    OleInitialize(nullptr);
+    CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+# ifndef __WINPTHREADS_VERSION
+    // (non-portable) initialization of statically linked pthread library
+    pthread_win32_process_attach_np();
+    pthread_win32_thread_attach_np();
+# endif
+#endif
+
+    // ---------------------------------------------------------------------------------------------------------------
+
+    int ret = 0;
+
+    if (std::strcmp(filename, ":batch") == 0)
+        do_batch_check(type);
+#ifndef BUILD_BRIDGE
+    else if (std::strcmp(filename, ":all") == 0)
+        do_cached_check(type);
+#endif
+    else if (! do_check(type, filename))
+        ret = 1;
+
     // ---------------------------------------------------------------------------------------------------------------
 
 #ifdef CARLA_OS_WIN
@@ -1817,7 +2132,7 @@ int main(int argc, char* argv[])
     OleUninitialize();
 #endif
 
-    return 0;
+    return ret;
 }
 
 // -------------------------------------------------------------------------------------------------------------------
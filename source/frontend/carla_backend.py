@@ -122,6 +122,28 @@ def numPtrToList(numPtr):
 
     return numList
 
+# ---------------------------------------------------------------------------------------------------------------------
+# Split a patchbay snapshot string into a list of engine callback arguments
+# @see carla_patchbay_get_snapshot
+
+def patchbaySnapshotToCallbacks(snapshot):
+    callbacks = []
+
+    for record in snapshot.split("\x1e"):
+        if not record:
+            continue
+
+        fields = record.split("\x1f", 6)
+
+        if len(fields) != 7:
+            print("patchbaySnapshotToCallbacks - invalid record:", fields)
+            continue
+
+        action, pluginId, value1, value2, value3 = (int(v) for v in fields[:5])
+        callbacks.append((action, pluginId, value1, value2, value3, float(fields[5]), fields[6]))
+
+    return callbacks
+
 # ---------------------------------------------------------------------------------------------------------------------
 # Convert a ctypes value into a python one
 
@@ -278,6 +300,25 @@ PLUGIN_OPTION_SEND_PROGRAM_CHANGES = 0x200
 # We always want notes enabled by default, not the contrary.
 PLUGIN_OPTION_SKIP_SENDING_NOTES = 0x400
 
+# Stop processing the plugin while its audio inputs and outputs are silent and no events arrive.
+# The plugin is put to sleep after about one second of silence and woken up on the first non-silent input or event.
+# Only available for plugins with audio inputs and no CV inputs.
+PLUGIN_OPTION_AUTO_SLEEP = 0x800
+
+# Render on more than one CPU core, for plugins that can split their own work between threads.
+# Currently used by SF2/SF3 plugins, which give FluidSynth half of the available cores.
+# Only applies when the plugin is loaded, so changing it requires a reload (for example of the project).
+PLUGIN_OPTION_MULTI_CORE = 0x1000
+
+# Keep IEEE denormal handling while this plugin processes, even if the engine flushes denormals to zero.
+# Only useful for plugins that rely on denormal numbers, which are otherwise turned into zero.
+PLUGIN_OPTION_KEEP_DENORMALS = 0x2000
+
+# Run this plugin at a larger internal block size than the engine, behind a FIFO that adds one block of latency.
+# Only used in patchbay mode, the block size is set by ENGINE_OPTION_PATCHBAY_DECOUPLED_BUFFER_SIZE.
+# Meant for heavy plugins where latency does not matter, so they do not pay the overhead of small engine blocks.
+PLUGIN_OPTION_DECOUPLED_BLOCKS = 0x4000
+
 # Special flag to indicate that plugin options are not yet set.
 # This flag exists because 0x0 as an option value is a valid one, so we need something else to indicate "null-ness".
 PLUGIN_OPTIONS_NULL = 0x10000
@@ -852,6 +893,32 @@ ENGINE_CALLBACK_PARAMETER_MAPPED_RANGE_CHANGED = 46
 # @a valuef   Y position 2
 ENGINE_CALLBACK_PATCHBAY_CLIENT_POSITION_CHANGED = 47
 
+# A plugin embed UI has been resized.
+# @a pluginId Plugin Id to resize
+# @a value1   New width
+# @a value2   New height
+ENGINE_CALLBACK_EMBED_UI_RESIZED = 48
+
+# A batch of patchbay changes has finished, see patchbay_begin_batch().
+# The patchbay callbacks that happened during the batch are not sent on their own, but collected here.
+# @a value1   Number of records
+# @a valueStr Records in the same format as patchbay_get_snapshot()
+ENGINE_CALLBACK_PATCHBAY_BATCH = 49
+
+# Several parameter values have been changed at once, see set_parameter_values().
+# They are not sent as ENGINE_CALLBACK_PARAMETER_VALUE_CHANGED on their own, but collected here.
+# @a value1   Number of records
+# @a valueStr Records separated by new lines, each as "pluginId:parameterId:value"
+ENGINE_CALLBACK_PARAMETER_VALUES_CHANGED = 50
+
+# A plugin requested with add_plugin_async() changed loading state.
+# Once added, the plugin is also announced with ENGINE_CALLBACK_PLUGIN_ADDED as usual.
+# @a pluginId Id of the new plugin when added, 0 otherwise
+# @a value1   Request id, as returned by add_plugin_async()
+# @a value2   1 for loading started, 2 for added, -1 for failed
+# @a valueStr Plugin name or label, or the error message when failed
+ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS = 51
+
 # ---------------------------------------------------------------------------------------------------------------------
 # NSM Callback Opcode
 # NSM callback opcodes.
@@ -1031,6 +1098,174 @@ ENGINE_OPTION_DEBUG_CONSOLE_OUTPUT = 33
 # @note MUST include at least one "." (dot).
 ENGINE_OPTION_CLIENT_NAME_PREFIX = 34
 
+# Number of extra threads used to process independent plugins in parallel.
+# In patchbay mode independent graph branches run in parallel, in rack mode lanes can be enabled
+# with ENGINE_OPTION_RACK_LANES. 0 (the default) processes everything in the audio thread.
+# In JACK single-client mode plugins run in parallel as long as none of their ports are connected to each other.
+# @note Cannot be set while the engine is running.
+ENGINE_OPTION_PROCESSING_THREADS = 35
+
+# Run bridged plugins one period behind the engine.
+# Each bridge is started at the end of its process call and collected on the next one,
+# so bridges run concurrently with the rest of the cycle in their own processes.
+# This adds one period of latency to every bridged plugin.
+# @note Cannot be set while the engine is running.
+ENGINE_OPTION_PIPELINED_BRIDGES = 36
+
+# Time in microseconds to busy-wait for a bridged plugin to finish processing before sleeping on its semaphore.
+# Spinning avoids the kernel wake-up latency for small buffer sizes, at the cost of burning CPU while waiting.
+# Valid range is 0 (the default, never spin) to 1000.
+ENGINE_OPTION_BRIDGE_SPIN_TIME = 37
+
+# Save plugin chunks as raw binary files next to the project file, instead of base64 text inside of it.
+# The chunks go into a folder named after the project file with a ".chunks" suffix.
+# Projects saved this way cannot be loaded from memory, as the chunk files are referenced by path.
+ENGINE_OPTION_SAVE_CHUNKS_AS_FILES = 38
+
+# Frame granularity used when splitting blocks at event times, for plugins without fixed buffers.
+# Blocks are only split at multiples of this value, parameter changes in between apply from the start of their
+# sub-block while MIDI events keep their exact time. Under dense automation plugins then run fewer and bigger
+# sub-blocks, at the cost of parameter timing precision.
+# Valid range is 1 (the default, sample accurate) to 512.
+ENGINE_OPTION_EVENT_SPLIT_GRANULARITY = 39
+
+# Number of idle plugin bridge processes to keep ready for each bridge binary.
+# These are started ahead of time and already attached to their shared memory, so that loading a bridged plugin
+# only needs to tell one of them which plugin to load. Mostly useful for Windows plugins, as Wine startup is slow.
+# Valid range is 0 (the default, disabled) to 8.
+ENGINE_OPTION_PLUGIN_BRIDGE_POOL_SIZE = 40
+
+# Maximum number of bridged plugins to run in a single bridge process.
+# Plugins using the same bridge binary then share one process and RT thread, which is woken up once for all of
+# them instead of once per plugin. A crash in one of them takes down the whole group.
+# Valid range is 0 (the default, one process per plugin) to 64.
+ENGINE_OPTION_PLUGIN_BRIDGE_GROUP_SIZE = 41
+
+# Load LV2 bundles on demand.
+# When the bundle of an LV2 plugin is known (as a full path or a bundle name inside LV2_PATH), only that bundle is
+# loaded instead of scanning all of LV2_PATH the first time an LV2 plugin is added.
+# Data that plugins keep in other bundles, like separate presets or UIs, is not available until a full scan.
+# Default is false.
+ENGINE_OPTION_LV2_LAZY_LOADING = 42
+
+# Amount of each SFZ sample to keep in memory, in milliseconds.
+# The rest of the sample is streamed from disk while playing, which greatly reduces memory usage and loading
+# time of big SFZ libraries. Samples that loop are always fully loaded.
+# Only applies to SFZ plugins loaded after the change.
+# Valid range is 0 (the default, load full samples) to 10000.
+ENGINE_OPTION_SFZ_PRELOAD_TIME = 43
+
+# Number of extra threads each SFZ plugin may use to render its voices.
+# Active voices are split between the threads and mixed together at the end of each block, which lets a single
+# heavily polyphonic sampler use more than one CPU core. Limited to the number of CPUs minus one.
+# Valid range is 0 (the default, render on the audio thread only) to 64.
+ENGINE_OPTION_SFZ_RENDER_THREADS = 44
+
+# Frame period at which CV inputs mapped to parameters are read, for plugins without fixed buffers.
+# Each CV is read once per period and a timed parameter event is sent whenever its value changed, which gives
+# smooth modulation without sending an event per frame. Plugins with fixed buffers always get one event per block.
+# Valid range is 0 (the default, read once per block) to 512.
+ENGINE_OPTION_CV_CONTROL_PERIOD = 45
+
+# Number of events each plugin event port can initially hold in patchbay mode, where every port has its own buffer.
+# Ports that run out of space are grown outside of the audio thread, up to 2048 events.
+# Valid range is 16 to 2048, default is 256.
+ENGINE_OPTION_EVENT_PORT_BUFFER_SIZE = 46
+
+# Flush denormal numbers to zero on every audio thread (FTZ and DAZ modes), including plugin bridges.
+# Avoids the large CPU spikes that denormals cause on decaying signals, such as reverb and filter tails.
+# Plugins that need IEEE behaviour can opt out with PLUGIN_OPTION_KEEP_DENORMALS.
+# Default is true.
+ENGINE_OPTION_FLUSH_DENORMALS = 47
+
+# Queue host callbacks instead of calling them from whichever thread raised them.
+# Queued callbacks are dispatched from carla_engine_idle(), in order, with consecutive parameter value changes
+# of the same parameter merged into one. This keeps a slow host from slowing down the engine threads.
+# ENGINE_CALLBACK_IDLE is always called directly, after dispatching what was queued so far.
+# Not used in plugin versions of Carla.
+# Default is false.
+ENGINE_OPTION_ASYNC_CALLBACKS = 48
+
+# Realtime priority of the audio thread in plugin bridges and JACK applications, from 1 to 99.
+# Each plugin can override it with the "CarlaRtPriority" property custom data.
+# Default is 0, which keeps the generic priority of Carla threads.
+ENGINE_OPTION_BRIDGE_RT_PRIO = 49
+
+# CPUs the audio thread of plugin bridges and JACK applications is restricted to.
+# Uses a comma-separated list of CPU indexes or ranges as value string, like "2,3,8-11".
+# Each plugin can override it with the "CarlaCpuAffinity" property custom data.
+# Only supported on Linux.
+# Default is empty, which allows all CPUs.
+ENGINE_OPTION_BRIDGE_CPU_AFFINITY = 50
+
+# CPUs the engine processing threads are restricted to, see ENGINE_OPTION_PROCESSING_THREADS.
+# Uses the same format as ENGINE_OPTION_BRIDGE_CPU_AFFINITY.
+# Only supported on Linux.
+# Default is empty, which allows all CPUs.
+ENGINE_OPTION_PROCESSING_CPU_AFFINITY = 51
+
+# Do not instantiate plugins saved as inactive when loading a project.
+# Only their saved state is kept, the plugin is instantiated the first time it gets activated.
+# Only used in rack mode, where there are no connections to the plugin ports to restore.
+# Default is false.
+ENGINE_OPTION_DORMANT_INACTIVE_PLUGINS = 52
+
+# Internal block size of patchbay plugins using PLUGIN_OPTION_DECOUPLED_BLOCKS.
+# Has no effect while the engine buffer size is the same or bigger.
+# Valid range is 128 to 8192, default is 1024.
+ENGINE_OPTION_PATCHBAY_DECOUPLED_BUFFER_SIZE = 53
+
+# Crossfade time in milliseconds used when replacing a plugin while the engine is running.
+# The new plugin is swapped in at the start of a cycle and both instances run during the fade.
+# Valid range is 0 to 1000, default is 0 (no crossfade, the slot is replaced directly).
+ENGINE_OPTION_REPLACE_PLUGIN_CROSSFADE = 54
+
+# Keep memory used by the audio thread in RAM, so it never gets paged out.
+# Covers the engine buffers, bridge audio pools and the sample data of the internal sample players.
+# 0 is off, 1 locks memory, 2 also asks for huge pages (if transparent huge pages are enabled).
+# Locking is limited by RLIMIT_MEMLOCK, see carla_get_locked_memory_size().
+# Cannot be changed while the engine is running. Default is 0.
+ENGINE_OPTION_LOCK_MEMORY = 55
+
+# Minimum number of parameters for saving a plugin's parameter values as a single compact block.
+# Parameters mapped to MIDI or CV are always saved individually.
+# Older Carla versions cannot read the compact block, 0 disables it.
+# Cannot be changed while the engine is running. Default is 0.
+ENGINE_OPTION_COMPACT_PARAMETER_STATE = 56
+
+# Open bridged LV2 UIs of the same toolkit in a single shared process, instead of one process per UI.
+# Saves startup time and memory, but a crashing UI takes the other UIs of its process with it.
+# Only applies to UIs opened afterwards, not supported on Windows. Default is false.
+ENGINE_OPTION_SHARE_UI_BRIDGES = 57
+
+# Maximum rate, in Hz, at which plugins are asked to redraw their inline display.
+# 0 means no limit, redraws are then only bound by the host idle rate. Default is 30.
+ENGINE_OPTION_INLINE_DISPLAY_MAX_RATE = 58
+
+# Minimum size, in frames, of the sub-blocks created when splitting blocks at event times.
+# An event that would leave a smaller sub-block before or after it is merged into the current sub-block instead,
+# so its parameter changes apply from the start of that sub-block. Combines with the split granularity.
+# Valid range is 0 (the default, no minimum) to 512.
+# @see ENGINE_OPTION_EVENT_SPLIT_GRANULARITY
+ENGINE_OPTION_EVENT_SPLIT_MIN_FRAMES = 59
+
+# Secondary audio device (within the same driver), used together with the main one.
+# Its inputs and outputs are added after the main device ones, and follow the main device clock
+# through a resampling buffer, which adds a fixed latency to them. Default unset.
+# Only used by RtAudio drivers that open hardware devices directly.
+# @see ENGINE_OPTION_AUDIO_DEVICE
+ENGINE_OPTION_AUDIO_SECONDARY_DEVICE = 60
+
+# Split the rack into lanes processed in parallel by the processing threads, one lane per chain
+# started by a plugin without audio inputs, with the lanes mixed together at the end.
+# This changes the rack signal flow: plugins after such a plugin no longer receive the audio and MIDI output
+# of the plugins before it, and only the first lane receives the rack audio input.
+# The result matches serial processing only when every lane after the first has no plugins processing audio
+# or MIDI coming from earlier lanes, as is the case for a rack of independent instruments.
+# Default is off. Only used in continuous rack mode when ENGINE_OPTION_PROCESSING_THREADS is set.
+# @note Cannot be set while the engine is running.
+ENGINE_OPTION_RACK_LANES = 61
+
 # ---------------------------------------------------------------------------------------------------------------------
 # Engine Process Mode
 # Engine process mode.
@@ -1408,6 +1643,87 @@ class CarlaRuntimeEngineInfo(Structure):
         ("xruns", c_uint32)
     ]
 
+# Process time statistics of a plugin, gathered from the audio thread.
+class CarlaPluginProcessTimeInfo(Structure):
+    _fields_ = [
+        # Number of measured process calls since the last reset.
+        ("count", c_uint64),
+
+        # Shortest, average and longest process call, in microseconds.
+        ("minUsecs", c_float),
+        ("avgUsecs", c_float),
+        ("maxUsecs", c_float),
+
+        # 99th percentile process call, in microseconds.
+        ("p99Usecs", c_float),
+
+        # Average number of sub-blocks per process call, above 1 when blocks are split at event times.
+        ("avgSubBlocks", c_float)
+    ]
+
+# Timing of a single engine process cycle.
+class CarlaEngineCycleInfo(Structure):
+    _fields_ = [
+        # Monotonic time at which the cycle started, in microseconds.
+        ("startTime", c_int64),
+
+        # Number of frames processed in the cycle.
+        ("frames", c_uint32),
+
+        # Time spent in the whole cycle, in microseconds.
+        ("totalUsecs", c_uint32),
+
+        # Time spent in each stage of the cycle, in microseconds.
+        ("prepareUsecs", c_uint32),
+        ("processUsecs", c_uint32),
+        ("postUsecs", c_uint32),
+
+        # Engine xrun count at the end of the cycle.
+        ("xruns", c_uint32)
+    ]
+
+# Timing of the most recent engine process cycles.
+class CarlaEngineCycleHistory(Structure):
+    _fields_ = [
+        # Number of cycles.
+        ("count", c_uint),
+
+        # Cycle timings, oldest first.
+        ("cycles", POINTER(CarlaEngineCycleInfo))
+    ]
+
+# Current value of a plugin output parameter, as part of a runtime snapshot.
+class CarlaRuntimeParameterValue(Structure):
+    _fields_ = [
+        # Plugin this parameter belongs to.
+        ("pluginId", c_uint),
+
+        # Parameter index.
+        ("parameterId", c_uint32),
+
+        # Current value.
+        ("value", c_float)
+    ]
+
+# Runtime values of the engine and all its plugins, gathered in a single call.
+class CarlaRuntimeSnapshot(Structure):
+    _fields_ = [
+        # Engine information, same as carla_get_runtime_engine_info().
+        ("engine", CarlaRuntimeEngineInfo),
+
+        # Number of plugins.
+        ("pluginCount", c_uint),
+
+        # Peak values, 4 per plugin: input left, input right, output left and output right.
+        ("peaks", POINTER(c_float)),
+
+        # Number of output parameters, for all plugins.
+        ("parameterCount", c_uint32),
+
+        # Output parameter values, ordered by plugin and then parameter index.
+        ("parameters", POINTER(CarlaRuntimeParameterValue))
+    ]
+
 # Runtime engine driver device information.
 class CarlaRuntimeEngineDriverDeviceInfo(Structure):
     _fields_ = [
@@ -1500,6 +1816,36 @@ PyCarlaRuntimeEngineInfo = {
     'xruns': 0
 }
 
+# @see CarlaPluginProcessTimeInfo
+PyCarlaPluginProcessTimeInfo = {
+    'count': 0,
+    'minUsecs': 0.0,
+    'avgUsecs': 0.0,
+    'maxUsecs': 0.0,
+    'p99Usecs': 0.0,
+    'avgSubBlocks': 0.0
+}
+
+# @see CarlaEngineCycleInfo
+PyCarlaEngineCycleInfo = {
+    'startTime': 0,
+    'frames': 0,
+    'totalUsecs': 0,
+    'prepareUsecs': 0,
+    'processUsecs': 0,
+    'postUsecs': 0,
+    'xruns': 0
+}
+
+# @see CarlaRuntimeSnapshot
+# 'peaks' has one (inL, inR, outL, outR) tuple per plugin, 'parameters' has (pluginId, parameterId, value) tuples.
+PyCarlaRuntimeSnapshot = {
+    'load': 0.0,
+    'xruns': 0,
+    'peaks': [],
+    'parameters': []
+}
+
 # @see CarlaRuntimeEngineDriverDeviceInfo
 PyCarlaRuntimeEngineDriverDeviceInfo = {
     'name': "",
@@ -1636,6 +1982,13 @@ class CarlaHostMeta():
     def show_engine_device_control_panel(self):
         raise NotImplementedError
 
+    # Render the current project offline into a 32-bit float WAV file, as fast as possible.
+    # Only supported by the "Render" engine driver, blocks until rendering is complete.
+    # @param filename Output filename
+    # @param frames   Number of frames to render
+    def render_to_file(self, filename, frames):
+        raise NotImplementedError
+
     # Clear the xrun count on the engine, so that the next time carla_get_runtime_engine_info() is called, it returns 0.
     @abstractmethod
     def clear_engine_xruns(self):
@@ -1698,6 +2051,24 @@ class CarlaHostMeta():
     def clear_project_filename(self):
         raise NotImplementedError
 
+    # Load a Carla project file ahead of time, without processing it yet.
+    # Its plugins are added disabled after the current ones, use switch_to_preloaded_project() to switch to them.
+    # @note Engine settings and external connections of the project are ignored.
+    @abstractmethod
+    def preload_project(self, filename):
+        raise NotImplementedError
+
+    # Replace the currently loaded plugins with the ones from the preloaded project.
+    # @param fadeTimeMs Time to fade the audio outputs out before the switch and back in after it, 0 to not fade
+    @abstractmethod
+    def switch_to_preloaded_project(self, fadeTimeMs):
+        raise NotImplementedError
+
+    # Remove the plugins of the preloaded project, if any.
+    @abstractmethod
+    def cancel_preloaded_project(self):
+        raise NotImplementedError
+
     # Connect two patchbay ports.
     # @param groupIdA Output group
     # @param portIdA  Output port
@@ -1730,6 +2101,28 @@ class CarlaHostMeta():
     def patchbay_refresh(self, external):
         raise NotImplementedError
 
+    # Get all patchbay clients, ports and connections at once, instead of through one callback each.
+    # Returns None if not available, in which case patchbay_refresh() should be used.
+    # @see patchbaySnapshotToCallbacks
+    # @param external Wherever to show external/hardware ports instead of internal ones.
+    #                 Only valid in patchbay engine mode, other modes will ignore this.
+    @abstractmethod
+    def patchbay_get_snapshot(self, external):
+        raise NotImplementedError
+
+    # Start a batch of patchbay changes, such as many connections at once.
+    # The rendering order is only rebuilt once the batch ends, and all patchbay callbacks
+    # are sent together as a single ENGINE_CALLBACK_PATCHBAY_BATCH.
+    # Batches can be nested, and each one must be ended with patchbay_end_batch().
+    @abstractmethod
+    def patchbay_begin_batch(self):
+        raise NotImplementedError
+
+    # Finish a batch of patchbay changes.
+    @abstractmethod
+    def patchbay_end_batch(self):
+        raise NotImplementedError
+
     # Start playback of the engine transport.
     @abstractmethod
     def transport_play(self):
@@ -1785,6 +2178,15 @@ class CarlaHostMeta():
     def add_plugin(self, btype, ptype, filename, name, label, uniqueId, extraPtr, options):
         raise NotImplementedError
 
+    # Add a new plugin without waiting for it to load.
+    # The plugin is loaded in the background when its type allows it, and added later during engine_idle().
+    # Progress is reported with ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS, using the returned request id.
+    # Returns 0 if the request failed, see get_last_error().
+    # Parameters are the same as in add_plugin().
+    @abstractmethod
+    def add_plugin_async(self, btype, ptype, filename, name, label, uniqueId, extraPtr, options):
+        raise NotImplementedError
+
     # Remove a plugin.
     # @param pluginId Plugin to remove.
     @abstractmethod
@@ -1825,6 +2227,23 @@ class CarlaHostMeta():
     def switch_plugins(self, pluginIdA, pluginIdB):
         raise NotImplementedError
 
+    # Freeze a chain of plugins, rendering it offline into an audio file and replacing it with a player for that file.
+    # The plugin states are saved next to the audio file, see unfreeze_plugin().
+    # Only supported in rack mode.
+    # @param firstId  First plugin of the chain
+    # @param lastId   Last plugin of the chain
+    # @param filename WAV file to render into
+    # @param frames   Number of frames to render, starting from transport frame 0
+    @abstractmethod
+    def freeze_plugins(self, firstId, lastId, filename, frames):
+        raise NotImplementedError
+
+    # Restore the plugins a frozen audio file player was rendered from.
+    # @param pluginId Plugin of the frozen audio file player
+    @abstractmethod
+    def unfreeze_plugin(self, pluginId):
+        raise NotImplementedError
+
     # Load a plugin state.
     # @param pluginId Plugin
     # @param filename Path to plugin state
@@ -2020,6 +2439,15 @@ class CarlaHostMeta():
     def get_current_parameter_value(self, pluginId, parameterId):
         raise NotImplementedError
 
+    # Get a range of a plugin's current parameter values at once.
+    # Returns a list of values, shorter than count if the range goes past the last parameter.
+    # @param pluginId    Plugin
+    # @param parameterId First parameter index
+    # @param count       Number of values to get
+    @abstractmethod
+    def get_current_parameter_values(self, pluginId, parameterId, count):
+        raise NotImplementedError
+
     # Get a plugin's internal parameter value.
     # @param pluginId    Plugin
     # @param parameterId Parameter index, maybe be negative
@@ -2042,6 +2470,34 @@ class CarlaHostMeta():
     def get_output_peak_value(self, pluginId, isLeft):
         raise NotImplementedError
 
+    # Get a plugin's process time statistics, measured on the audio thread.
+    # @param pluginId Plugin
+    # @see PyCarlaPluginProcessTimeInfo
+    @abstractmethod
+    def get_plugin_process_time_info(self, pluginId):
+        raise NotImplementedError
+
+    # Reset a plugin's process time statistics.
+    # @param pluginId Plugin
+    @abstractmethod
+    def reset_plugin_process_time_info(self, pluginId):
+        raise NotImplementedError
+
+    # Get the peaks of all plugins, their output parameter values and the engine runtime information at once.
+    # This replaces several calls per plugin by a single one when refreshing a GUI.
+    # @see PyCarlaRuntimeSnapshot
+    @abstractmethod
+    def get_runtime_snapshot(self):
+        raise NotImplementedError
+
+    # Get the timing of the most recent engine process cycles, oldest first.
+    # Useful to find out what happened around an xrun.
+    # @param maxCount Maximum number of cycles to get
+    # @see PyCarlaEngineCycleInfo
+    @abstractmethod
+    def get_engine_cycle_history(self, maxCount):
+        raise NotImplementedError
+
     # Render a plugin's inline display.
     # @param pluginId Plugin
     @abstractmethod
@@ -2113,6 +2569,24 @@ class CarlaHostMeta():
     def set_parameter_value(self, pluginId, parameterId, value):
         raise NotImplementedError
 
+    # Change several parameter values of a plugin at once.
+    # All values are applied in the same audio cycle, with a single ENGINE_CALLBACK_PARAMETER_VALUES_CHANGED.
+    # @param pluginId     Plugin
+    # @param parameterIds Parameter indexes
+    # @param values       New values
+    @abstractmethod
+    def set_parameter_values(self, pluginId, parameterIds, values):
+        raise NotImplementedError
+
+    # Change parameter values of several plugins at once, for recalling a scene.
+    # All values are applied in the same audio cycle, with a single ENGINE_CALLBACK_PARAMETER_VALUES_CHANGED.
+    # @param pluginIds    Plugin of each value
+    # @param parameterIds Parameter indexes
+    # @param values       New values
+    @abstractmethod
+    def set_multiple_parameter_values(self, pluginIds, parameterIds, values):
+        raise NotImplementedError
+
     # Change a plugin's parameter mapped control index.
     # @param pluginId    Plugin
     # @param parameterId Parameter index
@@ -2226,6 +2700,12 @@ class CarlaHostMeta():
     def get_sample_rate(self):
         raise NotImplementedError
 
+    # Get the amount of memory currently locked in RAM, in bytes.
+    # Always 0 unless ENGINE_OPTION_LOCK_MEMORY is set.
+    @abstractmethod
+    def get_locked_memory_size(self):
+        raise NotImplementedError
+
     # Get the last error.
     @abstractmethod
     def get_last_error(self):
@@ -2315,6 +2795,9 @@ class CarlaHostNull(CarlaHostMeta):
     def show_engine_device_control_panel(self):
         return False
 
+    def render_to_file(self, filename, frames):
+        return False
+
     def clear_engine_xruns(self):
         return
 
@@ -2345,6 +2828,15 @@ class CarlaHostNull(CarlaHostMeta):
     def clear_project_filename(self):
         return
 
+    def preload_project(self, filename):
+        return False
+
+    def switch_to_preloaded_project(self, fadeTimeMs):
+        return False
+
+    def cancel_preloaded_project(self):
+        return False
+
     def patchbay_connect(self, external, groupIdA, portIdA, groupIdB, portIdB):
         return False
 
@@ -2357,6 +2849,15 @@ class CarlaHostNull(CarlaHostMeta):
     def patchbay_refresh(self, external):
         return False
 
+    def patchbay_get_snapshot(self, external):
+        return None
+
+    def patchbay_begin_batch(self):
+        return
+
+    def patchbay_end_batch(self):
+        return
+
     def transport_play(self):
         return
 
@@ -2384,6 +2885,9 @@ class CarlaHostNull(CarlaHostMeta):
     def add_plugin(self, btype, ptype, filename, name, label, uniqueId, extraPtr, options):
         return False
 
+    def add_plugin_async(self, btype, ptype, filename, name, label, uniqueId, extraPtr, options):
+        return 0
+
     def remove_plugin(self, pluginId):
         return False
 
@@ -2402,6 +2906,12 @@ class CarlaHostNull(CarlaHostMeta):
     def switch_plugins(self, pluginIdA, pluginIdB):
         return False
 
+    def freeze_plugins(self, firstId, lastId, filename, frames):
+        return False
+
+    def unfreeze_plugin(self, pluginId):
+        return False
+
     def load_plugin_state(self, pluginId, filename):
         return False
 
@@ -2483,6 +2993,9 @@ class CarlaHostNull(CarlaHostMeta):
     def get_current_parameter_value(self, pluginId, parameterId):
         return 0.0
 
+    def get_current_parameter_values(self, pluginId, parameterId, count):
+        return []
+
     def get_internal_parameter_value(self, pluginId, parameterId):
         return 0.0
 
@@ -2492,6 +3005,23 @@ class CarlaHostNull(CarlaHostMeta):
     def get_output_peak_value(self, pluginId, isLeft):
         return 0.0
 
+    def get_plugin_process_time_info(self, pluginId):
+        return PyCarlaPluginProcessTimeInfo
+
+    def reset_plugin_process_time_info(self, pluginId):
+        return
+
+    def get_runtime_snapshot(self):
+        return {
+            'load': 0.0,
+            'xruns': 0,
+            'peaks': [],
+            'parameters': []
+        }
+
+    def get_engine_cycle_history(self, maxCount):
+        return []
+
     def render_inline_display(self, pluginId, width, height):
         return None
 
@@ -2522,6 +3052,12 @@ class CarlaHostNull(CarlaHostMeta):
     def set_parameter_value(self, pluginId, parameterId, value):
         return
 
+    def set_parameter_values(self, pluginId, parameterIds, values):
+        return False
+
+    def set_multiple_parameter_values(self, pluginIds, parameterIds, values):
+        return False
+
     def set_parameter_midi_channel(self, pluginId, parameterId, channel):
         return
 
@@ -2567,6 +3103,9 @@ class CarlaHostNull(CarlaHostMeta):
     def get_sample_rate(self):
         return 0.0
 
+    def get_locked_memory_size(self):
+        return 0
+
     def get_last_error(self):
         return ""
 
@@ -2636,6 +3175,9 @@ class CarlaHostDLL(CarlaHostMeta):
         self.lib.carla_show_engine_device_control_panel.argtypes = (c_void_p,)
         self.lib.carla_show_engine_device_control_panel.restype = c_bool
 
+        self.lib.carla_render_to_file.argtypes = (c_void_p, c_char_p, c_uint64)
+        self.lib.carla_render_to_file.restype = c_bool
+
         self.lib.carla_clear_engine_xruns.argtypes = (c_void_p,)
         self.lib.carla_clear_engine_xruns.restype = None
 
@@ -2666,6 +3208,15 @@ class CarlaHostDLL(CarlaHostMeta):
         self.lib.carla_clear_project_filename.argtypes = (c_void_p,)
         self.lib.carla_clear_project_filename.restype = None
 
+        self.lib.carla_preload_project.argtypes = (c_void_p, c_char_p)
+        self.lib.carla_preload_project.restype = c_bool
+
+        self.lib.carla_switch_to_preloaded_project.argtypes = (c_void_p, c_uint)
+        self.lib.carla_switch_to_preloaded_project.restype = c_bool
+
+        self.lib.carla_cancel_preloaded_project.argtypes = (c_void_p,)
+        self.lib.carla_cancel_preloaded_project.restype = c_bool
+
         self.lib.carla_patchbay_connect.argtypes = (c_void_p, c_bool, c_uint, c_uint, c_uint, c_uint)
         self.lib.carla_patchbay_connect.restype = c_bool
 
@@ -2678,6 +3229,15 @@ class CarlaHostDLL(CarlaHostMeta):
         self.lib.carla_patchbay_refresh.argtypes = (c_void_p, c_bool)
         self.lib.carla_patchbay_refresh.restype = c_bool
 
+        self.lib.carla_patchbay_get_snapshot.argtypes = (c_void_p, c_bool)
+        self.lib.carla_patchbay_get_snapshot.restype = c_char_p
+
+        self.lib.carla_patchbay_begin_batch.argtypes = (c_void_p,)
+        self.lib.carla_patchbay_begin_batch.restype = None
+
+        self.lib.carla_patchbay_end_batch.argtypes = (c_void_p,)
+        self.lib.carla_patchbay_end_batch.restype = None
+
         self.lib.carla_transport_play.argtypes = (c_void_p,)
         self.lib.carla_transport_play.restype = None
 
@@ -2706,6 +3266,10 @@ class CarlaHostDLL(CarlaHostMeta):
                                               c_void_p, c_uint)
         self.lib.carla_add_plugin.restype = c_bool
 
+        self.lib.carla_add_plugin_async.argtypes = (c_void_p, c_enum, c_enum, c_char_p, c_char_p, c_char_p, c_int64,
+                                                    c_void_p, c_uint)
+        self.lib.carla_add_plugin_async.restype = c_uint
+
         self.lib.carla_remove_plugin.argtypes = (c_void_p, c_uint)
         self.lib.carla_remove_plugin.restype = c_bool
 
@@ -2724,6 +3288,12 @@ class CarlaHostDLL(CarlaHostMeta):
         self.lib.carla_switch_plugins.argtypes = (c_void_p, c_uint, c_uint)
         self.lib.carla_switch_plugins.restype = c_bool
 
+        self.lib.carla_freeze_plugins.argtypes = (c_void_p, c_uint, c_uint, c_char_p, c_uint64)
+        self.lib.carla_freeze_plugins.restype = c_bool
+
+        self.lib.carla_unfreeze_plugin.argtypes = (c_void_p, c_uint)
+        self.lib.carla_unfreeze_plugin.restype = c_bool
+
         self.lib.carla_load_plugin_state.argtypes = (c_void_p, c_uint, c_char_p)
         self.lib.carla_load_plugin_state.restype = c_bool
 
@@ -2805,6 +3375,9 @@ class CarlaHostDLL(CarlaHostMeta):
         self.lib.carla_get_current_parameter_value.argtypes = (c_void_p, c_uint, c_uint32)
         self.lib.carla_get_current_parameter_value.restype = c_float
 
+        self.lib.carla_get_current_parameter_values.argtypes = (c_void_p, c_uint, c_uint32, c_uint32, POINTER(c_float))
+        self.lib.carla_get_current_parameter_values.restype = c_uint32
+
         self.lib.carla_get_internal_parameter_value.argtypes = (c_void_p, c_uint, c_int32)
         self.lib.carla_get_internal_parameter_value.restype = c_float
 
@@ -2814,6 +3387,18 @@ class CarlaHostDLL(CarlaHostMeta):
         self.lib.carla_get_output_peak_value.argtypes = (c_void_p, c_uint, c_bool)
         self.lib.carla_get_output_peak_value.restype = c_float
 
+        self.lib.carla_get_plugin_process_time_info.argtypes = (c_void_p, c_uint)
+        self.lib.carla_get_plugin_process_time_info.restype = POINTER(CarlaPluginProcessTimeInfo)
+
+        self.lib.carla_reset_plugin_process_time_info.argtypes = (c_void_p, c_uint)
+        self.lib.carla_reset_plugin_process_time_info.restype = None
+
+        self.lib.carla_get_runtime_snapshot.argtypes = (c_void_p,)
+        self.lib.carla_get_runtime_snapshot.restype = POINTER(CarlaRuntimeSnapshot)
+
+        self.lib.carla_get_engine_cycle_history.argtypes = (c_void_p, c_uint)
+        self.lib.carla_get_engine_cycle_history.restype = POINTER(CarlaEngineCycleHistory)
+
         self.lib.carla_render_inline_display.argtypes = (c_void_p, c_uint, c_uint, c_uint)
         self.lib.carla_render_inline_display.restype = POINTER(CarlaInlineDisplayImageSurface)
 
@@ -2844,6 +3429,12 @@ class CarlaHostDLL(CarlaHostMeta):
         self.lib.carla_set_parameter_value.argtypes = (c_void_p, c_uint, c_uint32, c_float)
         self.lib.carla_set_parameter_value.restype = None
 
+        self.lib.carla_set_parameter_values.argtypes = (c_void_p, c_uint, c_uint32, POINTER(c_uint32), POINTER(c_float))
+        self.lib.carla_set_parameter_values.restype = c_bool
+
+        self.lib.carla_set_multiple_parameter_values.argtypes = (c_void_p, c_uint32, POINTER(c_uint), POINTER(c_uint32), POINTER(c_float))
+        self.lib.carla_set_multiple_parameter_values.restype = c_bool
+
         self.lib.carla_set_parameter_midi_channel.argtypes = (c_void_p, c_uint, c_uint32, c_uint8)
         self.lib.carla_set_parameter_midi_channel.restype = None
 
@@ -2889,6 +3480,9 @@ class CarlaHostDLL(CarlaHostMeta):
         self.lib.carla_get_sample_rate.argtypes = (c_void_p,)
         self.lib.carla_get_sample_rate.restype = c_double
 
+        self.lib.carla_get_locked_memory_size.argtypes = (c_void_p,)
+        self.lib.carla_get_locked_memory_size.restype = c_uint64
+
         self.lib.carla_get_last_error.argtypes = (c_void_p,)
         self.lib.carla_get_last_error.restype = c_char_p
 
@@ -2950,6 +3544,9 @@ class CarlaHostDLL(CarlaHostMeta):
     def show_engine_device_control_panel(self):
         return bool(self.lib.carla_show_engine_device_control_panel(self.handle))
 
+    def render_to_file(self, filename, frames):
+        return bool(self.lib.carla_render_to_file(self.handle, filename.encode("utf-8"), frames))
+
     def clear_engine_xruns(self):
         self.lib.carla_clear_engine_xruns(self.handle)
 
@@ -2982,6 +3579,15 @@ class CarlaHostDLL(CarlaHostMeta):
     def clear_project_filename(self):
         self.lib.carla_clear_project_filename(self.handle)
 
+    def preload_project(self, filename):
+        return bool(self.lib.carla_preload_project(self.handle, filename.encode("utf-8")))
+
+    def switch_to_preloaded_project(self, fadeTimeMs):
+        return bool(self.lib.carla_switch_to_preloaded_project(self.handle, fadeTimeMs))
+
+    def cancel_preloaded_project(self):
+        return bool(self.lib.carla_cancel_preloaded_project(self.handle))
+
     def patchbay_connect(self, external, groupIdA, portIdA, groupIdB, portIdB):
         return bool(self.lib.carla_patchbay_connect(self.handle, external, groupIdA, portIdA, groupIdB, portIdB))
 
@@ -2994,6 +3600,16 @@ class CarlaHostDLL(CarlaHostMeta):
     def patchbay_refresh(self, external):
         return bool(self.lib.carla_patchbay_refresh(self.handle, external))
 
+    def patchbay_get_snapshot(self, external):
+        snapshot = self.lib.carla_patchbay_get_snapshot(self.handle, external)
+        return None if snapshot is None else charPtrToString(snapshot)
+
+    def patchbay_begin_batch(self):
+        self.lib.carla_patchbay_begin_batch(self.handle)
+
+    def patchbay_end_batch(self):
+        self.lib.carla_patchbay_end_batch(self.handle)
+
     def transport_play(self):
         self.lib.carla_transport_play(self.handle)
 
@@ -3029,6 +3645,17 @@ class CarlaHostDLL(CarlaHostMeta):
                                               btype, ptype,
                                               cfilename, cname, clabel, uniqueId, cast(extraPtr, c_void_p), options))
 
+    def add_plugin_async(self, btype, ptype, filename, name, label, uniqueId, extraPtr, options):
+        cfilename = filename.encode("utf-8") if filename else None
+        cname     = name.encode("utf-8") if name else None
+        if ptype == PLUGIN_JACK:
+            clabel = bytes(ord(b) for b in label)
+        else:
+            clabel = label.encode("utf-8") if label else None
+        return int(self.lib.carla_add_plugin_async(self.handle,
+                                                   btype, ptype,
+                                                   cfilename, cname, clabel, uniqueId, cast(extraPtr, c_void_p), options))
+
     def remove_plugin(self, pluginId):
         return bool(self.lib.carla_remove_plugin(self.handle, pluginId))
 
@@ -3047,6 +3674,12 @@ class CarlaHostDLL(CarlaHostMeta):
     def switch_plugins(self, pluginIdA, pluginIdB):
         return bool(self.lib.carla_switch_plugins(self.handle, pluginIdA, pluginIdB))
 
+    def freeze_plugins(self, firstId, lastId, filename, frames):
+        return bool(self.lib.carla_freeze_plugins(self.handle, firstId, lastId, filename.encode("utf-8"), frames))
+
+    def unfreeze_plugin(self, pluginId):
+        return bool(self.lib.carla_unfreeze_plugin(self.handle, pluginId))
+
     def load_plugin_state(self, pluginId, filename):
         return bool(self.lib.carla_load_plugin_state(self.handle, pluginId, filename.encode("utf-8")))
 
@@ -3134,6 +3767,13 @@ class CarlaHostDLL(CarlaHostMeta):
     def get_current_parameter_value(self, pluginId, parameterId):
         return float(self.lib.carla_get_current_parameter_value(self.handle, pluginId, parameterId))
 
+    def get_current_parameter_values(self, pluginId, parameterId, count):
+        if count <= 0:
+            return []
+        values = (c_float * count)()
+        count  = self.lib.carla_get_current_parameter_values(self.handle, pluginId, parameterId, count, values)
+        return values[:count]
+
     def get_internal_parameter_value(self, pluginId, parameterId):
         return float(self.lib.carla_get_internal_parameter_value(self.handle, pluginId, parameterId))
 
@@ -3143,6 +3783,28 @@ class CarlaHostDLL(CarlaHostMeta):
     def get_output_peak_value(self, pluginId, isLeft):
         return float(self.lib.carla_get_output_peak_value(self.handle, pluginId, isLeft))
 
+    def get_plugin_process_time_info(self, pluginId):
+        return structToDict(self.lib.carla_get_plugin_process_time_info(self.handle, pluginId).contents)
+
+    def reset_plugin_process_time_info(self, pluginId):
+        self.lib.carla_reset_plugin_process_time_info(self.handle, pluginId)
+
+    def get_runtime_snapshot(self):
+        snapshot = self.lib.carla_get_runtime_snapshot(self.handle).contents
+        peaks    = snapshot.peaks[:snapshot.pluginCount*4] if snapshot.pluginCount > 0 else []
+        params   = snapshot.parameters[:snapshot.parameterCount] if snapshot.parameterCount > 0 else []
+
+        return {
+            'load': float(snapshot.engine.load),
+            'xruns': int(snapshot.engine.xruns),
+            'peaks': [tuple(peaks[i:i+4]) for i in range(0, len(peaks), 4)],
+            'parameters': [(int(p.pluginId), int(p.parameterId), float(p.value)) for p in params]
+        }
+
+    def get_engine_cycle_history(self, maxCount):
+        history = self.lib.carla_get_engine_cycle_history(self.handle, maxCount).contents
+        return [structToDict(history.cycles[i]) for i in range(history.count)]
+
     def render_inline_display(self, pluginId, width, height):
         ptr = self.lib.carla_render_inline_display(self.handle, pluginId, width, height)
         if not ptr or not ptr.contents:
@@ -3185,6 +3847,19 @@ class CarlaHostDLL(CarlaHostMeta):
     def set_parameter_value(self, pluginId, parameterId, value):
         self.lib.carla_set_parameter_value(self.handle, pluginId, parameterId, value)
 
+    def set_parameter_values(self, pluginId, parameterIds, values):
+        count = min(len(parameterIds), len(values))
+        return bool(self.lib.carla_set_parameter_values(self.handle, pluginId, count,
+                                                        (c_uint32 * count)(*parameterIds[:count]),
+                                                        (c_float * count)(*values[:count])))
+
+    def set_multiple_parameter_values(self, pluginIds, parameterIds, values):
+        count = min(len(pluginIds), len(parameterIds), len(values))
+        return bool(self.lib.carla_set_multiple_parameter_values(self.handle, count,
+                                                                 (c_uint * count)(*pluginIds[:count]),
+                                                                 (c_uint32 * count)(*parameterIds[:count]),
+                                                                 (c_float * count)(*values[:count])))
+
     def set_parameter_midi_channel(self, pluginId, parameterId, channel):
         self.lib.carla_set_parameter_midi_channel(self.handle, pluginId, parameterId, channel)
 
@@ -3234,6 +3909,9 @@ class CarlaHostDLL(CarlaHostMeta):
     def get_sample_rate(self):
         return float(self.lib.carla_get_sample_rate(self.handle))
 
+    def get_locked_memory_size(self):
+        return int(self.lib.carla_get_locked_memory_size(self.handle))
+
     def get_last_error(self):
         return charPtrToString(self.lib.carla_get_last_error(self.handle))
 
@@ -3277,6 +3955,7 @@ class PluginStoreInfo():
         self.customDataCount = 0
         self.customData      = []
         self.peaks = [0.0, 0.0, 0.0, 0.0]
+        self.processTimeInfo = PyCarlaPluginProcessTimeInfo.copy()
 
 # ---------------------------------------------------------------------------------------------------------------------
 # Carla Host object for plugins (using pipes)
@@ -3363,6 +4042,9 @@ class CarlaHostPlugin(CarlaHostMeta):
     def show_engine_device_control_panel(self):
         return False
 
+    def render_to_file(self, filename, frames):
+        return False
+
     def clear_engine_xruns(self):
         self.sendMsg(["clear_engine_xruns"])
 
@@ -3390,6 +4072,15 @@ class CarlaHostPlugin(CarlaHostMeta):
     def clear_project_filename(self):
         return self.sendMsgAndSetError(["clear_project_filename"])
 
+    def preload_project(self, filename):
+        return False
+
+    def switch_to_preloaded_project(self, fadeTimeMs):
+        return False
+
+    def cancel_preloaded_project(self):
+        return False
+
     def patchbay_connect(self, external, groupIdA, portIdA, groupIdB, portIdB):
         return self.sendMsgAndSetError(["patchbay_connect", external, groupIdA, portIdA, groupIdB, portIdB])
 
@@ -3402,6 +4093,16 @@ class CarlaHostPlugin(CarlaHostMeta):
     def patchbay_refresh(self, external):
         return self.sendMsgAndSetError(["patchbay_refresh", external])
 
+    def patchbay_get_snapshot(self, external):
+        return None
+
+    # remote changes are applied one message at a time anyway
+    def patchbay_begin_batch(self):
+        return
+
+    def patchbay_end_batch(self):
+        return
+
     def transport_play(self):
         self.sendMsg(["transport_play"])
 
@@ -3433,6 +4134,10 @@ class CarlaHostPlugin(CarlaHostMeta):
                                         name or "(null)",
                                         label, uniqueId, options])
 
+    # the plugin version has no background loading, the plugin is added right away
+    def add_plugin_async(self, btype, ptype, filename, name, label, uniqueId, extraPtr, options):
+        return 1 if self.add_plugin(btype, ptype, filename, name, label, uniqueId, extraPtr, options) else 0
+
     def remove_plugin(self, pluginId):
         return self.sendMsgAndSetError(["remove_plugin", pluginId])
 
@@ -3454,6 +4159,12 @@ class CarlaHostPlugin(CarlaHostMeta):
             self._switchPlugins(pluginIdA, pluginIdB)
         return ret
 
+    def freeze_plugins(self, firstId, lastId, filename, frames):
+        return False
+
+    def unfreeze_plugin(self, pluginId):
+        return False
+
     def load_plugin_state(self, pluginId, filename):
         return self.sendMsgAndSetError(["load_plugin_state", pluginId, filename])
 
@@ -3542,6 +4253,9 @@ class CarlaHostPlugin(CarlaHostMeta):
     def get_current_parameter_value(self, pluginId, parameterId):
         return self.fPluginsInfo[pluginId].parameterValues[parameterId]
 
+    def get_current_parameter_values(self, pluginId, parameterId, count):
+        return self.fPluginsInfo[pluginId].parameterValues[parameterId:parameterId+max(0, count)]
+
     def get_internal_parameter_value(self, pluginId, parameterId):
         if parameterId == PARAMETER_NULL or parameterId <= PARAMETER_MAX:
             return 0.0
@@ -3556,6 +4270,38 @@ class CarlaHostPlugin(CarlaHostMeta):
     def get_output_peak_value(self, pluginId, isLeft):
         return self.fPluginsInfo[pluginId].peaks[2 if isLeft else 3]
 
+    def get_plugin_process_time_info(self, pluginId):
+        return self.fPluginsInfo.get(pluginId, self.fFallbackPluginInfo).processTimeInfo
+
+    def reset_plugin_process_time_info(self, pluginId):
+        # statistics are only received periodically, so this just clears the local copy
+        pluginInfo = self.fPluginsInfo.get(pluginId, None)
+        if pluginInfo is not None:
+            pluginInfo.processTimeInfo = PyCarlaPluginProcessTimeInfo.copy()
+
+    def get_runtime_snapshot(self):
+        peaks  = []
+        params = []
+
+        for pluginId in range(len(self.fPluginsInfo)):
+            info = self.fPluginsInfo.get(pluginId, self.fFallbackPluginInfo)
+            peaks.append(tuple(info.peaks))
+
+            for parameterId, paramData in enumerate(info.parameterData):
+                if paramData['type'] == PARAMETER_OUTPUT and parameterId < len(info.parameterValues):
+                    params.append((pluginId, parameterId, info.parameterValues[parameterId]))
+
+        return {
+            'load': self.fRuntimeEngineInfo['load'],
+            'xruns': self.fRuntimeEngineInfo['xruns'],
+            'peaks': peaks,
+            'parameters': params
+        }
+
+    def get_engine_cycle_history(self, maxCount):
+        # not sent by the engine, only available locally
+        return []
+
     def render_inline_display(self, pluginId, width, height):
         return None
 
@@ -3594,6 +4340,17 @@ class CarlaHostPlugin(CarlaHostMeta):
         self.sendMsg(["set_parameter_value", pluginId, parameterId, value])
         self.fPluginsInfo[pluginId].parameterValues[parameterId] = value
 
+    # there is no bulk message for the plugin version, values are sent one by one
+    def set_parameter_values(self, pluginId, parameterIds, values):
+        for parameterId, value in zip(parameterIds, values):
+            self.set_parameter_value(pluginId, parameterId, value)
+        return True
+
+    def set_multiple_parameter_values(self, pluginIds, parameterIds, values):
+        for pluginId, parameterId, value in zip(pluginIds, parameterIds, values):
+            self.set_parameter_value(pluginId, parameterId, value)
+        return True
+
     def set_parameter_midi_channel(self, pluginId, parameterId, channel):
         self.sendMsg(["set_parameter_midi_channel", pluginId, parameterId, channel])
         self.fPluginsInfo[pluginId].parameterData[parameterId]['midiChannel'] = channel
@@ -3653,6 +4410,10 @@ class CarlaHostPlugin(CarlaHostMeta):
     def get_sample_rate(self):
         return self.fSampleRate
 
+    def get_locked_memory_size(self):
+        # not sent by the engine, only available locally
+        return 0
+
     def get_last_error(self):
         return self.fLastError
 
@@ -3936,6 +4697,18 @@ class CarlaHostPlugin(CarlaHostMeta):
         if pluginInfo is not None:
             pluginInfo.peaks = [in1, in2, out1, out2]
 
+    def _set_plugin_process_time_info(self, pluginId, count, minUsecs, avgUsecs, maxUsecs, p99Usecs, avgSubBlocks):
+        pluginInfo = self.fPluginsInfo.get(pluginId, None)
+        if pluginInfo is not None:
+            pluginInfo.processTimeInfo = {
+                'count': count,
+                'minUsecs': minUsecs,
+                'avgUsecs': avgUsecs,
+                'maxUsecs': maxUsecs,
+                'p99Usecs': p99Usecs,
+                'avgSubBlocks': avgSubBlocks
+            }
+
     def _removePlugin(self, pluginId):
         pluginCountM1 = len(self.fPluginsInfo)-1
 
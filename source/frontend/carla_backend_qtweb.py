@@ -225,6 +225,10 @@ class CarlaHostQtWeb(CarlaHostQtNull):
             'options': options,
         }).text))
 
+    # the web API has no background loading, the plugin is added right away
+    def add_plugin_async(self, btype, ptype, filename, name, label, uniqueId, extraPtr, options):
+        return 1 if self.add_plugin(btype, ptype, filename, name, label, uniqueId, extraPtr, options) else 0
+
     def remove_plugin(self, pluginId):
         return bool(int(requests.get("{}/remove_plugin".format(self.baseurl), params={
             'filename': pluginId,
@@ -425,6 +429,25 @@ class CarlaHostQtWeb(CarlaHostQtNull):
     def get_output_peak_value(self, pluginId, isLeft):
         return self.peaks[pluginId][2 if isLeft else 3]
 
+    def get_plugin_process_time_info(self, pluginId):
+        return PyCarlaPluginProcessTimeInfo
+
+    def reset_plugin_process_time_info(self, pluginId):
+        return
+
+    def get_runtime_snapshot(self):
+        info = self.get_runtime_engine_info()
+
+        return {
+            'load': info['load'],
+            'xruns': info['xruns'],
+            'peaks': list(self.peaks),
+            'parameters': []
+        }
+
+    def get_engine_cycle_history(self, maxCount):
+        return []
+
     def set_option(self, pluginId, option, yesNo):
         requests.get("{}/set_option".format(self.baseurl), params={
             'pluginId': pluginId,
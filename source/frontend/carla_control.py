@@ -20,6 +20,7 @@
 # Imports (Global)
 
 from PyQt5.QtCore import QEventLoop
+from PyQt5.QtWidgets import QDialogButtonBox
 
 # ------------------------------------------------------------------------------------------------------------
 # Imports (Custom)
@@ -321,6 +322,9 @@ class CarlaControlServerTCP(Server):
         self.host = host
         self.rhost = rhost
 
+        # patchbay snapshot chunks received so far
+        self.fPatchbaySnapshot = []
+
     def idle(self):
         self.fReceivedMsgs = False
 
@@ -340,6 +344,22 @@ class CarlaControlServerTCP(Server):
         self.host._setViaCallback(action, pluginId, value1, value2, value3, valuef, valueStr)
         engineCallback(self.host, action, pluginId, value1, value2, value3, valuef, valueStr)
 
+    @make_method('/ctrl/patchbay', 'iis')
+    def carla_patchbay(self, path, args):
+        if DEBUG: print(path, args[:2])
+        self.fReceivedMsgs = True
+        index, last, chunk = args
+
+        if index == 0:
+            self.fPatchbaySnapshot = []
+
+        self.fPatchbaySnapshot.append(chunk)
+
+        if last:
+            snapshot = "".join(self.fPatchbaySnapshot)
+            self.fPatchbaySnapshot = []
+            patchbaySnapshotCallback(self.host, snapshot)
+
     @make_method('/ctrl/info', 'iiiihiisssssss')
     def carla_info(self, path, args):
         if DEBUG: print(path, args)
@@ -555,6 +575,12 @@ class CarlaControlServerUDP(Server):
         pluginId, in1, in2, out1, out2 = args
         self.host._set_peaks(pluginId, in1, in2, out1, out2)
 
+    @make_method('/ctrl/cputime', 'ihfffff')
+    def carla_cputime(self, path, args):
+        self.fReceivedMsgs = True
+        pluginId, count, minUsecs, avgUsecs, maxUsecs, p99Usecs, avgSubBlocks = args
+        self.host._set_plugin_process_time_info(pluginId, count, minUsecs, avgUsecs, maxUsecs, p99Usecs, avgSubBlocks)
+
     @make_method(None, None)
     def fallback(self, path, args):
         print("ControlServerUDP::fallback(\"%s\") - unknown message, args =" % path, args)
@@ -398,6 +398,7 @@ struct JackApplicationW::PrivateData {
         ui.cb_manage_window->setChecked(settings.valueBool("ManageWindow", true));
         ui.cb_capture_first_window->setChecked(settings.valueBool("CaptureFirstWindow", false));
         ui.cb_out_midi_mixdown->setChecked(settings.valueBool("MidiOutMixdown", false));
+        ui.cb_parallel_clients->setChecked(settings.valueBool("ParallelClients", false));
 
         checkIfButtonBoxShouldBeEnabled(ui.cb_session_mgr->currentIndex(), ui.le_command->text());
     }
@@ -415,6 +416,7 @@ struct JackApplicationW::PrivateData {
         settings.setValue("ManageWindow", ui.cb_manage_window->isChecked());
         settings.setValue("CaptureFirstWindow", ui.cb_capture_first_window->isChecked());
         settings.setValue("MidiOutMixdown", ui.cb_out_midi_mixdown->isChecked());
+        settings.setValue("ParallelClients", ui.cb_parallel_clients->isChecked());
     }
 
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PrivateData)
@@ -471,6 +473,8 @@ void JackApplicationW::getCommandAndFlags(QString& command, QString& name, QStri
         flags |= LIBJACK_FLAG_CONTROL_WINDOW;
     if (self->ui.cb_capture_first_window->isChecked())
         flags |= LIBJACK_FLAG_CAPTURE_FIRST_WINDOW;
+    if (self->ui.cb_parallel_clients->isChecked())
+        flags |= LIBJACK_FLAG_PARALLEL_CLIENTS;
     if (self->ui.cb_buffers_addition_mode->isChecked())
         flags |= LIBJACK_FLAG_AUDIO_BUFFERS_ADDITION;
     if (self->ui.cb_out_midi_mixdown->isChecked())
@@ -20,7 +20,10 @@
 # Imports (Global)
 
 from copy import deepcopy
+from queue import Empty, Queue
 from subprocess import Popen, PIPE
+from threading import Lock, Thread
+from time import monotonic
 
 from PyQt5.QtCore import pyqtSignal, pyqtSlot, Qt, QByteArray, QEventLoop, QThread
 from PyQt5.QtGui import QPixmap
@@ -37,6 +40,9 @@ from carla_backend import *
 from carla_shared import *
 from carla_utils import getPluginTypeAsString, getPluginCategoryAsString
 
+if not WINDOWS:
+    from signal import SIGKILL
+
 # ---------------------------------------------------------------------------------------------------------------------
 # Try Import LADSPA-RDF
 
@@ -159,7 +165,11 @@ PyPluginInfo = {
     'parameters.outs': 0
 }
 
-gDiscoveryProcess = None
+# Number of files handed to a single carla-discovery process in batch mode
+DISCOVERY_BATCH_SIZE = 16
+
+gDiscoveryProcesses = []
+gDiscoveryProcessesLock = Lock()
 
 def findWinePrefix(filename, recursionLimit = 10):
     if recursionLimit == 0 or len(filename) < 5 or "/" not in filename:
@@ -172,11 +182,25 @@ def findWinePrefix(filename, recursionLimit = 10):
 
     return findWinePrefix(path, recursionLimit-1)
 
-def runCarlaDiscovery(itype, stype, filename, tool, wineSettings=None):
-    if not os.path.exists(tool):
-        qWarning("runCarlaDiscovery() - tool '%s' does not exist" % tool)
-        return
+def getDiscoveryWinePrefix(filename, wineSettings):
+    if wineSettings['autoPrefix']:
+        winePrefix = findWinePrefix(filename)
+    else:
+        winePrefix = ""
+
+    if not winePrefix:
+        envWinePrefix = os.getenv("WINEPREFIX")
+
+        if envWinePrefix:
+            winePrefix = envWinePrefix
+        elif wineSettings['fallbackPrefix']:
+            winePrefix = os.path.expanduser(wineSettings['fallbackPrefix'])
+        else:
+            winePrefix = os.path.expanduser("~/.wine")
 
+    return winePrefix
+
+def getDiscoveryCommand(tool, filename, wineSettings):
     command = []
 
     if LINUX or MACOS:
@@ -186,147 +210,207 @@ def runCarlaDiscovery(itype, stype, filename, tool, wineSettings=None):
         if wineSettings is not None:
             command.append("WINEDEBUG=-all")
 
-            if wineSettings['autoPrefix']:
-                winePrefix = findWinePrefix(filename)
-            else:
-                winePrefix = ""
-
-            if not winePrefix:
-                envWinePrefix = os.getenv("WINEPREFIX")
-
-                if envWinePrefix:
-                    winePrefix = envWinePrefix
-                elif wineSettings['fallbackPrefix']:
-                    winePrefix = os.path.expanduser(wineSettings['fallbackPrefix'])
-                else:
-                    winePrefix = os.path.expanduser("~/.wine")
-
             wineCMD = wineSettings['executable'] if wineSettings['executable'] else "wine"
 
             if tool.endswith("64.exe") and os.path.exists(wineCMD + "64"):
                 wineCMD += "64"
 
-            command.append("WINEPREFIX=" + winePrefix)
+            command.append("WINEPREFIX=" + getDiscoveryWinePrefix(filename, wineSettings))
             command.append(wineCMD)
 
     command.append(tool)
-    command.append(stype)
-    command.append(filename)
+    return command
 
-    global gDiscoveryProcess
-    gDiscoveryProcess = Popen(command, stdout=PIPE)
+def startDiscoveryProcess(command, stdin=None):
+    # use a new session on posix systems, so that killDiscovery() also reaches batch mode children
+    process = Popen(command, stdin=stdin, stdout=PIPE, start_new_session=not WINDOWS)
 
-    pinfo = None
-    plugins = []
-    fakeLabel = os.path.basename(filename).rsplit(".", 1)[0]
+    with gDiscoveryProcessesLock:
+        gDiscoveryProcesses.append(process)
+
+    return process
+
+def stopDiscoveryProcess(process):
+    with gDiscoveryProcessesLock:
+        if process in gDiscoveryProcesses:
+            gDiscoveryProcesses.remove(process)
 
+def readDiscoveryLines(process):
     while True:
         try:
-            line = gDiscoveryProcess.stdout.readline().decode("utf-8", errors="ignore")
+            line = process.stdout.readline().decode("utf-8", errors="ignore")
         except:
             print("ERROR: discovery readline failed")
             break
 
         # line is valid, strip it
         if line:
-            line = line.strip()
+            yield line.strip()
 
         # line is invalid, try poll() again
-        elif gDiscoveryProcess.poll() is None:
+        elif process.poll() is None:
             continue
 
         # line is invalid and poll() failed, stop here
         else:
             break
 
-        if line == "carla-discovery::init::-----------":
-            pinfo = deepcopy(PyPluginInfo)
-            pinfo['type']     = itype
-            pinfo['filename'] = filename if filename != ":all" else ""
-
-        elif line == "carla-discovery::end::------------":
-            if pinfo is not None:
-                plugins.append(pinfo)
-                del pinfo
-                pinfo = None
+def handleDiscoveryLine(itype, filename, line, pinfo, plugins):
+    if line == "carla-discovery::init::-----------":
+        pinfo = deepcopy(PyPluginInfo)
+        pinfo['type']     = itype
+        pinfo['filename'] = filename if filename != ":all" else ""
 
-        elif line == "Segmentation fault":
-            print("carla-discovery::crash::%s crashed during discovery" % filename)
+    elif line == "carla-discovery::end::------------":
+        if pinfo is not None:
+            plugins.append(pinfo)
+            pinfo = None
 
-        elif line.startswith("err:module:import_dll Library"):
-            print(line)
+    elif line == "Segmentation fault":
+        print("carla-discovery::crash::%s crashed during discovery" % filename)
 
-        elif line.startswith("carla-discovery::info::"):
-            print("%s - %s" % (line, filename))
+    elif line.startswith("err:module:import_dll Library"):
+        print(line)
 
-        elif line.startswith("carla-discovery::warning::"):
-            print("%s - %s" % (line, filename))
+    elif line.startswith("carla-discovery::info::"):
+        print("%s - %s" % (line, filename))
 
-        elif line.startswith("carla-discovery::error::"):
-            print("%s - %s" % (line, filename))
+    elif line.startswith("carla-discovery::warning::"):
+        print("%s - %s" % (line, filename))
 
-        elif line.startswith("carla-discovery::"):
-            if pinfo == None:
-                continue
+    elif line.startswith("carla-discovery::error::"):
+        print("%s - %s" % (line, filename))
 
-            try:
-                prop, value = line.replace("carla-discovery::", "").split("::", 1)
-            except:
-                continue
+    elif line.startswith("carla-discovery::"):
+        if pinfo is None:
+            return None
 
-            if prop == "build":
-                if value.isdigit(): pinfo['build'] = int(value)
-            elif prop == "name":
-                pinfo['name'] = value if value else fakeLabel
-            elif prop == "label":
-                pinfo['label'] = value if value else fakeLabel
-            elif prop == "maker":
-                pinfo['maker'] = value
-            elif prop == "category":
-                pinfo['category'] = value
-            elif prop == "uniqueId":
-                if value.isdigit(): pinfo['uniqueId'] = int(value)
-            elif prop == "hints":
-                if value.isdigit(): pinfo['hints'] = int(value)
-            elif prop == "audio.ins":
-                if value.isdigit(): pinfo['audio.ins'] = int(value)
-            elif prop == "audio.outs":
-                if value.isdigit(): pinfo['audio.outs'] = int(value)
-            elif prop == "cv.ins":
-                if value.isdigit(): pinfo['cv.ins'] = int(value)
-            elif prop == "cv.outs":
-                if value.isdigit(): pinfo['cv.outs'] = int(value)
-            elif prop == "midi.ins":
-                if value.isdigit(): pinfo['midi.ins'] = int(value)
-            elif prop == "midi.outs":
-                if value.isdigit(): pinfo['midi.outs'] = int(value)
-            elif prop == "parameters.ins":
-                if value.isdigit(): pinfo['parameters.ins'] = int(value)
-            elif prop == "parameters.outs":
-                if value.isdigit(): pinfo['parameters.outs'] = int(value)
-            elif prop == "uri":
-                if value:
-                    pinfo['label'] = value
-                else:
-                    # cannot use empty URIs
-                    del pinfo
-                    pinfo = None
-                    continue
+        try:
+            prop, value = line.replace("carla-discovery::", "").split("::", 1)
+        except:
+            return pinfo
+
+        fakeLabel = os.path.basename(filename).rsplit(".", 1)[0]
+
+        if prop == "build":
+            if value.isdigit(): pinfo['build'] = int(value)
+        elif prop == "name":
+            pinfo['name'] = value if value else fakeLabel
+        elif prop == "label":
+            pinfo['label'] = value if value else fakeLabel
+        elif prop == "maker":
+            pinfo['maker'] = value
+        elif prop == "category":
+            pinfo['category'] = value
+        elif prop == "uniqueId":
+            if value.isdigit(): pinfo['uniqueId'] = int(value)
+        elif prop == "hints":
+            if value.isdigit(): pinfo['hints'] = int(value)
+        elif prop == "audio.ins":
+            if value.isdigit(): pinfo['audio.ins'] = int(value)
+        elif prop == "audio.outs":
+            if value.isdigit(): pinfo['audio.outs'] = int(value)
+        elif prop == "cv.ins":
+            if value.isdigit(): pinfo['cv.ins'] = int(value)
+        elif prop == "cv.outs":
+            if value.isdigit(): pinfo['cv.outs'] = int(value)
+        elif prop == "midi.ins":
+            if value.isdigit(): pinfo['midi.ins'] = int(value)
+        elif prop == "midi.outs":
+            if value.isdigit(): pinfo['midi.outs'] = int(value)
+        elif prop == "parameters.ins":
+            if value.isdigit(): pinfo['parameters.ins'] = int(value)
+        elif prop == "parameters.outs":
+            if value.isdigit(): pinfo['parameters.outs'] = int(value)
+        elif prop == "uri":
+            if value:
+                pinfo['label'] = value
             else:
-                print("%s - %s (unknown property)" % (line, filename))
+                # cannot use empty URIs
+                pinfo = None
+        else:
+            print("%s - %s (unknown property)" % (line, filename))
+
+    return pinfo
+
+def runCarlaDiscovery(itype, stype, filename, tool, wineSettings=None):
+    if not os.path.exists(tool):
+        qWarning("runCarlaDiscovery() - tool '%s' does not exist" % tool)
+        return
+
+    command = getDiscoveryCommand(tool, filename, wineSettings)
+    command.append(stype)
+    command.append(filename)
 
-    # FIXME?
-    tmp = gDiscoveryProcess
-    gDiscoveryProcess = None
-    del gDiscoveryProcess, tmp
+    process = startDiscoveryProcess(command)
 
+    pinfo = None
+    plugins = []
+
+    for line in readDiscoveryLines(process):
+        pinfo = handleDiscoveryLine(itype, filename, line, pinfo, plugins)
+
+    stopDiscoveryProcess(process)
     return plugins
 
+# Check several files using a single carla-discovery process.
+# Returns a dict of filename -> plugins for every file the tool started on,
+# plugins is None if the tool died (crashed or killed) while checking that file.
+def runCarlaDiscoveryBatch(itype, stype, filenames, tool, wineSettings=None):
+    if not os.path.exists(tool):
+        qWarning("runCarlaDiscoveryBatch() - tool '%s' does not exist" % tool)
+        return dict((filename, []) for filename in filenames)
+
+    command = getDiscoveryCommand(tool, filenames[0], wineSettings)
+    command.append(stype)
+    command.append(":batch")
+
+    process = startDiscoveryProcess(command, PIPE)
+
+    try:
+        process.stdin.write("".join("%s\n" % filename for filename in filenames).encode("utf-8"))
+        process.stdin.close()
+    except:
+        pass
+
+    results  = {}
+    filename = None
+    pinfo    = None
+    plugins  = []
+
+    for line in readDiscoveryLines(process):
+        if line.startswith("carla-discovery::file::"):
+            filename = line.replace("carla-discovery::file::", "", 1)
+            pinfo    = None
+            plugins  = []
+
+        elif line.startswith("carla-discovery::done::"):
+            if filename is not None:
+                results[filename] = plugins
+                filename = None
+
+        elif filename is not None:
+            pinfo = handleDiscoveryLine(itype, filename, line, pinfo, plugins)
+
+    stopDiscoveryProcess(process)
+
+    if filename is not None:
+        print("carla-discovery::crash::%s crashed during discovery" % filename)
+        results[filename] = None
+
+    return results
+
 def killDiscovery():
-    global gDiscoveryProcess
+    with gDiscoveryProcessesLock:
+        for process in gDiscoveryProcesses:
+            if WINDOWS:
+                process.kill()
+                continue
 
-    if gDiscoveryProcess is not None:
-        gDiscoveryProcess.kill()
+            try:
+                os.killpg(process.pid, SIGKILL)
+            except OSError:
+                process.kill()
 
 def checkPluginCached(desc, ptype):
     pinfo = deepcopy(PyPluginInfo)
@@ -383,11 +467,175 @@ def checkFileSFZ(filename, tool):
 def checkAllPluginsAU(tool):
     return runCarlaDiscovery(PLUGIN_AU, "AU", ":all", tool)
 
+# ---------------------------------------------------------------------------------------------------------------------
+# Parallel Plugin Query, with persistent cache
+
+# Maximum number of carla-discovery processes running at the same time
+DISCOVERY_MAX_WORKERS = max(1, os.cpu_count() or 1)
+
+# Seconds between checkpoints of a running search, see DiscoveryScheduler.run()
+DISCOVERY_CHECKPOINT_INTERVAL = 1.0
+
+# Returns [mtime, size] of a plugin file or bundle, or None if it cannot be read.
+# Bundles use the newest mtime and total size of their contents.
+def getDiscoveryFileStamp(filename):
+    try:
+        stat = os.stat(filename)
+
+        if not os.path.isdir(filename):
+            return [stat.st_mtime, stat.st_size]
+
+        mtime = stat.st_mtime
+        size  = 0
+
+        for root, dirs, files in os.walk(filename):
+            for name in files:
+                stat   = os.stat(os.path.join(root, name))
+                mtime  = max(mtime, stat.st_mtime)
+                size  += stat.st_size
+
+        return [mtime, size]
+
+    except OSError:
+        return None
+
+class DiscoveryScheduler(object):
+    def __init__(self, itype, stype, tool, wineSettings, cache):
+        self.fType  = itype
+        self.fSType = stype
+        self.fTool  = tool
+        self.fWineSettings = wineSettings
+
+        # filename -> [mtime, size, plugins]
+        self.fCache = cache
+
+        self.fPending     = []
+        self.fPendingLock = Lock()
+        self.fFinished    = Queue()
+        self.fStopped     = False
+
+    # Check all files, skipping those whose cache entry is still valid.
+    # progress(ratio, filename) is called from the current thread after each file,
+    # returning False from continueChecking() stops the search.
+    # checkpoint(plugins) is called regularly and once at the end with the plugin lists found since the last call,
+    # the cache is up to date at that point so it can be saved, letting an interrupted search resume from there.
+    # Returns the plugin lists of each file that has any, in the same order as filenames.
+    def run(self, filenames, progress, continueChecking, checkpoint=None):
+        results = {}
+        stamps  = {}
+
+        for filename in filenames:
+            stamp  = getDiscoveryFileStamp(filename)
+            cached = self.fCache.get(filename, None)
+
+            if stamp is not None and cached is not None and list(cached[:2]) == stamp:
+                results[filename] = cached[2]
+            else:
+                stamps[filename] = stamp
+
+        wanted = set(filenames)
+
+        for filename in tuple(self.fCache.keys()):
+            if filename not in wanted:
+                self.fCache.pop(filename)
+
+        self._schedule([filename for filename in filenames if filename in stamps])
+
+        workers = []
+        for _ in range(min(DISCOVERY_MAX_WORKERS, len(self.fPending))):
+            worker = Thread(target=self._worker)
+            worker.start()
+            workers.append(worker)
+
+        done  = len(results)
+        total = len(filenames)
+        found = []
+        lastCheckpoint = monotonic()
+
+        while any(worker.is_alive() for worker in workers) or not self.fFinished.empty():
+            if checkpoint is not None and monotonic() - lastCheckpoint >= DISCOVERY_CHECKPOINT_INTERVAL:
+                checkpoint(found)
+                found = []
+                lastCheckpoint = monotonic()
+
+            try:
+                filename, plugins = self.fFinished.get(timeout=0.05)
+            except Empty:
+                if not continueChecking():
+                    self.fStopped = True
+                continue
+
+            done += 1
+            progress(float(done) / total, filename)
+
+            # do not cache files which crashed or were skipped, they will be checked again next time
+            if plugins is None:
+                continue
+
+            results[filename] = plugins
+
+            if plugins:
+                found.append(plugins)
+
+            if stamps[filename] is not None:
+                self.fCache[filename] = stamps[filename] + [plugins]
+
+        for worker in workers:
+            worker.join()
+
+        if checkpoint is not None:
+            checkpoint(found)
+
+        return [results[filename] for filename in filenames if results.get(filename)]
+
+    def _schedule(self, filenames):
+        # files using different wine prefixes cannot share a discovery process
+        if self.fWineSettings is not None:
+            groups = {}
+            for filename in filenames:
+                groups.setdefault(getDiscoveryWinePrefix(filename, self.fWineSettings), []).append(filename)
+            groups = list(groups.values())
+        else:
+            groups = [filenames]
+
+        for group in groups:
+            for i in range(0, len(group), DISCOVERY_BATCH_SIZE):
+                self.fPending.append(group[i:i+DISCOVERY_BATCH_SIZE])
+
+    def _worker(self):
+        while not self.fStopped:
+            with self.fPendingLock:
+                if not self.fPending:
+                    return
+                filenames = self.fPending.pop(0)
+
+            results = runCarlaDiscoveryBatch(self.fType, self.fSType, filenames, self.fTool, self.fWineSettings)
+
+            # the tool did not even start, give up on these files
+            if not results:
+                for filename in filenames:
+                    self.fFinished.put((filename, None))
+                continue
+
+            remaining = []
+
+            for filename in filenames:
+                if filename in results:
+                    self.fFinished.put((filename, results[filename]))
+                else:
+                    remaining.append(filename)
+
+            # the tool died halfway, resume after the file that made it crash
+            if remaining:
+                with self.fPendingLock:
+                    self.fPending.insert(0, remaining)
+
 # ---------------------------------------------------------------------------------------------------------------------
 # Separate Thread for Plugin Search
 
 class SearchPluginsThread(QThread):
     pluginLook = pyqtSignal(int, str)
+    pluginsFound = pyqtSignal(str, list)
 
     def __init__(self, parent, pathBinaries):
         QThread.__init__(self, parent)
@@ -742,17 +990,7 @@ class SearchPluginsThread(QThread):
         if not self.fContinueChecking:
             return ladspaPlugins
 
-        for i in range(len(ladspaBinaries)):
-            ladspa  = ladspaBinaries[i]
-            percent = ( float(i) / len(ladspaBinaries) ) * self.fCurPercentValue
-            self._pluginLook((self.fLastCheckValue + percent) * 0.9, ladspa)
-
-            plugins = checkPluginLADSPA(ladspa, tool, self.fWineSettings if isWine else None)
-            if plugins:
-                ladspaPlugins.append(plugins)
-
-            if not self.fContinueChecking:
-                break
+        ladspaPlugins = self._runDiscovery(PLUGIN_LADSPA, "LADSPA", ladspaBinaries, tool, isWine, 0.9)
 
         self.fLastCheckValue += self.fCurPercentValue
         return ladspaPlugins
@@ -778,17 +1016,7 @@ class SearchPluginsThread(QThread):
         if not self.fContinueChecking:
             return dssiPlugins
 
-        for i in range(len(dssiBinaries)):
-            dssi    = dssiBinaries[i]
-            percent = ( float(i) / len(dssiBinaries) ) * self.fCurPercentValue
-            self._pluginLook(self.fLastCheckValue + percent, dssi)
-
-            plugins = checkPluginDSSI(dssi, tool, self.fWineSettings if isWine else None)
-            if plugins:
-                dssiPlugins.append(plugins)
-
-            if not self.fContinueChecking:
-                break
+        dssiPlugins = self._runDiscovery(PLUGIN_DSSI, "DSSI", dssiBinaries, tool, isWine)
 
         self.fLastCheckValue += self.fCurPercentValue
         return dssiPlugins
@@ -820,17 +1048,7 @@ class SearchPluginsThread(QThread):
         if not self.fContinueChecking:
             return vst2Plugins
 
-        for i in range(len(vst2Binaries)):
-            vst2    = vst2Binaries[i]
-            percent = ( float(i) / len(vst2Binaries) ) * self.fCurPercentValue
-            self._pluginLook(self.fLastCheckValue + percent, vst2)
-
-            plugins = checkPluginVST2(vst2, tool, self.fWineSettings if isWine else None)
-            if plugins:
-                vst2Plugins.append(plugins)
-
-            if not self.fContinueChecking:
-                break
+        vst2Plugins = self._runDiscovery(PLUGIN_VST2, "VST2", vst2Binaries, tool, isWine)
 
         self.fLastCheckValue += self.fCurPercentValue
         return vst2Plugins
@@ -862,17 +1080,7 @@ class SearchPluginsThread(QThread):
         if not self.fContinueChecking:
             return vst3Plugins
 
-        for i in range(len(vst3Binaries)):
-            vst3    = vst3Binaries[i]
-            percent = ( float(i) / len(vst3Binaries) ) * self.fCurPercentValue
-            self._pluginLook(self.fLastCheckValue + percent, vst3)
-
-            plugins = checkPluginVST3(vst3, tool, self.fWineSettings if isWine else None)
-            if plugins:
-                vst3Plugins.append(plugins)
-
-            if not self.fContinueChecking:
-                break
+        vst3Plugins = self._runDiscovery(PLUGIN_VST3, "VST3", vst3Binaries, tool, isWine)
 
         self.fLastCheckValue += self.fCurPercentValue
         return vst3Plugins
@@ -902,21 +1110,8 @@ class SearchPluginsThread(QThread):
         if not self.fContinueChecking:
             return kitPlugins
 
-        for i in range(len(kitFiles)):
-            kit     = kitFiles[i]
-            percent = ( float(i) / len(kitFiles) ) * self.fCurPercentValue
-            self._pluginLook(self.fLastCheckValue + percent, kit)
-
-            if kitExtension == "sf2":
-                plugins = checkFileSF2(kit, self.fToolNative)
-            else:
-                plugins = None
-
-            if plugins:
-                kitPlugins.append(plugins)
-
-            if not self.fContinueChecking:
-                break
+        if kitExtension == "sf2":
+            kitPlugins = self._runDiscovery(PLUGIN_SF2, "SF2", kitFiles, self.fToolNative, False)
 
         self.fLastCheckValue += self.fCurPercentValue
         return kitPlugins
@@ -994,6 +1189,28 @@ class SearchPluginsThread(QThread):
         self.fLastCheckValue += self.fCurPercentValue
         return sfzKits
 
+    def _runDiscovery(self, itype, stype, filenames, tool, isWine, progressScale=1.0):
+        settingsDB = QSafeSettings("falkTX", "CarlaPlugins5")
+        cacheKey   = "PluginCache/%s_%s" % (stype, os.path.basename(tool))
+        cache      = settingsDB.value(cacheKey, {}, dict)
+
+        def progress(ratio, filename):
+            self._pluginLook((self.fLastCheckValue + ratio * self.fCurPercentValue) * progressScale, filename)
+
+        def continueChecking():
+            return self.fContinueChecking
+
+        # save the cache as results come in, so a cancelled or crashed search does not lose them
+        def checkpoint(found):
+            settingsDB.setValue(cacheKey, cache)
+            settingsDB.sync()
+
+            if found:
+                self.pluginsFound.emit(stype, found)
+
+        scheduler = DiscoveryScheduler(itype, stype, tool, self.fWineSettings if isWine else None, cache)
+        return scheduler.run(filenames, progress, continueChecking, checkpoint)
+
     def _pluginLook(self, percent, plugin):
         self.pluginLook.emit(percent, plugin)
 
@@ -1001,6 +1218,8 @@ class SearchPluginsThread(QThread):
 # Plugin Refresh Dialog
 
 class PluginRefreshW(QDialog):
+    pluginsFound = pyqtSignal(str, list)
+
     def __init__(self, parent, host):
         QDialog.__init__(self, parent)
         self.host = host
@@ -1211,6 +1430,7 @@ class PluginRefreshW(QDialog):
         self.ui.ch_sfz.clicked.connect(self.slot_checkTools)
         self.fThread.pluginLook.connect(self.slot_handlePluginLook)
         self.fThread.finished.connect(self.slot_handlePluginThreadFinished)
+        self.fThread.pluginsFound.connect(self.pluginsFound)
 
         # -------------------------------------------------------------------------------------------------------------
         # Post-connect setup
@@ -1395,6 +1615,7 @@ class PluginDatabaseW(QDialog):
         # Internal stuff
 
         self.fLastTableIndex = 0
+        self.fTableKeys  = set()
         self.fRetPlugin  = None
         self.fRealParent = parent
         self.fFavoritePlugins = []
@@ -1654,12 +1875,37 @@ class PluginDatabaseW(QDialog):
 
     @pyqtSlot()
     def slot_refreshPlugins(self):
-        if PluginRefreshW(self, self.host).exec_():
+        dialog = PluginRefreshW(self, self.host)
+        dialog.pluginsFound.connect(self.slot_addFoundPlugins)
+
+        if dialog.exec_():
             self._reAddPlugins()
 
             if self.fRealParent:
                 self.fRealParent.setLoadRDFsNeeded()
 
+    # show plugins while a search is still running, the full list is loaded again once it finishes
+    @pyqtSlot(str, list)
+    def slot_addFoundPlugins(self, ptype, pluginLists):
+        plugins = []
+
+        for pluginList in pluginLists:
+            for plugin in pluginList:
+                if self._getPluginTableKey(plugin) not in self.fTableKeys:
+                    plugins.append(plugin)
+
+        if not plugins:
+            return
+
+        self.ui.tableWidget.setSortingEnabled(False)
+        self.ui.tableWidget.setRowCount(self.fLastTableIndex + len(plugins))
+
+        for plugin in plugins:
+            self._addPluginToTable(plugin, ptype)
+
+        self.ui.tableWidget.setSortingEnabled(True)
+        self._checkFilters()
+
     @pyqtSlot()
     def slot_clearFilters(self):
         self.blockSignals(True)
@@ -1995,6 +2241,10 @@ class PluginDatabaseW(QDialog):
         self.ui.tableWidget.item(index, self.TABLEWIDGET_ITEM_NAME).setData(Qt.UserRole+2, pluginText)
 
         self.fLastTableIndex += 1
+        self.fTableKeys.add(self._getPluginTableKey(plugin))
+
+    def _getPluginTableKey(self, plugin):
+        return (plugin['type'], plugin['build'], plugin['filename'], plugin['label'])
 
     # --------------------------------------------------------------------------------------------------------
 
@@ -2063,6 +2313,7 @@ class PluginDatabaseW(QDialog):
         settingsDB = QSafeSettings("falkTX", "CarlaPlugins5")
 
         self.fLastTableIndex = 0
+        self.fTableKeys.clear()
         self.ui.tableWidget.setSortingEnabled(False)
         self.ui.tableWidget.clearContents()
 
@@ -2226,6 +2477,7 @@ class JackApplicationW(QDialog):
 
     FLAG_CONTROL_WINDOW              = 0x01
     FLAG_CAPTURE_FIRST_WINDOW        = 0x02
+    FLAG_PARALLEL_CLIENTS            = 0x08
     FLAG_BUFFERS_ADDITION_MODE       = 0x10
     FLAG_MIDI_OUTPUT_CHANNEL_MIXDOWN = 0x20
     FLAG_EXTERNAL_START              = 0x40
@@ -2275,6 +2527,8 @@ class JackApplicationW(QDialog):
             flags |= self.FLAG_CONTROL_WINDOW
         if self.ui.cb_capture_first_window.isChecked():
             flags |= self.FLAG_CAPTURE_FIRST_WINDOW
+        if self.ui.cb_parallel_clients.isChecked():
+            flags |= self.FLAG_PARALLEL_CLIENTS
         if self.ui.cb_buffers_addition_mode.isChecked():
             flags |= self.FLAG_BUFFERS_ADDITION_MODE
         if self.ui.cb_out_midi_mixdown.isChecked():
@@ -2335,6 +2589,7 @@ class JackApplicationW(QDialog):
         self.ui.cb_manage_window.setChecked(settings.value("ManageWindow", True, bool))
         self.ui.cb_capture_first_window.setChecked(settings.value("CaptureFirstWindow", False, bool))
         self.ui.cb_out_midi_mixdown.setChecked(settings.value("MidiOutMixdown", False, bool))
+        self.ui.cb_parallel_clients.setChecked(settings.value("ParallelClients", False, bool))
 
         self.checkIfButtonBoxShouldBeEnabled(self.ui.cb_session_mgr.currentIndex(),
                                              self.ui.le_command.text())
@@ -2362,6 +2617,7 @@ class JackApplicationW(QDialog):
         settings.setValue("ManageWindow", self.ui.cb_manage_window.isChecked())
         settings.setValue("CaptureFirstWindow", self.ui.cb_capture_first_window.isChecked())
         settings.setValue("MidiOutMixdown", self.ui.cb_out_midi_mixdown.isChecked())
+        settings.setValue("ParallelClients", self.ui.cb_parallel_clients.isChecked())
 
 # ---------------------------------------------------------------------------------------------------------------------
 # Main
@@ -1207,32 +1207,48 @@ struct CarlaHostWindow::PrivateData {
         if (fPluginCount == 0 || fCurrentlyRemovingAllPlugins)
             return;
 
-        for (auto& pitem : fPluginList)
+        // fetch all peaks at once, instead of several calls per plugin
+        const CarlaRuntimeSnapshot* const snapshot = carla_get_runtime_snapshot(host.handle);
+        CARLA_SAFE_ASSERT_RETURN(snapshot != nullptr,);
+
+        const uint pluginCount = snapshot->pluginCount;
+
+        for (int i=0, count=fPluginList.size(); i<count; ++i)
         {
+            QWidget* const pitem = fPluginList[i];
+
             if (pitem == nullptr)
                 break;
+            if (static_cast<uint>(i) >= pluginCount)
+                break;
+
+            // items scrolled out of view get updated once visible again
+            if (pitem->visibleRegion().isEmpty())
+                continue;
 
             /*
-            pitem->getWidget().idleFast();
+            pitem->getWidget().idleFast(snapshot->peaks + i*4);
             */
         }
 
         for (uint pluginId : fSelectedPlugins)
         {
             fPeaksCleared = false;
+            if (pluginId >= pluginCount)
+                return;
+
+            const float* const peaks = snapshot->peaks + pluginId*4;
+
+            // meters only repaint when their level changes
             if (ui.peak_in->isVisible())
             {
-                /*
-                ui.peak_in->displayMeter(1, carla_get_input_peak_value(pluginId, true))
-                ui.peak_in->displayMeter(2, carla_get_input_peak_value(pluginId, false))
-                */
+                ui.peak_in->displayMeter(1, peaks[0]);
+                ui.peak_in->displayMeter(2, peaks[1]);
             }
             if (ui.peak_out->isVisible())
             {
-                /*
-                ui.peak_out->displayMeter(1, carla_get_output_peak_value(pluginId, true))
-                ui.peak_out->displayMeter(2, carla_get_output_peak_value(pluginId, false))
-                */
+                ui.peak_out->displayMeter(1, peaks[2]);
+                ui.peak_out->displayMeter(2, peaks[3]);
             }
             return;
         }
@@ -1241,12 +1257,10 @@ struct CarlaHostWindow::PrivateData {
             return;
 
         fPeaksCleared = true;
-        /*
-        ui.peak_in->displayMeter(1, 0.0, true);
-        ui.peak_in->displayMeter(2, 0.0, true);
-        ui.peak_out->displayMeter(1, 0.0, true);
-        ui.peak_out->displayMeter(2, 0.0, true);
-        */
+        ui.peak_in->displayMeter(1, 0.0f, true);
+        ui.peak_in->displayMeter(2, 0.0f, true);
+        ui.peak_out->displayMeter(1, 0.0f, true);
+        ui.peak_out->displayMeter(2, 0.0f, true);
     }
 
     void idleSlow()
@@ -47,9 +47,9 @@ from PyQt5.QtWidgets import QAction, QApplication, QInputDialog, QFileSystemMode
 import ui_carla_host
 
 from carla_app import *
+from carla_backend import *
 from carla_backend_qt import CarlaHostQtDLL, CarlaHostQtNull
-from carla_database import *
-from carla_settings import *
+from carla_shared import *
 from carla_utils import *
 from carla_widgets import *
 
@@ -209,6 +209,9 @@ class HostWindow(QMainWindow):
 
         self.fPeaksCleared = True
 
+        # output parameter values from the last runtime snapshot, as (pluginId, parameterId, value)
+        self.fOutputParameters = []
+
         self.fExternalPatchbay = False
         self.fSelectedPlugins  = []
 
@@ -933,6 +936,7 @@ class HostWindow(QMainWindow):
 
     @pyqtSlot()
     def slot_engineConfig(self):
+        from carla_settings import RuntimeDriverSettingsW
         dialog = RuntimeDriverSettingsW(self.fParentOrSelf, self.host)
 
         if not dialog.exec_():
@@ -1137,6 +1141,7 @@ class HostWindow(QMainWindow):
 
     def showAddPluginDialog(self):
         if self.fPluginDatabaseDialog is None:
+            from carla_database import PluginDatabaseW
             self.fPluginDatabaseDialog = PluginDatabaseW(self.fParentOrSelf, self.host)
         dialog = self.fPluginDatabaseDialog
 
@@ -1162,6 +1167,7 @@ class HostWindow(QMainWindow):
         return (btype, ptype, filename, label, uniqueId, extraPtr)
 
     def showAddJackAppDialog(self):
+        from carla_database import JackApplicationW
         dialog = JackApplicationW(self.fParentOrSelf, self.fProjectFilename)
 
         if not dialog.exec_():
@@ -1231,7 +1237,8 @@ class HostWindow(QMainWindow):
 
         btype, ptype, filename, label, uniqueId, extraPtr = data
 
-        if not self.host.add_plugin(btype, ptype, filename, None, label, uniqueId, extraPtr, PLUGIN_OPTIONS_NULL):
+        # loading errors after this point come through ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS
+        if not self.host.add_plugin_async(btype, ptype, filename, None, label, uniqueId, extraPtr, PLUGIN_OPTIONS_NULL):
             CustomMessageBox(self, QMessageBox.Critical, self.tr("Error"), self.tr("Failed to load plugin"),
                              self.host.get_last_error(), QMessageBox.Ok, QMessageBox.Ok)
 
@@ -1544,16 +1551,30 @@ class HostWindow(QMainWindow):
 
     @pyqtSlot()
     def slot_canvasRefresh(self):
+        patchcanvas.beginUpdate()
         patchcanvas.clear()
 
         if self.host.processMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK and self.host.isPlugin:
+            patchcanvas.endUpdate()
             return
 
         if self.host.is_engine_running():
-            self.host.patchbay_refresh(self.fExternalPatchbay)
+            self.refreshPatchbay()
+
+        patchcanvas.endUpdate()
 
         self.updateMiniCanvasLater()
 
+    def refreshPatchbay(self):
+        snapshot = self.host.patchbay_get_snapshot(self.fExternalPatchbay)
+
+        # remote hosts resend everything through callbacks instead
+        if snapshot is None:
+            self.host.patchbay_refresh(self.fExternalPatchbay)
+            return
+
+        patchbaySnapshotCallback(self.host, snapshot)
+
     @pyqtSlot()
     def slot_canvasZoomFit(self):
         self.scene.zoom_fit()
@@ -1976,6 +1997,7 @@ class HostWindow(QMainWindow):
 
     @pyqtSlot()
     def slot_configureCarla(self):
+        from carla_settings import CarlaSettingsW
         dialog = CarlaSettingsW(self.fParentOrSelf, self.host, True, hasGL)
         if not dialog.exec_():
             return
@@ -1990,7 +2012,7 @@ class HostWindow(QMainWindow):
         if self.host.processMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK and self.host.isPlugin:
             pass
         elif self.host.is_engine_running():
-            self.host.patchbay_refresh(self.fExternalPatchbay)
+            self.refreshPatchbay()
 
     # --------------------------------------------------------------------------------------------------------
     # About (menu actions)
@@ -2526,7 +2548,10 @@ class HostWindow(QMainWindow):
         self.fLadspaRdfNeedsUpdate = False
         self.fLadspaRdfList = []
 
-        if not haveLRDF:
+        # LADSPA-RDF support (and its env setup) lives with the plugin database
+        import carla_database
+
+        if not carla_database.haveLRDF:
             return
 
         settingsDir  = os.path.join(HOME, ".config", "falkTX")
@@ -2536,7 +2561,7 @@ class HostWindow(QMainWindow):
             frLadspa = open(frLadspaFile, 'r')
 
             try:
-                self.fLadspaRdfList = ladspa_rdf.get_c_ladspa_rdfs(json.load(frLadspa))
+                self.fLadspaRdfList = carla_database.ladspa_rdf.get_c_ladspa_rdfs(json.load(frLadspa))
             except:
                 pass
 
@@ -2649,20 +2674,33 @@ class HostWindow(QMainWindow):
         if self.fPluginCount == 0 or self.fCurrentlyRemovingAllPlugins:
             return
 
-        for pitem in self.fPluginList:
+        # fetch all peaks and output parameters at once, instead of several calls per plugin
+        snapshot = self.host.get_runtime_snapshot()
+        peaks    = snapshot['peaks']
+        self.fOutputParameters = snapshot['parameters']
+
+        for pluginId, pitem in enumerate(self.fPluginList):
             if pitem is None:
                 break
 
-            pitem.getWidget().idleFast()
+            widget = pitem.getWidget()
+
+            # items scrolled out of view get updated once visible again
+            if widget.visibleRegion().isEmpty():
+                continue
+
+            widget.idleFast(peaks[pluginId] if pluginId < len(peaks) else None)
 
         for pluginId in self.fSelectedPlugins:
             self.fPeaksCleared = False
+            if pluginId >= len(peaks):
+                return
             if self.ui.peak_in.isVisible():
-                self.ui.peak_in.displayMeter(1, self.host.get_input_peak_value(pluginId, True))
-                self.ui.peak_in.displayMeter(2, self.host.get_input_peak_value(pluginId, False))
+                self.ui.peak_in.displayMeter(1, peaks[pluginId][0])
+                self.ui.peak_in.displayMeter(2, peaks[pluginId][1])
             if self.ui.peak_out.isVisible():
-                self.ui.peak_out.displayMeter(1, self.host.get_output_peak_value(pluginId, True))
-                self.ui.peak_out.displayMeter(2, self.host.get_output_peak_value(pluginId, False))
+                self.ui.peak_out.displayMeter(1, peaks[pluginId][2])
+                self.ui.peak_out.displayMeter(2, peaks[pluginId][3])
             return
 
         if self.fPeaksCleared:
@@ -2680,11 +2718,16 @@ class HostWindow(QMainWindow):
         if self.fPluginCount == 0 or self.fCurrentlyRemovingAllPlugins:
             return
 
-        for pitem in self.fPluginList:
+        # output parameter values per plugin, taken from the snapshot of idleFast()
+        outputValues = {}
+        for pluginId, parameterId, value in self.fOutputParameters:
+            outputValues.setdefault(pluginId, {})[parameterId] = value
+
+        for pluginId, pitem in enumerate(self.fPluginList):
             if pitem is None:
                 break
 
-            pitem.getWidget().idleSlow()
+            pitem.getWidget().idleSlow(outputValues.get(pluginId, {}))
 
     def timerEvent(self, event):
         if event.timerId() == self.fIdleTimerFast:
@@ -2934,6 +2977,17 @@ def canvasCallback(action, value1, value2, valueStr):
         width, height = [int(v) for v in valueStr.split(":")]
         return host.render_inline_display(pluginId, width, height)
 
+# ------------------------------------------------------------------------------------------------------------
+# Patchbay snapshot, handled as the callbacks it replaces but laid out on the canvas in one go
+
+def patchbaySnapshotCallback(host, snapshot):
+    patchcanvas.beginUpdate()
+
+    for args in patchbaySnapshotToCallbacks(snapshot):
+        engineCallback(host, *args)
+
+    patchcanvas.endUpdate()
+
 # ------------------------------------------------------------------------------------------------------------
 # Engine callback
 
@@ -3022,6 +3076,18 @@ def engineCallback(host, action, pluginId, value1, value2, value3, valuef, value
         host.PatchbayConnectionAddedCallback.emit(pluginId, gOut, pOut, gIn, pIn)
     elif action == ENGINE_CALLBACK_PATCHBAY_CONNECTION_REMOVED:
         host.PatchbayConnectionRemovedCallback.emit(pluginId, value1, value2)
+    elif action == ENGINE_CALLBACK_PATCHBAY_BATCH:
+        patchbaySnapshotCallback(host, valueStr)
+    elif action == ENGINE_CALLBACK_PARAMETER_VALUES_CHANGED:
+        for record in valueStr.split("\n"):
+            if not record:
+                continue
+            recPluginId, recParameterId, recValue = record.split(":", 2)
+            host.ParameterValueChangedCallback.emit(int(recPluginId), int(recParameterId), float(recValue))
+    elif action == ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS:
+        # plugins show up through ENGINE_CALLBACK_PLUGIN_ADDED, only failures need handling here
+        if value2 < 0:
+            host.ErrorCallback.emit(valueStr)
     elif action == ENGINE_CALLBACK_ENGINE_STARTED:
         host.EngineStartedCallback.emit(pluginId, value1, value2, value3, valuef, valueStr)
     elif action == ENGINE_CALLBACK_ENGINE_STOPPED:
@@ -3366,6 +3432,7 @@ def setEngineSettings(host, oscPort = None):
     audioBufferSize = settings.value("%s%s/BufferSize" % (CARLA_KEY_ENGINE_DRIVER_PREFIX, audioDriver), CARLA_DEFAULT_AUDIO_BUFFER_SIZE, int)
     audioSampleRate = settings.value("%s%s/SampleRate" % (CARLA_KEY_ENGINE_DRIVER_PREFIX, audioDriver), CARLA_DEFAULT_AUDIO_SAMPLE_RATE, int)
     audioTripleBuffer = settings.value("%s%s/TripleBuffer" % (CARLA_KEY_ENGINE_DRIVER_PREFIX, audioDriver), CARLA_DEFAULT_AUDIO_TRIPLE_BUFFER, bool)
+    audioSecondaryDevice = settings.value("%s%s/SecondaryDevice" % (CARLA_KEY_ENGINE_DRIVER_PREFIX, audioDriver), "", str)
 
     # Only setup audio things if engine is not running
     if not host.is_engine_running():
@@ -3376,6 +3443,7 @@ def setEngineSettings(host, oscPort = None):
             host.set_engine_option(ENGINE_OPTION_AUDIO_BUFFER_SIZE, audioBufferSize, "")
             host.set_engine_option(ENGINE_OPTION_AUDIO_SAMPLE_RATE, audioSampleRate, "")
             host.set_engine_option(ENGINE_OPTION_AUDIO_TRIPLE_BUFFER, 1 if audioTripleBuffer else 0, "")
+            host.set_engine_option(ENGINE_OPTION_AUDIO_SECONDARY_DEVICE, 0, audioSecondaryDevice)
 
     # --------------------------------------------------------------------------------------------------------
     # fix things if needed
@@ -209,6 +209,15 @@ class DriverSettingsW(QDialog):
         for name in self.fDeviceNames:
             self.ui.cb_device.addItem(name)
 
+        # only RtAudio based drivers can open a secondary device
+        if driverName.startswith("JACK") or driverName in ("Dummy", "PulseAudio"):
+            self.ui.label_secondary_device.hide()
+            self.ui.cb_secondary_device.hide()
+        else:
+            self.ui.cb_secondary_device.addItem(self.tr("(None)"))
+            for name in self.fDeviceNames:
+                self.ui.cb_secondary_device.addItem(name)
+
         self.setWindowFlags(self.windowFlags() & ~Qt.WindowContextHelpButtonHint)
 
         # -------------------------------------------------------------------------------------------------------------
@@ -233,12 +242,18 @@ class DriverSettingsW(QDialog):
         audioBufferSize   = settings.value("%s%s/BufferSize"   % args, CARLA_DEFAULT_AUDIO_BUFFER_SIZE,   int)
         audioSampleRate   = settings.value("%s%s/SampleRate"   % args, CARLA_DEFAULT_AUDIO_SAMPLE_RATE,   int)
         audioTripleBuffer = settings.value("%s%s/TripleBuffer" % args, CARLA_DEFAULT_AUDIO_TRIPLE_BUFFER, bool)
+        secondaryDevice   = settings.value("%s%s/SecondaryDevice" % args, "",                             str)
 
         if audioDevice and audioDevice in self.fDeviceNames:
             self.ui.cb_device.setCurrentIndex(self.fDeviceNames.index(audioDevice))
         else:
             self.ui.cb_device.setCurrentIndex(-1)
 
+        if secondaryDevice and secondaryDevice in self.fDeviceNames:
+            self.ui.cb_secondary_device.setCurrentIndex(self.fDeviceNames.index(secondaryDevice) + 1)
+        else:
+            self.ui.cb_secondary_device.setCurrentIndex(0)
+
         # fill combo-boxes first
         self.slot_updateDeviceInfo()
 
@@ -278,6 +293,11 @@ class DriverSettingsW(QDialog):
         settings.setValue("%s%s/SampleRate"   % args, sampleRate)
         settings.setValue("%s%s/TripleBuffer" % args, self.ui.cb_triple_buffer.isChecked())
 
+        if self.ui.cb_secondary_device.currentIndex() > 0:
+            settings.setValue("%s%s/SecondaryDevice" % args, self.ui.cb_secondary_device.currentText())
+        else:
+            settings.setValue("%s%s/SecondaryDevice" % args, "")
+
     # -----------------------------------------------------------------------------------------------------------------
 
     @pyqtSlot()
@@ -352,6 +372,8 @@ class RuntimeDriverSettingsW(QDialog):
         self.ui.cb_buffersize.clear()
         self.ui.cb_samplerate.clear()
         self.ui.cb_triple_buffer.hide()
+        self.ui.label_secondary_device.hide()
+        self.ui.cb_secondary_device.hide()
         self.ui.ico_restart.hide()
         self.ui.label_restart.hide()
 
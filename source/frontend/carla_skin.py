@@ -945,12 +945,19 @@ class AbstractPluginSlot(QFrame, PluginEditParentMeta):
 
     # -----------------------------------------------------------------
 
-    def idleFast(self):
+    # peaks are (inL, inR, outL, outR), as returned by host.get_runtime_snapshot()
+    def idleFast(self, peaks=None):
+        if peaks is None:
+            peaks = (self.host.get_input_peak_value(self.fPluginId, True),
+                     self.host.get_input_peak_value(self.fPluginId, False),
+                     self.host.get_output_peak_value(self.fPluginId, True),
+                     self.host.get_output_peak_value(self.fPluginId, False))
+
         # Input peaks
         if self.fPeaksInputCount > 0:
             if self.fPeaksInputCount > 1:
-                peak1 = self.host.get_input_peak_value(self.fPluginId, True)
-                peak2 = self.host.get_input_peak_value(self.fPluginId, False)
+                peak1 = peaks[0]
+                peak2 = peaks[1]
                 ledState = bool(peak1 != 0.0 or peak2 != 0.0)
 
                 if self.peak_in is not None:
@@ -958,7 +965,7 @@ class AbstractPluginSlot(QFrame, PluginEditParentMeta):
                     self.peak_in.displayMeter(2, peak2)
 
             else:
-                peak = self.host.get_input_peak_value(self.fPluginId, True)
+                peak = peaks[0]
                 ledState = bool(peak != 0.0)
 
                 if self.peak_in is not None:
@@ -971,8 +978,8 @@ class AbstractPluginSlot(QFrame, PluginEditParentMeta):
         # Output peaks
         if self.fPeaksOutputCount > 0:
             if self.fPeaksOutputCount > 1:
-                peak1 = self.host.get_output_peak_value(self.fPluginId, True)
-                peak2 = self.host.get_output_peak_value(self.fPluginId, False)
+                peak1 = peaks[2]
+                peak2 = peaks[3]
                 ledState = bool(peak1 != 0.0 or peak2 != 0.0)
 
                 if self.peak_out is not None:
@@ -980,7 +987,7 @@ class AbstractPluginSlot(QFrame, PluginEditParentMeta):
                     self.peak_out.displayMeter(2, peak2)
 
             else:
-                peak = self.host.get_output_peak_value(self.fPluginId, True)
+                peak = peaks[2]
                 ledState = bool(peak != 0.0)
 
                 if self.peak_out is not None:
@@ -990,7 +997,8 @@ class AbstractPluginSlot(QFrame, PluginEditParentMeta):
                 self.fLastBlueLedState = ledState
                 self.led_audio_out.setChecked(ledState)
 
-    def idleSlow(self):
+    # outputValues maps output parameter ids to their values, as returned by host.get_runtime_snapshot()
+    def idleSlow(self, outputValues=None):
         if self.fParameterIconTimer == ICON_STATE_ON:
             self.parameterActivityChanged(True)
             self.fParameterIconTimer = ICON_STATE_WAIT
@@ -1002,7 +1010,17 @@ class AbstractPluginSlot(QFrame, PluginEditParentMeta):
             self.parameterActivityChanged(False)
             self.fParameterIconTimer = ICON_STATE_NULL
 
-        self.fEditDialog.idleSlow()
+        timeInfo = self.host.get_plugin_process_time_info(self.fPluginId)
+
+        if timeInfo['count'] > 0:
+            toolTip = self.tr("Process time: %.1f µs avg, %.1f µs p99, %.1f µs max") % (timeInfo['avgUsecs'],
+                                                                                     timeInfo['p99Usecs'],
+                                                                                     timeInfo['maxUsecs'])
+            if timeInfo['avgSubBlocks'] > 1.0:
+                toolTip += self.tr(", %.1f sub-blocks avg") % timeInfo['avgSubBlocks']
+            self.setToolTip(toolTip)
+
+        self.fEditDialog.idleSlow(outputValues)
 
     # -----------------------------------------------------------------
 
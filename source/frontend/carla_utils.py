@@ -26,9 +26,9 @@ from sys import argv
 # Imports (ctypes)
 
 from ctypes import (
-    c_bool, c_char_p, c_double, c_int, c_uint, c_uint32, c_void_p,
+    c_bool, c_char_p, c_double, c_int, c_int64, c_uint, c_uint32, c_void_p,
     cdll, Structure,
-    CFUNCTYPE, POINTER
+    CFUNCTYPE, POINTER, pointer
 )
 
 # ------------------------------------------------------------------------------------------------------------
@@ -219,6 +219,63 @@ class CarlaCachedPluginInfo(Structure):
         ("copyright", c_char_p)
     ]
 
+# Information about a plugin in the plugin index.
+# @see carla_plugin_index_get_info()
+class CarlaPluginIndexInfo(Structure):
+    _fields_ = [
+        # Plugin type.
+        ("type", c_enum),
+
+        # Binary type.
+        ("btype", c_enum),
+
+        # Plugin category.
+        ("category", c_enum),
+
+        # Plugin hints.
+        # @see PluginHints
+        ("hints", c_uint),
+
+        # Number of audio inputs.
+        ("audioIns", c_uint32),
+
+        # Number of audio outputs.
+        ("audioOuts", c_uint32),
+
+        # Number of CV inputs.
+        ("cvIns", c_uint32),
+
+        # Number of CV outputs.
+        ("cvOuts", c_uint32),
+
+        # Number of MIDI inputs.
+        ("midiIns", c_uint32),
+
+        # Number of MIDI outputs.
+        ("midiOuts", c_uint32),
+
+        # Number of input parameters.
+        ("parameterIns", c_uint32),
+
+        # Number of output parameters.
+        ("parameterOuts", c_uint32),
+
+        # Plugin unique Id, 0 if the plugin format does not have one.
+        ("uniqueId", c_int64),
+
+        # Plugin filename or bundle path.
+        ("filename", c_char_p),
+
+        # Plugin label, or URI for LV2 plugins.
+        ("label", c_char_p),
+
+        # Plugin name.
+        ("name", c_char_p),
+
+        # Plugin author/maker.
+        ("maker", c_char_p)
+    ]
+
 # ------------------------------------------------------------------------------------------------------------
 # Carla Utils API (Python compatible stuff)
 
@@ -267,6 +324,36 @@ class CarlaUtils():
         self.lib.carla_get_cached_plugin_info.argtypes = [c_enum, c_uint]
         self.lib.carla_get_cached_plugin_info.restype = POINTER(CarlaCachedPluginInfo)
 
+        self.lib.carla_plugin_index_clear.argtypes = None
+        self.lib.carla_plugin_index_clear.restype = None
+
+        self.lib.carla_plugin_index_add.argtypes = [POINTER(CarlaPluginIndexInfo)]
+        self.lib.carla_plugin_index_add.restype = c_bool
+
+        self.lib.carla_plugin_index_add_cached.argtypes = [c_enum, c_char_p]
+        self.lib.carla_plugin_index_add_cached.restype = c_uint
+
+        self.lib.carla_plugin_index_load.argtypes = [c_char_p]
+        self.lib.carla_plugin_index_load.restype = c_bool
+
+        self.lib.carla_plugin_index_save.argtypes = [c_char_p]
+        self.lib.carla_plugin_index_save.restype = c_bool
+
+        self.lib.carla_plugin_index_count.argtypes = None
+        self.lib.carla_plugin_index_count.restype = c_uint
+
+        self.lib.carla_plugin_index_get_info.argtypes = [c_uint]
+        self.lib.carla_plugin_index_get_info.restype = POINTER(CarlaPluginIndexInfo)
+
+        self.lib.carla_plugin_index_find_by_label.argtypes = [c_enum, c_char_p]
+        self.lib.carla_plugin_index_find_by_label.restype = c_int
+
+        self.lib.carla_plugin_index_find_by_unique_id.argtypes = [c_enum, c_int64]
+        self.lib.carla_plugin_index_find_by_unique_id.restype = c_int
+
+        self.lib.carla_plugin_index_find_by_name.argtypes = [c_char_p]
+        self.lib.carla_plugin_index_find_by_name.restype = c_int
+
         self.lib.carla_fflush.argtypes = [c_bool]
         self.lib.carla_fflush.restype = None
 
@@ -405,6 +492,54 @@ class CarlaUtils():
     def get_cached_plugin_info(self, ptype, index):
         return structToDict(self.lib.carla_get_cached_plugin_info(ptype, index).contents)
 
+    # Remove all plugins from the plugin index.
+    def plugin_index_clear(self):
+        self.lib.carla_plugin_index_clear()
+
+    # Add a plugin to the plugin index, replacing any previous entry with the same type and label.
+    def plugin_index_add(self, ptype, btype, filename, label, name, maker, uniqueId):
+        info = CarlaPluginIndexInfo()
+        info.type     = ptype
+        info.btype    = btype
+        info.uniqueId = uniqueId
+        info.filename = filename.encode("utf-8")
+        info.label    = label.encode("utf-8")
+        info.name     = name.encode("utf-8")
+        info.maker    = maker.encode("utf-8")
+        return bool(self.lib.carla_plugin_index_add(pointer(info)))
+
+    # Add all valid cached plugins of a type to the plugin index.
+    def plugin_index_add_cached(self, ptype, pluginPath):
+        return int(self.lib.carla_plugin_index_add_cached(ptype, pluginPath.encode("utf-8")))
+
+    # Load the plugin index from a file, replacing the current one.
+    def plugin_index_load(self, filename):
+        return bool(self.lib.carla_plugin_index_load(filename.encode("utf-8")))
+
+    # Save the plugin index to a file, in a compact binary format.
+    def plugin_index_save(self, filename):
+        return bool(self.lib.carla_plugin_index_save(filename.encode("utf-8")))
+
+    # Get how many plugins are in the plugin index.
+    def plugin_index_count(self):
+        return int(self.lib.carla_plugin_index_count())
+
+    # Get information about a plugin in the plugin index.
+    def plugin_index_get_info(self, index):
+        return structToDict(self.lib.carla_plugin_index_get_info(index).contents)
+
+    # Find a plugin in the plugin index by its label (URI for LV2 plugins), returns -1 if not found.
+    def plugin_index_find_by_label(self, ptype, label):
+        return int(self.lib.carla_plugin_index_find_by_label(ptype, label.encode("utf-8")))
+
+    # Find a plugin in the plugin index by its unique Id, returns -1 if not found.
+    def plugin_index_find_by_unique_id(self, ptype, uniqueId):
+        return int(self.lib.carla_plugin_index_find_by_unique_id(ptype, uniqueId))
+
+    # Find a plugin in the plugin index by its name, returns -1 if not found.
+    def plugin_index_find_by_name(self, name):
+        return int(self.lib.carla_plugin_index_find_by_name(name.encode("utf-8")))
+
     def fflush(self, err):
         self.lib.carla_fflush(err)
 
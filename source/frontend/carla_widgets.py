@@ -24,9 +24,10 @@ from abc import abstractmethod
 # ------------------------------------------------------------------------------------------------------------
 # Imports (PyQt5)
 
-from PyQt5.QtCore import pyqtSignal, pyqtSlot, Qt, QByteArray
+from PyQt5.QtCore import pyqtSignal, pyqtSlot, Qt, QAbstractListModel, QByteArray, QModelIndex, QPoint, QSize
 from PyQt5.QtGui import QCursor, QIcon, QPalette, QPixmap
-from PyQt5.QtWidgets import QDialog, QFileDialog, QInputDialog, QMenu, QMessageBox, QScrollArea, QVBoxLayout, QWidget
+from PyQt5.QtWidgets import QAbstractItemView, QAbstractScrollArea, QDialog, QFileDialog, QInputDialog, QListView
+from PyQt5.QtWidgets import QMenu, QMessageBox, QScrollArea, QVBoxLayout, QWidget
 
 # ------------------------------------------------------------------------------------------------------------
 # Imports (Custom)
@@ -103,6 +104,9 @@ ICON_STATE_WAIT = 2 # nothing, sets as off
 ICON_STATE_OFF  = 1 # turns off, sets as null
 ICON_STATE_NULL = 0 # nothing
 
+# parameter lists longer than this use PluginParameterListView, which only creates widgets for visible rows
+MAX_PARAMETER_WIDGETS_PER_TAB = 100
+
 # ------------------------------------------------------------------------------------------------------------
 # Carla About dialog
 
@@ -600,6 +604,284 @@ class PluginParameter(QWidget):
     def _valueCallBack(self, value):
         self.valueChanged.emit(self.fParameterId, value)
 
+# ------------------------------------------------------------------------------------------------------------
+# Plugin Parameter List (model)
+
+class PluginParameterListModel(QAbstractListModel):
+    def __init__(self, parent, paramList):
+        QAbstractListModel.__init__(self, parent)
+        self.fParamList = paramList
+        self.fRowSize   = QSize()
+
+    def getParameterInfo(self, row):
+        return self.fParamList[row]
+
+    def getRowSize(self):
+        return self.fRowSize
+
+    def setRowSize(self, size):
+        self.fRowSize = size
+
+    def rowCount(self, parent=QModelIndex()):
+        return 0 if parent.isValid() else len(self.fParamList)
+
+    def data(self, index, role=Qt.DisplayRole):
+        # rows are drawn by their PluginParameter widget, only their size matters here
+        if role == Qt.SizeHintRole and index.isValid():
+            return self.fRowSize
+        return None
+
+# ------------------------------------------------------------------------------------------------------------
+# Plugin Parameter List (view)
+
+# Shows a long list of parameters, creating PluginParameter widgets only for the rows currently visible.
+# The parameter info dicts are kept up to date so widgets can be re-created when scrolled back into view.
+class PluginParameterListView(QListView):
+    mappedControlChanged = pyqtSignal(int, int)
+    mappedRangeChanged   = pyqtSignal(int, float, float)
+    midiChannelChanged   = pyqtSignal(int, int)
+    valueChanged         = pyqtSignal(int, float)
+
+    # extra rows kept alive above and below the visible ones, to make scrolling smoother
+    kRowMargin = 4
+
+    def __init__(self, parent, host, paramList, labelWidth, pluginId, tabIndex):
+        QListView.__init__(self, parent)
+        self.host = host
+
+        # -------------------------------------------------------------
+        # Internal stuff
+
+        self.fLabelWidth = labelWidth
+        self.fPluginId   = pluginId
+        self.fTabIndex   = tabIndex
+        self.fWidgets    = {} # row -> widget
+        self.fRowsById   = dict((paramInfo['index'], row) for row, paramInfo in enumerate(paramList))
+
+        self.fModel = PluginParameterListModel(self, paramList)
+
+        # -------------------------------------------------------------
+        # Set-up GUI
+
+        self.setFrameStyle(0)
+        self.setModel(self.fModel)
+        self.setSelectionMode(QAbstractItemView.NoSelection)
+        self.setUniformItemSizes(True)
+        self.setVerticalScrollMode(QAbstractItemView.ScrollPerPixel)
+        self.setSpacing(1)
+
+        palette = self.palette()
+        palette.setColor(QPalette.Base, Qt.transparent)
+        self.setPalette(palette)
+
+        # the first row is always created, it gives the size for all the others
+        firstWidget = self._createWidget(0)
+        self.fModel.setRowSize(firstWidget.sizeHint())
+        self.setIndexWidget(self.fModel.index(0), firstWidget)
+        self.fWidgets[0] = firstWidget
+
+        # -------------------------------------------------------------
+        # Set-up connections
+
+        self.verticalScrollBar().valueChanged.connect(self.slot_updateVisibleRows)
+
+    # -----------------------------------------------------------------
+
+    def getTabIndex(self):
+        return self.fTabIndex
+
+    def setPluginId(self, pluginId):
+        self.fPluginId = pluginId
+
+        for widget in self.fWidgets.values():
+            widget.setPluginId(pluginId)
+
+    # -----------------------------------------------------------------
+    # per-parameter changes, return False if the parameter is not part of this list
+
+    def setParameterValue(self, parameterId, value):
+        row = self.fRowsById.get(parameterId, None)
+        if row is None:
+            return False
+
+        self.fModel.getParameterInfo(row)['current'] = value
+
+        widget = self.fWidgets.get(row, None)
+        if widget is not None:
+            widget.setValue(value)
+        return True
+
+    def setParameterDefault(self, parameterId, value):
+        row = self.fRowsById.get(parameterId, None)
+        if row is None:
+            return False
+
+        self.fModel.getParameterInfo(row)['default'] = value
+
+        widget = self.fWidgets.get(row, None)
+        if widget is not None:
+            widget.setDefault(value)
+        return True
+
+    def setParameterMappedControlIndex(self, parameterId, control):
+        row = self.fRowsById.get(parameterId, None)
+        if row is None:
+            return False
+
+        self.fModel.getParameterInfo(row)['mappedControlIndex'] = control
+
+        widget = self.fWidgets.get(row, None)
+        if widget is not None:
+            widget.setMappedControlIndex(control)
+        return True
+
+    def setParameterMappedRange(self, parameterId, minimum, maximum):
+        row = self.fRowsById.get(parameterId, None)
+        if row is None:
+            return False
+
+        paramInfo = self.fModel.getParameterInfo(row)
+        paramInfo['mappedMinimum'] = minimum
+        paramInfo['mappedMaximum'] = maximum
+
+        widget = self.fWidgets.get(row, None)
+        if widget is not None:
+            widget.setMappedRange(minimum, maximum)
+        return True
+
+    def setParameterMidiChannel(self, parameterId, channel):
+        row = self.fRowsById.get(parameterId, None)
+        if row is None:
+            return False
+
+        self.fModel.getParameterInfo(row)['midiChannel'] = channel
+
+        widget = self.fWidgets.get(row, None)
+        if widget is not None:
+            widget.setMidiChannel(channel)
+        return True
+
+    # -----------------------------------------------------------------
+    # value updates, done in bulk
+
+    def updateAllValues(self):
+        self._updateValues(0, self.fModel.rowCount()-1)
+
+    def updateVisibleValues(self, outputValues=None):
+        firstRow, lastRow = self._getVisibleRows()
+        self._updateValues(firstRow, lastRow, outputValues)
+
+    # -----------------------------------------------------------------
+
+    @pyqtSlot()
+    def slot_updateVisibleRows(self):
+        firstRow, lastRow = self._getVisibleRows()
+        firstRow = max(0, firstRow - self.kRowMargin)
+        lastRow  = min(self.fModel.rowCount()-1, lastRow + self.kRowMargin)
+
+        # remove widgets that went out of view, the first row is kept for its size
+        for row in [row for row in self.fWidgets if row != 0 and (row < firstRow or row > lastRow)]:
+            del self.fWidgets[row]
+            self.setIndexWidget(self.fModel.index(row), None)
+
+        newRows = [row for row in range(firstRow, lastRow+1) if row not in self.fWidgets]
+
+        if not newRows:
+            return
+
+        # get fresh values for the new rows at once, then create their widgets
+        self._updateValues(newRows[0], newRows[-1])
+
+        for row in newRows:
+            widget = self._createWidget(row)
+            self.setIndexWidget(self.fModel.index(row), widget)
+            self.fWidgets[row] = widget
+
+    @pyqtSlot(int, float)
+    def slot_widgetValueChanged(self, parameterId, value):
+        self.fModel.getParameterInfo(self.fRowsById[parameterId])['current'] = value
+        self.valueChanged.emit(parameterId, value)
+
+    @pyqtSlot(int, int)
+    def slot_widgetMappedControlChanged(self, parameterId, control):
+        self.fModel.getParameterInfo(self.fRowsById[parameterId])['mappedControlIndex'] = control
+        self.mappedControlChanged.emit(parameterId, control)
+
+    @pyqtSlot(int, float, float)
+    def slot_widgetMappedRangeChanged(self, parameterId, minimum, maximum):
+        paramInfo = self.fModel.getParameterInfo(self.fRowsById[parameterId])
+        paramInfo['mappedMinimum'] = minimum
+        paramInfo['mappedMaximum'] = maximum
+        self.mappedRangeChanged.emit(parameterId, minimum, maximum)
+
+    @pyqtSlot(int, int)
+    def slot_widgetMidiChannelChanged(self, parameterId, channel):
+        self.fModel.getParameterInfo(self.fRowsById[parameterId])['midiChannel'] = channel
+        self.midiChannelChanged.emit(parameterId, channel)
+
+    # -----------------------------------------------------------------
+
+    def resizeEvent(self, event):
+        QListView.resizeEvent(self, event)
+        self.slot_updateVisibleRows()
+
+    def showEvent(self, event):
+        QListView.showEvent(self, event)
+        self.slot_updateVisibleRows()
+
+    # -----------------------------------------------------------------
+
+    def _createWidget(self, row):
+        widget = PluginParameter(self.viewport(), self.host, self.fModel.getParameterInfo(row),
+                                 self.fPluginId, self.fTabIndex)
+        widget.setLabelWidth(self.fLabelWidth)
+        widget.valueChanged.connect(self.slot_widgetValueChanged)
+        widget.mappedControlChanged.connect(self.slot_widgetMappedControlChanged)
+        widget.mappedRangeChanged.connect(self.slot_widgetMappedRangeChanged)
+        widget.midiChannelChanged.connect(self.slot_widgetMidiChannelChanged)
+        return widget
+
+    def _getVisibleRows(self):
+        rowCount = self.fModel.rowCount()
+        firstRow = self.indexAt(QPoint(1, 1)).row()
+        lastRow  = self.indexAt(QPoint(1, self.viewport().height()-2)).row()
+
+        if firstRow < 0:
+            firstRow = 0
+
+        # past the last row, or not laid out yet; estimate from the row size, never create all widgets
+        if lastRow < 0:
+            rowHeight = max(1, self.fModel.getRowSize().height() + self.spacing()*2)
+            lastRow   = min(rowCount-1, firstRow + self.viewport().height() // rowHeight)
+
+        return (firstRow, lastRow)
+
+    def _updateValues(self, firstRow, lastRow, outputValues=None):
+        if firstRow > lastRow:
+            return
+
+        paramInfos = [self.fModel.getParameterInfo(row) for row in range(firstRow, lastRow+1)]
+
+        # use the values from the runtime snapshot if it has all of them, otherwise ask the host
+        if outputValues and all(paramInfo['index'] in outputValues for paramInfo in paramInfos):
+            paramValues = outputValues
+        else:
+            firstId     = min(paramInfo['index'] for paramInfo in paramInfos)
+            lastId      = max(paramInfo['index'] for paramInfo in paramInfos)
+            values      = self.host.get_current_parameter_values(self.fPluginId, firstId, lastId-firstId+1)
+            paramValues = dict((firstId+i, value) for i, value in enumerate(values))
+
+        for row, paramInfo in enumerate(paramInfos, firstRow):
+            value = paramValues.get(paramInfo['index'], None)
+            if value is None:
+                continue
+
+            paramInfo['current'] = value
+
+            widget = self.fWidgets.get(row, None)
+            if widget is not None:
+                widget.setValue(value)
+
 # ------------------------------------------------------------------------------------------------------------
 # Plugin Editor Parent (Meta class)
 
@@ -664,6 +946,7 @@ class PluginEdit(QDialog):
         self.fFirstInit      = True
 
         self.fParameterList      = [] # (type, id, widget)
+        self.fParameterViews     = [] # (type, view)
         self.fParametersToUpdate = [] # (id, value)
 
         self.fPlayingNotes = [] # (channel, note)
@@ -875,6 +1158,9 @@ class PluginEdit(QDialog):
             paramWidget.setValue(self.host.get_current_parameter_value(self.fPluginId, paramId))
             paramWidget.blockSignals(False)
 
+        for _, paramView in self.fParameterViews:
+            paramView.updateAllValues()
+
         # and the internal ones too
         self.ui.dial_drywet.blockSignals(True)
         self.ui.dial_drywet.setValue(self.host.get_internal_parameter_value(self.fPluginId, PARAMETER_DRYWET))
@@ -1009,13 +1295,14 @@ class PluginEdit(QDialog):
     def reloadParameters(self):
         # Reset
         self.fParameterList      = []
+        self.fParameterViews     = []
         self.fParametersToUpdate = []
         self.fTabIconTimers      = []
 
         # Save current tab state
         tabIndex  = self.ui.tabWidget.currentIndex()
         tabWidget = self.ui.tabWidget.currentWidget()
-        scrollVal = tabWidget.verticalScrollBar().value() if isinstance(tabWidget, QScrollArea) else None
+        scrollVal = tabWidget.verticalScrollBar().value() if isinstance(tabWidget, QAbstractScrollArea) else None
         del tabWidget
 
         # Remove all previous parameters
@@ -1196,6 +1483,9 @@ class PluginEdit(QDialog):
     def setPluginId(self, idx):
         self.fPluginId = idx
 
+        for _, paramView in self.fParameterViews:
+            paramView.setPluginId(idx)
+
     def setName(self, name):
         self.fPluginInfo['name'] = name
         self.ui.label_plugin.setText("\n%s\n" % name)
@@ -1215,25 +1505,41 @@ class PluginEdit(QDialog):
         for _, paramId, paramWidget in self.fParameterList:
             if paramId == parameterId:
                 paramWidget.setDefault(value)
-                break
+                return
+
+        for _, paramView in self.fParameterViews:
+            if paramView.setParameterDefault(parameterId, value):
+                return
 
     def setParameterMappedControlIndex(self, parameterId, control):
         for _, paramId, paramWidget in self.fParameterList:
             if paramId == parameterId:
                 paramWidget.setMappedControlIndex(control)
-                break
+                return
+
+        for _, paramView in self.fParameterViews:
+            if paramView.setParameterMappedControlIndex(parameterId, control):
+                return
 
     def setParameterMappedRange(self, parameterId, minimum, maximum):
         for _, paramId, paramWidget in self.fParameterList:
             if paramId == parameterId:
                 paramWidget.setMappedRange(minimum, maximum)
-                break
+                return
+
+        for _, paramView in self.fParameterViews:
+            if paramView.setParameterMappedRange(parameterId, minimum, maximum):
+                return
 
     def setParameterMidiChannel(self, parameterId, channel):
         for _, paramId, paramWidget in self.fParameterList:
             if paramId == parameterId:
                 paramWidget.setMidiChannel(channel+1)
-                break
+                return
+
+        for _, paramView in self.fParameterViews:
+            if paramView.setParameterMidiChannel(parameterId, channel+1):
+                return
 
     def setProgram(self, index):
         self.ui.cb_programs.blockSignals(True)
@@ -1291,7 +1597,8 @@ class PluginEdit(QDialog):
 
     #------------------------------------------------------------------
 
-    def idleSlow(self):
+    # outputValues maps output parameter ids to their values, as returned by host.get_runtime_snapshot()
+    def idleSlow(self, outputValues=None):
         # Check Tab icons
         for i in range(len(self.fTabIconTimers)):
             if self.fTabIconTimers[i] == ICON_STATE_ON:
@@ -1358,18 +1665,46 @@ class PluginEdit(QDialog):
                     self.fTabIconTimers[tabIndex-1] = ICON_STATE_ON
                     break
 
+                else:
+                    for paramType, paramView in self.fParameterViews:
+                        # FIXME see above
+                        if paramType != PARAMETER_INPUT:
+                            continue
+                        if not paramView.setParameterValue(index, value):
+                            continue
+
+                        tabIndex = paramView.getTabIndex()
+
+                        if self.fTabIconTimers[tabIndex-1] == ICON_STATE_NULL:
+                            self.ui.tabWidget.setTabIcon(tabIndex, self.fTabIconOn)
+
+                        self.fTabIconTimers[tabIndex-1] = ICON_STATE_ON
+                        break
+
         # Clear all parameters
         self.fParametersToUpdate = []
 
+        if outputValues is None:
+            outputValues = {}
+
         # Update parameter outputs | FIXME needed?
         for paramType, paramId, paramWidget in self.fParameterList:
             if paramType != PARAMETER_OUTPUT:
                 continue
 
+            value = outputValues.get(paramId, None)
+            if value is None:
+                value = self.host.get_current_parameter_value(self.fPluginId, paramId)
+
             paramWidget.blockSignals(True)
-            paramWidget.setValue(self.host.get_current_parameter_value(self.fPluginId, paramId))
+            paramWidget.setValue(value)
             paramWidget.blockSignals(False)
 
+        # only the visible rows of long lists
+        for paramType, paramView in self.fParameterViews:
+            if paramType == PARAMETER_OUTPUT and paramView.isVisible():
+                paramView.updateVisibleValues(outputValues)
+
     #------------------------------------------------------------------
 
     @pyqtSlot()
@@ -1722,6 +2057,10 @@ class PluginEdit(QDialog):
 
             tabIndex = self.ui.tabWidget.count()
 
+            if len(paramList) > MAX_PARAMETER_WIDGETS_PER_TAB:
+                self._createParameterListView(paramType, paramList, width, tabIndex, tabPageName)
+                continue
+
             scrollArea = QScrollArea(self.ui.tabWidget)
             scrollArea.setWidgetResizable(True)
             scrollArea.setFrameStyle(0)
@@ -1776,6 +2115,26 @@ class PluginEdit(QDialog):
 
             self.fTabIconTimers.append(ICON_STATE_NULL)
 
+    # long lists do not get parameter groups, rows are all the same size
+    def _createParameterListView(self, paramType, paramList, width, tabIndex, tabPageName):
+        paramView = PluginParameterListView(self.ui.tabWidget, self.host, paramList, width, self.fPluginId, tabIndex)
+
+        self.fParameterViews.append((paramType, paramView))
+
+        if paramType == PARAMETER_INPUT:
+            paramView.valueChanged.connect(self.slot_parameterValueChanged)
+
+        paramView.mappedControlChanged.connect(self.slot_parameterMappedControlChanged)
+        paramView.mappedRangeChanged.connect(self.slot_parameterMappedRangeChanged)
+        paramView.midiChannelChanged.connect(self.slot_parameterMidiChannelChanged)
+
+        self.ui.tabWidget.addTab(paramView, tabPageName)
+
+        if paramType == PARAMETER_INPUT:
+            self.ui.tabWidget.setTabIcon(tabIndex, self.fTabIconOff)
+
+        self.fTabIconTimers.append(ICON_STATE_NULL)
+
     def _updateCtrlPrograms(self):
         self.ui.keyboard.setEnabled(self.fControlChannel >= 0)
 
@@ -1808,6 +2167,9 @@ class PluginEdit(QDialog):
             paramWidget.setValue(self.host.get_current_parameter_value(self.fPluginId, paramId))
             paramWidget.blockSignals(False)
 
+        for _, paramView in self.fParameterViews:
+            paramView.updateAllValues()
+
     #------------------------------------------------------------------
 
     def testTimer(self):
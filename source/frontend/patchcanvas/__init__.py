@@ -137,6 +137,16 @@ class Canvas(object):
         self.group_plugin_map = {}
         self.old_group_pos = {}
 
+        # lookup maps for the lists above, by group_id, (group_id, port_id) and connection_id
+        self.group_map = {}
+        self.port_map = {}
+        self.connection_map = {}
+
+        # see beginUpdate()
+        self.update_level = 0
+        self.update_boxes = set()
+        self.scene_update_pending = False
+
         self.callback = self.callback
         self.debug = False
         self.scene = None
@@ -185,6 +185,14 @@ class CanvasBox(QGraphicsObject):
     def getPortCount(self):
         return len(self.m_port_list_ids)
 
+    def getPortDictList(self):
+        port_list = []
+        for port_id in self.m_port_list_ids:
+            port = canvas.port_map.get((self.m_group_id, port_id), None)
+            if port is not None:
+                port_list.append(port)
+        return port_list
+
     def getPortList(self):
         return self.m_port_list_ids
 
@@ -315,6 +323,11 @@ class CanvasBox(QGraphicsObject):
         del item
 
     def updatePositions(self):
+        # batch updates reposition each box only once, at the end
+        if canvas.update_level != 0:
+            canvas.update_boxes.add(self)
+            return
+
         self.prepareGeometryChange()
 
         # Check Text Name size
@@ -322,10 +335,7 @@ class CanvasBox(QGraphicsObject):
         self.p_width = max(50, app_name_size)
 
         # Get Port List
-        port_list = []
-        for port in canvas.port_list:
-            if port.group_id == self.m_group_id and port.port_id in self.m_port_list_ids:
-                port_list.append(port)
+        port_list = self.getPortDictList()
 
         if len(port_list) == 0:
             self.p_height = canvas.theme.box_header_height
@@ -380,10 +390,7 @@ class CanvasBox(QGraphicsObject):
 
     def repositionPorts(self, port_list = None):
         if port_list is None:
-            port_list = []
-            for port in canvas.port_list:
-                if port.group_id == self.m_group_id and port.port_id in self.m_port_list_ids:
-                    port_list.append(port)
+            port_list = self.getPortDictList()
 
         # Horizontal ports re-positioning
         inX = canvas.theme.port_offset
@@ -21,7 +21,7 @@
 
 from math import floor
 
-from PyQt5.QtCore import qCritical, Qt, QLineF, QPointF, QRectF, QTimer
+from PyQt5.QtCore import qCritical, Qt, QLineF, QPointF, QRectF
 from PyQt5.QtGui import QCursor, QFont, QFontMetrics, QPainter, QPainterPath, QPen, QPolygonF
 from PyQt5.QtWidgets import QGraphicsItem, QMenu
 
@@ -51,7 +51,7 @@ from . import (
 from .canvasbezierlinemov import CanvasBezierLineMov
 from .canvaslinemov import CanvasLineMov
 from .theme import Theme
-from .utils import CanvasGetFullPortName, CanvasGetPortConnectionList
+from .utils import CanvasGetFullPortName, CanvasGetPortConnectionList, CanvasUpdateSceneLater
 
 # ------------------------------------------------------------------------------------------------------------
 
@@ -121,14 +121,14 @@ class CanvasPort(QGraphicsItem):
 
     def setPortName(self, port_name):
         if QFontMetrics(self.m_port_font).width(port_name) < QFontMetrics(self.m_port_font).width(self.m_port_name):
-            QTimer.singleShot(0, canvas.scene.update)
+            CanvasUpdateSceneLater()
 
         self.m_port_name = port_name
         self.update()
 
     def setPortWidth(self, port_width):
         if port_width < self.m_port_width:
-            QTimer.singleShot(0, canvas.scene.update)
+            CanvasUpdateSceneLater()
 
         self.m_port_width = port_width
         self.update()
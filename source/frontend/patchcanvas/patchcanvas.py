@@ -20,7 +20,7 @@
 # Imports (Global)
 
 from PyQt5.QtCore import pyqtSlot, qCritical, qFatal, qWarning, QObject
-from PyQt5.QtCore import QPointF, QRectF, QTimer
+from PyQt5.QtCore import QPointF, QRectF
 from PyQt5.QtWidgets import QGraphicsObject
 
 # ------------------------------------------------------------------------------------------------------------
@@ -57,7 +57,7 @@ from .canvasbox import CanvasBox
 from .canvasbezierline import CanvasBezierLine
 from .canvasline import CanvasLine
 from .theme import Theme, getDefaultTheme, getThemeName
-from .utils import CanvasCallback, CanvasGetNewGroupPos, CanvasItemFX, CanvasRemoveItemFX
+from .utils import CanvasCallback, CanvasGetNewGroupPos, CanvasItemFX, CanvasRemoveItemFX, CanvasUpdateSceneLater
 
 # FIXME
 from . import *
@@ -242,6 +242,8 @@ def clear():
     port_list_ids = []
     connection_list_ids = []
 
+    beginUpdate()
+
     for group in canvas.group_list:
         group_pos[group.group_name] = (
             group.split,
@@ -271,6 +273,9 @@ def clear():
     canvas.group_list = []
     canvas.port_list = []
     canvas.connection_list = []
+    canvas.group_map = {}
+    canvas.port_map = {}
+    canvas.connection_map = {}
     canvas.group_plugin_map = {}
     canvas.old_group_pos = group_pos
 
@@ -288,7 +293,38 @@ def clear():
 
     canvas.initiated = False
 
-    QTimer.singleShot(0, canvas.scene.update)
+    endUpdate()
+
+# ------------------------------------------------------------------------------------------------------------
+
+# Batch a series of changes (e.g. a full patchbay refresh) so that box layouts and
+# the scene are only updated once, when the outermost endUpdate() is reached.
+def beginUpdate():
+    if canvas.debug:
+        print("PatchCanvas::beginUpdate()")
+
+    canvas.update_level += 1
+
+def endUpdate():
+    if canvas.debug:
+        print("PatchCanvas::endUpdate()")
+
+    if canvas.update_level == 0:
+        qCritical("PatchCanvas::endUpdate() - called without a matching beginUpdate()")
+        return
+
+    canvas.update_level -= 1
+
+    if canvas.update_level != 0:
+        return
+
+    update_boxes = canvas.update_boxes
+    canvas.update_boxes = set()
+
+    for box in update_boxes:
+        box.updatePositions()
+
+    CanvasUpdateSceneLater()
 
 # ------------------------------------------------------------------------------------------------------------
 
@@ -315,11 +351,10 @@ def addGroup(group_id, group_name, split=SPLIT_UNDEF, icon=ICON_APPLICATION):
         print("PatchCanvas::addGroup(%i, %s, %s, %s)" % (
               group_id, group_name.encode(), split2str(split), icon2str(icon)))
 
-    for group in canvas.group_list:
-        if group.group_id == group_id:
-            qWarning("PatchCanvas::addGroup(%i, %s, %s, %s) - group already exists" % (
-                     group_id, group_name.encode(), split2str(split), icon2str(icon)))
-            return None
+    if group_id in canvas.group_map:
+        qWarning("PatchCanvas::addGroup(%i, %s, %s, %s) - group already exists" % (
+                 group_id, group_name.encode(), split2str(split), icon2str(icon)))
+        return None
 
     old_matching_group = canvas.old_group_pos.pop(group_name, None)
 
@@ -399,11 +434,12 @@ def addGroup(group_id, group_name, split=SPLIT_UNDEF, icon=ICON_APPLICATION):
     group_box.blockSignals(False)
 
     canvas.group_list.append(group_dict)
+    canvas.group_map[group_id] = group_dict
 
     if options.eyecandy == EYECANDY_FULL and not options.auto_hide_groups:
         CanvasItemFX(group_box, True, False)
     else:
-        QTimer.singleShot(0, canvas.scene.update)
+        CanvasUpdateSceneLater()
 
     return group_dict
 
@@ -411,62 +447,67 @@ def removeGroup(group_id):
     if canvas.debug:
         print("PatchCanvas::removeGroup(%i)" % group_id)
 
-    for group in canvas.group_list:
-        if group.group_id == group_id:
-            item = group.widgets[0]
-            group_name = group.group_name
+    group = canvas.group_map.get(group_id, None)
 
-            if group.split:
-                s_item = group.widgets[1]
+    if group is None:
+        qCritical("PatchCanvas::removeGroup(%i) - unable to find group to remove" % group_id)
+        return
 
-                if features.handle_group_pos:
-                    canvas.settings.setValue("CanvasPositions/%s_OUTPUT" % group_name, item.pos())
-                    canvas.settings.setValue("CanvasPositions/%s_INPUT" % group_name, s_item.pos())
-                    canvas.settings.setValue("CanvasPositions/%s_SPLIT" % group_name, SPLIT_YES)
+    item = group.widgets[0]
+    group_name = group.group_name
 
-                if options.eyecandy == EYECANDY_FULL:
-                    CanvasItemFX(s_item, False, True)
-                else:
-                    s_item.removeIconFromScene()
-                    canvas.scene.removeItem(s_item)
-                    del s_item
-
-            else:
-                if features.handle_group_pos:
-                    canvas.settings.setValue("CanvasPositions/%s" % group_name, item.pos())
-                    canvas.settings.setValue("CanvasPositions/%s_SPLIT" % group_name, SPLIT_NO)
-
-            if options.eyecandy == EYECANDY_FULL:
-                CanvasItemFX(item, False, True)
-            else:
-                item.removeIconFromScene()
-                canvas.scene.removeItem(item)
-                del item
-
-            canvas.group_list.remove(group)
-            canvas.group_plugin_map.pop(group.plugin_id, None)
-
-            QTimer.singleShot(0, canvas.scene.update)
-            return
+    if group.split:
+        s_item = group.widgets[1]
+
+        if features.handle_group_pos:
+            canvas.settings.setValue("CanvasPositions/%s_OUTPUT" % group_name, item.pos())
+            canvas.settings.setValue("CanvasPositions/%s_INPUT" % group_name, s_item.pos())
+            canvas.settings.setValue("CanvasPositions/%s_SPLIT" % group_name, SPLIT_YES)
+
+        if options.eyecandy == EYECANDY_FULL:
+            CanvasItemFX(s_item, False, True)
+        else:
+            s_item.removeIconFromScene()
+            canvas.scene.removeItem(s_item)
+            del s_item
+
+    else:
+        if features.handle_group_pos:
+            canvas.settings.setValue("CanvasPositions/%s" % group_name, item.pos())
+            canvas.settings.setValue("CanvasPositions/%s_SPLIT" % group_name, SPLIT_NO)
 
-    qCritical("PatchCanvas::removeGroup(%i) - unable to find group to remove" % group_id)
+    if options.eyecandy == EYECANDY_FULL:
+        CanvasItemFX(item, False, True)
+    else:
+        item.removeIconFromScene()
+        canvas.scene.removeItem(item)
+        del item
+
+    canvas.group_list.remove(group)
+    canvas.group_map.pop(group_id, None)
+    canvas.group_plugin_map.pop(group.plugin_id, None)
+    canvas.update_boxes.discard(group.widgets[0])
+    canvas.update_boxes.discard(group.widgets[1])
+
+    CanvasUpdateSceneLater()
 
 def renameGroup(group_id, new_group_name):
     if canvas.debug:
         print("PatchCanvas::renameGroup(%i, %s)" % (group_id, new_group_name.encode()))
 
-    for group in canvas.group_list:
-        if group.group_id == group_id:
-            group.group_name = new_group_name
-            group.widgets[0].setGroupName(new_group_name)
+    group = canvas.group_map.get(group_id, None)
 
-            if group.split and group.widgets[1]:
-                group.widgets[1].setGroupName(new_group_name)
+    if group is None:
+        qCritical("PatchCanvas::renameGroup(%i, %s) - unable to find group to rename" % (group_id, new_group_name.encode()))
+        return
 
-            QTimer.singleShot(0, canvas.scene.update)
-            return
+    group.group_name = new_group_name
+    group.widgets[0].setGroupName(new_group_name)
+
+    if group.split and group.widgets[1]:
+        group.widgets[1].setGroupName(new_group_name)
 
-    qCritical("PatchCanvas::renameGroup(%i, %s) - unable to find group to rename" % (group_id, new_group_name.encode()))
+    CanvasUpdateSceneLater()
 
 def splitGroup(group_id):
     if canvas.debug:
@@ -482,20 +523,20 @@ def splitGroup(group_id):
     conns_data = []
 
     # Step 1 - Store all Item data
-    for group in canvas.group_list:
-        if group.group_id == group_id:
-            if group.split:
-                if canvas.debug:
-                    print("PatchCanvas::splitGroup(%i) - group is already split" % group_id)
-                return
+    group = canvas.group_map.get(group_id, None)
 
-            item = group.widgets[0]
-            group_name = group.group_name
-            group_icon = group.icon
-            plugin_id = group.plugin_id
-            plugin_ui = group.plugin_ui
-            plugin_inline = group.plugin_inline
-            break
+    if group is not None:
+        if group.split:
+            if canvas.debug:
+                print("PatchCanvas::splitGroup(%i) - group is already split" % group_id)
+            return
+
+        item = group.widgets[0]
+        group_name = group.group_name
+        group_icon = group.icon
+        plugin_id = group.plugin_id
+        plugin_ui = group.plugin_ui
+        plugin_inline = group.plugin_inline
 
     if not item:
         qCritical("PatchCanvas::splitGroup(%i) - unable to find group to split" % group_id)
@@ -503,17 +544,21 @@ def splitGroup(group_id):
 
     port_list_ids = list(item.getPortList())
 
-    for port in canvas.port_list:
-        if port.port_id in port_list_ids:
-            port_dict = port_dict_t()
-            port_dict.group_id = port.group_id
-            port_dict.port_id = port.port_id
-            port_dict.port_name = port.port_name
-            port_dict.port_mode = port.port_mode
-            port_dict.port_type = port.port_type
-            port_dict.is_alternate = port.is_alternate
-            port_dict.widget = None
-            ports_data.append(port_dict)
+    for port_id in port_list_ids:
+        port = canvas.port_map.get((group_id, port_id), None)
+
+        if port is None:
+            continue
+
+        port_dict = port_dict_t()
+        port_dict.group_id = port.group_id
+        port_dict.port_id = port.port_id
+        port_dict.port_name = port.port_name
+        port_dict.port_mode = port.port_mode
+        port_dict.port_type = port.port_type
+        port_dict.is_alternate = port.is_alternate
+        port_dict.widget = None
+        ports_data.append(port_dict)
 
     for connection in canvas.connection_list:
         if connection.port_out_id in port_list_ids or connection.port_in_id in port_list_ids:
@@ -553,7 +598,7 @@ def splitGroup(group_id):
         valueStr = "%i:%i:%i:%i" % (pos1.x(), pos1.y(), pos2.x(), pos2.y())
         CanvasCallback(ACTION_GROUP_POSITION, group_id, 0, valueStr)
 
-    QTimer.singleShot(0, canvas.scene.update)
+    CanvasUpdateSceneLater()
 
 def joinGroup(group_id):
     if canvas.debug:
@@ -570,21 +615,21 @@ def joinGroup(group_id):
     conns_data = []
 
     # Step 1 - Store all Item data
-    for group in canvas.group_list:
-        if group.group_id == group_id:
-            if not group.split:
-                if canvas.debug:
-                    print("PatchCanvas::joinGroup(%i) - group is not split" % group_id)
-                return
+    group = canvas.group_map.get(group_id, None)
 
-            item = group.widgets[0]
-            s_item = group.widgets[1]
-            group_name = group.group_name
-            group_icon = group.icon
-            plugin_id = group.plugin_id
-            plugin_ui = group.plugin_ui
-            plugin_inline = group.plugin_inline
-            break
+    if group is not None:
+        if not group.split:
+            if canvas.debug:
+                print("PatchCanvas::joinGroup(%i) - group is not split" % group_id)
+            return
+
+        item = group.widgets[0]
+        s_item = group.widgets[1]
+        group_name = group.group_name
+        group_icon = group.icon
+        plugin_id = group.plugin_id
+        plugin_ui = group.plugin_ui
+        plugin_inline = group.plugin_inline
 
     # FIXME
     if not (item and s_item):
@@ -598,17 +643,21 @@ def joinGroup(group_id):
         if port_id not in port_list_ids:
             port_list_ids.append(port_id)
 
-    for port in canvas.port_list:
-        if port.port_id in port_list_ids:
-            port_dict = port_dict_t()
-            port_dict.group_id = port.group_id
-            port_dict.port_id = port.port_id
-            port_dict.port_name = port.port_name
-            port_dict.port_mode = port.port_mode
-            port_dict.port_type = port.port_type
-            port_dict.is_alternate = port.is_alternate
-            port_dict.widget = None
-            ports_data.append(port_dict)
+    for port_id in port_list_ids:
+        port = canvas.port_map.get((group_id, port_id), None)
+
+        if port is None:
+            continue
+
+        port_dict = port_dict_t()
+        port_dict.group_id = port.group_id
+        port_dict.port_id = port.port_id
+        port_dict.port_name = port.port_name
+        port_dict.port_mode = port.port_mode
+        port_dict.port_type = port.port_type
+        port_dict.is_alternate = port.is_alternate
+        port_dict.widget = None
+        ports_data.append(port_dict)
 
     for connection in canvas.connection_list:
         if connection.port_out_id in port_list_ids or connection.port_in_id in port_list_ids:
@@ -647,7 +696,7 @@ def joinGroup(group_id):
         valueStr = "%i:%i:%i:%i" % (pos.x(), pos.y(), 0, 0)
         CanvasCallback(ACTION_GROUP_POSITION, group_id, 0, valueStr)
 
-    QTimer.singleShot(0, canvas.scene.update)
+    CanvasUpdateSceneLater()
 
 # ------------------------------------------------------------------------------------------------------------
 
@@ -655,9 +704,10 @@ def getGroupPos(group_id, port_mode=PORT_MODE_OUTPUT):
     if canvas.debug:
         print("PatchCanvas::getGroupPos(%i, %s)" % (group_id, port_mode2str(port_mode)))
 
-    for group in canvas.group_list:
-        if group.group_id == group_id:
-            return group.widgets[1 if (group.split and port_mode == PORT_MODE_INPUT) else 0].pos()
+    group = canvas.group_map.get(group_id, None)
+
+    if group is not None:
+        return group.widgets[1 if (group.split and port_mode == PORT_MODE_INPUT) else 0].pos()
 
     qCritical("PatchCanvas::getGroupPos(%i, %s) - unable to find group" % (group_id, port_mode2str(port_mode)))
     return QPointF(0, 0)
@@ -720,24 +770,25 @@ def setGroupPosFull(group_id, group_pos_x_o, group_pos_y_o, group_pos_x_i, group
         print("PatchCanvas::setGroupPos(%i, %i, %i, %i, %i)" % (
               group_id, group_pos_x_o, group_pos_y_o, group_pos_x_i, group_pos_y_i))
 
-    for group in canvas.group_list:
-        if group.group_id == group_id:
-            group.widgets[0].blockSignals(True)
-            group.widgets[0].setPos(group_pos_x_o, group_pos_y_o)
-            group.widgets[0].checkItemPos()
-            group.widgets[0].blockSignals(False)
-
-            if group.split and group.widgets[1]:
-                group.widgets[1].blockSignals(True)
-                group.widgets[1].setPos(group_pos_x_i, group_pos_y_i)
-                group.widgets[1].checkItemPos()
-                group.widgets[1].blockSignals(False)
-
-            QTimer.singleShot(0, canvas.scene.update)
-            return
+    group = canvas.group_map.get(group_id, None)
 
-    qCritical("PatchCanvas::setGroupPos(%i, %i, %i, %i, %i) - unable to find group to reposition" % (
-              group_id, group_pos_x_o, group_pos_y_o, group_pos_x_i, group_pos_y_i))
+    if group is None:
+        qCritical("PatchCanvas::setGroupPos(%i, %i, %i, %i, %i) - unable to find group to reposition" % (
+                  group_id, group_pos_x_o, group_pos_y_o, group_pos_x_i, group_pos_y_i))
+        return
+
+    group.widgets[0].blockSignals(True)
+    group.widgets[0].setPos(group_pos_x_o, group_pos_y_o)
+    group.widgets[0].checkItemPos()
+    group.widgets[0].blockSignals(False)
+
+    if group.split and group.widgets[1]:
+        group.widgets[1].blockSignals(True)
+        group.widgets[1].setPos(group_pos_x_i, group_pos_y_i)
+        group.widgets[1].checkItemPos()
+        group.widgets[1].blockSignals(False)
+
+    CanvasUpdateSceneLater()
 
 # ------------------------------------------------------------------------------------------------------------
 
@@ -745,39 +796,41 @@ def setGroupIcon(group_id, icon):
     if canvas.debug:
         print("PatchCanvas::setGroupIcon(%i, %s)" % (group_id, icon2str(icon)))
 
-    for group in canvas.group_list:
-        if group.group_id == group_id:
-            group.icon = icon
-            group.widgets[0].setIcon(icon)
+    group = canvas.group_map.get(group_id, None)
+
+    if group is None:
+        qCritical("PatchCanvas::setGroupIcon(%i, %s) - unable to find group to change icon" % (group_id, icon2str(icon)))
+        return
 
-            if group.split and group.widgets[1]:
-                group.widgets[1].setIcon(icon)
+    group.icon = icon
+    group.widgets[0].setIcon(icon)
 
-            QTimer.singleShot(0, canvas.scene.update)
-            return
+    if group.split and group.widgets[1]:
+        group.widgets[1].setIcon(icon)
 
-    qCritical("PatchCanvas::setGroupIcon(%i, %s) - unable to find group to change icon" % (group_id, icon2str(icon)))
+    CanvasUpdateSceneLater()
 
 def setGroupAsPlugin(group_id, plugin_id, hasUI, hasInlineDisplay):
     if canvas.debug:
         print("PatchCanvas::setGroupAsPlugin(%i, %i, %s, %s)" % (
               group_id, plugin_id, bool2str(hasUI), bool2str(hasInlineDisplay)))
 
-    for group in canvas.group_list:
-        if group.group_id == group_id:
-            group.plugin_id = plugin_id
-            group.plugin_ui = hasUI
-            group.plugin_inline = hasInlineDisplay
-            group.widgets[0].setAsPlugin(plugin_id, hasUI, hasInlineDisplay)
+    group = canvas.group_map.get(group_id, None)
 
-            if group.split and group.widgets[1]:
-                group.widgets[1].setAsPlugin(plugin_id, hasUI, hasInlineDisplay)
+    if group is None:
+        qCritical("PatchCanvas::setGroupAsPlugin(%i, %i, %s, %s) - unable to find group to set as plugin" % (
+                  group_id, plugin_id, bool2str(hasUI), bool2str(hasInlineDisplay)))
+        return
 
-            canvas.group_plugin_map[plugin_id] = group
-            return
+    group.plugin_id = plugin_id
+    group.plugin_ui = hasUI
+    group.plugin_inline = hasInlineDisplay
+    group.widgets[0].setAsPlugin(plugin_id, hasUI, hasInlineDisplay)
 
-    qCritical("PatchCanvas::setGroupAsPlugin(%i, %i, %s, %s) - unable to find group to set as plugin" % (
-              group_id, plugin_id, bool2str(hasUI), bool2str(hasInlineDisplay)))
+    if group.split and group.widgets[1]:
+        group.widgets[1].setAsPlugin(plugin_id, hasUI, hasInlineDisplay)
+
+    canvas.group_plugin_map[plugin_id] = group
 
 # ------------------------------------------------------------------------------------------------------------
 
@@ -816,24 +869,23 @@ def addPort(group_id, port_id, port_name, port_mode, port_type, is_alternate=Fal
               group_id, port_id, port_name.encode(),
               port_mode2str(port_mode), port_type2str(port_type), bool2str(is_alternate)))
 
-    for port in canvas.port_list:
-        if port.group_id == group_id and port.port_id == port_id:
-            qWarning("PatchCanvas::addPort(%i, %i, %s, %s, %s) - port already exists" % (
-                     group_id, port_id, port_name.encode(), port_mode2str(port_mode), port_type2str(port_type)))
-            return
+    if (group_id, port_id) in canvas.port_map:
+        qWarning("PatchCanvas::addPort(%i, %i, %s, %s, %s) - port already exists" % (
+                 group_id, port_id, port_name.encode(), port_mode2str(port_mode), port_type2str(port_type)))
+        return
 
     box_widget = None
     port_widget = None
 
-    for group in canvas.group_list:
-        if group.group_id == group_id:
-            if group.split and group.widgets[0].getSplittedMode() != port_mode and group.widgets[1]:
-                n = 1
-            else:
-                n = 0
-            box_widget = group.widgets[n]
-            port_widget = box_widget.addPortFromGroup(port_id, port_mode, port_type, port_name, is_alternate)
-            break
+    group = canvas.group_map.get(group_id, None)
+
+    if group is not None:
+        if group.split and group.widgets[0].getSplittedMode() != port_mode and group.widgets[1]:
+            n = 1
+        else:
+            n = 0
+        box_widget = group.widgets[n]
+        port_widget = box_widget.addPortFromGroup(port_id, port_mode, port_type, port_name, is_alternate)
 
     if not (box_widget and port_widget):
         qCritical("PatchCanvas::addPort(%i, %i, %s, %s, %s) - Unable to find parent group" % (
@@ -849,6 +901,7 @@ def addPort(group_id, port_id, port_name, port_mode, port_type, is_alternate=Fal
     port_dict.is_alternate = is_alternate
     port_dict.widget = port_widget
     canvas.port_list.append(port_dict)
+    canvas.port_map[(group_id, port_id)] = port_dict
 
     box_widget.updatePositions()
 
@@ -856,40 +909,42 @@ def addPort(group_id, port_id, port_name, port_mode, port_type, is_alternate=Fal
         CanvasItemFX(port_widget, True, False)
         return
 
-    QTimer.singleShot(0, canvas.scene.update)
+    CanvasUpdateSceneLater()
 
 def removePort(group_id, port_id):
     if canvas.debug:
         print("PatchCanvas::removePort(%i, %i)" % (group_id, port_id))
 
-    for port in canvas.port_list:
-        if port.group_id == group_id and port.port_id == port_id:
-            item = port.widget
-            item.parentItem().removePortFromGroup(port_id)
-            canvas.scene.removeItem(item)
-            canvas.port_list.remove(port)
-            del item
-
-            QTimer.singleShot(0, canvas.scene.update)
-            return
+    port = canvas.port_map.pop((group_id, port_id), None)
+
+    if port is None:
+        qCritical("PatchCanvas::removePort(%i, %i) - Unable to find port to remove" % (group_id, port_id))
+        return
 
-    qCritical("PatchCanvas::removePort(%i, %i) - Unable to find port to remove" % (group_id, port_id))
+    item = port.widget
+    item.parentItem().removePortFromGroup(port_id)
+    canvas.scene.removeItem(item)
+    canvas.port_list.remove(port)
+    del item
+
+    CanvasUpdateSceneLater()
 
 def renamePort(group_id, port_id, new_port_name):
     if canvas.debug:
         print("PatchCanvas::renamePort(%i, %i, %s)" % (group_id, port_id, new_port_name.encode()))
 
-    for port in canvas.port_list:
-        if port.group_id == group_id and port.port_id == port_id:
-            port.port_name = new_port_name
-            port.widget.setPortName(new_port_name)
-            port.widget.parentItem().updatePositions()
+    port = canvas.port_map.get((group_id, port_id), None)
 
-            QTimer.singleShot(0, canvas.scene.update)
-            return
+    if port is None:
+        qCritical("PatchCanvas::renamePort(%i, %i, %s) - Unable to find port to rename" % (
+                  group_id, port_id, new_port_name.encode()))
+        return
+
+    port.port_name = new_port_name
+    port.widget.setPortName(new_port_name)
+    port.widget.parentItem().updatePositions()
 
-    qCritical("PatchCanvas::renamePort(%i, %i, %s) - Unable to find port to rename" % (
-              group_id, port_id, new_port_name.encode()))
+    CanvasUpdateSceneLater()
 
 def connectPorts(connection_id, group_out_id, port_out_id, group_in_id, port_in_id):
     if canvas.last_connection_id >= connection_id:
@@ -903,25 +958,19 @@ def connectPorts(connection_id, group_out_id, port_out_id, group_in_id, port_in_
         print("PatchCanvas::connectPorts(%i, %i, %i, %i, %i)" % (
               connection_id, group_out_id, port_out_id, group_in_id, port_in_id))
 
-    port_out = None
-    port_in = None
-    port_out_parent = None
-    port_in_parent = None
-
-    for port in canvas.port_list:
-        if port.group_id == group_out_id and port.port_id == port_out_id:
-            port_out = port.widget
-            port_out_parent = port_out.parentItem()
-        elif port.group_id == group_in_id and port.port_id == port_in_id:
-            port_in = port.widget
-            port_in_parent = port_in.parentItem()
+    port_out_dict = canvas.port_map.get((group_out_id, port_out_id), None)
+    port_in_dict = canvas.port_map.get((group_in_id, port_in_id), None)
 
-    # FIXME
-    if not (port_out and port_in):
+    if port_out_dict is None or port_in_dict is None:
         qCritical("PatchCanvas::connectPorts(%i, %i, %i, %i, %i) - unable to find ports to connect" % (
                   connection_id, group_out_id, port_out_id, group_in_id, port_in_id))
         return
 
+    port_out = port_out_dict.widget
+    port_in = port_in_dict.widget
+    port_out_parent = port_out.parentItem()
+    port_in_parent = port_in.parentItem()
+
     connection_dict = connection_dict_t()
     connection_dict.connection_id = connection_id
     connection_dict.group_in_id = group_in_id
@@ -947,58 +996,42 @@ def connectPorts(connection_id, group_out_id, port_out_id, group_in_id, port_in_
     connection_dict.widget.setZValue(canvas.last_z_value)
 
     canvas.connection_list.append(connection_dict)
+    canvas.connection_map[connection_id] = connection_dict
 
     if options.eyecandy == EYECANDY_FULL:
         item = connection_dict.widget
         CanvasItemFX(item, True, False)
         return
 
-    QTimer.singleShot(0, canvas.scene.update)
+    CanvasUpdateSceneLater()
 
 def disconnectPorts(connection_id):
     if canvas.debug:
         print("PatchCanvas::disconnectPorts(%i)" % connection_id)
 
-    line = None
-    item1 = None
-    item2 = None
-    group1id = port1id = 0
-    group2id = port2id = 0
-
-    for connection in canvas.connection_list:
-        if connection.connection_id == connection_id:
-            group1id = connection.group_out_id
-            group2id = connection.group_in_id
-            port1id = connection.port_out_id
-            port2id = connection.port_in_id
-            line = connection.widget
-            canvas.connection_list.remove(connection)
-            break
+    connection = canvas.connection_map.pop(connection_id, None)
 
-    if not line:
+    if connection is None:
         qCritical("PatchCanvas::disconnectPorts(%i) - unable to find connection ports" % connection_id)
         return
 
-    for port in canvas.port_list:
-        if port.group_id == group1id and port.port_id == port1id:
-            item1 = port.widget
-            break
+    line = connection.widget
+    canvas.connection_list.remove(connection)
 
-    if not item1:
+    port1 = canvas.port_map.get((connection.group_out_id, connection.port_out_id), None)
+
+    if port1 is None:
         qCritical("PatchCanvas::disconnectPorts(%i) - unable to find output port" % connection_id)
         return
 
-    for port in canvas.port_list:
-        if port.group_id == group2id and port.port_id == port2id:
-            item2 = port.widget
-            break
+    port2 = canvas.port_map.get((connection.group_in_id, connection.port_in_id), None)
 
-    if not item2:
+    if port2 is None:
         qCritical("PatchCanvas::disconnectPorts(%i) - unable to find input port" % connection_id)
         return
 
-    item1.parentItem().removeLineFromGroup(connection_id)
-    item2.parentItem().removeLineFromGroup(connection_id)
+    port1.widget.parentItem().removeLineFromGroup(connection_id)
+    port2.widget.parentItem().removeLineFromGroup(connection_id)
 
     if options.eyecandy == EYECANDY_FULL:
         CanvasItemFX(line, False, True)
@@ -1007,7 +1040,7 @@ def disconnectPorts(connection_id):
     canvas.scene.removeItem(line)
     del line
 
-    QTimer.singleShot(0, canvas.scene.update)
+    CanvasUpdateSceneLater()
 
 # ------------------------------------------------------------------------------------------------------------
 
@@ -64,13 +64,11 @@ def CanvasGetFullPortName(group_id, port_id):
     if canvas.debug:
         print("PatchCanvas::CanvasGetFullPortName(%i, %i)" % (group_id, port_id))
 
-    for port in canvas.port_list:
-        if port.group_id == group_id and port.port_id == port_id:
-            group_id = port.group_id
-            for group in canvas.group_list:
-                if group.group_id == group_id:
-                    return group.group_name + ":" + port.port_name
-            break
+    port = canvas.port_map.get((group_id, port_id), None)
+    group = canvas.group_map.get(group_id, None)
+
+    if port is not None and group is not None:
+        return group.group_name + ":" + port.port_name
 
     qCritical("PatchCanvas::CanvasGetFullPortName(%i, %i) - unable to find port" % (group_id, port_id))
     return ""
@@ -132,6 +130,20 @@ def CanvasRemoveItemFX(item):
     canvas.scene.removeItem(item)
     del item
 
-    QTimer.singleShot(0, canvas.scene.update)
+    CanvasUpdateSceneLater()
+
+def CanvasUpdateSceneLater():
+    # a single pending update is enough, and batch updates do it at the end
+    if canvas.update_level != 0 or canvas.scene_update_pending:
+        return
+
+    canvas.scene_update_pending = True
+    QTimer.singleShot(0, CanvasUpdateScene)
+
+def CanvasUpdateScene():
+    canvas.scene_update_pending = False
+
+    if canvas.scene is not None:
+        canvas.scene.update()
 
 # ------------------------------------------------------------------------------------------------------------
@@ -22,6 +22,7 @@
 
 #include <QtGui/QPainter>
 #include <QtGui/QPaintEvent>
+#include <QtGui/QPixmap>
 
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 0, 0))
 # include <QtWidgets/QWidget>
@@ -65,7 +66,10 @@ public:
           fMeterStyle(STYLE_DEFAULT),
           fMeterBackground("#111111"),
           fMeterGradient(0, 0, 0, 0),
-          fSmoothMultiplier(1)
+          fSmoothMultiplier(1),
+          fCacheBackground(),
+          fCacheLevels(),
+          fCacheLines()
     {
         updateGrandient();
     }
@@ -100,6 +104,9 @@ public:
         if (count < 0)
             return qCritical("DigitalPeakMeter::setChannelCount(%i) - channel count must be a positive integer or zero", count);
 
+        delete[] fChannelData;
+        delete[] fLastChannelData;
+
         fChannelCount    = count;
         fChannelData     = new float[count];
         fLastChannelData = new float[count];
@@ -109,6 +116,8 @@ public:
             /**/fChannelData[i] = 0.0f;
             fLastChannelData[i] = 0.0f;
         }
+
+        invalidateCache();
     }
 
     // --------------------------------------------------------------------------------------------------------
@@ -156,6 +165,7 @@ public:
             return;
 
         fMeterLinesEnabled = yesNo;
+        invalidateCache();
     }
 
     // --------------------------------------------------------------------------------------------------------
@@ -251,7 +261,7 @@ public:
         if (fChannelData[i] != level)
         {
             fChannelData[i] = level;
-            update();
+            update(meterRect(i));
         }
 
         fLastChannelData[i] = level;
@@ -260,6 +270,25 @@ public:
     // --------------------------------------------------------------------------------------------------------
 
 protected:
+    // area covered by a single meter, so a level change only repaints that meter
+    QRect meterRect(const int i) const
+    {
+        const int width_  = width();
+        const int height_ = height();
+
+        const int meterSize = (fMeterOrientation == HORIZONTAL ? height_ : width_)/fChannelCount;
+
+        switch (fMeterOrientation)
+        {
+        case HORIZONTAL:
+            return QRect(0, meterSize*i, width_, meterSize+1);
+        case VERTICAL:
+            break;
+        }
+
+        return QRect(meterSize*i, 0, meterSize+1, height_);
+    }
+
     void updateGrandient()
     {
         fMeterGradient = QLinearGradient(0, 0, 1, 1);
@@ -306,6 +335,170 @@ protected:
             fMeterGradient.setFinalStop(0, height());
             break;
         }
+
+        invalidateCache();
+    }
+
+    // --------------------------------------------------------------------------------------------------------
+    // Everything except the current levels is pre-rendered, repaints only copy the lit part of each meter.
+
+    void invalidateCache()
+    {
+        fCacheBackground = QPixmap();
+        fCacheLevels     = QPixmap();
+        fCacheLines      = QPixmap();
+    }
+
+    void updateCache()
+    {
+        const int width_  = width();
+        const int height_ = height();
+
+        if (! fCacheBackground.isNull() && fCacheBackground.width() == width_ && fCacheBackground.height() == height_)
+            return;
+
+        fCacheBackground = QPixmap(width_, height_);
+        fCacheLevels     = QPixmap(width_, height_);
+        fCacheLines      = QPixmap(width_, height_);
+
+        fCacheBackground.fill(fMeterBackground);
+        fCacheLevels.fill(Qt::transparent);
+        fCacheLines.fill(Qt::transparent);
+
+        // draw background
+        {
+            QPainter painter(&fCacheBackground);
+            painter.setPen(QPen(fMeterBackground, 2));
+            painter.setBrush(fMeterBackground);
+            painter.drawRect(0, 0, width_, height_);
+        }
+
+        if (fChannelCount == 0)
+            return;
+
+        // draw all meters at full level
+        {
+            QPainter painter(&fCacheLevels);
+
+            int meterPad  = 0;
+            int meterPos  = 0;
+            int meterSize = (fMeterOrientation == HORIZONTAL ? height_ : width_)/fChannelCount;
+
+            if (fMeterStyle == STYLE_OPENAV)
+            {
+                QColor colorTrans(fMeterColorBase);
+                colorTrans.setAlphaF(0.5);
+                painter.setBrush(colorTrans);
+                painter.setPen(QPen(fMeterColorBase, 1));
+                meterPad  += 2;
+                meterSize -= 2;
+            }
+            else
+            {
+                painter.setPen(QPen(fMeterBackground, 0));
+                painter.setBrush(fMeterGradient);
+            }
+
+            for (int i=0; i<fChannelCount; ++i)
+            {
+                switch (fMeterOrientation)
+                {
+                case HORIZONTAL:
+                    painter.drawRect(0, meterPos, width_, meterSize);
+                    break;
+                case VERTICAL:
+                    painter.drawRect(meterPos, 0, meterSize, height_);
+                    break;
+                }
+
+                meterPos += meterSize+meterPad;
+            }
+        }
+
+        if (! fMeterLinesEnabled)
+            return;
+
+        // draw lines
+        {
+            QPainter painter(&fCacheLines);
+
+            switch (fMeterOrientation)
+            {
+            case HORIZONTAL: {
+                const float lsmall = float(width_);
+                const float lfull  = float(height_ - 1);
+
+                if (fMeterStyle == STYLE_OPENAV)
+                {
+                    painter.setPen(QColor(37, 37, 37, 100));
+                    painter.drawLine(QLineF(lsmall * 0.25f, 2.0f, lsmall * 0.25f, lfull-2.0f));
+                    painter.drawLine(QLineF(lsmall * 0.50f, 2.0f, lsmall * 0.50f, lfull-2.0f));
+                    painter.drawLine(QLineF(lsmall * 0.75f, 2.0f, lsmall * 0.75f, lfull-2.0f));
+
+                    if (fChannelCount > 1)
+                        painter.drawLine(QLineF(1.0f, lfull/2-1, lsmall-1, lfull/2-1));
+                }
+                else
+                {
+                    // Base
+                    painter.setBrush(Qt::black);
+                    painter.setPen(QPen(fMeterColorBaseAlt, 1));
+                    painter.drawLine(QLineF(lsmall * 0.25f, 2.0f, lsmall * 0.25f, lfull-2.0f));
+                    painter.drawLine(QLineF(lsmall * 0.50f, 2.0f, lsmall * 0.50f, lfull-2.0f));
+
+                    // Yellow
+                    painter.setPen(QColor(110, 110, 15, 100));
+                    painter.drawLine(QLineF(lsmall * 0.70f, 2.0f, lsmall * 0.70f, lfull-2.0f));
+                    painter.drawLine(QLineF(lsmall * 0.83f, 2.0f, lsmall * 0.83f, lfull-2.0f));
+
+                    // Orange
+                    painter.setPen(QColor(180, 110, 15, 100));
+                    painter.drawLine(QLineF(lsmall * 0.90f, 2.0f, lsmall * 0.90f, lfull-2.0f));
+
+                    // Red
+                    painter.setPen(QColor(110, 15, 15, 100));
+                    painter.drawLine(QLineF(lsmall * 0.96f, 2.0f, lsmall * 0.96f, lfull-2.0f));
+                }
+            }   break;
+
+            case VERTICAL: {
+                const float lsmall = float(height_);
+                const float lfull  = float(width_ - 1);
+
+                if (fMeterStyle == STYLE_OPENAV)
+                {
+                    painter.setPen(QColor(37, 37, 37, 100));
+                    painter.drawLine(QLineF(2.0f, lsmall - (lsmall * 0.25f), lfull-2.0f, lsmall - (lsmall * 0.25f)));
+                    painter.drawLine(QLineF(2.0f, lsmall - (lsmall * 0.50f), lfull-2.0f, lsmall - (lsmall * 0.50f)));
+                    painter.drawLine(QLineF(2.0f, lsmall - (lsmall * 0.75f), lfull-2.0f, lsmall - (lsmall * 0.75f)));
+
+                    if (fChannelCount > 1)
+                        painter.drawLine(QLineF(lfull/2-1, 1.0f, lfull/2-1, lsmall-1));
+                }
+                else
+                {
+                    // Base
+                    painter.setBrush(Qt::black);
+                    painter.setPen(QPen(fMeterColorBaseAlt, 1));
+                    painter.drawLine(QLineF(2.0f, lsmall - (lsmall * 0.25f), lfull-2.0f, lsmall - (lsmall * 0.25f)));
+                    painter.drawLine(QLineF(2.0f, lsmall - (lsmall * 0.50f), lfull-2.0f, lsmall - (lsmall * 0.50f)));
+
+                    // Yellow
+                    painter.setPen(QColor(110, 110, 15, 100));
+                    painter.drawLine(QLineF(2.0f, lsmall - (lsmall * 0.70f), lfull-2.0f, lsmall - (lsmall * 0.70f)));
+                    painter.drawLine(QLineF(2.0f, lsmall - (lsmall * 0.82f), lfull-2.0f, lsmall - (lsmall * 0.82f)));
+
+                    // Orange
+                    painter.setPen(QColor(180, 110, 15, 100));
+                    painter.drawLine(QLineF(2.0f, lsmall - (lsmall * 0.90f), lfull-2.0f, lsmall - (lsmall * 0.90f)));
+
+                    // Red
+                    painter.setPen(QColor(110, 15, 15, 100));
+                    painter.drawLine(QLineF(2.0f, lsmall - (lsmall * 0.96f), lfull-2.0f, lsmall - (lsmall * 0.96f)));
+                }
+            }   break;
+            }
+        }
     }
 
     // --------------------------------------------------------------------------------------------------------
@@ -327,13 +520,51 @@ protected:
         QPainter painter(this);
         ev->accept();
 
+        updateCache();
+
+        painter.drawPixmap(0, 0, fCacheBackground);
+
+        if (fChannelCount == 0)
+            return;
+
         const int width_  = width();
         const int height_ = height();
 
-        // draw background
-        painter.setPen(QPen(fMeterBackground, 2));
-        painter.setBrush(fMeterBackground);
-        painter.drawRect(0, 0, width_, height_);
+        int meterPad  = 0;
+        int meterPos  = 0;
+        int meterSize = (fMeterOrientation == HORIZONTAL ? height_ : width_)/fChannelCount;
+
+        if (fMeterStyle == STYLE_OPENAV)
+        {
+            meterPad  += 2;
+            meterSize -= 2;
+        }
+
+        // copy the lit part of each meter
+        for (int i=0; i<fChannelCount; ++i)
+        {
+            const float level = fChannelData[i];
+
+            if (level != 0.0f)
+            {
+                switch (fMeterOrientation)
+                {
+                case HORIZONTAL: {
+                    const int size = int(std::sqrt(level) * float(width_));
+                    painter.drawPixmap(0, meterPos, fCacheLevels, 0, meterPos, size, meterSize);
+                }   break;
+                case VERTICAL: {
+                    const int size = int(std::sqrt(level) * float(height_));
+                    painter.drawPixmap(meterPos, height_ - size, fCacheLevels, meterPos, height_ - size, meterSize, size);
+                }   break;
+                }
+            }
+
+            meterPos += meterSize+meterPad;
+        }
+
+        if (fMeterLinesEnabled)
+            painter.drawPixmap(0, 0, fCacheLines);
     }
 
     // --------------------------------------------------------------------------------------------------------
@@ -364,6 +595,10 @@ private:
 
     int fSmoothMultiplier;
 
+    QPixmap fCacheBackground;
+    QPixmap fCacheLevels;
+    QPixmap fCacheLines;
+
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DigitalPeakMeter)
 };
 
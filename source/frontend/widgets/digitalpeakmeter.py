@@ -21,7 +21,7 @@
 
 from math import sqrt
 
-from PyQt5.QtCore import qCritical, Qt, QTimer, QSize
+from PyQt5.QtCore import qCritical, Qt, QTimer, QRect, QSize
 from PyQt5.QtGui import QColor, QLinearGradient, QPainter, QPen, QPixmap
 from PyQt5.QtWidgets import QWidget
 
@@ -222,10 +222,25 @@ class DigitalPeakMeter(QWidget):
 
         if self.fChannelData[i] != level:
             self.fChannelData[i] = level
-            self.update()
+            self.update(self.meterRect(i))
 
         self.fLastChannelData[i] = level
 
+    # area covered by a single meter, so a level change only repaints that meter
+    def meterRect(self, i):
+        width  = self.width()
+        height = self.height()
+
+        if self.fMeterStyle == self.STYLE_CALF:
+            return QRect(0, 12*i, width, 12)
+
+        meterSize = (height if self.fMeterOrientation == self.HORIZONTAL else width)/self.fChannelCount
+
+        if self.fMeterOrientation == self.HORIZONTAL:
+            return QRect(0, int(meterSize*i), width, int(meterSize)+1)
+
+        return QRect(int(meterSize*i), 0, int(meterSize)+1, height)
+
     # --------------------------------------------------------------------------------------------------------
 
     def updateGrandient(self):
@@ -28,6 +28,8 @@ enum SetupHints {
     // Application Window management
     LIBJACK_FLAG_CONTROL_WINDOW              = 0x01,
     LIBJACK_FLAG_CAPTURE_FIRST_WINDOW        = 0x02,
+    // Processing
+    LIBJACK_FLAG_PARALLEL_CLIENTS            = 0x08,
     // Audio/MIDI Buffers management
     LIBJACK_FLAG_AUDIO_BUFFERS_ADDITION      = 0x10,
     LIBJACK_FLAG_MIDI_OUTPUT_CHANNEL_MIXDOWN = 0x20,
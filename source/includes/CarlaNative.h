@@ -67,9 +67,16 @@ typedef enum {
     NATIVE_PLUGIN_HAS_INLINE_DISPLAY   = 1 << 12,
     NATIVE_PLUGIN_USES_CONTROL_VOLTAGE = 1 << 13,
     NATIVE_PLUGIN_REQUESTS_IDLE        = 1 << 15,
-    NATIVE_PLUGIN_USES_UI_SIZE         = 1 << 16
+    NATIVE_PLUGIN_USES_UI_SIZE         = 1 << 16,
+    NATIVE_PLUGIN_IS_INPLACE_SAFE      = 1 << 17  /** runs on host buffers, see note below   */
 } NativePluginHints;
 
+/*
+ * NATIVE_PLUGIN_IS_INPLACE_SAFE means the plugin can run directly on the host port buffers:
+ * it writes every output sample on each process call, never writes to its inputs,
+ * and gives correct results when an output buffer is the same as an input one.
+ */
+
 typedef enum {
     NATIVE_PLUGIN_SUPPORTS_NOTHING          = 0,
     NATIVE_PLUGIN_SUPPORTS_PROGRAM_CHANGES  = 1 << 0, /** handles MIDI programs internally instead of host-exposed/exported */
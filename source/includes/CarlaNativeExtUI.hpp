@@ -22,6 +22,10 @@
 #include "CarlaExternalUI.hpp"
 #include "CarlaMIDI.h"
 
+#ifndef CARLA_OS_WIN
+# include "CarlaThread.hpp"
+#endif
+
 /*!
  * @defgroup CarlaNativeAPI Carla Native API
  * @{
@@ -38,6 +42,9 @@ public:
         : NativePluginClass(host),
           CarlaExternalUI(),
           fExtUiPath(getResourceDir())
+#ifndef CARLA_OS_WIN
+        , fMessageWatcher(*this)
+#endif
     {
         fExtUiPath += CARLA_OS_SEP_STR;
         fExtUiPath += pathToExternalUI;
@@ -46,6 +53,11 @@ public:
 #endif
     }
 
+    ~NativePluginAndUiClass() override
+    {
+        stopMessageWatcher();
+    }
+
     const char* getExtUiPath() const noexcept
     {
         return fExtUiPath;
@@ -73,17 +85,36 @@ protected:
             {
                 uiClosed();
                 hostUiUnavailable();
+                return;
             }
+
+#ifndef CARLA_OS_WIN
+            fMessageWatcher.startThread();
+#endif
         }
         else
         {
+            stopMessageWatcher();
             CarlaExternalUI::stopPipeServer(2000);
         }
     }
 
     void uiIdle() override
     {
-        CarlaExternalUI::idlePipe();
+#ifndef CARLA_OS_WIN
+        // while the watcher runs, there is nothing to read until it says so
+        const bool hasMessages = ! fMessageWatcher.isThreadRunning() || fMessageWatcher.takePendingMessages();
+#else
+        const bool hasMessages = true;
+#endif
+
+        if (hasMessages)
+        {
+            CarlaExternalUI::idlePipe();
+#ifndef CARLA_OS_WIN
+            fMessageWatcher.messagesHandled();
+#endif
+        }
 
         switch (CarlaExternalUI::getAndResetUiState())
         {
@@ -96,6 +127,7 @@ protected:
             break;
         case CarlaExternalUI::UiHide:
             uiClosed();
+            stopMessageWatcher();
             CarlaExternalUI::stopPipeServer(1000);
             break;
         }
@@ -216,6 +248,87 @@ protected:
 private:
     CarlaString fExtUiPath;
 
+#ifndef CARLA_OS_WIN
+    // Waits on the UI pipe in its own thread and asks the host for an idle call when messages arrive,
+    // so they are handled without waiting for the next regular idle, and quiet UIs cost nothing to idle.
+    class MessageWatcher : public CarlaThread
+    {
+    public:
+        MessageWatcher(NativePluginAndUiClass& owner) noexcept
+            : CarlaThread("NativeUiMessageWatcher"),
+              fOwner(owner),
+              fHandled(),
+              fPending(false) {}
+
+        // called from uiIdle(), true means idlePipe() has messages to read
+        bool takePendingMessages() noexcept
+        {
+            if (! fPending)
+                return false;
+
+            fPending = false;
+            return true;
+        }
+
+        void messagesHandled() noexcept
+        {
+            fHandled.signal();
+        }
+
+        void stop() noexcept
+        {
+            signalThreadShouldExit();
+            fHandled.signal();
+            stopThread(-1);
+        }
+
+    protected:
+        void run() noexcept override
+        {
+            bool closed = false;
+
+            while (! shouldThreadExit())
+            {
+                if (! fOwner.waitForMessages(kWaitTimeOut, closed))
+                {
+                    // nothing else will arrive, uiIdle() goes back to reading the pipe itself
+                    if (closed)
+                        break;
+                    continue;
+                }
+
+                fPending = true;
+                fOwner.hostRequestIdle();
+
+                // the pipe stays readable until uiIdle() reads it, only wait again after that
+                while (! fHandled.wait(kWaitTimeOut))
+                {
+                    if (shouldThreadExit())
+                        return;
+                }
+            }
+        }
+
+    private:
+        static const uint32_t kWaitTimeOut = 100;
+
+        NativePluginAndUiClass& fOwner;
+        CarlaSignal fHandled;
+        volatile bool fPending;
+
+        CARLA_DECLARE_NON_COPY_CLASS(MessageWatcher)
+    };
+
+    MessageWatcher fMessageWatcher;
+#endif
+
+    void stopMessageWatcher() noexcept
+    {
+#ifndef CARLA_OS_WIN
+        fMessageWatcher.stop();
+#endif
+    }
+
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NativePluginAndUiClass)
 };
 
@@ -224,8 +224,10 @@ bool lv2_atom_buffer_write (
 		< sizeof(LV2_Atom_Event) + size)
 		return false;
 
+	// same as LV2_ATOM_CONTENTS(LV2_Atom_Sequence, atoms), but taken from
+	// the start of the allocation, as compilers see 'atoms' ending there
 	LV2_Atom_Event *ev = (LV2_Atom_Event*) ((char *)
-		LV2_ATOM_CONTENTS(LV2_Atom_Sequence, atoms) + iter->offset);
+		buf + sizeof(LV2_Atom_Buffer) + iter->offset);
 
 	ev->time.frames = frames;
 	ev->body.type = type;
@@ -0,0 +1,249 @@
+/*
+ * Carla Interposer for checking realtime safety of the audio thread
+ * Copyright (C) 2014-2020 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+/*
+ * Debugging aid, not meant for regular use.
+ * Preload this library into the Carla host process, for example:
+ *
+ *   LD_PRELOAD=/path/to/libcarla_interposer-rtcheck.so carla
+ *
+ * The engine marks its audio thread(s) while processing, see carla_interposer_rtcheck_enter().
+ * Memory allocation, blocking mutex locks, sleeps and file opening done while marked are reported
+ * on stderr together with the plugin being processed (or "engine") and a backtrace.
+ * Only the first offending call per processing cycle is reported, to keep the output readable.
+ */
+
+#include "CarlaUtils.hpp"
+
+#include <cstdarg>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------
+// glibc internals, used for memory functions so they work before (and while) dlsym is resolved
+
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void  __libc_free(void*);
+}
+
+// -----------------------------------------------------------------------
+// Function typedefs
+
+typedef int (*PthreadMutexLockFunc)(pthread_mutex_t*);
+typedef int (*NanosleepFunc)(const struct timespec*, struct timespec*);
+typedef int (*UsleepFunc)(useconds_t);
+typedef int (*OpenFunc)(const char*, int, ...);
+typedef FILE* (*FopenFunc)(const char*, const char*);
+
+// resolved in the library constructor, plain pointers as static locals would need a lock for their init
+static PthreadMutexLockFunc gRealPthreadMutexLock = nullptr;
+static NanosleepFunc        gRealNanosleep        = nullptr;
+static UsleepFunc           gRealUsleep           = nullptr;
+static OpenFunc             gRealOpen             = nullptr;
+static FopenFunc            gRealFopen            = nullptr;
+
+// -----------------------------------------------------------------------
+// Current state, per thread
+
+#define RTCHECK_TLS __thread __attribute__((tls_model("initial-exec")))
+
+// plugin name or "engine" while the thread is processing audio, null otherwise
+static RTCHECK_TLS const char* tContext = nullptr;
+
+// set while reporting, so the report itself (which allocates) is not checked
+static RTCHECK_TLS bool tInsideReport = false;
+
+// only report the first offending call of each cycle
+static RTCHECK_TLS bool tReportedThisCycle = false;
+
+static void reportCall(const char* const funcName) noexcept
+{
+    tInsideReport = true;
+
+    if (! tReportedThisCycle)
+    {
+        tReportedThisCycle = true;
+
+        carla_stderr2("Carla RT check: '%s' called %s() from the audio thread, backtrace follows", tContext, funcName);
+
+        void* frames[32];
+        const int numFrames = ::backtrace(frames, 32);
+
+        // skip ourselves
+        if (numFrames > 2)
+            ::backtrace_symbols_fd(frames + 2, numFrames - 2, STDERR_FILENO);
+    }
+
+    tInsideReport = false;
+}
+
+static inline void checkCall(const char* const funcName) noexcept
+{
+    if (tContext != nullptr && ! tInsideReport)
+        reportCall(funcName);
+}
+
+// -----------------------------------------------------------------------
+// Thread marking, looked up by the engine with dlsym
+
+CARLA_EXPORT
+const char* carla_interposer_rtcheck_enter(const char* const context)
+{
+    const char* const previous = tContext;
+
+    if (previous == nullptr)
+        tReportedThisCycle = false;
+
+    tContext = context != nullptr ? context : "(unknown)";
+    return previous;
+}
+
+CARLA_EXPORT
+void carla_interposer_rtcheck_leave(const char* const previousContext)
+{
+    tContext = previousContext;
+}
+
+// -----------------------------------------------------------------------
+// Memory
+
+CARLA_EXPORT
+void* malloc(size_t size)
+{
+    checkCall("malloc");
+    return __libc_malloc(size);
+}
+
+CARLA_EXPORT
+void* calloc(size_t nmemb, size_t size)
+{
+    checkCall("calloc");
+    return __libc_calloc(nmemb, size);
+}
+
+CARLA_EXPORT
+void* realloc(void* ptr, size_t size)
+{
+    checkCall("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+CARLA_EXPORT
+void free(void* ptr)
+{
+    if (ptr != nullptr)
+        checkCall("free");
+
+    __libc_free(ptr);
+}
+
+// -----------------------------------------------------------------------
+// Locking
+
+CARLA_EXPORT
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    checkCall("pthread_mutex_lock");
+
+    if (gRealPthreadMutexLock == nullptr)
+        gRealPthreadMutexLock = (PthreadMutexLockFunc)::dlsym(RTLD_NEXT, "pthread_mutex_lock");
+
+    return gRealPthreadMutexLock(mutex);
+}
+
+// -----------------------------------------------------------------------
+// Sleeping and file access
+
+CARLA_EXPORT
+int nanosleep(const struct timespec* req, struct timespec* rem)
+{
+    checkCall("nanosleep");
+
+    if (gRealNanosleep == nullptr)
+        gRealNanosleep = (NanosleepFunc)::dlsym(RTLD_NEXT, "nanosleep");
+
+    return gRealNanosleep(req, rem);
+}
+
+CARLA_EXPORT
+int usleep(useconds_t usec)
+{
+    checkCall("usleep");
+
+    if (gRealUsleep == nullptr)
+        gRealUsleep = (UsleepFunc)::dlsym(RTLD_NEXT, "usleep");
+
+    return gRealUsleep(usec);
+}
+
+CARLA_EXPORT
+int open(const char* pathname, int flags, ...)
+{
+    checkCall("open");
+
+    if (gRealOpen == nullptr)
+        gRealOpen = (OpenFunc)::dlsym(RTLD_NEXT, "open");
+
+    mode_t mode = 0;
+
+    if ((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE)
+    {
+        va_list args;
+        va_start(args, flags);
+        mode = static_cast<mode_t>(va_arg(args, int));
+        va_end(args);
+    }
+
+    return gRealOpen(pathname, flags, mode);
+}
+
+CARLA_EXPORT
+FILE* fopen(const char* pathname, const char* mode)
+{
+    checkCall("fopen");
+
+    if (gRealFopen == nullptr)
+        gRealFopen = (FopenFunc)::dlsym(RTLD_NEXT, "fopen");
+
+    return gRealFopen(pathname, mode);
+}
+
+// -----------------------------------------------------------------------
+// Library constructor
+
+__attribute__((constructor))
+static void carla_interposer_rtcheck_init()
+{
+    gRealPthreadMutexLock = (PthreadMutexLockFunc)::dlsym(RTLD_NEXT, "pthread_mutex_lock");
+    gRealNanosleep        = (NanosleepFunc)::dlsym(RTLD_NEXT, "nanosleep");
+    gRealUsleep           = (UsleepFunc)::dlsym(RTLD_NEXT, "usleep");
+    gRealOpen             = (OpenFunc)::dlsym(RTLD_NEXT, "open");
+    gRealFopen            = (FopenFunc)::dlsym(RTLD_NEXT, "fopen");
+
+    // the first backtrace() call loads libgcc, do it now instead of in the middle of a report
+    void* frame;
+    ::backtrace(&frame, 1);
+}
+
+// -----------------------------------------------------------------------
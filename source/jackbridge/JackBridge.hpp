@@ -333,7 +333,9 @@ JACKBRIDGE_API float          jackbridge_cpu_load(jack_client_t* client);
 
 JACKBRIDGE_API jack_port_t* jackbridge_port_register(jack_client_t* client, const char* port_name, const char* port_type, uint64_t flags, uint64_t buffer_size);
 JACKBRIDGE_API bool         jackbridge_port_unregister(jack_client_t* client, jack_port_t* port);
+#ifndef JACKBRIDGE_DIRECT
 JACKBRIDGE_API void*        jackbridge_port_get_buffer(jack_port_t* port, jack_nframes_t nframes);
+#endif
 
 JACKBRIDGE_API const char*  jackbridge_port_name(const jack_port_t* port);
 JACKBRIDGE_API jack_uuid_t  jackbridge_port_uuid(const jack_port_t* port);
@@ -374,11 +376,50 @@ JACKBRIDGE_API jack_port_t* jackbridge_port_by_id(jack_client_t* client, jack_po
 
 JACKBRIDGE_API void jackbridge_free(void* ptr);
 
+#ifdef JACKBRIDGE_DIRECT
+// when linking to JACK directly the calls used during processing are inlined
+static inline
+void* jackbridge_port_get_buffer(jack_port_t* port, jack_nframes_t nframes)
+{
+    return jack_port_get_buffer(port, nframes);
+}
+
+static inline
+uint32_t jackbridge_midi_get_event_count(void* port_buffer)
+{
+    return jack_midi_get_event_count(port_buffer);
+}
+
+static inline
+bool jackbridge_midi_event_get(jack_midi_event_t* event, void* port_buffer, uint32_t event_index)
+{
+    return (jack_midi_event_get(event, port_buffer, event_index) == 0);
+}
+
+static inline
+void jackbridge_midi_clear_buffer(void* port_buffer)
+{
+    jack_midi_clear_buffer(port_buffer);
+}
+
+static inline
+bool jackbridge_midi_event_write(void* port_buffer, jack_nframes_t time, const jack_midi_data_t* data, uint32_t data_size)
+{
+    return (jack_midi_event_write(port_buffer, time, data, data_size) == 0);
+}
+
+static inline
+jack_midi_data_t* jackbridge_midi_event_reserve(void* port_buffer, jack_nframes_t time, uint32_t data_size)
+{
+    return jack_midi_event_reserve(port_buffer, time, data_size);
+}
+#else
 JACKBRIDGE_API uint32_t jackbridge_midi_get_event_count(void* port_buffer);
 JACKBRIDGE_API bool     jackbridge_midi_event_get(jack_midi_event_t* event, void* port_buffer, uint32_t event_index);
 JACKBRIDGE_API void     jackbridge_midi_clear_buffer(void* port_buffer);
 JACKBRIDGE_API bool     jackbridge_midi_event_write(void* port_buffer, jack_nframes_t time, const jack_midi_data_t* data, uint32_t data_size);
 JACKBRIDGE_API jack_midi_data_t* jackbridge_midi_event_reserve(void* port_buffer, jack_nframes_t time, uint32_t data_size);
+#endif
 
 JACKBRIDGE_API bool jackbridge_release_timebase(jack_client_t* client);
 JACKBRIDGE_API bool jackbridge_set_sync_callback(jack_client_t* client, JackSyncCallback sync_callback, void* arg);
@@ -417,5 +458,6 @@ JACKBRIDGE_API void* jackbridge_shm_map(void* shm, uint64_t size) noexcept;
 JACKBRIDGE_API void  jackbridge_shm_unmap(void* shm, void* ptr) noexcept;
 
 JACKBRIDGE_API void jackbridge_parent_deathsig(bool kill) noexcept;
+JACKBRIDGE_API bool jackbridge_set_thread_policy(int rtPrio, const char* cpuList) noexcept;
 
 #endif // JACKBRIDGE_HPP_INCLUDED
@@ -177,6 +177,38 @@ typedef void (JACKSYM_API *jacksym_set_thread_creator)(jacksym_thread_creator_t)
 
 } // extern "C"
 
+// -----------------------------------------------------------------------------
+// Functions used in the process callbacks.
+// These are resolved once when the library is loaded and never point to null,
+// so the wrappers can call them directly without going through getBridgeInstance().
+
+static void*    JACKSYM_API jackbridge_rt_port_get_buffer(jack_port_t*, jack_nframes_t) { return nullptr; }
+static uint32_t JACKSYM_API jackbridge_rt_midi_get_event_count(void*) { return 0; }
+static int      JACKSYM_API jackbridge_rt_midi_event_get(jack_midi_event_t*, void*, uint32_t) { return -1; }
+static void     JACKSYM_API jackbridge_rt_midi_clear_buffer(void*) {}
+static int      JACKSYM_API jackbridge_rt_midi_event_write(void*, jack_nframes_t, const jack_midi_data_t*, size_t) { return -1; }
+static jack_midi_data_t* JACKSYM_API jackbridge_rt_midi_event_reserve(void*, jack_nframes_t, size_t) { return nullptr; }
+
+struct JackBridgeRT {
+    jacksym_port_get_buffer port_get_buffer_ptr;
+    jacksym_midi_get_event_count midi_get_event_count_ptr;
+    jacksym_midi_event_get midi_event_get_ptr;
+    jacksym_midi_clear_buffer midi_clear_buffer_ptr;
+    jacksym_midi_event_write midi_event_write_ptr;
+    jacksym_midi_event_reserve midi_event_reserve_ptr;
+};
+
+static const JackBridgeRT kJackBridgeRTFallback = {
+    jackbridge_rt_port_get_buffer,
+    jackbridge_rt_midi_get_event_count,
+    jackbridge_rt_midi_event_get,
+    jackbridge_rt_midi_clear_buffer,
+    jackbridge_rt_midi_event_write,
+    jackbridge_rt_midi_event_reserve
+};
+
+static JackBridgeRT gJackBridgeRT = kJackBridgeRTFallback;
+
 // -----------------------------------------------------------------------------
 
 struct JackBridge {
@@ -543,10 +575,23 @@ struct JackBridge {
 
         #undef JOIN
         #undef LIB_SYMBOL
+
+        #define RT_SYMBOL(NAME) if (NAME ## _ptr != nullptr) gJackBridgeRT.NAME ## _ptr = NAME ## _ptr;
+
+        RT_SYMBOL(port_get_buffer)
+        RT_SYMBOL(midi_get_event_count)
+        RT_SYMBOL(midi_event_get)
+        RT_SYMBOL(midi_clear_buffer)
+        RT_SYMBOL(midi_event_write)
+        RT_SYMBOL(midi_event_reserve)
+
+        #undef RT_SYMBOL
     }
 
     ~JackBridge() noexcept
     {
+        gJackBridgeRT = kJackBridgeRTFallback;
+
         if (lib != nullptr)
         {
             lib_close(lib);
@@ -1345,17 +1390,15 @@ bool jackbridge_port_unregister(jack_client_t* client, jack_port_t* port)
     return false;
 }
 
+#ifndef JACKBRIDGE_DIRECT
 void* jackbridge_port_get_buffer(jack_port_t* port, jack_nframes_t nframes)
 {
-#if defined(JACKBRIDGE_DUMMY)
-#elif defined(JACKBRIDGE_DIRECT)
-    return jack_port_get_buffer(port, nframes);
-#else
-    if (getBridgeInstance().port_get_buffer_ptr != nullptr)
-        return getBridgeInstance().port_get_buffer_ptr(port, nframes);
+#ifndef JACKBRIDGE_DUMMY
+    return gJackBridgeRT.port_get_buffer_ptr(port, nframes);
 #endif
     return nullptr;
 }
+#endif
 
 // -----------------------------------------------------------------------------
 
@@ -1761,64 +1804,46 @@ void jackbridge_free(void* ptr)
 
 // -----------------------------------------------------------------------------
 
+#ifndef JACKBRIDGE_DIRECT
 uint32_t jackbridge_midi_get_event_count(void* port_buffer)
 {
-#if defined(JACKBRIDGE_DUMMY)
-#elif defined(JACKBRIDGE_DIRECT)
-    return jack_midi_get_event_count(port_buffer);
-#else
-    if (getBridgeInstance().midi_get_event_count_ptr != nullptr)
-        return getBridgeInstance().midi_get_event_count_ptr(port_buffer);
+#ifndef JACKBRIDGE_DUMMY
+    return gJackBridgeRT.midi_get_event_count_ptr(port_buffer);
 #endif
     return 0;
 }
 
 bool jackbridge_midi_event_get(jack_midi_event_t* event, void* port_buffer, uint32_t event_index)
 {
-#if defined(JACKBRIDGE_DUMMY)
-#elif defined(JACKBRIDGE_DIRECT)
-    return (jack_midi_event_get(event, port_buffer, event_index) == 0);
-#else
-    if (getBridgeInstance().midi_event_get_ptr != nullptr)
-        return (getBridgeInstance().midi_event_get_ptr(event, port_buffer, event_index) == 0);
+#ifndef JACKBRIDGE_DUMMY
+    return (gJackBridgeRT.midi_event_get_ptr(event, port_buffer, event_index) == 0);
 #endif
     return false;
 }
 
 void jackbridge_midi_clear_buffer(void* port_buffer)
 {
-#if defined(JACKBRIDGE_DUMMY)
-#elif defined(JACKBRIDGE_DIRECT)
-    jack_midi_clear_buffer(port_buffer);
-#else
-    if (getBridgeInstance().midi_clear_buffer_ptr != nullptr)
-        getBridgeInstance().midi_clear_buffer_ptr(port_buffer);
+#ifndef JACKBRIDGE_DUMMY
+    gJackBridgeRT.midi_clear_buffer_ptr(port_buffer);
 #endif
 }
 
 bool jackbridge_midi_event_write(void* port_buffer, jack_nframes_t time, const jack_midi_data_t* data, uint32_t data_size)
 {
-#if defined(JACKBRIDGE_DUMMY)
-#elif defined(JACKBRIDGE_DIRECT)
-    return (jack_midi_event_write(port_buffer, time, data, data_size) == 0);
-#else
-    if (getBridgeInstance().midi_event_write_ptr != nullptr)
-        return (getBridgeInstance().midi_event_write_ptr(port_buffer, time, data, data_size) == 0);
+#ifndef JACKBRIDGE_DUMMY
+    return (gJackBridgeRT.midi_event_write_ptr(port_buffer, time, data, data_size) == 0);
 #endif
     return false;
 }
 
 jack_midi_data_t* jackbridge_midi_event_reserve(void* port_buffer, jack_nframes_t time, uint32_t data_size)
 {
-#if defined(JACKBRIDGE_DUMMY)
-#elif defined(JACKBRIDGE_DIRECT)
-    return jack_midi_event_reserve(port_buffer, time, data_size);
-#else
-    if (getBridgeInstance().midi_event_reserve_ptr != nullptr)
-        return getBridgeInstance().midi_event_reserve_ptr(port_buffer, time, data_size);
+#ifndef JACKBRIDGE_DUMMY
+    return gJackBridgeRT.midi_event_reserve_ptr(port_buffer, time, data_size);
 #endif
     return nullptr;
 }
+#endif // ! JACKBRIDGE_DIRECT
 
 // -----------------------------------------------------------------------------
 
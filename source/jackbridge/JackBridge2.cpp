@@ -22,6 +22,7 @@
 # include "CarlaProcessUtils.hpp"
 # include "CarlaSemUtils.hpp"
 # include "CarlaShmUtils.hpp"
+# include "CarlaThread.hpp"
 #endif // ! JACKBRIDGE_DUMMY
 
 // -----------------------------------------------------------------------------
@@ -144,4 +145,24 @@ void jackbridge_parent_deathsig(bool kill) noexcept
 #endif
 }
 
+// Changes the scheduling of the caller thread, an rtPrio of 0 or a null cpuList keeps the current value.
+// Windows bridges running in Wine reach this native code through the exported functions,
+// which is the only way for them to get realtime scheduling and CPU affinity.
+bool jackbridge_set_thread_policy(int rtPrio, const char* cpuList) noexcept
+{
+#ifdef JACKBRIDGE_DUMMY
+    return false;
+#else
+    bool ok = true;
+
+    if (rtPrio > 0 && ! CarlaThread::setCurrentThreadRealtimePriority(rtPrio))
+        ok = false;
+
+    if (cpuList != nullptr && ! CarlaThread::setCurrentThreadCpuAffinity(cpuList))
+        ok = false;
+
+    return ok;
+#endif
+}
+
 // -----------------------------------------------------------------------------
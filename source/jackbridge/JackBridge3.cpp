@@ -141,6 +141,7 @@ const JackBridgeExportedFunctions* JACKBRIDGE_API jackbridge_get_exported_functi
     funcs.shm_map_ptr                          = jackbridge_shm_map;
     funcs.shm_unmap_ptr                        = jackbridge_shm_unmap;
     funcs.parent_deathsig_ptr                  = jackbridge_parent_deathsig;
+    funcs.set_thread_policy_ptr                = jackbridge_set_thread_policy;
 
     funcs.unique1 = funcs.unique2 = funcs.unique3 = 0xdeadf00d;
 
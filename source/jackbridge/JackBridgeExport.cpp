@@ -603,4 +603,9 @@ void jackbridge_parent_deathsig(bool kill) noexcept
     return getBridgeInstance().parent_deathsig_ptr(kill);
 }
 
+bool jackbridge_set_thread_policy(int rtPrio, const char* cpuList) noexcept
+{
+    return getBridgeInstance().set_thread_policy_ptr(rtPrio, cpuList);
+}
+
 // -----------------------------------------------------------------------------
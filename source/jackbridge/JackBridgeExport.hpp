@@ -124,6 +124,7 @@ typedef void (JACKBRIDGE_API *jackbridgesym_shm_close)(void*);
 typedef void* (JACKBRIDGE_API *jackbridgesym_shm_map)(void*, uint64_t);
 typedef void (JACKBRIDGE_API *jackbridgesym_shm_unmap)(void*, void*);
 typedef void (JACKBRIDGE_API *jackbridgesym_parent_deathsig)(bool);
+typedef bool (JACKBRIDGE_API *jackbridgesym_set_thread_policy)(int, const char*);
 
 // -----------------------------------------------------------------------------
 
@@ -234,6 +235,7 @@ struct _JackBridgeExportedFunctions {
     jackbridgesym_shm_map shm_map_ptr;
     jackbridgesym_shm_unmap shm_unmap_ptr;
     jackbridgesym_parent_deathsig parent_deathsig_ptr;
+    jackbridgesym_set_thread_policy set_thread_policy_ptr;
     ulong unique3;
 };
 
@@ -18,6 +18,7 @@
 #include "libjack.hpp"
 
 #include "CarlaThread.hpp"
+#include "CarlaThreadPool.hpp"
 #include "CarlaJuceUtils.hpp"
 
 #include <signal.h>
@@ -113,6 +114,10 @@ public:
           fShmNonRtServerControl(),
           fAudioPoolCopy(nullptr),
           fAudioTmpBuf(nullptr),
+          fParallelBuffers(nullptr),
+          fNumParallelClients(0),
+          fNextParallelClient(0),
+          fThreadPool(),
           fDummyMidiInBuffer(true),
           fDummyMidiOutBuffer(false),
           fMidiInBuffers(nullptr),
@@ -221,7 +226,7 @@ public:
             return nullptr;
 
         while (fNonRealtimeThread.isThreadRunning() && ! fIsReady)
-            carla_sleep(1);
+            carla_msleep(5);
 
         return new JackClientState(fServer, name);
     }
@@ -331,6 +336,17 @@ private:
     bool handleRtData();
     bool handleNonRtData();
 
+    void setClientBuffers(JackClientState* jclient, float* fdataCopyOuts, float* tmpBuf, float* fdataRealOuts);
+    void mixClientOutputs(JackClientState* jclient, const float* fdataCopyOuts, float* fdataRealOuts,
+                          int& numClientOutputsProcessed, bool doBufferAddition);
+    void resizeParallelBuffers();
+    void processParallelClients();
+
+    static void processParallelClientsCallback(void* const ptr, uint)
+    {
+        static_cast<CarlaJackAppClient*>(ptr)->processParallelClients();
+    }
+
     BridgeAudioPool          fShmAudioPool;
     BridgeRtClientControl    fShmRtClientControl;
     BridgeNonRtClientControl fShmNonRtClientControl;
@@ -339,6 +355,20 @@ private:
     float* fAudioPoolCopy;
     float* fAudioTmpBuf;
 
+    // clients processed on the thread pool during the current cycle, see LIBJACK_FLAG_PARALLEL_CLIENTS
+    static const uint kMaxParallelClients = 16;
+    static const uint kMaxParallelWorkers = 3;
+
+    struct ParallelClient {
+        JackClientState* client;
+        float* outs;
+    } fParallelClients[kMaxParallelClients];
+
+    float* fParallelBuffers;
+    uint fNumParallelClients;
+    volatile uint fNextParallelClient;
+    CarlaThreadPool fThreadPool;
+
     JackMidiPortBufferDummy fDummyMidiInBuffer;
     JackMidiPortBufferDummy fDummyMidiOutBuffer;
     JackMidiPortBufferOnStack* fMidiInBuffers;
@@ -457,6 +487,8 @@ bool CarlaJackAppClient::initSharedMemmory()
     fAudioTmpBuf = new float[fServer.bufferSize];
     carla_zeroFloats(fAudioTmpBuf, fServer.bufferSize);
 
+    resizeParallelBuffers();
+
     fLastPingTime = getCurrentTimeMilliseconds();
     CARLA_SAFE_ASSERT(fLastPingTime > 0);
 
@@ -490,6 +522,12 @@ void CarlaJackAppClient::clearSharedMemory() noexcept
         fAudioTmpBuf = nullptr;
     }
 
+    if (fParallelBuffers != nullptr)
+    {
+        delete[] fParallelBuffers;
+        fParallelBuffers = nullptr;
+    }
+
     if (fMidiInBuffers != nullptr)
     {
         delete[] fMidiInBuffers;
@@ -508,6 +546,159 @@ void CarlaJackAppClient::clearSharedMemory() noexcept
     fShmNonRtServerControl.clear();
 }
 
+void CarlaJackAppClient::setClientBuffers(JackClientState* const jclient, float* fdataCopyOuts, float* const tmpBuf,
+                                          float* const fdataRealOuts)
+{
+    uint8_t i;
+    // direct access to shm buffer, used only for inputs
+    float* fdataReal = fShmAudioPool.data;
+    // wherever we're using tmpBuf
+    bool needsTmpBufClear = false;
+
+    // set audio inputs, taken from the previous client output if 'fdataRealOuts' is set (buffer addition mode)
+    i = 0;
+    for (LinkedList<JackPortState*>::Itenerator it = jclient->audioIns.begin2(); it.valid(); it.next())
+    {
+        JackPortState* const jport = it.getValue(nullptr);
+        CARLA_SAFE_ASSERT_CONTINUE(jport != nullptr);
+
+        if (i++ < fServer.numAudioIns)
+        {
+            if (fdataRealOuts == nullptr)
+                jport->buffer = fdataReal;
+            else
+                jport->buffer = fdataRealOuts + (i*fServer.bufferSize);
+
+            fdataReal += fServer.bufferSize;
+        }
+        else
+        {
+            jport->buffer = tmpBuf;
+            needsTmpBufClear = true;
+        }
+    }
+
+    // set audio outputs
+    i = 0;
+    for (LinkedList<JackPortState*>::Itenerator it = jclient->audioOuts.begin2(); it.valid(); it.next())
+    {
+        JackPortState* const jport = it.getValue(nullptr);
+        CARLA_SAFE_ASSERT_CONTINUE(jport != nullptr);
+
+        if (i++ < fServer.numAudioOuts)
+        {
+            jport->buffer = fdataCopyOuts;
+            fdataCopyOuts += fServer.bufferSize;
+        }
+        else
+        {
+            jport->buffer = tmpBuf;
+            needsTmpBufClear = true;
+        }
+    }
+    if (i < fServer.numAudioOuts)
+    {
+        const std::size_t remainingBufferSize = fServer.bufferSize * static_cast<uint8_t>(fServer.numAudioOuts - i);
+        carla_zeroFloats(fdataCopyOuts, remainingBufferSize);
+    }
+
+    // set midi inputs
+    i = 0;
+    for (LinkedList<JackPortState*>::Itenerator it = jclient->midiIns.begin2(); it.valid(); it.next())
+    {
+        JackPortState* const jport = it.getValue(nullptr);
+        CARLA_SAFE_ASSERT_CONTINUE(jport != nullptr);
+
+        if (i++ < fServer.numMidiIns)
+            jport->buffer = &fMidiInBuffers[i-1];
+        else
+            jport->buffer = &fDummyMidiInBuffer;
+    }
+
+    // set midi outputs
+    i = 0;
+    for (LinkedList<JackPortState*>::Itenerator it = jclient->midiOuts.begin2(); it.valid(); it.next())
+    {
+        JackPortState* const jport = it.getValue(nullptr);
+        CARLA_SAFE_ASSERT_CONTINUE(jport != nullptr);
+
+        if (i++ < fServer.numMidiOuts)
+            jport->buffer = &fMidiOutBuffers[i-1];
+        else
+            jport->buffer = &fDummyMidiOutBuffer;
+    }
+
+    if (needsTmpBufClear)
+        carla_zeroFloats(tmpBuf, fServer.bufferSize);
+}
+
+void CarlaJackAppClient::mixClientOutputs(JackClientState* const jclient, const float* const fdataCopyOuts,
+                                          float* const fdataRealOuts, int& numClientOutputsProcessed,
+                                          const bool doBufferAddition)
+{
+    if (fServer.numAudioOuts == 0)
+        return;
+
+    if (++numClientOutputsProcessed == 1)
+    {
+        // first client, we can copy stuff over
+        carla_copyFloats(fdataRealOuts, fdataCopyOuts,
+                         fServer.bufferSize*fServer.numAudioOuts);
+    }
+    else
+    {
+        // subsequent clients, add data (then divide by number of clients later on)
+        carla_add(fdataRealOuts, fdataCopyOuts,
+                  fServer.bufferSize*fServer.numAudioOuts);
+
+        if (doBufferAddition)
+        {
+            // for more than 1 client addition, we need to divide buffers now
+            carla_multiply(fdataRealOuts,
+                           1.0f/static_cast<float>(numClientOutputsProcessed),
+                           fServer.bufferSize*fServer.numAudioOuts);
+        }
+    }
+
+    if (jclient->audioOuts.count() == 1 && fServer.numAudioOuts > 1)
+    {
+        for (uint8_t j=1; j<fServer.numAudioOuts; ++j)
+        {
+            carla_copyFloats(fdataRealOuts+(fServer.bufferSize*j),
+                             fdataCopyOuts,
+                             fServer.bufferSize);
+        }
+    }
+}
+
+void CarlaJackAppClient::resizeParallelBuffers()
+{
+    if ((fSetupHints & LIBJACK_FLAG_PARALLEL_CLIENTS) == 0)
+        return;
+
+    delete[] fParallelBuffers;
+
+    // outputs plus a temporary buffer per client
+    const std::size_t size = kMaxParallelClients*fServer.bufferSize*(fServer.numAudioOuts+1U);
+    fParallelBuffers = new float[size];
+    carla_zeroFloats(fParallelBuffers, size);
+}
+
+void CarlaJackAppClient::processParallelClients()
+{
+#ifdef __SSE2_MATH__
+    // Set FTZ and DAZ flags, workers do not inherit them
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+#endif
+
+    for (uint i; (i = __sync_fetch_and_add(&fNextParallelClient, 1)) < fNumParallelClients;)
+    {
+        JackClientState* const jclient(fParallelClients[i].client);
+
+        jclient->processCb(fServer.bufferSize, jclient->processCbPtr);
+    }
+}
+
 bool CarlaJackAppClient::handleRtData()
 {
     if (fNewClients.count() != 0)
@@ -586,6 +777,8 @@ bool CarlaJackAppClient::handleRtData()
                     delete[] fAudioTmpBuf;
                     fAudioTmpBuf = new float[fServer.bufferSize];
                     carla_zeroFloats(fAudioTmpBuf, fServer.bufferSize);
+
+                    resizeParallelBuffers();
                 }
             }
             break;
@@ -842,163 +1035,81 @@ bool CarlaJackAppClient::handleRtData()
 
                     int numClientOutputsProcessed = 0;
 
+                    fNumParallelClients = 0;
+
                     // now go through each client
                     for (LinkedList<JackClientState*>::Itenerator it = fClients.begin2(); it.valid(); it.next())
                     {
                         JackClientState* const jclient(it.getValue(nullptr));
                         CARLA_SAFE_ASSERT_CONTINUE(jclient != nullptr);
 
-                        const CarlaMutexTryLocker cmtl2(jclient->mutex, fIsOffline);
+                        // released after processing, or after the mixdown for clients running in parallel
+                        const bool locked = fIsOffline ? jclient->mutex.lock() : jclient->mutex.tryLock();
 
                         // check if we can process
-                        if (cmtl2.wasNotLocked() || jclient->processCb == nullptr || ! jclient->activated)
+                        if (! locked || jclient->processCb == nullptr || ! jclient->activated)
                         {
+                            if (locked)
+                                jclient->mutex.unlock();
+
                             if (fServer.numAudioOuts > 0)
                                 carla_zeroFloats(fdataRealOuts, fServer.bufferSize*fServer.numAudioOuts);
 
                             if (jclient->deactivated)
                                 fShmRtClientControl.data->procFlags = 1;
-                        }
-                        else
-                        {
-                            // report transport sync changes if needed
-                            if (transportChanged && jclient->syncCb != nullptr)
-                            {
-                                jclient->syncCb(fServer.playing ? JackTransportRolling : JackTransportStopped,
-                                                &fServer.position,
-                                                jclient->syncCbPtr);
-                            }
-
-                            uint8_t i;
-                            // direct access to shm buffer, used only for inputs
-                            float* fdataReal = fShmAudioPool.data;
-                            // safe temp location for output, mixed down to shm buffer later on
-                            float* fdataCopy = fAudioPoolCopy;
-                            // wherever we're using fAudioTmpBuf
-                            bool needsTmpBufClear = false;
-
-                            // set audio inputs
-                            i = 0;
-                            for (LinkedList<JackPortState*>::Itenerator it2 = jclient->audioIns.begin2(); it2.valid(); it2.next())
-                            {
-                                JackPortState* const jport = it2.getValue(nullptr);
-                                CARLA_SAFE_ASSERT_CONTINUE(jport != nullptr);
 
-                                if (i++ < fServer.numAudioIns)
-                                {
-                                    if (numClientOutputsProcessed == 0 || ! doBufferAddition)
-                                        jport->buffer = fdataReal;
-                                    else
-                                        jport->buffer = fdataRealOuts + (i*fServer.bufferSize);
+                            continue;
+                        }
 
-                                    fdataReal += fServer.bufferSize;
-                                    fdataCopy += fServer.bufferSize;
-                                }
-                                else
-                                {
-                                    jport->buffer = fAudioTmpBuf;
-                                    needsTmpBufClear = true;
-                                }
-                            }
-                            if (i < fServer.numAudioIns)
-                            {
-                                const std::size_t remainingBufferSize = fServer.bufferSize * static_cast<uint8_t>(fServer.numAudioIns - i);
-                                //fdataReal += remainingBufferSize;
-                                fdataCopy += remainingBufferSize;
-                            }
+                        // report transport sync changes if needed
+                        if (transportChanged && jclient->syncCb != nullptr)
+                        {
+                            jclient->syncCb(fServer.playing ? JackTransportRolling : JackTransportStopped,
+                                            &fServer.position,
+                                            jclient->syncCbPtr);
+                        }
 
-                            // location to start of audio outputs
-                            float* const fdataCopyOuts = fdataCopy;
+                        // clients sharing the same inputs and without MIDI output can run at the same time,
+                        // each one then needs its own output and temporary buffers
+                        if (fThreadPool.getNumWorkers() != 0 && fParallelBuffers != nullptr && ! doBufferAddition
+                            && jclient->midiOuts.isEmpty() && fNumParallelClients < kMaxParallelClients)
+                        {
+                            float* const fdataCopyOuts = fParallelBuffers
+                                                       + fNumParallelClients*fServer.bufferSize*(fServer.numAudioOuts+1U);
 
-                            // set audio outputs
-                            i = 0;
-                            for (LinkedList<JackPortState*>::Itenerator it2 = jclient->audioOuts.begin2(); it2.valid(); it2.next())
-                            {
-                                JackPortState* const jport = it2.getValue(nullptr);
-                                CARLA_SAFE_ASSERT_CONTINUE(jport != nullptr);
+                            setClientBuffers(jclient, fdataCopyOuts, fdataCopyOuts + fServer.bufferSize*fServer.numAudioOuts, nullptr);
 
-                                if (i++ < fServer.numAudioOuts)
-                                {
-                                    jport->buffer = fdataCopy;
-                                    fdataCopy += fServer.bufferSize;
-                                }
-                                else
-                                {
-                                    jport->buffer = fAudioTmpBuf;
-                                    needsTmpBufClear = true;
-                                }
-                            }
-                            if (i < fServer.numAudioOuts)
-                            {
-                                const std::size_t remainingBufferSize = fServer.bufferSize * static_cast<uint8_t>(fServer.numAudioOuts - i);
-                                carla_zeroFloats(fdataCopy, remainingBufferSize);
-                                //fdataCopy += remainingBufferSize;
-                            }
+                            fParallelClients[fNumParallelClients].client = jclient;
+                            fParallelClients[fNumParallelClients].outs   = fdataCopyOuts;
+                            ++fNumParallelClients;
+                            continue;
+                        }
 
-                            // set midi inputs
-                            i = 0;
-                            for (LinkedList<JackPortState*>::Itenerator it2 = jclient->midiIns.begin2(); it2.valid(); it2.next())
-                            {
-                                JackPortState* const jport = it2.getValue(nullptr);
-                                CARLA_SAFE_ASSERT_CONTINUE(jport != nullptr);
+                        // safe temp location for output, mixed down to shm buffer later on
+                        float* const fdataCopyOuts = fAudioPoolCopy + fServer.bufferSize*fServer.numAudioIns;
 
-                                if (i++ < fServer.numMidiIns)
-                                    jport->buffer = &fMidiInBuffers[i-1];
-                                else
-                                    jport->buffer = &fDummyMidiInBuffer;
-                            }
+                        setClientBuffers(jclient, fdataCopyOuts, fAudioTmpBuf,
+                                         (numClientOutputsProcessed != 0 && doBufferAddition) ? fdataRealOuts : nullptr);
 
-                            // set midi outputs
-                            i = 0;
-                            for (LinkedList<JackPortState*>::Itenerator it2 = jclient->midiOuts.begin2(); it2.valid(); it2.next())
-                            {
-                                JackPortState* const jport = it2.getValue(nullptr);
-                                CARLA_SAFE_ASSERT_CONTINUE(jport != nullptr);
+                        jclient->processCb(fServer.bufferSize, jclient->processCbPtr);
 
-                                if (i++ < fServer.numMidiOuts)
-                                    jport->buffer = &fMidiOutBuffers[i-1];
-                                else
-                                    jport->buffer = &fDummyMidiOutBuffer;
-                            }
+                        mixClientOutputs(jclient, fdataCopyOuts, fdataRealOuts, numClientOutputsProcessed, doBufferAddition);
 
-                            if (needsTmpBufClear)
-                                carla_zeroFloats(fAudioTmpBuf, fServer.bufferSize);
+                        jclient->mutex.unlock();
+                    }
 
-                            jclient->processCb(fServer.bufferSize, jclient->processCbPtr);
+                    if (fNumParallelClients != 0)
+                    {
+                        fNextParallelClient = 0;
+                        fThreadPool.run(processParallelClientsCallback, this, fNumParallelClients - 1);
 
-                            if (fServer.numAudioOuts > 0)
-                            {
-                                if (++numClientOutputsProcessed == 1)
-                                {
-                                    // first client, we can copy stuff over
-                                    carla_copyFloats(fdataRealOuts, fdataCopyOuts,
-                                                     fServer.bufferSize*fServer.numAudioOuts);
-                                }
-                                else
-                                {
-                                    // subsequent clients, add data (then divide by number of clients later on)
-                                    carla_add(fdataRealOuts, fdataCopyOuts,
-                                              fServer.bufferSize*fServer.numAudioOuts);
+                        for (uint i=0; i < fNumParallelClients; ++i)
+                        {
+                            JackClientState* const jclient(fParallelClients[i].client);
 
-                                    if (doBufferAddition)
-                                    {
-                                        // for more than 1 client addition, we need to divide buffers now
-                                        carla_multiply(fdataRealOuts,
-                                                       1.0f/static_cast<float>(numClientOutputsProcessed),
-                                                       fServer.bufferSize*fServer.numAudioOuts);
-                                    }
-                                }
+                            mixClientOutputs(jclient, fParallelClients[i].outs, fdataRealOuts, numClientOutputsProcessed, false);
 
-                                if (jclient->audioOuts.count() == 1 && fServer.numAudioOuts > 1)
-                                {
-                                    for (uint8_t j=1; j<fServer.numAudioOuts; ++j)
-                                    {
-                                        carla_copyFloats(fdataRealOuts+(fServer.bufferSize*j),
-                                                         fdataCopyOuts,
-                                                         fServer.bufferSize);
-                                    }
-                                }
-                            }
+                            jclient->mutex.unlock();
                         }
                     }
 
@@ -1124,6 +1235,11 @@ bool CarlaJackAppClient::handleRtData()
         case kPluginBridgeRtClientQuit:
             ret = true;
             break;
+
+        case kPluginBridgeRtClientSetMidiBlockSize:
+            // never sent to JACK applications, MIDI keeps going through the ring buffer
+            fShmRtClientControl.readUInt();
+            break;
         }
 
 #ifdef DEBUG
@@ -1194,6 +1310,10 @@ bool CarlaJackAppClient::handleNonRtData()
         case kPluginBridgeNonRtClientSetMidiProgram:
         case kPluginBridgeNonRtClientSetCustomData:
         case kPluginBridgeNonRtClientSetChunkDataFile:
+        case kPluginBridgeNonRtClientSetChunkDataShm:
+        case kPluginBridgeNonRtClientSetSaveChunkDataShm:
+        case kPluginBridgeNonRtClientLoadPlugin:
+        case kPluginBridgeNonRtClientAddGroupMember:
             break;
 
         case kPluginBridgeNonRtClientSetOption:
@@ -1213,6 +1333,11 @@ bool CarlaJackAppClient::handleNonRtData()
             fShmNonRtClientControl.readUInt();
             break;
 
+        case kPluginBridgeNonRtClientGetParameterNames:
+            fShmNonRtClientControl.readUInt();
+            fShmNonRtClientControl.readUInt();
+            break;
+
         case kPluginBridgeNonRtClientPrepareForSave:
             {
                 if (fSessionManager == LIBJACK_SESSION_MANAGER_AUTO && std::getenv("NSM_URL") == nullptr)
@@ -1272,6 +1397,25 @@ bool CarlaJackAppClient::handleNonRtData()
         case kPluginBridgeNonRtClientQuit:
             ret = true;
             break;
+
+        case kPluginBridgeNonRtClientSetThreadPolicy: {
+            const int32_t rtPrio(fShmNonRtClientControl.readInt());
+
+            const uint32_t cpuListSize(fShmNonRtClientControl.readUInt());
+            char cpuList[cpuListSize+1];
+            carla_zeroChars(cpuList, cpuListSize+1);
+            if (cpuListSize != 0)
+                fShmNonRtClientControl.readCustomData(cpuList, cpuListSize);
+
+            if (! fRealtimeThread.isThreadRunning())
+                break;
+
+            if (rtPrio > 0)
+                fRealtimeThread.setRealtimePriority(rtPrio);
+
+            fRealtimeThread.setCpuAffinity(cpuList);
+            break;
+        }
         }
 
 #ifdef DEBUG
@@ -1293,6 +1437,19 @@ void CarlaJackAppClient::runRealtimeThread()
     _mm_setcsr(_mm_getcsr() | 0x8040);
 #endif
 
+    // host defaults, plugin overrides come later through kPluginBridgeNonRtClientSetThreadPolicy
+    if (const char* const rtPrio = std::getenv("CARLA_LIBJACK_RT_PRIO"))
+        if (const int prio = std::atoi(rtPrio))
+            CarlaThread::setCurrentThreadRealtimePriority(prio);
+
+    const char* const cpuList = std::getenv("CARLA_LIBJACK_CPU_AFFINITY");
+
+    if (cpuList != nullptr && cpuList[0] != '\0')
+        CarlaThread::setCurrentThreadCpuAffinity(cpuList);
+
+    if (fSetupHints & LIBJACK_FLAG_PARALLEL_CLIENTS)
+        fThreadPool.start(kMaxParallelWorkers, true, cpuList);
+
     bool quitReceived = false;
 
     for (; ! fRealtimeThread.shouldThreadExit();)
@@ -1305,6 +1462,7 @@ void CarlaJackAppClient::runRealtimeThread()
     }
 
     fNonRealtimeThread.signalThreadShouldExit();
+    fThreadPool.stop();
 
     carla_debug("CarlaJackAppClient runRealtimeThread FINISHED");
 
@@ -1343,7 +1501,8 @@ void CarlaJackAppClient::runNonRealtimeThread()
 
     for (; ! fNonRealtimeThread.shouldThreadExit();)
     {
-        carla_msleep(50);
+        // woken up as soon as the server commits new data, the timeout only makes us check for thread exit
+        fShmNonRtClientControl.waitForData(500);
 
         try {
             quitReceived = handleNonRtData();
@@ -70,6 +70,16 @@ int64_t ad_seek  (void *sf, int64_t pos);
  */
 ssize_t ad_read  (void *sf, float* out, size_t len);
 
+/** decode audio data chunk to separate (non-interleaved) floating point buffers, one per channel
+ *
+ * saves the caller from de-interleaving, and backends can skip their own interleaving.
+ * @param sf decoder handle
+ * @param out array of nfo->channels buffers -- each must be large enough to hold (sizeof(float) * frames) bytes.
+ * @param frames number of frames (!) to read.
+ * @return the number of read frames, -1 on error.
+ */
+ssize_t ad_read_planar (void *sf, float** out, size_t frames);
+
 /** re-read the file information and meta-data.
  *
  * this is not neccesary in general \ref ad_open includes an inplicit call
@@ -32,6 +32,15 @@
 #define MIN(a,b) ( ( (a) < (b) )? (a) : (b) )
 #endif
 
+/* distance between seek index entries, and how far before the wanted frame decoding starts after a seek */
+#define SEEK_INDEX_INTERVAL_MS 250
+#define SEEK_PREROLL_MS 50
+
+typedef struct {
+  int64_t frame; // first frame of the packet
+  int64_t pos;   // byte position of the packet in the file
+} ffmpeg_seek_point;
+
 typedef struct {
   AVFormatContext* formatContext;
   AVCodecContext*  codecContext;
@@ -41,9 +50,19 @@ typedef struct {
   int              pkt_len;
   uint8_t*         pkt_ptr;
 
+  /* decoded frames as float, one plane of m_planeCapacity frames per channel */
+  float*           m_planes;
+  unsigned long    m_planeCapacity;
+  unsigned long    m_planeStart;  // first frame not yet returned
+  unsigned long    m_planeFrames; // number of frames not yet returned
+
+#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(54, 0, 0)
   int16_t          m_tmpBuffer[AVCODEC_MAX_AUDIO_FRAME_SIZE];
-  int16_t*         m_tmpBufferStart;
-  unsigned long    m_tmpBufferLen;
+#endif
+
+  /* built on open for compressed formats, so seeking can land close before the wanted frame */
+  ffmpeg_seek_point* seek_index;
+  int              seek_index_len;
 
   int64_t          decoder_clock;
   int64_t          output_clock;
@@ -90,13 +109,63 @@ static int ad_info_ffmpeg(void *sf, struct adinfo *nfo) {
   return 0;
 }
 
+/* read through all packets once (without decoding) and remember where they start.
+ * timestamp-based seeking lands anywhere for most compressed formats, this makes seeks frame accurate.
+ */
+static void build_seek_index(ffmpeg_audio_decoder *priv) {
+  AVFormatContext *fc = priv->formatContext;
+  const AVStream *stream = fc->streams[priv->audioStream];
+  const double frames_per_tick = priv->samplerate * av_q2d(stream->time_base);
+  const int64_t interval = (int64_t) priv->samplerate * SEEK_INDEX_INTERVAL_MS / 1000;
+  int capacity = 0;
+  int64_t last_frame = -interval;
+  AVPacket packet;
+
+  if (!fc->pb || (fc->iformat->flags & AVFMT_NO_BYTE_SEEK)) return;
+  /* raw PCM can be seeked to exactly already */
+  if (av_get_bits_per_sample(priv->codecContext->codec_id) != 0) return;
+
+  memset(&packet, 0, sizeof(AVPacket));
+  while (av_read_frame(fc, &packet) >= 0) {
+    if (packet.stream_index == priv->audioStream && packet.pts != AV_NOPTS_VALUE && packet.pos >= 0) {
+      const int64_t frame = (int64_t) (frames_per_tick * packet.pts);
+      if (frame - last_frame >= interval) {
+        if (priv->seek_index_len == capacity) {
+          const int new_capacity = capacity ? capacity * 2 : 256;
+          ffmpeg_seek_point *index = (ffmpeg_seek_point*) realloc(priv->seek_index, sizeof(ffmpeg_seek_point) * new_capacity);
+          if (!index) { av_free_packet(&packet); break; }
+          priv->seek_index = index;
+          capacity = new_capacity;
+        }
+        priv->seek_index[priv->seek_index_len].frame = frame;
+        priv->seek_index[priv->seek_index_len].pos = packet.pos;
+        ++priv->seek_index_len;
+        last_frame = frame;
+      }
+    }
+    av_free_packet(&packet);
+  }
+
+  dbg(1, "ffmpeg - seek index with %i entries", priv->seek_index_len);
+
+  /* back to the start */
+  if (priv->seek_index_len > 0) {
+    av_seek_frame(fc, priv->audioStream, priv->seek_index[0].pos, AVSEEK_FLAG_BYTE);
+  } else {
+    av_seek_frame(fc, priv->audioStream, 0, AVSEEK_FLAG_ANY | AVSEEK_FLAG_BACKWARD);
+  }
+  avcodec_flush_buffers(priv->codecContext);
+}
+
 static void *ad_open_ffmpeg(const char *fn, struct adinfo *nfo) {
   ffmpeg_audio_decoder *priv = (ffmpeg_audio_decoder*) calloc(1, sizeof(ffmpeg_audio_decoder));
   
-  priv->m_tmpBufferStart=NULL;
-  priv->m_tmpBufferLen=0;
+  priv->m_planes=NULL;
+  priv->m_planeCapacity=priv->m_planeStart=priv->m_planeFrames=0;
   priv->decoder_clock=priv->output_clock=priv->seek_frame=0; 
   priv->packet.size=0; priv->packet.data=NULL;
+  priv->seek_index=NULL;
+  priv->seek_index_len=0;
 
   if (avformat_open_input(&priv->formatContext, fn, NULL, NULL) <0) {
     dbg(0, "ffmpeg is unable to open file '%s'.", fn);
@@ -152,6 +221,8 @@ static void *ad_open_ffmpeg(const char *fn, struct adinfo *nfo) {
     free(priv); return(NULL);
   }
 
+  build_seek_index(priv);
+
   dbg(1, "ffmpeg - %s", fn);
   if (nfo) 
     dbg(1, "ffmpeg - sr:%i c:%i d:%"PRIi64" f:%"PRIi64, nfo->sample_rate, nfo->channels, nfo->length, nfo->frames);
@@ -164,40 +235,105 @@ static int ad_close_ffmpeg(void *sf) {
   if (!priv) return -1;
   avcodec_close(priv->codecContext);
   avformat_close_input(&priv->formatContext);
+  free(priv->m_planes);
+  free(priv->seek_index);
   free(priv);
   return 0;
 }
 
-static void int16_to_float(int16_t *in, float *out, int num_channels, int num_samples, int out_offset) {
-  int i,ii;
-  for (i=0;i<num_samples;i++) {
-    for (ii=0;ii<num_channels;ii++) {
-     out[(i+out_offset)*num_channels+ii]= (float) in[i*num_channels+ii]/ 32768.0;
+/* make room for 'frames' decoded frames, previous contents are discarded */
+static int reserve_planes(ffmpeg_audio_decoder *priv, unsigned long frames) {
+  if (frames <= priv->m_planeCapacity) return 0;
+  float *planes = (float*) malloc(sizeof(float) * frames * priv->channels);
+  if (!planes) return -1;
+  free(priv->m_planes);
+  priv->m_planes = planes;
+  priv->m_planeCapacity = frames;
+  return 0;
+}
+
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(54, 0, 0)
+/* convert decoded samples to float planes, straight from the decoder's sample format */
+static void samples_to_float(const uint8_t * const *data, enum AVSampleFormat fmt, int num_channels, int num_samples, float *planes, unsigned long capacity) {
+  const int planar = av_sample_fmt_is_planar(fmt);
+  const int stride = planar ? 1 : num_channels;
+  int c, i;
+  for (c = 0; c < num_channels; c++) {
+    const uint8_t *in = planar ? data[c] : data[0];
+    const int offset = planar ? 0 : c;
+    float *out = planes + c * capacity;
+    switch (av_get_packed_sample_fmt(fmt)) {
+      case AV_SAMPLE_FMT_U8:
+        for (i = 0; i < num_samples; i++)
+          out[i] = (float) ((int) in[i*stride+offset] - 128) / 128.0f;
+        break;
+      case AV_SAMPLE_FMT_S16:
+        for (i = 0; i < num_samples; i++)
+          out[i] = (float) ((const int16_t*) in)[i*stride+offset] / 32768.0f;
+        break;
+      case AV_SAMPLE_FMT_S32:
+        for (i = 0; i < num_samples; i++)
+          out[i] = (float) ((double) ((const int32_t*) in)[i*stride+offset] / 2147483648.0);
+        break;
+      case AV_SAMPLE_FMT_FLT:
+        if (planar) {
+          memcpy(out, in, sizeof(float) * num_samples);
+        } else {
+          for (i = 0; i < num_samples; i++)
+            out[i] = ((const float*) in)[i*stride+offset];
+        }
+        break;
+      case AV_SAMPLE_FMT_DBL:
+        for (i = 0; i < num_samples; i++)
+          out[i] = (float) ((const double*) in)[i*stride+offset];
+        break;
+      default:
+        dbg(0, "unsupported sample format %i", fmt);
+        memset(out, 0, sizeof(float) * num_samples);
+        break;
     }
   }
 }
+#else
+static void int16_to_float(const int16_t *in, int num_channels, int num_samples, float *planes, unsigned long capacity) {
+  int c, i;
+  for (c = 0; c < num_channels; c++) {
+    float *out = planes + c * capacity;
+    for (i = 0; i < num_samples; i++)
+      out[i] = (float) in[i*num_channels+c] / 32768.0f;
+  }
+}
+#endif
 
-static ssize_t ad_read_ffmpeg(void *sf, float* d, size_t len) {
-  ffmpeg_audio_decoder *priv = (ffmpeg_audio_decoder*) sf;
-  if (!priv) return -1;
-  size_t frames = len / priv->channels;
+/* decode 'frames' frames into either 'interleaved' or 'planar', returns the number of frames read */
+static ssize_t ffmpeg_read(ffmpeg_audio_decoder *priv, float *interleaved, float **planar, size_t frames) {
+  const unsigned int channels = priv->channels;
+  unsigned int c;
 
   size_t written = 0;
   ssize_t ret = 0;
   while (ret >= 0 && written < frames) {
-    dbg(3,"loop: %i/%i (bl:%lu)",written, frames, priv->m_tmpBufferLen );
-    if (priv->seek_frame == 0 && priv->m_tmpBufferLen > 0 ) {
-      int s = MIN(priv->m_tmpBufferLen / priv->channels, frames - written );
-      int16_to_float(priv->m_tmpBufferStart, d, priv->channels, s , written);
+    dbg(3,"loop: %lu/%lu (bl:%lu)", (unsigned long) written, (unsigned long) frames, priv->m_planeFrames);
+    if (priv->seek_frame == 0 && priv->m_planeFrames > 0 ) {
+      const unsigned long s = MIN(priv->m_planeFrames, frames - written);
+      for (c = 0; c < channels; c++) {
+        const float *in = priv->m_planes + c * priv->m_planeCapacity + priv->m_planeStart;
+        if (planar) {
+          memcpy(planar[c] + written, in, sizeof(float) * s);
+        } else {
+          unsigned long i;
+          for (i = 0; i < s; i++)
+            interleaved[(written+i)*channels+c] = in[i];
+        }
+      }
       written += s;
       priv->output_clock+=s;
-      s = s * priv->channels;
-      priv->m_tmpBufferStart += s;
-      priv->m_tmpBufferLen -= s;
+      priv->m_planeStart += s;
+      priv->m_planeFrames -= s;
       ret = 0;
     } else {
-      priv->m_tmpBufferStart = priv->m_tmpBuffer;
-      priv->m_tmpBufferLen = 0;
+      priv->m_planeStart = 0;
+      priv->m_planeFrames = 0;
 
       if (!priv->pkt_ptr || priv->pkt_len <1 ) {
         if (priv->packet.data) av_free_packet(&priv->packet);
@@ -213,7 +349,7 @@ static ssize_t ad_read_ffmpeg(void *sf, float* d, size_t len) {
       }
 
       /* decode all chunks in packet */
-      int data_size = AVCODEC_MAX_AUDIO_FRAME_SIZE;
+      int decoded = 0;
 
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(54, 0, 0)
       // TODO use av_frame_alloc() and av_frame_free() with newer ffmpeg
@@ -222,23 +358,17 @@ static ssize_t ad_read_ffmpeg(void *sf, float* d, size_t len) {
       int got_frame = 0;
       ret = avcodec_decode_audio4(priv->codecContext, &avf, &got_frame, &priv->packet);
       if (ret >= 0 && got_frame) {
-        int ch, plane_size;
-        const int planar = av_sample_fmt_is_planar(priv->codecContext->sample_fmt);
-        data_size = av_samples_get_buffer_size(&plane_size, priv->codecContext->channels, avf.nb_samples, priv->codecContext->sample_fmt, 1);
-        if (data_size <= AVCODEC_MAX_AUDIO_FRAME_SIZE) {
-          memcpy(priv->m_tmpBuffer, avf.extended_data[0], plane_size);
-          if (planar && priv->codecContext->channels > 1) {
-            uint8_t *out = ((uint8_t *)priv->m_tmpBuffer) + plane_size;
-            for (ch = 1; ch < priv->codecContext->channels; ch++) {
-              memcpy(out, avf.extended_data[ch], plane_size);
-              out += plane_size;
-            }
-          }
+        if (reserve_planes(priv, avf.nb_samples) == 0) {
+          samples_to_float((const uint8_t * const *) avf.extended_data, priv->codecContext->sample_fmt,
+                           channels, avf.nb_samples, priv->m_planes, priv->m_planeCapacity);
+          decoded = avf.nb_samples;
         }
       } else {
         ret = -1;
       }
-#elif LIBAVUTIL_VERSION_INT > AV_VERSION_INT(49, 15, 0) && LIBAVCODEC_VERSION_INT > AV_VERSION_INT(52, 20, 1) // ??
+#else
+      int data_size = AVCODEC_MAX_AUDIO_FRAME_SIZE;
+#if LIBAVUTIL_VERSION_INT > AV_VERSION_INT(49, 15, 0) && LIBAVCODEC_VERSION_INT > AV_VERSION_INT(52, 20, 1) // ??
       // this was deprecated in LIBAVCODEC_VERSION_MAJOR 53
       ret = avcodec_decode_audio3(priv->codecContext,
           priv->m_tmpBuffer, &data_size, &priv->packet);
@@ -248,6 +378,14 @@ static ssize_t ad_read_ffmpeg(void *sf, float* d, size_t len) {
       ret = avcodec_decode_audio2(priv->codecContext,
           priv->m_tmpBuffer, &data_size, ptr, len);
 #endif
+      if (ret >= 0 && data_size > 0) {
+        const int num_samples = (data_size>>1) / channels; // 2 bytes per sample
+        if (reserve_planes(priv, num_samples) == 0) {
+          int16_to_float(priv->m_tmpBuffer, channels, num_samples, priv->m_planes, priv->m_planeCapacity);
+          decoded = num_samples;
+        }
+      }
+#endif
 
       if (ret < 0 || ret > priv->pkt_len) {
 #if 0
@@ -266,36 +404,30 @@ static ssize_t ad_read_ffmpeg(void *sf, float* d, size_t len) {
         priv->decoder_clock = priv->samplerate * av_q2d(priv->formatContext->streams[priv->audioStream]->time_base) * priv->packet.pts;
       } else {
         dbg(0, "!!! NO PTS timestamp in file");
-        priv->decoder_clock += (data_size>>1) / priv->channels;
+        priv->decoder_clock += decoded;
       }
 
-      if (data_size>0) {
-        priv->m_tmpBufferLen+= (data_size>>1); // 2 bytes per sample
-      }
+      priv->m_planeFrames = decoded;
 
       /* align buffer after seek. */
       if (priv->seek_frame > 0) { 
-        const int diff = priv->output_clock-priv->decoder_clock;
+        const int64_t diff = priv->output_clock-priv->decoder_clock;
         if (diff<0) { 
           /* seek ended up past the wanted sample */
           dbg(0, " !!! Audio seek failed.");
           return -1;
-        } else if (priv->m_tmpBufferLen < (diff*priv->channels)) {
+        } else if ((int64_t) priv->m_planeFrames < diff) {
           /* wanted sample not in current buffer - keep going */
-          dbg(2, " !!! seeked sample was not in decoded buffer. frames-to-go: %li", diff);
-          priv->m_tmpBufferLen = 0;
-        } else if (diff!=0 && data_size > 0) {
+          dbg(2, " !!! seeked sample was not in decoded buffer. frames-to-go: %"PRIi64, diff);
+          priv->m_planeFrames = 0;
+        } else if (diff!=0 && decoded > 0) {
           /* wanted sample is in current buffer but not at the beginnning */
-          dbg(2, " !!! sync buffer to seek. (diff:%i)", diff);
-          priv->m_tmpBufferStart+= diff*priv->codecContext->channels;
-          priv->m_tmpBufferLen  -= diff*priv->codecContext->channels;
-#if 1
-          memmove(priv->m_tmpBuffer, priv->m_tmpBufferStart, priv->m_tmpBufferLen);
-          priv->m_tmpBufferStart = priv->m_tmpBuffer;
-#endif
+          dbg(2, " !!! sync buffer to seek. (diff:%"PRIi64")", diff);
+          priv->m_planeStart += diff;
+          priv->m_planeFrames -= diff;
           priv->seek_frame=0;
           priv->decoder_clock += diff;
-        } else if (data_size > 0) {
+        } else if (decoded > 0) {
           dbg(2, "Audio exact sync-seek (%"PRIi64" == %"PRIi64")", priv->decoder_clock, priv->seek_frame);
           priv->seek_frame=0;
         } else {
@@ -309,7 +441,20 @@ static ssize_t ad_read_ffmpeg(void *sf, float* d, size_t len) {
   if (written!=frames) {
         dbg(2, "short-read");
   }
-  return written * priv->channels;
+  return written;
+}
+
+static ssize_t ad_read_ffmpeg(void *sf, float* d, size_t len) {
+  ffmpeg_audio_decoder *priv = (ffmpeg_audio_decoder*) sf;
+  if (!priv) return -1;
+  const ssize_t frames = ffmpeg_read(priv, d, NULL, len / priv->channels);
+  return frames < 0 ? frames : frames * (ssize_t) priv->channels;
+}
+
+static ssize_t ad_read_planar_ffmpeg(void *sf, float** d, size_t frames) {
+  ffmpeg_audio_decoder *priv = (ffmpeg_audio_decoder*) sf;
+  if (!priv) return -1;
+  return ffmpeg_read(priv, NULL, d, frames);
 }
 
 static int64_t ad_seek_ffmpeg(void *sf, int64_t pos) {
@@ -318,19 +463,28 @@ static int64_t ad_seek_ffmpeg(void *sf, int64_t pos) {
   if (pos == priv->output_clock) return pos;
 
   /* flush internal buffer */
-  priv->m_tmpBufferLen = 0;
+  priv->m_planeFrames = 0;
   priv->seek_frame = pos;
   priv->output_clock = pos;
   priv->pkt_len = 0; priv->pkt_ptr = NULL;
   priv->decoder_clock = 0;
 
-#if 0
-  /* TODO seek at least 1 packet before target.
-   * for mpeg compressed files, the
-   * output may depend on past frames! */
-  if (pos > 8192) pos -= 8192;
-  else pos = 0;
-#endif
+  if (priv->seek_index_len > 0) {
+    /* start decoding a bit before the target, output can depend on past frames.
+     * the decoded frames before it are skipped by the alignment in ffmpeg_read() */
+    const int64_t target = pos - (int64_t) priv->samplerate * SEEK_PREROLL_MS / 1000;
+    int lo = 0, hi = priv->seek_index_len - 1;
+    while (lo < hi) {
+      const int mid = (lo + hi + 1) / 2;
+      if (priv->seek_index[mid].frame <= target) lo = mid;
+      else hi = mid - 1;
+    }
+    dbg(2, "seek frame:%"PRIi64" - index frame:%"PRIi64, pos, priv->seek_index[lo].frame);
+    if (av_seek_frame(priv->formatContext, priv->audioStream, priv->seek_index[lo].pos, AVSEEK_FLAG_BYTE) >= 0) {
+      avcodec_flush_buffers(priv->codecContext);
+      return pos;
+    }
+  }
 
   const int64_t timestamp = pos / av_q2d(priv->formatContext->streams[priv->audioStream]->time_base) / priv->samplerate;
   dbg(2, "seek frame:%"PRIi64" - idx:%"PRIi64, pos, timestamp);
@@ -355,14 +509,16 @@ static const ad_plugin ad_ffmpeg = {
   &ad_close_ffmpeg,
   &ad_info_ffmpeg,
   &ad_seek_ffmpeg,
-  &ad_read_ffmpeg
+  &ad_read_ffmpeg,
+  &ad_read_planar_ffmpeg
 #else
   &ad_eval_null,
   &ad_open_null,
   &ad_close_null,
   &ad_info_null,
   &ad_seek_null,
-  &ad_read_null
+  &ad_read_null,
+  &ad_read_planar_null
 #endif
 };
 
@@ -31,9 +31,13 @@
 
 /* internal abstraction */
 
+/* frames read at once by ad_read_planar_sndfile */
+#define PLANAR_READ_FRAMES 4096
+
 typedef struct {
 	SF_INFO sfinfo;
 	SNDFILE *sffile;
+	float *planar_tmp; // interleaved frames for de-interleaving, allocated on first use
 } sndfile_audio_decoder;
 
 static int parse_bit_depth(int format) {
@@ -88,6 +92,7 @@ static int ad_close_sndfile(void *sf) {
 		dbg(0, "fatal: bad file close.\n");
 		return -1;
 	}
+	free(priv->planar_tmp);
 	free(priv);
 	return 0;
 }
@@ -104,6 +109,36 @@ static ssize_t ad_read_sndfile(void *sf, float* d, size_t len) {
 	return sf_read_float (priv->sffile, d, len);
 }
 
+static ssize_t ad_read_planar_sndfile(void *sf, float** d, size_t frames) {
+	sndfile_audio_decoder *priv = (sndfile_audio_decoder*) sf;
+	if (!priv) return -1;
+	const int channels = priv->sfinfo.channels;
+	/* libsndfile only reads interleaved data, which is planar already for mono */
+	if (channels == 1)
+		return sf_readf_float (priv->sffile, d[0], frames);
+	if (!priv->planar_tmp) {
+		priv->planar_tmp = (float*) malloc(sizeof(float) * PLANAR_READ_FRAMES * channels);
+		if (!priv->planar_tmp) return -1;
+	}
+	size_t done = 0;
+	while (done < frames) {
+		const size_t todo = (frames - done) < PLANAR_READ_FRAMES ? (frames - done) : PLANAR_READ_FRAMES;
+		const sf_count_t r = sf_readf_float (priv->sffile, priv->planar_tmp, todo);
+		if (r <= 0) break;
+		int c;
+		for (c = 0; c < channels; c++) {
+			const float *in = priv->planar_tmp + c;
+			float *out = d[c] + done;
+			sf_count_t i;
+			for (i = 0; i < r; i++)
+				out[i] = in[i * channels];
+		}
+		done += r;
+		if ((size_t) r < todo) break;
+	}
+	return done;
+}
+
 static int ad_eval_sndfile(const char *f) { 
 	char *ext = strrchr(f, '.');
 	if (strstr (f, "://")) return 0;
@@ -141,14 +176,16 @@ static const ad_plugin ad_sndfile = {
 	&ad_close_sndfile,
 	&ad_info_sndfile,
 	&ad_seek_sndfile,
-	&ad_read_sndfile
+	&ad_read_sndfile,
+	&ad_read_planar_sndfile
 #else
   &ad_eval_null,
 	&ad_open_null,
 	&ad_close_null,
 	&ad_info_null,
 	&ad_seek_null,
-	&ad_read_null
+	&ad_read_null,
+	&ad_read_planar_null
 #endif
 };
 
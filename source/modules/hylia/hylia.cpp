@@ -30,6 +30,8 @@
 
 #include "ableton/link/HostTimeFilter.hpp"
 #include <chrono>
+#include <condition_variable>
+#include <thread>
 
 class HyliaTransport {
 public:
@@ -37,26 +39,43 @@ public:
         : link(120.0),
           engine(link),
           outputLatency(0),
-          sampleTime(0)
+          sampleTime(0),
+          sessionThread(),
+          sessionMutex(),
+          sessionCondition(),
+          sessionThreadRunning(false)
     {
     }
 
+    ~HyliaTransport()
+    {
+        stopSessionThread();
+    }
+
     void setEnabled(const bool enabled)
     {
         if (enabled)
+        {
             sampleTime = 0;
+            startSessionThread();
+        }
 
         link.enable(enabled);
+
+        if (! enabled)
+            stopSessionThread();
     }
 
     void setQuantum(const double quantum)
     {
         engine.setQuantum(quantum);
+        wakeSessionThread();
     }
 
     void setTempo(const double tempo)
     {
         engine.setTempo(tempo);
+        wakeSessionThread();
     }
 
     void setOutputLatency(const uint32_t latency) noexcept
@@ -72,13 +91,16 @@ public:
     void startPlaying()
     {
         engine.startPlaying();
+        wakeSessionThread();
     }
 
     void stopPlaying()
     {
         engine.stopPlaying();
+        wakeSessionThread();
     }
 
+    // called from the audio thread, never blocks on the Link session
     void process(const uint32_t frames, LinkTimeInfo* const info)
     {
         const std::chrono::microseconds hostTime = hostTimeFilter.sampleTimeToHostTime(sampleTime)
@@ -94,6 +116,58 @@ private:
     ableton::link::HostTimeFilter<ableton::link::platform::Clock> hostTimeFilter;
 
     uint32_t outputLatency, sampleTime;
+
+    // helper thread that owns all Link session capture/commit calls
+    std::thread sessionThread;
+    std::mutex sessionMutex;
+    std::condition_variable sessionCondition;
+    bool sessionThreadRunning;
+
+    void startSessionThread()
+    {
+        if (sessionThread.joinable())
+            return;
+
+        // have a valid timeline before the audio thread needs one
+        engine.updateSessionState();
+
+        sessionThreadRunning = true;
+        sessionThread = std::thread(&HyliaTransport::runSessionThread, this);
+    }
+
+    void stopSessionThread()
+    {
+        if (! sessionThread.joinable())
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(sessionMutex);
+            sessionThreadRunning = false;
+        }
+
+        sessionCondition.notify_one();
+        sessionThread.join();
+    }
+
+    void wakeSessionThread()
+    {
+        sessionCondition.notify_one();
+    }
+
+    void runSessionThread()
+    {
+        std::unique_lock<std::mutex> lock(sessionMutex);
+
+        while (sessionThreadRunning)
+        {
+            lock.unlock();
+            engine.updateSessionState();
+            lock.lock();
+
+            // peers can change the timeline at any time, so refresh often even without local requests
+            sessionCondition.wait_for(lock, std::chrono::milliseconds(2));
+        }
+    }
 };
 
 hylia_t* hylia_create(void)
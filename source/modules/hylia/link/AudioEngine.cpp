@@ -27,8 +27,11 @@ namespace link
 AudioEngine::AudioEngine(Link& link)
   : mLink(link)
   , mSharedEngineData({0., false, false, 4., false})
-  , mLockfreeEngineData(mSharedEngineData)
   , mIsPlaying(false)
+  , mSnapshots()
+  , mMiddleIndex(1)
+  , mWriteIndex(0)
+  , mReadIndex(2)
 {
 }
 
@@ -84,40 +87,34 @@ void AudioEngine::setStartStopSyncEnabled(const bool enabled)
 
 AudioEngine::EngineData AudioEngine::pullEngineData()
 {
-  auto engineData = EngineData{};
-  if (mEngineDataGuard.try_lock())
-  {
-    engineData.requestedTempo = mSharedEngineData.requestedTempo;
-    mSharedEngineData.requestedTempo = 0;
-    engineData.requestStart = mSharedEngineData.requestStart;
-    mSharedEngineData.requestStart = false;
-    engineData.requestStop = mSharedEngineData.requestStop;
-    mSharedEngineData.requestStop = false;
-
-    mLockfreeEngineData.quantum = mSharedEngineData.quantum;
-    mLockfreeEngineData.startStopSyncOn = mSharedEngineData.startStopSyncOn;
+  std::lock_guard<std::mutex> lock(mEngineDataGuard);
 
-    mEngineDataGuard.unlock();
-  }
-  engineData.quantum = mLockfreeEngineData.quantum;
+  const auto engineData = mSharedEngineData;
+  mSharedEngineData.requestedTempo = 0;
+  mSharedEngineData.requestStart = false;
+  mSharedEngineData.requestStop = false;
 
   return engineData;
 }
 
-void AudioEngine::timelineCallback(const std::chrono::microseconds hostTime, LinkTimeInfo* const info)
+void AudioEngine::updateSessionState()
 {
   const auto engineData = pullEngineData();
+  const auto now = mLink.clock().micros();
 
-  auto sessionState = mLink.captureAudioSessionState();
+  auto sessionState = mLink.captureAppSessionState();
+  bool changed = false;
 
   if (engineData.requestStart)
   {
-    sessionState.setIsPlaying(true, hostTime);
+    sessionState.setIsPlaying(true, now);
+    changed = true;
   }
 
   if (engineData.requestStop)
   {
-    sessionState.setIsPlaying(false, hostTime);
+    sessionState.setIsPlaying(false, now);
+    changed = true;
   }
 
   if (!mIsPlaying && sessionState.isPlaying())
@@ -125,6 +122,7 @@ void AudioEngine::timelineCallback(const std::chrono::microseconds hostTime, Lin
     // Reset the timeline so that beat 0 corresponds to the time when transport starts
     sessionState.requestBeatAtStartPlayingTime(0, engineData.quantum);
     mIsPlaying = true;
+    changed = true;
   }
   else if (mIsPlaying && !sessionState.isPlaying())
   {
@@ -133,19 +131,49 @@ void AudioEngine::timelineCallback(const std::chrono::microseconds hostTime, Lin
 
   if (engineData.requestedTempo > 0)
   {
-    // Set the newly requested tempo from the beginning of this buffer
-    sessionState.setTempo(engineData.requestedTempo, hostTime);
+    sessionState.setTempo(engineData.requestedTempo, now);
+    changed = true;
+  }
+
+  if (changed)
+    mLink.commitAppSessionState(sessionState);
+
+  // Publish the timeline for the audio thread
+  Snapshot& snapshot(mSnapshots[mWriteIndex]);
+  snapshot.refTime = now;
+  snapshot.refBeat = sessionState.beatAtTime(now, engineData.quantum);
+  snapshot.tempo   = sessionState.tempo();
+  snapshot.quantum = engineData.quantum;
+  snapshot.playing = mIsPlaying;
+  snapshot.valid   = true;
+
+  mWriteIndex = mMiddleIndex.exchange(mWriteIndex | kSnapshotFresh) & ~kSnapshotFresh;
+}
+
+void AudioEngine::timelineCallback(const std::chrono::microseconds hostTime, LinkTimeInfo* const info)
+{
+  if (mMiddleIndex.load() & kSnapshotFresh)
+    mReadIndex = mMiddleIndex.exchange(mReadIndex) & ~kSnapshotFresh;
+
+  const Snapshot& snapshot(mSnapshots[mReadIndex]);
+
+  if (!snapshot.valid)
+  {
+    info->beat    = -1.0;
+    info->phase   = 0.0;
+    info->playing = false;
+    return;
   }
 
-  // Timeline modifications are complete, commit the results
-  mLink.commitAudioSessionState(sessionState);
+  // Interpolate from the reference point, tempo is constant until the next snapshot
+  const double elapsedMinutes = static_cast<double>((hostTime - snapshot.refTime).count()) / 60e6;
+  const double beat = snapshot.refBeat + elapsedMinutes * snapshot.tempo;
 
-  // Save session state
-  info->beatsPerBar    = engineData.quantum;
-  info->beatsPerMinute = sessionState.tempo();
-  info->beat           = sessionState.beatAtTime(hostTime, engineData.quantum);
-  info->phase          = sessionState.phaseAtTime(hostTime, engineData.quantum);
-  info->playing        = mIsPlaying;
+  info->beatsPerBar    = snapshot.quantum;
+  info->beatsPerMinute = snapshot.tempo;
+  info->beat           = beat;
+  info->phase          = beat - snapshot.quantum * std::floor(beat / snapshot.quantum);
+  info->playing        = snapshot.playing;
 }
 
 } // namespace link
@@ -33,6 +33,7 @@
 #endif
 #endif
 
+#include <atomic>
 #include <cmath>
 
 #include "ableton/Link.hpp"
@@ -61,6 +62,10 @@ public:
   bool isStartStopSyncEnabled() const;
   void setStartStopSyncEnabled(bool enabled);
 
+  // Link session handling, must be called periodically from a non-realtime thread
+  void updateSessionState();
+
+  // wait-free, meant for the audio thread
   void timelineCallback(const std::chrono::microseconds hostTime, LinkTimeInfo* const info);
 
 private:
@@ -73,13 +78,31 @@ private:
     bool startStopSyncOn;
   };
 
+  // session timeline as seen at a reference host time, beats are linear in time from there
+  struct Snapshot
+  {
+    std::chrono::microseconds refTime;
+    double refBeat;
+    double tempo;
+    double quantum;
+    bool playing;
+    bool valid;
+  };
+
   EngineData pullEngineData();
 
   Link& mLink;
   EngineData mSharedEngineData;
-  EngineData mLockfreeEngineData;
   bool mIsPlaying;
   std::mutex mEngineDataGuard;
+
+  // triple buffer: the writer fills mSnapshots[mWriteIndex], the reader uses mSnapshots[mReadIndex],
+  // both swap their slot with mMiddleIndex; kSnapshotFresh marks a middle slot not yet seen by the reader
+  static constexpr int kSnapshotFresh = 0x4;
+  Snapshot mSnapshots[3];
+  std::atomic<int> mMiddleIndex;
+  int mWriteIndex;
+  int mReadIndex;
 };
 
 
@@ -1,7 +1,7 @@
 /*
  * RealTime Memory Pool, heavily based on work by Nedko Arnaudov
  * Copyright (C) 2006-2009 Nedko Arnaudov <nedko@arnaudov.name>
- * Copyright (C) 2013-2016 Filipe Coelho <falktx@falktx.com>
+ * Copyright (C) 2013-2020 Filipe Coelho <falktx@falktx.com>
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License as
@@ -16,29 +16,33 @@
  * For a full copy of the GNU General Public License see the GPL.txt file
  */
 
-#include "list.h"
 #include "rtmempool.h"
 #include "rtmempool-lv2.h"
 
 #include <assert.h>
 #include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define RTMEMPOOL_THREAD_SAFETY 0
-
-#if RTMEMPOOL_THREAD_SAFETY
-#define rtmempool_mutex_lock(m) pthread_mutex_lock(m)
-#define rtmempool_mutex_unlock(m) pthread_mutex_unlock(m)
-#else
-#define rtmempool_mutex_lock(...)
-#define rtmempool_mutex_unlock(...)
-#endif
-
 // ------------------------------------------------------------------------------------------------
-
-typedef struct list_head k_list_head;
+// Unused nodes are kept in a lock-free stack (Treiber stack).
+// The stack head packs the index of the top node (plus 1, 0 means empty) with a tag that changes on
+// every push and pop, so a compare-and-swap cannot succeed against a head that was popped and pushed
+// back in between (ABA problem).
+// Nodes are allocated in segments which are only freed when the pool is destroyed, so reading the
+// next index of a node that another thread just popped is always safe, it will just fail the CAS.
+// Segment sizes double, segment N starts at node index (2^N - 1) * segmentBase.
+
+#define RTMEMPOOL_MAX_SEGMENTS 32
+#define RTMEMPOOL_NODE_HEADER_SIZE 16
+
+typedef struct _RtMemPoolNode
+{
+    uint32_t next;  // index+1 of the next unused node, only valid while in the stack
+    uint32_t index;
+} RtMemPoolNode;
 
 // ------------------------------------------------------------------------------------------------
 
@@ -47,66 +51,130 @@ typedef struct _RtMemPool
     char name[RTSAFE_MEMORY_POOL_NAME_MAX];
 
     size_t dataSize;
+    size_t nodeSize;
     size_t minPreallocated;
     size_t maxPreallocated;
 
-    k_list_head used;
-    unsigned int usedCount;
-
-    k_list_head unused;
+    uint64_t head;
     unsigned int unusedCount;
 
-    pthread_mutex_t mutex;
+    // only changed while holding growMutex
+    unsigned int segmentBaseShift;
+    unsigned int segmentCount;
+    unsigned int allocatedCount;
+    char* segments[RTMEMPOOL_MAX_SEGMENTS];
+
+    pthread_mutex_t growMutex;
 
 } RtMemPool;
 
 // ------------------------------------------------------------------------------------------------
-// adjust unused list size
 
-static void rtsafe_memory_pool_sleepy(RtMemPool* poolPtr, bool* overMaxOrMallocFailed)
+static RtMemPoolNode* rtsafe_memory_pool_get_node(RtMemPool* poolPtr, uint32_t index)
 {
-    k_list_head* nodePtr;
-    k_list_head unused;
-    unsigned int unusedCount;
+    const uint64_t base = (uint64_t)1 << poolPtr->segmentBaseShift;
+    const uint64_t pos  = ((uint64_t)index >> poolPtr->segmentBaseShift) + 1;
+
+    unsigned int segment = 0;
+    while ((pos >> (segment + 1)) != 0)
+        ++segment;
+
+    const uint64_t segmentStart = (((uint64_t)1 << segment) - 1) * base;
 
-    INIT_LIST_HEAD(&unused);
-    unusedCount = 0;
+    assert(segment < poolPtr->segmentCount);
+    return (RtMemPoolNode*)(poolPtr->segments[segment] + (index - segmentStart) * poolPtr->nodeSize);
+}
+
+static uint64_t rtsafe_memory_pool_next_head(uint64_t head, uint32_t top)
+{
+    return (((head >> 32) + 1) << 32) | top;
+}
+
+// push a chain of nodes already linked together, from first to last
+static void rtsafe_memory_pool_push(RtMemPool* poolPtr, RtMemPoolNode* first, RtMemPoolNode* last, unsigned int count)
+{
+    uint64_t head = __atomic_load_n(&poolPtr->head, __ATOMIC_RELAXED);
+
+    // counted first so that a concurrent pop never makes it wrap around
+    __atomic_add_fetch(&poolPtr->unusedCount, count, __ATOMIC_RELAXED);
 
-    while (poolPtr->unusedCount + unusedCount < poolPtr->minPreallocated)
+    do {
+        __atomic_store_n(&last->next, (uint32_t)head, __ATOMIC_RELAXED);
+    }
+    while (! __atomic_compare_exchange_n(&poolPtr->head, &head, rtsafe_memory_pool_next_head(head, first->index + 1),
+                                         true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+// ------------------------------------------------------------------------------------------------
+// allocate a new segment and add its nodes to the unused stack, must hold growMutex
+
+static bool rtsafe_memory_pool_grow(RtMemPool* poolPtr)
+{
+    RtMemPoolNode* nodePtr;
+    RtMemPoolNode* prevPtr;
+    char* segment;
+    unsigned int count, i;
+
+    if (poolPtr->allocatedCount >= poolPtr->maxPreallocated || poolPtr->segmentCount >= RTMEMPOOL_MAX_SEGMENTS)
     {
-        if (poolPtr->usedCount + poolPtr->unusedCount + unusedCount >= poolPtr->maxPreallocated)
-        {
-            *overMaxOrMallocFailed = true;
-            break;
-        }
+        return false;
+    }
+
+    count = (unsigned int)(poolPtr->maxPreallocated - poolPtr->allocatedCount);
+
+    if (poolPtr->segmentBaseShift + poolPtr->segmentCount < 32 && count > 1U << (poolPtr->segmentBaseShift + poolPtr->segmentCount))
+    {
+        count = 1U << (poolPtr->segmentBaseShift + poolPtr->segmentCount);
+    }
+
+    segment = malloc((size_t)count * poolPtr->nodeSize);
+
+    if (segment == NULL)
+    {
+        return false;
+    }
+
+    prevPtr = NULL;
 
-        nodePtr = malloc(sizeof(k_list_head) + poolPtr->dataSize);
+    for (i = 0; i < count; ++i)
+    {
+        nodePtr = (RtMemPoolNode*)(segment + i * poolPtr->nodeSize);
+        nodePtr->index = poolPtr->allocatedCount + i;
 
-        if (nodePtr == NULL)
+        if (prevPtr != NULL)
         {
-            *overMaxOrMallocFailed = true;
-            break;
+            prevPtr->next = nodePtr->index + 1;
         }
 
-        list_add_tail(nodePtr, &unused);
-        ++unusedCount;
+        prevPtr = nodePtr;
     }
 
-    rtmempool_mutex_lock(&poolPtr->mutex);
+    // readers only look at a segment after popping one of its nodes, the push below publishes it
+    poolPtr->segments[poolPtr->segmentCount++] = segment;
+    poolPtr->allocatedCount += count;
 
-    poolPtr->unusedCount += unusedCount;
+    rtsafe_memory_pool_push(poolPtr, (RtMemPoolNode*)segment, prevPtr, count);
+    return true;
+}
 
-    while (unusedCount != 0)
-    {
-        assert(! list_empty(&unused));
+// ------------------------------------------------------------------------------------------------
+// adjust unused stack size, never blocks the atomic allocate and deallocate calls
+
+static void rtsafe_memory_pool_sleepy(RtMemPool* poolPtr, bool* overMaxOrMallocFailed)
+{
+    pthread_mutex_lock(&poolPtr->growMutex);
 
-        nodePtr = unused.next;
-        list_del(nodePtr);
-        list_add_tail(nodePtr, &poolPtr->unused);
-        --unusedCount;
+    while (__atomic_load_n(&poolPtr->unusedCount, __ATOMIC_RELAXED) < poolPtr->minPreallocated
+           || __atomic_load_n(&poolPtr->unusedCount, __ATOMIC_RELAXED) == 0)
+    {
+        if (! rtsafe_memory_pool_grow(poolPtr))
+        {
+            *overMaxOrMallocFailed = true;
+            break;
+        }
     }
 
-    rtmempool_mutex_unlock(&poolPtr->mutex);
+    pthread_mutex_unlock(&poolPtr->growMutex);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -120,10 +188,9 @@ static bool rtsafe_memory_pool_create2(RtMemPool_Handle* handlePtr,
     assert(minPreallocated <= maxPreallocated);
     assert(poolName == NULL || strlen(poolName) < RTSAFE_MEMORY_POOL_NAME_MAX);
 
-    k_list_head* nodePtr;
     RtMemPool* poolPtr;
 
-    poolPtr = malloc(sizeof(RtMemPool));
+    poolPtr = calloc(1, sizeof(RtMemPool));
 
     if (poolPtr == NULL)
     {
@@ -139,35 +206,37 @@ static bool rtsafe_memory_pool_create2(RtMemPool_Handle* handlePtr,
         sprintf(poolPtr->name, "%p", poolPtr);
     }
 
+    // node indexes are 32-bit, with 0 reserved for an empty stack
+    if (maxPreallocated >= UINT32_MAX)
+    {
+        maxPreallocated = UINT32_MAX - 1;
+    }
+    if (minPreallocated > maxPreallocated)
+    {
+        minPreallocated = maxPreallocated;
+    }
+
     poolPtr->dataSize = dataSize;
+    poolPtr->nodeSize = (RTMEMPOOL_NODE_HEADER_SIZE + dataSize + 15) & ~(size_t)15;
     poolPtr->minPreallocated = minPreallocated;
     poolPtr->maxPreallocated = maxPreallocated;
 
-    INIT_LIST_HEAD(&poolPtr->used);
-    poolPtr->usedCount = 0;
+    // first segment fits all preallocated nodes
+    poolPtr->segmentBaseShift = 4;
 
-    INIT_LIST_HEAD(&poolPtr->unused);
-    poolPtr->unusedCount = 0;
+    while (((size_t)1 << poolPtr->segmentBaseShift) < minPreallocated)
+    {
+        ++poolPtr->segmentBaseShift;
+    }
 
-    pthread_mutexattr_t atts;
-    pthread_mutexattr_init(&atts);
-#ifdef __ARM_ARCH_7A__
-    pthread_mutexattr_setprotocol(&atts, PTHREAD_PRIO_INHERIT);
-#endif
-    pthread_mutex_init(&poolPtr->mutex, &atts);
-    pthread_mutexattr_destroy(&atts);
+    pthread_mutex_init(&poolPtr->growMutex, NULL);
 
     while (poolPtr->unusedCount < poolPtr->minPreallocated)
     {
-        nodePtr = malloc(sizeof(k_list_head) + poolPtr->dataSize);
-
-        if (nodePtr == NULL)
+        if (! rtsafe_memory_pool_grow(poolPtr))
         {
             break;
         }
-
-        list_add_tail(nodePtr, &poolPtr->unused);
-        poolPtr->unusedCount++;
     }
 
     *handlePtr = (RtMemPool_Handle)poolPtr;
@@ -203,63 +272,51 @@ void rtsafe_memory_pool_destroy(RtMemPool_Handle handle)
 {
     assert(handle);
 
-    k_list_head* nodePtr;
+    unsigned int i;
     RtMemPool* poolPtr = (RtMemPool*)handle;
 
     // caller should deallocate all chunks prior releasing pool itself
-    if (poolPtr->usedCount != 0)
+    if (poolPtr->unusedCount != poolPtr->allocatedCount)
     {
         fprintf(stderr, "warning: rtsafe_memory_pool_destroy called with nodes still active\n");
     }
 
-    while (poolPtr->unusedCount != 0)
+    for (i = 0; i < poolPtr->segmentCount; ++i)
     {
-        assert(! list_empty(&poolPtr->unused));
-
-        nodePtr = poolPtr->unused.next;
-
-        list_del(nodePtr);
-        poolPtr->unusedCount--;
-
-        free(nodePtr);
+        free(poolPtr->segments[i]);
     }
 
-    assert(list_empty(&poolPtr->unused));
-
-    pthread_mutex_destroy(&poolPtr->mutex);
+    pthread_mutex_destroy(&poolPtr->growMutex);
 
     free(poolPtr);
 }
 
 // ------------------------------------------------------------------------------------------------
-// find entry in unused list, fail if it is empty
+// pop from unused stack, fail if it is empty
 
 void* rtsafe_memory_pool_allocate_atomic(RtMemPool_Handle handle)
 {
     assert(handle);
 
-    k_list_head* nodePtr;
+    RtMemPoolNode* nodePtr;
     RtMemPool* poolPtr = (RtMemPool*)handle;
+    uint64_t head = __atomic_load_n(&poolPtr->head, __ATOMIC_ACQUIRE);
 
-    rtmempool_mutex_lock(&poolPtr->mutex);
+    do {
+        if ((uint32_t)head == 0)
+        {
+            return NULL;
+        }
 
-    if (list_empty(&poolPtr->unused))
-    {
-        rtmempool_mutex_unlock(&poolPtr->mutex);
-        return NULL;
+        nodePtr = rtsafe_memory_pool_get_node(poolPtr, (uint32_t)head - 1);
     }
+    while (! __atomic_compare_exchange_n(&poolPtr->head, &head,
+                                         rtsafe_memory_pool_next_head(head, __atomic_load_n(&nodePtr->next, __ATOMIC_RELAXED)),
+                                         true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
 
-    nodePtr = poolPtr->unused.next;
-    list_del(nodePtr);
-
-    poolPtr->unusedCount--;
-    poolPtr->usedCount++;
+    __atomic_sub_fetch(&poolPtr->unusedCount, 1, __ATOMIC_RELAXED);
 
-    list_add_tail(nodePtr, &poolPtr->used);
-
-    rtmempool_mutex_unlock(&poolPtr->mutex);
-
-    return (nodePtr + 1);
+    return (char*)nodePtr + RTMEMPOOL_NODE_HEADER_SIZE;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -282,22 +339,16 @@ void* rtsafe_memory_pool_allocate_sleepy(RtMemPool_Handle handle)
 }
 
 // ------------------------------------------------------------------------------------------------
-// move from used to unused list
+// push back into unused stack
 
 void rtsafe_memory_pool_deallocate(RtMemPool_Handle handle, void* memoryPtr)
 {
     assert(handle);
 
     RtMemPool* poolPtr = (RtMemPool*)handle;
+    RtMemPoolNode* nodePtr = (RtMemPoolNode*)((char*)memoryPtr - RTMEMPOOL_NODE_HEADER_SIZE);
 
-    rtmempool_mutex_lock(&poolPtr->mutex);
-
-    list_del((k_list_head*)memoryPtr - 1);
-    list_add_tail((k_list_head*)memoryPtr - 1, &poolPtr->unused);
-    poolPtr->usedCount--;
-    poolPtr->unusedCount++;
-
-    rtmempool_mutex_unlock(&poolPtr->mutex);
+    rtsafe_memory_pool_push(poolPtr, nodePtr, nodePtr, 1);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -8,5 +8,6 @@
 #include "sfzero/SFZRegion.cpp" 
 #include "sfzero/SFZSample.cpp" 
 #include "sfzero/SFZSound.cpp"
+#include "sfzero/SFZStream.cpp"
 #include "sfzero/SFZSynth.cpp"
 #include "sfzero/SFZVoice.cpp"
@@ -363,6 +363,10 @@ void Reader::read(const char *text, unsigned int length)
           {
             buildingRegion->tune = value.getIntValue();
           }
+          else if (opcode == "sample_quality")
+          {
+            buildingRegion->sample_quality = value.getIntValue();
+          }
           else if (opcode == "pitch_keycenter")
           {
             buildingRegion->pitch_keycenter = keyValue(value);
@@ -59,6 +59,7 @@ void Region::clear()
     pitch_keytrack = 100;
     bend_up = 200;
     bend_down = -200;
+    sample_quality = 1;
     volume = pan = 0.0f;
     amp_veltrack = 100.0f;
     ampeg.clear();
@@ -78,6 +78,7 @@ struct Region
   int tune;
   int pitch_keycenter, pitch_keytrack;
   int bend_up, bend_down;
+  int sample_quality; // 0..1 linear, 2 and up cubic interpolation
 
   float volume, pan;
   float amp_veltrack;
@@ -8,125 +8,225 @@
 #include "SFZSample.h"
 #include "SFZDebug.h"
 
-#if 0
-#include "water/audioformat/AudioFormatManager.h"
-#include "water/audioformat/AudioFormatReader.h"
-#include "water/text/StringPairArray.h"
-#else
+#include "CarlaMemoryLock.hpp"
+#include "CarlaMutex.hpp"
+
+#include "water/containers/HashMap.h"
+
 extern "C" {
 #include "audio_decoder/ad.h"
 }
-#endif
 
 namespace sfzero
 {
 
-bool Sample::load()
+// Decoded audio of a sample file, shared read-only by all samples using the same file.
+struct SampleCacheEntry
 {
-#if 0
-    static water::AudioFormatManager afm;
-    static bool needsInit = true;
-    if (needsInit)
-    {
-        needsInit = false;
-        afm.registerBasicFormats();
-    }
+  water::String key;
+  CarlaScopedPointer<water::AudioSampleBuffer> buffer;
+  double sampleRate;
+  water::uint64 sampleLength, headLength;
+  int refCount;
+  bool locked;
+
+  SampleCacheEntry() : key(), buffer(nullptr), sampleRate(0), sampleLength(0), headLength(0), refCount(0), locked(false) {}
+
+  ~SampleCacheEntry()
+  {
+    if (locked)
+      CarlaMemoryLock::getInstance().unlock(buffer->getReadPointer(0), getBufferSize());
+  }
 
-    water::AudioFormatReader* reader = afm.createReaderFor(file_);
-    CARLA_SAFE_ASSERT_RETURN(reader != nullptr, false);
+  // keep the decoded audio in RAM if ENGINE_OPTION_LOCK_MEMORY is set,
+  // water keeps all channels in a single block so it is locked in one go
+  void lock()
+  {
+    if (buffer->getNumChannels() > 0)
+      locked = CarlaMemoryLock::getInstance().lock(buffer->getReadPointer(0), getBufferSize());
+  }
 
-    sampleRate_ = reader->sampleRate;
-    sampleLength_ = (water::uint64) reader->lengthInSamples;
+  std::size_t getBufferSize() const
+  {
+    const int lastChannel = buffer->getNumChannels() - 1;
+    const float* const end = buffer->getReadPointer(lastChannel) + buffer->getNumSamples();
+    return static_cast<std::size_t>(end - buffer->getReadPointer(0)) * sizeof(float);
+  }
 
-    // Read some extra samples, which will be filled with zeros, so interpolation
-    // can be done without having to check for the edge all the time.
-    CARLA_SAFE_ASSERT_RETURN(sampleLength_ < std::numeric_limits<int>::max(), false);
+  CARLA_DECLARE_NON_COPY_STRUCT(SampleCacheEntry)
+};
 
-    water::AudioSampleBuffer* buf = new water::AudioSampleBuffer((int) reader->numChannels, static_cast<int>(sampleLength_ + 4), true);
-    reader->read(buf, 0, static_cast<int>(sampleLength_ + 4), 0, true, true);
-    buffer_ = buf;
+// Process-wide cache of decoded samples, so plugin instances using the same files only load them once.
+// Entries are keyed by path, modification time and preload time, and deleted when their last user is gone.
+class SampleCache
+{
+public:
+  static SampleCache &getInstance()
+  {
+    static SampleCache cache;
+    return cache;
+  }
 
-    water::StringPairArray *metadata = &reader->metadataValues;
-    int numLoops = metadata->getValue("NumSampleLoops", "0").getIntValue();
-    if (numLoops > 0)
+  SampleCacheEntry *acquire(const water::String &key)
+  {
+    const CarlaMutexLocker cml(mutex_);
+
+    SampleCacheEntry *const entry = entries_[key];
+
+    if (entry != nullptr)
+      ++entry->refCount;
+
+    return entry;
+  }
+
+  // Add a newly decoded entry, or drop it in favour of an existing one if another instance was faster.
+  SampleCacheEntry *insert(SampleCacheEntry *const newEntry)
+  {
+    const CarlaMutexLocker cml(mutex_);
+
+    if (SampleCacheEntry *const entry = entries_[newEntry->key])
     {
-        loopStart_ = (water::uint64) metadata->getValue("Loop0Start", "0").getLargeIntValue();
-        loopEnd_ = (water::uint64) metadata->getValue("Loop0End", "0").getLargeIntValue();
+      ++entry->refCount;
+      delete newEntry;
+      return entry;
     }
-    delete reader;
-#else
-    const water::String filename(file_.getFullPathName());
+
+    newEntry->refCount = 1;
+    entries_.set(newEntry->key, newEntry);
+    return newEntry;
+  }
+
+  void release(SampleCacheEntry *const entry)
+  {
+    const CarlaMutexLocker cml(mutex_);
+
+    if (--entry->refCount != 0)
+      return;
+
+    entries_.remove(entry->key);
+    delete entry;
+  }
+
+private:
+  SampleCache() : mutex_(), entries_() {}
+
+  CarlaMutex mutex_;
+  water::HashMap<water::String, SampleCacheEntry *> entries_;
+
+  CARLA_DECLARE_NON_COPY_CLASS(SampleCache)
+};
+
+static SampleCacheEntry *decodeSample(const water::File &file, water::uint32 preloadTimeMs)
+{
+    const water::String filename(file.getFullPathName());
 
     struct adinfo info;
     carla_zeroStruct(info);
 
     void* const handle = ad_open(filename.toRawUTF8(), &info);
-    CARLA_SAFE_ASSERT_RETURN(handle != nullptr, false);
+    CARLA_SAFE_ASSERT_RETURN(handle != nullptr, nullptr);
 
-    if (info.frames >= std::numeric_limits<int>::max())
+    if (info.channels == 0 || info.frames <= 0)
     {
-        carla_stderr2("sfzero::Sample::load() - file is too big!");
+        carla_stderr2("sfzero::Sample::load() - file is empty or invalid");
         ad_close(handle);
-        return false;
+        return nullptr;
     }
 
-    sampleRate_ = info.sample_rate;
-    sampleLength_ = info.frames/info.channels;
+    water::uint64 sampleLength = static_cast<water::uint64>(info.frames);
+    water::uint64 headLength = sampleLength;
     // TODO loopStart_, loopEnd_
 
-    // read interleaved buffer
-    float* const rbuffer = (float*)std::calloc(1, sizeof(float)*info.frames);
-
-    if (rbuffer == nullptr)
+    if (preloadTimeMs != 0)
     {
-        carla_stderr2("sfzero::Sample::load() - out of memory");
-        ad_close(handle);
-        return false;
-    }
+        const water::uint64 preloadFrames = static_cast<water::uint64>(info.sample_rate) * preloadTimeMs / 1000;
 
-    // Fix for misinformation using libsndfile
-    if (info.frames % info.channels)
-        --info.frames;
+        if (preloadFrames < sampleLength)
+            headLength = preloadFrames;
+    }
 
-    const ssize_t r = ad_read(handle, rbuffer, info.frames);
-    if (r != info.frames)
+    if (headLength >= static_cast<water::uint64>(std::numeric_limits<int>::max() - 4))
     {
-        if (r != 0)
-            carla_stderr2("sfzero::Sample::load() - failed to read complete file: " P_SSIZE " vs " P_INT64, r, info.frames);
+        carla_stderr2("sfzero::Sample::load() - file is too big!");
         ad_close(handle);
-        return false;
+        return nullptr;
     }
 
     // NOTE: We add some extra samples, which will be filled with zeros,
     // so interpolation can be done without having to check for the edge all the time.
 
-    buffer_ = new water::AudioSampleBuffer(info.channels, sampleLength_ + 4, true);
+    water::AudioSampleBuffer* const buffer = new water::AudioSampleBuffer(info.channels,
+                                                                          static_cast<int>(headLength + 4), true);
 
-    for (int i=info.channels; --i >= 0;)
-        buffer_->copyFromInterleavedSource(i, rbuffer, r);
+    // decode straight into the buffer, no temporary copy of the file is needed
+    const ssize_t r = ad_read_planar(handle, buffer->getArrayOfWritePointers(), static_cast<size_t>(headLength));
+    const water::uint64 framesDone = r > 0 ? static_cast<water::uint64>(r) : 0;
 
-    std::free(rbuffer);
     ad_close(handle);
-#endif
 
-    return true;
-}
+    if (framesDone == 0)
+    {
+        carla_stderr2("sfzero::Sample::load() - failed to read file");
+        delete buffer;
+        return nullptr;
+    }
 
-Sample::~Sample() { }
+    // reported length can be an estimate for compressed files
+    if (framesDone < headLength)
+    {
+        carla_stderr2("sfzero::Sample::load() - failed to read complete file: " P_UINT64 " vs " P_UINT64,
+                      static_cast<uint64_t>(framesDone), static_cast<uint64_t>(headLength));
+        sampleLength = headLength = framesDone;
+    }
 
-water::String Sample::getShortName() { return (file_.getFileName()); }
+    SampleCacheEntry* const entry = new SampleCacheEntry();
+    entry->buffer = buffer;
+    entry->sampleRate = info.sample_rate;
+    entry->sampleLength = sampleLength;
+    entry->headLength = headLength;
+    entry->lock();
+    return entry;
+}
 
-void Sample::setBuffer(water::AudioSampleBuffer *newBuffer)
+bool Sample::load(water::uint32 preloadTimeMs)
 {
-  buffer_ = newBuffer;
-  sampleLength_ = buffer_->getNumSamples();
+    SampleCache& cache(SampleCache::getInstance());
+
+    water::String key(file_.getFullPathName());
+    key << ":" << file_.getLastModificationTime() << ":" << static_cast<int>(preloadTimeMs);
+
+    SampleCacheEntry* entry = cache.acquire(key);
+
+    if (entry == nullptr)
+    {
+        entry = decodeSample(file_, preloadTimeMs);
+
+        if (entry == nullptr)
+            return false;
+
+        entry->key = key;
+        entry = cache.insert(entry);
+    }
+
+    if (cacheEntry_ != nullptr)
+        cache.release(cacheEntry_);
+
+    cacheEntry_ = entry;
+    buffer_ = entry->buffer;
+    sampleRate_ = entry->sampleRate;
+    sampleLength_ = entry->sampleLength;
+    headLength_ = entry->headLength;
+    return true;
 }
 
-water::AudioSampleBuffer *Sample::detachBuffer()
+Sample::~Sample()
 {
-  return buffer_.release();
+    if (cacheEntry_ != nullptr)
+        SampleCache::getInstance().release(cacheEntry_);
 }
 
+water::String Sample::getShortName() { return (file_.getFileName()); }
+
 water::String Sample::dump() { return file_.getFullPathName() + "\n"; }
 
 #ifdef DEBUG
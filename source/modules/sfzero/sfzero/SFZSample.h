@@ -12,27 +12,30 @@
 #include "water/buffers/AudioSampleBuffer.h"
 #include "water/files/File.h"
 
-#include "CarlaScopeUtils.hpp"
-
 namespace sfzero
 {
 
+struct SampleCacheEntry;
+
 class Sample
 {
 public:
-  explicit Sample(const water::File &fileIn) : file_(fileIn), buffer_(nullptr), sampleRate_(0), sampleLength_(0), loopStart_(0), loopEnd_(0) {}
+  explicit Sample(const water::File &fileIn) : file_(fileIn), buffer_(nullptr), cacheEntry_(nullptr), sampleRate_(0), sampleLength_(0), headLength_(0), loopStart_(0), loopEnd_(0) {}
   virtual ~Sample();
 
-  bool load();
+  // If 'preloadTimeMs' is not 0 only that much of the sample is kept in memory,
+  // voices play the rest through a SampleStreamer.
+  // Decoded audio is shared with other samples loading the same file, and must not be modified.
+  bool load(water::uint32 preloadTimeMs = 0);
 
   water::File getFile() { return (file_); }
   water::AudioSampleBuffer *getBuffer() { return (buffer_); }
   double getSampleRate() { return (sampleRate_); }
   water::String getShortName();
-  void setBuffer(water::AudioSampleBuffer *newBuffer);
-  water::AudioSampleBuffer *detachBuffer();
   water::String dump();
   water::uint64 getSampleLength() const { return sampleLength_; }
+  water::uint64 getHeadLength() const { return headLength_; }
+  bool isStreamed() const { return headLength_ < sampleLength_; }
   water::uint64 getLoopStart() const { return loopStart_; }
   water::uint64 getLoopEnd() const { return loopEnd_; }
 
@@ -42,9 +45,10 @@ public:
 
 private:
   water::File file_;
-  CarlaScopedPointer<water::AudioSampleBuffer> buffer_;
+  water::AudioSampleBuffer *buffer_;
+  SampleCacheEntry *cacheEntry_;
   double sampleRate_;
-  water::uint64 sampleLength_, loopStart_, loopEnd_;
+  water::uint64 sampleLength_, headLength_, loopStart_, loopEnd_;
 
   CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Sample)
 };
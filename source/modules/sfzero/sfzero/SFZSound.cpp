@@ -10,12 +10,177 @@
 #include "SFZRegion.h"
 #include "SFZSample.h"
 
+#include "CarlaMutex.hpp"
+#include "CarlaThreadPool.hpp"
+
 namespace sfzero
 {
 
-Sound::Sound(const water::File &fileIn) : file_(fileIn) {}
+// Samples of a sound, loaded over a thread pool.
+// Decoding each file is independent, only progress reporting stays on the calling thread.
+struct SampleLoader
+{
+  Sample **samples;
+  water::uint32 *preloadTimes;
+  bool *loaded;
+  int count;
+  volatile int nextIndex;
+  volatile int numDone;
+  const Sound::LoadingIdleCallback &cb;
+
+  SampleLoader(int numSamples, const Sound::LoadingIdleCallback &callback)
+      : samples(new Sample *[numSamples]), preloadTimes(new water::uint32[numSamples]), loaded(new bool[numSamples]),
+        count(numSamples), nextIndex(0), numDone(0), cb(callback)
+  {
+  }
+
+  ~SampleLoader()
+  {
+    delete[] samples;
+    delete[] preloadTimes;
+    delete[] loaded;
+  }
+
+  void load()
+  {
+    CarlaThreadPool threadPool;
+    const uint numThreads = CarlaThreadPool::getNumCPUs();
+
+    if (numThreads > 1 && count > 1)
+      threadPool.start(std::min(numThreads, static_cast<uint>(count)) - 1, false);
+
+    threadPool.run(loadCallback, this);
+  }
+
+  static void loadCallback(void *const ptr, const uint threadIndex)
+  {
+    SampleLoader *const self = static_cast<SampleLoader *>(ptr);
+    int numReported = 0;
+
+    for (int i; (i = __sync_fetch_and_add(&self->nextIndex, 1)) < self->count;)
+    {
+      Sample *const sample = self->samples[i];
+
+      self->loaded[i] = sample->load(self->preloadTimes[i]);
+
+      __sync_add_and_fetch(&self->numDone, 1);
+
+      if (threadIndex == 0)
+        numReported = self->reportProgress(numReported);
+    }
+
+    if (threadIndex != 0)
+      return;
+
+    // keep reporting while the workers finish their last samples
+    while (numReported != self->count)
+    {
+      carla_msleep(5);
+      numReported = self->reportProgress(numReported);
+    }
+  }
+
+  int reportProgress(int numReported)
+  {
+    const int done = __sync_fetch_and_add(&numDone, 0);
+
+    for (; numReported < done; ++numReported)
+      cb.callback(cb.callbackPtr);
+
+    return numReported;
+  }
+
+  CARLA_DECLARE_NON_COPY_STRUCT(SampleLoader)
+};
+
+// Result of parsing an SFZ file and indexing its regions, shared read-only by all sounds using the same file.
+// Regions are kept without their sample, which is stored as a full path in samplePaths instead.
+struct ParsedSoundEntry
+{
+  water::String key;
+  water::Array<Region> regions;
+  water::StringArray samplePaths;
+  water::StringArray errors;
+  water::StringArray warnings;
+  water::Array<int> regionIndex;
+  water::Array<int> cellStart;
+  water::uint16 regionCells[128][128];
+  int refCount;
+
+  ParsedSoundEntry() : key(), regions(), samplePaths(), errors(), warnings(), regionIndex(), cellStart(), refCount(0)
+  {
+    carla_zeroStructs(regionCells, 128);
+  }
+
+  CARLA_DECLARE_NON_COPY_STRUCT(ParsedSoundEntry)
+};
+
+// Process-wide cache of parsed SFZ files, so plugin instances using the same file only parse it once.
+// Entries are keyed by path and modification time, and deleted when their last user is gone.
+class ParsedSoundCache
+{
+public:
+  static ParsedSoundCache &getInstance()
+  {
+    static ParsedSoundCache cache;
+    return cache;
+  }
+
+  ParsedSoundEntry *acquire(const water::String &key)
+  {
+    const CarlaMutexLocker cml(mutex_);
+
+    ParsedSoundEntry *const entry = entries_[key];
+
+    if (entry != nullptr)
+      ++entry->refCount;
+
+    return entry;
+  }
+
+  // Add a newly parsed entry, or drop it in favour of an existing one if another instance was faster.
+  ParsedSoundEntry *insert(ParsedSoundEntry *const newEntry)
+  {
+    const CarlaMutexLocker cml(mutex_);
+
+    if (ParsedSoundEntry *const entry = entries_[newEntry->key])
+    {
+      ++entry->refCount;
+      delete newEntry;
+      return entry;
+    }
+
+    newEntry->refCount = 1;
+    entries_.set(newEntry->key, newEntry);
+    return newEntry;
+  }
+
+  void release(ParsedSoundEntry *const entry)
+  {
+    const CarlaMutexLocker cml(mutex_);
+
+    if (--entry->refCount != 0)
+      return;
+
+    entries_.remove(entry->key);
+    delete entry;
+  }
+
+private:
+  ParsedSoundCache() : mutex_(), entries_() {}
+
+  CarlaMutex mutex_;
+  water::HashMap<water::String, ParsedSoundEntry *> entries_;
+
+  CARLA_DECLARE_NON_COPY_CLASS(ParsedSoundCache)
+};
+
+Sound::Sound(const water::File &fileIn) : file_(fileIn), parsedEntry_(nullptr) { carla_zeroStructs(regionCells_, 128); }
 Sound::~Sound()
 {
+  if (parsedEntry_ != nullptr)
+    ParsedSoundCache::getInstance().release(parsedEntry_);
+
   int numRegions = regions_.size();
 
   for (int i = 0; i < numRegions; ++i)
@@ -37,7 +202,14 @@ bool Sound::appliesToNote(int /*midiNoteNumber*/)
 }
 
 bool Sound::appliesToChannel(int /*midiChannel*/) { return true; }
-void Sound::addRegion(Region *region) { regions_.add(region); }
+void Sound::addRegion(Region *region)
+{
+  regions_.add(region);
+
+  // index is outdated now
+  regionIndex_.clearQuick();
+  cellStart_.clearQuick();
+}
 Sample *Sound::addSample(water::String path, water::String defaultPath)
 {
   path = path.replaceCharacter('\\', '/');
@@ -52,6 +224,11 @@ Sample *Sound::addSample(water::String path, water::String defaultPath)
     water::File defaultDir = file_.getSiblingFile(defaultPath);
     sampleFile = defaultDir.getChildFile(path);
   }
+  return addSampleFile(sampleFile);
+}
+
+Sample *Sound::addSampleFile(const water::File &sampleFile)
+{
   water::String samplePath = sampleFile.getFullPathName();
   Sample *sample = samples_[samplePath];
   if (sample == nullptr)
@@ -77,31 +254,180 @@ void Sound::addUnsupportedOpcode(const water::String &opcode)
 
 void Sound::loadRegions()
 {
+  ParsedSoundCache &cache(ParsedSoundCache::getInstance());
+
+  water::String key(file_.getFullPathName());
+  key << ":" << file_.getLastModificationTime();
+
+  if (ParsedSoundEntry *const entry = cache.acquire(key))
+  {
+    for (int i = 0; i < entry->regions.size(); ++i)
+    {
+      Region *const region = new Region(entry->regions.getReference(i));
+      const water::String &samplePath(entry->samplePaths[i]);
+
+      region->sample = samplePath.isNotEmpty() ? addSampleFile(water::File(samplePath)) : nullptr;
+      regions_.add(region);
+    }
+
+    errors_.addArray(entry->errors);
+    warnings_.addArray(entry->warnings);
+    regionIndex_ = entry->regionIndex;
+    cellStart_ = entry->cellStart;
+    std::memcpy(regionCells_, entry->regionCells, sizeof(regionCells_));
+
+    if (parsedEntry_ != nullptr)
+      cache.release(parsedEntry_);
+
+    parsedEntry_ = entry;
+    return;
+  }
+
   Reader reader(this);
 
   reader.read(file_);
+
+  buildRegionIndex();
+
+  // nothing worth sharing if the file could not be read
+  if (regions_.size() == 0)
+    return;
+
+  ParsedSoundEntry *const newEntry = new ParsedSoundEntry();
+  newEntry->key = key;
+
+  for (int i = 0; i < regions_.size(); ++i)
+  {
+    Region region(*regions_[i]);
+
+    newEntry->samplePaths.add(region.sample != nullptr ? region.sample->getFile().getFullPathName() : water::String());
+
+    region.sample = nullptr;
+    newEntry->regions.add(region);
+  }
+
+  newEntry->errors = errors_;
+  newEntry->warnings = warnings_;
+  newEntry->regionIndex = regionIndex_;
+  newEntry->cellStart = cellStart_;
+  std::memcpy(newEntry->regionCells, regionCells_, sizeof(regionCells_));
+
+  if (parsedEntry_ != nullptr)
+    cache.release(parsedEntry_);
+
+  parsedEntry_ = cache.insert(newEntry);
 }
 
-void Sound::loadSamples(const LoadingIdleCallback& cb)
+void Sound::buildRegionIndex()
 {
-    for (water::HashMap<water::String, Sample *>::Iterator i(samples_); i.next();)
+  const int numRegions = regions_.size();
+  water::Array<int> noteRegions;
+
+  regionIndex_.clearQuick();
+  cellStart_.clearQuick();
+
+  for (int note = 0; note < 128; ++note)
+  {
+    noteRegions.clearQuick();
+
+    for (int i = 0; i < numRegions; ++i)
     {
-        Sample* const sample = i.getValue();
+      const Region *const region = regions_[i];
 
-        if (sample->load())
-        {
-            carla_debug("Loaded sample '%s'", sample->getShortName().toRawUTF8());
-            cb.callback(cb.callbackPtr);
-        }
-        else
+      if (note >= region->lokey && note <= region->hikey)
+        noteRegions.add(i);
+    }
+
+    // the list of regions only changes where a velocity range starts or ends
+    for (int velocity = 0; velocity < 128;)
+    {
+      int cellEnd = 128;
+
+      for (int j = 0; j < noteRegions.size(); ++j)
+      {
+        const Region *const region = regions_[noteRegions[j]];
+
+        if (region->lovel > velocity && region->lovel < cellEnd)
+          cellEnd = region->lovel;
+        if (region->hivel + 1 > velocity && region->hivel + 1 < cellEnd)
+          cellEnd = region->hivel + 1;
+      }
+
+      const water::uint16 cell = static_cast<water::uint16>(cellStart_.size());
+      cellStart_.add(regionIndex_.size());
+
+      for (int j = 0; j < noteRegions.size(); ++j)
+      {
+        const Region *const region = regions_[noteRegions[j]];
+
+        if (velocity >= region->lovel && velocity <= region->hivel)
+          regionIndex_.add(noteRegions[j]);
+      }
+
+      for (; velocity < cellEnd; ++velocity)
+        regionCells_[note][velocity] = cell;
+    }
+  }
+
+  cellStart_.add(regionIndex_.size());
+}
+
+void Sound::loadSamples(const LoadingIdleCallback& cb, water::uint32 preloadTimeMs)
+{
+    // voices only stream forwards, so looped samples are always kept in memory
+    water::Array<Sample *> loopedSamples;
+
+    if (preloadTimeMs != 0)
+    {
+        for (int i = 0; i < regions_.size(); ++i)
         {
-            addError("Couldn't load sample \"" + sample->getShortName() + "\"");
+            const Region* const region = regions_[i];
+
+            if (region->loop_mode != Region::no_loop && region->loop_mode != Region::one_shot)
+                loopedSamples.addIfNotAlreadyThere(region->sample);
         }
     }
+
+    SampleLoader loader(samples_.size(), cb);
+    int numSamples = 0;
+
+    for (water::HashMap<water::String, Sample *>::Iterator i(samples_); i.next(); ++numSamples)
+    {
+        Sample* const sample = i.getValue();
+
+        loader.samples[numSamples] = sample;
+        loader.preloadTimes[numSamples] = loopedSamples.contains(sample) ? 0 : preloadTimeMs;
+    }
+
+    if (numSamples == 0)
+        return;
+
+    loader.load();
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (! loader.loaded[i])
+            addError("Couldn't load sample \"" + loader.samples[i]->getShortName() + "\"");
+    }
 }
 
 Region *Sound::getRegionFor(int note, int velocity, Region::Trigger trigger)
 {
+  int count;
+  if (const int *const indices = getRegionIndicesFor(note, velocity, count))
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      Region *region = regions_[indices[i]];
+      if (region->matches(note, velocity, trigger))
+      {
+        return region;
+      }
+    }
+
+    return nullptr;
+  }
+
   int numRegions = regions_.size();
 
   for (int i = 0; i < numRegions; ++i)
@@ -120,6 +446,24 @@ int Sound::getNumRegions() { return regions_.size(); }
 
 Region *Sound::regionAt(int index) { return regions_[index]; }
 
+const int *Sound::getRegionIndicesFor(int note, int velocity, int &count)
+{
+  count = 0;
+
+  if (cellStart_.size() == 0 || note < 0 || note > 127 || velocity < 0 || velocity > 127)
+  {
+    return nullptr;
+  }
+
+  const int cell = regionCells_[note][velocity];
+  const int start = cellStart_.getUnchecked(cell);
+
+  static const int kNoRegions = -1;
+
+  count = cellStart_.getUnchecked(cell + 1) - start;
+  return count != 0 ? regionIndex_.begin() + start : &kNoRegions;
+}
+
 water::String Sound::dump()
 {
   water::String info;
@@ -19,6 +19,7 @@ namespace sfzero
 {
 
 class Sample;
+struct ParsedSoundEntry;
 
 class Sound : public water::SynthesiserSound
 {
@@ -36,18 +37,28 @@ public:
   bool appliesToNote(int midiNoteNumber) override;
   bool appliesToChannel(int midiChannel) override;
 
-  void addRegion(Region *region); // Takes ownership of the region.
+  void addRegion(Region *region); // Takes ownership of the region, call buildRegionIndex() when done adding.
   Sample *addSample(water::String path, water::String defaultPath = water::String());
   void addError(const water::String &message);
   void addUnsupportedOpcode(const water::String &opcode);
 
+  // Parsed regions are shared with other sounds loading the same unchanged file.
   virtual void loadRegions();
-  virtual void loadSamples(const LoadingIdleCallback& cb);
+  // If 'preloadTimeMs' is not 0 samples are streamed from disk, see Sample::load().
+  virtual void loadSamples(const LoadingIdleCallback& cb, water::uint32 preloadTimeMs = 0);
+
+  // Precompute which regions apply to each note and velocity, so lookups don't scan all regions.
+  // Called by loadRegions(), lookups fall back to a full scan while the index is not built.
+  void buildRegionIndex();
 
   Region *getRegionFor(int note, int velocity, Region::Trigger trigger = Region::attack);
   int getNumRegions();
   Region *regionAt(int index);
 
+  // Indices of the regions whose key and velocity ranges include note and velocity, in file order.
+  // Returns null if the index is not built, the trigger still needs to be checked with Region::matches().
+  const int *getRegionIndicesFor(int note, int velocity, int &count);
+
   const water::StringArray &getErrors() { return errors_; }
   const water::StringArray &getWarnings() { return warnings_; }
 
@@ -58,6 +69,8 @@ public:
   water::File &getFile() { return file_; }
 
 private:
+  Sample *addSampleFile(const water::File &sampleFile);
+
   water::File file_;
   water::Array<Region *> regions_;
   water::HashMap<water::String, Sample *> samples_;
@@ -65,6 +78,13 @@ private:
   water::StringArray warnings_;
   water::HashMap<water::String, water::String> unsupportedOpcodes_;
 
+  // region indices grouped per lookup cell, a cell covers a velocity range of a single note
+  water::Array<int> regionIndex_;
+  water::Array<int> cellStart_;
+  water::uint16 regionCells_[128][128];
+
+  ParsedSoundEntry *parsedEntry_;
+
   CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Sound)
 };
 }
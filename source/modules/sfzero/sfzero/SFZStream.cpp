@@ -0,0 +1,333 @@
+/*************************************************************************************
+ * Original code copyright (C) 2012 Steve Folta
+ * Converted to Juce module (C) 2016 Leo Olivers
+ * Forked from https://github.com/stevefolta/SFZero
+ * For license info please see the LICENSE file distributed with this source code
+ *************************************************************************************/
+
+#include "SFZStream.h"
+#include "SFZSample.h"
+
+extern "C" {
+#include "audio_decoder/ad.h"
+}
+
+namespace sfzero
+{
+
+// number of frames decoded at once by the reader thread
+static const water::uint32 kReadFrames = 4096;
+
+SampleStream::SampleStream()
+    : state_(kStateFree), sample_(nullptr), startFrame_(0), readOffset_(0), writeOffset_(0), endOfFile_(false),
+      handle_(nullptr), numChannels_(0)
+{
+  buffers_[0] = new float[kRingFrames];
+  buffers_[1] = new float[kRingFrames];
+  carla_zeroFloats(buffers_[0], kRingFrames);
+  carla_zeroFloats(buffers_[1], kRingFrames);
+}
+
+SampleStream::~SampleStream()
+{
+  CARLA_SAFE_ASSERT(handle_ == nullptr);
+
+  delete[] buffers_[0];
+  delete[] buffers_[1];
+}
+
+water::int64 SampleStream::getEndFrame() const noexcept
+{
+  const water::uint32 writeOffset = writeOffset_;
+  __sync_synchronize();
+  return startFrame_ + writeOffset;
+}
+
+void SampleStream::setReadFrame(water::int64 frame) noexcept
+{
+  const water::int64 offset = frame - startFrame_;
+
+  if (offset > 0)
+    readOffset_ = static_cast<water::uint32>(offset);
+}
+
+bool SampleStream::needsRefill() const noexcept
+{
+  if (endOfFile_)
+    return false;
+
+  const water::int32 used = static_cast<water::int32>(writeOffset_ - readOffset_);
+  return used < static_cast<water::int32>(kRingFrames / 2);
+}
+
+// -----------------------------------------------------------------------
+
+SampleStreamer::SampleStreamer()
+    : CarlaThread("SFZeroStreamer"), streams_(nullptr), numStreams_(0), tempBuffer_(nullptr), tempBufferSize_(0),
+      tempPlanes_(nullptr), tempPlanesSize_(0), sem_(), semValid_(false), needsRead_(false), quitNow_(true)
+{
+  semValid_ = carla_sem_create2(sem_, false);
+}
+
+SampleStreamer::~SampleStreamer()
+{
+  CARLA_SAFE_ASSERT(quitNow_);
+  CARLA_SAFE_ASSERT(! isThreadRunning());
+
+  if (streams_ != nullptr)
+  {
+    for (int i = 0; i < numStreams_; ++i)
+      closeStream(streams_[i]);
+
+    delete[] streams_;
+  }
+
+  delete[] tempBuffer_;
+  delete[] tempPlanes_;
+
+  if (semValid_)
+    carla_sem_destroy2(sem_);
+}
+
+void SampleStreamer::allocate(int numStreams)
+{
+  CARLA_SAFE_ASSERT_RETURN(streams_ == nullptr,);
+  CARLA_SAFE_ASSERT_RETURN(numStreams > 0,);
+
+  streams_ = new SampleStream[numStreams];
+  numStreams_ = numStreams;
+}
+
+void SampleStreamer::startNow()
+{
+  if (streams_ == nullptr || ! semValid_)
+    return;
+
+  quitNow_ = false;
+  startThread();
+}
+
+void SampleStreamer::stopNow()
+{
+  quitNow_ = true;
+  wakeUp();
+
+  stopThread(1000);
+
+  for (int i = 0; i < numStreams_; ++i)
+  {
+    closeStream(streams_[i]);
+    streams_[i].state_ = SampleStream::kStateFree;
+  }
+}
+
+SampleStream *SampleStreamer::acquire(Sample *sample, water::int64 startFrame) noexcept
+{
+  if (quitNow_)
+    return nullptr;
+
+  for (int i = 0; i < numStreams_; ++i)
+  {
+    SampleStream &stream(streams_[i]);
+
+    if (stream.state_ != SampleStream::kStateFree)
+      continue;
+
+    stream.sample_ = sample;
+    stream.startFrame_ = startFrame;
+    stream.readOffset_ = 0;
+    stream.writeOffset_ = 0;
+    stream.endOfFile_ = false;
+
+    __sync_synchronize();
+    stream.state_ = SampleStream::kStateRequested;
+
+    wakeUp();
+    return &stream;
+  }
+
+  return nullptr;
+}
+
+void SampleStreamer::release(SampleStream *stream) noexcept
+{
+  CARLA_SAFE_ASSERT_RETURN(stream != nullptr,);
+
+  stream->state_ = SampleStream::kStateReleased;
+  wakeUp();
+}
+
+void SampleStreamer::wakeUp() noexcept
+{
+  // only post once per request, the reader clears the flag after taking the semaphore
+  if (__sync_bool_compare_and_swap(&needsRead_, false, true) && semValid_)
+    carla_sem_post(sem_);
+}
+
+void SampleStreamer::run()
+{
+  while (! quitNow_)
+  {
+    for (int i = 0; i < numStreams_ && ! quitNow_; ++i)
+    {
+      SampleStream &stream(streams_[i]);
+
+      switch (stream.state_)
+      {
+      case SampleStream::kStateRequested:
+        __sync_synchronize();
+
+        if (! openStream(stream))
+          stream.endOfFile_ = true;
+
+        // the voice might have been stopped while we were opening the file
+        if (! __sync_bool_compare_and_swap(&stream.state_, SampleStream::kStateRequested, SampleStream::kStateActive))
+        {
+          closeStream(stream);
+          stream.state_ = SampleStream::kStateFree;
+          break;
+        }
+
+        fillStream(stream);
+        break;
+
+      case SampleStream::kStateActive:
+        fillStream(stream);
+        break;
+
+      case SampleStream::kStateReleased:
+        closeStream(stream);
+        stream.state_ = SampleStream::kStateFree;
+        break;
+      }
+    }
+
+    if (carla_sem_timedwait(sem_, 50))
+      needsRead_ = false;
+  }
+}
+
+bool SampleStreamer::openStream(SampleStream &stream)
+{
+  CARLA_SAFE_ASSERT_RETURN(stream.sample_ != nullptr, false);
+  CARLA_SAFE_ASSERT_RETURN(stream.handle_ == nullptr, false);
+
+  const water::String filename(stream.sample_->getFile().getFullPathName());
+
+  struct adinfo info;
+  carla_zeroStruct(info);
+
+  void *const handle = ad_open(filename.toRawUTF8(), &info);
+  CARLA_SAFE_ASSERT_RETURN(handle != nullptr, false);
+
+  if (info.channels == 0 || ad_seek(handle, stream.startFrame_) != stream.startFrame_)
+  {
+    carla_stderr2("sfzero::SampleStreamer::openStream() - failed to seek in '%s'", filename.toRawUTF8());
+    ad_close(handle);
+    return false;
+  }
+
+  if (info.channels > 2 && tempBufferSize_ < kReadFrames * (info.channels - 2))
+  {
+    delete[] tempBuffer_;
+    tempBufferSize_ = kReadFrames * (info.channels - 2);
+    tempBuffer_ = new float[tempBufferSize_];
+  }
+
+  if (tempPlanesSize_ < info.channels)
+  {
+    delete[] tempPlanes_;
+    tempPlanesSize_ = info.channels;
+    tempPlanes_ = new float *[tempPlanesSize_];
+  }
+
+  stream.handle_ = handle;
+  stream.numChannels_ = info.channels;
+  return true;
+}
+
+void SampleStreamer::closeStream(SampleStream &stream) noexcept
+{
+  if (stream.handle_ != nullptr)
+  {
+    ad_close(stream.handle_);
+    stream.handle_ = nullptr;
+  }
+
+  stream.sample_ = nullptr;
+  stream.numChannels_ = 0;
+}
+
+void SampleStreamer::fillStream(SampleStream &stream)
+{
+  if (stream.handle_ == nullptr)
+    return;
+
+  const water::int64 sampleLength = static_cast<water::int64>(stream.sample_->getSampleLength());
+  const water::uint32 numChannels = stream.numChannels_;
+
+  while (! stream.endOfFile_ && ! quitNow_ && stream.state_ == SampleStream::kStateActive)
+  {
+    water::uint32 writeOffset = stream.writeOffset_;
+    const water::uint32 readOffset = stream.readOffset_;
+
+    // the voice ran past the data we have, skip ahead instead of decoding frames nobody will play
+    if (static_cast<water::int32>(readOffset - writeOffset) > 0)
+    {
+      if (ad_seek(stream.handle_, stream.startFrame_ + readOffset) < 0)
+      {
+        stream.endOfFile_ = true;
+        break;
+      }
+
+      writeOffset = readOffset;
+    }
+
+    if (writeOffset - readOffset + kReadFrames > SampleStream::kRingFrames)
+      break;
+
+    const water::int64 framesLeft = sampleLength - (stream.startFrame_ + writeOffset);
+
+    if (framesLeft <= 0)
+    {
+      stream.endOfFile_ = true;
+      break;
+    }
+
+    // decode straight into the ring, up to its end so every channel is a single contiguous block
+    const water::uint32 index = writeOffset & (SampleStream::kRingFrames - 1);
+    const water::uint32 framesToRead = static_cast<water::uint32>(
+        std::min<water::int64>(std::min(kReadFrames, SampleStream::kRingFrames - index), framesLeft));
+
+    float *const bufL = stream.buffers_[0] + index;
+    float *const bufR = stream.buffers_[1] + index;
+
+    tempPlanes_[0] = bufL;
+
+    if (numChannels > 1)
+      tempPlanes_[1] = bufR;
+
+    for (water::uint32 c = 2; c < numChannels; ++c)
+      tempPlanes_[c] = tempBuffer_ + (c - 2) * kReadFrames;
+
+    const ssize_t r = ad_read_planar(stream.handle_, tempPlanes_, framesToRead);
+
+    if (r <= 0)
+    {
+      stream.endOfFile_ = true;
+      break;
+    }
+
+    const water::uint32 framesRead = static_cast<water::uint32>(r);
+
+    if (numChannels == 1)
+      carla_copyFloats(bufR, bufL, framesRead);
+
+    __sync_synchronize();
+    stream.writeOffset_ = writeOffset + framesRead;
+
+    if (framesRead < framesToRead)
+      stream.endOfFile_ = true;
+  }
+}
+}
@@ -0,0 +1,133 @@
+/*************************************************************************************
+ * Original code copyright (C) 2012 Steve Folta
+ * Converted to Juce module (C) 2016 Leo Olivers
+ * Forked from https://github.com/stevefolta/SFZero
+ * For license info please see the LICENSE file distributed with this source code
+ *************************************************************************************/
+#ifndef SFZSTREAM_H_INCLUDED
+#define SFZSTREAM_H_INCLUDED
+
+#include "SFZCommon.h"
+
+#include "CarlaSemUtils.hpp"
+#include "CarlaThread.hpp"
+
+namespace sfzero
+{
+
+class Sample;
+
+// Ring buffer holding the part of a sample that is not kept in memory, for a single playing voice.
+// Frames are written by the SampleStreamer thread and read by the voice, neither side ever blocks.
+class SampleStream
+{
+public:
+  static const water::uint32 kRingFrames = 32768; // must be power of 2
+
+  SampleStream();
+  ~SampleStream();
+
+  // Frame position of the first streamed frame, anything before it comes from the sample head.
+  water::int64 getStartFrame() const noexcept { return startFrame_; }
+
+  // Frame position after the last frame available for reading.
+  water::int64 getEndFrame() const noexcept;
+
+  // Read a single frame, 'endFrame' must come from getEndFrame() in the same cycle.
+  // Returns false if the frame is not available (yet).
+  bool getFrame(water::int64 frame, water::int64 endFrame, float &left, float &right) const noexcept
+  {
+    const water::int64 offset = frame - startFrame_;
+
+    if (offset < 0 || frame >= endFrame)
+      return false;
+
+    const water::uint32 index = static_cast<water::uint32>(offset) & (kRingFrames - 1);
+    left = buffers_[0][index];
+    right = buffers_[1][index];
+    return true;
+  }
+
+  // Let the reader thread know frames before 'frame' are no longer needed.
+  void setReadFrame(water::int64 frame) noexcept;
+
+  // Whether enough frames were consumed for the reader thread to do a refill.
+  bool needsRefill() const noexcept;
+
+private:
+  friend class SampleStreamer;
+
+  enum State
+  {
+    kStateFree,
+    kStateRequested,
+    kStateActive,
+    kStateReleased
+  };
+
+  volatile int state_;
+  Sample *sample_;
+  water::int64 startFrame_;
+
+  // relative to startFrame_
+  volatile water::uint32 readOffset_;
+  volatile water::uint32 writeOffset_;
+  volatile bool endOfFile_;
+
+  // mono samples are written to both buffers
+  float *buffers_[2];
+
+  // reader thread only
+  void *handle_;
+  water::uint32 numChannels_;
+
+  CARLA_DECLARE_NON_COPY_CLASS(SampleStream)
+};
+
+// Background reader feeding the streams of all voices of a synth.
+class SampleStreamer : public CarlaThread
+{
+public:
+  SampleStreamer();
+  ~SampleStreamer() override;
+
+  // Allocate streams, must be called before startNow(). Usually one stream per voice.
+  void allocate(int numStreams);
+  bool isAllocated() const noexcept { return numStreams_ != 0; }
+
+  void startNow();
+  void stopNow();
+
+  // Realtime side.
+  // Start streaming 'sample' from 'startFrame', returns null if no stream is free.
+  SampleStream *acquire(Sample *sample, water::int64 startFrame) noexcept;
+  void release(SampleStream *stream) noexcept;
+  void wakeUp() noexcept;
+
+protected:
+  void run() override;
+
+private:
+  SampleStream *streams_;
+  int numStreams_;
+
+  // planes for channels past the 2nd one, those are decoded and then dropped
+  float *tempBuffer_;
+  water::uint32 tempBufferSize_;
+  float **tempPlanes_;
+  water::uint32 tempPlanesSize_;
+
+  carla_sem_t sem_;
+  bool semValid_;
+  volatile bool needsRead_;
+  volatile bool quitNow_;
+
+  bool openStream(SampleStream &stream);
+  void closeStream(SampleStream &stream) noexcept;
+  void fillStream(SampleStream &stream);
+
+  CARLA_DECLARE_NON_COPY_CLASS(SampleStreamer)
+};
+}
+
+#endif // SFZSTREAM_H_INCLUDED
@@ -85,10 +85,15 @@ void Synth::noteOn(int midiChannel, int midiNoteNumber, float velocity)
   Region::Trigger trigger = (anyNotesPlaying ? Region::legato : Region::first);
   if (sound)
   {
-    int numRegions = sound->getNumRegions();
+    int numRegions;
+    const int *regionIndices = sound->getRegionIndicesFor(midiNoteNumber, midiVelocity, numRegions);
+    if (regionIndices == nullptr)
+    {
+      numRegions = sound->getNumRegions();
+    }
     for (i = 0; i < numRegions; ++i)
     {
-      Region *region = sound->regionAt(i);
+      Region *region = sound->regionAt(regionIndices != nullptr ? regionIndices[i] : i);
       if (region->matches(midiNoteNumber, midiVelocity, trigger))
       {
         Voice *voice =
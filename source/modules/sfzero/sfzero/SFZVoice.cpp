@@ -9,6 +9,7 @@
 #include "SFZRegion.h"
 #include "SFZSample.h"
 #include "SFZSound.h"
+#include "SFZStream.h"
 #include "SFZVoice.h"
 
 #include "water/midi/MidiMessage.h"
@@ -20,9 +21,146 @@ namespace sfzero
 
 static const float globalGain = -1.0;
 
-Voice::Voice()
+// Samples rendered at once, bounded so the per-segment scratch buffers fit on the stack.
+static const int kRenderChunkSize = 128;
+
+// Frames of the sample being played, as seen by the checked interpolation path.
+struct SampleSource
+{
+  const float *inL;
+  const float *inR;
+  water::int64 numFrames;
+  const SampleStream *stream;
+  water::int64 streamEnd;
+  bool looping;
+  water::int64 loopStart, loopEnd;
+
+  // Returns false if the frame is outside the sample or the stream does not have it (yet).
+  bool getFrame(water::int64 frame, float &left, float &right) const noexcept
+  {
+    if (looping && frame > loopEnd)
+    {
+      frame = loopStart + (frame - loopEnd - 1);
+    }
+    if (frame < 0)
+    {
+      return false;
+    }
+    if (frame < numFrames)
+    {
+      left = inL[frame];
+      right = inR != nullptr ? inR[frame] : left;
+      return true;
+    }
+    return stream != nullptr && stream->getFrame(frame, streamEnd, left, right);
+  }
+};
+
+// Clamp a sample count computed in floating point to 1..count, without overflowing the int conversion.
+static int numSamplesFor(double samples, int count) noexcept
+{
+  return static_cast<int>(std::max(1.0, std::min<double>(count, samples)));
+}
+
+// Number of samples, at most 'count', for which the integer part of the position stays at or below 'lastPos'.
+static int numSamplesUpTo(double position, double pitchRatio, water::int64 lastPos, int count) noexcept
+{
+  int num = static_cast<int>(std::max(0.0, std::min<double>(count, (static_cast<double>(lastPos + 1) - position) / pitchRatio)));
+  // fix up rounding errors of the division
+  while (num > 0 && static_cast<water::int64>(position + (num - 1) * pitchRatio) > lastPos)
+  {
+    --num;
+  }
+  while (num < count && static_cast<water::int64>(position + num * pitchRatio) <= lastPos)
+  {
+    ++num;
+  }
+  return num;
+}
+
+// Interpolation kernels, without branches or bounds checks so the compiler can vectorize them.
+// The caller guarantees all frames read are inside the buffer.
+static void interpolateLinear(const float *in, double position, double pitchRatio, float *out, int count) noexcept
+{
+  for (int i = 0; i < count; ++i)
+  {
+    const double p = position + i * pitchRatio;
+    const int pos = static_cast<int>(p);
+    const float alpha = static_cast<float>(p - pos);
+    out[i] = in[pos] + alpha * (in[pos + 1] - in[pos]);
+  }
+}
+
+static inline float cubicHermite(float xm1, float x0, float x1, float x2, float t) noexcept
+{
+  const float c1 = 0.5f * (x1 - xm1);
+  const float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+  const float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+  return ((c3 * t + c2) * t + c1) * t + x0;
+}
+
+static void interpolateCubic(const float *in, double position, double pitchRatio, float *out, int count) noexcept
+{
+  for (int i = 0; i < count; ++i)
+  {
+    const double p = position + i * pitchRatio;
+    const int pos = static_cast<int>(p);
+    const float t = static_cast<float>(p - pos);
+    out[i] = cubicHermite(in[pos - 1], in[pos], in[pos + 1], in[pos + 2], t);
+  }
+}
+
+// Same as the above, but going through SampleSource::getFrame() for every frame.
+// Missing frames repeat their neighbour, or are silent if the current one is missing,
+// so a stream that did not keep up plays silence instead of waiting for the reader thread.
+static void interpolateChecked(const SampleSource &source, bool cubic, double position, double pitchRatio,
+                               float *outL, float *outR, int count) noexcept
+{
+  for (int i = 0; i < count; ++i)
+  {
+    const double p = position + i * pitchRatio;
+    const water::int64 pos = static_cast<water::int64>(p);
+    const float t = static_cast<float>(p - static_cast<double>(pos));
+
+    float curL, curR, nextL, nextR;
+    if (!source.getFrame(pos, curL, curR))
+    {
+      curL = curR = 0.0f;
+    }
+    if (!source.getFrame(pos + 1, nextL, nextR))
+    {
+      nextL = curL;
+      nextR = curR;
+    }
+
+    if (cubic)
+    {
+      float prevL, prevR, afterL, afterR;
+      if (!source.getFrame(pos - 1, prevL, prevR))
+      {
+        prevL = curL;
+        prevR = curR;
+      }
+      if (!source.getFrame(pos + 2, afterL, afterR))
+      {
+        afterL = nextL;
+        afterR = nextR;
+      }
+      outL[i] = cubicHermite(prevL, curL, nextL, afterL, t);
+      outR[i] = cubicHermite(prevR, curR, nextR, afterR, t);
+    }
+    else
+    {
+      outL[i] = curL + t * (nextL - curL);
+      outR[i] = curR + t * (nextR - curR);
+    }
+  }
+}
+
+Voice::Voice(SampleStreamer *streamer)
     : region_(nullptr), curMidiNote_(0), curPitchWheel_(0), pitchRatio_(0), noteGainLeft_(0), noteGainRight_(0),
-      sourceSamplePosition_(0), sampleEnd_(0), loopStart_(0), loopEnd_(0), numLoops_(0), curVelocity_(0)
+      sourceSamplePosition_(0), sampleEnd_(0), loopStart_(0), loopEnd_(0), streamer_(streamer), stream_(nullptr),
+      numLoops_(0), curVelocity_(0)
 {
   ampeg_.setExponentialDecay(true);
 }
@@ -89,6 +227,30 @@ void Voice::startNote(int midiNoteNumber, float floatVelocity, water::Synthesise
     sampleEnd_ = region_->end + 1;
   }
 
+  // Streaming.
+  if (stream_ != nullptr)
+  {
+    streamer_->release(stream_);
+    stream_ = nullptr;
+  }
+  if (region_->sample->isStreamed())
+  {
+    const water::int64 headLength = static_cast<water::int64>(region_->sample->getHeadLength());
+
+    if (sampleEnd_ > headLength)
+    {
+      if (streamer_ != nullptr)
+      {
+        stream_ = streamer_->acquire(region_->sample, std::max(headLength, region_->offset));
+      }
+      if (stream_ == nullptr)
+      {
+        // No free stream, play only what is in memory.
+        sampleEnd_ = headLength;
+      }
+    }
+  }
+
   // Loop.
   loopStart_ = loopEnd_ = 0;
   Region::LoopMode loopMode = region_->loop_mode;
@@ -171,82 +333,162 @@ void Voice::renderNextBlock(water::AudioSampleBuffer &outputBuffer, int startSam
   }
 
   water::AudioSampleBuffer *buffer = region_->sample->getBuffer();
-  const float *inL = buffer->getReadPointer(0, 0);
-  const float *inR = buffer->getNumChannels() > 1 ? buffer->getReadPointer(1, 0) : nullptr;
+  SampleStream *const stream = stream_;
+
+  SampleSource source;
+  source.inL = buffer->getReadPointer(0, 0);
+  source.inR = buffer->getNumChannels() > 1 ? buffer->getReadPointer(1, 0) : nullptr;
+  source.stream = stream;
+  source.streamEnd = stream != nullptr ? stream->getEndFrame() : 0;
+  source.looping = loopStart_ < loopEnd_;
+  source.loopStart = loopStart_;
+  source.loopEnd = loopEnd_;
+  // Frames that can be read straight from the buffer, which includes the zero padding of fully loaded samples.
+  source.numFrames = stream != nullptr ? static_cast<water::int64>(region_->sample->getHeadLength())
+                                       : static_cast<water::int64>(buffer->getNumSamples());
 
   float *outL = outputBuffer.getWritePointer(0, startSample);
   float *outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer(1, startSample) : nullptr;
 
-  int bufferNumSamples = buffer->getNumSamples(); // leoo
-
   // Cache some values, to give them at least some chance of ending up in
   // registers.
   double sourceSamplePosition = this->sourceSamplePosition_;
+  const double pitchRatio = pitchRatio_;
   float ampegGain = ampeg_.getLevel();
   float ampegSlope = ampeg_.getSlope();
   int samplesUntilNextAmpSegment = ampeg_.getSamplesUntilNextSegment();
   bool ampSegmentIsExponential = ampeg_.getSegmentIsExponential();
-  float loopStart = static_cast<float>(this->loopStart_);
-  float loopEnd = static_cast<float>(this->loopEnd_);
-  float sampleEnd = static_cast<float>(this->sampleEnd_);
+  const bool looping = source.looping;
+  const double loopStart = static_cast<double>(loopStart_);
+  const double loopEnd = static_cast<double>(loopEnd_);
+  const double sampleEnd = static_cast<double>(sampleEnd_);
+  const bool cubic = region_->sample_quality >= 2;
+
+  // Frames the kernels may read around the current one, and the range in which they can do so unchecked.
+  // The frame after the loop end wraps to the loop start, so the unchecked range stops at the loop end.
+  const int framesBefore = cubic ? 1 : 0;
+  const int framesAfter = cubic ? 2 : 1;
+  water::int64 lastDirectFrame = source.numFrames - 1;
+  if (looping)
+  {
+    lastDirectFrame = std::min(lastDirectFrame, loopEnd_);
+  }
+  const water::int64 lastDirectPos = lastDirectFrame - framesAfter;
+
+  float mixL[kRenderChunkSize];
+  float mixR[kRenderChunkSize];
+  float gains[kRenderChunkSize];
 
-  while (--numSamples >= 0)
+  while (numSamples > 0)
   {
-    const int pos = static_cast<int>(sourceSamplePosition);
-    CARLA_SAFE_ASSERT_CONTINUE(pos >= 0 && pos < bufferNumSamples); // leoo
+    // Render in segments during which nothing but the read position changes:
+    // up to the end of the block, the next EG segment, the loop end or the sample end.
+    int count = std::min(numSamples, kRenderChunkSize);
+    if (samplesUntilNextAmpSegment < count)
+    {
+      count = std::max(1, samplesUntilNextAmpSegment + 1);
+    }
+    if (looping)
+    {
+      // Number of samples until the position goes past the loop end.
+      count = numSamplesFor(std::floor((loopEnd - sourceSamplePosition) / pitchRatio) + 1.0, count);
+    }
+    // Number of samples until the position reaches the sample end.
+    count = numSamplesFor(std::ceil((sampleEnd - sourceSamplePosition) / pitchRatio), count);
 
-    float alpha = static_cast<float>(sourceSamplePosition - pos);
-    float invAlpha = 1.0f - alpha;
-    int nextPos = pos + 1;
-    if ((loopStart < loopEnd) && (nextPos > loopEnd))
+    // Use the unchecked kernels for the part of the segment where all frames are in the buffer.
+    const water::int64 pos = static_cast<water::int64>(sourceSamplePosition);
+    int direct = 0;
+    if (pos < framesBefore)
+    {
+      count = numSamplesFor(std::ceil((framesBefore - sourceSamplePosition) / pitchRatio), count);
+    }
+    else if (pos <= lastDirectPos)
     {
-      nextPos = static_cast<int>(loopStart);
+      direct = numSamplesUpTo(sourceSamplePosition, pitchRatio, lastDirectPos, count);
+      count = direct;
     }
 
-    // Simple linear interpolation with buffer overrun check
-    float nextL = nextPos < bufferNumSamples ? inL[nextPos] : inL[pos];
-    float nextR = inR ? (nextPos < bufferNumSamples ? inR[nextPos] : inR[pos]) : nextL;
-    float l = (inL[pos] * invAlpha + nextL * alpha);
-    float r = inR ? (inR[pos] * invAlpha + nextR * alpha) : l;
+    const float *segmentR = mixR;
+    if (direct > 0)
+    {
+      if (cubic)
+      {
+        interpolateCubic(source.inL, sourceSamplePosition, pitchRatio, mixL, count);
+        if (source.inR != nullptr)
+        {
+          interpolateCubic(source.inR, sourceSamplePosition, pitchRatio, mixR, count);
+        }
+      }
+      else
+      {
+        interpolateLinear(source.inL, sourceSamplePosition, pitchRatio, mixL, count);
+        if (source.inR != nullptr)
+        {
+          interpolateLinear(source.inR, sourceSamplePosition, pitchRatio, mixR, count);
+        }
+      }
+      if (source.inR == nullptr)
+      {
+        segmentR = mixL;
+      }
+    }
+    else
+    {
+      // Around the loop points, the sample edges and past the sample head.
+      interpolateChecked(source, cubic, sourceSamplePosition, pitchRatio, mixL, mixR, count);
+    }
 
-    //// Simple linear interpolation, old version (possible buffer overrun with non-loop??)
-    // float l = (inL[pos] * invAlpha + inL[nextPos] * alpha);
-    // float r = inR ? (inR[pos] * invAlpha + inR[nextPos] * alpha) : l;
+    // Envelope, which cannot change segment within this segment.
+    if (ampSegmentIsExponential)
+    {
+      for (int i = 0; i < count; ++i)
+      {
+        gains[i] = ampegGain;
+        ampegGain *= ampegSlope;
+      }
+    }
+    else
+    {
+      for (int i = 0; i < count; ++i)
+      {
+        gains[i] = ampegGain + static_cast<float>(i) * ampegSlope;
+      }
+      ampegGain += static_cast<float>(count) * ampegSlope;
+    }
 
-    float gainLeft = noteGainLeft_ * ampegGain;
-    float gainRight = noteGainRight_ * ampegGain;
-    l *= gainLeft;
-    r *= gainRight;
     // Shouldn't we dither here?
-
+    const float gainLeft = noteGainLeft_;
+    const float gainRight = noteGainRight_;
     if (outR)
     {
-      *outL++ += l;
-      *outR++ += r;
+      for (int i = 0; i < count; ++i)
+      {
+        outL[i] += mixL[i] * gains[i] * gainLeft;
+        outR[i] += segmentR[i] * gains[i] * gainRight;
+      }
+      outR += count;
     }
     else
     {
-      *outL++ += (l + r) * 0.5f;
+      for (int i = 0; i < count; ++i)
+      {
+        outL[i] += (mixL[i] * gainLeft + segmentR[i] * gainRight) * gains[i] * 0.5f;
+      }
     }
+    outL += count;
+    numSamples -= count;
 
-    // Next sample.
-    sourceSamplePosition += pitchRatio_;
-    if ((loopStart < loopEnd) && (sourceSamplePosition > loopEnd))
+    // Next segment.
+    sourceSamplePosition += static_cast<double>(count) * pitchRatio;
+    if (looping && (sourceSamplePosition > loopEnd))
     {
       sourceSamplePosition = loopStart;
       numLoops_ += 1;
     }
 
-    // Update EG.
-    if (ampSegmentIsExponential)
-    {
-      ampegGain *= ampegSlope;
-    }
-    else
-    {
-      ampegGain += ampegSlope;
-    }
-    if (--samplesUntilNextAmpSegment < 0)
+    samplesUntilNextAmpSegment -= count;
+    if (samplesUntilNextAmpSegment < 0)
     {
       ampeg_.setLevel(ampegGain);
       ampeg_.nextSegment();
@@ -265,6 +507,15 @@ void Voice::renderNextBlock(water::AudioSampleBuffer &outputBuffer, int startSam
 
   this->sourceSamplePosition_ = sourceSamplePosition;
   ampeg_.setLevel(ampegGain);
+
+  if (stream_ != nullptr)
+  {
+    stream_->setReadFrame(static_cast<water::int64>(sourceSamplePosition));
+    if (stream_->needsRefill())
+    {
+      streamer_->wakeUp();
+    }
+  }
   ampeg_.setSamplesUntilNextSegment(samplesUntilNextAmpSegment);
 }
 
@@ -324,6 +575,11 @@ void Voice::calcPitchRatio()
 
 void Voice::killNote()
 {
+  if (stream_ != nullptr)
+  {
+    streamer_->release(stream_);
+    stream_ = nullptr;
+  }
   region_ = nullptr;
   clearCurrentNote();
 }
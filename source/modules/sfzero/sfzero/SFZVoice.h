@@ -16,11 +16,14 @@ namespace sfzero
 {
 
 struct Region;
+class SampleStream;
+class SampleStreamer;
 
 class Voice : public water::SynthesiserVoice
 {
 public:
-  Voice();
+  // 'streamer' is used to play samples that are not fully loaded in memory, see Sample::isStreamed().
+  explicit Voice(SampleStreamer *streamer = nullptr);
   virtual ~Voice();
 
   bool canPlaySound(water::SynthesiserSound *sound) override;
@@ -51,6 +54,8 @@ private:
   EG ampeg_;
   water::int64 sampleEnd_;
   water::int64 loopStart_, loopEnd_;
+  SampleStreamer *streamer_;
+  SampleStream *stream_;
 
   // Info only.
   int numLoops_;
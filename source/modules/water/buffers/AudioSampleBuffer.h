@@ -330,9 +330,9 @@ public:
     {
         if (newNumSamples != size || newNumChannels != numChannels)
         {
-            const uint32_t allocatedSamplesPerChannel = (newNumSamples + 3) & ~3u;
+            const uint32_t allocatedSamplesPerChannel = getAlignedNumSamples (newNumSamples);
             const uint32_t channelListSize = ((sizeof (float*) * (newNumChannels + 1)) + 15) & ~15u;
-            const size_t newTotalBytes = newNumChannels * allocatedSamplesPerChannel * sizeof(float) + channelListSize + 32u;
+            const size_t newTotalBytes = newNumChannels * allocatedSamplesPerChannel * sizeof(float) + channelListSize + kChannelAlignment;
 
             if (allocatedBytes >= newTotalBytes)
             {
@@ -346,7 +346,7 @@ public:
                 channels = reinterpret_cast<float**> (allocatedData.getData());
             }
 
-            float* chan = reinterpret_cast<float*> (allocatedData + channelListSize);
+            float* chan = getAlignedChannelStart (allocatedData + channelListSize);
             for (uint32_t i = 0; i < newNumChannels; ++i)
             {
                 channels[i] = chan;
@@ -370,13 +370,13 @@ public:
     {
         if (newNumSamples != size)
         {
-            const uint32_t allocatedSamplesPerChannel = (newNumSamples + 3) & ~3u;
+            const uint32_t allocatedSamplesPerChannel = getAlignedNumSamples (newNumSamples);
             const uint32_t channelListSize = ((sizeof (float*) * (numChannels + 1)) + 15) & ~15u;
-            const size_t newTotalBytes = numChannels * allocatedSamplesPerChannel * sizeof(float) + channelListSize + 32u;
+            const size_t newTotalBytes = numChannels * allocatedSamplesPerChannel * sizeof(float) + channelListSize + kChannelAlignment;
 
             CARLA_SAFE_ASSERT_RETURN(allocatedBytes >= newTotalBytes, false);
 
-            float* chan = reinterpret_cast<float*> (allocatedData + channelListSize);
+            float* chan = getAlignedChannelStart (allocatedData + channelListSize);
             for (uint32_t i = 0; i < numChannels; ++i)
             {
                 channels[i] = chan;
@@ -425,6 +425,28 @@ public:
         return allocateChannels (dataToReferTo, 0);
     }
 
+    /** Makes a buffer that already refers to external data point to a new set of arrays,
+        in a real-time safe manner.
+
+        The number of channels stays the same, so the new array must hold as many pointers.
+        Buffers that own their data cannot be changed this way, and this returns false.
+    */
+    bool setDataToReferToRT (float* const* dataToReferTo, const uint32_t newNumSamples) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(dataToReferTo != nullptr || numChannels == 0, false);
+        CARLA_SAFE_ASSERT_RETURN(allocatedBytes == 0, false);
+
+        for (uint32_t i = 0; i < numChannels; ++i)
+        {
+            CARLA_SAFE_ASSERT_RETURN(dataToReferTo[i] != nullptr, false);
+            channels[i] = dataToReferTo[i];
+        }
+
+        size = newNumSamples;
+        isClear = false;
+        return true;
+    }
+
     //==============================================================================
     /** Clears all the samples in all channels. */
     void clear() noexcept
@@ -724,6 +746,22 @@ private:
     float* preallocatedChannelSpace [32];
     bool isClear;
 
+    /* Channels allocated by setSize() start on a cache line and are a whole number of
+       cache lines long, so neighbouring channels never share one. */
+    static const uint32_t kChannelAlignment = 64;
+
+    static uint32_t getAlignedNumSamples (const uint32_t numSamples) noexcept
+    {
+        const uint32_t samplesPerLine = kChannelAlignment / sizeof (float);
+        return (numSamples + samplesPerLine - 1) & ~(samplesPerLine - 1);
+    }
+
+    static float* getAlignedChannelStart (char* const data) noexcept
+    {
+        const uintptr_t address = reinterpret_cast<uintptr_t> (data);
+        return reinterpret_cast<float*> ((address + kChannelAlignment - 1) & ~static_cast<uintptr_t> (kChannelAlignment - 1));
+    }
+
     bool allocateData (bool clearData = false)
     {
         const size_t channelListSize = sizeof (float*) * (numChannels + 1);
@@ -1062,6 +1062,16 @@ int64 File::getSize() const
     return 0;
 }
 
+int64 File::getLastModificationTime() const
+{
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+    if (GetFileAttributesEx (fullPath.toUTF8(), GetFileExInfoStandard, &attributes))
+        return WindowsFileHelpers::fileTimeToTime (&attributes.ftLastWriteTime);
+
+    return 0;
+}
+
 bool File::deleteFile() const
 {
     if (! exists())
@@ -1286,6 +1296,12 @@ int64 File::getSize() const
     return water_stat (fullPath, info) ? info.st_size : 0;
 }
 
+int64 File::getLastModificationTime() const
+{
+    water_statStruct info;
+    return water_stat (fullPath, info) ? (int64) info.st_mtime * 1000 : 0;
+}
+
 bool File::deleteFile() const
 {
     if (! exists() && ! isSymbolicLink())
@@ -132,6 +132,12 @@ public:
     */
     int64 getSize() const;
 
+    /** Returns the last time the file was modified, in milliseconds since midnight Jan 1st 1970 UTC.
+
+        @returns    the modification time, or 0 if the file doesn't exist.
+    */
+    int64 getLastModificationTime() const;
+
     /** Utility function to convert a file size in bytes to a neat string description.
 
         So for example 100 would return "100 bytes", 2000 would return "2 KB",
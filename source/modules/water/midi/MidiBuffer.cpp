@@ -138,6 +138,65 @@ void MidiBuffer::addEvent (const void* const newData, const int maxBytes, const
     }
 }
 
+void MidiBuffer::addRawEvent (const void* const rawData, const int numBytes, const int sampleNumber, const int lastAddedTime)
+{
+    if (numBytes <= 0 || numBytes > 0xffff)
+        return;
+
+    const size_t newItemSize = (size_t) numBytes + sizeof (int32) + sizeof (uint16);
+    const int offset = (lastAddedTime >= 0 && sampleNumber >= lastAddedTime)
+                     ? data.size()
+                     : (int) (MidiBufferHelpers::findEventAfter (data.begin(), data.end(), sampleNumber) - data.begin());
+
+    data.insertMultiple (offset, 0, (int) newItemSize);
+
+    uint8* const d = data.begin() + offset;
+    writeUnaligned<int32>  (d, sampleNumber);
+    writeUnaligned<uint16> (d + 4, static_cast<uint16> (numBytes));
+    memcpy (d + 6, rawData, (size_t) numBytes);
+}
+
+void MidiBuffer::mergeEvents (const MidiBuffer& otherBuffer, MidiBuffer& scratch)
+{
+    if (otherBuffer.data.size() == 0)
+        return;
+
+    if (data.size() == 0)
+    {
+        // copy into the storage we already have, assigning the array would reallocate it
+        data.clearQuick();
+        data.addArray (static_cast<const uint8*> (otherBuffer.data.begin()), otherBuffer.data.size());
+        return;
+    }
+
+    if (otherBuffer.getFirstEventTime() >= getLastEventTime())
+    {
+        data.addArray (static_cast<const uint8*> (otherBuffer.data.begin()), otherBuffer.data.size());
+        return;
+    }
+
+    Array<uint8>& out (scratch.data);
+    out.clearQuick();
+    out.ensureStorageAllocated (data.size() + otherBuffer.data.size());
+
+    const uint8* a = data.begin();
+    const uint8* b = otherBuffer.data.begin();
+    const uint8* const endA = data.end();
+    const uint8* const endB = otherBuffer.data.end();
+
+    while (a < endA || b < endB)
+    {
+        // events from this buffer go first when times are equal, same as addEvents()
+        const uint8*& d = (b >= endB || (a < endA && MidiBufferHelpers::getEventTime (a) <= MidiBufferHelpers::getEventTime (b))) ? a : b;
+        const int itemSize = MidiBufferHelpers::getEventTotalSize (d);
+
+        out.addArray (d, itemSize);
+        d += itemSize;
+    }
+
+    data.swapWith (out);
+}
+
 void MidiBuffer::addEvents (const MidiBuffer& otherBuffer,
                             const int startSample,
                             const int numSamples,
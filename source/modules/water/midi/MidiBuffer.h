@@ -139,6 +139,27 @@ public:
                     int numSamples,
                     int sampleDeltaToAdd);
 
+    /** Adds an event without interpreting its contents as MIDI data.
+
+        This is used to carry non-MIDI event structures through the graph.
+        The event is inserted after any existing events with the same or an earlier
+        timestamp, and is appended directly when it is not earlier than 'lastAddedTime'
+        (pass a negative value if unknown).
+    */
+    void addRawEvent (const void* rawData,
+                      int numBytes,
+                      int sampleNumber,
+                      int lastAddedTime = -1);
+
+    /** Merges all events from another buffer into this one, keeping them sorted by time.
+
+        Unlike addEvents(), this runs in linear time: the common cases of an empty
+        buffer or non-overlapping ranges are plain copies, anything else is merged
+        into 'scratch', which is then swapped with this buffer.
+        The event contents are copied as-is, so this also works for raw events.
+    */
+    void mergeEvents (const MidiBuffer& otherBuffer, MidiBuffer& scratch);
+
     /** Returns the sample number of the first event in the buffer.
         If the buffer's empty, this will just return 0.
     */
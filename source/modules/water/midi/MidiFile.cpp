@@ -95,52 +95,87 @@ namespace MidiFileHelpers
         return true;
     }
 
-    static double convertTicksToSeconds (const double time,
-                                         const MidiMessageSequence& tempoEvents,
-                                         const int timeFormat)
+    // tempo changes in seconds, so timestamps can be converted without walking all tempo events for each one
+    struct TempoMap
     {
-        if (timeFormat < 0)
-            return time / (-(timeFormat >> 8) * (timeFormat & 0xff));
-
-        double lastTime = 0.0, correctedTime = 0.0;
-        const double tickLen = 1.0 / (timeFormat & 0x7fff);
-        double secsPerTick = 0.5 * tickLen;
-        const int numEvents = tempoEvents.getNumEvents();
-
-        for (int i = 0; i < numEvents; ++i)
+        struct Segment
         {
-            const MidiMessage& m = tempoEvents.getEventPointer(i)->message;
-            const double eventTime = m.getTimeStamp();
+            double startTick;
+            double startSeconds;
+            double secsPerTick;
+        };
 
-            if (eventTime >= time)
-                break;
+        TempoMap (const MidiMessageSequence& tempoEvents, const int timeFormat)
+            : segments(), cursor (0)
+        {
+            const double tickLen = 1.0 / (timeFormat & 0x7fff);
+            const int numEvents = tempoEvents.getNumEvents();
 
-            correctedTime += (eventTime - lastTime) * secsPerTick;
-            lastTime = eventTime;
+            segments.ensureStorageAllocated (numEvents + 1);
 
-            if (m.isTempoMetaEvent())
-                secsPerTick = tickLen * m.getTempoSecondsPerQuarterNote();
+            const Segment first = { 0.0, 0.0, 0.5 * tickLen };
+            segments.add (first);
 
-            while (i + 1 < numEvents)
+            for (int i = 0; i < numEvents; ++i)
             {
-                const MidiMessage& m2 = tempoEvents.getEventPointer(i + 1)->message;
+                const MidiMessage& m = tempoEvents.getEventPointer(i)->message;
 
-                if (m2.getTimeStamp() != eventTime)
-                    break;
+                if (! m.isTempoMetaEvent())
+                    continue;
 
-                if (m2.isTempoMetaEvent())
-                    secsPerTick = tickLen * m2.getTempoSecondsPerQuarterNote();
+                Segment& last = segments.getReference (segments.size() - 1);
+                const double eventTime = m.getTimeStamp();
+                const double secsPerTick = tickLen * m.getTempoSecondsPerQuarterNote();
 
-                ++i;
+                // the last of several changes at the same time wins
+                if (segments.size() > 1 && last.startTick == eventTime)
+                {
+                    last.secsPerTick = secsPerTick;
+                    continue;
+                }
+
+                const Segment segment = { eventTime,
+                                          last.startSeconds + (eventTime - last.startTick) * last.secsPerTick,
+                                          secsPerTick };
+                segments.add (segment);
             }
         }
 
-        return correctedTime + (time - lastTime) * secsPerTick;
-    }
+        // fastest when called with increasing times, as done for the (sorted) events of a track
+        double convert (const double time) noexcept
+        {
+            // a tempo change only applies to events after it
+            if (segments.getReference (cursor).startTick >= time)
+                cursor = 0;
+
+            while (cursor + 1 < segments.size() && segments.getReference (cursor + 1).startTick < time)
+                ++cursor;
+
+            const Segment& segment = segments.getReference (cursor);
+            return segment.startSeconds + (time - segment.startTick) * segment.secsPerTick;
+        }
+
+        void rewind() noexcept
+        {
+            cursor = 0;
+        }
+
+        Array<Segment> segments;
+        int cursor;
+    };
 
     // a comparator that puts all the note-offs before note-ons that have the same time
     struct Sorter
     {
+        static bool isSorted (const OwnedArray<MidiMessageSequence::MidiEventHolder>& list) noexcept
+        {
+            for (size_t i = 1; i < list.size(); ++i)
+                if (compareElements (list.getUnchecked (i - 1), list.getUnchecked (i)) > 0)
+                    return false;
+
+            return true;
+        }
+
         static int compareElements (const MidiMessageSequence::MidiEventHolder* const first,
                                     const MidiMessageSequence::MidiEventHolder* const second) noexcept
         {
@@ -316,7 +351,14 @@ void MidiFile::readNextTrack (const uint8* data, int size)
     double time = 0;
     uint8 lastStatusByte = 0;
 
-    MidiMessageSequence result;
+    // read straight into the new track, copying a big sequence costs as much as reading it
+    MidiMessageSequence* const track = new MidiMessageSequence();
+    tracks.add (track);
+
+    MidiMessageSequence& result (*track);
+
+    // an event needs at least 2 bytes, with running status
+    result.list.ensureStorageAllocated (size / 3);
 
     while (size > 0)
     {
@@ -335,6 +377,7 @@ void MidiFile::readNextTrack (const uint8* data, int size)
         size -= messSize;
         data += messSize;
 
+        // delta times are never negative, so this always appends
         result.addEvent (mm);
 
         const uint8 firstByte = *(mm.getRawData());
@@ -344,10 +387,11 @@ void MidiFile::readNextTrack (const uint8* data, int size)
 
     // use a sort that puts all the note-offs before note-ons that have the same time
     MidiFileHelpers::Sorter sorter;
-    result.list.sort (sorter, true);
 
-    addTrack (result);
-    tracks.getLast()->updateMatchedPairs();
+    if (! MidiFileHelpers::Sorter::isSorted (result.list))
+        result.list.sort (sorter, true);
+
+    result.updateMatchedPairs();
 }
 
 //==============================================================================
@@ -355,10 +399,11 @@ void MidiFile::convertTimestampTicksToSeconds()
 {
     MidiMessageSequence tempoEvents;
     findAllTempoEvents (tempoEvents);
-    findAllTimeSigEvents (tempoEvents);
 
-    if (timeFormat != 0)
+    if (timeFormat < 0)
     {
+        const double framesPerSecond = -(timeFormat >> 8) * (timeFormat & 0xff);
+
         for (size_t i = 0; i < tracks.size(); ++i)
         {
             const MidiMessageSequence& ms = *tracks.getUnchecked(i);
@@ -366,7 +411,23 @@ void MidiFile::convertTimestampTicksToSeconds()
             for (int j = ms.getNumEvents(); --j >= 0;)
             {
                 MidiMessage& m = ms.getEventPointer(j)->message;
-                m.setTimeStamp (MidiFileHelpers::convertTicksToSeconds (m.getTimeStamp(), tempoEvents, timeFormat));
+                m.setTimeStamp (m.getTimeStamp() / framesPerSecond);
+            }
+        }
+    }
+    else if (timeFormat != 0)
+    {
+        MidiFileHelpers::TempoMap tempoMap (tempoEvents, timeFormat);
+
+        for (size_t i = 0; i < tracks.size(); ++i)
+        {
+            const MidiMessageSequence& ms = *tracks.getUnchecked(i);
+            tempoMap.rewind();
+
+            for (int j = 0, numEvents = ms.getNumEvents(); j < numEvents; ++j)
+            {
+                MidiMessage& m = ms.getEventPointer(j)->message;
+                m.setTimeStamp (tempoMap.convert (m.getTimeStamp()));
             }
         }
     }
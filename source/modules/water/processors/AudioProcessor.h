@@ -159,6 +159,38 @@ public:
                                      AudioSampleBuffer& cvOutBuffer,
                                      MidiBuffer& midiMessages) = 0;
 
+    /** Returns true if this processor can start a block in startBlockWithCV() and
+        complete it later in processBlockWithCV().
+
+        This is meant for processors that hand their work off to another process.
+        The graph can then start several of them before waiting on any, so that
+        they run at the same time.
+    */
+    virtual bool canStartBlock() const noexcept                 { return false; }
+
+    /** Starts processing a block in the background.
+
+        Only called if canStartBlock() returns true. The next processBlockWithCV()
+        call receives the same buffers and must wait for and complete this block.
+    */
+    virtual void startBlockWithCV (AudioSampleBuffer&, const AudioSampleBuffer&,
+                                   AudioSampleBuffer&, MidiBuffer&) {}
+
+    /** Returns true if this processor has to run even when none of its outputs are used.
+
+        A graph skips processors whose outputs cannot reach any of its own outputs.
+        Processors that do something else with their input, like meters and analysers,
+        should override this.
+    */
+    virtual bool mustAlwaysProcess() const noexcept             { return false; }
+
+    /** Returns true if a block can be skipped when all of its audio inputs are silent,
+        there is no midi to process and the processor does not use CV inputs.
+
+        Only meant for processors that have no state and write no outputs of their own.
+    */
+    virtual bool canSkipSilentBlocks() const noexcept           { return false; }
+
     //==============================================================================
     /** Returns the total number of input channels. */
     uint getTotalNumInputChannels(ChannelType t) const noexcept;
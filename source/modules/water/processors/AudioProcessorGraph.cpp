@@ -21,21 +21,50 @@
 #include "AudioProcessorGraph.h"
 #include "../containers/SortedSet.h"
 
+#include "CarlaThreadPool.hpp"
+
 namespace water {
 
 //==============================================================================
 namespace GraphRenderingOps
 {
 
+/** The shared buffers touched by a set of rendering ops. */
+struct RenderingBufferUsage
+{
+    Array<int> audio, cv, midi;
+};
+
 struct AudioGraphRenderingOpBase
 {
     AudioGraphRenderingOpBase() noexcept {}
     virtual ~AudioGraphRenderingOpBase() {}
 
+    /** 'silentAudioChans' tells which shared audio channels are known to only contain zeros.
+        Ops must keep it up to date for every audio channel they write to.
+    */
     virtual void perform (AudioSampleBuffer& sharedAudioBufferChans,
                           AudioSampleBuffer& sharedCVBufferChans,
                           const OwnedArray<MidiBuffer>& sharedMidiBuffers,
+                          bool* silentAudioChans,
                           const int numSamples) = 0;
+
+    virtual void addUsedBuffers (RenderingBufferUsage& usage) const = 0;
+
+    /** Starts this op in the background if it is able to, in which case the next
+        perform() call with the same buffers completes it. Returns false otherwise.
+    */
+    virtual bool start (AudioSampleBuffer&, AudioSampleBuffer&, const OwnedArray<MidiBuffer>&, bool*, const int)
+    {
+        return false;
+    }
+
+    virtual bool canStart() const noexcept      { return false; }
+
+    /** Returns true if 'other' is the same kind of op working on the same buffers.
+        The delay amount of delay ops is not compared, as it can be changed in place.
+    */
+    virtual bool isSameOpAs (const AudioGraphRenderingOpBase& other) const = 0;
 };
 
 // use CRTP
@@ -45,13 +74,22 @@ struct AudioGraphRenderingOp  : public AudioGraphRenderingOpBase
     void perform (AudioSampleBuffer& sharedAudioBufferChans,
                   AudioSampleBuffer& sharedCVBufferChans,
                   const OwnedArray<MidiBuffer>& sharedMidiBuffers,
+                  bool* const silentAudioChans,
                   const int numSamples) override
     {
         static_cast<Child*> (this)->perform (sharedAudioBufferChans,
                                              sharedCVBufferChans,
                                              sharedMidiBuffers,
+                                             silentAudioChans,
                                              numSamples);
     }
+
+    bool isSameOpAs (const AudioGraphRenderingOpBase& other) const override
+    {
+        const Child* const otherOp = dynamic_cast<const Child*> (&other);
+
+        return otherOp != nullptr && static_cast<const Child*> (this)->hasSameSettings (*otherOp);
+    }
 };
 
 //==============================================================================
@@ -63,12 +101,28 @@ struct ClearChannelOp  : public AudioGraphRenderingOp<ClearChannelOp>
     void perform (AudioSampleBuffer& sharedAudioBufferChans,
                   AudioSampleBuffer& sharedCVBufferChans,
                   const OwnedArray<MidiBuffer>&,
+                  bool* const silentAudioChans,
                   const int numSamples)
     {
         if (isCV)
+        {
             sharedCVBufferChans.clear (channelNum, 0, numSamples);
-        else
+        }
+        else if (! silentAudioChans[channelNum])
+        {
             sharedAudioBufferChans.clear (channelNum, 0, numSamples);
+            silentAudioChans[channelNum] = true;
+        }
+    }
+
+    void addUsedBuffers (RenderingBufferUsage& usage) const override
+    {
+        (isCV ? usage.cv : usage.audio).addIfNotAlreadyThere (channelNum);
+    }
+
+    bool hasSameSettings (const ClearChannelOp& other) const noexcept
+    {
+        return channelNum == other.channelNum && isCV == other.isCV;
     }
 
     const int channelNum;
@@ -86,12 +140,38 @@ struct CopyChannelOp  : public AudioGraphRenderingOp<CopyChannelOp>
     void perform (AudioSampleBuffer& sharedAudioBufferChans,
                   AudioSampleBuffer& sharedCVBufferChans,
                   const OwnedArray<MidiBuffer>&,
+                  bool* const silentAudioChans,
                   const int numSamples)
     {
         if (isCV)
+        {
             sharedCVBufferChans.copyFrom (dstChannelNum, 0, sharedCVBufferChans, srcChannelNum, 0, numSamples);
+        }
+        else if (silentAudioChans[srcChannelNum])
+        {
+            if (! silentAudioChans[dstChannelNum])
+            {
+                sharedAudioBufferChans.clear (dstChannelNum, 0, numSamples);
+                silentAudioChans[dstChannelNum] = true;
+            }
+        }
         else
+        {
             sharedAudioBufferChans.copyFrom (dstChannelNum, 0, sharedAudioBufferChans, srcChannelNum, 0, numSamples);
+            silentAudioChans[dstChannelNum] = false;
+        }
+    }
+
+    void addUsedBuffers (RenderingBufferUsage& usage) const override
+    {
+        Array<int>& buffers (isCV ? usage.cv : usage.audio);
+        buffers.addIfNotAlreadyThere (srcChannelNum);
+        buffers.addIfNotAlreadyThere (dstChannelNum);
+    }
+
+    bool hasSameSettings (const CopyChannelOp& other) const noexcept
+    {
+        return srcChannelNum == other.srcChannelNum && dstChannelNum == other.dstChannelNum && isCV == other.isCV;
     }
 
     const int srcChannelNum, dstChannelNum;
@@ -109,12 +189,35 @@ struct AddChannelOp  : public AudioGraphRenderingOp<AddChannelOp>
     void perform (AudioSampleBuffer& sharedAudioBufferChans,
                   AudioSampleBuffer& sharedCVBufferChans,
                   const OwnedArray<MidiBuffer>&,
+                  bool* const silentAudioChans,
                   const int numSamples)
     {
         if (isCV)
+        {
             sharedCVBufferChans.addFrom (dstChannelNum, 0, sharedCVBufferChans, srcChannelNum, 0, numSamples);
-        else
-            sharedAudioBufferChans.addFrom (dstChannelNum, 0, sharedAudioBufferChans, srcChannelNum, 0, numSamples);
+        }
+        else if (! silentAudioChans[srcChannelNum])
+        {
+            // adding into silence is a plain copy
+            if (silentAudioChans[dstChannelNum])
+                sharedAudioBufferChans.copyFrom (dstChannelNum, 0, sharedAudioBufferChans, srcChannelNum, 0, numSamples);
+            else
+                sharedAudioBufferChans.addFrom (dstChannelNum, 0, sharedAudioBufferChans, srcChannelNum, 0, numSamples);
+
+            silentAudioChans[dstChannelNum] = false;
+        }
+    }
+
+    void addUsedBuffers (RenderingBufferUsage& usage) const override
+    {
+        Array<int>& buffers (isCV ? usage.cv : usage.audio);
+        buffers.addIfNotAlreadyThere (srcChannelNum);
+        buffers.addIfNotAlreadyThere (dstChannelNum);
+    }
+
+    bool hasSameSettings (const AddChannelOp& other) const noexcept
+    {
+        return srcChannelNum == other.srcChannelNum && dstChannelNum == other.dstChannelNum && isCV == other.isCV;
     }
 
     const int srcChannelNum, dstChannelNum;
@@ -130,11 +233,21 @@ struct ClearMidiBufferOp  : public AudioGraphRenderingOp<ClearMidiBufferOp>
 
     void perform (AudioSampleBuffer&, AudioSampleBuffer&,
                   const OwnedArray<MidiBuffer>& sharedMidiBuffers,
-                  const int)
+                  bool*, const int)
     {
         sharedMidiBuffers.getUnchecked (bufferNum)->clear();
     }
 
+    void addUsedBuffers (RenderingBufferUsage& usage) const override
+    {
+        usage.midi.addIfNotAlreadyThere (bufferNum);
+    }
+
+    bool hasSameSettings (const ClearMidiBufferOp& other) const noexcept
+    {
+        return bufferNum == other.bufferNum;
+    }
+
     const int bufferNum;
 
     CARLA_DECLARE_NON_COPY_CLASS (ClearMidiBufferOp)
@@ -149,11 +262,22 @@ struct CopyMidiBufferOp  : public AudioGraphRenderingOp<CopyMidiBufferOp>
 
     void perform (AudioSampleBuffer&, AudioSampleBuffer&,
                   const OwnedArray<MidiBuffer>& sharedMidiBuffers,
-                  const int)
+                  bool*, const int)
     {
         *sharedMidiBuffers.getUnchecked (dstBufferNum) = *sharedMidiBuffers.getUnchecked (srcBufferNum);
     }
 
+    void addUsedBuffers (RenderingBufferUsage& usage) const override
+    {
+        usage.midi.addIfNotAlreadyThere (srcBufferNum);
+        usage.midi.addIfNotAlreadyThere (dstBufferNum);
+    }
+
+    bool hasSameSettings (const CopyMidiBufferOp& other) const noexcept
+    {
+        return srcBufferNum == other.srcBufferNum && dstBufferNum == other.dstBufferNum;
+    }
+
     const int srcBufferNum, dstBufferNum;
 
     CARLA_DECLARE_NON_COPY_CLASS (CopyMidiBufferOp)
@@ -168,13 +292,25 @@ struct AddMidiBufferOp  : public AudioGraphRenderingOp<AddMidiBufferOp>
 
     void perform (AudioSampleBuffer&, AudioSampleBuffer&,
                   const OwnedArray<MidiBuffer>& sharedMidiBuffers,
-                  const int numSamples)
+                  bool*, const int)
     {
         sharedMidiBuffers.getUnchecked (dstBufferNum)
-            ->addEvents (*sharedMidiBuffers.getUnchecked (srcBufferNum), 0, numSamples, 0);
+            ->mergeEvents (*sharedMidiBuffers.getUnchecked (srcBufferNum), scratchBuffer);
+    }
+
+    void addUsedBuffers (RenderingBufferUsage& usage) const override
+    {
+        usage.midi.addIfNotAlreadyThere (srcBufferNum);
+        usage.midi.addIfNotAlreadyThere (dstBufferNum);
+    }
+
+    bool hasSameSettings (const AddMidiBufferOp& other) const noexcept
+    {
+        return srcBufferNum == other.srcBufferNum && dstBufferNum == other.dstBufferNum;
     }
 
     const int srcBufferNum, dstBufferNum;
+    MidiBuffer scratchBuffer;
 
     CARLA_DECLARE_NON_COPY_CLASS (AddMidiBufferOp)
 };
@@ -182,41 +318,140 @@ struct AddMidiBufferOp  : public AudioGraphRenderingOp<AddMidiBufferOp>
 //==============================================================================
 struct DelayChannelOp  : public AudioGraphRenderingOp<DelayChannelOp>
 {
-    DelayChannelOp (const int chan, const int delaySize, const bool cv)
+    DelayChannelOp (const int chan, const int delaySize, const int blockSize, const bool cv)
         : channel (chan),
-          bufferSize (delaySize + 1),
-          readIndex (0), writeIndex (delaySize),
+          delay (delaySize),
+          maxDelay (getMaxDelayFor (delaySize)),
+          bufferSize (maxDelay + jmax (1, blockSize)),
+          writeIndex (0),
+          silentLineSamples (bufferSize),
           isCV (cv)
     {
         buffer.calloc ((size_t) bufferSize);
     }
 
+    int getDelay() const noexcept
+    {
+        return __atomic_load_n (&delay, __ATOMIC_ACQUIRE);
+    }
+
+    bool canSetDelay (const int newDelay) const noexcept
+    {
+        return newDelay >= 0 && newDelay <= maxDelay;
+    }
+
+    /** Changes the delay while the op is in use, keeping the line contents.
+        The line always receives the input, so a longer delay reads back real history.
+    */
+    void setDelay (const int newDelay) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN (canSetDelay (newDelay),);
+
+        __atomic_store_n (&delay, newDelay, __ATOMIC_RELEASE);
+    }
+
     void perform (AudioSampleBuffer& sharedAudioBufferChans,
                   AudioSampleBuffer& sharedCVBufferChans,
                   const OwnedArray<MidiBuffer>&,
+                  bool* const silentAudioChans,
                   const int numSamples)
     {
+        if (! isCV)
+        {
+            if (! silentAudioChans[channel])
+            {
+                silentLineSamples = 0;
+            }
+            else
+            {
+                // once the line has been fed silence all the way round, it only gives back silence
+                if (silentLineSamples >= bufferSize)
+                    return;
+
+                silentLineSamples += numSamples;
+            }
+
+            silentAudioChans[channel] = false;
+        }
+
+        const int curDelay = getDelay();
+
         float* data = isCV
                     ? sharedCVBufferChans.getWritePointer (channel, 0)
                     : sharedAudioBufferChans.getWritePointer (channel, 0);
-        HeapBlock<float>& block = buffer;
 
-        for (int i = numSamples; --i >= 0;)
+        // the line holds a full block more than the delay, so each block can be written
+        // before it is read back, in at most 2 spans each way
+        const int maxChunk = bufferSize - curDelay;
+
+        for (int remaining = numSamples; remaining > 0;)
         {
-            block [writeIndex] = *data;
-            *data++ = block [readIndex];
+            const int chunk = jmin (remaining, maxChunk);
+            const int readIndex = (writeIndex >= curDelay) ? writeIndex - curDelay : writeIndex - curDelay + bufferSize;
+
+            copySpans (writeIndex, data, chunk, true);
+
+            if (curDelay != 0)
+                copySpans (readIndex, data, chunk, false);
 
-            if (++readIndex  >= bufferSize) readIndex = 0;
-            if (++writeIndex >= bufferSize) writeIndex = 0;
+            writeIndex += chunk;
+            if (writeIndex >= bufferSize)
+                writeIndex -= bufferSize;
+
+            data += chunk;
+            remaining -= chunk;
         }
     }
 
+    void addUsedBuffers (RenderingBufferUsage& usage) const override
+    {
+        (isCV ? usage.cv : usage.audio).addIfNotAlreadyThere (channel);
+    }
+
+    bool hasSameSettings (const DelayChannelOp& other) const noexcept
+    {
+        return channel == other.channel && isCV == other.isCV;
+    }
+
 private:
     HeapBlock<float> buffer;
-    const int channel, bufferSize;
-    int readIndex, writeIndex;
+    const int channel;
+    int delay;
+    const int maxDelay, bufferSize;
+    int writeIndex;
+    int silentLineSamples;
     const bool isCV;
 
+    // leave room for the delay to grow in place, up to the next power of 2
+    static int getMaxDelayFor (const int delaySize) noexcept
+    {
+        int maxSize = 64;
+
+        while (maxSize < delaySize)
+            maxSize *= 2;
+
+        return maxSize;
+    }
+
+    void copySpans (const int lineIndex, float* const data, const int count, const bool toLine) noexcept
+    {
+        float* const line = buffer.getData();
+        const int first = jmin (count, bufferSize - lineIndex);
+
+        if (toLine)
+        {
+            carla_copyFloats (line + lineIndex, data, (std::size_t) first);
+            if (first < count)
+                carla_copyFloats (line, data + first, (std::size_t) (count - first));
+        }
+        else
+        {
+            carla_copyFloats (data, line + lineIndex, (std::size_t) first);
+            if (first < count)
+                carla_copyFloats (data + first, line, (std::size_t) (count - first));
+        }
+    }
+
     CARLA_DECLARE_NON_COPY_CLASS (DelayChannelOp)
 };
 
@@ -225,6 +460,7 @@ struct ProcessBufferOp   : public AudioGraphRenderingOp<ProcessBufferOp>
 {
     ProcessBufferOp (const AudioProcessorGraph::Node::Ptr& n,
                      const Array<uint>& audioChannelsUsed,
+                     const uint numAudioInChans,
                      const uint totalNumChans,
                      const Array<uint>& cvInChannelsUsed,
                      const Array<uint>& cvOutChannelsUsed,
@@ -234,6 +470,7 @@ struct ProcessBufferOp   : public AudioGraphRenderingOp<ProcessBufferOp>
           audioChannelsToUse (audioChannelsUsed),
           cvInChannelsToUse (cvInChannelsUsed),
           cvOutChannelsToUse (cvOutChannelsUsed),
+          numAudioIns (numAudioInChans),
           totalAudioChans (jmax (1U, totalNumChans)),
           totalCVIns (cvInChannelsUsed.size()),
           totalCVOuts (cvOutChannelsUsed.size()),
@@ -247,11 +484,66 @@ struct ProcessBufferOp   : public AudioGraphRenderingOp<ProcessBufferOp>
             audioChannelsToUse.add (0);
     }
 
+    bool start (AudioSampleBuffer& sharedAudioBufferChans,
+                AudioSampleBuffer& sharedCVBufferChans,
+                const OwnedArray<MidiBuffer>& sharedMidiBuffers,
+                bool* const silentAudioChans,
+                const int numSamples) override
+    {
+        if (! processor->canStartBlock() || processor->isSuspended())
+            return false;
+
+        markAudioChannels (silentAudioChans, false);
+
+        for (uint i = 0; i < totalAudioChans; ++i)
+            audioChannels[i] = sharedAudioBufferChans.getWritePointer (audioChannelsToUse.getUnchecked (i), 0);
+
+        for (uint i = 0; i < totalCVIns; ++i)
+            cvInChannels[i] = sharedCVBufferChans.getWritePointer (cvInChannelsToUse.getUnchecked (i), 0);
+
+        for (uint i = 0; i < totalCVOuts; ++i)
+            cvOutChannels[i] = sharedCVBufferChans.getWritePointer (cvOutChannelsToUse.getUnchecked (i), 0);
+
+        AudioSampleBuffer audioBuffer (audioChannels, totalAudioChans, numSamples);
+        AudioSampleBuffer cvInBuffer  (cvInChannels, totalCVIns, numSamples);
+        AudioSampleBuffer cvOutBuffer (cvOutChannels, totalCVOuts, numSamples);
+
+        const CarlaRecursiveMutexLocker cml (processor->getCallbackLock());
+
+        processor->startBlockWithCV (audioBuffer, cvInBuffer, cvOutBuffer, *sharedMidiBuffers.getUnchecked (midiBufferToUse));
+        return true;
+    }
+
+    bool canStart() const noexcept override
+    {
+        return processor->canStartBlock();
+    }
+
     void perform (AudioSampleBuffer& sharedAudioBufferChans,
                   AudioSampleBuffer& sharedCVBufferChans,
                   const OwnedArray<MidiBuffer>& sharedMidiBuffers,
+                  bool* const silentAudioChans,
                   const int numSamples)
     {
+        if (canSkipBlock (silentAudioChans, *sharedMidiBuffers.getUnchecked (midiBufferToUse)))
+        {
+            for (uint i = 0; i < totalAudioChans; ++i)
+            {
+                const uint chan = audioChannelsToUse.getUnchecked (i);
+
+                if (! silentAudioChans[chan])
+                {
+                    sharedAudioBufferChans.clear (static_cast<int> (chan), 0, numSamples);
+                    silentAudioChans[chan] = true;
+                }
+            }
+
+            for (uint i = 0; i < totalCVOuts; ++i)
+                sharedCVBufferChans.clear (static_cast<int> (cvOutChannelsToUse.getUnchecked (i)), 0, numSamples);
+
+            return;
+        }
+
         HeapBlock<float*>& audioChannelsCopy = audioChannels;
         HeapBlock<float*>& cvInChannelsCopy  = cvInChannels;
         HeapBlock<float*>& cvOutChannelsCopy = cvOutChannels;
@@ -273,12 +565,14 @@ struct ProcessBufferOp   : public AudioGraphRenderingOp<ProcessBufferOp>
         {
             audioBuffer.clear();
             cvOutBuffer.clear();
+            markAudioChannels (silentAudioChans, true);
         }
         else
         {
             const CarlaRecursiveMutexLocker cml (processor->getCallbackLock());
 
             callProcess (audioBuffer, cvInBuffer, cvOutBuffer, *sharedMidiBuffers.getUnchecked (midiBufferToUse));
+            markAudioChannels (silentAudioChans, false);
         }
     }
 
@@ -290,6 +584,29 @@ struct ProcessBufferOp   : public AudioGraphRenderingOp<ProcessBufferOp>
         processor->processBlockWithCV (audioBuffer, cvInBuffer, cvOutBuffer, midiMessages);
     }
 
+    void addUsedBuffers (RenderingBufferUsage& usage) const override
+    {
+        for (int i = 0; i < audioChannelsToUse.size(); ++i)
+            usage.audio.addIfNotAlreadyThere (static_cast<int> (audioChannelsToUse.getUnchecked (i)));
+
+        for (int i = 0; i < cvInChannelsToUse.size(); ++i)
+            usage.cv.addIfNotAlreadyThere (static_cast<int> (cvInChannelsToUse.getUnchecked (i)));
+
+        for (int i = 0; i < cvOutChannelsToUse.size(); ++i)
+            usage.cv.addIfNotAlreadyThere (static_cast<int> (cvOutChannelsToUse.getUnchecked (i)));
+
+        usage.midi.addIfNotAlreadyThere (midiBufferToUse);
+    }
+
+    bool hasSameSettings (const ProcessBufferOp& other) const
+    {
+        return node == other.node
+            && audioChannelsToUse == other.audioChannelsToUse
+            && cvInChannelsToUse == other.cvInChannelsToUse
+            && cvOutChannelsToUse == other.cvOutChannelsToUse
+            && midiBufferToUse == other.midiBufferToUse;
+    }
+
     const AudioProcessorGraph::Node::Ptr node;
     AudioProcessor* const processor;
 
@@ -301,11 +618,30 @@ private:
     HeapBlock<float*> cvInChannels;
     HeapBlock<float*> cvOutChannels;
     AudioSampleBuffer tempBuffer;
+    const uint numAudioIns;
     const uint totalAudioChans;
     const uint totalCVIns;
     const uint totalCVOuts;
     const int midiBufferToUse;
 
+    bool canSkipBlock (const bool* const silentAudioChans, const MidiBuffer& midiBuffer) const noexcept
+    {
+        if (numAudioIns == 0 || totalCVIns != 0 || ! midiBuffer.isEmpty() || ! processor->canSkipSilentBlocks())
+            return false;
+
+        for (uint i = 0; i < numAudioIns; ++i)
+            if (! silentAudioChans[audioChannelsToUse.getUnchecked (i)])
+                return false;
+
+        return true;
+    }
+
+    void markAudioChannels (bool* const silentAudioChans, const bool silent) const noexcept
+    {
+        for (uint i = 0; i < totalAudioChans; ++i)
+            silentAudioChans[audioChannelsToUse.getUnchecked (i)] = silent;
+    }
+
     CARLA_DECLARE_NON_COPY_CLASS (ProcessBufferOp)
 };
 
@@ -317,23 +653,43 @@ struct RenderingOpSequenceCalculator
 {
     RenderingOpSequenceCalculator (AudioProcessorGraph& g,
                                    const Array<AudioProcessorGraph::Node*>& nodes,
-                                   Array<void*>& renderingOps)
+                                   Array<void*>& renderingOps,
+                                   const bool usesTasks = false)
         : graph (g),
           orderedNodes (nodes),
+          keepTasksParallel (usesTasks),
+          currentStep (0),
           totalLatency (0)
     {
         audioNodeIds.add ((uint32) zeroNodeID); // first buffer is read-only zeros
         audioChannels.add (0);
+        audioDelays.add (0);
 
         cvNodeIds.add ((uint32) zeroNodeID);
         cvChannels.add (0);
 
         midiNodeIds.add ((uint32) zeroNodeID);
 
-        for (int i = 0; i < orderedNodes.size(); ++i)
+        indexConnections();
+
+        if (keepTasksParallel)
+            stepDependencies.insertMultiple (0, false, orderedNodes.size() * orderedNodes.size());
+
+        for (int i = 0, firstOp = 0; i < orderedNodes.size(); ++i)
         {
+            currentStep = i;
+
+            if (keepTasksParallel)
+                addConnectionDependencies (i);
+
             createRenderingOpsForNode (*orderedNodes.getUnchecked(i), renderingOps, i);
+            nodeRenderingOpsEnd.add (renderingOps.size());
+
+            if (keepTasksParallel)
+                addBufferDependencies (i, renderingOps, firstOp, renderingOps.size());
+
             markAnyUnusedBuffersAsFree (i);
+            firstOp = renderingOps.size();
         }
 
         graph.setLatencySamples (totalLatency);
@@ -343,12 +699,44 @@ struct RenderingOpSequenceCalculator
     int getNumCVBuffersNeeded() const noexcept       { return cvNodeIds.size(); }
     int getNumMidiBuffersNeeded() const noexcept     { return midiNodeIds.size(); }
 
+    /** For each ordered node, the index just past its last rendering op. */
+    const Array<int>& getNodeRenderingOpsEnd() const noexcept   { return nodeRenderingOpsEnd; }
+
 private:
     //==============================================================================
     AudioProcessorGraph& graph;
     const Array<AudioProcessorGraph::Node*>& orderedNodes;
     Array<uint> audioChannels, cvChannels;
     Array<uint32> audioNodeIds, cvNodeIds, midiNodeIds;
+    Array<int> audioDelays; // non-zero for delayed copies of a node output, see getSharedDelayedBuffer()
+    Array<int> nodeRenderingOpsEnd;
+
+    // Connections grouped by the step of their destination node, kept in the order of a backwards
+    // walk through the graph connections.
+    Array<int> nodeInputsStart; // [step], with an extra entry marking the end of the last one
+    Array<const AudioProcessorGraph::Connection*> nodeInputs;
+    Array<int> nodeInputSourceSteps; // -1 if the source node is not processed
+
+    // The last step reading each connected output, sorted by channel type, node and channel.
+    struct OutputLastUse
+    {
+        AudioProcessor::ChannelType channelType;
+        uint32 nodeId;
+        uint channel;
+        int step;
+        uint inputChannel;  // the input it is connected to on that step
+        bool severalInputs; // connected to more than one input of that step
+    };
+
+    Array<OutputLastUse> outputLastUses;
+
+    // When the ops are split into tasks, each task waits for the last one that used any of its
+    // buffers. A free buffer is then only handed out again if its last user is already something
+    // the current step depends on, so that re-using it never serializes independent nodes.
+    const bool keepTasksParallel;
+    int currentStep;
+    Array<int> audioLastUsers, cvLastUsers, midiLastUsers;
+    Array<bool> stepDependencies; // [step * numSteps + otherStep]
 
     enum { freeNodeID = 0xffffffff, zeroNodeID = 0xfffffffe, anonymousNodeID = 0xfffffffd };
 
@@ -375,19 +763,147 @@ private:
         }
     }
 
-    int getInputLatencyForNode (const uint32 nodeID) const
+    int getInputLatencyForStep (const int step) const
     {
         int maxLatency = 0;
 
-        for (int i = graph.getNumConnections(); --i >= 0;)
+        for (int i = nodeInputsStart.getUnchecked (step), end = nodeInputsStart.getUnchecked (step + 1); i < end; ++i)
+            maxLatency = jmax (maxLatency, getNodeDelay (nodeInputs.getUnchecked (i)->sourceNodeId));
+
+        return maxLatency;
+    }
+
+    //==============================================================================
+    void indexConnections()
+    {
+        const int numSteps = orderedNodes.size();
+        const int numConnections = graph.getNumConnections();
+
+        // node ids to steps, through a sorted list of the ids
+        SortedSet<uint32> nodeIds;
+        Array<int> nodeIdSteps;
+
+        for (int i = 0; i < numSteps; ++i)
+            nodeIds.add (orderedNodes.getUnchecked (i)->nodeId);
+
+        nodeIdSteps.insertMultiple (0, -1, nodeIds.size());
+
+        for (int i = 0; i < numSteps; ++i)
+            nodeIdSteps.set (nodeIds.indexOf (orderedNodes.getUnchecked (i)->nodeId), i);
+
+        Array<int> destSteps, sourceSteps;
+        destSteps.ensureStorageAllocated (numConnections);
+        sourceSteps.ensureStorageAllocated (numConnections);
+
+        // count the inputs of each step first, so they can be stored contiguously
+        nodeInputsStart.insertMultiple (0, 0, numSteps + 1);
+
+        for (int i = 0; i < numConnections; ++i)
         {
             const AudioProcessorGraph::Connection* const c = graph.getConnection (i);
+            const int destIndex = nodeIds.indexOf (c->destNodeId);
+            const int sourceIndex = nodeIds.indexOf (c->sourceNodeId);
+            const int destStep = destIndex >= 0 ? nodeIdSteps.getUnchecked (destIndex) : -1;
+
+            destSteps.add (destStep);
+            sourceSteps.add (sourceIndex >= 0 ? nodeIdSteps.getUnchecked (sourceIndex) : -1);
 
-            if (c->destNodeId == nodeID)
-                maxLatency = jmax (maxLatency, getNodeDelay (c->sourceNodeId));
+            if (destStep >= 0)
+                ++nodeInputsStart.getReference (destStep + 1);
         }
 
-        return maxLatency;
+        for (int i = 0; i < numSteps; ++i)
+            nodeInputsStart.getReference (i + 1) += nodeInputsStart.getUnchecked (i);
+
+        nodeInputs.insertMultiple (0, nullptr, nodeInputsStart.getLast());
+        nodeInputSourceSteps.insertMultiple (0, -1, nodeInputsStart.getLast());
+
+        Array<int> nextInput (nodeInputsStart);
+
+        for (int i = numConnections; --i >= 0;)
+        {
+            const int destStep = destSteps.getUnchecked (i);
+
+            if (destStep < 0)
+                continue;
+
+            const AudioProcessorGraph::Connection* const c = graph.getConnection (i);
+            const int index = nextInput.getReference (destStep)++;
+
+            nodeInputs.set (index, c);
+            nodeInputSourceSteps.set (index, sourceSteps.getUnchecked (i));
+
+            // connections to channels the processor does not have are never read
+            if (c->destChannelIndex < orderedNodes.getUnchecked (destStep)->getProcessor()->getTotalNumInputChannels (c->channelType))
+                addOutputUse (c->channelType, c->sourceNodeId, c->sourceChannelIndex, destStep, c->destChannelIndex);
+        }
+    }
+
+    static int compareOutput (const OutputLastUse& use, const AudioProcessor::ChannelType channelType,
+                              const uint32 nodeId, const uint channel) noexcept
+    {
+        if (use.channelType != channelType)
+            return use.channelType < channelType ? -1 : 1;
+        if (use.nodeId != nodeId)
+            return use.nodeId < nodeId ? -1 : 1;
+        if (use.channel != channel)
+            return use.channel < channel ? -1 : 1;
+
+        return 0;
+    }
+
+    /** Returns the index of the output in outputLastUses, or -1 with insertIndex set to where it would go. */
+    int findOutputLastUse (const AudioProcessor::ChannelType channelType, const uint32 nodeId,
+                           const uint channel, int& insertIndex) const noexcept
+    {
+        int start = 0;
+        int end = outputLastUses.size();
+
+        while (start < end)
+        {
+            const int halfway = (start + end) / 2;
+            const int result = compareOutput (outputLastUses.getReference (halfway), channelType, nodeId, channel);
+
+            if (result == 0)
+            {
+                insertIndex = halfway;
+                return halfway;
+            }
+
+            if (result < 0)
+                start = halfway + 1;
+            else
+                end = halfway;
+        }
+
+        insertIndex = start;
+        return -1;
+    }
+
+    void addOutputUse (const AudioProcessor::ChannelType channelType, const uint32 nodeId, const uint channel,
+                       const int step, const uint inputChannel)
+    {
+        int index;
+
+        if (findOutputLastUse (channelType, nodeId, channel, index) < 0)
+        {
+            const OutputLastUse use = { channelType, nodeId, channel, step, inputChannel, false };
+            outputLastUses.insert (index, use);
+            return;
+        }
+
+        OutputLastUse& use (outputLastUses.getReference (index));
+
+        if (step > use.step)
+        {
+            use.step = step;
+            use.inputChannel = inputChannel;
+            use.severalInputs = false;
+        }
+        else if (step == use.step && inputChannel != use.inputChannel)
+        {
+            use.severalInputs = true;
+        }
     }
 
     //==============================================================================
@@ -405,7 +921,7 @@ private:
         Array<uint> audioChannelsToUse, cvInChannelsToUse, cvOutChannelsToUse;
         int midiBufferToUse = -1;
 
-        int maxLatency = getInputLatencyForNode (node.nodeId);
+        int maxLatency = getInputLatencyForStep (ourRenderingIndex);
 
         for (uint inputChan = 0; inputChan < numAudioIns; ++inputChan)
         {
@@ -413,12 +929,12 @@ private:
             Array<uint32> sourceNodes;
             Array<uint> sourceOutputChans;
 
-            for (int i = graph.getNumConnections(); --i >= 0;)
+            for (int i = nodeInputsStart.getUnchecked (ourRenderingIndex),
+                     end = nodeInputsStart.getUnchecked (ourRenderingIndex + 1); i < end; ++i)
             {
-                const AudioProcessorGraph::Connection* const c = graph.getConnection (i);
+                const AudioProcessorGraph::Connection* const c = nodeInputs.getUnchecked (i);
 
-                if (c->destNodeId == node.nodeId
-                    && c->destChannelIndex == inputChan
+                if (c->destChannelIndex == inputChan
                     && c->channelType == AudioProcessor::ChannelTypeAudio)
                 {
                     sourceNodes.add (c->sourceNodeId);
@@ -449,11 +965,22 @@ private:
                     wassert (bufIndex >= 0);
                 }
 
-                if (inputChan < numAudioOuts
-                     && isBufferNeededLater (AudioProcessor::ChannelTypeAudio,
-                                             ourRenderingIndex,
-                                             inputChan,
-                                             srcNode, srcChan))
+                const bool neededLater = isBufferNeededLater (AudioProcessor::ChannelTypeAudio,
+                                                              ourRenderingIndex,
+                                                              inputChan,
+                                                              srcNode, srcChan);
+
+                const int nodeDelay = getNodeDelay (srcNode);
+
+                if (nodeDelay < maxLatency)
+                {
+                    if (neededLater)
+                        bufIndex = getSharedDelayedBuffer (bufIndex, srcNode, srcChan, maxLatency - nodeDelay, renderingOps);
+                    else
+                        bufIndex = delayUnusedBuffer (bufIndex, srcNode, srcChan, maxLatency - nodeDelay, renderingOps);
+                }
+
+                if (inputChan < numAudioOuts && neededLater)
                 {
                     // can't mess up this channel because it's needed later by another node, so we
                     // need to use a copy of it..
@@ -463,11 +990,6 @@ private:
 
                     bufIndex = newFreeBuffer;
                 }
-
-                const int nodeDelay = getNodeDelay (srcNode);
-
-                if (nodeDelay < maxLatency)
-                    renderingOps.add (new DelayChannelOp (bufIndex, maxLatency - nodeDelay, false));
             }
             else
             {
@@ -495,7 +1017,10 @@ private:
 
                         const int nodeDelay = getNodeDelay (sourceNodes.getUnchecked (i));
                         if (nodeDelay < maxLatency)
-                            renderingOps.add (new DelayChannelOp (sourceBufIndex, maxLatency - nodeDelay, false));
+                            bufIndex = delayUnusedBuffer (sourceBufIndex,
+                                                          sourceNodes.getUnchecked(i),
+                                                          sourceOutputChans.getUnchecked(i),
+                                                          maxLatency - nodeDelay, renderingOps);
 
                         break;
                     }
@@ -513,21 +1038,27 @@ private:
                     const int srcIndex = getBufferContaining (AudioProcessor::ChannelTypeAudio,
                                                               sourceNodes.getUnchecked (0),
                                                               sourceOutputChans.getUnchecked (0));
+                    const int nodeDelay = getNodeDelay (sourceNodes.getFirst());
+
                     if (srcIndex < 0)
                     {
                         // if not found, this is probably a feedback loop
                         renderingOps.add (new ClearChannelOp (bufIndex, false));
                     }
+                    else if (nodeDelay < maxLatency)
+                    {
+                        const int delayedIndex = getSharedDelayedBuffer (srcIndex,
+                                                                         sourceNodes.getFirst(),
+                                                                         sourceOutputChans.getFirst(),
+                                                                         maxLatency - nodeDelay, renderingOps);
+                        renderingOps.add (new CopyChannelOp (delayedIndex, bufIndex, false));
+                    }
                     else
                     {
                         renderingOps.add (new CopyChannelOp (srcIndex, bufIndex, false));
                     }
 
                     reusableInputIndex = 0;
-                    const int nodeDelay = getNodeDelay (sourceNodes.getFirst());
-
-                    if (nodeDelay < maxLatency)
-                        renderingOps.add (new DelayChannelOp (bufIndex, maxLatency - nodeDelay, false));
                 }
 
                 for (int j = 0; j < sourceNodes.size(); ++j)
@@ -548,14 +1079,17 @@ private:
                                                            sourceNodes.getUnchecked(j),
                                                            sourceOutputChans.getUnchecked(j)))
                                 {
-                                    renderingOps.add (new DelayChannelOp (srcIndex, maxLatency - nodeDelay, false));
+                                    srcIndex = delayUnusedBuffer (srcIndex,
+                                                                  sourceNodes.getUnchecked(j),
+                                                                  sourceOutputChans.getUnchecked(j),
+                                                                  maxLatency - nodeDelay, renderingOps);
                                 }
                                 else // buffer is reused elsewhere, can't be delayed
                                 {
-                                    const int bufferToDelay = getFreeBuffer (AudioProcessor::ChannelTypeAudio);
-                                    renderingOps.add (new CopyChannelOp (srcIndex, bufferToDelay, false));
-                                    renderingOps.add (new DelayChannelOp (bufferToDelay, maxLatency - nodeDelay, false));
-                                    srcIndex = bufferToDelay;
+                                    srcIndex = getSharedDelayedBuffer (srcIndex,
+                                                                       sourceNodes.getUnchecked(j),
+                                                                       sourceOutputChans.getUnchecked(j),
+                                                                       maxLatency - nodeDelay, renderingOps);
                                 }
                             }
 
@@ -586,12 +1120,12 @@ private:
             Array<uint32> sourceNodes;
             Array<uint> sourceOutputChans;
 
-            for (int i = graph.getNumConnections(); --i >= 0;)
+            for (int i = nodeInputsStart.getUnchecked (ourRenderingIndex),
+                     end = nodeInputsStart.getUnchecked (ourRenderingIndex + 1); i < end; ++i)
             {
-                const AudioProcessorGraph::Connection* const c = graph.getConnection (i);
+                const AudioProcessorGraph::Connection* const c = nodeInputs.getUnchecked (i);
 
-                if (c->destNodeId == node.nodeId
-                    && c->destChannelIndex == inputChan
+                if (c->destChannelIndex == inputChan
                     && c->channelType == AudioProcessor::ChannelTypeCV)
                 {
                     sourceNodes.add (c->sourceNodeId);
@@ -631,7 +1165,7 @@ private:
                 const int nodeDelay = getNodeDelay (srcNode);
 
                 if (nodeDelay < maxLatency)
-                    renderingOps.add (new DelayChannelOp (bufIndex, maxLatency - nodeDelay, true));
+                    renderingOps.add (new DelayChannelOp (bufIndex, maxLatency - nodeDelay, graph.getBlockSize(), true));
             }
             else
             {
@@ -657,7 +1191,7 @@ private:
                     const int nodeDelay = getNodeDelay (sourceNodes.getFirst());
 
                     if (nodeDelay < maxLatency)
-                        renderingOps.add (new DelayChannelOp (bufIndex, maxLatency - nodeDelay, true));
+                        renderingOps.add (new DelayChannelOp (bufIndex, maxLatency - nodeDelay, graph.getBlockSize(), true));
                 }
 
                 for (int j = 1; j < sourceNodes.size(); ++j)
@@ -673,7 +1207,7 @@ private:
                         {
                             const int bufferToDelay = getFreeBuffer (AudioProcessor::ChannelTypeCV);
                             renderingOps.add (new CopyChannelOp (srcIndex, bufferToDelay, true));
-                            renderingOps.add (new DelayChannelOp (bufferToDelay, maxLatency - nodeDelay, true));
+                            renderingOps.add (new DelayChannelOp (bufferToDelay, maxLatency - nodeDelay, graph.getBlockSize(), true));
                             srcIndex = bufferToDelay;
                         }
 
@@ -698,11 +1232,12 @@ private:
         // Now the same thing for midi..
         Array<uint32> midiSourceNodes;
 
-        for (int i = graph.getNumConnections(); --i >= 0;)
+        for (int i = nodeInputsStart.getUnchecked (ourRenderingIndex),
+                 end = nodeInputsStart.getUnchecked (ourRenderingIndex + 1); i < end; ++i)
         {
-            const AudioProcessorGraph::Connection* const c = graph.getConnection (i);
+            const AudioProcessorGraph::Connection* const c = nodeInputs.getUnchecked (i);
 
-            if (c->destNodeId == node.nodeId && c->channelType == AudioProcessor::ChannelTypeMIDI)
+            if (c->channelType == AudioProcessor::ChannelTypeMIDI)
                 midiSourceNodes.add (c->sourceNodeId);
         }
 
@@ -804,6 +1339,7 @@ private:
 
         renderingOps.add (new ProcessBufferOp (&node,
                                                audioChannelsToUse,
+                                               numAudioIns,
                                                totalAudioChans,
                                                cvInChannelsToUse,
                                                cvOutChannelsToUse,
@@ -817,11 +1353,17 @@ private:
         {
         case AudioProcessor::ChannelTypeAudio:
             for (int i = 1; i < audioNodeIds.size(); ++i)
-                if (audioNodeIds.getUnchecked(i) == freeNodeID)
+            {
+                if (audioNodeIds.getUnchecked(i) == freeNodeID && canReuseBuffer (audioLastUsers, i))
+                {
+                    audioDelays.set (i, 0);
                     return i;
+                }
+            }
 
             audioNodeIds.add ((uint32) freeNodeID);
             audioChannels.add (0);
+            audioDelays.add (0);
             return audioNodeIds.size() - 1;
 
         case AudioProcessor::ChannelTypeCV:
@@ -835,7 +1377,7 @@ private:
 
         case AudioProcessor::ChannelTypeMIDI:
             for (int i = 1; i < midiNodeIds.size(); ++i)
-                if (midiNodeIds.getUnchecked(i) == freeNodeID)
+                if (midiNodeIds.getUnchecked(i) == freeNodeID && canReuseBuffer (midiLastUsers, i))
                     return i;
 
             midiNodeIds.add ((uint32) freeNodeID);
@@ -845,6 +1387,128 @@ private:
         return -1;
     }
 
+    bool canReuseBuffer (const Array<int>& lastUsers, const int bufIndex) const noexcept
+    {
+        if (! keepTasksParallel)
+            return true;
+
+        if (bufIndex >= lastUsers.size())
+            return true;
+
+        const int lastUser = lastUsers.getUnchecked (bufIndex);
+        return lastUser < 0 || lastUser == currentStep || dependsOn (currentStep, lastUser);
+    }
+
+    bool dependsOn (const int step, const int otherStep) const noexcept
+    {
+        return stepDependencies.getUnchecked (step * orderedNodes.size() + otherStep);
+    }
+
+    void addDependency (const int step, const int otherStep)
+    {
+        const int numSteps = orderedNodes.size();
+
+        if (dependsOn (step, otherStep))
+            return;
+
+        stepDependencies.set (step * numSteps + otherStep, true);
+
+        for (int i = 0; i < otherStep; ++i)
+            if (dependsOn (otherStep, i))
+                stepDependencies.set (step * numSteps + i, true);
+    }
+
+    /** Adds the earlier steps that feed this one, known before its ops are created. */
+    void addConnectionDependencies (const int step)
+    {
+        for (int i = nodeInputsStart.getUnchecked (step), end = nodeInputsStart.getUnchecked (step + 1); i < end; ++i)
+        {
+            const int sourceStep = nodeInputSourceSteps.getUnchecked (i);
+
+            if (sourceStep >= 0 && sourceStep < step)
+                addDependency (step, sourceStep);
+        }
+    }
+
+    /** Adds the dependencies the task list will create from the buffers used by a step's ops. */
+    void addBufferDependencies (const int step, const Array<void*>& renderingOps, const int firstOp, const int endOp)
+    {
+        RenderingBufferUsage usage;
+
+        for (int i = firstOp; i < endOp; ++i)
+            static_cast<const AudioGraphRenderingOpBase*> (renderingOps.getUnchecked (i))->addUsedBuffers (usage);
+
+        // CV buffers are never re-used, but they still link tasks together
+        updateLastUsers (step, usage.audio, audioLastUsers);
+        updateLastUsers (step, usage.cv, cvLastUsers);
+        updateLastUsers (step, usage.midi, midiLastUsers);
+    }
+
+    void updateLastUsers (const int step, const Array<int>& buffers, Array<int>& lastUsers)
+    {
+        for (int i = 0; i < buffers.size(); ++i)
+        {
+            const int bufIndex = buffers.getUnchecked (i);
+
+            if (bufIndex >= lastUsers.size())
+                lastUsers.insertMultiple (lastUsers.size(), -1, bufIndex + 1 - lastUsers.size());
+
+            const int lastUser = lastUsers.getUnchecked (bufIndex);
+
+            if (lastUser >= 0 && lastUser != step)
+                addDependency (step, lastUser);
+
+            lastUsers.set (bufIndex, step);
+        }
+    }
+
+    int getDelayedBufferContaining (const uint32 nodeId, const uint outputChannel, const int delay) const noexcept
+    {
+        for (int i = audioNodeIds.size(); --i >= 0;)
+            if (audioNodeIds.getUnchecked(i) == nodeId && audioChannels.getUnchecked(i) == outputChannel
+                 && audioDelays.getUnchecked(i) == delay)
+                return i;
+
+        return -1;
+    }
+
+    /** Returns a buffer with a node output delayed by 'delay' samples, leaving 'srcIndex' untouched.
+        The delayed copy is kept for as long as the original output is needed, so that nodes which
+        need the same compensation for it share a single delay line.
+    */
+    int getSharedDelayedBuffer (const int srcIndex, const uint32 nodeId, const uint outputChannel,
+                                const int delay, Array<void*>& renderingOps)
+    {
+        int bufIndex = getDelayedBufferContaining (nodeId, outputChannel, delay);
+
+        if (bufIndex >= 0)
+            return bufIndex;
+
+        bufIndex = getFreeBuffer (AudioProcessor::ChannelTypeAudio);
+
+        renderingOps.add (new CopyChannelOp (srcIndex, bufIndex, false));
+        renderingOps.add (new DelayChannelOp (bufIndex, delay, graph.getBlockSize(), false));
+
+        markBufferAsContaining (AudioProcessor::ChannelTypeAudio, bufIndex, nodeId, static_cast<int> (outputChannel));
+        audioDelays.set (bufIndex, delay);
+        return bufIndex;
+    }
+
+    /** Delays a buffer that is not needed by any later node in place,
+        unless a shared delayed copy of it already exists.
+    */
+    int delayUnusedBuffer (const int bufIndex, const uint32 nodeId, const uint outputChannel,
+                           const int delay, Array<void*>& renderingOps)
+    {
+        const int delayedIndex = getDelayedBufferContaining (nodeId, outputChannel, delay);
+
+        if (delayedIndex >= 0)
+            return delayedIndex;
+
+        renderingOps.add (new DelayChannelOp (bufIndex, delay, graph.getBlockSize(), false));
+        return bufIndex;
+    }
+
     int getReadOnlyEmptyBuffer() const noexcept
     {
         return 0;
@@ -858,7 +1522,8 @@ private:
         {
         case AudioProcessor::ChannelTypeAudio:
             for (int i = audioNodeIds.size(); --i >= 0;)
-                if (audioNodeIds.getUnchecked(i) == nodeId && audioChannels.getUnchecked(i) == outputChannel)
+                if (audioNodeIds.getUnchecked(i) == nodeId && audioChannels.getUnchecked(i) == outputChannel
+                     && audioDelays.getUnchecked(i) == 0)
                     return i;
             break;
 
@@ -909,27 +1574,25 @@ private:
     }
 
     bool isBufferNeededLater (const AudioProcessor::ChannelType channelType,
-                              int stepIndexToSearchFrom,
-                              uint inputChannelOfIndexToIgnore,
+                              const int stepIndexToSearchFrom,
+                              const uint inputChannelOfIndexToIgnore,
                               const uint32 nodeId,
-                              const uint outputChanIndex) const
+                              const uint outputChanIndex) const noexcept
     {
-        while (stepIndexToSearchFrom < orderedNodes.size())
-        {
-            const AudioProcessorGraph::Node* const node = (const AudioProcessorGraph::Node*) orderedNodes.getUnchecked (stepIndexToSearchFrom);
+        int index;
 
-            for (uint i = 0; i < node->getProcessor()->getTotalNumInputChannels(channelType); ++i)
-                if (i != inputChannelOfIndexToIgnore
-                        && graph.getConnectionBetween (channelType,
-                                                       nodeId, outputChanIndex,
-                                                       node->nodeId, i) != nullptr)
-                    return true;
+        if (findOutputLastUse (channelType, nodeId, outputChanIndex, index) < 0)
+            return false;
 
-            inputChannelOfIndexToIgnore = (uint)-1;
-            ++stepIndexToSearchFrom;
-        }
+        const OutputLastUse& use (outputLastUses.getReference (index));
 
-        return false;
+        if (use.step != stepIndexToSearchFrom)
+            return use.step > stepIndexToSearchFrom;
+
+        // only the given input of the first step is ignored
+        return inputChannelOfIndexToIgnore == (uint)-1
+            || use.severalInputs
+            || use.inputChannel != inputChannelOfIndexToIgnore;
     }
 
     void markBufferAsContaining (const AudioProcessor::ChannelType channelType,
@@ -941,6 +1604,7 @@ private:
             CARLA_SAFE_ASSERT_BREAK (bufferNum >= 0 && bufferNum < audioNodeIds.size());
             audioNodeIds.set (bufferNum, nodeId);
             audioChannels.set (bufferNum, outputIndex);
+            audioDelays.set (bufferNum, 0);
             break;
 
         case AudioProcessor::ChannelTypeCV:
@@ -960,133 +1624,497 @@ private:
 };
 
 //==============================================================================
-// Holds a fast lookup table for checking which nodes are inputs to others.
-class ConnectionLookupTable
+// The source nodes of each graph node, by their index in the graph, for walking through the graph in linear time.
+class NodeInputsTable
 {
 public:
-    explicit ConnectionLookupTable (const OwnedArray<AudioProcessorGraph::Connection>& connections)
+    NodeInputsTable (const ReferenceCountedArray<AudioProcessorGraph::Node>& nodes,
+                     const OwnedArray<AudioProcessorGraph::Connection>& connections)
     {
+        const int numNodes = nodes.size();
+
+        for (int i = 0; i < numNodes; ++i)
+            nodeIds.add (nodes.getUnchecked (i)->nodeId);
+
+        nodeIndexes.insertMultiple (0, -1, nodeIds.size());
+
+        for (int i = 0; i < numNodes; ++i)
+            nodeIndexes.set (nodeIds.indexOf (nodes.getUnchecked (i)->nodeId), i);
+
+        // count the inputs of each node first, so they can be stored contiguously
+        inputsStart.insertMultiple (0, 0, numNodes + 1);
+
         for (int i = 0; i < static_cast<int>(connections.size()); ++i)
         {
-            const AudioProcessorGraph::Connection* const c = connections.getUnchecked(i);
+            const AudioProcessorGraph::Connection* const c = connections.getUnchecked (i);
+            const int destIndex = getNodeIndex (c->destNodeId);
+
+            if (destIndex >= 0 && getNodeIndex (c->sourceNodeId) >= 0)
+                ++inputsStart.getReference (destIndex + 1);
+        }
 
-            int index;
-            Entry* entry = findEntry (c->destNodeId, index);
+        for (int i = 0; i < numNodes; ++i)
+            inputsStart.getReference (i + 1) += inputsStart.getUnchecked (i);
 
-            if (entry == nullptr)
-            {
-                entry = new Entry (c->destNodeId);
-                entries.insert (index, entry);
-            }
+        inputs.insertMultiple (0, -1, inputsStart.getLast());
 
-            entry->srcNodes.add (c->sourceNodeId);
+        Array<int> nextInput (inputsStart);
+
+        for (int i = 0; i < static_cast<int>(connections.size()); ++i)
+        {
+            const AudioProcessorGraph::Connection* const c = connections.getUnchecked (i);
+            const int destIndex = getNodeIndex (c->destNodeId);
+            const int sourceIndex = getNodeIndex (c->sourceNodeId);
+
+            if (destIndex >= 0 && sourceIndex >= 0)
+                inputs.set (nextInput.getReference (destIndex)++, sourceIndex);
         }
     }
 
-    bool isAnInputTo (const uint32 possibleInputId,
-                      const uint32 possibleDestinationId) const noexcept
+    /** Returns the index of a node in the graph, or -1 if it doesn't exist. */
+    int getNodeIndex (const uint32 nodeId) const noexcept
     {
-        return isAnInputToRecursive (possibleInputId, possibleDestinationId, entries.size());
+        const int index = nodeIds.indexOf (nodeId);
+        return index >= 0 ? nodeIndexes.getUnchecked (index) : -1;
     }
 
+    int getInputsStart (const int nodeIndex) const noexcept     { return inputsStart.getUnchecked (nodeIndex); }
+    int getInputsEnd (const int nodeIndex) const noexcept       { return inputsStart.getUnchecked (nodeIndex + 1); }
+    int getInput (const int index) const noexcept               { return inputs.getUnchecked (index); }
+
 private:
-    //==============================================================================
-    struct Entry
+    SortedSet<uint32> nodeIds;
+    Array<int> nodeIndexes; // graph node index, for each entry in nodeIds
+    Array<int> inputsStart;
+    Array<int> inputs;
+
+    CARLA_DECLARE_NON_COPY_CLASS (NodeInputsTable)
+};
+
+//==============================================================================
+struct ConnectionSorter
+{
+    static int compareElements (const AudioProcessorGraph::Connection* const first,
+                                const AudioProcessorGraph::Connection* const second) noexcept
     {
-        explicit Entry (const uint32 destNodeId_) noexcept : destNodeId (destNodeId_) {}
+        if (first->sourceNodeId < second->sourceNodeId)                return -1;
+        if (first->sourceNodeId > second->sourceNodeId)                return 1;
+        if (first->destNodeId < second->destNodeId)                    return -1;
+        if (first->destNodeId > second->destNodeId)                    return 1;
+        if (first->sourceChannelIndex < second->sourceChannelIndex)    return -1;
+        if (first->sourceChannelIndex > second->sourceChannelIndex)    return 1;
+        if (first->destChannelIndex < second->destChannelIndex)        return -1;
+        if (first->destChannelIndex > second->destChannelIndex)        return 1;
+
+        return 0;
+    }
+};
 
-        const uint32 destNodeId;
-        SortedSet<uint32> srcNodes;
 
-        CARLA_DECLARE_NON_COPY_CLASS (Entry)
-    };
+//==============================================================================
+/** The rendering ops of a single node, plus the nodes that have to wait for it. */
+struct RenderingTask
+{
+    RenderingTask (const int firstOpIndex, const int endOpIndex) noexcept
+        : firstOp (firstOpIndex), endOp (endOpIndex),
+          numDependencies (0), pendingDependencies (0), started (false) {}
+
+    const int firstOp, endOp;
+    Array<int> dependants;
+    int numDependencies;
+    volatile int pendingDependencies;
+    bool started;
 
-    OwnedArray<Entry> entries;
+    CARLA_DECLARE_NON_COPY_CLASS (RenderingTask)
+};
+
+//==============================================================================
+/** Turns a calculated rendering sequence into a dependency graph that can be
+    processed by several threads at once.
 
-    bool isAnInputToRecursive (const uint32 possibleInputId,
-                               const uint32 possibleDestinationId,
-                               int recursionCheck) const noexcept
+    Two nodes depend on each other if their ops touch a common shared buffer, in
+    which case they keep their original order. Nodes become ready once all of
+    their dependencies are done, and get published into a lock-free queue that
+    every participating thread takes work from.
+*/
+struct RenderingTaskList
+{
+    RenderingTaskList (const Array<void*>& ops,
+                       const Array<int>& nodeRenderingOpsEnd,
+                       const int numAudioBuffers, const int numCVBuffers, const int numMidiBuffers)
+        : readyWriteIndex (0),
+          readyReadIndex (0),
+          numCompleted (0),
+          numSamples (0),
+          numStartableTasks (0)
     {
-        int index;
+        Array<int> lastAudioUser, lastCVUser, lastMidiUser;
+        lastAudioUser.insertMultiple (0, -1, numAudioBuffers);
+        lastCVUser.insertMultiple (0, -1, numCVBuffers);
+        lastMidiUser.insertMultiple (0, -1, numMidiBuffers);
 
-        if (const Entry* const entry = findEntry (possibleDestinationId, index))
+        for (int i = 0, firstOp = 0; i < nodeRenderingOpsEnd.size(); ++i)
         {
-            const SortedSet<uint32>& srcNodes = entry->srcNodes;
+            const int endOp = nodeRenderingOpsEnd.getUnchecked (i);
 
-            if (srcNodes.contains (possibleInputId))
-                return true;
+            RenderingBufferUsage usage;
+            for (int j = firstOp; j < endOp; ++j)
+                static_cast<const AudioGraphRenderingOpBase*> (ops.getUnchecked (j))->addUsedBuffers (usage);
 
-            if (--recursionCheck >= 0)
-            {
-                for (int i = 0; i < srcNodes.size(); ++i)
-                    if (isAnInputToRecursive (possibleInputId, srcNodes.getUnchecked(i), recursionCheck))
-                        return true;
-            }
+            tasks.add (new RenderingTask (firstOp, endOp));
+
+            addDependencies (i, usage.audio, lastAudioUser);
+            addDependencies (i, usage.cv, lastCVUser);
+            addDependencies (i, usage.midi, lastMidiUser);
+
+            if (tasks.getUnchecked (i)->numDependencies == 0)
+                rootTasks.add (i);
+
+            if (endOp > firstOp && static_cast<const AudioGraphRenderingOpBase*> (ops.getUnchecked (endOp - 1))->canStart())
+                ++numStartableTasks;
+
+            firstOp = endOp;
         }
 
-        return false;
+        readyQueue.malloc (jmax<size_t> (1, tasks.size()));
     }
 
-    Entry* findEntry (const uint32 destNodeId, int& insertIndex) const noexcept
+    int getNumTasks() const noexcept            { return static_cast<int> (tasks.size()); }
+    int getNumStartableTasks() const noexcept   { return numStartableTasks; }
+
+    /** Resets the dependency counters, must be called before each processing cycle. */
+    void prepare (const int newNumSamples) noexcept
     {
-        Entry* result = nullptr;
+        numSamples = newNumSamples;
 
-        int start = 0;
-        int end = entries.size();
+        for (int i = static_cast<int> (tasks.size()); --i >= 0;)
+        {
+            RenderingTask* const task = tasks.getUnchecked (i);
+            task->pendingDependencies = task->numDependencies;
+            readyQueue[i] = -1;
+        }
+
+        readyReadIndex = readyWriteIndex = numCompleted = 0;
 
-        for (;;)
+        for (int i = 0; i < rootTasks.size(); ++i)
+            pushReadyTask (rootTasks.getUnchecked (i));
+    }
+
+    /** Processes ready tasks until all of them are done. Called from every participating thread. */
+    void perform (const Array<void*>& ops,
+                  AudioSampleBuffer& sharedAudioBufferChans,
+                  AudioSampleBuffer& sharedCVBufferChans,
+                  const OwnedArray<MidiBuffer>& sharedMidiBuffers,
+                  bool* const silentAudioChans) noexcept
+    {
+        const int numTasks = static_cast<int> (tasks.size());
+        volatile int* const queue = readyQueue.getData();
+
+        while (numCompleted < numTasks)
         {
-            if (start >= end)
+            const int slot = readyReadIndex;
+
+            if (slot >= readyWriteIndex)
+                continue;
+            if (! __sync_bool_compare_and_swap (&readyReadIndex, slot, slot + 1))
+                continue;
+
+            // the slot is reserved before the task index is written, wait for it
+            int taskIndex;
+            while ((taskIndex = queue[slot]) < 0) {}
+
+            __sync_synchronize();
+
+            const RenderingTask* const task = tasks.getUnchecked (taskIndex);
+
+            for (int i = task->firstOp; i < task->endOp; ++i)
+                static_cast<AudioGraphRenderingOpBase*> (ops.getUnchecked (i))->perform (sharedAudioBufferChans,
+                                                                                        sharedCVBufferChans,
+                                                                                        sharedMidiBuffers,
+                                                                                        silentAudioChans,
+                                                                                        numSamples);
+
+            for (int i = 0; i < task->dependants.size(); ++i)
             {
-                break;
+                const int dependant = task->dependants.getUnchecked (i);
+
+                if (__sync_sub_and_fetch (&tasks.getUnchecked (dependant)->pendingDependencies, 1) == 0)
+                    pushReadyTask (dependant);
             }
-            else if (destNodeId == entries.getUnchecked (start)->destNodeId)
+
+            __sync_add_and_fetch (&numCompleted, 1);
+        }
+    }
+
+    /** Processes all tasks from the calling thread alone, one stage of ready tasks at a time.
+
+        Within a stage every node that can start in the background (such as a plugin
+        bridge) is started first, the others are processed while those are busy, and
+        only then are the started ones waited on.
+    */
+    void performInStages (const Array<void*>& ops,
+                          AudioSampleBuffer& sharedAudioBufferChans,
+                          AudioSampleBuffer& sharedCVBufferChans,
+                          const OwnedArray<MidiBuffer>& sharedMidiBuffers,
+                          bool* const silentAudioChans) noexcept
+    {
+        const int* const queue = readyQueue.getData();
+
+        for (int stageStart = 0; stageStart < readyWriteIndex;)
+        {
+            const int stageEnd = readyWriteIndex;
+
+            for (int slot = stageStart; slot < stageEnd; ++slot)
             {
-                result = entries.getUnchecked (start);
-                break;
+                RenderingTask* const task = tasks.getUnchecked (queue[slot]);
+                task->started = false;
+
+                if (task->endOp <= task->firstOp)
+                    continue;
+
+                for (int i = task->firstOp; i < task->endOp - 1; ++i)
+                    getOp (ops, i)->perform (sharedAudioBufferChans, sharedCVBufferChans, sharedMidiBuffers,
+                                             silentAudioChans, numSamples);
+
+                task->started = getOp (ops, task->endOp - 1)->start (sharedAudioBufferChans, sharedCVBufferChans,
+                                                                     sharedMidiBuffers, silentAudioChans, numSamples);
             }
-            else
+
+            for (int pass = 0; pass < 2; ++pass)
             {
-                const int halfway = (start + end) / 2;
+                // first the ones that were not started, then collect the others
+                for (int slot = stageStart; slot < stageEnd; ++slot)
+                {
+                    const RenderingTask* const task = tasks.getUnchecked (queue[slot]);
 
-                if (halfway == start)
+                    if (task->endOp > task->firstOp && task->started == (pass == 1))
+                        getOp (ops, task->endOp - 1)->perform (sharedAudioBufferChans, sharedCVBufferChans,
+                                                               sharedMidiBuffers, silentAudioChans, numSamples);
+                }
+            }
+
+            for (int slot = stageStart; slot < stageEnd; ++slot)
+            {
+                const RenderingTask* const task = tasks.getUnchecked (queue[slot]);
+
+                for (int i = 0; i < task->dependants.size(); ++i)
                 {
-                    if (destNodeId >= entries.getUnchecked (halfway)->destNodeId)
-                        ++start;
+                    const int dependant = task->dependants.getUnchecked (i);
 
-                    break;
+                    if (--tasks.getUnchecked (dependant)->pendingDependencies == 0)
+                        pushReadyTask (dependant);
                 }
-                else if (destNodeId >= entries.getUnchecked (halfway)->destNodeId)
-                    start = halfway;
-                else
-                    end = halfway;
             }
+
+            stageStart = stageEnd;
         }
+    }
 
-        insertIndex = start;
-        return result;
+private:
+    OwnedArray<RenderingTask> tasks;
+    Array<int> rootTasks;
+    HeapBlock<int> readyQueue;
+    volatile int readyWriteIndex, readyReadIndex, numCompleted;
+    int numSamples;
+    int numStartableTasks;
+
+    static AudioGraphRenderingOpBase* getOp (const Array<void*>& ops, const int index) noexcept
+    {
+        return static_cast<AudioGraphRenderingOpBase*> (ops.getUnchecked (index));
     }
 
-    CARLA_DECLARE_NON_COPY_CLASS (ConnectionLookupTable)
+    void addDependencies (const int taskIndex, const Array<int>& buffersUsed, Array<int>& lastUsers)
+    {
+        RenderingTask* const task = tasks.getUnchecked (taskIndex);
+
+        for (int i = 0; i < buffersUsed.size(); ++i)
+        {
+            const int buffer = buffersUsed.getUnchecked (i);
+            CARLA_SAFE_ASSERT_CONTINUE (buffer >= 0 && buffer < lastUsers.size());
+
+            const int lastUser = lastUsers.getUnchecked (buffer);
+            lastUsers.set (buffer, taskIndex);
+
+            if (lastUser < 0 || lastUser == taskIndex)
+                continue;
+
+            if (tasks.getUnchecked (lastUser)->dependants.addIfNotAlreadyThere (taskIndex))
+                ++task->numDependencies;
+        }
+    }
+
+    void pushReadyTask (const int taskIndex) noexcept
+    {
+        const int slot = __sync_fetch_and_add (&readyWriteIndex, 1);
+        static_cast<volatile int*> (readyQueue.getData())[slot] = taskIndex;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS (RenderingTaskList)
 };
 
 //==============================================================================
-struct ConnectionSorter
+/** Everything the audio thread needs to render the graph.
+
+    A new sequence is built and allocated completely off the audio thread, so
+    that only a pointer swap has to happen while holding the callback lock.
+*/
+struct RenderingSequence
 {
-    static int compareElements (const AudioProcessorGraph::Connection* const first,
-                                const AudioProcessorGraph::Connection* const second) noexcept
+    RenderingSequence() noexcept {}
+
+    ~RenderingSequence()
     {
-        if (first->sourceNodeId < second->sourceNodeId)                return -1;
-        if (first->sourceNodeId > second->sourceNodeId)                return 1;
-        if (first->destNodeId < second->destNodeId)                    return -1;
-        if (first->destNodeId > second->destNodeId)                    return 1;
-        if (first->sourceChannelIndex < second->sourceChannelIndex)    return -1;
-        if (first->sourceChannelIndex > second->sourceChannelIndex)    return 1;
-        if (first->destChannelIndex < second->destChannelIndex)        return -1;
-        if (first->destChannelIndex > second->destChannelIndex)        return 1;
+        for (int i = ops.size(); --i >= 0;)
+            delete static_cast<AudioGraphRenderingOpBase*> (ops.getUnchecked(i));
+    }
 
-        return 0;
+    void perform (const int numSamples) noexcept
+    {
+        if (tasks != nullptr && tasks->getNumStartableTasks() != 0)
+        {
+            tasks->prepare (numSamples);
+            tasks->performInStages (ops, audioBuffers, cvBuffers, midiBuffers, silentAudioChans);
+            return;
+        }
+
+        for (int i = 0; i < ops.size(); ++i)
+            static_cast<AudioGraphRenderingOpBase*> (ops.getUnchecked(i))->perform (audioBuffers, cvBuffers,
+                                                                                   midiBuffers, silentAudioChans,
+                                                                                   numSamples);
+    }
+
+    /** Copies the delay amounts of 'newOps' into the delay ops of this sequence, if both only
+        differ in their delays. Delay ops that 'newOps' no longer has are kept with a 0 delay.
+        Returns false without changing anything otherwise.
+    */
+    bool updateDelaysFrom (const Array<void*>& newOps)
+    {
+        Array<int> newDelays; // -1 for ops that are not delays
+        int j = 0;
+
+        for (int i = 0; i < ops.size(); ++i)
+        {
+            const AudioGraphRenderingOpBase* const op = static_cast<AudioGraphRenderingOpBase*> (ops.getUnchecked (i));
+            const AudioGraphRenderingOpBase* const newOp = j < newOps.size()
+                                                         ? static_cast<AudioGraphRenderingOpBase*> (newOps.getUnchecked (j))
+                                                         : nullptr;
+
+            if (const DelayChannelOp* const delayOp = dynamic_cast<const DelayChannelOp*> (op))
+            {
+                int newDelay = 0;
+
+                if (newOp != nullptr && delayOp->isSameOpAs (*newOp))
+                {
+                    newDelay = static_cast<const DelayChannelOp*> (newOp)->getDelay();
+                    ++j;
+                }
+
+                if (! delayOp->canSetDelay (newDelay))
+                    return false;
+
+                newDelays.add (newDelay);
+                continue;
+            }
+
+            if (newOp == nullptr || ! op->isSameOpAs (*newOp))
+                return false;
+
+            newDelays.add (-1);
+            ++j;
+        }
+
+        if (j != newOps.size())
+            return false;
+
+        for (int i = 0; i < ops.size(); ++i)
+            if (newDelays.getUnchecked (i) >= 0)
+                static_cast<DelayChannelOp*> (ops.getUnchecked (i))->setDelay (newDelays.getUnchecked (i));
+
+        return true;
+    }
+
+    /** Takes the ops of 'newSequence' where they differ from the current ones, keeping the
+        unchanged ops at the start and end of the sequence together with their state.
+        The current buffers and silent flags are kept as well, the replaced ops are handed over
+        to 'newSequence' so they can be deleted outside of the callback lock.
+        Returns false without changing anything if the current buffers are not enough.
+    */
+    bool patchFrom (RenderingSequence& newSequence,
+                    const int numAudioBuffers, const int numCVBuffers, const int numMidiBuffers) noexcept
+    {
+        if (numAudioBuffers > static_cast<int>(audioBuffers.getNumChannels())
+            || numCVBuffers > static_cast<int>(cvBuffers.getNumChannels())
+            || numMidiBuffers > static_cast<int>(midiBuffers.size()))
+            return false;
+
+        Array<void*>& newOps (newSequence.ops);
+        const int numOps = ops.size();
+        const int numNewOps = newOps.size();
+
+        int numSameFirst = 0;
+        while (numSameFirst < numOps && numSameFirst < numNewOps
+               && isSameOp (ops.getUnchecked (numSameFirst), newOps.getUnchecked (numSameFirst)))
+            ++numSameFirst;
+
+        int numSameLast = 0;
+        while (numSameLast < numOps - numSameFirst && numSameLast < numNewOps - numSameFirst
+               && isSameOp (ops.getUnchecked (numOps - 1 - numSameLast), newOps.getUnchecked (numNewOps - 1 - numSameLast)))
+            ++numSameLast;
+
+        // put the current ops in place of their copies, which then get deleted with 'newSequence'
+        for (int i = 0; i < numSameFirst; ++i)
+            swapOps (ops, i, newOps, i);
+
+        for (int i = 1; i <= numSameLast; ++i)
+            swapOps (ops, numOps - i, newOps, numNewOps - i);
+
+        ops.swapWith (newOps);
+        tasks.swapWith (newSequence.tasks);
+        return true;
     }
+
+    static void performTasksCallback (void* const ptr, uint)
+    {
+        RenderingSequence* const sequence = static_cast<RenderingSequence*> (ptr);
+
+        sequence->tasks->perform (sequence->ops, sequence->audioBuffers, sequence->cvBuffers, sequence->midiBuffers,
+                                  sequence->silentAudioChans);
+    }
+
+    Array<void*> ops;
+    CarlaScopedPointer<RenderingTaskList> tasks;
+    AudioSampleBuffer audioBuffers, cvBuffers;
+    OwnedArray<MidiBuffer> midiBuffers;
+
+    // one flag per audio buffer, set while it is known to be silent
+    HeapBlock<bool> silentAudioChans;
+
+private:
+    // like isSameOpAs(), but delay ops must also have the same delay
+    static bool isSameOp (const void* const opPtr, const void* const newOpPtr) noexcept
+    {
+        const AudioGraphRenderingOpBase* const op = static_cast<const AudioGraphRenderingOpBase*> (opPtr);
+        const AudioGraphRenderingOpBase* const newOp = static_cast<const AudioGraphRenderingOpBase*> (newOpPtr);
+
+        if (! op->isSameOpAs (*newOp))
+            return false;
+
+        if (const DelayChannelOp* const delayOp = dynamic_cast<const DelayChannelOp*> (op))
+            return delayOp->getDelay() == static_cast<const DelayChannelOp*> (newOp)->getDelay();
+
+        return true;
+    }
+
+    static void swapOps (Array<void*>& ops, const int index, Array<void*>& otherOps, const int otherIndex) noexcept
+    {
+        void* const op = ops.getUnchecked (index);
+        ops.set (index, otherOps.getUnchecked (otherIndex));
+        otherOps.set (otherIndex, op);
+    }
+
+public:
+
+    CARLA_DECLARE_NON_COPY_CLASS (RenderingSequence)
 };
 
 }
@@ -1142,53 +2170,56 @@ struct AudioProcessorGraph::AudioProcessorGraphBufferHelpers
 {
     AudioProcessorGraphBufferHelpers() noexcept
         : currentAudioInputBuffer (nullptr),
-          currentCVInputBuffer (nullptr) {}
-
-    void setRenderingBufferSize (int newNumAudioChannels, int newNumCVChannels, int newNumSamples) noexcept
-    {
-        renderingAudioBuffers.setSize (newNumAudioChannels, newNumSamples);
-        renderingAudioBuffers.clear();
-
-        renderingCVBuffers.setSize (newNumCVChannels, newNumSamples);
-        renderingCVBuffers.clear();
-    }
+          currentCVInputBuffer (nullptr),
+          currentAudioOutputBuffer (nullptr),
+          currentCVOutputBuffer (nullptr) {}
 
     void release() noexcept
     {
-        renderingAudioBuffers.setSize (1, 1);
         currentAudioInputBuffer = nullptr;
         currentCVInputBuffer = nullptr;
-        currentAudioOutputBuffer.setSize (1, 1);
-        currentCVOutputBuffer.setSize (1, 1);
-
-        renderingCVBuffers.setSize (1, 1);
+        currentAudioOutputBuffer = nullptr;
+        currentCVOutputBuffer = nullptr;
+        audioOutputBuffer.setSize (1, 1);
+        cvOutputBuffer.setSize (1, 1);
     }
 
     void prepareInOutBuffers (int newNumAudioChannels, int newNumCVChannels, int newNumSamples) noexcept
     {
         currentAudioInputBuffer = nullptr;
         currentCVInputBuffer = nullptr;
-        currentAudioOutputBuffer.setSize (newNumAudioChannels, newNumSamples);
-        currentCVOutputBuffer.setSize (newNumCVChannels, newNumSamples);
+        currentAudioOutputBuffer = nullptr;
+        currentCVOutputBuffer = nullptr;
+        audioOutputBuffer.setSize (newNumAudioChannels, newNumSamples);
+        cvOutputBuffer.setSize (newNumCVChannels, newNumSamples);
     }
 
-    AudioSampleBuffer        renderingAudioBuffers;
-    AudioSampleBuffer        renderingCVBuffers;
-    AudioSampleBuffer*       currentAudioInputBuffer;
+    const AudioSampleBuffer* currentAudioInputBuffer;
     const AudioSampleBuffer* currentCVInputBuffer;
-    AudioSampleBuffer        currentAudioOutputBuffer;
-    AudioSampleBuffer        currentCVOutputBuffer;
+    AudioSampleBuffer*       currentAudioOutputBuffer;
+    AudioSampleBuffer*       currentCVOutputBuffer;
+
+    // outputs are rendered here first when processing in place
+    AudioSampleBuffer        audioOutputBuffer;
+    AudioSampleBuffer        cvOutputBuffer;
 };
 
 //==============================================================================
 AudioProcessorGraph::AudioProcessorGraph()
     : lastNodeId (0), audioAndCVBuffers (new AudioProcessorGraphBufferHelpers),
-      currentMidiInputBuffer (nullptr), isPrepared (false), needsReorder (false)
+      currentMidiInputBuffer (nullptr), isPrepared (false), needsReorder (false), needsLatencyUpdate (false),
+      reorderSuspendCount (0), numProcessingThreads (0), threadPool (nullptr)
 {
 }
 
 AudioProcessorGraph::~AudioProcessorGraph()
 {
+    if (threadPool != nullptr)
+    {
+        CarlaSharedThreadPool::release (threadPool);
+        threadPool = nullptr;
+    }
+
     clearRenderingSequence();
     clear();
 }
@@ -1203,7 +2234,7 @@ void AudioProcessorGraph::clear()
 {
     nodes.clear();
     connections.clear();
-    needsReorder = true;
+    triggerReorder();
 }
 
 AudioProcessorGraph::Node* AudioProcessorGraph::getNodeForId (const uint32 nodeId) const
@@ -1242,7 +2273,7 @@ AudioProcessorGraph::Node* AudioProcessorGraph::addNode (AudioProcessor* const n
     nodes.add (n);
 
     if (isPrepared)
-        needsReorder = true;
+        triggerReorder();
 
     n->setParentGraph (this);
     return n;
@@ -1259,7 +2290,7 @@ bool AudioProcessorGraph::removeNode (const uint32 nodeId)
             nodes.remove (i);
 
             if (isPrepared)
-                needsReorder = true;
+                triggerReorder();
 
             return true;
         }
@@ -1347,7 +2378,7 @@ bool AudioProcessorGraph::addConnection (const ChannelType ct,
                                                    destNodeId, destChannelIndex));
 
     if (isPrepared)
-        needsReorder = true;
+        triggerReorder();
 
     return true;
 }
@@ -1357,7 +2388,7 @@ void AudioProcessorGraph::removeConnection (const int index)
     connections.remove (index);
 
     if (isPrepared)
-        needsReorder = true;
+        triggerReorder();
 }
 
 bool AudioProcessorGraph::removeConnection (const ChannelType ct,
@@ -1434,22 +2465,14 @@ bool AudioProcessorGraph::removeIllegalConnections()
 }
 
 //==============================================================================
-static void deleteRenderOpArray (Array<void*>& ops)
-{
-    for (int i = ops.size(); --i >= 0;)
-        delete static_cast<GraphRenderingOps::AudioGraphRenderingOpBase*> (ops.getUnchecked(i));
-}
-
 void AudioProcessorGraph::clearRenderingSequence()
 {
-    Array<void*> oldOps;
+    CarlaScopedPointer<GraphRenderingOps::RenderingSequence> oldSequence;
 
     {
         const CarlaRecursiveMutexLocker cml (getCallbackLock());
-        renderingOps.swapWith (oldOps);
+        renderingSequence.swapWith (oldSequence);
     }
-
-    deleteRenderOpArray (oldOps);
 }
 
 bool AudioProcessorGraph::isAnInputTo (const uint32 possibleInputId,
@@ -1472,62 +2495,220 @@ bool AudioProcessorGraph::isAnInputTo (const uint32 possibleInputId,
     return false;
 }
 
-void AudioProcessorGraph::buildRenderingSequence()
+void AudioProcessorGraph::getRenderingOrder (Array<Node*>& orderedNodes, const bool prepareNodes)
 {
-    Array<void*> newRenderingOps;
-    int numAudioRenderingBuffersNeeded = 2;
-    int numCVRenderingBuffersNeeded = 0;
-    int numMidiBuffersNeeded = 1;
+    const int numNodes = nodes.size();
 
+    if (prepareNodes)
     {
-        const CarlaRecursiveMutexLocker cml (reorderMutex);
+        for (int i = 0; i < numNodes; ++i)
+            nodes.getUnchecked(i)->prepare (getSampleRate(), getBlockSize(), this);
+    }
 
-        Array<Node*> orderedNodes;
+    // depth-first walk through the inputs of each node, placing every node after the ones feeding it.
+    // an input that is still being walked through closes a feedback loop and is skipped
+    const GraphRenderingOps::NodeInputsTable table (nodes, connections);
 
+    enum { notVisited, visiting, visited };
+
+    Array<int> states, nextInputs, stack;
+    states.insertMultiple (0, notVisited, numNodes);
+    nextInputs.insertMultiple (0, 0, numNodes);
+    orderedNodes.ensureStorageAllocated (numNodes);
+
+    for (int i = 0; i < numNodes; ++i)
+    {
+        if (states.getUnchecked (i) != notVisited)
+            continue;
+
+        states.set (i, visiting);
+        nextInputs.set (i, table.getInputsStart (i));
+        stack.add (i);
+
+        while (stack.size() != 0)
         {
-            const GraphRenderingOps::ConnectionLookupTable table (connections);
+            const int index = stack.getLast();
+            const int nextInput = nextInputs.getUnchecked (index);
 
-            for (int i = 0; i < nodes.size(); ++i)
+            if (nextInput == table.getInputsEnd (index))
             {
-                Node* const node = nodes.getUnchecked(i);
+                stack.removeLast();
+                states.set (index, visited);
+                orderedNodes.add (nodes.getUnchecked (index));
+                continue;
+            }
+
+            nextInputs.set (index, nextInput + 1);
+
+            const int source = table.getInput (nextInput);
+
+            if (states.getUnchecked (source) == notVisited)
+            {
+                states.set (source, visiting);
+                nextInputs.set (source, table.getInputsStart (source));
+                stack.add (source);
+            }
+        }
+    }
+
+    removeUnusedNodes (orderedNodes);
+}
+
+void AudioProcessorGraph::removeUnusedNodes (Array<Node*>& orderedNodes) const
+{
+    // nodes without any outputs are where the signal ends up, everything else only
+    // needs to run if it feeds one of them, directly or through other nodes
+    const GraphRenderingOps::NodeInputsTable table (nodes, connections);
+
+    Array<bool> used;
+    Array<int> pending;
+    used.insertMultiple (0, false, nodes.size());
+
+    for (int i = 0; i < orderedNodes.size(); ++i)
+    {
+        const Node* const node = orderedNodes.getUnchecked (i);
+        const AudioProcessor* const processor = node->getProcessor();
+
+        if (processor->mustAlwaysProcess()
+            || (processor->getTotalNumOutputChannels (AudioProcessor::ChannelTypeAudio) == 0
+                && processor->getTotalNumOutputChannels (AudioProcessor::ChannelTypeCV) == 0
+                && processor->getTotalNumOutputChannels (AudioProcessor::ChannelTypeMIDI) == 0))
+        {
+            const int index = table.getNodeIndex (node->nodeId);
+            CARLA_SAFE_ASSERT_CONTINUE (index >= 0);
+
+            if (! used.getUnchecked (index))
+            {
+                used.set (index, true);
+                pending.add (index);
+            }
+        }
+    }
 
-                node->prepare (getSampleRate(), getBlockSize(), this);
+    // walk back through the inputs, each node only once so that feedback loops are handled too
+    while (pending.size() != 0)
+    {
+        const int index = pending.getLast();
+        pending.removeLast();
 
-                int j = 0;
-                for (; j < orderedNodes.size(); ++j)
-                    if (table.isAnInputTo (node->nodeId, ((Node*) orderedNodes.getUnchecked(j))->nodeId))
-                      break;
+        for (int i = table.getInputsStart (index), end = table.getInputsEnd (index); i < end; ++i)
+        {
+            const int source = table.getInput (i);
 
-                orderedNodes.insert (j, node);
+            if (! used.getUnchecked (source))
+            {
+                used.set (source, true);
+                pending.add (source);
             }
         }
+    }
+
+    Array<Node*> usedNodes;
+    usedNodes.ensureStorageAllocated (orderedNodes.size());
+
+    for (int i = 0; i < orderedNodes.size(); ++i)
+    {
+        Node* const node = orderedNodes.getUnchecked (i);
+        const int index = table.getNodeIndex (node->nodeId);
+
+        if (index >= 0 && used.getUnchecked (index))
+            usedNodes.add (node);
+    }
+
+    orderedNodes.swapWith (usedNodes);
+}
+
+void AudioProcessorGraph::buildRenderingSequence()
+{
+    CarlaScopedPointer<GraphRenderingOps::RenderingSequence> newSequence (new GraphRenderingOps::RenderingSequence());
+
+    {
+        const CarlaRecursiveMutexLocker cml (reorderMutex);
+
+        Array<Node*> orderedNodes;
+        getRenderingOrder (orderedNodes, true);
+
+        // tasks are needed for parallel processing, and for starting several nodes at once
+        bool needsTasks = numProcessingThreads != 0;
+
+        for (int i = 0; i < orderedNodes.size() && ! needsTasks; ++i)
+            needsTasks = orderedNodes.getUnchecked(i)->getProcessor()->canStartBlock();
+
+        GraphRenderingOps::RenderingOpSequenceCalculator calculator (*this, orderedNodes, newSequence->ops,
+                                                                     needsTasks);
+
+        const int numAudioRenderingBuffersNeeded = calculator.getNumAudioBuffersNeeded();
+        const int numCVRenderingBuffersNeeded = calculator.getNumCVBuffersNeeded();
+        const int numMidiBuffersNeeded = calculator.getNumMidiBuffersNeeded();
+
+        if (needsTasks)
+            newSequence->tasks = new GraphRenderingOps::RenderingTaskList (newSequence->ops,
+                                                                           calculator.getNodeRenderingOpsEnd(),
+                                                                           numAudioRenderingBuffersNeeded,
+                                                                           numCVRenderingBuffersNeeded,
+                                                                           numMidiBuffersNeeded);
+
+        // single connection changes only touch a few ops, so try patching the current sequence first.
+        // this keeps its buffers and the state of the unchanged ops, like delay lines
+        if (renderingSequence != nullptr)
+        {
+            const CarlaRecursiveMutexLocker cml2 (getCallbackLock());
+
+            if (renderingSequence->patchFrom (*newSequence, numAudioRenderingBuffersNeeded,
+                                              numCVRenderingBuffersNeeded, numMidiBuffersNeeded))
+                return;
+        }
+
+        newSequence->audioBuffers.setSize (numAudioRenderingBuffersNeeded, getBlockSize());
+        newSequence->audioBuffers.clear();
+        newSequence->silentAudioChans.malloc (static_cast<size_t> (jmax (1, numAudioRenderingBuffersNeeded)));
+
+        for (int i = 0; i < numAudioRenderingBuffersNeeded; ++i)
+            newSequence->silentAudioChans[i] = true;
 
-        GraphRenderingOps::RenderingOpSequenceCalculator calculator (*this, orderedNodes, newRenderingOps);
+        newSequence->cvBuffers.setSize (numCVRenderingBuffersNeeded, getBlockSize());
+        newSequence->cvBuffers.clear();
 
-        numAudioRenderingBuffersNeeded = calculator.getNumAudioBuffersNeeded();
-        numCVRenderingBuffersNeeded = calculator.getNumCVBuffersNeeded();
-        numMidiBuffersNeeded = calculator.getNumMidiBuffersNeeded();
+        while (static_cast<int>(newSequence->midiBuffers.size()) < numMidiBuffersNeeded)
+            newSequence->midiBuffers.add (new MidiBuffer());
     }
 
     {
         // swap over to the new rendering sequence..
         const CarlaRecursiveMutexLocker cml (getCallbackLock());
+        renderingSequence.swapWith (newSequence);
+    }
+
+    // the old one gets deleted here, outside of the callback lock
+}
+
+void AudioProcessorGraph::updateLatencies()
+{
+    const CarlaRecursiveMutexLocker crml (reorderMutex);
+
+    if (renderingSequence == nullptr)
+    {
+        buildRenderingSequence();
+        return;
+    }
 
-        audioAndCVBuffers->setRenderingBufferSize (numAudioRenderingBuffersNeeded,
-                                                   numCVRenderingBuffersNeeded,
-                                                   getBlockSize());
+    // compute the sequence for the new latencies, but only keep its delay amounts
+    GraphRenderingOps::RenderingSequence newSequence;
+    Array<Node*> orderedNodes;
+    getRenderingOrder (orderedNodes, false);
 
-        for (int i = static_cast<int>(midiBuffers.size()); --i >= 0;)
-            midiBuffers.getUnchecked(i)->clear();
+    const GraphRenderingOps::RenderingOpSequenceCalculator calculator (*this, orderedNodes, newSequence.ops,
+                                                                       renderingSequence->tasks != nullptr);
 
-        while (static_cast<int>(midiBuffers.size()) < numMidiBuffersNeeded)
-            midiBuffers.add (new MidiBuffer());
+    bool updated;
 
-        renderingOps.swapWith (newRenderingOps);
+    {
+        const CarlaRecursiveMutexLocker cml (getCallbackLock());
+        updated = renderingSequence->updateDelaysFrom (newSequence.ops);
     }
 
-    // delete the old ones..
-    deleteRenderOpArray (newRenderingOps);
+    if (! updated)
+        buildRenderingSequence();
 }
 
 //==============================================================================
@@ -1555,8 +2736,8 @@ void AudioProcessorGraph::releaseResources()
     for (int i = 0; i < nodes.size(); ++i)
         nodes.getUnchecked(i)->unprepare();
 
+    clearRenderingSequence();
     audioAndCVBuffers->release();
-    midiBuffers.clear();
 
     currentMidiInputBuffer = nullptr;
     currentMidiOutputBuffer.clear();
@@ -1623,47 +2804,61 @@ void AudioProcessorGraph::processAudioAndCV (AudioSampleBuffer& audioBuffer,
                                              AudioSampleBuffer& cvOutBuffer,
                                              MidiBuffer& midiMessages)
 {
-    AudioSampleBuffer*&       currentAudioInputBuffer  = audioAndCVBuffers->currentAudioInputBuffer;
-    const AudioSampleBuffer*& currentCVInputBuffer     = audioAndCVBuffers->currentCVInputBuffer;
-    AudioSampleBuffer&        currentAudioOutputBuffer = audioAndCVBuffers->currentAudioOutputBuffer;
-    AudioSampleBuffer&        currentCVOutputBuffer    = audioAndCVBuffers->currentCVOutputBuffer;
-    AudioSampleBuffer&        renderingAudioBuffers    = audioAndCVBuffers->renderingAudioBuffers;
-    AudioSampleBuffer&        renderingCVBuffers       = audioAndCVBuffers->renderingCVBuffers;
+    AudioSampleBuffer& audioOutputBuffer = audioAndCVBuffers->audioOutputBuffer;
+    AudioSampleBuffer& cvOutputBuffer    = audioAndCVBuffers->cvOutputBuffer;
 
     const int numSamples = audioBuffer.getNumSamples();
 
-    if (! audioAndCVBuffers->currentAudioOutputBuffer.setSizeRT(numSamples))
+    if (! audioOutputBuffer.setSizeRT(numSamples))
         return;
-    if (! audioAndCVBuffers->currentCVOutputBuffer.setSizeRT(numSamples))
+    if (! cvOutputBuffer.setSizeRT(numSamples))
         return;
-    if (! audioAndCVBuffers->renderingAudioBuffers.setSizeRT(numSamples))
+
+    renderSequence (audioBuffer, audioOutputBuffer, cvInBuffer, cvOutputBuffer, midiMessages);
+
+    for (uint32_t i = 0; i < audioBuffer.getNumChannels(); ++i)
+        audioBuffer.copyFrom (i, 0, audioOutputBuffer, i, 0, numSamples);
+
+    for (uint32_t i = 0; i < cvOutBuffer.getNumChannels(); ++i)
+        cvOutBuffer.copyFrom (i, 0, cvOutputBuffer, i, 0, numSamples);
+}
+
+void AudioProcessorGraph::renderSequence (const AudioSampleBuffer& audioInBuffer,
+                                          AudioSampleBuffer& audioOutBuffer,
+                                          const AudioSampleBuffer& cvInBuffer,
+                                          AudioSampleBuffer& cvOutBuffer,
+                                          MidiBuffer& midiMessages)
+{
+    GraphRenderingOps::RenderingSequence* const sequence = renderingSequence.get();
+    CARLA_SAFE_ASSERT_RETURN (sequence != nullptr,);
+
+    const int numSamples = audioInBuffer.getNumSamples();
+
+    if (! sequence->audioBuffers.setSizeRT(numSamples))
         return;
-    if (! audioAndCVBuffers->renderingCVBuffers.setSizeRT(numSamples))
+    if (! sequence->cvBuffers.setSizeRT(numSamples))
         return;
 
-    currentAudioInputBuffer = &audioBuffer;
-    currentCVInputBuffer = &cvInBuffer;
+    audioAndCVBuffers->currentAudioInputBuffer = &audioInBuffer;
+    audioAndCVBuffers->currentCVInputBuffer = &cvInBuffer;
+    audioAndCVBuffers->currentAudioOutputBuffer = &audioOutBuffer;
+    audioAndCVBuffers->currentCVOutputBuffer = &cvOutBuffer;
     currentMidiInputBuffer = &midiMessages;
-    currentAudioOutputBuffer.clear();
-    currentCVOutputBuffer.clear();
+    audioOutBuffer.clear();
+    cvOutBuffer.clear();
     currentMidiOutputBuffer.clear();
 
-    for (int i = 0; i < renderingOps.size(); ++i)
+    if (sequence->tasks != nullptr && threadPool != nullptr)
     {
-        GraphRenderingOps::AudioGraphRenderingOpBase* const op
-            = (GraphRenderingOps::AudioGraphRenderingOpBase*) renderingOps.getUnchecked(i);
-
-        op->perform (renderingAudioBuffers, renderingCVBuffers, midiBuffers, numSamples);
+        sequence->tasks->prepare (numSamples);
+        threadPool->run (GraphRenderingOps::RenderingSequence::performTasksCallback, sequence, numProcessingThreads);
+    }
+    else
+    {
+        sequence->perform (numSamples);
     }
 
-    for (uint32_t i = 0; i < audioBuffer.getNumChannels(); ++i)
-        audioBuffer.copyFrom (i, 0, currentAudioOutputBuffer, i, 0, numSamples);
-
-    for (uint32_t i = 0; i < cvOutBuffer.getNumChannels(); ++i)
-        cvOutBuffer.copyFrom (i, 0, currentCVOutputBuffer, i, 0, numSamples);
-
-    midiMessages.clear();
-    midiMessages.addEvents (currentMidiOutputBuffer, 0, audioBuffer.getNumSamples(), 0);
+    midiMessages.swapWith (currentMidiOutputBuffer);
 }
 
 bool AudioProcessorGraph::acceptsMidi() const                       { return true; }
@@ -1684,13 +2879,32 @@ void AudioProcessorGraph::processBlockWithCV (AudioSampleBuffer& audioBuffer,
     processAudioAndCV (audioBuffer, cvInBuffer, cvOutBuffer, midiMessages);
 }
 
+void AudioProcessorGraph::processBlockWithCV (const AudioSampleBuffer& audioInBuffer,
+                                              AudioSampleBuffer& audioOutBuffer,
+                                              const AudioSampleBuffer& cvInBuffer,
+                                              AudioSampleBuffer& cvOutBuffer,
+                                              MidiBuffer& midiMessages)
+{
+    renderSequence (audioInBuffer, audioOutBuffer, cvInBuffer, cvOutBuffer, midiMessages);
+}
+
 void AudioProcessorGraph::reorderNowIfNeeded()
 {
+    // resumeReordering() wakes up the reorder thread again
+    if (reorderSuspendCount > 0)
+        return;
+
     if (needsReorder)
     {
         needsReorder = false;
+        needsLatencyUpdate = false;
         buildRenderingSequence();
     }
+    else if (needsLatencyUpdate)
+    {
+        needsLatencyUpdate = false;
+        updateLatencies();
+    }
 }
 
 const CarlaRecursiveMutex& AudioProcessorGraph::getReorderMutex() const
@@ -1698,6 +2912,72 @@ const CarlaRecursiveMutex& AudioProcessorGraph::getReorderMutex() const
     return reorderMutex;
 }
 
+void AudioProcessorGraph::setNumProcessingThreads (const uint numThreads, const char* const cpuAffinity)
+{
+    const CarlaRecursiveMutexLocker crml (reorderMutex);
+
+    if (numProcessingThreads == numThreads)
+        return;
+
+    CarlaThreadPool* const newThreadPool = numThreads != 0 ? CarlaSharedThreadPool::acquire (numThreads, cpuAffinity)
+                                                           : nullptr;
+    CarlaThreadPool* oldThreadPool;
+
+    {
+        const CarlaRecursiveMutexLocker cml (getCallbackLock());
+        oldThreadPool = threadPool;
+        threadPool = newThreadPool;
+        numProcessingThreads = threadPool != nullptr ? jmin (numThreads, threadPool->getNumWorkers()) : 0;
+    }
+
+    // the old reference gets dropped here, outside of the callback lock
+    if (oldThreadPool != nullptr)
+        CarlaSharedThreadPool::release (oldThreadPool);
+
+    if (isPrepared)
+        buildRenderingSequence();
+}
+
+uint AudioProcessorGraph::getNumProcessingThreads() const noexcept
+{
+    return numProcessingThreads;
+}
+
+void AudioProcessorGraph::triggerReorder() noexcept
+{
+    needsReorder = true;
+    reorderSignal.signal();
+}
+
+void AudioProcessorGraph::triggerLatencyUpdate() noexcept
+{
+    needsLatencyUpdate = true;
+    reorderSignal.signal();
+}
+
+void AudioProcessorGraph::suspendReordering() noexcept
+{
+    __sync_add_and_fetch (&reorderSuspendCount, 1);
+}
+
+void AudioProcessorGraph::resumeReordering() noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN (reorderSuspendCount > 0,);
+
+    if (__sync_sub_and_fetch (&reorderSuspendCount, 1) == 0 && (needsReorder || needsLatencyUpdate))
+        reorderSignal.signal();
+}
+
+void AudioProcessorGraph::waitForReorderRequest() noexcept
+{
+    reorderSignal.wait();
+}
+
+void AudioProcessorGraph::wakeUpReorderWaiter() noexcept
+{
+    reorderSignal.signal();
+}
+
 //==============================================================================
 AudioProcessorGraph::AudioGraphIOProcessor::AudioGraphIOProcessor (const IODeviceType deviceType)
     : type (deviceType), graph (nullptr)
@@ -1744,8 +3024,8 @@ void AudioProcessorGraph::AudioGraphIOProcessor::processAudioAndCV (AudioSampleB
     {
         case audioOutputNode:
         {
-            AudioSampleBuffer&  currentAudioOutputBuffer =
-                graph->audioAndCVBuffers->currentAudioOutputBuffer;
+            AudioSampleBuffer& currentAudioOutputBuffer =
+                *graph->audioAndCVBuffers->currentAudioOutputBuffer;
 
             for (int i = jmin (currentAudioOutputBuffer.getNumChannels(),
                                audioBuffer.getNumChannels()); --i >= 0;)
@@ -1758,7 +3038,7 @@ void AudioProcessorGraph::AudioGraphIOProcessor::processAudioAndCV (AudioSampleB
 
         case audioInputNode:
         {
-            AudioSampleBuffer*& currentAudioInputBuffer =
+            const AudioSampleBuffer*& currentAudioInputBuffer =
                 graph->audioAndCVBuffers->currentAudioInputBuffer;
 
             for (int i = jmin (currentAudioInputBuffer->getNumChannels(),
@@ -1772,8 +3052,8 @@ void AudioProcessorGraph::AudioGraphIOProcessor::processAudioAndCV (AudioSampleB
 
         case cvOutputNode:
         {
-            AudioSampleBuffer&  currentCVOutputBuffer =
-                graph->audioAndCVBuffers->currentCVOutputBuffer;
+            AudioSampleBuffer& currentCVOutputBuffer =
+                *graph->audioAndCVBuffers->currentCVOutputBuffer;
 
             for (int i = jmin (currentCVOutputBuffer.getNumChannels(),
                                cvInBuffer.getNumChannels()); --i >= 0;)
@@ -1799,11 +3079,11 @@ void AudioProcessorGraph::AudioGraphIOProcessor::processAudioAndCV (AudioSampleB
         }
 
         case midiOutputNode:
-            graph->currentMidiOutputBuffer.addEvents (midiMessages, 0, audioBuffer.getNumSamples(), 0);
+            graph->currentMidiOutputBuffer.mergeEvents (midiMessages, midiScratchBuffer);
             break;
 
         case midiInputNode:
-            midiMessages.addEvents (*graph->currentMidiInputBuffer, 0, audioBuffer.getNumSamples(), 0);
+            midiMessages.mergeEvents (*graph->currentMidiInputBuffer, midiScratchBuffer);
             break;
 
         default:
@@ -1829,6 +3109,12 @@ bool AudioProcessorGraph::AudioGraphIOProcessor::producesMidi() const
     return type == midiInputNode;
 }
 
+bool AudioProcessorGraph::AudioGraphIOProcessor::canSkipSilentBlocks() const noexcept
+{
+    // adding silence to the graph output does nothing
+    return type == audioOutputNode;
+}
+
 bool AudioProcessorGraph::AudioGraphIOProcessor::isInput() const noexcept
 {
     return type == audioInputNode || type == cvInputNode || type == midiInputNode;
@@ -27,8 +27,12 @@
 #include "../containers/ReferenceCountedArray.h"
 #include "../midi/MidiBuffer.h"
 
+class CarlaThreadPool;
+
 namespace water {
 
+namespace GraphRenderingOps { struct RenderingSequence; }
+
 //==============================================================================
 /**
     A type of AudioProcessor which plays back a graph of other AudioProcessors.
@@ -327,6 +331,7 @@ public:
 
         bool acceptsMidi() const override;
         bool producesMidi() const override;
+        bool canSkipSilentBlocks() const noexcept override;
 
         /** @internal */
         void setParentGraph (AudioProcessorGraph*);
@@ -334,6 +339,7 @@ public:
     private:
         const IODeviceType type;
         AudioProcessorGraph* graph;
+        MidiBuffer midiScratchBuffer;
 
         //==============================================================================
         //void processAudio (AudioSampleBuffer& buffer, MidiBuffer& midiMessages);
@@ -355,6 +361,18 @@ public:
                              AudioSampleBuffer& cvOutBuffer,
                              MidiBuffer& midiMessages) override;
 
+    /** Processes a block reading the inputs from and writing the outputs into separate buffers.
+
+        The graph input and output nodes use these buffers directly, which saves copying all
+        channels in and out of a shared in-place buffer. The input and output buffers must
+        not overlap, as the outputs are cleared before any input is read.
+    */
+    void processBlockWithCV (const AudioSampleBuffer& audioInBuffer,
+                             AudioSampleBuffer& audioOutBuffer,
+                             const AudioSampleBuffer& cvInBuffer,
+                             AudioSampleBuffer& cvOutBuffer,
+                             MidiBuffer& midiMessages);
+
     void reset() override;
     void setNonRealtime (bool) noexcept override;
 
@@ -364,6 +382,49 @@ public:
     void reorderNowIfNeeded();
     const CarlaRecursiveMutex& getReorderMutex() const;
 
+    /** Marks the rendering sequence as outdated and wakes up the thread
+        waiting in waitForReorderRequest(), if any.
+        This is called automatically when nodes or connections change.
+    */
+    void triggerReorder() noexcept;
+
+    /** Blocks until triggerReorder() or wakeUpReorderWaiter() is called.
+        Meant to be used by a dedicated thread that calls reorderNowIfNeeded() afterwards.
+    */
+    void waitForReorderRequest() noexcept;
+
+    /** Wakes up the thread waiting in waitForReorderRequest() without requesting a reorder. */
+    void wakeUpReorderWaiter() noexcept;
+
+    /** Like triggerReorder(), for when only the latency of some nodes changed.
+        The delay lines of the current rendering sequence are then adjusted in place,
+        and the sequence is only rebuilt if the new latencies need different delay lines.
+    */
+    void triggerLatencyUpdate() noexcept;
+
+    /** Holds back reorderNowIfNeeded() until the matching resumeReordering(), so that a
+        batch of node and connection changes only rebuilds the rendering sequence once.
+        Calls can be nested.
+    */
+    void suspendReordering() noexcept;
+
+    /** Ends a suspendReordering() call, waking up the reorder thread if needed. */
+    void resumeReordering() noexcept;
+
+    //==============================================================================
+    /** Sets the number of extra threads used to process independent nodes in parallel.
+
+        The audio callback thread always takes part in processing, so a value of 0
+        (the default) renders the whole graph serially on the calling thread.
+        The extra threads come from the process-wide CarlaSharedThreadPool, so graphs of
+        different engines share them; when spawned here they can be restricted to some CPUs
+        with a list like "2,3,8-11".
+    */
+    void setNumProcessingThreads (uint numThreads, const char* cpuAffinity = nullptr);
+
+    /** Returns the number of extra processing threads this graph can use. */
+    uint getNumProcessingThreads() const noexcept;
+
 private:
     //==============================================================================
     // void processAudio (AudioSampleBuffer& audioBuffer, MidiBuffer& midiMessages);
@@ -371,13 +432,17 @@ private:
                             const AudioSampleBuffer& cvInBuffer,
                             AudioSampleBuffer& cvOutBuffer,
                             MidiBuffer& midiMessages);
+    void renderSequence (const AudioSampleBuffer& audioInBuffer,
+                         AudioSampleBuffer& audioOutBuffer,
+                         const AudioSampleBuffer& cvInBuffer,
+                         AudioSampleBuffer& cvOutBuffer,
+                         MidiBuffer& midiMessages);
 
     //==============================================================================
     ReferenceCountedArray<Node> nodes;
     OwnedArray<Connection> connections;
     uint32 lastNodeId;
-    OwnedArray<MidiBuffer> midiBuffers;
-    Array<void*> renderingOps;
+    CarlaScopedPointer<GraphRenderingOps::RenderingSequence> renderingSequence;
 
     friend class AudioGraphIOProcessor;
     struct AudioProcessorGraphBufferHelpers;
@@ -386,12 +451,20 @@ private:
     MidiBuffer* currentMidiInputBuffer;
     MidiBuffer currentMidiOutputBuffer;
 
-    bool isPrepared, needsReorder;
+    bool isPrepared, needsReorder, needsLatencyUpdate;
+    volatile int reorderSuspendCount;
     CarlaRecursiveMutex reorderMutex;
+    CarlaSignal reorderSignal;
+
+    uint numProcessingThreads;
+    CarlaThreadPool* threadPool;
 
 public:
     void clearRenderingSequence();
     void buildRenderingSequence();
+    void updateLatencies();
+    void getRenderingOrder (Array<Node*>& orderedNodes, bool prepareNodes);
+    void removeUnusedNodes (Array<Node*>& orderedNodes) const;
     bool isAnInputTo (uint32 possibleInputId, uint32 possibleDestinationId, int recursionCheck) const;
 
     CARLA_DECLARE_NON_COPY_CLASS (AudioProcessorGraph)
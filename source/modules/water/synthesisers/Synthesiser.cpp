@@ -30,6 +30,8 @@
 #include "../midi/MidiBuffer.h"
 #include "../midi/MidiMessage.h"
 
+#include "CarlaThreadPool.hpp"
+
 namespace water {
    
 SynthesiserSound::SynthesiserSound() {}
@@ -88,7 +90,13 @@ Synthesiser::Synthesiser()
       lastNoteOnCounter (0),
       minimumSubBlockSize (32),
       subBlockSubdivisionIsStrict (false),
-      shouldStealNotes (true)
+      shouldStealNotes (true),
+      renderThreadChannels (0),
+      renderThreadBufferSize (0),
+      renderOutput (nullptr),
+      renderStartSample (0),
+      renderNumSamples (0),
+      renderNextVoice (0)
 {
     for (size_t i = 0; i < numElementsInArray (lastPitchWheelValues); ++i)
         lastPitchWheelValues[i] = 0x2000;
@@ -98,6 +106,7 @@ Synthesiser::Synthesiser()
 
 Synthesiser::~Synthesiser()
 {
+    renderThreadPool = nullptr;
 }
 
 //==============================================================================
@@ -221,12 +230,145 @@ void Synthesiser::processNextBlock (AudioSampleBuffer& outputAudio,
         handleMidiEvent (m);
 }
 
+//==============================================================================
+struct Synthesiser::RenderThread
+{
+    RenderThread (const int numChannels, const int numSamples)
+        : buffer (static_cast<uint32_t> (numChannels), static_cast<uint32_t> (numSamples), true),
+          used (false) {}
+
+    AudioSampleBuffer buffer;
+    bool used;
+};
+
+// waking up the workers is not worth it for just a few voices
+static const int kMinVoicesForRenderThreads = 4;
+
 void Synthesiser::renderVoices (AudioSampleBuffer& buffer, int startSample, int numSamples)
 {
+    if (renderThreadPool != nullptr
+        && numSamples <= renderThreadBufferSize
+        && static_cast<int> (buffer.getNumChannels()) == renderThreadChannels)
+    {
+        int numActiveVoices = 0;
+
+        for (int i = voices.size(); --i >= 0;)
+            if (voices.getUnchecked (i)->isVoiceActive())
+                ++numActiveVoices;
+
+        if (numActiveVoices >= kMinVoicesForRenderThreads)
+        {
+            renderOutput = &buffer;
+            renderStartSample = startSample;
+            renderNumSamples = numSamples;
+            renderNextVoice = 0;
+
+            for (int i = renderThreads.size(); --i >= 0;)
+                renderThreads.getUnchecked (i)->used = false;
+
+            renderThreadPool->run (renderVoicesCallback, this);
+
+            for (int i = renderThreads.size(); --i >= 0;)
+            {
+                RenderThread* const thread = renderThreads.getUnchecked (i);
+
+                if (! thread->used)
+                    continue;
+
+                for (uint32_t c = 0; c < buffer.getNumChannels(); ++c)
+                    buffer.addFrom (c, static_cast<uint32_t> (startSample), thread->buffer, c, 0,
+                                    static_cast<uint32_t> (numSamples));
+            }
+
+            renderOutput = nullptr;
+            return;
+        }
+    }
+
     for (int i = voices.size(); --i >= 0;)
         voices.getUnchecked (i)->renderNextBlock (buffer, startSample, numSamples);
 }
 
+void Synthesiser::renderVoicesCallback (void* const ptr, const uint threadIndex)
+{
+    static_cast<Synthesiser*> (ptr)->renderVoicesOnThread (threadIndex);
+}
+
+void Synthesiser::renderVoicesOnThread (const uint threadIndex)
+{
+    // the calling thread renders straight into the output, workers into their own buffer
+    RenderThread* const thread = threadIndex != 0 ? renderThreads.getUnchecked (static_cast<int> (threadIndex - 1))
+                                                  : nullptr;
+    AudioSampleBuffer& buffer (thread != nullptr ? thread->buffer : *renderOutput);
+    const int startSample = thread != nullptr ? 0 : renderStartSample;
+    const int numVoices = static_cast<int> (voices.size());
+
+    for (;;)
+    {
+        const int index = __sync_fetch_and_add (&renderNextVoice, 1);
+
+        if (index >= numVoices)
+            break;
+
+        SynthesiserVoice* const voice = voices.getUnchecked (index);
+
+        if (! voice->isVoiceActive())
+            continue;
+
+        if (thread != nullptr && ! thread->used)
+        {
+            thread->buffer.clear (0, static_cast<uint32_t> (renderNumSamples));
+            thread->used = true;
+        }
+
+        voice->renderNextBlock (buffer, startSample, renderNumSamples);
+    }
+}
+
+void Synthesiser::setNumRenderThreads (const uint numThreads, const int numChannels, const int maxBlockSize)
+{
+    CARLA_SAFE_ASSERT_RETURN(numChannels > 0,);
+    CARLA_SAFE_ASSERT_RETURN(maxBlockSize > 0,);
+
+    if (numThreads == 0)
+    {
+        renderThreads.clear();
+        renderThreadPool = nullptr;
+        renderThreadChannels = renderThreadBufferSize = 0;
+        return;
+    }
+
+    if (renderThreadPool == nullptr || renderThreadPool->getNumWorkers() != numThreads)
+    {
+        renderThreads.clear();
+        renderThreadPool = new CarlaThreadPool();
+
+        if (! renderThreadPool->start (numThreads, true))
+        {
+            renderThreadPool = nullptr;
+            renderThreadChannels = renderThreadBufferSize = 0;
+            return;
+        }
+    }
+
+    if (renderThreads.size() == renderThreadPool->getNumWorkers()
+        && renderThreadChannels == numChannels && renderThreadBufferSize == maxBlockSize)
+        return;
+
+    renderThreads.clear();
+
+    for (uint i = 0; i < renderThreadPool->getNumWorkers(); ++i)
+        renderThreads.add (new RenderThread (numChannels, maxBlockSize));
+
+    renderThreadChannels = numChannels;
+    renderThreadBufferSize = maxBlockSize;
+}
+
+uint Synthesiser::getNumRenderThreads() const noexcept
+{
+    return renderThreadPool != nullptr ? renderThreadPool->getNumWorkers() : 0;
+}
+
 void Synthesiser::handleMidiEvent (const MidiMessage& m)
 {
     const int channel = m.getChannel();
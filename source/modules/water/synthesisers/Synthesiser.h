@@ -33,6 +33,8 @@
 #include "CarlaJuceUtils.hpp"
 #include "CarlaMutex.hpp"
 
+class CarlaThreadPool;
+
 namespace water {
 
 //==============================================================================
@@ -550,6 +552,23 @@ public:
     virtual void renderVoices (AudioSampleBuffer& outputAudio,
                                int startSample, int numSamples);
 
+    /** Sets the number of extra threads used to render voices in parallel.
+
+        Active voices are split between the calling thread and the workers, each worker
+        rendering into its own buffer which is then added to the output. Voices must not
+        share any state that changes while rendering for this to be safe.
+
+        The worker buffers are sized for the given number of channels and samples, larger
+        blocks or other channel counts are rendered serially. A value of 0 (the default)
+        always renders on the calling thread only.
+
+        This must not be called while rendering.
+    */
+    void setNumRenderThreads (uint numThreads, int numChannels, int maxBlockSize);
+
+    /** Returns the number of extra rendering threads that are running. */
+    uint getNumRenderThreads() const noexcept;
+
     /** Can be overridden to do custom handling of incoming midi events. */
     virtual void handleMidiEvent (const MidiMessage&);
 
@@ -606,6 +625,10 @@ private:
                            const MidiBuffer& inputMidi,
                            int startSample,
                            int numSamples);
+
+    struct RenderThread;
+    static void renderVoicesCallback (void* ptr, uint threadIndex);
+    void renderVoicesOnThread (uint threadIndex);
     //==============================================================================
     double sampleRate;
     uint32 lastNoteOnCounter;
@@ -614,6 +637,15 @@ private:
     bool shouldStealNotes;
     bool sustainPedalsDown[17];
 
+    CarlaScopedPointer<CarlaThreadPool> renderThreadPool;
+    OwnedArray<RenderThread> renderThreads;
+    int renderThreadChannels, renderThreadBufferSize;
+
+    // state of the current parallel renderVoices() call
+    AudioSampleBuffer* renderOutput;
+    int renderStartSample, renderNumSamples;
+    volatile int renderNextVoice;
+
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Synthesiser)
 };
 
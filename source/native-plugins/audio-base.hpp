@@ -20,6 +20,11 @@
 
 #include "CarlaThread.hpp"
 #include "CarlaMathUtils.hpp"
+#include "CarlaMemoryLock.hpp"
+#include "CarlaSemUtils.hpp"
+#include "LinkedList.hpp"
+
+#include "water/memory/SharedResourcePointer.h"
 
 extern "C" {
 #include "audio_decoder/ad.h"
@@ -27,59 +32,83 @@ extern "C" {
 
 typedef struct adinfo ADInfo;
 
+// file channel played on output 'index', -1 if that output stays silent. Mono files play on every output.
+static inline
+int32_t getAudioFileChannelForOutput(const uint32_t numFileChannels, const uint32_t index) noexcept
+{
+    if (numFileChannels == 1)
+        return 0;
+    if (index < numFileChannels)
+        return static_cast<int32_t>(index);
+    return -1;
+}
+
+// fixed-size block of decoded audio, used when streaming from disk
+struct AudioFileChunk {
+    float** buffers; // one per file channel
+    volatile int32_t index; // chunk position in the file, -1 while empty or being written
+
+    AudioFileChunk() noexcept
+        : buffers(nullptr),
+          index(-1) {}
+
+    CARLA_DECLARE_NON_COPY_STRUCT(AudioFileChunk)
+};
+
 struct AudioFilePool {
-    float*   buffer[2];
+    float**  buffers; // one per file channel
+    uint32_t numChannels;
     uint32_t numFrames;
     volatile uint64_t startFrame;
 
-#ifdef CARLA_PROPER_CPP11_SUPPORT
     AudioFilePool() noexcept
-        : buffer{nullptr},
+        : buffers(nullptr),
+          numChannels(0),
           numFrames(0),
           startFrame(0) {}
-#else
-    AudioFilePool() noexcept
-        : numFrames(0),
-          startFrame(0)
-    {
-        buffer[0] = buffer[1] = nullptr;
-    }
-#endif
 
     ~AudioFilePool()
     {
         destroy();
     }
 
-    void create(const uint32_t desiredNumFrames)
+    void create(const uint32_t desiredNumChannels, const uint32_t desiredNumFrames)
     {
-        CARLA_ASSERT(buffer[0] == nullptr);
-        CARLA_ASSERT(buffer[1] == nullptr);
+        CARLA_ASSERT(buffers == nullptr);
         CARLA_ASSERT(startFrame == 0);
         CARLA_ASSERT(numFrames == 0);
 
+        CarlaMemoryLock& memoryLock(CarlaMemoryLock::getInstance());
+
+        buffers = new float*[desiredNumChannels];
+
+        for (uint32_t c=0; c < desiredNumChannels; ++c)
+        {
+            buffers[c] = static_cast<float*>(memoryLock.allocate(sizeof(float)*desiredNumFrames));
+
+            if (buffers[c] == nullptr)
+                throw std::bad_alloc();
+        }
+
+        numChannels = desiredNumChannels;
         numFrames = desiredNumFrames;
-        buffer[0] = new float[numFrames];
-        buffer[1] = new float[numFrames];
 
         reset();
     }
 
     void destroy() noexcept
     {
-        if (buffer[0] != nullptr)
+        if (buffers != nullptr)
         {
-            delete[] buffer[0];
-            buffer[0] = nullptr;
-        }
+            for (uint32_t c=0; c < numChannels; ++c)
+                CarlaMemoryLock::getInstance().deallocate(buffers[c]);
 
-        if (buffer[1] != nullptr)
-        {
-            delete[] buffer[1];
-            buffer[1] = nullptr;
+            delete[] buffers;
+            buffers = nullptr;
         }
 
         startFrame = 0;
+        numChannels = 0;
         numFrames = 0;
     }
 
@@ -89,14 +118,181 @@ struct AudioFilePool {
 
         if (numFrames != 0)
         {
-            carla_zeroFloats(buffer[0], numFrames);
-            carla_zeroFloats(buffer[1], numFrames);
+            for (uint32_t c=0; c < numChannels; ++c)
+                carla_zeroFloats(buffers[c], numFrames);
         }
     }
 
     CARLA_DECLARE_NON_COPY_STRUCT(AudioFilePool)
 };
 
+// windowed-sinc resampler, used by the reader thread to convert files to the engine sample rate
+class AudioFileResampler
+{
+public:
+    static const uint32_t kNumPhases = 512;
+    static const uint32_t kHalfTaps  = 16;
+
+    AudioFileResampler() noexcept
+        : fRatio(1.0),
+          fNumTaps(0),
+          fTable(nullptr) {}
+
+    ~AudioFileResampler() noexcept
+    {
+        clear();
+    }
+
+    void clear() noexcept
+    {
+        if (fTable != nullptr)
+        {
+            delete[] fTable;
+            fTable = nullptr;
+        }
+
+        fRatio = 1.0;
+        fNumTaps = 0;
+    }
+
+    bool isActive() const noexcept
+    {
+        return fTable != nullptr;
+    }
+
+    /*
+     * Prepare for converting 'inputRate' to 'outputRate'.
+     * Returns false (and stays inactive) if no conversion is needed.
+     */
+    bool setup(const uint32_t inputRate, const uint32_t outputRate)
+    {
+        clear();
+
+        if (inputRate == outputRate || inputRate == 0 || outputRate == 0)
+            return false;
+
+        fRatio = static_cast<double>(inputRate) / static_cast<double>(outputRate);
+
+        // when downsampling the cutoff follows the output nyquist, so the kernel gets wider
+        const double cutoff   = std::min(1.0, 1.0 / fRatio) * 0.95;
+        const uint32_t halfTaps = static_cast<uint32_t>(std::ceil(kHalfTaps / cutoff));
+
+        fNumTaps = halfTaps * 2;
+        fTable   = new float[(kNumPhases + 1) * fNumTaps];
+
+        // one kernel per fractional position, plus an extra phase for interpolating the last one
+        for (uint32_t k=0; k <= kNumPhases; ++k)
+        {
+            float* const kernel = fTable + k * fNumTaps;
+            const double frac = static_cast<double>(k) / kNumPhases;
+            double sum = 0.0;
+
+            for (uint32_t j=0; j < fNumTaps; ++j)
+            {
+                const double x = static_cast<double>(j) - halfTaps + 1 - frac;
+                const double w = x / halfTaps;
+                const double window = 0.42 + 0.5 * std::cos(M_PI * w) + 0.08 * std::cos(2.0 * M_PI * w);
+                const double sinc = carla_isZero(x) ? 1.0 : std::sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+                const double value = cutoff * sinc * window;
+
+                kernel[j] = static_cast<float>(value);
+                sum += value;
+            }
+
+            // unity gain at DC for every phase
+            for (uint32_t j=0; j < fNumTaps; ++j)
+                kernel[j] = static_cast<float>(kernel[j] / sum);
+        }
+
+        return true;
+    }
+
+    // number of output frames for a file of 'inputFrames' frames
+    uint64_t getOutputFrames(const uint64_t inputFrames) const noexcept
+    {
+        return static_cast<uint64_t>(std::ceil(static_cast<double>(inputFrames) / fRatio));
+    }
+
+    // first input frame needed to compute output frame 'outFrame'
+    int64_t getFirstInputFrame(const uint64_t outFrame) const noexcept
+    {
+        return static_cast<int64_t>(static_cast<double>(outFrame) * fRatio) - fNumTaps / 2 + 1;
+    }
+
+    // input frame after the last one needed to compute 'frames' output frames starting at 'outFrame'
+    int64_t getEndInputFrame(const uint64_t outFrame, const uint32_t frames) const noexcept
+    {
+        return static_cast<int64_t>(static_cast<double>(outFrame + frames - 1) * fRatio) + fNumTaps / 2 + 1;
+    }
+
+    // maximum input window size for 'frames' output frames
+    uint32_t getMaxInputFrames(const uint32_t frames) const noexcept
+    {
+        return static_cast<uint32_t>(std::ceil(frames * fRatio)) + fNumTaps + 2;
+    }
+
+    /*
+     * Compute 'frames' output samples starting at output frame 'outFrame'.
+     * 'input' holds 'inputFrames' samples starting at input frame 'inputStart', anything outside of it is treated as silence.
+     */
+    void process(const float* const input, const int64_t inputStart, const uint32_t inputFrames,
+                 const uint64_t outFrame, float* const out, const uint32_t frames) const noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(fTable != nullptr,);
+
+        const int64_t halfTaps = fNumTaps / 2;
+
+        for (uint32_t i=0; i < frames; ++i)
+        {
+            const double pos = static_cast<double>(outFrame + i) * fRatio;
+            const int64_t ipos = static_cast<int64_t>(pos);
+            const double phase = (pos - static_cast<double>(ipos)) * kNumPhases;
+            const uint32_t k = std::min(static_cast<uint32_t>(phase), kNumPhases - 1);
+            const float t = static_cast<float>(phase - k);
+
+            const float* const kernel0 = fTable + k * fNumTaps;
+            const float* const kernel1 = kernel0 + fNumTaps;
+            const int64_t first = ipos - halfTaps + 1 - inputStart;
+
+            float sum0 = 0.0f, sum1 = 0.0f;
+
+            if (first >= 0 && first + fNumTaps <= inputFrames)
+            {
+                // contiguous, simple enough for the compiler to vectorize
+                const float* const in = input + first;
+
+                for (uint32_t j=0; j < fNumTaps; ++j)
+                {
+                    sum0 += in[j] * kernel0[j];
+                    sum1 += in[j] * kernel1[j];
+                }
+            }
+            else
+            {
+                for (uint32_t j=0; j < fNumTaps; ++j)
+                {
+                    const int64_t index = first + j;
+
+                    if (index < 0 || index >= inputFrames)
+                        continue;
+
+                    sum0 += input[index] * kernel0[j];
+                    sum1 += input[index] * kernel1[j];
+                }
+            }
+
+            out[i] = sum0 + (sum1 - sum0) * t;
+        }
+    }
+
+private:
+    double fRatio; // input frames per output frame
+    uint32_t fNumTaps;
+    float* fTable;
+
+    CARLA_DECLARE_NON_COPY_CLASS(AudioFileResampler)
+};
+
 class AbstractAudioPlayer
 {
 public:
@@ -104,23 +300,112 @@ public:
     virtual uint64_t getLastFrame() const = 0;
 };
 
-class AudioFileThread : public CarlaThread
+class AudioFileReader;
+
+/*
+ * Single thread shared by all streaming audio file readers in the process.
+ * Reads one chunk at a time, always for the stream with the least audio buffered ahead of its playhead.
+ */
+class AudioFileReaderScheduler : public CarlaThread
+{
+public:
+    AudioFileReaderScheduler()
+        : CarlaThread("AudioFileReaderScheduler"),
+          fReaders(),
+          fMutex(),
+          fSem(),
+          fSemValid(carla_sem_create2(fSem, false))
+    {
+        if (fSemValid)
+            startThread();
+    }
+
+    ~AudioFileReaderScheduler() override
+    {
+        CARLA_SAFE_ASSERT(fReaders.isEmpty());
+
+        signalThreadShouldExit();
+        wakeUp();
+        stopThread(1000);
+
+        if (fSemValid)
+            carla_sem_destroy2(fSem);
+    }
+
+    bool isValid() const noexcept
+    {
+        return fSemValid;
+    }
+
+    void addReader(AudioFileReader* const reader)
+    {
+        {
+            const CarlaMutexLocker cml(fMutex);
+            fReaders.append(reader);
+        }
+
+        wakeUp();
+    }
+
+    // blocks until the reader is no longer being read from
+    void removeReader(AudioFileReader* const reader)
+    {
+        const CarlaMutexLocker cml(fMutex);
+        fReaders.removeOne(reader);
+    }
+
+    // safe to call from the audio thread
+    void wakeUp() noexcept
+    {
+        if (fSemValid)
+            carla_sem_post(fSem);
+    }
+
+protected:
+    void run() override;
+
+private:
+    LinkedList<AudioFileReader*> fReaders;
+    CarlaMutex fMutex;
+
+    carla_sem_t fSem;
+    bool fSemValid;
+
+    CARLA_DECLARE_NON_COPY_CLASS(AudioFileReaderScheduler)
+};
+
+class AudioFileReader
 {
 public:
-    AudioFileThread(AbstractAudioPlayer* const player)
-        : CarlaThread("AudioFileThread"),
-          kPlayer(player),
+    static const uint32_t kChunkFrames = 16384;
+
+    AudioFileReader(AbstractAudioPlayer* const player)
+        : kPlayer(player),
           fEntireFileLoaded(false),
           fLoopingMode(true),
           fNeedsRead(false),
-          fQuitNow(true),
+          fScheduled(false),
           fFilePtr(nullptr),
           fFileNfo(),
+          fFileReadPos(-1),
+          fNumChannels(0),
+          fNumInputFrames(0),
           fNumFileFrames(0),
-          fPollTempData(nullptr),
-          fPollTempSize(0),
+          fResampler(),
+          fPollPlanes(nullptr),
+          fInputBuffers(nullptr),
+          fInputCapacity(0),
+          fInputStart(0),
+          fInputFrames(0),
+          fChunks(nullptr),
+          fNumChunks(0),
+          fWantedChunks(nullptr),
+          fNumWantedChunks(0),
+          fNextChunk(-1),
+          fLastReadChunk(-1),
           fPool(),
-          fMutex()
+          fMutex(),
+          fScheduler()
     {
         CARLA_ASSERT(kPlayer != nullptr);
 
@@ -135,10 +420,9 @@ public:
         ad_clear_nfo(&fFileNfo);
     }
 
-    ~AudioFileThread() override
+    ~AudioFileReader()
     {
-        CARLA_ASSERT(fQuitNow);
-        CARLA_ASSERT(! isThreadRunning());
+        CARLA_ASSERT(! fScheduled);
 
         cleanup();
     }
@@ -153,32 +437,59 @@ public:
             fFilePtr = nullptr;
         }
 
-        if (fPollTempData != nullptr)
+        deallocateInput();
+
+        if (fChunks != nullptr)
+        {
+            for (uint32_t i=0; i < fNumChunks; ++i)
+            {
+                if (fChunks[i].buffers == nullptr)
+                    continue;
+
+                for (uint32_t c=0; c < fNumChannels; ++c)
+                    delete[] fChunks[i].buffers[c];
+
+                delete[] fChunks[i].buffers;
+            }
+
+            delete[] fChunks;
+            fChunks = nullptr;
+            fNumChunks = 0;
+        }
+
+        if (fWantedChunks != nullptr)
         {
-            delete[] fPollTempData;
-            fPollTempData = nullptr;
-            fPollTempSize = 0;
+            delete[] fWantedChunks;
+            fWantedChunks = nullptr;
         }
 
+        fFileReadPos = -1;
+        fNumChannels = 0;
+        fNumInputFrames = 0;
+        fNumWantedChunks = 0;
+        fNextChunk = -1;
+        fLastReadChunk = -1;
+
+        fResampler.clear();
         fPool.destroy();
     }
 
     void startNow()
     {
-        if (fPollTempData == nullptr)
+        if (fChunks == nullptr || fScheduled || ! fScheduler->isValid())
             return;
 
-        fNeedsRead = true;
-        fQuitNow = false;
-        startThread();
+        fScheduled = true;
+        fScheduler->addReader(this);
     }
 
     void stopNow()
     {
-        fNeedsRead = false;
-        fQuitNow = true;
-
-        stopThread(1000);
+        if (fScheduled)
+        {
+            fScheduler->removeReader(this);
+            fScheduled = false;
+        }
 
         const CarlaMutexLocker cml(fMutex);
         fPool.reset();
@@ -189,14 +500,15 @@ public:
         return fEntireFileLoaded;
     }
 
+    // number of frames at the engine sample rate
     uint32_t getMaxFrame() const noexcept
     {
         return fNumFileFrames;
     }
 
-    uint64_t getPoolStartFrame() const noexcept
+    uint32_t getPoolNumChannels() const noexcept
     {
-        return fPool.startFrame;
+        return fPool.numChannels;
     }
 
     uint32_t getPoolNumFrames() const noexcept
@@ -209,14 +521,17 @@ public:
         fLoopingMode = on;
     }
 
+    // wakes up the scheduler, safe to call from the audio thread
     void setNeedsRead() noexcept
     {
-        fNeedsRead = true;
+        // only post once per request, the scheduler clears the flag when it checks this reader
+        if (__sync_bool_compare_and_swap(&fNeedsRead, false, true))
+            fScheduler->wakeUp();
     }
 
     bool loadFilename(const char* const filename, const uint32_t sampleRate)
     {
-        CARLA_SAFE_ASSERT_RETURN(! isThreadRunning(), false);
+        CARLA_SAFE_ASSERT_RETURN(! fScheduled, false);
         CARLA_SAFE_ASSERT_RETURN(filename != nullptr && *filename != '\0', false);
 
         cleanup();
@@ -237,41 +552,71 @@ public:
         if (fFileNfo.frames <= 0)
             carla_stderr("L: filename \"%s\" has 0 frames", filename);
 
-        if ((fFileNfo.channels == 1 || fFileNfo.channels == 2) && fFileNfo.frames > 0)
+        if (fFileNfo.channels > 0 && fFileNfo.frames > 0 && fFileNfo.frames < INT32_MAX)
         {
             // valid
-            const uint32_t fileNumFrames = static_cast<uint32_t>(fFileNfo.frames);
+            fNumChannels = fFileNfo.channels;
+            fNumInputFrames = static_cast<uint32_t>(fFileNfo.frames);
+
+            // decode at the engine sample rate
+            uint64_t fileNumFrames = fNumInputFrames;
+
+            if (fResampler.setup(fFileNfo.sample_rate, sampleRate))
+                fileNumFrames = fResampler.getOutputFrames(fNumInputFrames);
+
+            if (fileNumFrames >= INT32_MAX)
+            {
+                carla_stderr("L: filename \"%s\" is too long", filename);
+                cleanup();
+                ad_clear_nfo(&fFileNfo);
+                return false;
+            }
+
+            fNumFileFrames = static_cast<uint32_t>(fileNumFrames);
+
             const uint32_t poolNumFrames = sampleRate * 5;
 
-            if (fileNumFrames <= poolNumFrames)
+            if (fNumFileFrames <= poolNumFrames)
             {
                 // entire file fits in a small pool, lets read it now
-                fPool.create(fileNumFrames);
+                fPool.create(fNumChannels, fNumFileFrames);
                 readEntireFileIntoPool();
                 ad_close(fFilePtr);
                 fFilePtr = nullptr;
+                return true;
             }
-            else
+
+            // file is too big for our audio pool, stream it in chunks ahead of the playhead
+            const uint32_t numChunks = (poolNumFrames + kChunkFrames - 1) / kChunkFrames + 1;
+
+            if (! allocateInput())
             {
-                // file is too big for our audio pool, we need an extra buffer
-                fPool.create(poolNumFrames);
+                cleanup();
+                ad_clear_nfo(&fFileNfo);
+                return false;
+            }
 
-                const size_t pollTempSize = poolNumFrames * fFileNfo.channels;
+            try {
+                fWantedChunks = new int32_t[numChunks];
+                fChunks = new AudioFileChunk[numChunks];
+                fNumChunks = numChunks;
 
-                try {
-                    fPollTempData = new float[pollTempSize];
-                } catch (...) {
-                    ad_close(fFilePtr);
-                    fFilePtr = nullptr;
-                    return false;
-                }
+                for (uint32_t i=0; i < numChunks; ++i)
+                {
+                    fChunks[i].buffers = new float*[fNumChannels];
+                    carla_zeroPointers(fChunks[i].buffers, fNumChannels);
 
-                fPollTempSize = pollTempSize;
+                    for (uint32_t c=0; c < fNumChannels; ++c)
+                        fChunks[i].buffers[c] = new float[kChunkFrames];
+                }
+            } catch (...) {
+                cleanup();
+                ad_clear_nfo(&fFileNfo);
+                return false;
             }
 
-            fNumFileFrames = fileNumFrames;
-
-            readPoll();
+            // prefill from the current position, so playback can start right away
+            fillChunks();
             return true;
         }
         else
@@ -287,250 +632,521 @@ public:
     void putAllData(AudioFilePool& pool)
     {
         CARLA_SAFE_ASSERT_RETURN(pool.numFrames == fPool.numFrames,);
+        CARLA_SAFE_ASSERT_RETURN(pool.numChannels == fPool.numChannels,);
 
         const CarlaMutexLocker cml(fMutex);
 
         pool.startFrame = fPool.startFrame;
-        carla_copyFloats(pool.buffer[0], fPool.buffer[0], fPool.numFrames);
-        carla_copyFloats(pool.buffer[1], fPool.buffer[1], fPool.numFrames);
+
+        for (uint32_t c=0; c < fPool.numChannels; ++c)
+            carla_copyFloats(pool.buffers[c], fPool.buffers[c], fPool.numFrames);
     }
 
-    bool tryPutData(AudioFilePool& pool, const uint64_t framePos, const uint32_t frames)
+    /*
+     * Copy streamed audio into 'numOutputs' buffers starting at 'framePos', following loop mode.
+     * Channels are mapped as in getAudioFileChannelForOutput().
+     * Never blocks, frames that are not buffered yet are zeroed and the reader thread is woken up.
+     * Returns false if any frame was missing.
+     */
+    bool readStream(float** const outs, const uint32_t numOutputs, const uint64_t framePos, const uint32_t frames) noexcept
     {
-        CARLA_SAFE_ASSERT_RETURN(pool.numFrames == fPool.numFrames, false);
+        CARLA_SAFE_ASSERT_RETURN(fChunks != nullptr && fNumFileFrames != 0, false);
 
-        if (framePos >= fPool.numFrames)
-            return false;
+        bool allFound = true;
+        int32_t firstChunk = -1;
 
-        const CarlaMutexLocker cml(fMutex);
-        /*
-        const CarlaMutexTryLocker cmtl(fMutex);
-        if (! cmtl.wasLocked())
-            return false;
-        */
+        for (uint32_t framesDone=0; framesDone < frames;)
+        {
+            uint64_t filePos = framePos + framesDone;
 
-        pool.startFrame = fPool.startFrame;
+            if (filePos >= fNumFileFrames)
+            {
+                if (! fLoopingMode)
+                {
+                    for (uint32_t i=0; i < numOutputs; ++i)
+                        carla_zeroFloats(outs[i]+framesDone, frames-framesDone);
+                    break;
+                }
 
-        carla_copyFloats(pool.buffer[0] + framePos, fPool.buffer[0] + framePos, frames);
-        carla_copyFloats(pool.buffer[1] + framePos, fPool.buffer[1] + framePos, frames);
+                filePos %= fNumFileFrames;
+            }
 
-        return true;
+            const uint32_t pos    = static_cast<uint32_t>(filePos);
+            const int32_t  index  = static_cast<int32_t>(pos / kChunkFrames);
+            const uint32_t offset = pos % kChunkFrames;
+            const uint32_t framesToDo = std::min(std::min(frames - framesDone, kChunkFrames - offset),
+                                                 fNumFileFrames - pos);
+
+            if (firstChunk == -1)
+                firstChunk = index;
+
+            if (! copyFromChunk(index, offset, outs, numOutputs, framesDone, framesToDo))
+            {
+                for (uint32_t i=0; i < numOutputs; ++i)
+                    carla_zeroFloats(outs[i]+framesDone, framesToDo);
+                allFound = false;
+            }
+
+            framesDone += framesToDo;
+        }
+
+        // request more data on misses, or as soon as the playhead enters a new chunk
+        if (! allFound || firstChunk != fLastReadChunk)
+        {
+            fLastReadChunk = firstChunk;
+            setNeedsRead();
+        }
+
+        return allFound;
     }
 
     void readEntireFileIntoPool()
     {
         CARLA_SAFE_ASSERT_RETURN(fPool.numFrames > 0,);
+        CARLA_SAFE_ASSERT_RETURN(fPool.numChannels == fNumChannels,);
 
-        const uint numChannels = fFileNfo.channels;
-        const size_t bufferSize = fPool.numFrames * numChannels;
-        float* const buffer = (float*)std::malloc(bufferSize*sizeof(float));
-        CARLA_SAFE_ASSERT_RETURN(buffer != nullptr,);
-
-        carla_zeroFloats(buffer, bufferSize);
-
-        ad_seek(fFilePtr, 0);
-        ssize_t rv = ad_read(fFilePtr, buffer, bufferSize);
-        CARLA_SAFE_ASSERT_INT2_RETURN(rv == static_cast<ssize_t>(bufferSize),
-                                      static_cast<int>(rv),
-                                      static_cast<int>(bufferSize),
-                                      std::free(buffer));
+        // decode in small blocks straight into the pool, no temporary copy of the whole file is needed
+        if (! allocateInput())
+            return;
 
         {
             // lock, and put data asap
             const CarlaMutexLocker cml(fMutex);
 
-            for (ssize_t i=0, j=0; j < rv; ++j)
-            {
-                if (numChannels == 1)
-                {
-                    fPool.buffer[0][i] = buffer[j];
-                    fPool.buffer[1][i] = buffer[j];
-                    ++i;
-                }
-                else
-                {
-                    if (j % 2 == 0)
-                    {
-                        fPool.buffer[0][i] = buffer[j];
-                    }
-                    else
-                    {
-                        fPool.buffer[1][i] = buffer[j];
-                        ++i;
-                    }
-                }
-            }
+            for (uint32_t frame=0; frame < fPool.numFrames; frame += kChunkFrames)
+                decodeFrames(frame, std::min(kChunkFrames, fPool.numFrames - frame), fPool.buffers, frame);
         }
 
-        std::free(buffer);
+        deallocateInput();
 
         fEntireFileLoaded = true;
     }
 
-    void readPoll()
+    /*
+     * Check if any chunk following the playhead still needs to be decoded, wrapping around the file end when looping.
+     * 'framesAhead' is set to how much audio is buffered before the first missing chunk, used for prioritizing streams.
+     * Called from the scheduler thread, followed by readNextChunk() if this returns true.
+     */
+    bool needsRead(uint32_t& framesAhead)
     {
-        if (fNumFileFrames == 0 || fFileNfo.channels == 0 || fFilePtr == nullptr)
+        fNeedsRead = false;
+        fNextChunk = -1;
+
+        uint32_t startOffset;
+
+        if (! updateWantedChunks(startOffset))
+            return false;
+
+        for (uint32_t i=0; i < fNumWantedChunks; ++i)
         {
-            carla_debug("R: no song loaded");
-            fNeedsRead = false;
-            return;
+            if (findChunk(fWantedChunks[i]) != nullptr)
+                continue;
+
+            fNextChunk = fWantedChunks[i];
+            framesAhead = i == 0 ? 0 : i * kChunkFrames - startOffset;
+            return true;
         }
-        if (fPollTempData == nullptr)
+
+        return false;
+    }
+
+    // decode the chunk found by needsRead(), reusing one outside of the read-ahead window
+    void readNextChunk()
+    {
+        CARLA_SAFE_ASSERT_RETURN(fNextChunk != -1,);
+
+        AudioFileChunk* const chunk = findFreeChunk(fNumWantedChunks);
+        CARLA_SAFE_ASSERT_RETURN(chunk != nullptr,);
+
+        readChunk(*chunk, fNextChunk);
+        fNextChunk = -1;
+    }
+
+private:
+    AbstractAudioPlayer* const kPlayer;
+
+    bool fEntireFileLoaded;
+    volatile bool fLoopingMode;
+    volatile bool fNeedsRead;
+    bool fScheduled;
+
+    void*  fFilePtr;
+    ADInfo fFileNfo;
+    int64_t fFileReadPos; // in file frames, -1 if unknown
+
+    uint32_t fNumChannels;
+    uint32_t fNumInputFrames; // at the file sample rate
+    uint32_t fNumFileFrames;  // at the engine sample rate
+
+    AudioFileResampler fResampler;
+
+    // per-channel decoding destinations, pointing into fInputBuffers
+    float** fPollPlanes;
+
+    // decoded file frames for the chunk being read, kept around for sequential reads
+    float**  fInputBuffers;
+    uint32_t fInputCapacity;
+    int64_t  fInputStart;
+    uint32_t fInputFrames;
+
+    AudioFileChunk* fChunks;
+    uint32_t fNumChunks;
+    int32_t* fWantedChunks; // scheduler thread only
+    uint32_t fNumWantedChunks;
+    int32_t fNextChunk;
+    int32_t fLastReadChunk; // audio thread only
+
+    AudioFilePool fPool;
+    CarlaMutex    fMutex;
+
+    water::SharedResourcePointer<AudioFileReaderScheduler> fScheduler;
+
+    /*
+     * List the chunks following the playhead, nearest first, in fWantedChunks.
+     * Returns false if there is nothing to read.
+     */
+    bool updateWantedChunks(uint32_t& startOffset) noexcept
+    {
+        fNumWantedChunks = 0;
+
+        if (fNumFileFrames == 0 || fFilePtr == nullptr || fChunks == nullptr)
         {
-            carla_debug("R: nothing to poll");
-            fNeedsRead = false;
-            return;
+            carla_debug("R: no song loaded");
+            return false;
         }
 
-        uint64_t lastFrame = kPlayer->getLastFrame();
-        int64_t readFrameCheck;
+        const uint64_t lastFrame = kPlayer->getLastFrame();
+        uint64_t startFrame;
 
         if (lastFrame >= fNumFileFrames)
         {
-            if (fLoopingMode)
-            {
-                const uint64_t readFrameCheckLoop = lastFrame % fNumFileFrames;
-                CARLA_SAFE_ASSERT_RETURN(readFrameCheckLoop < INT32_MAX,);
-
-                carla_debug("R: transport out of bounds for loop");
-                readFrameCheck = static_cast<int64_t>(readFrameCheckLoop);
-            }
-            else
+            if (! fLoopingMode)
             {
                 carla_debug("R: transport out of bounds");
-                fNeedsRead = false;
-                return;
+                return false;
             }
+
+            startFrame = lastFrame % fNumFileFrames;
         }
         else
         {
-            CARLA_SAFE_ASSERT_RETURN(lastFrame < INT32_MAX,);
-            readFrameCheck = static_cast<int64_t>(lastFrame);
+            startFrame = lastFrame;
         }
 
-        const int64_t readFrame = readFrameCheck;
+        const int32_t numFileChunks = static_cast<int32_t>((fNumFileFrames + kChunkFrames - 1) / kChunkFrames);
+        const int32_t startChunk = static_cast<int32_t>(startFrame / kChunkFrames);
 
-        // temp data buffer
-        carla_zeroFloats(fPollTempData, fPollTempSize);
+        startOffset = static_cast<uint32_t>(startFrame % kChunkFrames);
 
+        for (int32_t index = startChunk; fNumWantedChunks < fNumChunks;)
         {
-#if 0
-            const int32_t sampleRate = 44100;
-            carla_debug("R: poll data - reading at frame %li, time %li:%02li, lastFrame %li",
-                        readFrame, readFrame/sampleRate/60, (readFrame/sampleRate) % 60, lastFrame);
-#endif
-
-            ad_seek(fFilePtr, readFrame);
-            size_t i = 0;
-            ssize_t j = 0;
-            ssize_t rv = ad_read(fFilePtr, fPollTempData, fPollTempSize);
+            fWantedChunks[fNumWantedChunks++] = index;
 
-            if (rv < 0)
+            if (++index == numFileChunks)
             {
-                carla_stderr("R: ad_read failed");
-                fNeedsRead = false;
-                return;
+                if (! fLoopingMode)
+                    break;
+                index = 0;
             }
 
-            const size_t urv = static_cast<size_t>(rv);
+            if (index == startChunk)
+                break;
+        }
 
-            // see if we can read more
-            if (readFrame + rv >= static_cast<ssize_t>(fFileNfo.frames) && urv < fPollTempSize)
+        return true;
+    }
+
+    // decode the whole read-ahead window, only used before the reader is scheduled
+    void fillChunks()
+    {
+        uint32_t framesAhead;
+
+        while (needsRead(framesAhead))
+            readNextChunk();
+    }
+
+    // audio thread side, the reader marks chunks invalid before writing to them
+    bool copyFromChunk(const int32_t index, const uint32_t offset,
+                       float** const outs, const uint32_t numOutputs,
+                       const uint32_t outOffset, const uint32_t frames) const noexcept
+    {
+        for (uint32_t i=0; i < fNumChunks; ++i)
+        {
+            const AudioFileChunk& chunk(fChunks[i]);
+
+            if (chunk.index != index)
+                continue;
+
+            __sync_synchronize();
+
+            for (uint32_t i=0; i < numOutputs; ++i)
             {
-                carla_debug("R: from start");
-                ad_seek(fFilePtr, 0);
-                rv += ad_read(fFilePtr, fPollTempData+urv, fPollTempSize-urv);
+                const int32_t c = getAudioFileChannelForOutput(fNumChannels, i);
+
+                if (c >= 0)
+                    carla_copyFloats(outs[i] + outOffset, chunk.buffers[c] + offset, frames);
+                else
+                    carla_zeroFloats(outs[i] + outOffset, frames);
             }
 
-            // lock, and put data asap
-            const CarlaMutexLocker cml(fMutex);
+            __sync_synchronize();
 
-            do {
-                for (; i < fPool.numFrames && j < rv; ++j)
-                {
-                    if (fFileNfo.channels == 1)
-                    {
-                        fPool.buffer[0][i] = fPollTempData[j];
-                        fPool.buffer[1][i] = fPollTempData[j];
-                        i++;
-                    }
-                    else
-                    {
-                        if (j % 2 == 0)
-                        {
-                            fPool.buffer[0][i] = fPollTempData[j];
-                        }
-                        else
-                        {
-                            fPool.buffer[1][i] = fPollTempData[j];
-                            i++;
-                        }
-                    }
-                }
+            // chunk was replaced while copying
+            return chunk.index == index;
+        }
 
-                if (i >= fPool.numFrames)
-                    break;
+        return false;
+    }
 
-                if (rv == fFileNfo.frames)
-                {
-                    // full file read
-                    j = 0;
-                    carla_debug("R: full file was read, filling buffers again");
-                }
-                else
-                {
-                    carla_debug("read break, not enough space");
+    AudioFileChunk* findChunk(const int32_t index) const noexcept
+    {
+        for (uint32_t i=0; i < fNumChunks; ++i)
+        {
+            if (fChunks[i].index == index)
+                return &fChunks[i];
+        }
 
-                    carla_zeroFloats(fPool.buffer[0] + i, fPool.numFrames - i);
-                    carla_zeroFloats(fPool.buffer[1] + i, fPool.numFrames - i);
+        return nullptr;
+    }
+
+    // find a chunk that is empty or not part of the current read-ahead window
+    AudioFileChunk* findFreeChunk(const uint32_t numWanted) const noexcept
+    {
+        for (uint32_t i=0; i < fNumChunks; ++i)
+        {
+            const int32_t index = fChunks[i].index;
+
+            if (index == -1)
+                return &fChunks[i];
+
+            bool wanted = false;
+
+            for (uint32_t j=0; j < numWanted; ++j)
+            {
+                if (fWantedChunks[j] == index)
+                {
+                    wanted = true;
                     break;
                 }
+            }
+
+            if (! wanted)
+                return &fChunks[i];
+        }
+
+        return nullptr;
+    }
 
-            } while (i < fPool.numFrames);
+    // decode 'frames' file frames into the input buffers at 'offset', returns the number of frames read
+    uint32_t readInput(const uint32_t offset, const uint32_t frames)
+    {
+        for (uint32_t c=0; c < fNumChannels; ++c)
+            fPollPlanes[c] = fInputBuffers[c] + offset;
+
+        const ssize_t rv = ad_read_planar(fFilePtr, fPollPlanes, frames);
 
-            fPool.startFrame = lastFrame;
+        if (rv < 0)
+        {
+            carla_stderr("R: ad_read_planar failed");
+            fFileReadPos = -1;
+            return 0;
         }
 
-        fNeedsRead = false;
+        // never trust the decoder to stay within the requested size, callers zero-fill past what is returned
+        CARLA_SAFE_ASSERT_UINT2(static_cast<uint64_t>(rv) <= frames, static_cast<uint>(rv), frames);
+
+        const uint32_t framesRead = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(rv), frames));
+        fFileReadPos += framesRead;
+        return framesRead;
     }
 
-protected:
-    void run() override
+    // make the input buffers hold file frames [first, end), reusing what was read for the previous chunk
+    void fillInput(const int64_t first, const int64_t end)
+    {
+        if (end < first || end - first > fInputCapacity)
+        {
+            carla_safe_assert("end >= first && end - first <= fInputCapacity", __FILE__, __LINE__);
+            // nothing valid to copy from, the caller zero-fills the block
+            fInputStart  = first;
+            fInputFrames = 0;
+            return;
+        }
+
+        const int64_t inputEnd = fInputStart + fInputFrames;
+        uint32_t framesKept = 0;
+
+        if (fInputFrames != 0 && first >= fInputStart && first <= inputEnd && fFileReadPos == inputEnd)
+        {
+            framesKept = static_cast<uint32_t>(inputEnd - first);
+
+            if (const uint32_t offset = static_cast<uint32_t>(first - fInputStart))
+            {
+                for (uint32_t c=0; c < fNumChannels; ++c)
+                    std::memmove(fInputBuffers[c], fInputBuffers[c] + offset, framesKept*sizeof(float));
+            }
+        }
+        // avoid seeking during sequential reads, it is expensive for some formats
+        else if (fFileReadPos != first)
+        {
+            fFileReadPos = ad_seek(fFilePtr, first);
+        }
+
+        fInputStart  = first;
+        fInputFrames = framesKept;
+
+        if (end > first + framesKept && fFileReadPos == first + framesKept)
+            fInputFrames += readInput(framesKept, static_cast<uint32_t>(end - first - framesKept));
+    }
+
+    /*
+     * Decode 'numFrames' frames at the engine sample rate starting at 'frame',
+     * writing each channel into 'buffers' at 'offset'. Frames past the end of the file are zeroed.
+     */
+    void decodeFrames(const uint64_t frame, const uint32_t numFrames, float* const* const buffers, const uint32_t offset)
     {
-        const uint64_t numFramesNearEnd = fPool.numFrames*3/4;
-        uint64_t lastFrame;
+        // file frames needed for this block
+        int64_t first, end;
 
-        while (! fQuitNow)
+        if (fResampler.isActive())
         {
-            lastFrame = kPlayer->getLastFrame();
+            first = std::max<int64_t>(fResampler.getFirstInputFrame(frame), 0);
+            end   = std::min<int64_t>(fResampler.getEndInputFrame(frame, numFrames), fNumInputFrames);
+        }
+        else
+        {
+            first = static_cast<int64_t>(frame);
+            end   = static_cast<int64_t>(frame + numFrames);
+        }
+
+        fillInput(first, end);
 
-            if (fNeedsRead || lastFrame < fPool.startFrame || lastFrame - fPool.startFrame >= numFramesNearEnd)
-                readPoll();
+        for (uint32_t c=0; c < fNumChannels; ++c)
+        {
+            float* const buffer = buffers[c] + offset;
+            uint32_t framesDone;
 
-            carla_msleep(50);
+            if (fResampler.isActive())
+            {
+                fResampler.process(fInputBuffers[c], fInputStart, fInputFrames, frame, buffer, numFrames);
+                framesDone = numFrames;
+            }
+            else
+            {
+                framesDone = std::min(numFrames, fInputFrames);
+                carla_copyFloats(buffer, fInputBuffers[c], framesDone);
+            }
+
+            if (framesDone < numFrames)
+                carla_zeroFloats(buffer + framesDone, numFrames - framesDone);
         }
     }
 
-private:
-    AbstractAudioPlayer* const kPlayer;
+    void readChunk(AudioFileChunk& chunk, const int32_t index)
+    {
+        const uint64_t frame = static_cast<uint64_t>(index) * kChunkFrames;
+        const uint32_t numFrames = static_cast<uint32_t>(std::min<uint64_t>(kChunkFrames, fNumFileFrames - frame));
 
-    bool fEntireFileLoaded;
-    bool fLoopingMode;
-    volatile bool fNeedsRead;
-    volatile bool fQuitNow;
+        chunk.index = -1;
+        __sync_synchronize();
 
-    void*  fFilePtr;
-    ADInfo fFileNfo;
+        decodeFrames(frame, numFrames, chunk.buffers, 0);
 
-    uint32_t fNumFileFrames;
+        if (numFrames < kChunkFrames)
+        {
+            for (uint32_t c=0; c < fNumChannels; ++c)
+                carla_zeroFloats(chunk.buffers[c] + numFrames, kChunkFrames - numFrames);
+        }
 
-    float* fPollTempData;
-    size_t fPollTempSize;
+        __sync_synchronize();
+        chunk.index = index;
+    }
 
-    AudioFilePool fPool;
-    CarlaMutex    fMutex;
+    // buffers for decoding one chunk worth of engine frames
+    bool allocateInput()
+    {
+        CARLA_SAFE_ASSERT_RETURN(fInputBuffers == nullptr, false);
+
+        const uint32_t inputCapacity = fResampler.isActive() ? fResampler.getMaxInputFrames(kChunkFrames)
+                                                             : kChunkFrames;
+        try {
+            fPollPlanes = new float*[fNumChannels];
+
+            fInputBuffers = new float*[fNumChannels];
+            carla_zeroPointers(fInputBuffers, fNumChannels);
+            fInputCapacity = inputCapacity;
+
+            for (uint32_t c=0; c < fNumChannels; ++c)
+                fInputBuffers[c] = new float[inputCapacity];
+        } catch (...) {
+            deallocateInput();
+            return false;
+        }
+
+        return true;
+    }
+
+    void deallocateInput() noexcept
+    {
+        if (fPollPlanes != nullptr)
+        {
+            delete[] fPollPlanes;
+            fPollPlanes = nullptr;
+        }
+
+        if (fInputBuffers != nullptr)
+        {
+            for (uint32_t c=0; c < fNumChannels; ++c)
+                delete[] fInputBuffers[c];
+
+            delete[] fInputBuffers;
+            fInputBuffers = nullptr;
+            fInputCapacity = 0;
+        }
+
+        fInputStart = 0;
+        fInputFrames = 0;
+    }
 
-    CARLA_DECLARE_NON_COPY_STRUCT(AudioFileThread)
+    CARLA_DECLARE_NON_COPY_STRUCT(AudioFileReader)
 };
 
+// -----------------------------------------------------------------------
+
+inline void AudioFileReaderScheduler::run()
+{
+    while (! shouldThreadExit())
+    {
+        // keep reading while any stream is missing data, most urgent one first
+        while (! shouldThreadExit())
+        {
+            const CarlaMutexLocker cml(fMutex);
+
+            AudioFileReader* nextReader = nullptr;
+            uint32_t nextFramesAhead = UINT32_MAX;
+
+            for (LinkedList<AudioFileReader*>::Itenerator it = fReaders.begin2(); it.valid(); it.next())
+            {
+                AudioFileReader* const reader(it.getValue(nullptr));
+                CARLA_SAFE_ASSERT_CONTINUE(reader != nullptr);
+
+                uint32_t framesAhead;
+
+                if (reader->needsRead(framesAhead) && (nextReader == nullptr || framesAhead < nextFramesAhead))
+                {
+                    nextReader = reader;
+                    nextFramesAhead = framesAhead;
+                }
+            }
+
+            if (nextReader == nullptr)
+                break;
+
+            // other readers keep their pending chunk, it is looked up again on the next round
+            nextReader->readNextChunk();
+        }
+
+        carla_sem_timedwait(fSem, 50);
+    }
+}
+
 #endif // AUDIO_BASE_HPP_INCLUDED
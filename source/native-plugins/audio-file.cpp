@@ -54,19 +54,21 @@ class AudioFilePlugin : public NativePluginClass,
 #endif
 {
 public:
-    AudioFilePlugin(const NativeHostDescriptor* const host)
+    AudioFilePlugin(const NativeHostDescriptor* const host, const uint32_t numOutputs = 2)
 #ifdef HAVE_PYQT
-        : NativePluginWithMidiPrograms<FileAudio>(host, fPrograms, 2),
+        : NativePluginWithMidiPrograms<FileAudio>(host, fPrograms, numOutputs),
 #else
         : NativePluginClass(host),
 #endif
           AbstractAudioPlayer(),
+          kNumOutputs(numOutputs),
           fLoopMode(true),
           fDoProcess(false),
           fLastFrame(0),
           fMaxFrame(0),
           fPool(),
-          fThread(this)
+          fReader(this),
+          fFilename()
 #ifdef HAVE_PYQT
         , fPrograms(hostGetFilePath("audio"), audiofilesWildcard),
           fInlineDisplay()
@@ -76,7 +78,7 @@ public:
 
     ~AudioFilePlugin() override
     {
-        fThread.stopNow();
+        fReader.stopNow();
         fPool.destroy();
     }
 
@@ -138,8 +140,8 @@ protected:
             return;
 
         fLoopMode = b;
-        fThread.setLoopingMode(b);
-        fThread.setNeedsRead();
+        fReader.setLoopingMode(b);
+        fReader.setNeedsRead();
     }
 
     void setCustomData(const char* const key, const char* const value) override
@@ -161,15 +163,11 @@ protected:
     {
         const NativeTimeInfo* const timePos(getTimeInfo());
 
-        float* out1 = outBuffer[0];
-        float* out2 = outBuffer[1];
-
         if (! fDoProcess)
         {
             //carla_stderr("P: no process");
             fLastFrame = timePos->frame;
-            carla_zeroFloats(out1, frames);
-            carla_zeroFloats(out2, frames);
+            zeroOutputs(outBuffer, 0, frames);
             return;
         }
 
@@ -177,24 +175,20 @@ protected:
         if (! timePos->playing)
         {
             //carla_stderr("P: not playing");
-            if (timePos->frame == 0 && fLastFrame > 0)
-                fThread.setNeedsRead();
+            // let the reader follow relocations while stopped
+            if (timePos->frame != fLastFrame && ! fReader.isEntireFileLoaded())
+                fReader.setNeedsRead();
 
             fLastFrame = timePos->frame;
-            carla_zeroFloats(out1, frames);
-            carla_zeroFloats(out2, frames);
+            zeroOutputs(outBuffer, 0, frames);
             return;
         }
 
         // out of reach
-        if ((timePos->frame < fPool.startFrame || timePos->frame >= fMaxFrame) && !fLoopMode)
+        if (timePos->frame >= fMaxFrame && !fLoopMode)
         {
-            if (timePos->frame < fPool.startFrame)
-                fThread.setNeedsRead();
-
             fLastFrame = timePos->frame;
-            carla_zeroFloats(out1, frames);
-            carla_zeroFloats(out2, frames);
+            zeroOutputs(outBuffer, 0, frames);
 
 #ifdef HAVE_PYQT
             if (fInlineDisplay.writtenValues < 32)
@@ -213,7 +207,7 @@ protected:
             return;
         }
 
-        if (fThread.isEntireFileLoaded())
+        if (fReader.isEntireFileLoaded())
         {
             // NOTE: timePos->frame is always < fMaxFrame (or looping)
             uint32_t targetStartFrame = static_cast<uint32_t>(fLoopMode ? timePos->frame % fMaxFrame : timePos->frame);
@@ -223,14 +217,12 @@ protected:
                 if (targetStartFrame + framesToDo <= fMaxFrame)
                 {
                     // everything fits together
-                    carla_copyFloats(out1+framesDone, fPool.buffer[0]+targetStartFrame, framesToDo);
-                    carla_copyFloats(out2+framesDone, fPool.buffer[1]+targetStartFrame, framesToDo);
+                    copyFromPool(outBuffer, framesDone, targetStartFrame, framesToDo);
                     break;
                 }
 
                 remainingFrames = std::min(fMaxFrame - targetStartFrame, framesToDo);
-                carla_copyFloats(out1+framesDone, fPool.buffer[0]+targetStartFrame, remainingFrames);
-                carla_copyFloats(out2+framesDone, fPool.buffer[1]+targetStartFrame, remainingFrames);
+                copyFromPool(outBuffer, framesDone, targetStartFrame, remainingFrames);
                 framesDone += remainingFrames;
                 framesToDo -= remainingFrames;
 
@@ -238,10 +230,7 @@ protected:
                 {
                     // not looping, stop here
                     if (framesToDo != 0)
-                    {
-                        carla_zeroFloats(out1+framesDone, framesToDo);
-                        carla_zeroFloats(out2+framesDone, framesToDo);
-                    }
+                        zeroOutputs(outBuffer, framesDone, framesToDo);
                     break;
                 }
 
@@ -251,26 +240,16 @@ protected:
         }
         else
         {
-            // NOTE: timePos->frame is always >= fPool.startFrame
-            const uint64_t poolStartFrame = timePos->frame - fThread.getPoolStartFrame();
-
-            if (fThread.tryPutData(fPool, poolStartFrame, frames))
-            {
-                carla_copyFloats(out1, fPool.buffer[0]+poolStartFrame, frames);
-                carla_copyFloats(out2, fPool.buffer[1]+poolStartFrame, frames);
-            }
-            else
-            {
-                carla_zeroFloats(out1, frames);
-                carla_zeroFloats(out2, frames);
-            }
+            // reader thread follows the playhead, must be set before reading
+            fLastFrame = timePos->frame;
+            fReader.readStream(outBuffer, kNumOutputs, timePos->frame, frames);
         }
 
 #ifdef HAVE_PYQT
         if (fInlineDisplay.writtenValues < 32)
         {
-            fInlineDisplay.lastValuesL[fInlineDisplay.writtenValues] = carla_findMaxNormalizedFloat(out1, frames);
-            fInlineDisplay.lastValuesR[fInlineDisplay.writtenValues] = carla_findMaxNormalizedFloat(out2, frames);
+            fInlineDisplay.lastValuesL[fInlineDisplay.writtenValues] = carla_findMaxNormalizedFloat(outBuffer[0], frames);
+            fInlineDisplay.lastValuesR[fInlineDisplay.writtenValues] = carla_findMaxNormalizedFloat(outBuffer[1], frames);
             ++fInlineDisplay.writtenValues;
         }
 
@@ -284,6 +263,19 @@ protected:
         fLastFrame = timePos->frame;
     }
 
+    // -------------------------------------------------------------------
+    // Plugin dispatcher calls
+
+    void sampleRateChanged(const double) override
+    {
+        // files are decoded at the engine sample rate, so they need to be read again
+        if (fFilename.isEmpty())
+            return;
+
+        const CarlaString filename(fFilename);
+        loadFilename(filename);
+    }
+
     // -------------------------------------------------------------------
     // Plugin UI calls
 
@@ -318,11 +310,9 @@ protected:
 
         const uint32_t width = rwidth == height ? height * 4 : rwidth;
 
-        /* NOTE the code is this function is not optimized, still learning my way through pixels...
-         */
         const size_t stride = width * 4;
         const size_t dataSize = stride * height;
-        const uint pxToMove = fDoProcess ? fInlineDisplay.writtenValues : 0;
+        const uint pxToMove = fDoProcess ? std::min<uint>(fInlineDisplay.writtenValues, width) : 0;
 
         uchar* data = fInlineDisplay.data;
 
@@ -336,10 +326,9 @@ protected:
         }
         else if (pxToMove != 0)
         {
-            // shift all previous values to the left
-            for (uint w=0; w < width - pxToMove; ++w)
-                for (uint h=0; h < height; ++h)
-                    std::memmove(&data[h * stride + w * 4], &data[h * stride + (w+pxToMove) * 4], 4);
+            // shift all previous values to the left, one row at a time
+            for (uint h=0; h < height; ++h)
+                std::memmove(&data[h * stride], &data[h * stride + pxToMove * 4], (width - pxToMove) * 4);
         }
 
         fInlineDisplay.width  = static_cast<int>(width);
@@ -349,71 +338,19 @@ protected:
         if (pxToMove != 0)
         {
             const uint h2 = height / 2;
+            const uint firstNewColumn = width - pxToMove;
 
-            // clear current line
-            for (uint w=width-pxToMove; w < width; ++w)
-                for (uint h=0; h < height; ++h)
-                    memset(&data[h * stride + w * 4], 0, 4);
+            // clear the new columns, everything else was already drawn
+            for (uint h=0; h < height; ++h)
+                std::memset(&data[h * stride + firstNewColumn * 4], 0, pxToMove * 4);
 
-            // draw upper/left
+            // draw upper/left and lower/right halves of each new column
             for (uint i=0; i < pxToMove && i < 32; ++i)
             {
-                const float valueL = fInlineDisplay.lastValuesL[i];
-                const float valueR = fInlineDisplay.lastValuesR[i];
-
-                const uint h2L = static_cast<uint>(valueL * (float)h2);
-                const uint h2R = static_cast<uint>(valueR * (float)h2);
-                const uint w   = width - pxToMove + i;
+                const uint w = firstNewColumn + i;
 
-                for (uint h=0; h < h2L; ++h)
-                {
-                    // -30dB
-                    //if (valueL < 0.032f)
-                    //    continue;
-
-                    data[(h2 - h) * stride + w * 4 + 3] = 160;
-
-                    // -12dB
-                    if (valueL < 0.25f)
-                    {
-                        data[(h2 - h) * stride + w * 4 + 1] = 255;
-                    }
-                    // -3dB
-                    else if (valueL < 0.70f)
-                    {
-                        data[(h2 - h) * stride + w * 4 + 2] = 255;
-                        data[(h2 - h) * stride + w * 4 + 1] = 255;
-                    }
-                    else
-                    {
-                        data[(h2 - h) * stride + w * 4 + 2] = 255;
-                    }
-                }
-
-                for (uint h=0; h < h2R; ++h)
-                {
-                    // -30dB
-                    //if (valueR < 0.032f)
-                    //    continue;
-
-                    data[(h2 + h) * stride + w * 4 + 3] = 160;
-
-                    // -12dB
-                    if (valueR < 0.25f)
-                    {
-                        data[(h2 + h) * stride + w * 4 + 1] = 255;
-                    }
-                    // -3dB
-                    else if (valueR < 0.70f)
-                    {
-                        data[(h2 + h) * stride + w * 4 + 2] = 255;
-                        data[(h2 + h) * stride + w * 4 + 1] = 255;
-                    }
-                    else
-                    {
-                        data[(h2 + h) * stride + w * 4 + 2] = 255;
-                    }
-                }
+                drawInlineDisplayColumn(data + w * 4, h2, stride, -1, fInlineDisplay.lastValuesL[i]);
+                drawInlineDisplayColumn(data + w * 4, h2, stride, 1, fInlineDisplay.lastValuesR[i]);
             }
         }
 
@@ -426,6 +363,8 @@ protected:
     // -------------------------------------------------------------------
 
 private:
+    const uint32_t kNumOutputs;
+
     bool fLoopMode;
     bool fDoProcess;
 
@@ -433,7 +372,8 @@ private:
     uint32_t fMaxFrame;
 
     AudioFilePool   fPool;
-    AudioFileThread fThread;
+    AudioFileReader fReader;
+    CarlaString     fFilename;
 
 #ifdef HAVE_PYQT
     NativeMidiPrograms fPrograms;
@@ -473,13 +413,67 @@ private:
     } fInlineDisplay;
 #endif
 
+#ifdef HAVE_PYQT
+    // draw a single meter column of 'value' starting at row 'h2' and growing in 'direction'
+    static void drawInlineDisplayColumn(uchar* const column, const uint h2, const size_t stride,
+                                        const int direction, const float value) noexcept
+    {
+        const uint size = std::min(h2, static_cast<uint>(value * (float)h2));
+
+        // -12dB green, -3dB yellow, red above that
+        uchar pixel[4] = { 0, 0, 0, 160 };
+
+        if (value < 0.25f)
+        {
+            pixel[1] = 255;
+        }
+        else if (value < 0.70f)
+        {
+            pixel[1] = 255;
+            pixel[2] = 255;
+        }
+        else
+        {
+            pixel[2] = 255;
+        }
+
+        for (uint h=0; h < size; ++h)
+        {
+            const uint y = direction < 0 ? h2 - h : h2 + h;
+            std::memcpy(&column[y * stride], pixel, 4);
+        }
+    }
+#endif
+
+    void zeroOutputs(float** const outBuffer, const uint32_t offset, const uint32_t frames) const noexcept
+    {
+        for (uint32_t i=0; i < kNumOutputs; ++i)
+            carla_zeroFloats(outBuffer[i]+offset, frames);
+    }
+
+    // copy 'frames' from the pool starting at 'poolFrame', one file channel per output
+    void copyFromPool(float** const outBuffer, const uint32_t offset,
+                      const uint32_t poolFrame, const uint32_t frames) const noexcept
+    {
+        for (uint32_t i=0; i < kNumOutputs; ++i)
+        {
+            const int32_t c = getAudioFileChannelForOutput(fPool.numChannels, i);
+
+            if (c >= 0)
+                carla_copyFloats(outBuffer[i]+offset, fPool.buffers[c]+poolFrame, frames);
+            else
+                carla_zeroFloats(outBuffer[i]+offset, frames);
+        }
+    }
+
     void loadFilename(const char* const filename)
     {
         CARLA_ASSERT(filename != nullptr);
         carla_debug("AudioFilePlugin::loadFilename(\"%s\")", filename);
 
-        fThread.stopNow();
+        fReader.stopNow();
         fPool.destroy();
+        fFilename = filename;
 
         if (filename == nullptr || *filename == '\0')
         {
@@ -488,15 +482,19 @@ private:
             return;
         }
 
-        if (fThread.loadFilename(filename, static_cast<uint32_t>(getSampleRate())))
+        if (fReader.loadFilename(filename, static_cast<uint32_t>(getSampleRate())))
         {
-            fPool.create(fThread.getPoolNumFrames());
-            fMaxFrame = fThread.getMaxFrame();
+            fMaxFrame = fReader.getMaxFrame();
 
-            if (fThread.isEntireFileLoaded())
-                fThread.putAllData(fPool);
+            if (fReader.isEntireFileLoaded())
+            {
+                fPool.create(fReader.getPoolNumChannels(), fReader.getPoolNumFrames());
+                fReader.putAllData(fPool);
+            }
             else
-                fThread.startNow();
+            {
+                fReader.startNow();
+            }
 
             fDoProcess = true;
         }
@@ -513,6 +511,19 @@ private:
 
 // -----------------------------------------------------------------------
 
+// Multi-channel variants, each file channel goes to its own output and is still decoded only once
+template <uint32_t numOutputs>
+class AudioFileMultiChannelPlugin : public AudioFilePlugin
+{
+public:
+    AudioFileMultiChannelPlugin(const NativeHostDescriptor* const host)
+        : AudioFilePlugin(host, numOutputs) {}
+
+    PluginClassEND(AudioFileMultiChannelPlugin)
+};
+
+// -----------------------------------------------------------------------
+
 static const NativePluginDescriptor audiofileDesc = {
     /* category  */ NATIVE_PLUGIN_CATEGORY_UTILITY,
     /* hints     */ static_cast<NativePluginHints>(NATIVE_PLUGIN_IS_RTSAFE
@@ -537,6 +548,54 @@ static const NativePluginDescriptor audiofileDesc = {
     PluginDescriptorFILL(AudioFilePlugin)
 };
 
+static const NativePluginDescriptor audiofile8Desc = {
+    /* category  */ NATIVE_PLUGIN_CATEGORY_UTILITY,
+    /* hints     */ static_cast<NativePluginHints>(NATIVE_PLUGIN_IS_RTSAFE
+                                                  |NATIVE_PLUGIN_HAS_UI
+#ifdef HAVE_PYQT
+                                                  |NATIVE_PLUGIN_HAS_INLINE_DISPLAY
+                                                  |NATIVE_PLUGIN_REQUESTS_IDLE
+#endif
+                                                  |NATIVE_PLUGIN_NEEDS_UI_OPEN_SAVE
+                                                  |NATIVE_PLUGIN_USES_TIME),
+    /* supports  */ NATIVE_PLUGIN_SUPPORTS_NOTHING,
+    /* audioIns  */ 0,
+    /* audioOuts */ 8,
+    /* midiIns   */ 0,
+    /* midiOuts  */ 0,
+    /* paramIns  */ 1,
+    /* paramOuts */ 0,
+    /* name      */ "Audio File (8 channels)",
+    /* label     */ "audiofile_8",
+    /* maker     */ "falkTX",
+    /* copyright */ "GNU GPL v2+",
+    PluginDescriptorFILL(AudioFileMultiChannelPlugin<8>)
+};
+
+static const NativePluginDescriptor audiofile16Desc = {
+    /* category  */ NATIVE_PLUGIN_CATEGORY_UTILITY,
+    /* hints     */ static_cast<NativePluginHints>(NATIVE_PLUGIN_IS_RTSAFE
+                                                  |NATIVE_PLUGIN_HAS_UI
+#ifdef HAVE_PYQT
+                                                  |NATIVE_PLUGIN_HAS_INLINE_DISPLAY
+                                                  |NATIVE_PLUGIN_REQUESTS_IDLE
+#endif
+                                                  |NATIVE_PLUGIN_NEEDS_UI_OPEN_SAVE
+                                                  |NATIVE_PLUGIN_USES_TIME),
+    /* supports  */ NATIVE_PLUGIN_SUPPORTS_NOTHING,
+    /* audioIns  */ 0,
+    /* audioOuts */ 16,
+    /* midiIns   */ 0,
+    /* midiOuts  */ 0,
+    /* paramIns  */ 1,
+    /* paramOuts */ 0,
+    /* name      */ "Audio File (16 channels)",
+    /* label     */ "audiofile_16",
+    /* maker     */ "falkTX",
+    /* copyright */ "GNU GPL v2+",
+    PluginDescriptorFILL(AudioFileMultiChannelPlugin<16>)
+};
+
 // -----------------------------------------------------------------------
 
 CARLA_EXPORT
@@ -546,6 +605,8 @@ CARLA_EXPORT
 void carla_register_native_plugin_audiofile()
 {
     carla_register_native_plugin(&audiofileDesc);
+    carla_register_native_plugin(&audiofile8Desc);
+    carla_register_native_plugin(&audiofile16Desc);
 }
 
 // -----------------------------------------------------------------------
@@ -247,7 +247,7 @@ static intptr_t audiogain_dispatcher(NativePluginHandle handle, NativePluginDisp
 
 static const NativePluginDescriptor audiogainMonoDesc = {
     .category  = NATIVE_PLUGIN_CATEGORY_UTILITY,
-    .hints     = NATIVE_PLUGIN_IS_RTSAFE,
+    .hints     = NATIVE_PLUGIN_IS_RTSAFE|NATIVE_PLUGIN_IS_INPLACE_SAFE,
     .supports  = NATIVE_PLUGIN_SUPPORTS_NOTHING,
     .audioIns  = 1,
     .audioOuts = 1,
@@ -295,7 +295,7 @@ static const NativePluginDescriptor audiogainMonoDesc = {
 
 static const NativePluginDescriptor audiogainStereoDesc = {
     .category  = NATIVE_PLUGIN_CATEGORY_UTILITY,
-    .hints     = NATIVE_PLUGIN_IS_RTSAFE,
+    .hints     = NATIVE_PLUGIN_IS_RTSAFE|NATIVE_PLUGIN_IS_INPLACE_SAFE,
     .supports  = NATIVE_PLUGIN_SUPPORTS_NOTHING,
     .audioIns  = 2,
     .audioOuts = 2,
@@ -21,8 +21,15 @@
 #include "CarlaNativeExtUI.hpp"
 
 #include "water/maths/MathsFunctions.h"
+#include "water/misc/Time.h"
 
 using water::roundToIntAccurate;
+using water::Time;
+
+// -----------------------------------------------------------------------
+
+// minimum time between meter updates sent to the UI, in milliseconds
+static const uint32_t kUiMeterInterval = 30;
 
 // -----------------------------------------------------------------------
 
@@ -35,6 +42,7 @@ public:
           fStyle(1),
           fOutLeft(0.0f),
           fOutRight(0.0f),
+          fUiMeters(),
           fInlineDisplay() {}
 
 protected:
@@ -182,6 +190,47 @@ protected:
         }
     }
 
+    // -------------------------------------------------------------------
+    // Plugin UI calls
+
+    void uiShow(const bool show) override
+    {
+        // a new UI process has nothing yet, send it everything again
+        if (show)
+        {
+            fUiMeters[0].reset();
+            fUiMeters[1].reset();
+        }
+
+        NativePluginAndUiClass::uiShow(show);
+    }
+
+    void uiSetParameterValue(const uint32_t index, float value) noexcept override
+    {
+        if (index == 2 || index == 3)
+        {
+            UiMeter& meter(fUiMeters[index - 2]);
+
+            // same cut-off as the UI meter
+            if (value < 0.001f)
+                value = 0.0f;
+
+            if (carla_isEqual(meter.lastValue, value))
+                return;
+
+            // skipped values are not stored, the next idle sends the latest one
+            const uint32_t now = Time::getMillisecondCounter();
+
+            if (meter.lastTime != 0 && now - meter.lastTime < kUiMeterInterval)
+                return;
+
+            meter.lastValue = value;
+            meter.lastTime  = now != 0 ? now : 1;
+        }
+
+        NativePluginAndUiClass::uiSetParameterValue(index, value);
+    }
+
     // -------------------------------------------------------------------
     // Plugin dispatcher calls
 
@@ -190,97 +239,54 @@ protected:
         CARLA_SAFE_ASSERT_RETURN(rwidth > 0 && height > 0, nullptr);
 
         const uint32_t width = rwidth == height ? height / 6 : rwidth;
+        CARLA_SAFE_ASSERT_RETURN(width > 0, nullptr);
+
         const size_t stride = width * 4;
         const size_t dataSize = stride * height;
 
         uchar* data = fInlineDisplay.data;
+        bool fullRedraw = false;
 
         if (fInlineDisplay.dataSize < dataSize || data == nullptr)
         {
             delete[] data;
             data = new uchar[dataSize];
-            std::memset(data, 0, dataSize);
             fInlineDisplay.data = data;
             fInlineDisplay.dataSize = dataSize;
+            fullRedraw = true;
         }
 
-        std::memset(data, 0, dataSize);
-
-        fInlineDisplay.width = static_cast<int>(width);
-        fInlineDisplay.height = static_cast<int>(height);
-        fInlineDisplay.stride = static_cast<int>(stride);
-
-        const uint heightValueLeft = static_cast<uint>(fInlineDisplay.lastLeft * static_cast<float>(height));
-        const uint heightValueRight = static_cast<uint>(fInlineDisplay.lastRight * static_cast<float>(height));
-
-        for (uint h=0; h < height; ++h)
+        if (fullRedraw || fInlineDisplay.width != static_cast<int>(width) || fInlineDisplay.height != static_cast<int>(height))
         {
-            for (uint w=0; w < width; ++w)
-            {
-//                 data[h * stride + w * 4 + 0] = 0;
-//                 data[h * stride + w * 4 + 1] = 255;
-//                 data[h * stride + w * 4 + 2] = 0;
-                data[h * stride + w * 4 + 3] = 160;
-            }
+            fInlineDisplay.width = static_cast<int>(width);
+            fInlineDisplay.height = static_cast<int>(height);
+            fInlineDisplay.stride = static_cast<int>(stride);
+            fInlineDisplay.prepareRows(width);
+            fullRedraw = true;
         }
 
-        for (uint h=0; h < heightValueLeft; ++h)
-        {
-            const uint h2 = height - h - 1;
+        const uint heightValueLeft = std::min(height, static_cast<uint>(fInlineDisplay.lastLeft * static_cast<float>(height)));
+        const uint heightValueRight = std::min(height, static_cast<uint>(fInlineDisplay.lastRight * static_cast<float>(height)));
 
-            for (uint w=0; w < width / 2; ++w)
-            {
-                data[h2 * stride + w * 4 + 0] = 200;
-                data[h2 * stride + w * 4 + 1] = 0;
-                data[h2 * stride + w * 4 + 2] = 0;
-                data[h2 * stride + w * 4 + 3] = 255;
-            }
-        }
+        // left meter uses the columns before the middle one, right meter the middle one and after
+        const size_t middleOffset = (width / 2) * 4;
 
-        for (uint h=0; h < heightValueRight; ++h)
+        if (fullRedraw)
         {
-            const uint h2 = height - h - 1;
-
-            for (uint w=width / 2; w < width; ++w)
-            {
-                data[h2 * stride + w * 4 + 0] = 200;
-                data[h2 * stride + w * 4 + 1] = 0;
-                data[h2 * stride + w * 4 + 2] = 0;
-                data[h2 * stride + w * 4 + 3] = 255;
-            }
+            fInlineDisplay.drawRows(0, height - heightValueLeft, 0, middleOffset, false);
+            fInlineDisplay.drawRows(height - heightValueLeft, height, 0, middleOffset, true);
+            fInlineDisplay.drawRows(0, height - heightValueRight, middleOffset, stride - middleOffset, false);
+            fInlineDisplay.drawRows(height - heightValueRight, height, middleOffset, stride - middleOffset, true);
         }
-
-        // draw 1px border
-        for (uint w=0; w < width; ++w)
+        else
         {
-//             data[w * 4 + 0] = 0;
-//             data[w * 4 + 1] = 0;
-//             data[w * 4 + 2] = 255;
-              data[w * 4 + 3] = 120;
-
-//             data[(height - 1) * stride + w * 4 + 0] = 0;
-//             data[(height - 1) * stride + w * 4 + 1] = 0;
-//             data[(height - 1) * stride + w * 4 + 2] = 255;
-            data[(height - 1) * stride + w * 4 + 3] = 120;
+            // only touch the rows between the previous and current meter levels
+            fInlineDisplay.drawRowsBetween(fInlineDisplay.drawnLeft, heightValueLeft, 0, middleOffset);
+            fInlineDisplay.drawRowsBetween(fInlineDisplay.drawnRight, heightValueRight, middleOffset, stride - middleOffset);
         }
 
-        for (uint h=0; h < height; ++h)
-        {
-//             data[h * stride + 0] = 0;
-//             data[h * stride + 1] = 0;
-//             data[h * stride + 2] = 255;
-            data[h * stride + 3] = 120;
-
-            data[h * stride + (width / 2) * 4 + 0] = 0;
-            data[h * stride + (width / 2) * 4 + 1] = 0;
-            data[h * stride + (width / 2) * 4 + 2] = 0;
-            data[h * stride + (width / 2) * 4 + 3] = 160;
-
-//             data[h * stride + (width - 1) * 4 + 0] = 0;
-//             data[h * stride + (width - 1) * 4 + 1] = 0;
-//             data[h * stride + (width - 1) * 4 + 2] = 255;
-            data[h * stride + (width - 1) * 4 + 3] = 120;
-        }
+        fInlineDisplay.drawnLeft = heightValueLeft;
+        fInlineDisplay.drawnRight = heightValueRight;
 
         fInlineDisplay.pending = rwidth == height ? -1 : 0;
         return (NativeInlineDisplayImageSurface*)(NativeInlineDisplayImageSurfaceCompat*)&fInlineDisplay;
@@ -290,16 +296,51 @@ private:
     int fColor, fStyle;
     float fOutLeft, fOutRight;
 
+    // last meter values sent to the UI
+    struct UiMeter {
+        float lastValue;
+        uint32_t lastTime;
+
+        UiMeter() noexcept
+            : lastValue(-1.0f),
+              lastTime(0) {}
+
+        void reset() noexcept
+        {
+            lastValue = -1.0f;
+            lastTime  = 0;
+        }
+    } fUiMeters[2];
+
     struct InlineDisplay : NativeInlineDisplayImageSurfaceCompat {
         float lastLeft;
         float lastRight;
         volatile int pending;
 
+        // meter heights currently drawn in data, in rows
+        uint drawnLeft;
+        uint drawnRight;
+
+        // pre-rendered rows for the current width, copied into data as needed
+        enum RowType {
+            kRowBackground = 0,
+            kRowMeter,
+            kRowBackgroundBorder,
+            kRowMeterBorder,
+            kRowCount
+        };
+        uchar* rows;
+        size_t rowsSize;
+
         InlineDisplay()
             : NativeInlineDisplayImageSurfaceCompat(),
               lastLeft(0.0f),
               lastRight(0.0f),
-              pending(0) {}
+              pending(0),
+              drawnLeft(0),
+              drawnRight(0),
+              rows(nullptr),
+              rowsSize(0) {}
 
         ~InlineDisplay()
         {
@@ -308,6 +349,79 @@ private:
                 delete[] data;
                 data = nullptr;
             }
+
+            if (rows != nullptr)
+            {
+                delete[] rows;
+                rows = nullptr;
+            }
+        }
+
+        void prepareRows(const uint32_t w)
+        {
+            const size_t rowStride = w * 4;
+
+            if (rowsSize < rowStride * kRowCount || rows == nullptr)
+            {
+                delete[] rows;
+                rows = new uchar[rowStride * kRowCount];
+                rowsSize = rowStride * kRowCount;
+            }
+
+            for (int type = 0; type < kRowCount; ++type)
+            {
+                uchar* const row = rows + rowStride * static_cast<uint>(type);
+                const bool meter  = type == kRowMeter || type == kRowMeterBorder;
+                const bool border = type == kRowBackgroundBorder || type == kRowMeterBorder;
+
+                for (uint i=0; i < w; ++i)
+                {
+                    row[i * 4 + 0] = meter ? 200 : 0;
+                    row[i * 4 + 1] = 0;
+                    row[i * 4 + 2] = 0;
+                    row[i * 4 + 3] = border ? 120 : (meter ? 255 : 160);
+                }
+
+                // 1px border and middle separator
+                row[3] = 120;
+
+                row[(w / 2) * 4 + 0] = 0;
+                row[(w / 2) * 4 + 1] = 0;
+                row[(w / 2) * 4 + 2] = 0;
+                row[(w / 2) * 4 + 3] = 160;
+
+                row[(w - 1) * 4 + 3] = 120;
+            }
+        }
+
+        // copy [offset, offset+size) bytes of the matching pre-rendered row into rows [first, last)
+        void drawRows(const uint first, const uint last, const size_t offset, const size_t size, const bool meter)
+        {
+            const uint h = static_cast<uint>(height);
+            const size_t rowStride = static_cast<size_t>(stride);
+
+            for (uint y=first; y < last; ++y)
+            {
+                const bool border = y == 0 || y == h - 1;
+                const int type = meter ? (border ? kRowMeterBorder : kRowMeter)
+                                       : (border ? kRowBackgroundBorder : kRowBackground);
+
+                std::memcpy(data + y * rowStride + offset, rows + rowStride * static_cast<uint>(type) + offset, size);
+            }
+        }
+
+        // redraw the rows that differ between meter heights 'from' and 'to'
+        void drawRowsBetween(const uint from, const uint to, const size_t offset, const size_t size)
+        {
+            if (from == to)
+                return;
+
+            const uint h = static_cast<uint>(height);
+
+            if (to > from)
+                drawRows(h - to, h - from, offset, size, true);
+            else
+                drawRows(h - from, h - to, offset, size, false);
         }
 
         CARLA_DECLARE_NON_COPY_STRUCT(InlineDisplay)
@@ -49,7 +49,7 @@ static void bypass_process(NativePluginHandle handle,
 
 static const NativePluginDescriptor bypassDesc = {
     .category  = NATIVE_PLUGIN_CATEGORY_NONE,
-    .hints     = NATIVE_PLUGIN_IS_RTSAFE,
+    .hints     = NATIVE_PLUGIN_IS_RTSAFE|NATIVE_PLUGIN_IS_INPLACE_SAFE,
     .supports  = NATIVE_PLUGIN_SUPPORTS_NOTHING,
     .audioIns  = 1,
     .audioOuts = 1,
@@ -20,11 +20,12 @@
 
 #include "CarlaMIDI.h"
 #include "CarlaMutex.hpp"
-#include "LinkedList.hpp"
 
 #include "CarlaJuceUtils.hpp"
 #include "CarlaMathUtils.hpp"
 
+#include <algorithm>
+
 // -----------------------------------------------------------------------
 
 #define MAX_EVENT_DATA_SIZE          4
@@ -52,21 +53,34 @@ public:
 
 class MidiPattern
 {
+    struct EventArray {
+        RawMidiEvent* data;
+        uint32_t count;
+        uint32_t capacity;
+        EventArray* next; // used while retired
+    };
+
 public:
     MidiPattern(AbstractMidiPlayer* const player) noexcept
         : kPlayer(player),
           fMidiPort(0),
           fStartTime(0),
-          fReadMutex(),
           fWriteMutex(),
-          fData()
+          fLatest(nullptr),
+          fPending(nullptr),
+          fRetired(nullptr),
+          fActive(nullptr),
+          fPlayIndex(0)
     {
         CARLA_SAFE_ASSERT(kPlayer != nullptr);
     }
 
     ~MidiPattern() noexcept
     {
-        clear();
+        // nothing can be playing at this point, so everything can go
+        destroyEventArray(fPending);
+        destroyEventArray(fActive);
+        reclaimEventArrays();
     }
 
     // -------------------------------------------------------------------
@@ -74,23 +88,26 @@ public:
 
     void addControl(const uint64_t time, const uint8_t channel, const uint8_t control, const uint8_t value)
     {
-        RawMidiEvent* const ctrlEvent(new RawMidiEvent());
-        ctrlEvent->time    = time;
-        ctrlEvent->size    = 3;
-        ctrlEvent->data[0] = uint8_t(MIDI_STATUS_CONTROL_CHANGE | (channel & MIDI_CHANNEL_BIT));
-        ctrlEvent->data[1] = control;
-        ctrlEvent->data[2] = value;
+        RawMidiEvent ctrlEvent;
+        ctrlEvent.time    = time;
+        ctrlEvent.size    = 3;
+        ctrlEvent.data[0] = uint8_t(MIDI_STATUS_CONTROL_CHANGE | (channel & MIDI_CHANNEL_BIT));
+        ctrlEvent.data[1] = control;
+        ctrlEvent.data[2] = value;
+        ctrlEvent.data[3] = 0;
 
         appendSorted(ctrlEvent);
     }
 
     void addChannelPressure(const uint64_t time, const uint8_t channel, const uint8_t pressure)
     {
-        RawMidiEvent* const pressureEvent(new RawMidiEvent());
-        pressureEvent->time    = time;
-        pressureEvent->size    = 2;
-        pressureEvent->data[0] = uint8_t(MIDI_STATUS_CHANNEL_PRESSURE | (channel & MIDI_CHANNEL_BIT));
-        pressureEvent->data[1] = pressure;
+        RawMidiEvent pressureEvent;
+        pressureEvent.time    = time;
+        pressureEvent.size    = 2;
+        pressureEvent.data[0] = uint8_t(MIDI_STATUS_CHANNEL_PRESSURE | (channel & MIDI_CHANNEL_BIT));
+        pressureEvent.data[1] = pressure;
+        pressureEvent.data[2] = 0;
+        pressureEvent.data[3] = 0;
 
         appendSorted(pressureEvent);
     }
@@ -103,54 +120,60 @@ public:
 
     void addNoteOn(const uint64_t time, const uint8_t channel, const uint8_t pitch, const uint8_t velocity)
     {
-        RawMidiEvent* const noteOnEvent(new RawMidiEvent());
-        noteOnEvent->time    = time;
-        noteOnEvent->size    = 3;
-        noteOnEvent->data[0] = uint8_t(MIDI_STATUS_NOTE_ON | (channel & MIDI_CHANNEL_BIT));
-        noteOnEvent->data[1] = pitch;
-        noteOnEvent->data[2] = velocity;
+        RawMidiEvent noteOnEvent;
+        noteOnEvent.time    = time;
+        noteOnEvent.size    = 3;
+        noteOnEvent.data[0] = uint8_t(MIDI_STATUS_NOTE_ON | (channel & MIDI_CHANNEL_BIT));
+        noteOnEvent.data[1] = pitch;
+        noteOnEvent.data[2] = velocity;
+        noteOnEvent.data[3] = 0;
 
         appendSorted(noteOnEvent);
     }
 
     void addNoteOff(const uint64_t time, const uint8_t channel, const uint8_t pitch, const uint8_t velocity = 0)
     {
-        RawMidiEvent* const noteOffEvent(new RawMidiEvent());
-        noteOffEvent->time    = time;
-        noteOffEvent->size    = 3;
-        noteOffEvent->data[0] = uint8_t(MIDI_STATUS_NOTE_OFF | (channel & MIDI_CHANNEL_BIT));
-        noteOffEvent->data[1] = pitch;
-        noteOffEvent->data[2] = velocity;
+        RawMidiEvent noteOffEvent;
+        noteOffEvent.time    = time;
+        noteOffEvent.size    = 3;
+        noteOffEvent.data[0] = uint8_t(MIDI_STATUS_NOTE_OFF | (channel & MIDI_CHANNEL_BIT));
+        noteOffEvent.data[1] = pitch;
+        noteOffEvent.data[2] = velocity;
+        noteOffEvent.data[3] = 0;
 
         appendSorted(noteOffEvent);
     }
 
     void addNoteAftertouch(const uint64_t time, const uint8_t channel, const uint8_t pitch, const uint8_t pressure)
     {
-        RawMidiEvent* const noteAfterEvent(new RawMidiEvent());
-        noteAfterEvent->time    = time;
-        noteAfterEvent->size    = 3;
-        noteAfterEvent->data[0] = uint8_t(MIDI_STATUS_POLYPHONIC_AFTERTOUCH | (channel & MIDI_CHANNEL_BIT));
-        noteAfterEvent->data[1] = pitch;
-        noteAfterEvent->data[2] = pressure;
+        RawMidiEvent noteAfterEvent;
+        noteAfterEvent.time    = time;
+        noteAfterEvent.size    = 3;
+        noteAfterEvent.data[0] = uint8_t(MIDI_STATUS_POLYPHONIC_AFTERTOUCH | (channel & MIDI_CHANNEL_BIT));
+        noteAfterEvent.data[1] = pitch;
+        noteAfterEvent.data[2] = pressure;
+        noteAfterEvent.data[3] = 0;
 
         appendSorted(noteAfterEvent);
     }
 
     void addProgram(const uint64_t time, const uint8_t channel, const uint8_t bank, const uint8_t program)
     {
-        RawMidiEvent* const bankEvent(new RawMidiEvent());
-        bankEvent->time    = time;
-        bankEvent->size    = 3;
-        bankEvent->data[0] = uint8_t(MIDI_STATUS_CONTROL_CHANGE | (channel & MIDI_CHANNEL_BIT));
-        bankEvent->data[1] = MIDI_CONTROL_BANK_SELECT;
-        bankEvent->data[2] = bank;
-
-        RawMidiEvent* const programEvent(new RawMidiEvent());
-        programEvent->time    = time;
-        programEvent->size    = 2;
-        programEvent->data[0] = uint8_t(MIDI_STATUS_PROGRAM_CHANGE | (channel & MIDI_CHANNEL_BIT));
-        programEvent->data[1] = program;
+        RawMidiEvent bankEvent;
+        bankEvent.time    = time;
+        bankEvent.size    = 3;
+        bankEvent.data[0] = uint8_t(MIDI_STATUS_CONTROL_CHANGE | (channel & MIDI_CHANNEL_BIT));
+        bankEvent.data[1] = MIDI_CONTROL_BANK_SELECT;
+        bankEvent.data[2] = bank;
+        bankEvent.data[3] = 0;
+
+        RawMidiEvent programEvent;
+        programEvent.time    = time;
+        programEvent.size    = 2;
+        programEvent.data[0] = uint8_t(MIDI_STATUS_PROGRAM_CHANGE | (channel & MIDI_CHANNEL_BIT));
+        programEvent.data[1] = program;
+        programEvent.data[2] = 0;
+        programEvent.data[3] = 0;
 
         appendSorted(bankEvent);
         appendSorted(programEvent);
@@ -158,31 +181,92 @@ public:
 
     void addPitchbend(const uint64_t time, const uint8_t channel, const uint8_t lsb, const uint8_t msb)
     {
-        RawMidiEvent* const pressureEvent(new RawMidiEvent());
-        pressureEvent->time    = time;
-        pressureEvent->size    = 3;
-        pressureEvent->data[0] = uint8_t(MIDI_STATUS_PITCH_WHEEL_CONTROL | (channel & MIDI_CHANNEL_BIT));
-        pressureEvent->data[1] = lsb;
-        pressureEvent->data[2] = msb;
+        RawMidiEvent pressureEvent;
+        pressureEvent.time    = time;
+        pressureEvent.size    = 3;
+        pressureEvent.data[0] = uint8_t(MIDI_STATUS_PITCH_WHEEL_CONTROL | (channel & MIDI_CHANNEL_BIT));
+        pressureEvent.data[1] = lsb;
+        pressureEvent.data[2] = msb;
+        pressureEvent.data[3] = 0;
 
         appendSorted(pressureEvent);
     }
 
     void addRaw(const uint64_t time, const uint8_t* const data, const uint8_t size)
     {
-        RawMidiEvent* const rawEvent(new RawMidiEvent());
-        rawEvent->time = time;
-        rawEvent->size = size;
+        CARLA_SAFE_ASSERT_RETURN(size > 0 && size <= MAX_EVENT_DATA_SIZE,);
 
-        carla_copy<uint8_t>(rawEvent->data, data, size);
+        RawMidiEvent rawEvent;
+        carla_zeroStruct(rawEvent);
+        rawEvent.time = time;
+        rawEvent.size = size;
 
-        // Fix zero-velocity note-ons
-        if (MIDI_IS_STATUS_NOTE_ON(data[0]) && data[2] == 0)
-            rawEvent->data[0] = uint8_t(MIDI_STATUS_NOTE_OFF | (data[0] & MIDI_CHANNEL_BIT));
+        carla_copy<uint8_t>(rawEvent.data, data, size);
+        fixRawEvent(rawEvent);
 
         appendSorted(rawEvent);
     }
 
+    /*
+     * Add many events at once, in any order.
+     * They are sorted in one go and merged with the existing ones, which is much faster than adding them one by one.
+     * Events with the same time keep their order.
+     */
+    void addRawEvents(const RawMidiEvent* const events, const uint32_t count)
+    {
+        CARLA_SAFE_ASSERT_RETURN(events != nullptr,);
+
+        if (count == 0)
+            return;
+
+        RawMidiEvent* added;
+
+        try {
+            added = new RawMidiEvent[count];
+        } CARLA_SAFE_EXCEPTION_RETURN("MidiPattern::addRawEvents",);
+
+        const uint32_t numAdded = copySortedRawEvents(added, events, count);
+
+        const CarlaMutexLocker cmlw(fWriteMutex);
+
+        const uint32_t oldCount = fLatest != nullptr ? fLatest->count : 0;
+        EventArray* const merged = createEventArray(oldCount + numAdded);
+
+        if (merged == nullptr)
+        {
+            delete[] added;
+            return;
+        }
+
+        if (oldCount != 0)
+            std::merge(fLatest->data, fLatest->data + oldCount, added, added + numAdded, merged->data, compareEventTime);
+        else
+            carla_copyStructs(merged->data, added, numAdded);
+
+        merged->count = oldCount + numAdded;
+        delete[] added;
+
+        publishEventArray(merged);
+    }
+
+    /*
+     * Replace all events at once, in any order.
+     * play() switches to the new events in a single step, it never sees a partially replaced pattern.
+     */
+    void replaceRawEvents(const RawMidiEvent* const events, const uint32_t count)
+    {
+        CARLA_SAFE_ASSERT_RETURN(events != nullptr || count == 0,);
+
+        EventArray* const newEvents = createEventArray(count);
+        CARLA_SAFE_ASSERT_RETURN(newEvents != nullptr,);
+
+        if (count != 0)
+            newEvents->count = copySortedRawEvents(newEvents->data, events, count);
+
+        const CarlaMutexLocker cmlw(fWriteMutex);
+        publishEventArray(newEvents);
+    }
+
     // -------------------------------------------------------------------
     // remove data
 
@@ -190,25 +274,30 @@ public:
     {
         const CarlaMutexLocker cmlw(fWriteMutex);
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
+        if (fLatest != nullptr)
         {
-            const RawMidiEvent* const rawMidiEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(rawMidiEvent != nullptr);
+            for (uint32_t i = findFirstEventAt(*fLatest, time); i < fLatest->count && fLatest->data[i].time == time; ++i)
+            {
+                const RawMidiEvent& rawMidiEvent(fLatest->data[i]);
 
-            if (rawMidiEvent->time != time)
-                continue;
-            if (rawMidiEvent->size != size)
-                continue;
-            if (std::memcmp(rawMidiEvent->data, data, size) != 0)
-                continue;
+                if (rawMidiEvent.size != size)
+                    continue;
+                if (std::memcmp(rawMidiEvent.data, data, size) != 0)
+                    continue;
 
-            {
-                const CarlaMutexLocker cmlr(fReadMutex);
-                fData.remove(it);
-            }
+                EventArray* const events = createEventArray(fLatest->count - 1);
+                CARLA_SAFE_ASSERT_RETURN(events != nullptr,);
 
-            delete rawMidiEvent;
-            return;
+                if (i != 0)
+                    carla_copyStructs(events->data, fLatest->data, i);
+                if (i + 1 < fLatest->count)
+                    carla_copyStructs(events->data + i, fLatest->data + i + 1, fLatest->count - i - 1);
+
+                events->count = fLatest->count - 1;
+
+                publishEventArray(events);
+                return;
+            }
         }
 
         carla_stderr("MidiPattern::removeRaw(" P_INT64 ", %p, %i) - unable to find event to remove", time, data, size);
@@ -219,13 +308,13 @@ public:
 
     void clear() noexcept
     {
-        const CarlaMutexLocker cmlr(fReadMutex);
         const CarlaMutexLocker cmlw(fWriteMutex);
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
-            delete it.getValue(nullptr);
+        if (fLatest == nullptr || fLatest->count == 0)
+            return;
 
-        fData.clear();
+        if (EventArray* const events = createEventArray(0))
+            publishEventArray(events);
     }
 
     // -------------------------------------------------------------------
@@ -240,36 +329,49 @@ public:
     {
         long double ldtime;
 
-        const CarlaMutexTryLocker cmtl(fReadMutex);
+        // pick up the latest edits, the old events are deleted later by the writer side
+        if (EventArray* const pending = __sync_lock_test_and_set(&fPending, static_cast<EventArray*>(nullptr)))
+        {
+            retireEventArray(fActive);
+            fActive = pending;
+        }
 
-        if (cmtl.wasNotLocked())
-            return false;
+        const EventArray* const events = fActive;
+
+        if (events == nullptr)
+            return true;
 
         if (fStartTime != 0)
             timePosFrame += static_cast<long double>(fStartTime);
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
+        const long double endPosFrame = timePosFrame + frames;
+
+        // continue from where the last block stopped, only search on seek or edits
+        uint32_t i = fPlayIndex;
+
+        if (! isFirstEventFrom(*events, i, timePosFrame))
+            i = findFirstEventFrom(*events, timePosFrame);
+
+        for (; i < events->count; ++i)
         {
-            const RawMidiEvent* const rawMidiEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(rawMidiEvent != nullptr);
+            const RawMidiEvent& rawMidiEvent(events->data[i]);
 
-            ldtime = static_cast<long double>(rawMidiEvent->time);
+            ldtime = static_cast<long double>(rawMidiEvent.time);
 
-            if (ldtime < timePosFrame)
-                continue;
-            if (ldtime > timePosFrame + frames)
+            if (ldtime > endPosFrame)
                 break;
 
-            if (carla_isEqual(ldtime, timePosFrame + frames))
+            if (carla_isEqual(ldtime, endPosFrame))
             {
                 // only allow a few events to pass through in this special case
-                if (! MIDI_IS_STATUS_NOTE_OFF(rawMidiEvent->data[0]))
+                if (! MIDI_IS_STATUS_NOTE_OFF(rawMidiEvent.data[0]))
                     continue;
             }
 
-            kPlayer->writeMidiEvent(fMidiPort, ldtime + offset - timePosFrame, rawMidiEvent);
+            kPlayer->writeMidiEvent(fMidiPort, ldtime + offset - timePosFrame, &rawMidiEvent);
         }
 
+        fPlayIndex = findFirstEventFrom(*events, endPosFrame, i);
         return true;
     }
 
@@ -294,9 +396,15 @@ public:
         return fWriteMutex;
     }
 
-    LinkedList<const RawMidiEvent*>::Itenerator iteneratorBegin() const noexcept
+    // events are sorted by time, only valid while the write mutex is locked
+    const RawMidiEvent* getEvents() const noexcept
     {
-        return fData.begin2();
+        return fLatest != nullptr ? fLatest->data : nullptr;
+    }
+
+    uint32_t getEventCount() const noexcept
+    {
+        return fLatest != nullptr ? fLatest->count : 0;
     }
 
     // -------------------------------------------------------------------
@@ -310,10 +418,12 @@ public:
 
         const CarlaMutexLocker cmlw(fWriteMutex);
 
-        char* const data((char*)std::calloc(1, fData.count() * maxMsgSize + 1));
+        const uint32_t eventCount = getEventCount();
+
+        char* const data((char*)std::calloc(1, eventCount * maxMsgSize + 1));
         CARLA_SAFE_ASSERT_RETURN(data != nullptr, nullptr);
 
-        if (fData.count() == 0)
+        if (eventCount == 0)
         {
             *data = '\0';
             return data;
@@ -322,22 +432,21 @@ public:
         char* dataWrtn = data;
         int wrtn;
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
+        for (uint32_t i=0; i < eventCount; ++i)
         {
-            const RawMidiEvent* const rawMidiEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(rawMidiEvent != nullptr);
+            const RawMidiEvent& rawMidiEvent(fLatest->data[i]);
 
-            wrtn = std::snprintf(dataWrtn, maxTimeSize+6, P_UINT64 ":%u:", rawMidiEvent->time, rawMidiEvent->size);
+            wrtn = std::snprintf(dataWrtn, maxTimeSize+6, P_UINT64 ":%u:", rawMidiEvent.time, rawMidiEvent.size);
             CARLA_SAFE_ASSERT_BREAK(wrtn > 0);
             dataWrtn += wrtn;
 
-            wrtn = std::snprintf(dataWrtn, 5, "0x%02X", rawMidiEvent->data[0]);
+            wrtn = std::snprintf(dataWrtn, 5, "0x%02X", rawMidiEvent.data[0]);
             CARLA_SAFE_ASSERT_BREAK(wrtn > 0);
             dataWrtn += wrtn;
 
-            for (uint8_t i=1, size=rawMidiEvent->size; i<size; ++i)
+            for (uint8_t j=1, size=rawMidiEvent.size; j<size; ++j)
             {
-                wrtn = std::snprintf(dataWrtn, 5, ":%03u", rawMidiEvent->data[i]);
+                wrtn = std::snprintf(dataWrtn, 5, ":%03u", rawMidiEvent.data[j]);
                 CARLA_SAFE_ASSERT_BREAK(wrtn > 0);
                 dataWrtn += wrtn;
             }
@@ -354,6 +463,21 @@ public:
     {
         CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
 
+        EventArray* const events = createEventArray(MIN_PREALLOCATED_EVENT_COUNT);
+        CARLA_SAFE_ASSERT_RETURN(events != nullptr,);
+
+        // parsing stops at the first error, keeping the events read so far
+        parseState(data, *events);
+
+        const CarlaMutexLocker cmlw(fWriteMutex);
+        publishEventArray(events);
+    }
+
+    // -------------------------------------------------------------------
+
+private:
+    static void parseState(const char* const data, EventArray& events)
+    {
         const size_t dataLen  = std::strlen(data);
         const char*  dataRead = data;
         const char*  needle;
@@ -361,11 +485,6 @@ public:
         char    tmpBuf[24];
         ssize_t tmpSize;
 
-        clear();
-
-        const CarlaMutexLocker cmlr(fReadMutex);
-        const CarlaMutexLocker cmlw(fWriteMutex);
-
         for (size_t dataPos=0; dataPos < dataLen && *dataRead != '\0';)
         {
             // get time
@@ -445,47 +564,269 @@ public:
             for (int i=midiDataSize; i<MAX_EVENT_DATA_SIZE; ++i)
                 midiEvent.data[i] = 0;
 
-            RawMidiEvent* const event(new RawMidiEvent());
-            carla_copyStruct(*event, midiEvent);
-            fData.append(event);
+            insertSorted(events, midiEvent);
         }
     }
 
-    // -------------------------------------------------------------------
-
-private:
     AbstractMidiPlayer* const kPlayer;
 
     uint8_t  fMidiPort;
     uint64_t fStartTime;
 
-    CarlaMutex fReadMutex;
     CarlaMutex fWriteMutex;
-    LinkedList<const RawMidiEvent*> fData;
 
-    void appendSorted(const RawMidiEvent* const event)
+    /*
+     * Published event arrays are never modified again.
+     * Edits build a new array and put it in fPending, which play() swaps into fActive.
+     * Arrays replaced by play() go into the fRetired list, deleted by the next edit on the writer side.
+     * This way the realtime thread never waits for (or skips a block because of) an edit.
+     */
+    EventArray* fLatest;           // newest array, writer side only (with fWriteMutex locked)
+    EventArray* volatile fPending; // published but not picked up by play() yet
+    EventArray* volatile fRetired; // no longer used by play(), waiting to be deleted
+    EventArray* fActive;           // used by play()
+
+    // index of the first event not played yet, only used in play()
+    uint32_t fPlayIndex;
+
+    static bool compareEventTime(const RawMidiEvent& a, const RawMidiEvent& b) noexcept
     {
-        const CarlaMutexLocker cmlw(fWriteMutex);
+        return a.time < b.time;
+    }
+
+    static void fixRawEvent(RawMidiEvent& event) noexcept
+    {
+        // Fix zero-velocity note-ons
+        if (MIDI_IS_STATUS_NOTE_ON(event.data[0]) && event.size > 2 && event.data[2] == 0)
+            event.data[0] = uint8_t(MIDI_STATUS_NOTE_OFF | (event.data[0] & MIDI_CHANNEL_BIT));
+    }
+
+    // copies the valid events into 'dest', fixed and sorted by time, returns how many were copied
+    static uint32_t copySortedRawEvents(RawMidiEvent* const dest, const RawMidiEvent* const events, const uint32_t count)
+    {
+        uint32_t numCopied = 0;
 
-        if (fData.isEmpty())
+        for (uint32_t i=0; i < count; ++i)
         {
-            fData.append(event);
-            return;
+            CARLA_SAFE_ASSERT_CONTINUE(events[i].size > 0 && events[i].size <= MAX_EVENT_DATA_SIZE);
+
+            dest[numCopied] = events[i];
+            fixRawEvent(dest[numCopied++]);
         }
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
+        std::stable_sort(dest, dest + numCopied, compareEventTime);
+        return numCopied;
+    }
+
+    // -------------------------------------------------------------------
+    // event arrays
+
+    static EventArray* createEventArray(const uint32_t capacity) noexcept
+    {
+        EventArray* events;
+
+        try {
+            events = new EventArray;
+        } CARLA_SAFE_EXCEPTION_RETURN("MidiPattern::createEventArray", nullptr);
+
+        events->data     = nullptr;
+        events->count    = 0;
+        events->capacity = 0;
+        events->next     = nullptr;
+
+        if (capacity != 0)
         {
-            const RawMidiEvent* const oldEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(oldEvent != nullptr);
+            try {
+                events->data = new RawMidiEvent[capacity];
+            } CARLA_SAFE_EXCEPTION("MidiPattern::createEventArray");
+
+            if (events->data == nullptr)
+            {
+                delete events;
+                return nullptr;
+            }
+
+            events->capacity = capacity;
+        }
+
+        return events;
+    }
+
+    static void destroyEventArray(EventArray* const events) noexcept
+    {
+        if (events == nullptr)
+            return;
+
+        delete[] events->data;
+        delete events;
+    }
+
+    // returns a copy of the latest events, with room for 'extra' more
+    EventArray* copyLatestEventArray(const uint32_t extra) const noexcept
+    {
+        const uint32_t count = fLatest != nullptr ? fLatest->count : 0;
+
+        EventArray* const events = createEventArray(count + extra);
+        CARLA_SAFE_ASSERT_RETURN(events != nullptr, nullptr);
+
+        if (count != 0)
+            carla_copyStructs(events->data, fLatest->data, count);
+
+        events->count = count;
+        return events;
+    }
+
+    // must be called with fWriteMutex locked
+    void publishEventArray(EventArray* const events) noexcept
+    {
+        fLatest = events;
 
-            if (event->time >= oldEvent->time)
-                continue;
+        // make sure the contents are visible before the pointer
+        __sync_synchronize();
 
-            fData.insertAt(event, it);
+        // if play() did not pick up the previous one yet, nothing else references it
+        if (EventArray* const unused = __sync_lock_test_and_set(&fPending, events))
+            destroyEventArray(unused);
+
+        reclaimEventArrays();
+    }
+
+    void reclaimEventArrays() noexcept
+    {
+        for (EventArray* events = __sync_lock_test_and_set(&fRetired, static_cast<EventArray*>(nullptr)); events != nullptr;)
+        {
+            EventArray* const next = events->next;
+            destroyEventArray(events);
+            events = next;
+        }
+    }
+
+    // called from play(), lock-free
+    void retireEventArray(EventArray* const events) noexcept
+    {
+        if (events == nullptr)
             return;
+
+        EventArray* head;
+
+        do {
+            head = fRetired;
+            events->next = head;
+        } while (! __sync_bool_compare_and_swap(&fRetired, head, events));
+    }
+
+    // -------------------------------------------------------------------
+    // searching
+
+    // first event with a time equal or later than 'time'
+    static uint32_t findFirstEventAt(const EventArray& events, const uint64_t time) noexcept
+    {
+        uint32_t low = 0, high = events.count;
+
+        while (low < high)
+        {
+            const uint32_t mid = low + (high - low) / 2;
+
+            if (events.data[mid].time < time)
+                low = mid + 1;
+            else
+                high = mid;
         }
 
-        fData.append(event);
+        return low;
+    }
+
+    // first event with a time later than 'time'
+    static uint32_t findFirstEventAfter(const EventArray& events, const uint64_t time) noexcept
+    {
+        uint32_t low = 0, high = events.count;
+
+        while (low < high)
+        {
+            const uint32_t mid = low + (high - low) / 2;
+
+            if (events.data[mid].time <= time)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        return low;
+    }
+
+    // first event with a time equal or later than 'frame', searching from 'low'
+    static uint32_t findFirstEventFrom(const EventArray& events, const long double frame, uint32_t low = 0) noexcept
+    {
+        uint32_t high = events.count;
+
+        while (low < high)
+        {
+            const uint32_t mid = low + (high - low) / 2;
+
+            if (static_cast<long double>(events.data[mid].time) < frame)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        return low;
+    }
+
+    static bool isFirstEventFrom(const EventArray& events, const uint32_t index, const long double frame) noexcept
+    {
+        if (index > events.count)
+            return false;
+        if (index > 0 && static_cast<long double>(events.data[index-1].time) >= frame)
+            return false;
+        if (index < events.count && static_cast<long double>(events.data[index].time) < frame)
+            return false;
+        return true;
+    }
+
+    // -------------------------------------------------------------------
+    // editing, on arrays not published yet
+
+    static void insertSorted(EventArray& events, const RawMidiEvent& event)
+    {
+        if (events.count == events.capacity)
+        {
+            const uint32_t newCapacity = events.capacity != 0 ? events.capacity * 2 : MIN_PREALLOCATED_EVENT_COUNT;
+            RawMidiEvent* newData;
+
+            try {
+                newData = new RawMidiEvent[newCapacity];
+            } CARLA_SAFE_EXCEPTION_RETURN("MidiPattern::insertSorted",);
+
+            if (events.count != 0)
+                carla_copyStructs(newData, events.data, events.count);
+
+            delete[] events.data;
+            events.data = newData;
+            events.capacity = newCapacity;
+        }
+
+        // after any events with the same time, appending is the common case
+        uint32_t index = events.count;
+
+        if (index > 0 && events.data[index-1].time > event.time)
+            index = findFirstEventAfter(events, event.time);
+
+        if (index < events.count)
+            std::memmove(events.data + index + 1, events.data + index, sizeof(RawMidiEvent) * (events.count - index));
+
+        events.data[index] = event;
+        ++events.count;
+    }
+
+    void appendSorted(const RawMidiEvent& event)
+    {
+        const CarlaMutexLocker cmlw(fWriteMutex);
+
+        EventArray* const events = copyLatestEventArray(1);
+        CARLA_SAFE_ASSERT_RETURN(events != nullptr,);
+
+        insertSorted(*events, event);
+        publishEventArray(events);
     }
 
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiPattern)
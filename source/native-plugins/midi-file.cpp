@@ -16,6 +16,7 @@
  */
 
 #include "CarlaNativePrograms.hpp"
+#include "CarlaThread.hpp"
 #include "midi-base.hpp"
 
 #include "water/files/FileInputStream.h"
@@ -27,6 +28,170 @@
 
 // -----------------------------------------------------------------------
 
+/*
+ * Reads MIDI files on its own thread, so big files do not block the caller.
+ * The pattern only changes once the whole file is read, replacing all its events in one go.
+ */
+class MidiFileLoader : public CarlaThread
+{
+public:
+    MidiFileLoader(MidiPattern& pattern) noexcept
+        : CarlaThread("MidiFileLoader"),
+          fPattern(pattern),
+          fFilename(),
+          fSampleRate(0.0),
+          fLoaded(false) {}
+
+    ~MidiFileLoader() override
+    {
+        stopThread(-1);
+    }
+
+    void load(const char* const filename, const double sampleRate)
+    {
+        // a new file replaces the one still being read
+        stopThread(-1);
+
+        fFilename   = filename;
+        fSampleRate = sampleRate;
+
+        startThread();
+    }
+
+    // stop reading the current file, if any, leaving the pattern as-is
+    void cancel()
+    {
+        stopThread(-1);
+    }
+
+    // true once after a file was loaded into the pattern
+    bool checkAndClearLoaded() noexcept
+    {
+        return __sync_bool_compare_and_swap(&fLoaded, true, false);
+    }
+
+protected:
+    void run() override
+    {
+        RawMidiEvent* events = nullptr;
+        uint32_t numEvents = 0;
+
+        // the pattern is cleared when the file cannot be read, same as loading an empty file
+        readFile(events, numEvents);
+
+        if (! shouldThreadExit())
+        {
+            fPattern.replaceRawEvents(events, numEvents);
+            fLoaded = true;
+        }
+
+        delete[] events;
+    }
+
+private:
+    MidiPattern& fPattern;
+
+    CarlaString fFilename;
+    double fSampleRate;
+
+    volatile bool fLoaded;
+
+    void readFile(RawMidiEvent*& events, uint32_t& numEvents)
+    {
+        using namespace water;
+
+        const String jfilename = String(CharPointer_UTF8(fFilename.buffer()));
+        File file(jfilename);
+
+        if (! file.existsAsFile())
+           return;
+
+        FileInputStream fileStream(file);
+        MidiFile        midiFile;
+
+        if (! midiFile.readFrom(fileStream))
+            return;
+
+        if (shouldThreadExit())
+            return;
+
+        midiFile.convertTimestampTicksToSeconds();
+
+        const double sampleRate(fSampleRate);
+        const size_t numTracks(midiFile.getNumTracks());
+
+        // collect all events first and add them in one go, individual sorted inserts are too slow for big files
+        uint32_t maxEvents = 0;
+
+        for (size_t i=0; i<numTracks; ++i)
+        {
+            if (const MidiMessageSequence* const track = midiFile.getTrack(i))
+                maxEvents += static_cast<uint32_t>(track->getNumEvents());
+        }
+
+        if (maxEvents == 0)
+            return;
+
+        try {
+            events = new RawMidiEvent[maxEvents];
+        } CARLA_SAFE_EXCEPTION_RETURN("MidiFileLoader::readFile",);
+
+        for (size_t i=0; i<numTracks && ! shouldThreadExit(); ++i)
+        {
+            const MidiMessageSequence* const track(midiFile.getTrack(i));
+            CARLA_SAFE_ASSERT_CONTINUE(track != nullptr);
+
+            for (int j=0, numTrackEvents = track->getNumEvents(); j<numTrackEvents && numEvents<maxEvents; ++j)
+            {
+                const MidiMessageSequence::MidiEventHolder* const midiEventHolder(track->getEventPointer(j));
+                CARLA_SAFE_ASSERT_CONTINUE(midiEventHolder != nullptr);
+
+                const MidiMessage& midiMessage(midiEventHolder->message);
+                //const double time(track->getEventTime(i)*sampleRate);
+                const int dataSize(midiMessage.getRawDataSize());
+
+                if (dataSize <= 0 || dataSize > MAX_EVENT_DATA_SIZE)
+                    continue;
+                if (midiMessage.isActiveSense())
+                    continue;
+                if (midiMessage.isMetaEvent())
+                    continue;
+                if (midiMessage.isMidiStart())
+                    continue;
+                if (midiMessage.isMidiContinue())
+                    continue;
+                if (midiMessage.isMidiStop())
+                    continue;
+                if (midiMessage.isMidiClock())
+                    continue;
+                if (midiMessage.isSongPositionPointer())
+                    continue;
+                if (midiMessage.isQuarterFrame())
+                    continue;
+                if (midiMessage.isFullFrame())
+                    continue;
+                if (midiMessage.isMidiMachineControlMessage())
+                    continue;
+                if (midiMessage.isSysEx())
+                    continue;
+
+                const double time(midiMessage.getTimeStamp()*sampleRate);
+                CARLA_SAFE_ASSERT_CONTINUE(time >= 0.0);
+
+                RawMidiEvent& rawEvent(events[numEvents++]);
+                carla_zeroStruct(rawEvent);
+                rawEvent.time = static_cast<uint64_t>(time);
+                rawEvent.size = static_cast<uint8_t>(dataSize);
+                carla_copy<uint8_t>(rawEvent.data, midiMessage.getRawData(), rawEvent.size);
+            }
+        }
+    }
+
+    CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiFileLoader)
+};
+
+// -----------------------------------------------------------------------
+
 #ifdef HAVE_PYQT
 class MidiFilePlugin : public NativePluginWithMidiPrograms<FileMIDI>,
 #else
@@ -43,7 +208,8 @@ public:
 #endif
           fMidiOut(this),
           fNeedsAllNotesOff(false),
-          fWasPlayingBefore(false)
+          fWasPlayingBefore(false),
+          fLoader(fMidiOut)
 #ifdef HAVE_PYQT
         , fPrograms(hostGetFilePath("midi"), "*.mid;*.midi")
 #endif
@@ -84,6 +250,9 @@ protected:
             fWasPlayingBefore = timePos->playing;
         }
 
+        if (fLoader.checkAndClearLoaded())
+            fNeedsAllNotesOff = true;
+
         if (fNeedsAllNotesOff)
         {
             NativeMidiEvent midiEvent;
@@ -134,6 +303,8 @@ protected:
 
     void setState(const char* const data) override
     {
+        // the state wins over a file still being read
+        fLoader.cancel();
         fMidiOut.setState(data);
     }
 
@@ -168,79 +339,14 @@ private:
     MidiPattern fMidiOut;
     bool fNeedsAllNotesOff;
     bool fWasPlayingBefore;
+    MidiFileLoader fLoader;
 #ifdef HAVE_PYQT
     NativeMidiPrograms fPrograms;
 #endif
 
     void _loadMidiFile(const char* const filename)
     {
-        fMidiOut.clear();
-
-        using namespace water;
-
-        const String jfilename = String(CharPointer_UTF8(filename));
-        File file(jfilename);
-
-        if (! file.existsAsFile())
-           return;
-
-        FileInputStream fileStream(file);
-        MidiFile        midiFile;
-
-        if (! midiFile.readFrom(fileStream))
-            return;
-
-        midiFile.convertTimestampTicksToSeconds();
-
-        const double sampleRate(getSampleRate());
-
-        for (size_t i=0, numTracks = midiFile.getNumTracks(); i<numTracks; ++i)
-        {
-            const MidiMessageSequence* const track(midiFile.getTrack(i));
-            CARLA_SAFE_ASSERT_CONTINUE(track != nullptr);
-
-            for (int j=0, numEvents = track->getNumEvents(); j<numEvents; ++j)
-            {
-                const MidiMessageSequence::MidiEventHolder* const midiEventHolder(track->getEventPointer(j));
-                CARLA_SAFE_ASSERT_CONTINUE(midiEventHolder != nullptr);
-
-                const MidiMessage& midiMessage(midiEventHolder->message);
-                //const double time(track->getEventTime(i)*sampleRate);
-                const int dataSize(midiMessage.getRawDataSize());
-
-                if (dataSize <= 0 || dataSize > MAX_EVENT_DATA_SIZE)
-                    continue;
-                if (midiMessage.isActiveSense())
-                    continue;
-                if (midiMessage.isMetaEvent())
-                    continue;
-                if (midiMessage.isMidiStart())
-                    continue;
-                if (midiMessage.isMidiContinue())
-                    continue;
-                if (midiMessage.isMidiStop())
-                    continue;
-                if (midiMessage.isMidiClock())
-                    continue;
-                if (midiMessage.isSongPositionPointer())
-                    continue;
-                if (midiMessage.isQuarterFrame())
-                    continue;
-                if (midiMessage.isFullFrame())
-                    continue;
-                if (midiMessage.isMidiMachineControlMessage())
-                    continue;
-                if (midiMessage.isSysEx())
-                    continue;
-
-                const double time(midiMessage.getTimeStamp()*sampleRate);
-                CARLA_SAFE_ASSERT_CONTINUE(time >= 0.0);
-
-                fMidiOut.addRaw(static_cast<uint64_t>(time), midiMessage.getRawData(), static_cast<uint8_t>(dataSize));
-            }
-        }
-
-        fNeedsAllNotesOff = true;
+        fLoader.load(filename, getSampleRate());
     }
 
     PluginClassEND(MidiFilePlugin)
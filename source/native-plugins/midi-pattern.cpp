@@ -24,6 +24,35 @@
 // matches UI side
 #define TICKS_PER_BEAT 48
 
+// -----------------------------------------------------------------------
+// Events are exchanged with the UI in batches, one base64 line of packed little-endian records:
+// 8 bytes time, 1 byte size and MAX_EVENT_DATA_SIZE bytes data each.
+
+static const std::size_t kPackedEventSize   = 9 + MAX_EVENT_DATA_SIZE;
+static const uint32_t    kMaxEventsPerBatch = 1024;
+
+static inline
+void packRawEvent(uint8_t* const dest, const RawMidiEvent& event) noexcept
+{
+    for (int i=0; i<8; ++i)
+        dest[i] = static_cast<uint8_t>(event.time >> (i*8));
+
+    dest[8] = event.size;
+    std::memcpy(dest + 9, event.data, MAX_EVENT_DATA_SIZE);
+}
+
+static inline
+void unpackRawEvent(RawMidiEvent& event, const uint8_t* const src) noexcept
+{
+    event.time = 0;
+
+    for (int i=0; i<8; ++i)
+        event.time |= static_cast<uint64_t>(src[i]) << (i*8);
+
+    event.size = src[8];
+    std::memcpy(event.data, src + 9, MAX_EVENT_DATA_SIZE);
+}
+
 // -----------------------------------------------------------------------
 
 class MidiPatternPlugin : public NativePluginAndUiClass,
@@ -49,8 +78,7 @@ public:
           fMaxTicks(0.0),
           fMidiOut(this),
           fTimeInfo(),
-          fMidiQueue(),
-          fMidiQueueRT()
+          fMidiQueue()
     {
         carla_zeroStruct(fTimeInfo);
 
@@ -240,13 +268,15 @@ protected:
             fNeedsAllNotesOff = false;
         }
 
-        if (fMidiQueue.isNotEmpty() && fMidiQueueRT.tryToCopyDataFrom(fMidiQueue))
+        if (fMidiQueue.isNotEmpty())
         {
+            uint32_t time;
             uint8_t d1, d2, d3;
             NativeMidiEvent ev = { 0, 0, 3, { 0, 0, 0, 0 } };
 
-            while (fMidiQueueRT.get(d1, d2, d3))
+            while (fMidiQueue.get(time, d1, d2, d3))
             {
+                ev.time    = time < frames ? time : frames - 1;
                 ev.data[0] = d1;
                 ev.data[1] = d2;
                 ev.data[2] = d3;
@@ -339,10 +369,7 @@ protected:
             std::snprintf(strBuf, 0xff, "%i:" P_UINT64 ":%i:%i:%i\n", int(fTimeInfo.playing), fTimeInfo.frame, bar, beat, tick);
             CARLA_SAFE_ASSERT_RETURN(writeMessage(strBuf),);
 
-            {
-                const CarlaScopedLocale csl;
-                std::snprintf(strBuf, 0xff, "%.12g\n", beatsPerMinute);
-            }
+            std::snprintf(strBuf, 0xff, "%s\n", CarlaFloatString(beatsPerMinute).buffer);
 
             CARLA_SAFE_ASSERT_RETURN(writeMessage(strBuf),);
 
@@ -416,7 +443,6 @@ protected:
             const uint8_t status   = on ? MIDI_STATUS_NOTE_ON : MIDI_STATUS_NOTE_OFF;
             const uint8_t velocity = on ? 100 : 0;
 
-            const CarlaMutexLocker cml(fMidiQueue.getMutex());
 
             fMidiQueue.put(status, note, velocity);
             return true;
@@ -464,6 +490,47 @@ protected:
             return true;
         }
 
+        const bool addingEvents = std::strcmp(msg, "midievents-add") == 0;
+
+        if (addingEvents || std::strcmp(msg, "midievents-remove") == 0)
+        {
+            uint32_t count;
+            const char* base64;
+
+            CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(count), true);
+            CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(base64, false), true);
+            CARLA_SAFE_ASSERT_RETURN(count > 0 && count <= kMaxEventsPerBatch, true);
+
+            std::vector<uint8_t> packed;
+            uint8_t* packedData;
+
+            try {
+                carla_getChunkFromBase64String_impl(packed, base64);
+                CARLA_SAFE_ASSERT_RETURN(packed.size() == count * kPackedEventSize, true);
+                packedData = packed.data();
+            } CARLA_SAFE_EXCEPTION_RETURN("midievents batch", true);
+
+            RawMidiEvent events[kMaxEventsPerBatch];
+
+            for (uint32_t i=0; i<count; ++i)
+                unpackRawEvent(events[i], packedData + i * kPackedEventSize);
+
+            if (addingEvents)
+            {
+                fMidiOut.addRawEvents(events, count);
+            }
+            else
+            {
+                for (uint32_t i=0; i<count; ++i)
+                {
+                    CARLA_SAFE_ASSERT_CONTINUE(events[i].size > 0 && events[i].size <= MAX_EVENT_DATA_SIZE);
+                    fMidiOut.removeRaw(events[i].time, events[i].data, events[i].size);
+                }
+            }
+
+            return true;
+        }
+
         return false;
     }
 
@@ -483,7 +550,7 @@ private:
     MidiPattern    fMidiOut;
     NativeTimeInfo fTimeInfo;
 
-    MIDIEventQueue<32> fMidiQueue, fMidiQueueRT;
+    MIDIEventQueue<32> fMidiQueue;
 
     float fParameters[kParameterCount];
 
@@ -505,24 +572,26 @@ private:
                       static_cast<int>(fParameters[kParameterQuantize]));
         writeMessage(strBuf);
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fMidiOut.iteneratorBegin(); it.valid(); it.next())
+        const RawMidiEvent* const events = fMidiOut.getEvents();
+        uint8_t packed[kMaxEventsPerBatch * kPackedEventSize];
+
+        for (uint32_t j=0, count=fMidiOut.getEventCount(); j < count; j += kMaxEventsPerBatch)
         {
-            const RawMidiEvent* const rawMidiEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(rawMidiEvent != nullptr);
+            const uint32_t batchCount = std::min(count - j, kMaxEventsPerBatch);
 
-            writeMessage("midievent-add\n", 14);
+            for (uint32_t i=0; i < batchCount; ++i)
+                packRawEvent(packed + i * kPackedEventSize, events[j + i]);
 
-            std::snprintf(strBuf, 0xff, P_INT64 "\n", rawMidiEvent->time);
-            writeMessage(strBuf);
+            writeMessage("midievents-add\n", 15);
 
-            std::snprintf(strBuf, 0xff, "%i\n", rawMidiEvent->size);
+            std::snprintf(strBuf, 0xff, "%u\n", batchCount);
             writeMessage(strBuf);
 
-            for (uint8_t i=0, size=rawMidiEvent->size; i<size; ++i)
-            {
-                std::snprintf(strBuf, 0xff, "%i\n", rawMidiEvent->data[i]);
-                writeMessage(strBuf);
-            }
+            try {
+                CarlaString base64(CarlaString::asBase64(packed, batchCount * kPackedEventSize));
+                base64 += "\n";
+                writeMessage(base64.buffer(), base64.length());
+            } CARLA_SAFE_EXCEPTION_BREAK("midievents-add");
         }
     }
 
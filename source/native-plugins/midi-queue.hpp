@@ -18,122 +18,108 @@
 #ifndef MIDI_QUEUE_HPP_INCLUDED
 #define MIDI_QUEUE_HPP_INCLUDED
 
-#include "CarlaMutex.hpp"
+#include "CarlaUtils.hpp"
 
+/*
+ * Fixed-size lock-free queue of short MIDI events, with a single producer and a single consumer.
+ * Meant for events coming from the UI or other non-RT threads, the RT side never waits on the producer.
+ * Each event has a frame offset, for producers that know where in the next block it belongs.
+ */
 template<uint16_t MAX_SIZE>
 class MIDIEventQueue
 {
+    static_assert((MAX_SIZE & (MAX_SIZE - 1)) == 0, "MIDIEventQueue size must be a power of 2");
+
 public:
     MIDIEventQueue() noexcept
-        : index(0),
-          empty(true),
-          full(false),
-          mutex() {}
+        : data(),
+          readIndex(0),
+          writeIndex(0) {}
 
+    // consumer side
     bool isEmpty() const noexcept
     {
-        return empty;
+        return readIndex == writeIndex;
     }
 
+    // consumer side
     bool isNotEmpty() const noexcept
     {
-        return !empty;
+        return readIndex != writeIndex;
     }
 
+    // producer side
     bool isFull() const noexcept
     {
-        return full;
+        return writeIndex - readIndex >= MAX_SIZE;
     }
 
-    CarlaMutex& getMutex() noexcept
-    {
-        return mutex;
-    }
-
-    bool put(unsigned char d1, unsigned char d2, unsigned char d3)
+    // producer side, returns false if full
+    bool put(const uint8_t d1, const uint8_t d2, const uint8_t d3, const uint32_t time = 0) noexcept
     {
         CARLA_SAFE_ASSERT_RETURN(d1 != 0, false);
 
-        if (full)
+        const uint32_t wrIndex = writeIndex;
+
+        if (wrIndex - readIndex >= MAX_SIZE)
             return false;
 
-        for (unsigned short i=0; i < MAX_SIZE; i++)
-        {
-            if (data[i].d1 == 0)
-            {
-                data[i].d1 = d1;
-                data[i].d2 = d2;
-                data[i].d3 = d3;
-                empty = false;
-                full  = (i == MAX_SIZE-1);
-                break;
-            }
-        }
+        MIDIEvent& event(data[wrIndex % MAX_SIZE]);
+        event.time = time;
+        event.d1   = d1;
+        event.d2   = d2;
+        event.d3   = d3;
 
+        // event contents must be visible before the new index
+        __sync_synchronize();
+        writeIndex = wrIndex + 1;
         return true;
     }
 
-    bool get(uint8_t& d1, uint8_t& d2, uint8_t& d3)
+    // consumer side, returns false if empty
+    bool get(uint32_t& time, uint8_t& d1, uint8_t& d2, uint8_t& d3) noexcept
     {
-        if (empty)
-            return false;
-
-        full = false;
-
-        if (data[index].d1 == 0)
-        {
-            index = 0;
-            empty = true;
+        const uint32_t rdIndex = readIndex;
 
+        if (rdIndex == writeIndex)
             return false;
-        }
 
-        d1 = data[index].d1;
-        d2 = data[index].d2;
-        d3 = data[index].d3;
+        __sync_synchronize();
 
-        data[index].d1 = data[index].d2 = data[index].d3 = 0;
-        empty = false;
-        ++index;
+        const MIDIEvent& event(data[rdIndex % MAX_SIZE]);
+        time = event.time;
+        d1   = event.d1;
+        d2   = event.d2;
+        d3   = event.d3;
 
+        // slot must be read before the producer can reuse it
+        __sync_synchronize();
+        readIndex = rdIndex + 1;
         return true;
     }
 
-    bool tryToCopyDataFrom(MIDIEventQueue& queue) noexcept
+    bool get(uint8_t& d1, uint8_t& d2, uint8_t& d3) noexcept
     {
-        const CarlaMutexTryLocker cml(queue.mutex);
-
-        if (cml.wasNotLocked())
-            return false;
-
-        // copy data from queue
-        carla_copyStruct(data, queue.data);
-        index = queue.index;
-        empty = queue.empty;
-        full  = queue.full;
-
-        // reset queque
-        carla_zeroStruct(queue.data);
-        queue.index = 0;
-        queue.empty = true;
-        queue.full  = false;
-
-        return true;
+        uint32_t time;
+        return get(time, d1, d2, d3);
     }
 
 private:
     struct MIDIEvent {
+        uint32_t time;
         uint8_t d1, d2, d3;
 
         MIDIEvent() noexcept
-            : d1(0), d2(0), d3(0) {}
+            : time(0), d1(0), d2(0), d3(0) {}
     };
 
     MIDIEvent data[MAX_SIZE];
-    uint16_t index;
-    volatile bool empty, full;
 
-    CarlaMutex mutex;
+    // only ever increased, wrapping around
+    volatile uint32_t readIndex;
+    volatile uint32_t writeIndex;
+
+    CARLA_DECLARE_NON_COPY_CLASS(MIDIEventQueue)
 };
 
 #endif // MIDI_QUEUE_HPP_INCLUDED
@@ -40,8 +40,7 @@ public:
         : NativePluginAndUiClass(host, "xycontroller-ui"),
           params(),
           channels(),
-          mqueue(),
-          mqueueRT()
+          mqueue()
     {
         carla_zeroStruct(params);
         carla_zeroStruct(channels);
@@ -144,19 +143,21 @@ protected:
     // -------------------------------------------------------------------
     // Plugin process calls
 
-    void process(const float* const*, float**, const uint32_t,
+    void process(const float* const*, float**, const uint32_t frames,
                  const NativeMidiEvent* const midiEvents, const uint32_t midiEventCount) override
     {
         params[kParamOutX] = params[kParamInX];
         params[kParamOutY] = params[kParamInY];
 
-        if (mqueue.isNotEmpty() && mqueueRT.tryToCopyDataFrom(mqueue))
+        if (mqueue.isNotEmpty())
         {
+            uint32_t time;
             uint8_t d1, d2, d3;
             NativeMidiEvent ev = { 0, 0, 3, { 0, 0, 0, 0 } };
 
-            while (mqueueRT.get(d1, d2, d3))
+            while (mqueue.get(time, d1, d2, d3))
             {
+                ev.time    = time < frames ? time : frames - 1;
                 ev.data[0] = d1;
                 ev.data[1] = d2;
                 ev.data[2] = d3;
@@ -168,6 +169,18 @@ protected:
             writeMidiEvent(&midiEvents[i]);
     }
 
+    // -------------------------------------------------------------------
+    // Plugin UI calls
+
+    void uiSetParameterValue(const uint32_t index, const float value) noexcept override
+    {
+        // the UI only shows the inputs, outputs are a copy of them
+        if (index >= kParamOutX)
+            return;
+
+        NativePluginAndUiClass::uiSetParameterValue(index, value);
+    }
+
     // -------------------------------------------------------------------
     // Pipe Server calls
 
@@ -182,8 +195,6 @@ protected:
             CARLA_SAFE_ASSERT_RETURN(readNextLineAsByte(cc), true);
             CARLA_SAFE_ASSERT_RETURN(readNextLineAsByte(value), true);
 
-            const CarlaMutexLocker cml(mqueue.getMutex());
-
             for (int i=0; i<16; ++i)
             {
                 if (channels[i])
@@ -202,8 +213,6 @@ protected:
             CARLA_SAFE_ASSERT_RETURN(readNextLineAsByte(cc2), true);
             CARLA_SAFE_ASSERT_RETURN(readNextLineAsByte(value2), true);
 
-            const CarlaMutexLocker cml(mqueue.getMutex());
-
             for (int i=0; i<16; ++i)
             {
                 if (channels[i])
@@ -228,7 +237,6 @@ protected:
             const uint8_t status   = onOff ? MIDI_STATUS_NOTE_ON : MIDI_STATUS_NOTE_OFF;
             const uint8_t velocity = onOff ? 100 : 0;
 
-            const CarlaMutexLocker cml(mqueue.getMutex());
 
             for (int i=0; i<16; ++i)
             {
@@ -247,7 +255,7 @@ private:
     float params[kParamCount];
     bool channels[16];
 
-    MIDIEventQueue<128> mqueue, mqueueRT;
+    MIDIEventQueue<128> mqueue;
 
     PluginClassEND(XYControllerPlugin)
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(XYControllerPlugin)
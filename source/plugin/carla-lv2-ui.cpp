@@ -19,9 +19,9 @@
 # error This file should not be built
 #endif
 
+#include "CarlaFloatStringUtils.hpp"
 #include "CarlaLv2Utils.hpp"
 #include "CarlaPipeUtils.hpp"
-#include "CarlaScopeUtils.hpp"
 
 // --------------------------------------------------------------------------------------------------------------------
 
@@ -137,10 +137,7 @@ public:
             char msg[128];
             const float* const valuePtr = (const float*)buffer;
 
-            {
-                const CarlaScopedLocale csl;
-                std::snprintf(msg, 127, "control %u %.12g", portIndex, static_cast<double>(*valuePtr));
-            }
+            std::snprintf(msg, 127, "control %u %s", portIndex, CarlaFloatString(*valuePtr).buffer);
 
             msg[127] = '\0';
 
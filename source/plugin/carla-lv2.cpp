@@ -171,6 +171,8 @@ public:
                 fPorts.paramsLast[i] = fDescriptor->get_parameter_value(fHandle, i);
                 fPorts.paramsOut [i] = fDescriptor->get_parameter_info(fHandle, i)->hints & NATIVE_PARAMETER_IS_OUTPUT;
             }
+
+            fPorts.initParamsIn();
         }
 
         return true;
@@ -561,12 +563,7 @@ public:
                 const int index = std::atoi(msgIndex) - static_cast<int>(fPorts.indexOffset);
                 CARLA_SAFE_ASSERT_RETURN(index >= 0, LV2_WORKER_ERR_UNKNOWN);
 
-                float value;
-
-                {
-                    const CarlaScopedLocale csl;
-                    value = static_cast<float>(std::atof(msgSplit+1));
-                }
+                const float value = carla_stringToFloat(msgSplit+1);
 
                 fDescriptor->ui_set_parameter_value(fHandle, static_cast<uint32_t>(index), value);
             }
@@ -39,6 +39,7 @@
 
 #include "water/files/File.h"
 
+#include "CarlaFloatStringUtils.hpp"
 #include "CarlaMathUtils.hpp"
 #include "CarlaVstUtils.hpp"
 
@@ -311,8 +312,8 @@ public:
                 }
                 else
                 {
-                    std::snprintf(cptr, 23, "%.12g%s%s",
-                                  static_cast<double>(paramValue),
+                    std::snprintf(cptr, 23, "%s%s%s",
+                                  CarlaFloatString(paramValue).buffer,
                                   param->unit != nullptr && param->unit[0] != '\0' ? " " : "",
                                   param->unit != nullptr && param->unit[0] != '\0' ? param->unit : "");
                     cptr[23] = '\0';
@@ -16,6 +16,7 @@
  */
 
 #include "buffers.hpp"
+#include "CarlaFloatStringUtils.hpp"
 #include "CarlaMathUtils.hpp"
 
 #include <cstdio>
@@ -29,15 +30,15 @@ enum {
     kSizeBufSize = 31,
 };
 
-// static buffer to return json
+// per-thread buffer to return json
 // NOTE size is never checked for json, the buffer is big enough in order to assume it all always fits
-static char jsonBuf[kJsonBufSize+1];
+static thread_local char jsonBuf[kJsonBufSize+1];
 
-// static buffer to return size
-static char sizeBuf[kSizeBufSize+1];
+// per-thread buffer to return size
+static thread_local char sizeBuf[kSizeBufSize+1];
 
-// static buffer to return regular strings
-static char strBuf[kStrBufSize+1];
+// per-thread buffer to return regular strings
+static thread_local char strBuf[kStrBufSize+1];
 
 // -------------------------------------------------------------------------------------------------------------------
 
@@ -62,7 +63,7 @@ const char* str_buf_bool(const bool value)
 
 const char* str_buf_float(const double value)
 {
-    std::snprintf(strBuf, kStrBufSize, "%f", value);
+    std::strncpy(strBuf, CarlaFloatString(value).buffer, kStrBufSize);
     strBuf[kStrBufSize] = '\0';
     return strBuf;
 }
@@ -70,19 +71,16 @@ const char* str_buf_float(const double value)
 const char* str_buf_float_array(const double* const values, const char sep)
 {
     std::size_t bytesRead = 0;
-    char tmpBuf[32];
 
     for (int i=0; carla_isNotZero(values[i]) && bytesRead < kStrBufSize; ++i)
     {
-        std::snprintf(tmpBuf, 31, "%f", values[i]);
-        tmpBuf[31] = '\0';
-
-        const std::size_t size = std::strlen(tmpBuf);
+        const CarlaFloatString valueStr(values[i]);
+        const std::size_t size = std::strlen(valueStr.buffer);
 
         if (bytesRead + size > kStrBufSize)
             break;
 
-        std::strncpy(strBuf+bytesRead, tmpBuf, kStrBufSize - bytesRead);
+        std::strncpy(strBuf+bytesRead, valueStr.buffer, kStrBufSize - bytesRead);
         bytesRead += size;
         strBuf[bytesRead] = sep;
         bytesRead += 1;
@@ -310,3 +308,135 @@ const char* json_buf_end(char* jsonBufPtr)
 }
 
 // -------------------------------------------------------------------------------------------------------------------
+
+JsonBuffer::JsonBuffer()
+    : fBuffer("{"),
+      fNeedsComma(false)
+{
+    fBuffer.reserve(kJsonBufSize);
+}
+
+void JsonBuffer::addKey(const char* const key)
+{
+    if (fNeedsComma)
+        fBuffer += ',';
+
+    fNeedsComma = true;
+
+    if (key == nullptr)
+        return;
+
+    fBuffer += '"';
+    fBuffer += key;
+    fBuffer += "\":";
+}
+
+void JsonBuffer::addBool(const char* const key, const bool value)
+{
+    addKey(key);
+    fBuffer += value ? "true" : "false";
+}
+
+void JsonBuffer::addFloat(const char* const key, const double value)
+{
+    addKey(key);
+    fBuffer += CarlaFloatString(value).buffer;
+}
+
+void JsonBuffer::addFloatArray(const char* const key, const float* const values, const uint count)
+{
+    addKey(key);
+    fBuffer += '[';
+
+    for (uint i=0; i<count; ++i)
+    {
+        if (i != 0)
+            fBuffer += ',';
+        fBuffer += CarlaFloatString(values[i]).buffer;
+    }
+
+    fBuffer += ']';
+}
+
+void JsonBuffer::addInt(const char* const key, const int value)
+{
+    char tmpBuf[32];
+    std::snprintf(tmpBuf, 31, "%i", value);
+    tmpBuf[31] = '\0';
+
+    addKey(key);
+    fBuffer += tmpBuf;
+}
+
+void JsonBuffer::addUint(const char* const key, const uint value)
+{
+    char tmpBuf[32];
+    std::snprintf(tmpBuf, 31, "%u", value);
+    tmpBuf[31] = '\0';
+
+    addKey(key);
+    fBuffer += tmpBuf;
+}
+
+void JsonBuffer::addString(const char* const key, const char* const value)
+{
+    addKey(key);
+    fBuffer += '"';
+
+    for (const char* c = value; *c != '\0'; ++c)
+    {
+        switch (*c)
+        {
+        case '"':
+        case '\\':
+            fBuffer += '\\';
+            fBuffer += *c;
+            break;
+        case '\n':
+            fBuffer += "\\n";
+            break;
+        case '\f':
+            fBuffer += "\\f";
+            break;
+        default:
+            fBuffer += *c;
+            break;
+        }
+    }
+
+    fBuffer += '"';
+}
+
+void JsonBuffer::beginObject(const char* const key)
+{
+    addKey(key);
+    fBuffer += '{';
+    fNeedsComma = false;
+}
+
+void JsonBuffer::endObject()
+{
+    fBuffer += '}';
+    fNeedsComma = true;
+}
+
+void JsonBuffer::beginArray(const char* const key)
+{
+    addKey(key);
+    fBuffer += '[';
+    fNeedsComma = false;
+}
+
+void JsonBuffer::endArray()
+{
+    fBuffer += ']';
+    fNeedsComma = true;
+}
+
+const std::string& JsonBuffer::end()
+{
+    fBuffer += '}';
+    return fBuffer;
+}
+
+// -------------------------------------------------------------------------------------------------------------------
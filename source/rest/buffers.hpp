@@ -26,6 +26,8 @@
 # include <stdint.h>
 #endif
 
+#include <string>
+
 // size buf
 const char* size_buf(const char* const buf);
 
@@ -55,4 +57,34 @@ char* json_buf_add_uint64(char* jsonBufPtr, const char* const key, const uint64_
 char* json_buf_add_uint_array(char* jsonBufPtr, const char* const key, const uint* const values);
 const char* json_buf_end(char* jsonBufPtr);
 
+// growable json writer, owned by a single request or message so it needs no shared storage
+// NOTE nesting is not validated, callers must balance begin/end calls
+class JsonBuffer
+{
+public:
+    JsonBuffer();
+
+    void addBool(const char* const key, const bool value);
+    void addFloat(const char* const key, const double value);
+    void addFloatArray(const char* const key, const float* const values, const uint count);
+    void addInt(const char* const key, const int value);
+    void addUint(const char* const key, const uint value);
+    void addString(const char* const key, const char* const value);
+
+    // key can be null for unnamed objects inside arrays
+    void beginObject(const char* const key = nullptr);
+    void endObject();
+    void beginArray(const char* const key);
+    void endArray();
+
+    // close the top-level object, returns the final string
+    const std::string& end();
+
+private:
+    std::string fBuffer;
+    bool fNeedsComma;
+
+    void addKey(const char* const key);
+};
+
 #endif // REST_BUFFERS_HPP_INCLUDED
@@ -20,12 +20,57 @@
 #include "CarlaHost.h"
 #include "CarlaBackendUtils.hpp"
 
+#include <vector>
+
 // -------------------------------------------------------------------------------------------------------------------
 
 static bool gEngineRunning = false;
 
 // -------------------------------------------------------------------------------------------------------------------
 
+// parse a comma separated list of ids, as used by batched requests
+static std::vector<uint> parse_uint_list(const std::string& str)
+{
+    std::vector<uint> ret;
+
+    for (std::size_t pos = 0; pos < str.size();)
+    {
+        std::size_t next = str.find(',', pos);
+        if (next == std::string::npos)
+            next = str.size();
+
+        if (next > pos)
+        {
+            const int value = std::atoi(str.substr(pos, next - pos).c_str());
+            CARLA_SAFE_ASSERT_CONTINUE(value >= 0);
+            ret.push_back(static_cast<uint>(value));
+        }
+
+        pos = next + 1;
+    }
+
+    return ret;
+}
+
+static std::vector<float> parse_float_list(const std::string& str)
+{
+    std::vector<float> ret;
+
+    for (std::size_t pos = 0; pos < str.size();)
+    {
+        std::size_t next = str.find(',', pos);
+        if (next == std::string::npos)
+            next = str.size();
+
+        ret.push_back(static_cast<float>(std::atof(str.substr(pos, next - pos).c_str())));
+        pos = next + 1;
+    }
+
+    return ret;
+}
+
+// -------------------------------------------------------------------------------------------------------------------
+
 static void EngineCallback(void* ptr, EngineCallbackOpcode action, uint pluginId, int value1, int value2, float value3, const char* valueStr)
 {
     carla_debug("EngineCallback(%p, %u:%s, %u, %i, %i, %f, %s)",
@@ -908,6 +953,84 @@ void handle_carla_get_output_peak_value(const std::shared_ptr<Session> session)
     session->close(OK, buf, { { "Content-Length", size_buf(buf) } } );
 }
 
+// -------------------------------------------------------------------------------------------------------------------
+// batched getters, returning many values in a single request
+
+void handle_carla_get_current_parameter_values(const std::shared_ptr<Session> session)
+{
+    const std::shared_ptr<const Request> request = session->get_request();
+
+    const int pluginId = std::atoi(request->get_query_parameter("pluginId").c_str());
+    CARLA_SAFE_ASSERT_RETURN(pluginId >= 0,)
+
+    const uint32_t parameterCount = carla_get_parameter_count(pluginId);
+
+    // no parameterIds means all parameters
+    std::vector<uint> parameterIds(parse_uint_list(request->get_query_parameter("parameterIds")));
+
+    if (parameterIds.empty())
+    {
+        for (uint32_t i=0; i<parameterCount; ++i)
+            parameterIds.push_back(i);
+    }
+
+    JsonBuffer json;
+    json.addUint("pluginId", pluginId);
+    json.beginArray("parameters");
+
+    for (const uint parameterId : parameterIds)
+    {
+        CARLA_SAFE_ASSERT_CONTINUE(parameterId < parameterCount);
+
+        json.beginObject();
+        json.addUint("id", parameterId);
+        json.addFloat("value", carla_get_current_parameter_value(pluginId, parameterId));
+        json.endObject();
+    }
+
+    json.endArray();
+
+    const std::string& buf(json.end());
+    session->close(OK, buf, { { "Content-Length", size_buf(buf.c_str()) } } );
+}
+
+void handle_carla_get_peak_values(const std::shared_ptr<Session> session)
+{
+    const std::shared_ptr<const Request> request = session->get_request();
+
+    const uint pluginCount = carla_get_current_plugin_count();
+
+    // no pluginIds means all plugins
+    std::vector<uint> pluginIds(parse_uint_list(request->get_query_parameter("pluginIds")));
+
+    if (pluginIds.empty())
+    {
+        for (uint i=0; i<pluginCount; ++i)
+            pluginIds.push_back(i);
+    }
+
+    JsonBuffer json;
+    json.beginArray("peaks");
+
+    for (const uint pluginId : pluginIds)
+    {
+        CARLA_SAFE_ASSERT_CONTINUE(pluginId < pluginCount);
+
+        const float* const peaks = carla_get_peak_values(pluginId);
+        CARLA_SAFE_ASSERT_CONTINUE(peaks != nullptr);
+
+        json.beginObject();
+        json.addUint("pluginId", pluginId);
+        json.addFloatArray("values", peaks, 4);
+        json.endObject();
+    }
+
+    json.endArray();
+
+    const std::string& buf(json.end());
+    session->close(OK, buf, { { "Content-Length", size_buf(buf.c_str()) } } );
+}
+
 // -------------------------------------------------------------------------------------------------------------------
 
 void handle_carla_set_active(const std::shared_ptr<Session> session)
@@ -1043,6 +1166,28 @@ void handle_carla_set_parameter_value(const std::shared_ptr<Session> session)
     session->close(OK);
 }
 
+void handle_carla_set_parameter_values(const std::shared_ptr<Session> session)
+{
+    const std::shared_ptr<const Request> request = session->get_request();
+
+    const int pluginId = std::atoi(request->get_query_parameter("pluginId").c_str());
+    CARLA_SAFE_ASSERT_RETURN(pluginId >= 0,)
+
+    const std::vector<uint> parameterIds(parse_uint_list(request->get_query_parameter("parameterIds")));
+    const std::vector<float> values(parse_float_list(request->get_query_parameter("values")));
+
+    if (parameterIds.empty() || parameterIds.size() != values.size())
+    {
+        session->close(BAD_REQUEST);
+        return;
+    }
+
+    for (std::size_t i=0; i<parameterIds.size(); ++i)
+        carla_set_parameter_value(pluginId, parameterIds[i], values[i]);
+
+    session->close(OK);
+}
+
 void handle_carla_set_parameter_midi_channel(const std::shared_ptr<Session> session)
 {
     const std::shared_ptr<const Request> request = session->get_request();
@@ -31,8 +31,11 @@
 
 // -------------------------------------------------------------------------------------------------------------------
 
+#include <array>
+#include <cmath>
 #include <map>
 #include <restbed>
+#include <sstream>
 #include <system_error>
 #include <openssl/sha.h>
 #include <openssl/hmac.h>
@@ -51,6 +54,85 @@ CarlaMutex gSessionMessagesMutex;
 
 std::map< string, shared_ptr< WebSocket > > sockets = { };
 
+// -------------------------------------------------------------------------------------------------------------------
+// websocket subscriptions
+//
+// Clients send text frames in the form "subscribe <topic> [rateHz] [pluginIds]" or "unsubscribe <topic>",
+// where topic is one of "parameters", "peaks" or "runtime" and pluginIds a comma separated list (default all).
+// Subscribed sockets then receive json messages containing only the values that changed since the last push,
+// and stop receiving the legacy "Peaks:" broadcast.
+
+static const uint kEventStreamIntervalMs = 33;
+static const uint kSubscriptionMaxRate   = 1000 / kEventStreamIntervalMs;
+
+struct SocketSubscription {
+    struct Topic {
+        bool enabled;
+        uint intervalMs;
+        int64_t lastSentMs;
+
+        Topic()
+            : enabled(false),
+              intervalMs(0),
+              lastSentMs(0) {}
+
+        bool isDue(const int64_t nowMs)
+        {
+            if (! enabled || nowMs - lastSentMs < static_cast<int64_t>(intervalMs))
+                return false;
+
+            lastSentMs = nowMs;
+            return true;
+        }
+    };
+
+    Topic parameters, peaks, runtime;
+
+    // empty means all plugins
+    std::vector<uint> pluginIds;
+
+    // last values sent to this socket, NaN for never sent
+    std::vector<std::vector<float>> lastParameters;
+    std::vector<std::array<float, 4>> lastPeaks;
+    float lastLoad;
+    uint32_t lastXruns;
+
+    SocketSubscription()
+        : lastLoad(NAN),
+          lastXruns(0) {}
+
+    bool isActive() const noexcept
+    {
+        return parameters.enabled || peaks.enabled || runtime.enabled;
+    }
+
+    bool wantsPlugin(const uint pluginId) const noexcept
+    {
+        if (pluginIds.empty())
+            return true;
+
+        for (const uint id : pluginIds)
+            if (id == pluginId)
+                return true;
+
+        return false;
+    }
+
+    Topic* getTopic(const std::string& name) noexcept
+    {
+        if (name == "parameters")
+            return &parameters;
+        if (name == "peaks")
+            return &peaks;
+        if (name == "runtime")
+            return &runtime;
+        return nullptr;
+    }
+};
+
+std::map<string, SocketSubscription> gSubscriptions;
+CarlaMutex gSubscriptionsMutex;
+
 // -------------------------------------------------------------------------------------------------------------------
 
 void send_server_side_message(const char* const message)
@@ -62,6 +144,201 @@ void send_server_side_message(const char* const message)
 
 // -------------------------------------------------------------------------------------------------------------------
 
+static bool handle_subscription_message(const string& key, const string& message, string& reply)
+{
+    std::istringstream stream(message);
+    string command, topicName, pluginIds;
+    uint rate = kSubscriptionMaxRate, requestedRate;
+
+    stream >> command >> topicName;
+
+    if (command != "subscribe" && command != "unsubscribe")
+        return false;
+
+    const CarlaMutexLocker cml(gSubscriptionsMutex);
+
+    SocketSubscription& subscription(gSubscriptions[key]);
+    SocketSubscription::Topic* const topic = subscription.getTopic(topicName);
+
+    if (topic == nullptr)
+    {
+        if (! subscription.isActive())
+            gSubscriptions.erase(key);
+
+        reply = "Error: unknown topic '" + topicName + "'";
+        return true;
+    }
+
+    if (command == "unsubscribe")
+    {
+        topic->enabled = false;
+
+        if (! subscription.isActive())
+            gSubscriptions.erase(key);
+
+        reply = "Unsubscribed: " + topicName;
+        return true;
+    }
+
+    if (stream >> requestedRate)
+        rate = std::max(1U, std::min(requestedRate, kSubscriptionMaxRate));
+
+    if (stream >> pluginIds)
+        subscription.pluginIds = parse_uint_list(pluginIds);
+
+    topic->enabled = true;
+    topic->intervalMs = 1000 / rate;
+    topic->lastSentMs = 0;
+
+    // make sure the first push contains everything
+    if (topic == &subscription.parameters)
+        subscription.lastParameters.clear();
+    else if (topic == &subscription.peaks)
+        subscription.lastPeaks.clear();
+    else
+        subscription.lastLoad = NAN;
+
+    reply = "Subscribed: " + topicName;
+    return true;
+}
+
+static bool push_parameter_changes(SocketSubscription& subscription, const uint pluginCount, JsonBuffer& json)
+{
+    subscription.lastParameters.resize(pluginCount);
+
+    bool changed = false;
+
+    json.addString("type", "parameters");
+    json.beginArray("changes");
+
+    for (uint i=0; i<pluginCount; ++i)
+    {
+        if (! subscription.wantsPlugin(i))
+            continue;
+
+        std::vector<float>& lastValues(subscription.lastParameters[i]);
+        const uint32_t parameterCount = carla_get_parameter_count(i);
+
+        if (lastValues.size() != parameterCount)
+            lastValues.assign(parameterCount, NAN);
+
+        for (uint32_t j=0; j<parameterCount; ++j)
+        {
+            const float value = carla_get_current_parameter_value(i, j);
+
+            // NaN never compares equal, so unsent values always go out
+            if (value == lastValues[j])
+                continue;
+
+            lastValues[j] = value;
+            changed = true;
+
+            json.beginObject();
+            json.addUint("pluginId", i);
+            json.addUint("parameterId", j);
+            json.addFloat("value", value);
+            json.endObject();
+        }
+    }
+
+    json.endArray();
+    return changed;
+}
+
+static bool push_peak_changes(SocketSubscription& subscription, const uint pluginCount, JsonBuffer& json)
+{
+    subscription.lastPeaks.resize(pluginCount, {{ NAN, NAN, NAN, NAN }});
+
+    bool changed = false;
+
+    json.addString("type", "peaks");
+    json.beginArray("changes");
+
+    for (uint i=0; i<pluginCount; ++i)
+    {
+        if (! subscription.wantsPlugin(i))
+            continue;
+
+        const float* const peaks = carla_get_peak_values(i);
+        CARLA_SAFE_ASSERT_CONTINUE(peaks != nullptr);
+
+        std::array<float, 4>& lastPeaks(subscription.lastPeaks[i]);
+
+        if (peaks[0] == lastPeaks[0] && peaks[1] == lastPeaks[1] &&
+            peaks[2] == lastPeaks[2] && peaks[3] == lastPeaks[3])
+            continue;
+
+        std::memcpy(lastPeaks.data(), peaks, sizeof(float)*4);
+        changed = true;
+
+        json.beginObject();
+        json.addUint("pluginId", i);
+        json.addFloatArray("values", peaks, 4);
+        json.endObject();
+    }
+
+    json.endArray();
+    return changed;
+}
+
+static bool push_runtime_changes(SocketSubscription& subscription, JsonBuffer& json)
+{
+    const CarlaRuntimeEngineInfo* const info = carla_get_runtime_engine_info();
+    CARLA_SAFE_ASSERT_RETURN(info != nullptr, false);
+
+    if (info->load == subscription.lastLoad && info->xruns == subscription.lastXruns)
+        return false;
+
+    subscription.lastLoad = info->load;
+    subscription.lastXruns = info->xruns;
+
+    json.addString("type", "runtime");
+    json.addFloat("load", info->load);
+    json.addUint("xruns", info->xruns);
+    return true;
+}
+
+// returns true if the socket has active subscriptions, in which case legacy peak messages are skipped
+static bool push_subscribed_changes(const string& key, const shared_ptr<WebSocket>& socket, const uint pluginCount)
+{
+    const CarlaMutexLocker cml(gSubscriptionsMutex);
+
+    auto it = gSubscriptions.find(key);
+
+    if (it == gSubscriptions.end())
+        return false;
+
+    SocketSubscription& subscription(it->second);
+    const int64_t nowMs = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+
+    if (pluginCount != 0 && subscription.parameters.isDue(nowMs))
+    {
+        JsonBuffer json;
+
+        // nothing changed is the common case, skip sending then
+        if (push_parameter_changes(subscription, pluginCount, json))
+            socket->send(json.end());
+    }
+
+    if (pluginCount != 0 && subscription.peaks.isDue(nowMs))
+    {
+        JsonBuffer json;
+
+        if (push_peak_changes(subscription, pluginCount, json))
+            socket->send(json.end());
+    }
+
+    if (subscription.runtime.isDue(nowMs))
+    {
+        JsonBuffer json;
+
+        if (push_runtime_changes(subscription, json))
+            socket->send(json.end());
+    }
+
+    return subscription.isActive();
+}
+
 static void event_stream_handler(void)
 {
     static bool firstInit = true;
@@ -99,10 +376,23 @@ static void event_stream_handler(void)
 
     if (running)
     {
-        if (const uint count = carla_get_current_plugin_count())
+        const uint count = carla_get_current_plugin_count();
+
+        // sockets without subscriptions keep getting all peaks, every time
+        std::vector<shared_ptr<WebSocket>> legacySockets;
+
+        for (auto entry : sockets)
+        {
+            auto socket = entry.second;
+
+            if (socket->is_open() && ! push_subscribed_changes(entry.first, socket, count))
+                legacySockets.push_back(socket);
+        }
+
+        if (count != 0 && ! legacySockets.empty())
         {
             char msgBuf[1024];
-            float* peaks;
+            const float* peaks;
 
             for (uint i=0; i<count; ++i)
             {
@@ -112,13 +402,8 @@ static void event_stream_handler(void)
                 std::snprintf(msgBuf, 1023, "Peaks: %u %f %f %f %f", i, peaks[0], peaks[1], peaks[2], peaks[3]);
                 msgBuf[1023] = '\0';
 
-                for (auto entry : sockets)
-                {
-                    auto socket = entry.second;
-
-                    if (socket->is_open())
-                        socket->send(msgBuf);
-                }
+                for (auto socket : legacySockets)
+                    socket->send(msgBuf);
             }
         }
     }
@@ -186,6 +471,11 @@ void close_handler( const shared_ptr< WebSocket > socket )
     const auto key = socket->get_key( );
     sockets.erase( key );
 
+    {
+        const CarlaMutexLocker cml(gSubscriptionsMutex);
+        gSubscriptions.erase( key );
+    }
+
     fprintf( stderr, "Closed connection to %s.\n", key.data( ) );
 }
 
@@ -228,18 +518,19 @@ void message_handler( const shared_ptr< WebSocket > source, const shared_ptr< We
     }
     else if ( opcode == WebSocketMessage::TEXT_FRAME )
     {
-        auto response = make_shared< WebSocketMessage >( *message );
-        response->set_mask( 0 );
+        const auto key = source->get_key( );
+        const auto& data = message->get_data( );
+        const string text( data.begin( ), data.end( ) );
+        string reply;
 
-        for ( auto socket : sockets )
+        if ( handle_subscription_message( key, text, reply ) )
         {
-            auto destination = socket.second;
-            destination->send( response );
+            source->send( reply );
+            return;
         }
 
-        const auto key = source->get_key( );
-        const auto data = String::format( "Received message '%.*s' from %s\n", message->get_data( ).size( ), message->get_data( ).data( ), key.data( ) );
-        fprintf( stderr, "%s", data.data( ) );
+        const auto log = String::format( "Received unknown message '%s' from %s\n", text.data( ), key.data( ) );
+        fprintf( stderr, "%s", log.data( ) );
     }
 }
 
@@ -400,6 +691,8 @@ int main(int, const char**)
     make_resource(service, "/get_internal_parameter_value", handle_carla_get_internal_parameter_value);
     make_resource(service, "/get_input_peak_value", handle_carla_get_input_peak_value);
     make_resource(service, "/get_output_peak_value", handle_carla_get_output_peak_value);
+    make_resource(service, "/get_current_parameter_values", handle_carla_get_current_parameter_values);
+    make_resource(service, "/get_peak_values", handle_carla_get_peak_values);
 
     make_resource(service, "/set_active", handle_carla_set_active);
     make_resource(service, "/set_drywet", handle_carla_set_drywet);
@@ -411,6 +704,7 @@ int main(int, const char**)
     make_resource(service, "/set_option", handle_carla_set_option);
 
     make_resource(service, "/set_parameter_value", handle_carla_set_parameter_value);
+    make_resource(service, "/set_parameter_values", handle_carla_set_parameter_values);
     make_resource(service, "/set_parameter_midi_channel", handle_carla_set_parameter_midi_channel);
     make_resource(service, "/set_parameter_midi_cc", handle_carla_set_parameter_midi_cc);
     make_resource(service, "/set_program", handle_carla_set_program);
@@ -437,7 +731,7 @@ int main(int, const char**)
     make_resource(service, "/get_cached_plugin_info", handle_carla_get_cached_plugin_info);
 
     // schedule events
-    service.schedule(event_stream_handler, std::chrono::milliseconds(33));
+    service.schedule(event_stream_handler, std::chrono::milliseconds(kEventStreamIntervalMs));
     service.schedule(ping_handler, milliseconds(5000));
 
     std::shared_ptr<Settings> settings = std::make_shared<Settings>();
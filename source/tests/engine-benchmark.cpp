@@ -0,0 +1,440 @@
+/*
+ * Carla engine benchmarks
+ * Copyright (C) 2020 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+/*
+ * Measures the cost of the main engine code paths, so regressions can be spotted between releases:
+ *  - rack and patchbay graph cycle time vs. number of internal plugins (dummy driver in benchmark mode)
+ *  - bridge RT round-trip latency through BridgeRtClientControl (client runs in a local thread)
+ *  - CarlaRingBufferControl throughput
+ *  - MIDI <-> engine event conversion
+ *  - project load time
+ *
+ * Usage: engine-benchmark [seconds-per-graph-measurement]
+ */
+
+#include "CarlaHost.h"
+#include "CarlaEngine.hpp"
+
+#include "CarlaBridgeUtils.hpp"
+#include "CarlaMIDI.h"
+#include "CarlaRingBuffer.hpp"
+#include "CarlaThread.hpp"
+#include "CarlaTimeUtils.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+CARLA_BACKEND_USE_NAMESPACE
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static void runIdleFor(const CarlaHostHandle handle, const uint msecs)
+{
+    const int64_t end = carla_gettime_us() + static_cast<int64_t>(msecs) * 1000;
+
+    while (carla_gettime_us() < end)
+    {
+        carla_engine_idle(handle);
+        carla_msleep(20);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Graph cycle cost vs plugin count
+
+static const uint kBufferSize = 256;
+static const uint kSampleRate = 48000;
+
+static bool initEngine(const CarlaHostHandle handle, const EngineProcessMode processMode)
+{
+    carla_set_engine_option(handle, ENGINE_OPTION_PROCESS_MODE, processMode, nullptr);
+    carla_set_engine_option(handle, ENGINE_OPTION_AUDIO_BUFFER_SIZE, kBufferSize, nullptr);
+    carla_set_engine_option(handle, ENGINE_OPTION_AUDIO_SAMPLE_RATE, kSampleRate, nullptr);
+
+    if (carla_engine_init(handle, "Dummy", "engine-benchmark"))
+        return true;
+
+    std::fprintf(stderr, "Failed to init engine: %s\n", carla_get_last_error(handle));
+    return false;
+}
+
+static bool addInternalPlugins(const CarlaHostHandle handle, const uint32_t count)
+{
+    while (carla_get_current_plugin_count(handle) < count)
+    {
+        if (! carla_add_plugin(handle, BINARY_NATIVE, PLUGIN_INTERNAL, nullptr, nullptr, "audiogain_s", 0,
+                               nullptr, PLUGIN_OPTIONS_NULL))
+        {
+            std::fprintf(stderr, "Failed to add plugin: %s\n", carla_get_last_error(handle));
+            return false;
+        }
+
+        carla_set_active(handle, carla_get_current_plugin_count(handle) - 1, true);
+    }
+
+    return true;
+}
+
+static void benchmarkGraph(const CarlaHostHandle handle, const EngineProcessMode processMode,
+                           const char* const modeName, const uint msecs)
+{
+    static const uint32_t kPluginCounts[] = { 0, 1, 4, 16, 64 };
+
+    if (! initEngine(handle, processMode))
+        return;
+
+    std::printf("%s graph, %u frames @ %uHz (%.1fus per cycle in realtime)\n",
+                modeName, kBufferSize, kSampleRate, 1000000.0 * kBufferSize / kSampleRate);
+    std::printf("  plugins     cycles   avg(us)   max(us)  process avg(us)\n");
+
+    for (uint i=0; i < sizeof(kPluginCounts)/sizeof(kPluginCounts[0]); ++i)
+    {
+        if (! addInternalPlugins(handle, kPluginCounts[i]))
+            break;
+
+        // let things settle, then only look at cycles after that
+        runIdleFor(handle, 200);
+
+        const int64_t startTime = carla_gettime_us();
+        runIdleFor(handle, msecs);
+
+        const CarlaEngineCycleHistory* const history = carla_get_engine_cycle_history(handle, 8192);
+        CARLA_SAFE_ASSERT_CONTINUE(history != nullptr);
+
+        uint count = 0;
+        uint64_t total = 0, process = 0;
+        uint32_t maximum = 0;
+
+        for (uint j=0; j < history->count; ++j)
+        {
+            const CarlaEngineCycleInfo& cycle(history->cycles[j]);
+
+            if (cycle.startTime < startTime)
+                continue;
+
+            ++count;
+            total   += cycle.totalUsecs;
+            process += cycle.processUsecs;
+
+            if (cycle.totalUsecs > maximum)
+                maximum = cycle.totalUsecs;
+        }
+
+        if (count == 0)
+        {
+            std::printf("  %7u  (no cycles recorded)\n", kPluginCounts[i]);
+            continue;
+        }
+
+        std::printf("  %7u  %9u  %8.2f  %8u  %15.2f\n",
+                    kPluginCounts[i], count,
+                    static_cast<double>(total) / count, maximum,
+                    static_cast<double>(process) / count);
+    }
+
+    carla_remove_all_plugins(handle);
+    carla_engine_close(handle);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Project load time
+
+static void benchmarkProjectLoad(const CarlaHostHandle handle)
+{
+    static const uint32_t kNumPlugins = 32;
+
+    if (! initEngine(handle, ENGINE_PROCESS_MODE_CONTINUOUS_RACK))
+        return;
+
+    char filename[64];
+    std::snprintf(filename, sizeof(filename), "/tmp/carla-engine-benchmark-%i.carxp", static_cast<int>(getpid()));
+
+    if (addInternalPlugins(handle, kNumPlugins) && carla_save_project(handle, filename))
+    {
+        carla_remove_all_plugins(handle);
+        runIdleFor(handle, 100);
+
+        const int64_t startTime = carla_gettime_us();
+        const bool ok = carla_load_project(handle, filename);
+        const int64_t endTime = carla_gettime_us();
+
+        if (ok)
+            std::printf("Project load, %u internal plugins: %.2fms\n",
+                        carla_get_current_plugin_count(handle),
+                        static_cast<double>(endTime - startTime) / 1000.0);
+        else
+            std::fprintf(stderr, "Failed to load project: %s\n", carla_get_last_error(handle));
+
+        std::remove(filename);
+    }
+
+    carla_remove_all_plugins(handle);
+    carla_engine_close(handle);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Bridge RT round-trip
+
+class BridgeClientThread : public CarlaThread
+{
+public:
+    BridgeClientThread(const char* const basename)
+        : CarlaThread("BridgeClientThread"),
+          fBaseName(basename),
+          fControl() {}
+
+    bool attach()
+    {
+        return fControl.attachClient(fBaseName) && fControl.mapData();
+    }
+
+protected:
+    void run() override
+    {
+        for (bool quit = false; ! quit && ! shouldThreadExit();)
+        {
+            const BridgeRtClientControl::WaitHelper helper(fControl);
+
+            if (! helper.ok)
+                continue;
+
+            for (; fControl.isDataAvailableForReading();)
+            {
+                const PluginBridgeRtClientOpcode opcode = fControl.readOpcode();
+
+                switch (opcode)
+                {
+                case kPluginBridgeRtClientProcess:
+                    fControl.readUInt();
+                    break;
+                case kPluginBridgeRtClientQuit:
+                    quit = true;
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+    }
+
+private:
+    const char* const fBaseName;
+    BridgeRtClientControl fControl;
+};
+
+static void benchmarkBridgeRoundTrip(const uint spinUsecs)
+{
+    static const uint kNumRoundTrips = 20000;
+
+    BridgeRtClientControl server;
+
+    if (! server.initializeServer())
+    {
+        std::fprintf(stderr, "Failed to create bridge shared memory\n");
+        return;
+    }
+
+    // the client side only needs the random part of the name, same as the real bridges
+    BridgeClientThread client(server.filename.buffer() + server.filename.length() - 6);
+
+    if (! client.attach() || ! client.startThread(true))
+    {
+        std::fprintf(stderr, "Failed to start bridge client\n");
+        server.clear();
+        return;
+    }
+
+    int64_t total = 0, minimum = INT64_MAX, maximum = 0;
+    uint count = 0;
+
+    for (uint i=0; i < kNumRoundTrips; ++i)
+    {
+        const int64_t startTime = carla_gettime_us();
+
+        server.writeOpcode(kPluginBridgeRtClientProcess);
+        server.writeUInt(kBufferSize);
+        server.commitWrite();
+
+        if (! server.waitForClient(1000, spinUsecs))
+        {
+            std::fprintf(stderr, "Bridge client timed out\n");
+            break;
+        }
+
+        const int64_t elapsed = carla_gettime_us() - startTime;
+
+        ++count;
+        total += elapsed;
+
+        if (elapsed < minimum)
+            minimum = elapsed;
+        if (elapsed > maximum)
+            maximum = elapsed;
+    }
+
+    server.writeOpcode(kPluginBridgeRtClientQuit);
+    server.commitWrite();
+    server.waitForClient(1000);
+
+    client.stopThread(2000);
+    server.clear();
+
+    if (count != 0)
+        std::printf("Bridge RT round-trip, spin %3uus: avg %.2fus, min " P_INT64 "us, max " P_INT64 "us\n",
+                    spinUsecs, static_cast<double>(total) / count, minimum, maximum);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Ring buffer throughput
+
+struct RingBufferMessage {
+    uint32_t opcode;
+    uint32_t frame;
+    float value;
+    uint8_t data[4];
+};
+
+static void benchmarkRingBuffer()
+{
+    static const uint kNumMessages = 4000000;
+    static const uint kBatchSize   = 64;
+
+    CarlaHeapRingBuffer ringBuffer;
+    ringBuffer.createBuffer(kBatchSize * sizeof(RingBufferMessage) * 2);
+
+    RingBufferMessage msg;
+    carla_zeroStruct(msg);
+
+    uint64_t checksum = 0;
+    const int64_t startTime = carla_gettime_us();
+
+    for (uint i=0; i < kNumMessages; i += kBatchSize)
+    {
+        for (uint j=0; j < kBatchSize; ++j)
+        {
+            msg.frame = i + j;
+            ringBuffer.writeCustomType(msg);
+        }
+
+        ringBuffer.commitWrite();
+
+        for (uint j=0; j < kBatchSize; ++j)
+        {
+            ringBuffer.readCustomType(msg);
+            checksum += msg.frame;
+        }
+    }
+
+    const int64_t elapsed = carla_gettime_us() - startTime;
+
+    std::printf("Ring buffer, %u-byte messages: %.2f M messages/s (checksum " P_UINT64 ")\n",
+                static_cast<uint>(sizeof(RingBufferMessage)),
+                static_cast<double>(kNumMessages) / static_cast<double>(elapsed),
+                checksum);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Event conversion
+
+static void benchmarkEventConversion()
+{
+    static const uint kNumEvents = 4000000;
+
+    uint64_t checksum = 0;
+
+    // MIDI => engine event
+    {
+        EngineEvent event;
+        uint8_t midiData[3] = { 0, 0, 0 };
+
+        const int64_t startTime = carla_gettime_us();
+
+        for (uint i=0; i < kNumEvents; ++i)
+        {
+            switch (i % 4)
+            {
+            case 0: midiData[0] = MIDI_STATUS_NOTE_ON; break;
+            case 1: midiData[0] = MIDI_STATUS_NOTE_OFF; break;
+            case 2: midiData[0] = MIDI_STATUS_CONTROL_CHANGE; break;
+            case 3: midiData[0] = MIDI_STATUS_PITCH_WHEEL_CONTROL; break;
+            }
+
+            midiData[0] = static_cast<uint8_t>(midiData[0] | (i % MAX_MIDI_CHANNELS));
+            midiData[1] = static_cast<uint8_t>(i % MAX_MIDI_VALUE);
+            midiData[2] = static_cast<uint8_t>((i >> 7) % MAX_MIDI_VALUE);
+
+            event.fillFromMidiData(3, midiData, 0);
+            checksum += event.type;
+        }
+
+        const int64_t elapsed = carla_gettime_us() - startTime;
+
+        std::printf("MIDI to engine event: %.2fns per event\n",
+                    static_cast<double>(elapsed) * 1000.0 / kNumEvents);
+    }
+
+    // engine control event => MIDI
+    {
+        EngineControlEvent ctrlEvent;
+        carla_zeroStruct(ctrlEvent);
+        ctrlEvent.type = kEngineControlEventTypeParameter;
+
+        uint8_t midiData[3];
+
+        const int64_t startTime = carla_gettime_us();
+
+        for (uint i=0; i < kNumEvents; ++i)
+        {
+            ctrlEvent.param = static_cast<uint16_t>(i % MAX_MIDI_VALUE);
+            ctrlEvent.normalizedValue = static_cast<float>(i % 1000) / 1000.0f;
+
+            checksum += ctrlEvent.convertToMidiData(static_cast<uint8_t>(i % MAX_MIDI_CHANNELS), midiData);
+        }
+
+        const int64_t elapsed = carla_gettime_us() - startTime;
+
+        std::printf("Control event to MIDI: %.2fns per event (checksum " P_UINT64 ")\n",
+                    static_cast<double>(elapsed) * 1000.0 / kNumEvents, checksum);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    const uint msecs = argc > 1 ? static_cast<uint>(std::atof(argv[1]) * 1000.0) : 2000;
+
+    benchmarkRingBuffer();
+    benchmarkEventConversion();
+    benchmarkBridgeRoundTrip(0);
+    benchmarkBridgeRoundTrip(50);
+
+    // run the dummy driver cycles back to back
+    carla_setenv("CARLA_DUMMY_BENCHMARK", "1");
+
+    const CarlaHostHandle handle = carla_standalone_host_init();
+    CARLA_SAFE_ASSERT_RETURN(handle != nullptr, 1);
+
+    benchmarkGraph(handle, ENGINE_PROCESS_MODE_CONTINUOUS_RACK, "Rack", msecs);
+    benchmarkGraph(handle, ENGINE_PROCESS_MODE_PATCHBAY, "Patchbay", msecs);
+    benchmarkProjectLoad(handle);
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
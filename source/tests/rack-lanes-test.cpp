@@ -0,0 +1,243 @@
+/*
+ * Carla rack lanes test
+ * Copyright (C) 2020 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+/*
+ * Renders the same rack in serial mode and with ENGINE_OPTION_RACK_LANES, and checks the results are identical.
+ * The rack is an effect followed by 2 audio file players, which have no audio inputs and so start new lanes.
+ * Players only add the audio coming from earlier plugins to their own, so for this rack lanes must not change
+ * the signal flow.
+ * Each player uses its own tone, both tones must be present in each output so silence cannot pass as a match.
+ */
+
+#include "CarlaHost.h"
+#include "CarlaUtils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+CARLA_BACKEND_USE_NAMESPACE
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+static const uint kBufferSize = 256;
+static const uint kSampleRate = 48000;
+static const uint kRenderFrames = kSampleRate;
+
+// rendered files are 32-bit float stereo WAV, see CarlaEngineRenderWriter
+static const std::size_t kRenderHeaderSize = 58;
+
+static const double kToneFreq1 = 440.0;
+static const double kToneFreq2 = 660.0;
+
+// lowest amplitude for a tone to count as present, the players write it at about 0.5
+static const double kMinToneAmplitude = 0.05;
+
+static void writeLE(std::FILE* const file, uint32_t value, const uint bytes)
+{
+    for (uint i=0; i < bytes; ++i, value >>= 8)
+        std::fputc(static_cast<int>(value & 0xff), file);
+}
+
+// writes a short 16-bit stereo WAV file with a sine wave at 'freq' Hz
+static bool writeSineFile(const char* const filename, const double freq)
+{
+    std::FILE* const file = std::fopen(filename, "wb");
+    CARLA_SAFE_ASSERT_RETURN(file != nullptr, false);
+
+    const uint32_t frames   = kSampleRate / 2;
+    const uint32_t dataSize = frames * 2 * 2;
+
+    std::fputs("RIFF", file);
+    writeLE(file, 36 + dataSize, 4);
+    std::fputs("WAVEfmt ", file);
+    writeLE(file, 16, 4);
+    writeLE(file, 1, 2); // PCM
+    writeLE(file, 2, 2);
+    writeLE(file, kSampleRate, 4);
+    writeLE(file, kSampleRate * 2 * 2, 4);
+    writeLE(file, 2 * 2, 2);
+    writeLE(file, 16, 2);
+    std::fputs("data", file);
+    writeLE(file, dataSize, 4);
+
+    for (uint32_t i=0; i < frames; ++i)
+    {
+        const double value = std::sin(2.0 * M_PI * freq * i / kSampleRate) * 16000.0;
+        const uint32_t sample = static_cast<uint16_t>(static_cast<int16_t>(value));
+
+        writeLE(file, sample, 2);
+        writeLE(file, sample, 2);
+    }
+
+    return std::fclose(file) == 0;
+}
+
+static bool readFile(const char* const filename, std::vector<char>& data)
+{
+    std::FILE* const file = std::fopen(filename, "rb");
+    CARLA_SAFE_ASSERT_RETURN(file != nullptr, false);
+
+    char buf[4096];
+
+    for (std::size_t r; (r = std::fread(buf, 1, sizeof(buf), file)) != 0;)
+        data.insert(data.end(), buf, buf + r);
+
+    std::fclose(file);
+    return ! data.empty();
+}
+
+// amplitude of a tone in the left channel of a rendered file, using the Goertzel algorithm
+static double getToneAmplitude(const std::vector<char>& data, const double freq)
+{
+    if (data.size() <= kRenderHeaderSize)
+        return 0.0;
+
+    const std::size_t frames = (data.size() - kRenderHeaderSize) / (sizeof(float) * 2);
+    const double coeff = 2.0 * std::cos(2.0 * M_PI * freq / kSampleRate);
+    double s1 = 0.0, s2 = 0.0;
+
+    for (std::size_t i=0; i < frames; ++i)
+    {
+        float sample;
+        std::memcpy(&sample, &data[kRenderHeaderSize + i * sizeof(float) * 2], sizeof(float));
+
+        const double s0 = sample + coeff * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+
+    const double power = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+    return frames != 0 ? 2.0 * std::sqrt(std::max(power, 0.0)) / static_cast<double>(frames) : 0.0;
+}
+
+static bool hasBothTones(const char* const name, const std::vector<char>& data)
+{
+    const double amp1 = getToneAmplitude(data, kToneFreq1);
+    const double amp2 = getToneAmplitude(data, kToneFreq2);
+
+    if (amp1 >= kMinToneAmplitude && amp2 >= kMinToneAmplitude)
+        return true;
+
+    std::fprintf(stderr, "rack-lanes-test: %s output is missing a lane, tone amplitudes are %f and %f\n",
+                 name, amp1, amp2);
+    return false;
+}
+
+// returns 0 if rendered, 1 on failure and 2 if the rack could not be set up (skipped)
+static int renderRack(const CarlaHostHandle handle, const bool rackLanes,
+                      const char* const inFile1, const char* const inFile2, const char* const outFile)
+{
+    carla_set_engine_option(handle, ENGINE_OPTION_PROCESS_MODE, ENGINE_PROCESS_MODE_CONTINUOUS_RACK, nullptr);
+    carla_set_engine_option(handle, ENGINE_OPTION_AUDIO_BUFFER_SIZE, kBufferSize, nullptr);
+    carla_set_engine_option(handle, ENGINE_OPTION_AUDIO_SAMPLE_RATE, kSampleRate, nullptr);
+    carla_set_engine_option(handle, ENGINE_OPTION_PROCESSING_THREADS, 2, nullptr);
+    carla_set_engine_option(handle, ENGINE_OPTION_RACK_LANES, rackLanes ? 1 : 0, nullptr);
+
+    if (! carla_engine_init(handle, "Render", "rack-lanes-test"))
+    {
+        std::fprintf(stderr, "Failed to init engine: %s\n", carla_get_last_error(handle));
+        return 2;
+    }
+
+    static const char* const kLabels[] = { "audiogain_s", "audiofile", "audiofile" };
+    const char* const files[] = { nullptr, inFile1, inFile2 };
+    int ret = 0;
+
+    for (uint i=0; i < 3 && ret == 0; ++i)
+    {
+        if (! carla_add_plugin(handle, BINARY_NATIVE, PLUGIN_INTERNAL, nullptr, nullptr, kLabels[i], 0,
+                               nullptr, PLUGIN_OPTIONS_NULL))
+        {
+            std::fprintf(stderr, "Failed to add plugin '%s': %s\n", kLabels[i], carla_get_last_error(handle));
+            ret = 2;
+            break;
+        }
+
+        if (files[i] != nullptr)
+            carla_set_custom_data(handle, i, CUSTOM_DATA_TYPE_STRING, "file", files[i]);
+
+        carla_set_active(handle, i, true);
+    }
+
+    // let the players load their files
+    for (uint i=0; i < 25 && ret == 0; ++i)
+    {
+        carla_engine_idle(handle);
+        carla_msleep(20);
+    }
+
+    if (ret == 0 && ! carla_render_to_file(handle, outFile, kRenderFrames))
+    {
+        std::fprintf(stderr, "Failed to render: %s\n", carla_get_last_error(handle));
+        ret = 1;
+    }
+
+    carla_engine_close(handle);
+    return ret;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    const char* const inFile1   = "/tmp/carla-rack-lanes-test-in1.wav";
+    const char* const inFile2   = "/tmp/carla-rack-lanes-test-in2.wav";
+    const char* const serialOut = "/tmp/carla-rack-lanes-test-serial.wav";
+    const char* const lanesOut  = "/tmp/carla-rack-lanes-test-lanes.wav";
+
+    if (! writeSineFile(inFile1, kToneFreq1) || ! writeSineFile(inFile2, kToneFreq2))
+        return 1;
+
+    const CarlaHostHandle handle = carla_standalone_host_init();
+    CARLA_SAFE_ASSERT_RETURN(handle != nullptr, 1);
+
+    int ret = renderRack(handle, false, inFile1, inFile2, serialOut);
+
+    if (ret == 0)
+        ret = renderRack(handle, true, inFile1, inFile2, lanesOut);
+
+    if (ret == 2)
+    {
+        std::printf("rack-lanes-test: skipped, required internal plugins are not available\n");
+        return 0;
+    }
+
+    if (ret != 0)
+        return ret;
+
+    std::vector<char> serialData, lanesData;
+
+    if (! readFile(serialOut, serialData) || ! readFile(lanesOut, lanesData))
+        return 1;
+
+    if (! hasBothTones("serial", serialData) || ! hasBothTones("lanes", lanesData))
+        return 1;
+
+    if (serialData != lanesData)
+    {
+        std::fprintf(stderr, "rack-lanes-test: lanes output differs from serial rack output\n");
+        return 1;
+    }
+
+    std::printf("rack-lanes-test: lanes output matches serial rack output\n");
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
@@ -1061,16 +1061,17 @@ void CarlaStyle::drawPrimitive(PrimitiveElement elem,
     }
         break;
     case PE_IndicatorCheckBox:
-        painter->save();
         if (const QStyleOptionButton *checkbox = qstyleoption_cast<const QStyleOptionButton*>(option)) {
-            painter->setRenderHint(QPainter::Antialiasing, true);
-            painter->translate(0.5, 0.5);
+            BEGIN_STYLE_PIXMAPCACHE(QString::fromLatin1("checkbox"))
+            p->save();
+            p->setRenderHint(QPainter::Antialiasing, true);
+            p->translate(0.5, 0.5);
             rect = rect.adjusted(0, 0, -1, -1);
 
             const QColor& baseColor = option->palette.base().color();
 
             QColor pressedColor = mergedColors(baseColor, qt_palette_fg_color(option->palette), 85);
-            painter->setBrush(Qt::NoBrush);
+            p->setBrush(Qt::NoBrush);
 
             // Gradient fill
             QLinearGradient gradient(rect.topLeft(), rect.bottomLeft());
@@ -1088,14 +1089,14 @@ void CarlaStyle::drawPrimitive(PrimitiveElement elem,
                 gradient.setColorAt(1, baseColor);
             }
 
-            painter->setBrush((state & State_Sunken) ? QBrush(pressedColor) : gradient);
+            p->setBrush((state & State_Sunken) ? QBrush(pressedColor) : gradient);
 
             if (option->state & State_HasFocus && option->state & State_KeyboardFocusChange)
-                painter->setPen(QPen(highlightedOutline, 1));
+                p->setPen(QPen(highlightedOutline, 1));
             else
-                painter->setPen(QPen(outline.lighter(110), 1));
+                p->setPen(QPen(outline.lighter(110), 1));
 
-            painter->drawRect(rect);
+            p->drawRect(rect);
 
             QColor checkMarkColor = option->palette.text().color().darker(120);
 
@@ -1106,27 +1107,28 @@ void CarlaStyle::drawPrimitive(PrimitiveElement elem,
                 checkMarkColor.setAlpha(140);
                 gradient.setColorAt(1, checkMarkColor);
                 checkMarkColor.setAlpha(180);
-                painter->setPen(QPen(checkMarkColor, 1));
-                painter->setBrush(gradient);
-                painter->drawRect(rect.adjusted(3, 3, -3, -3));
+                p->setPen(QPen(checkMarkColor, 1));
+                p->setBrush(gradient);
+                p->drawRect(rect.adjusted(3, 3, -3, -3));
 
             } else if (checkbox->state & (State_On)) {
                 QPen checkPen = QPen(checkMarkColor, 1.8);
                 checkMarkColor.setAlpha(210);
-                painter->translate(-1, 0.5);
-                painter->setPen(checkPen);
-                painter->setBrush(Qt::NoBrush);
-                painter->translate(0.2, 0.0);
+                p->translate(-1, 0.5);
+                p->setPen(checkPen);
+                p->setBrush(Qt::NoBrush);
+                p->translate(0.2, 0.0);
 
                 // Draw checkmark
                 QPainterPath path;
                 path.moveTo(5, rect.height() / 2.0);
                 path.lineTo(rect.width() / 2.0 - 0, rect.height() - 3);
                 path.lineTo(rect.width() - 2.5, 3);
-                painter->drawPath(path.translated(rect.topLeft()));
+                p->drawPath(path.translated(rect.topLeft()));
             }
+            p->restore();
+            END_STYLE_PIXMAPCACHE
         }
-        painter->restore();
         break;
     case PE_IndicatorRadioButton:
         painter->save();
@@ -1646,29 +1648,36 @@ void CarlaStyle::drawControl(ControlElement element, const QStyleOption *option,
         painter->restore();
         break;
     case CE_ProgressBarGroove:
-        painter->save();
     {
-        painter->setRenderHint(QPainter::Antialiasing, true);
-        painter->translate(0.5, 0.5);
-
+        // drawn above the groove rect, so kept out of the cached pixmap
         QColor shadowAlpha = Qt::black;
         shadowAlpha.setAlpha(16);
+        painter->save();
+        painter->setRenderHint(QPainter::Antialiasing, true);
+        painter->translate(0.5, 0.5);
         painter->setPen(shadowAlpha);
         painter->drawLine(rect.topLeft() - QPoint(0, 1), rect.topRight() - QPoint(0, 1));
+        painter->restore();
 
-        painter->setBrush(Qt::NoBrush);
-        painter->setPen(QPen(outline, 1));
-        painter->drawRoundedRect(rect.adjusted(0, 0, -1, -1), 2.5, 2.5);
-        painter->setBrush(option->palette.base());
-        painter->setPen(QPen(option->palette.base(), 1));
-        painter->drawRoundedRect(rect.adjusted(1, 1, -2, -2), 1.8, 1.8);
+        BEGIN_STYLE_PIXMAPCACHE(QString::fromLatin1("progressbar_groove"))
+        p->save();
+        p->setRenderHint(QPainter::Antialiasing, true);
+        p->translate(0.5, 0.5);
+
+        p->setBrush(Qt::NoBrush);
+        p->setPen(QPen(outline, 1));
+        p->drawRoundedRect(rect.adjusted(0, 0, -1, -1), 2.5, 2.5);
+        p->setBrush(option->palette.base());
+        p->setPen(QPen(option->palette.base(), 1));
+        p->drawRoundedRect(rect.adjusted(1, 1, -2, -2), 1.8, 1.8);
 
         // Inner shadow
-        painter->setPen(d->topShadow());
-        painter->drawLine(QPoint(rect.left() + 1, rect.top() + 1),
-                          QPoint(rect.right() - 1, rect.top() + 1));
+        p->setPen(d->topShadow());
+        p->drawLine(QPoint(rect.left() + 1, rect.top() + 1),
+                    QPoint(rect.right() - 1, rect.top() + 1));
+        p->restore();
+        END_STYLE_PIXMAPCACHE
     }
-        painter->restore();
         break;
     case CE_ProgressBarContents:
         painter->save();
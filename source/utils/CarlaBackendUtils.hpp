@@ -319,6 +319,12 @@ const char* EngineCallbackOpcode2Str(const EngineCallbackOpcode opcode) noexcept
         return "ENGINE_CALLBACK_PATCHBAY_CLIENT_POSITION_CHANGED";
     case ENGINE_CALLBACK_EMBED_UI_RESIZED:
         return "ENGINE_CALLBACK_EMBED_UI_RESIZED";
+    case ENGINE_CALLBACK_PATCHBAY_BATCH:
+        return "ENGINE_CALLBACK_PATCHBAY_BATCH";
+    case ENGINE_CALLBACK_PARAMETER_VALUES_CHANGED:
+        return "ENGINE_CALLBACK_PARAMETER_VALUES_CHANGED";
+    case ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS:
+        return "ENGINE_CALLBACK_PLUGIN_LOAD_PROGRESS";
     }
 
     carla_stderr("CarlaBackend::EngineCallbackOpcode2Str(%i) - invalid opcode", opcode);
@@ -402,6 +408,60 @@ const char* EngineOption2Str(const EngineOption option) noexcept
         return "ENGINE_OPTION_DEBUG_CONSOLE_OUTPUT";
     case ENGINE_OPTION_CLIENT_NAME_PREFIX:
         return "ENGINE_OPTION_CLIENT_NAME_PREFIX";
+    case ENGINE_OPTION_PROCESSING_THREADS:
+        return "ENGINE_OPTION_PROCESSING_THREADS";
+    case ENGINE_OPTION_PIPELINED_BRIDGES:
+        return "ENGINE_OPTION_PIPELINED_BRIDGES";
+    case ENGINE_OPTION_BRIDGE_SPIN_TIME:
+        return "ENGINE_OPTION_BRIDGE_SPIN_TIME";
+    case ENGINE_OPTION_SAVE_CHUNKS_AS_FILES:
+        return "ENGINE_OPTION_SAVE_CHUNKS_AS_FILES";
+    case ENGINE_OPTION_EVENT_SPLIT_GRANULARITY:
+        return "ENGINE_OPTION_EVENT_SPLIT_GRANULARITY";
+    case ENGINE_OPTION_PLUGIN_BRIDGE_POOL_SIZE:
+        return "ENGINE_OPTION_PLUGIN_BRIDGE_POOL_SIZE";
+    case ENGINE_OPTION_PLUGIN_BRIDGE_GROUP_SIZE:
+        return "ENGINE_OPTION_PLUGIN_BRIDGE_GROUP_SIZE";
+    case ENGINE_OPTION_LV2_LAZY_LOADING:
+        return "ENGINE_OPTION_LV2_LAZY_LOADING";
+    case ENGINE_OPTION_SFZ_PRELOAD_TIME:
+        return "ENGINE_OPTION_SFZ_PRELOAD_TIME";
+    case ENGINE_OPTION_SFZ_RENDER_THREADS:
+        return "ENGINE_OPTION_SFZ_RENDER_THREADS";
+    case ENGINE_OPTION_CV_CONTROL_PERIOD:
+        return "ENGINE_OPTION_CV_CONTROL_PERIOD";
+    case ENGINE_OPTION_EVENT_PORT_BUFFER_SIZE:
+        return "ENGINE_OPTION_EVENT_PORT_BUFFER_SIZE";
+    case ENGINE_OPTION_FLUSH_DENORMALS:
+        return "ENGINE_OPTION_FLUSH_DENORMALS";
+    case ENGINE_OPTION_ASYNC_CALLBACKS:
+        return "ENGINE_OPTION_ASYNC_CALLBACKS";
+    case ENGINE_OPTION_BRIDGE_RT_PRIO:
+        return "ENGINE_OPTION_BRIDGE_RT_PRIO";
+    case ENGINE_OPTION_BRIDGE_CPU_AFFINITY:
+        return "ENGINE_OPTION_BRIDGE_CPU_AFFINITY";
+    case ENGINE_OPTION_PROCESSING_CPU_AFFINITY:
+        return "ENGINE_OPTION_PROCESSING_CPU_AFFINITY";
+    case ENGINE_OPTION_DORMANT_INACTIVE_PLUGINS:
+        return "ENGINE_OPTION_DORMANT_INACTIVE_PLUGINS";
+    case ENGINE_OPTION_PATCHBAY_DECOUPLED_BUFFER_SIZE:
+        return "ENGINE_OPTION_PATCHBAY_DECOUPLED_BUFFER_SIZE";
+    case ENGINE_OPTION_REPLACE_PLUGIN_CROSSFADE:
+        return "ENGINE_OPTION_REPLACE_PLUGIN_CROSSFADE";
+    case ENGINE_OPTION_LOCK_MEMORY:
+        return "ENGINE_OPTION_LOCK_MEMORY";
+    case ENGINE_OPTION_COMPACT_PARAMETER_STATE:
+        return "ENGINE_OPTION_COMPACT_PARAMETER_STATE";
+    case ENGINE_OPTION_SHARE_UI_BRIDGES:
+        return "ENGINE_OPTION_SHARE_UI_BRIDGES";
+    case ENGINE_OPTION_INLINE_DISPLAY_MAX_RATE:
+        return "ENGINE_OPTION_INLINE_DISPLAY_MAX_RATE";
+    case ENGINE_OPTION_EVENT_SPLIT_MIN_FRAMES:
+        return "ENGINE_OPTION_EVENT_SPLIT_MIN_FRAMES";
+    case ENGINE_OPTION_AUDIO_SECONDARY_DEVICE:
+        return "ENGINE_OPTION_AUDIO_SECONDARY_DEVICE";
+    case ENGINE_OPTION_RACK_LANES:
+        return "ENGINE_OPTION_RACK_LANES";
     }
 
     carla_stderr("CarlaBackend::EngineOption2Str(%i) - invalid option", option);
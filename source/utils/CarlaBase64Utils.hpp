@@ -1,7 +1,7 @@
 /*
  * Carla base64 utils, based on http://www.adp-gmbh.ch/cpp/common/base64.html
  * Copyright (C) 2004-2008 René Nyffenegger
- * Copyright (C) 2014 Filipe Coelho <falktx@falktx.com>
+ * Copyright (C) 2014-2020 Filipe Coelho <falktx@falktx.com>
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License as
@@ -21,9 +21,14 @@
 
 #include "CarlaUtils.hpp"
 
-#include <cctype>
 #include <vector>
 
+#if (defined(__i386__) || defined(__x86_64__)) && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+// SSSE3 code is built regardless of compiler flags and only used if the running CPU supports it
+# define CARLA_BASE64_SSSE3
+# include <tmmintrin.h>
+#endif
+
 // -----------------------------------------------------------------------
 // Helpers
 
@@ -34,87 +39,269 @@ static const char* const kBase64Chars =
     "abcdefghijklmnopqrstuvwxyz"
     "0123456789+/";
 
-static inline
-uint8_t findBase64CharIndex(const char c)
-{
-    static const uint8_t kBase64CharsLen(static_cast<uint8_t>(std::strlen(kBase64Chars)));
+// character to value lookup, for the scalar decoder
+struct DecodeTable {
+    enum {
+        kSkip    = 0xfe,
+        kInvalid = 0xff
+    };
 
-    for (uint8_t i=0; i<kBase64CharsLen; ++i)
+    uint8_t values[256];
+
+    DecodeTable() noexcept
     {
-        if (kBase64Chars[i] == c)
-            return i;
+        std::memset(values, kInvalid, sizeof(values));
+
+        for (uint8_t i=0; i<64; ++i)
+            values[static_cast<uint8_t>(kBase64Chars[i])] = i;
+
+        values[static_cast<uint8_t>(' ')]  = kSkip;
+        values[static_cast<uint8_t>('\n')] = kSkip;
     }
+};
+
+static inline
+const uint8_t* getDecodeTable() noexcept
+{
+    static const DecodeTable table;
+    return table.values;
+}
+
+#ifdef CARLA_BASE64_SSSE3
+/*
+ * Check if the running CPU supports SSSE3, the result is cached.
+ */
+static inline
+bool cpuHasSSSE3() noexcept
+{
+    static const bool hasSSSE3 = (__builtin_cpu_init(), __builtin_cpu_supports("ssse3") != 0);
+    return hasSSSE3;
+}
+
+/*
+ * Encode 12 bytes into 16 characters, reading 16 bytes from 'src'.
+ * Based on the pshufb method by Wojciech Muła.
+ */
+__attribute__((target("ssse3")))
+static inline
+void encodeBlockSSSE3(char* const dst, const uint8_t* const src) noexcept
+{
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+    // split each 3 bytes into 4 values of 6 bits, one per byte
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    const __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    const __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+    const __m128i indices = _mm_or_si128(t0, t1);
 
-    carla_stderr2("findBase64CharIndex('%c') - failed", c);
-    return 0;
+    // turn values into characters by adding an offset that depends on the range
+    const __m128i offsetLUT = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                            '/' - 63, 'A', 0, 0);
+
+    __m128i offsets = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    offsets = _mm_or_si128(offsets, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+    offsets = _mm_shuffle_epi8(offsetLUT, offsets);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_add_epi8(indices, offsets));
 }
 
+/*
+ * Decode 16 characters into 12 bytes, writing 16 bytes to 'dst'.
+ * Returns false without decoding if any character is not part of the base64 alphabet.
+ * Based on the method by Wojciech Muła and Alfred Klomp.
+ */
+__attribute__((target("ssse3")))
 static inline
-bool isBase64Char(const char c)
+bool decodeBlockSSSE3(uint8_t* const dst, const char* const src) noexcept
 {
-    return (std::isalnum(c) || (c == '+') || (c == '/'));
+    const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                          0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2f);
+
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+    const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask2F);
+    const __m128i loNibbles = _mm_and_si128(in, mask2F);
+    const __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+    const __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0)
+        return false;
+
+    // characters into values
+    const __m128i eq2F = _mm_cmpeq_epi8(in, mask2F);
+    in = _mm_add_epi8(in, _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles)));
+
+    // pack 4 values of 6 bits into 3 bytes
+    const __m128i merged = _mm_madd_epi16(_mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+    const __m128i out = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), out);
+    return true;
 }
+#endif
 
 } // namespace CarlaBase64Helpers
 
 // -----------------------------------------------------------------------
 
+/*
+ * Size of the base64 encoding of 'size' bytes, including padding and excluding the null terminator.
+ */
 static inline
-void carla_getChunkFromBase64String_impl(std::vector<uint8_t>& vector, const char* const base64string)
+std::size_t carla_base64EncodedSize(const std::size_t size) noexcept
 {
-    CARLA_SAFE_ASSERT_RETURN(base64string != nullptr,);
+    return (size + 2) / 3 * 4;
+}
 
-    uint i=0, j=0;
-    uint charArray3[3], charArray4[4];
+/*
+ * Encode 'size' bytes from 'src' into 'dst', which must hold carla_base64EncodedSize(size) characters.
+ * No null terminator is written.
+ */
+static inline
+void carla_base64Encode(char* const dst, const void* const src, const std::size_t size) noexcept
+{
+    using CarlaBase64Helpers::kBase64Chars;
 
-    vector.clear();
-    vector.reserve(std::strlen(base64string)*3/4 + 4);
+    const uint8_t* const bytes = static_cast<const uint8_t*>(src);
+    std::size_t s = 0, d = 0;
 
-    for (std::size_t l=0, len=std::strlen(base64string); l<len; ++l)
+#ifdef CARLA_BASE64_SSSE3
+    if (CarlaBase64Helpers::cpuHasSSSE3())
     {
-        const char c = base64string[l];
+        for (; s + 16 <= size; s += 12, d += 16)
+            CarlaBase64Helpers::encodeBlockSSSE3(dst + d, bytes + s);
+    }
+#endif
 
-        if (c == '\0' || c == '=')
-            break;
-        if (c == ' ' || c == '\n')
-            continue;
+    for (; s + 3 <= size; s += 3)
+    {
+        const uint32_t bits = static_cast<uint32_t>(bytes[s] << 16 | bytes[s+1] << 8 | bytes[s+2]);
+
+        dst[d++] = kBase64Chars[(bits >> 18) & 0x3f];
+        dst[d++] = kBase64Chars[(bits >> 12) & 0x3f];
+        dst[d++] = kBase64Chars[(bits >> 6) & 0x3f];
+        dst[d++] = kBase64Chars[bits & 0x3f];
+    }
 
-         CARLA_SAFE_ASSERT_CONTINUE(CarlaBase64Helpers::isBase64Char(c));
+    if (s < size)
+    {
+        const uint32_t bits = static_cast<uint32_t>(bytes[s] << 16 | (s + 1 < size ? bytes[s+1] << 8 : 0));
+
+        dst[d++] = kBase64Chars[(bits >> 18) & 0x3f];
+        dst[d++] = kBase64Chars[(bits >> 12) & 0x3f];
+        dst[d++] = s + 1 < size ? kBase64Chars[(bits >> 6) & 0x3f] : '=';
+        dst[d++] = '=';
+    }
+}
 
-        charArray4[i++] = static_cast<uint>(c);
+/*
+ * Space needed to decode 'len' base64 characters with carla_base64Decode().
+ * This is a bit more than the decoded size, as the decoder writes full blocks.
+ */
+static inline
+std::size_t carla_base64DecodedMaxSize(const std::size_t len) noexcept
+{
+    return len*3/4 + 4;
+}
 
-        if (i == 4)
+/*
+ * Decode up to 'len' base64 characters from 'src' into 'dst', which must hold carla_base64DecodedMaxSize(len) bytes.
+ * Stops at the first null or padding character, spaces and newlines are skipped.
+ * Returns the number of decoded bytes.
+ */
+static inline
+std::size_t carla_base64Decode(uint8_t* const dst, const char* const src, const std::size_t len) noexcept
+{
+    const uint8_t* const table = CarlaBase64Helpers::getDecodeTable();
+#ifdef CARLA_BASE64_SSSE3
+    const bool useSSSE3 = CarlaBase64Helpers::cpuHasSSSE3();
+#endif
+
+    std::size_t s = 0, d = 0;
+    uint32_t bits = 0;
+    uint numChars = 0;
+
+    while (s < len)
+    {
+#ifdef CARLA_BASE64_SSSE3
+        // blocks with whitespace or padding go through the code below
+        if (useSSSE3 && numChars == 0)
         {
-            for (i=0; i<4; ++i)
-                charArray4[i] = CarlaBase64Helpers::findBase64CharIndex(static_cast<char>(charArray4[i]));
+            while (s + 16 <= len && CarlaBase64Helpers::decodeBlockSSSE3(dst + d, src + s))
+            {
+                s += 16;
+                d += 12;
+            }
+
+            if (s >= len)
+                break;
+        }
+#endif
+
+        const char c = src[s++];
+
+        if (c == '\0' || c == '=')
+            break;
+
+        const uint8_t value = table[static_cast<uint8_t>(c)];
 
-            charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
-            charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-            charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+        if (value >= 64)
+        {
+            if (value != CarlaBase64Helpers::DecodeTable::kSkip)
+                carla_safe_assert("isBase64Char(c)", __FILE__, __LINE__);
+            continue;
+        }
 
-            for (i=0; i<3; ++i)
-                vector.push_back(static_cast<uint8_t>(charArray3[i]));
+        bits = bits << 6 | value;
 
-            i = 0;
+        if (++numChars == 4)
+        {
+            dst[d++] = static_cast<uint8_t>(bits >> 16);
+            dst[d++] = static_cast<uint8_t>(bits >> 8);
+            dst[d++] = static_cast<uint8_t>(bits);
+            bits = 0;
+            numChars = 0;
         }
     }
 
-    if (i != 0)
+    // incomplete last block, as if padded with zeros
+    if (numChars > 1)
     {
-        for (j=0; j<i && j<4; ++j)
-            charArray4[j] = CarlaBase64Helpers::findBase64CharIndex(static_cast<char>(charArray4[j]));
-
-        for (j=i; j<4; ++j)
-            charArray4[j] = 0;
+        bits <<= 6 * (4 - numChars);
 
-        charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
-        charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-        charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+        dst[d++] = static_cast<uint8_t>(bits >> 16);
 
-        for (j=0; i>0 && j<i-1; j++)
-            vector.push_back(static_cast<uint8_t>(charArray3[j]));
+        if (numChars == 3)
+            dst[d++] = static_cast<uint8_t>(bits >> 8);
     }
 
+    return d;
+}
+
+// -----------------------------------------------------------------------
+
+static inline
+void carla_getChunkFromBase64String_impl(std::vector<uint8_t>& vector, const char* const base64string, const std::size_t len)
+{
+    CARLA_SAFE_ASSERT_RETURN(base64string != nullptr,);
+
+    vector.resize(carla_base64DecodedMaxSize(len));
+    vector.resize(carla_base64Decode(vector.data(), base64string, len));
+}
+
+static inline
+void carla_getChunkFromBase64String_impl(std::vector<uint8_t>& vector, const char* const base64string)
+{
+    CARLA_SAFE_ASSERT_RETURN(base64string != nullptr,);
+
+    carla_getChunkFromBase64String_impl(vector, base64string, std::strlen(base64string));
 }
 
 static inline
@@ -20,11 +20,20 @@
 
 #include "CarlaDefines.h"
 
+#ifdef CARLA_PROPER_CPP11_SUPPORT
+# include <cstdint>
+#else
+# include <stdint.h>
+#endif
+
 // how much backwards compatible we are
-#define CARLA_PLUGIN_BRIDGE_API_VERSION_MINIMUM 6
+// the shared ring buffer layout changed in 14 (separate cache lines for indices), older peers cannot read it
+// chunk pools got an ownership flag and one pool per direction in 16, older peers would write over each other
+// nothing older than this is supported, so neither side checks for opcodes added before it
+#define CARLA_PLUGIN_BRIDGE_API_VERSION_MINIMUM 16
 
 // current API version, bumped when something is added
-#define CARLA_PLUGIN_BRIDGE_API_VERSION_CURRENT 7
+#define CARLA_PLUGIN_BRIDGE_API_VERSION_CURRENT 16
 
 // -------------------------------------------------------------------------------------------------------------------
 
@@ -40,9 +49,11 @@ enum PluginBridgeRtClientOpcode {
     kPluginBridgeRtClientControlEventMidiProgram, // uint/frame, byte/chan, ushort
     kPluginBridgeRtClientControlEventAllSoundOff, // uint/frame, byte/chan
     kPluginBridgeRtClientControlEventAllNotesOff, // uint/frame, byte/chan
-    kPluginBridgeRtClientMidiEvent,               // uint/frame, byte/port, byte/size, byte[]/data
+    kPluginBridgeRtClientMidiEvent,               // uint/frame, byte/port, byte/size, byte[]/data (JACK clients only)
     kPluginBridgeRtClientProcess,                 // uint/frames
-    kPluginBridgeRtClientQuit
+    kPluginBridgeRtClientQuit,
+    // stuff added in API 12
+    kPluginBridgeRtClientSetMidiBlockSize         // uint (always used by plugin bridges, JACK clients keep using midiOut)
 };
 
 // Server sends these to client during non-RT
@@ -77,6 +88,18 @@ enum PluginBridgeNonRtClientOpcode {
     // stuff added in API 7
     kPluginBridgeNonRtClientSetParameterMappedRange,        // uint, float, float
     kPluginBridgeNonRtClientSetOptions,                     // uint
+    // stuff added in API 8
+    kPluginBridgeNonRtClientSetChunkDataShm,                // uint/size, str[] (shm suffix), ulong/poolSize, ulong/dataSize (0 for none)
+    // stuff added in API 10
+    kPluginBridgeNonRtClientLoadPlugin,                     // uint/type, uint/size, str[] (filename), uint/size, str[] (label), long/uniqueId
+    // stuff added in API 11
+    kPluginBridgeNonRtClientAddGroupMember,                 // uint/size, str[] (shm ids)
+    // stuff added in API 13
+    kPluginBridgeNonRtClientSetThreadPolicy,                // int/rtPrio, uint/size, str[] (cpu list)
+    // stuff added in API 15
+    kPluginBridgeNonRtClientGetParameterNames,              // uint/first, uint/count
+    // stuff added in API 16
+    kPluginBridgeNonRtClientSetSaveChunkDataShm,            // uint/size, str[] (shm suffix), ulong/poolSize
 };
 
 // Client sends these to server during non-RT
@@ -112,7 +135,15 @@ enum PluginBridgeNonRtServerOpcode {
     kPluginBridgeNonRtServerUiClosed,
     kPluginBridgeNonRtServerError,              // uint/size, str[]
     // stuff added in API 7
-    kPluginBridgeNonRtServerVersion             // uint
+    kPluginBridgeNonRtServerVersion,            // uint
+    // stuff added in API 8
+    kPluginBridgeNonRtServerSetChunkDataShm,    // ulong/dataSize (content in save chunk pool)
+    kPluginBridgeNonRtServerResizeChunkDataShm, // ulong/dataSize (of save chunk pool)
+    // stuff added in API 9
+    kPluginBridgeNonRtServerParameterInfo,      // uint/count, then for each: uint/index, ParameterData1, ParameterData2, ParameterRanges and ParameterValue2 data without their index
+    // stuff added in API 15
+    kPluginBridgeNonRtServerParameterInfo2,     // same as ParameterInfo without the ParameterData2 strings, see kPluginBridgeNonRtClientGetParameterNames
+    kPluginBridgeNonRtServerParameterNames      // uint/count, then for each: uint/index, ParameterData2 data without its index
 };
 
 // used for kPluginBridgeNonRtServerPortName
@@ -144,6 +175,21 @@ struct BridgeSemaphore {
     };
 };
 
+// sem is posted by the reader of a non-RT ring once it has made room for a writer waiting on it,
+// readerSem by the writer once it has committed data for a reader waiting on it
+struct BridgeRingSemaphore {
+    union {
+        void* sem;
+        char _padSem[64];
+    };
+    union {
+        void* readerSem;
+        char _padReaderSem[64];
+    };
+    uint32_t writerWaiting;
+    uint32_t readerWaiting;
+};
+
 // NOTE: needs to be 64bit aligned
 struct BridgeTimeInfo {
     uint64_t playing;
@@ -16,18 +16,24 @@
  */
 
 #include "CarlaBridgeUtils.hpp"
+#include "CarlaMemoryLock.hpp"
 #include "CarlaShmUtils.hpp"
 
+#include <ctime>
+#include <sys/time.h>
+
 // must be last
 #include "jackbridge/JackBridge.hpp"
 
 #if defined(CARLA_OS_WIN) && defined(BUILDING_CARLA_FOR_WINDOWS)
 # define PLUGIN_BRIDGE_NAMEPREFIX_AUDIO_POOL    "Local\\carla-bridge_shm_ap_"
+# define PLUGIN_BRIDGE_NAMEPREFIX_CHUNK_POOL    "Local\\carla-bridge_shm_ck_"
 # define PLUGIN_BRIDGE_NAMEPREFIX_RT_CLIENT     "Local\\carla-bridge_shm_rtC_"
 # define PLUGIN_BRIDGE_NAMEPREFIX_NON_RT_CLIENT "Local\\carla-bridge_shm_nonrtC_"
 # define PLUGIN_BRIDGE_NAMEPREFIX_NON_RT_SERVER "Local\\carla-bridge_shm_nonrtS_"
 #else
 # define PLUGIN_BRIDGE_NAMEPREFIX_AUDIO_POOL    "/crlbrdg_shm_ap_"
+# define PLUGIN_BRIDGE_NAMEPREFIX_CHUNK_POOL    "/crlbrdg_shm_ck_"
 # define PLUGIN_BRIDGE_NAMEPREFIX_RT_CLIENT     "/crlbrdg_shm_rtC_"
 # define PLUGIN_BRIDGE_NAMEPREFIX_NON_RT_CLIENT "/crlbrdg_shm_nonrtC_"
 # define PLUGIN_BRIDGE_NAMEPREFIX_NON_RT_SERVER "/crlbrdg_shm_nonrtS_"
@@ -42,13 +48,112 @@ bool jackbridge_shm_map2(void* shm, T*& value) noexcept
     return (value != nullptr);
 }
 
+// Waits for the reader of a non-RT ring until 3/4 of it is free.
+// The reader posts the ring semaphore as soon as that happens, the timeout is only a fallback.
+template<class BufferStruct>
+static bool waitForRingSpace(CarlaRingBufferControl<BufferStruct>& ring, BridgeRingSemaphore& sem, const bool server) noexcept
+{
+    for (int timeouts=50; timeouts > 0;)
+    {
+        if (ring.getAvailableDataSize() >= BufferStruct::size*3/4)
+            break;
+
+        __sync_lock_test_and_set(&sem.writerWaiting, 1);
+
+        // the reader might have made room before seeing the flag
+        if (ring.getAvailableDataSize() >= BufferStruct::size*3/4)
+            break;
+
+        if (! jackbridge_sem_timedwait(&sem.sem, 20, server))
+            --timeouts;
+    }
+
+    __sync_lock_release(&sem.writerWaiting);
+    return ring.getAvailableDataSize() >= BufferStruct::size*3/4;
+}
+
+template<class BufferStruct>
+static void wakeUpRingWriter(CarlaRingBufferControl<BufferStruct>& ring, BridgeRingSemaphore& sem, const bool server) noexcept
+{
+    if (sem.writerWaiting == 0)
+        return;
+    if (ring.getAvailableDataSize() < BufferStruct::size*3/4)
+        return;
+
+    if (__sync_bool_compare_and_swap(&sem.writerWaiting, 1, 0))
+        jackbridge_sem_post(&sem.sem, server);
+}
+
+// Waits for the writer of a non-RT ring to commit new data.
+// The writer posts the ring reader semaphore as soon as that happens, the timeout is only a fallback.
+template<class BufferStruct>
+static bool waitForRingData(CarlaRingBufferControl<BufferStruct>& ring, BridgeRingSemaphore& sem,
+                            const uint msecs, const bool server) noexcept
+{
+    if (ring.isDataAvailableForReading())
+        return true;
+
+    __sync_bool_compare_and_swap(&sem.readerWaiting, 0, 1);
+
+    // the writer might have committed data before seeing the flag
+    const bool woken = ! ring.isDataAvailableForReading() && jackbridge_sem_timedwait(&sem.readerSem, msecs, server);
+
+    // the writer cleared the flag without waking us up, consume its post so the semaphore stays usable
+    if (! woken && ! __sync_bool_compare_and_swap(&sem.readerWaiting, 1, 0))
+        jackbridge_sem_timedwait(&sem.readerSem, 1000, server);
+
+    return ring.isDataAvailableForReading();
+}
+
+static void wakeUpRingReader(BridgeRingSemaphore& sem, const bool server) noexcept
+{
+    if (__sync_bool_compare_and_swap(&sem.readerWaiting, 1, 0))
+        jackbridge_sem_post(&sem.readerSem, server);
+}
+
+// Posts the semaphore of a group leader, unless a wake-up is already pending.
+// The futex-based semaphores only count up to 1, so the leader must be posted at most once per wait.
+static void wakeUpGroupLeader(BridgeRtClientData* const leaderData, const bool server) noexcept
+{
+    if (__sync_bool_compare_and_swap(&leaderData->serverPending, 0, 1))
+        jackbridge_sem_post(&leaderData->sem.server, server);
+}
+
+// Moves a shm handle into another, leaving the source one invalid.
+static void moveShm(char* const dst, char* const src) noexcept
+{
+    std::memcpy(dst, src, 64);
+    carla_zeroChars(src, 64);
+    jackbridge_shm_init(src);
+}
+
+static int64_t getTimeInMicroseconds() noexcept
+{
+#if defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN)
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+
+    return (tv.tv_sec * 1000000) + tv.tv_usec;
+#else
+    struct timespec ts;
+# ifdef CLOCK_MONOTONIC_RAW
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+# else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+# endif
+
+    return (ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+#endif
+}
+
 // -------------------------------------------------------------------------------------------------------------------
 
 BridgeAudioPool::BridgeAudioPool() noexcept
     : data(nullptr),
       dataSize(0),
       filename(),
-      isServer(false)
+      isServer(false),
+      isLocked(false)
 {
     carla_zeroChars(shm, 64);
     jackbridge_shm_init(shm);
@@ -107,24 +212,54 @@ void BridgeAudioPool::clear() noexcept
     if (data != nullptr)
     {
         if (isServer)
+        {
+            if (isLocked)
+                CarlaMemoryLock::getInstance().unlock(data, dataSize);
             jackbridge_shm_unmap(shm, data);
+        }
         data = nullptr;
     }
 
     dataSize = 0;
+    isLocked = false;
     jackbridge_shm_close(shm);
     jackbridge_shm_init(shm);
 }
 
-void BridgeAudioPool::resize(const uint32_t bufferSize, const uint32_t audioPortCount, const uint32_t cvPortCount) noexcept
+void BridgeAudioPool::adopt(BridgeAudioPool& other) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(other.isServer,);
+
+    clear();
+
+    data     = other.data;
+    dataSize = other.dataSize;
+    filename = other.filename;
+    isServer = true;
+    isLocked = other.isLocked;
+    moveShm(shm, other.shm);
+
+    other.data     = nullptr;
+    other.dataSize = 0;
+    other.isLocked = false;
+    other.filename.clear();
+}
+
+void BridgeAudioPool::resize(const uint32_t bufferSize, const uint32_t audioPortCount, const uint32_t cvPortCount,
+                             const uint32_t midiBlockSize) noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(jackbridge_shm_is_valid(shm),);
     CARLA_SAFE_ASSERT_RETURN(isServer,);
 
     if (data != nullptr)
+    {
+        if (isLocked)
+            CarlaMemoryLock::getInstance().unlock(data, dataSize);
         jackbridge_shm_unmap(shm, data);
+        isLocked = false;
+    }
 
-    dataSize = (audioPortCount+cvPortCount)*bufferSize*sizeof(float);
+    dataSize = (audioPortCount+cvPortCount)*bufferSize*sizeof(float) + midiBlockSize*2;
 
     if (dataSize == 0)
         dataSize = sizeof(float);
@@ -133,6 +268,9 @@ void BridgeAudioPool::resize(const uint32_t bufferSize, const uint32_t audioPort
     CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
 
     std::memset(data, 0, dataSize);
+
+    // shared with the bridge audio thread, on every cycle
+    isLocked = CarlaMemoryLock::getInstance().lock(data, dataSize);
 }
 
 const char* BridgeAudioPool::getFilenameSuffix() const noexcept
@@ -147,10 +285,172 @@ const char* BridgeAudioPool::getFilenameSuffix() const noexcept
 
 // -------------------------------------------------------------------------------------------------------------------
 
+// chunks are usually big, grow in steps of 1MiB so that small changes do not remap every time
+static const std::size_t kBridgeChunkPoolGranularity = 1024*1024;
+
+// the ownership flag gets its own cache line in front of the data
+static const std::size_t kBridgeChunkPoolHeaderSize = 64;
+
+BridgeChunkPool::BridgeChunkPool() noexcept
+    : data(nullptr),
+      dataSize(0),
+      filename(),
+      isServer(false),
+      owned(nullptr)
+{
+    carla_zeroChars(shm, 64);
+    jackbridge_shm_init(shm);
+}
+
+BridgeChunkPool::~BridgeChunkPool() noexcept
+{
+    // should be cleared by now
+    CARLA_SAFE_ASSERT(data == nullptr);
+
+    clear();
+}
+
+bool BridgeChunkPool::initializeServer() noexcept
+{
+    char tmpFileBase[64];
+    std::sprintf(tmpFileBase, PLUGIN_BRIDGE_NAMEPREFIX_CHUNK_POOL "XXXXXX");
+
+    const carla_shm_t shm2 = carla_shm_create_temp(tmpFileBase);
+    CARLA_SAFE_ASSERT_RETURN(carla_is_shm_valid(shm2), false);
+
+    void* const shmptr = shm;
+    carla_shm_t& shm1  = *(carla_shm_t*)shmptr;
+    carla_copyStruct(shm1, shm2);
+
+    filename = tmpFileBase;
+    isServer = true;
+    return true;
+}
+
+bool BridgeChunkPool::attachClient(const char* const basename) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(basename != nullptr && basename[0] != '\0', false);
+
+    // must be invalid right now
+    CARLA_SAFE_ASSERT_RETURN(! jackbridge_shm_is_valid(shm), false);
+
+    filename  = PLUGIN_BRIDGE_NAMEPREFIX_CHUNK_POOL;
+    filename += basename;
+
+    jackbridge_shm_attach(shm, filename);
+
+    return jackbridge_shm_is_valid(shm);
+}
+
+void BridgeChunkPool::clear() noexcept
+{
+    filename.clear();
+
+    if (! jackbridge_shm_is_valid(shm))
+    {
+        CARLA_SAFE_ASSERT(data == nullptr);
+        return;
+    }
+
+    if (owned != nullptr)
+    {
+        jackbridge_shm_unmap(shm, owned);
+        owned = nullptr;
+        data  = nullptr;
+    }
+
+    dataSize = 0;
+    jackbridge_shm_close(shm);
+    jackbridge_shm_init(shm);
+}
+
+bool BridgeChunkPool::grow(const std::size_t size) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(jackbridge_shm_is_valid(shm), false);
+    CARLA_SAFE_ASSERT_RETURN(isServer, false);
+    CARLA_SAFE_ASSERT_RETURN(size > 0, false);
+
+    if (size <= dataSize)
+        return true;
+
+    if (owned != nullptr)
+        jackbridge_shm_unmap(shm, owned);
+
+    // growing keeps the file contents, including the ownership flag
+    dataSize = (size + kBridgeChunkPoolGranularity - 1) / kBridgeChunkPoolGranularity * kBridgeChunkPoolGranularity;
+    owned = (uint32_t*)jackbridge_shm_map(shm, kBridgeChunkPoolHeaderSize + dataSize);
+
+    if (owned == nullptr)
+    {
+        data = nullptr;
+        dataSize = 0;
+        return false;
+    }
+
+    data = reinterpret_cast<uint8_t*>(owned) + kBridgeChunkPoolHeaderSize;
+    return true;
+}
+
+bool BridgeChunkPool::map(const std::size_t size) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(jackbridge_shm_is_valid(shm), false);
+    CARLA_SAFE_ASSERT_RETURN(! isServer, false);
+    CARLA_SAFE_ASSERT_RETURN(size > 0, false);
+
+    if (owned != nullptr)
+    {
+        if (size == dataSize)
+            return true;
+
+        jackbridge_shm_unmap(shm, owned);
+    }
+
+    owned = (uint32_t*)jackbridge_shm_map(shm, kBridgeChunkPoolHeaderSize + size);
+
+    if (owned == nullptr)
+    {
+        data = nullptr;
+        dataSize = 0;
+        return false;
+    }
+
+    data = reinterpret_cast<uint8_t*>(owned) + kBridgeChunkPoolHeaderSize;
+    dataSize = size;
+    return true;
+}
+
+bool BridgeChunkPool::acquire() noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(owned != nullptr, false);
+
+    return __sync_bool_compare_and_swap(owned, 0, 1);
+}
+
+void BridgeChunkPool::release() noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(owned != nullptr,);
+
+    __sync_lock_release(owned);
+}
+
+const char* BridgeChunkPool::getFilenameSuffix() const noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(filename.isNotEmpty(), nullptr);
+
+    const std::size_t prefixLength(std::strlen(PLUGIN_BRIDGE_NAMEPREFIX_CHUNK_POOL));
+    CARLA_SAFE_ASSERT_RETURN(filename.length() > prefixLength, nullptr);
+
+    return filename.buffer() + prefixLength;
+}
+
+// -------------------------------------------------------------------------------------------------------------------
+
 BridgeRtClientControl::BridgeRtClientControl() noexcept
     : data(nullptr),
       filename(),
       needsSemDestroy(false),
+      lastClientSeq(0),
+      groupData(nullptr),
       isServer(false)
 {
     carla_zeroChars(shm, 64);
@@ -228,6 +528,7 @@ bool BridgeRtClientControl::attachClient(const char* const basename) noexcept
 void BridgeRtClientControl::clear() noexcept
 {
     filename.clear();
+    groupData = nullptr;
 
     if (needsSemDestroy)
     {
@@ -246,6 +547,29 @@ void BridgeRtClientControl::clear() noexcept
     jackbridge_shm_init(shm);
 }
 
+void BridgeRtClientControl::adopt(BridgeRtClientControl& other) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(other.isServer,);
+    CARLA_SAFE_ASSERT_RETURN(other.data != nullptr,);
+
+    clear();
+
+    data            = other.data;
+    filename        = other.filename;
+    needsSemDestroy = other.needsSemDestroy;
+    lastClientSeq   = other.lastClientSeq;
+    groupData       = other.groupData;
+    isServer        = true;
+    moveShm(shm, other.shm);
+    setRingBuffer(&data->ringBuffer, false);
+
+    other.data = nullptr;
+    other.filename.clear();
+    other.needsSemDestroy = false;
+    other.groupData = nullptr;
+    other.setRingBuffer(nullptr, false);
+}
+
 bool BridgeRtClientControl::mapData() noexcept
 {
     CARLA_SAFE_ASSERT(data == nullptr);
@@ -257,6 +581,7 @@ bool BridgeRtClientControl::mapData() noexcept
     {
         std::memset(data, 0, sizeof(BridgeRtClientData));
         setRingBuffer(&data->ringBuffer, true);
+        lastClientSeq = 0;
     }
     else
     {
@@ -282,15 +607,66 @@ void BridgeRtClientControl::unmapData() noexcept
     setRingBuffer(nullptr, false);
 }
 
-bool BridgeRtClientControl::waitForClient(const uint msecs) noexcept
+void BridgeRtClientControl::setGroup(BridgeRtClientData* const leaderData) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(isServer,);
+
+    groupData = leaderData;
+}
+
+bool BridgeRtClientControl::waitForClient(const uint msecs, const uint spinUsecs) noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(msecs > 0, false);
     CARLA_SAFE_ASSERT_RETURN(data != nullptr, false);
     CARLA_SAFE_ASSERT_RETURN(isServer, false);
 
-    jackbridge_sem_post(&data->sem.server, true);
+    startClient();
 
-    return jackbridge_sem_timedwait(&data->sem.client, msecs, true);
+    return waitForClientToFinish(msecs, spinUsecs);
+}
+
+void BridgeRtClientControl::startClient() noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(isServer,);
+
+    if (groupData == nullptr)
+    {
+        jackbridge_sem_post(&data->sem.server, true);
+        return;
+    }
+
+    // the group leader runs every bridge with a pending request each time it wakes up,
+    // so only wake it up if nobody else did already
+    __sync_bool_compare_and_swap(&data->serverPending, 0, 1);
+    wakeUpGroupLeader(groupData, true);
+}
+
+bool BridgeRtClientControl::waitForClientToFinish(const uint msecs, const uint spinUsecs) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(msecs > 0, false);
+    CARLA_SAFE_ASSERT_RETURN(data != nullptr, false);
+    CARLA_SAFE_ASSERT_RETURN(isServer, false);
+
+    // short blocks usually finish within a few microseconds, so poll the client sequence for a while
+    // before paying for a sleep and wake-up on the semaphore
+    if (spinUsecs != 0 && __sync_fetch_and_add(&data->clientSeq, 0) == lastClientSeq)
+    {
+        const int64_t timeout = getTimeInMicroseconds() + static_cast<int64_t>(spinUsecs);
+
+        while (__sync_fetch_and_add(&data->clientSeq, 0) == lastClientSeq)
+        {
+            if (getTimeInMicroseconds() >= timeout)
+                break;
+        }
+    }
+
+    // semaphore has been posted already if the client finished while spinning
+    if (! jackbridge_sem_timedwait(&data->sem.client, msecs, true))
+        return false;
+
+    ++lastClientSeq;
+    return true;
 }
 
 bool BridgeRtClientControl::writeOpcode(const PluginBridgeRtClientOpcode opcode) noexcept
@@ -305,14 +681,51 @@ PluginBridgeRtClientOpcode BridgeRtClientControl::readOpcode() noexcept
     return static_cast<PluginBridgeRtClientOpcode>(readUInt());
 }
 
+bool BridgeRtClientControl::waitForGroupRequest(const uint msecs) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(data != nullptr, false);
+    CARLA_SAFE_ASSERT_RETURN(! isServer, false);
+
+    if (! jackbridge_sem_timedwait(&data->sem.server, msecs, false))
+        return false;
+
+    // requests made from now on need a new wake-up
+    __sync_bool_compare_and_swap(&data->serverPending, 1, 0);
+    return true;
+}
+
+void BridgeRtClientControl::interruptGroupWait() noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(! isServer,);
+
+    wakeUpGroupLeader(data, false);
+}
+
 BridgeRtClientControl::WaitHelper::WaitHelper(BridgeRtClientControl& c) noexcept
     : data(c.data),
       ok(jackbridge_sem_timedwait(&data->sem.server, 5000, false)) {}
 
 BridgeRtClientControl::WaitHelper::~WaitHelper() noexcept
 {
-    if (ok)
-        jackbridge_sem_post(&data->sem.client, false);
+    if (! ok)
+        return;
+
+    __sync_add_and_fetch(&data->clientSeq, 1);
+    jackbridge_sem_post(&data->sem.client, false);
+}
+
+BridgeRtClientControl::GroupedWaitHelper::GroupedWaitHelper(BridgeRtClientControl& c) noexcept
+    : data(c.data),
+      ok(__sync_bool_compare_and_swap(&data->serverPending, 1, 0)) {}
+
+BridgeRtClientControl::GroupedWaitHelper::~GroupedWaitHelper() noexcept
+{
+    if (! ok)
+        return;
+
+    __sync_add_and_fetch(&data->clientSeq, 1);
+    jackbridge_sem_post(&data->sem.client, false);
 }
 
 // -------------------------------------------------------------------------------------------------------------------
@@ -321,6 +734,7 @@ BridgeNonRtClientControl::BridgeNonRtClientControl() noexcept
     : data(nullptr),
       filename(),
       mutex(),
+      needsSemDestroy(false),
       isServer(false)
 {
     carla_zeroChars(shm, 64);
@@ -358,6 +772,25 @@ bool BridgeNonRtClientControl::initializeServer() noexcept
     }
 
     CARLA_SAFE_ASSERT(data != nullptr);
+
+    if (! jackbridge_sem_init(&data->sem.sem))
+    {
+        unmapData();
+        jackbridge_shm_close(shm);
+        jackbridge_shm_init(shm);
+        return false;
+    }
+
+    if (! jackbridge_sem_init(&data->sem.readerSem))
+    {
+        jackbridge_sem_destroy(&data->sem.sem);
+        unmapData();
+        jackbridge_shm_close(shm);
+        jackbridge_shm_init(shm);
+        return false;
+    }
+
+    needsSemDestroy = true;
     return true;
 }
 
@@ -380,6 +813,13 @@ void BridgeNonRtClientControl::clear() noexcept
 {
     filename.clear();
 
+    if (needsSemDestroy)
+    {
+        jackbridge_sem_destroy(&data->sem.sem);
+        jackbridge_sem_destroy(&data->sem.readerSem);
+        needsSemDestroy = false;
+    }
+
     if (data != nullptr)
         unmapData();
 
@@ -395,6 +835,26 @@ void BridgeNonRtClientControl::clear() noexcept
     jackbridge_shm_init(shm);
 }
 
+void BridgeNonRtClientControl::adopt(BridgeNonRtClientControl& other) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(other.isServer,);
+    CARLA_SAFE_ASSERT_RETURN(other.data != nullptr,);
+
+    clear();
+
+    data            = other.data;
+    filename        = other.filename;
+    needsSemDestroy = other.needsSemDestroy;
+    isServer        = true;
+    moveShm(shm, other.shm);
+    setRingBuffer(&data->ringBuffer, false);
+
+    other.data = nullptr;
+    other.filename.clear();
+    other.needsSemDestroy = false;
+    other.setRingBuffer(nullptr, false);
+}
+
 bool BridgeNonRtClientControl::mapData() noexcept
 {
     CARLA_SAFE_ASSERT(data == nullptr);
@@ -402,6 +862,13 @@ bool BridgeNonRtClientControl::mapData() noexcept
     if (jackbridge_shm_map2<BridgeNonRtClientData>(shm, data))
     {
         setRingBuffer(&data->ringBuffer, isServer);
+
+        if (! isServer)
+        {
+            CARLA_SAFE_ASSERT_RETURN(jackbridge_sem_connect(&data->sem.sem), false);
+            CARLA_SAFE_ASSERT_RETURN(jackbridge_sem_connect(&data->sem.readerSem), false);
+        }
+
         return true;
     }
 
@@ -424,18 +891,14 @@ void BridgeNonRtClientControl::waitIfDataIsReachingLimit() noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(isServer,);
 
-    if (getAvailableDataSize() < BigStackBuffer::size/4)
+    if (getAvailableDataSize() >= BigStackBuffer::size/4)
         return;
 
-    for (int i=50; --i >= 0;)
+    if (waitForRingSpace(*this, data->sem, true))
     {
-        if (getAvailableDataSize() >= BigStackBuffer::size*3/4)
-        {
-            writeOpcode(kPluginBridgeNonRtClientPing);
-            commitWrite();
-            return;
-        }
-        carla_msleep(20);
+        writeOpcode(kPluginBridgeNonRtClientPing);
+        commitWrite();
+        return;
     }
 
     carla_stderr("Server waitIfDataIsReachingLimit() reached and failed");
@@ -448,11 +911,33 @@ bool BridgeNonRtClientControl::writeOpcode(const PluginBridgeNonRtClientOpcode o
     return writeUInt(static_cast<uint32_t>(opcode));
 }
 
+bool BridgeNonRtClientControl::commitWrite() noexcept
+{
+    if (! CarlaRingBufferControl<BigStackBuffer>::commitWrite())
+        return false;
+
+    if (data != nullptr)
+        wakeUpRingReader(data->sem, true);
+
+    return true;
+}
+
 PluginBridgeNonRtClientOpcode BridgeNonRtClientControl::readOpcode() noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(! isServer, kPluginBridgeNonRtClientNull);
 
-    return static_cast<PluginBridgeNonRtClientOpcode>(readUInt());
+    const uint32_t opcode = readUInt();
+    wakeUpRingWriter(*this, data->sem, false);
+
+    return static_cast<PluginBridgeNonRtClientOpcode>(opcode);
+}
+
+bool BridgeNonRtClientControl::waitForData(const uint msecs) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(! isServer, false);
+    CARLA_SAFE_ASSERT_RETURN(data != nullptr, false);
+
+    return waitForRingData(*this, data->sem, msecs, false);
 }
 
 // -------------------------------------------------------------------------------------------------------------------
@@ -461,6 +946,7 @@ BridgeNonRtServerControl::BridgeNonRtServerControl() noexcept
     : data(nullptr),
       filename(),
       mutex(),
+      needsSemDestroy(false),
       isServer(false)
 {
     carla_zeroChars(shm, 64);
@@ -498,6 +984,25 @@ bool BridgeNonRtServerControl::initializeServer() noexcept
     }
 
     CARLA_SAFE_ASSERT(data != nullptr);
+
+    if (! jackbridge_sem_init(&data->sem.sem))
+    {
+        unmapData();
+        jackbridge_shm_close(shm);
+        jackbridge_shm_init(shm);
+        return false;
+    }
+
+    if (! jackbridge_sem_init(&data->sem.readerSem))
+    {
+        jackbridge_sem_destroy(&data->sem.sem);
+        unmapData();
+        jackbridge_shm_close(shm);
+        jackbridge_shm_init(shm);
+        return false;
+    }
+
+    needsSemDestroy = true;
     return true;
 }
 
@@ -520,6 +1025,13 @@ void BridgeNonRtServerControl::clear() noexcept
 {
     filename.clear();
 
+    if (needsSemDestroy)
+    {
+        jackbridge_sem_destroy(&data->sem.sem);
+        jackbridge_sem_destroy(&data->sem.readerSem);
+        needsSemDestroy = false;
+    }
+
     if (data != nullptr)
         unmapData();
 
@@ -533,6 +1045,26 @@ void BridgeNonRtServerControl::clear() noexcept
     jackbridge_shm_init(shm);
 }
 
+void BridgeNonRtServerControl::adopt(BridgeNonRtServerControl& other) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(other.isServer,);
+    CARLA_SAFE_ASSERT_RETURN(other.data != nullptr,);
+
+    clear();
+
+    data            = other.data;
+    filename        = other.filename;
+    needsSemDestroy = other.needsSemDestroy;
+    isServer        = true;
+    moveShm(shm, other.shm);
+    setRingBuffer(&data->ringBuffer, false);
+
+    other.data = nullptr;
+    other.filename.clear();
+    other.needsSemDestroy = false;
+    other.setRingBuffer(nullptr, false);
+}
+
 bool BridgeNonRtServerControl::mapData() noexcept
 {
     CARLA_SAFE_ASSERT(data == nullptr);
@@ -540,6 +1072,13 @@ bool BridgeNonRtServerControl::mapData() noexcept
     if (jackbridge_shm_map2<BridgeNonRtServerData>(shm, data))
     {
         setRingBuffer(&data->ringBuffer, isServer);
+
+        if (! isServer)
+        {
+            CARLA_SAFE_ASSERT_RETURN(jackbridge_sem_connect(&data->sem.sem), false);
+            CARLA_SAFE_ASSERT_RETURN(jackbridge_sem_connect(&data->sem.readerSem), false);
+        }
+
         return true;
     }
 
@@ -562,25 +1101,32 @@ PluginBridgeNonRtServerOpcode BridgeNonRtServerControl::readOpcode() noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(isServer, kPluginBridgeNonRtServerNull);
 
-    return static_cast<PluginBridgeNonRtServerOpcode>(readUInt());
+    const uint32_t opcode = readUInt();
+    wakeUpRingWriter(*this, data->sem, true);
+
+    return static_cast<PluginBridgeNonRtServerOpcode>(opcode);
+}
+
+bool BridgeNonRtServerControl::waitForData(const uint msecs) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(isServer, false);
+    CARLA_SAFE_ASSERT_RETURN(data != nullptr, false);
+
+    return waitForRingData(*this, data->sem, msecs, true);
 }
 
 void BridgeNonRtServerControl::waitIfDataIsReachingLimit() noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(! isServer,);
 
-    if (getAvailableDataSize() < HugeStackBuffer::size/4)
+    if (getAvailableDataSize() >= HugeStackBuffer::size/4)
         return;
 
-    for (int i=50; --i >= 0;)
+    if (waitForRingSpace(*this, data->sem, false))
     {
-        if (getAvailableDataSize() >= HugeStackBuffer::size*3/4)
-        {
-            writeOpcode(kPluginBridgeNonRtServerPong);
-            commitWrite();
-            return;
-        }
-        carla_msleep(20);
+        writeOpcode(kPluginBridgeNonRtServerPong);
+        commitWrite();
+        return;
     }
 
     carla_stderr("Client waitIfDataIsReachingLimit() reached and failed");
@@ -593,4 +1139,15 @@ bool BridgeNonRtServerControl::writeOpcode(const PluginBridgeNonRtServerOpcode o
     return writeUInt(static_cast<uint32_t>(opcode));
 }
 
+bool BridgeNonRtServerControl::commitWrite() noexcept
+{
+    if (! CarlaRingBufferControl<HugeStackBuffer>::commitWrite())
+        return false;
+
+    if (data != nullptr)
+        wakeUpRingReader(data->sem, false);
+
+    return true;
+}
+
 // -------------------------------------------------------------------------------------------------------------------
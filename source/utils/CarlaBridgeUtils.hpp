@@ -56,6 +56,8 @@ const char* PluginBridgeRtClientOpcode2str(const PluginBridgeRtClientOpcode opco
         return "kPluginBridgeRtClientProcess";
     case kPluginBridgeRtClientQuit:
         return "kPluginBridgeRtClientQuit";
+    case kPluginBridgeRtClientSetMidiBlockSize:
+        return "kPluginBridgeRtClientSetMidiBlockSize";
     }
 
     carla_stderr("CarlaBackend::PluginBridgeRtClientOpcode2str(%i) - invalid opcode", opcode);
@@ -125,6 +127,18 @@ const char* PluginBridgeNonRtClientOpcode2str(const PluginBridgeNonRtClientOpcod
         return "kPluginBridgeNonRtClientSetParameterMappedRange";
     case kPluginBridgeNonRtClientSetOptions:
         return "kPluginBridgeNonRtClientSetOptions";
+    case kPluginBridgeNonRtClientSetChunkDataShm:
+        return "kPluginBridgeNonRtClientSetChunkDataShm";
+    case kPluginBridgeNonRtClientLoadPlugin:
+        return "kPluginBridgeNonRtClientLoadPlugin";
+    case kPluginBridgeNonRtClientAddGroupMember:
+        return "kPluginBridgeNonRtClientAddGroupMember";
+    case kPluginBridgeNonRtClientSetThreadPolicy:
+        return "kPluginBridgeNonRtClientSetThreadPolicy";
+    case kPluginBridgeNonRtClientGetParameterNames:
+        return "kPluginBridgeNonRtClientGetParameterNames";
+    case kPluginBridgeNonRtClientSetSaveChunkDataShm:
+        return "kPluginBridgeNonRtClientSetSaveChunkDataShm";
     }
 
     carla_stderr("CarlaBackend::PluginBridgeNonRtClientOpcode2str(%i) - invalid opcode", opcode);
@@ -198,6 +212,16 @@ const char* PluginBridgeNonRtServerOpcode2str(const PluginBridgeNonRtServerOpcod
         return "kPluginBridgeNonRtServerError";
     case kPluginBridgeNonRtServerVersion:
         return "kPluginBridgeNonRtServerVersion";
+    case kPluginBridgeNonRtServerSetChunkDataShm:
+        return "kPluginBridgeNonRtServerSetChunkDataShm";
+    case kPluginBridgeNonRtServerResizeChunkDataShm:
+        return "kPluginBridgeNonRtServerResizeChunkDataShm";
+    case kPluginBridgeNonRtServerParameterInfo:
+        return "kPluginBridgeNonRtServerParameterInfo";
+    case kPluginBridgeNonRtServerParameterInfo2:
+        return "kPluginBridgeNonRtServerParameterInfo2";
+    case kPluginBridgeNonRtServerParameterNames:
+        return "kPluginBridgeNonRtServerParameterNames";
     }
 
     carla_stderr("CarlaBackend::PluginBridgeNonRtServerOpcode2str%i) - invalid opcode", opcode);
@@ -209,6 +233,40 @@ const char* PluginBridgeNonRtServerOpcode2str(const PluginBridgeNonRtServerOpcod
 static const std::size_t kBridgeRtClientDataMidiOutSize = 511*4;
 static const std::size_t kBridgeBaseMidiOutHeaderSize   = 6U /* time, port and size */;
 
+// MIDI event blocks, used instead of kPluginBridgeRtClientMidiEvent and midiOut since API 12.
+// There is one block per direction right after the audio and CV buffers of the audio pool, server => client first.
+// Each block starts with this header, followed by 'size' bytes of events packed in the same format as midiOut.
+// The writer fills the whole block before the reader is woken up, so it is transferred with a single copy.
+struct BridgeMidiBlockHeader {
+    uint32_t count;
+    uint32_t size;
+};
+
+// space reserved per event when sizing a block, enough for all channel messages
+static const std::size_t kBridgeMidiBlockBytesPerEvent = 12;
+
+// appends an event to a MIDI block of 'blockSize' bytes, returns a pointer to the written data or null if full
+static inline
+uint8_t* writeBridgeMidiBlockEvent(uint8_t* const block, const std::size_t blockSize, const uint32_t time,
+                                   const uint8_t port, const uint8_t size, const uint8_t* const data) noexcept
+{
+    BridgeMidiBlockHeader* const header = (BridgeMidiBlockHeader*)block;
+    const std::size_t offset = sizeof(BridgeMidiBlockHeader) + header->size;
+
+    if (offset + kBridgeBaseMidiOutHeaderSize + size > blockSize)
+        return nullptr;
+
+    uint8_t* const eventData = block + offset;
+    std::memcpy(eventData, &time, sizeof(uint32_t));
+    eventData[4] = port;
+    eventData[5] = size;
+    std::memcpy(eventData + kBridgeBaseMidiOutHeaderSize, data, size);
+
+    ++header->count;
+    header->size += static_cast<uint32_t>(kBridgeBaseMidiOutHeaderSize + size);
+    return eventData + kBridgeBaseMidiOutHeaderSize;
+}
+
 // Server => Client RT
 struct BridgeRtClientData {
     BridgeSemaphore sem;
@@ -216,16 +274,20 @@ struct BridgeRtClientData {
     SmallStackBuffer ringBuffer;
     uint8_t midiOut[kBridgeRtClientDataMidiOutSize];
     uint32_t procFlags;
+    uint32_t clientSeq; // bumped by the client before posting sem.client
+    uint32_t serverPending; // set by the server before waking up a grouped bridge
 };
 
 // Server => Client Non-RT
 struct BridgeNonRtClientData {
     BigStackBuffer ringBuffer;
+    BridgeRingSemaphore sem;
 };
 
 // Client => Server Non-RT
 struct BridgeNonRtServerData {
     HugeStackBuffer ringBuffer;
+    BridgeRingSemaphore sem;
 };
 
 // -------------------------------------------------------------------------------------------------------------------
@@ -236,6 +298,7 @@ struct BridgeAudioPool {
     CarlaString filename;
     char shm[64];
     bool isServer;
+    bool isLocked; // server only, see CarlaMemoryLock
 
     BridgeAudioPool() noexcept;
     ~BridgeAudioPool() noexcept;
@@ -244,7 +307,12 @@ struct BridgeAudioPool {
     bool attachClient(const char* const fname) noexcept;
     void clear() noexcept;
 
-    void resize(const uint32_t bufferSize, const uint32_t audioPortCount, const uint32_t cvPortCount) noexcept;
+    // takes over the shm of another server, leaving it empty
+    void adopt(BridgeAudioPool& other) noexcept;
+
+    // 'midiBlockSize' reserves space for 2 MIDI blocks after the audio and CV buffers, see BridgeMidiBlockHeader
+    void resize(const uint32_t bufferSize, const uint32_t audioPortCount, const uint32_t cvPortCount,
+                const uint32_t midiBlockSize = 0) noexcept;
 
     const char* getFilenameSuffix() const noexcept;
 
@@ -253,10 +321,52 @@ struct BridgeAudioPool {
 
 // -------------------------------------------------------------------------------------------------------------------
 
+// Raw plugin chunk data, one pool per direction (host to bridge for setChunkData, bridge to host for saves).
+// The server owns the size, the client asks it to grow when a chunk does not fit.
+// A flag before the data tells who owns the pool, the writer acquires it and the reader releases it once the chunk
+// was consumed, so a chunk is never overwritten while the other side is still reading it.
+struct BridgeChunkPool {
+    uint8_t* data;        // after the ownership flag
+    std::size_t dataSize; // usable size, not counting the ownership flag
+    CarlaString filename;
+    char shm[64];
+    bool isServer;
+
+    BridgeChunkPool() noexcept;
+    ~BridgeChunkPool() noexcept;
+
+    bool initializeServer() noexcept;
+    bool attachClient(const char* const basename) noexcept;
+    void clear() noexcept;
+
+    // non-bridge, server
+    bool grow(const std::size_t size) noexcept;
+
+    // bridge, client
+    bool map(const std::size_t size) noexcept;
+
+    // writer side, fails while the reader still owns the previous chunk
+    bool acquire() noexcept;
+
+    // reader side, after the chunk was consumed
+    void release() noexcept;
+
+    const char* getFilenameSuffix() const noexcept;
+
+private:
+    uint32_t* owned;
+
+    CARLA_DECLARE_NON_COPY_STRUCT(BridgeChunkPool)
+};
+
+// -------------------------------------------------------------------------------------------------------------------
+
 struct BridgeRtClientControl : public CarlaRingBufferControl<SmallStackBuffer> {
     BridgeRtClientData* data;
     CarlaString filename;
     bool needsSemDestroy; // client only
+    uint32_t lastClientSeq; // server only
+    BridgeRtClientData* groupData; // server only, see setGroup()
     char shm[64];
     bool isServer;
 
@@ -271,12 +381,22 @@ struct BridgeRtClientControl : public CarlaRingBufferControl<SmallStackBuffer> {
     void unmapData() noexcept;
 
     // non-bridge, server
-    bool waitForClient(const uint msecs) noexcept;
+    void adopt(BridgeRtClientControl& other) noexcept;
+    // wake up the client through the RT control of a group of bridges, null to wake it up directly
+    void setGroup(BridgeRtClientData* const leaderData) noexcept;
+    // 'spinUsecs' is how long to busy-wait for the client before sleeping on the semaphore
+    bool waitForClient(const uint msecs, const uint spinUsecs = 0) noexcept;
+    void startClient() noexcept;
+    bool waitForClientToFinish(const uint msecs, const uint spinUsecs = 0) noexcept;
     bool writeOpcode(const PluginBridgeRtClientOpcode opcode) noexcept;
 
     // bridge, client
     PluginBridgeRtClientOpcode readOpcode() noexcept;
 
+    // bridge, group leader
+    bool waitForGroupRequest(const uint msecs) noexcept;
+    void interruptGroupWait() noexcept;
+
     // helper class that automatically posts semaphore on destructor
     struct WaitHelper {
         BridgeRtClientData* const data;
@@ -288,6 +408,17 @@ struct BridgeRtClientControl : public CarlaRingBufferControl<SmallStackBuffer> {
         CARLA_DECLARE_NON_COPY_STRUCT(WaitHelper)
     };
 
+    // same as WaitHelper for bridges run by a group leader, does not block
+    struct GroupedWaitHelper {
+        BridgeRtClientData* const data;
+        const bool ok;
+
+        GroupedWaitHelper(BridgeRtClientControl& c) noexcept;
+        ~GroupedWaitHelper() noexcept;
+
+        CARLA_DECLARE_NON_COPY_STRUCT(GroupedWaitHelper)
+    };
+
     CARLA_DECLARE_NON_COPY_STRUCT(BridgeRtClientControl)
 };
 
@@ -297,6 +428,7 @@ struct BridgeNonRtClientControl : public CarlaRingBufferControl<BigStackBuffer>
     BridgeNonRtClientData* data;
     CarlaString filename;
     CarlaMutex mutex;
+    bool needsSemDestroy; // server only
     char shm[64];
     bool isServer;
 
@@ -311,11 +443,14 @@ struct BridgeNonRtClientControl : public CarlaRingBufferControl<BigStackBuffer>
     void unmapData() noexcept;
 
     // non-bridge, server
+    void adopt(BridgeNonRtClientControl& other) noexcept;
     void waitIfDataIsReachingLimit() noexcept;
     bool writeOpcode(const PluginBridgeNonRtClientOpcode opcode) noexcept;
+    bool commitWrite() noexcept;
 
     // bridge, client
     PluginBridgeNonRtClientOpcode readOpcode() noexcept;
+    bool waitForData(const uint msecs) noexcept;
 
     CARLA_DECLARE_NON_COPY_STRUCT(BridgeNonRtClientControl)
 };
@@ -326,6 +461,7 @@ struct BridgeNonRtServerControl : public CarlaRingBufferControl<HugeStackBuffer>
     BridgeNonRtServerData* data;
     CarlaString filename;
     CarlaMutex mutex;
+    bool needsSemDestroy; // server only
     char shm[64];
     bool isServer;
 
@@ -340,11 +476,14 @@ struct BridgeNonRtServerControl : public CarlaRingBufferControl<HugeStackBuffer>
     void unmapData() noexcept;
 
     // non-bridge, server
+    void adopt(BridgeNonRtServerControl& other) noexcept;
     PluginBridgeNonRtServerOpcode readOpcode() noexcept;
+    bool waitForData(const uint msecs) noexcept;
 
     // bridge, client
     void waitIfDataIsReachingLimit() noexcept;
     bool writeOpcode(const PluginBridgeNonRtServerOpcode opcode) noexcept;
+    bool commitWrite() noexcept;
 
     CARLA_DECLARE_NON_COPY_STRUCT(BridgeNonRtServerControl)
 };
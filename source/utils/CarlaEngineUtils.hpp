@@ -19,6 +19,8 @@
 #define CARLA_ENGINE_UTILS_HPP_INCLUDED
 
 #include "CarlaEngine.hpp"
+#include "CarlaMathUtils.hpp"
+#include "CarlaMemoryLock.hpp"
 #include "CarlaUtils.hpp"
 #include "CarlaMIDI.h"
 
@@ -52,6 +54,8 @@ const char* EngineType2Str(const EngineType type) noexcept
         return "kEngineTypeBridge";
     case kEngineTypeDummy:
         return "kEngineTypeDummy";
+    case kEngineTypeRender:
+        return "kEngineTypeRender";
     }
 
     carla_stderr("CarlaBackend::EngineType2Str(%i) - invalid type", type);
@@ -118,36 +122,236 @@ const char* EngineControlEventType2Str(const EngineControlEventType type) noexce
 }
 
 // -----------------------------------------------------------------------
+// Event buffer helpers
+// Buffers end at the first kEngineEventTypeNull event, anything after it is undefined.
+// Keeping them terminated (instead of zeroing all slots) makes their cost follow the actual event count.
 
 static inline
-void fillEngineEventsFromWaterMidiBuffer(EngineEvent engineEvents[kMaxEngineEventInternalCount], const water::MidiBuffer& midiBuffer)
+void clearEngineEvents(EngineEvent engineEvents[kMaxEngineEventInternalCount]) noexcept
 {
-    const uint8_t* midiData;
-    int numBytes, sampleNumber;
-    ushort engineEventIndex = 0;
+    engineEvents[0].type = kEngineEventTypeNull;
+}
+
+static inline
+uint32_t getEngineEventCount(const EngineEvent engineEvents[kMaxEngineEventInternalCount]) noexcept
+{
+    uint32_t i=0;
 
-    for (ushort i=0; i < kMaxEngineEventInternalCount; ++i)
+    for (; i < kMaxEngineEventInternalCount; ++i)
     {
-        const EngineEvent& engineEvent(engineEvents[i]);
+        if (engineEvents[i].type == kEngineEventTypeNull)
+            break;
+    }
 
-        if (engineEvent.type != kEngineEventTypeNull)
-            continue;
+    return i;
+}
+
+static inline
+void terminateEngineEvents(EngineEvent engineEvents[kMaxEngineEventInternalCount], const uint32_t count) noexcept
+{
+    if (count < kMaxEngineEventInternalCount)
+        engineEvents[count].type = kEngineEventTypeNull;
+}
+
+static inline
+uint32_t copyEngineEvents(EngineEvent dst[kMaxEngineEventInternalCount], const EngineEvent src[kMaxEngineEventInternalCount]) noexcept
+{
+    const uint32_t count = getEngineEventCount(src);
+
+    if (count != 0)
+        carla_copyStructs(dst, src, count);
+
+    terminateEngineEvents(dst, count);
+
+    return count;
+}
+
+/*
+ * Merge the events of 'src' into 'dst', keeping them sorted by time.
+ * Both buffers must already be sorted. Events from 'src' go after events from 'dst' with the same time.
+ * This is done in place from the back, so nothing is allocated and each event is moved at most once.
+ * If the result does not fit, the latest events are dropped.
+ */
+static inline
+uint32_t mergeEngineEvents(EngineEvent dst[kMaxEngineEventInternalCount], const EngineEvent src[kMaxEngineEventInternalCount]) noexcept
+{
+    const uint32_t dstCount = getEngineEventCount(dst);
+    const uint32_t srcCount = getEngineEventCount(src);
+    const uint32_t total    = dstCount + srcCount;
+
+    int32_t i = static_cast<int32_t>(dstCount) - 1;
+    int32_t j = static_cast<int32_t>(srcCount) - 1;
+    int32_t k = static_cast<int32_t>(total) - 1;
+
+    // once 'src' is used up, the remaining 'dst' events are already in place
+    for (; j >= 0; --k)
+    {
+        const EngineEvent& event(i >= 0 && dst[i].time > src[j].time ? dst[i--] : src[j--]);
+
+        if (k < static_cast<int32_t>(kMaxEngineEventInternalCount))
+            dst[k] = event;
+    }
+
+    const uint32_t count = total < kMaxEngineEventInternalCount ? total : kMaxEngineEventInternalCount;
+    terminateEngineEvents(dst, count);
+
+    return count;
+}
+
+// -----------------------------------------------------------------------
+// Event data arena
+// Holds the data of MIDI events too big for EngineMidiEvent::data (like SysEx), owned by an output event port.
+// Memory is preallocated and handed out linearly, then reset when the port buffer is initialized for a new cycle.
+// Pointers into it stay valid for the whole cycle, even after the events get copied into other buffers.
+
+struct EngineEventDataArena {
+    static const uint32_t kSize = 16384;
+
+    EngineEventDataArena() noexcept
+        : fUsed(0) {}
+
+    void reset() noexcept
+    {
+        fUsed = 0;
+    }
+
+    uint8_t* allocate(const uint32_t size) noexcept
+    {
+        if (size > kSize - fUsed)
+            return nullptr;
+
+        uint8_t* const ptr = fData + fUsed;
+        fUsed += size;
+        return ptr;
+    }
+
+private:
+    uint32_t fUsed;
+    uint8_t  fData[kSize];
+
+    CARLA_DECLARE_NON_COPY_STRUCT(EngineEventDataArena)
+};
 
-        engineEventIndex = i;
-        break;
+// -----------------------------------------------------------------------
+// Audio buffer arena
+// Hands out audio buffers from a single allocation, each one starting on its own 64-byte boundary.
+// SIMD code can rely on aligned loads, and buffers handed out one after the other are adjacent in memory.
+// Buffers stay valid until the next reset(), which is meant to be called when the buffer size changes.
+
+struct EngineAudioBufferArena {
+    static const uint32_t kAlignment = 64;
+
+    EngineAudioBufferArena() noexcept
+        : fMemory(nullptr),
+          fData(nullptr),
+          fStride(0),
+          fNumBuffers(0),
+          fUsed(0) {}
+
+    ~EngineAudioBufferArena() noexcept
+    {
+        CarlaMemoryLock::getInstance().deallocate(fMemory);
     }
 
-    for (water::MidiBuffer::Iterator midiBufferIterator(midiBuffer); midiBufferIterator.getNextEvent(midiData, numBytes, sampleNumber) && engineEventIndex < kMaxEngineEventInternalCount;)
+    /*
+     * Make room for 'numBuffers' buffers of 'bufferSize' frames, invalidating all previous ones.
+     * Passing 0 for either releases the memory.
+     */
+    bool reset(const uint32_t numBuffers, const uint32_t bufferSize) noexcept
+    {
+        CarlaMemoryLock& memoryLock(CarlaMemoryLock::getInstance());
+
+        memoryLock.deallocate(fMemory);
+        fMemory     = nullptr;
+        fData       = nullptr;
+        fStride     = 0;
+        fNumBuffers = 0;
+        fUsed       = 0;
+
+        if (numBuffers == 0 || bufferSize == 0)
+            return true;
+
+        // round each buffer up to whole cache lines, so the next one stays aligned
+        const uint32_t floatsPerLine = kAlignment / sizeof(float);
+        const std::size_t stride = (bufferSize + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+
+        fMemory = memoryLock.allocate(stride * numBuffers * sizeof(float) + kAlignment);
+        CARLA_SAFE_ASSERT_RETURN(fMemory != nullptr, false);
+
+        const uintptr_t address = reinterpret_cast<uintptr_t>(fMemory);
+        fData       = reinterpret_cast<float*>((address + kAlignment - 1) & ~static_cast<uintptr_t>(kAlignment - 1));
+        fStride     = stride;
+        fNumBuffers = numBuffers;
+
+        carla_zeroFloats(fData, stride * numBuffers);
+        return true;
+    }
+
+    /*
+     * Get the next buffer, zeroed, or null if all buffers reserved by reset() were handed out.
+     */
+    float* allocate() noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(fUsed < fNumBuffers, nullptr);
+
+        return fData + fStride * fUsed++;
+    }
+
+private:
+    void* fMemory;
+    float* fData;
+    std::size_t fStride;
+    uint32_t fNumBuffers;
+    uint32_t fUsed;
+
+    CARLA_DECLARE_NON_COPY_STRUCT(EngineAudioBufferArena)
+};
+
+// -----------------------------------------------------------------------
+
+// Graph event helpers
+// Patchbay graph buffers carry raw EngineEvent structs instead of MIDI bytes, so events do not need
+// to be re-encoded between plugins. Large MIDI events store their extended data right after the struct.
+
+// Returns false if some events did not fit in 'capacity'.
+static inline
+bool fillEngineEventsFromWaterMidiBuffer(EngineEvent engineEvents[kMaxEngineEventInternalCount], const water::MidiBuffer& midiBuffer,
+                                         const uint32_t capacity = kMaxEngineEventInternalCount)
+{
+    const uint8_t* eventData;
+    int numBytes, sampleNumber;
+    uint32_t engineEventIndex = getEngineEventCount(engineEvents);
+    bool fits = true;
+
+    for (water::MidiBuffer::Iterator midiBufferIterator(midiBuffer); midiBufferIterator.getNextEvent(eventData, numBytes, sampleNumber);)
     {
-        CARLA_SAFE_ASSERT_CONTINUE(numBytes > 0);
+        if (engineEventIndex >= capacity)
+        {
+            fits = false;
+            break;
+        }
+
+        CARLA_SAFE_ASSERT_CONTINUE(numBytes >= static_cast<int>(sizeof(EngineEvent)));
         CARLA_SAFE_ASSERT_CONTINUE(sampleNumber >= 0);
-        CARLA_SAFE_ASSERT_CONTINUE(numBytes < 0xFF /* uint8_t max */);
 
-        EngineEvent& engineEvent(engineEvents[engineEventIndex++]);
+        EngineEvent& engineEvent(engineEvents[engineEventIndex]);
+        std::memcpy(&engineEvent, eventData, sizeof(EngineEvent));
+
+        if (engineEvent.type == kEngineEventTypeMidi && engineEvent.midi.size > EngineMidiEvent::kDataSize)
+        {
+            CARLA_SAFE_ASSERT_CONTINUE(numBytes == static_cast<int>(sizeof(EngineEvent) + engineEvent.midi.size));
+
+            // points into the water buffer, valid until it gets modified
+            engineEvent.midi.dataExt = eventData + sizeof(EngineEvent);
+        }
 
         engineEvent.time = static_cast<uint32_t>(sampleNumber);
-        engineEvent.fillFromMidiData(static_cast<uint8_t>(numBytes), midiData, 0);
+        ++engineEventIndex;
     }
+
+    terminateEngineEvents(engineEvents, engineEventIndex);
+
+    return fits;
 }
 
 // -----------------------------------------------------------------------
@@ -155,14 +359,15 @@ void fillEngineEventsFromWaterMidiBuffer(EngineEvent engineEvents[kMaxEngineEven
 static inline
 void fillWaterMidiBufferFromEngineEvents(water::MidiBuffer& midiBuffer, const EngineEvent engineEvents[kMaxEngineEventInternalCount])
 {
-    uint8_t size     = 0;
-    uint8_t mdata[3] = { 0, 0, 0 };
-    uint8_t mdataTmp[EngineMidiEvent::kDataSize];
-    const uint8_t* mdataPtr;
+    uint8_t eventData[sizeof(EngineEvent) + 0xff];
+
+    // events are usually already sorted, so only search for the insertion point when needed
+    int lastTime = midiBuffer.isEmpty() ? 0 : -1;
 
-    for (ushort i=0; i < kMaxEngineEventInternalCount; ++i)
+    for (uint32_t i=0; i < kMaxEngineEventInternalCount; ++i)
     {
         const EngineEvent& engineEvent(engineEvents[i]);
+        int numBytes = static_cast<int>(sizeof(EngineEvent));
 
         /**/ if (engineEvent.type == kEngineEventTypeNull)
         {
@@ -170,36 +375,21 @@ void fillWaterMidiBufferFromEngineEvents(water::MidiBuffer& midiBuffer, const En
         }
         else if (engineEvent.type == kEngineEventTypeControl)
         {
-            const EngineControlEvent& ctrlEvent(engineEvent.ctrl);
-
-            size = ctrlEvent.convertToMidiData(engineEvent.channel, mdata);
-            mdataPtr = mdata;
+            std::memcpy(eventData, &engineEvent, sizeof(EngineEvent));
         }
         else if (engineEvent.type == kEngineEventTypeMidi)
         {
             const EngineMidiEvent& midiEvent(engineEvent.midi);
+            CARLA_SAFE_ASSERT_CONTINUE(midiEvent.size > 0);
 
-            size = midiEvent.size;
-            CARLA_SAFE_ASSERT_CONTINUE(size > 0);
+            std::memcpy(eventData, &engineEvent, sizeof(EngineEvent));
 
-            if (size > EngineMidiEvent::kDataSize)
+            if (midiEvent.size > EngineMidiEvent::kDataSize)
             {
                 CARLA_SAFE_ASSERT_CONTINUE(midiEvent.dataExt != nullptr);
-                mdataPtr = midiEvent.dataExt;
-            }
-            else
-            {
-                // set first byte
-                mdataTmp[0] = static_cast<uint8_t>(midiEvent.data[0] | (engineEvent.channel & MIDI_CHANNEL_BIT));
-
-                if (size > 1)
-                {
-                    // copy rest
-                    carla_copy<uint8_t>(mdataTmp+1, midiEvent.data+1, size-1U);
-                }
 
-                // done
-                mdataPtr = mdataTmp;
+                std::memcpy(eventData + sizeof(EngineEvent), midiEvent.dataExt, midiEvent.size);
+                numBytes += midiEvent.size;
             }
         }
         else
@@ -207,8 +397,12 @@ void fillWaterMidiBufferFromEngineEvents(water::MidiBuffer& midiBuffer, const En
             continue;
         }
 
-        if (size > 0)
-            midiBuffer.addEvent(mdataPtr, static_cast<int>(size), static_cast<int>(engineEvent.time));
+        const int time = static_cast<int>(engineEvent.time);
+
+        midiBuffer.addRawEvent(eventData, numBytes, time, lastTime);
+
+        if (lastTime >= 0 && time >= lastTime)
+            lastTime = time;
     }
 }
 
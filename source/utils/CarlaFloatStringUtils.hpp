@@ -0,0 +1,485 @@
+/*
+ * Carla float <-> string conversion utils
+ * Copyright (C) 2011-2020 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_FLOAT_STRING_UTILS_HPP_INCLUDED
+#define CARLA_FLOAT_STRING_UTILS_HPP_INCLUDED
+
+#include "CarlaUtils.hpp"
+
+#include <cmath>
+#include <clocale>
+#include <limits>
+
+#if defined(__GLIBC__) || defined(CARLA_OS_BSD) || defined(CARLA_OS_MAC)
+# define CARLA_USE_STRTOD_L
+# include <locale.h>
+# if defined(CARLA_OS_BSD) || defined(CARLA_OS_MAC)
+#  include <xlocale.h>
+# endif
+#endif
+
+/*
+ * Conversion between numbers and text that always uses '.' as decimal separator,
+ * regardless of the current locale, and without switching locales (see CarlaScopedLocale).
+ * Numbers are written with the fewest digits that read back to the exact same value.
+ */
+
+// --------------------------------------------------------------------------------------------------------------------
+// Helpers
+
+namespace CarlaFloatStringHelpers {
+
+#ifdef CARLA_USE_STRTOD_L
+static inline
+locale_t getNumericLocale() noexcept
+{
+    static const locale_t loc = ::newlocale(LC_NUMERIC_MASK, "C", (locale_t)nullptr);
+    return loc;
+}
+#endif
+
+/*
+ * Parse a number written with '.' as decimal separator.
+ * Without the *_l functions, the text is adjusted to the current locale instead.
+ */
+template<typename T>
+static inline
+T parse(const char* const str) noexcept
+{
+#ifdef CARLA_USE_STRTOD_L
+    if (const locale_t loc = getNumericLocale())
+        return sizeof(T) == sizeof(float) ? static_cast<T>(::strtof_l(str, nullptr, loc))
+                                          : static_cast<T>(::strtod_l(str, nullptr, loc));
+#endif
+
+    const char* const decimalPoint = std::localeconv()->decimal_point;
+
+    if (decimalPoint == nullptr || std::strcmp(decimalPoint, ".") == 0)
+        return sizeof(T) == sizeof(float) ? static_cast<T>(std::strtof(str, nullptr))
+                                          : static_cast<T>(std::strtod(str, nullptr));
+
+    const std::size_t decimalPointLen = std::strlen(decimalPoint);
+    char buf[64];
+    std::size_t i = 0;
+
+    for (const char* s = str; *s != '\0' && i + decimalPointLen < sizeof(buf); ++s)
+    {
+        if (*s == '.')
+        {
+            std::memcpy(buf + i, decimalPoint, decimalPointLen);
+            i += decimalPointLen;
+        }
+        else
+        {
+            buf[i++] = *s;
+        }
+    }
+
+    buf[i] = '\0';
+
+    return sizeof(T) == sizeof(float) ? static_cast<T>(std::strtof(buf, nullptr))
+                                      : static_cast<T>(std::strtod(buf, nullptr));
+}
+
+/*
+ * Write 'numDigits' digits with decimal exponent 'exp10' (value is d.ddd * 10^exp10).
+ * Uses plain notation for moderately sized numbers and scientific notation otherwise.
+ */
+static inline
+std::size_t writeDigits(char* const buf, const bool negative, const char* const digits, const int numDigits, const int exp10) noexcept
+{
+    std::size_t i = 0;
+
+    if (negative)
+        buf[i++] = '-';
+
+    if (exp10 >= -5 && exp10 < 0)
+    {
+        buf[i++] = '0';
+        buf[i++] = '.';
+        for (int z = -1; z > exp10; --z)
+            buf[i++] = '0';
+        for (int d = 0; d < numDigits; ++d)
+            buf[i++] = digits[d];
+    }
+    else if (exp10 >= 0 && exp10 < 17)
+    {
+        for (int d = 0; d <= exp10; ++d)
+            buf[i++] = d < numDigits ? digits[d] : '0';
+
+        if (numDigits > exp10 + 1)
+        {
+            buf[i++] = '.';
+            for (int d = exp10 + 1; d < numDigits; ++d)
+                buf[i++] = digits[d];
+        }
+    }
+    else
+    {
+        buf[i++] = digits[0];
+
+        if (numDigits > 1)
+        {
+            buf[i++] = '.';
+            for (int d = 1; d < numDigits; ++d)
+                buf[i++] = digits[d];
+        }
+
+        buf[i++] = 'e';
+
+        int e = exp10;
+        if (e < 0)
+        {
+            buf[i++] = '-';
+            e = -e;
+        }
+
+        if (e >= 100)
+            buf[i++] = static_cast<char>('0' + e / 100);
+        if (e >= 10)
+            buf[i++] = static_cast<char>('0' + (e / 10) % 10);
+        buf[i++] = static_cast<char>('0' + e % 10);
+    }
+
+    buf[i] = '\0';
+    return i;
+}
+
+/*
+ * Common cases that do not need digit generation: nan, infinity and small integers.
+ */
+template<typename T>
+static inline
+bool formatSpecial(char* const buf, const T value, const double maxInteger, std::size_t& len) noexcept
+{
+    if (std::isnan(value))
+    {
+        std::memcpy(buf, "nan", 4);
+        len = 3;
+        return true;
+    }
+
+    const bool negative = std::signbit(value);
+
+    if (std::isinf(value))
+    {
+        std::memcpy(buf, negative ? "-inf" : "inf", negative ? 5 : 4);
+        len = negative ? 4 : 3;
+        return true;
+    }
+
+    const double absValue = std::abs(static_cast<double>(value));
+
+    if (absValue >= maxInteger || absValue != std::floor(absValue))
+        return false;
+
+    char digits[20];
+    char* first = digits + sizeof(digits);
+    long long v = static_cast<long long>(absValue);
+
+    do {
+        *--first = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+
+    const int exp10 = static_cast<int>(digits + sizeof(digits) - first) - 1;
+    int numDigits = exp10 + 1;
+
+    while (numDigits > 1 && first[numDigits - 1] == '0')
+        --numDigits;
+
+    len = writeDigits(buf, negative && absValue != 0.0, first, numDigits, exp10);
+    return true;
+}
+
+static const double kPowersOf10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+ * value * 10^exp10, exact for powers up to 22 and close enough otherwise.
+ */
+static inline
+double scaleByPowerOf10(double value, int exp10) noexcept
+{
+    for (; exp10 > 22; exp10 -= 22)
+        value *= 1e22;
+    for (; exp10 < -22; exp10 += 22)
+        value /= 1e22;
+
+    return exp10 >= 0 ? value * kPowersOf10[exp10] : value / kPowersOf10[-exp10];
+}
+
+/*
+ * Check if the given digits read back as 'value'.
+ * For floats this is decided with a single double operation when the result is clearly away from
+ * the float rounding boundaries, otherwise the number is written out and parsed.
+ */
+static inline
+bool readsBack(const float value, const char* const digits, const int numDigits, const int exp10) noexcept
+{
+    const int scale = exp10 - numDigits + 1;
+
+    if (scale >= -22 && scale <= 22 && value < std::numeric_limits<float>::max())
+    {
+        uint32_t mantissa = 0;
+        for (int i = 0; i < numDigits; ++i)
+            mantissa = mantissa * 10 + static_cast<uint32_t>(digits[i] - '0');
+
+        // value is positive and finite, so its neighbours are one bit pattern away
+        uint32_t bits;
+        float prev, next;
+        std::memcpy(&bits, &value, sizeof(bits));
+        --bits;
+        std::memcpy(&prev, &bits, sizeof(prev));
+        bits += 2;
+        std::memcpy(&next, &bits, sizeof(next));
+
+        const double d = scale >= 0 ? mantissa * kPowersOf10[scale] : mantissa / kPowersOf10[-scale];
+        const double lowMid = (static_cast<double>(value) + prev) * 0.5;
+        const double highMid = (static_cast<double>(value) + next) * 0.5;
+        const double tolerance = d * 2.3e-16;
+
+        if (std::abs(d - lowMid) > tolerance && std::abs(d - highMid) > tolerance)
+            return d > lowMid && d < highMid;
+    }
+
+    char buf[32];
+    writeDigits(buf, false, digits, numDigits, exp10);
+    return parse<float>(buf) == value;
+}
+
+static inline
+bool readsBack(const double value, const char* const digits, const int numDigits, const int exp10) noexcept
+{
+    char buf[32];
+    writeDigits(buf, false, digits, numDigits, exp10);
+    return parse<double>(buf) == value;
+}
+
+/*
+ * Round 'digits' to 'numDigits', returns the new exponent.
+ */
+static inline
+int roundDigits(char* const rounded, const char* const digits, const int totalDigits, const int numDigits, const int exp10) noexcept
+{
+    std::memcpy(rounded, digits, static_cast<std::size_t>(numDigits));
+
+    if (numDigits >= totalDigits || digits[numDigits] < '5')
+        return exp10;
+
+    for (int d = numDigits; --d >= 0;)
+    {
+        if (rounded[d] != '9')
+        {
+            ++rounded[d];
+            return exp10;
+        }
+
+        rounded[d] = '0';
+    }
+
+    rounded[0] = '1';
+    return exp10 + 1;
+}
+
+/*
+ * Write the fewest of 'digits' that still read back as 'value'.
+ * 'digits' must be more precise than 'maxDigits', which is the precision that always reads back the same.
+ */
+template<typename T>
+static inline
+std::size_t writeShortest(char* const buf, const bool negative, const T value,
+                          const char* const digits, const int totalDigits, const int exp10, const int maxDigits) noexcept
+{
+    char rounded[24], candidate[24];
+    int candidateDigits = maxDigits;
+    int candidateExp10 = roundDigits(candidate, digits, totalDigits, maxDigits, exp10);
+
+    for (int low = 1, high = maxDigits - 1; low <= high;)
+    {
+        const int mid = (low + high) / 2;
+        const int roundedExp10 = roundDigits(rounded, digits, totalDigits, mid, exp10);
+
+        if (readsBack(value, rounded, mid, roundedExp10))
+        {
+            std::memcpy(candidate, rounded, static_cast<std::size_t>(mid));
+            candidateDigits = mid;
+            candidateExp10 = roundedExp10;
+            high = mid - 1;
+        }
+        else
+        {
+            low = mid + 1;
+        }
+    }
+
+    while (candidateDigits > 1 && candidate[candidateDigits - 1] == '0')
+        --candidateDigits;
+
+    return writeDigits(buf, negative, candidate, candidateDigits, candidateExp10);
+}
+
+/*
+ * Shortest round-trip conversion for floats.
+ * Double math is precise enough for generating the digits of a float, so no C library calls are needed.
+ */
+static inline
+std::size_t formatFloat(char* const buf, const float value) noexcept
+{
+    std::size_t len;
+    if (formatSpecial<float>(buf, value, 16777216.0, len))
+        return len;
+
+    const float absValue = std::abs(value);
+
+    // 16 digits, more than the 9 needed
+    int exp10 = static_cast<int>(std::floor(std::log10(static_cast<double>(absValue))));
+    long long mantissa = std::llround(scaleByPowerOf10(absValue, 15 - exp10));
+
+    if (mantissa >= 10000000000000000LL)
+        mantissa = std::llround(scaleByPowerOf10(absValue, 15 - ++exp10));
+    else if (mantissa < 1000000000000000LL)
+        mantissa = std::llround(scaleByPowerOf10(absValue, 15 - --exp10));
+
+    if (mantissa >= 10000000000000000LL)
+    {
+        mantissa /= 10;
+        ++exp10;
+    }
+
+    char digits[16];
+    for (int i = 16; --i >= 0;)
+    {
+        digits[i] = static_cast<char>('0' + mantissa % 10);
+        mantissa /= 10;
+    }
+
+    return writeShortest<float>(buf, std::signbit(value), absValue, digits, 16, exp10, 9);
+}
+
+/*
+ * Shortest round-trip conversion for doubles.
+ * Double math is not precise enough for generating its own digits, so these come from the C library,
+ * which rounds them correctly. Only its decimal separator depends on the locale, and it is skipped here.
+ */
+static inline
+std::size_t formatDouble(char* const buf, const double value) noexcept
+{
+    std::size_t len;
+    if (formatSpecial<double>(buf, value, 1e15, len))
+        return len;
+
+    const double absValue = std::abs(value);
+
+    // 20 digits, more than the 17 needed
+    char sci[64];
+    std::snprintf(sci, sizeof(sci), "%.19e", absValue);
+    sci[sizeof(sci)-1] = '\0';
+
+    char digits[20];
+    int numDigits = 0, exp10 = 0;
+
+    for (const char* s = sci; *s != '\0'; ++s)
+    {
+        if (*s >= '0' && *s <= '9')
+        {
+            if (numDigits < 20)
+                digits[numDigits++] = *s;
+        }
+        else if (*s == 'e')
+        {
+            exp10 = std::atoi(s + 1);
+            break;
+        }
+    }
+
+    CARLA_SAFE_ASSERT_RETURN(numDigits == 20, writeDigits(buf, false, "0", 1, 0));
+
+    return writeShortest<double>(buf, std::signbit(value), absValue, digits, 20, exp10, 17);
+}
+
+} // namespace CarlaFloatStringHelpers
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/*
+ * Maximum size needed for writing a float or double, including the null terminator.
+ */
+static const std::size_t kCarlaFloatStringMaxSize = 32;
+
+/*
+ * Write 'value' into 'buf', which must hold kCarlaFloatStringMaxSize characters.
+ * Returns the length of the string written.
+ */
+static inline
+std::size_t carla_floatToString(char* const buf, const float value) noexcept
+{
+    return CarlaFloatStringHelpers::formatFloat(buf, value);
+}
+
+static inline
+std::size_t carla_doubleToString(char* const buf, const double value) noexcept
+{
+    return CarlaFloatStringHelpers::formatDouble(buf, value);
+}
+
+/*
+ * Read a number written with '.' as decimal separator, like atof().
+ */
+static inline
+float carla_stringToFloat(const char* const str) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(str != nullptr, 0.0f);
+
+    return CarlaFloatStringHelpers::parse<float>(str);
+}
+
+static inline
+double carla_stringToDouble(const char* const str) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(str != nullptr, 0.0);
+
+    return CarlaFloatStringHelpers::parse<double>(str);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// CarlaFloatString class
+
+/*
+ * A float or double written into a stack buffer, meant for passing numbers into printf-like calls as "%s".
+ */
+struct CarlaFloatString {
+    char buffer[kCarlaFloatStringMaxSize];
+
+    explicit CarlaFloatString(const float value) noexcept
+    {
+        carla_floatToString(buffer, value);
+    }
+
+    explicit CarlaFloatString(const double value) noexcept
+    {
+        carla_doubleToString(buffer, value);
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(CarlaFloatString)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+#endif // CARLA_FLOAT_STRING_UTILS_HPP_INCLUDED
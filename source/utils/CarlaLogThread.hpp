@@ -19,6 +19,7 @@
 #define CARLA_LOG_THREAD_HPP_INCLUDED
 
 #include "CarlaBackend.h"
+#include "CarlaRtLog.hpp"
 #include "CarlaString.hpp"
 #include "CarlaThread.hpp"
 
@@ -142,6 +143,8 @@ protected:
 
         while (! shouldThreadExit())
         {
+            CarlaRtLog::getInstance().flush();
+
             bufRead[0] = '\0';
 
             while ((r = read(fPipe[0], bufRead, 1024)) > 0)
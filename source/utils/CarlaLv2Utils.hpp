@@ -19,6 +19,8 @@
 #define CARLA_LV2_UTILS_HPP_INCLUDED
 
 #include "CarlaMathUtils.hpp"
+#include "CarlaMutex.hpp"
+#include "CarlaString.hpp"
 #include "CarlaStringList.hpp"
 
 #ifndef nullptr
@@ -286,6 +288,9 @@ public:
 
     bool needsInit;
 
+    // lilv is not thread-safe, and when Carla runs as a plugin several engines share this world
+    CarlaRecursiveMutex mutex;
+
     const LilvPlugins* allPlugins;
     const LilvPlugin** cachedPlugins;
     uint pluginCount;
@@ -417,6 +422,7 @@ public:
           rdfs_range         (new_uri(NS_rdfs "range")),
 
           needsInit(true),
+          mutex(),
           allPlugins(nullptr),
           cachedPlugins(nullptr),
           pluginCount(0) {}
@@ -448,6 +454,8 @@ public:
             LV2_PATH = DEFAULT_LV2_PATH;
         }
 
+        const CarlaRecursiveMutexLocker crml(mutex);
+
         if (! needsInit)
             return;
 
@@ -455,40 +463,95 @@ public:
 
         Lilv::World::load_all(LV2_PATH);
 
-        allPlugins = lilv_world_get_all_plugins(this->me);
-        CARLA_SAFE_ASSERT_RETURN(allPlugins != nullptr,);
-
-        if ((pluginCount = lilv_plugins_size(allPlugins)))
-        {
-            cachedPlugins = new const LilvPlugin*[pluginCount+1];
-            carla_zeroPointers(cachedPlugins, pluginCount+1);
-
-            int i = 0;
-            for (LilvIter* it = lilv_plugins_begin(allPlugins); ! lilv_plugins_is_end(allPlugins, it); it = lilv_plugins_next(allPlugins, it))
-                cachedPlugins[i++] = lilv_plugins_get(allPlugins, it);
-        }
+        updateCachedPlugins();
     }
 
     void load_bundle(const char* const bundle)
     {
         CARLA_SAFE_ASSERT_RETURN(bundle != nullptr && bundle[0] != '\0',);
+
+        const CarlaRecursiveMutexLocker crml(mutex);
         CARLA_SAFE_ASSERT_RETURN(needsInit,);
 
         needsInit = false;
         Lilv::World::load_bundle(Lilv::Node(new_uri(bundle)));
 
-        allPlugins = lilv_world_get_all_plugins(this->me);
-        CARLA_SAFE_ASSERT_RETURN(allPlugins != nullptr,);
+        updateCachedPlugins();
+    }
 
-        if ((pluginCount = lilv_plugins_size(allPlugins)))
+    // Load a single bundle on demand, without scanning LV2_PATH.
+    // The bundle is either a full path or the name of a bundle folder inside one of the LV2_PATH entries.
+    // Does nothing if the full world is already loaded; a later initIfNeeded() call still loads everything else.
+    bool loadBundleOnDemand(const char* LV2_PATH, const char* const bundle)
+    {
+        CARLA_SAFE_ASSERT_RETURN(bundle != nullptr && bundle[0] != '\0', false);
+
+        const CarlaRecursiveMutexLocker crml(mutex);
+
+        if (! needsInit)
+            return true;
+
+        if (LV2_PATH == nullptr || LV2_PATH[0] == '\0')
         {
-            cachedPlugins = new const LilvPlugin*[pluginCount+1];
-            carla_zeroPointers(cachedPlugins, pluginCount+1);
+            static const char* const DEFAULT_LV2_PATH = LILV_DEFAULT_LV2_PATH;
+            LV2_PATH = DEFAULT_LV2_PATH;
+        }
 
-            int i = 0;
-            for (LilvIter* it = lilv_plugins_begin(allPlugins); ! lilv_plugins_is_end(allPlugins, it); it = lilv_plugins_next(allPlugins, it))
-                cachedPlugins[i++] = lilv_plugins_get(allPlugins, it);
+#ifdef CARLA_OS_WIN
+        const bool isAbsolute = bundle[0] != '\0' && bundle[1] == ':';
+#else
+        const bool isAbsolute = bundle[0] == CARLA_OS_SEP;
+#endif
+
+        CarlaString bundlePath;
+
+        if (isAbsolute)
+        {
+            if (isBundleDir(bundle))
+                bundlePath = bundle;
+        }
+        else
+        {
+            const char* const home = std::getenv("HOME");
+
+            for (const char* path = LV2_PATH; path != nullptr && bundlePath.isEmpty();)
+            {
+                const char* const split = std::strchr(path, CARLA_OS_SPLIT);
+
+                CarlaString entry(path);
+                if (split != nullptr)
+                    entry.truncate(static_cast<std::size_t>(split - path));
+
+                if (entry.startsWith('~') && home != nullptr)
+                    entry = CarlaString(home) + (entry.buffer() + 1);
+
+                if (entry.isNotEmpty())
+                {
+                    entry += CARLA_OS_SEP_STR;
+                    entry += bundle;
+
+                    if (isBundleDir(entry))
+                        bundlePath = entry;
+                }
+
+                path = split != nullptr ? split + 1 : nullptr;
+            }
         }
+
+        if (bundlePath.isEmpty())
+            return false;
+
+        if (! bundlePath.endsWith(CARLA_OS_SEP))
+            bundlePath += CARLA_OS_SEP_STR;
+
+        LilvNode* const bundleNode(new_file_uri(nullptr, bundlePath));
+        CARLA_SAFE_ASSERT_RETURN(bundleNode != nullptr, false);
+
+        lilv_world_load_bundle(this->me, bundleNode);
+        lilv_node_free(bundleNode);
+
+        updateCachedPlugins();
+        return allPlugins != nullptr;
     }
 
     uint getPluginCount() const
@@ -510,7 +573,8 @@ public:
     const LilvPlugin* getPluginFromURI(const LV2_URI uri) const
     {
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', nullptr);
-        CARLA_SAFE_ASSERT_RETURN(! needsInit, nullptr);
+
+        const CarlaRecursiveMutexLocker crml(mutex);
         CARLA_SAFE_ASSERT_RETURN(allPlugins != nullptr, nullptr);
 
         LilvNode* const uriNode(lilv_new_uri(this->me, uri));
@@ -526,7 +590,9 @@ public:
     {
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', nullptr);
         CARLA_SAFE_ASSERT_RETURN(uridMap != nullptr, nullptr);
-        CARLA_SAFE_ASSERT_RETURN(! needsInit, nullptr);
+
+        const CarlaRecursiveMutexLocker crml(mutex);
+        CARLA_SAFE_ASSERT_RETURN(allPlugins != nullptr, nullptr);
 
         LilvNode* const uriNode(lilv_new_uri(this->me, uri));
         CARLA_SAFE_ASSERT_RETURN(uriNode != nullptr, nullptr);
@@ -539,6 +605,44 @@ public:
         return cState;
     }
 
+private:
+    static bool isBundleDir(const char* const path)
+    {
+        CarlaString manifest(path);
+        manifest += CARLA_OS_SEP_STR "manifest.ttl";
+
+        if (std::FILE* const file = std::fopen(manifest, "r"))
+        {
+            std::fclose(file);
+            return true;
+        }
+
+        return false;
+    }
+
+    void updateCachedPlugins()
+    {
+        if (cachedPlugins != nullptr)
+        {
+            delete[] cachedPlugins;
+            cachedPlugins = nullptr;
+        }
+
+        allPlugins = lilv_world_get_all_plugins(this->me);
+        CARLA_SAFE_ASSERT_RETURN(allPlugins != nullptr,);
+
+        if ((pluginCount = lilv_plugins_size(allPlugins)))
+        {
+            cachedPlugins = new const LilvPlugin*[pluginCount+1];
+            carla_zeroPointers(cachedPlugins, pluginCount+1);
+
+            int i = 0;
+            for (LilvIter* it = lilv_plugins_begin(allPlugins); ! lilv_plugins_is_end(allPlugins, it); it = lilv_plugins_next(allPlugins, it))
+                cachedPlugins[i++] = lilv_plugins_get(allPlugins, it);
+        }
+    }
+
+public:
     CARLA_PREVENT_VIRTUAL_HEAP_ALLOCATION
     CARLA_DECLARE_NON_COPY_STRUCT(Lv2WorldClass)
 };
@@ -567,7 +671,7 @@ public:
     Lv2PluginBaseClass(const double sampleRate, const LV2_Feature* const* const features)
         : fIsActive(false),
           fIsOffline(false),
-          fUsingNominal(false),
+          fUsingMaxBlockLength(false),
           fBufferSize(0),
           fSampleRate(sampleRate),
           fFreePath(nullptr),
@@ -629,14 +733,14 @@ public:
                     const int32_t value(*(const int32_t*)options[i].value);
                     CARLA_SAFE_ASSERT_CONTINUE(value > 0);
 
-                    fBufferSize = static_cast<uint32_t>(value);
-                    fUsingNominal = true;
+                    if (! fUsingMaxBlockLength)
+                        fBufferSize = static_cast<uint32_t>(value);
                 }
                 else
                 {
                     carla_stderr("Host provides nominalBlockLength but has wrong value type");
                 }
-                break;
+                continue;
             }
 
             if (options[i].key == uridMap->map(uridMap->handle, LV2_BUF_SIZE__maxBlockLength))
@@ -646,13 +750,14 @@ public:
                     const int32_t value(*(const int32_t*)options[i].value);
                     CARLA_SAFE_ASSERT_CONTINUE(value > 0);
 
+                    // always preferred over nominalBlockLength, so buffers are never too small for the host
                     fBufferSize = static_cast<uint32_t>(value);
+                    fUsingMaxBlockLength = true;
                 }
                 else
                 {
                     carla_stderr("Host provides maxBlockLength but has wrong value type");
                 }
-                // no break, continue in case host supports nominalBlockLength
             }
         }
 
@@ -937,22 +1042,42 @@ public:
         }
 
         // Check for updated parameters
-        float curValue;
-
-        for (uint32_t i=0; i < fPorts.numParams; ++i)
+        if (fPorts.numParamsIn > 0)
         {
-            if (fPorts.paramsOut[i])
-                continue;
+            const uint32_t numParamsIn = fPorts.numParamsIn;
+            float* const paramsInCur   = fPorts.paramsInValues;
+            float* const paramsInPrev  = fPorts.paramsInValues + numParamsIn;
+
+            // copy inputs into a contiguous block, so the common "nothing changed" case is a single memcmp
+            for (uint32_t j=0; j < numParamsIn; ++j)
+            {
+                const float* const ptr = fPorts.paramsPtr[fPorts.paramsInIndexes[j]];
+                paramsInCur[j] = ptr != nullptr ? *ptr : paramsInPrev[j];
+            }
 
-            CARLA_SAFE_ASSERT_CONTINUE(fPorts.paramsPtr[i] != nullptr)
+            if (std::memcmp(paramsInCur, paramsInPrev, sizeof(float)*numParamsIn) != 0)
+            {
+                float curValue;
 
-            curValue = *fPorts.paramsPtr[i];
+                for (uint32_t j=0; j < numParamsIn; ++j)
+                {
+                    curValue = paramsInCur[j];
 
-            if (carla_isEqual(fPorts.paramsLast[i], curValue))
-                continue;
+                    if (carla_isEqual(paramsInPrev[j], curValue))
+                        continue;
 
-            fPorts.paramsLast[i] = curValue;
-            handleParameterValueChanged(i, curValue);
+                    paramsInPrev[j] = curValue;
+
+                    // values can also be changed by the plugin side, as in state restore
+                    const uint32_t i = fPorts.paramsInIndexes[j];
+
+                    if (carla_isEqual(fPorts.paramsLast[i], curValue))
+                        continue;
+
+                    fPorts.paramsLast[i] = curValue;
+                    handleParameterValueChanged(i, curValue);
+                }
+            }
         }
 
         if (frames == 0)
@@ -1054,7 +1179,7 @@ public:
     {
         for (int i=0; options[i].key != 0; ++i)
         {
-            if (options[i].key == fUridMap->map(fUridMap->handle, LV2_BUF_SIZE__nominalBlockLength))
+            if (options[i].key == fUridMap->map(fUridMap->handle, LV2_BUF_SIZE__nominalBlockLength) && ! fUsingMaxBlockLength)
             {
                 if (options[i].type == fURIs.atomInt)
                 {
@@ -1074,7 +1199,7 @@ public:
                     carla_stderr("Host changed nominalBlockLength but with wrong value type");
                 }
             }
-            else if (options[i].key == fUridMap->map(fUridMap->handle, LV2_BUF_SIZE__maxBlockLength) && ! fUsingNominal)
+            else if (options[i].key == fUridMap->map(fUridMap->handle, LV2_BUF_SIZE__maxBlockLength))
             {
                 if (options[i].type == fURIs.atomInt)
                 {
@@ -1178,7 +1303,7 @@ protected:
     // LV2 host data
     bool     fIsActive : 1;
     bool     fIsOffline : 1;
-    bool     fUsingNominal : 1;
+    bool     fUsingMaxBlockLength : 1;
     uint32_t fBufferSize;
     double   fSampleRate;
 
@@ -1265,6 +1390,11 @@ protected:
         float** paramsPtr;
         bool*   paramsOut;
 
+        // input parameters only, current and previous port values in 2 contiguous blocks
+        uint32_t  numParamsIn;
+        uint32_t* paramsInIndexes;
+        float*    paramsInValues;
+
         Ports()
             : indexOffset(0),
               numAudioIns(0),
@@ -1284,7 +1414,10 @@ protected:
               freewheel(nullptr),
               paramsLast(nullptr),
               paramsPtr(nullptr),
-              paramsOut(nullptr) {}
+              paramsOut(nullptr),
+              numParamsIn(0),
+              paramsInIndexes(nullptr),
+              paramsInValues(nullptr) {}
 
         ~Ports()
         {
@@ -1335,6 +1468,18 @@ protected:
                 delete[] paramsOut;
                 paramsOut = nullptr;
             }
+
+            if (paramsInIndexes != nullptr)
+            {
+                delete[] paramsInIndexes;
+                paramsInIndexes = nullptr;
+            }
+
+            if (paramsInValues != nullptr)
+            {
+                delete[] paramsInValues;
+                paramsInValues = nullptr;
+            }
         }
 
         // NOTE: assumes num* has been filled by parent class
@@ -1384,12 +1529,15 @@ protected:
                 paramsLast = new float[numParams];
                 paramsPtr  = new float*[numParams];
                 paramsOut  = new bool[numParams];
+                paramsInIndexes = new uint32_t[numParams];
+                paramsInValues  = new float[numParams*2];
 
                 carla_zeroFloats(paramsLast, numParams);
                 carla_zeroPointers(paramsPtr, numParams);
                 carla_zeroStructs(paramsOut, numParams);
+                carla_zeroFloats(paramsInValues, numParams*2);
 
-                // NOTE: need to be filled in by the parent class
+                // NOTE: need to be filled in by the parent class, which then calls initParamsIn()
             }
 
             indexOffset  = numAudioIns + numAudioOuts + numCVIns + numCVOuts;
@@ -1401,6 +1549,24 @@ protected:
             indexOffset += 1;
         }
 
+        // NOTE: assumes paramsLast and paramsOut have been filled by parent class
+        void initParamsIn() noexcept
+        {
+            numParamsIn = 0;
+
+            for (uint32_t i=0; i < numParams; ++i)
+            {
+                if (! paramsOut[i])
+                    paramsInIndexes[numParamsIn++] = i;
+            }
+
+            // current values first, previous ones right after
+            for (uint32_t j=0; j < numParamsIn; ++j)
+            {
+                paramsInValues[j] = paramsInValues[numParamsIn+j] = paramsLast[paramsInIndexes[j]];
+            }
+        }
+
         void connectPort(const uint32_t port, void* const dataLocation)
         {
             uint32_t index = 0;
@@ -1650,6 +1816,7 @@ const LV2_RDF_Descriptor* lv2_rdf_new(const LV2_URI uri, const bool loadPresets)
     CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', nullptr);
 
     Lv2WorldClass& lv2World(Lv2WorldClass::getInstance());
+    const CarlaRecursiveMutexLocker crml(lv2World.mutex);
 
     const LilvPlugin* const cPlugin(lv2World.getPluginFromURI(uri));
     CARLA_SAFE_ASSERT_RETURN(cPlugin != nullptr, nullptr);
@@ -158,6 +158,246 @@ bool carla_isNotZero(const T& value)
     return std::abs(value) >= std::numeric_limits<T>::epsilon();
 }
 
+// --------------------------------------------------------------------------------------------------------------------
+// SIMD helpers for the buffer functions below
+
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__SSE2__)
+# define CARLA_MATH_UTILS_SSE2
+# include <emmintrin.h>
+# if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+// AVX code is built regardless of compiler flags and only used if the running CPU supports it
+#  define CARLA_MATH_UTILS_AVX
+#  include <immintrin.h>
+# endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# define CARLA_MATH_UTILS_NEON
+# include <arm_neon.h>
+#endif
+
+/*
+ * Check if the running CPU supports AVX.
+ * The result is cached, call this once during init so it is not checked in realtime context.
+ */
+inline
+bool carla_cpuHasAVX() noexcept
+{
+#ifdef CARLA_MATH_UTILS_AVX
+    static const bool hasAVX = (__builtin_cpu_init(), __builtin_cpu_supports("avx") != 0);
+    return hasAVX;
+#else
+    return false;
+#endif
+}
+
+#if defined(CARLA_MATH_UTILS_SSE2) || defined(CARLA_MATH_UTILS_NEON)
+// 4 floats at once, using whatever the build target has (SSE2 or NEON)
+# ifdef CARLA_MATH_UTILS_SSE2
+typedef __m128 carla_float4;
+
+static inline carla_float4 carla_float4_load(const float* const p) noexcept { return _mm_loadu_ps(p); }
+static inline void carla_float4_store(float* const p, const carla_float4 v) noexcept { _mm_storeu_ps(p, v); }
+static inline carla_float4 carla_float4_set(const float value) noexcept { return _mm_set1_ps(value); }
+static inline carla_float4 carla_float4_add(const carla_float4 a, const carla_float4 b) noexcept { return _mm_add_ps(a, b); }
+static inline carla_float4 carla_float4_mul(const carla_float4 a, const carla_float4 b) noexcept { return _mm_mul_ps(a, b); }
+static inline carla_float4 carla_float4_max(const carla_float4 a, const carla_float4 b) noexcept { return _mm_max_ps(a, b); }
+static inline carla_float4 carla_float4_abs(const carla_float4 v) noexcept { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+
+static inline float carla_float4_hmax(carla_float4 v) noexcept
+{
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(v);
+}
+
+// a = [x0 y0 x1 y1], b = [x2 y2 x3 y3] -> x = [x0 x1 x2 x3], y = [y0 y1 y2 y3]
+static inline void carla_float4_deinterleave2(const carla_float4 a, const carla_float4 b,
+                                              carla_float4& x, carla_float4& y) noexcept
+{
+    x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+// reverse of carla_float4_deinterleave2
+static inline void carla_float4_interleave2(const carla_float4 x, const carla_float4 y,
+                                            carla_float4& a, carla_float4& b) noexcept
+{
+    a = _mm_unpacklo_ps(x, y);
+    b = _mm_unpackhi_ps(x, y);
+}
+
+// rows become columns
+static inline void carla_float4_transpose(carla_float4& r0, carla_float4& r1, carla_float4& r2, carla_float4& r3) noexcept
+{
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+# else
+typedef float32x4_t carla_float4;
+
+static inline carla_float4 carla_float4_load(const float* const p) noexcept { return vld1q_f32(p); }
+static inline void carla_float4_store(float* const p, const carla_float4 v) noexcept { vst1q_f32(p, v); }
+static inline carla_float4 carla_float4_set(const float value) noexcept { return vdupq_n_f32(value); }
+static inline carla_float4 carla_float4_add(const carla_float4 a, const carla_float4 b) noexcept { return vaddq_f32(a, b); }
+static inline carla_float4 carla_float4_mul(const carla_float4 a, const carla_float4 b) noexcept { return vmulq_f32(a, b); }
+static inline carla_float4 carla_float4_max(const carla_float4 a, const carla_float4 b) noexcept { return vmaxq_f32(a, b); }
+static inline carla_float4 carla_float4_abs(const carla_float4 v) noexcept { return vabsq_f32(v); }
+
+static inline float carla_float4_hmax(const carla_float4 v) noexcept
+{
+    float32x2_t m = vpmax_f32(vget_low_f32(v), vget_high_f32(v));
+    m = vpmax_f32(m, m);
+    return vget_lane_f32(m, 0);
+}
+
+static inline void carla_float4_deinterleave2(const carla_float4 a, const carla_float4 b,
+                                              carla_float4& x, carla_float4& y) noexcept
+{
+    const float32x4x2_t r = vuzpq_f32(a, b);
+    x = r.val[0];
+    y = r.val[1];
+}
+
+static inline void carla_float4_interleave2(const carla_float4 x, const carla_float4 y,
+                                            carla_float4& a, carla_float4& b) noexcept
+{
+    const float32x4x2_t r = vzipq_f32(x, y);
+    a = r.val[0];
+    b = r.val[1];
+}
+
+static inline void carla_float4_transpose(carla_float4& r0, carla_float4& r1, carla_float4& r2, carla_float4& r3) noexcept
+{
+    const float32x4x2_t t01 = vtrnq_f32(r0, r1);
+    const float32x4x2_t t23 = vtrnq_f32(r2, r3);
+    r0 = vcombine_f32(vget_low_f32(t01.val[0]),  vget_low_f32(t23.val[0]));
+    r1 = vcombine_f32(vget_low_f32(t01.val[1]),  vget_low_f32(t23.val[1]));
+    r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+# endif
+#endif
+
+#ifdef CARLA_MATH_UTILS_AVX
+// 8 floats at once, must only be called if carla_cpuHasAVX() returns true
+__attribute__((target("avx")))
+static inline
+void carla_addFloats_avx(float dest[], const float src[], const std::size_t count) noexcept
+{
+    std::size_t i = 0;
+    for (; i+8 <= count; i += 8)
+        _mm256_storeu_ps(dest+i, _mm256_add_ps(_mm256_loadu_ps(dest+i), _mm256_loadu_ps(src+i)));
+    for (; i<count; ++i)
+        dest[i] += src[i];
+}
+
+__attribute__((target("avx")))
+static inline
+void carla_addFloatsWithGain_avx(float dest[], const float src[], const float gain, const std::size_t count) noexcept
+{
+    const __m256 g = _mm256_set1_ps(gain);
+    std::size_t i = 0;
+    for (; i+8 <= count; i += 8)
+        _mm256_storeu_ps(dest+i, _mm256_add_ps(_mm256_loadu_ps(dest+i), _mm256_mul_ps(_mm256_loadu_ps(src+i), g)));
+    for (; i<count; ++i)
+        dest[i] += src[i] * gain;
+}
+
+__attribute__((target("avx")))
+static inline
+void carla_multiply_avx(float data[], const float multiplier, const std::size_t count) noexcept
+{
+    const __m256 m = _mm256_set1_ps(multiplier);
+    std::size_t i = 0;
+    for (; i+8 <= count; i += 8)
+        _mm256_storeu_ps(data+i, _mm256_mul_ps(_mm256_loadu_ps(data+i), m));
+    for (; i<count; ++i)
+        data[i] *= multiplier;
+}
+
+__attribute__((target("avx")))
+static inline
+void carla_fillFloats_avx(float data[], const float value, const std::size_t count) noexcept
+{
+    const __m256 v = _mm256_set1_ps(value);
+    std::size_t i = 0;
+    for (; i+8 <= count; i += 8)
+        _mm256_storeu_ps(data+i, v);
+    for (; i<count; ++i)
+        data[i] = value;
+}
+
+// highest absolute value, copying into 'dest' at the same time if not null
+__attribute__((target("avx")))
+static inline
+float carla_findMaxAbsFloat_avx(float dest[], const float src[], const std::size_t count) noexcept
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    __m256 vmax = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i+8 <= count; i += 8)
+    {
+        const __m256 v = _mm256_loadu_ps(src+i);
+        if (dest != nullptr)
+            _mm256_storeu_ps(dest+i, v);
+        vmax = _mm256_max_ps(vmax, _mm256_andnot_ps(signMask, v));
+    }
+
+    __m128 vmax4 = _mm_max_ps(_mm256_castps256_ps128(vmax), _mm256_extractf128_ps(vmax, 1));
+    vmax4 = _mm_max_ps(vmax4, _mm_shuffle_ps(vmax4, vmax4, _MM_SHUFFLE(2, 3, 0, 1)));
+    vmax4 = _mm_max_ps(vmax4, _mm_shuffle_ps(vmax4, vmax4, _MM_SHUFFLE(1, 0, 3, 2)));
+    float maxf = _mm_cvtss_f32(vmax4);
+
+    for (; i<count; ++i)
+    {
+        if (dest != nullptr)
+            dest[i] = src[i];
+        const float tmp = std::abs(src[i]);
+        if (tmp > maxf)
+            maxf = tmp;
+    }
+
+    return maxf;
+}
+#endif
+
+// highest absolute value, copying into 'dest' at the same time if not null
+static inline
+float carla_findMaxAbsFloat(float dest[], const float src[], const std::size_t count) noexcept
+{
+#ifdef CARLA_MATH_UTILS_AVX
+    if (carla_cpuHasAVX())
+        return carla_findMaxAbsFloat_avx(dest, src, count);
+#endif
+
+    float maxf = 0.0f;
+    std::size_t i = 0;
+
+#if defined(CARLA_MATH_UTILS_SSE2) || defined(CARLA_MATH_UTILS_NEON)
+    if (count >= 4)
+    {
+        carla_float4 vmax = carla_float4_set(0.0f);
+        for (; i+4 <= count; i += 4)
+        {
+            const carla_float4 v = carla_float4_load(src+i);
+            if (dest != nullptr)
+                carla_float4_store(dest+i, v);
+            vmax = carla_float4_max(vmax, carla_float4_abs(v));
+        }
+        maxf = carla_float4_hmax(vmax);
+    }
+#endif
+
+    for (; i<count; ++i)
+    {
+        if (dest != nullptr)
+            dest[i] = src[i];
+        const float tmp = std::abs(src[i]);
+        if (tmp > maxf)
+            maxf = tmp;
+    }
+
+    return maxf;
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 // math functions (extended)
 
@@ -171,8 +411,46 @@ void carla_addFloats(float dest[], const float src[], const std::size_t count) n
     CARLA_SAFE_ASSERT_RETURN(src != nullptr,);
     CARLA_SAFE_ASSERT_RETURN(count > 0,);
 
-    for (std::size_t i=0; i<count; ++i)
-        *dest++ += *src++;
+#ifdef CARLA_MATH_UTILS_AVX
+    if (carla_cpuHasAVX())
+        return carla_addFloats_avx(dest, src, count);
+#endif
+
+    std::size_t i = 0;
+#if defined(CARLA_MATH_UTILS_SSE2) || defined(CARLA_MATH_UTILS_NEON)
+    for (; i+4 <= count; i += 4)
+        carla_float4_store(dest+i, carla_float4_add(carla_float4_load(dest+i), carla_float4_load(src+i)));
+#endif
+    for (; i<count; ++i)
+        dest[i] += src[i];
+}
+
+/*
+ * Add float array values multiplied by a gain to another float array.
+ */
+static inline
+void carla_addFloatsWithGain(float dest[], const float src[], const float gain, const std::size_t count) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(dest != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(src != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(count > 0,);
+
+    if (carla_isZero(gain))
+        return;
+
+#ifdef CARLA_MATH_UTILS_AVX
+    if (carla_cpuHasAVX())
+        return carla_addFloatsWithGain_avx(dest, src, gain, count);
+#endif
+
+    std::size_t i = 0;
+#if defined(CARLA_MATH_UTILS_SSE2) || defined(CARLA_MATH_UTILS_NEON)
+    const carla_float4 g = carla_float4_set(gain);
+    for (; i+4 <= count; i += 4)
+        carla_float4_store(dest+i, carla_float4_add(carla_float4_load(dest+i), carla_float4_mul(carla_float4_load(src+i), g)));
+#endif
+    for (; i<count; ++i)
+        dest[i] += src[i] * gain;
 }
 
 /*
@@ -188,6 +466,20 @@ void carla_copyFloats(float dest[], const float src[], const std::size_t count)
     std::memcpy(dest, src, count*sizeof(float));
 }
 
+/*
+ * Copy float array values to another float array, returning the highest absolute and normalized value.
+ */
+static inline
+float carla_copyFloatsWithPeak(float dest[], const float src[], const std::size_t count) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(dest != nullptr, 0.0f);
+    CARLA_SAFE_ASSERT_RETURN(src != nullptr, 0.0f);
+    CARLA_SAFE_ASSERT_RETURN(count > 0, 0.0f);
+
+    const float maxf = carla_findMaxAbsFloat(dest, src, count);
+    return maxf > 1.0f ? 1.0f : maxf;
+}
+
 /*
  * Fill a float array with a single float value.
  */
@@ -200,12 +492,22 @@ void carla_fillFloatsWithSingleValue(float data[], const float& value, const std
     if (carla_isZero(value))
     {
         std::memset(data, 0, count*sizeof(float));
+        return;
     }
-    else
-    {
-        for (std::size_t i=0; i<count; ++i)
-            *data++ = value;
-    }
+
+#ifdef CARLA_MATH_UTILS_AVX
+    if (carla_cpuHasAVX())
+        return carla_fillFloats_avx(data, value, count);
+#endif
+
+    std::size_t i = 0;
+#if defined(CARLA_MATH_UTILS_SSE2) || defined(CARLA_MATH_UTILS_NEON)
+    const carla_float4 v = carla_float4_set(value);
+    for (; i+4 <= count; i += 4)
+        carla_float4_store(data+i, v);
+#endif
+    for (; i<count; ++i)
+        data[i] = value;
 }
 
 /*
@@ -220,6 +522,166 @@ void carla_zeroFloats(float floats[], const std::size_t count) noexcept
     std::memset(floats, 0, count*sizeof(float));
 }
 
+/*
+ * Split interleaved audio into one buffer per channel.
+ * 2, 4 and 8 channels are vectorized, other channel counts use a generic path.
+ */
+static inline
+void carla_deinterleaveFloats(float* const dest[], const float src[], const uint channels, const std::size_t frames) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(dest != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(src != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(channels > 0,);
+    CARLA_SAFE_ASSERT_RETURN(frames > 0,);
+
+    if (channels == 1)
+        return carla_copyFloats(dest[0], src, frames);
+
+    std::size_t i = 0;
+
+#if defined(CARLA_MATH_UTILS_SSE2) || defined(CARLA_MATH_UTILS_NEON)
+    carla_float4 r0, r1, r2, r3;
+
+    switch (channels)
+    {
+    case 2:
+        for (; i+4 <= frames; i += 4)
+        {
+            carla_float4_deinterleave2(carla_float4_load(src+i*2), carla_float4_load(src+i*2+4), r0, r1);
+            carla_float4_store(dest[0]+i, r0);
+            carla_float4_store(dest[1]+i, r1);
+        }
+        break;
+
+    case 4:
+        for (; i+4 <= frames; i += 4)
+        {
+            const float* const s = src + i*4;
+            r0 = carla_float4_load(s);
+            r1 = carla_float4_load(s+4);
+            r2 = carla_float4_load(s+8);
+            r3 = carla_float4_load(s+12);
+            carla_float4_transpose(r0, r1, r2, r3);
+            carla_float4_store(dest[0]+i, r0);
+            carla_float4_store(dest[1]+i, r1);
+            carla_float4_store(dest[2]+i, r2);
+            carla_float4_store(dest[3]+i, r3);
+        }
+        break;
+
+    case 8:
+        // as two 4x4 blocks, first and second half of each frame
+        for (; i+4 <= frames; i += 4)
+        {
+            const float* const s = src + i*8;
+
+            for (uint h=0; h < 8; h += 4)
+            {
+                r0 = carla_float4_load(s+h);
+                r1 = carla_float4_load(s+h+8);
+                r2 = carla_float4_load(s+h+16);
+                r3 = carla_float4_load(s+h+24);
+                carla_float4_transpose(r0, r1, r2, r3);
+                carla_float4_store(dest[h]+i,   r0);
+                carla_float4_store(dest[h+1]+i, r1);
+                carla_float4_store(dest[h+2]+i, r2);
+                carla_float4_store(dest[h+3]+i, r3);
+            }
+        }
+        break;
+    }
+#endif
+
+    // generic path, and frames left over from the above
+    for (uint c=0; c < channels; ++c)
+    {
+        float* const d = dest[c];
+        const float* s = src + i*channels + c;
+
+        for (std::size_t j=i; j < frames; ++j, s += channels)
+            d[j] = *s;
+    }
+}
+
+/*
+ * Merge one buffer per channel into interleaved audio.
+ * 2, 4 and 8 channels are vectorized, other channel counts use a generic path.
+ */
+static inline
+void carla_interleaveFloats(float dest[], const float* const src[], const uint channels, const std::size_t frames) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(dest != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(src != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(channels > 0,);
+    CARLA_SAFE_ASSERT_RETURN(frames > 0,);
+
+    if (channels == 1)
+        return carla_copyFloats(dest, src[0], frames);
+
+    std::size_t i = 0;
+
+#if defined(CARLA_MATH_UTILS_SSE2) || defined(CARLA_MATH_UTILS_NEON)
+    carla_float4 r0, r1, r2, r3;
+
+    switch (channels)
+    {
+    case 2:
+        for (; i+4 <= frames; i += 4)
+        {
+            carla_float4_interleave2(carla_float4_load(src[0]+i), carla_float4_load(src[1]+i), r0, r1);
+            carla_float4_store(dest+i*2,   r0);
+            carla_float4_store(dest+i*2+4, r1);
+        }
+        break;
+
+    case 4:
+        for (; i+4 <= frames; i += 4)
+        {
+            float* const d = dest + i*4;
+            r0 = carla_float4_load(src[0]+i);
+            r1 = carla_float4_load(src[1]+i);
+            r2 = carla_float4_load(src[2]+i);
+            r3 = carla_float4_load(src[3]+i);
+            carla_float4_transpose(r0, r1, r2, r3);
+            carla_float4_store(d,    r0);
+            carla_float4_store(d+4,  r1);
+            carla_float4_store(d+8,  r2);
+            carla_float4_store(d+12, r3);
+        }
+        break;
+
+    case 8:
+        for (; i+4 <= frames; i += 4)
+        {
+            float* const d = dest + i*8;
+
+            for (uint h=0; h < 8; h += 4)
+            {
+                r0 = carla_float4_load(src[h]+i);
+                r1 = carla_float4_load(src[h+1]+i);
+                r2 = carla_float4_load(src[h+2]+i);
+                r3 = carla_float4_load(src[h+3]+i);
+                carla_float4_transpose(r0, r1, r2, r3);
+                carla_float4_store(d+h,    r0);
+                carla_float4_store(d+h+8,  r1);
+                carla_float4_store(d+h+16, r2);
+                carla_float4_store(d+h+24, r3);
+            }
+        }
+        break;
+    }
+#endif
+
+    for (uint c=0; c < channels; ++c)
+    {
+        const float* const s = src[c];
+        float* d = dest + i*channels + c;
+
+        for (std::size_t j=i; j < frames; ++j, d += channels)
+            *d = s[j];
+    }
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 
 /*
@@ -243,23 +705,11 @@ float carla_findMaxNormalizedFloat(const float floats[], const std::size_t count
 
     static const float kEmptyFloats[8192] = { 0.0f };
 
-    if (count <= 8192 && std::memcmp(floats, kEmptyFloats, count) == 0)
+    if (count <= 8192 && std::memcmp(floats, kEmptyFloats, count*sizeof(float)) == 0)
         return 0.0f;
 
-    float tmp, maxf2 = std::abs(floats[0]);
-
-    for (std::size_t i=1; i<count; ++i)
-    {
-        tmp = std::abs(*floats++);
-
-        if (tmp > maxf2)
-            maxf2 = tmp;
-    }
-
-    if (maxf2 > 1.0f)
-        maxf2 = 1.0f;
-
-    return maxf2;
+    const float maxf = carla_findMaxAbsFloat(nullptr, floats, count);
+    return maxf > 1.0f ? 1.0f : maxf;
 }
 
 /*
@@ -274,12 +724,67 @@ void carla_multiply(float data[], const float& multiplier, const std::size_t cou
     if (carla_isZero(multiplier))
     {
         std::memset(data, 0, count*sizeof(float));
+        return;
     }
-    else
-    {
-        for (std::size_t i=0; i<count; ++i)
-            *data++ *= multiplier;
-    }
+
+#ifdef CARLA_MATH_UTILS_AVX
+    if (carla_cpuHasAVX())
+        return carla_multiply_avx(data, multiplier, count);
+#endif
+
+    std::size_t i = 0;
+#if defined(CARLA_MATH_UTILS_SSE2) || defined(CARLA_MATH_UTILS_NEON)
+    const carla_float4 m = carla_float4_set(multiplier);
+    for (; i+4 <= count; i += 4)
+        carla_float4_store(data+i, carla_float4_mul(carla_float4_load(data+i), m));
+#endif
+    for (; i<count; ++i)
+        data[i] *= multiplier;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// floating-point control (denormals)
+
+/*
+ * Enable or disable flushing of denormal numbers to zero on the calling thread (FTZ and DAZ on SSE, FZ on ARM64).
+ * Returns the previous floating-point control state, to be given back to carla_restoreFloatControl().
+ * Does nothing on other architectures.
+ */
+static inline
+uintptr_t carla_setDenormalsFlushed(const bool flush) noexcept
+{
+#if defined(CARLA_MATH_UTILS_SSE2)
+    const uint csr = _mm_getcsr();
+    _mm_setcsr(flush ? (csr | 0x8040) : (csr & ~0x8040U));
+    return csr;
+#elif defined(__aarch64__)
+    uintptr_t fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    const uintptr_t newfpcr = flush ? (fpcr | (1UL << 24)) : (fpcr & ~(1UL << 24));
+    __asm__ __volatile__("msr fpcr, %0" :: "r"(newfpcr));
+    return fpcr;
+#else
+    return 0;
+    // unused
+    (void)flush;
+#endif
+}
+
+/*
+ * Restore the floating-point control state returned by carla_setDenormalsFlushed().
+ */
+static inline
+void carla_restoreFloatControl(const uintptr_t state) noexcept
+{
+#if defined(CARLA_MATH_UTILS_SSE2)
+    _mm_setcsr(static_cast<uint>(state));
+#elif defined(__aarch64__)
+    __asm__ __volatile__("msr fpcr, %0" :: "r"(state));
+#else
+    return;
+    // unused
+    (void)state;
+#endif
 }
 
 // --------------------------------------------------------------------------------------------------------------------
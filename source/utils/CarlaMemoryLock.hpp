@@ -0,0 +1,229 @@
+/*
+ * Carla memory locking
+ * Copyright (C) 2011-2020 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_MEMORY_LOCK_HPP_INCLUDED
+#define CARLA_MEMORY_LOCK_HPP_INCLUDED
+
+#include "CarlaUtils.hpp"
+
+#ifndef CARLA_OS_WIN
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+// -----------------------------------------------------------------------
+// CarlaMemoryLock class
+
+/*
+ * Process-wide switch for keeping memory used by the audio thread in RAM, see ENGINE_OPTION_LOCK_MEMORY.
+ * Only applies to memory allocated or locked after it is enabled.
+ * Locking works on whole pages and does not nest, so allocate() gives each block pages of its own,
+ * while lock() is meant for big buffers allocated elsewhere, like decoded samples.
+ * Does nothing on Windows.
+ */
+class CarlaMemoryLock
+{
+public:
+    enum Mode {
+        kModeOff = 0,
+        kModeLock = 1,
+        kModeLockHugePages = 2
+    };
+
+    static CarlaMemoryLock& getInstance() noexcept
+    {
+        static CarlaMemoryLock memoryLock;
+        return memoryLock;
+    }
+
+    void setMode(const int mode) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(mode >= kModeOff && mode <= kModeLockHugePages,);
+        fMode = mode;
+    }
+
+    bool isEnabled() const noexcept
+    {
+        return fMode != kModeOff;
+    }
+
+    /*
+     * Total amount of memory currently locked through this class, in bytes.
+     */
+    uint64_t getLockedSize() const noexcept
+    {
+        return __sync_fetch_and_add(const_cast<volatile uint64_t*>(&fLockedSize), 0);
+    }
+
+    /*
+     * Lock existing memory if enabled.
+     * Returns true if locked, unlock() must then be called with the same arguments before freeing it.
+     */
+    bool lock(const void* const ptr, const std::size_t size) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(ptr != nullptr, false);
+
+        if (fMode == kModeOff || size == 0)
+            return false;
+
+#ifndef CARLA_OS_WIN
+        std::size_t pagesSize;
+        void* const pages = getPages(ptr, size, pagesSize);
+
+        return lockPages(pages, pagesSize);
+#else
+        return false;
+#endif
+    }
+
+    void unlock(const void* const ptr, const std::size_t size) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(ptr != nullptr,);
+
+#ifndef CARLA_OS_WIN
+        std::size_t pagesSize;
+        void* const pages = getPages(ptr, size, pagesSize);
+
+        unlockPages(pages, pagesSize);
+#endif
+    }
+
+    /*
+     * Allocate memory, locked if enabled, aligned to 16 bytes.
+     * Must be released with deallocate().
+     */
+    void* allocate(const std::size_t size) noexcept
+    {
+        const std::size_t totalSize = size + kHeaderSize;
+
+#ifndef CARLA_OS_WIN
+        if (fMode != kModeOff)
+        {
+            const std::size_t pageSize = getPageSize();
+            const std::size_t mapSize = (totalSize + pageSize - 1) / pageSize * pageSize;
+
+            void* const mem = ::mmap(nullptr, mapSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+
+            if (mem != MAP_FAILED)
+            {
+                Header* const header = static_cast<Header*>(mem);
+                header->mapSize = mapSize;
+                header->locked  = lockPages(mem, mapSize);
+
+                return static_cast<uint8_t*>(mem) + kHeaderSize;
+            }
+        }
+#endif
+
+        void* const mem = std::malloc(totalSize);
+        CARLA_SAFE_ASSERT_RETURN(mem != nullptr, nullptr);
+
+        Header* const header = static_cast<Header*>(mem);
+        header->mapSize = 0;
+        header->locked  = false;
+
+        return static_cast<uint8_t*>(mem) + kHeaderSize;
+    }
+
+    void deallocate(void* const ptr) noexcept
+    {
+        if (ptr == nullptr)
+            return;
+
+        Header* const header = reinterpret_cast<Header*>(static_cast<uint8_t*>(ptr) - kHeaderSize);
+
+#ifndef CARLA_OS_WIN
+        if (header->mapSize != 0)
+        {
+            const std::size_t mapSize = header->mapSize;
+
+            if (header->locked)
+                unlockPages(header, mapSize);
+
+            ::munmap(header, mapSize);
+            return;
+        }
+#endif
+
+        std::free(header);
+    }
+
+private:
+    struct Header {
+        std::size_t mapSize; // 0 if allocated with malloc
+        bool locked;
+    };
+
+    // keeps the memory after it aligned for SIMD
+    static const std::size_t kHeaderSize = 64;
+
+    volatile int fMode;
+    volatile uint64_t fLockedSize;
+
+    CarlaMemoryLock() noexcept
+        : fMode(kModeOff),
+          fLockedSize(0) {}
+
+#ifndef CARLA_OS_WIN
+    static std::size_t getPageSize() noexcept
+    {
+        static const long pageSize = ::sysconf(_SC_PAGESIZE);
+        return pageSize > 0 ? static_cast<std::size_t>(pageSize) : 4096;
+    }
+
+    static void* getPages(const void* const ptr, const std::size_t size, std::size_t& pagesSize) noexcept
+    {
+        const uintptr_t pageMask = static_cast<uintptr_t>(getPageSize() - 1);
+        const uintptr_t start = reinterpret_cast<uintptr_t>(ptr) & ~pageMask;
+        const uintptr_t end   = (reinterpret_cast<uintptr_t>(ptr) + size + pageMask) & ~pageMask;
+
+        pagesSize = end - start;
+        return reinterpret_cast<void*>(start);
+    }
+
+    bool lockPages(void* const pages, const std::size_t size) noexcept
+    {
+# ifdef MADV_HUGEPAGE
+        // only a hint, needs transparent huge pages enabled in "madvise" or "always" mode
+        if (fMode == kModeLockHugePages)
+            ::madvise(pages, size, MADV_HUGEPAGE);
+# endif
+
+        if (::mlock(pages, size) != 0)
+        {
+            carla_stderr2("CarlaMemoryLock - failed to lock " P_SIZE " bytes, check the memlock limit", size);
+            return false;
+        }
+
+        __sync_add_and_fetch(&fLockedSize, static_cast<uint64_t>(size));
+        return true;
+    }
+
+    void unlockPages(void* const pages, const std::size_t size) noexcept
+    {
+        if (::munlock(pages, size) == 0)
+            __sync_sub_and_fetch(&fLockedSize, static_cast<uint64_t>(size));
+    }
+#endif
+
+    CARLA_PREVENT_HEAP_ALLOCATION
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaMemoryLock)
+};
+
+// -----------------------------------------------------------------------
+
+#endif // CARLA_MEMORY_LOCK_HPP_INCLUDED
@@ -21,6 +21,7 @@
 #include "CarlaUtils.hpp"
 
 #include <pthread.h>
+#include <sys/time.h>
 
 class CarlaSignal;
 
@@ -244,6 +245,43 @@ public:
         pthread_mutex_unlock(&fMutex);
     }
 
+    /*
+     * Wait for a signal, for at most @a msecs milliseconds.
+     * Returns false if the time-out was reached first.
+     */
+    bool wait(const uint msecs) noexcept
+    {
+        timeval now;
+        gettimeofday(&now, nullptr);
+
+        const long nsecs = (now.tv_usec + static_cast<long>(msecs % 1000) * 1000L) * 1000L;
+
+        timespec end;
+        end.tv_sec  = now.tv_sec + static_cast<time_t>(msecs / 1000) + static_cast<time_t>(nsecs / 1000000000L);
+        end.tv_nsec = nsecs % 1000000000L;
+
+        pthread_mutex_lock(&fMutex);
+
+        while (! fTriggered)
+        {
+            int ret;
+
+            try {
+                ret = pthread_cond_timedwait(&fCondition, &fMutex, &end);
+            } CARLA_SAFE_EXCEPTION_BREAK("pthread_cond_timedwait");
+
+            // non-zero means time-out or error, zero can be a spurious wake-up
+            if (ret != 0)
+                break;
+        }
+
+        const bool triggered = fTriggered;
+        fTriggered = false;
+
+        pthread_mutex_unlock(&fMutex);
+        return triggered;
+    }
+
     /*
      * Wake up all waiting threads.
      */
@@ -16,7 +16,10 @@
  */
 
 #include "CarlaPipeUtils.hpp"
+#include "CarlaFloatStringUtils.hpp"
 #include "CarlaProcessUtils.hpp"
+#include "CarlaRingBuffer.hpp"
+#include "CarlaShmUtils.hpp"
 #include "CarlaString.hpp"
 #include "CarlaMIDI.h"
 
@@ -41,6 +44,7 @@
 # include <ctime>
 #else
 # include <cerrno>
+# include <poll.h>
 # include <signal.h>
 # include <sys/wait.h>
 # ifdef CARLA_OS_LINUX
@@ -57,6 +61,84 @@
 # define INVALID_PIPE_VALUE -1
 #endif
 
+// -----------------------------------------------------------------------
+// binary frames, only used if both sides agree on it during startup
+
+static const char     kBinaryFrameMarker     = '\x1b';
+static const uint32_t kBinaryFrameHeaderSize = 1 + sizeof(uint32_t);
+static const uint32_t kReadBufferSize        = 0xffff;
+static const uint32_t kMaxBinaryFrameSize    = kReadBufferSize - kBinaryFrameHeaderSize;
+
+struct CarlaPipeReadBuffer {
+    char     data[kReadBufferSize+1];
+    uint32_t pos;
+    uint32_t len;
+
+    CarlaPipeReadBuffer() noexcept
+        : pos(0),
+          len(0)
+    {
+        carla_zeroChars(data, kReadBufferSize+1);
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(CarlaPipeReadBuffer)
+};
+
+// -----------------------------------------------------------------------
+// shared memory rings, used for control and atom messages once both sides agree on it
+
+#ifdef CARLA_OS_WIN
+# define CARLA_PIPE_SHM_PREFIX "Local\\carla-pipe_shm_"
+#else
+# define CARLA_PIPE_SHM_PREFIX "/crlpipe_shm_"
+#endif
+
+// bigger messages always go through the pipe
+static const uint32_t kMaxRingMessageSize = HugeStackBuffer::size / 4;
+
+struct CarlaPipeSharedData {
+    HugeStackBuffer serverToClient;
+    HugeStackBuffer clientToServer;
+
+    // pipe bytes handled by each side, wake-ups excluded.
+    // a writer only uses its ring when the other side has handled everything sent through the pipe,
+    // so ring messages never overtake pipe messages.
+    uint32_t serverPipeBytesRead;
+    uint32_t clientPipeBytesRead;
+};
+
+class CarlaPipeRingBuffer : public CarlaRingBufferControl<HugeStackBuffer>
+{
+public:
+    CarlaPipeRingBuffer() noexcept
+        : CarlaRingBufferControl<HugeStackBuffer>() {}
+
+    void setBuffer(HugeStackBuffer* const ringBuf, const bool resetBuffer) noexcept
+    {
+        setRingBuffer(ringBuf, resetBuffer);
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaPipeRingBuffer)
+};
+
+// -----------------------------------------------------------------------
+
+static inline
+std::size_t writeBinaryFrameHeader(char* const buf, const uint32_t size) noexcept
+{
+    buf[0] = kBinaryFrameMarker;
+    std::memcpy(buf + 1, &size, sizeof(uint32_t));
+    return kBinaryFrameHeaderSize;
+}
+
+static inline
+std::size_t writeBinaryFrame(char* const buf, const void* const data, const uint32_t size) noexcept
+{
+    writeBinaryFrameHeader(buf, size);
+    std::memcpy(buf + kBinaryFrameHeaderSize, data, size);
+    return kBinaryFrameHeaderSize + size;
+}
+
 #ifdef CARLA_OS_WIN
 // -----------------------------------------------------------------------
 // win32 stuff
@@ -126,6 +208,10 @@ ssize_t ReadFileWin32(const HANDLE pipeh, const HANDLE event, void* const buf, c
     if (::PeekNamedPipe(pipeh, nullptr, 0, nullptr, &available, nullptr) == FALSE || available == 0)
         return -1;
 
+    // never block waiting for more data than what is there
+    if (dsize > available)
+        dsize = available;
+
     OVERLAPPED ov;
     carla_zeroStruct(ov);
     ov.hEvent = event;
@@ -592,9 +678,41 @@ struct CarlaPipeCommon::PrivateData {
     // for debugging
     bool isServer;
 
+    // server side, the client lives in a process not started by us
+    bool clientIsShared;
+
+    // binary frames were negotiated with the other side
+    bool binaryFraming;
+
     // common write lock
     CarlaMutex writeLock;
 
+    // incoming data, read from the pipe in bulk
+    CarlaPipeReadBuffer pipeBuffer;
+
+    // single message taken from the shared memory ring
+    CarlaPipeReadBuffer ringBuffer;
+
+    // buffer used by the read functions, points to one of the above
+    CarlaPipeReadBuffer* readBuf;
+
+    // optional shared memory, with one ring per direction
+    carla_shm_t shm;
+    CarlaPipeSharedData* shmData;
+    CarlaPipeRingBuffer ringSend;
+    CarlaPipeRingBuffer ringRecv;
+
+    // the other side has attached to our shared memory, so ringSend can be used
+    bool ringSendReady;
+
+    // pipe byte counters, see CarlaPipeSharedData
+    uint32_t pipeBytesWritten;
+    uint32_t pipeBytesFilled;
+    uint32_t pipeWakeupBytes;
+
+    // a line bigger than the read buffer is being read into tmpStr
+    bool readingLongLine;
+
     // temporary buffers for _readline()
     mutable char        tmpBuf[0xffff];
     mutable CarlaString tmpStr;
@@ -612,7 +730,21 @@ struct CarlaPipeCommon::PrivateData {
           pipeClosed(true),
           lastMessageFailed(false),
           isServer(false),
+          clientIsShared(false),
+          binaryFraming(false),
           writeLock(),
+          pipeBuffer(),
+          ringBuffer(),
+          readBuf(&pipeBuffer),
+          shm(),
+          shmData(nullptr),
+          ringSend(),
+          ringRecv(),
+          ringSendReady(false),
+          pipeBytesWritten(0),
+          pipeBytesFilled(0),
+          pipeWakeupBytes(0),
+          readingLongLine(false),
           tmpBuf(),
           tmpStr()
     {
@@ -626,6 +758,154 @@ struct CarlaPipeCommon::PrivateData {
 #endif
 
         carla_zeroChars(tmpBuf, 0xffff);
+        carla_shm_init(shm);
+    }
+
+    // move unread data to the start of the pipe buffer and append as much as the pipe has available
+    // returns false if nothing new was read
+    bool fillReadBuffer() noexcept
+    {
+        // ring messages are always complete
+        if (readBuf != &pipeBuffer)
+            return false;
+
+        if (pipeBuffer.pos != 0)
+        {
+            pipeBuffer.len -= pipeBuffer.pos;
+
+            if (pipeBuffer.len != 0)
+                std::memmove(pipeBuffer.data, pipeBuffer.data + pipeBuffer.pos, pipeBuffer.len);
+
+            pipeBuffer.pos = 0;
+        }
+
+        if (pipeBuffer.len == kReadBufferSize)
+            return false;
+
+        ssize_t ret;
+
+        try {
+#ifdef CARLA_OS_WIN
+            ret = ReadFileWin32(pipeRecv, ovRecv, pipeBuffer.data + pipeBuffer.len, kReadBufferSize - pipeBuffer.len);
+#else
+            ret = ::read(pipeRecv, pipeBuffer.data + pipeBuffer.len, kReadBufferSize - pipeBuffer.len);
+#endif
+        } CARLA_SAFE_EXCEPTION_RETURN("CarlaPipeCommon::fillReadBuffer() - read", false);
+
+        if (ret <= 0)
+            return false;
+
+        pipeBuffer.len  += static_cast<uint32_t>(ret);
+        pipeBytesFilled += static_cast<uint32_t>(ret);
+        return true;
+    }
+
+    // let the other side know how much of its pipe data we have handled
+    void updatePipeBytesRead() noexcept
+    {
+        if (shmData == nullptr)
+            return;
+
+        const uint32_t bytesRead = pipeBytesFilled - (pipeBuffer.len - pipeBuffer.pos) - pipeWakeupBytes;
+
+        __sync_synchronize();
+
+        if (isServer)
+            shmData->serverPipeBytesRead = bytesRead;
+        else
+            shmData->clientPipeBytesRead = bytesRead;
+    }
+
+    // check if the other side has handled everything we sent through the pipe
+    bool canWriteToRing() const noexcept
+    {
+        if (! ringSendReady)
+            return false;
+
+        const uint32_t bytesRead = isServer ? shmData->clientPipeBytesRead : shmData->serverPipeBytesRead;
+
+        __sync_synchronize();
+
+        return bytesRead == pipeBytesWritten;
+    }
+
+    bool createSharedMemory(char* const filename) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(shmData == nullptr, false);
+
+        std::strcpy(filename, CARLA_PIPE_SHM_PREFIX "XXXXXX");
+
+        shm = carla_shm_create_temp(filename);
+        CARLA_SAFE_ASSERT_RETURN(carla_is_shm_valid(shm), false);
+
+        if (! carla_shm_map<CarlaPipeSharedData>(shm, shmData))
+        {
+            carla_shm_close(shm);
+            carla_shm_init(shm);
+            return false;
+        }
+
+        ringSend.setBuffer(&shmData->serverToClient, true);
+        ringRecv.setBuffer(&shmData->clientToServer, true);
+        shmData->serverPipeBytesRead = 0;
+        shmData->clientPipeBytesRead = 0;
+        return true;
+    }
+
+    bool attachSharedMemory(const char* const filename) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(shmData == nullptr, false);
+
+        shm = carla_shm_attach(filename);
+        CARLA_SAFE_ASSERT_RETURN(carla_is_shm_valid(shm), false);
+
+        if (! carla_shm_map<CarlaPipeSharedData>(shm, shmData))
+        {
+            carla_shm_close(shm);
+            carla_shm_init(shm);
+            return false;
+        }
+
+        ringSend.setBuffer(&shmData->clientToServer, false);
+        ringRecv.setBuffer(&shmData->serverToClient, false);
+        return true;
+    }
+
+    void closeSharedMemory() noexcept
+    {
+        ringSendReady = false;
+
+        if (shmData == nullptr)
+            return;
+
+        ringSend.setBuffer(nullptr, false);
+        ringRecv.setBuffer(nullptr, false);
+
+        carla_shm_unmap(shm, shmData);
+        shmData = nullptr;
+
+        carla_shm_close(shm);
+        carla_shm_init(shm);
+    }
+
+    // must be called with the pipes closed and write lock held
+    void clearPipeState() noexcept
+    {
+        closeSharedMemory();
+
+        binaryFraming    = false;
+        readingLongLine  = false;
+        pipeBuffer.pos   = 0;
+        pipeBuffer.len   = 0;
+        readBuf          = &pipeBuffer;
+        pipeBytesWritten = 0;
+        pipeBytesFilled  = 0;
+        pipeWakeupBytes  = 0;
+    }
+
+    ~PrivateData() noexcept
+    {
+        closeSharedMemory();
     }
 
     CARLA_DECLARE_NON_COPY_STRUCT(PrivateData)
@@ -657,8 +937,20 @@ void CarlaPipeCommon::idlePipe(const bool onlyOnce) noexcept
 {
     bool readSucess;
 
+    _readRingMessages();
+
     for (;;)
     {
+        // skip binary frames left behind by unhandled messages
+        if (pData->binaryFraming && pData->readBuf->pos != pData->readBuf->len
+            && pData->readBuf->data[pData->readBuf->pos] == kBinaryFrameMarker)
+        {
+            uint32_t size;
+            if (_readBinaryFrame(size) == nullptr)
+                break;
+            continue;
+        }
+
         readSucess = false;
         const char* const msg = _readline(true, 0, readSucess);
 
@@ -667,20 +959,11 @@ void CarlaPipeCommon::idlePipe(const bool onlyOnce) noexcept
         if (msg == nullptr)
             continue;
 
-        pData->isReading = true;
+        // anything written to shared memory before this message must be handled first
+        _readRingMessages();
 
-        if (std::strcmp(msg, "__carla-quit__") == 0)
-        {
-            pData->pipeClosed = true;
-        }
-        else if (! pData->clientClosingDown)
-        {
-            try {
-                msgReceived(msg);
-            } CARLA_SAFE_EXCEPTION("msgReceived");
-        }
-
-        pData->isReading = false;
+        _handleMessage(msg);
+        pData->updatePipeBytesRead();
 
         delete[] msg;
 
@@ -689,6 +972,40 @@ void CarlaPipeCommon::idlePipe(const bool onlyOnce) noexcept
     }
 }
 
+#ifndef CARLA_OS_WIN
+bool CarlaPipeCommon::waitForMessages(const uint32_t timeOutMilliseconds, bool& closed) const noexcept
+{
+    closed = false;
+
+    if (pData->pipeClosed || pData->pipeRecv == INVALID_PIPE_VALUE)
+    {
+        closed = true;
+        return false;
+    }
+
+    pollfd pfd;
+    pfd.fd      = pData->pipeRecv;
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+
+    int ret;
+
+    try {
+        ret = ::poll(&pfd, 1, static_cast<int>(timeOutMilliseconds));
+    } CARLA_SAFE_EXCEPTION_RETURN("CarlaPipeCommon::waitForMessages", false);
+
+    if (ret <= 0)
+        return false;
+
+    // data left behind by a closed pipe still needs to be read
+    if (pfd.revents & POLLIN)
+        return true;
+
+    closed = (pfd.revents & (POLLHUP|POLLERR|POLLNVAL)) != 0;
+    return false;
+}
+#endif
+
 // -------------------------------------------------------------------
 
 void CarlaPipeCommon::lockPipe() const noexcept
@@ -748,6 +1065,14 @@ bool CarlaPipeCommon::readNextLineAsInt(int32_t& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
+    uint32_t size;
+    if (const void* const data = _readBinaryFrame(size))
+    {
+        CARLA_SAFE_ASSERT_UINT2_RETURN(size == sizeof(value), size, sizeof(value), false);
+        std::memcpy(&value, data, sizeof(value));
+        return true;
+    }
+
     if (const char* const msg = _readlineblock(false))
     {
         value = std::atoi(msg);
@@ -761,6 +1086,14 @@ bool CarlaPipeCommon::readNextLineAsUInt(uint32_t& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
+    uint32_t size;
+    if (const void* const data = _readBinaryFrame(size))
+    {
+        CARLA_SAFE_ASSERT_UINT2_RETURN(size == sizeof(value), size, sizeof(value), false);
+        std::memcpy(&value, data, sizeof(value));
+        return true;
+    }
+
     if (const char* const msg = _readlineblock(false))
     {
         const long aslong = std::atol(msg);
@@ -779,6 +1112,14 @@ bool CarlaPipeCommon::readNextLineAsLong(int64_t& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
+    uint32_t size;
+    if (const void* const data = _readBinaryFrame(size))
+    {
+        CARLA_SAFE_ASSERT_UINT2_RETURN(size == sizeof(value), size, sizeof(value), false);
+        std::memcpy(&value, data, sizeof(value));
+        return true;
+    }
+
     if (const char* const msg = _readlineblock(false))
     {
         value = std::atol(msg);
@@ -792,6 +1133,14 @@ bool CarlaPipeCommon::readNextLineAsULong(uint64_t& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
+    uint32_t size;
+    if (const void* const data = _readBinaryFrame(size))
+    {
+        CARLA_SAFE_ASSERT_UINT2_RETURN(size == sizeof(value), size, sizeof(value), false);
+        std::memcpy(&value, data, sizeof(value));
+        return true;
+    }
+
     if (const char* const msg = _readlineblock(false))
     {
         const int64_t asint64 = std::atol(msg);
@@ -810,12 +1159,17 @@ bool CarlaPipeCommon::readNextLineAsFloat(float& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
+    uint32_t size;
+    if (const void* const data = _readBinaryFrame(size))
+    {
+        CARLA_SAFE_ASSERT_UINT2_RETURN(size == sizeof(value), size, sizeof(value), false);
+        std::memcpy(&value, data, sizeof(value));
+        return true;
+    }
+
     if (const char* const msg = _readlineblock(false))
     {
-        {
-            const CarlaScopedLocale csl;
-            value = static_cast<float>(std::atof(msg));
-        }
+        value = carla_stringToFloat(msg);
         return true;
     }
 
@@ -826,12 +1180,17 @@ bool CarlaPipeCommon::readNextLineAsDouble(double& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
+    uint32_t size;
+    if (const void* const data = _readBinaryFrame(size))
+    {
+        CARLA_SAFE_ASSERT_UINT2_RETURN(size == sizeof(value), size, sizeof(value), false);
+        std::memcpy(&value, data, sizeof(value));
+        return true;
+    }
+
     if (const char* const msg = _readlineblock(false))
     {
-        {
-            const CarlaScopedLocale csl;
-            value = std::atof(msg);
-        }
+        value = carla_stringToDouble(msg);
         return true;
     }
 
@@ -854,6 +1213,19 @@ bool CarlaPipeCommon::readNextLineAsString(const char*& value, const bool alloca
     return false;
 }
 
+bool CarlaPipeCommon::readNextBinaryFrame(const void*& data, uint32_t& size) const noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
+
+    if (const void* const frame = _readBinaryFrame(size))
+    {
+        data = frame;
+        return true;
+    }
+
+    return false;
+}
+
 // -------------------------------------------------------------------
 // must be locked before calling
 
@@ -975,19 +1347,29 @@ void CarlaPipeCommon::writeControlMessage(const uint32_t index, const float valu
 
     const CarlaMutexLocker cml(pData->writeLock);
 
-    if (! _writeMsgBuffer("control\n", 8))
-        return;
-
-    std::snprintf(tmpBuf, 0xfe, "%i\n", index);
-    if (! _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf)))
-        return;
+    std::size_t size;
 
+    if (pData->binaryFraming)
+    {
+        std::memcpy(tmpBuf, "control\n", 8);
+        size  = 8;
+        size += writeBinaryFrame(tmpBuf + size, &index, sizeof(index));
+        size += writeBinaryFrame(tmpBuf + size, &value, sizeof(value));
+    }
+    else
     {
-        const CarlaScopedLocale csl;
-        std::snprintf(tmpBuf, 0xfe, "%.12g\n", static_cast<double>(value));
+        std::snprintf(tmpBuf, 0xfe, "control\n%i\n", index);
+        size = std::strlen(tmpBuf);
+
+        size += carla_floatToString(tmpBuf + size, value);
+        tmpBuf[size++] = '\n';
     }
 
-    if (! _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf)))
+    if (_writeRingMessage(tmpBuf, size))
+        return;
+
+    // single write for the whole message
+    if (! _writeMsgBuffer(tmpBuf, size))
         return;
 
     flushMessages();
@@ -1131,6 +1513,32 @@ void CarlaPipeCommon::writeLv2AtomMessage(const uint32_t index, const LV2_Atom*
     tmpBuf[0xfe] = '\0';
 
     const uint32_t atomTotalSize(lv2_atom_total_size(atom));
+
+    if (pData->binaryFraming && atomTotalSize <= kMaxBinaryFrameSize)
+    {
+        std::size_t size;
+
+        const CarlaMutexLocker cml(pData->writeLock);
+
+        std::memcpy(tmpBuf, "atom\n", 5);
+        size  = 5;
+        size += writeBinaryFrame(tmpBuf + size, &index, sizeof(index));
+        size += writeBinaryFrameHeader(tmpBuf + size, atomTotalSize);
+
+        if (_writeRingMessage(tmpBuf, size, atom, atomTotalSize))
+            return;
+
+        if (! _writeMsgBuffer(tmpBuf, size))
+            return;
+
+        // raw atom follows, no need for base64
+        if (! _writeMsgBuffer((const char*)atom, atomTotalSize))
+            return;
+
+        flushMessages();
+        return;
+    }
+
     CarlaString base64atom(CarlaString::asBase64(atom, atomTotalSize));
 
     const CarlaMutexLocker cml(pData->writeLock);
@@ -1158,7 +1566,6 @@ void CarlaPipeCommon::writeLv2AtomMessage(const uint32_t index, const LV2_Atom*
 
 void CarlaPipeCommon::writeLv2UridMessage(const uint32_t urid, const char* const uri) const noexcept
 {
-    CARLA_SAFE_ASSERT_RETURN(urid != 0,);
     CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0',);
 
     char tmpBuf[0xff];
@@ -1186,123 +1593,311 @@ void CarlaPipeCommon::writeLv2UridMessage(const uint32_t urid, const char* const
 // -------------------------------------------------------------------
 
 // internal
-const char* CarlaPipeCommon::_readline(const bool allocReturn, const uint16_t size, bool& readSucess) const noexcept
+void CarlaPipeCommon::_handleMessage(const char* const msg) noexcept
 {
-    CARLA_SAFE_ASSERT_RETURN(pData->pipeRecv != INVALID_PIPE_VALUE, nullptr);
+    pData->isReading = true;
 
-    char    c;
-    char*   ptr = pData->tmpBuf;
-    ssize_t ret = -1;
-    bool tooBig = false;
-
-    pData->tmpStr.clear();
-
-    if (size == 0 || size == 1)
+    if (std::strcmp(msg, "__carla-quit__") == 0)
     {
-        for (int i=0; i<0xfffe; ++i)
+        pData->pipeClosed = true;
+    }
+    else if (std::strcmp(msg, "__carla-binary__") == 0)
+    {
+        if (pData->isServer)
         {
-            try {
-    #ifdef CARLA_OS_WIN
-                ret = ReadFileWin32(pData->pipeRecv, pData->ovRecv, &c, 1);
-    #else
-                ret = ::read(pData->pipeRecv, &c, 1);
-    #endif
-            } CARLA_SAFE_EXCEPTION_BREAK("CarlaPipeCommon::readline() - read");
-
-            if (ret != 1)
-                break;
-
-            if (c == '\n')
+            // client confirmed binary frames, now offer shared memory
+            if (! pData->binaryFraming)
             {
-                *ptr = '\0';
-                break;
-            }
+                pData->binaryFraming = true;
 
-            if (c == '\r')
-                c = '\n';
+                char shmName[64];
 
-            *ptr++ = c;
+                if (pData->createSharedMemory(shmName))
+                {
+                    const CarlaMutexLocker cml(pData->writeLock);
+
+                    if (_writeMsgBuffer("__carla-shm__\n", 14) && writeAndFixMessage(shmName))
+                        flushMessages();
+                }
+            }
+        }
+        // server offers binary frames, confirm before using them ourselves
+        else if (! pData->binaryFraming)
+        {
+            const CarlaMutexLocker cml(pData->writeLock);
 
-            if (i+1 == 0xfffe)
+            if (_writeMsgBuffer("__carla-binary__\n", 17))
             {
-                i = 0;
-                *ptr = '\0';
-                tooBig = true;
-                pData->tmpStr += pData->tmpBuf;
-                ptr = pData->tmpBuf;
+                flushMessages();
+                pData->binaryFraming = true;
             }
         }
     }
-    else
+    else if (std::strcmp(msg, "__carla-shm__") == 0)
     {
-        uint16_t remaining = size;
+        if (pData->isServer)
+        {
+            // client has attached, our side of the ring can be used now
+            const CarlaMutexLocker cml(pData->writeLock);
+            pData->ringSendReady = pData->shmData != nullptr;
+        }
+        else if (const char* const filename = _readlineblock(false))
+        {
+            if (pData->shmData == nullptr && pData->attachSharedMemory(filename))
+            {
+                const CarlaMutexLocker cml(pData->writeLock);
+
+                if (_writeMsgBuffer("__carla-shm__\n", 14))
+                {
+                    flushMessages();
+                    pData->ringSendReady = true;
+                }
+            }
+        }
+    }
+    else if (std::strcmp(msg, "__carla-ring__") == 0)
+    {
+        // wake-up only, ring messages were already handled
+        if (pData->readBuf == &pData->pipeBuffer)
+            pData->pipeWakeupBytes += 15;
+    }
+    else if (! pData->clientClosingDown)
+    {
+        try {
+            msgReceived(msg);
+        } CARLA_SAFE_EXCEPTION("msgReceived");
+    }
+
+    pData->isReading = false;
+}
+
+// internal
+void CarlaPipeCommon::_readRingMessages() noexcept
+{
+    if (pData->shmData == nullptr)
+        return;
+
+    CarlaPipeRingBuffer& ring(pData->ringRecv);
+    bool readSucess;
+
+    while (ring.isDataAvailableForReading())
+    {
+        const uint32_t size = ring.readUInt();
+        CARLA_SAFE_ASSERT_UINT2_BREAK(size != 0 && size <= kMaxRingMessageSize, size, kMaxRingMessageSize);
+
+        // reads from msgReceived() now come from this message only
+        ring.readCustomData(pData->ringBuffer.data, size);
+        pData->ringBuffer.pos = 0;
+        pData->ringBuffer.len = size;
+        pData->readBuf = &pData->ringBuffer;
+
         readSucess = false;
 
-        for (;;)
+        if (const char* const msg = _readline(true, 0, readSucess))
         {
-            try {
-    #ifdef CARLA_OS_WIN
-                ret = ReadFileWin32(pData->pipeRecv, pData->ovRecv, ptr, remaining);
-    #else
-                ret = ::read(pData->pipeRecv, ptr, remaining);
-    #endif
-            } CARLA_SAFE_EXCEPTION_RETURN("CarlaPipeCommon::readline() - read", nullptr);
-
-            if (ret == -1 && errno == EAGAIN)
-                continue;
+            _handleMessage(msg);
+            delete[] msg;
+        }
+
+        pData->readBuf = &pData->pipeBuffer;
+    }
+}
+
+// internal, must be locked before calling
+bool CarlaPipeCommon::_writeRingMessage(const char* const msg, const std::size_t size,
+                                        const void* const extraData, const std::size_t extraSize) const noexcept
+{
+    if (size + extraSize > kMaxRingMessageSize || ! pData->canWriteToRing())
+        return false;
+
+    CarlaPipeRingBuffer& ring(pData->ringSend);
+
+    // the other side drains everything at once, only wake it up when needed
+    const bool wasEmpty = ! ring.isDataAvailableForReading();
+
+    ring.writeUInt(static_cast<uint32_t>(size + extraSize));
+    ring.writeCustomData(msg, static_cast<uint32_t>(size));
+
+    if (extraSize != 0)
+        ring.writeCustomData(extraData, static_cast<uint32_t>(extraSize));
+
+    if (! ring.commitWrite())
+        return false;
+
+    if (wasEmpty && _writeMsgBuffer("__carla-ring__\n", 15))
+    {
+        // wake-ups are not counted, see CarlaPipeSharedData
+        pData->pipeBytesWritten -= 15;
+        flushMessages();
+    }
+
+    return true;
+}
+
+// internal
+static inline
+const char* allocLineCopy(const char* const line, const std::size_t size) noexcept
+{
+    // matches what the old string-based reader returned for empty lines
+    if (size == 0)
+        return nullptr;
+
+    char* ret;
+
+    try {
+        ret = new char[size+1];
+    } CARLA_SAFE_EXCEPTION_RETURN("CarlaPipeCommon::readline() - alloc", nullptr);
+
+    std::memcpy(ret, line, size);
+    ret[size] = '\0';
+    return ret;
+}
+
+// internal
+const char* CarlaPipeCommon::_readline(const bool allocReturn, const uint16_t size, bool& readSucess) const noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(pData->pipeRecv != INVALID_PIPE_VALUE, nullptr);
 
-            CARLA_SAFE_ASSERT_INT2_RETURN(ret > 0, ret, remaining, nullptr);
-            CARLA_SAFE_ASSERT_INT2_RETURN(ret <= (ssize_t)remaining, ret, remaining, nullptr);
+    if (size == 0 || size == 1)
+    {
+        char* line;
+        std::size_t lineSize;
 
-            for (ssize_t i=0; i<ret; ++i)
+        for (;;)
+        {
+            char* const start = pData->readBuf->data + pData->readBuf->pos;
+            const std::size_t available = pData->readBuf->len - pData->readBuf->pos;
+
+            if (char* const end = available != 0 ? static_cast<char*>(std::memchr(start, '\n', available)) : nullptr)
             {
-                if (ptr[i] == '\r')
-                    ptr[i] = '\n';
+                *end = '\0';
+                line = start;
+                lineSize = static_cast<std::size_t>(end - start);
+                pData->readBuf->pos += static_cast<uint32_t>(lineSize + 1);
+                break;
             }
 
-            ptr += ret;
-            *ptr = '\0';
-            remaining = static_cast<uint16_t>(remaining - ret);
-
-            if (remaining != 0)
+            if (pData->fillReadBuffer())
                 continue;
 
-            readSucess = true;
+            if (pData->readBuf->len != kReadBufferSize)
+            {
+                // no complete line yet, keep partial data for the next call
+                return nullptr;
+            }
 
-            if (allocReturn)
+            // line does not fit in the read buffer, move what we have into tmpStr
+            if (! pData->readingLongLine)
             {
-                pData->tmpStr = pData->tmpBuf;
-                return pData->tmpStr.releaseBufferPointer();
+                pData->readingLongLine = true;
+                pData->tmpStr.clear();
             }
 
-            return pData->tmpBuf;
+            for (uint32_t i=0; i<kReadBufferSize; ++i)
+            {
+                if (pData->readBuf->data[i] == '\r')
+                    pData->readBuf->data[i] = '\n';
+            }
+
+            pData->readBuf->data[kReadBufferSize] = '\0';
+            pData->tmpStr += pData->readBuf->data;
+            pData->readBuf->len = 0;
         }
-    }
 
-    if (ptr != pData->tmpBuf)
-    {
-        *ptr = '\0';
+        for (std::size_t i=0; i<lineSize; ++i)
+        {
+            if (line[i] == '\r')
+                line[i] = '\n';
+        }
+
+        readSucess = true;
 
-        if (! allocReturn && ! tooBig)
+        if (pData->readingLongLine)
         {
-            readSucess = true;
-            return pData->tmpBuf;
+            pData->readingLongLine = false;
+            pData->tmpStr += line;
+
+            if (! allocReturn)
+                return pData->tmpStr.buffer();
+
+            const char* const ret = allocLineCopy(pData->tmpStr.buffer(), pData->tmpStr.length());
+            pData->tmpStr.clear();
+            return ret;
         }
 
-        pData->tmpStr += pData->tmpBuf;
+        return allocReturn ? allocLineCopy(line, lineSize) : line;
     }
-    else if (pData->tmpStr.isEmpty() && ret != 1)
+
+    // fixed size read, data can contain line breaks
+    while (pData->readBuf->len - pData->readBuf->pos < size)
     {
-        // some error
-        return nullptr;
+        if (! pData->fillReadBuffer())
+            return nullptr;
+    }
+
+    char* const ptr = pData->tmpBuf;
+    std::memcpy(ptr, pData->readBuf->data + pData->readBuf->pos, size);
+    ptr[size] = '\0';
+    pData->readBuf->pos += size;
+
+    for (uint16_t i=0; i<size; ++i)
+    {
+        if (ptr[i] == '\r')
+            ptr[i] = '\n';
     }
 
     readSucess = true;
 
-    if (! allocReturn && ! tooBig)
-        return pData->tmpBuf;
+    return allocReturn ? allocLineCopy(ptr, size) : ptr;
+}
+
+// internal
+const void* CarlaPipeCommon::_readBinaryFrame(uint32_t& size, const uint32_t timeOutMilliseconds) const noexcept
+{
+    if (! pData->binaryFraming)
+        return nullptr;
+
+    const uint32_t timeoutEnd = water::Time::getMillisecondCounter() + timeOutMilliseconds;
+
+    for (;;)
+    {
+        const char* const start = pData->readBuf->data + pData->readBuf->pos;
+        const uint32_t available = pData->readBuf->len - pData->readBuf->pos;
+
+        if (available != 0)
+        {
+            // next item is a text line
+            if (start[0] != kBinaryFrameMarker)
+                return nullptr;
+
+            if (available >= kBinaryFrameHeaderSize)
+            {
+                uint32_t frameSize;
+                std::memcpy(&frameSize, start + 1, sizeof(uint32_t));
+                CARLA_SAFE_ASSERT_UINT2_RETURN(frameSize <= kMaxBinaryFrameSize, frameSize, kMaxBinaryFrameSize, nullptr);
+
+                if (available >= kBinaryFrameHeaderSize + frameSize)
+                {
+                    pData->readBuf->pos += kBinaryFrameHeaderSize + frameSize;
+                    size = frameSize;
+                    return start + kBinaryFrameHeaderSize;
+                }
+            }
+        }
+
+        if (pData->fillReadBuffer())
+            continue;
+
+        if (water::Time::getMillisecondCounter() >= timeoutEnd)
+            break;
+
+        carla_msleep(5);
+    }
+
+    if (pData->readBuf->len != pData->readBuf->pos)
+        carla_stderr("readBinaryFrame timed out");
 
-    return allocReturn ? pData->tmpStr.releaseBufferPointer() : pData->tmpStr.buffer();
+    return nullptr;
 }
 
 const char* CarlaPipeCommon::_readlineblock(const bool allocReturn,
@@ -1382,6 +1977,8 @@ bool CarlaPipeCommon::_writeMsgBuffer(const char* const msg, const std::size_t s
 
     if (ret == static_cast<ssize_t>(size))
     {
+        pData->pipeBytesWritten += static_cast<uint32_t>(size);
+
         if (pData->lastMessageFailed)
             pData->lastMessageFailed = false;
         return true;
@@ -1400,6 +1997,66 @@ bool CarlaPipeCommon::_writeMsgBuffer(const char* const msg, const std::size_t s
 
 // -----------------------------------------------------------------------
 
+#ifndef CARLA_OS_WIN
+// creates the pipe pairs used by startPipeServer(), with the reading ends set as non-blocking
+// returns an error message on failure, in which case nothing is left open
+static const char* createPipes(int pipe1[2], int pipe2[2], const int size) noexcept
+{
+    if (::pipe(pipe1) != 0)
+        return "pipe1 creation failed";
+
+    if (::pipe(pipe2) != 0)
+    {
+        try { ::close(pipe1[0]); } CARLA_SAFE_EXCEPTION("close(pipe1[0])");
+        try { ::close(pipe1[1]); } CARLA_SAFE_EXCEPTION("close(pipe1[1])");
+        return "pipe2 creation failed";
+    }
+
+    //-----------------------------------------------------------------------------------------------------------------
+    // set size, non-fatal
+
+# ifdef CARLA_OS_LINUX
+    try {
+        ::fcntl(pipe2[0], F_SETPIPE_SZ, size);
+    } CARLA_SAFE_EXCEPTION("Set pipe size");
+
+    try {
+        ::fcntl(pipe1[0], F_SETPIPE_SZ, size);
+    } CARLA_SAFE_EXCEPTION("Set pipe size");
+# else
+    // unused
+    (void)size;
+# endif
+
+    //-----------------------------------------------------------------------------------------------------------------
+    // set non-block
+
+    int ret;
+
+    try {
+        ret = ::fcntl(pipe2[0], F_SETFL, ::fcntl(pipe2[0], F_GETFL) | O_NONBLOCK);
+
+        if (ret == 0)
+            ret = ::fcntl(pipe1[0], F_SETFL, ::fcntl(pipe1[0], F_GETFL) | O_NONBLOCK);
+    } catch (...) {
+        ret = -1;
+    }
+
+    if (ret < 0)
+    {
+        try { ::close(pipe1[0]); } CARLA_SAFE_EXCEPTION("close(pipe1[0])");
+        try { ::close(pipe1[1]); } CARLA_SAFE_EXCEPTION("close(pipe1[1])");
+        try { ::close(pipe2[0]); } CARLA_SAFE_EXCEPTION("close(pipe2[0])");
+        try { ::close(pipe2[1]); } CARLA_SAFE_EXCEPTION("close(pipe2[1])");
+        return "failed to set pipe as non-block";
+    }
+
+    return nullptr;
+}
+#endif
+
+// -----------------------------------------------------------------------
+
 CarlaPipeServer::CarlaPipeServer() noexcept
     : CarlaPipeCommon()
 {
@@ -1501,17 +2158,9 @@ bool CarlaPipeServer::startPipeServer(const char* const filename,
     int pipe1[2]; // read by server, written by client
     int pipe2[2]; // read by client, written by server
 
-    if (::pipe(pipe1) != 0)
+    if (const char* const error = createPipes(pipe1, pipe2, size))
     {
-        fail("pipe1 creation failed");
-        return false;
-    }
-
-    if (::pipe(pipe2) != 0)
-    {
-        try { ::close(pipe1[0]); } CARLA_SAFE_EXCEPTION("close(pipe1[0])");
-        try { ::close(pipe1[1]); } CARLA_SAFE_EXCEPTION("close(pipe1[1])");
-        fail("pipe2 creation failed");
+        fail(error);
         return false;
     }
 
@@ -1524,50 +2173,6 @@ bool CarlaPipeServer::startPipeServer(const char* const filename,
     std::snprintf(pipeSendServerStr, 100, "%i", pipeSendServer);
     std::snprintf(pipeRecvClientStr, 100, "%i", pipeRecvClient);
     std::snprintf(pipeSendClientStr, 100, "%i", pipeSendClient);
-
-    //-----------------------------------------------------------------------------------------------------------------
-    // set size, non-fatal
-
-# ifdef CARLA_OS_LINUX
-    try {
-        ::fcntl(pipeRecvClient, F_SETPIPE_SZ, size);
-    } CARLA_SAFE_EXCEPTION("Set pipe size");
-
-    try {
-        ::fcntl(pipeRecvServer, F_SETPIPE_SZ, size);
-    } CARLA_SAFE_EXCEPTION("Set pipe size");
-# endif
-
-    //-----------------------------------------------------------------------------------------------------------------
-    // set non-block
-
-    int ret;
-
-    try {
-        ret = ::fcntl(pipeRecvClient, F_SETFL, ::fcntl(pipeRecvClient, F_GETFL) | O_NONBLOCK);
-    } catch (...) {
-        ret = -1;
-        fail("failed to set pipe as non-block");
-    }
-
-    if (ret == 0)
-    {
-        try {
-            ret = ::fcntl(pipeRecvServer, F_SETFL, ::fcntl(pipeRecvServer, F_GETFL) | O_NONBLOCK);
-        } catch (...) {
-            ret = -1;
-            fail("failed to set pipe as non-block");
-        }
-    }
-
-    if (ret < 0)
-    {
-        try { ::close(pipe1[0]); } CARLA_SAFE_EXCEPTION("close(pipe1[0])");
-        try { ::close(pipe1[1]); } CARLA_SAFE_EXCEPTION("close(pipe1[1])");
-        try { ::close(pipe2[0]); } CARLA_SAFE_EXCEPTION("close(pipe2[0])");
-        try { ::close(pipe2[1]); } CARLA_SAFE_EXCEPTION("close(pipe2[1])");
-        return false;
-    }
 #endif
 
     //-----------------------------------------------------------------------------------------------------------------
@@ -1653,6 +2258,10 @@ bool CarlaPipeServer::startPipeServer(const char* const filename,
         pData->pipeSend = pipeSendClient;
         pData->pipeClosed = false;
         carla_stdout("ALL OK!");
+
+        // offer binary frames, only used after the client confirms
+        if (_writeMsgBuffer("__carla-binary__\n", 17))
+            flushMessages();
         return true;
     }
 
@@ -1698,6 +2307,59 @@ bool CarlaPipeServer::startPipeServer(const char* const filename,
     (void)size; (void)ovRecv; (void)process;
 }
 
+#ifndef CARLA_OS_WIN
+bool CarlaPipeServer::startPipeServerWithSharedClient(const SendClientPipesFunc sendFunc, void* const ptr,
+                                                      const int size) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(pData->pipeRecv == INVALID_PIPE_VALUE, false);
+    CARLA_SAFE_ASSERT_RETURN(pData->pipeSend == INVALID_PIPE_VALUE, false);
+    CARLA_SAFE_ASSERT_RETURN(pData->pid == -1, false);
+    CARLA_SAFE_ASSERT_RETURN(sendFunc != nullptr, false);
+    carla_debug("CarlaPipeServer::startPipeServerWithSharedClient(%p, %p)", sendFunc, ptr);
+
+    const CarlaMutexLocker cml(pData->writeLock);
+
+    int pipe1[2]; // read by client, written by server
+    int pipe2[2]; // read by server, written by client
+
+    if (const char* const error = createPipes(pipe1, pipe2, size))
+    {
+        fail(error);
+        return false;
+    }
+
+    bool sent;
+
+    try {
+        sent = sendFunc(ptr, pipe1[0], pipe2[1]);
+    } CARLA_SAFE_EXCEPTION_RETURN("startPipeServerWithSharedClient sendFunc", false);
+
+    // the client process has its own copies now
+    try { ::close(pipe1[0]); } CARLA_SAFE_EXCEPTION("close(pipe1[0])");
+    try { ::close(pipe2[1]); } CARLA_SAFE_EXCEPTION("close(pipe2[1])");
+
+    if (sent && waitForClientFirstMessage(pipe2[0], nullptr, nullptr, 10*1000 /* 10 secs */))
+    {
+        pData->pipeRecv = pipe2[0];
+        pData->pipeSend = pipe1[1];
+        pData->pipeClosed = false;
+        pData->clientIsShared = true;
+
+        // offer binary frames, only used after the client confirms
+        if (_writeMsgBuffer("__carla-binary__\n", 17))
+            flushMessages();
+        return true;
+    }
+
+    if (! sent)
+        fail("failed to send pipes to client process");
+
+    try { ::close(pipe2[0]); } CARLA_SAFE_EXCEPTION("close(pipe2[0])");
+    try { ::close(pipe1[1]); } CARLA_SAFE_EXCEPTION("close(pipe1[1])");
+    return false;
+}
+#endif
+
 void CarlaPipeServer::stopPipeServer(const uint32_t timeOutMilliseconds) noexcept
 {
     carla_debug("CarlaPipeServer::stopPipeServer(%i)", timeOutMilliseconds);
@@ -1734,6 +2396,17 @@ void CarlaPipeServer::stopPipeServer(const uint32_t timeOutMilliseconds) noexcep
         waitForChildToStopOrKillIt(pData->pid, timeOutMilliseconds);
         pData->pid = -1;
     }
+    else if (pData->clientIsShared)
+    {
+        // the process is not ours, only tell the client to go away
+        const CarlaMutexLocker cml(pData->writeLock);
+
+        if (pData->pipeSend != INVALID_PIPE_VALUE && ! pData->pipeClosed)
+        {
+            if (_writeMsgBuffer("__carla-quit__\n", 15))
+                flushMessages();
+        }
+    }
 #endif
 
     closePipeServer();
@@ -1770,6 +2443,9 @@ void CarlaPipeServer::closePipeServer() noexcept
 #endif
         pData->pipeSend = INVALID_PIPE_VALUE;
     }
+
+    pData->clientIsShared = false;
+    pData->clearPipeState();
 }
 
 void CarlaPipeServer::writeShowMessage() const noexcept
@@ -1874,6 +2550,29 @@ bool CarlaPipeClient::initPipeClient(const char* argv[]) noexcept
     return true;
 }
 
+#ifndef CARLA_OS_WIN
+bool CarlaPipeClient::initPipeClient(const int pipeRecv, const int pipeSend) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(pData->pipeRecv == INVALID_PIPE_VALUE, false);
+    CARLA_SAFE_ASSERT_RETURN(pData->pipeSend == INVALID_PIPE_VALUE, false);
+    CARLA_SAFE_ASSERT_RETURN(pipeRecv > 0, false);
+    CARLA_SAFE_ASSERT_RETURN(pipeSend > 0, false);
+    carla_debug("CarlaPipeClient::initPipeClient(%i, %i)", pipeRecv, pipeSend);
+
+    const CarlaMutexLocker cml(pData->writeLock);
+
+    pData->pipeRecv = pipeRecv;
+    pData->pipeSend = pipeSend;
+    pData->pipeClosed = false;
+    pData->clientClosingDown = false;
+
+    if (writeMessage("\n", 1))
+        flushMessages();
+
+    return true;
+}
+#endif
+
 void CarlaPipeClient::closePipeClient() noexcept
 {
     carla_debug("CarlaPipeClient::closePipeClient()");
@@ -1901,6 +2600,8 @@ void CarlaPipeClient::closePipeClient() noexcept
 #endif
         pData->pipeSend = INVALID_PIPE_VALUE;
     }
+
+    pData->clearPipeState();
 }
 
 void CarlaPipeClient::writeExitingMessageAndWait() noexcept
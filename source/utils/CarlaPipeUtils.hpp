@@ -71,6 +71,16 @@ public:
      */
     void idlePipe(bool onlyOnce = false) noexcept;
 
+#ifndef CARLA_OS_WIN
+    /*!
+     * Wait until the other side sends something, for at most @a timeOutMilliseconds.
+     * Returns false on time-out, or when the other side has closed its end, in which case @a closed is set to true.
+     * Does not read anything, so it can be called from another thread to know when idlePipe() has work to do.
+     * The pipe must not be closed while waiting.
+     */
+    bool waitForMessages(uint32_t timeOutMilliseconds, bool& closed) const noexcept;
+#endif
+
     // -------------------------------------------------------------------
     // write lock
 
@@ -144,6 +154,13 @@ public:
      */
     bool readNextLineAsString(const char*& value, bool allocateString, uint32_t size = 0) const noexcept;
 
+    /*!
+     * Read the next binary frame, if the other side sent one.
+     * Returns false without reading anything if the next item is a text line.
+     * @note: @a data is only valid until the next read.
+     */
+    bool readNextBinaryFrame(const void*& data, uint32_t& size) const noexcept;
+
     // -------------------------------------------------------------------
     // write messages, must be locked before calling
 
@@ -224,6 +241,7 @@ public:
 
     /*!
      * Write an lv2 "urid" message.
+     * A @a urid of 0 asks the other side for the URID of @a uri, which it sends back as another "urid" message.
      */
     void writeLv2UridMessage(uint32_t urid, const char* uri) const noexcept;
 
@@ -241,9 +259,22 @@ protected:
     /*! @internal */
     const char* _readlineblock(bool allocReturn, uint16_t size = 0, uint32_t timeOutMilliseconds = 50) const noexcept;
 
+    /*! @internal */
+    const void* _readBinaryFrame(uint32_t& size, uint32_t timeOutMilliseconds = 50) const noexcept;
+
     /*! @internal */
     bool _writeMsgBuffer(const char* msg, std::size_t size) const noexcept;
 
+    /*! @internal */
+    bool _writeRingMessage(const char* msg, std::size_t size,
+                           const void* extraData = nullptr, std::size_t extraSize = 0) const noexcept;
+
+    /*! @internal */
+    void _handleMessage(const char* msg) noexcept;
+
+    /*! @internal */
+    void _readRingMessages() noexcept;
+
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaPipeCommon)
 };
 
@@ -276,6 +307,22 @@ public:
      */
     bool startPipeServer(const char* const filename, const char* const arg1, const char* const arg2, const int size = -1) noexcept;
 
+#ifndef CARLA_OS_WIN
+    /*!
+     * Function used to hand the client side of the pipes over to an already running process.
+     * The file descriptors are closed after it returns, so they need to be duplicated or sent to the process.
+     */
+    typedef bool (*SendClientPipesFunc)(void* ptr, int pipeRecv, int pipeSend);
+
+    /*!
+     * Start the pipe server for a client living in an already running process, such as a shared UI host.
+     * The process is not owned by this pipe server, stopping it only asks the client to quit.
+     * @see CarlaPipeClient::initPipeClient(int, int)
+     * @see fail()
+     */
+    bool startPipeServerWithSharedClient(SendClientPipesFunc sendFunc, void* ptr, const int size = -1) noexcept;
+#endif
+
     /*!
      * Stop the pipe server.
      * This will send a quit message to the client, wait for it to close for @a timeOutMilliseconds, and close the pipes.
@@ -330,6 +377,14 @@ public:
      */
     bool initPipeClient(const char* argv[]) noexcept;
 
+#ifndef CARLA_OS_WIN
+    /*!
+     * Initialize pipes received as open file descriptors, owned by this client from now on.
+     * @see CarlaPipeServer::startPipeServerWithSharedClient()
+     */
+    bool initPipeClient(int pipeRecv, int pipeSend) noexcept;
+#endif
+
     /*!
      * Close the pipes.
      */
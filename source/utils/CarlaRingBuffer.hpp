@@ -1,6 +1,6 @@
 /*
  * Carla Ring Buffer
- * Copyright (C) 2013-2018 Filipe Coelho <falktx@falktx.com>
+ * Copyright (C) 2013-2020 Filipe Coelho <falktx@falktx.com>
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU General Public License as
@@ -20,6 +20,8 @@
 
 #include "CarlaMathUtils.hpp"
 
+#include <algorithm>
+
 // -----------------------------------------------------------------------
 // Buffer structs
 
@@ -41,13 +43,23 @@
    invalidateCommit:
     boolean used to check if a write operation failed.
     this ensures we don't get incomplete writes.
+
+   The values written by the producer (head, wrtn and invalidateCommit) and the one written by the consumer (tail)
+   are padded to separate cache lines, so that both sides do not invalidate each other's cache on every update.
+   The stack buffers are shared between the host and bridge processes, changing their layout requires a bump of
+   CARLA_PLUGIN_BRIDGE_API_VERSION_MINIMUM.
   */
 
+#define CARLA_RING_BUFFER_CACHE_LINE_SIZE 64
+
 struct HeapBuffer {
+    uint8_t* buf;
     uint32_t size;
-    uint32_t head, tail, wrtn;
+    uint8_t  _pad1[CARLA_RING_BUFFER_CACHE_LINE_SIZE - sizeof(uint8_t*) - sizeof(uint32_t)];
+    uint32_t head, wrtn;
     bool     invalidateCommit;
-    uint8_t* buf;
+    uint8_t  _pad2[CARLA_RING_BUFFER_CACHE_LINE_SIZE - 2*sizeof(uint32_t) - sizeof(bool)];
+    uint32_t tail;
 
     void copyDataFrom(const HeapBuffer& rb) noexcept
     {
@@ -63,28 +75,37 @@ struct HeapBuffer {
 
 struct SmallStackBuffer {
     static const uint32_t size = 4096;
-    uint32_t head, tail, wrtn;
+    uint32_t head, wrtn;
     bool     invalidateCommit;
+    uint8_t  _pad1[CARLA_RING_BUFFER_CACHE_LINE_SIZE - 2*sizeof(uint32_t) - sizeof(bool)];
+    uint32_t tail;
+    uint8_t  _pad2[CARLA_RING_BUFFER_CACHE_LINE_SIZE - sizeof(uint32_t)];
     uint8_t  buf[size];
 };
 
 struct BigStackBuffer {
     static const uint32_t size = 16384;
-    uint32_t head, tail, wrtn;
+    uint32_t head, wrtn;
     bool     invalidateCommit;
+    uint8_t  _pad1[CARLA_RING_BUFFER_CACHE_LINE_SIZE - 2*sizeof(uint32_t) - sizeof(bool)];
+    uint32_t tail;
+    uint8_t  _pad2[CARLA_RING_BUFFER_CACHE_LINE_SIZE - sizeof(uint32_t)];
     uint8_t  buf[size];
 };
 
 struct HugeStackBuffer {
     static const uint32_t size = 65536;
-    uint32_t head, tail, wrtn;
+    uint32_t head, wrtn;
     bool     invalidateCommit;
+    uint8_t  _pad1[CARLA_RING_BUFFER_CACHE_LINE_SIZE - 2*sizeof(uint32_t) - sizeof(bool)];
+    uint32_t tail;
+    uint8_t  _pad2[CARLA_RING_BUFFER_CACHE_LINE_SIZE - sizeof(uint32_t)];
     uint8_t  buf[size];
 };
 
 #ifdef CARLA_PROPER_CPP11_SUPPORT
-# define HeapBuffer_INIT  {0, 0, 0, 0, false, nullptr}
-# define StackBuffer_INIT {0, 0, 0, false, {0}}
+# define HeapBuffer_INIT  {nullptr, 0, {0}, 0, 0, false, {0}, 0}
+# define StackBuffer_INIT {0, 0, false, {0}, 0, {0}, {0}}
 #else
 # define HeapBuffer_INIT
 # define StackBuffer_INIT
@@ -158,6 +179,21 @@ public:
         return wrap + fBuffer->tail - fBuffer->wrtn;
     }
 
+    uint32_t getReadableDataSize() const noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(fBuffer != nullptr, 0);
+
+        const uint32_t head(fBuffer->head);
+        const uint32_t tail(fBuffer->tail);
+
+        if (head == tail)
+            return 0;
+
+        const uint32_t wrap((head > tail) ? 0 : fBuffer->size);
+
+        return wrap + head - tail;
+    }
+
     // -------------------------------------------------------------------
 
     bool readBool() noexcept
@@ -236,6 +272,30 @@ public:
             std::memset(&type, 0, sizeof(T));
     }
 
+    /*
+     * Read as much data as available, up to maxSize bytes, moving the read position only once.
+     * Returns the number of bytes read.
+     */
+    uint32_t readBulkData(void* const data, const uint32_t maxSize) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(fBuffer != nullptr, 0);
+        CARLA_SAFE_ASSERT_RETURN(fBuffer->buf != nullptr, 0);
+        CARLA_SAFE_ASSERT_RETURN(data != nullptr, 0);
+
+        const uint32_t head(fBuffer->head);
+        const uint32_t tail(fBuffer->tail);
+
+        if (head == tail || maxSize == 0)
+            return 0;
+
+        const uint32_t wrap((head > tail) ? 0 : fBuffer->size);
+        const uint32_t size(std::min(maxSize, wrap + head - tail));
+
+        fBuffer->tail = copyFromBuffer(static_cast<uint8_t*>(data), tail, size);
+        fErrorReading = false;
+        return size;
+    }
+
     // -------------------------------------------------------------------
 
     bool writeBool(const bool value) noexcept
@@ -302,6 +362,30 @@ public:
         return tryWrite(&type, sizeof(T));
     }
 
+    /*
+     * Write as much data as there is space for, up to size bytes.
+     * Returns the number of bytes written, which like any other write only becomes visible after commitWrite().
+     */
+    uint32_t writeBulkData(const void* const data, const uint32_t size) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(fBuffer != nullptr, 0);
+        CARLA_SAFE_ASSERT_RETURN(data != nullptr, 0);
+
+        const uint32_t tail(fBuffer->tail);
+        const uint32_t wrtn(fBuffer->wrtn);
+        const uint32_t wrap((tail > wrtn) ? 0 : fBuffer->size);
+        const uint32_t space(wrap + tail - wrtn);
+
+        // one byte always stays free, otherwise a full buffer would look empty
+        if (space <= 1 || size == 0)
+            return 0;
+
+        const uint32_t written(std::min(size, space - 1));
+
+        fBuffer->wrtn = copyToBuffer(static_cast<const uint8_t*>(data), wrtn, written);
+        return written;
+    }
+
     // -------------------------------------------------------------------
 
 protected:
@@ -345,32 +429,7 @@ protected:
             return false;
         }
 
-        uint32_t readto(tail + size);
-
-        if (readto > fBuffer->size)
-        {
-            readto -= fBuffer->size;
-
-            if (size == 1)
-            {
-                std::memcpy(bytebuf, fBuffer->buf + tail, 1);
-            }
-            else
-            {
-                const uint32_t firstpart(fBuffer->size - tail);
-                std::memcpy(bytebuf, fBuffer->buf + tail, firstpart);
-                std::memcpy(bytebuf + firstpart, fBuffer->buf, readto);
-            }
-        }
-        else
-        {
-            std::memcpy(bytebuf, fBuffer->buf + tail, size);
-
-            if (readto == fBuffer->size)
-                readto = 0;
-        }
-
-        fBuffer->tail = readto;
+        fBuffer->tail = copyFromBuffer(bytebuf, tail, size);
         fErrorReading = false;
         return true;
     }
@@ -399,6 +458,45 @@ protected:
             return false;
         }
 
+        fBuffer->wrtn = copyToBuffer(bytebuf, wrtn, size);
+        return true;
+    }
+
+private:
+    // copies size bytes starting at tail, returns the new read position
+    uint32_t copyFromBuffer(uint8_t* const bytebuf, const uint32_t tail, const uint32_t size) const noexcept
+    {
+        uint32_t readto(tail + size);
+
+        if (readto > fBuffer->size)
+        {
+            readto -= fBuffer->size;
+
+            if (size == 1)
+            {
+                std::memcpy(bytebuf, fBuffer->buf + tail, 1);
+            }
+            else
+            {
+                const uint32_t firstpart(fBuffer->size - tail);
+                std::memcpy(bytebuf, fBuffer->buf + tail, firstpart);
+                std::memcpy(bytebuf + firstpart, fBuffer->buf, readto);
+            }
+        }
+        else
+        {
+            std::memcpy(bytebuf, fBuffer->buf + tail, size);
+
+            if (readto == fBuffer->size)
+                readto = 0;
+        }
+
+        return readto;
+    }
+
+    // copies size bytes starting at wrtn, returns the new write position
+    uint32_t copyToBuffer(const uint8_t* const bytebuf, const uint32_t wrtn, const uint32_t size) noexcept
+    {
         uint32_t writeto(wrtn + size);
 
         if (writeto > fBuffer->size)
@@ -424,11 +522,9 @@ protected:
                 writeto = 0;
         }
 
-        fBuffer->wrtn = writeto;
-        return true;
+        return writeto;
     }
 
-private:
     BufferStruct* fBuffer;
 
     // wherever read/write errors have been printed to terminal
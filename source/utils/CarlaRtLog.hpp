@@ -0,0 +1,191 @@
+/*
+ * Carla realtime-safe log
+ * Copyright (C) 2011-2020 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_RT_LOG_HPP_INCLUDED
+#define CARLA_RT_LOG_HPP_INCLUDED
+
+#include "CarlaMutex.hpp"
+
+#include <cstdarg>
+#include <ctime>
+
+// -----------------------------------------------------------------------
+// CarlaRtLog class
+
+/*
+ * Process-wide log ring for messages coming from the audio thread.
+ * Writers format into a fixed-size slot and never block nor allocate, if the ring is busy or full the message is
+ * dropped and counted instead. The non-realtime side calls flush() regularly, see CarlaEngineThread and CarlaLogThread.
+ */
+class CarlaRtLog
+{
+public:
+    static const uint kMaxMessages        = 64;
+    static const uint kMaxMessageSize     = 256;
+    static const uint kMaxMessagesPerSite = 4;
+
+    /*
+     * Per call-site limiter, lets through at most kMaxMessagesPerSite messages per second.
+     */
+    struct Limiter {
+        uint period;
+        uint count;
+
+        bool check() noexcept
+        {
+            const uint curPeriod = getInstance().fPeriod;
+
+            if (period != curPeriod)
+            {
+                period = curPeriod;
+                count  = 0;
+            }
+
+            if (count >= kMaxMessagesPerSite)
+                return false;
+
+            ++count;
+            return true;
+        }
+    };
+
+    static CarlaRtLog& getInstance() noexcept
+    {
+        static CarlaRtLog log;
+        return log;
+    }
+
+    /*
+     * Add a message to the ring, realtime safe.
+     */
+    void write(const bool isError, const char* const fmt, ...) noexcept
+    {
+        if (! fWriteMutex.tryLock())
+        {
+            __sync_add_and_fetch(&fDropped, 1);
+            return;
+        }
+
+        const uint writePos = fWritePos;
+
+        if (writePos - __sync_fetch_and_add(&fReadPos, 0) >= kMaxMessages)
+        {
+            fWriteMutex.unlock();
+            __sync_add_and_fetch(&fDropped, 1);
+            return;
+        }
+
+        Message& msg(fMessages[writePos % kMaxMessages]);
+        msg.isError = isError;
+
+        ::va_list args;
+        ::va_start(args, fmt);
+        std::vsnprintf(msg.text, kMaxMessageSize, fmt, args);
+        ::va_end(args);
+
+        __sync_synchronize();
+        fWritePos = writePos + 1;
+
+        fWriteMutex.unlock();
+    }
+
+    /*
+     * Print all pending messages, must not be called from the audio thread.
+     */
+    void flush() noexcept
+    {
+        if (! fReadMutex.tryLock())
+            return;
+
+        const std::time_t now = std::time(nullptr);
+
+        if (now != fLastTime)
+        {
+            fLastTime = now;
+            __sync_add_and_fetch(&fPeriod, 1);
+        }
+
+        const uint writePos = __sync_fetch_and_add(&fWritePos, 0);
+
+        for (uint readPos = fReadPos; readPos != writePos; ++readPos)
+        {
+            const Message& msg(fMessages[readPos % kMaxMessages]);
+
+            if (msg.isError)
+                carla_stderr2("%s", msg.text);
+            else
+                carla_stdout("%s", msg.text);
+
+            __sync_synchronize();
+            fReadPos = readPos + 1;
+        }
+
+        if (const uint dropped = __sync_lock_test_and_set(&fDropped, 0))
+            carla_stderr2("%u realtime log messages were dropped", dropped);
+
+        fReadMutex.unlock();
+    }
+
+private:
+    struct Message {
+        bool isError;
+        char text[kMaxMessageSize];
+    };
+
+    Message fMessages[kMaxMessages];
+    CarlaMutex fWriteMutex;
+    CarlaMutex fReadMutex;
+    volatile uint fWritePos;
+    volatile uint fReadPos;
+    volatile uint fDropped;
+    volatile uint fPeriod;
+    std::time_t fLastTime;
+
+    CarlaRtLog() noexcept
+        : fMessages(),
+          fWriteMutex(false),
+          fReadMutex(false),
+          fWritePos(0),
+          fReadPos(0),
+          fDropped(0),
+          fPeriod(0),
+          fLastTime(0) {}
+
+    CARLA_PREVENT_HEAP_ALLOCATION
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaRtLog)
+};
+
+// -----------------------------------------------------------------------
+// Realtime safe, rate-limited versions of carla_stdout and carla_stderr2
+
+#define carla_rt_stdout(...)                                              \
+    do {                                                                  \
+        static CarlaRtLog::Limiter _carla_rt_limiter = { 0, 0 };          \
+        if (_carla_rt_limiter.check())                                    \
+            CarlaRtLog::getInstance().write(false, __VA_ARGS__);          \
+    } while (0)
+
+#define carla_rt_stderr2(...)                                             \
+    do {                                                                  \
+        static CarlaRtLog::Limiter _carla_rt_limiter = { 0, 0 };          \
+        if (_carla_rt_limiter.check())                                    \
+            CarlaRtLog::getInstance().write(true, __VA_ARGS__);           \
+    } while (0)
+
+// -----------------------------------------------------------------------
+
+#endif // CARLA_RT_LOG_HPP_INCLUDED
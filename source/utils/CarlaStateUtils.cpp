@@ -18,14 +18,14 @@
 #include "CarlaStateUtils.hpp"
 
 #include "CarlaBackendUtils.hpp"
+#include "CarlaBase64Utils.hpp"
+#include "CarlaFloatStringUtils.hpp"
 #include "CarlaMathUtils.hpp"
 #include "CarlaMIDI.h"
 
 #include "water/streams/MemoryOutputStream.h"
 #include "water/xml/XmlElement.h"
 
-#include <string>
-
 using water::MemoryOutputStream;
 using water::String;
 using water::XmlElement;
@@ -55,48 +55,25 @@ static void getNewLineSplittedString(MemoryOutputStream& stream, const String& s
 }
 
 // -----------------------------------------------------------------------
-// xmlSafeStringFast
-
-/* Based on some code by James Kanze from stackoverflow
- * https://stackoverflow.com/questions/7724011/in-c-whats-the-fastest-way-to-replace-all-occurrences-of-a-substring-within */
+// writeXmlSafeString
 
-static std::string replaceStdString(const std::string& original, const std::string& before, const std::string& after)
+// escapes straight into the stream, used for custom data values which can be several megabytes
+static void writeXmlSafeString(MemoryOutputStream& stream, const char* const cstring)
 {
-    std::string::const_iterator current = original.begin(), end = original.end(), next;
-    std::string retval;
-
-    for (; (next = std::search(current, end, before.begin(), before.end())) != end;)
+    for (const char* s = cstring;;)
     {
-        retval.append(current, next);
-        retval.append(after);
-        current = next + static_cast<ssize_t>(before.size());
-    }
-    retval.append(current, next);
-    return retval;
-}
+        const std::size_t run = std::strcspn(s, kXmlSpecialChars);
 
-static std::string xmlSafeStringFast(const char* const cstring, const bool toXml)
-{
-    std::string string(cstring);
+        if (run != 0)
+            stream.write(s, run);
 
-    if (toXml)
-    {
-        string = replaceStdString(string, "&","&amp;");
-        string = replaceStdString(string, "<","&lt;");
-        string = replaceStdString(string, ">","&gt;");
-        string = replaceStdString(string, "'","&apos;");
-        string = replaceStdString(string, "\"","&quot;");
-    }
-    else
-    {
-        string = replaceStdString(string, "&lt;","<");
-        string = replaceStdString(string, "&gt;",">");
-        string = replaceStdString(string, "&apos;","'");
-        string = replaceStdString(string, "&quot;","\"");
-        string = replaceStdString(string, "&amp;","&");
-    }
+        s += run;
+
+        if (*s == '\0')
+            break;
 
-    return string;
+        stream << xmlEntityForChar(*s++);
+    }
 }
 
 // -----------------------------------------------------------------------
@@ -114,6 +91,74 @@ static const char* xmlSafeStringCharDup(const String& string, const bool toXml)
     return carla_strdup(xmlSafeString(string, toXml).toRawUTF8());
 }
 
+// -----------------------------------------------------------------------
+// compact parameter values, one "index [symbol] value" line each
+
+static bool canWriteCompactParameter(const CarlaStateSave::Parameter* const stateParameter) noexcept
+{
+    if (stateParameter->dummy)
+        return false;
+
+#ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
+    if (stateParameter->mappedControlIndex > CONTROL_INDEX_NONE && stateParameter->mappedControlIndex <= CONTROL_INDEX_MAX_ALLOWED)
+        return false;
+#endif
+
+    return stateParameter->symbol == nullptr || std::strpbrk(stateParameter->symbol, " \t\r\n") == nullptr;
+}
+
+static void readCompactParameters(CarlaStateSave::ParameterList& parameters, const char* const text)
+{
+    static const char* const kSpaces = " \t\r\n";
+
+    for (const char* line = text; *line != '\0';)
+    {
+        const char* const lineEnd = line + std::strcspn(line, "\n");
+        const char* tokens[3];
+        std::size_t tokenLengths[3];
+        uint numTokens = 0;
+
+        for (const char* s = line + std::strspn(line, " \t\r"); s < lineEnd; s += std::strspn(s, " \t\r"))
+        {
+            const std::size_t length = std::strcspn(s, kSpaces);
+
+            if (numTokens < 3)
+            {
+                tokens[numTokens] = s;
+                tokenLengths[numTokens] = length;
+            }
+
+            ++numTokens;
+            s += length;
+        }
+
+        line = *lineEnd != '\0' ? lineEnd + 1 : lineEnd;
+
+        if (numTokens == 0)
+            continue;
+
+        CARLA_SAFE_ASSERT_UINT_CONTINUE(numTokens == 2 || numTokens == 3, numTokens);
+
+        const int index = std::atoi(tokens[0]);
+        CARLA_SAFE_ASSERT_INT_CONTINUE(index >= 0, index);
+
+        CarlaStateSave::Parameter* const stateParameter(new CarlaStateSave::Parameter());
+        stateParameter->dummy = false;
+        stateParameter->index = index;
+        stateParameter->value = carla_stringToFloat(tokens[numTokens-1]);
+
+        if (numTokens == 3)
+        {
+            char* const symbol = new char[tokenLengths[1]+1];
+            std::memcpy(symbol, tokens[1], tokenLengths[1]);
+            symbol[tokenLengths[1]] = '\0';
+            stateParameter->symbol = symbol;
+        }
+
+        parameters.append(stateParameter);
+    }
+}
+
 // -----------------------------------------------------------------------
 // StateParameter
 
@@ -207,6 +252,8 @@ CarlaStateSave::CarlaStateSave() noexcept
       currentMidiBank(-1),
       currentMidiProgram(-1),
       chunk(nullptr),
+      chunkData(),
+      chunkFile(nullptr),
       parameters(),
       customData() {}
 
@@ -248,6 +295,15 @@ void CarlaStateSave::clear() noexcept
         chunk = nullptr;
     }
 
+    if (chunkFile != nullptr)
+    {
+        delete[] chunkFile;
+        chunkFile = nullptr;
+    }
+
+    // release the memory too, chunks can be big
+    std::vector<uint8_t>().swap(chunkData);
+
     uniqueId = 0;
     options  = 0x0;
 
@@ -325,7 +381,34 @@ bool CarlaStateSave::fillFromXmlElement(const XmlElement* const xmlElement)
             for (XmlElement* xmlData = elem->getFirstChildElement(); xmlData != nullptr; xmlData = xmlData->getNextElement())
             {
                 const String& tag(xmlData->getTagName());
-                const String  text(xmlData->getAllSubText().trim());
+
+                // -------------------------------------------------------
+                // Chunk
+
+                if (tag == "Chunk")
+                {
+                    // decode straight from the text element when possible, to avoid copies of big data
+                    const XmlElement* const xmlText(xmlData->getFirstChildElement());
+
+                    if (xmlText != nullptr && xmlText->isTextElement() && xmlText->getNextElement() == nullptr)
+                    {
+                        const String& chunkText(xmlText->getText());
+                        carla_getChunkFromBase64String_impl(chunkData, chunkText.toRawUTF8(), chunkText.getNumBytesAsUTF8());
+                    }
+                    else
+                    {
+                        carla_getChunkFromBase64String_impl(chunkData, xmlData->getAllSubText().trim().toRawUTF8());
+                    }
+                    continue;
+                }
+
+                const String text(xmlData->getAllSubText().trim());
+
+                if (tag == "ChunkFile")
+                {
+                    chunkFile = xmlSafeStringCharDup(text, false);
+                    continue;
+                }
 
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
                 // -------------------------------------------------------
@@ -337,23 +420,23 @@ bool CarlaStateSave::fillFromXmlElement(const XmlElement* const xmlElement)
                 }
                 else if (tag == "DryWet")
                 {
-                    dryWet = carla_fixedValue(0.0f, 1.0f, text.getFloatValue());
+                    dryWet = carla_fixedValue(0.0f, 1.0f, carla_stringToFloat(text.toRawUTF8()));
                 }
                 else if (tag == "Volume")
                 {
-                    volume = carla_fixedValue(0.0f, 1.27f, text.getFloatValue());
+                    volume = carla_fixedValue(0.0f, 1.27f, carla_stringToFloat(text.toRawUTF8()));
                 }
                 else if (tag == "Balance-Left")
                 {
-                    balanceLeft = carla_fixedValue(-1.0f, 1.0f, text.getFloatValue());
+                    balanceLeft = carla_fixedValue(-1.0f, 1.0f, carla_stringToFloat(text.toRawUTF8()));
                 }
                 else if (tag == "Balance-Right")
                 {
-                    balanceRight = carla_fixedValue(-1.0f, 1.0f, text.getFloatValue());
+                    balanceRight = carla_fixedValue(-1.0f, 1.0f, carla_stringToFloat(text.toRawUTF8()));
                 }
                 else if (tag == "Panning")
                 {
-                    panning = carla_fixedValue(-1.0f, 1.0f, text.getFloatValue());
+                    panning = carla_fixedValue(-1.0f, 1.0f, carla_stringToFloat(text.toRawUTF8()));
                 }
                 else if (tag == "ControlChannel")
                 {
@@ -436,7 +519,7 @@ bool CarlaStateSave::fillFromXmlElement(const XmlElement* const xmlElement)
                         else if (pTag == "Value")
                         {
                             stateParameter->dummy = false;
-                            stateParameter->value = pText.getFloatValue();
+                            stateParameter->value = carla_stringToFloat(pText.toRawUTF8());
                         }
 #ifndef BUILD_BRIDGE_ALTERNATIVE_ARCH
                         else if (pTag == "MidiChannel")
@@ -461,12 +544,12 @@ bool CarlaStateSave::fillFromXmlElement(const XmlElement* const xmlElement)
                         else if (pTag == "MappedMinimum")
                         {
                             hasMappedMinimum = true;
-                            stateParameter->mappedMinimum = pText.getFloatValue();
+                            stateParameter->mappedMinimum = carla_stringToFloat(pText.toRawUTF8());
                         }
                         else if (pTag == "MappedMaximum")
                         {
                             hasMappedMaximum = true;
-                            stateParameter->mappedMaximum = pText.getFloatValue();
+                            stateParameter->mappedMaximum = carla_stringToFloat(pText.toRawUTF8());
                         }
 #endif
                     }
@@ -479,6 +562,14 @@ bool CarlaStateSave::fillFromXmlElement(const XmlElement* const xmlElement)
                     parameters.append(stateParameter);
                 }
 
+                // -------------------------------------------------------
+                // Parameters, compact form
+
+                else if (tag == "ParameterValues")
+                {
+                    readCompactParameters(parameters, xmlData->getAllSubText().toRawUTF8());
+                }
+
                 // -------------------------------------------------------
                 // Custom Data
 
@@ -504,14 +595,6 @@ bool CarlaStateSave::fillFromXmlElement(const XmlElement* const xmlElement)
                     else
                         carla_stderr("Reading CustomData property failed, missing data");
                 }
-
-                // -------------------------------------------------------
-                // Chunk
-
-                else if (tag == "Chunk")
-                {
-                    chunk = carla_strdup(text.toRawUTF8());
-                }
             }
         }
     }
@@ -522,7 +605,8 @@ bool CarlaStateSave::fillFromXmlElement(const XmlElement* const xmlElement)
 // -----------------------------------------------------------------------
 // fillXmlStringFromStateSave
 
-void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content) const
+void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content, const char* const chunkFilename,
+                                        const uint compactParameterCount) const
 {
     {
         MemoryOutputStream infoXml;
@@ -590,15 +674,15 @@ void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content) const
         dataXml << "   <Active>" << (active ? "Yes" : "No") << "</Active>\n";
 
         if (carla_isNotEqual(dryWet, 1.0f))
-            dataXml << "   <DryWet>"        << String(dryWet, 7)       << "</DryWet>\n";
+            dataXml << "   <DryWet>"        << CarlaFloatString(dryWet).buffer       << "</DryWet>\n";
         if (carla_isNotEqual(volume, 1.0f))
-            dataXml << "   <Volume>"        << String(volume, 7)       << "</Volume>\n";
+            dataXml << "   <Volume>"        << CarlaFloatString(volume).buffer       << "</Volume>\n";
         if (carla_isNotEqual(balanceLeft, -1.0f))
-            dataXml << "   <Balance-Left>"  << String(balanceLeft, 7)  << "</Balance-Left>\n";
+            dataXml << "   <Balance-Left>"  << CarlaFloatString(balanceLeft).buffer  << "</Balance-Left>\n";
         if (carla_isNotEqual(balanceRight, 1.0f))
-            dataXml << "   <Balance-Right>" << String(balanceRight, 7) << "</Balance-Right>\n";
+            dataXml << "   <Balance-Right>" << CarlaFloatString(balanceRight).buffer << "</Balance-Right>\n";
         if (carla_isNotEqual(panning, 0.0f))
-            dataXml << "   <Panning>"       << String(panning, 7)      << "</Panning>\n";
+            dataXml << "   <Panning>"       << CarlaFloatString(panning).buffer      << "</Panning>\n";
 
         if (ctrlChannel < 0)
             dataXml << "   <ControlChannel>N</ControlChannel>\n";
@@ -611,11 +695,65 @@ void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content) const
     }
 #endif
 
+    bool compactParameters = false;
+
+    if (compactParameterCount != 0)
+    {
+        uint count = 0;
+
+        for (ParameterItenerator it = parameters.begin2(); it.valid(); it.next())
+        {
+            const Parameter* const stateParameter(it.getValue(nullptr));
+
+            if (stateParameter != nullptr && canWriteCompactParameter(stateParameter))
+                ++count;
+        }
+
+        compactParameters = count >= compactParameterCount;
+    }
+
+    if (compactParameters)
+    {
+        // symbols are only used for restoring LADSPA and LV2 plugins
+        const PluginType ptype = getPluginTypeFromString(type);
+        const bool withSymbols = ptype == PLUGIN_LADSPA || ptype == PLUGIN_LV2;
+
+        MemoryOutputStream parameterXml;
+
+        parameterXml << "\n";
+        parameterXml << "   <ParameterValues>\n";
+
+        for (ParameterItenerator it = parameters.begin2(); it.valid(); it.next())
+        {
+            const Parameter* const stateParameter(it.getValue(nullptr));
+
+            if (stateParameter == nullptr || ! canWriteCompactParameter(stateParameter))
+                continue;
+
+            parameterXml << "    " << stateParameter->index << " ";
+
+            if (withSymbols && stateParameter->symbol != nullptr && stateParameter->symbol[0] != '\0')
+            {
+                writeXmlSafeString(parameterXml, stateParameter->symbol);
+                parameterXml << " ";
+            }
+
+            parameterXml << CarlaFloatString(stateParameter->value).buffer << "\n";
+        }
+
+        parameterXml << "   </ParameterValues>\n";
+
+        content << parameterXml;
+    }
+
     for (ParameterItenerator it = parameters.begin2(); it.valid(); it.next())
     {
         Parameter* const stateParameter(it.getValue(nullptr));
         CARLA_SAFE_ASSERT_CONTINUE(stateParameter != nullptr);
 
+        if (compactParameters && canWriteCompactParameter(stateParameter))
+            continue;
+
         MemoryOutputStream parameterXml;
 
         parameterXml << "\n";
@@ -634,8 +772,8 @@ void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content) const
 
             if (stateParameter->mappedRangeValid)
             {
-                parameterXml << "    <MappedMinimum>" << String(stateParameter->mappedMinimum, 15) << "</MappedMinimum>\n";
-                parameterXml << "    <MappedMaximum>" << String(stateParameter->mappedMaximum, 15) << "</MappedMaximum>\n";
+                parameterXml << "    <MappedMinimum>" << CarlaFloatString(stateParameter->mappedMinimum).buffer << "</MappedMinimum>\n";
+                parameterXml << "    <MappedMaximum>" << CarlaFloatString(stateParameter->mappedMaximum).buffer << "</MappedMaximum>\n";
             }
 
             // backwards compatibility for older carla versions
@@ -645,7 +783,7 @@ void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content) const
 #endif
 
         if (! stateParameter->dummy)
-            parameterXml << "    <Value>" << String(stateParameter->value, 15) << "</Value>\n";
+            parameterXml << "    <Value>" << CarlaFloatString(stateParameter->value).buffer << "</Value>\n";
 
         parameterXml << "   </Parameter>\n";
 
@@ -694,13 +832,13 @@ void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content) const
         if (std::strcmp(stateCustomData->type, CUSTOM_DATA_TYPE_CHUNK) == 0 || std::strlen(stateCustomData->value) >= 128)
         {
             customDataXml << "    <Value>\n";
-            customDataXml << xmlSafeStringFast(stateCustomData->value, true);
+            writeXmlSafeString(customDataXml, stateCustomData->value);
             customDataXml << "\n    </Value>\n";
         }
         else
         {
             customDataXml << "    <Value>";
-            customDataXml << xmlSafeStringFast(stateCustomData->value, true);
+            writeXmlSafeString(customDataXml, stateCustomData->value);
             customDataXml << "</Value>\n";
         }
 
@@ -709,7 +847,11 @@ void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content) const
         content << customDataXml;
     }
 
-    if (chunk != nullptr && chunk[0] != '\0')
+    if (chunkFilename != nullptr && chunkFilename[0] != '\0')
+    {
+        content << "\n   <ChunkFile>" << xmlSafeString(chunkFilename, true) << "</ChunkFile>\n";
+    }
+    else if (chunk != nullptr && chunk[0] != '\0')
     {
         MemoryOutputStream chunkXml, chunkSplt;
         getNewLineSplittedString(chunkSplt, chunk);
@@ -720,6 +862,17 @@ void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content) const
 
         content << chunkXml;
     }
+    else if (! chunkData.empty())
+    {
+        MemoryOutputStream chunkXml, chunkSplt;
+        getNewLineSplittedString(chunkSplt, String(CarlaString::asBase64(&chunkData.front(), chunkData.size()).buffer()));
+
+        chunkXml << "\n   <Chunk>\n";
+        chunkXml << chunkSplt;
+        chunkXml << "\n   </Chunk>\n";
+
+        content << chunkXml;
+    }
 
     content << "  </Data>\n";
 }
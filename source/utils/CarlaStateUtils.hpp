@@ -23,6 +23,9 @@
 
 #include "water/text/String.h"
 
+#include <string>
+#include <vector>
+
 CARLA_BACKEND_START_NAMESPACE
 
 // -----------------------------------------------------------------------
@@ -92,6 +95,13 @@ struct CarlaStateSave {
     int32_t     currentMidiProgram;
     const char* chunk;
 
+    // binary chunk, decoded directly from the document text when reading a project
+    // used instead of 'chunk' when not empty
+    std::vector<uint8_t> chunkData;
+
+    // file holding the binary chunk, relative to the project folder
+    const char* chunkFile;
+
     ParameterList parameters;
     CustomDataList customData;
 
@@ -100,31 +110,139 @@ struct CarlaStateSave {
     void clear() noexcept;
 
     bool fillFromXmlElement(const water::XmlElement* const xmlElement);
-    void dumpToMemoryStream(water::MemoryOutputStream& stream) const;
+    // parameter values are written as a single compact block if at least 'compactParameterCount' of them can be
+    void dumpToMemoryStream(water::MemoryOutputStream& stream, const char* chunkFilename = nullptr,
+                            uint compactParameterCount = 0) const;
 
     CARLA_DECLARE_NON_COPY_STRUCT(CarlaStateSave)
 };
 
+// -----------------------------------------------------------------------
+// XML escaping of the 5 predefined entities, done in a single pass
+
+static const char* const kXmlSpecialChars = "&<>'\"";
+
 static inline
-water::String xmlSafeString(const char* const cstring, const bool toXml)
+const char* xmlEntityForChar(const char c) noexcept
+{
+    switch (c)
+    {
+    case '&':  return "&amp;";
+    case '<':  return "&lt;";
+    case '>':  return "&gt;";
+    case '\'': return "&apos;";
+    case '"':  return "&quot;";
+    }
+
+    return nullptr;
+}
+
+// returns the character for the entity at the start of 'str', or 0 if it is not one of ours
+static inline
+char xmlCharForEntity(const char* const str, std::size_t& entityLength) noexcept
+{
+    static const struct {
+        const char* entity;
+        std::size_t length;
+        char c;
+    } kEntities[] = {
+        { "&amp;",  5, '&'  },
+        { "&lt;",   4, '<'  },
+        { "&gt;",   4, '>'  },
+        { "&apos;", 6, '\'' },
+        { "&quot;", 6, '"'  },
+    };
+
+    for (std::size_t i=0; i < sizeof(kEntities)/sizeof(kEntities[0]); ++i)
+    {
+        if (std::strncmp(str, kEntities[i].entity, kEntities[i].length) == 0)
+        {
+            entityLength = kEntities[i].length;
+            return kEntities[i].c;
+        }
+    }
+
+    return '\0';
+}
+
+static inline
+std::string xmlSafeStdString(const char* const cstring, const bool toXml)
 {
-    water::String newString = water::String(water::CharPointer_UTF8(cstring));
+    std::string string;
+    std::size_t entityLength;
 
     if (toXml)
-        return newString.replace("&","&amp;").replace("<","&lt;").replace(">","&gt;").replace("'","&apos;").replace("\"","&quot;");
+    {
+        std::size_t length = 0;
+
+        for (const char* s = cstring; *s != '\0'; ++s)
+        {
+            const char* const entity = xmlEntityForChar(*s);
+            length += entity != nullptr ? std::strlen(entity) : 1;
+        }
+
+        string.reserve(length);
+
+        for (const char* s = cstring;;)
+        {
+            const std::size_t run = std::strcspn(s, kXmlSpecialChars);
+            string.append(s, run);
+            s += run;
+
+            if (*s == '\0')
+                break;
+
+            string.append(xmlEntityForChar(*s++));
+        }
+    }
     else
-        return newString.replace("&lt;","<").replace("&gt;",">").replace("&apos;","'").replace("&quot;","\"").replace("&amp;","&");
+    {
+        // unescaping never grows the string
+        string.reserve(std::strlen(cstring));
+
+        for (const char* s = cstring;;)
+        {
+            const std::size_t run = std::strcspn(s, "&");
+            string.append(s, run);
+            s += run;
+
+            if (*s == '\0')
+                break;
+
+            if (const char c = xmlCharForEntity(s, entityLength))
+            {
+                string.push_back(c);
+                s += entityLength;
+            }
+            else
+            {
+                string.push_back(*s++);
+            }
+        }
+    }
+
+    return string;
+}
+
+static inline
+water::String xmlSafeString(const char* const cstring, const bool toXml)
+{
+    // nothing to replace, avoid the extra copy
+    if (std::strpbrk(cstring, toXml ? kXmlSpecialChars : "&") == nullptr)
+        return water::String(water::CharPointer_UTF8(cstring));
+
+    return water::String(xmlSafeStdString(cstring, toXml));
 }
 
 static inline
 water::String xmlSafeString(const water::String& string, const bool toXml)
 {
-    water::String newString(string);
+    const char* const cstring = string.toRawUTF8();
 
-    if (toXml)
-        return newString.replace("&","&amp;").replace("<","&lt;").replace(">","&gt;").replace("'","&apos;").replace("\"","&quot;");
-    else
-        return newString.replace("&lt;","<").replace("&gt;",">").replace("&apos;","'").replace("&quot;","\"").replace("&amp;","&");
+    if (std::strpbrk(cstring, toXml ? kXmlSpecialChars : "&") == nullptr)
+        return string;
+
+    return water::String(xmlSafeStdString(cstring, toXml));
 }
 
 // -----------------------------------------------------------------------
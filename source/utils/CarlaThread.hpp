@@ -232,6 +232,48 @@ public:
         return fHandle;
     }
 
+    /*
+     * Change the realtime priority of this thread, can be called from any thread.
+     * A priority of 0 switches back to normal scheduling.
+     */
+    bool setRealtimePriority(const int priority) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(isThreadRunning(), false);
+
+        return _setRealtimePriority(fHandle, priority);
+    }
+
+    /*
+     * Restrict this thread to a set of CPUs, can be called from any thread.
+     * @see setCurrentThreadCpuAffinity()
+     */
+    bool setCpuAffinity(const char* const cpuList) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(isThreadRunning(), false);
+
+        return _setCpuAffinity(fHandle, cpuList);
+    }
+
+    /*
+     * Change the realtime priority of the caller thread.
+     * A priority of 0 switches back to normal scheduling.
+     */
+    static bool setCurrentThreadRealtimePriority(const int priority) noexcept
+    {
+        return _setRealtimePriority(pthread_self(), priority);
+    }
+
+    /*
+     * Restrict the caller thread to a set of CPUs.
+     * 'cpuList' is a comma-separated list of CPU indexes or ranges, like "2,3,8-11".
+     * An empty list allows all CPUs again.
+     * Only supported on Linux, returns false elsewhere.
+     */
+    static bool setCurrentThreadCpuAffinity(const char* const cpuList) noexcept
+    {
+        return _setCpuAffinity(pthread_self(), cpuList);
+    }
+
     /*
      * Changes the name of the caller thread.
      */
@@ -293,6 +335,113 @@ private:
 #endif
     }
 
+    /*
+     * Set the scheduling policy of a thread.
+     */
+    static bool _setRealtimePriority(const pthread_t handle, const int priority) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(priority >= 0 && priority <= 99, false);
+
+#ifdef CARLA_OS_WIN
+        // only SCHED_OTHER is available
+        return priority == 0;
+#else
+        struct sched_param sched_param;
+        carla_zeroStruct(sched_param);
+
+        int policy = SCHED_OTHER;
+
+        if (priority > 0)
+        {
+            policy = SCHED_FIFO;
+            sched_param.sched_priority = std::max(sched_get_priority_min(SCHED_FIFO),
+                                                  std::min(sched_get_priority_max(SCHED_FIFO), priority));
+        }
+
+        if (pthread_setschedparam(handle, policy, &sched_param) == 0)
+            return true;
+
+        carla_stderr("CarlaThread::setRealtimePriority(%i) - failed, missing permissions?", priority);
+        return false;
+#endif
+    }
+
+    /*
+     * Set the CPU affinity of a thread.
+     */
+    static bool _setCpuAffinity(const pthread_t handle, const char* const cpuList) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(cpuList != nullptr, false);
+
+#ifdef CARLA_OS_LINUX
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+
+        if (cpuList[0] == '\0')
+        {
+            for (int i=0; i < CPU_SETSIZE; ++i)
+                CPU_SET(i, &cpuset);
+        }
+        else
+        {
+            bool valid = true;
+
+            for (const char* s = cpuList; valid && *s != '\0';)
+            {
+                char* end;
+                const long first = std::strtol(s, &end, 10);
+                long last = first;
+
+                if (end == s || first < 0 || first >= CPU_SETSIZE)
+                {
+                    valid = false;
+                    break;
+                }
+
+                if (*end == '-')
+                {
+                    s = end + 1;
+                    last = std::strtol(s, &end, 10);
+
+                    if (end == s || last < first || last >= CPU_SETSIZE)
+                    {
+                        valid = false;
+                        break;
+                    }
+                }
+
+                for (long i=first; i <= last; ++i)
+                    CPU_SET(static_cast<int>(i), &cpuset);
+
+                s = end;
+
+                if (*s == ',')
+                    ++s;
+                else if (*s != '\0')
+                    valid = false;
+            }
+
+            if (! valid)
+            {
+                carla_stderr("CarlaThread::setCpuAffinity(\"%s\") - invalid CPU list", cpuList);
+                return false;
+            }
+        }
+
+        if (pthread_setaffinity_np(handle, sizeof(cpu_set_t), &cpuset) == 0)
+            return true;
+
+        carla_stderr("CarlaThread::setCpuAffinity(\"%s\") - failed", cpuList);
+        return false;
+#else
+        // nothing to do for an empty list
+        return cpuList[0] == '\0';
+
+        // unused
+        (void)handle;
+#endif
+    }
+
     /*
      * Thread entry point.
      */
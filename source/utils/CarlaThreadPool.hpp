@@ -0,0 +1,391 @@
+/*
+ * Carla Thread Pool
+ * Copyright (C) 2013-2020 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_THREAD_POOL_HPP_INCLUDED
+#define CARLA_THREAD_POOL_HPP_INCLUDED
+
+#include "CarlaThread.hpp"
+#include "CarlaSemUtils.hpp"
+
+#include <algorithm>
+
+#ifndef CARLA_OS_WIN
+# include <unistd.h>
+#endif
+
+// -----------------------------------------------------------------------
+// CarlaThreadPool class
+
+/*
+ * A set of pre-spawned worker threads meant to help the audio thread.
+ * Workers sleep on their own semaphore until run() is called, then call the job
+ * function together with the calling thread and report back when done.
+ * Calling run() does not allocate or lock anything, so it is safe to use in realtime context.
+ * Several threads can call run() at the same time, idle workers are split between them.
+ */
+class CarlaThreadPool
+{
+public:
+    /*
+     * Job function, called once per participating thread.
+     * 'threadIndex' is 0 for the thread calling run(), 1 and up for the workers helping it.
+     */
+    typedef void (*JobFunc)(void* ptr, uint threadIndex);
+
+    /*
+     * Constructor.
+     */
+    CarlaThreadPool() noexcept
+        : fWorkers(nullptr),
+          fMaxWorkers(0),
+          fNumWorkers(0),
+          fNumRunning(0) {}
+
+    /*
+     * Destructor.
+     */
+    ~CarlaThreadPool() noexcept
+    {
+        stop();
+    }
+
+    /*
+     * Spawn threads until there are 'numWorkers' of them, can be called again to add more.
+     * The amount is limited so that the workers plus the calling thread never exceed the number of CPUs,
+     * as the workers busy-wait while running jobs.
+     * Workers can be restricted to some CPUs with 'cpuAffinity', see CarlaThread::setCurrentThreadCpuAffinity().
+     * Returns false if there are no workers at all.
+     */
+    bool start(uint numWorkers, const bool withRealtimePriority, const char* const cpuAffinity = nullptr) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(numWorkers > 0, false);
+
+        if (fWorkers == nullptr)
+        {
+            const uint numCPUs = getNumCPUs();
+
+            if (numCPUs <= 1)
+                return false;
+
+            fMaxWorkers = numCPUs - 1;
+            fWorkers = new Worker*[fMaxWorkers];
+        }
+
+        if (numWorkers > fMaxWorkers)
+            numWorkers = fMaxWorkers;
+
+        for (uint i=fNumWorkers; i < numWorkers; ++i)
+        {
+            Worker* const worker(new Worker(cpuAffinity));
+
+            if (! worker->init(withRealtimePriority))
+            {
+                delete worker;
+                continue;
+            }
+
+            // make the worker visible to run() only once fully set up
+            fWorkers[fNumWorkers] = worker;
+            __sync_synchronize();
+            ++fNumWorkers;
+        }
+
+        if (fNumWorkers == 0)
+        {
+            delete[] fWorkers;
+            fWorkers = nullptr;
+            fMaxWorkers = 0;
+            return false;
+        }
+
+        return true;
+    }
+
+    /*
+     * Stop and delete all worker threads.
+     * Must not be called while run() is active.
+     */
+    void stop() noexcept
+    {
+        if (fWorkers == nullptr)
+            return;
+
+        for (uint i=0; i < fNumWorkers; ++i)
+            delete fWorkers[i];
+
+        delete[] fWorkers;
+        fWorkers = nullptr;
+        fMaxWorkers = 0;
+        fNumWorkers = 0;
+    }
+
+    /*
+     * Number of online CPUs, at least 1.
+     */
+    static uint getNumCPUs() noexcept
+    {
+#ifdef CARLA_OS_WIN
+        SYSTEM_INFO info;
+        ::GetSystemInfo(&info);
+        return info.dwNumberOfProcessors > 0 ? static_cast<uint>(info.dwNumberOfProcessors) : 1U;
+#else
+        const long count = ::sysconf(_SC_NPROCESSORS_ONLN);
+        return count > 0 ? static_cast<uint>(count) : 1U;
+#endif
+    }
+
+    /*
+     * Number of running worker threads, not counting the caller of run().
+     */
+    uint getNumWorkers() const noexcept
+    {
+        return fNumWorkers;
+    }
+
+    /*
+     * Call 'func' on the workers and on the calling thread, returning once every call has finished.
+     */
+    void run(const JobFunc func, void* const ptr) noexcept
+    {
+        run(func, ptr, fNumWorkers);
+    }
+
+    /*
+     * Call 'func' on up to 'maxWorkers' idle workers and on the calling thread, returning once every call has finished.
+     * While other threads are inside run() too, each one only takes its fair share of the workers,
+     * busy workers are skipped. The job must not rely on any worker actually helping.
+     */
+    void run(const JobFunc func, void* const ptr, const uint maxWorkers) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(func != nullptr,);
+
+        const uint numWorkers = fNumWorkers;
+
+        if (numWorkers == 0 || maxWorkers == 0)
+        {
+            func(ptr, 0);
+            return;
+        }
+
+        const uint numRunning = static_cast<uint>(__sync_add_and_fetch(&fNumRunning, 1));
+        const uint share = std::min(maxWorkers, (numWorkers + numRunning - 1) / numRunning);
+
+        volatile int numDone = 0;
+        uint numClaimed = 0;
+
+        for (uint i=0; i < numWorkers && numClaimed < share; ++i)
+        {
+            Worker* const worker(fWorkers[i]);
+
+            if (! __sync_bool_compare_and_swap(&worker->fBusy, 0, 1))
+                continue;
+
+            worker->fJobFunc  = func;
+            worker->fJobPtr   = ptr;
+            worker->fJobIndex = ++numClaimed;
+            worker->fJobDone  = &numDone;
+
+            // carla_sem_post implies a full memory barrier
+            carla_sem_post(worker->fSem);
+        }
+
+        func(ptr, 0);
+
+        while (__sync_fetch_and_add(&numDone, 0) != static_cast<int>(numClaimed)) {}
+
+        __sync_sub_and_fetch(&fNumRunning, 1);
+    }
+
+private:
+    // -------------------------------------------------------------------
+
+    class Worker : public CarlaThread
+    {
+    public:
+        Worker(const char* const cpuAffinity) noexcept
+            : CarlaThread("CarlaThreadPoolWorker"),
+              fSem(),
+              fBusy(0),
+              fJobFunc(nullptr),
+              fJobPtr(nullptr),
+              fJobIndex(0),
+              fJobDone(nullptr),
+              fCpuAffinity(cpuAffinity),
+              fSemValid(false) {}
+
+        ~Worker() noexcept override
+        {
+            stopThread(-1);
+
+            if (fSemValid)
+                carla_sem_destroy2(fSem);
+        }
+
+        bool init(const bool withRealtimePriority) noexcept
+        {
+            fSemValid = carla_sem_create2(fSem, false);
+            CARLA_SAFE_ASSERT_RETURN(fSemValid, false);
+
+            return startThread(withRealtimePriority);
+        }
+
+        carla_sem_t fSem;
+
+        // set by run() while claimed, the job below belongs to that caller
+        volatile int fBusy;
+        JobFunc fJobFunc;
+        void* fJobPtr;
+        uint fJobIndex;
+        volatile int* fJobDone;
+
+    protected:
+        void run() noexcept override
+        {
+            if (fCpuAffinity.isNotEmpty())
+                setCurrentThreadCpuAffinity(fCpuAffinity);
+
+            for (; ! shouldThreadExit();)
+            {
+                if (! carla_sem_timedwait(fSem, 100))
+                    continue;
+
+                volatile int* const jobDone = fJobDone;
+
+                fJobFunc(fJobPtr, fJobIndex);
+
+                // free for the next caller before reporting back, the caller's counter stays valid until then
+                __sync_lock_release(&fBusy);
+                __sync_add_and_fetch(jobDone, 1);
+            }
+        }
+
+    private:
+        const CarlaString fCpuAffinity;
+        bool fSemValid;
+
+        CARLA_DECLARE_NON_COPY_CLASS(Worker)
+    };
+
+    // -------------------------------------------------------------------
+
+    Worker** fWorkers;
+    uint fMaxWorkers;
+    volatile uint fNumWorkers;
+    volatile int fNumRunning;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaThreadPool)
+};
+
+// -----------------------------------------------------------------------
+// CarlaSharedThreadPool class
+
+/*
+ * A single thread pool for the whole process (or rather, for everything linked into the same binary),
+ * so that several engines running next to each other do not each spawn workers for all CPUs.
+ * The pool is created on first acquire() and stopped when the last user releases it.
+ * Users should pass their own limit to CarlaThreadPool::run(), the pool grows to the biggest one requested.
+ * Worker CPU affinity is set by whoever spawns them.
+ */
+class CarlaSharedThreadPool
+{
+public:
+    /*
+     * Take a reference to the shared pool, making sure it has up to 'numWorkers' workers.
+     * Returns null if no workers could be started.
+     */
+    static CarlaThreadPool* acquire(const uint numWorkers, const char* const cpuAffinity = nullptr) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(numWorkers > 0, nullptr);
+
+        SharedData& shared(getSharedData());
+        const CarlaMutexLocker cml(shared.mutex);
+
+        if (shared.pool == nullptr)
+        {
+            try {
+                shared.pool = new CarlaThreadPool();
+            } CARLA_SAFE_EXCEPTION_RETURN("CarlaSharedThreadPool::acquire", nullptr);
+        }
+
+        if (shared.pool->getNumWorkers() < numWorkers)
+            shared.pool->start(numWorkers, true, cpuAffinity);
+
+        if (shared.pool->getNumWorkers() == 0)
+        {
+            if (shared.refCount == 0)
+            {
+                delete shared.pool;
+                shared.pool = nullptr;
+            }
+            return nullptr;
+        }
+
+        ++shared.refCount;
+        return shared.pool;
+    }
+
+    /*
+     * Drop a reference taken with acquire(), stopping the workers if it was the last one.
+     * Must not be called while still inside CarlaThreadPool::run().
+     */
+    static void release(CarlaThreadPool* const pool) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(pool != nullptr,);
+
+        SharedData& shared(getSharedData());
+        const CarlaMutexLocker cml(shared.mutex);
+
+        CARLA_SAFE_ASSERT_RETURN(pool == shared.pool,);
+        CARLA_SAFE_ASSERT_RETURN(shared.refCount > 0,);
+
+        if (--shared.refCount != 0)
+            return;
+
+        delete shared.pool;
+        shared.pool = nullptr;
+    }
+
+private:
+    struct SharedData {
+        CarlaMutex mutex;
+        CarlaThreadPool* pool;
+        uint refCount;
+
+        SharedData() noexcept
+            : mutex(),
+              pool(nullptr),
+              refCount(0) {}
+
+        ~SharedData() noexcept
+        {
+            CARLA_SAFE_ASSERT(refCount == 0);
+            delete pool;
+        }
+
+        CARLA_DECLARE_NON_COPY_STRUCT(SharedData)
+    };
+
+    static SharedData& getSharedData() noexcept
+    {
+        static SharedData sData;
+        return sData;
+    }
+};
+
+// -----------------------------------------------------------------------
+
+#endif // CARLA_THREAD_POOL_HPP_INCLUDED
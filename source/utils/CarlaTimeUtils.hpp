@@ -0,0 +1,79 @@
+/*
+ * Carla time utils
+ * Copyright (C) 2013-2019 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_TIME_UTILS_HPP_INCLUDED
+#define CARLA_TIME_UTILS_HPP_INCLUDED
+
+#include "CarlaUtils.hpp"
+
+#include <ctime>
+#include <sys/time.h>
+
+// -----------------------------------------------------------------------
+// carla_gettime_*
+
+/*
+ * Get a monotonic timestamp in microseconds, only meaningful when compared to another one.
+ * Uses the raw hardware clock where available, so NTP adjustments do not skew measurements.
+ */
+static inline
+int64_t carla_gettime_us() noexcept
+{
+#if defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN)
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+
+    return (static_cast<int64_t>(tv.tv_sec) * 1000000) + tv.tv_usec;
+#else
+    struct timespec ts;
+# ifdef CLOCK_MONOTONIC_RAW
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+# else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+# endif
+
+    return (static_cast<int64_t>(ts.tv_sec) * 1000000) + (ts.tv_nsec / 1000);
+#endif
+}
+
+/*
+ * Same as carla_gettime_us(), in nanoseconds.
+ * Precision is still limited to microseconds on macOS and Windows.
+ */
+static inline
+int64_t carla_gettime_ns() noexcept
+{
+#if defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN)
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+
+    return (static_cast<int64_t>(tv.tv_sec) * 1000000000LL) + (tv.tv_usec * 1000LL);
+#else
+    struct timespec ts;
+# ifdef CLOCK_MONOTONIC_RAW
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+# else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+# endif
+
+    return (static_cast<int64_t>(ts.tv_sec) * 1000000000LL) + ts.tv_nsec;
+#endif
+}
+
+// -----------------------------------------------------------------------
+
+#endif // CARLA_TIME_UTILS_HPP_INCLUDED
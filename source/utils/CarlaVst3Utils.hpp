@@ -0,0 +1,500 @@
+/*
+ * Carla VST3 utils
+ * Copyright (C) 2011-2020 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_VST3_UTILS_HPP_INCLUDED
+#define CARLA_VST3_UTILS_HPP_INCLUDED
+
+#include "CarlaUtils.hpp"
+
+#include "water/files/File.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------------------------------
+// Include fixes
+
+// only the interface headers are used, the SDK sources are not built as part of Carla
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 6))
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wnon-virtual-dtor"
+# pragma GCC diagnostic ignored "-Wshadow"
+#endif
+
+#include "pluginterfaces/base/ibstream.h"
+#include "pluginterfaces/base/ipluginbase.h"
+#include "pluginterfaces/vst/ivstaudioprocessor.h"
+#include "pluginterfaces/vst/ivstcomponent.h"
+#include "pluginterfaces/vst/ivsteditcontroller.h"
+#include "pluginterfaces/vst/ivstevents.h"
+#include "pluginterfaces/vst/ivsthostapplication.h"
+#include "pluginterfaces/vst/ivstmessage.h"
+#include "pluginterfaces/vst/ivstmidicontrollers.h"
+#include "pluginterfaces/vst/ivstparameterchanges.h"
+#include "pluginterfaces/vst/ivstprocesscontext.h"
+#include "pluginterfaces/vst/ivstunits.h"
+
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 6))
+# pragma GCC diagnostic pop
+#endif
+
+#ifdef CARLA_OS_MAC
+# include <CoreFoundation/CoreFoundation.h>
+#endif
+
+// -----------------------------------------------------------------------
+// Binary location inside a VST3 bundle
+
+#if defined(CARLA_OS_MAC)
+# define V3_CONTENT_DIR "MacOS"
+#elif defined(CARLA_OS_WIN)
+# if defined(__aarch64__) || defined(_M_ARM64)
+#  define V3_CONTENT_DIR "arm64-win"
+# elif defined(CARLA_OS_64BIT)
+#  define V3_CONTENT_DIR "x86_64-win"
+# else
+#  define V3_CONTENT_DIR "x86-win"
+# endif
+# define V3_BINARY_EXT ".vst3"
+#else
+# if defined(__aarch64__)
+#  define V3_CONTENT_DIR "aarch64-linux"
+# elif defined(__arm__)
+#  define V3_CONTENT_DIR "armv7l-linux"
+# elif defined(__x86_64__)
+#  define V3_CONTENT_DIR "x86_64-linux"
+# else
+#  define V3_CONTENT_DIR "i386-linux"
+# endif
+# define V3_BINARY_EXT ".so"
+#endif
+
+// -----------------------------------------------------------------------
+// Module entry points
+
+typedef Steinberg::IPluginFactory* (PLUGIN_API *V3_GetFactoryFunction)();
+
+#if defined(CARLA_OS_MAC)
+typedef bool (*V3_ModuleEntryFunction)(CFBundleRef);
+typedef bool (*V3_ModuleExitFunction)();
+# define V3_MODULE_ENTRY_NAME "bundleEntry"
+# define V3_MODULE_EXIT_NAME  "bundleExit"
+#elif defined(CARLA_OS_WIN)
+typedef bool (PLUGIN_API *V3_ModuleEntryFunction)();
+typedef bool (PLUGIN_API *V3_ModuleExitFunction)();
+# define V3_MODULE_ENTRY_NAME "InitDll"
+# define V3_MODULE_EXIT_NAME  "ExitDll"
+#else
+typedef bool (PLUGIN_API *V3_ModuleEntryFunction)(void*);
+typedef bool (PLUGIN_API *V3_ModuleExitFunction)();
+# define V3_MODULE_ENTRY_NAME "ModuleEntry"
+# define V3_MODULE_EXIT_NAME  "ModuleExit"
+#endif
+
+// -----------------------------------------------------------------------
+// Get the binary to open for a VST3 file or bundle (macOS bundles are opened as-is)
+
+static inline
+water::File getVst3BinaryFile(const char* const filename)
+{
+    const water::File file(filename);
+
+#ifndef CARLA_OS_MAC
+    if (file.isDirectory())
+        return file.getChildFile("Contents")
+                   .getChildFile(V3_CONTENT_DIR)
+                   .getChildFile(file.getFileNameWithoutExtension() + V3_BINARY_EXT);
+#endif
+
+    return file;
+}
+
+// -----------------------------------------------------------------------
+// Unique id compatible with the one used by JUCE, so existing projects keep working
+
+static inline
+int64_t getVst3UniqueId(const Steinberg::TUID tuid) noexcept
+{
+    uint32_t value = 0;
+
+    for (uint i=0; i < sizeof(Steinberg::TUID); ++i)
+        value = (value * 31) + static_cast<uint32_t>(tuid[i]);
+
+    return static_cast<int32_t>(value);
+}
+
+// -----------------------------------------------------------------------
+// Convert a null-terminated UTF-16 string into UTF-8, truncating if needed
+
+static inline
+void vst3StringToUtf8(char* const dst, const Steinberg::char16* const src, const std::size_t size) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(dst != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(size > 0,);
+
+    std::size_t pos = 0;
+
+    for (std::size_t i=0; src != nullptr && src[i] != 0; ++i)
+    {
+        uint32_t c = static_cast<uint16_t>(src[i]);
+
+        // surrogate pair
+        if (c >= 0xd800 && c <= 0xdbff && static_cast<uint16_t>(src[i+1]) >= 0xdc00 && static_cast<uint16_t>(src[i+1]) <= 0xdfff)
+        {
+            c = 0x10000 + ((c - 0xd800) << 10) + (static_cast<uint16_t>(src[i+1]) - 0xdc00);
+            ++i;
+        }
+
+        char buf[4];
+        std::size_t len;
+
+        if (c < 0x80)
+        {
+            buf[0] = static_cast<char>(c);
+            len = 1;
+        }
+        else if (c < 0x800)
+        {
+            buf[0] = static_cast<char>(0xc0 | (c >> 6));
+            buf[1] = static_cast<char>(0x80 | (c & 0x3f));
+            len = 2;
+        }
+        else if (c < 0x10000)
+        {
+            buf[0] = static_cast<char>(0xe0 | (c >> 12));
+            buf[1] = static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+            buf[2] = static_cast<char>(0x80 | (c & 0x3f));
+            len = 3;
+        }
+        else
+        {
+            buf[0] = static_cast<char>(0xf0 | (c >> 18));
+            buf[1] = static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+            buf[2] = static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+            buf[3] = static_cast<char>(0x80 | (c & 0x3f));
+            len = 4;
+        }
+
+        if (pos + len >= size)
+            break;
+
+        std::memcpy(dst + pos, buf, len);
+        pos += len;
+    }
+
+    dst[pos] = '\0';
+}
+
+// -----------------------------------------------------------------------
+// Messages exchanged between a plugin component and its edit controller, allocated by the host
+
+class CarlaVst3AttributeList : public Steinberg::Vst::IAttributeList
+{
+public:
+    CarlaVst3AttributeList() noexcept
+        : fRefCount(1),
+          fAttributes() {}
+
+    virtual ~CarlaVst3AttributeList() {}
+
+    Steinberg::tresult PLUGIN_API queryInterface(const Steinberg::TUID iid, void** const obj) override
+    {
+        if (Steinberg::FUnknownPrivate::iidEqual(iid, Steinberg::FUnknown_iid) ||
+            Steinberg::FUnknownPrivate::iidEqual(iid, Steinberg::Vst::IAttributeList_iid))
+        {
+            addRef();
+            *obj = this;
+            return Steinberg::kResultOk;
+        }
+
+        *obj = nullptr;
+        return Steinberg::kNoInterface;
+    }
+
+    Steinberg::uint32 PLUGIN_API addRef() override
+    {
+        return static_cast<Steinberg::uint32>(__sync_add_and_fetch(&fRefCount, 1));
+    }
+
+    Steinberg::uint32 PLUGIN_API release() override
+    {
+        const int refCount = __sync_sub_and_fetch(&fRefCount, 1);
+
+        if (refCount == 0)
+            delete this;
+
+        return static_cast<Steinberg::uint32>(refCount);
+    }
+
+    Steinberg::tresult PLUGIN_API setInt(AttrID id, Steinberg::int64 value) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(id != nullptr, Steinberg::kInvalidArgument);
+
+        Attribute& attr(fAttributes[id]);
+        attr.type = kTypeInt;
+        attr.i = value;
+        return Steinberg::kResultOk;
+    }
+
+    Steinberg::tresult PLUGIN_API getInt(AttrID id, Steinberg::int64& value) override
+    {
+        const Attribute* const attr = find(id, kTypeInt);
+        CARLA_SAFE_ASSERT_RETURN(attr != nullptr, Steinberg::kResultFalse);
+
+        value = attr->i;
+        return Steinberg::kResultOk;
+    }
+
+    Steinberg::tresult PLUGIN_API setFloat(AttrID id, double value) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(id != nullptr, Steinberg::kInvalidArgument);
+
+        Attribute& attr(fAttributes[id]);
+        attr.type = kTypeFloat;
+        attr.f = value;
+        return Steinberg::kResultOk;
+    }
+
+    Steinberg::tresult PLUGIN_API getFloat(AttrID id, double& value) override
+    {
+        const Attribute* const attr = find(id, kTypeFloat);
+        CARLA_SAFE_ASSERT_RETURN(attr != nullptr, Steinberg::kResultFalse);
+
+        value = attr->f;
+        return Steinberg::kResultOk;
+    }
+
+    Steinberg::tresult PLUGIN_API setString(AttrID id, const Steinberg::Vst::TChar* string) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(id != nullptr, Steinberg::kInvalidArgument);
+        CARLA_SAFE_ASSERT_RETURN(string != nullptr, Steinberg::kInvalidArgument);
+
+        std::size_t len = 0;
+        while (string[len] != 0)
+            ++len;
+
+        // keep the null terminator as part of the data
+        Attribute& attr(fAttributes[id]);
+        attr.type = kTypeString;
+        attr.data.assign(reinterpret_cast<const uint8_t*>(string),
+                         reinterpret_cast<const uint8_t*>(string + len + 1));
+        return Steinberg::kResultOk;
+    }
+
+    Steinberg::tresult PLUGIN_API getString(AttrID id, Steinberg::Vst::TChar* string, Steinberg::uint32 sizeInBytes) override
+    {
+        const Attribute* const attr = find(id, kTypeString);
+        CARLA_SAFE_ASSERT_RETURN(attr != nullptr, Steinberg::kResultFalse);
+        CARLA_SAFE_ASSERT_RETURN(string != nullptr && sizeInBytes >= sizeof(Steinberg::Vst::TChar), Steinberg::kInvalidArgument);
+
+        const std::size_t size = std::min(attr->data.size(), static_cast<std::size_t>(sizeInBytes));
+        std::memcpy(string, attr->data.data(), size);
+        string[sizeInBytes / sizeof(Steinberg::Vst::TChar) - 1] = 0;
+        return Steinberg::kResultOk;
+    }
+
+    Steinberg::tresult PLUGIN_API setBinary(AttrID id, const void* data, Steinberg::uint32 size) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(id != nullptr, Steinberg::kInvalidArgument);
+        CARLA_SAFE_ASSERT_RETURN(data != nullptr || size == 0, Steinberg::kInvalidArgument);
+
+        Attribute& attr(fAttributes[id]);
+        attr.type = kTypeBinary;
+        attr.data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+        return Steinberg::kResultOk;
+    }
+
+    Steinberg::tresult PLUGIN_API getBinary(AttrID id, const void*& data, Steinberg::uint32& size) override
+    {
+        const Attribute* const attr = find(id, kTypeBinary);
+        CARLA_SAFE_ASSERT_RETURN(attr != nullptr, Steinberg::kResultFalse);
+
+        data = attr->data.data();
+        size = static_cast<Steinberg::uint32>(attr->data.size());
+        return Steinberg::kResultOk;
+    }
+
+private:
+    enum AttributeType {
+        kTypeInt,
+        kTypeFloat,
+        kTypeString,
+        kTypeBinary
+    };
+
+    struct Attribute {
+        AttributeType type;
+        Steinberg::int64 i;
+        double f;
+        std::vector<uint8_t> data;
+
+        Attribute() noexcept
+            : type(kTypeInt),
+              i(0),
+              f(0.0),
+              data() {}
+    };
+
+    volatile int fRefCount;
+    std::map<std::string, Attribute> fAttributes;
+
+    const Attribute* find(AttrID id, const AttributeType type) const
+    {
+        CARLA_SAFE_ASSERT_RETURN(id != nullptr, nullptr);
+
+        const std::map<std::string, Attribute>::const_iterator it = fAttributes.find(id);
+
+        if (it == fAttributes.end() || it->second.type != type)
+            return nullptr;
+
+        return &it->second;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaVst3AttributeList)
+};
+
+class CarlaVst3Message : public Steinberg::Vst::IMessage
+{
+public:
+    CarlaVst3Message() noexcept
+        : fRefCount(1),
+          fMessageId(),
+          fAttributes(new CarlaVst3AttributeList()) {}
+
+    virtual ~CarlaVst3Message()
+    {
+        fAttributes->release();
+    }
+
+    Steinberg::tresult PLUGIN_API queryInterface(const Steinberg::TUID iid, void** const obj) override
+    {
+        if (Steinberg::FUnknownPrivate::iidEqual(iid, Steinberg::FUnknown_iid) ||
+            Steinberg::FUnknownPrivate::iidEqual(iid, Steinberg::Vst::IMessage_iid))
+        {
+            addRef();
+            *obj = this;
+            return Steinberg::kResultOk;
+        }
+
+        *obj = nullptr;
+        return Steinberg::kNoInterface;
+    }
+
+    Steinberg::uint32 PLUGIN_API addRef() override
+    {
+        return static_cast<Steinberg::uint32>(__sync_add_and_fetch(&fRefCount, 1));
+    }
+
+    Steinberg::uint32 PLUGIN_API release() override
+    {
+        const int refCount = __sync_sub_and_fetch(&fRefCount, 1);
+
+        if (refCount == 0)
+            delete this;
+
+        return static_cast<Steinberg::uint32>(refCount);
+    }
+
+    Steinberg::FIDString PLUGIN_API getMessageID() override
+    {
+        return fMessageId.c_str();
+    }
+
+    void PLUGIN_API setMessageID(Steinberg::FIDString id) override
+    {
+        fMessageId = (id != nullptr) ? id : "";
+    }
+
+    Steinberg::Vst::IAttributeList* PLUGIN_API getAttributes() override
+    {
+        return fAttributes;
+    }
+
+private:
+    volatile int fRefCount;
+    std::string fMessageId;
+    CarlaVst3AttributeList* const fAttributes;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaVst3Message)
+};
+
+// -----------------------------------------------------------------------
+// Minimal host application, given to the plugin factory and its instances
+
+class CarlaVst3HostApplication : public Steinberg::Vst::IHostApplication
+{
+public:
+    CarlaVst3HostApplication() noexcept {}
+    virtual ~CarlaVst3HostApplication() {}
+
+    Steinberg::tresult PLUGIN_API queryInterface(const Steinberg::TUID iid, void** const obj) override
+    {
+        if (Steinberg::FUnknownPrivate::iidEqual(iid, Steinberg::FUnknown_iid) ||
+            Steinberg::FUnknownPrivate::iidEqual(iid, Steinberg::Vst::IHostApplication_iid))
+        {
+            *obj = this;
+            return Steinberg::kResultOk;
+        }
+
+        *obj = nullptr;
+        return Steinberg::kNoInterface;
+    }
+
+    // lifetime is managed by the host
+    Steinberg::uint32 PLUGIN_API addRef() override { return 1; }
+    Steinberg::uint32 PLUGIN_API release() override { return 1; }
+
+    Steinberg::tresult PLUGIN_API getName(Steinberg::Vst::String128 name) override
+    {
+        static const char kName[] = "Carla";
+
+        for (uint i=0; i < sizeof(kName); ++i)
+            name[i] = static_cast<Steinberg::char16>(kName[i]);
+
+        return Steinberg::kResultOk;
+    }
+
+    Steinberg::tresult PLUGIN_API createInstance(Steinberg::TUID cid, Steinberg::TUID iid, void** const obj) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(obj != nullptr, Steinberg::kInvalidArgument);
+
+        *obj = nullptr;
+
+        if (Steinberg::FUnknownPrivate::iidEqual(cid, Steinberg::Vst::IMessage_iid) &&
+            Steinberg::FUnknownPrivate::iidEqual(iid, Steinberg::Vst::IMessage_iid))
+        {
+            *obj = static_cast<Steinberg::Vst::IMessage*>(new CarlaVst3Message());
+            return Steinberg::kResultOk;
+        }
+
+        if (Steinberg::FUnknownPrivate::iidEqual(cid, Steinberg::Vst::IAttributeList_iid) &&
+            Steinberg::FUnknownPrivate::iidEqual(iid, Steinberg::Vst::IAttributeList_iid))
+        {
+            *obj = static_cast<Steinberg::Vst::IAttributeList*>(new CarlaVst3AttributeList());
+            return Steinberg::kResultOk;
+        }
+
+        return Steinberg::kNoInterface;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaVst3HostApplication)
+};
+
+// -----------------------------------------------------------------------
+
+#endif // CARLA_VST3_UTILS_HPP_INCLUDED